@@ -18,6 +18,9 @@ extern "C" {
 // Opaque handle to the ZuneDevice object
 typedef void* zune_device_handle_t;
 
+// Opaque handle to the lookup indexes over one ZuneMusicLibrary
+typedef void* zune_library_index_t;
+
 // Callback types
 typedef void (*log_callback_t)(const char* message);
 typedef void (*device_discovered_callback_t)(const char* ip_address, const char* uuid);
@@ -33,7 +36,10 @@ struct ZuneObjectInfo {
     bool is_folder;
 };
 
-// Flat music library structures - grouping done in C# with LINQ
+// Flat music library structures - grouping done in C# with LINQ, or through
+// the zune_library_index_* lookups.
+// Strings are read-only: tracks with the same artist or genre may share one
+// artist_name / artist_guid / genre pointer.
 struct ZuneMusicTrack {
     const char* title;
     const char* artist_name;
@@ -148,6 +154,23 @@ struct ZuneMusicLibrary {
     uint32_t podcast_episode_count;
 };
 
+// Changes to a tracked library since it was read or since the previous delta.
+// changed holds the new or updated tracks, albums and artists (and artwork entries
+// for new albums) with their current values; its other arrays are empty.
+struct ZuneLibraryDelta {
+    ZuneMusicLibrary* changed;
+    uint32_t* removed_atom_ids;    // Tracks, albums and artists deleted on the device
+    uint32_t removed_count;
+};
+
+// Result of a library index query: indices into the queried library's array
+// (tracks or albums), in device order. Owned by the index; valid until
+// zune_library_index_free. count is 0 (and indices NULL) when nothing matches.
+struct ZuneIndexRange {
+    const uint32_t* indices;
+    uint32_t count;
+};
+
 struct ZunePlaylistInfo {
     const char* Name;
     uint32_t TrackCount;
@@ -163,15 +186,47 @@ XUNE_SYNC_API const char* zune_get_last_error();
 XUNE_SYNC_API zune_device_handle_t zune_device_create();
 XUNE_SYNC_API void zune_device_destroy(zune_device_handle_t handle);
 
+// Connects to the first Zune that no other handle has open, so with
+// several plugged in, each handle created and connected gets the next one.
+// Every handle has its own MTP session, scheduler and async worker, and
+// zune_get_last_error() is per thread, so devices can sync in parallel.
 XUNE_SYNC_API bool zune_device_connect_usb(zune_device_handle_t handle);
+// Connects to the Zune with this serial number (see zune_device_list_usb)
+XUNE_SYNC_API bool zune_device_connect_usb_serial(zune_device_handle_t handle, const char* serial);
 XUNE_SYNC_API void zune_device_disconnect(zune_device_handle_t handle);
 
 // Connection validation - lightweight MTP operation to verify session is still valid
 XUNE_SYNC_API bool zune_device_is_connected(zune_device_handle_t handle);
 XUNE_SYNC_API bool zune_device_validate_connection(zune_device_handle_t handle);
 
+/// Log lines reach the callback in order on a library thread, so a slow
+/// callback never holds up transfers or the network stack
 XUNE_SYNC_API void zune_device_set_log_callback(zune_device_handle_t handle, log_callback_t callback);
 
+/// Log categories
+typedef enum {
+    ZUNE_LOG_MTP = 0,       // Device session: connection, pairing, properties
+    ZUNE_LOG_ZMDB,          // Library database and track state
+    ZUNE_LOG_PPP,           // PPP negotiation and the 0x922c/0x922d link
+    ZUNE_LOG_TCP,           // TCP connections and segments
+    ZUNE_LOG_HTTP,          // Intercepted HTTP requests and responses
+    ZUNE_LOG_CATEGORY_COUNT
+} ZuneLogCategory;
+
+/// Log levels, least detailed first
+typedef enum {
+    ZUNE_LOG_ERROR = 0,
+    ZUNE_LOG_WARNING,
+    ZUNE_LOG_INFO,          // Default for every category
+    ZUNE_LOG_DEBUG          // Per-packet detail
+} ZuneLogLevel;
+
+/// Most detailed level logged for category, or for every category with
+/// ZUNE_LOG_CATEGORY_COUNT. Lines above it are never formatted.
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_set_log_level(
+    zune_device_handle_t handle, ZuneLogCategory category, ZuneLogLevel level);
+
 // Set the path to the MTPZ authentication data file.
 // Must be called before zune_device_connect_usb().
 // If not set, falls back to $HOME/.mtpz-data.
@@ -240,10 +295,125 @@ XUNE_SYNC_API bool zune_device_supports_network_mode(zune_device_handle_t handle
 
 // Library & File Operations
 XUNE_SYNC_API ZuneMusicLibrary* zune_device_get_music_library(zune_device_handle_t handle);
+// Opt into multi-threaded ZMDB parsing for zune_device_get_music_library (off by default).
+// Output is identical to serial parsing.
+XUNE_SYNC_API void zune_device_set_parallel_library_parsing(zune_device_handle_t handle, bool enable);
+// Parse the ZMDB while it is still transferring from the device (off by default).
+// Output is identical; any transfer problem falls back to a buffered read.
+// Has no effect while a library cache directory is set.
+XUNE_SYNC_API void zune_device_set_streaming_library_read(zune_device_handle_t handle, bool enable);
+// Cache parsed libraries on the host, one snapshot per device serial under directory.
+// zune_device_get_music_library still reads the ZMDB, but skips parsing when it is
+// unchanged since the last call. Either way the library is built in one pass, with no
+// intermediate parsed copy. NULL or "" disables (the default).
+XUNE_SYNC_API void zune_device_set_library_cache_dir(zune_device_handle_t handle, const char* directory);
+// With a library cache directory set, first compare a cheap fingerprint of the device's
+// contents (storage free space, object sizes, play counts and ratings) with the one the
+// cached library was stored under, and return the cached library without reading the
+// ZMDB when they match. Metadata-only edits keep every object size, so the fingerprint
+// cannot see them: property writes made through this library (track and album
+// properties, album references, playlists, artist backfill, zune_mtp_set_object_property_*)
+// discard the cached library instead. Edits made by other software, and on-device skip
+// counts, show up only once something else changes. Off by default.
+XUNE_SYNC_API void zune_device_set_library_fingerprint_check(zune_device_handle_t handle, bool enable);
+// Leave the description of every video and podcast episode, and the episode_url of
+// podcast episodes, empty in zune_device_get_music_library instead of decoding them;
+// fetch one with zune_device_get_media_detail when it is shown. Off by default.
+XUNE_SYNC_API void zune_device_set_deferred_media_details(zune_device_handle_t handle, bool enable);
 XUNE_SYNC_API void zune_device_free_music_library(ZuneMusicLibrary* library);
+// Packed variant: same contents as zune_device_get_music_library, but the structs, playlist
+// track-id arrays and all strings live in one contiguous block. Release with
+// zune_packed_music_library_free (never zune_device_free_music_library).
+XUNE_SYNC_API ZuneMusicLibrary* zune_device_get_packed_music_library(zune_device_handle_t handle);
+// Write a packed library to disk. Returns 0 on success, -1 on error.
+XUNE_SYNC_API int zune_packed_music_library_save(const ZuneMusicLibrary* library, const char* path);
+// Memory-map a file written by zune_packed_music_library_save. Returns NULL if the file is
+// missing, corrupt, or was written by a build with a different struct layout.
+XUNE_SYNC_API ZuneMusicLibrary* zune_packed_music_library_load(const char* path);
+XUNE_SYNC_API void zune_packed_music_library_free(ZuneMusicLibrary* library);
+// Keep the library from the last zune_device_get_music_library (or packed) call current
+// as zune_upload_* and zune_mtp_update_* writes succeed, so it can be fetched again
+// without another ZMDB read (off by default; disabling or disconnecting drops it).
+// Uploaded albums keep their .alb ObjectId as atom_id until the next full read.
+XUNE_SYNC_API void zune_device_set_library_tracking(zune_device_handle_t handle, bool enable);
+// The tracked library with all writes applied. Free with zune_device_free_music_library.
+// Returns NULL if tracking is off or no library has been read yet.
+XUNE_SYNC_API ZuneMusicLibrary* zune_device_get_tracked_music_library(zune_device_handle_t handle);
+// Changes since the tracked library was read or the previous delta was taken.
+// Free with zune_library_delta_free. Returns NULL if tracking is off or no library has been read yet.
+XUNE_SYNC_API ZuneLibraryDelta* zune_device_take_library_delta(zune_device_handle_t handle);
+XUNE_SYNC_API void zune_library_delta_free(ZuneLibraryDelta* delta);
+// Bring play counts and ratings in the tracked library up to date without
+// re-reading the ZMDB: two GetObjectPropertyLists (UseCount, UserRating) merged
+// by atom_id. Changed tracks show up in the next zune_device_take_library_delta.
+// Returns tracks changed, -1 on a query failure, -2 if not connected, -3 if
+// tracking is off or no library has been read yet.
+XUNE_SYNC_API int zune_device_refresh_user_states(zune_device_handle_t handle);
+// Build the album / artist / genre / atom_id lookup indexes for library once (O(n)) so
+// grouping queries no longer scan the arrays. Works with any library returned above;
+// the index must not outlive it. Returns NULL if library is NULL.
+XUNE_SYNC_API zune_library_index_t zune_library_index_create(const ZuneMusicLibrary* library);
+XUNE_SYNC_API void zune_library_index_free(zune_library_index_t index);
+// Tracks whose album_ref is album_atom_id (indices into library->tracks)
+XUNE_SYNC_API ZuneIndexRange zune_library_tracks_for_album(zune_library_index_t index, uint32_t album_atom_id);
+// Albums whose artist_ref is artist_atom_id (indices into library->albums)
+XUNE_SYNC_API ZuneIndexRange zune_library_albums_for_artist(zune_library_index_t index, uint32_t artist_atom_id);
+// Tracks whose genre_ref is genre_atom_id (indices into library->tracks)
+XUNE_SYNC_API ZuneIndexRange zune_library_tracks_for_genre(zune_library_index_t index, uint32_t genre_atom_id);
+// Index into library->tracks of the track with atom_id, or -1 if there is none
+XUNE_SYNC_API int32_t zune_library_find_track_by_atom(zune_library_index_t index, uint32_t atom_id);
 XUNE_SYNC_API int zune_device_download_file(zune_device_handle_t handle, uint32_t object_handle, const char* destination_path);
 XUNE_SYNC_API int zune_device_delete_file(zune_device_handle_t handle, uint32_t object_handle);
 
+// Batch delete, e.g. an artist's tracks, artwork, album objects and folders
+// in one call instead of one zune_device_delete_file each. Objects go in a
+// safe order (files, then albums and playlists, then folders deepest first)
+// under one MTP grant, and the tracked library, folder cache and content
+// index are updated as they go. Planning costs two property lists.
+// out_results (optional, count entries) receives 0 per object deleted or
+// already gone, -1 per object still on the device.
+// Returns objects not deleted (0 = all), -1 on bad arguments, no session or
+// a failed property list query.
+typedef enum {
+    ZUNE_DELETE_DEFAULT = 0,
+    // A folder listed with its whole contents is deleted alone and the device
+    // removes what it holds; if it refuses, the contents go one by one first
+    ZUNE_DELETE_COLLAPSE_FOLDERS = 1
+} ZuneDeleteFlags;
+XUNE_SYNC_API int zune_device_delete_objects(
+    zune_device_handle_t handle,
+    const uint32_t* object_handles,
+    uint32_t count,
+    uint32_t flags,
+    int* out_results);
+
+// Batch artwork download, e.g. every ZuneAlbumArtwork::mtp_object_id of a library.
+// Item i goes to destination_paths[i]; when destination_paths is NULL or an
+// entry is NULL, its artwork is passed to callback instead (data is valid
+// only during the call; return false to stop). The next item is fetched
+// while the current one is written. A file that already holds exactly the
+// object's artwork (its RepresentativeSampleSize in bytes) is kept and not
+// fetched again.
+// out_results (optional, count entries) receives a ZuneArtworkStatus per item.
+// Returns 0 when every item was attempted, -1 on bad arguments or no
+// session, -2 if the callback stopped.
+typedef enum {
+    ZUNE_ARTWORK_DOWNLOADED = 0,
+    ZUNE_ARTWORK_CACHED = 1,       // Existing file kept, nothing fetched
+    ZUNE_ARTWORK_FAILED = -1       // Fetch or write failed, or not reached
+} ZuneArtworkStatus;
+typedef bool (*zune_artwork_data_callback_t)(
+    uint32_t index, uint32_t object_handle, const uint8_t* data, uint32_t size, void* user_data);
+XUNE_SYNC_API int zune_device_download_artwork_batch(
+    zune_device_handle_t handle,
+    const uint32_t* object_handles,
+    const char* const* destination_paths,
+    uint32_t count,
+    zune_artwork_data_callback_t callback,
+    void* user_data,
+    int* out_results
+);
+
 // Streaming/Partial Downloads
 XUNE_SYNC_API int zune_device_get_partial_object(
     zune_device_handle_t handle,
@@ -256,6 +426,41 @@ XUNE_SYNC_API int zune_device_get_partial_object(
 XUNE_SYNC_API void zune_device_free_partial_data(uint8_t* data);
 XUNE_SYNC_API uint64_t zune_device_get_object_size(zune_device_handle_t handle, uint32_t object_id);
 XUNE_SYNC_API const char* zune_device_get_object_filename(zune_device_handle_t handle, uint32_t object_id);
+// Text of a video or podcast episode (object_id = its atom_id), read from the device.
+// Valid until the next call on the same thread; "" if the object has none.
+typedef enum {
+    ZUNE_MEDIA_DETAIL_DESCRIPTION = 0,
+    ZUNE_MEDIA_DETAIL_URL = 1          // Episode download URL (MTP 0xDD60)
+} ZuneMediaDetail;
+XUNE_SYNC_API const char* zune_device_get_media_detail(zune_device_handle_t handle, uint32_t object_id, ZuneMediaDetail detail);
+
+// Stream an object from offset to its end in chunk_size pieces (0 = 1 MB).
+// The next chunk is fetched while the callback handles the current one;
+// chunks arrive in order on the calling thread. Return false to stop.
+// out_next_offset (optional) receives the offset after the last delivered
+// byte: pass it back as offset to resume an interrupted download.
+// Returns 0 on success, -1 on a device error, -2 if the callback stopped.
+typedef bool (*zune_download_chunk_callback_t)(
+    const uint8_t* data, uint32_t size, uint64_t offset, void* user_data);
+XUNE_SYNC_API int zune_device_download_object(
+    zune_device_handle_t handle,
+    uint32_t object_id,
+    uint64_t offset,
+    uint32_t chunk_size,
+    zune_download_chunk_callback_t callback,
+    void* user_data,
+    uint64_t* out_next_offset
+);
+// As above, writing each chunk to fd at its current position. To resume,
+// position fd at the end of what was written and pass out_next_offset back.
+// -2 means a write to fd failed.
+XUNE_SYNC_API int zune_device_download_object_to_fd(
+    zune_device_handle_t handle,
+    uint32_t object_id,
+    int fd,
+    uint64_t offset,
+    uint64_t* out_next_offset
+);
 
 // Dynamic ObjectId resolution
 // Query MTP for a specific audio track's ObjectId by title/filename within an album context.
@@ -277,6 +482,23 @@ XUNE_SYNC_API uint32_t zune_device_get_audio_track_object_id(
     uint32_t album_object_id
 );
 
+// Batch ObjectId resolution
+// Fill the cache used by zune_device_get_audio_track_object_id for many albums at once,
+// e.g. before creating playlists. Costs one MTP request for every object's name plus one
+// reference query per album, instead of one request per track.
+//
+// Parameters:
+//   handle - Device handle from zune_device_create()
+//   album_object_ids - MTP ObjectIds of the albums to resolve, or NULL for every album on the device
+//   count - Number of entries in album_object_ids
+// Returns:
+//   The number of tracks added to the cache, or -1 on error
+XUNE_SYNC_API int zune_device_prewarm_track_cache(
+    zune_device_handle_t handle,
+    const uint32_t* album_object_ids,
+    uint32_t count
+);
+
 // ============================================================================
 // Playlist Management
 // ============================================================================
@@ -320,6 +542,44 @@ XUNE_SYNC_API int zune_device_delete_playlist(
     uint32_t playlist_id
 );
 
+// Staged playlist edits, for hosts that edit interactively (drag to reorder).
+// Each call only replaces the staged track list; one write per playlist goes to
+// the device on zune_device_commit_playlists, once the playlist has had no edit
+// for the debounce, or at disconnect. Deleting a playlist drops its staged edits.
+
+/// Stage the full track list of an existing playlist
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_stage_playlist_tracks(
+    zune_device_handle_t handle,
+    uint32_t playlist_id,
+    const uint32_t* track_ids,
+    size_t track_count
+);
+
+/// Stage a playlist that does not exist yet, keyed by guid; it is created with its
+/// last staged name and tracks in one zune_device_create_playlist. Staging the same
+/// guid after that updates the created playlist.
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_stage_new_playlist(
+    zune_device_handle_t handle,
+    const char* name,
+    const char* guid,
+    const uint32_t* track_ids,
+    size_t track_count,
+    uint32_t playlists_folder_id
+);
+
+/// Write every staged edit now
+/// @return Number of playlists the device rejected (not retried), -1 on bad handle
+XUNE_SYNC_API int zune_device_commit_playlists(zune_device_handle_t handle);
+
+/// MTP object ID a playlist staged as new was created with, 0 until it has been
+XUNE_SYNC_API uint32_t zune_device_get_staged_playlist_id(zune_device_handle_t handle, const char* guid);
+
+/// Quiet time after a playlist's last staged edit before it is written.
+/// 0 (the default) writes only on zune_device_commit_playlists and at disconnect.
+XUNE_SYNC_API void zune_device_set_playlist_debounce(zune_device_handle_t handle, uint32_t milliseconds);
+
 // Track User State (Play Count, Skip Count, Rating)
 /// Set track user state metadata via MTP SetObjectPropValue.
 /// @param handle Device handle from zune_device_create()
@@ -336,13 +596,92 @@ XUNE_SYNC_API int zune_device_set_track_user_state(
     int rating
 );
 
+/// One track for zune_device_set_track_user_states; -1 leaves a value alone
+struct ZuneTrackUserState {
+    uint32_t zmdb_atom_id;
+    int play_count;         // UseCount (0xDC91)
+    int skip_count;         // Not writable (see above); pass -1
+    int rating;             // UserRating (0xDC8A)
+};
+
+/// Set user state for many tracks: one SetObjectPropList per 256 tracks
+/// instead of a SetObjectPropValue per value. A chunk the device rejects
+/// is retried one property at a time, so each failure is reported on its
+/// own track; if the device does not support SetObjectPropList at all, the
+/// remaining chunks go straight to single writes.
+/// @param out_status count entries: the zune_device_set_track_user_state
+///        code for each track (-5: skip_count ignored, other values written)
+/// @return Tracks fully applied, -1 on bad arguments, -2 not connected
+XUNE_SYNC_API int zune_device_set_track_user_states(
+    zune_device_handle_t handle,
+    const ZuneTrackUserState* states,
+    uint32_t count,
+    int* out_status
+);
+
+// Artist Metadata Backfill (HD)
+/// One artist for zune_device_backfill_artist_metadata. artist_id and
+/// tracks_done are updated as work completes; passing the same items back
+/// after an interruption resumes where the last call stopped.
+struct ZuneArtistBackfillItem {
+    const char* name;
+    const uint8_t* guid_bytes;      // 16-byte artist GUID (DA97), or NULL
+    const uint32_t* track_ids;      // Tracks to reference this artist (ArtistId 0xDAB9)
+    uint32_t track_count;
+    uint32_t artist_id;             // In/out: existing .art object, or 0 to create one
+    uint32_t tracks_done;           // In/out: leading track_ids already referenced
+};
+
+/// Called after each artist object created and each batch of track
+/// references written. Return false to stop; items record how far it got.
+typedef bool (*zune_artist_backfill_callback_t)(
+    uint32_t artists_done, uint32_t artist_count,
+    uint64_t tracks_done, uint64_t track_total, void* user_data);
+
+/// Give an existing library artist metadata: create each missing .art
+/// object in artists_folder back to back (no per-artist readback), then set
+/// ArtistId on that artist's tracks with one SetObjectPropList per 512
+/// tracks rather than an UpdateTrackProperties per track. An artist or
+/// batch the device rejects is left for the next call.
+/// @return Artists fully done, -1 on bad arguments, -2 not connected
+XUNE_SYNC_API int zune_device_backfill_artist_metadata(
+    zune_device_handle_t handle,
+    uint32_t artists_folder,
+    ZuneArtistBackfillItem* items,
+    uint32_t count,
+    zune_artist_backfill_callback_t callback,
+    void* user_data
+);
+
 // USB Discovery functions
 XUNE_SYNC_API bool zune_device_find_on_usb(const char** uuid, const char** device_name);
 
+// Serial numbers of the Zunes on USB that no handle has open. Strings stay
+// valid until the next call on the same thread.
+// @return Number found (may exceed capacity; only capacity are written), or -1 on error
+XUNE_SYNC_API int zune_device_list_usb(const char** serials, int capacity);
+
 // Lightweight USB detection — checks sysfs/IOKit for Zune VID/PID only.
 // Does NOT open the device or claim any USB interfaces.
 XUNE_SYNC_API bool zune_device_detect_on_usb();
 
+// USB hotplug: called on a library thread when a Microsoft (VID 045E)
+// device is plugged in or removed
+typedef void (*usb_hotplug_callback_t)(bool arrived, uint16_t product_id, void* user_data);
+
+// Watch for Zunes being plugged in or removed using OS notifications, instead
+// of calling the functions above on a timer. Devices already connected are
+// reported first. While it runs, zune_device_detect_on_usb answers from the
+// devices it knows and zune_device_connect_usb opens the known device without
+// enumerating the bus. Returns false if already started.
+XUNE_SYNC_API bool zune_usb_hotplug_start(usb_hotplug_callback_t callback, void* user_data);
+XUNE_SYNC_API void zune_usb_hotplug_stop();
+
+// Log lines from the hotplug monitor (arrivals and removals at INFO,
+// enumeration trouble at WARNING), delivered like a device's log callback.
+// NULL stops them.
+XUNE_SYNC_API void zune_usb_hotplug_set_log_callback(log_callback_t callback);
+
 // SSDP Discovery functions
 XUNE_SYNC_API void zune_ssdp_start_discovery(device_discovered_callback_t callback);
 XUNE_SYNC_API void zune_ssdp_stop_discovery();
@@ -359,6 +698,12 @@ typedef enum {
     ZUNE_ARTIST_METADATA_MODE_HYBRID = 3     // Try local files first, proxy if not found, cache responses
 } ZuneArtistMetadataMode;
 
+/// Congestion control for the interceptor's TCP responses
+typedef enum {
+    ZUNE_CONGESTION_CONTROL_USB_LINK = 0,   // Full receiver window, paced by the 0x922c rate
+    ZUNE_CONGESTION_CONTROL_RENO = 1        // RFC 5681 slow start, for comparison
+} ZuneCongestionControl;
+
 /// Configuration for artist metadata interception.
 /// Static mode uses C# path resolver callbacks (no directory config needed).
 /// Proxy mode forwards to the configured HTTP server.
@@ -375,6 +720,31 @@ typedef struct {
 
     // Server IP for DNS resolution (e.g., "192.168.0.30")
     const char* server_ip;              // IP address that DNS will resolve to (port 80)
+
+    // Proxied responses are passed to the cache storage callback on a
+    // background thread after they are sent; requests wait when it falls
+    // this far behind
+    int cache_write_queue_depth;        // Queued writes (0 = default 32)
+    int cache_write_queue_limit_kb;     // Queued body bytes in KB (0 = default 64 MB)
+
+    // Request workers: a fast lane for cache hits, local files and
+    // biography XML, and a slow lane for upstream fetches
+    int fast_lane_workers;              // 0 = default 2
+    int slow_lane_workers;              // 0 = default 4
+
+    // Responses go to the device as PPP frames packed into 0x922c
+    // transfers; a transfer that is not full may wait briefly for more
+    int usb_transfer_budget;            // Bytes per transfer (0 = default 7680)
+    int coalesce_max_wait_us;           // Longest wait (0 = default 2000, negative = never wait)
+
+    ZuneCongestionControl congestion_control;  // Default USB link
+
+    // Frames to the device are MPPC-compressed when it offers MPPC in CCP
+    int disable_ppp_compression;        // Nonzero: reject the offer, send uncompressed
+
+    // Reactor mode: the poll thread answers cached metadata itself and sends
+    // every response; local files and upstream fetches still go to workers
+    int reactor_mode;                   // Nonzero: serve from the poll thread
 } ZuneArtistMetadataConfig;
 
 /// Start the artist metadata HTTP interceptor
@@ -480,6 +850,183 @@ XUNE_SYNC_API void zune_device_set_cache_storage_callback(
     void* user_data
 );
 
+/// In-memory cache of metadata responses served to the device. Repeated
+/// requests for the same host, path and query are answered from it without
+/// calling the path resolver or the proxy server. It lives as long as the
+/// connection and is cleared when a different path resolver is registered.
+/// Once the device asks for anything about an artist, that artist's
+/// biography, images, background and listed images are fetched into it in
+/// the background.
+struct ZuneMetadataCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;     // Entries dropped to stay within capacity
+    uint64_t entries;
+    uint64_t bytes;         // Bytes currently held
+    uint64_t capacity;      // Byte budget (32 MB by default)
+    uint64_t prefetched;    // Artist resources fetched before the device asked
+    uint64_t prefetch_hits; // Prefetched responses the device then requested
+};
+
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_metadata_cache_stats(
+    zune_device_handle_t handle, ZuneMetadataCacheStats* out);
+
+/// Drop every cached response, e.g. after the files behind the resolver changed
+XUNE_SYNC_API void zune_device_clear_metadata_cache(zune_device_handle_t handle);
+
+/// Byte budget of the cache; 0 disables it. Takes effect once connected.
+XUNE_SYNC_API void zune_device_set_metadata_cache_capacity(
+    zune_device_handle_t handle, uint64_t capacity_bytes);
+
+/// Native on-disk store for Static and Hybrid modes, used in place of the
+/// path resolver and cache storage callbacks when those are not registered
+/// (a registered callback still takes precedence). Lookups need no call
+/// into the host. Bodies are kept once each by content, in directory/blobs,
+/// and indexed in directory/metadata.xmdc; entries older than ttl_seconds
+/// expire, and past max_bytes the least recently served are evicted.
+struct ZuneMetadataDiskCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t expired;       // Entries dropped for their age
+    uint64_t evictions;     // Entries dropped to stay within max_bytes
+    uint64_t entries;
+    uint64_t blobs;         // Distinct bodies on disk
+    uint64_t bytes;         // Their total size
+    uint64_t capacity;      // max_bytes
+};
+
+/// @param directory NULL or "" closes the store
+/// @param max_bytes 0 = unbounded
+/// @param ttl_seconds 0 = never expire
+/// @return 0 on success, -1 on bad arguments or if directory cannot be created
+XUNE_SYNC_API int zune_device_set_metadata_disk_cache(
+    zune_device_handle_t handle, const char* directory, uint64_t max_bytes, uint64_t ttl_seconds);
+
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_metadata_disk_cache_stats(
+    zune_device_handle_t handle, ZuneMetadataDiskCacheStats* out);
+
+/// Scale a JPEG to width pixels wide, keeping its aspect ratio, writing the
+/// new JPEG into out (out_capacity bytes, the input size). Return its size,
+/// or 0 to send the original. Called from the HTTP worker and prefetch
+/// threads, possibly several at once.
+typedef uint32_t (*zune_image_resize_callback_t)(
+    const uint8_t* jpeg, uint32_t size, uint32_t width,
+    uint8_t* out, uint32_t out_capacity, void* user_data);
+
+/// Device-sized copies of the local images the path resolver returns. The
+/// device asks for /image/{id} and deviceBackgroundImage with width=480 and
+/// resize=true; in Static and Hybrid modes a JPEG wider than that is sent
+/// resized by the callback instead, each image and width resized once and
+/// kept (16 MB budget) for as long as the connection.
+struct ZuneImageVariantStats {
+    uint64_t hits;
+    uint64_t misses;        // Images resized, or found narrow enough, on request
+    uint64_t waits;         // Requests that waited on the same image's resize
+    uint64_t resized;       // Smaller copies made by the callback
+    uint64_t kept;          // Sent as they are: no wider than asked, or declined
+    uint64_t bytes_in;      // Resized images, as the files hold them
+    uint64_t bytes_out;     // The same images, as sent
+    uint64_t entries;
+    uint64_t bytes;         // Bytes currently held
+};
+
+/// NULL sends local images as they are (the default). Takes effect once connected.
+XUNE_SYNC_API void zune_device_set_image_resize_callback(
+    zune_device_handle_t handle, zune_image_resize_callback_t callback, void* user_data);
+
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_image_variant_stats(
+    zune_device_handle_t handle, ZuneImageVariantStats* out);
+
+/// One lane of the interceptor's HTTP request workers
+struct ZuneHTTPWorkerLaneStats {
+    uint64_t workers;
+    uint64_t queued;            // Requests routed to this lane
+    uint64_t completed;
+    uint64_t stolen;            // Served by the other lane's idle workers
+    uint64_t depth;             // Waiting now
+    uint64_t wait_us_total;     // Time queued before a worker took it
+    uint64_t wait_us_max;
+    uint64_t service_us_total;  // Time to serve once taken
+    uint64_t service_us_max;
+};
+
+/// Counters since the interceptor started; zeroed when it is not running.
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_http_worker_stats(
+    zune_device_handle_t handle,
+    ZuneHTTPWorkerLaneStats* fast_lane,
+    ZuneHTTPWorkerLaneStats* slow_lane);
+
+/// One TCP connection from the device to the interceptor
+struct ZuneTCPConnectionStats {
+    uint32_t device_ip;
+    uint32_t device_port;
+    uint32_t server_ip;             // Address the device connected to
+    uint32_t server_port;
+    uint32_t state;                 // 0 CLOSED, 3 SYN_RECEIVED, 4 ESTABLISHED, 7 CLOSE_WAIT, 9 LAST_ACK
+    uint32_t receiver_window;       // Last window the device advertised
+    uint64_t cwnd;                  // Congestion window, bytes
+    uint64_t ssthresh;              // Slow start threshold, bytes
+    uint64_t bytes_in_flight;
+    int32_t srtt_ms;                // Smoothed RTT; -1 before the first sample
+    uint32_t rto_ms;
+    uint32_t unacked_segments;
+    uint32_t active_transmissions;  // HTTP responses being sent
+    uint32_t fast_retransmits;      // Loss recoveries started by duplicate ACKs
+    uint32_t rto_retransmits;
+    uint32_t sack_permitted;        // 1 if the device negotiated SACK
+};
+
+/// Counters and gauges of the interceptor's network stack
+struct ZuneNetworkStats {
+    uint64_t http_requests;
+    uint64_t responses_started;       // Responses whose first segment went to TCP
+    uint64_t first_segment_us_total;  // Request parsed to its first response segment
+    uint64_t first_segment_us_max;
+    uint64_t first_segment_us_last;
+    uint64_t requests_completed;      // By the request workers, both lanes
+    uint64_t request_wait_us_total;   // Queued before a worker took it, both lanes
+    uint64_t request_wait_us_max;
+    uint64_t fast_retransmits;        // All connections, including closed ones
+    uint64_t rto_retransmits;
+    uint64_t response_queue_depth;    // PPP frames waiting for 0x922c
+    uint64_t usb_transfers;           // 0x922c operations
+    uint64_t usb_bytes_sent;
+    uint64_t bytes_per_second;        // Sent to the device in the last full second
+    uint64_t compressed_frames;       // IP frames sent MPPC-compressed
+    uint64_t compression_bytes_in;    // Those frames' packets before compression
+    uint64_t compression_bytes_out;   // And after
+    uint32_t connection_count;        // All connections, even past capacity
+    uint32_t ppp_compression;         // 1 while MPPC is in use
+};
+
+/// Snapshot since the interceptor started; zeroed when it is not running.
+/// Fills connections with up to capacity entries (connections may be NULL
+/// if capacity is 0).
+/// @return Connections written, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_network_stats(
+    zune_device_handle_t handle,
+    ZuneNetworkStats* out,
+    ZuneTCPConnectionStats* connections,
+    uint32_t capacity);
+
+/// Capture raw PPP traffic in both directions into an in-memory ring of the
+/// last max_transfers USB transfers, replacing any earlier capture; 0 stops
+/// capturing. Much cheaper than verbose logging. Needs a connected device.
+/// @return 0 on success, -1 on bad arguments or no device connection
+XUNE_SYNC_API int zune_device_set_packet_capture(
+    zune_device_handle_t handle, uint32_t max_transfers);
+
+/// Write the captured frames to a pcap file for Wireshark (PPP with
+/// direction link type); capturing carries on.
+/// @return Frames written, -1 on bad arguments or if the file can't be written
+XUNE_SYNC_API int64_t zune_device_write_packet_capture(
+    zune_device_handle_t handle, const char* path);
+
 // ============================================================================
 // HTTP Network Operations
 // ============================================================================
@@ -507,6 +1054,8 @@ XUNE_SYNC_API void zune_device_enable_network_polling(
 
 /// Perform one network polling cycle: PollEvent → Op922d → ProcessPacket → ProcessPendingSends.
 /// Called from C# in a loop for clean cancellation (no native monitoring thread).
+/// The wait ends early when a sent segment's retransmission timeout is due,
+/// and due retransmits are sent before reading the device.
 /// @param handle Device handle
 /// @param timeout_ms USB interrupt timeout in milliseconds (0 = non-blocking)
 /// @return 1 = processed data, 0 = timeout/no data, -1 = not running/error, -2 = no session
@@ -515,9 +1064,47 @@ XUNE_SYNC_API int zune_device_poll_network_data(
     int timeout_ms
 );
 
-/// Enable or disable verbose network logging
+/// Events of the native poll loop
+typedef enum {
+    ZUNE_NETWORK_POLL_ACTIVE = 1,   // Data or transmissions after an idle spell; polling hot
+    ZUNE_NETWORK_POLL_IDLE = 2,     // Nothing in flight; backed off to the idle wait
+    ZUNE_NETWORK_POLL_STOPPED = 3   // Loop ended; result is 0 if stopped, else the poll error (-1, -2)
+} ZuneNetworkPollEvent;
+
+/// Called on the poll loop's thread. It may call zune_device_stop_network_poll_loop.
+typedef void (*zune_network_poll_event_callback_t)(
+    ZuneNetworkPollEvent event, int result, void* user_data);
+
+/// Run the poll cycle on a native thread instead of calling
+/// zune_device_poll_network_data in a loop. Polls with hot_wait_ms while
+/// segments are in flight or data arrives, and doubles the wait on each
+/// empty cycle up to idle_wait_ms. Ends on a poll error or when stopped;
+/// stopping the interceptor stops it too.
+/// @param hot_wait_ms Wait while active (0 = non-blocking, negative = default 1)
+/// @param idle_wait_ms Longest wait when idle (0 or negative = default 250)
+/// @param callback Event callback, may be NULL
+/// @return Cancellation token (> 0) for zune_device_stop_network_poll_loop,
+///         0 if a loop is already running or there is no network session
+XUNE_SYNC_API uint64_t zune_device_start_network_poll_loop(
+    zune_device_handle_t handle,
+    int hot_wait_ms,
+    int idle_wait_ms,
+    zune_network_poll_event_callback_t callback,
+    void* user_data
+);
+
+/// Stop the loop started with token and wait for it to end (unless called
+/// from its own callback). A stale token leaves a newer loop running.
+/// @return true if the loop was stopped, false for an unknown token
+XUNE_SYNC_API bool zune_device_stop_network_poll_loop(
+    zune_device_handle_t handle,
+    uint64_t token
+);
+
+/// Enable or disable verbose network logging (off by default)
 /// @param handle Device handle
-/// @param enable true to enable verbose TCP/IP packet logging, false for errors only
+/// @param enable true sets PPP, TCP and HTTP logging to ZUNE_LOG_DEBUG,
+///               false back to ZUNE_LOG_INFO
 XUNE_SYNC_API void zune_device_set_verbose_network_logging(
     zune_device_handle_t handle,
     bool enable
@@ -590,6 +1177,199 @@ XUNE_SYNC_API bool zune_device_read_sync_status(
 XUNE_SYNC_API bool zune_device_close_session(
     zune_device_handle_t handle);
 
+// ============================================================================
+// Transfer Statistics
+// ============================================================================
+// Per-device counters for the MTP operations that carry sync traffic.
+// Latency is measured around each operation on the host, so it includes the
+// device's response time; compare bytes/s against the ~35 MB/s a USB 2.0
+// bulk link sustains to tell a slow device from a slow host.
+
+/// Instrumented operations
+typedef enum {
+    ZUNE_TRANSFER_OP_SEND_OBJECT_PROP_LIST = 0,
+    ZUNE_TRANSFER_OP_SEND_OBJECT,
+    ZUNE_TRANSFER_OP_GET_OBJECT_PROP_LIST,
+    ZUNE_TRANSFER_OP_GET_PARTIAL_OBJECT,
+    ZUNE_TRANSFER_OP_NETWORK_SEND,     // 0x922c
+    ZUNE_TRANSFER_OP_NETWORK_POLL,     // 0x922d
+    ZUNE_TRANSFER_OP_COUNT
+} ZuneTransferOp;
+
+/// Latency histogram buckets: bucket 0 counts operations under 1 us, bucket
+/// i counts [2^(i-1), 2^i) us, and the last bucket everything from 2^22 us
+/// (~4.2 s) up.
+#define ZUNE_TRANSFER_HISTOGRAM_BUCKETS 24
+
+struct ZuneTransferOpStats {
+    uint64_t count;
+    uint64_t failures;              // Operations that threw
+    uint64_t total_us;
+    uint64_t max_us;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t histogram[ZUNE_TRANSFER_HISTOGRAM_BUCKETS];
+};
+
+struct ZuneTransferStats {
+    uint64_t bytes_sent;            // Sum over ops
+    uint64_t bytes_received;
+    ZuneTransferOpStats ops[ZUNE_TRANSFER_OP_COUNT];  // Indexed by ZuneTransferOp
+};
+
+/// Fill out with the counters accumulated since connect (or the last reset).
+/// Counters are read individually while transfers may be running, so the
+/// snapshot is not an atomic cut across ops.
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_transfer_stats(
+    zune_device_handle_t handle, ZuneTransferStats* out);
+
+XUNE_SYNC_API void zune_device_reset_transfer_stats(zune_device_handle_t handle);
+
+/// Live progress for SendObject payloads and streamed downloads
+/// (ZUNE_TRANSFER_OP_GET_PARTIAL_OBJECT). bytes_per_second is the average
+/// since the data phase started. Runs on the transferring thread.
+typedef void (*zune_transfer_progress_callback_t)(
+    int op, uint64_t bytes_done, uint64_t bytes_total,
+    double bytes_per_second, void* user_data);
+
+/// Register (or clear, with NULL) the progress callback. Without one the
+/// data path does no progress work at all.
+XUNE_SYNC_API void zune_device_set_transfer_progress_callback(
+    zune_device_handle_t handle, zune_transfer_progress_callback_t callback,
+    void* user_data);
+
+// ============================================================================
+// Tracing
+// ============================================================================
+// Process-wide spans for the connect phases (USB enumeration, Device::Open,
+// OpenSession, MTPZ, identification) and every MtpReader / MtpWriter call,
+// to see where a slow connect or sync start spends its time. The newest
+// 8192 spans are kept. Off by default; while off, instrumented code only
+// checks a flag.
+
+struct ZuneTraceSpan {
+    const char* category;   // "connect", "MtpReader", "MtpWriter"; static strings
+    const char* name;
+    uint64_t start_us;      // Steady clock, since the library first traced
+    uint64_t duration_us;
+    uint32_t thread;        // Small per-thread number
+};
+
+XUNE_SYNC_API void zune_trace_set_enabled(bool enable);
+
+/// Copy up to capacity spans, oldest first. With out NULL, only count them.
+/// @return Spans copied (or held, with out NULL)
+XUNE_SYNC_API size_t zune_trace_get_spans(ZuneTraceSpan* out, size_t capacity);
+
+/// Forget every span recorded so far
+XUNE_SYNC_API void zune_trace_clear();
+
+/// Write the spans as Chrome trace-event JSON (chrome://tracing, Perfetto)
+/// @return 0 on success, -1 on bad arguments or a write error
+XUNE_SYNC_API int zune_trace_export_chrome(const char* path);
+
+// ============================================================================
+// Asynchronous Operations
+// ============================================================================
+// _async variants of the long calls run on a worker thread the library owns,
+// one per device, in submission order; the calling thread returns at once.
+// They take the same MTP scheduling grants as the blocking calls, so mixing
+// the two is safe. Callbacks run on the worker and may call back into the
+// API (including zune_async_cancel), but must not destroy the device.
+// zune_device_disconnect cancels everything queued and waits for the
+// running operation.
+
+/// Operation id; 0 means the call was rejected (NULL handle or arguments)
+typedef uint64_t zune_async_op_t;
+
+typedef enum {
+    ZUNE_ASYNC_DONE = 0,        // Ran; result is the blocking call's return value
+    ZUNE_ASYNC_CANCELLED = 1,   // Cancelled before it ran, or stopped early; result -1
+    ZUNE_ASYNC_FAILED = 2       // Threw; result -1
+} ZuneAsyncStatus;
+
+/// Bytes done of total. Only uploads report progress.
+typedef void (*zune_async_progress_callback_t)(
+    zune_async_op_t op, uint64_t done, uint64_t total, void* user_data);
+
+/// Called exactly once per accepted operation. data is the operation's
+/// output: the ZuneMusicLibrary* for zune_device_get_music_library_async
+/// (free it with zune_device_free_music_library), NULL otherwise.
+typedef void (*zune_async_complete_callback_t)(
+    zune_async_op_t op, ZuneAsyncStatus status, int result, void* data, void* user_data);
+
+/// zune_device_get_music_library; result is 0, or -1 if no library was read
+XUNE_SYNC_API zune_async_op_t zune_device_get_music_library_async(
+    zune_device_handle_t handle, zune_async_complete_callback_t complete, void* user_data);
+
+/// zune_upload_send_audio. Like the blocking call it must be the next
+/// operation after zune_upload_create_track. Cancelling stops it only
+/// before the SendObject starts.
+XUNE_SYNC_API zune_async_op_t zune_upload_send_audio_async(
+    zune_device_handle_t handle, const char* file_path,
+    zune_async_progress_callback_t progress, zune_async_complete_callback_t complete,
+    void* user_data);
+
+XUNE_SYNC_API zune_async_op_t zune_device_download_file_async(
+    zune_device_handle_t handle, uint32_t object_handle, const char* destination_path,
+    zune_async_complete_callback_t complete, void* user_data);
+
+XUNE_SYNC_API zune_async_op_t zune_device_erase_all_content_async(
+    zune_device_handle_t handle, zune_async_complete_callback_t complete, void* user_data);
+
+/// Cancel op. A queued operation completes as ZUNE_ASYNC_CANCELLED without
+/// running; a running one stops where it safely can, or runs to the end.
+/// @return false if op is unknown or has already completed
+XUNE_SYNC_API bool zune_async_cancel(zune_device_handle_t handle, zune_async_op_t op);
+
+/// Operations queued or running on the device's worker
+XUNE_SYNC_API uint32_t zune_async_pending(zune_device_handle_t handle);
+
+// ============================================================================
+// MTP Scheduling
+// ============================================================================
+// The device's MTP transactions (uploads, reads, the HTTP interceptor's
+// network polling) are serialized by priority: when the session frees up,
+// the highest-priority waiter goes next. Priority applies between
+// operations; a SendObject in progress is never interrupted.
+
+/// Scheduling classes, highest priority first
+typedef enum {
+    ZUNE_MTP_CLASS_NETWORK = 0,     // 0x922c / 0x922d for the HTTP interceptor
+    ZUNE_MTP_CLASS_CONTROL,         // Object creation, properties, deletes, verification
+    ZUNE_MTP_CLASS_READ,            // GetPartialObject, library and artwork reads
+    ZUNE_MTP_CLASS_BULK,            // SendObject payloads
+    ZUNE_MTP_CLASS_COUNT
+} ZuneMtpOpClass;
+
+struct ZuneMtpClassStats {
+    uint64_t count;                 // Operations granted
+    uint64_t queued;                // Of those, how many had to wait
+    uint64_t total_wait_us;         // Time spent queued
+    uint64_t max_wait_us;
+    uint64_t total_hold_us;         // Time spent holding the session
+    uint64_t bypassed;              // Times a higher class went first while this one waited
+    uint32_t waiting;               // Queued right now
+};
+
+struct ZuneMtpSchedulerStats {
+    uint32_t max_bypass;            // Current fairness limit
+    ZuneMtpClassStats classes[ZUNE_MTP_CLASS_COUNT];  // Indexed by ZuneMtpOpClass
+};
+
+/// Fill out with the scheduler's per-class queue-wait counters
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_mtp_scheduler_stats(
+    zune_device_handle_t handle, ZuneMtpSchedulerStats* out);
+
+XUNE_SYNC_API void zune_device_reset_mtp_scheduler_stats(zune_device_handle_t handle);
+
+/// A waiting class goes next once higher classes have overtaken it
+/// max_bypass times in a row (default 8); 0 is strict priority.
+XUNE_SYNC_API void zune_device_set_mtp_scheduler_fairness(
+    zune_device_handle_t handle, uint32_t max_bypass);
+
 // ============================================================================
 // Low-Level MTP Primitives
 // ============================================================================
@@ -983,10 +1763,249 @@ XUNE_SYNC_API uint32_t zune_upload_create_track(
 XUNE_SYNC_API int zune_upload_send_audio(
     zune_device_handle_t handle, const char* file_path);
 
-/// Verify track (GetObjPropList ALL)
+/// When uploaded objects are read back. Zune Desktop reads every track back
+/// after its data, and every album after its references; that is the default.
+typedef enum {
+    ZUNE_UPLOAD_VERIFY_PER_OBJECT = 0,  // verify_track / verify_album read as Zune Desktop does
+    ZUNE_UPLOAD_VERIFY_BATCHED = 1,     // One ObjectSize list over the album's folder at album end
+    ZUNE_UPLOAD_VERIFY_DEFERRED = 2     // One ObjectSize list over the device in verify_session
+} ZuneUploadVerifyPolicy;
+
+/// Set the read-back policy for the upload calls and zune_upload_tracks (per object by default).
+/// Batched and deferred checks confirm each track is listed at the size that was sent.
+XUNE_SYNC_API void zune_device_set_upload_verify_policy(
+    zune_device_handle_t handle, ZuneUploadVerifyPolicy policy);
+
+/// Verify track (GetObjPropList ALL). Does nothing unless the policy is per object.
 XUNE_SYNC_API int zune_upload_verify_track(
     zune_device_handle_t handle, uint32_t track_id);
 
+/// Check every track uploaded since the last check with one ObjectSize list
+/// (ZUNE_UPLOAD_VERIFY_DEFERRED; also settles what a batched album check has not).
+/// @return Number of tracks missing or short on the device, -1 if the list could not be read
+XUNE_SYNC_API int zune_upload_verify_session(zune_device_handle_t handle);
+
+// --- Batch Track Upload ---
+
+/// Per-item outcome of zune_upload_tracks
+typedef enum {
+    ZUNE_UPLOAD_OK = 0,
+    ZUNE_UPLOAD_READ_FAILED = -1,      // File missing or unreadable
+    ZUNE_UPLOAD_CREATE_FAILED = -2,    // SendObjectPropList rejected (see mtp_error)
+    ZUNE_UPLOAD_TRANSFER_FAILED = -3,  // SendObject or verify failed
+    ZUNE_UPLOAD_CANCELLED = -4         // Not attempted: the batch was stopped
+} ZuneUploadStatus;
+
+struct ZuneUploadItem {
+    const char* file_path;
+    uint32_t album_folder;          // Parent folder for the track object
+    uint32_t artist_meta_id;        // HD: artist reference when props is NULL
+    const ZuneTrackProps* props;    // NULL = read tags from file_path
+};
+
+struct ZuneUploadItemResult {
+    uint32_t index;                 // Position in the items array
+    uint32_t track_id;              // MTP handle, 0 unless status is ZUNE_UPLOAD_OK
+    int status;                     // ZuneUploadStatus
+    uint16_t mtp_error;             // Response code for ZUNE_UPLOAD_CREATE_FAILED
+    uint16_t format_code;
+    uint64_t file_size;
+};
+
+typedef void (*zune_upload_progress_callback_t)(
+    uint32_t index, uint64_t bytes_sent, uint64_t total_bytes, void* user_data);
+/// Return false to stop; the remaining items are not attempted
+typedef bool (*zune_upload_result_callback_t)(
+    const ZuneUploadItemResult* result, void* user_data);
+
+/// Create, send and verify a list of tracks in order. Tag reading,
+/// property-list building and file loading run on worker threads ahead of
+/// the transfer, so each SendObject follows the previous one directly.
+/// Callbacks run on the calling thread. With ZUNE_UPLOAD_VERIFY_BATCHED the
+/// results of consecutive items in one album folder are reported together
+/// after the folder check; with _DEFERRED, zune_upload_verify_session checks them.
+/// @return Number of tracks uploaded, -1 on bad arguments, -2 if no session
+XUNE_SYNC_API int zune_upload_tracks(
+    zune_device_handle_t handle, const ZuneUploadItem* items, uint32_t count,
+    uint8_t is_hd, zune_upload_progress_callback_t progress_callback,
+    zune_upload_result_callback_t result_callback, void* user_data);
+
+// --- Sync Planning ---
+
+/// One file of the host collection, with the tags the planner matches on
+struct ZuneHostTrack {
+    const char* file_path;
+    const char* title;
+    const char* artist;
+    const char* album;
+    const char* album_artist;       // NULL or "" = artist
+    const char* genre;
+    const char* date_authored;      // "YYYYMMDDTHHMMSS.0", or NULL to omit on upload
+    uint32_t track_number;
+    uint32_t disc_number;           // 0 = 1
+    uint32_t duration_ms;
+    uint64_t file_size;
+};
+
+struct ZuneHostPlaylist {
+    const char* name;
+    const uint32_t* track_indices;  // Into the host track array, in play order
+    uint32_t track_count;
+};
+
+typedef enum {
+    ZUNE_SYNC_OP_DELETE_TRACK = 0,      // device_atom_id: track to delete
+    ZUNE_SYNC_OP_DELETE_PLAYLIST = 1,   // device_atom_id: playlist to delete
+    ZUNE_SYNC_OP_CREATE_ALBUM = 2,      // group: folder + album to create before its tracks
+    ZUNE_SYNC_OP_ADD_TRACK = 3,         // host_index: file to upload into group
+    ZUNE_SYNC_OP_UPDATE_TRACK = 4,      // host_index -> device_atom_id: same file, new tags
+    ZUNE_SYNC_OP_CREATE_PLAYLIST = 5,   // host_index: host playlist
+    ZUNE_SYNC_OP_UPDATE_PLAYLIST = 6    // host_index -> device_atom_id: replace its tracks
+} ZuneSyncOpType;
+
+#define ZUNE_SYNC_NONE 0xFFFFFFFFu
+
+struct ZuneSyncOp {
+    int type;                       // ZuneSyncOpType
+    uint32_t host_index;            // Host track or playlist, ZUNE_SYNC_NONE if unused
+    uint32_t device_atom_id;        // Device track or playlist, 0 if unused
+    uint32_t group;                 // Album group, ZUNE_SYNC_NONE if unused
+};
+
+/// Album that receives added tracks. Strings point into the host manifest.
+struct ZuneSyncAlbumGroup {
+    const char* artist;             // Album artist as the host spells it
+    const char* album;
+    uint32_t device_album_atom_id;  // Existing device album, 0 if CREATE_ALBUM precedes it
+    uint32_t add_count;             // ADD_TRACK ops in this group
+};
+
+struct ZuneSyncPlanOptions {
+    uint32_t duration_tolerance_ms; // Tag vs ZMDB duration slack (default 2000)
+    bool delete_unmatched_tracks;   // Delete device tracks the host lacks (default true)
+    bool delete_unmatched_playlists;  // Delete device playlists the host lacks (default false)
+};
+
+/// Ops in execution order: deletes, then each album group (CREATE_ALBUM,
+/// then its ADD_TRACKs by disc and track number), then tag updates, then
+/// playlists, which may reference tracks added earlier in the plan.
+struct ZuneSyncPlan {
+    const ZuneSyncOp* ops;
+    uint32_t op_count;
+    const ZuneSyncAlbumGroup* groups;
+    uint32_t group_count;
+    const uint32_t* host_matches;   // Per host track: matched device atom_id, 0 if added
+    uint32_t host_track_count;
+    uint32_t add_count;
+    uint32_t update_count;
+    uint32_t delete_count;          // Tracks
+    uint32_t playlist_op_count;     // Created, updated and deleted playlists
+    uint32_t resumed_count;         // Host tracks an interrupted sync already uploaded
+    uint32_t identified_count;      // Host tracks matched by content fingerprint
+};
+
+/// Compare a host manifest against a device library.
+/// A host track matches a device track with the same album, title and
+/// track number (case-insensitive, whitespace-trimmed), a duration within
+/// the tolerance and the same file size (either size 0 = unknown). A match
+/// whose artist, genre or disc differs becomes UPDATE_TRACK; same album,
+/// title and number with a different duration or size is a changed file,
+/// planned as DELETE_TRACK + ADD_TRACK.
+/// @param options NULL for the defaults
+/// @return Plan to release with zune_sync_plan_free, or NULL on bad arguments.
+///         The plan keeps pointers into tracks; keep the manifest alive with it.
+XUNE_SYNC_API ZuneSyncPlan* zune_sync_plan_create(
+    const ZuneMusicLibrary* library,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const ZuneHostPlaylist* playlists, uint32_t playlist_count,
+    const ZuneSyncPlanOptions* options);
+XUNE_SYNC_API void zune_sync_plan_free(ZuneSyncPlan* plan);
+
+/// Journal every track the upload calls create and complete, one file per
+/// device serial under directory, so a sync that is cut off part way can
+/// resume with zune_sync_plan_create_resumed. NULL or "" disables (the default).
+XUNE_SYNC_API void zune_device_set_sync_journal_dir(
+    zune_device_handle_t handle, const char* directory);
+
+/// Empty the connected device's journal; call once a sync has completed
+XUNE_SYNC_API void zune_device_clear_sync_journal(zune_device_handle_t handle);
+
+/// Fingerprint every track the upload calls complete (file size plus hashes
+/// of its first and last 64 KB) next to its object handle, one file per
+/// device serial under directory. zune_sync_plan_create_resumed then matches
+/// host tracks it would add against them, so a library restored from backup,
+/// renamed or re-tagged does not upload again. NULL or "" disables (the default).
+XUNE_SYNC_API void zune_device_set_content_index_dir(
+    zune_device_handle_t handle, const char* directory);
+
+/// As zune_sync_plan_create, after checking the device's sync journal with
+/// one ObjectSize property-list query. Host tracks whose file (same path,
+/// size and modification time) a previous sync fully uploaded match that
+/// object even if library predates it, so they are not uploaded again;
+/// journaled objects that never received all their data are deleted.
+/// With a content index, host tracks still left to add whose fingerprint
+/// matches a library track are matched to it instead (identified_count),
+/// reading only those files. Without a journal, or if the query fails,
+/// plans as zune_sync_plan_create.
+XUNE_SYNC_API ZuneSyncPlan* zune_sync_plan_create_resumed(
+    zune_device_handle_t handle, const ZuneMusicLibrary* library,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const ZuneHostPlaylist* playlists, uint32_t playlist_count,
+    const ZuneSyncPlanOptions* options);
+
+/// Upload every ADD_TRACK of plan through the batch upload engine, in plan
+/// order, with tags taken from the manifest. Run once the plan's
+/// CREATE_ALBUM ops are done: group_folders[g] is the folder for group g,
+/// and group_artist_meta_ids (HD, may be NULL) its artist reference.
+/// Results and progress report the host track index.
+/// @return Number of tracks uploaded, or -1 / -2 as zune_upload_tracks
+XUNE_SYNC_API int zune_sync_plan_upload(
+    zune_device_handle_t handle, const ZuneSyncPlan* plan,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const uint32_t* group_folders, const uint32_t* group_artist_meta_ids,
+    zune_upload_progress_callback_t progress_callback,
+    zune_upload_result_callback_t result_callback, void* user_data);
+
+// --- Host Collection Scanning ---
+
+struct ZuneMediaScanOptions {
+    const char* cache_path;         // Tag cache file; NULL or "" = parse every file
+    uint32_t worker_threads;        // 0 = 4
+    bool read_artwork;              // Fill artwork_size (copies each cover once)
+};
+
+/// What a scan knows about a file beyond the planner's ZuneHostTrack
+struct ZuneMediaTrackInfo {
+    int rating;                     // -1 = untagged
+    uint32_t year;                  // 0 = untagged
+    const char* artist_guid;        // "" if none
+    uint32_t artwork_size;          // Embedded cover bytes, 0 if none or not probed
+    int64_t modified_time;
+    bool tagged;                    // false: tags unreadable, title is the file name
+};
+
+struct ZuneMediaScan {
+    const ZuneHostTrack* tracks;    // Sorted by path; pass to zune_sync_plan_create
+    const ZuneMediaTrackInfo* info; // Parallel to tracks
+    uint32_t track_count;
+    uint32_t cache_hits;            // Unchanged files answered from the cache
+    uint32_t parsed;                // Files whose tags were read
+    uint32_t failed;                // Unreadable files, left out of tracks
+};
+
+/// Read the tags of every audio file under root (or root itself) on a
+/// worker pool. With a cache path, files whose size and modification time
+/// match the cache are not opened, so a rescan only parses what changed.
+/// @param options NULL for the defaults (no cache)
+/// @return Scan to release with zune_media_scan_free, or NULL on bad arguments
+XUNE_SYNC_API ZuneMediaScan* zune_media_scan(const char* root, const ZuneMediaScanOptions* options);
+XUNE_SYNC_API void zune_media_scan_free(ZuneMediaScan* scan);
+
+/// Copy the first embedded cover of file_path into buffer.
+/// @return Cover size (larger than capacity means nothing was copied;
+///         call again with a bigger buffer), 0 if none, -1 on bad arguments
+XUNE_SYNC_API int64_t zune_media_read_artwork(const char* file_path, uint8_t* buffer, uint32_t capacity);
+
 // --- Album Metadata ---
 
 /// Create album metadata object. Returns MTP handle or 0 on error.
@@ -994,7 +2013,8 @@ XUNE_SYNC_API uint32_t zune_upload_create_album(
     zune_device_handle_t handle, uint32_t albums_folder,
     const ZuneAlbumProps* props);
 
-/// Set album artwork (read current + set data + set JPEG format)
+/// Set album artwork (read current + set data + set JPEG format).
+/// Goes through the artwork pipeline when one is set (zune_device_set_artwork_pipeline).
 XUNE_SYNC_API int zune_upload_set_artwork(
     zune_device_handle_t handle, uint32_t album_id,
     const uint8_t* data, uint32_t size);
@@ -1004,7 +2024,9 @@ XUNE_SYNC_API int zune_upload_set_album_refs(
     zune_device_handle_t handle, uint32_t album_id,
     const uint32_t* track_ids, uint32_t count);
 
-/// Verify album (subset + optional ParentObject desc + ALL)
+/// Verify album (subset + optional ParentObject desc + ALL). With ZUNE_UPLOAD_VERIFY_BATCHED,
+/// instead checks the tracks uploaded since the last album with one ObjectSize list per
+/// track folder, returning -1 if one is missing or short. Does nothing when deferred.
 XUNE_SYNC_API int zune_upload_verify_album(
     zune_device_handle_t handle, uint32_t album_id, bool include_parent_desc);
 
@@ -1012,6 +2034,67 @@ XUNE_SYNC_API int zune_upload_verify_album(
 XUNE_SYNC_API int zune_upload_read_album_subset(
     zune_device_handle_t handle, uint32_t album_id);
 
+// --- Command Buffers ---
+// A whole album upload (folder, tracks, audio, album, artwork, references,
+// verification) in one call instead of one native call per step. Each
+// command does exactly what the zune_upload_* function of the same name
+// does. A handle argument can name an earlier command's result instead of
+// a literal handle, so the sequence can be built before any object exists.
+// Command references count from 1 so a zeroed field means "literal".
+
+typedef enum {
+    ZUNE_CMD_CREATE_FOLDER = 1,     // object: parent; text: name -> handle
+    ZUNE_CMD_FOLDER_READBACK,       // object: folder
+    ZUNE_CMD_ROOT_RE_ENUM,
+    ZUNE_CMD_CREATE_TRACK,          // object: album folder; track, format_code, file_size -> handle
+    ZUNE_CMD_SEND_AUDIO,            // text: file path; must follow its CREATE_TRACK
+    ZUNE_CMD_VERIFY_TRACK,          // object: track
+    ZUNE_CMD_CREATE_ALBUM,          // object: albums folder; album -> handle
+    ZUNE_CMD_SET_ARTWORK,           // object: album; data, size
+    ZUNE_CMD_SET_ALBUM_REFS,        // object: album; refs / refs_from, ref_count
+    ZUNE_CMD_VERIFY_ALBUM           // object: album; flag: include ParentObject desc
+} ZuneCommandType;
+
+struct ZuneCommand {
+    ZuneCommandType type;
+    uint32_t object;                // Literal handle, used when object_from is 0
+    uint32_t object_from;           // n > 0: the handle returned by command n-1
+    const char* text;
+    const ZuneTrackProps* track;
+    const ZuneAlbumProps* album;
+    uint16_t format_code;
+    uint64_t file_size;
+    const uint8_t* data;
+    uint32_t size;
+    const uint32_t* refs;           // Literal track handles
+    const uint32_t* refs_from;      // Optional, per entry as object_from
+    uint32_t ref_count;
+    bool flag;
+};
+
+typedef enum {
+    ZUNE_CMD_OK = 0,
+    ZUNE_CMD_FAILED = -1,           // The operation failed (see mtp_error for CREATE_TRACK)
+    ZUNE_CMD_BAD_ARGUMENT = -2,     // Unknown type, or a reference to a later or failed command
+    ZUNE_CMD_NOT_RUN = -3           // After a failure, with ZUNE_CMD_STOP_ON_ERROR
+} ZuneCommandStatus;
+
+struct ZuneCommandResult {
+    int32_t status;                 // ZuneCommandStatus
+    uint32_t handle;                // CREATE_* result, else 0
+    uint16_t mtp_error;             // CREATE_TRACK: MTP response code on failure
+};
+
+#define ZUNE_CMD_STOP_ON_ERROR 0x1  // Leave the rest ZUNE_CMD_NOT_RUN after a failure
+
+/// Run count commands in order, writing one result per command to results.
+/// @param flags ZUNE_CMD_STOP_ON_ERROR or 0 (a command that refers to a
+///              failed one fails with ZUNE_CMD_BAD_ARGUMENT either way)
+/// @return Number of commands that succeeded, or -1 on bad arguments / no session
+XUNE_SYNC_API int32_t zune_upload_execute(
+    zune_device_handle_t handle, const ZuneCommand* commands, uint32_t count,
+    ZuneCommandResult* results, uint32_t flags);
+
 // --- Podcast Series ---
 
 /// Podcast series properties for creating a .ser metadata object
@@ -1096,6 +2179,105 @@ XUNE_SYNC_API int zune_upload_query_artist_descs(zune_device_handle_t handle);
 /// Query artwork property descriptors (RepSampleData + RepSampleFormat)
 XUNE_SYNC_API int zune_upload_query_artwork_descs(zune_device_handle_t handle);
 
+// --- Descriptor Cache ---
+
+/// Descriptor query counters since the cache was bound to this session
+struct ZuneDescriptorCacheStats {
+    uint64_t queries_issued;    // Round trips made
+    uint64_t queries_skipped;   // Round trips left out because the firmware was cached
+    uint64_t query_us;          // Time spent in the issued queries
+    uint64_t saved_us;          // Estimate: skipped x mean latency recorded for this firmware
+};
+
+/// Remember which descriptor queries each device family + firmware has
+/// answered, one file per firmware under directory. With skip_cached, the
+/// zune_upload_query_*_descs calls leave out queries the cache already holds.
+/// Skipping is opt-in: if the device then rejects a SendObjectPropList,
+/// call zune_device_clear_descriptor_cache so the next session queries in
+/// full again. NULL or "" disables (the default).
+XUNE_SYNC_API void zune_device_set_descriptor_cache_dir(
+    zune_device_handle_t handle, const char* directory, bool skip_cached);
+
+/// Forget the cached descriptors for the connected firmware
+XUNE_SYNC_API void zune_device_clear_descriptor_cache(zune_device_handle_t handle);
+
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_descriptor_cache_stats(
+    zune_device_handle_t handle, ZuneDescriptorCacheStats* out);
+
+// --- Folder Cache ---
+
+/// Folder listing lookups since the cache was enabled
+struct ZuneFolderCacheStats {
+    uint64_t hits;      // Root / folder discoveries answered without the device
+    uint64_t misses;    // Discoveries read from the device
+};
+
+/// Keep the folder handles zune_upload_discover_root / _discover_folder find
+/// for the rest of the session, so asking again for the same Music, artist
+/// or album folder costs no USB transactions. Folders created and objects
+/// deleted through this API keep it current, and each folder is read back
+/// once. Cleared on disconnect. Off by default.
+XUNE_SYNC_API void zune_device_set_folder_cache(zune_device_handle_t handle, bool enabled);
+
+/// @return 0 on success, -1 on bad arguments
+XUNE_SYNC_API int zune_device_get_folder_cache_stats(
+    zune_device_handle_t handle, ZuneFolderCacheStats* out);
+
+// --- Device Profile ---
+
+/// Keep each device's firmware, 0xd21a identification and storage layout in
+/// directory, one file per serial number. A reconnect then validates the
+/// profile with a single property read and takes storage IDs and capacity
+/// from it. A firmware change invalidates it. NULL or "" disables (the default).
+XUNE_SYNC_API void zune_device_set_profile_dir(
+    zune_device_handle_t handle, const char* directory);
+
+// --- Artwork Pipeline ---
+
+/// Downscale a JPEG so neither side exceeds max_dimension, writing the new
+/// JPEG into out (out_capacity bytes, the input size). Return its size, or
+/// 0 to send the original. Called from worker threads, possibly several at once.
+typedef uint32_t (*zune_artwork_resize_callback_t)(
+    const uint8_t* jpeg, uint32_t size, uint32_t max_dimension,
+    uint8_t* out, uint32_t out_capacity, void* user_data);
+
+struct ZuneArtworkPipelineOptions {
+    zune_artwork_resize_callback_t resize;  // NULL: dedup only
+    void* user_data;
+    const char* cache_dir;          // Resized images kept across sessions; NULL or "" = none
+    uint32_t max_dimension;         // 0: the family's screen (240 Classic, 272 HD)
+    uint32_t worker_threads;        // zune_device_prepare_artwork workers (0 = 2)
+};
+
+struct ZuneArtworkPipelineStats {
+    uint64_t images;                // Images seen this session
+    uint64_t duplicates;            // Of those, already prepared
+    uint64_t resized;               // Resized by the callback
+    uint64_t disk_hits;             // Resized image taken from cache_dir
+    uint64_t sends_skipped;         // Object already had that image
+    uint64_t bytes_in;              // Distinct images, as given
+    uint64_t bytes_out;             // Distinct images, as sent
+};
+
+/// Route zune_upload_set_artwork and zune_upload_set_series_artwork through
+/// a host-side stage: each distinct image (by content hash) is prepared
+/// once per session, JPEGs larger than max_dimension go through resize,
+/// and an object is not sent the same image twice. NULL disables (the default).
+XUNE_SYNC_API void zune_device_set_artwork_pipeline(
+    zune_device_handle_t handle, const ZuneArtworkPipelineOptions* options);
+
+/// Prepare images ahead of album creation on the worker pool, so the
+/// artwork calls that follow only send. Duplicates are prepared once.
+/// @return 0 on success, -1 on bad arguments or if the pipeline is off
+XUNE_SYNC_API int zune_device_prepare_artwork(
+    zune_device_handle_t handle, const uint8_t* const* images,
+    const uint32_t* sizes, uint32_t count);
+
+/// @return 0 on success, -1 on bad arguments or if the pipeline is off
+XUNE_SYNC_API int zune_device_get_artwork_pipeline_stats(
+    zune_device_handle_t handle, ZuneArtworkPipelineStats* out);
+
 
 // ── Windows Driver Management ────────────────────────────────────────────
 // Query-only functions for detecting Zune devices and their USB driver status.
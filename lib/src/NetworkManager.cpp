@@ -1,16 +1,22 @@
 #include "NetworkManager.h"
 #include "protocols/http/ZuneHTTPInterceptor.h"
 #include "protocols/ppp/PPPParser.h"
+#include "protocols/ppp/PPPLinkProfile.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <thread>
 #include <chrono>
 
+#define NETWORK_LOG(category, level, message) ZUNE_LOG(logger_, nullptr, category, level, message)
+
 using namespace mtp;
 
-NetworkManager::NetworkManager(std::shared_ptr<mtp::Session> mtp_session, LogCallback log_callback)
-    : mtp_session_(mtp_session), log_callback_(log_callback) {
+NetworkManager::NetworkManager(std::shared_ptr<mtp::Session> mtp_session, zune::Logger* logger,
+                               zune::TransferStats* transfer_stats, zune::MtpScheduler* scheduler,
+                               MetadataDiskCache* disk_cache)
+    : mtp_session_(mtp_session), logger_(logger), transfer_stats_(transfer_stats),
+      scheduler_(scheduler), disk_cache_(disk_cache) {
 }
 
 NetworkManager::~NetworkManager() {
@@ -27,75 +33,83 @@ void NetworkManager::RequestShutdown() {
     });
 }
 
-void NetworkManager::Log(const std::string& message) {
-    if (log_callback_) {
-        log_callback_(message);
-    }
+void NetworkManager::Send922c(const mtp::ByteArray& payload) {
+    packet_capture_.Record(PacketCapture::Direction::ToDevice, payload);
+    zune::MtpScheduler::Run(scheduler_, ZUNE_MTP_CLASS_NETWORK, [&] {
+        zune::TransferStats::Measure(transfer_stats_, ZUNE_TRANSFER_OP_NETWORK_SEND, payload.size(),
+                                     [&] { mtp_session_->Operation922c(payload, 3, 3); });
+    });
 }
 
-void NetworkManager::VerboseLog(const std::string& message) {
-    if (verbose_logging_ && log_callback_) {
-        log_callback_(message);
-    }
+mtp::ByteArray NetworkManager::Poll922d() {
+    mtp::ByteArray data = zune::MtpScheduler::Run(scheduler_, ZUNE_MTP_CLASS_NETWORK, [&] {
+        return zune::TransferStats::Measure(transfer_stats_, ZUNE_TRANSFER_OP_NETWORK_POLL, 0,
+                                            [&] { return mtp_session_->Operation922d(3, 3); });
+    });
+    packet_capture_.Record(PacketCapture::Direction::FromDevice, data);
+    return data;
 }
 
 bool NetworkManager::InitializeHTTPSubsystem() {
     if (!mtp_session_) {
-        Log("Error: MTP session not initialized, cannot initialize HTTP subsystem");
+        NETWORK_LOG(HTTP, ERROR, "Error: MTP session not initialized, cannot initialize HTTP subsystem");
         return false;
     }
 
     try {
-        Log("Initializing HTTP subsystem on device...");
+        // The init sequence runs as one unit; nothing else belongs between its operations
+        zune::MtpScheduler::Grant grant;
+        if (scheduler_) grant = scheduler_->Acquire(ZUNE_MTP_CLASS_NETWORK);
+        NETWORK_LOG(HTTP, INFO, "Initializing HTTP subsystem on device...");
 
         // HTTP trigger command (pcap shows single call with 258B data)
-        Log("  → Sending 0x9231() - HTTP init trigger");
+        NETWORK_LOG(HTTP, INFO, "  → Sending 0x9231() - HTTP init trigger");
         mtp_session_->Operation9231();
-        Log("  [OK] 0x9231 complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x9231 complete");
 
         // Sync operations
-        Log("  → Sending 0x9217(1)");
+        NETWORK_LOG(PPP, INFO, "  → Sending 0x9217(1)");
         mtp_session_->Operation9217(1);
-        Log("  [OK] 0x9217 complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x9217 complete");
 
-        Log("  → Sending 0x9218(0, 0, 5000)");
+        NETWORK_LOG(PPP, INFO, "  → Sending 0x9218(0, 0, 5000)");
         mtp_session_->Operation9218(0, 0, 5000);
-        Log("  [OK] 0x9218 complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x9218 complete");
 
         // Second sync
-        Log("  → Sending 0x9217(1) again");
+        NETWORK_LOG(PPP, INFO, "  → Sending 0x9217(1) again");
         mtp_session_->Operation9217(1);
-        Log("  [OK] 0x9217 complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x9217 complete");
 
         // NOTE: 0x9214 is part of MTPZ auth, not HTTP init - skip it here
 
-        Log("  → Sending 0x9219(0, 0, 5000)");
+        NETWORK_LOG(PPP, INFO, "  → Sending 0x9219(0, 0, 5000)");
         mtp_session_->Operation9219(0, 0, 5000);
-        Log("  [OK] 0x9219 complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x9219 complete");
 
-        Log("  → Sending 0x922f");
+        NETWORK_LOG(PPP, INFO, "  → Sending 0x922f");
         mtp::ByteArray empty;
         mtp_session_->Operation922f(empty);
-        Log("  [OK] 0x922f complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x922f complete");
 
         // Network subsystem setup
-        Log("  → Sending 0x922b(3, 1, 0)");
+        NETWORK_LOG(PPP, INFO, "  → Sending 0x922b(3, 1, 0)");
         mtp_session_->Operation922b(3, 1, 0);
-        Log("  [OK] 0x922b complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x922b complete");
 
         // Enable wireless/network sync
-        Log("  → Sending 0x9230(1)");
+        NETWORK_LOG(PPP, INFO, "  → Sending 0x9230(1)");
         mtp_session_->Operation9230(1);
-        Log("  [OK] 0x9230 complete");
+        NETWORK_LOG(PPP, INFO, "  [OK] 0x9230 complete");
 
         // After this, the device will send "CLIENT" via Op922d when ready.
         // TriggerNetworkMode() polls for this signal before sending "CLIENTSERVER".
 
-        Log("[OK] HTTP subsystem initialization complete");
+        NETWORK_LOG(HTTP, INFO, "[OK] HTTP subsystem initialization complete");
         return true;
 
     } catch (const std::exception& e) {
-        Log(std::string("HTTP initialization failed: ") + e.what());
+        NETWORK_LOG(HTTP, ERROR, std::string("HTTP initialization failed: ") + e.what());
         return false;
     }
 }
@@ -108,13 +122,20 @@ void NetworkManager::StartHTTPInterceptor(const InterceptorConfig& config) {
     std::lock_guard<std::mutex> lock(interceptor_mutex_);
 
     if (http_interceptor_ && http_interceptor_->IsRunning()) {
-        Log("HTTP interceptor is already running");
+        NETWORK_LOG(HTTP, INFO, "HTTP interceptor is already running");
         return;
     }
 
-    Log("Starting HTTP interceptor...");
+    NETWORK_LOG(HTTP, INFO, "Starting HTTP interceptor...");
     http_interceptor_ = std::make_shared<ZuneHTTPInterceptor>(mtp_session_);
-    http_interceptor_->SetLogCallback(log_callback_);
+    http_interceptor_->SetLogger(logger_);
+    http_interceptor_->SetTransferStats(transfer_stats_);
+    http_interceptor_->SetMtpScheduler(scheduler_);
+    http_interceptor_->SetResponseCache(&metadata_cache_);
+    http_interceptor_->SetImageVariantCache(&image_variants_);
+    http_interceptor_->SetDiskCache(disk_cache_);
+    http_interceptor_->SetPacketCapture(&packet_capture_);
+    http_interceptor_->SetLinkProfile(&link_profile_);
 
     // Apply any callbacks that were registered before the interceptor existed
     if (pending_path_resolver_) {
@@ -131,13 +152,16 @@ void NetworkManager::StartHTTPInterceptor(const InterceptorConfig& config) {
 }
 
 void NetworkManager::StopHTTPInterceptor() {
+    // The poll loop has nothing left to poll
+    poll_loop_.Stop();
+
     std::shared_ptr<ZuneHTTPInterceptor> interceptor;
     {
         std::lock_guard<std::mutex> lock(interceptor_mutex_);
         interceptor = std::move(http_interceptor_);
     }
     if (interceptor) {
-        Log("Stopping HTTP interceptor...");
+        NETWORK_LOG(HTTP, INFO, "Stopping HTTP interceptor...");
         interceptor->Stop();
     }
 }
@@ -148,9 +172,9 @@ void NetworkManager::EnableNetworkPolling() {
         throw std::runtime_error("HTTP interceptor not running - call StartHTTPInterceptor() first");
     }
 
-    Log("Enabling network polling...");
+    NETWORK_LOG(PPP, INFO, "Enabling network polling...");
     http_interceptor_->EnableNetworkPolling();
-    Log("  [OK] Network polling enabled — C# drives via PollNetworkData()");
+    NETWORK_LOG(PPP, INFO, "  [OK] Network polling enabled — C# drives via PollNetworkData()");
 }
 
 int NetworkManager::PollNetworkData(int timeout_ms) {
@@ -165,6 +189,25 @@ int NetworkManager::PollNetworkData(int timeout_ms) {
     return interceptor->PollOnce(timeout_ms);
 }
 
+uint64_t NetworkManager::StartNetworkPollLoop(NetworkPollLoop::EventFn on_event,
+                                              int hot_wait_ms, int idle_wait_ms) {
+    uint64_t token = poll_loop_.Start(
+        [this](int timeout_ms) { return PollNetworkData(timeout_ms); },
+        [this] {
+            std::lock_guard<std::mutex> lock(interceptor_mutex_);
+            return http_interceptor_ && http_interceptor_->HasActiveTransmissions();
+        },
+        std::move(on_event), hot_wait_ms, idle_wait_ms);
+    if (token != 0) {
+        NETWORK_LOG(HTTP, INFO, "Native network poll loop started");
+    }
+    return token;
+}
+
+bool NetworkManager::StopNetworkPollLoop(uint64_t token) {
+    return poll_loop_.Stop(token);
+}
+
 bool NetworkManager::IsHTTPInterceptorRunning() const {
     std::lock_guard<std::mutex> lock(interceptor_mutex_);
     return http_interceptor_ && http_interceptor_->IsRunning();
@@ -178,6 +221,26 @@ InterceptorConfig NetworkManager::GetHTTPInterceptorConfig() const {
     return InterceptorConfig{};
 }
 
+InterceptorNetworkStats NetworkManager::GetNetworkStats() const {
+    std::shared_ptr<ZuneHTTPInterceptor> interceptor;
+    {
+        std::lock_guard<std::mutex> lock(interceptor_mutex_);
+        interceptor = http_interceptor_;
+    }
+    if (interceptor) {
+        return interceptor->GetNetworkStats();
+    }
+    return InterceptorNetworkStats{};
+}
+
+RequestWorkerStats NetworkManager::GetRequestWorkerStats() const {
+    std::lock_guard<std::mutex> lock(interceptor_mutex_);
+    if (http_interceptor_) {
+        return http_interceptor_->GetWorkerStats();
+    }
+    return RequestWorkerStats{};
+}
+
 void NetworkManager::TriggerNetworkMode() {
     if (shutdown_requested_.load(std::memory_order_relaxed)) {
         throw std::runtime_error("NetworkManager is shutting down");
@@ -197,7 +260,9 @@ void NetworkManager::TriggerNetworkMode() {
         }
     } guard{*this};
 
-    Log("Triggering network mode...");
+    auto trigger_start = std::chrono::steady_clock::now();
+
+    NETWORK_LOG(PPP, INFO, "Triggering network mode...");
 
     // Helper function to format byte array as hex string
     auto format_hex = [](const mtp::ByteArray& data, size_t max_bytes = 0) -> std::string {
@@ -216,20 +281,20 @@ void NetworkManager::TriggerNetworkMode() {
     // PPP handshake: device sends "CLIENT", host responds "CLIENTSERVER"
     const mtp::ByteArray client_sig = {0x43, 0x4c, 0x49, 0x45, 0x4e, 0x54}; // "CLIENT"
 
-    Log("Polling for device CLIENT readiness signal...");
+    NETWORK_LOG(PPP, INFO, "Polling for device CLIENT readiness signal...");
     int poll_count = 0;
     const int max_polls = 200;
     bool found_client = false;
 
     while (!found_client && poll_count < max_polls && !shutdown_requested_.load(std::memory_order_relaxed)) {
-        mtp::ByteArray response = mtp_session_->Operation922d(3, 3);
+        mtp::ByteArray response = Poll922d();
         poll_count++;
 
         if (response.size() == 6 && response == client_sig) {
-            Log("  [OK] Device sent CLIENT (poll " + std::to_string(poll_count) + ")");
+            NETWORK_LOG(PPP, INFO, "  [OK] Device sent CLIENT (poll " + std::to_string(poll_count) + ")");
             found_client = true;
         } else if (!response.empty()) {
-            VerboseLog("  → Poll " + std::to_string(poll_count) + ": " +
+            NETWORK_LOG(PPP, DEBUG, "  → Poll " + std::to_string(poll_count) + ": " +
                        std::to_string(response.size()) + "B (not CLIENT)");
         }
 
@@ -240,32 +305,32 @@ void NetworkManager::TriggerNetworkMode() {
 
     if (!found_client) {
         if (shutdown_requested_.load(std::memory_order_relaxed)) return;
-        Log("  [FAIL] Device did not send CLIENT after " + std::to_string(max_polls) + " polls");
+        NETWORK_LOG(PPP, ERROR, "  [FAIL] Device did not send CLIENT after " + std::to_string(max_polls) + " polls");
         throw std::runtime_error("Device did not signal readiness for network mode");
     }
 
-    Log("Sending CLIENTSERVER response...");
+    NETWORK_LOG(PPP, INFO, "Sending CLIENTSERVER response...");
     const char* trigger_str = "CLIENTSERVER";
     mtp::ByteArray trigger_payload(trigger_str, trigger_str + 12);
-    mtp_session_->Operation922c(trigger_payload, 3, 3);
-    Log("  [OK] CLIENTSERVER sent");
+    Send922c(trigger_payload);
+    NETWORK_LOG(PPP, INFO, "  [OK] CLIENTSERVER sent");
 
-    Log("Polling for device LCP Config-Request...");
+    NETWORK_LOG(PPP, INFO, "Polling for device LCP Config-Request...");
     mtp::ByteArray device_lcp;
     poll_count = 0;
     bool found_valid_lcp = false;
 
     while (!found_valid_lcp && poll_count < max_polls && !shutdown_requested_.load(std::memory_order_relaxed)) {
-        mtp::ByteArray response = mtp_session_->Operation922d(3, 3);
+        mtp::ByteArray response = Poll922d();
         poll_count++;
 
         if (!response.empty() && PPPParser::IsValidFrame(response)) {
-            Log("  [OK] Received PPP frame: " + std::to_string(response.size()) + " bytes (poll " +
+            NETWORK_LOG(PPP, INFO, "  [OK] Received PPP frame: " + std::to_string(response.size()) + " bytes (poll " +
                 std::to_string(poll_count) + ")");
             device_lcp = response;
             found_valid_lcp = true;
         } else if (!response.empty()) {
-            VerboseLog("  → Poll " + std::to_string(poll_count) + ": " +
+            NETWORK_LOG(PPP, DEBUG, "  → Poll " + std::to_string(poll_count) + ": " +
                        std::to_string(response.size()) + "B (not PPP)");
         }
 
@@ -276,57 +341,48 @@ void NetworkManager::TriggerNetworkMode() {
 
     if (!found_valid_lcp) {
         if (shutdown_requested_.load(std::memory_order_relaxed)) return;
-        Log("  [FAIL] Device did not send LCP Config-Request after " + std::to_string(max_polls) + " polls");
+        NETWORK_LOG(PPP, ERROR, "  [FAIL] Device did not send LCP Config-Request after " + std::to_string(max_polls) + " polls");
         throw std::runtime_error("Device did not enter network mode");
     }
 
-    Log("  [OK] Device LCP Config-Request received: " + std::to_string(device_lcp.size()) + " bytes");
-    Log("    Data: " + format_hex(device_lcp, 50));
-
-    Log("Sending LCP response...");
-    const uint8_t lcp_response_data[] = {
-        0x7e, 0xff, 0x7d, 0x23, 0xc0, 0x21, 0x7d, 0x22, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x2e, 0x7d, 0x22,
-        0x7d, 0x26, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x27, 0x7d, 0x22, 0x7d, 0x28,
-        0x7d, 0x22, 0xe3, 0xb2, 0x7e, 0x7e, 0xff, 0x7d, 0x23, 0xc0, 0x21, 0x7d, 0x21, 0x7d, 0x21, 0x7d,
-        0x20, 0x7d, 0x2e, 0x7d, 0x22, 0x7d, 0x26, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d,
-        0x27, 0x7d, 0x22, 0x7d, 0x28, 0x7d, 0x22, 0x70, 0x34, 0x7e
-    };
+    NETWORK_LOG(PPP, INFO, "  [OK] Device LCP Config-Request received: " + std::to_string(device_lcp.size()) + " bytes");
+    NETWORK_LOG(PPP, INFO, "    Data: " + format_hex(device_lcp, 50));
 
-    mtp::ByteArray lcp_response_payload(lcp_response_data, lcp_response_data + sizeof(lcp_response_data));
-    mtp_session_->Operation922c(lcp_response_payload, 3, 3);
-    Log("  [OK] LCP response sent");
+    NETWORK_LOG(PPP, INFO, "Sending LCP response...");
+    Send922c(link_profile_.LCPResponse());
+    NETWORK_LOG(PPP, INFO, "  [OK] LCP response sent");
 
-    Log("Polling for device LCP reply...");
-    mtp::ByteArray device_lcp_reply = mtp_session_->Operation922d(3, 3);
-    Log("  [OK] Device LCP reply received: " + std::to_string(device_lcp_reply.size()) + " bytes");
-    Log("    Data: " + format_hex(device_lcp_reply, 50));
+    NETWORK_LOG(PPP, INFO, "Polling for device LCP reply...");
+    mtp::ByteArray device_lcp_reply = Poll922d();
+    NETWORK_LOG(PPP, INFO, "  [OK] Device LCP reply received: " + std::to_string(device_lcp_reply.size()) + " bytes");
+    NETWORK_LOG(PPP, INFO, "    Data: " + format_hex(device_lcp_reply, 50));
 
-    Log("Checking for device IPCP Config-Request in LCP reply...");
+    NETWORK_LOG(PPP, INFO, "Checking for device IPCP Config-Request in LCP reply...");
     mtp::ByteArray device_ipcp_request;
     poll_count = 0;
     bool found_device_ipcp_request = false;
 
     if (!device_lcp_reply.empty() &&
         PPPParser_ContainsIPCPCode(device_lcp_reply, IPCPParser::IPCP_CODE_CONFIG_REQUEST)) {
-        Log("  [OK] Found IPCP Config-Request in LCP reply message!");
+        NETWORK_LOG(PPP, INFO, "  [OK] Found IPCP Config-Request in LCP reply message!");
         device_ipcp_request = device_lcp_reply;
         found_device_ipcp_request = true;
     }
 
     // If not found in LCP reply, poll for it separately
     if (!found_device_ipcp_request) {
-        Log("Polling for device IPCP Config-Request...");
+        NETWORK_LOG(PPP, INFO, "Polling for device IPCP Config-Request...");
     }
 
     while (!found_device_ipcp_request && poll_count < max_polls && !shutdown_requested_.load(std::memory_order_relaxed)) {
-        mtp::ByteArray response = mtp_session_->Operation922d(3, 3);
+        mtp::ByteArray response = Poll922d();
         poll_count++;
 
         if (!response.empty() && PPPParser::IsValidFrame(response) &&
             PPPParser_ContainsIPCPCode(response, IPCPParser::IPCP_CODE_CONFIG_REQUEST)) {
-            Log("  [OK] Received device IPCP Config-Request: " + std::to_string(response.size()) + " bytes (poll " +
+            NETWORK_LOG(PPP, INFO, "  [OK] Received device IPCP Config-Request: " + std::to_string(response.size()) + " bytes (poll " +
                 std::to_string(poll_count) + ")");
-            Log("    Data: " + format_hex(response, 50));
+            NETWORK_LOG(PPP, INFO, "    Data: " + format_hex(response, 50));
             device_ipcp_request = response;
             found_device_ipcp_request = true;
         }
@@ -338,7 +394,7 @@ void NetworkManager::TriggerNetworkMode() {
 
     if (!found_device_ipcp_request) {
         if (shutdown_requested_.load(std::memory_order_relaxed)) return;
-        Log("  [FAIL] Device did not send IPCP Config-Request after " + std::to_string(max_polls) + " polls");
+        NETWORK_LOG(PPP, ERROR, "  [FAIL] Device did not send IPCP Config-Request after " + std::to_string(max_polls) + " polls");
         throw std::runtime_error("Device IPCP negotiation failed");
     }
 
@@ -348,14 +404,13 @@ void NetworkManager::TriggerNetworkMode() {
     }
 
     uint8_t device_ipcp_request_id = device_request.identifier;
-    Log("  → Device IPCP Config-Request ID: " + std::to_string(device_ipcp_request_id));
+    NETWORK_LOG(PPP, INFO, "  → Device IPCP Config-Request ID: " + std::to_string(device_ipcp_request_id));
 
-    Log("Parsing device IPCP Config-Request...");
+    NETWORK_LOG(PPP, INFO, "Parsing device IPCP Config-Request...");
 
-    // Network configuration
-    const uint32_t host_ip = 0xC0A83764;      // 192.168.55.100
-    const uint32_t device_ip = 0xC0A83765;    // 192.168.55.101
-    const uint32_t dns_ip = host_ip;          // DNS server = host IP (device queries host for DNS)
+    // Network configuration (the device queries the host for DNS)
+    const uint32_t host_ip = PPPLinkProfile::kHostIP;
+    const uint32_t device_ip = PPPLinkProfile::kDeviceIP;
 
     uint32_t device_requested_ip = 0;
 
@@ -365,73 +420,24 @@ void NetworkManager::TriggerNetworkMode() {
         if (opt.type == IPCPParser::IPCP_OPT_IP_ADDRESS && opt.data.size() == 4) {
             device_requested_ip = (opt.data[0] << 24) | (opt.data[1] << 16) |
                                 (opt.data[2] << 8) | opt.data[3];
-            Log("  → Device requested IP: " + IPParser::IPToString(device_requested_ip));
+            NETWORK_LOG(PPP, INFO, "  → Device requested IP: " + IPParser::IPToString(device_requested_ip));
             break;
         }
     }
 
-    // Build IPCP Config-Request with IP-Compression and IP-Address options
-    mtp::ByteArray our_config_request;
-    our_config_request.push_back(0x01); // Config-Request
-    our_config_request.push_back(0x01); // Identifier = 1
-    our_config_request.push_back(0x00);
-    our_config_request.push_back(0x10); // Length = 16 bytes
-    // IP-Compression option (type 2)
-    our_config_request.push_back(0x02);
-    our_config_request.push_back(0x06);
-    our_config_request.push_back(0x00);
-    our_config_request.push_back(0x2d);
-    our_config_request.push_back(0x0f);
-    our_config_request.push_back(0x01);
-    // IP-Address option (type 3)
-    our_config_request.push_back(0x03);
-    our_config_request.push_back(0x06);
-    our_config_request.push_back((host_ip >> 24) & 0xFF);
-    our_config_request.push_back((host_ip >> 16) & 0xFF);
-    our_config_request.push_back((host_ip >> 8) & 0xFF);
-    our_config_request.push_back(host_ip & 0xFF);
-    mtp::ByteArray our_config_request_ppp = PPPParser::WrapPayload(our_config_request, 0x8021);
-
-    // Build CCP Config-Request
-    mtp::ByteArray ccp_request;
-    ccp_request.push_back(0x01); // Config-Request
-    ccp_request.push_back(0x01); // Identifier = 1
-    ccp_request.push_back(0x00);
-    ccp_request.push_back(0x0a); // Length = 10 bytes
-    ccp_request.push_back(0x12);
-    ccp_request.push_back(0x06);
-    ccp_request.push_back(0x00);
-    ccp_request.push_back(0x00);
-    ccp_request.push_back(0x00);
-    ccp_request.push_back(0x01);
-    mtp::ByteArray ccp_request_ppp = PPPParser::WrapPayload(ccp_request, 0x80fd);
-
     if (device_requested_ip == 0) {
         // Device requested invalid IP — send Config-Nak with corrected IP
-        VerboseLog("Building initial IPCP response (Config-Request + CCP + Config-Nak)...");
-        mtp::ByteArray config_nak_ipcp = IPCPParser::BuildConfigNak(device_ipcp_request_id, device_ip, dns_ip);
-        mtp::ByteArray config_nak_ppp = PPPParser::WrapPayload(config_nak_ipcp, 0x8021);
-
-        // Combine in Windows order: Config-Request + CCP + Config-Nak
-        mtp::ByteArray initial_ipcp_payload;
-        initial_ipcp_payload.insert(initial_ipcp_payload.end(),
-                                   our_config_request_ppp.begin(), our_config_request_ppp.end());
-        initial_ipcp_payload.insert(initial_ipcp_payload.end(),
-                                   ccp_request_ppp.begin(), ccp_request_ppp.end());
-        initial_ipcp_payload.insert(initial_ipcp_payload.end(),
-                                   config_nak_ppp.begin(), config_nak_ppp.end());
-
-        VerboseLog("Sending IPCP Config-Request + CCP + Config-Nak...");
-        Log("  → Our Config-Request for " + IPParser::IPToString(host_ip));
-        VerboseLog("  → CCP Config-Request");
-        Log("  → Config-Nak suggesting device use " + IPParser::IPToString(device_ip));
-        mtp_session_->Operation922c(initial_ipcp_payload, 3, 3);
-        Log("  [OK] Initial IPCP sent");
+        NETWORK_LOG(PPP, DEBUG, "Sending IPCP Config-Request + CCP + Config-Nak...");
+        NETWORK_LOG(PPP, INFO, "  → Our Config-Request for " + IPParser::IPToString(host_ip));
+        NETWORK_LOG(PPP, DEBUG, "  → CCP Config-Request");
+        NETWORK_LOG(PPP, INFO, "  → Config-Nak suggesting device use " + IPParser::IPToString(device_ip));
+        Send922c(link_profile_.NakReply(device_request));
+        NETWORK_LOG(PPP, INFO, "  [OK] Initial IPCP sent");
 
         // Step 8: Wait for device's Config-Reject + NEW Config-Request
         // Per Windows capture: Device sends Config-Reject (ID=1, rejecting compression)
         // followed by NEW Config-Request (ID=3, with corrected IP) in SAME 922d response
-        Log("Polling for device's Config-Reject + corrected IPCP Config-Request...");
+        NETWORK_LOG(PPP, INFO, "Polling for device's Config-Reject + corrected IPCP Config-Request...");
         mtp::ByteArray device_new_request;
         poll_count = 0;
         bool found_config_reject = false;
@@ -439,7 +445,7 @@ void NetworkManager::TriggerNetworkMode() {
         uint8_t new_request_id = 0;
 
         while (!found_new_request && poll_count < max_polls && !shutdown_requested_.load(std::memory_order_relaxed)) {
-            mtp::ByteArray response = mtp_session_->Operation922d(3, 3);
+            mtp::ByteArray response = Poll922d();
             poll_count++;
 
             if (!response.empty() && PPPParser::IsValidFrame(response)) {
@@ -447,7 +453,7 @@ void NetworkManager::TriggerNetworkMode() {
                 IPCPParser::IPCPPacket reject_packet;
                 if (PPPParser_FindIPCPFrame(response, IPCPParser::IPCP_CODE_CONFIG_REJECT, reject_packet)) {
                     found_config_reject = true;
-                    Log("  [OK] Received Config-Reject (ID=" + std::to_string(reject_packet.identifier) +
+                    NETWORK_LOG(PPP, INFO, "  [OK] Received Config-Reject (ID=" + std::to_string(reject_packet.identifier) +
                         ") - device rejecting compression option");
                 }
 
@@ -458,9 +464,9 @@ void NetworkManager::TriggerNetworkMode() {
                     new_request_id = new_config_request.identifier;
                     device_new_request = response;
                     found_new_request = true;
-                    Log("  [OK] Received device's new Config-Request (ID=" + std::to_string(new_request_id) +
+                    NETWORK_LOG(PPP, INFO, "  [OK] Received device's new Config-Request (ID=" + std::to_string(new_request_id) +
                         "): " + std::to_string(response.size()) + " bytes (poll " + std::to_string(poll_count) + ")");
-                    Log("    Data: " + format_hex(response, 50));
+                    NETWORK_LOG(PPP, INFO, "    Data: " + format_hex(response, 50));
                 }
             }
 
@@ -471,7 +477,7 @@ void NetworkManager::TriggerNetworkMode() {
 
         if (!found_new_request) {
             if (shutdown_requested_.load(std::memory_order_relaxed)) return;
-            Log("  [FAIL] Device did not send new IPCP Config-Request after Config-Nak");
+            NETWORK_LOG(PPP, ERROR, "  [FAIL] Device did not send new IPCP Config-Request after Config-Nak");
             throw std::runtime_error("Device IPCP negotiation failed after Config-Nak");
         }
 
@@ -482,73 +488,32 @@ void NetworkManager::TriggerNetworkMode() {
 
         // Step 9: Send SECOND Config-Request (ID=2, WITHOUT compression) + Config-Ack
         // Per Windows capture Frame 2387: After receiving Config-Reject, send new Config-Request without compression
-        Log("Building second IPCP Config-Request (without compression) + Config-Ack...");
-
-        // Build Config-Request WITHOUT compression (ID=2)
-        // NOTE: Build IPCP packet only (no protocol bytes) - WrapPayload adds protocol
-        mtp::ByteArray our_second_request;
-        our_second_request.push_back(0x01); // Config-Request
-        our_second_request.push_back(0x02); // Identifier = 2 (second request, after compression rejected)
-        our_second_request.push_back(0x00); // Length high byte
-        our_second_request.push_back(0x0A); // Length low byte (10 bytes total)
-        // Option 3: IP-Address (NO compression option this time)
-        our_second_request.push_back(0x03); // Option type 3 (IP-Address)
-        our_second_request.push_back(0x06); // Option length (6 bytes)
-        our_second_request.push_back((host_ip >> 24) & 0xFF);
-        our_second_request.push_back((host_ip >> 16) & 0xFF);
-        our_second_request.push_back((host_ip >> 8) & 0xFF);
-        our_second_request.push_back(host_ip & 0xFF);
-        mtp::ByteArray our_second_request_ppp = PPPParser::WrapPayload(our_second_request, 0x8021);
-
-        // Build Config-Ack for device's new Config-Request
-        mtp::ByteArray config_ack_ipcp = IPCPParser::BuildConfigAck(device_request);
-        mtp::ByteArray config_ack_ppp = PPPParser::WrapPayload(config_ack_ipcp, 0x8021);
-
-        // Combine: Second Config-Request + Config-Ack
-        mtp::ByteArray second_ipcp_payload;
-        second_ipcp_payload.insert(second_ipcp_payload.end(),
-                                   our_second_request_ppp.begin(), our_second_request_ppp.end());
-        second_ipcp_payload.insert(second_ipcp_payload.end(),
-                                   config_ack_ppp.begin(), config_ack_ppp.end());
-
-        Log("Sending second IPCP Config-Request (no compression) + Config-Ack...");
-        Log("  → Our Config-Request (ID=2) for " + IPParser::IPToString(host_ip) + " (no compression)");
-        Log("  → Config-Ack for device's Config-Request (ID=" + std::to_string(device_request.identifier) + ")");
-        mtp_session_->Operation922c(second_ipcp_payload, 3, 3);
-        Log("  [OK] Second IPCP Config-Request + Config-Ack sent");
+        NETWORK_LOG(PPP, INFO, "Sending second IPCP Config-Request (no compression) + Config-Ack...");
+        NETWORK_LOG(PPP, INFO, "  → Our Config-Request (ID=2) for " + IPParser::IPToString(host_ip) + " (no compression)");
+        NETWORK_LOG(PPP, INFO, "  → Config-Ack for device's Config-Request (ID=" + std::to_string(device_request.identifier) + ")");
+        Send922c(link_profile_.SecondReply(device_request));
+        NETWORK_LOG(PPP, INFO, "  [OK] Second IPCP Config-Request + Config-Ack sent");
     } else {
         // Device sent valid IP - send Config-Request + CCP + Config-Ack
-        VerboseLog("Building initial IPCP response (Config-Request + CCP + Config-Ack)...");
-        Log("  → Device requested valid IP: " + IPParser::IPToString(device_requested_ip));
+        NETWORK_LOG(PPP, DEBUG, "Building initial IPCP response (Config-Request + CCP + Config-Ack)...");
+        NETWORK_LOG(PPP, INFO, "  → Device requested valid IP: " + IPParser::IPToString(device_requested_ip));
 
-        mtp::ByteArray config_ack_ipcp = IPCPParser::BuildConfigAck(device_request);
-        mtp::ByteArray config_ack_ppp = PPPParser::WrapPayload(config_ack_ipcp, 0x8021);
-
-        // Combine in Windows order: Config-Request + CCP + Config-Ack
-        mtp::ByteArray initial_ipcp_payload;
-        initial_ipcp_payload.insert(initial_ipcp_payload.end(),
-                                   our_config_request_ppp.begin(), our_config_request_ppp.end());
-        initial_ipcp_payload.insert(initial_ipcp_payload.end(),
-                                   ccp_request_ppp.begin(), ccp_request_ppp.end());
-        initial_ipcp_payload.insert(initial_ipcp_payload.end(),
-                                   config_ack_ppp.begin(), config_ack_ppp.end());
-
-        VerboseLog("Sending IPCP Config-Request + CCP + Config-Ack...");
-        Log("  → Our Config-Request for " + IPParser::IPToString(host_ip));
-        VerboseLog("  → CCP Config-Request");
-        Log("  → Config-Ack for device's Config-Request");
-        mtp_session_->Operation922c(initial_ipcp_payload, 3, 3);
-        Log("  [OK] Initial IPCP sent");
+        NETWORK_LOG(PPP, DEBUG, "Sending IPCP Config-Request + CCP + Config-Ack...");
+        NETWORK_LOG(PPP, INFO, "  → Our Config-Request for " + IPParser::IPToString(host_ip));
+        NETWORK_LOG(PPP, DEBUG, "  → CCP Config-Request");
+        NETWORK_LOG(PPP, INFO, "  → Config-Ack for device's Config-Request");
+        Send922c(link_profile_.AckReply(device_request));
+        NETWORK_LOG(PPP, INFO, "  [OK] Initial IPCP sent");
     }
 
     // Step 10: Poll for device's Config-Ack to our Config-Request
-    Log("Polling for device IPCP Config-Ack...");
+    NETWORK_LOG(PPP, INFO, "Polling for device IPCP Config-Ack...");
     mtp::ByteArray device_config_ack;
     poll_count = 0;
     bool found_config_ack = false;
 
     while (!found_config_ack && poll_count < max_polls && !shutdown_requested_.load(std::memory_order_relaxed)) {
-        mtp::ByteArray response = mtp_session_->Operation922d(3, 3);
+        mtp::ByteArray response = Poll922d();
         poll_count++;
 
         if (!response.empty() && PPPParser::IsValidFrame(response)) {
@@ -557,9 +522,9 @@ void NetworkManager::TriggerNetworkMode() {
             IPCPParser::IPCPPacket ack_packet;
             if (PPPParser_FindIPCPFrame(response, IPCPParser::IPCP_CODE_CONFIG_ACK, ack_packet) &&
                 (ack_packet.identifier == 0x01 || ack_packet.identifier == 0x02)) {
-                Log("  [OK] Received device IPCP Config-Ack (ID=" + std::to_string(ack_packet.identifier) +
+                NETWORK_LOG(PPP, INFO, "  [OK] Received device IPCP Config-Ack (ID=" + std::to_string(ack_packet.identifier) +
                     "): " + std::to_string(response.size()) + " bytes (poll " + std::to_string(poll_count) + ")");
-                Log("    Data: " + format_hex(response, 50));
+                NETWORK_LOG(PPP, INFO, "    Data: " + format_hex(response, 50));
                 device_config_ack = response;
                 found_config_ack = true;
             }
@@ -572,11 +537,18 @@ void NetworkManager::TriggerNetworkMode() {
 
     if (!found_config_ack) {
         if (shutdown_requested_.load(std::memory_order_relaxed)) return;
-        Log("  [FAIL] Device did not send IPCP Config-Ack after " + std::to_string(max_polls) + " polls");
+        NETWORK_LOG(PPP, ERROR, "  [FAIL] Device did not send IPCP Config-Ack after " + std::to_string(max_polls) + " polls");
         throw std::runtime_error("Device did not complete IPCP negotiation");
     }
 
-    Log("[OK] Network mode fully established - Bidirectional LCP and IPCP handshakes complete!");
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - trigger_start);
+    link_profile_.RecordNegotiation(device_requested_ip == 0, elapsed);
+    PPPLinkProfile::Stats link_stats = link_profile_.GetStats();
+    NETWORK_LOG(PPP, INFO, "[OK] Network mode fully established - Bidirectional LCP and IPCP handshakes complete!");
+    NETWORK_LOG(PPP, INFO, "  Negotiated in " + std::to_string(elapsed.count() / 1000) + " ms (session " +
+        std::to_string(link_stats.negotiations) + ", " + std::to_string(link_stats.replies_reused) +
+        " IPCP replies reused so far)");
 }
 
 USBHandlesWithEndpoints NetworkManager::ExtractUSBHandles() {
@@ -584,7 +556,7 @@ USBHandlesWithEndpoints NetworkManager::ExtractUSBHandles() {
         throw std::runtime_error("MTP session not initialized");
     }
 
-    Log("Extracting USB handles from MTP session...");
+    NETWORK_LOG(PPP, INFO, "Extracting USB handles from MTP session...");
 
     // Get the BulkPipe from the session
     auto pipe = mtp_session_->GetBulkPipe();
@@ -600,7 +572,7 @@ USBHandlesWithEndpoints NetworkManager::ExtractUSBHandles() {
         throw std::runtime_error("Failed to extract USB handles from session");
     }
 
-    Log("Discovering HTTP endpoints (0x01 IN/OUT) before disconnect...");
+    NETWORK_LOG(HTTP, INFO, "Discovering HTTP endpoints (0x01 IN/OUT) before disconnect...");
 
     // CRITICAL: Discover endpoints NOW while interface is still claimed by MTP
     // After disconnect, the interface becomes invalid for enumeration
@@ -618,11 +590,11 @@ USBHandlesWithEndpoints NetworkManager::ExtractUSBHandles() {
         if (address == 0x01 && type == mtp::usb::EndpointType::Bulk) {
             if (direction == mtp::usb::EndpointDirection::Out) {
                 endpoint_out = ep;
-                Log("  → Found HTTP OUT endpoint: 0x01");
+                NETWORK_LOG(HTTP, INFO, "  → Found HTTP OUT endpoint: 0x01");
             }
             else if (direction == mtp::usb::EndpointDirection::In) {
                 endpoint_in = ep;
-                Log("  → Found HTTP IN endpoint: 0x01");
+                NETWORK_LOG(HTTP, INFO, "  → Found HTTP IN endpoint: 0x01");
             }
         }
     }
@@ -631,9 +603,9 @@ USBHandlesWithEndpoints NetworkManager::ExtractUSBHandles() {
         throw std::runtime_error("Failed to discover HTTP endpoints 0x01 IN/OUT");
     }
 
-    Log("[OK] USB handles and endpoints extracted");
-    Log("  IMPORTANT: After MTP disconnect, you must re-claim the interface");
-    Log("  Call usb_device->ClaimInterface(usb_interface) to regain access");
+    NETWORK_LOG(PPP, INFO, "[OK] USB handles and endpoints extracted");
+    NETWORK_LOG(PPP, INFO, "  IMPORTANT: After MTP disconnect, you must re-claim the interface");
+    NETWORK_LOG(PPP, INFO, "  Call usb_device->ClaimInterface(usb_interface) to regain access");
 
     USBHandlesWithEndpoints handles;
     handles.device = usb_device;
@@ -646,6 +618,9 @@ USBHandlesWithEndpoints NetworkManager::ExtractUSBHandles() {
 
 void NetworkManager::SetPathResolverCallback(PathResolverCallback callback, void* user_data) {
     std::lock_guard<std::mutex> lock(interceptor_mutex_);
+    if (callback != pending_path_resolver_ || user_data != pending_path_resolver_user_data_) {
+        metadata_cache_.Clear();  // Cached responses came from the old resolver's files
+    }
     pending_path_resolver_ = callback;
     pending_path_resolver_user_data_ = user_data;
     if (http_interceptor_) {
@@ -653,6 +628,12 @@ void NetworkManager::SetPathResolverCallback(PathResolverCallback callback, void
     }
 }
 
+void NetworkManager::SetImageResizer(ImageVariantCache::Resizer resizer) {
+    image_variants_.SetResizer(std::move(resizer));
+    // Responses cached so far hold images as the old resizer left them
+    metadata_cache_.Clear();
+}
+
 void NetworkManager::SetCacheStorageCallback(CacheStorageCallback callback, void* user_data) {
     std::lock_guard<std::mutex> lock(interceptor_mutex_);
     pending_cache_storage_ = callback;
@@ -662,10 +643,3 @@ void NetworkManager::SetCacheStorageCallback(CacheStorageCallback callback, void
     }
 }
 
-void NetworkManager::SetVerboseNetworkLogging(bool enable) {
-    verbose_logging_ = enable;
-    std::lock_guard<std::mutex> lock(interceptor_mutex_);
-    if (http_interceptor_) {
-        http_interceptor_->SetVerboseLogging(enable);
-    }
-}
@@ -13,7 +13,16 @@
 #include <usb/Interface.h>
 
 #include "protocols/http/ZuneHTTPInterceptor.h"
+#include "protocols/http/ImageVariantCache.h"
+#include "protocols/http/MetadataDiskCache.h"
+#include "protocols/http/MetadataResponseCache.h"
+#include "protocols/http/NetworkPollLoop.h"
+#include "protocols/http/PacketCapture.h"
+#include "protocols/ppp/PPPLinkProfile.h"
 #include "ZuneTypes.h"
+#include "ZuneTransferStats.h"
+#include "ZuneMtpScheduler.h"
+#include "ZuneLog.h"
 
 
 // Forward declarations
@@ -23,11 +32,13 @@ struct InterceptorConfig;
 
 class NetworkManager {
 public:
-    using LogCallback = std::function<void(const std::string& message)>;
     using PathResolverCallback = const char* (*)(const char* artist_uuid, const char* endpoint_type, const char* resource_id, void* user_data);
     using CacheStorageCallback = bool (*)(const char* artist_uuid, const char* endpoint_type, const char* resource_id, const void* data, size_t data_length, const char* content_type, void* user_data);
 
-    NetworkManager(std::shared_ptr<mtp::Session> mtp_session, LogCallback log_callback);
+    NetworkManager(std::shared_ptr<mtp::Session> mtp_session, zune::Logger* logger,
+                   zune::TransferStats* transfer_stats = nullptr,
+                   zune::MtpScheduler* scheduler = nullptr,
+                   MetadataDiskCache* disk_cache = nullptr);
     ~NetworkManager();
 
     // --- Artist Metadata HTTP Interception ---
@@ -39,13 +50,38 @@ public:
     void TriggerNetworkMode();  // Send 0x922c(3,3) to initiate PPP/HTTP after track upload
     void EnableNetworkPolling();  // Enable polling flag - call AFTER TriggerNetworkMode()
     int PollNetworkData(int timeout_ms);  // Single poll cycle - called from C# in a loop
+
+    // Native alternative to calling PollNetworkData in a loop (see NetworkPollLoop);
+    // returns the token for StopNetworkPollLoop, 0 if a loop is already running
+    uint64_t StartNetworkPollLoop(NetworkPollLoop::EventFn on_event, int hot_wait_ms, int idle_wait_ms);
+    bool StopNetworkPollLoop(uint64_t token);  // 0 stops any loop
     void RequestShutdown();  // Signal shutdown and wait for in-flight operations to complete
-    void SetVerboseNetworkLogging(bool enable);  // Enable/disable verbose TCP/IP packet logging
 
     // Callback registration for hybrid mode
     void SetPathResolverCallback(PathResolverCallback callback, void* user_data);
     void SetCacheStorageCallback(CacheStorageCallback callback, void* user_data);
 
+    // In-memory metadata responses, kept across interceptor sessions
+    MetadataResponseCache::Stats GetMetadataCacheStats() const { return metadata_cache_.GetStats(); }
+    void ClearMetadataCache() { metadata_cache_.Clear(); }
+    void SetMetadataCacheCapacity(size_t bytes) { metadata_cache_.SetCapacity(bytes); }
+
+    // Local images resized to the width the device asks for, kept across
+    // interceptor sessions; an empty resizer sends the files as they are
+    void SetImageResizer(ImageVariantCache::Resizer resizer);
+    ImageVariantCache::Stats GetImageVariantStats() const { return image_variants_.GetStats(); }
+
+    // Ring of raw PPP traffic for Wireshark, kept across interceptor sessions;
+    // 0 transfers stops capturing. Writes frames to a pcap, -1 on failure.
+    void SetPacketCapture(size_t max_transfers) { packet_capture_.Enable(max_transfers); }
+    int64_t WritePacketCapture(const std::string& path) const { return packet_capture_.WritePcap(path); }
+
+    // HTTP request worker lanes of the running interceptor (zeroed if none)
+    RequestWorkerStats GetRequestWorkerStats() const;
+
+    // TCP, queue and transfer stats of the interceptor (zeroed if none)
+    InterceptorNetworkStats GetNetworkStats() const;
+
     // --- Raw USB Access (for monitoring without MTP session) ---
     // Extracts USB device/interface/endpoints from MTP session for raw monitoring
     // Call this BEFORE Disconnect() - discovers endpoints while interface is still claimed
@@ -54,10 +90,16 @@ public:
 
 private:
     std::shared_ptr<mtp::Session> mtp_session_;
-    LogCallback log_callback_;
+    zune::Logger* logger_;                 // Owned by ZuneDevice; may be null
+    zune::TransferStats* transfer_stats_;  // Owned by ZuneDevice; may be null
+    zune::MtpScheduler* scheduler_;        // Owned by ZuneDevice; may be null
+    MetadataDiskCache* disk_cache_;        // Owned by ZuneDevice; may be null
     std::shared_ptr<ZuneHTTPInterceptor> http_interceptor_;
+    MetadataResponseCache metadata_cache_;  // Outlives each interceptor
+    ImageVariantCache image_variants_;      // Likewise
+    PacketCapture packet_capture_;          // Also covers the PPP negotiation
+    PPPLinkProfile link_profile_;           // Negotiated link, warm across sessions
     mutable std::mutex interceptor_mutex_;
-    bool verbose_logging_ = true;
 
     // Deferred callbacks — stored until interceptor is created
     PathResolverCallback pending_path_resolver_ = nullptr;
@@ -70,6 +112,9 @@ private:
     std::mutex shutdown_mutex_;
     std::condition_variable shutdown_cv_;
 
-    void Log(const std::string& message);
-    void VerboseLog(const std::string& message);
+    NetworkPollLoop poll_loop_;  // Declared last: stopped before anything it polls is gone
+
+    // 0x922c / 0x922d, counted in transfer_stats_ and scheduled as ZUNE_MTP_CLASS_NETWORK
+    void Send922c(const mtp::ByteArray& payload);
+    mtp::ByteArray Poll922d();
 };
@@ -1,11 +1,82 @@
 #include "ZMDBLibraryExtractor.h"
+#include "zmdb/ZMDBUtils.h"
 #include <cstring>
 #include <iostream>
 #include <algorithm>
 #include <set>
 
+// SSE2 is baseline on x86-64; other targets use the scalar scans
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZMDB_LEGACY_SSE2 1
+#endif
+
 namespace zmdb_legacy {
 
+namespace {
+
+/**
+ * First F marker (byte 3 == 0x46, byte 2 == 0x00) at begin + 4k with
+ * begin + 4k < last, or last if none. memchr skips to each 0x46 byte; hits
+ * off the 4-byte grid or without the zero byte are stepped over.
+ */
+size_t ScanFMarker(const uint8_t* data, size_t size, size_t begin, size_t last) {
+    const size_t limit = std::min(last, size >= 4 ? size - 3 : 0);  // Whole marker in the blob
+    size_t pos = begin;
+    while (pos < limit) {
+        const void* hit = std::memchr(data + pos + 3, 0x46, limit - pos);
+        if (!hit) {
+            break;
+        }
+        size_t marker = static_cast<const uint8_t*>(hit) - data - 3;
+        size_t misaligned = (marker - begin) & 3;
+        if (misaligned == 0 && data[marker + 2] == 0x00) {
+            return marker;
+        }
+        pos = marker + (misaligned ? 4 - misaligned : 4);
+    }
+    return last;
+}
+
+/**
+ * First offset in [begin, end) holding a 0x3009 or 0xB901 track codec
+ * marker (little-endian u16), or end if none. Reads data[end], so callers
+ * keep end < size.
+ */
+size_t ScanTrackMarker(const uint8_t* data, size_t begin, size_t end) {
+    size_t pos = begin;
+#if defined(ZMDB_LEGACY_SSE2)
+    const __m128i mp3_lo = _mm_set1_epi8(0x09);
+    const __m128i mp3_hi = _mm_set1_epi8(0x30);
+    const __m128i wma_lo = _mm_set1_epi8(0x01);
+    const __m128i wma_hi = _mm_set1_epi8(static_cast<char>(0xB9));
+    // Low bytes at pos..pos+15, high bytes one further on
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+        __m128i mp3 = _mm_and_si128(_mm_cmpeq_epi8(lo, mp3_lo), _mm_cmpeq_epi8(hi, mp3_hi));
+        __m128i wma = _mm_and_si128(_mm_cmpeq_epi8(lo, wma_lo), _mm_cmpeq_epi8(hi, wma_hi));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(mp3, wma)));
+        if (mask != 0) {
+            while ((mask & 1) == 0) {
+                mask >>= 1;
+                pos++;
+            }
+            return pos;
+        }
+    }
+#endif
+    for (; pos < end; pos++) {
+        uint16_t marker = data[pos] | (data[pos + 1] << 8);
+        if (marker == 0x3009 || marker == 0xB901) {
+            return pos;
+        }
+    }
+    return end;
+}
+
+} // namespace
+
 ZMDBLibraryExtractor::ZMDBLibraryExtractor() {
 }
 
@@ -54,8 +125,10 @@ ZMDBLibrary ZMDBLibraryExtractor::ExtractLibrary(const mtp::ByteArray& zmdb_data
 
             // Albums without direct metadata need at least one organizational property to be valid
             if (!has_direct && !has_0x0100_plus1 && !has_0x0500) {
-                Log("Album 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
-                    "): SKIPPED - garbage data (no direct metadata or organizational properties)");
+                if (verbose_) {
+                    Log("Album 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
+                        "): SKIPPED - garbage data (no direct metadata or organizational properties)");
+                }
                 albums_skipped_garbage++;
                 continue;
             }
@@ -84,8 +157,10 @@ ZMDBLibrary ZMDBLibraryExtractor::ExtractLibrary(const mtp::ByteArray& zmdb_data
                 library.albums_by_artist[album.artist_name].push_back(album);
                 albums_added++;
             } else {
-                Log("Album 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
-                    "): SKIPPED - missing title or artist");
+                if (verbose_) {
+                    Log("Album 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
+                        "): SKIPPED - missing title or artist");
+                }
             }
         } catch (const std::exception& e) {
             Log("Error extracting album " + std::to_string(album_pid) + ": " + e.what());
@@ -119,23 +194,22 @@ ZMDBLibrary ZMDBLibraryExtractor::ExtractLibrary(const mtp::ByteArray& zmdb_data
     return library;
 }
 
-std::map<uint32_t, uint32_t> ZMDBLibraryExtractor::BuildPropertyMap(const mtp::ByteArray& blob, size_t start) {
-    std::map<uint32_t, uint32_t> props;
+ZMDBLibraryExtractor::PropertyMap ZMDBLibraryExtractor::BuildPropertyMap(const mtp::ByteArray& blob, size_t start) {
+    PropertyMap props;
+    const uint8_t* data = blob.data();
     size_t offset = start;
 
     while (offset + 8 <= blob.size()) {
         uint32_t ptr, pid;
-        std::memcpy(&ptr, &blob[offset], 4);
-        std::memcpy(&pid, &blob[offset + 4], 4);
+        std::memcpy(&ptr, data + offset, 4);
+        std::memcpy(&pid, data + offset + 4, 4);
 
         if (ptr == 0 && pid == 0) {
             break;  // Terminator
         }
 
         // Only store first occurrence of each PID (like Python: if pid not in property_map)
-        if (props.find(pid) == props.end()) {
-            props[pid] = ptr;
-        }
+        props.emplace(pid, ptr);
         offset += 8;
     }
 
@@ -145,16 +219,14 @@ std::map<uint32_t, uint32_t> ZMDBLibraryExtractor::BuildPropertyMap(const mtp::B
 std::string ZMDBLibraryExtractor::ReadNullTerminatedAscii(const mtp::ByteArray& blob, size_t pos) const {
     if (pos >= blob.size()) return "";
 
-    size_t end = pos;
-    while (end < blob.size() && blob[end] != 0) {
-        end++;
-    }
+    const char* begin = reinterpret_cast<const char*>(blob.data() + pos);
+    const void* null = std::memchr(begin, 0, blob.size() - pos);
+    size_t length = null ? static_cast<const char*>(null) - begin : blob.size() - pos;
 
-    return std::string(reinterpret_cast<const char*>(&blob[pos]), end - pos);
+    return std::string(begin, length);
 }
 
 std::string ZMDBLibraryExtractor::ReadUtf16LeUntilDelimiter(const mtp::ByteArray& blob, size_t start, size_t end) const {
-    std::string result;
     size_t pos = start;
 
     // Check for 18-byte GUID prefix (marker 0x1410 at offset 16-17)
@@ -166,55 +238,47 @@ std::string ZMDBLibraryExtractor::ReadUtf16LeUntilDelimiter(const mtp::ByteArray
         }
     }
 
-    while (pos + 1 < end && pos + 1 < blob.size()) {
-        uint16_t char_code;
-        std::memcpy(&char_code, &blob[pos], 2);
-
-        if (char_code == 0) break;
-
-        // Convert UTF-16LE to UTF-8
-        if (char_code < 0x80) {
-            // ASCII range - single byte
-            result += static_cast<char>(char_code);
-        } else if (char_code < 0x800) {
-            // 2-byte UTF-8
-            result += static_cast<char>(0xC0 | (char_code >> 6));
-            result += static_cast<char>(0x80 | (char_code & 0x3F));
-        } else {
-            // 3-byte UTF-8 (covers BMP - Basic Multilingual Plane)
-            result += static_cast<char>(0xE0 | (char_code >> 12));
-            result += static_cast<char>(0x80 | ((char_code >> 6) & 0x3F));
-            result += static_cast<char>(0x80 | (char_code & 0x3F));
-        }
-
-        pos += 2;
+    // Whole code units in [pos, min(end, blob.size())), up to the first null
+    size_t stop = std::min(end, blob.size());
+    if (pos >= stop) {
+        return "";
     }
-
-    return result;
+    return zmdb::utf16le_to_utf8(zmdb::ByteView(blob.data() + pos, stop - pos));
 }
 
 size_t ZMDBLibraryExtractor::FindUtf16LePattern(const mtp::ByteArray& blob, size_t start, const std::string& pattern, size_t max_search) const {
-    // Convert pattern to UTF-16LE bytes
-    std::vector<uint8_t> pattern_bytes;
-    for (char c : pattern) {
-        pattern_bytes.push_back(static_cast<uint8_t>(c));
-        pattern_bytes.push_back(0x00);
+    // Pattern is ASCII; in UTF-16LE every character is followed by 0x00
+    const size_t pattern_size = pattern.size() * 2;
+    if (start > blob.size() || blob.size() - start < pattern_size) {
+        return 0;
     }
 
-    // Search for pattern
-    for (size_t offset = 0; offset < max_search; offset++) {
-        size_t pos = start + offset;
-        if (pos + pattern_bytes.size() > blob.size()) break;
+    // Candidate starts: the first max_search offsets that leave room for the pattern
+    const size_t last = std::min(start + max_search, blob.size() - pattern_size + 1);
+    if (pattern.empty()) {
+        return start < last ? start : 0;
+    }
+
+    const uint8_t* data = blob.data();
+    const uint8_t first = static_cast<uint8_t>(pattern[0]);
+    size_t pos = start;
+    while (pos < last) {
+        const void* hit = std::memchr(data + pos, first, last - pos);
+        if (!hit) {
+            break;
+        }
+        pos = static_cast<const uint8_t*>(hit) - data;
 
         bool match = true;
-        for (size_t i = 0; i < pattern_bytes.size(); i++) {
-            if (blob[pos + i] != pattern_bytes[i]) {
+        for (size_t i = 0; i < pattern.size(); i++) {
+            if (data[pos + 2 * i] != static_cast<uint8_t>(pattern[i]) || data[pos + 2 * i + 1] != 0x00) {
                 match = false;
                 break;
             }
         }
 
         if (match) return pos;
+        pos++;
     }
 
     return 0;  // Not found
@@ -234,12 +298,12 @@ bool ZMDBLibraryExtractor::IsFMarker(const mtp::ByteArray& blob, size_t offset)
 }
 
 size_t ZMDBLibraryExtractor::FindFMarker(const mtp::ByteArray& blob, size_t start, size_t max_search) const {
-    for (size_t offset = 0; offset < max_search; offset += 4) {
-        if (IsFMarker(blob, start + offset)) {
-            return start + offset;
-        }
+    if (start >= blob.size()) {
+        return 0;
     }
-    return 0;
+    size_t last = start + std::min(max_search, blob.size() - start);
+    size_t offset = ScanFMarker(blob.data(), blob.size(), start, last);
+    return offset < last ? offset : 0;
 }
 
 ZMDBLibraryExtractor::FMarkerData ZMDBLibraryExtractor::ExtractFromFMarker(
@@ -318,8 +382,10 @@ ZMDBLibraryExtractor::MetadataResult ZMDBLibraryExtractor::ExtractMetadataDirect
 
     // Find null terminator
     size_t null_pos = ptr + metadata_offset;
-    while (null_pos < blob.size() && null_pos < ptr + 200 && blob[null_pos] != 0) {
-        null_pos++;
+    if (const void* null = std::memchr(blob.data() + null_pos, 0, ptr + 200 - null_pos)) {
+        null_pos = static_cast<const uint8_t*>(null) - blob.data();
+    } else {
+        null_pos = ptr + 200;
     }
 
     // Read UTF-16LE string after null terminator
@@ -348,26 +414,30 @@ ZMDBLibraryExtractor::MetadataResult ZMDBLibraryExtractor::FindFMarkerWithMatchi
     MetadataResult result;
 
     // Search for F-markers (Python: searches to end of file, not just 200 bytes!)
-    for (size_t f_offset = 0; ptr + f_offset + 4 < blob.size(); f_offset += 4) {
-        if (IsFMarker(blob, ptr + f_offset)) {
-            // Read F-marker's 0x0800 ref at bytes +4-7
-            uint32_t f_marker_0x0800_ref = 0;
-            if (ptr + f_offset + 8 <= blob.size()) {
-                std::memcpy(&f_marker_0x0800_ref, &blob[ptr + f_offset + 4], 4);
-            }
+    // Candidates need ptr + f_offset + 4 < size, i.e. start before size - 4
+    const size_t last = blob.size() > 4 ? blob.size() - 4 : 0;
+    for (size_t marker = ScanFMarker(blob.data(), blob.size(), ptr, last); marker < last;
+         marker = ScanFMarker(blob.data(), blob.size(), marker + 4, last)) {
+        size_t f_offset = marker - ptr;
+        // Read F-marker's 0x0800 ref at bytes +4-7
+        uint32_t f_marker_0x0800_ref = 0;
+        if (ptr + f_offset + 8 <= blob.size()) {
+            std::memcpy(&f_marker_0x0800_ref, &blob[ptr + f_offset + 4], 4);
+        }
 
-            // No refs = take first F-marker
-            // Otherwise match refs
-            if (track_0x0800_refs.empty() || track_0x0800_refs.count(f_marker_0x0800_ref) > 0) {
-                FMarkerData f_data = ExtractFromFMarker(blob, ptr, f_offset, family);
-                if (f_data.valid) {
-                    result.album_name = f_data.album_name;
-                    result.artist_name = f_data.artist_name;
-                    result.alb_reference = f_data.alb_reference;
-                    result.valid = true;
+        // No refs = take first F-marker
+        // Otherwise match refs
+        if (track_0x0800_refs.empty() || track_0x0800_refs.count(f_marker_0x0800_ref) > 0) {
+            FMarkerData f_data = ExtractFromFMarker(blob, ptr, f_offset, family);
+            if (f_data.valid) {
+                result.album_name = f_data.album_name;
+                result.artist_name = f_data.artist_name;
+                result.alb_reference = f_data.alb_reference;
+                result.valid = true;
+                if (verbose_) {
                     Log("FindFMarkerWithMatching: Found at offset " + std::to_string(f_offset) + " -> '" + result.album_name + "' / '" + result.artist_name + "'");
-                    return result;
                 }
+                return result;
             }
         }
     }
@@ -392,73 +462,78 @@ std::map<uint32_t, std::vector<ZMDBTrack>> ZMDBLibraryExtractor::ScanTracks(
     int total_markers_found = 0;
     int valid_tracks = 0;
 
-    for (size_t offset = TRACK_REGION_START; offset < TRACK_REGION_END; offset++) {
-        uint16_t marker;
-        std::memcpy(&marker, &blob[offset], 2);
-
-        // Track markers: 0x3009 or 0xB901
-        if (marker == 0x3009 || marker == 0xB901) {
-            total_markers_found++;
-            ZMDBTrack track;
+    // Track markers: 0x3009 or 0xB901
+    const uint8_t* data = blob.data();
+    for (size_t offset = ScanTrackMarker(data, TRACK_REGION_START, TRACK_REGION_END); offset < TRACK_REGION_END;
+         offset = ScanTrackMarker(data, offset + 1, TRACK_REGION_END)) {
+        total_markers_found++;
+        ZMDBTrack track;
 
-            // Read track title (ASCII string at offset+4)
-            if (offset + 4 < blob.size()) {
-                track.title = ReadNullTerminatedAscii(blob, offset + 4);
-            }
+        // Read track title (ASCII string at offset+4)
+        if (offset + 4 < blob.size()) {
+            track.title = ReadNullTerminatedAscii(blob, offset + 4);
+        }
 
-            // Skip if title is empty or too short
-            if (track.title.length() < 1) {
+        // Skip if title is empty or too short
+        if (track.title.length() < 1) {
+            if (verbose_) {
                 Log("ScanTracks: Marker at 0x" + std::to_string(offset) + " has empty title, skipping");
-                continue;
             }
+            continue;
+        }
 
-            valid_tracks++;
+        valid_tracks++;
 
-            // Read track number (byte at offset-4)
-            if (offset >= 4) {
-                track.track_number = blob[offset - 4];
-            }
+        // Read track number (byte at offset-4)
+        if (offset >= 4) {
+            track.track_number = blob[offset - 4];
+        }
 
-            // Read album PID (4 bytes at device-specific offset)
-            if (offset >= static_cast<size_t>(-ALBUM_PID_OFFSET)) {
-                uint32_t album_pid;
-                std::memcpy(&album_pid, &blob[offset + ALBUM_PID_OFFSET], 4);
-
-                uint16_t category = GetPropertyCategory(album_pid);
-                // Validate it's an album PID (0x0600 category)
-                if (category == 0x0600) {
-                    // For ZuneHD: Convert album_pid (0x0600xxxx) to metadata_pid (0x0800xxxx)
-                    // For Classic: Use album_pid as-is (0x0600xxxx)
-                    uint32_t metadata_pid = album_pid;
-                    if (is_zunehd) {
-                        uint16_t album_idx = GetPropertyIndex(album_pid);
-                        metadata_pid = (0x0800 << 16) | album_idx;
-                    }
+        // Read album PID (4 bytes at device-specific offset)
+        if (offset >= static_cast<size_t>(-ALBUM_PID_OFFSET)) {
+            uint32_t album_pid;
+            std::memcpy(&album_pid, &blob[offset + ALBUM_PID_OFFSET], 4);
+
+            uint16_t category = GetPropertyCategory(album_pid);
+            // Validate it's an album PID (0x0600 category)
+            if (category == 0x0600) {
+                // For ZuneHD: Convert album_pid (0x0600xxxx) to metadata_pid (0x0800xxxx)
+                // For Classic: Use album_pid as-is (0x0600xxxx)
+                uint32_t metadata_pid = album_pid;
+                if (is_zunehd) {
+                    uint16_t album_idx = GetPropertyIndex(album_pid);
+                    metadata_pid = (0x0800 << 16) | album_idx;
+                }
 
-                    // Read ref_0x0800 from track offset -20 (for matching F-markers)
-                    uint32_t ref_0x0800 = 0;
-                    if (offset >= static_cast<size_t>(-REF_0X0800_OFFSET)) {
-                        std::memcpy(&ref_0x0800, &blob[offset + REF_0X0800_OFFSET], 4);
-                        // Store the ref for this album (keyed by metadata_pid!)
-                        if (ref_0x0800 != 0) {
-                            album_tracks_refs[metadata_pid].insert(ref_0x0800);
-                        }
+                // Read ref_0x0800 from track offset -20 (for matching F-markers)
+                uint32_t ref_0x0800 = 0;
+                if (offset >= static_cast<size_t>(-REF_0X0800_OFFSET)) {
+                    std::memcpy(&ref_0x0800, &blob[offset + REF_0X0800_OFFSET], 4);
+                    // Store the ref for this album (keyed by metadata_pid!)
+                    if (ref_0x0800 != 0) {
+                        album_tracks_refs[metadata_pid].insert(ref_0x0800);
                     }
+                }
 
-                    album_tracks[metadata_pid].push_back(track);
-                    uint16_t album_cat = GetPropertyCategory(album_pid);
-                    uint16_t album_idx = GetPropertyIndex(album_pid);
-                    uint16_t meta_cat = GetPropertyCategory(metadata_pid);
-                    uint16_t meta_idx = GetPropertyIndex(metadata_pid);
+                album_tracks[metadata_pid].push_back(track);
+                uint16_t album_cat = GetPropertyCategory(album_pid);
+                uint16_t album_idx = GetPropertyIndex(album_pid);
+                uint16_t meta_cat = GetPropertyCategory(metadata_pid);
+                uint16_t meta_idx = GetPropertyIndex(metadata_pid);
+                if (verbose_) {
                     Log("ScanTracks: Track '" + track.title + "' -> album_pid=0x" + std::to_string(album_pid) +
                         " (cat=0x" + std::to_string(album_cat) + " idx=" + std::to_string(album_idx) +
                         "), metadata_pid=0x0800[" + std::to_string(meta_idx) + "]" +
                         " (ref=0x" + std::to_string(ref_0x0800) + ")");
-                } else {
+                }
+            } else {
+                if (verbose_) {
                     Log("ScanTracks: Track '" + track.title + "' has invalid album PID 0x" + std::to_string(album_pid) +
                         " (category 0x" + std::to_string(category) + ", not 0x0600)");
                 }
-            } else {
+            }
+        } else {
+            if (verbose_) {
                 Log("ScanTracks: Track '" + track.title + "' at 0x" + std::to_string(offset) +
                     " cannot read album PID (offset too small)");
             }
@@ -476,7 +551,7 @@ std::map<uint32_t, std::vector<ZMDBTrack>> ZMDBLibraryExtractor::ScanTracks(
 ZMDBAlbum ZMDBLibraryExtractor::ExtractAlbum(
     const mtp::ByteArray& blob,
     uint32_t album_pid,
-    const std::map<uint32_t, uint32_t>& props,
+    const PropertyMap& props,
     zune::DeviceFamily family,
     const std::set<uint32_t>& track_0x0800_refs) const {
 
@@ -528,7 +603,9 @@ ZMDBAlbum ZMDBLibraryExtractor::ExtractAlbum(
 
     // Try 3: Deterministic choice for ZuneHD, 0x0100[idx+1] for Zune30
     if (!metadata.valid) {
-        Log("Try 3: album_idx=" + std::to_string(album_idx) + " is_zunehd=" + std::string(is_zunehd ? "true" : "false"));
+        if (verbose_) {
+            Log("Try 3: album_idx=" + std::to_string(album_idx) + " is_zunehd=" + std::string(is_zunehd ? "true" : "false"));
+        }
         if (is_zunehd) {
             // Check if 0x0500[idx] exists - indicates organizational structure
             uint32_t pid_0x0500 = (0x0500 << 16) | album_idx;
@@ -645,11 +722,15 @@ ZMDBAlbum ZMDBLibraryExtractor::ExtractAlbum(
         album.title = metadata.album_name;
         album.artist_name = metadata.artist_name;
         album.alb_reference = metadata.alb_reference;
-        Log("ExtractAlbum 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
-            "): album='" + album.title + "' artist='" + album.artist_name + "' source=" + source);
+        if (verbose_) {
+            Log("ExtractAlbum 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
+                "): album='" + album.title + "' artist='" + album.artist_name + "' source=" + source);
+        }
     } else {
-        Log("ExtractAlbum 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
-            "): NO METADATA FOUND");
+        if (verbose_) {
+            Log("ExtractAlbum 0x" + std::to_string(album_pid) + " (idx=" + std::to_string(album_idx) +
+                "): NO METADATA FOUND");
+        }
     }
 
     return album;
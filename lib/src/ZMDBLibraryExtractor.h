@@ -5,6 +5,7 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <cstdint>
 #include <mtp/ByteArray.h>
 #include "ZuneDeviceIdentification.h"
@@ -62,9 +63,18 @@ public:
      */
     ZMDBLibrary ExtractLibrary(const mtp::ByteArray& zmdb_data, zune::DeviceFamily family);
 
+    /**
+     * Log every track and album as it is resolved (off by default).
+     * Summaries and errors are always logged.
+     */
+    void SetVerbose(bool verbose) { verbose_ = verbose; }
+
 private:
+    // PID -> pointer, first occurrence of each PID
+    using PropertyMap = std::unordered_map<uint32_t, uint32_t>;
+
     // Core extraction algorithms
-    std::map<uint32_t, uint32_t> BuildPropertyMap(const mtp::ByteArray& blob, size_t start = 0x2F0);
+    PropertyMap BuildPropertyMap(const mtp::ByteArray& blob, size_t start = 0x2F0);
 
     // String utilities
     std::string ReadNullTerminatedAscii(const mtp::ByteArray& blob, size_t pos) const;
@@ -116,7 +126,7 @@ private:
     ZMDBAlbum ExtractAlbum(
         const mtp::ByteArray& blob,
         uint32_t album_pid,
-        const std::map<uint32_t, uint32_t>& props,
+        const PropertyMap& props,
         zune::DeviceFamily family,
         const std::set<uint32_t>& track_0x0800_refs) const;
 
@@ -126,6 +136,8 @@ private:
     // Property category extraction
     uint16_t GetPropertyCategory(uint32_t pid) const { return (pid >> 16) & 0xFFFF; }
     uint16_t GetPropertyIndex(uint32_t pid) const { return pid & 0xFFFF; }
+
+    bool verbose_ = false;
 };
 
 } // namespace zmdb_legacy
@@ -0,0 +1,116 @@
+#include "ZuneArtworkBatch.h"
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace zune {
+
+int ArtworkBatch::Run(const Source& source,
+                      const std::vector<uint32_t>& handles,
+                      const std::vector<std::string>& paths,
+                      const Sink& sink,
+                      std::vector<int>* results) {
+    const size_t count = handles.size();
+    if (results) results->assign(count, Failed);
+    if (count == 0)
+        return 0;
+
+    auto path_for = [&](size_t i) -> const std::string* {
+        return i < paths.size() && !paths[i].empty() ? &paths[i] : nullptr;
+    };
+
+    struct Fetched {
+        size_t index;
+        int status;
+        std::vector<uint8_t> data;
+    };
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Fetched> ready;      // At most one item waits while it is written
+    bool fetch_done = false;
+    bool stop = false;
+
+    std::thread fetcher([&] {
+        for (size_t i = 0; i < count; i++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return stop || ready.empty(); });
+                if (stop) break;
+            }
+            Fetched item{i, Failed, {}};
+            try {
+                const std::string* path = path_for(i);
+                uint64_t cached = 0;
+                if (path) {
+                    std::error_code ec;
+                    cached = std::filesystem::file_size(std::filesystem::u8path(*path), ec);
+                    if (ec) cached = 0;
+                }
+                // Compare with the artwork's own size, which is what the
+                // file holds after a download
+                if (cached > 0 && source.size && cached == source.size(handles[i])) {
+                    item.status = Cached;
+                } else if (source.fetch(handles[i], item.data)) {
+                    item.status = Downloaded;
+                }
+            } catch (...) {
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(std::move(item));
+            cv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        fetch_done = true;
+        cv.notify_all();
+    });
+
+    int result = 0;
+    try {
+        for (;;) {
+            Fetched item;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !ready.empty() || fetch_done; });
+                if (ready.empty())
+                    break;
+                item = std::move(ready.front());
+                ready.pop_front();
+            }
+            cv.notify_all();  // Fetcher may start on the next item now
+
+            if (item.status == Downloaded) {
+                const uint8_t* data = item.data.data();
+                size_t size = item.data.size();
+                if (const std::string* path = path_for(item.index)) {
+                    std::ofstream file(std::filesystem::u8path(*path), std::ios::binary);
+                    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+                    if (!file.good())
+                        item.status = Failed;
+                } else if (!sink) {
+                    item.status = Failed;
+                } else if (!sink(item.index, data, size)) {
+                    if (results) (*results)[item.index] = item.status;
+                    result = -2;
+                    break;
+                }
+            }
+            if (results) (*results)[item.index] = item.status;
+        }
+    } catch (...) {
+        result = -2;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    fetcher.join();
+    return result;
+}
+
+} // namespace zune
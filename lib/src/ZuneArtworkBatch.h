@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace zune {
+
+/// Artwork for many objects in one call (MtpReader::DownloadArtworkBatch).
+///
+/// Item i is written to paths[i] when that is non-empty, otherwise handed
+/// to sink (return false to stop). A helper thread fetches the next item's
+/// artwork while the current one is written. An item whose file already
+/// holds exactly its artwork size in bytes is kept without a fetch; when
+/// the source cannot tell the size, the artwork is always fetched.
+///
+/// The device side comes in through Source, so the batch runs without a
+/// session.
+class ArtworkBatch {
+public:
+    enum Status { Failed = -1, Downloaded = 0, Cached = 1 };
+    using Sink = std::function<bool(size_t index, const uint8_t* data, size_t size)>;
+
+    struct Source {
+        /// Byte size of handle's artwork without fetching it; 0 if unknown
+        std::function<uint64_t(uint32_t handle)> size;
+        /// handle's artwork bytes into data; false if there are none
+        std::function<bool(uint32_t handle, std::vector<uint8_t>& data)> fetch;
+    };
+
+    /// results (optional) receives one Status per handle; items not reached
+    /// after a stop stay Failed. Returns 0 when every item was attempted,
+    /// -2 if sink stopped.
+    static int Run(const Source& source,
+                   const std::vector<uint32_t>& handles,
+                   const std::vector<std::string>& paths,
+                   const Sink& sink,
+                   std::vector<int>* results);
+};
+
+} // namespace zune
@@ -0,0 +1,254 @@
+#include "ZuneArtworkPipeline.h"
+#include "ZuneFileStore.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unordered_set>
+
+namespace zune {
+
+uint32_t ArtworkPipeline::DefaultMaxDimension(DeviceFamily family) {
+    switch (family) {
+        case DeviceFamily::Keel:
+        case DeviceFamily::Scorpius:
+        case DeviceFamily::Draco:
+            return 240;     // 320x240 screen
+        case DeviceFamily::Pavo:
+            return 272;     // 480x272 screen
+        default:
+            return 0;
+    }
+}
+
+uint64_t ArtworkPipeline::Hash(const uint8_t* data, size_t size) {
+    return Fnv1a64(data, size);
+}
+
+uint64_t ArtworkPipeline::Key(uint64_t hash, size_t size) {
+    return hash ^ (static_cast<uint64_t>(size) * 0x9E3779B97F4A7C15ull);
+}
+
+bool ArtworkPipeline::JpegDimensions(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height) {
+    if (!data || size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) return false;
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {           // Fill byte
+            pos++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;                   // No length field
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) return false;    // EOI / SOS before any SOF
+
+        size_t length = (static_cast<size_t>(data[pos + 2]) << 8) | data[pos + 3];
+        if (length < 2 || pos + 2 + length > size) return false;
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (length < 7) return false;
+            height = (static_cast<uint32_t>(data[pos + 5]) << 8) | data[pos + 6];
+            width = (static_cast<uint32_t>(data[pos + 7]) << 8) | data[pos + 8];
+            return true;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+void ArtworkPipeline::Configure(const Options& options, DeviceFamily family) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = true;
+    options_ = options;
+    max_dimension_ = options.max_dimension ? options.max_dimension : DefaultMaxDimension(family);
+    prepared_.clear();
+    sent_.clear();
+    stats_ = Stats{};
+}
+
+void ArtworkPipeline::Disable() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = false;
+    options_ = Options{};
+    prepared_.clear();
+    sent_.clear();
+}
+
+bool ArtworkPipeline::IsEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+std::string ArtworkPipeline::CachePath(uint64_t hash, size_t size) const {
+    if (options_.cache_dir.empty()) return "";
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%zu-%u.jpg",
+                  static_cast<unsigned long long>(hash), size, max_dimension_);
+    return (std::filesystem::path(options_.cache_dir) / name).string();
+}
+
+std::shared_ptr<const std::vector<uint8_t>> ArtworkPipeline::Process(
+    const Job& job, const uint8_t* data, size_t size, bool& disk_hit)
+{
+    disk_hit = false;
+    if (!job.resize || job.max_dimension == 0) return nullptr;
+    uint32_t width = 0, height = 0;
+    if (!JpegDimensions(data, size, width, height) || std::max(width, height) <= job.max_dimension)
+        return nullptr;
+
+    if (!job.cache_path.empty()) {
+        std::ifstream file(job.cache_path, std::ios::binary);
+        if (file) {
+            auto cached = std::make_shared<std::vector<uint8_t>>(
+                (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (!cached->empty() && cached->size() < size) {
+                disk_hit = true;
+                return cached;
+            }
+        }
+    }
+
+    auto out = std::make_shared<std::vector<uint8_t>>(size);
+    size_t n = 0;
+    try {
+        n = job.resize(data, size, job.max_dimension, out->data(), out->size());
+    } catch (...) {
+        return nullptr;
+    }
+    if (n == 0 || n >= size) return nullptr;
+    out->resize(n);
+
+    if (!job.cache_path.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(job.cache_path).parent_path(), ec);
+        WriteFileAtomic(job.cache_path, *out);
+    }
+    return out;
+}
+
+bool ArtworkPipeline::LookupLocked(uint64_t hash, size_t size, Prepared& result, Job& job) {
+    stats_.images++;
+    result.key = Key(hash, size);
+    auto it = prepared_.find(result.key);
+    if (it != prepared_.end()) {
+        stats_.duplicates++;
+        result.data = it->second.data;
+        return true;
+    }
+    job.resize = options_.resize;
+    job.max_dimension = max_dimension_;
+    job.cache_path = CachePath(hash, size);
+    return false;
+}
+
+void ArtworkPipeline::StoreLocked(size_t size, Prepared& result, bool disk_hit) {
+    auto [it, inserted] = prepared_.try_emplace(result.key, Entry{result.data});
+    if (!inserted) {
+        stats_.duplicates++;        // Prepared concurrently
+        result.data = it->second.data;
+        return;
+    }
+    stats_.bytes_in += size;
+    stats_.bytes_out += result.data ? result.data->size() : size;
+    if (result.data) (disk_hit ? stats_.disk_hits : stats_.resized)++;
+}
+
+ArtworkPipeline::Prepared ArtworkPipeline::Prepare(const uint8_t* data, size_t size) {
+    uint64_t hash = Hash(data, size);
+    Prepared result;
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (LookupLocked(hash, size, result, job)) return result;
+    }
+
+    // Decode / resize and disk I/O run unlocked
+    bool disk_hit = false;
+    result.data = Process(job, data, size, disk_hit);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    StoreLocked(size, result, disk_hit);
+    return result;
+}
+
+void ArtworkPipeline::PrepareBatch(const std::vector<std::pair<const uint8_t*, size_t>>& images) {
+    // Hash and look up on this thread so each distinct image is processed once
+    struct Work {
+        const uint8_t* data;
+        size_t size;
+        Prepared result;
+        Job job;
+    };
+    std::vector<Work> work;
+    unsigned threads;
+    {
+        std::vector<std::pair<uint64_t, size_t>> hashes;
+        hashes.reserve(images.size());
+        for (const auto& [data, size] : images)
+            hashes.emplace_back(data && size > 0 ? Hash(data, size) : 0, size);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads = std::max(1u, options_.worker_threads);
+        std::unordered_set<uint64_t> queued;
+        for (size_t i = 0; i < images.size(); i++) {
+            if (!images[i].first || images[i].second == 0) continue;
+            Work w{images[i].first, images[i].second, {}, {}};
+            if (LookupLocked(hashes[i].first, hashes[i].second, w.result, w.job)) continue;
+            if (!queued.insert(w.result.key).second) {
+                stats_.duplicates++;
+                continue;
+            }
+            work.push_back(std::move(w));
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i = next++; i < work.size(); i = next++) {
+            Work& w = work[i];
+            bool disk_hit = false;
+            w.result.data = Process(w.job, w.data, w.size, disk_hit);
+            std::lock_guard<std::mutex> lock(mutex_);
+            StoreLocked(w.size, w.result, disk_hit);
+        }
+    };
+    threads = static_cast<unsigned>(std::min<size_t>(threads, work.size()));
+    if (threads <= 1) {
+        worker();
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++)
+        pool.emplace_back(worker);
+    for (auto& t : pool)
+        t.join();
+}
+
+bool ArtworkPipeline::ShouldSend(uint32_t object_id, uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = sent_.try_emplace(object_id, key);
+    if (!inserted && it->second == key) {
+        stats_.sends_skipped++;
+        return false;
+    }
+    it->second = key;
+    return true;
+}
+
+void ArtworkPipeline::ForgetSend(uint32_t object_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_.erase(object_id);
+}
+
+ArtworkPipeline::Stats ArtworkPipeline::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace zune
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ZuneDeviceIdentification.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace zune {
+
+/// Host-side artwork stage ahead of SetAlbumArtwork / SetSeriesArtwork.
+///
+/// Embedded covers are often 1-3 MB, the device only shows them at screen
+/// size, and compilations carry the same image on every track. Each image
+/// is keyed by a 64-bit hash of its bytes plus its size; one that has been
+/// seen this session is not processed again, and an object that already
+/// received it is not sent it twice.
+///
+/// The library has no image codec, so downscaling is the host's: the
+/// resize callback turns a JPEG into one no larger than max_dimension on
+/// either side. It is only called for images whose JPEG header says they
+/// are larger, and its output is only used when smaller than the input.
+/// Resized images are cached as <cache_dir>/<hash>-<size>-<dimension>.jpg
+/// so later sessions skip the resize as well.
+class ArtworkPipeline {
+public:
+    /// Write the resized JPEG into out (capacity bytes); return its size,
+    /// or 0 to keep the original. May run on several threads at once.
+    using Resizer = std::function<size_t(const uint8_t* jpeg, size_t size, uint32_t max_dimension,
+                                         uint8_t* out, size_t capacity)>;
+
+    struct Options {
+        Resizer resize;                 // Empty: dedup only
+        std::string cache_dir;          // Empty: no disk cache
+        uint32_t max_dimension = 0;     // 0: DefaultMaxDimension(family)
+        unsigned worker_threads = 2;    // For PrepareBatch
+    };
+
+    struct Stats {
+        uint64_t images = 0;            // Prepare calls, batch entries included
+        uint64_t duplicates = 0;        // Already prepared this session
+        uint64_t resized = 0;           // Resize callback produced a smaller image
+        uint64_t disk_hits = 0;         // Resized image loaded from cache_dir
+        uint64_t sends_skipped = 0;     // Object already had the image
+        uint64_t bytes_in = 0;          // Input bytes of the unique images
+        uint64_t bytes_out = 0;         // Bytes those images send as
+    };
+
+    /// Image to send. data is null when the caller's bytes go out unchanged.
+    struct Prepared {
+        std::shared_ptr<const std::vector<uint8_t>> data;
+        uint64_t key = 0;
+    };
+
+    /// Enable with options for a device family; resets the session state
+    void Configure(const Options& options, DeviceFamily family);
+    void Disable();
+    bool IsEnabled() const;
+
+    /// The image to send for data (cached, or processed on this thread)
+    Prepared Prepare(const uint8_t* data, size_t size);
+    /// Process many images on the worker pool, each distinct image once, so
+    /// the Prepare calls that follow during album creation are cache hits
+    void PrepareBatch(const std::vector<std::pair<const uint8_t*, size_t>>& images);
+
+    /// False if object_id was already sent this image; otherwise notes the send
+    bool ShouldSend(uint32_t object_id, uint64_t key);
+    /// Forget the sends noted for object_id (e.g. its SetObjectProperty failed)
+    void ForgetSend(uint32_t object_id);
+
+    Stats GetStats() const;
+
+    /// Longest side the family's screen can show artwork at; 0 = unknown
+    static uint32_t DefaultMaxDimension(DeviceFamily family);
+    /// Width and height from a baseline or progressive JPEG's SOF marker
+    static bool JpegDimensions(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height);
+    /// FNV-1a 64 of the bytes
+    static uint64_t Hash(const uint8_t* data, size_t size);
+
+private:
+    struct Entry {
+        std::shared_ptr<const std::vector<uint8_t>> data;   // Null: send the original
+    };
+
+    // What processing an image needs, copied out under the lock
+    struct Job {
+        Resizer resize;
+        uint32_t max_dimension = 0;
+        std::string cache_path;
+    };
+
+    // Resized image, or null to send the original
+    static std::shared_ptr<const std::vector<uint8_t>> Process(
+        const Job& job, const uint8_t* data, size_t size, bool& disk_hit);
+    // True (result filled) if already prepared; otherwise fills job
+    bool LookupLocked(uint64_t hash, size_t size, Prepared& result, Job& job);
+    void StoreLocked(size_t size, Prepared& result, bool disk_hit);
+    std::string CachePath(uint64_t hash, size_t size) const;
+    static uint64_t Key(uint64_t hash, size_t size);
+
+    mutable std::mutex mutex_;
+    bool enabled_ = false;
+    Options options_;
+    uint32_t max_dimension_ = 0;
+    std::unordered_map<uint64_t, Entry> prepared_;      // Key -> processed image
+    std::unordered_map<uint32_t, uint64_t> sent_;       // Object -> key last sent
+    Stats stats_;
+};
+
+} // namespace zune
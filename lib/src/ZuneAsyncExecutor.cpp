@@ -0,0 +1,121 @@
+#include "ZuneAsyncExecutor.h"
+#include <algorithm>
+#include <exception>
+
+namespace zune {
+
+AsyncExecutor::~AsyncExecutor() {
+    CancelAll();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint64_t AsyncExecutor::Submit(Work work, ProgressFn progress, CompleteFn complete) {
+    auto op = std::make_unique<Operation>();
+    op->work = std::move(work);
+    op->complete = std::move(complete);
+    op->context.progress_ = std::move(progress);
+
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        op->context.id_ = id;
+        queue_.push_back(std::move(op));
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&AsyncExecutor::Run, this);
+        }
+    }
+    work_cv_.notify_one();
+    return id;
+}
+
+bool AsyncExecutor::Cancel(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ && running_->context.id_ == id) {
+        running_->context.cancelled_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    for (auto& op : queue_) {
+        if (op->context.id_ == id) {
+            // Completed as cancelled when the worker reaches it, so every
+            // callback still runs on the worker and in order
+            op->context.cancelled_.store(true, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsyncExecutor::CancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        running_->context.cancelled_.store(true, std::memory_order_relaxed);
+    }
+    for (auto& op : queue_) {
+        op->context.cancelled_.store(true, std::memory_order_relaxed);
+    }
+}
+
+void AsyncExecutor::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (thread_.get_id() == std::this_thread::get_id()) {
+        return;
+    }
+    idle_cv_.wait(lock, [this] { return queue_.empty() && !running_; });
+}
+
+size_t AsyncExecutor::Pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + (running_ ? 1 : 0);
+}
+
+void AsyncExecutor::Finish(Operation& op, Status status, int result) {
+    if (op.complete) {
+        op.complete(op.context.id_, status, result, op.context.data_);
+    }
+}
+
+void AsyncExecutor::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;  // Stopping, and everything queued has completed
+        }
+        std::unique_ptr<Operation> op = std::move(queue_.front());
+        queue_.pop_front();
+        running_ = op.get();
+        lock.unlock();
+
+        if (op->context.Cancelled()) {
+            Finish(*op, Status::Cancelled, -1);
+        } else {
+            Status status = Status::Done;
+            int result = -1;
+            try {
+                result = op->work(op->context);
+                if (op->context.stopped_) status = Status::Cancelled;
+            } catch (const std::exception&) {
+                status = Status::Failed;
+            } catch (...) {
+                status = Status::Failed;
+            }
+            Finish(*op, status, result);
+        }
+
+        lock.lock();
+        running_ = nullptr;
+        if (queue_.empty()) {
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+} // namespace zune
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace zune {
+
+/// Runs a device's long operations (library reads, uploads, downloads,
+/// erase) on a thread the library owns, for the _async C API.
+///
+/// One worker per device, started on the first Submit, runs operations in
+/// submission order. That is enough: MTP runs one transaction at a time,
+/// and the operations still take MtpScheduler grants, so async work is
+/// prioritized against synchronous calls and network polling the same way
+/// as before. Progress and completion callbacks run on the worker.
+///
+/// Cancel() removes a queued operation, which then completes as cancelled
+/// without running. A running operation is told through
+/// Context::Cancelled() and stops where it can; a SendObject that has
+/// started is never cut short, as MTP cannot abandon a data phase.
+class AsyncExecutor {
+public:
+    enum class Status { Done = 0, Cancelled = 1, Failed = 2 };
+
+    class Context {
+    public:
+        bool Cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+        void Progress(uint64_t done, uint64_t total) const {
+            if (progress_) progress_(id_, done, total);
+        }
+        void SetData(void* data) { data_ = data; }
+        /// For work that gave up because of Cancelled(): return context.Stopped()
+        int Stopped() {
+            stopped_ = true;
+            return -1;
+        }
+
+    private:
+        friend class AsyncExecutor;
+        uint64_t id_ = 0;
+        std::atomic<bool> cancelled_{false};
+        std::function<void(uint64_t, uint64_t, uint64_t)> progress_;
+        void* data_ = nullptr;
+        bool stopped_ = false;
+    };
+
+    /// Returns the operation's result code; may set data through the context
+    using Work = std::function<int(Context& context)>;
+    using ProgressFn = std::function<void(uint64_t id, uint64_t done, uint64_t total)>;
+    using CompleteFn = std::function<void(uint64_t id, Status status, int result, void* data)>;
+
+    AsyncExecutor() = default;
+    ~AsyncExecutor();  // Cancels what is queued and waits for the running operation
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+    /// Queue work; returns its id (never 0)
+    uint64_t Submit(Work work, ProgressFn progress, CompleteFn complete);
+
+    /// False if id is unknown or has already completed
+    bool Cancel(uint64_t id);
+    void CancelAll();
+
+    /// Wait until nothing is queued or running. Returns at once on the
+    /// worker (from a callback), where waiting would deadlock.
+    void WaitIdle();
+
+    /// Queued plus running
+    size_t Pending() const;
+
+private:
+    struct Operation {
+        Work work;
+        CompleteFn complete;
+        Context context;
+    };
+
+    void Run();
+    static void Finish(Operation& op, Status status, int result);
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;   // Queued, or stopping
+    std::condition_variable idle_cv_;   // Queue drained and nothing running
+    std::deque<std::unique_ptr<Operation>> queue_;
+    Operation* running_ = nullptr;
+    uint64_t next_id_ = 1;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace zune
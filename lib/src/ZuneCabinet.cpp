@@ -0,0 +1,478 @@
+#include "ZuneCabinet.h"
+#include <algorithm>
+#include <cctype>
+
+namespace zune {
+
+namespace {
+
+constexpr size_t kHeaderSize = 36;
+constexpr uint16_t kFlagPrevCabinet = 0x0001;
+constexpr uint16_t kFlagNextCabinet = 0x0002;
+constexpr uint16_t kFlagReservePresent = 0x0004;
+constexpr uint16_t kCompressNone = 0;
+constexpr uint16_t kCompressMszip = 1;
+constexpr size_t kMszipWindow = 32768;
+
+// CFDATA checksum: XOR of little-endian 32-bit words, with the tail bytes
+// packed high to low
+uint32_t Checksum(const uint8_t* data, size_t size, uint32_t seed) {
+    uint32_t sum = seed;
+    size_t words = size / 4;
+    for (size_t i = 0; i < words; i++, data += 4) {
+        sum ^= static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+               (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+    uint32_t tail = 0;
+    switch (size % 4) {
+    case 3: tail |= static_cast<uint32_t>(*data++) << 16; [[fallthrough]];
+    case 2: tail |= static_cast<uint32_t>(*data++) << 8; [[fallthrough]];
+    case 1: tail |= *data++; break;
+    default: break;
+    }
+    return sum ^ tail;
+}
+
+// Raw deflate (RFC 1951) into out, whose existing bytes are the history
+// back-references may reach into. Canonical Huffman decoding one bit at a
+// time, after zlib's puff.
+class Inflater {
+public:
+    Inflater(const uint8_t* in, size_t size, std::vector<uint8_t>& out, size_t limit)
+        : in_(in), size_(size), out_(out), limit_(limit) {}
+
+    // Up to and including the block marked final
+    bool Run() {
+        bool last = false;
+        while (!last) {
+            last = Bits(1) != 0;
+            int type = Bits(2);
+            if (overrun_) return false;
+            bool ok = false;
+            switch (type) {
+            case 0: ok = Stored(); break;
+            case 1: ok = Fixed(); break;
+            case 2: ok = Dynamic(); break;
+            default: return false;
+            }
+            if (!ok || overrun_) return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int kMaxBits = 15;
+
+    struct Huffman {
+        uint16_t count[kMaxBits + 1];
+        uint16_t symbol[288];
+    };
+
+    int Bits(int need) {
+        uint32_t value = bitbuf_;
+        while (bitcnt_ < need) {
+            if (pos_ == size_) {
+                overrun_ = true;
+                return 0;
+            }
+            value |= static_cast<uint32_t>(in_[pos_++]) << bitcnt_;
+            bitcnt_ += 8;
+        }
+        bitbuf_ = value >> need;
+        bitcnt_ -= need;
+        return static_cast<int>(value & ((1u << need) - 1));
+    }
+
+    bool Stored() {
+        bitbuf_ = 0;
+        bitcnt_ = 0;
+        if (size_ - pos_ < 4) return false;
+        size_t length = in_[pos_] | (in_[pos_ + 1] << 8);
+        size_t check = in_[pos_ + 2] | (in_[pos_ + 3] << 8);
+        pos_ += 4;
+        if (length != (~check & 0xFFFF)) return false;
+        if (size_ - pos_ < length || out_.size() + length > limit_) return false;
+        out_.insert(out_.end(), in_ + pos_, in_ + pos_ + length);
+        pos_ += length;
+        return true;
+    }
+
+    int Decode(const Huffman& h) {
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int length = 1; length <= kMaxBits; length++) {
+            code |= Bits(1);
+            if (overrun_) return -1;
+            int count = h.count[length];
+            if (code - count < first) {
+                return h.symbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    // Returns the codes left unused: 0 for a complete code, > 0 for an
+    // incomplete one, < 0 when oversubscribed
+    static int Build(Huffman& h, const uint8_t* lengths, int n) {
+        std::fill(std::begin(h.count), std::end(h.count), 0);
+        for (int symbol = 0; symbol < n; symbol++) h.count[lengths[symbol]]++;
+        if (h.count[0] == n) return 0;
+
+        int left = 1;
+        for (int length = 1; length <= kMaxBits; length++) {
+            left <<= 1;
+            left -= h.count[length];
+            if (left < 0) return left;
+        }
+
+        uint16_t offsets[kMaxBits + 1];
+        offsets[1] = 0;
+        for (int length = 1; length < kMaxBits; length++) {
+            offsets[length + 1] = static_cast<uint16_t>(offsets[length] + h.count[length]);
+        }
+        for (int symbol = 0; symbol < n; symbol++) {
+            if (lengths[symbol] != 0) h.symbol[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+        }
+        return left;
+    }
+
+    bool Codes(const Huffman& lencode, const Huffman& distcode) {
+        static constexpr uint16_t kLengthBase[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static constexpr uint8_t kLengthExtra[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static constexpr uint16_t kDistanceBase[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static constexpr uint8_t kDistanceExtra[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        while (true) {
+            int symbol = Decode(lencode);
+            if (symbol < 0) return false;
+            if (symbol < 256) {
+                if (out_.size() >= limit_) return false;
+                out_.push_back(static_cast<uint8_t>(symbol));
+                continue;
+            }
+            if (symbol == 256) return true;
+
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            size_t length = kLengthBase[symbol] + Bits(kLengthExtra[symbol]);
+            symbol = Decode(distcode);
+            if (symbol < 0 || symbol >= 30) return false;
+            size_t distance = kDistanceBase[symbol] + Bits(kDistanceExtra[symbol]);
+            if (overrun_ || distance > out_.size() || out_.size() + length > limit_) return false;
+            size_t from = out_.size() - distance;
+            for (size_t i = 0; i < length; i++) {
+                out_.push_back(out_[from + i]);  // May overlap what it writes
+            }
+        }
+    }
+
+    bool Fixed() {
+        static const std::pair<Huffman, Huffman> tables = [] {
+            std::pair<Huffman, Huffman> t;
+            uint8_t lengths[288];
+            int symbol = 0;
+            for (; symbol < 144; symbol++) lengths[symbol] = 8;
+            for (; symbol < 256; symbol++) lengths[symbol] = 9;
+            for (; symbol < 280; symbol++) lengths[symbol] = 7;
+            for (; symbol < 288; symbol++) lengths[symbol] = 8;
+            Build(t.first, lengths, 288);
+            for (symbol = 0; symbol < 30; symbol++) lengths[symbol] = 5;
+            Build(t.second, lengths, 30);
+            return t;
+        }();
+        return Codes(tables.first, tables.second);
+    }
+
+    bool Dynamic() {
+        static constexpr uint8_t kOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        int nlen = Bits(5) + 257;
+        int ndist = Bits(5) + 1;
+        int ncode = Bits(4) + 4;
+        if (overrun_ || nlen > 286 || ndist > 30) return false;
+
+        uint8_t lengths[320] = {};
+        for (int index = 0; index < ncode; index++) {
+            lengths[kOrder[index]] = static_cast<uint8_t>(Bits(3));
+        }
+        Huffman lencode;
+        Huffman distcode;
+        if (Build(lencode, lengths, 19) != 0) return false;
+
+        int index = 0;
+        while (index < nlen + ndist) {
+            int symbol = Decode(lencode);
+            if (symbol < 0) return false;
+            if (symbol < 16) {
+                lengths[index++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            uint8_t length = 0;
+            int repeat;
+            if (symbol == 16) {
+                if (index == 0) return false;
+                length = lengths[index - 1];
+                repeat = 3 + Bits(2);
+            } else if (symbol == 17) {
+                repeat = 3 + Bits(3);
+            } else {
+                repeat = 11 + Bits(7);
+            }
+            if (overrun_ || index + repeat > nlen + ndist) return false;
+            while (repeat--) lengths[index++] = length;
+        }
+        if (lengths[256] == 0) return false;
+
+        // Incomplete codes are only allowed for a single length
+        int left = Build(lencode, lengths, nlen);
+        if (left < 0 || (left > 0 && nlen != lencode.count[0] + lencode.count[1])) return false;
+        left = Build(distcode, lengths + nlen, ndist);
+        if (left < 0 || (left > 0 && ndist != distcode.count[0] + distcode.count[1])) return false;
+        return Codes(lencode, distcode);
+    }
+
+    const uint8_t* in_;
+    size_t size_;
+    size_t pos_ = 0;
+    uint32_t bitbuf_ = 0;
+    int bitcnt_ = 0;
+    bool overrun_ = false;
+    std::vector<uint8_t>& out_;
+    size_t limit_;
+};
+
+} // namespace
+
+bool Cabinet::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool Cabinet::Open(std::vector<uint8_t> data) {
+    data_ = std::move(data);
+    folders_.clear();
+    files_.clear();
+    data_reserve_ = 0;
+    cursor_ = Cursor();
+    error_.clear();
+
+    auto has = [&](size_t at, size_t n) { return at <= data_.size() && data_.size() - at >= n; };
+    auto le16 = [&](size_t at) { return static_cast<uint16_t>(data_[at] | (data_[at + 1] << 8)); };
+    auto le32 = [&](size_t at) {
+        return static_cast<uint32_t>(data_[at]) | (static_cast<uint32_t>(data_[at + 1]) << 8) |
+               (static_cast<uint32_t>(data_[at + 2]) << 16) | (static_cast<uint32_t>(data_[at + 3]) << 24);
+    };
+
+    if (!has(0, kHeaderSize) || data_[0] != 'M' || data_[1] != 'S' || data_[2] != 'C' || data_[3] != 'F') {
+        return Fail("not a cabinet");
+    }
+    uint32_t files_offset = le32(16);
+    uint16_t folder_count = le16(26);
+    uint16_t file_count = le16(28);
+    uint16_t flags = le16(30);
+    if (flags & (kFlagPrevCabinet | kFlagNextCabinet)) {
+        return Fail("cabinet sets are not supported");
+    }
+
+    size_t pos = kHeaderSize;
+    size_t folder_reserve = 0;
+    if (flags & kFlagReservePresent) {
+        if (!has(pos, 4)) return Fail("truncated header");
+        size_t header_reserve = le16(pos);
+        folder_reserve = data_[pos + 2];
+        data_reserve_ = data_[pos + 3];
+        pos += 4 + header_reserve;
+    }
+
+    for (uint16_t i = 0; i < folder_count; i++) {
+        if (!has(pos, 8 + folder_reserve)) return Fail("truncated folder table");
+        Folder folder;
+        folder.data_offset = le32(pos);
+        folder.blocks = le16(pos + 4);
+        folder.compression = le16(pos + 6) & 0x000F;
+        if (folder.compression != kCompressNone && folder.compression != kCompressMszip) {
+            return Fail("only stored and MSZIP folders are supported");
+        }
+        folders_.push_back(folder);
+        pos += 8 + folder_reserve;
+    }
+
+    pos = files_offset;
+    for (uint16_t i = 0; i < file_count; i++) {
+        if (!has(pos, 16)) return Fail("truncated file table");
+        File file;
+        file.size = le32(pos);
+        file.offset = le32(pos + 4);
+        file.folder = le16(pos + 8);
+        if (file.folder >= folders_.size()) {
+            return Fail("files continued across cabinets are not supported");
+        }
+        size_t name = pos + 16;
+        size_t end = name;
+        while (end < data_.size() && data_[end] != 0) end++;
+        if (end == data_.size()) return Fail("truncated file table");
+        file.name.assign(reinterpret_cast<const char*>(data_.data() + name), end - name);
+        files_.push_back(std::move(file));
+        pos = end + 1;
+    }
+    return true;
+}
+
+int Cabinet::Find(const std::string& name) const {
+    auto lower = [](std::string s) {
+        for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return s;
+    };
+    std::string wanted = lower(name);
+    for (size_t i = 0; i < files_.size(); i++) {
+        if (lower(files_[i].name) == wanted) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void Cabinet::Rewind(int folder) {
+    cursor_ = Cursor();
+    cursor_.folder = folder;
+    cursor_.next_offset = folders_[static_cast<size_t>(folder)].data_offset;
+}
+
+bool Cabinet::DecodeBlock() {
+    const Folder& folder = folders_[static_cast<size_t>(cursor_.folder)];
+    if (cursor_.next_block >= folder.blocks) return Fail("file runs past the end of its folder");
+
+    size_t at = cursor_.next_offset;
+    if (at > data_.size() || data_.size() - at < 8 + data_reserve_) return Fail("truncated data block");
+    const uint8_t* header = data_.data() + at;
+    uint32_t sum = static_cast<uint32_t>(header[0]) | (static_cast<uint32_t>(header[1]) << 8) |
+                   (static_cast<uint32_t>(header[2]) << 16) | (static_cast<uint32_t>(header[3]) << 24);
+    size_t packed = header[4] | (header[5] << 8);
+    size_t unpacked = header[6] | (header[7] << 8);
+    size_t payload = at + 8 + data_reserve_;
+    if (data_.size() - payload < packed) return Fail("truncated data block");
+    const uint8_t* in = data_.data() + payload;
+    if (sum != 0 && Checksum(header + 4, 4, Checksum(in, packed, 0)) != sum) {
+        return Fail("data block checksum mismatch");
+    }
+
+    cursor_.block_start += cursor_.block.size();
+    if (folder.compression == kCompressNone) {
+        if (packed != unpacked) return Fail("stored block sizes differ");
+        cursor_.block.assign(in, in + packed);
+    } else {
+        if (packed < 2 || in[0] != 'C' || in[1] != 'K') return Fail("missing MSZIP signature");
+        std::vector<uint8_t> out = std::move(cursor_.window);
+        size_t base = out.size();
+        out.reserve(base + unpacked);
+        Inflater inflater(in + 2, packed - 2, out, base + unpacked);
+        if (!inflater.Run() || out.size() - base != unpacked) return Fail("corrupt MSZIP block");
+        cursor_.block.assign(out.begin() + static_cast<std::ptrdiff_t>(base), out.end());
+        if (out.size() > kMszipWindow) {
+            out.erase(out.begin(), out.end() - static_cast<std::ptrdiff_t>(kMszipWindow));
+        }
+        cursor_.window = std::move(out);
+    }
+    cursor_.next_block++;
+    cursor_.next_offset = payload + packed;
+    return true;
+}
+
+bool Cabinet::Read(size_t index, std::vector<uint8_t>& out) {
+    out.clear();
+    if (index >= files_.size()) return Fail("no such file");
+    const File& file = files_[index];
+    if (cursor_.folder != file.folder || file.offset < cursor_.block_start) {
+        Rewind(file.folder);
+    }
+
+    out.reserve(file.size);
+    uint64_t position = file.offset;
+    uint64_t end = position + file.size;
+    while (position < end) {
+        uint64_t block_end = cursor_.block_start + cursor_.block.size();
+        if (position >= block_end) {
+            if (!DecodeBlock()) {
+                out.clear();
+                return false;
+            }
+            continue;
+        }
+        auto from = cursor_.block.begin() + static_cast<std::ptrdiff_t>(position - cursor_.block_start);
+        uint64_t take = std::min(block_end, end) - position;
+        out.insert(out.end(), from, from + static_cast<std::ptrdiff_t>(take));
+        position += take;
+    }
+    return true;
+}
+
+CabinetPrefetcher::CabinetPrefetcher(Cabinet& cabinet, std::vector<size_t> order, size_t max_buffered_bytes)
+    : cabinet_(cabinet), order_(std::move(order)), max_buffered_bytes_(max_buffered_bytes) {
+    thread_ = std::thread(&CabinetPrefetcher::Run, this);
+}
+
+CabinetPrefetcher::~CabinetPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    space_cv_.notify_all();
+    thread_.join();
+}
+
+void CabinetPrefetcher::Run() {
+    for (size_t index : order_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_cv_.wait(lock, [this] {
+                return stop_ || queue_.empty() || buffered_bytes_ < max_buffered_bytes_;
+            });
+            if (stop_) break;
+        }
+
+        Entry entry;
+        entry.index = index;
+        bool ok = cabinet_.Read(index, entry.data);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ok) {
+            failed_ = true;
+            break;
+        }
+        buffered_bytes_ += entry.data.size();
+        queue_.push_back(std::move(entry));
+        ready_cv_.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    ready_cv_.notify_all();
+}
+
+bool CabinetPrefetcher::Next(Entry& entry) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_cv_.wait(lock, [this] { return !queue_.empty() || finished_; });
+    if (queue_.empty()) return false;
+    entry = std::move(queue_.front());
+    queue_.pop_front();
+    buffered_bytes_ -= entry.data.size();
+    space_cv_.notify_one();
+    return true;
+}
+
+bool CabinetPrefetcher::failed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+} // namespace zune
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zune {
+
+/// Reads Microsoft cabinet files (.cab, and the .ccgame packages XNA Game
+/// Studio builds) from memory, for folders that are stored or MSZIP
+/// compressed. Quantum and LZX folders, and cabinets split across a set,
+/// are rejected by Open().
+///
+/// MSZIP is deflate in blocks of up to 32 KB, each prefixed "CK", that
+/// share the 32 KB window of the blocks before them; the inflater here is
+/// self-contained. CFDATA checksums are verified when present.
+///
+/// Read() keeps its place in the folder it last decoded, so reading files
+/// in cabinet order decompresses every folder once. Not thread-safe.
+class Cabinet {
+public:
+    struct File {
+        std::string name;
+        uint32_t size = 0;
+        uint16_t folder = 0;
+        uint32_t offset = 0;    // Within the folder's uncompressed data
+    };
+
+    /// False, with error(), for anything that is not a single cabinet with
+    /// stored or MSZIP folders
+    bool Open(std::vector<uint8_t> data);
+
+    const std::vector<File>& files() const { return files_; }
+    const std::string& error() const { return error_; }
+
+    /// Index of the file called name (ASCII case-insensitive), -1 if none
+    int Find(const std::string& name) const;
+
+    /// Decompress files()[index] into out
+    bool Read(size_t index, std::vector<uint8_t>& out);
+
+private:
+    struct Folder {
+        uint32_t data_offset = 0;   // First CFDATA
+        uint16_t blocks = 0;
+        uint16_t compression = 0;
+    };
+
+    // Where Read() is in the folder it last decoded
+    struct Cursor {
+        int folder = -1;
+        uint16_t next_block = 0;
+        size_t next_offset = 0;         // Of the next CFDATA in data_
+        uint64_t block_start = 0;       // Uncompressed offset of block[0]
+        std::vector<uint8_t> block;     // Latest decoded block
+        std::vector<uint8_t> window;    // MSZIP history, up to 32 KB
+    };
+
+    bool Fail(const std::string& message);
+    void Rewind(int folder);
+    bool DecodeBlock();
+
+    std::vector<uint8_t> data_;
+    std::vector<Folder> folders_;
+    std::vector<File> files_;
+    size_t data_reserve_ = 0;   // Per-CFDATA reserved bytes
+    Cursor cursor_;
+    std::string error_;
+};
+
+/// Decompresses cabinet files on a thread of its own, ahead of the caller,
+/// so unpacking later files overlaps with whatever is done with earlier
+/// ones (sending them to the device). At most max_buffered_bytes of
+/// decoded files wait at a time, though a single larger file always fits.
+/// The cabinet belongs to the prefetcher until it is destroyed.
+class CabinetPrefetcher {
+public:
+    struct Entry {
+        size_t index = 0;
+        std::vector<uint8_t> data;
+    };
+
+    CabinetPrefetcher(Cabinet& cabinet, std::vector<size_t> order, size_t max_buffered_bytes);
+    ~CabinetPrefetcher();   // Stops decoding and waits for the thread
+    CabinetPrefetcher(const CabinetPrefetcher&) = delete;
+    CabinetPrefetcher& operator=(const CabinetPrefetcher&) = delete;
+
+    /// Next file in order. False once every file has been taken, or when a
+    /// file failed to decode (failed() tells which).
+    bool Next(Entry& entry);
+    bool failed() const;
+
+private:
+    void Run();
+
+    Cabinet& cabinet_;
+    std::vector<size_t> order_;
+    size_t max_buffered_bytes_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_cv_;  // Entry queued, or decoding finished
+    std::condition_variable space_cv_;  // Room in the buffer, or stopping
+    std::deque<Entry> queue_;
+    size_t buffered_bytes_ = 0;
+    bool finished_ = false;
+    bool failed_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace zune
@@ -0,0 +1,160 @@
+#include "ZuneContentIndex.h"
+#include "ZuneFileStore.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace zune {
+
+static constexpr char kIndexMagic[4] = {'X', 'Z', 'C', 'I'};
+static constexpr uint32_t kIndexVersion = 1;
+
+ContentFingerprint ContentFingerprint::FromData(const uint8_t* data, size_t size) {
+    ContentFingerprint f;
+    f.size = size;
+    size_t block = std::min(size, kBlockSize);
+    f.head = Fnv1a64(data, block);
+    f.tail = Fnv1a64(data + (size - block), block);
+    return f;
+}
+
+bool ContentFingerprint::FromFile(const std::string& path, ContentFingerprint& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamoff end = file.tellg();
+    if (end < 0) return false;
+    uint64_t size = static_cast<uint64_t>(end);
+    size_t block = static_cast<size_t>(std::min<uint64_t>(size, kBlockSize));
+
+    std::vector<uint8_t> buffer(block);
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(block))) return false;
+    out.size = size;
+    out.head = Fnv1a64(buffer.data(), block);
+
+    file.seekg(static_cast<std::streamoff>(size - block));
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(block))) return false;
+    out.tail = Fnv1a64(buffer.data(), block);
+    return true;
+}
+
+std::string ContentIndex::FileName(const std::string& serial) {
+    return SerialFileName(serial, ".xzcontent");
+}
+
+// A missing, truncated or foreign file leaves the index empty
+void ContentIndex::Open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!path_.empty()) SaveLocked();
+    entries_.clear();
+    dirty_ = false;
+    path_ = path;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    BinaryReader r{data};
+    const uint8_t* magic = r.Take(sizeof(kIndexMagic));
+    if (!magic || std::memcmp(magic, kIndexMagic, sizeof(kIndexMagic)) != 0) return;
+    if (r.Get(4) != kIndexVersion) return;
+    uint32_t count = static_cast<uint32_t>(r.Get(4));
+    std::unordered_map<ContentFingerprint, uint32_t, ContentFingerprintHash> entries;
+    entries.reserve(std::min<size_t>(count, data.size() / 28));
+    for (uint32_t i = 0; i < count && r.ok; i++) {
+        ContentFingerprint f;
+        f.size = r.Get(8);
+        f.head = r.Get(8);
+        f.tail = r.Get(8);
+        entries[f] = static_cast<uint32_t>(r.Get(4));
+    }
+    if (!r.ok) return;
+    entries_ = std::move(entries);
+}
+
+void ContentIndex::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!path_.empty()) SaveLocked();
+    path_.clear();
+    entries_.clear();
+    pending_object_ = 0;
+}
+
+bool ContentIndex::IsOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !path_.empty();
+}
+
+bool ContentIndex::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SaveLocked();
+}
+
+void ContentIndex::Record(const ContentFingerprint& fingerprint, uint32_t object_id) {
+    if (object_id == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[fingerprint] = object_id;
+    dirty_ = true;
+}
+
+uint32_t ContentIndex::Find(const ContentFingerprint& fingerprint) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(fingerprint);
+    return it != entries_.end() ? it->second : 0;
+}
+
+void ContentIndex::Remove(uint32_t object_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second == object_id) {
+            it = entries_.erase(it);
+            dirty_ = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t ContentIndex::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void ContentIndex::SetPendingObject(uint32_t object_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_object_ = object_id;
+}
+
+uint32_t ContentIndex::PendingObject() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_object_;
+}
+
+bool ContentIndex::SaveLocked() {
+    if (!dirty_ || path_.empty()) return true;
+
+    std::vector<uint8_t> out;
+    out.reserve(12 + entries_.size() * 28);
+    out.insert(out.end(), kIndexMagic, kIndexMagic + sizeof(kIndexMagic));
+    Put32(out, kIndexVersion);
+    Put32(out, static_cast<uint32_t>(entries_.size()));
+    for (const auto& [f, object_id] : entries_) {
+        Put64(out, f.size);
+        Put64(out, f.head);
+        Put64(out, f.tail);
+        Put32(out, object_id);
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path_).parent_path(), ec);
+
+    if (!WriteFileAtomic(path_, out)) return false;
+    dirty_ = false;
+    return true;
+}
+
+} // namespace zune
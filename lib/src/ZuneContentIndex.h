@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace zune {
+
+/// Cheap identity of a file's content: its size and hashes of its first and
+/// last kBlockSize bytes. Two copies of a track match no matter what they
+/// are called or how their tags are spelled, which is what a library
+/// restored from backup needs.
+struct ContentFingerprint {
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    uint64_t size = 0;
+    uint64_t head = 0;      // FNV-1a 64 of the first block
+    uint64_t tail = 0;      // FNV-1a 64 of the last block (the head again if shorter)
+
+    bool operator==(const ContentFingerprint& o) const {
+        return size == o.size && head == o.head && tail == o.tail;
+    }
+
+    /// Fingerprint of a host file; false if it cannot be read
+    static bool FromFile(const std::string& path, ContentFingerprint& out);
+    /// Fingerprint of a file already in memory
+    static ContentFingerprint FromData(const uint8_t* data, size_t size);
+};
+
+struct ContentFingerprintHash {
+    size_t operator()(const ContentFingerprint& f) const {
+        return static_cast<size_t>(f.head ^ (f.tail * 0x9E3779B97F4A7C15ull) ^ f.size);
+    }
+};
+
+/// Host record of the fingerprint of every track uploaded to one device,
+/// next to the object handle it got (a track's ZMDB atom_id is its MTP
+/// object handle). The sync planner asks it about tracks it would
+/// otherwise add, so a re-sync of renamed or re-tagged files finds the
+/// copies the device already has.
+///
+/// File layout (little-endian): "XZCI" magic, u32 format version, u32 entry
+/// count, then entries of u64 size, u64 head hash, u64 tail hash, u32
+/// object handle. Written with temp file + rename.
+class ContentIndex {
+public:
+    /// Bind to path, loading it when it exists. Saves any previous binding.
+    void Open(const std::string& path);
+    /// Save pending entries and unbind
+    void Close();
+    bool IsOpen() const;
+    bool Save();
+
+    void Record(const ContentFingerprint& fingerprint, uint32_t object_id);
+    /// Object uploaded with this fingerprint, 0 if none
+    uint32_t Find(const ContentFingerprint& fingerprint) const;
+    /// Drop the entries of a deleted object
+    void Remove(uint32_t object_id);
+    size_t Size() const;
+
+    /// Object whose data the next bare SendObject carries (zune_upload_create_track)
+    void SetPendingObject(uint32_t object_id);
+    uint32_t PendingObject() const;
+
+    /// File name of the index for a device serial
+    static std::string FileName(const std::string& serial);
+
+private:
+    bool SaveLocked();
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    std::unordered_map<ContentFingerprint, uint32_t, ContentFingerprintHash> entries_;
+    bool dirty_ = false;
+    uint32_t pending_object_ = 0;
+};
+
+} // namespace zune
@@ -0,0 +1,142 @@
+#include "ZuneDeletePlan.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace zune {
+
+namespace {
+
+constexpr uint16_t kFolderFormat = 0x3001;
+
+// Files, then the abstract objects referencing them, then folders
+int Rank(uint16_t format) {
+    if (format == kFolderFormat) return 2;
+    if ((format & 0xFF00) == 0xBA00) return 1;
+    return 0;
+}
+
+} // namespace
+
+DeletePlan DeletePlan::Build(const std::vector<uint32_t>& handles,
+                             const std::unordered_map<uint32_t, uint16_t>& formats,
+                             const std::unordered_map<uint32_t, uint32_t>& parents,
+                             bool collapse_folders) {
+    DeletePlan plan;
+
+    struct Entry {
+        uint32_t handle;
+        int rank;
+        uint32_t depth;   // Folders: levels below the root
+        size_t position;  // In the caller's order
+    };
+    std::vector<Entry> entries;
+    std::unordered_set<uint32_t> in_set;
+    for (uint32_t handle : handles) {
+        if (!in_set.insert(handle).second) {
+            continue;  // Listed twice
+        }
+        auto format = formats.find(handle);
+        if (format == formats.end()) {
+            plan.missing.push_back(handle);
+            continue;
+        }
+        Entry entry{handle, Rank(format->second), 0, entries.size()};
+        if (entry.rank == 2) {
+            // Bounded walk: a malformed list must not loop forever
+            auto parent = parents.find(handle);
+            while (parent != parents.end() && parent->second != 0 && entry.depth < parents.size()) {
+                entry.depth++;
+                parent = parents.find(parent->second);
+            }
+        }
+        entries.push_back(entry);
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.rank != b.rank) return a.rank < b.rank;
+        if (a.rank == 2 && a.depth != b.depth) return a.depth > b.depth;
+        return a.position < b.position;
+    });
+
+    // Folders whose every object is being deleted, and the folder each
+    // collapsed object goes with
+    std::unordered_map<uint32_t, uint32_t> collapsed_into;
+    if (collapse_folders) {
+        std::unordered_map<uint32_t, std::vector<uint32_t>> children;
+        for (const Entry& entry : entries) {
+            if (entry.rank == 2) {
+                children[entry.handle];
+            }
+        }
+        for (const auto& [handle, parent] : parents) {
+            auto folder = children.find(parent);
+            if (folder != children.end() && formats.count(handle)) {
+                folder->second.push_back(handle);
+            }
+        }
+
+        // Deepest folders come first, so a nested folder is decided before
+        // the folder holding it
+        std::unordered_set<uint32_t> whole;
+        for (const Entry& entry : entries) {
+            if (entry.rank != 2) {
+                continue;
+            }
+            const auto& contents = children[entry.handle];
+            bool all = std::all_of(contents.begin(), contents.end(), [&](uint32_t child) {
+                return in_set.count(child) && (children.count(child) == 0 || whole.count(child));
+            });
+            if (all) {
+                whole.insert(entry.handle);
+            }
+        }
+
+        // Each object goes with its outermost whole folder
+        for (const Entry& entry : entries) {
+            uint32_t outermost = 0;
+            auto parent = parents.find(entry.handle);
+            for (size_t steps = 0; parent != parents.end() && parent->second != 0 && steps < parents.size();
+                 steps++) {
+                if (whole.count(parent->second)) {
+                    outermost = parent->second;
+                }
+                parent = parents.find(parent->second);
+            }
+            if (outermost != 0) {
+                collapsed_into[entry.handle] = outermost;
+            }
+        }
+    }
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> covered;
+    for (const Entry& entry : entries) {
+        auto into = collapsed_into.find(entry.handle);
+        if (into != collapsed_into.end()) {
+            covered[into->second].push_back(entry.handle);
+        }
+    }
+    for (const Entry& entry : entries) {
+        if (collapsed_into.count(entry.handle)) {
+            continue;
+        }
+        Step step;
+        step.handle = entry.handle;
+        auto contents = covered.find(entry.handle);
+        if (contents != covered.end()) {
+            step.covered = std::move(contents->second);
+        }
+        plan.steps.push_back(std::move(step));
+    }
+    return plan;
+}
+
+size_t DeletePlan::ObjectCount() const {
+    size_t count = 0;
+    for (const Step& step : steps) {
+        count += 1 + step.covered.size();
+    }
+    return count;
+}
+
+} // namespace zune
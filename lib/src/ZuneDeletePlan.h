@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+/// Order for deleting a set of objects in one pass.
+///
+/// Removing an artist deletes tracks, artwork, .alb objects and folders,
+/// and the device refuses some orders of those (a folder that still holds
+/// objects) or does extra work for others (an album whose tracks are still
+/// present). A plan deletes files first, then the abstract objects that
+/// reference them (albums, playlists, podcast series: formats 0xBA00 -
+/// 0xBAFF), then folders, deepest first; within each group the caller's
+/// order is kept.
+///
+/// With collapse_folders, a folder whose every object on the device is in
+/// the set (nested folders included) is deleted alone, its contents going
+/// with it as MTP deletes an association's objects. Its step lists those
+/// contents, in plan order, so they can be deleted one by one if the device
+/// refuses the folder.
+///
+/// formats and parents hold ObjectFormat and ParentObject for every object
+/// on the device (MtpReader::GetObjectFormats / GetObjectParents). Handles
+/// not in formats are already gone and listed as missing.
+struct DeletePlan {
+    struct Step {
+        uint32_t handle = 0;
+        std::vector<uint32_t> covered;  // Deleted with handle (a collapsed folder's contents)
+    };
+
+    std::vector<Step> steps;
+    std::vector<uint32_t> missing;
+
+    static DeletePlan Build(const std::vector<uint32_t>& handles,
+                            const std::unordered_map<uint32_t, uint16_t>& formats,
+                            const std::unordered_map<uint32_t, uint32_t>& parents,
+                            bool collapse_folders);
+
+    /// Objects the plan deletes, covered ones included
+    size_t ObjectCount() const;
+};
+
+} // namespace zune
@@ -0,0 +1,156 @@
+#include "ZuneDescriptorCache.h"
+#include "ZuneFileStore.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace zune {
+
+static constexpr char kCacheMagic[4] = {'X', 'Z', 'D', 'C'};
+static constexpr uint32_t kCacheVersion = 1;
+
+std::string DescriptorCache::FileName(DeviceFamily family, const std::string& firmware) {
+    std::string name = std::to_string(static_cast<unsigned>(family)) + "-" + firmware;
+    // Firmware versions look like "4.5 (Build 407)"; keep the filename safe regardless
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '.')
+            c = '_';
+    }
+    return name + ".xzdesc";
+}
+
+void DescriptorCache::Open(const std::string& directory, DeviceFamily family, const std::string& firmware) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!path_.empty()) SaveLocked();
+
+    known_.clear();
+    recorded_queries_ = 0;
+    recorded_us_ = 0;
+    dirty_ = false;
+    stats_ = Stats{};
+    family_ = family;
+    firmware_ = firmware;
+    path_ = (std::filesystem::path(directory) / FileName(family, firmware)).string();
+    LoadLocked();
+}
+
+void DescriptorCache::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!path_.empty()) SaveLocked();
+    path_.clear();
+    known_.clear();
+}
+
+bool DescriptorCache::IsOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !path_.empty();
+}
+
+bool DescriptorCache::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SaveLocked();
+}
+
+void DescriptorCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    known_.clear();
+    recorded_queries_ = 0;
+    recorded_us_ = 0;
+    dirty_ = false;
+    if (!path_.empty()) std::remove(path_.c_str());
+}
+
+void DescriptorCache::SetSkipCached(bool skip) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    skip_ = skip;
+}
+
+bool DescriptorCache::ShouldSkip(uint16_t prop, uint16_t format) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!skip_ || path_.empty() || known_.count(Key(prop, format)) == 0)
+        return false;
+    stats_.queries_skipped++;
+    if (recorded_queries_ > 0)
+        stats_.saved_us += recorded_us_ / recorded_queries_;
+    return true;
+}
+
+void DescriptorCache::Record(uint16_t prop, uint16_t format, uint64_t duration_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.queries_issued++;
+    stats_.query_us += duration_us;
+    if (path_.empty()) return;
+    known_.insert(Key(prop, format));
+    recorded_queries_++;
+    recorded_us_ += duration_us;
+    dirty_ = true;
+}
+
+DescriptorCache::Stats DescriptorCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void DescriptorCache::ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = Stats{};
+}
+
+bool DescriptorCache::SaveLocked() {
+    if (!dirty_ || path_.empty()) return true;
+
+    std::vector<uint32_t> keys(known_.begin(), known_.end());
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<uint8_t> out;
+    out.insert(out.end(), kCacheMagic, kCacheMagic + sizeof(kCacheMagic));
+    Put32(out, kCacheVersion);
+    Put32(out, static_cast<uint32_t>(family_));
+    Put32(out, static_cast<uint32_t>(firmware_.size()));
+    out.insert(out.end(), firmware_.begin(), firmware_.end());
+    Put64(out, recorded_queries_);
+    Put64(out, recorded_us_);
+    Put32(out, static_cast<uint32_t>(keys.size()));
+    for (uint32_t key : keys) Put32(out, key);
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path_).parent_path(), ec);
+
+    if (!WriteFileAtomic(path_, out)) return false;
+    dirty_ = false;
+    return true;
+}
+
+// A missing, truncated or foreign file leaves the cache empty
+void DescriptorCache::LoadLocked() {
+    std::ifstream file(path_, std::ios::binary);
+    if (!file) return;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    BinaryReader r{data};
+    const uint8_t* magic = r.Take(sizeof(kCacheMagic));
+    if (!magic || std::memcmp(magic, kCacheMagic, sizeof(kCacheMagic)) != 0) return;
+    if (r.Get(4) != kCacheVersion) return;
+    if (r.Get(4) != static_cast<uint32_t>(family_)) return;
+    size_t firmware_size = static_cast<size_t>(r.Get(4));
+    const uint8_t* firmware = r.Take(firmware_size);
+    if (!firmware || std::string(reinterpret_cast<const char*>(firmware), firmware_size) != firmware_) return;
+
+    uint64_t queries = r.Get(8);
+    uint64_t total_us = r.Get(8);
+    uint32_t count = static_cast<uint32_t>(r.Get(4));
+    std::unordered_set<uint32_t> keys;
+    for (uint32_t i = 0; i < count && r.ok; i++) keys.insert(static_cast<uint32_t>(r.Get(4)));
+    if (!r.ok) return;
+
+    known_ = std::move(keys);
+    recorded_queries_ = queries;
+    recorded_us_ = total_us;
+}
+
+} // namespace zune
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ZuneDeviceIdentification.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace zune {
+
+/// Host-side record of the property descriptor queries a device has
+/// answered, keyed by device family and firmware version.
+///
+/// Uploads replay Zune Desktop's GetObjectPropDesc / GetObjectPropsSupported
+/// sequence. The answers never change for a given firmware, and the host
+/// never uses them, so once a firmware has answered a query it can be left
+/// out of later sessions. With skipping enabled, MtpWriter's Query*
+/// helpers ask ShouldSkip() before each round trip and Record() after it.
+///
+/// Skipping is off by default: whether a device accepts SendObjectPropList
+/// without the matching descriptor reads is firmware behaviour, not
+/// something the protocol guarantees. Clear() returns to full queries.
+///
+/// File layout (little-endian): "XZDC" magic, u32 format version,
+/// u32 device family, u32 firmware length + bytes, u64 queries recorded,
+/// u64 total query time in us, u32 entry count, then u32 entries
+/// (property code << 16 | format code; property 0 = GetObjectPropsSupported).
+class DescriptorCache {
+public:
+    struct Stats {
+        uint64_t queries_issued = 0;    // Round trips made this session
+        uint64_t queries_skipped = 0;   // Round trips left out this session
+        uint64_t query_us = 0;          // Time spent in the issued queries
+        uint64_t saved_us = 0;          // Skipped x mean recorded latency
+    };
+
+    /// Bind to one device, loading <directory>/<family>-<firmware>.xzdesc
+    /// when it exists. Saves and replaces any previous binding.
+    void Open(const std::string& directory, DeviceFamily family, const std::string& firmware);
+    /// Save pending entries and unbind
+    void Close();
+    bool IsOpen() const;
+
+    /// Write pending entries (temp file + rename). No-op when nothing changed.
+    bool Save();
+    /// Forget every entry for the bound firmware and delete its file
+    void Clear();
+
+    void SetSkipCached(bool skip);
+
+    /// True if the query is known for this firmware and skipping is on;
+    /// a true result counts as a skipped round trip
+    bool ShouldSkip(uint16_t prop, uint16_t format);
+    /// Note an issued query and how long it took
+    void Record(uint16_t prop, uint16_t format, uint64_t duration_us);
+
+    Stats GetStats() const;
+    void ResetStats();
+
+    /// File name of the cache for a family / firmware pair
+    static std::string FileName(DeviceFamily family, const std::string& firmware);
+
+private:
+    static uint32_t Key(uint16_t prop, uint16_t format) {
+        return (static_cast<uint32_t>(prop) << 16) | format;
+    }
+    bool SaveLocked();
+    void LoadLocked();
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    DeviceFamily family_ = DeviceFamily::Unknown;
+    std::string firmware_;
+    std::unordered_set<uint32_t> known_;
+    uint64_t recorded_queries_ = 0;     // Persisted, for the mean latency
+    uint64_t recorded_us_ = 0;
+    bool skip_ = false;
+    bool dirty_ = false;
+    Stats stats_;
+};
+
+} // namespace zune
@@ -14,17 +14,26 @@
 #include <chrono>
 #include <cstring>
 #include <cctype>
+#include <filesystem>
 #include <regex>
 #include <random>
 #include <mtp/ptp/ObjectPropertyListParser.h>
 #include <cli/PosixStreams.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <sys/stat.h>
 #include "NetworkManager.h"
 #include "ZuneMtpReader.h"
 #include "ZuneMtpWriter.h"
+#include "ZuneDeletePlan.h"
+#include "ZuneFileStore.h"
+#include "ZunePackedLibrary.h"
+#include "ZuneTrace.h"
+#include "zmdb/ZMDBUtils.h"
 #include <mtp/mtpz/TrustedApp.h>
 
+#define DEVICE_LOG(category, level, message) ZUNE_LOG(&logger_, nullptr, category, level, message)
+
 
 
 using namespace mtp;
@@ -110,64 +119,123 @@ public:
 };
 
 ZuneDevice::ZuneDevice()
-    : guid_file_(".mac-zune-guid"), device_guid_file_(".device-zune-guid") {
+    : guid_file_(".mac-zune-guid"), device_guid_file_(".device-zune-guid"),
+      playlist_stage_(
+          [this](const zune::PlaylistStage::NewPlaylist& playlist) {
+              return CreatePlaylist(playlist.name, playlist.guid, playlist.tracks, playlist.folder_id);
+          },
+          [this](uint32_t playlist_id, const std::vector<uint32_t>& tracks) {
+              return UpdatePlaylistTracks(playlist_id, tracks);
+          }) {
 }
 
 ZuneDevice::~ZuneDevice() {
     Disconnect();
 }
 
-bool ZuneDevice::ConnectUSB() {
+bool ZuneDevice::ConnectUSB(const std::string& serial) {
+    ZUNE_TRACE_SPAN("connect", "ConnectUSB");
     try {
-        Log("Connecting to Zune device via USB...");
-        usb_context_ = std::make_shared<usb::Context>();
+        DEVICE_LOG(MTP, INFO, serial.empty() ? std::string("Connecting to Zune device via USB...")
+                                             : "Connecting to Zune " + serial + " via USB...");
+        zune::Tracer::Span enumerate("connect", "usb.enumerate");
+        auto context = std::make_shared<usb::Context>();
 
         // Find Zune device and store descriptor for later product ID lookup
-        auto devices = usb_context_->GetDevices();
+        auto devices = context->GetDevices();
+        enumerate.End();
         for (auto desc : devices) {
-            if (desc->GetVendorId() == 0x045E) {  // Microsoft vendor ID
-                try {
-                    device_ = Device::Open(usb_context_, desc, true, false);
-                    if (device_) {
-                        usb_descriptor_ = desc;
-                        break;
-                    }
-                } catch (const std::exception& e) {
-                    Log("Failed to open device: " + std::string(e.what()));
-                }
+            if (desc->GetVendorId() == 0x045E && OpenUSBDevice(context, desc, serial)) {  // Microsoft vendor ID
+                break;
             }
         }
 
         if (!device_) {
-            Log("Error: No MTP device found on USB");
+            DEVICE_LOG(MTP, ERROR, serial.empty() ? std::string("Error: No MTP device found on USB")
+                                                  : "Error: Zune " + serial + " not found on USB");
             return false;
         }
-        Log("  [OK] Device found");
+        DEVICE_LOG(MTP, INFO, "  [OK] Device found");
+    } catch (const std::exception& e) {
+        DEVICE_LOG(MTP, ERROR, "Error connecting to USB device: " + std::string(e.what()));
+        return false;
+    }
+    return OpenUSBSession();
+}
 
-        Log("Opening MTP session...");
+bool ZuneDevice::ConnectUSB(const usb::ContextPtr& context, const usb::DeviceDescriptorPtr& descriptor,
+                            const std::string& serial) {
+    ZUNE_TRACE_SPAN("connect", "ConnectUSB");
+    DEVICE_LOG(MTP, INFO, "Connecting to Zune device via USB (known descriptor)...");
+    if (!OpenUSBDevice(context, descriptor, serial)) {
+        return false;
+    }
+    DEVICE_LOG(MTP, INFO, "  [OK] Device opened");
+    return OpenUSBSession();
+}
+
+bool ZuneDevice::OpenUSBDevice(const usb::ContextPtr& context, const usb::DeviceDescriptorPtr& descriptor,
+                               const std::string& serial) {
+    try {
+        zune::Tracer::Span open("connect", "Device::Open");
+        // Claiming the interface fails if another handle has this Zune open
+        auto device = Device::Open(context, descriptor, true, false);
+        open.End();
+        if (!device) {
+            DEVICE_LOG(MTP, ERROR, "Error: Failed to open device");
+            return false;
+        }
+        if (!serial.empty()) {
+            // GetDeviceInfo needs no session, so a wrong Zune costs one
+            // transaction, not an MTPZ handshake
+            ZUNE_TRACE_SPAN("connect", "GetDeviceInfo");
+            if (device->GetInfo().SerialNumber != serial) {
+                return false;
+            }
+        }
+        usb_context_ = context;
+        device_ = device;
+        usb_descriptor_ = descriptor;
+        return true;
+    } catch (const std::exception& e) {
+        DEVICE_LOG(MTP, ERROR, "Failed to open device: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool ZuneDevice::OpenUSBSession() {
+    try {
+        DEVICE_LOG(MTP, INFO, "Opening MTP session...");
+        transfer_stats_.Reset();
+        mtp_scheduler_.Reset();
+        ResetDeviceIdentity();
+        zune::Tracer::Span open_session("connect", "OpenSession");
         mtp_session_ = device_->OpenSession(1);
+        open_session.End();
         if (!mtp_session_) {
-            Log("Error: Failed to open MTP session");
+            DEVICE_LOG(MTP, ERROR, "Error: Failed to open MTP session");
             return false;
         }
-        Log("  [OK] Session opened");
+        DEVICE_LOG(MTP, INFO, "  [OK] Session opened");
 
         // NOTE: Do NOT call Operation1002 here - HTTP init happens later via InitializeHTTPSubsystem()
         // The Windows Zune software does NOT call Operation1002 during initial connection
 
-        Log("Initializing MTPZ authentication...");
+        DEVICE_LOG(MTP, INFO, "Initializing MTPZ authentication...");
+        zune::Tracer::Span mtpz("connect", "mtpz.auth");
         if (!mtpz_data_path_.empty()) {
             if (!MtpzDataExists(mtpz_data_path_, [this](const std::string& msg) { this->Log(msg); })) {
-                Log("  [WARN] MTPZ keys unavailable — device may deny data read operations");
+                DEVICE_LOG(MTP, WARNING, "  [WARN] MTPZ keys unavailable — device may deny data read operations");
             }
         }
         cli_session_ = std::make_shared<cli::Session>(mtp_session_, false, mtpz_data_path_);
-        Log("  [OK] MTPZ session initialized");
+        mtpz.End();
+        DEVICE_LOG(MTP, INFO, "  [OK] MTPZ session initialized");
 
         // Initialize NetworkManager
-        network_manager_ = std::make_unique<NetworkManager>(mtp_session_, [this](const std::string& msg) {
-            this->Log(msg);
-        });
+        network_manager_ = std::make_unique<NetworkManager>(mtp_session_, &logger_,
+                                                            &transfer_stats_, &mtp_scheduler_,
+                                                            &metadata_disk_cache_);
 
         // NOTE: Do NOT scan library here - Windows Zune doesn't do this during connect
         // Library scanning might interfere with the device's autonomous metadata fetching
@@ -175,17 +243,20 @@ bool ZuneDevice::ConnectUSB() {
 
         return true;
     } catch (const std::exception& e) {
-        Log("Error connecting to USB device: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error connecting to USB device: " + std::string(e.what()));
         return false;
     }
 }
 
 bool ZuneDevice::ConnectWireless(const std::string& ip_address) {
-    Log("Wireless connection is not yet implemented.");
+    DEVICE_LOG(MTP, INFO, "Wireless connection is not yet implemented.");
     return false;
 }
 
 void ZuneDevice::Disconnect() {
+    async_executor_.CancelAll();
+    async_executor_.WaitIdle();
+    playlist_stage_.Flush();
     if (network_manager_) {
         network_manager_->RequestShutdown();
         network_manager_.reset();
@@ -205,7 +276,15 @@ void ZuneDevice::Disconnect() {
     if (usb_context_) {
         usb_context_.reset();
     }
-    Log("Device disconnected.");
+    ResetDeviceIdentity();
+    library_model_.Clear();
+    descriptor_cache_.Close();
+    folder_cache_.Clear();
+    sync_journal_.Close();
+    content_index_.Close();
+    upload_verifier_.Clear();
+    artwork_pipeline_.Disable();
+    DEVICE_LOG(MTP, INFO, "Device disconnected.");
 }
 
 bool ZuneDevice::IsConnected() {
@@ -213,6 +292,7 @@ bool ZuneDevice::IsConnected() {
 }
 
 bool ZuneDevice::ValidateConnection() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_ || !device_) {
         return false;
     }
@@ -223,10 +303,10 @@ bool ZuneDevice::ValidateConnection() {
         device_->GetInfo();
         return true;
     } catch (const std::exception& e) {
-        Log("ValidateConnection: MTP operation failed - " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "ValidateConnection: MTP operation failed - " + std::string(e.what()));
         return false;
     } catch (...) {
-        Log("ValidateConnection: Unknown exception during MTP operation");
+        DEVICE_LOG(MTP, INFO, "ValidateConnection: Unknown exception during MTP operation");
         return false;
     }
 }
@@ -236,25 +316,25 @@ void ZuneDevice::SetMtpzDataPath(const std::string& path) {
 }
 
 void ZuneDevice::SetLogCallback(LogCallback callback) {
-    log_callback_ = callback;
+    logger_.SetSink(std::move(callback));
 }
 
-void ZuneDevice::Log(const std::string& message) {
-    if (log_callback_) {
-        log_callback_(message);
+void ZuneDevice::SetLogLevel(ZuneLogCategory category, ZuneLogLevel level) {
+    if (category == ZUNE_LOG_CATEGORY_COUNT) {
+        logger_.SetLevel(level);
+    } else {
+        logger_.SetLevel(category, level);
     }
 }
 
-void ZuneDevice::VerboseLog(const std::string& message) {
-    if (verbose_logging_ && log_callback_) {
-        log_callback_(message);
-    }
+void ZuneDevice::Log(const std::string& message) {
+    DEVICE_LOG(MTP, INFO, message);
 }
 
 bool ZuneDevice::LoadMacGuid() {
     std::ifstream file(guid_file_);
     if (!file.is_open()) {
-        Log("Error: Could not open " + guid_file_);
+        DEVICE_LOG(MTP, ERROR, "Error: Could not open " + guid_file_);
         return false;
     }
     std::getline(file, mac_guid_);
@@ -284,7 +364,7 @@ std::string ZuneDevice::Utf16leToAscii(const ByteArray& data, bool is_guid) {
 bool ZuneDevice::SaveSessionGuidBinary(const ByteArray& guid_data) {
     std::ofstream file(device_guid_file_, std::ios::binary);
     if (!file.is_open()) {
-        Log("Error: Could not write to " + device_guid_file_);
+        DEVICE_LOG(MTP, ERROR, "Error: Could not write to " + device_guid_file_);
         return false;
     }
     file.write(reinterpret_cast<const char*>(guid_data.data()), guid_data.size());
@@ -292,6 +372,7 @@ bool ZuneDevice::SaveSessionGuidBinary(const ByteArray& guid_data) {
 }
 
 bool ZuneDevice::LoadSessionGuid() {
+    ZUNE_TRACE_SPAN("connect", "LoadSessionGuid");
     std::ifstream file(device_guid_file_, std::ios::binary);
     if (!file.is_open()) {
         return false;
@@ -332,187 +413,191 @@ ByteArray ZuneDevice::LoadPropertyFromFile(const std::string& filename) {
 }
 
 int ZuneDevice::EstablishSyncPairing(const std::string& device_name) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return 1;
     }
 
-    Log("Phase 1: USB Sync Pairing");
-    Log("Establishing USB synchronization partnership...");
+    DEVICE_LOG(MTP, INFO, "Phase 1: USB Sync Pairing");
+    DEVICE_LOG(MTP, INFO, "Establishing USB synchronization partnership...");
 
     try {
-        Log("Setting MTP driver version...");
+        DEVICE_LOG(MTP, INFO, "Setting MTP driver version...");
         std::string driver_str = "macOS/11.0 ZuneWirelessSync/1.0.0";
         ByteArray driver_data;
         OutputStream stream(driver_data);
         stream << driver_str;
         mtp_session_->SetDeviceProperty((DeviceProperty)0xd406, driver_data);
-        Log("  [OK] Property 0xd406 set");
+        DEVICE_LOG(MTP, INFO, "  [OK] Property 0xd406 set");
 
-        Log("Querying property descriptors...");
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd22f); } catch (const std::exception& e) { Log("  → Failed to query 0xd22f (non-critical): " + std::string(e.what())); }
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd402); } catch (const std::exception& e) { Log("  → Failed to query 0xd402 (non-critical): " + std::string(e.what())); }
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0x5002); } catch (const std::exception& e) { Log("  → Failed to query 0x5002 (non-critical): " + std::string(e.what())); }
-        Log("  [OK] Queried initial descriptors");
+        DEVICE_LOG(MTP, INFO, "Querying property descriptors...");
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd22f); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd22f (non-critical): " + std::string(e.what())); }
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd402); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd402 (non-critical): " + std::string(e.what())); }
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0x5002); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0x5002 (non-critical): " + std::string(e.what())); }
+        DEVICE_LOG(MTP, INFO, "  [OK] Queried initial descriptors");
 
         // Set device name if provided
         if (!device_name.empty()) {
-            Log("Setting device name...");
+            DEVICE_LOG(MTP, INFO, "Setting device name...");
             ByteArray name_data;
             OutputStream name_stream(name_data);
             name_stream << device_name;
             mtp_session_->SetDeviceProperty((DeviceProperty)0xd402, name_data);
-            Log("  [OK] Device name set to: \"" + device_name + "\"");
+            DEVICE_LOG(MTP, INFO, "  [OK] Device name set to: \"" + device_name + "\"");
         }
 
-        Log("Querying pairing property descriptors...");
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd231); } catch (const std::exception& e) { Log("  → Failed to query 0xd231 (non-critical): " + std::string(e.what())); }
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd232); } catch (const std::exception& e) { Log("  → Failed to query 0xd232 (non-critical): " + std::string(e.what())); }
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd21c); } catch (const std::exception& e) { Log("  → Failed to query 0xd21c (non-critical): " + std::string(e.what())); }
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd225); } catch (const std::exception& e) { Log("  → Failed to query 0xd225 (non-critical): " + std::string(e.what())); }
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd401); } catch (const std::exception& e) { Log("  → Failed to query 0xd401 (non-critical): " + std::string(e.what())); }
-        Log("  [OK] Queried pairing descriptors");
+        DEVICE_LOG(MTP, INFO, "Querying pairing property descriptors...");
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd231); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd231 (non-critical): " + std::string(e.what())); }
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd232); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd232 (non-critical): " + std::string(e.what())); }
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd21c); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd21c (non-critical): " + std::string(e.what())); }
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd225); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd225 (non-critical): " + std::string(e.what())); }
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd401); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd401 (non-critical): " + std::string(e.what())); }
+        DEVICE_LOG(MTP, INFO, "  [OK] Queried pairing descriptors");
 
-        Log("Setting pairing properties...");
+        DEVICE_LOG(MTP, INFO, "Setting pairing properties...");
 
-        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd22c); } catch (const std::exception& e) { Log("  → Failed to query 0xd22c (non-critical): " + std::string(e.what())); }
-        Log("  → Queried descriptor 0xd22c");
+        try { mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd22c); } catch (const std::exception& e) { DEVICE_LOG(MTP, WARNING, "  → Failed to query 0xd22c (non-critical): " + std::string(e.what())); }
+        DEVICE_LOG(MTP, INFO, "  → Queried descriptor 0xd22c");
 
         // Generate a new sync partner GUID for this pairing
         std::string sync_partner_guid = GenerateUUID();
-        Log("  Generated new sync partner GUID: " + sync_partner_guid);
+        DEVICE_LOG(MTP, INFO, "  Generated new sync partner GUID: " + sync_partner_guid);
 
         cli_session_->SetDeviceProp("d225", "{00000000-0000-0000-0000-000000000000}");
-        Log("  [OK] Set property 0xd225 (Null GUID)");
+        DEVICE_LOG(MTP, INFO, "  [OK] Set property 0xd225 (Null GUID)");
 
         ByteArray prop_d21c = {0x00};
         mtp_session_->SetDeviceProperty((DeviceProperty)0xd21c, prop_d21c);
-        Log("  [OK] Set property 0xd21c");
+        DEVICE_LOG(MTP, INFO, "  [OK] Set property 0xd21c");
 
         cli_session_->SetDeviceProp("d401", sync_partner_guid);
-        Log("  [OK] Set property 0xd401 (SynchronizationPartner) = " + sync_partner_guid + " * KEY PROPERTY");
+        DEVICE_LOG(MTP, INFO, "  [OK] Set property 0xd401 (SynchronizationPartner) = " + sync_partner_guid + " * KEY PROPERTY");
 
         // Set remaining properties from embedded data
         mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd230);
         ByteArray prop_d230(prop_d230_data, prop_d230_data + sizeof(prop_d230_data));
         mtp_session_->SetDeviceProperty((DeviceProperty)0xd230, prop_d230);
-        Log("  [OK] Set property 0xd230");
+        DEVICE_LOG(MTP, INFO, "  [OK] Set property 0xd230");
 
         mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd229);
         ByteArray prop_d229(prop_d229_data, prop_d229_data + sizeof(prop_d229_data));
         mtp_session_->SetDeviceProperty((DeviceProperty)0xd229, prop_d229);
-        Log("  [OK] Set property 0xd229");
+        DEVICE_LOG(MTP, INFO, "  [OK] Set property 0xd229");
 
         mtp_session_->GetDevicePropertyDesc((DeviceProperty)0xd22a);
         ByteArray prop_d22a(prop_d22a_data, prop_d22a_data + sizeof(prop_d22a_data));
         mtp_session_->SetDeviceProperty((DeviceProperty)0xd22a, prop_d22a);
-        Log("  [OK] Set property 0xd22a");
+        DEVICE_LOG(MTP, INFO, "  [OK] Set property 0xd22a");
 
-        Log("Running final sync operations...");
+        DEVICE_LOG(MTP, INFO, "Running final sync operations...");
         mtp_session_->Operation9224();
-        Log("  [OK] Operation 0x9224 complete");
+        DEVICE_LOG(MTP, INFO, "  [OK] Operation 0x9224 complete");
 
         mtp_session_->GetDeviceProperty((DeviceProperty)0xd217);
         mtp_session_->GetDeviceProperty((DeviceProperty)0xd217);
         mtp_session_->GetDeviceProperty((DeviceProperty)0xd217);
-        Log("  [OK] Property 0xd217 read 3x");
+        DEVICE_LOG(MTP, INFO, "  [OK] Property 0xd217 read 3x");
 
         mtp_session_->Operation9217(1);
-        Log("  [OK] Operation 0x9217(1) complete");
+        DEVICE_LOG(MTP, INFO, "  [OK] Operation 0x9217(1) complete");
 
         try {
             mtp_session_->Operation9227_Init();
-            Log("  [OK] Operation 0x9227 succeeded");
+            DEVICE_LOG(MTP, INFO, "  [OK] Operation 0x9227 succeeded");
         } catch (const std::exception& e) {
-            Log("  → Operation 0x9227 failed (expected): " + std::string(e.what()));
+            DEVICE_LOG(MTP, INFO, "  → Operation 0x9227 failed (expected): " + std::string(e.what()));
         }
 
         mtp_session_->Operation9218(0, 0, 5000);
-        Log("  [OK] Operation 0x9218(0, 0, 5000) complete");
+        DEVICE_LOG(MTP, INFO, "  [OK] Operation 0x9218(0, 0, 5000) complete");
         
-        Log("\n[OK] Phase 1 Complete!");
+        DEVICE_LOG(MTP, INFO, "\n[OK] Phase 1 Complete!");
         return 0;
 
     } catch (const std::exception& e) {
-        Log("\nError during Phase 1: " + std::string(e.what()));
+        DEVICE_LOG(MTP, INFO, "\nError during Phase 1: " + std::string(e.what()));
         return 1;
     }
 }
 
 std::string ZuneDevice::EstablishWirelessPairing(const std::string& ssid, const std::string& password) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return "";
     }
     if (!LoadMacGuid()) {
         return "";
     }
 
-    Log("Phase 2: Wireless Setup");
+    DEVICE_LOG(MTP, INFO, "Phase 2: Wireless Setup");
 
     try {
-        Log("Network Subsystem Initialization...");
+        DEVICE_LOG(MTP, INFO, "Network Subsystem Initialization...");
         mtp_session_->Operation9230(1);
         mtp_session_->Operation922b(3, 1, 0);
 
-        Log("Setting GUID properties...");
+        DEVICE_LOG(MTP, INFO, "Setting GUID properties...");
         cli_session_->SetDeviceProp("d220", mac_guid_);
         ByteArray session_guid_data = mtp_session_->GetDeviceProperty((DeviceProperty)0xd221);
         session_guid_ = Utf16leToAscii(session_guid_data, true);
         SaveSessionGuidBinary(session_guid_data);
 
-        Log("WiFi Subsystem Initialization...");
+        DEVICE_LOG(MTP, INFO, "WiFi Subsystem Initialization...");
         cli_session_->SetWiFiNetwork(ssid, password);
 
-        Log("Enabling wireless sync...");
+        DEVICE_LOG(MTP, INFO, "Enabling wireless sync...");
         mtp_session_->Operation9230(1);
 
-        Log("\n[OK] Phase 2 Complete!");
+        DEVICE_LOG(MTP, INFO, "\n[OK] Phase 2 Complete!");
         return session_guid_;
 
     } catch (const std::exception& e) {
-        Log("\nError during Phase 2: " + std::string(e.what()));
+        DEVICE_LOG(MTP, INFO, "\nError during Phase 2: " + std::string(e.what()));
         return "";
     }
 }
 
 int ZuneDevice::DisableWireless() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return 1;
     }
     try {
-        Log("Disabling wireless sync...");
+        DEVICE_LOG(MTP, INFO, "Disabling wireless sync...");
         cli_session_->DisableWireless();
-        Log("[OK] Wireless sync disabled");
+        DEVICE_LOG(MTP, INFO, "[OK] Wireless sync disabled");
         return 0;
     } catch (const std::exception& e) {
-        Log("Error disabling wireless: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error disabling wireless: " + std::string(e.what()));
         return 1;
     }
 }
 
 int ZuneDevice::EraseAllContent() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return -1;
     }
     
     try {
-        Log("WARNING: Erasing all content on device...");
+        DEVICE_LOG(MTP, WARNING, "WARNING: Erasing all content on device...");
         
         // Get the default storage ID (typically 0x00010001)
         uint32_t storageId = GetDefaultStorageId();
         if (storageId == 0) {
-            Log("Error: Could not find default storage on device.");
+            DEVICE_LOG(MTP, ERROR, "Error: Could not find default storage on device.");
             return -2;
         }
 
-        Log("Executing FormatStore operation...");
+        DEVICE_LOG(MTP, INFO, "Executing FormatStore operation...");
         mtp_session_->FormatStore(mtp::StorageId(storageId), 0);
-        Log("FormatStore completed (device content erased)");
+        DEVICE_LOG(MTP, INFO, "FormatStore completed (device content erased)");
 
-        Log("Checking device state...");
+        DEVICE_LOG(MTP, INFO, "Checking device state...");
         for (int i = 0; i < 2; i++) {
             try {
                 auto prop = mtp_session_->GetDeviceProperty(mtp::DeviceProperty(0xd217));
@@ -520,52 +605,56 @@ int ZuneDevice::EraseAllContent() {
                 if (prop.size() >= 4) {
                     uint32_t value = 0;
                     std::memcpy(&value, prop.data(), 4);
-                    std::stringstream ss;
-                    ss << "Property 0xd217 query " << (i+1) 
-                       << " returned: 0x" << std::hex << value
-                       << " (" << std::dec << value << ")";
-                    VerboseLog(ss.str());
+                    if (ZUNE_LOG_ENABLED(&logger_, MTP, DEBUG)) {
+                        std::stringstream ss;
+                        ss << "Property 0xd217 query " << (i+1) 
+                           << " returned: 0x" << std::hex << value
+                           << " (" << std::dec << value << ")";
+                        DEVICE_LOG(MTP, DEBUG, ss.str());
+                    }
                 } else {
-                    VerboseLog("Property 0xd217 query " + std::to_string(i+1) + " complete");
+                    DEVICE_LOG(MTP, DEBUG, "Property 0xd217 query " + std::to_string(i+1) + " complete");
                 }
             } catch (const std::exception& e) {
-                VerboseLog("Property 0xd217 not available: " + std::string(e.what()));
+                DEVICE_LOG(MTP, DEBUG, "Property 0xd217 not available: " + std::string(e.what()));
             }
         }
 
-        Log("Executing device finalization...");
+        DEVICE_LOG(MTP, INFO, "Executing device finalization...");
         mtp_session_->Operation9217(1);
-        Log("Device finalization complete");
+        DEVICE_LOG(MTP, INFO, "Device finalization complete");
 
-        Log("Verifying storage state...");
+        DEVICE_LOG(MTP, INFO, "Verifying storage state...");
         auto storage_info = mtp_session_->GetStorageInfo(mtp::StorageId(storageId));
-        Log("Storage verified - Free space: " + std::to_string(storage_info.FreeSpaceInBytes / 1024 / 1024) + " MB");
+        DEVICE_LOG(MTP, INFO, "Storage verified - Free space: " + std::to_string(storage_info.FreeSpaceInBytes / 1024 / 1024) + " MB");
 
-        Log("Performing final device state check...");
+        DEVICE_LOG(MTP, INFO, "Performing final device state check...");
         try {
             auto prop = mtp_session_->GetDeviceProperty(mtp::DeviceProperty(0xd217));
             if (prop.size() >= 4) {
                 uint32_t value = 0;
                 std::memcpy(&value, prop.data(), 4);
-                std::stringstream ss;
-                ss << "Property 0xd217 final query returned: 0x" << std::hex << value
-                   << " (" << std::dec << value << ")";
-                VerboseLog(ss.str());
+                if (ZUNE_LOG_ENABLED(&logger_, MTP, DEBUG)) {
+                    std::stringstream ss;
+                    ss << "Property 0xd217 final query returned: 0x" << std::hex << value
+                       << " (" << std::dec << value << ")";
+                    DEVICE_LOG(MTP, DEBUG, ss.str());
+                }
             }
         } catch (const std::exception& e) {
-            VerboseLog("Property 0xd217 final query failed: " + std::string(e.what()));
+            DEVICE_LOG(MTP, DEBUG, "Property 0xd217 final query failed: " + std::string(e.what()));
         }
 
-        Log("Rebooting device...");
+        DEVICE_LOG(MTP, INFO, "Rebooting device...");
         try {
             mtp_session_->RebootDevice();
             // Note: This command will not receive a response as the device is rebooting
         } catch (const std::exception& e) {
             // Expected - device won't respond after reboot command
-            VerboseLog("RebootDevice exception (expected): " + std::string(e.what()));
+            DEVICE_LOG(MTP, DEBUG, "RebootDevice exception (expected): " + std::string(e.what()));
         }
         
-        Log("Device is rebooting. The device will be unavailable for a few seconds.");
+        DEVICE_LOG(MTP, INFO, "Device is rebooting. The device will be unavailable for a few seconds.");
         
         // Clear cached data since device content has been erased
         ClearTrackObjectIdCache();
@@ -575,14 +664,15 @@ int ZuneDevice::EraseAllContent() {
         
         return 0;
     } catch (const std::exception& e) {
-        Log("Error during erase operation: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error during erase operation: " + std::string(e.what()));
         return -2;
     }
 }
 
 std::string ZuneDevice::GetSyncPartnerGuid() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return "";
     }
     try {
@@ -596,18 +686,19 @@ std::string ZuneDevice::GetSyncPartnerGuid() {
         std::transform(guid.begin(), guid.end(), guid.begin(), ::toupper);
         return guid;
     } catch (const std::exception& e) {
-        Log("Error getting sync partner GUID: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error getting sync partner GUID: " + std::string(e.what()));
         return "";
     }
 }
 
 int ZuneDevice::SetDeviceName(const std::string& name) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (name.empty()) {
-        Log("Error: Device name cannot be empty.");
+        DEVICE_LOG(MTP, ERROR, "Error: Device name cannot be empty.");
         return -1;
     }
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return -2;
     }
     try {
@@ -616,10 +707,10 @@ int ZuneDevice::SetDeviceName(const std::string& name) {
         OutputStream stream(name_data);
         stream << truncated;
         mtp_session_->SetDeviceProperty((DeviceProperty)0xd402, name_data);
-        Log("Device name set to: " + truncated);
+        DEVICE_LOG(MTP, INFO, "Device name set to: " + truncated);
         return 0;
     } catch (const std::exception& e) {
-        Log("Error setting device name: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error setting device name: " + std::string(e.what()));
         return -3;
     }
 }
@@ -632,16 +723,17 @@ const char* ZuneDevice::GetSyncPartnerGuidCached() {
 }
 
 std::vector<std::string> ZuneDevice::ScanWiFiNetworks() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return {};
     }
     try {
-        Log("Scanning for WiFi networks...");
+        DEVICE_LOG(MTP, INFO, "Scanning for WiFi networks...");
         mtp_session_->GetWiFiNetworkList();
         return {};
     } catch (const std::exception& e) {
-        Log("Error scanning WiFi networks: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error scanning WiFi networks: " + std::string(e.what()));
         return {};
     }
 }
@@ -649,73 +741,80 @@ std::vector<std::string> ZuneDevice::ScanWiFiNetworks() {
 
 
 std::string ZuneDevice::GetName() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return "";
     }
     try {
         ByteArray name_data = mtp_session_->GetDeviceProperty((DeviceProperty)0xd402);
         return Utf16leToAscii(name_data);
     } catch (const std::exception& e) {
-        Log("Error getting device name: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error getting device name: " + std::string(e.what()));
         return "";
     }
 }
 
 std::string ZuneDevice::GetSerialNumber() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!device_) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return "";
     }
-    try {
-        auto info = device_->GetInfo();
-        return info.SerialNumber;
-    } catch (const std::exception& e) {
-        Log("Error getting serial number: " + std::string(e.what()));
+    if (!CacheDeviceInfo()) {
         return "";
     }
+    return device_serial_;
 }
 
 uint64_t ZuneDevice::GetStorageCapacityBytes() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return 0;
     }
 
     try {
-        auto storage_ids = mtp_session_->GetStorageIDs();
-        if (storage_ids.StorageIDs.empty()) {
-            Log("Error: No storage found on device.");
+        if (!CacheStorageIds()) {
+            DEVICE_LOG(MTP, ERROR, "Error: No storage found on device.");
             return 0;
         }
 
-        // Get capacity from first (primary) storage
-        auto storage_info = mtp_session_->GetStorageInfo(storage_ids.StorageIDs[0]);
-        return storage_info.MaxCapacity;
+        // Get capacity from first (primary) storage; it never changes
+        if (storage_capacity_ == 0) {
+            auto storage_info = mtp_session_->GetStorageInfo(mtp::StorageId(storage_ids_[0]));
+            storage_capacity_ = storage_info.MaxCapacity;
+            SaveDeviceProfile();
+        }
+        return storage_capacity_;
     } catch (const std::exception& e) {
-        Log("Error getting storage capacity: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error getting storage capacity: " + std::string(e.what()));
         return 0;
     }
 }
 
 uint64_t ZuneDevice::GetStorageFreeBytes() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected()) {
-        Log("Error: Not connected to a device.");
+        DEVICE_LOG(MTP, ERROR, "Error: Not connected to a device.");
         return 0;
     }
 
     try {
-        auto storage_ids = mtp_session_->GetStorageIDs();
-        if (storage_ids.StorageIDs.empty()) {
-            Log("Error: No storage found on device.");
+        if (!CacheStorageIds()) {
+            DEVICE_LOG(MTP, ERROR, "Error: No storage found on device.");
             return 0;
         }
 
         // Get free space from first (primary) storage
-        auto storage_info = mtp_session_->GetStorageInfo(storage_ids.StorageIDs[0]);
+        auto storage_info = mtp_session_->GetStorageInfo(mtp::StorageId(storage_ids_[0]));
+        if (storage_capacity_ == 0) {
+            storage_capacity_ = storage_info.MaxCapacity;
+            SaveDeviceProfile();
+        }
         return storage_info.FreeSpaceInBytes;
     } catch (const std::exception& e) {
-        Log("Error getting storage free space: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "Error getting storage free space: " + std::string(e.what()));
         return 0;
     }
 }
@@ -757,6 +856,7 @@ const char* ZuneDevice::GetSessionGuidCached() {
 // ============================================================================
 
 void ZuneDevice::CacheDeviceIdentification() const {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (device_ident_cached_) {
         return;
     }
@@ -766,6 +866,7 @@ void ZuneDevice::CacheDeviceIdentification() const {
         return;
     }
 
+    ZUNE_TRACE_SPAN("connect", "CacheDeviceIdentification");
     try {
         // Read MTP property 0xd21a (device identification)
         // All Zune models support this property
@@ -780,21 +881,114 @@ void ZuneDevice::CacheDeviceIdentification() const {
 
             cached_device_ident_ = zune::ParseDeviceIdentification(raw);
             device_ident_cached_ = true;
+            raw_device_ident_ = raw;
 
             // Log the identification result
-            if (log_callback_) {
+            if (ZUNE_LOG_ENABLED(&logger_, MTP, INFO)) {
                 std::ostringstream ss;
                 ss << "Device identification: Family=" << cached_device_ident_.family_name
                    << ", Color=" << cached_device_ident_.color_name
                    << " (ID=" << static_cast<int>(cached_device_ident_.color_id) << ")";
-                log_callback_(ss.str());
+                DEVICE_LOG(MTP, INFO, ss.str());
             }
         }
     } catch (const std::exception& e) {
-        if (log_callback_) {
-            log_callback_("Failed to read device identification (0xd21a): " + std::string(e.what()));
-        }
+        DEVICE_LOG(MTP, ERROR, "Failed to read device identification (0xd21a): " + std::string(e.what()));
+    }
+
+    // The 0xd21a read doubles as the check that the profile still applies
+    if (device_ident_cached_) {
+        LoadDeviceProfile();
+    }
+}
+
+bool ZuneDevice::CacheDeviceInfo() const {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+    if (device_info_cached_) {
+        return true;
+    }
+    if (!device_) {
+        return false;
+    }
+    ZUNE_TRACE_SPAN("connect", "GetDeviceInfo");
+    try {
+        auto info = device_->GetInfo();
+        device_serial_ = info.SerialNumber;
+        device_firmware_ = info.DeviceVersion;
+        device_info_cached_ = true;
+    } catch (const std::exception& e) {
+        DEVICE_LOG(MTP, ERROR, "Error getting device info: " + std::string(e.what()));
+    }
+    return device_info_cached_;
+}
+
+bool ZuneDevice::CacheStorageIds() const {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+    CacheDeviceIdentification();  // May fill storage from the profile
+    if (!storage_ids_.empty()) {
+        return true;
+    }
+    if (!mtp_session_) {
+        return false;
+    }
+    ZUNE_TRACE_SPAN("connect", "GetStorageIDs");
+    auto storage_ids = mtp_session_->GetStorageIDs();
+    for (const auto& id : storage_ids.StorageIDs) {
+        storage_ids_.push_back(id.Id);
+    }
+    return !storage_ids_.empty();
+}
+
+void ZuneDevice::LoadDeviceProfile() const {
+    if (device_profile_dir_.empty() || profile_matched_ || !CacheDeviceInfo()) {
+        return;
+    }
+    zune::DeviceProfile profile;
+    if (!zune::DeviceProfile::Load(device_profile_dir_, device_serial_, profile)) {
+        return;
+    }
+    if (!profile.Matches(device_firmware_, raw_device_ident_)) {
+        DEVICE_LOG(MTP, INFO, "Device profile out of date (firmware " + device_firmware_ + "), reading identity");
+        return;
+    }
+    storage_ids_ = profile.storage_ids;
+    storage_capacity_ = profile.capacity_bytes;
+    profile_matched_ = true;
+    DEVICE_LOG(MTP, INFO, "Device profile matched: storage taken from " + zune::DeviceProfile::FileName(device_serial_));
+}
+
+void ZuneDevice::SaveDeviceProfile() const {
+    if (device_profile_dir_.empty() || profile_matched_ || !device_ident_cached_ || !device_info_cached_ ||
+        storage_ids_.empty() || storage_capacity_ == 0) {
+        return;
     }
+    zune::DeviceProfile profile;
+    profile.serial = device_serial_;
+    profile.firmware = device_firmware_;
+    profile.identification = raw_device_ident_;
+    profile.capacity_bytes = storage_capacity_;
+    profile.storage_ids = storage_ids_;
+    if (profile.Save(device_profile_dir_)) {
+        profile_matched_ = true;
+    } else {
+        DEVICE_LOG(MTP, INFO, "Device profile not saved to " + device_profile_dir_);
+    }
+}
+
+void ZuneDevice::ResetDeviceIdentity() {
+    device_ident_cached_ = false;
+    cached_device_ident_ = zune::DeviceIdentification{};
+    raw_device_ident_ = 0;
+    device_info_cached_ = false;
+    device_serial_.clear();
+    device_firmware_.clear();
+    storage_ids_.clear();
+    storage_capacity_ = 0;
+    profile_matched_ = false;
+}
+
+void ZuneDevice::SetDeviceProfileDirectory(const std::string& directory) {
+    device_profile_dir_ = directory;
 }
 
 zune::DeviceFamily ZuneDevice::GetDeviceFamily() {
@@ -835,19 +1029,324 @@ const char* ZuneDevice::GetDeviceColorNameCached() {
 // MTP Read Operations (via ZuneMtpReader primitives)
 // ============================================================================
 
+zune::LibraryReadOptions ZuneDevice::BuildLibraryReadOptions() {
+    zune::LibraryReadOptions options;
+    options.parallel_parse = parallel_library_parsing_;
+    options.streaming = streaming_library_read_;
+    options.snapshot_path = LibrarySnapshotPath();
+    options.fingerprint_check = library_fingerprint_check_;
+    options.deferred_details = deferred_media_details_;
+    return options;
+}
+
 ZuneMusicLibrary* ZuneDevice::GetMusicLibrary() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
     if (!mtp_session_) return nullptr;
-    return zune::MtpReader::ReadMusicLibrary(mtp_session_, GetDeviceFamily());
+    if (!library_tracking_) {
+        return zune::MtpReader::ReadMusicLibrary(
+            mtp_session_, GetDeviceFamily(), BuildLibraryReadOptions());
+    }
+
+    ZuneMusicLibrary* result = nullptr;
+    ReadTrackedLibrary([&](const zmdb::ZMDBLibrary& library,
+                           const zune::LibraryModel::AlbumArtworkMap& alb_to_objectid) {
+        result = zune::MtpReader::BuildMusicLibrary(library, alb_to_objectid);
+    });
+    return result;
+}
+
+ZuneMusicLibrary* ZuneDevice::GetPackedMusicLibrary() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
+    if (!mtp_session_) return nullptr;
+    if (!library_tracking_) {
+        return zune::MtpReader::ReadPackedMusicLibrary(
+            mtp_session_, GetDeviceFamily(), BuildLibraryReadOptions());
+    }
+
+    ZuneMusicLibrary* result = nullptr;
+    ReadTrackedLibrary([&](const zmdb::ZMDBLibrary& library,
+                           const zune::LibraryModel::AlbumArtworkMap& alb_to_objectid) {
+        result = zune::BuildPackedLibrary(library, alb_to_objectid);
+    });
+    return result;
+}
+
+void ZuneDevice::ReadTrackedLibrary(const std::function<void(
+    const zmdb::ZMDBLibrary&, const zune::LibraryModel::AlbumArtworkMap&)>& build)
+{
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
+    try {
+        zmdb::ZMDBLibrary library;
+        zune::LibraryModel::AlbumArtworkMap alb_to_objectid;
+        if (!zune::MtpReader::ReadParsedMusicLibrary(
+                mtp_session_, GetDeviceFamily(), BuildLibraryReadOptions(), library, alb_to_objectid))
+            return;
+
+        build(library, alb_to_objectid);
+        library_model_.Reset(std::move(library), std::move(alb_to_objectid));
+    } catch (...) {}
+}
+
+void ZuneDevice::SetLibraryTracking(bool enable) {
+    library_tracking_ = enable;
+    if (!enable)
+        library_model_.Clear();
+}
+
+ZuneMusicLibrary* ZuneDevice::GetTrackedMusicLibrary() {
+    ZuneMusicLibrary* result = nullptr;
+    library_model_.Visit([&](const zmdb::ZMDBLibrary& library,
+                             const zune::LibraryModel::AlbumArtworkMap& alb_to_objectid) {
+        result = zune::MtpReader::BuildMusicLibrary(library, alb_to_objectid);
+    });
+    return result;
+}
+
+int ZuneDevice::RefreshUserStates() {
+    if (!library_model_.HasLibrary()) return -3;
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
+    if (!mtp_session_) return -2;
+
+    std::vector<zune::TrackUserState> states;
+    bool read = zune::TransferStats::Measure(&transfer_stats_, ZUNE_TRANSFER_OP_GET_OBJECT_PROP_LIST, 0,
+                                             [&] { return zune::MtpReader::ReadUserStates(mtp_session_, states); });
+    if (!read) return -1;
+    size_t changed = library_model_.UserStatesRead(states);
+    DEVICE_LOG(ZMDB, DEBUG, "RefreshUserStates: " + std::to_string(states.size()) + " objects read, " +
+               std::to_string(changed) + " tracks changed");
+    return static_cast<int>(changed);
+}
+
+ZuneLibraryDelta* ZuneDevice::TakeLibraryDelta() {
+    zune::LibraryDelta delta;
+    if (!library_model_.TakeDelta(delta))
+        return nullptr;
+
+    auto result = std::unique_ptr<ZuneLibraryDelta, decltype(&zune::MtpReader::FreeLibraryDelta)>(
+        new ZuneLibraryDelta{}, &zune::MtpReader::FreeLibraryDelta);
+    result->changed = zune::MtpReader::BuildMusicLibrary(delta.changed, delta.alb_to_objectid);
+    if (!result->changed)
+        return nullptr;
+
+    result->removed_count = static_cast<uint32_t>(delta.removed.size());
+    if (!delta.removed.empty()) {
+        result->removed_atom_ids = new uint32_t[delta.removed.size()];
+        std::copy(delta.removed.begin(), delta.removed.end(), result->removed_atom_ids);
+    }
+    return result.release();
+}
+
+void ZuneDevice::SetParallelLibraryParsing(bool enable) {
+    parallel_library_parsing_ = enable;
+}
+
+void ZuneDevice::SetStreamingLibraryRead(bool enable) {
+    streaming_library_read_ = enable;
+}
+
+void ZuneDevice::SetLibraryCacheDirectory(const std::string& directory) {
+    library_cache_dir_ = directory;
+}
+
+void ZuneDevice::SetLibraryFingerprintCheck(bool enable) {
+    library_fingerprint_check_ = enable;
+}
+
+void ZuneDevice::SetDeferredMediaDetails(bool enable) {
+    deferred_media_details_ = enable;
+}
+
+void ZuneDevice::SetDescriptorCacheDirectory(const std::string& directory, bool skip_cached) {
+    descriptor_cache_.Close();
+    descriptor_cache_.ResetStats();
+    descriptor_cache_dir_ = directory;
+    descriptor_cache_.SetSkipCached(skip_cached);
+}
+
+zune::DescriptorCache* ZuneDevice::GetDescriptorCache() {
+    if (descriptor_cache_dir_.empty() || !device_) return nullptr;
+    if (!descriptor_cache_.IsOpen()) {
+        if (!CacheDeviceInfo()) {
+            DEVICE_LOG(MTP, INFO, "Descriptor cache unavailable: no device info");
+            return nullptr;
+        }
+        descriptor_cache_.Open(descriptor_cache_dir_, GetDeviceFamily(), device_firmware_);
+    }
+    return &descriptor_cache_;
+}
+
+void ZuneDevice::ClearDescriptorCache() {
+    if (auto* cache = GetDescriptorCache()) cache->Clear();
+}
+
+void ZuneDevice::SetFolderCacheEnabled(bool enabled) {
+    folder_cache_enabled_ = enabled;
+    folder_cache_.Clear();
+}
+
+void ZuneDevice::SetSyncJournalDirectory(const std::string& directory) {
+    sync_journal_.Close();
+    sync_journal_dir_ = directory;
+}
+
+zune::SyncJournal* ZuneDevice::GetSyncJournal() {
+    if (sync_journal_dir_.empty() || !device_) return nullptr;
+    if (!sync_journal_.IsOpen()) {
+        std::string serial = GetSerialNumberCached();
+        if (serial.empty()) return nullptr;
+        std::string path = (std::filesystem::path(sync_journal_dir_) / zune::SyncJournal::FileName(serial)).string();
+        if (!sync_journal_.Open(path)) {
+            DEVICE_LOG(ZMDB, INFO, "Sync journal unavailable: " + path);
+            return nullptr;
+        }
+    }
+    return &sync_journal_;
+}
+
+bool ZuneDevice::ResumeSyncJournal(zune::SyncResume& resume) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+    resume = zune::SyncResume{};
+    zune::SyncJournal* journal = GetSyncJournal();
+    if (!journal || !mtp_session_) return false;
+    if (journal->Entries().empty()) return true;
+
+    std::unordered_map<uint32_t, uint64_t> sizes;
+    bool ok = zune::TransferStats::Measure(&transfer_stats_, ZUNE_TRANSFER_OP_GET_OBJECT_PROP_LIST, 0,
+                                           [&] { return zune::MtpReader::GetObjectSizes(mtp_session_, sizes); });
+    if (!ok) {
+        DEVICE_LOG(ZMDB, ERROR, "Sync journal: object size query failed, not resuming");
+        return false;
+    }
+    resume = journal->Resume(sizes);
+    DEVICE_LOG(ZMDB, DEBUG, "Sync journal: " + std::to_string(resume.committed.size()) + " objects to keep, " +
+               std::to_string(resume.stale.size()) + " to delete");
+    return true;
+}
+
+void ZuneDevice::ClearSyncJournal() {
+    if (auto* journal = GetSyncJournal()) journal->Clear();
+}
+
+void ZuneDevice::SetContentIndexDirectory(const std::string& directory) {
+    content_index_.Close();
+    content_index_dir_ = directory;
+}
+
+zune::ContentIndex* ZuneDevice::GetContentIndex() {
+    if (content_index_dir_.empty() || !device_) return nullptr;
+    if (!content_index_.IsOpen()) {
+        std::string serial = GetSerialNumberCached();
+        if (serial.empty()) return nullptr;
+        content_index_.Open((std::filesystem::path(content_index_dir_) / zune::ContentIndex::FileName(serial)).string());
+        DEVICE_LOG(ZMDB, DEBUG, "Content index: " + std::to_string(content_index_.Size()) + " fingerprints");
+    }
+    return &content_index_;
+}
+
+void ZuneDevice::SetArtworkPipeline(bool enabled, const zune::ArtworkPipeline::Options& options) {
+    artwork_pipeline_.Disable();
+    artwork_pipeline_enabled_ = enabled;
+    artwork_pipeline_options_ = enabled ? options : zune::ArtworkPipeline::Options{};
+}
+
+zune::ArtworkPipeline* ZuneDevice::GetArtworkPipeline() {
+    if (!artwork_pipeline_enabled_ || !device_) return nullptr;
+    if (!artwork_pipeline_.IsEnabled())
+        artwork_pipeline_.Configure(artwork_pipeline_options_, GetDeviceFamily());
+    return &artwork_pipeline_;
+}
+
+void ZuneDevice::InvalidateLibrarySnapshot() {
+    std::string path = LibrarySnapshotPath();
+    std::error_code ec;
+    if (!path.empty()) std::filesystem::remove(path, ec);
+}
+
+std::string ZuneDevice::LibrarySnapshotPath() {
+    if (library_cache_dir_.empty()) return "";
+
+    std::string serial = GetSerialNumberCached();
+    if (serial.empty()) return "";
+
+    std::error_code ec;
+    std::filesystem::create_directories(library_cache_dir_, ec);
+    if (ec) {
+        DEVICE_LOG(ZMDB, INFO, "Library cache directory unavailable: " + ec.message());
+        return "";
+    }
+    return (std::filesystem::path(library_cache_dir_) / zune::SerialFileName(serial, ".zmdbsnap")).string();
 }
 
 int ZuneDevice::DownloadFile(uint32_t object_handle, const std::string& destination_path) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
     if (!mtp_session_) return -1;
     return zune::MtpReader::DownloadArtwork(mtp_session_, object_handle, destination_path);
 }
 
+int ZuneDevice::DownloadArtworkBatch(const std::vector<uint32_t>& object_handles,
+                                     const std::vector<std::string>& destination_paths,
+                                     const std::function<bool(size_t, const uint8_t*, size_t)>& sink,
+                                     std::vector<int>* results) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
+    if (!mtp_session_) {
+        if (results) results->assign(object_handles.size(), zune::MtpReader::ArtworkFailed);
+        return -1;
+    }
+    return zune::MtpReader::DownloadArtworkBatch(mtp_session_, object_handles, destination_paths, sink, results);
+}
+
 int ZuneDevice::DeleteFile(uint32_t object_handle) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) return -1;
-    return zune::MtpWriter::DeleteObject(mtp_session_, object_handle);
+    int result = zune::MtpWriter::DeleteObject(mtp_session_, object_handle, GetFolderCache());
+    if (result == 0) {
+        library_model_.ObjectDeleted(object_handle);
+        if (auto* index = GetContentIndex()) index->Remove(object_handle);
+    }
+    return result;
+}
+
+int ZuneDevice::DeleteObjects(const std::vector<uint32_t>& object_handles, bool collapse_folders,
+                              std::vector<int>* results) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+    if (results) results->assign(object_handles.size(), -1);
+    if (!mtp_session_) return -1;
+
+    std::unordered_map<uint32_t, uint16_t> formats;
+    std::unordered_map<uint32_t, uint32_t> parents;
+    if (object_handles.size() > 1) {
+        if (!zune::MtpReader::GetObjectFormats(mtp_session_, formats) ||
+            !zune::MtpReader::GetObjectParents(mtp_session_, parents)) {
+            return -1;
+        }
+    } else {
+        // Nothing to order: skip the lists
+        for (uint32_t handle : object_handles) formats[handle] = 0;
+    }
+
+    zune::DeletePlan plan = zune::DeletePlan::Build(object_handles, formats, parents, collapse_folders);
+    auto* index = GetContentIndex();
+    auto forget = [&](uint32_t handle) {
+        library_model_.ObjectDeleted(handle);
+        if (index) index->Remove(handle);
+    };
+    for (uint32_t handle : plan.missing) {
+        if (auto* folders = GetFolderCache()) folders->ObjectDeleted(handle);
+        forget(handle);
+    }
+    std::vector<uint32_t> failed = zune::MtpWriter::DeleteObjects(mtp_session_, plan, GetFolderCache(), forget);
+
+    DEVICE_LOG(MTP, INFO, "DeleteObjects: " + std::to_string(plan.ObjectCount() - failed.size()) + " deleted in " +
+        std::to_string(plan.steps.size()) + " operations, " + std::to_string(plan.missing.size()) +
+        " already gone, " + std::to_string(failed.size()) + " failed");
+
+    if (results) {
+        std::unordered_set<uint32_t> left(failed.begin(), failed.end());
+        for (size_t i = 0; i < object_handles.size(); i++) {
+            (*results)[i] = left.count(object_handles[i]) ? -1 : 0;
+        }
+    }
+    return static_cast<int>(failed.size());
 }
 
 uint32_t ZuneDevice::CreatePlaylist(
@@ -856,52 +1355,109 @@ uint32_t ZuneDevice::CreatePlaylist(
     const std::vector<uint32_t>& track_mtp_ids,
     uint32_t playlists_folder_id
 ) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) return 0;
-    return zune::MtpWriter::CreatePlaylist(
+    uint32_t playlist_id = zune::MtpWriter::CreatePlaylist(
         mtp_session_, GetDefaultStorageId(), playlists_folder_id,
         name, guid, track_mtp_ids.data(), track_mtp_ids.size());
+    if (playlist_id != 0 && folder_cache_enabled_)
+        folder_cache_.Invalidate(playlists_folder_id);
+    return playlist_id;
 }
 
 bool ZuneDevice::UpdatePlaylistTracks(
     uint32_t playlist_mtp_id,
     const std::vector<uint32_t>& track_mtp_ids
 ) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) return false;
-    return zune::MtpWriter::UpdatePlaylistTracks(
+    bool updated = zune::MtpWriter::UpdatePlaylistTracks(
         mtp_session_, playlist_mtp_id,
         track_mtp_ids.data(), track_mtp_ids.size());
+    if (updated) InvalidateLibrarySnapshot();
+    return updated;
 }
 
 bool ZuneDevice::DeletePlaylist(uint32_t playlist_mtp_id) {
+    playlist_stage_.Discard(playlist_mtp_id);
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) return false;
-    return zune::MtpWriter::DeletePlaylist(mtp_session_, playlist_mtp_id);
+    return zune::MtpWriter::DeletePlaylist(mtp_session_, playlist_mtp_id, GetFolderCache());
+}
+
+void ZuneDevice::StagePlaylistTracks(uint32_t playlist_mtp_id, std::vector<uint32_t> track_mtp_ids) {
+    playlist_stage_.Stage(playlist_mtp_id, std::move(track_mtp_ids));
+}
+
+void ZuneDevice::StageNewPlaylist(const std::string& name, const std::string& guid,
+                                  std::vector<uint32_t> track_mtp_ids, uint32_t playlists_folder_id) {
+    playlist_stage_.StageNew({name, guid, playlists_folder_id, std::move(track_mtp_ids)});
+}
+
+size_t ZuneDevice::CommitPlaylists() {
+    return playlist_stage_.Flush();
+}
+
+uint32_t ZuneDevice::GetStagedPlaylistId(const std::string& guid) const {
+    return playlist_stage_.CreatedId(guid);
+}
+
+void ZuneDevice::SetPlaylistDebounce(uint32_t milliseconds) {
+    playlist_stage_.SetDebounce(std::chrono::milliseconds(milliseconds));
 }
 
 mtp::ByteArray ZuneDevice::GetPartialObject(uint32_t object_id, uint64_t offset, uint32_t size) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
     if (!mtp_session_) return mtp::ByteArray();
-    return zune::MtpReader::GetPartialObject(mtp_session_, object_id, offset, size);
+    zune::TransferStats::Scope scope(&transfer_stats_, ZUNE_TRANSFER_OP_GET_PARTIAL_OBJECT);
+    mtp::ByteArray data = zune::MtpReader::GetPartialObject(mtp_session_, object_id, offset, size);
+    scope.AddReceived(data.size());
+    if (!data.empty() || size == 0) scope.Succeeded();  // MtpReader maps errors to empty
+    return data;
+}
+
+int ZuneDevice::StreamObject(uint32_t object_id, const zune::StreamObjectOptions& options,
+                             const std::function<bool(const uint8_t*, size_t, uint64_t)>& sink,
+                             uint64_t* next_offset) {
+    if (next_offset) *next_offset = options.offset;
+    if (!mtp_session_) return -1;
+    return zune::MtpReader::StreamObject(mtp_session_, object_id, options, sink, next_offset,
+                                         &transfer_stats_, &mtp_scheduler_);
 }
 
 uint64_t ZuneDevice::GetObjectSize(uint32_t object_id) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) return 0;
     return zune::MtpReader::GetObjectSize(mtp_session_, object_id);
 }
 
 std::string ZuneDevice::GetObjectFilename(uint32_t object_id) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) return "";
     return zune::MtpReader::GetObjectFilename(mtp_session_, object_id);
 }
 
+std::string ZuneDevice::GetMediaDetail(uint32_t object_id, ZuneMediaDetail detail) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+    if (!mtp_session_) return "";
+    uint16_t property = detail == ZUNE_MEDIA_DETAIL_URL
+        ? zune::MtpProp::SourceURL : zune::MtpProp::Description;
+    return zune::MtpReader::GetObjectText(mtp_session_, object_id, property);
+}
+
 uint32_t ZuneDevice::GetAudioTrackObjectId(const std::string& track_title, uint32_t album_object_id) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_ || track_title.empty() || album_object_id == 0) return 0;
 
     // Check cache first
-    std::string cache_key = std::to_string(album_object_id) + ":" + track_title;
     {
         std::lock_guard<std::mutex> lock(track_cache_mutex_);
-        auto it = track_objectid_cache_.find(cache_key);
-        if (it != track_objectid_cache_.end())
-            return it->second;
+        auto album = track_objectid_cache_.find(album_object_id);
+        if (album != track_objectid_cache_.end()) {
+            auto it = album->second.find(track_title);
+            if (it != album->second.end())
+                return it->second;
+        }
     }
 
     // Cache miss — query MTP and cache all siblings from the same album
@@ -911,32 +1467,52 @@ uint32_t ZuneDevice::GetAudioTrackObjectId(const std::string& track_title, uint3
 
     {
         std::lock_guard<std::mutex> lock(track_cache_mutex_);
-        for (const auto& sibling : siblings) {
-            std::string key = std::to_string(album_object_id) + ":" + sibling.name;
-            track_objectid_cache_.emplace(key, sibling.object_id);
-        }
+        auto& album = track_objectid_cache_[album_object_id];
+        for (const auto& sibling : siblings)
+            album.emplace(sibling.name, sibling.object_id);
     }
 
     return found_id;
 }
 
+int ZuneDevice::PrewarmTrackObjectIdCache(const std::vector<uint32_t>& album_object_ids) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+    if (!mtp_session_) return -1;
+
+    auto albums = zune::MtpReader::ResolveAlbumTracks(mtp_session_, album_object_ids);
+
+    int cached = 0;
+    std::lock_guard<std::mutex> lock(track_cache_mutex_);
+    for (const auto& resolved : albums) {
+        auto& album = track_objectid_cache_[resolved.album_object_id];
+        for (const auto& track : resolved.tracks) {
+            if (album.emplace(track.name, track.object_id).second)
+                cached++;
+        }
+    }
+    DEVICE_LOG(ZMDB, DEBUG, "Prewarmed track ObjectId cache: " + std::to_string(cached) + " tracks in " +
+               std::to_string(albums.size()) + " albums");
+    return cached;
+}
+
 void ZuneDevice::ClearTrackObjectIdCache() {
     std::lock_guard<std::mutex> lock(track_cache_mutex_);
     track_objectid_cache_.clear();
 }
 
 int ZuneDevice::SetTrackUserState(uint32_t zmdb_atom_id, int play_count, int skip_count, int rating) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) {
-        Log("SetTrackUserState: Device not connected");
+        DEVICE_LOG(ZMDB, INFO, "SetTrackUserState: Device not connected");
         return -2;
     }
 
     if (zmdb_atom_id == 0) {
-        Log("SetTrackUserState: Invalid ZMDB atom_id (0)");
+        DEVICE_LOG(ZMDB, INFO, "SetTrackUserState: Invalid ZMDB atom_id (0)");
         return -3;
     }
 
-    Log("SetTrackUserState: atom_id=" + std::to_string(zmdb_atom_id) +
+    DEVICE_LOG(ZMDB, INFO, "SetTrackUserState: atom_id=" + std::to_string(zmdb_atom_id) +
         " (play_count=" + std::to_string(play_count) +
         ", skip_count=" + std::to_string(skip_count) +
         ", rating=" + std::to_string(rating) + ")");
@@ -944,46 +1520,28 @@ int ZuneDevice::SetTrackUserState(uint32_t zmdb_atom_id, int play_count, int ski
     if (play_count >= 0) {
         try {
             // UseCount (0xDC91) — Uint32, confirmed writable on both Classic and HD
-            mtp::ByteArray countData(4);
-            countData[0] = static_cast<uint8_t>(play_count & 0xFF);
-            countData[1] = static_cast<uint8_t>((play_count >> 8) & 0xFF);
-            countData[2] = static_cast<uint8_t>((play_count >> 16) & 0xFF);
-            countData[3] = static_cast<uint8_t>((play_count >> 24) & 0xFF);
-
-            mtp_session_->SetObjectProperty(
-                mtp::ObjectId(zmdb_atom_id),
-                mtp::ObjectProperty::UseCount,
-                countData
-            );
-            Log("  UseCount set to " + std::to_string(play_count));
+            zune::MtpWriter::SetPlayCount(mtp_session_, zmdb_atom_id, static_cast<uint32_t>(play_count));
+            DEVICE_LOG(ZMDB, INFO, "  UseCount set to " + std::to_string(play_count));
         } catch (const std::exception& e) {
-            Log("  UseCount update FAILED: " + std::string(e.what()));
+            DEVICE_LOG(ZMDB, ERROR, "  UseCount update FAILED: " + std::string(e.what()));
             return -4;
         }
     }
 
     if (skip_count >= 0) {
         // SkipCount (0xDC92) is not supported by Zune devices — InvalidObjectPropCode
-        Log("  SkipCount write not supported by device firmware");
+        DEVICE_LOG(ZMDB, INFO, "  SkipCount write not supported by device firmware");
         return -5;
     }
 
     if (rating >= 0) {
         try {
             // UserRating (0xDC8A) expects Uint16 (2 bytes, little-endian)
-            mtp::ByteArray ratingData(2);
-            ratingData[0] = static_cast<uint8_t>(rating & 0xFF);
-            ratingData[1] = static_cast<uint8_t>((rating >> 8) & 0xFF);
-
-            mtp_session_->SetObjectProperty(
-                mtp::ObjectId(zmdb_atom_id),
-                mtp::ObjectProperty::UserRating,
-                ratingData
-            );
-            Log("  Rating set to " + std::to_string(rating) + " via SetObjectProperty(UserRating) as Uint16 - SUCCESS");
+            zune::MtpWriter::SetRating(mtp_session_, zmdb_atom_id, static_cast<uint16_t>(rating));
+            DEVICE_LOG(ZMDB, INFO, "  Rating set to " + std::to_string(rating) + " via SetObjectProperty(UserRating) as Uint16 - SUCCESS");
             return 0;
         } catch (const std::exception& e) {
-            Log("  Rating update FAILED: " + std::string(e.what()));
+            DEVICE_LOG(ZMDB, ERROR, "  Rating update FAILED: " + std::string(e.what()));
             return -1;
         }
     }
@@ -991,7 +1549,184 @@ int ZuneDevice::SetTrackUserState(uint32_t zmdb_atom_id, int play_count, int ski
     return 0;
 }
 
+int ZuneDevice::SetTrackUserStates(const ZuneTrackUserState* states, uint32_t count, int* status) {
+    if (!mtp_session_) return -2;
+
+    // Tracks per SetObjectPropList: two properties each, about 8 KB of list
+    constexpr size_t kChunk = 256;
+    constexpr uint16_t kOperationNotSupported = 0x2005;
+
+    std::vector<zune::TrackUserState> pending;
+    std::vector<uint32_t> pending_index;
+    pending.reserve(std::min<size_t>(count, kChunk));
+    pending_index.reserve(pending.capacity());
+    bool use_lists = true;
+    size_t list_writes = 0, single_writes = 0;
+
+    // Per-property writes for one chunk, so each failure lands on its own track
+    auto write_singly = [&] {
+        for (size_t i = 0; i < pending.size(); i++) {
+            const zune::TrackUserState& st = pending[i];
+            int& result = status[pending_index[i]];
+            if (st.play_count >= 0) {
+                try {
+                    zune::MtpWriter::SetPlayCount(mtp_session_, st.object_id, static_cast<uint32_t>(st.play_count));
+                    single_writes++;
+                } catch (const std::exception&) {
+                    result = -4;
+                    continue;
+                }
+            }
+            if (st.rating >= 0) {
+                try {
+                    zune::MtpWriter::SetRating(mtp_session_, st.object_id, static_cast<uint16_t>(st.rating));
+                    single_writes++;
+                } catch (const std::exception&) {
+                    result = -1;
+                }
+            }
+        }
+    };
+
+    // One grant per chunk so network polling can run between chunks
+    auto flush = [&] {
+        if (pending.empty()) return;
+        auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+        bool listed = false;
+        if (use_lists) {
+            try {
+                zune::MtpWriter::SetUserStateList(mtp_session_, pending.data(), pending.size());
+                list_writes++;
+                listed = true;
+            } catch (const mtp::InvalidResponseException& ex) {
+                if (static_cast<uint16_t>(ex.Type) == kOperationNotSupported) {
+                    DEVICE_LOG(ZMDB, INFO, "SetTrackUserStates: SetObjectPropList not supported, using per-property writes");
+                    use_lists = false;
+                }
+            } catch (const std::exception&) {}
+        }
+        if (!listed) write_singly();
+        pending.clear();
+        pending_index.clear();
+    };
+
+    for (uint32_t i = 0; i < count; i++) {
+        const ZuneTrackUserState& in = states[i];
+        status[i] = 0;
+        if (in.zmdb_atom_id == 0) {
+            status[i] = -3;
+            continue;
+        }
+        if (in.play_count < 0 && in.rating < 0) continue;
+        pending.push_back(zune::TrackUserState{in.zmdb_atom_id, in.play_count, in.rating});
+        pending_index.push_back(i);
+        if (pending.size() == kChunk) flush();
+    }
+    flush();
+
+    // SkipCount (0xDC92) is not writable on Zune firmware; the other values still went out
+    int applied = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (status[i] == 0 && states[i].skip_count >= 0) status[i] = -5;
+        if (status[i] == 0) applied++;
+    }
+
+    DEVICE_LOG(ZMDB, DEBUG, "SetTrackUserStates: " + std::to_string(applied) + "/" + std::to_string(count) +
+               " tracks in " + std::to_string(list_writes) + " property lists and " +
+               std::to_string(single_writes) + " single writes");
+    return applied;
+}
+
+int ZuneDevice::BackfillArtistMetadata(uint32_t artists_folder, ZuneArtistBackfillItem* items, uint32_t count,
+                                       const ArtistBackfillProgress& progress) {
+    if (!mtp_session_) return -2;
+
+    // Tracks per SetObjectPropList: one property each, about 6 KB of list
+    constexpr uint32_t kChunk = 512;
+
+    uint64_t track_total = 0, tracks_done = 0;
+    uint32_t artists_done = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        ZuneArtistBackfillItem& item = items[i];
+        item.tracks_done = std::min(item.tracks_done, item.track_count);
+        track_total += item.track_count;
+        tracks_done += item.tracks_done;
+        if (item.artist_id != 0 && item.tracks_done == item.track_count) artists_done++;
+    }
+
+    size_t created = 0, list_writes = 0, failed = 0;
+    bool stopped = false;
+    for (uint32_t i = 0; i < count && !stopped; i++) {
+        ZuneArtistBackfillItem& item = items[i];
+        if (item.artist_id != 0 && item.tracks_done == item.track_count) continue;
+
+        if (item.artist_id == 0) {
+            std::string name = item.name ? item.name : "";
+            uint32_t artist_id = 0;
+            {
+                auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+                if (!mtp_session_) return -2;
+                try {
+                    artist_id = zune::MtpWriter::CreateArtistMetadata(
+                        mtp_session_, GetDefaultStorageId(), artists_folder,
+                        name, item.guid_bytes, item.guid_bytes ? 16 : 0, false);
+                } catch (const std::exception&) {}
+            }
+            if (artist_id == 0) {
+                failed++;
+                continue;
+            }
+            item.artist_id = artist_id;
+            created++;
+            if (item.tracks_done == item.track_count) artists_done++;
+            library_model_.ArtistCreated(artist_id, name,
+                item.guid_bytes ? zmdb::parse_windows_guid(zmdb::ByteView(item.guid_bytes, 16)) : "");
+            if (folder_cache_enabled_) folder_cache_.Invalidate(artists_folder);
+            if (progress && !progress(artists_done, count, tracks_done, track_total)) {
+                stopped = true;
+                break;
+            }
+        }
+
+        // One grant per chunk so network polling can run between chunks
+        while (item.tracks_done < item.track_count) {
+            uint32_t n = std::min(kChunk, item.track_count - item.tracks_done);
+            bool written = false;
+            {
+                auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
+                if (!mtp_session_) return -2;
+                try {
+                    zune::MtpWriter::SetArtistIdList(mtp_session_, item.artist_id,
+                                                     item.track_ids + item.tracks_done, n);
+                    written = true;
+                } catch (const std::exception&) {}
+            }
+            if (!written) {
+                failed++;
+                break;
+            }
+            list_writes++;
+            item.tracks_done += n;
+            tracks_done += n;
+            if (item.tracks_done == item.track_count) artists_done++;
+            if (progress && !progress(artists_done, count, tracks_done, track_total)) {
+                stopped = true;
+                break;
+            }
+        }
+    }
+
+    if (created > 0 || list_writes > 0) InvalidateLibrarySnapshot();
+
+    DEVICE_LOG(ZMDB, INFO, "BackfillArtistMetadata: " + std::to_string(artists_done) + "/" + std::to_string(count) +
+               " artists, " + std::to_string(created) + " created, " + std::to_string(tracks_done) + "/" +
+               std::to_string(track_total) + " tracks in " + std::to_string(list_writes) + " property lists, " +
+               std::to_string(failed) + " failed" + (stopped ? " (stopped)" : ""));
+    return static_cast<int>(artists_done);
+}
+
 mtp::ByteArray ZuneDevice::GetZuneMetadata(const std::vector<uint8_t>& object_id) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_READ);
     if (mtp_session_) {
         return zune::MtpReader::ReadZuneMetadata(mtp_session_, object_id);
     }
@@ -1034,6 +1769,21 @@ int ZuneDevice::PollNetworkData(int timeout_ms) {
     return -1;
 }
 
+uint64_t ZuneDevice::StartNetworkPollLoop(NetworkPollLoop::EventFn on_event,
+                                          int hot_wait_ms, int idle_wait_ms) {
+    if (network_manager_) {
+        return network_manager_->StartNetworkPollLoop(std::move(on_event), hot_wait_ms, idle_wait_ms);
+    }
+    return 0;
+}
+
+bool ZuneDevice::StopNetworkPollLoop(uint64_t token) {
+    if (network_manager_) {
+        return network_manager_->StopNetworkPollLoop(token);
+    }
+    return false;
+}
+
 bool ZuneDevice::IsHTTPInterceptorRunning() const {
     if (network_manager_) {
         return network_manager_->IsHTTPInterceptorRunning();
@@ -1073,44 +1823,135 @@ void ZuneDevice::SetCacheStorageCallback(CacheStorageCallback callback, void* us
     }
 }
 
-void ZuneDevice::SetVerboseNetworkLogging(bool enable) {
-    verbose_logging_ = enable;
+MetadataResponseCache::Stats ZuneDevice::GetMetadataCacheStats() const {
+    if (network_manager_) {
+        return network_manager_->GetMetadataCacheStats();
+    }
+    return MetadataResponseCache::Stats{};
+}
+
+void ZuneDevice::ClearMetadataCache() {
+    if (network_manager_) {
+        network_manager_->ClearMetadataCache();
+    }
+}
+
+void ZuneDevice::SetMetadataCacheCapacity(size_t bytes) {
+    if (network_manager_) {
+        network_manager_->SetMetadataCacheCapacity(bytes);
+    }
+}
+
+bool ZuneDevice::SetMetadataDiskCache(const std::string& directory,
+                                      const MetadataDiskCache::Limits& limits) {
+    // Responses already in memory were resolved against the old store
+    ClearMetadataCache();
+    if (directory.empty()) {
+        metadata_disk_cache_.Close();
+        return true;
+    }
+    if (!metadata_disk_cache_.Open(directory, limits)) {
+        DEVICE_LOG(HTTP, WARNING, "Metadata disk cache: cannot open " + directory);
+        return false;
+    }
+    auto stats = metadata_disk_cache_.GetStats();
+    DEVICE_LOG(HTTP, INFO, "Metadata disk cache: " + std::to_string(stats.entries) + " entries, " +
+               std::to_string(stats.bytes / 1024) + " KB in " + directory);
+    return true;
+}
+
+MetadataDiskCache::Stats ZuneDevice::GetMetadataDiskCacheStats() const {
+    return metadata_disk_cache_.GetStats();
+}
+
+void ZuneDevice::SetImageResizeCallback(ImageResizeCallback callback, void* user_data) {
+    if (!network_manager_) {
+        return;
+    }
+    ImageVariantCache::Resizer resizer;
+    if (callback) {
+        resizer = [callback, user_data](const uint8_t* jpeg, size_t size, uint32_t width,
+                                        uint8_t* out, size_t capacity) -> size_t {
+            if (size > UINT32_MAX) return 0;
+            return callback(jpeg, static_cast<uint32_t>(size), width,
+                            out, static_cast<uint32_t>(capacity), user_data);
+        };
+    }
+    network_manager_->SetImageResizer(std::move(resizer));
+}
+
+ImageVariantCache::Stats ZuneDevice::GetImageVariantStats() const {
+    if (network_manager_) {
+        return network_manager_->GetImageVariantStats();
+    }
+    return ImageVariantCache::Stats{};
+}
+
+RequestWorkerStats ZuneDevice::GetRequestWorkerStats() const {
+    if (network_manager_) {
+        return network_manager_->GetRequestWorkerStats();
+    }
+    return RequestWorkerStats{};
+}
+
+InterceptorNetworkStats ZuneDevice::GetNetworkStats() const {
+    if (network_manager_) {
+        return network_manager_->GetNetworkStats();
+    }
+    return InterceptorNetworkStats{};
+}
+
+bool ZuneDevice::SetPacketCapture(size_t max_transfers) {
+    if (network_manager_) {
+        network_manager_->SetPacketCapture(max_transfers);
+        return true;
+    }
+    return false;
+}
+
+int64_t ZuneDevice::WritePacketCapture(const std::string& path) const {
     if (network_manager_) {
-        network_manager_->SetVerboseNetworkLogging(enable);
+        return network_manager_->WritePacketCapture(path);
     }
+    return -1;
+}
+
+void ZuneDevice::SetVerboseNetworkLogging(bool enable) {
+    ZuneLogLevel level = enable ? ZUNE_LOG_DEBUG : ZUNE_LOG_INFO;
+    logger_.SetLevel(ZUNE_LOG_PPP, level);
+    logger_.SetLevel(ZUNE_LOG_TCP, level);
+    logger_.SetLevel(ZUNE_LOG_HTTP, level);
 }
 
 // === Low-Level MTP Access Methods ===
 
 uint32_t ZuneDevice::GetDefaultStorageId() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!mtp_session_) {
         return 0;
     }
 
     try {
-        auto storages = mtp_session_->GetStorageIDs();
-        if (storages.StorageIDs.empty()) {
-            return 0;
-        }
-        return storages.StorageIDs[0].Id;
+        return CacheStorageIds() ? storage_ids_[0] : 0;
     } catch (const std::exception& e) {
-        Log("GetDefaultStorageId failed: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "GetDefaultStorageId failed: " + std::string(e.what()));
         return 0;
     }
 }
 
 bool ZuneDevice::ReadNetworkState(int32_t& active, int32_t& progress, int32_t& phase, int32_t& status) {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_NETWORK);
     if (!IsConnected() || !mtp_session_) return false;
 
     try {
         ByteArray empty;
         ByteArray response = mtp_session_->Operation922f(empty);
         if (response.size() < 16) {
-            Log("ReadNetworkState: response too short (" + std::to_string(response.size()) + " bytes)");
+            DEVICE_LOG(MTP, INFO, "ReadNetworkState: response too short (" + std::to_string(response.size()) + " bytes)");
             return false;
         }
         if (response.size() != 1036) {
-            Log("ReadNetworkState: unexpected response size (" + std::to_string(response.size()) + " bytes, expected 1036)");
+            DEVICE_LOG(MTP, INFO, "ReadNetworkState: unexpected response size (" + std::to_string(response.size()) + " bytes, expected 1036)");
         }
 
         // Extract 4 little-endian uint32 values at offsets 0, 4, 8, 12
@@ -1123,12 +1964,13 @@ bool ZuneDevice::ReadNetworkState(int32_t& active, int32_t& progress, int32_t& p
         status   = read_le32(response.data() + 12);
         return true;
     } catch (const std::exception& e) {
-        Log("ReadNetworkState failed: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "ReadNetworkState failed: " + std::string(e.what()));
         return false;
     }
 }
 
 bool ZuneDevice::TeardownNetworkSession() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_NETWORK);
     if (!IsConnected() || !mtp_session_) return false;
 
     try {
@@ -1136,24 +1978,25 @@ bool ZuneDevice::TeardownNetworkSession() {
         mtp_session_->Operation922b(3, 2, 0);  // Close session
         return true;
     } catch (const std::exception& e) {
-        Log("TeardownNetworkSession failed: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "TeardownNetworkSession failed: " + std::string(e.what()));
         return false;
     }
 }
 
 bool ZuneDevice::EnableTrustedFiles() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected() || !cli_session_) return false;
 
     try {
         auto trustedApp = cli_session_->GetTrustedApp();
         if (!trustedApp) {
-            Log("EnableTrustedFiles: TrustedApp not available");
+            DEVICE_LOG(MTP, INFO, "EnableTrustedFiles: TrustedApp not available");
             return false;
         }
         trustedApp->EnableTrustedFiles();
         return true;
     } catch (const std::exception& e) {
-        Log("EnableTrustedFiles failed: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "EnableTrustedFiles failed: " + std::string(e.what()));
         return false;
     }
 }
@@ -1161,18 +2004,19 @@ bool ZuneDevice::EnableTrustedFiles() {
 
 
 bool ZuneDevice::DisableTrustedFiles() {
+    auto grant = mtp_scheduler_.Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!IsConnected() || !cli_session_) return false;
 
     try {
         auto trustedApp = cli_session_->GetTrustedApp();
         if (!trustedApp) {
-            Log("DisableTrustedFiles: TrustedApp not available");
+            DEVICE_LOG(MTP, INFO, "DisableTrustedFiles: TrustedApp not available");
             return false;
         }
         trustedApp->DisableTrustedFiles();
         return true;
     } catch (const std::exception& e) {
-        Log("DisableTrustedFiles failed: " + std::string(e.what()));
+        DEVICE_LOG(MTP, ERROR, "DisableTrustedFiles failed: " + std::string(e.what()));
         return false;
     }
 }
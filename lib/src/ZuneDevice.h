@@ -13,10 +13,29 @@
 #include "xune_sync/xune_sync_api.h"
 #include "ZuneTypes.h"
 #include "ZuneDeviceIdentification.h"
+#include "ZuneLibraryModel.h"
+#include "ZuneTransferStats.h"
+#include "ZuneMtpScheduler.h"
+#include "ZuneLog.h"
+#include "ZuneDescriptorCache.h"
+#include "ZuneFolderCache.h"
+#include "ZuneDeviceProfile.h"
+#include "ZuneSyncJournal.h"
+#include "ZuneContentIndex.h"
+#include "ZuneArtworkPipeline.h"
+#include "ZuneAsyncExecutor.h"
+#include "ZunePlaylistStage.h"
+#include "ZuneUploadVerifier.h"
+#include "protocols/http/MetadataDiskCache.h"
+#include "protocols/http/MetadataResponseCache.h"
+#include "protocols/http/NetworkPollLoop.h"
+#include "protocols/http/RequestWorkerPool.h"
 
 class ZuneHTTPInterceptor;
 struct InterceptorConfig;
+struct InterceptorNetworkStats;
 class NetworkManager;
+namespace zune { struct LibraryReadOptions; struct StreamObjectOptions; }
 
 
 
@@ -50,7 +69,14 @@ public:
     void SetMtpzDataPath(const std::string& path);
 
     // --- Connection Management ---
-    bool ConnectUSB();
+    // First Zune that opens, or the one with this serial number. A Zune
+    // another ZuneDevice has open cannot be claimed and is passed over, so
+    // several handles connect to several Zunes.
+    bool ConnectUSB(const std::string& serial = "");
+    // Open a descriptor already found (e.g. by zune::UsbHotplug) instead of
+    // enumerating the bus; context must be the one it came from
+    bool ConnectUSB(const usb::ContextPtr& context, const usb::DeviceDescriptorPtr& descriptor,
+                    const std::string& serial = "");
     bool ConnectWireless(const std::string& ip_address);
     void Disconnect();
     bool IsConnected();
@@ -114,8 +140,49 @@ public:
 
     // --- Library & File Operations ---
     ZuneMusicLibrary* GetMusicLibrary();  // Fast: Returns flat data (tracks, albums, artworks) using zmdb
+    ZuneMusicLibrary* GetPackedMusicLibrary();  // Same data in one contiguous block; free with zune::FreePackedLibrary
+    void SetParallelLibraryParsing(bool enable);  // Multi-threaded ZMDB parsing in GetMusicLibrary (off by default)
+    void SetStreamingLibraryRead(bool enable);  // Parse the ZMDB while it transfers (off by default; not combined with the cache)
+    // Host directory for per-device parsed-library snapshots (<dir>/<serial>.zmdbsnap).
+    // GetMusicLibrary skips the ZMDB parse when the device's ZMDB is unchanged. Empty disables.
+    void SetLibraryCacheDirectory(const std::string& directory);
+    // With a cache directory, skip the ZMDB read itself when the device's contents
+    // fingerprint matches the snapshot's (off by default; see MtpReader::ReadLibraryFingerprint)
+    void SetLibraryFingerprintCheck(bool enable);
+    // Drop the cached library snapshot after a property write (titles, albums,
+    // references, artist IDs): those leave the fingerprint unchanged, so the
+    // next read must go back to the ZMDB
+    void InvalidateLibrarySnapshot();
+    // Leave video/podcast descriptions and episode URLs out of GetMusicLibrary
+    // (off by default); GetMediaDetail fetches one when it is shown
+    void SetDeferredMediaDetails(bool enable);
+    // Keep the last library read by GetMusicLibrary / GetPackedMusicLibrary current
+    // as uploads and property updates succeed (off by default; disabling drops it).
+    void SetLibraryTracking(bool enable);
+    ZuneMusicLibrary* GetTrackedMusicLibrary();  // Tracked library as ReadMusicLibrary would build it; nullptr if nothing tracked
+    ZuneLibraryDelta* TakeLibraryDelta();  // Changes since the last read or delta; nullptr if nothing tracked
+    // Merge the device's current play counts and ratings into the tracked library
+    // from two property lists, without a ZMDB read. Returns tracks changed (they
+    // appear in the next delta); -1 on a query failure, -2 if not connected,
+    // -3 if nothing is tracked.
+    int RefreshUserStates();
+    zune::LibraryModel& GetLibraryModel() { return library_model_; }
     int DownloadFile(uint32_t object_handle, const std::string& destination_path);
+    // Pipelined artwork download for many objects (see MtpReader::DownloadArtworkBatch)
+    int DownloadArtworkBatch(const std::vector<uint32_t>& object_handles,
+                             const std::vector<std::string>& destination_paths,
+                             const std::function<bool(size_t index, const uint8_t* data, size_t size)>& sink,
+                             std::vector<int>* results);
     int DeleteFile(uint32_t object_handle);
+    // Delete many objects under one MTP grant, in a safe order: files, then
+    // albums and playlists, then folders deepest first (see zune::DeletePlan).
+    // Costs two property lists plus one DeleteObject per object, or per
+    // folder whose whole contents are listed when collapse_folders is set.
+    // results (optional) gets 0 per handle deleted or already gone, -1 per
+    // handle still on the device. Returns objects not deleted, or -1 if not
+    // connected or the object lists could not be read.
+    int DeleteObjects(const std::vector<uint32_t>& object_handles, bool collapse_folders,
+                      std::vector<int>* results);
 
     // --- Playlist Management ---
     // Create a playlist on the device
@@ -133,13 +200,31 @@ public:
         const std::vector<uint32_t>& track_mtp_ids
     );
 
-    // Delete a playlist from the device
+    // Delete a playlist from the device (dropping any staged edits to it)
     bool DeletePlaylist(uint32_t playlist_mtp_id);
 
+    // Staged edits (see zune::PlaylistStage): only the latest track list of
+    // each playlist is written, on CommitPlaylists or after the debounce.
+    // Disconnect commits what is still staged.
+    void StagePlaylistTracks(uint32_t playlist_mtp_id, std::vector<uint32_t> track_mtp_ids);
+    void StageNewPlaylist(const std::string& name, const std::string& guid,
+                          std::vector<uint32_t> track_mtp_ids, uint32_t playlists_folder_id);
+    size_t CommitPlaylists();  // Writes that failed
+    uint32_t GetStagedPlaylistId(const std::string& guid) const;  // 0 until created
+    void SetPlaylistDebounce(uint32_t milliseconds);  // 0 = only on CommitPlaylists (default)
+
     // --- Streaming/Partial Downloads ---
     mtp::ByteArray GetPartialObject(uint32_t object_id, uint64_t offset, uint32_t size);
+    // Chunked, double-buffered download of an object range (see MtpReader::StreamObject).
+    // Returns 0 on success, -1 on a device error or no session, -2 if sink stopped.
+    int StreamObject(uint32_t object_id, const zune::StreamObjectOptions& options,
+                     const std::function<bool(const uint8_t* data, size_t size, uint64_t offset)>& sink,
+                     uint64_t* next_offset);
     uint64_t GetObjectSize(uint32_t object_id);
     std::string GetObjectFilename(uint32_t object_id);
+    // Description (ZUNE_MEDIA_DETAIL_DESCRIPTION) or episode URL of a video or
+    // podcast episode, read from the device; "" if it has none
+    std::string GetMediaDetail(uint32_t object_id, ZuneMediaDetail detail);
 
     // --- Track Lookup ---
     // Query MTP for a specific audio track's ObjectId by title/filename within an album
@@ -147,6 +232,11 @@ public:
     // Returns 0 if not found
     uint32_t GetAudioTrackObjectId(const std::string& track_title, uint32_t album_object_id);
 
+    // Fill the track ObjectId cache for many albums up front (e.g. before creating
+    // playlists) with one batched name query plus one reference query per album.
+    // Empty album_object_ids prewarms every album. Returns the number of tracks cached, -1 if not connected.
+    int PrewarmTrackObjectIdCache(const std::vector<uint32_t>& album_object_ids);
+
     // Clear the track ObjectId cache (call when device library changes)
     void ClearTrackObjectIdCache();
 
@@ -169,12 +259,26 @@ public:
     // Play count and skip count are ignored pending protocol analysis.
     int SetTrackUserState(uint32_t zmdb_atom_id, int play_count, int skip_count, int rating);
 
+    // Many tracks at once (see zune_device_set_track_user_states). status[i] gets
+    // SetTrackUserState's code for states[i]. Returns tracks fully applied, -2 if not connected.
+    int SetTrackUserStates(const ZuneTrackUserState* states, uint32_t count, int* status);
+
+    // --- Artist Metadata Backfill ---
+    // Create missing artist objects and point their tracks at them (see
+    // zune_device_backfill_artist_metadata); items are updated as each step
+    // lands. progress gets (artists done, artists, tracks done, tracks) and
+    // returns false to stop. Returns artists fully done, -2 if not connected.
+    using ArtistBackfillProgress = std::function<bool(uint32_t, uint32_t, uint64_t, uint64_t)>;
+    int BackfillArtistMetadata(uint32_t artists_folder, ZuneArtistBackfillItem* items, uint32_t count,
+                               const ArtistBackfillProgress& progress);
+
     // --- Metadata Retrieval ---
     mtp::ByteArray GetZuneMetadata(const std::vector<uint8_t>& object_id);
 
     // --- Callbacks ---
     using LogCallback = std::function<void(const std::string& message)>;
-    void SetLogCallback(LogCallback callback);
+    void SetLogCallback(LogCallback callback);  // Called on the logger's delivery thread
+    void SetLogLevel(ZuneLogCategory category, ZuneLogLevel level);  // ZUNE_LOG_CATEGORY_COUNT: all
 
     // --- Artist Metadata HTTP Interception ---
     bool InitializeHTTPSubsystem();  // Must be called before StartHTTPInterceptor
@@ -185,7 +289,9 @@ public:
     void TriggerNetworkMode();  // Send 0x922c(3,3) to initiate PPP/HTTP after track upload
     void EnableNetworkPolling();  // Enable polling flag - call AFTER TriggerNetworkMode()
     int PollNetworkData(int timeout_ms);  // Single poll cycle - called from C# in a loop
-    void SetVerboseNetworkLogging(bool enable);  // Enable/disable verbose TCP/IP packet logging
+    uint64_t StartNetworkPollLoop(NetworkPollLoop::EventFn on_event, int hot_wait_ms, int idle_wait_ms);
+    bool StopNetworkPollLoop(uint64_t token);  // 0 stops any loop
+    void SetVerboseNetworkLogging(bool enable);  // PPP, TCP and HTTP at DEBUG, or back to INFO
 
     // Callback registration for hybrid mode
     using PathResolverCallback = const char* (*)(const char* artist_uuid, const char* endpoint_type, const char* resource_id, void* user_data);
@@ -193,6 +299,28 @@ public:
     void SetPathResolverCallback(PathResolverCallback callback, void* user_data);
     void SetCacheStorageCallback(CacheStorageCallback callback, void* user_data);
 
+    // In-memory cache of served metadata responses (zeroed stats without a network manager)
+    MetadataResponseCache::Stats GetMetadataCacheStats() const;
+    void ClearMetadataCache();
+    void SetMetadataCacheCapacity(size_t bytes);
+
+    // Native stand-in for the two callbacks above (see MetadataDiskCache);
+    // a registered callback still takes precedence. Empty directory disables.
+    bool SetMetadataDiskCache(const std::string& directory, const MetadataDiskCache::Limits& limits);
+    MetadataDiskCache::Stats GetMetadataDiskCacheStats() const;
+
+    // Local images sent at the width the device asks for (see ImageVariantCache)
+    using ImageResizeCallback = uint32_t (*)(const uint8_t* jpeg, uint32_t size, uint32_t width,
+                                             uint8_t* out, uint32_t out_capacity, void* user_data);
+    void SetImageResizeCallback(ImageResizeCallback callback, void* user_data);
+    ImageVariantCache::Stats GetImageVariantStats() const;
+    RequestWorkerStats GetRequestWorkerStats() const;
+    InterceptorNetworkStats GetNetworkStats() const;
+
+    // Raw PPP traffic ring (see PacketCapture); both fail without a network manager
+    bool SetPacketCapture(size_t max_transfers);
+    int64_t WritePacketCapture(const std::string& path) const;  // Frames written, -1 on failure
+
     // --- Raw USB Access (for monitoring without MTP session) ---
     // Extracts USB device/interface/endpoints from MTP session for raw monitoring
     // Call this BEFORE Disconnect() - discovers endpoints while interface is still claimed
@@ -224,6 +352,68 @@ public:
     // Get default storage ID (first storage or cached value)
     uint32_t GetDefaultStorageId();
 
+    // Counters and progress callback for this device's sync traffic (reset on connect)
+    zune::TransferStats& GetTransferStats() { return transfer_stats_; }
+
+    // Priority arbiter for this device's MTP transactions; methods that use the
+    // session take a grant, and C API callers take one around direct session use
+    zune::MtpScheduler& GetMtpScheduler() { return mtp_scheduler_; }
+
+    // Worker for the _async C API; Disconnect cancels what is queued and
+    // waits for the running operation
+    zune::AsyncExecutor& GetAsyncExecutor() { return async_executor_; }
+
+    // Host directory for per-firmware descriptor caches (<dir>/<family>-<firmware>.xzdesc).
+    // With skip_cached, descriptor queries the firmware has already answered are left
+    // out of later sessions. Empty disables (the default).
+    void SetDescriptorCacheDirectory(const std::string& directory, bool skip_cached);
+    // Cache for this session's descriptor queries, bound on first use; nullptr if disabled
+    zune::DescriptorCache* GetDescriptorCache();
+    void ClearDescriptorCache();
+    zune::DescriptorCache::Stats GetDescriptorCacheStats() const { return descriptor_cache_.GetStats(); }
+
+    // Folder handles MtpWriter has discovered this session, so repeat lookups of
+    // the same artist / album folders skip the device. Off by default; cleared on
+    // Disconnect and when disabled.
+    void SetFolderCacheEnabled(bool enabled);
+    zune::FolderCache* GetFolderCache() { return folder_cache_enabled_ ? &folder_cache_ : nullptr; }
+    zune::FolderCache::Stats GetFolderCacheStats() const { return folder_cache_.GetStats(); }
+
+    // Host directory for per-device identity profiles (<dir>/<serial>.xzprofile).
+    // A reconnect then checks family, firmware and storage against the profile
+    // with one property read instead of reading them all. Empty disables (the default).
+    void SetDeviceProfileDirectory(const std::string& directory);
+
+    // Host directory for per-device upload journals (<dir>/<serial>.xzjournal), so an
+    // interrupted sync can resume. Empty disables (the default).
+    void SetSyncJournalDirectory(const std::string& directory);
+    // Journal for this device, bound on first use; nullptr if disabled
+    zune::SyncJournal* GetSyncJournal();
+    // Verify the journal against the device with one ObjectSize query.
+    // False (and an empty resume) if disabled or the query failed.
+    bool ResumeSyncJournal(zune::SyncResume& resume);
+    void ClearSyncJournal();
+
+    // Host directory for per-device content indexes (<dir>/<serial>.xzcontent) that
+    // fingerprint every uploaded track, so the planner recognizes files the device
+    // already has. Empty disables (the default).
+    void SetContentIndexDirectory(const std::string& directory);
+    // Index for this device, loaded on first use; nullptr if disabled
+    zune::ContentIndex* GetContentIndex();
+
+    // When uploads are read back (ZuneUploadVerifyPolicy; per object by default).
+    // Batched and deferred checks settle the tracks recorded in the verifier,
+    // which Disconnect clears.
+    void SetUploadVerifyPolicy(ZuneUploadVerifyPolicy policy) { upload_verify_policy_ = policy; }
+    ZuneUploadVerifyPolicy GetUploadVerifyPolicy() const { return upload_verify_policy_; }
+    zune::UploadVerifier& GetUploadVerifier() { return upload_verifier_; }
+
+    // Host-side artwork dedup / resize ahead of SetAlbumArtwork and SetSeriesArtwork.
+    // Options apply from the next use; the session state resets on each connect.
+    void SetArtworkPipeline(bool enabled, const zune::ArtworkPipeline::Options& options);
+    // Pipeline for the connected family, configured on first use; nullptr if disabled
+    zune::ArtworkPipeline* GetArtworkPipeline();
+
 private:
     // --- Internal Helper Methods ---
     bool LoadMacGuid();
@@ -232,8 +422,10 @@ private:
     mtp::ByteArray HexToBytes(const std::string& hex_str);
     mtp::ByteArray LoadPropertyFromFile(const std::string& filename);
     std::string Utf16leToAscii(const mtp::ByteArray& data, bool is_guid = false);
-    void Log(const std::string& message);
-    void VerboseLog(const std::string& message);  // Log only if verbose_logging_ is true
+    void Log(const std::string& message);  // MTP category at INFO
+    bool OpenUSBDevice(const usb::ContextPtr& context, const usb::DeviceDescriptorPtr& descriptor,
+                       const std::string& serial);  // Sets device_ if it opens and matches
+    bool OpenUSBSession();  // Rest of ConnectUSB once device_ is open
 
 
 
@@ -251,8 +443,36 @@ private:
     cli::SessionPtr cli_session_;
 
 
-    LogCallback log_callback_;
-    bool verbose_logging_ = true;  // Verbose network logging enabled by default
+    mutable zune::Logger logger_;  // Before network_manager_, which logs through it
+    bool parallel_library_parsing_ = false;
+    bool streaming_library_read_ = false;
+    std::string library_cache_dir_;
+    bool library_fingerprint_check_ = false;
+    bool deferred_media_details_ = false;
+    std::string LibrarySnapshotPath();
+    zune::LibraryReadOptions BuildLibraryReadOptions();
+    // Full read that also reseeds library_model_; build runs before the model takes the library
+    void ReadTrackedLibrary(const std::function<void(
+        const zmdb::ZMDBLibrary&, const zune::LibraryModel::AlbumArtworkMap&)>& build);
+    bool library_tracking_ = false;
+    zune::LibraryModel library_model_;
+    zune::TransferStats transfer_stats_;
+    mutable zune::MtpScheduler mtp_scheduler_;
+    std::string descriptor_cache_dir_;
+    std::string device_profile_dir_;
+    zune::DescriptorCache descriptor_cache_;
+    bool folder_cache_enabled_ = false;
+    zune::FolderCache folder_cache_;
+    std::string sync_journal_dir_;
+    zune::SyncJournal sync_journal_;
+    std::string content_index_dir_;
+    zune::ContentIndex content_index_;
+    MetadataDiskCache metadata_disk_cache_;  // Host-wide; before network_manager_, which reads it
+    ZuneUploadVerifyPolicy upload_verify_policy_ = ZUNE_UPLOAD_VERIFY_PER_OBJECT;
+    zune::UploadVerifier upload_verifier_;
+    bool artwork_pipeline_enabled_ = false;
+    zune::ArtworkPipeline::Options artwork_pipeline_options_;
+    zune::ArtworkPipeline artwork_pipeline_;
 
     // Cached device info strings (handle-scoped, thread-safe)
     mutable std::string cached_name_;
@@ -266,12 +486,33 @@ private:
     // Device identification cache (from MTP property 0xd21a)
     mutable zune::DeviceIdentification cached_device_ident_;
     mutable bool device_ident_cached_ = false;
+    mutable uint32_t raw_device_ident_ = 0;
     void CacheDeviceIdentification() const;
 
+    // Identity read once per connection, under a control grant; storage
+    // comes from the device profile when it matches
+    mutable bool device_info_cached_ = false;
+    mutable std::string device_serial_;
+    mutable std::string device_firmware_;
+    mutable std::vector<uint32_t> storage_ids_;
+    mutable uint64_t storage_capacity_ = 0;
+    mutable bool profile_matched_ = false;
+    bool CacheDeviceInfo() const;       // Serial and firmware (DeviceInfo)
+    bool CacheStorageIds() const;
+    void LoadDeviceProfile() const;
+    void SaveDeviceProfile() const;
+    void ResetDeviceIdentity();
+
     // Network Manager
     std::unique_ptr<NetworkManager> network_manager_;
 
-    // Track ObjectId cache: key = "album_id:track_title", value = track_object_id
-    std::unordered_map<std::string, uint32_t> track_objectid_cache_;
+    // Track ObjectId cache: album ObjectId -> (track title -> track ObjectId)
+    std::unordered_map<uint32_t, std::unordered_map<std::string, uint32_t>> track_objectid_cache_;
     mutable std::mutex track_cache_mutex_;
+
+    // Writes through CreatePlaylist / UpdatePlaylistTracks
+    zune::PlaylistStage playlist_stage_;
+
+    // Last member: destroyed first, while the session its operations use is still there
+    zune::AsyncExecutor async_executor_;
 };
@@ -0,0 +1,65 @@
+#include "ZuneDeviceProfile.h"
+#include "ZuneFileStore.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace zune {
+
+static constexpr char kProfileMagic[4] = {'X', 'Z', 'D', 'P'};
+static constexpr uint32_t kProfileVersion = 1;
+
+std::string DeviceProfile::FileName(const std::string& serial) {
+    return SerialFileName(serial, ".xzprofile");
+}
+
+bool DeviceProfile::Load(const std::string& directory, const std::string& serial, DeviceProfile& out) {
+    std::ifstream file(std::filesystem::path(directory) / FileName(serial), std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    BinaryReader r{data};
+    const uint8_t* magic = r.Take(sizeof(kProfileMagic));
+    if (!magic || std::memcmp(magic, kProfileMagic, sizeof(kProfileMagic)) != 0) return false;
+    if (r.Get(4) != kProfileVersion) return false;
+
+    DeviceProfile profile;
+    profile.serial = r.GetString();
+    if (!r.ok || profile.serial != serial) return false;
+    profile.firmware = r.GetString();
+    profile.identification = static_cast<uint32_t>(r.Get(4));
+    profile.capacity_bytes = r.Get(8);
+    uint32_t count = static_cast<uint32_t>(r.Get(4));
+    for (uint32_t i = 0; i < count && r.ok; i++) {
+        profile.storage_ids.push_back(static_cast<uint32_t>(r.Get(4)));
+    }
+    if (!r.ok || profile.storage_ids.empty()) return false;
+
+    out = std::move(profile);
+    return true;
+}
+
+bool DeviceProfile::Save(const std::string& directory) const {
+    if (serial.empty()) return false;
+
+    std::vector<uint8_t> out;
+    out.insert(out.end(), kProfileMagic, kProfileMagic + sizeof(kProfileMagic));
+    Put32(out, kProfileVersion);
+    PutString(out, serial);
+    PutString(out, firmware);
+    Put32(out, identification);
+    Put64(out, capacity_bytes);
+    Put32(out, static_cast<uint32_t>(storage_ids.size()));
+    for (uint32_t id : storage_ids) Put32(out, id);
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    const std::string path = (std::filesystem::path(directory) / FileName(serial)).string();
+    if (!WriteFileAtomic(path, out)) return false;
+    return true;
+}
+
+} // namespace zune
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zune {
+
+/// Host-side record of the parts of a device's identity that never change
+/// for a given firmware, one file per serial number, so a reconnect can
+/// take them from disk instead of asking the device again.
+///
+/// A profile is trusted only while it Matches() the connected device: same
+/// firmware (from DeviceInfo, which is read anyway to learn the serial) and
+/// the same 0xd21a identification value (one property read). A firmware
+/// update or a different unit with a recycled serial falls back to reading
+/// everything, which then replaces the file.
+///
+/// File layout (little-endian): "XZDP" magic, u32 format version,
+/// u32 serial length + bytes, u32 firmware length + bytes, u32 0xd21a value,
+/// u64 primary storage capacity, u32 storage ID count, then u32 storage IDs.
+struct DeviceProfile {
+    std::string serial;
+    std::string firmware;              // DeviceInfo DeviceVersion
+    uint32_t identification = 0;       // Raw 0xd21a: family and color
+    uint64_t capacity_bytes = 0;       // MaxCapacity of the first storage
+    std::vector<uint32_t> storage_ids;
+
+    /// Still describes the connected device
+    bool Matches(const std::string& device_firmware, uint32_t device_identification) const {
+        return firmware == device_firmware && identification == device_identification;
+    }
+
+    /// Read <directory>/<serial>.xzprofile; false if missing, truncated or
+    /// written for another serial
+    static bool Load(const std::string& directory, const std::string& serial, DeviceProfile& out);
+    /// Write <directory>/<serial>.xzprofile (temp file + rename)
+    bool Save(const std::string& directory) const;
+
+    /// File name of the profile for a serial number
+    static std::string FileName(const std::string& serial);
+};
+
+} // namespace zune
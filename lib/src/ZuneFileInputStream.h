@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ZuneFileSource.h"
+#include "ZuneTransferStats.h"
+#include <mtp/ptp/IObjectStream.h>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace zune {
+
+/// SendObject input stream over a FileSource. Replaces cli::ObjectInputStream
+/// for file uploads: the file is mapped (or read unbuffered) and each Read()
+/// the bulk writer issues is a single copy into its transfer buffer.
+/// With stats, each Read() also drives the device's progress callback;
+/// progress, if set, is called too, with the bytes read so far and the size.
+class FileInputStream : public mtp::IObjectInputStream {
+public:
+    using ProgressFn = std::function<void(uint64_t done, uint64_t total)>;
+
+    explicit FileInputStream(const std::string& path, TransferStats* stats = nullptr,
+                             ProgressFn progress = nullptr)
+        : stats_(stats), progress_(std::move(progress)), started_(TransferStats::Clock::now()) {
+        if (!source_.Open(path)) {
+            throw std::runtime_error("cannot open " + path);
+        }
+    }
+
+    mtp::u64 GetSize() const override { return source_.Size(); }
+
+    size_t Read(mtp::u8* data, size_t size) override {
+        size_t n = source_.Read(data, size);
+        if (stats_ && stats_->HasProgressCallback()) {
+            stats_->ReportProgress(ZUNE_TRANSFER_OP_SEND_OBJECT,
+                                   source_.Position(), source_.Size(), started_);
+        }
+        if (progress_) {
+            progress_(source_.Position(), source_.Size());
+        }
+        return n;
+    }
+
+    void Cancel() override {}
+
+private:
+    FileSource source_;
+    TransferStats* stats_;
+    ProgressFn progress_;
+    TransferStats::Clock::time_point started_;
+};
+
+} // namespace zune
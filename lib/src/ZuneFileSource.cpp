@@ -0,0 +1,153 @@
+#include "ZuneFileSource.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zune {
+
+FileSource::~FileSource() {
+    Close();
+}
+
+bool FileSource::Open(const std::string& path, bool allow_map) {
+    Close();
+#ifndef _WIN32
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        Close();
+        return false;
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+
+    if (allow_map && size_ > 0 && size_ <= SIZE_MAX) {
+        void* mapped = ::mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_SHARED, fd_, 0);
+        if (mapped != MAP_FAILED) {
+            mapped_ = static_cast<const uint8_t*>(mapped);
+            ::madvise(mapped, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+            // The mapping holds its own reference to the file
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+    if (!mapped_) {
+#if defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(F_RDAHEAD)
+        ::fcntl(fd_, F_RDAHEAD, 1);
+#endif
+    }
+#else
+    (void)allow_map;
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        return false;
+    }
+    // Reads go straight into the caller's buffer
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    if (_fseeki64(file_, 0, SEEK_END) != 0) {
+        Close();
+        return false;
+    }
+    size_ = static_cast<uint64_t>(_ftelli64(file_));
+    _fseeki64(file_, 0, SEEK_SET);
+#endif
+    open_ = true;
+    AdviseAround(0);
+    return true;
+}
+
+void FileSource::Close() {
+#ifndef _WIN32
+    if (mapped_) {
+        ::munmap(const_cast<uint8_t*>(mapped_), static_cast<size_t>(size_));
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#else
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+#endif
+    mapped_ = nullptr;
+    open_ = false;
+    size_ = 0;
+    position_ = 0;
+    advised_until_ = 0;
+    released_until_ = 0;
+}
+
+size_t FileSource::Read(uint8_t* dst, size_t n) {
+    if (!open_ || position_ >= size_) {
+        return 0;
+    }
+    n = static_cast<size_t>(std::min<uint64_t>(n, size_ - position_));
+
+    if (mapped_) {
+        std::memcpy(dst, mapped_ + position_, n);
+        position_ += n;
+        AdviseAround(position_);
+        return n;
+    }
+
+    size_t total = 0;
+#ifndef _WIN32
+    while (total < n) {
+        ssize_t got = ::read(fd_, dst + total, n - total);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        total += static_cast<size_t>(got);
+    }
+#else
+    total = std::fread(dst, 1, n, file_);
+#endif
+    position_ += total;
+    return total;
+}
+
+// Mapped files only: prefetch the next window once the cursor is halfway
+// through the current one, and drop the pages more than a window behind.
+void FileSource::AdviseAround(uint64_t position) {
+#ifndef _WIN32
+    if (!mapped_ || position + kReadaheadWindow / 2 < advised_until_ || advised_until_ >= size_) {
+        return;
+    }
+    static const uint64_t page = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    auto* base = const_cast<uint8_t*>(mapped_);
+
+    uint64_t ahead = advised_until_ - advised_until_ % page;
+    uint64_t ahead_end = std::min<uint64_t>(position + kReadaheadWindow, size_);
+    ::madvise(base + ahead, static_cast<size_t>(ahead_end - ahead), MADV_WILLNEED);
+    advised_until_ = ahead_end;
+
+    if (position > kReadaheadWindow) {
+        uint64_t behind = position - kReadaheadWindow;
+        behind -= behind % page;
+        if (behind > released_until_) {
+            ::madvise(base + released_until_, static_cast<size_t>(behind - released_until_), MADV_DONTNEED);
+            released_until_ = behind;
+        }
+    }
+#else
+    (void)position;
+#endif
+}
+
+} // namespace zune
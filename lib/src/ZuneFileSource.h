@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace zune {
+
+/// Sequential reader for SendObject payloads (tracks, video podcasts,
+/// audiobooks).
+///
+/// On POSIX the file is mapped read-only and Read() copies straight out of
+/// the page cache into the caller's buffer; the mapping is advised
+/// sequential, the window ahead of the cursor is prefetched and the window
+/// behind it is dropped, so a multi-hundred-MB file streams without holding
+/// its pages resident. Where mmap is unavailable (Windows, 32-bit builds
+/// with files over the address space, or allow_map = false) Read() issues
+/// unbuffered reads directly into the caller's buffer with a sequential
+/// readahead hint.
+///
+/// Either way there is no intermediate stdio buffer: each Read() is one
+/// copy from the kernel into the destination.
+class FileSource {
+public:
+    /// Bytes prefetched ahead of / released behind the read cursor
+    static constexpr size_t kReadaheadWindow = 8u << 20;
+
+    FileSource() = default;
+    ~FileSource();
+    FileSource(const FileSource&) = delete;
+    FileSource& operator=(const FileSource&) = delete;
+
+    /// @return false if the file cannot be opened
+    bool Open(const std::string& path, bool allow_map = true);
+    void Close();
+
+    bool IsOpen() const { return open_; }
+    bool IsMapped() const { return mapped_ != nullptr; }
+    uint64_t Size() const { return size_; }
+    uint64_t Position() const { return position_; }
+
+    /// The whole file, when mapped; nullptr otherwise
+    const uint8_t* Data() const { return mapped_; }
+
+    /// Copy up to n bytes from the cursor into dst.
+    /// @return Bytes copied; 0 at end of file or on a read error
+    size_t Read(uint8_t* dst, size_t n);
+
+private:
+    void AdviseAround(uint64_t position);
+
+    bool open_ = false;
+    uint64_t size_ = 0;
+    uint64_t position_ = 0;
+    const uint8_t* mapped_ = nullptr;
+    uint64_t advised_until_ = 0;   // End of the last prefetched window
+    uint64_t released_until_ = 0;  // Pages before this were dropped
+#ifndef _WIN32
+    int fd_ = -1;
+#else
+    std::FILE* file_ = nullptr;
+#endif
+};
+
+} // namespace zune
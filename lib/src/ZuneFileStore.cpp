@@ -0,0 +1,88 @@
+#include "ZuneFileStore.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <filesystem>
+#endif
+
+namespace zune {
+
+void PutN(std::vector<uint8_t>& out, uint64_t v, size_t width) {
+    for (size_t i = 0; i < width; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+void PutString(std::vector<uint8_t>& out, const std::string& s, size_t width) {
+    PutN(out, s.size(), width);
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+const uint8_t* BinaryReader::Take(size_t n) {
+    if (!ok || pos > end || end - pos < n) {
+        ok = false;
+        return nullptr;
+    }
+    const uint8_t* p = data.data() + pos;
+    pos += n;
+    return p;
+}
+
+uint64_t BinaryReader::Get(size_t width) {
+    const uint8_t* p = Take(width);
+    uint64_t v = 0;
+    for (size_t i = 0; p && i < width; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+std::string BinaryReader::GetString(size_t width) {
+    size_t size = static_cast<size_t>(Get(width));
+    const uint8_t* p = Take(size);
+    return p ? std::string(reinterpret_cast<const char*>(p), size) : std::string();
+}
+
+namespace {
+
+bool RenameOver(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    // rename() refuses an existing target on Windows
+    return MoveFileExW(std::filesystem::path(from).c_str(), std::filesystem::path(to).c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    // rename(2) replaces the target atomically
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+} // namespace
+
+bool WriteFileAtomic(const std::string& path, const uint8_t* data, size_t size) {
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        file.close();
+        if (!file) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (!RenameOver(tmp_path, path)) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string SerialFileName(const std::string& serial, const char* extension) {
+    std::string name = serial;
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+            c = '_';
+    }
+    return name + extension;
+}
+
+} // namespace zune
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zune {
+
+// Shared plumbing for the little on-disk formats kept between sessions
+// (descriptor cache, sync journal, content index, scanner cache, device
+// profiles, XNA manifests, metadata cache). All integers are little-endian.
+
+static constexpr uint32_t kFnv1a32Offset = 2166136261u;
+static constexpr uint32_t kFnv1a32Prime = 16777619u;
+static constexpr uint64_t kFnv1a64Offset = 14695981039346656037ull;
+static constexpr uint64_t kFnv1a64Prime = 1099511628211ull;
+
+/// FNV-1a of the bytes, continuing from hash (checksums, content keys)
+inline uint32_t Fnv1a32(const uint8_t* data, size_t size, uint32_t hash = kFnv1a32Offset) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= kFnv1a32Prime;
+    }
+    return hash;
+}
+
+inline uint64_t Fnv1a64(const uint8_t* data, size_t size, uint64_t hash = kFnv1a64Offset) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= kFnv1a64Prime;
+    }
+    return hash;
+}
+
+/// Append the low width bytes of v
+void PutN(std::vector<uint8_t>& out, uint64_t v, size_t width);
+inline void Put32(std::vector<uint8_t>& out, uint32_t v) { PutN(out, v, 4); }
+inline void Put64(std::vector<uint8_t>& out, uint64_t v) { PutN(out, v, 8); }
+
+/// Append s behind a width-byte length
+void PutString(std::vector<uint8_t>& out, const std::string& s, size_t width = 4);
+
+/// Bounds-checked reads of data[pos, end); any overrun marks the reader
+/// bad and later reads return nothing, so a parser can check ok once at
+/// the end.
+struct BinaryReader {
+    const std::vector<uint8_t>& data;
+    size_t end;
+    size_t pos = 0;
+    bool ok = true;
+
+    explicit BinaryReader(const std::vector<uint8_t>& data) : data(data), end(data.size()) {}
+    BinaryReader(const std::vector<uint8_t>& data, size_t end, size_t pos = 0)
+        : data(data), end(end), pos(pos) {}
+
+    /// Next n bytes, or nullptr past the end
+    const uint8_t* Take(size_t n);
+    uint64_t Get(size_t width);
+    std::string GetString(size_t width = 4);
+};
+
+/// Replace path with data. The bytes go to a sibling temp file that is
+/// then renamed over path, so a crash leaves the old file or the new one,
+/// never a torn mix. The temp file is removed on failure.
+bool WriteFileAtomic(const std::string& path, const uint8_t* data, size_t size);
+inline bool WriteFileAtomic(const std::string& path, const std::vector<uint8_t>& data) {
+    return WriteFileAtomic(path, data.data(), data.size());
+}
+
+/// File name for per-device state: serial + extension, with anything but
+/// letters, digits, '-' and '_' replaced by '_'. Serials are alphanumeric
+/// in practice; this keeps the name safe regardless.
+std::string SerialFileName(const std::string& serial, const char* extension);
+
+} // namespace zune
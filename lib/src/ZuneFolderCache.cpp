@@ -0,0 +1,104 @@
+#include "ZuneFolderCache.h"
+#include <algorithm>
+
+namespace zune {
+
+bool FolderCache::GetRoot(RootDiscoveryResult& root) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_root_) {
+        stats_.misses++;
+        return false;
+    }
+    stats_.hits++;
+    root = root_;
+    return true;
+}
+
+void FolderCache::SetRoot(const RootDiscoveryResult& root) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    root_ = root;
+    has_root_ = true;
+}
+
+bool FolderCache::GetChildren(uint32_t folder, std::vector<FolderChild>& children) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = children_.find(folder);
+    if (it == children_.end()) {
+        stats_.misses++;
+        return false;
+    }
+    stats_.hits++;
+    children = it->second;
+    return true;
+}
+
+void FolderCache::SetChildren(uint32_t folder, const std::vector<FolderChild>& children) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    children_[folder] = children;
+}
+
+uint32_t FolderCache::Find(uint32_t folder, const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = children_.find(folder);
+    if (it == children_.end()) return 0;
+    for (const auto& child : it->second) {
+        if (child.name == name) return child.handle;
+    }
+    return 0;
+}
+
+void FolderCache::FolderCreated(uint32_t parent, const std::string& name, uint32_t handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (parent == 0) {
+        // A root folder changes what DiscoverRoot would report
+        has_root_ = false;
+    } else {
+        auto it = children_.find(parent);
+        if (it != children_.end()) it->second.push_back({name, handle});
+    }
+    children_[handle].clear();
+}
+
+void FolderCache::ObjectDeleted(uint32_t handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [folder, children] : children_) {
+        children.erase(std::remove_if(children.begin(), children.end(),
+                                      [&](const FolderChild& c) { return c.handle == handle; }),
+                       children.end());
+    }
+    // Deleting a folder deletes what it held; those handles are never reused
+    // within a session, so their listings are left to be forgotten on Clear()
+    children_.erase(handle);
+    read_back_.erase(handle);
+    if (has_root_ &&
+        (handle == root_.music_folder || handle == root_.albums_folder ||
+         handle == root_.artists_folder || handle == root_.playlists_folder ||
+         handle == root_.series_folder || handle == root_.podcasts_folder)) {
+        has_root_ = false;
+    }
+}
+
+void FolderCache::Invalidate(uint32_t folder) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    children_.erase(folder);
+}
+
+bool FolderCache::MarkReadBack(uint32_t folder) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return read_back_.insert(folder).second;
+}
+
+void FolderCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    has_root_ = false;
+    root_ = {};
+    children_.clear();
+    read_back_.clear();
+}
+
+FolderCache::Stats FolderCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace zune
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ZuneMtpWriterTypes.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace zune {
+
+/// Session-scoped record of the device's folder tree, as MtpWriter has
+/// discovered it.
+///
+/// A multi-album upload asks again and again whether Music/<Artist> or an
+/// album folder exists, and every DiscoverRoot / DiscoverFolderChildren
+/// replays Zune Desktop's three-operation listing to answer. With a cache,
+/// MtpWriter answers from the names it parsed the first time, adds folders
+/// it creates and drops objects it deletes, so a lookup of a known folder
+/// costs no USB transactions. FolderReadback is also sent only once per
+/// folder.
+///
+/// Only changes made through MtpWriter with the cache are seen. Callers
+/// creating other objects in a cached folder call Invalidate() for it;
+/// anything else that may have changed the tree (another session, a
+/// reconnect) calls Clear(). Thread-safe.
+class FolderCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;      // Listings answered without the device
+        uint64_t misses = 0;    // Listings read from the device
+    };
+
+    /// Root folders from an earlier DiscoverRoot; false if not known
+    bool GetRoot(RootDiscoveryResult& root);
+    void SetRoot(const RootDiscoveryResult& root);
+
+    /// Children of folder from an earlier listing; false if not known
+    bool GetChildren(uint32_t folder, std::vector<FolderChild>& children);
+    void SetChildren(uint32_t folder, const std::vector<FolderChild>& children);
+
+    /// Handle of a child named name in a listed folder, 0 if unknown
+    uint32_t Find(uint32_t folder, const std::string& name) const;
+
+    /// A folder created in parent (0 = root): added to parent's listing,
+    /// and known to be empty itself
+    void FolderCreated(uint32_t parent, const std::string& name, uint32_t handle);
+    /// An object deleted: dropped from every listing, with its own
+    void ObjectDeleted(uint32_t handle);
+    /// Forget folder's listing; the next lookup reads the device
+    void Invalidate(uint32_t folder);
+
+    /// True the first time folder is read back this session
+    bool MarkReadBack(uint32_t folder);
+
+    void Clear();
+    Stats GetStats() const;
+
+private:
+    mutable std::mutex mutex_;
+    bool has_root_ = false;
+    RootDiscoveryResult root_;
+    std::unordered_map<uint32_t, std::vector<FolderChild>> children_;
+    std::unordered_set<uint32_t> read_back_;
+    Stats stats_;
+};
+
+} // namespace zune
@@ -0,0 +1,78 @@
+#include "ZuneLibraryIndex.h"
+
+namespace zune {
+
+ZuneIndexRange LibraryIndex::Grouping::Find(uint32_t key) const {
+    auto it = ranges.find(key);
+    if (it == ranges.end()) {
+        return ZuneIndexRange{nullptr, 0};
+    }
+    return ZuneIndexRange{indices.data() + it->second.first, it->second.second};
+}
+
+// Counting sort on key: count per key, assign each key its slice in
+// first-seen order, then place records so each slice keeps device order.
+template <typename Record, typename KeyFn>
+LibraryIndex::Grouping LibraryIndex::Group(const Record* records, uint32_t count, KeyFn key) {
+    Grouping grouping;
+
+    std::vector<uint32_t> order;  // Distinct keys, first-seen
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t k = key(records[i]);
+        if (k == 0) continue;
+        auto [it, inserted] = grouping.ranges.try_emplace(k, 0, 0);
+        if (inserted) order.push_back(k);
+        it->second.second++;
+    }
+
+    uint32_t next = 0;
+    for (uint32_t k : order) {
+        auto& range = grouping.ranges[k];
+        range.first = next;
+        next += range.second;
+        range.second = 0;  // Refilled below as the fill cursor
+    }
+
+    grouping.indices.resize(next);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t k = key(records[i]);
+        if (k == 0) continue;
+        auto& range = grouping.ranges[k];
+        grouping.indices[range.first + range.second++] = i;
+    }
+    return grouping;
+}
+
+LibraryIndex::LibraryIndex(const ZuneMusicLibrary& library)
+    : tracks_by_album_(Group(library.tracks, library.track_count,
+                             [](const ZuneMusicTrack& t) { return t.album_ref; })),
+      albums_by_artist_(Group(library.albums, library.album_count,
+                              [](const ZuneMusicAlbum& a) { return a.artist_ref; })),
+      tracks_by_genre_(Group(library.tracks, library.track_count,
+                             [](const ZuneMusicTrack& t) { return t.genre_ref; }))
+{
+    track_by_atom_.reserve(library.track_count);
+    for (uint32_t i = 0; i < library.track_count; i++) {
+        // First record wins, matching a front-to-back scan
+        track_by_atom_.emplace(library.tracks[i].atom_id, i);
+    }
+}
+
+ZuneIndexRange LibraryIndex::TracksForAlbum(uint32_t album_atom_id) const {
+    return tracks_by_album_.Find(album_atom_id);
+}
+
+ZuneIndexRange LibraryIndex::AlbumsForArtist(uint32_t artist_atom_id) const {
+    return albums_by_artist_.Find(artist_atom_id);
+}
+
+ZuneIndexRange LibraryIndex::TracksForGenre(uint32_t genre_atom_id) const {
+    return tracks_by_genre_.Find(genre_atom_id);
+}
+
+int32_t LibraryIndex::FindTrackByAtom(uint32_t atom_id) const {
+    auto it = track_by_atom_.find(atom_id);
+    return it != track_by_atom_.end() ? static_cast<int32_t>(it->second) : -1;
+}
+
+} // namespace zune
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "xune_sync/xune_sync_api.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+/// Lookup indexes over a ZuneMusicLibrary: tracks of an album, albums of an
+/// artist, tracks of a genre, and track by atom_id.
+///
+/// Built in one O(n) pass per grouping. Each grouping stores the record
+/// indices bucketed by key (keeping device order within a bucket), so a
+/// query is one hash lookup returning a range of that array; no records are
+/// copied. Indices refer to the arrays of the library the index was built
+/// from, which works the same for strdup, packed and loaded libraries.
+///
+/// Records whose reference is 0 (no album / genre / artist) are not indexed.
+/// The index keeps no pointer into the library, but its indices are only
+/// meaningful while that library is unchanged.
+class LibraryIndex {
+public:
+    explicit LibraryIndex(const ZuneMusicLibrary& library);
+
+    ZuneIndexRange TracksForAlbum(uint32_t album_atom_id) const;
+    ZuneIndexRange AlbumsForArtist(uint32_t artist_atom_id) const;
+    ZuneIndexRange TracksForGenre(uint32_t genre_atom_id) const;
+
+    /// @return Index into library.tracks, or -1 if no track has atom_id
+    int32_t FindTrackByAtom(uint32_t atom_id) const;
+
+private:
+    // Record indices bucketed by key; ranges[key] = (first, count) into indices
+    struct Grouping {
+        std::vector<uint32_t> indices;
+        std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> ranges;
+
+        ZuneIndexRange Find(uint32_t key) const;
+    };
+
+    template <typename Record, typename KeyFn>
+    static Grouping Group(const Record* records, uint32_t count, KeyFn key);
+
+    Grouping tracks_by_album_;
+    Grouping albums_by_artist_;
+    Grouping tracks_by_genre_;
+    std::unordered_map<uint32_t, uint32_t> track_by_atom_;
+};
+
+} // namespace zune
@@ -0,0 +1,410 @@
+#include "ZuneLibraryModel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <new>
+#include <utility>
+
+namespace zune {
+
+namespace {
+
+// "YYYYMMDDTHHMMSS.0" -> YYYY, 0 if absent or malformed
+int YearFromDateAuthored(const std::string& date_authored) {
+    if (date_authored.size() < 4) return 0;
+    int year = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(date_authored[i]))) return 0;
+        year = year * 10 + (date_authored[i] - '0');
+    }
+    return year;
+}
+
+// Same .alb filename MtpWriter::CreateAlbumMetadata gives the album object
+std::string AlbReference(const AlbumProperties& props) {
+    return props.artist + "--" + props.album_name + ".alb";
+}
+
+} // namespace
+
+// ── Lifecycle ────────────────────────────────────────────────────────────
+
+void LibraryModel::Reset(zmdb::ZMDBLibrary library, AlbumArtworkMap alb_to_objectid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    library_ = std::move(library);
+    alb_to_objectid_ = std::move(alb_to_objectid);
+    seeded_ = true;
+
+    track_index_.clear();
+    for (int i = 0; i < library_.track_count; ++i)
+        track_index_[library_.tracks[i].atom_id] = i;
+
+    changed_tracks_.clear();
+    changed_albums_.clear();
+    changed_artists_.clear();
+    removed_.clear();
+}
+
+void LibraryModel::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    library_ = zmdb::ZMDBLibrary();
+    alb_to_objectid_.clear();
+    track_index_.clear();
+    seeded_ = false;
+
+    changed_tracks_.clear();
+    changed_albums_.clear();
+    changed_artists_.clear();
+    removed_.clear();
+}
+
+bool LibraryModel::HasLibrary() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return seeded_;
+}
+
+// ── Writes ───────────────────────────────────────────────────────────────
+
+void LibraryModel::TrackCreated(
+    uint32_t track_id, const TrackProperties& props,
+    uint16_t format_code, uint64_t file_size)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_ || track_id == 0) return;
+
+    if (zmdb::ZMDBTrack* existing = FindTrack(track_id)) {
+        ApplyTrackFields(*existing, props);
+        changed_tracks_.insert(track_id);
+        return;
+    }
+
+    zmdb::ZMDBTrack track;
+    track.atom_id = track_id;
+    track.codec_id = format_code;
+    track.file_size_bytes = static_cast<int>(std::min<uint64_t>(file_size, INT_MAX));
+    if (props.rating >= 0) track.rating = static_cast<uint8_t>(props.rating);
+    if (props.play_count > 0) track.playcount = static_cast<uint16_t>(props.play_count);
+    ApplyTrackFields(track, props);
+
+    // The device files the track under an existing album with the same
+    // name; a new album is linked later through AlbumReferencesSet.
+    const std::string& album_artist = props.album_artist.empty() ? props.artist : props.album_artist;
+    if (uint32_t album_atom = FindAlbumByName(props.album_name, album_artist)) {
+        track.album_ref = album_atom;
+        track.album_alb_ref = library_.strings.intern(library_.album_metadata[album_atom].alb_reference);
+    }
+
+    AppendTrack(std::move(track));
+    changed_tracks_.insert(track_id);
+}
+
+void LibraryModel::TrackPropertiesUpdated(uint32_t track_id, const TrackProperties& props) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_) return;
+
+    zmdb::ZMDBTrack* track = FindTrack(track_id);
+    if (!track) return;
+
+    ApplyTrackFields(*track, props);
+    changed_tracks_.insert(track_id);
+}
+
+size_t LibraryModel::UserStatesRead(const std::vector<TrackUserState>& states) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_) return 0;
+
+    size_t changed = 0;
+    for (const TrackUserState& state : states) {
+        zmdb::ZMDBTrack* track = FindTrack(state.object_id);
+        if (!track) continue;
+        bool differs = false;
+        if (state.play_count >= 0 && track->playcount != static_cast<uint16_t>(state.play_count)) {
+            track->playcount = static_cast<uint16_t>(state.play_count);
+            differs = true;
+        }
+        if (state.rating >= 0 && track->rating != static_cast<uint8_t>(state.rating)) {
+            track->rating = static_cast<uint8_t>(state.rating);
+            differs = true;
+        }
+        if (differs) {
+            changed_tracks_.insert(state.object_id);
+            changed++;
+        }
+    }
+    return changed;
+}
+
+void LibraryModel::AlbumCreated(uint32_t album_id, const AlbumProperties& props) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_ || album_id == 0) return;
+
+    zmdb::ZMDBAlbum album;
+    album.title = props.album_name;
+    album.artist_name = props.artist;
+    album.release_year = YearFromDateAuthored(props.date_authored);
+    album.alb_reference = AlbReference(props);
+    album.atom_id = album_id;
+    album.artist_ref = (props.is_hd && props.artist_meta_id != 0)
+        ? props.artist_meta_id
+        : FindArtistByName(props.artist);
+
+    auto artist = library_.artist_metadata.find(album.artist_ref);
+    if (artist != library_.artist_metadata.end())
+        album.artist_guid = artist->second.guid;
+
+    alb_to_objectid_[album.alb_reference] = album_id;
+    library_.album_metadata[album_id] = std::move(album);
+    library_.album_count = static_cast<int>(library_.album_metadata.size());
+    changed_albums_.insert(album_id);
+}
+
+void LibraryModel::AlbumPropertiesUpdated(uint32_t album_id, const AlbumProperties& props) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_) return;
+
+    uint32_t atom = ResolveAlbumAtom(album_id);
+    if (atom == 0) return;
+
+    // The .alb filename is fixed at creation; only the editable fields change
+    zmdb::ZMDBAlbum& album = library_.album_metadata[atom];
+    album.title = props.album_name;
+    album.artist_name = props.artist;
+    if (props.is_hd) {
+        album.release_year = YearFromDateAuthored(props.date_authored);
+        album.artist_ref = props.artist_meta_id;
+    }
+    changed_albums_.insert(atom);
+}
+
+void LibraryModel::AlbumReferencesSet(uint32_t album_id, const uint32_t* track_ids, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_ || !track_ids) return;
+
+    uint32_t atom = ResolveAlbumAtom(album_id);
+    if (atom == 0) return;
+
+    zmdb::SharedString alb_ref = library_.strings.intern(library_.album_metadata[atom].alb_reference);
+    for (size_t i = 0; i < count; ++i) {
+        zmdb::ZMDBTrack* track = FindTrack(track_ids[i]);
+        if (!track) continue;
+        track->album_ref = atom;
+        track->album_alb_ref = alb_ref;
+        changed_tracks_.insert(track_ids[i]);
+    }
+}
+
+void LibraryModel::ArtistCreated(uint32_t artist_id, const std::string& name, const std::string& guid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_ || artist_id == 0) return;
+
+    zmdb::ZMDBArtist artist;
+    artist.name = name;
+    artist.filename = name + ".art";  // As MtpWriter::CreateArtistMetadata names it
+    artist.guid = guid;
+    artist.atom_id = artist_id;
+
+    library_.artist_metadata[artist_id] = std::move(artist);
+    library_.artist_count = static_cast<int>(library_.artist_metadata.size());
+    changed_artists_.insert(artist_id);
+}
+
+void LibraryModel::ObjectDeleted(uint32_t object_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_ || object_id == 0) return;
+
+    if (track_index_.count(object_id)) {
+        RemoveTrack(object_id);
+        MarkRemoved(object_id);
+        return;
+    }
+
+    if (uint32_t atom = ResolveAlbumAtom(object_id)) {
+        library_.album_metadata.erase(atom);
+        library_.album_count = static_cast<int>(library_.album_metadata.size());
+        for (auto it = alb_to_objectid_.begin(); it != alb_to_objectid_.end();) {
+            it = (it->second == object_id) ? alb_to_objectid_.erase(it) : std::next(it);
+        }
+        MarkRemoved(atom);
+        return;
+    }
+
+    if (library_.artist_metadata.erase(object_id)) {
+        library_.artist_count = static_cast<int>(library_.artist_metadata.size());
+        MarkRemoved(object_id);
+    }
+}
+
+// ── Reads ────────────────────────────────────────────────────────────────
+
+bool LibraryModel::Visit(
+    const std::function<void(const zmdb::ZMDBLibrary&, const AlbumArtworkMap&)>& fn) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_) return false;
+    fn(library_, alb_to_objectid_);
+    return true;
+}
+
+bool LibraryModel::TakeDelta(LibraryDelta& delta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!seeded_) return false;
+
+    zmdb::ZMDBLibrary changed;
+    changed.device_family = library_.device_family;
+
+    if (!changed_tracks_.empty()) {
+        changed.tracks_capacity = static_cast<int>(changed_tracks_.size());
+        changed.tracks = static_cast<zmdb::ZMDBTrack*>(
+            ::operator new[](changed.tracks_capacity * sizeof(zmdb::ZMDBTrack)));
+        for (uint32_t atom_id : changed_tracks_) {
+            if (const zmdb::ZMDBTrack* track = FindTrack(atom_id)) {
+                new (&changed.tracks[changed.track_count]) zmdb::ZMDBTrack(*track);
+                changed.track_count++;
+            }
+        }
+    }
+
+    AlbumArtworkMap artworks;
+    for (uint32_t atom_id : changed_albums_) {
+        auto it = library_.album_metadata.find(atom_id);
+        if (it == library_.album_metadata.end()) continue;
+        changed.album_metadata.emplace(atom_id, it->second);
+        auto artwork = alb_to_objectid_.find(it->second.alb_reference);
+        if (artwork != alb_to_objectid_.end())
+            artworks.emplace(artwork->first, artwork->second);
+    }
+    changed.album_count = static_cast<int>(changed.album_metadata.size());
+
+    for (uint32_t atom_id : changed_artists_) {
+        auto it = library_.artist_metadata.find(atom_id);
+        if (it != library_.artist_metadata.end())
+            changed.artist_metadata.emplace(atom_id, it->second);
+    }
+    changed.artist_count = static_cast<int>(changed.artist_metadata.size());
+
+    delta.changed = std::move(changed);
+    delta.alb_to_objectid = std::move(artworks);
+    delta.removed = std::move(removed_);
+
+    changed_tracks_.clear();
+    changed_albums_.clear();
+    changed_artists_.clear();
+    removed_.clear();
+    return true;
+}
+
+// ── Helpers (mutex_ held) ────────────────────────────────────────────────
+
+zmdb::ZMDBTrack* LibraryModel::FindTrack(uint32_t track_id) {
+    auto it = track_index_.find(track_id);
+    return it != track_index_.end() ? &library_.tracks[it->second] : nullptr;
+}
+
+uint32_t LibraryModel::ResolveAlbumAtom(uint32_t album_object_id) const {
+    if (album_object_id == 0) return 0;
+
+    // Albums created through the model are keyed by their object handle
+    if (library_.album_metadata.count(album_object_id))
+        return album_object_id;
+
+    // Parsed albums: .alb object handle -> .alb filename -> album
+    for (const auto& [alb_reference, object_id] : alb_to_objectid_) {
+        if (object_id != album_object_id) continue;
+        for (const auto& [atom_id, album] : library_.album_metadata) {
+            if (album.alb_reference == alb_reference)
+                return atom_id;
+        }
+    }
+    return 0;
+}
+
+uint32_t LibraryModel::FindAlbumByName(const std::string& title, const std::string& artist) const {
+    if (title.empty()) return 0;
+    for (const auto& [atom_id, album] : library_.album_metadata) {
+        if (album.title == title && album.artist_name == artist)
+            return atom_id;
+    }
+    return 0;
+}
+
+uint32_t LibraryModel::FindArtistByName(const std::string& name) const {
+    if (name.empty()) return 0;
+    for (const auto& [atom_id, artist] : library_.artist_metadata) {
+        if (artist.name == name)
+            return atom_id;
+    }
+    return 0;
+}
+
+uint32_t LibraryModel::FindGenreByName(const std::string& name) const {
+    if (name.empty()) return 0;
+    for (const auto& [atom_id, genre] : library_.genre_metadata) {
+        if (genre.name == name)
+            return atom_id;
+    }
+    return 0;
+}
+
+// Fields MtpWriter::CreateTrack and UpdateTrackProperties both write
+void LibraryModel::ApplyTrackFields(zmdb::ZMDBTrack& track, const TrackProperties& props) {
+    track.title = props.title;
+    track.artist_name = library_.strings.intern(props.artist);
+    track.genre = library_.strings.intern(props.genre);
+    track.genre_ref = FindGenreByName(props.genre);
+    track.track_number = props.track_number;
+    track.duration_ms = static_cast<int>(props.duration_ms);
+    if (props.is_hd)
+        track.disc_number = props.disc_number > 0 ? static_cast<int>(props.disc_number) : 1;
+
+    uint32_t artist_atom = (props.is_hd && props.artist_meta_id != 0)
+        ? props.artist_meta_id
+        : FindArtistByName(props.artist);
+    auto artist = library_.artist_metadata.find(artist_atom);
+    track.artist_guid = artist != library_.artist_metadata.end()
+        ? library_.strings.intern(artist->second.guid)
+        : zmdb::SharedString();
+}
+
+void LibraryModel::AppendTrack(zmdb::ZMDBTrack&& track) {
+    if (library_.track_count == library_.tracks_capacity) {
+        int capacity = std::max(16, library_.tracks_capacity * 2);
+        auto* grown = static_cast<zmdb::ZMDBTrack*>(::operator new[](capacity * sizeof(zmdb::ZMDBTrack)));
+        for (int i = 0; i < library_.track_count; ++i) {
+            new (&grown[i]) zmdb::ZMDBTrack(std::move(library_.tracks[i]));
+            library_.tracks[i].~ZMDBTrack();
+        }
+        if (library_.tracks)
+            ::operator delete[](library_.tracks);
+        library_.tracks = grown;
+        library_.tracks_capacity = capacity;
+    }
+
+    track_index_[track.atom_id] = library_.track_count;
+    new (&library_.tracks[library_.track_count]) zmdb::ZMDBTrack(std::move(track));
+    library_.track_count++;
+}
+
+// Keeps the remaining tracks in device order
+void LibraryModel::RemoveTrack(uint32_t track_id) {
+    auto it = track_index_.find(track_id);
+    if (it == track_index_.end()) return;
+
+    int index = it->second;
+    track_index_.erase(it);
+    for (int i = index; i + 1 < library_.track_count; ++i) {
+        library_.tracks[i] = std::move(library_.tracks[i + 1]);
+        track_index_[library_.tracks[i].atom_id] = i;
+    }
+    library_.tracks[library_.track_count - 1].~ZMDBTrack();
+    library_.track_count--;
+}
+
+void LibraryModel::MarkRemoved(uint32_t atom_id) {
+    changed_tracks_.erase(atom_id);
+    changed_albums_.erase(atom_id);
+    changed_artists_.erase(atom_id);
+    removed_.push_back(atom_id);
+}
+
+} // namespace zune
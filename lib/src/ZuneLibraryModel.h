@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ * ZuneLibraryModel — Host-side copy of the device library, kept current
+ * across uploads without re-reading the ZMDB.
+ *
+ * Seeded with the parsed library from a full read, then told about every
+ * MtpWriter operation that succeeded (new tracks, albums and artists,
+ * property updates, album references, deletions). Each change is applied in
+ * place and remembered, so callers can fetch either the whole updated
+ * library or just what changed since the last delta.
+ *
+ * Identity follows the device: ZMDB track, artist and podcast atom_ids are
+ * MTP object handles, so new records use the handle MtpWriter returned. A
+ * new album is keyed by its .alb object handle until the next full read
+ * assigns the ZMDB album atom. Existing albums are matched to their .alb
+ * handle through the artwork map.
+ *
+ * Every method is a no-op until Reset() has seeded the model. All methods
+ * are thread-safe.
+ */
+
+#include "zmdb/ZMDBTypes.h"
+#include "ZuneMtpWriterTypes.h"
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+// Records added or changed since the model was seeded or the last delta
+struct LibraryDelta {
+    zmdb::ZMDBLibrary changed;                                 // Tracks, albums and artists (current values)
+    std::unordered_map<std::string, uint32_t> alb_to_objectid; // Artwork entries for new albums
+    std::vector<uint32_t> removed;                             // atom_ids of deleted records
+};
+
+class LibraryModel {
+public:
+    using AlbumArtworkMap = std::unordered_map<std::string, uint32_t>;
+
+    // --- Lifecycle ---
+    // Replace the model with a freshly parsed library and its .alb -> ObjectId map.
+    // Discards any pending delta.
+    void Reset(zmdb::ZMDBLibrary library, AlbumArtworkMap alb_to_objectid);
+    void Clear();
+    bool HasLibrary() const;
+
+    // --- Writes (call after the MtpWriter operation succeeded) ---
+    void TrackCreated(uint32_t track_id, const TrackProperties& props,
+                      uint16_t format_code, uint64_t file_size);
+    void TrackPropertiesUpdated(uint32_t track_id, const TrackProperties& props);
+    void AlbumCreated(uint32_t album_id, const AlbumProperties& props);
+    void AlbumPropertiesUpdated(uint32_t album_id, const AlbumProperties& props);
+    void AlbumReferencesSet(uint32_t album_id, const uint32_t* track_ids, size_t count);
+    void ArtistCreated(uint32_t artist_id, const std::string& name, const std::string& guid);
+    void ObjectDeleted(uint32_t object_id);
+    // Play counts and ratings read back from the device, matched by atom_id;
+    // -1 values and unknown objects are ignored. Returns tracks changed.
+    size_t UserStatesRead(const std::vector<TrackUserState>& states);
+
+    // --- Reads ---
+    // Run fn on the current library under the model lock.
+    // Returns false (without calling fn) if the model has not been seeded.
+    bool Visit(const std::function<void(const zmdb::ZMDBLibrary&, const AlbumArtworkMap&)>& fn) const;
+
+    // Move the pending changes into delta and start a new one.
+    // Returns false if the model has not been seeded.
+    bool TakeDelta(LibraryDelta& delta);
+
+private:
+    zmdb::ZMDBTrack* FindTrack(uint32_t track_id);
+    uint32_t ResolveAlbumAtom(uint32_t album_object_id) const;
+    uint32_t FindAlbumByName(const std::string& title, const std::string& artist) const;
+    uint32_t FindArtistByName(const std::string& name) const;
+    uint32_t FindGenreByName(const std::string& name) const;
+    void ApplyTrackFields(zmdb::ZMDBTrack& track, const TrackProperties& props);
+    void AppendTrack(zmdb::ZMDBTrack&& track);
+    void RemoveTrack(uint32_t track_id);
+    void MarkRemoved(uint32_t atom_id);
+
+    mutable std::mutex mutex_;
+    bool seeded_ = false;
+    zmdb::ZMDBLibrary library_;
+    AlbumArtworkMap alb_to_objectid_;
+    std::unordered_map<uint32_t, int> track_index_;  // atom_id -> index into library_.tracks
+
+    // Pending delta
+    std::set<uint32_t> changed_tracks_;
+    std::set<uint32_t> changed_albums_;
+    std::set<uint32_t> changed_artists_;
+    std::vector<uint32_t> removed_;
+};
+
+} // namespace zune
@@ -0,0 +1,137 @@
+#include "ZuneLog.h"
+
+namespace zune {
+
+Logger::Logger() {
+    for (auto& level : levels_) {
+        level.store(ZUNE_LOG_INFO, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void Logger::SetSink(Sink sink) {
+    bool on_delivery_thread;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        on_delivery_thread = thread_.joinable() && thread_.get_id() == std::this_thread::get_id();
+    }
+    has_sink_.store(static_cast<bool>(sink), std::memory_order_relaxed);
+    if (on_delivery_thread) {
+        sink_ = std::move(sink);  // sink_mutex_ is already held by Run; used from its next batch
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    sink_ = std::move(sink);
+}
+
+void Logger::SetLevel(ZuneLogCategory category, ZuneLogLevel level) {
+    if (category < 0 || category >= ZUNE_LOG_CATEGORY_COUNT) return;
+    levels_[category].store(level, std::memory_order_relaxed);
+}
+
+void Logger::SetLevel(ZuneLogLevel level) {
+    for (auto& l : levels_) {
+        l.store(level, std::memory_order_relaxed);
+    }
+}
+
+ZuneLogLevel Logger::GetLevel(ZuneLogCategory category) const {
+    if (category < 0 || category >= ZUNE_LOG_CATEGORY_COUNT) return ZUNE_LOG_INFO;
+    return static_cast<ZuneLogLevel>(levels_[category].load(std::memory_order_relaxed));
+}
+
+void Logger::Write(ZuneLogCategory, ZuneLogLevel, const char* source, std::string message) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        if (queue_.size() >= kMaxQueued) {
+            stats_.dropped++;
+            dropped_unreported_++;
+            return;
+        }
+        queue_.push_back(Line{source, std::move(message)});
+        stats_.written++;
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&Logger::Run, this);
+        }
+        wake = waiting_;
+    }
+    // Only a sleeping delivery thread needs the syscall
+    if (wake) {
+        cv_.notify_one();
+    }
+}
+
+void Logger::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (thread_.joinable() && thread_.get_id() == std::this_thread::get_id()) {
+        return;  // From the sink: the lines before this one are out already
+    }
+    idle_cv_.wait(lock, [this] { return queue_.empty() && !delivering_; });
+}
+
+Logger::Stats Logger::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void Logger::Run() {
+    std::deque<Line> batch;
+    for (;;) {
+        uint64_t dropped;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            delivering_ = false;
+            if (queue_.empty()) {
+                idle_cv_.notify_all();
+                if (stop_) return;
+                waiting_ = true;
+                cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                waiting_ = false;
+                if (queue_.empty()) return;  // Stopping with nothing left
+            }
+            batch.swap(queue_);
+            dropped = dropped_unreported_;
+            dropped_unreported_ = 0;
+            delivering_ = true;
+        }
+
+        uint64_t delivered = 0;
+        {
+            std::lock_guard<std::mutex> lock(sink_mutex_);
+            // A copy, so a sink replacing itself is not destroyed while it runs
+            Sink sink = sink_;
+            std::string text;
+            for (const Line& line : batch) {
+                if (!sink) break;
+                if (line.source) {
+                    text.assign("[").append(line.source).append("] ").append(line.message);
+                    sink(text);
+                } else {
+                    sink(line.message);
+                }
+                delivered++;
+            }
+            if (dropped > 0 && sink) {
+                sink("[log] " + std::to_string(dropped) + " lines dropped, the log callback fell behind");
+            }
+        }
+        batch.clear();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.delivered += delivered;
+    }
+}
+
+} // namespace zune
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "xune_sync/xune_sync_api.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace zune {
+
+/// Per-device log with a level per category and asynchronous delivery.
+///
+/// Callers check IsEnabled before building a line (ZUNE_LOG does this), so a
+/// disabled level costs one relaxed load and no formatting. Enabled lines are
+/// queued under a short lock and handed to the sink in order by a delivery
+/// thread, started on the first line; a slow host callback therefore never
+/// holds up the USB or HTTP threads. If the sink falls kMaxQueued lines
+/// behind, further lines are dropped and counted, and a note saying how many
+/// follows once it catches up.
+///
+/// Every category starts at ZUNE_LOG_INFO. Nothing is enabled without a sink.
+class Logger {
+public:
+    using Sink = std::function<void(const std::string& message)>;
+    static constexpr size_t kMaxQueued = 8192;
+
+    struct Stats {
+        uint64_t written = 0;    // Queued for delivery
+        uint64_t delivered = 0;
+        uint64_t dropped = 0;    // Queue full
+    };
+
+    Logger();
+    ~Logger();  // Delivers what is queued, then stops the thread
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /// Replace the sink; null stops delivery. Once this returns the old sink
+    /// is not running and will not be called again (unless called from the
+    /// sink itself, which takes effect from the next batch of lines).
+    void SetSink(Sink sink);
+
+    void SetLevel(ZuneLogCategory category, ZuneLogLevel level);
+    void SetLevel(ZuneLogLevel level);  // Every category
+    ZuneLogLevel GetLevel(ZuneLogCategory category) const;
+
+    bool IsEnabled(ZuneLogCategory category, ZuneLogLevel level) const {
+        return has_sink_.load(std::memory_order_relaxed) &&
+               static_cast<int>(level) <=
+                   levels_[category].load(std::memory_order_relaxed);
+    }
+
+    /// Queue a line; source, if set, is prefixed as "[source] " on the
+    /// delivery thread and must be a string literal
+    void Write(ZuneLogCategory category, ZuneLogLevel level, const char* source, std::string message);
+
+    /// Wait until every line queued so far has been delivered
+    void Flush();
+
+    Stats GetStats() const;
+
+private:
+    struct Line {
+        const char* source;
+        std::string message;
+    };
+
+    void Run();
+
+    std::atomic<int> levels_[ZUNE_LOG_CATEGORY_COUNT];
+    std::atomic<bool> has_sink_{false};
+
+    mutable std::mutex mutex_;     // Guards the queue, counters and thread start
+    std::condition_variable cv_;       // Lines queued, or stopping
+    std::condition_variable idle_cv_;  // Queue drained, for Flush
+    std::deque<Line> queue_;
+    bool delivering_ = false;
+    bool waiting_ = false;         // Delivery thread asleep on cv_
+    bool stop_ = false;
+    uint64_t dropped_unreported_ = 0;
+    Stats stats_;
+    std::thread thread_;
+
+    std::mutex sink_mutex_;        // Held while the sink runs
+    Sink sink_;
+};
+
+/// Adapts logger for components that take a plain log callback: lines are
+/// logged at category and level, when enabled. They are built before the
+/// check, so this suits components that log rarely. Null if logger is.
+inline Logger::Sink LogCallbackFor(Logger* logger, ZuneLogCategory category, ZuneLogLevel level) {
+    if (!logger) {
+        return nullptr;
+    }
+    return [logger, category, level](const std::string& message) {
+        if (logger->IsEnabled(category, level)) {
+            logger->Write(category, level, nullptr, message);
+        }
+    };
+}
+
+} // namespace zune
+
+/// Log message if logger (a zune::Logger*, may be null) has category at
+/// level enabled. message is only evaluated, and so only formatted, when
+/// it is. category and level are the enumerator suffixes, e.g. TCP, DEBUG.
+#define ZUNE_LOG(logger, source, category, level, message)                                   \
+    do {                                                                                     \
+        ::zune::Logger* zune_logger_ = (logger);                                             \
+        if (zune_logger_ && zune_logger_->IsEnabled(ZUNE_LOG_##category, ZUNE_LOG_##level)) { \
+            zune_logger_->Write(ZUNE_LOG_##category, ZUNE_LOG_##level, (source), (message)); \
+        }                                                                                    \
+    } while (0)
+
+/// For log lines built over several statements
+#define ZUNE_LOG_ENABLED(logger, category, level) \
+    ((logger) && (logger)->IsEnabled(ZUNE_LOG_##category, ZUNE_LOG_##level))
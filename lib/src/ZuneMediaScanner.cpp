@@ -0,0 +1,312 @@
+#include "ZuneMediaScanner.h"
+#include "ZuneFileStore.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace zune {
+
+static constexpr char kCacheMagic[4] = {'X', 'Z', 'M', 'S'};
+static constexpr uint32_t kCacheVersion = 1;
+
+static constexpr uint8_t kFlagTagged = 0x01;
+static constexpr uint8_t kFlagArtworkProbed = 0x02;
+
+namespace {
+
+void PutEntry(std::vector<uint8_t>& out, const ScannedTrack& t) {
+    PutString(out, t.path);
+    Put64(out, t.file_size);
+    Put64(out, static_cast<uint64_t>(t.mtime));
+    out.push_back(static_cast<uint8_t>((t.tagged ? kFlagTagged : 0) | (t.artwork_probed ? kFlagArtworkProbed : 0)));
+    Put32(out, t.artwork_size);
+    Put32(out, t.year);
+    out.push_back(static_cast<uint8_t>(t.track.track_number));
+    out.push_back(static_cast<uint8_t>(t.track.track_number >> 8));
+    Put32(out, t.track.disc_number);
+    Put32(out, t.track.duration_ms);
+    Put32(out, static_cast<uint32_t>(t.track.rating));
+    PutString(out, t.track.filename);
+    PutString(out, t.track.title);
+    PutString(out, t.track.artist);
+    PutString(out, t.track.album_name);
+    PutString(out, t.track.album_artist);
+    PutString(out, t.track.genre);
+    PutString(out, t.track.date_authored);
+    PutString(out, t.album.artist);
+    PutString(out, t.album.album_name);
+    PutString(out, t.album.date_authored);
+    PutString(out, t.artist_guid);
+}
+
+ScannedTrack GetEntry(BinaryReader& r) {
+    ScannedTrack t;
+    t.path = r.GetString();
+    t.file_size = r.Get(8);
+    t.mtime = static_cast<int64_t>(r.Get(8));
+    uint8_t flags = static_cast<uint8_t>(r.Get(1));
+    t.tagged = (flags & kFlagTagged) != 0;
+    t.artwork_probed = (flags & kFlagArtworkProbed) != 0;
+    t.artwork_size = static_cast<uint32_t>(r.Get(4));
+    t.year = static_cast<unsigned>(r.Get(4));
+    t.track.track_number = static_cast<uint16_t>(r.Get(2));
+    t.track.disc_number = static_cast<uint32_t>(r.Get(4));
+    t.track.duration_ms = static_cast<uint32_t>(r.Get(4));
+    t.track.rating = static_cast<int32_t>(static_cast<uint32_t>(r.Get(4)));
+    t.track.filename = r.GetString();
+    t.track.title = r.GetString();
+    t.track.artist = r.GetString();
+    t.track.album_name = r.GetString();
+    t.track.album_artist = r.GetString();
+    t.track.genre = r.GetString();
+    t.track.date_authored = r.GetString();
+    t.album.artist = r.GetString();
+    t.album.album_name = r.GetString();
+    t.album.date_authored = r.GetString();
+    t.artist_guid = r.GetString();
+    return t;
+}
+
+bool FileIdentity(const fs::path& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    uintmax_t file_size = fs::file_size(path, ec);
+    if (ec) return false;
+    auto write_time = fs::last_write_time(path, ec);
+    if (ec) return false;
+    size = static_cast<uint64_t>(file_size);
+    mtime = static_cast<int64_t>(write_time.time_since_epoch().count());
+    return true;
+}
+
+// path is root or inside it
+bool IsUnder(const std::string& path, const std::string& root) {
+    if (path.compare(0, root.size(), root) != 0) return false;
+    if (path.size() == root.size()) return true;
+    char c = path[root.size()];
+    return c == '/' || c == '\\' || root.back() == '/' || root.back() == '\\';
+}
+
+std::string FormatDate(unsigned year, const char* suffix) {
+    if (year < 1000) year = 2000;
+    std::ostringstream ss;
+    ss << std::setfill('0') << std::setw(4) << year << suffix;
+    return ss.str();
+}
+
+} // namespace
+
+MediaScanner::MediaScanner(Options options) : options_(std::move(options)) {}
+
+std::string MediaScanner::TrackDate(unsigned year) {
+    return FormatDate(year, "0101T160100.0");
+}
+
+std::string MediaScanner::AlbumDate(unsigned year) {
+    return FormatDate(year, "0102T000100.0");
+}
+
+bool MediaScanner::IsAudioFile(const std::string& path) {
+    static const char* const kExtensions[] = {".mp3", ".wma", ".m4a", ".flac", ".aac", ".ogg"};
+    std::string ext = fs::path(path).extension().string();
+    for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    for (const char* e : kExtensions) {
+        if (ext == e) return true;
+    }
+    return false;
+}
+
+// A missing, truncated or foreign file leaves the cache empty
+void MediaScanner::OpenCache(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!cache_path_.empty()) SaveCacheLocked();
+    cache_.clear();
+    dirty_ = false;
+    cache_path_ = path;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    BinaryReader r{data};
+    const uint8_t* magic = r.Take(sizeof(kCacheMagic));
+    if (!magic || std::memcmp(magic, kCacheMagic, sizeof(kCacheMagic)) != 0) return;
+    if (r.Get(4) != kCacheVersion) return;
+    uint32_t count = static_cast<uint32_t>(r.Get(4));
+    std::unordered_map<std::string, ScannedTrack> entries;
+    entries.reserve(std::min<size_t>(count, data.size() / 64));
+    for (uint32_t i = 0; i < count && r.ok; i++) {
+        ScannedTrack t = GetEntry(r);
+        std::string key = t.path;
+        entries[std::move(key)] = std::move(t);
+    }
+    if (!r.ok) return;
+    cache_ = std::move(entries);
+}
+
+bool MediaScanner::SaveCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SaveCacheLocked();
+}
+
+void MediaScanner::CloseCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!cache_path_.empty()) SaveCacheLocked();
+    cache_path_.clear();
+    cache_.clear();
+}
+
+MediaScanner::Stats MediaScanner::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::vector<ScannedTrack> MediaScanner::Scan(const std::string& root, const Progress& progress) {
+    // Walk on this thread; stat is cheap next to a tag parse
+    std::vector<fs::path> files;
+    std::error_code ec;
+    if (fs::is_regular_file(root, ec)) {
+        if (IsAudioFile(root)) files.emplace_back(root);
+    } else {
+        auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            std::error_code type_ec;
+            if (it->is_regular_file(type_ec) && IsAudioFile(it->path().string()))
+                files.push_back(it->path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    struct Slot {
+        ScannedTrack track;
+        bool ok = false;
+        bool parse = false;
+    };
+    std::vector<Slot> slots(files.size());
+    std::vector<size_t> work;
+    Stats stats;
+    stats.files = files.size();
+    TagReader read;
+    bool read_artwork;
+    unsigned threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        read = options_.read ? options_.read : TagReader(&MediaScanner::ReadTags);
+        read_artwork = options_.read_artwork;
+        threads = std::max(1u, options_.worker_threads);
+        for (size_t i = 0; i < files.size(); i++) {
+            Slot& slot = slots[i];
+            slot.track.path = files[i].string();
+            if (!FileIdentity(files[i], slot.track.file_size, slot.track.mtime)) {
+                stats.failed++;
+                continue;
+            }
+            auto cached = cache_.find(slot.track.path);
+            if (cached != cache_.end() && cached->second.file_size == slot.track.file_size &&
+                cached->second.mtime == slot.track.mtime && (!read_artwork || cached->second.artwork_probed)) {
+                slot.track = cached->second;
+                slot.ok = true;
+                stats.cache_hits++;
+                continue;
+            }
+            slot.parse = true;
+            work.push_back(i);
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{static_cast<size_t>(stats.cache_hits)};
+    std::mutex progress_mutex;
+    auto report = [&](size_t completed) {
+        if (!progress) return;
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        progress(completed, files.size());
+    };
+    auto worker = [&] {
+        for (size_t w = next++; w < work.size(); w = next++) {
+            Slot& slot = slots[work[w]];
+            try {
+                slot.ok = read(slot.track.path, read_artwork, slot.track);
+            } catch (...) {
+                slot.ok = false;
+            }
+            report(++done);
+        }
+    };
+    threads = static_cast<unsigned>(std::min<size_t>(threads, work.size()));
+    if (threads <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; t++)
+            pool.emplace_back(worker);
+        for (auto& t : pool)
+            t.join();
+    }
+
+    std::vector<ScannedTrack> results;
+    results.reserve(slots.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_set<std::string> seen;
+    seen.reserve(slots.size());
+    for (Slot& slot : slots) {
+        seen.insert(slot.track.path);
+        if (slot.parse) {
+            if (slot.ok) {
+                stats.parsed++;
+                cache_[slot.track.path] = slot.track;
+            } else {
+                stats.failed++;
+                cache_.erase(slot.track.path);
+            }
+            dirty_ = true;
+        }
+        if (slot.ok) results.push_back(std::move(slot.track));
+    }
+
+    // Files under root that are no longer there
+    const std::string root_key = fs::path(root).string();
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        if (IsUnder(it->first, root_key) && !seen.count(it->first)) {
+            it = cache_.erase(it);
+            stats.dropped++;
+            dirty_ = true;
+        } else {
+            ++it;
+        }
+    }
+    stats_ = stats;
+    SaveCacheLocked();
+    return results;
+}
+
+bool MediaScanner::SaveCacheLocked() {
+    if (!dirty_ || cache_path_.empty()) return true;
+
+    std::vector<uint8_t> out;
+    out.reserve(12 + cache_.size() * 160);
+    out.insert(out.end(), kCacheMagic, kCacheMagic + sizeof(kCacheMagic));
+    Put32(out, kCacheVersion);
+    Put32(out, static_cast<uint32_t>(cache_.size()));
+    for (const auto& [path, track] : cache_)
+        PutEntry(out, track);
+
+    std::error_code ec;
+    fs::create_directories(fs::path(cache_path_).parent_path(), ec);
+
+    if (!WriteFileAtomic(cache_path_, out)) return false;
+    dirty_ = false;
+    return true;
+}
+
+} // namespace zune
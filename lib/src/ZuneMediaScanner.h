@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ZuneMtpWriterTypes.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+/// Tags and identity of one host audio file
+struct ScannedTrack {
+    std::string path;
+    uint64_t file_size = 0;
+    int64_t mtime = 0;              // As SyncJournal::SourceIdentity reports it
+    TrackProperties track;          // is_hd / artist_meta_id are left for the caller
+    AlbumProperties album;          // Album artist (or artist), album name, album date
+    unsigned year = 0;
+    std::string artist_guid;        // ZuneAlbumArtistMediaID or MusicBrainz artist ID
+    uint32_t artwork_size = 0;      // Embedded cover bytes; only probed with read_artwork
+    bool artwork_probed = false;
+    bool tagged = false;            // false: TagLib could not open the file, fields are fallbacks
+};
+
+/// Walks a host folder tree and reads every audio file's tags on a worker
+/// pool, for the upload and sync-planning paths that used to re-read them
+/// one file at a time in each tool.
+///
+/// Results are kept by path, size and modification time for the scanner's
+/// lifetime, and across runs with a cache file open: a rescan of an
+/// unchanged collection opens no audio files. Only new or modified files
+/// are parsed, and files that disappeared from under the scanned root are
+/// dropped from the cache.
+///
+/// Cache layout (little-endian): "XZMS" magic, u32 format version, u32
+/// entry count, then per entry the path, u64 size, i64 mtime, u8 flags,
+/// u32 artwork size, u32 year, u16 track number, u32 disc, u32 duration,
+/// i32 rating and the text fields, each string as u32 length + bytes.
+/// Written with temp file + rename.
+class MediaScanner {
+public:
+    /// Fill out from path (file_size / mtime are already set); false if unreadable
+    using TagReader = std::function<bool(const std::string& path, bool read_artwork, ScannedTrack& out)>;
+    using Progress = std::function<void(size_t done, size_t total)>;
+
+    struct Options {
+        unsigned worker_threads = 4;
+        bool read_artwork = false;      // Also measure the embedded cover
+        TagReader read;                 // Empty: ReadTags
+    };
+
+    struct Stats {
+        uint64_t files = 0;             // Audio files found
+        uint64_t cache_hits = 0;        // Unchanged since they were cached
+        uint64_t parsed = 0;            // Read through the tag reader
+        uint64_t failed = 0;            // Tag reader returned false; left out of the results
+        uint64_t dropped = 0;           // Cache entries whose file is gone
+    };
+
+    MediaScanner() = default;
+    explicit MediaScanner(Options options);
+
+    /// Bind to a cache file, loading it when it exists. Saves any previous binding.
+    void OpenCache(const std::string& path);
+    bool SaveCache();
+    void CloseCache();
+
+    /// Every audio file under root (or root itself), sorted by path.
+    /// progress runs as files complete, possibly on a worker thread (one
+    /// call at a time). Saves the cache when one is open.
+    std::vector<ScannedTrack> Scan(const std::string& root, const Progress& progress = nullptr);
+
+    /// Counters of the last Scan
+    Stats GetStats() const;
+
+    /// TagLib reader: tags, duration and (with read_artwork) cover size.
+    /// Untagged text fields are left empty; the title falls back to the
+    /// file stem. False if the file does not exist.
+    static bool ReadTags(const std::string& path, bool read_artwork, ScannedTrack& out);
+    /// First embedded cover of an MP3, WMA, M4A or FLAC file; empty if none
+    static std::vector<uint8_t> ExtractArtwork(const std::string& path);
+    /// Extension in the set the upload tools accept (case-insensitive)
+    static bool IsAudioFile(const std::string& path);
+    /// "YYYY0101T160100.0" / "YYYY0102T000100.0" as Zune Desktop writes them;
+    /// years before 1000 become 2000
+    static std::string TrackDate(unsigned year);
+    static std::string AlbumDate(unsigned year);
+
+private:
+    bool SaveCacheLocked();
+
+    mutable std::mutex mutex_;
+    Options options_;
+    std::string cache_path_;
+    std::unordered_map<std::string, ScannedTrack> cache_;
+    bool dirty_ = false;
+    Stats stats_;
+};
+
+} // namespace zune
@@ -0,0 +1,129 @@
+// TagLib side of MediaScanner, kept apart so the scanner's walk and cache
+// build without it
+#include "ZuneMediaScanner.h"
+
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+#include <taglib/tpropertymap.h>
+#include <taglib/mpegfile.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/attachedpictureframe.h>
+#include <taglib/asffile.h>
+#include <taglib/asftag.h>
+#include <taglib/mp4file.h>
+#include <taglib/mp4tag.h>
+#include <taglib/mp4coverart.h>
+#include <taglib/flacfile.h>
+#include <taglib/flacpicture.h>
+
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace zune {
+
+namespace {
+
+TagLib::ByteVector FirstCover(TagLib::File* file) {
+    if (auto* f = dynamic_cast<TagLib::MPEG::File*>(file)) {
+        if (f->ID3v2Tag()) {
+            auto frames = f->ID3v2Tag()->frameList("APIC");
+            if (!frames.isEmpty()) {
+                if (auto* pic = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front()))
+                    return pic->picture();
+            }
+        }
+    } else if (auto* f = dynamic_cast<TagLib::ASF::File*>(file)) {
+        if (f->tag()) {
+            auto& m = f->tag()->attributeListMap();
+            if (m.contains("WM/Picture") && !m["WM/Picture"].isEmpty())
+                return m["WM/Picture"][0].toPicture().picture();
+        }
+    } else if (auto* f = dynamic_cast<TagLib::MP4::File*>(file)) {
+        if (f->tag() && f->tag()->contains("covr")) {
+            auto covers = f->tag()->item("covr").toCoverArtList();
+            if (!covers.isEmpty()) return covers[0].data();
+        }
+    } else if (auto* f = dynamic_cast<TagLib::FLAC::File*>(file)) {
+        auto pictures = f->pictureList();
+        if (!pictures.isEmpty()) return pictures[0]->data();
+    }
+    return TagLib::ByteVector();
+}
+
+} // namespace
+
+bool MediaScanner::ReadTags(const std::string& path, bool read_artwork, ScannedTrack& out) {
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) return false;
+
+    ScannedTrack t;
+    t.path = out.path.empty() ? path : out.path;
+    t.file_size = out.file_size;
+    t.mtime = out.mtime;
+    t.track.filename = fs::path(path).filename().string();
+
+    TagLib::FileRef fileRef(path.c_str());
+    if (!fileRef.isNull()) {
+        t.tagged = true;
+        if (auto* tag = fileRef.tag()) {
+            t.track.title = tag->title().toCString(true);
+            t.track.artist = tag->artist().toCString(true);
+            t.track.album_name = tag->album().toCString(true);
+            t.track.genre = tag->genre().toCString(true);
+            t.track.track_number = static_cast<uint16_t>(tag->track());
+            t.year = tag->year();
+        }
+
+        auto props = fileRef.file()->properties();
+        if (props.contains("ALBUMARTIST"))
+            t.track.album_artist = props["ALBUMARTIST"].front().toCString(true);
+        if (props.contains("DISCNUMBER"))
+            t.track.disc_number = static_cast<uint32_t>(std::max(0, props["DISCNUMBER"].front().toInt()));
+        if (props.contains("RATING"))
+            t.track.rating = props["RATING"].front().toInt();
+
+        if (fileRef.audioProperties())
+            t.track.duration_ms = static_cast<uint32_t>(fileRef.audioProperties()->lengthInMilliseconds());
+
+        // Artist GUID from WMA or ID3v2
+        if (auto* asfFile = dynamic_cast<TagLib::ASF::File*>(fileRef.file())) {
+            if (asfFile->tag()) {
+                auto& m = asfFile->tag()->attributeListMap();
+                if (m.contains("ZuneAlbumArtistMediaID") && !m["ZuneAlbumArtistMediaID"].isEmpty())
+                    t.artist_guid = m["ZuneAlbumArtistMediaID"][0].toString().toCString(true);
+                else if (m.contains("MusicBrainz/Artist ID") && !m["MusicBrainz/Artist ID"].isEmpty())
+                    t.artist_guid = m["MusicBrainz/Artist ID"][0].toString().toCString(true);
+            }
+        } else if (props.contains("MUSICBRAINZ_ARTISTID")) {
+            t.artist_guid = props["MUSICBRAINZ_ARTISTID"].front().toCString(true);
+        }
+
+        if (read_artwork) {
+            t.artwork_size = static_cast<uint32_t>(FirstCover(fileRef.file()).size());
+            t.artwork_probed = true;
+        }
+    }
+
+    if (t.track.title.empty())
+        t.track.title = fs::path(path).stem().string();
+    t.track.date_authored = TrackDate(t.year);
+    t.album.artist = t.track.album_artist.empty() ? t.track.artist : t.track.album_artist;
+    t.album.album_name = t.track.album_name;
+    t.album.date_authored = AlbumDate(t.year);
+
+    out = std::move(t);
+    return true;
+}
+
+std::vector<uint8_t> MediaScanner::ExtractArtwork(const std::string& path) {
+    std::vector<uint8_t> artwork;
+    TagLib::FileRef fileRef(path.c_str());
+    if (fileRef.isNull()) return artwork;
+    TagLib::ByteVector data = FirstCover(fileRef.file());
+    artwork.assign(data.begin(), data.end());
+    return artwork;
+}
+
+} // namespace zune
@@ -1,14 +1,31 @@
 #include "ZuneMtpReader.h"
+#include "ZuneFileStore.h"
 #include "zmdb/ZMDBParserFactory.h"
-#include <mtp/ptp/ObjectPropertyListParser.h>
+#include "zmdb/ZMDBSnapshot.h"
+#include "zmdb/ZMDBStream.h"
+#include "zmdb/ZMDBUtils.h"
+#include "ZuneMusicLibrarySink.h"
+#include "ZunePackedLibrary.h"
+#include "ZunePropertyList.h"
+#include "ZuneTransferStats.h"
+#include "ZuneMtpScheduler.h"
+#include "ZuneTrace.h"
 #include <mtp/ptp/ByteArrayObjectStream.h>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <thread>
 #include <chrono>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <memory>
+#include <exception>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace mtp;
 
@@ -24,11 +41,15 @@ static constexpr size_t ZMDB_HEADER_SIZE = 12;
 static constexpr int ZMDB_DEVICE_PREPARE_DELAY_MS = 250;
 static constexpr int ZMDB_PIPE_DRAIN_TIMEOUT_MS = 100;
 
+// MTP RepresentativeSampleSize: byte count of RepresentativeSampleData
+static constexpr uint16_t REPRESENTATIVE_SAMPLE_SIZE = 0xDC82;
+
 namespace zune {
 
 // ── Object Properties ────────────────────────────────────────────────────
 
 uint64_t MtpReader::GetObjectSize(const SessionPtr& session, uint32_t object_id) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
     try {
         return session->GetObjectIntegerProperty(
             mtp::ObjectId(object_id), mtp::ObjectProperty::ObjectSize);
@@ -38,6 +59,7 @@ uint64_t MtpReader::GetObjectSize(const SessionPtr& session, uint32_t object_id)
 }
 
 std::string MtpReader::GetObjectFilename(const SessionPtr& session, uint32_t object_id) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
     try {
         auto info = session->GetObjectInfo(mtp::ObjectId(object_id));
         return info.Filename;
@@ -46,12 +68,160 @@ std::string MtpReader::GetObjectFilename(const SessionPtr& session, uint32_t obj
     }
 }
 
+std::string MtpReader::GetObjectText(const SessionPtr& session, uint32_t object_id, uint16_t property) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    mtp::ByteArray data;
+    try {
+        data = session->GetObjectProperty(mtp::ObjectId(object_id), mtp::ObjectProperty(property));
+    } catch (...) {
+        return "";
+    }
+
+    // STR: u8 character count (including the NUL), UTF-16LE.
+    // AUINT16: u32 element count, UTF-16LE code units.
+    if (!data.empty() && size_t(data[0]) * 2 + 1 == data.size()) {
+        return zmdb::utf16le_to_utf8(zmdb::ByteView(data.data() + 1, data.size() - 1));
+    }
+    if (data.size() < 4) return "";
+    uint32_t count;
+    std::memcpy(&count, data.data(), sizeof(count));
+    size_t bytes = std::min<size_t>(size_t(count) * 2, data.size() - 4);
+    return zmdb::utf16le_to_utf8(zmdb::ByteView(data.data() + 4, bytes));
+}
+
+// Walk a single-property list of integers: fn(handle, value) per element.
+// False if the list is malformed or holds another type.
+template <typename Fn>
+static bool ForEachListedInteger(const mtp::ByteArray& data, Fn&& fn) {
+    bool integers = true;
+    bool ok = zune::ForEachProperty(data, [&](const zune::PropertyEntry& entry) {
+        if (entry.IsInteger()) fn(entry.handle, entry.Integer());
+        else integers = false;
+    });
+    return ok && integers;
+}
+
+bool MtpReader::GetObjectSizes(const SessionPtr& session, std::unordered_map<uint32_t, uint64_t>& sizes,
+                               uint32_t parent) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    mtp::ByteArray data;
+    try {
+        data = session->GetObjectPropertyList(
+            parent ? mtp::ObjectId(parent) : mtp::Session::Root, mtp::ObjectFormat(0),
+            mtp::ObjectProperty::ObjectSize, 0, 1);
+    } catch (...) {
+        return false;
+    }
+
+    return ForEachListedInteger(data, [&](uint32_t handle, uint64_t size) { sizes[handle] = size; });
+}
+
+bool MtpReader::GetObjectFormats(const SessionPtr& session, std::unordered_map<uint32_t, uint16_t>& formats,
+                                 uint32_t parent) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    mtp::ByteArray data;
+    try {
+        data = session->GetObjectPropertyList(
+            parent ? mtp::ObjectId(parent) : mtp::Session::Root, mtp::ObjectFormat(0),
+            mtp::ObjectProperty::ObjectFormat, 0, 1);
+    } catch (...) {
+        return false;
+    }
+
+    return ForEachListedInteger(data, [&](uint32_t handle, uint64_t format) {
+        formats[handle] = static_cast<uint16_t>(format);
+    });
+}
+
+bool MtpReader::GetObjectParents(const SessionPtr& session, std::unordered_map<uint32_t, uint32_t>& parents,
+                                 uint32_t parent) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    mtp::ByteArray data;
+    try {
+        data = session->GetObjectPropertyList(
+            parent ? mtp::ObjectId(parent) : mtp::Session::Root, mtp::ObjectFormat(0),
+            mtp::ObjectProperty::ParentObject, 0, 1);
+    } catch (...) {
+        return false;
+    }
+
+    return ForEachListedInteger(data, [&](uint32_t handle, uint64_t owner) {
+        parents[handle] = static_cast<uint32_t>(owner);
+    });
+}
+
+bool MtpReader::ReadUserStates(const SessionPtr& session, std::vector<TrackUserState>& states) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    // Format 0 rather than one list per audio format: the lists carry only
+    // objects that have the property, and callers match by handle
+    mtp::ByteArray use_counts, ratings;
+    try {
+        use_counts = session->GetObjectPropertyList(
+            mtp::Session::Root, mtp::ObjectFormat(0), mtp::ObjectProperty::UseCount, 0, 1);
+        ratings = session->GetObjectPropertyList(
+            mtp::Session::Root, mtp::ObjectFormat(0), mtp::ObjectProperty::UserRating, 0, 1);
+    } catch (...) {
+        return false;
+    }
+
+    std::unordered_map<uint32_t, size_t> index;
+    auto state = [&](uint32_t handle) -> TrackUserState& {
+        auto [it, added] = index.emplace(handle, states.size());
+        if (added) states.push_back(TrackUserState{handle, -1, -1});
+        return states[it->second];
+    };
+    states.clear();
+    bool ok = ForEachListedInteger(use_counts, [&](uint32_t handle, uint64_t count) {
+        state(handle).play_count = static_cast<int>(std::min<uint64_t>(count, INT32_MAX));
+    });
+    ok = ok && ForEachListedInteger(ratings, [&](uint32_t handle, uint64_t rating) {
+        state(handle).rating = static_cast<int>(std::min<uint64_t>(rating, INT32_MAX));
+    });
+    return ok;
+}
+
+bool MtpReader::ReadLibraryFingerprint(const SessionPtr& session, uint64_t& fingerprint) {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    uint64_t hash = kFnv1a64Offset;
+    auto mix = [&hash](const uint8_t* data, size_t size) { hash = Fnv1a64(data, size, hash); };
+    auto mix64 = [&mix](uint64_t value) {
+        uint8_t bytes[8];
+        for (size_t i = 0; i < sizeof(bytes); i++) bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+        mix(bytes, sizeof(bytes));
+    };
+
+    try {
+        auto storages = session->GetStorageIDs();
+        for (const auto& id : storages.StorageIDs) {
+            auto info = session->GetStorageInfo(id);
+            mix64(id.Id);
+            mix64(info.MaxCapacity);
+            mix64(info.FreeSpaceInBytes);
+        }
+
+        // Raw lists: handle, property, type and value per object
+        for (auto property : {mtp::ObjectProperty::ObjectSize, mtp::ObjectProperty::UseCount,
+                              mtp::ObjectProperty::UserRating}) {
+            mtp::ByteArray list = session->GetObjectPropertyList(
+                mtp::Session::Root, mtp::ObjectFormat(0), property, 0, 1);
+            mix64(list.size());
+            mix(list.data(), list.size());
+        }
+    } catch (...) {
+        return false;
+    }
+
+    fingerprint = hash != 0 ? hash : 1;
+    return true;
+}
+
 // ── Streaming / Partial Downloads ────────────────────────────────────────
 
 mtp::ByteArray MtpReader::GetPartialObject(
     const SessionPtr& session, uint32_t object_id,
     uint64_t offset, uint32_t size)
 {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
     try {
         return session->GetPartialObject(mtp::ObjectId(object_id), offset, size);
     } catch (...) {
@@ -59,12 +229,122 @@ mtp::ByteArray MtpReader::GetPartialObject(
     }
 }
 
+int MtpReader::StreamObject(
+    const SessionPtr& session, uint32_t object_id,
+    const StreamObjectOptions& options, const ChunkSink& sink,
+    uint64_t* next_offset, TransferStats* stats, MtpScheduler* scheduler)
+{
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    uint64_t delivered_until = options.offset;
+    if (next_offset) *next_offset = delivered_until;
+
+    // A caller already holding the session covers the fetcher too; the
+    // fetcher cannot queue behind its own caller
+    if (scheduler && scheduler->HeldByCurrentThread()) scheduler = nullptr;
+
+    uint64_t end = MtpScheduler::Run(scheduler, ZUNE_MTP_CLASS_CONTROL,
+                                     [&] { return GetObjectSize(session, object_id); });
+    if (options.length != 0 && options.offset + options.length < end)
+        end = options.offset + options.length;
+    if (options.offset >= end)
+        return 0;
+    const uint32_t chunk_size = options.chunk_size ? options.chunk_size : (1u << 20);
+
+    struct Chunk {
+        mtp::ByteArray data;
+        uint64_t offset;
+    };
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Chunk> ready;        // At most one chunk waits while sink runs
+    bool fetch_done = false;
+    bool fetch_failed = false;
+    bool stop = false;
+
+    std::thread fetcher([&] {
+        uint64_t pos = options.offset;
+        while (pos < end) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return stop || ready.empty(); });
+                if (stop) break;
+            }
+            auto size = static_cast<uint32_t>(std::min<uint64_t>(chunk_size, end - pos));
+            mtp::ByteArray data;
+            try {
+                data = MtpScheduler::Run(scheduler, ZUNE_MTP_CLASS_READ, [&] {
+                    return TransferStats::Measure(stats, ZUNE_TRANSFER_OP_GET_PARTIAL_OBJECT, 0, [&] {
+                        return session->GetPartialObject(mtp::ObjectId(object_id), pos, size);
+                    });
+                });
+            } catch (...) {
+            }
+            if (data.empty()) {
+                std::lock_guard<std::mutex> lock(mutex);
+                fetch_failed = true;
+                break;
+            }
+            if (data.size() > size) data.resize(size);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            uint64_t chunk_offset = pos;
+            pos += data.size();
+            ready.push_back(Chunk{std::move(data), chunk_offset});
+            cv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        fetch_done = true;
+        cv.notify_all();
+    });
+
+    auto started = TransferStats::Clock::now();
+    int result = 0;
+    try {
+        for (;;) {
+            Chunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !ready.empty() || fetch_done; });
+                if (ready.empty()) {
+                    if (fetch_failed) result = -1;
+                    break;
+                }
+                chunk = std::move(ready.front());
+                ready.pop_front();
+            }
+            cv.notify_all();  // Fetcher may request the next chunk now
+
+            if (!sink(chunk.data.data(), chunk.data.size(), chunk.offset)) {
+                result = -2;
+                break;
+            }
+            delivered_until = chunk.offset + chunk.data.size();
+            if (next_offset) *next_offset = delivered_until;
+            if (stats && stats->HasProgressCallback()) {
+                stats->ReportProgress(ZUNE_TRANSFER_OP_GET_PARTIAL_OBJECT,
+                                      delivered_until - options.offset, end - options.offset, started);
+            }
+        }
+    } catch (...) {
+        result = -2;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    fetcher.join();
+    return result;
+}
+
 // ── Artwork Download ─────────────────────────────────────────────────────
 
 int MtpReader::DownloadArtwork(
     const SessionPtr& session, uint32_t object_handle,
     const std::string& destination_path)
 {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
     try {
         mtp::ByteArray artwork_data = session->GetObjectProperty(
             mtp::ObjectId(object_handle),
@@ -86,14 +366,52 @@ int MtpReader::DownloadArtwork(
     }
 }
 
+int MtpReader::DownloadArtworkBatch(
+    const SessionPtr& session,
+    const std::vector<uint32_t>& object_handles,
+    const std::vector<std::string>& destination_paths,
+    const ArtworkSink& sink,
+    std::vector<int>* results)
+{
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    ArtworkBatch::Source source;
+    source.size = [&session](uint32_t handle) -> uint64_t {
+        try {
+            return session->GetObjectIntegerProperty(
+                mtp::ObjectId(handle), mtp::ObjectProperty(REPRESENTATIVE_SAMPLE_SIZE));
+        } catch (...) {
+            return 0;
+        }
+    };
+    source.fetch = [&session](uint32_t handle, std::vector<uint8_t>& data) {
+        data = session->GetObjectProperty(
+            mtp::ObjectId(handle), mtp::ObjectProperty::RepresentativeSampleData);
+        // MTP property data has a 4-byte length prefix
+        if (data.size() < 4)
+            return false;
+        data.erase(data.begin(), data.begin() + 4);
+        return true;
+    };
+    return ArtworkBatch::Run(source, object_handles, destination_paths, sink, results);
+}
+
 // ── Track Lookup ─────────────────────────────────────────────────────────
 
+// Track names are matched without their file extension
+static std::string StripExtension(const std::string& file_name) {
+    size_t dot_pos = file_name.rfind('.');
+    return (dot_pos != std::string::npos && dot_pos > 0)
+        ? file_name.substr(0, dot_pos)
+        : file_name;
+}
+
 uint32_t MtpReader::FindTrackObjectId(
     const SessionPtr& session,
     const std::string& track_title,
     uint32_t album_object_id,
     std::vector<TrackReference>* siblings_out)
 {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
     if (track_title.empty() || album_object_id == 0)
         return 0;
 
@@ -103,14 +421,8 @@ uint32_t MtpReader::FindTrackObjectId(
 
         for (const auto& handle : object_refs.ObjectHandles) {
             try {
-                std::string file_name = session->GetObjectStringProperty(
-                    handle, mtp::ObjectProperty::Name);
-
-                // Strip file extension
-                size_t dot_pos = file_name.rfind('.');
-                std::string track_name = (dot_pos != std::string::npos && dot_pos > 0)
-                    ? file_name.substr(0, dot_pos)
-                    : file_name;
+                std::string track_name = StripExtension(session->GetObjectStringProperty(
+                    handle, mtp::ObjectProperty::Name));
 
                 if (siblings_out)
                     siblings_out->push_back({track_name, handle.Id});
@@ -128,320 +440,414 @@ uint32_t MtpReader::FindTrackObjectId(
     }
 }
 
+std::vector<AlbumTracks> MtpReader::ResolveAlbumTracks(
+    const SessionPtr& session,
+    const std::vector<uint32_t>& album_object_ids)
+{
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    std::vector<AlbumTracks> result;
+
+    // Every object's Name in one request, instead of one query per track.
+    // Names stay views into the list; only album tracks get converted
+    mtp::ByteArray name_list;
+    std::unordered_map<uint32_t, zune::PropertyString> names;
+    try {
+        name_list = session->GetObjectPropertyList(
+            mtp::Session::Root, mtp::ObjectFormat(0),
+            mtp::ObjectProperty::Name, 0, 1);
+    } catch (...) {}
+    zune::ForEachProperty(name_list, [&](const zune::PropertyEntry& entry) {
+        if (entry.IsString()) names.emplace(entry.handle, entry.String());
+    });
+
+    std::vector<uint32_t> albums = album_object_ids;
+    if (albums.empty()) {
+        try {
+            mtp::ByteArray album_list = session->GetObjectPropertyList(
+                mtp::Session::Root,
+                mtp::ObjectFormat::AbstractAudioAlbum,
+                mtp::ObjectProperty::ObjectFilename,
+                0, 1);
+
+            zune::ForEachProperty(album_list, [&](const zune::PropertyEntry& entry) {
+                albums.push_back(entry.handle);
+            });
+        } catch (...) {
+            return result;
+        }
+    }
+
+    // Album membership is only exposed through references: one request per album
+    std::unordered_set<uint32_t> seen;
+    for (uint32_t album_object_id : albums) {
+        if (album_object_id == 0 || !seen.insert(album_object_id).second)
+            continue;
+
+        AlbumTracks album{album_object_id, {}};
+        try {
+            auto object_refs = session->GetObjectReferences(mtp::ObjectId(album_object_id));
+            album.tracks.reserve(object_refs.ObjectHandles.size());
+
+            for (const auto& handle : object_refs.ObjectHandles) {
+                auto it = names.find(handle.Id);
+                if (it != names.end()) {
+                    album.tracks.push_back({StripExtension(it->second.ToUtf8()), handle.Id});
+                    continue;
+                }
+
+                // Not in the name list (e.g. the batched query failed)
+                try {
+                    album.tracks.push_back({StripExtension(session->GetObjectStringProperty(
+                        handle, mtp::ObjectProperty::Name)), handle.Id});
+                } catch (...) {
+                    continue;
+                }
+            }
+        } catch (...) {
+            continue;
+        }
+        result.push_back(std::move(album));
+    }
+
+    return result;
+}
+
 // ── ZMDB (Zune Metadata Database) ────────────────────────────────────────
 
+// Send the ZMDB request for object_id and read the response header.
+// Returns the total size from the header (0 if the device sent none).
+template <typename PipePtr>
+static uint32_t SendZmdbRequest(
+    const PipePtr& pipe,
+    const std::vector<uint8_t>& object_id,
+    mtp::ByteArray& header_data)
+{
+    // Build 16-byte request
+    mtp::ByteArray request_data(ZMDB_REQUEST_SIZE, 0);
+    request_data[0] = ZMDB_REQUEST_LENGTH_BYTE;
+    request_data[4] = ZMDB_COMMAND_MARKER;
+    request_data[6] = ZMDB_OPERATION_CODE_HIGH;
+    request_data[7] = ZMDB_OPERATION_CODE_LOW;
+    for (size_t i = 0; i < object_id.size() && i < ZMDB_OBJECT_ID_SIZE; ++i)
+        request_data[8 + i] = object_id[i];
+    request_data[12] = ZMDB_TRAILER_VALUE;
+
+    // Send request
+    auto input = std::make_shared<mtp::ByteArrayObjectInputStream>(request_data);
+    pipe->Write(input, mtp::Session::DefaultTimeout);
+
+    // Wait for device to prepare response
+    std::this_thread::sleep_for(std::chrono::milliseconds(ZMDB_DEVICE_PREPARE_DELAY_MS));
+
+    // Read header
+    auto header = std::make_shared<mtp::ByteArrayObjectOutputStream>();
+    pipe->Read(header, mtp::Session::DefaultTimeout);
+    header_data = header->GetData();
+
+    // Parse total size from header
+    uint32_t total_size = 0;
+    if (header_data.size() >= 4) {
+        total_size = header_data[0] |
+                    (header_data[1] << 8) |
+                    (header_data[2] << 16) |
+                    (header_data[3] << 24);
+    }
+    return total_size;
+}
+
+template <typename PipePtr>
+static void DrainZmdbPipe(const PipePtr& pipe)
+{
+    try {
+        auto drain = std::make_shared<mtp::ByteArrayObjectOutputStream>();
+        pipe->Read(drain, ZMDB_PIPE_DRAIN_TIMEOUT_MS);
+    } catch (...) {}
+}
+
 mtp::ByteArray MtpReader::ReadZuneMetadata(
     const SessionPtr& session,
     const std::vector<uint8_t>& object_id)
 {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
     mtp::ByteArray result;
 
     try {
-        // Build 16-byte request
-        mtp::ByteArray request_data(ZMDB_REQUEST_SIZE, 0);
-        request_data[0] = ZMDB_REQUEST_LENGTH_BYTE;
-        request_data[4] = ZMDB_COMMAND_MARKER;
-        request_data[6] = ZMDB_OPERATION_CODE_HIGH;
-        request_data[7] = ZMDB_OPERATION_CODE_LOW;
-        for (size_t i = 0; i < object_id.size() && i < ZMDB_OBJECT_ID_SIZE; ++i)
-            request_data[8 + i] = object_id[i];
-        request_data[12] = ZMDB_TRAILER_VALUE;
-
         auto pipe = session->GetBulkPipe();
         if (!pipe)
             return result;
 
-        // Send request
-        auto input = std::make_shared<mtp::ByteArrayObjectInputStream>(request_data);
-        pipe->Write(input, mtp::Session::DefaultTimeout);
-
-        // Wait for device to prepare response
-        std::this_thread::sleep_for(std::chrono::milliseconds(ZMDB_DEVICE_PREPARE_DELAY_MS));
-
-        // Read header
-        auto header = std::make_shared<mtp::ByteArrayObjectOutputStream>();
-        pipe->Read(header, mtp::Session::DefaultTimeout);
+        mtp::ByteArray header;
+        uint32_t total_size = SendZmdbRequest(pipe, object_id, header);
 
-        if (header->GetData().empty())
+        if (header.empty())
             return result;
 
-        // Parse total size from header
-        uint32_t total_size = 0;
-        if (header->GetData().size() >= 4) {
-            total_size = header->GetData()[0] |
-                        (header->GetData()[1] << 8) |
-                        (header->GetData()[2] << 16) |
-                        (header->GetData()[3] << 24);
-        }
-
         // Header-only response
-        if (header->GetData().size() == ZMDB_HEADER_SIZE && total_size <= ZMDB_HEADER_SIZE)
-            return header->GetData();
+        if (header.size() == ZMDB_HEADER_SIZE && total_size <= ZMDB_HEADER_SIZE)
+            return header;
 
         // Read payload
         if (total_size > ZMDB_HEADER_SIZE) {
             auto payload = std::make_shared<mtp::ByteArrayObjectOutputStream>();
             pipe->Read(payload, mtp::Session::LongTimeout);
             result = payload->GetData();
-
-            // Drain pipe
-            try {
-                auto drain = std::make_shared<mtp::ByteArrayObjectOutputStream>();
-                pipe->Read(drain, ZMDB_PIPE_DRAIN_TIMEOUT_MS);
-            } catch (...) {}
+            DrainZmdbPipe(pipe);
         }
     } catch (...) {}
 
     return result;
 }
 
-// ── Full Library Read ────────────────────────────────────────────────────
+namespace {
 
-ZuneMusicLibrary* MtpReader::ReadMusicLibrary(
+// Feeds USB chunks straight into a ZMDBStreamBuffer as they arrive
+class ZmdbStreamOutput : public mtp::IObjectOutputStream {
+public:
+    explicit ZmdbStreamOutput(zmdb::ZMDBStreamBuffer& buffer) : buffer_(buffer) {}
+
+    size_t Write(const uint8_t* data, size_t size) override {
+        if (buffer_.Append(data, size) != size)
+            overflow_ = true;
+        return size;
+    }
+
+    void Cancel() override {}
+
+    bool Overflowed() const { return overflow_; }
+
+private:
+    zmdb::ZMDBStreamBuffer& buffer_;
+    bool overflow_ = false;
+};
+
+} // namespace
+
+std::unique_ptr<zmdb::ZMDBStreamBuffer> MtpReader::ReadZuneMetadataStreaming(
     const SessionPtr& session,
-    zune::DeviceFamily device_family)
+    const std::vector<uint8_t>& object_id,
+    const std::function<void(const zmdb::ZMDBStreamBuffer&)>& consume)
 {
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
     try {
-        // Step 1: Read ZMDB binary from device
-        std::vector<uint8_t> library_object_id = {0x03, 0x92, 0x1f};
-        mtp::ByteArray zmdb_data = ReadZuneMetadata(session, library_object_id);
+        auto pipe = session->GetBulkPipe();
+        if (!pipe)
+            return nullptr;
 
-        if (zmdb_data.empty())
+        mtp::ByteArray header;
+        uint32_t total_size = SendZmdbRequest(pipe, object_id, header);
+        if (total_size <= ZMDB_HEADER_SIZE)
             return nullptr;
 
-        // Step 2: Parse ZMDB
-        auto parser = zmdb::ZMDBParserFactory::CreateParser(device_family);
-        zmdb::ZMDBLibrary library = parser->ExtractLibrary(zmdb_data);
-        library.device_family = device_family;
+        // The header's total covers itself; the buffer must know the exact
+        // payload length up front so the parser can wait on any offset.
+        auto buffer = std::make_unique<zmdb::ZMDBStreamBuffer>(total_size - ZMDB_HEADER_SIZE);
+        auto output = std::make_shared<ZmdbStreamOutput>(*buffer);
 
-        // Step 3: Query MTP for album artwork ObjectIds
-        std::unordered_map<std::string, uint32_t> alb_to_objectid;
-        try {
-            mtp::ByteArray album_list = session->GetObjectPropertyList(
-                mtp::Session::Root,
-                mtp::ObjectFormat::AbstractAudioAlbum,
-                mtp::ObjectProperty::ObjectFilename,
-                0, 1);
+        bool transfer_ok = false;
+        std::thread transfer([&] {
+            try {
+                pipe->Read(output, mtp::Session::LongTimeout);
+                transfer_ok = true;
+            } catch (...) {}
+            DrainZmdbPipe(pipe);
+            buffer->Finish();
+        });
 
-            mtp::ObjectStringPropertyListParser::Parse(album_list,
-                [&](mtp::ObjectId id, mtp::ObjectProperty, const std::string& filename) {
-                    alb_to_objectid[filename] = id.Id;
-                });
-        } catch (...) {}
-
-        // Step 4: Build flat C data structure (zero-initialized for safe partial cleanup)
-        auto result = std::unique_ptr<ZuneMusicLibrary, decltype(&MtpReader::FreeLibrary)>(
-            new ZuneMusicLibrary{}, &MtpReader::FreeLibrary);
-
-        // Copy tracks
-        result->track_count = library.track_count;
-        result->tracks = new ZuneMusicTrack[result->track_count]{};
-        for (uint32_t i = 0; i < library.track_count; i++) {
-            const auto& t = library.tracks[i];
-            result->tracks[i].title = strdup(t.title.c_str());
-            result->tracks[i].artist_name = strdup(t.artist_name.c_str());
-            result->tracks[i].artist_guid = strdup(t.artist_guid.c_str());
-            result->tracks[i].genre = strdup(t.genre.c_str());
-            result->tracks[i].track_number = t.track_number;
-            result->tracks[i].disc_number = t.disc_number;
-            result->tracks[i].duration_ms = t.duration_ms;
-            result->tracks[i].file_size_bytes = t.file_size_bytes;
-            result->tracks[i].album_ref = t.album_ref;
-            result->tracks[i].atom_id = t.atom_id;
-            result->tracks[i].genre_ref = t.genre_ref;
-            result->tracks[i].playcount = t.playcount;
-            result->tracks[i].skip_count = t.skip_count;
-            result->tracks[i].codec_id = t.codec_id;
-            result->tracks[i].rating = t.rating;
-            result->tracks[i].on_device_playcount = t.on_device_playcount;
-            result->tracks[i].last_played_timestamp = t.last_played_timestamp;
+        std::exception_ptr consume_error;
+        try {
+            consume(*buffer);
+        } catch (...) {
+            consume_error = std::current_exception();
         }
+        transfer.join();
 
-        // Copy albums
-        result->album_count = library.album_metadata.size();
-        result->albums = new ZuneMusicAlbum[result->album_count]{};
-        size_t album_idx = 0;
-        for (const auto& [atom_id, album] : library.album_metadata) {
-            result->albums[album_idx].title = strdup(album.title.c_str());
-            result->albums[album_idx].artist_name = strdup(album.artist_name.c_str());
-            result->albums[album_idx].artist_guid = strdup(album.artist_guid.c_str());
-            result->albums[album_idx].alb_reference = strdup(album.alb_reference.c_str());
-            result->albums[album_idx].release_year = album.release_year;
-            result->albums[album_idx].atom_id = album.atom_id;
-            result->albums[album_idx].album_pid = album.album_pid;
-            result->albums[album_idx].artist_ref = album.artist_ref;
-            album_idx++;
-        }
+        if (!transfer_ok || output->Overflowed() || !buffer->Complete())
+            return nullptr;
+        if (consume_error)
+            std::rethrow_exception(consume_error);
+        return buffer;
+    } catch (...) {
+        return nullptr;
+    }
+}
 
-        // Copy artists
-        result->artist_count = library.artist_metadata.size();
-        result->artists = new ZuneMusicArtist[result->artist_count]{};
-        size_t artist_idx = 0;
-        for (const auto& [atom_id, artist] : library.artist_metadata) {
-            result->artists[artist_idx].name = strdup(artist.name.c_str());
-            result->artists[artist_idx].filename = strdup(artist.filename.c_str());
-            result->artists[artist_idx].guid = strdup(artist.guid.c_str());
-            result->artists[artist_idx].atom_id = artist.atom_id;
-            artist_idx++;
-        }
+// ── Full Library Read ────────────────────────────────────────────────────
 
-        // Copy genres
-        result->genre_count = library.genre_metadata.size();
-        result->genres = new ZuneMusicGenre[result->genre_count]{};
-        size_t genre_idx = 0;
-        for (const auto& [atom_id, genre] : library.genre_metadata) {
-            result->genres[genre_idx].name = strdup(genre.name.c_str());
-            result->genres[genre_idx].atom_id = genre.atom_id;
-            genre_idx++;
+bool MtpReader::ReadParsedMusicLibrary(
+    const SessionPtr& session,
+    zune::DeviceFamily device_family,
+    const LibraryReadOptions& options,
+    zmdb::ZMDBLibrary& library,
+    std::unordered_map<std::string, uint32_t>& alb_to_objectid)
+{
+    zmdb::ZMDBLibrarySink sink(library);
+    if (!ReadParsedMusicLibrary(session, device_family, options, sink, alb_to_objectid))
+        return false;
+    library.device_family = device_family;
+    return true;
+}
+
+bool MtpReader::ReadParsedMusicLibrary(
+    const SessionPtr& session,
+    zune::DeviceFamily device_family,
+    const LibraryReadOptions& options,
+    zmdb::ZMDBRecordSink& sink,
+    std::unordered_map<std::string, uint32_t>& alb_to_objectid)
+{
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    std::vector<uint8_t> library_object_id = {0x03, 0x92, 0x1f};
+
+    // Step 0: a device whose fingerprint has not moved since the snapshot
+    // was written is served from it without the ZMDB transfer. Taken before
+    // the read, so a change that races the read only costs a later miss.
+    bool parsed = false;
+    uint64_t fingerprint = 0;
+    if (options.fingerprint_check && !options.snapshot_path.empty() &&
+        ReadLibraryFingerprint(session, fingerprint)) {
+        // A snapshot without details cannot serve a read that wants them
+        parsed = zmdb::read_library_snapshot_for_device(
+            options.snapshot_path, fingerprint, device_family, sink, options.deferred_details);
+    }
+
+    // Steps 1+2 overlapped: parse while the ZMDB is still arriving. Any
+    // transfer problem falls back to the buffered read below.
+    if (!parsed && options.streaming && options.snapshot_path.empty()) {
+        auto parser = zmdb::ZMDBParserFactory::CreateParser(device_family);
+        parser->SetParallelExtraction(options.parallel_parse);
+        parser->SetDeferredDetails(options.deferred_details);
+        auto stream = MtpReader::ReadZuneMetadataStreaming(session, library_object_id,
+            [&](const zmdb::ZMDBStreamBuffer& buffer) {
+                parser->ExtractStreaming(buffer, sink);
+            });
+        if (stream) {
+            parsed = true;
+        } else {
+            // Records of the failed transfer are sent again below
+            sink.Reset();
         }
+    }
 
-        // Build artwork array
-        result->artwork_count = alb_to_objectid.size();
-        result->artworks = new ZuneAlbumArtwork[result->artwork_count]{};
-        size_t artwork_idx = 0;
-        for (const auto& [alb_ref, object_id] : alb_to_objectid) {
-            result->artworks[artwork_idx].alb_reference = strdup(alb_ref.c_str());
-            result->artworks[artwork_idx].mtp_object_id = object_id;
-            artwork_idx++;
+    if (!parsed) {
+        // Step 1: Read ZMDB binary from device
+        mtp::ByteArray zmdb_data = MtpReader::ReadZuneMetadata(session, library_object_id);
+
+        if (zmdb_data.empty())
+            return false;
+
+        // Step 2: Load the on-host snapshot if the ZMDB is unchanged,
+        // otherwise parse it and refresh the snapshot. Either way the
+        // records go straight to the sink.
+        const std::string& snapshot_path = options.snapshot_path;
+        bool loaded = false;
+        uint64_t zmdb_hash = 0;
+        if (!snapshot_path.empty()) {
+            zmdb_hash = zmdb::hash_zmdb(zmdb_data);
+            loaded = zmdb::read_library_snapshot(snapshot_path, zmdb_hash, zmdb_data.size(),
+                                                 device_family, sink, options.deferred_details);
         }
 
-        // Copy playlists
-        result->playlist_count = library.playlist_count;
-        result->playlists = new ZuneMusicPlaylist[result->playlist_count]{};
-        for (uint32_t i = 0; i < library.playlist_count; i++) {
-            const auto& p = library.playlists[i];
-            result->playlists[i].name = strdup(p.name.c_str());
-            result->playlists[i].filename = strdup(p.filename.c_str());
-            result->playlists[i].guid = strdup(p.guid.c_str());
-            result->playlists[i].folder = strdup(p.folder.c_str());
-            result->playlists[i].track_count = p.track_atom_ids.size();
-            result->playlists[i].atom_id = p.atom_id;
-
-            if (p.track_atom_ids.size() > 0) {
-                result->playlists[i].track_atom_ids = new uint32_t[p.track_atom_ids.size()];
-                for (size_t j = 0; j < p.track_atom_ids.size(); j++)
-                    result->playlists[i].track_atom_ids[j] = p.track_atom_ids[j];
+        if (loaded) {
+            // Same library, other fingerprint: match it next time
+            if (fingerprint != 0)
+                zmdb::update_snapshot_fingerprint(snapshot_path, zmdb_hash, zmdb_data.size(), fingerprint);
+        } else {
+            auto parser = zmdb::ZMDBParserFactory::CreateParser(device_family);
+            parser->SetParallelExtraction(options.parallel_parse);
+            parser->SetDeferredDetails(options.deferred_details);
+            if (snapshot_path.empty()) {
+                parser->Extract(zmdb_data, sink);
+            } else {
+                // The snapshot is encoded from the records on their way
+                // to the sink
+                zmdb::ZMDBSnapshotSink snapshot(sink, device_family);
+                parser->Extract(zmdb_data, snapshot);
+
+                // A failed write only costs the next connect a re-parse
+                snapshot.Write(snapshot_path, zmdb_hash, zmdb_data.size(), fingerprint);
             }
         }
+    }
 
-        // Copy podcast shows (atom_id = MTP handle of .ser object)
-        result->podcast_show_count = library.podcast_show_metadata.size();
-        result->podcast_shows = new ZunePodcastShow[result->podcast_show_count]{};
-        size_t show_idx = 0;
-        for (const auto& [atom_id, show] : library.podcast_show_metadata) {
-            auto& out = result->podcast_shows[show_idx++];
-            out.name          = strdup(show.name.c_str());
-            out.ser_filename  = strdup(show.ser_filename.c_str());
-            out.author        = strdup(show.author.c_str());
-            out.feed_url      = strdup(show.feed_url.c_str());
-            out.filename_ref  = show.filename_ref;
-            out.is_subscribed = show.is_subscribed;
-            out.atom_id       = show.atom_id;
-        }
+    // Step 3: Query MTP for album artwork ObjectIds
+    try {
+        mtp::ByteArray album_list = session->GetObjectPropertyList(
+            mtp::Session::Root,
+            mtp::ObjectFormat::AbstractAudioAlbum,
+            mtp::ObjectProperty::ObjectFilename,
+            0, 1);
+
+        zune::ForEachProperty(album_list, [&](const zune::PropertyEntry& entry) {
+            if (entry.IsString()) alb_to_objectid[entry.String().ToUtf8()] = entry.handle;
+        });
+    } catch (...) {}
 
-        // Copy podcast episodes (audio + promoted video podcasts)
-        result->podcast_episode_count = library.podcast_count;
-        result->podcast_episodes = library.podcast_count > 0
-            ? new ZunePodcastEpisode[library.podcast_count]{}
-            : nullptr;
-        for (int i = 0; i < library.podcast_count; ++i) {
-            const auto& ep = library.podcasts[i];
-            auto& out = result->podcast_episodes[i];
-            out.title             = strdup(ep.title.c_str());
-            out.show_name         = strdup(ep.show_name.c_str());
-            out.author            = strdup(ep.author.c_str());
-            out.description       = strdup(ep.description.c_str());
-            out.episode_url       = strdup(ep.episode_url.c_str());
-            out.folder_name       = strdup(ep.folder_name.c_str());
-            out.episode_filename  = strdup(ep.episode_filename.c_str());
-            out.atom_id           = ep.atom_id;
-            out.filename_ref      = ep.filename_ref;
-            out.podcast_show_ref  = ep.podcast_show_ref;
-            out.duration_ms       = ep.duration_ms;
-            out.bookmark_ms       = ep.bookmark_ms;
-            out.publish_date      = ep.publish_date;
-            out.file_size_bytes   = ep.file_size_bytes;
-            out.codec_id          = ep.codec_id;
-            out.meta_genre        = ep.meta_genre();
-            out.played_flag       = ep.played_flag;
-            out.is_played         = ep.is_played();
-            out.media_type        = static_cast<uint8_t>(ep.media_type);
-        }
+    return true;
+}
+
+ZuneMusicLibrary* MtpReader::ReadMusicLibrary(
+    const SessionPtr& session,
+    zune::DeviceFamily device_family,
+    const LibraryReadOptions& options)
+{
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    try {
+        // Step 4: Build the flat C data structure as the records are parsed
+        MusicLibrarySink sink;
+        std::unordered_map<std::string, uint32_t> alb_to_objectid;
+        if (!ReadParsedMusicLibrary(session, device_family, options, sink, alb_to_objectid))
+            return nullptr;
 
-        return result.release();
+        return sink.Release(alb_to_objectid);
 
     } catch (...) {
         return nullptr;
     }
 }
 
-// ── Library Cleanup ─────────────────────────────────────────────────────
-
-void MtpReader::FreeLibrary(ZuneMusicLibrary* library) {
-    if (!library) return;
-
-    for (uint32_t i = 0; i < library->track_count; ++i) {
-        free((void*)library->tracks[i].title);
-        free((void*)library->tracks[i].artist_name);
-        free((void*)library->tracks[i].artist_guid);
-        free((void*)library->tracks[i].genre);
+ZuneMusicLibrary* MtpReader::BuildMusicLibrary(
+    const zmdb::ZMDBLibrary& library,
+    const std::unordered_map<std::string, uint32_t>& alb_to_objectid)
+{
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    try {
+        MusicLibrarySink sink;
+        sink.Add(library);
+        return sink.Release(alb_to_objectid);
+    } catch (...) {
+        return nullptr;
     }
-    delete[] library->tracks;
+}
 
-    for (uint32_t i = 0; i < library->album_count; ++i) {
-        free((void*)library->albums[i].title);
-        free((void*)library->albums[i].artist_name);
-        free((void*)library->albums[i].artist_guid);
-        free((void*)library->albums[i].alb_reference);
-    }
-    delete[] library->albums;
+ZuneMusicLibrary* MtpReader::ReadPackedMusicLibrary(
+    const SessionPtr& session,
+    zune::DeviceFamily device_family,
+    const LibraryReadOptions& options)
+{
+    ZUNE_TRACE_SPAN("MtpReader", __func__);
+    try {
+        zmdb::ZMDBLibrary library;
+        std::unordered_map<std::string, uint32_t> alb_to_objectid;
+        if (!ReadParsedMusicLibrary(session, device_family, options, library, alb_to_objectid))
+            return nullptr;
 
-    for (uint32_t i = 0; i < library->artist_count; ++i) {
-        free((void*)library->artists[i].name);
-        free((void*)library->artists[i].filename);
-        free((void*)library->artists[i].guid);
-    }
-    delete[] library->artists;
+        return BuildPackedLibrary(library, alb_to_objectid);
 
-    for (uint32_t i = 0; i < library->genre_count; ++i) {
-        free((void*)library->genres[i].name);
+    } catch (...) {
+        return nullptr;
     }
-    delete[] library->genres;
+}
 
-    for (uint32_t i = 0; i < library->artwork_count; ++i) {
-        free((void*)library->artworks[i].alb_reference);
-    }
-    delete[] library->artworks;
-
-    for (uint32_t i = 0; i < library->playlist_count; ++i) {
-        free((void*)library->playlists[i].name);
-        free((void*)library->playlists[i].filename);
-        free((void*)library->playlists[i].guid);
-        free((void*)library->playlists[i].folder);
-        delete[] library->playlists[i].track_atom_ids;
-    }
-    delete[] library->playlists;
+// ── Library Cleanup ─────────────────────────────────────────────────────
 
-    for (uint32_t i = 0; i < library->podcast_show_count; ++i) {
-        free((void*)library->podcast_shows[i].name);
-        free((void*)library->podcast_shows[i].ser_filename);
-        free((void*)library->podcast_shows[i].author);
-        free((void*)library->podcast_shows[i].feed_url);
-    }
-    delete[] library->podcast_shows;
-
-    for (uint32_t i = 0; i < library->podcast_episode_count; ++i) {
-        free((void*)library->podcast_episodes[i].title);
-        free((void*)library->podcast_episodes[i].show_name);
-        free((void*)library->podcast_episodes[i].author);
-        free((void*)library->podcast_episodes[i].description);
-        free((void*)library->podcast_episodes[i].episode_url);
-        free((void*)library->podcast_episodes[i].folder_name);
-        free((void*)library->podcast_episodes[i].episode_filename);
-    }
-    delete[] library->podcast_episodes;
+void MtpReader::FreeLibrary(ZuneMusicLibrary* library) {
+    FreeMusicLibrary(library);
+}
 
-    delete library;
+void MtpReader::FreeLibraryDelta(ZuneLibraryDelta* delta) {
+    if (!delta) return;
+    FreeLibrary(delta->changed);
+    delete[] delta->removed_atom_ids;
+    delete delta;
 }
 
 } // namespace zune
@@ -10,19 +10,67 @@
 #include <mtp/ptp/Session.h>
 #include "xune_sync/xune_sync_api.h"
 #include "ZuneDeviceIdentification.h"
+#include "zmdb/ZMDBTypes.h"
+#include "ZuneMtpWriterTypes.h"
+#include "ZuneArtworkBatch.h"
 
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <utility>
 
+namespace zmdb { class ZMDBStreamBuffer; class ZMDBRecordSink; }
+
 namespace zune {
 
+class TransferStats;
+class MtpScheduler;
+
 struct TrackReference {
     std::string name;       // Track name (without file extension)
     uint32_t object_id;
 };
 
+// The tracks referenced by one album object
+struct AlbumTracks {
+    uint32_t album_object_id;
+    std::vector<TrackReference> tracks;
+};
+
+// How ReadMusicLibrary / ReadPackedMusicLibrary obtain the parsed library.
+struct LibraryReadOptions {
+    // Multi-threaded ZMDB extraction (same output)
+    bool parallel_parse = false;
+    // Parse the ZMDB while it is still being transferred (same output).
+    // Ignored when snapshot_path is set: a snapshot hit needs the whole
+    // blob hashed before deciding whether to parse at all.
+    bool streaming = false;
+    // If non-empty, an on-host snapshot of the parsed library: loaded
+    // instead of parsing when it matches the ZMDB's hash, rewritten after
+    // a parse otherwise.
+    std::string snapshot_path;
+    // With snapshot_path: take MtpReader::ReadLibraryFingerprint first, and
+    // when it matches the fingerprint the snapshot was written with, return
+    // the snapshot without reading the ZMDB at all. Only safe if property
+    // writes since the snapshot removed it; see ReadLibraryFingerprint.
+    bool fingerprint_check = false;
+    // Leave video and podcast descriptions and episode URLs empty instead of
+    // decoding them (ZMDBParserBase::SetDeferredDetails); fetch them per
+    // object with GetObjectText when shown. A snapshot written without
+    // them is not used for a read that wants them.
+    bool deferred_details = false;
+};
+
+// Byte range and chunking for MtpReader::StreamObject
+struct StreamObjectOptions {
+    uint64_t offset = 0;            // First byte; pass the last next_offset to resume
+    uint64_t length = 0;            // 0 = to the end of the object
+    uint32_t chunk_size = 1u << 20; // Bytes per GetPartialObject
+};
+
 class MtpReader {
 public:
     using SessionPtr = std::shared_ptr<mtp::Session>;
@@ -30,12 +78,58 @@ public:
     // --- Object Properties ---
     static uint64_t GetObjectSize(const SessionPtr& session, uint32_t object_id);
     static std::string GetObjectFilename(const SessionPtr& session, uint32_t object_id);
+    // UTF-16 text property (AUINT16 or string) as UTF-8, e.g. the Description
+    // and SourceURL a library read with deferred_details left out; "" if the
+    // object has no such property
+    static std::string GetObjectText(const SessionPtr& session, uint32_t object_id, uint16_t property);
+    // ObjectSize of every object (or of parent's children) in one
+    // GetObjectPropertyList; false if the query failed
+    static bool GetObjectSizes(const SessionPtr& session, std::unordered_map<uint32_t, uint64_t>& sizes,
+                               uint32_t parent = 0);
+    // ObjectFormat / ParentObject of every object (or of parent's children),
+    // one GetObjectPropertyList each, e.g. to plan a batch delete
+    static bool GetObjectFormats(const SessionPtr& session, std::unordered_map<uint32_t, uint16_t>& formats,
+                                 uint32_t parent = 0);
+    static bool GetObjectParents(const SessionPtr& session, std::unordered_map<uint32_t, uint32_t>& parents,
+                                 uint32_t parent = 0);
+
+    // UseCount and UserRating of every object that has them, from two
+    // GetObjectPropertyLists of a few bytes per object instead of a ZMDB
+    // read. A value an object does not report stays -1. False if a query failed.
+    static bool ReadUserStates(const SessionPtr& session, std::vector<TrackUserState>& states);
+
+    // Cheap summary of what the device holds, for telling whether its library
+    // changed without reading the ZMDB: per-storage capacity and free space,
+    // and every object's handle, size, UseCount and UserRating (three
+    // property lists of a few bytes per object). Objects added or removed,
+    // and plays and ratings on the device, move it. Metadata-only edits
+    // (titles, albums, references, ArtistId) keep every size and do not,
+    // nor do on-device skip counts: whoever writes properties must drop the
+    // snapshot (ZuneDevice::InvalidateLibrarySnapshot). Never 0. False if a
+    // query failed.
+    static bool ReadLibraryFingerprint(const SessionPtr& session, uint64_t& fingerprint);
 
     // --- Streaming / Partial Downloads ---
     static mtp::ByteArray GetPartialObject(
         const SessionPtr& session, uint32_t object_id,
         uint64_t offset, uint32_t size);
 
+    // Stream an object range to sink in chunk_size pieces. A helper thread
+    // issues the GetPartialObject requests, so the next chunk is in flight
+    // while sink handles the current one; sink runs on the calling thread,
+    // in order. Return false from sink to stop.
+    // next_offset (optional) receives the offset after the last byte sink
+    // accepted, which is where an interrupted download resumes.
+    // With a scheduler, each request takes its own READ grant, so other
+    // operations can run between chunks.
+    // Returns 0 on success, -1 on a device error, -2 if sink stopped.
+    using ChunkSink = std::function<bool(const uint8_t* data, size_t size, uint64_t offset)>;
+    static int StreamObject(
+        const SessionPtr& session, uint32_t object_id,
+        const StreamObjectOptions& options, const ChunkSink& sink,
+        uint64_t* next_offset = nullptr, TransferStats* stats = nullptr,
+        MtpScheduler* scheduler = nullptr);
+
     // --- Artwork Download ---
     // Downloads album artwork via RepresentativeSampleData property, writes to file.
     // Returns 0 on success, -1 on error.
@@ -43,6 +137,24 @@ public:
         const SessionPtr& session, uint32_t object_handle,
         const std::string& destination_path);
 
+    // Artwork for many objects in one call; see ArtworkBatch. Items whose
+    // file on disk already holds the object's RepresentativeSampleSize
+    // bytes are kept without fetching RepresentativeSampleData.
+    // results (optional) receives one ArtworkStatus per handle.
+    // Returns 0 when every item was attempted, -2 if sink stopped.
+    enum ArtworkStatus {
+        ArtworkFailed = ArtworkBatch::Failed,
+        ArtworkDownloaded = ArtworkBatch::Downloaded,
+        ArtworkCached = ArtworkBatch::Cached,
+    };
+    using ArtworkSink = ArtworkBatch::Sink;
+    static int DownloadArtworkBatch(
+        const SessionPtr& session,
+        const std::vector<uint32_t>& object_handles,
+        const std::vector<std::string>& destination_paths,
+        const ArtworkSink& sink,
+        std::vector<int>* results = nullptr);
+
     // --- Track Lookup ---
     // Queries album's object references, matches by track title (sans extension).
     // Returns matching track's ObjectId (0 if not found).
@@ -54,22 +166,80 @@ public:
         uint32_t album_object_id,
         std::vector<TrackReference>* siblings_out = nullptr);
 
+    // Batched form of FindTrackObjectId for many albums: one property-list
+    // query for every object's Name, then one GetObjectReferences per album
+    // (instead of one Name query per track). An empty album_object_ids
+    // resolves every AbstractAudioAlbum on the device. Albums whose
+    // references cannot be read are left out.
+    static std::vector<AlbumTracks> ResolveAlbumTracks(
+        const SessionPtr& session,
+        const std::vector<uint32_t>& album_object_ids);
+
     // --- ZMDB (Zune Metadata Database) ---
     // Reads raw ZMDB data from device via bulk pipe protocol (Op9217).
     static mtp::ByteArray ReadZuneMetadata(
         const SessionPtr& session,
         const std::vector<uint8_t>& object_id);
 
+    // Same request as ReadZuneMetadata, but the payload is read into a
+    // ZMDBStreamBuffer on a transfer thread while consume runs on the calling
+    // thread with that buffer. Returns the filled buffer once both finish,
+    // or nullptr if the transfer failed or its length did not match the
+    // transfer header; consume's output must then be discarded. An exception
+    // thrown by consume is rethrown only when the transfer itself succeeded.
+    static std::unique_ptr<zmdb::ZMDBStreamBuffer> ReadZuneMetadataStreaming(
+        const SessionPtr& session,
+        const std::vector<uint8_t>& object_id,
+        const std::function<void(const zmdb::ZMDBStreamBuffer&)>& consume);
+
     // --- Full Library Read ---
     // Reads ZMDB + queries MTP album artwork ObjectIds → builds ZuneMusicLibrary.
     // Caller owns the returned pointer (free with FreeLibrary or zune_device_free_music_library).
     static ZuneMusicLibrary* ReadMusicLibrary(
         const SessionPtr& session,
-        zune::DeviceFamily device_family);
+        zune::DeviceFamily device_family,
+        const LibraryReadOptions& options = {});
+
+    // Same contents as ReadMusicLibrary, packed into one contiguous block
+    // (see ZunePackedLibrary.h). Free with FreePackedLibrary, not FreeLibrary.
+    static ZuneMusicLibrary* ReadPackedMusicLibrary(
+        const SessionPtr& session,
+        zune::DeviceFamily device_family,
+        const LibraryReadOptions& options = {});
+
+    // Steps shared by the strdup and packed library builders: read the ZMDB,
+    // load or parse it, and query the album artwork ObjectIds (.alb filename
+    // -> ObjectId). Returns false if the device returned no ZMDB.
+    static bool ReadParsedMusicLibrary(
+        const SessionPtr& session,
+        zune::DeviceFamily device_family,
+        const LibraryReadOptions& options,
+        zmdb::ZMDBLibrary& library,
+        std::unordered_map<std::string, uint32_t>& alb_to_objectid);
+
+    // Same steps, with the records handed to sink as they are parsed or
+    // decoded from the snapshot, instead of collected in a ZMDBLibrary.
+    // Refreshing the snapshot encodes the records on their way to sink.
+    // Wrap a consumer of another type in zmdb::ZMDBSinkAdapter.
+    static bool ReadParsedMusicLibrary(
+        const SessionPtr& session,
+        zune::DeviceFamily device_family,
+        const LibraryReadOptions& options,
+        zmdb::ZMDBRecordSink& sink,
+        std::unordered_map<std::string, uint32_t>& alb_to_objectid);
+
+    // Builds the strdup ZuneMusicLibrary that ReadMusicLibrary returns from an
+    // already parsed library. Returns nullptr on allocation failure.
+    static ZuneMusicLibrary* BuildMusicLibrary(
+        const zmdb::ZMDBLibrary& library,
+        const std::unordered_map<std::string, uint32_t>& alb_to_objectid);
 
     // --- Library Cleanup ---
     // Frees a ZuneMusicLibrary allocated by ReadMusicLibrary.
     static void FreeLibrary(ZuneMusicLibrary* library);
+
+    // Frees a ZuneLibraryDelta and the library it owns.
+    static void FreeLibraryDelta(ZuneLibraryDelta* delta);
 };
 
 } // namespace zune
@@ -0,0 +1,146 @@
+#include "ZuneMtpScheduler.h"
+#include <algorithm>
+
+namespace zune {
+
+namespace {
+
+uint64_t ElapsedUs(MtpScheduler::Clock::time_point since, MtpScheduler::Clock::time_point now) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - since).count());
+}
+
+} // namespace
+
+MtpScheduler::Grant& MtpScheduler::Grant::operator=(Grant&& other) noexcept {
+    if (this != &other) {
+        Release();
+        scheduler_ = other.scheduler_;
+        class_ = other.class_;
+        outer_ = other.outer_;
+        granted_ = other.granted_;
+        other.scheduler_ = nullptr;
+    }
+    return *this;
+}
+
+void MtpScheduler::Grant::Release() {
+    if (!scheduler_) return;
+    MtpScheduler* scheduler = scheduler_;
+    scheduler_ = nullptr;
+    scheduler->Release(class_, outer_, granted_);
+}
+
+MtpScheduler::Grant MtpScheduler::Acquire(ZuneMtpOpClass op_class) {
+    if (op_class < 0 || op_class >= ZUNE_MTP_CLASS_COUNT) op_class = ZUNE_MTP_CLASS_CONTROL;
+    const std::thread::id self = std::this_thread::get_id();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (busy_ && owner_ == self) {
+        depth_++;
+        return Grant(this, op_class, false, Clock::time_point{});
+    }
+
+    ClassState& state = classes_[op_class];
+    bool contended = busy_ || granted_ticket_ != 0 ||
+        std::any_of(std::begin(classes_), std::end(classes_),
+                    [](const ClassState& c) { return !c.waiting.empty(); });
+    Clock::time_point queued_at;
+    if (contended) {
+        queued_at = Clock::now();
+        uint64_t ticket = next_ticket_++;
+        state.waiting.push_back(ticket);
+        cv_.wait(lock, [&] { return granted_ticket_ == ticket; });
+        granted_ticket_ = 0;
+    }
+
+    busy_ = true;
+    owner_ = self;
+    depth_ = 1;
+    Clock::time_point now = Clock::now();
+    state.stats.count++;
+    if (contended) {
+        uint64_t wait_us = ElapsedUs(queued_at, now);
+        state.stats.queued++;
+        state.stats.total_wait_us += wait_us;
+        state.stats.max_wait_us = std::max(state.stats.max_wait_us, wait_us);
+    }
+    return Grant(this, op_class, true, now);
+}
+
+void MtpScheduler::Release(ZuneMtpOpClass op_class, bool outer, Clock::time_point granted) {
+    bool handed_off;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!outer) {
+            if (depth_ > 1) depth_--;
+            return;
+        }
+        classes_[op_class].stats.total_hold_us += ElapsedUs(granted, Clock::now());
+        busy_ = false;
+        owner_ = std::thread::id();
+        depth_ = 0;
+        handed_off = GrantNextLocked();
+    }
+    if (handed_off) cv_.notify_all();
+}
+
+bool MtpScheduler::GrantNextLocked() {
+    int top = -1;
+    for (int c = 0; c < ZUNE_MTP_CLASS_COUNT; c++) {
+        if (!classes_[c].waiting.empty()) {
+            top = c;
+            break;
+        }
+    }
+    if (top < 0) return false;
+
+    // The highest-priority class that has waited out its bypass budget goes first
+    int chosen = top;
+    if (max_bypass_ > 0) {
+        for (int c = top + 1; c < ZUNE_MTP_CLASS_COUNT; c++) {
+            if (!classes_[c].waiting.empty() && classes_[c].bypassed >= max_bypass_) {
+                chosen = c;
+                break;
+            }
+        }
+    }
+    for (int c = chosen + 1; c < ZUNE_MTP_CLASS_COUNT; c++) {
+        if (!classes_[c].waiting.empty()) {
+            classes_[c].bypassed++;
+            classes_[c].stats.bypassed++;
+        }
+    }
+
+    ClassState& next = classes_[chosen];
+    next.bypassed = 0;
+    granted_ticket_ = next.waiting.front();
+    next.waiting.pop_front();
+    return true;
+}
+
+bool MtpScheduler::HeldByCurrentThread() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return busy_ && owner_ == std::this_thread::get_id();
+}
+
+void MtpScheduler::SetMaxBypass(unsigned max_bypass) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bypass_ = max_bypass;
+}
+
+void MtpScheduler::Snapshot(ZuneMtpSchedulerStats& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out = ZuneMtpSchedulerStats{};
+    out.max_bypass = max_bypass_;
+    for (int c = 0; c < ZUNE_MTP_CLASS_COUNT; c++) {
+        out.classes[c] = classes_[c].stats;
+        out.classes[c].waiting = static_cast<uint32_t>(classes_[c].waiting.size());
+    }
+}
+
+void MtpScheduler::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& c : classes_) c.stats = ZuneMtpClassStats{};
+}
+
+} // namespace zune
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "xune_sync/xune_sync_api.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace zune {
+
+/// Serializes MTP transactions on one device's session by priority.
+///
+/// MTP runs one transaction at a time and a SendObject cannot be split, so
+/// the scheduler works between operations: whoever holds the session keeps
+/// it until its operation returns, then the highest-priority waiter goes
+/// next (FIFO within a class). A network poll queued behind a track upload
+/// therefore runs after that track's SendObject instead of after the batch.
+///
+/// Fairness: a waiting class that has been overtaken max_bypass times in a
+/// row by higher-priority grants goes next, so a steady stream of network
+/// polls cannot starve an upload. 0 disables aging (strict priority).
+///
+/// Grants are reentrant on the holding thread, so a scheduled method may
+/// call other scheduled methods (or a callback may call back into the API)
+/// without deadlocking; only the outermost grant is queued and timed.
+class MtpScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr unsigned kDefaultMaxBypass = 8;
+
+    /// Exclusive use of the session until destroyed or released
+    class Grant {
+    public:
+        Grant() = default;
+        Grant(Grant&& other) noexcept { *this = std::move(other); }
+        Grant& operator=(Grant&& other) noexcept;
+        Grant(const Grant&) = delete;
+        Grant& operator=(const Grant&) = delete;
+        ~Grant() { Release(); }
+
+        void Release();
+
+    private:
+        friend class MtpScheduler;
+        Grant(MtpScheduler* scheduler, ZuneMtpOpClass op_class, bool outer, Clock::time_point granted)
+            : scheduler_(scheduler), class_(op_class), outer_(outer), granted_(granted) {}
+
+        MtpScheduler* scheduler_ = nullptr;
+        ZuneMtpOpClass class_ = ZUNE_MTP_CLASS_CONTROL;
+        bool outer_ = false;
+        Clock::time_point granted_;
+    };
+
+    /// Block until op_class may use the session
+    Grant Acquire(ZuneMtpOpClass op_class);
+
+    /// Run fn holding a grant. A null scheduler runs fn directly.
+    template <typename Fn>
+    static auto Run(MtpScheduler* scheduler, ZuneMtpOpClass op_class, Fn&& fn) -> decltype(fn()) {
+        Grant grant = scheduler ? scheduler->Acquire(op_class) : Grant();
+        return fn();
+    }
+
+    /// True inside a grant on this thread (where Acquire would nest)
+    bool HeldByCurrentThread() const;
+
+    void SetMaxBypass(unsigned max_bypass);
+    void Snapshot(ZuneMtpSchedulerStats& out) const;
+    void Reset();
+
+private:
+    void Release(ZuneMtpOpClass op_class, bool outer, Clock::time_point granted);
+    // Pick the next waiter; false if none
+    bool GrantNextLocked();
+
+    struct ClassState {
+        std::deque<uint64_t> waiting;   // Tickets, FIFO
+        unsigned bypassed = 0;          // Consecutive grants to higher classes while waiting
+        ZuneMtpClassStats stats = {};
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool busy_ = false;
+    std::thread::id owner_;
+    unsigned depth_ = 0;
+    uint64_t next_ticket_ = 1;
+    uint64_t granted_ticket_ = 0;       // Waiter chosen to go next, 0 if none
+    unsigned max_bypass_ = kDefaultMaxBypass;
+    ClassState classes_[ZUNE_MTP_CLASS_COUNT];
+};
+
+} // namespace zune
@@ -1,6 +1,12 @@
 #include "ZuneMtpWriter.h"
-#include <cli/PosixStreams.h>
+#include "ZuneFileInputStream.h"
+#include "ZuneDeletePlan.h"
+#include "ZuneDescriptorCache.h"
+#include "ZuneFolderCache.h"
+#include "ZunePropertyList.h"
+#include "ZuneTrace.h"
 #include <mtp/ptp/ObjectFormat.h>
+#include <chrono>
 #include <cstring>
 
 namespace zune {
@@ -81,12 +87,20 @@ size_t MtpWriter::GetBatchFormatCount(bool isHD) {
 // ── Pre-Upload Operations ────────────────────────────────────────────────
 
 void MtpWriter::QueryStorageInfo(const SessionPtr& session, uint32_t storageId) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // Pcap: GetStorageInfo (non-fresh devices only)
     try { session->GetStorageInfo(mtp::StorageId(storageId)); } catch (...) {}
 }
 
-RootDiscoveryResult MtpWriter::DiscoverRoot(const SessionPtr& session, uint32_t storageId, bool isHD) {
+RootDiscoveryResult MtpWriter::DiscoverRoot(
+    const SessionPtr& session, uint32_t storageId, bool isHD, FolderCache* folderCache)
+{
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     RootDiscoveryResult result;
+    if (folderCache && folderCache->GetRoot(result) && result.storage_id == storageId &&
+        (!isHD || result.artists_folder != 0))
+        return result;
+    result = {};
     result.storage_id = storageId;
 
     // Pcap: GetObjectHandles root
@@ -104,31 +118,39 @@ RootDiscoveryResult MtpWriter::DiscoverRoot(const SessionPtr& session, uint32_t
                 mtp::Session::Device, mtp::ObjectFormat(0),
                 mtp::ObjectProperty(MtpProp::ObjectFileName), 0, 1);
 
-            for (const auto& [handle, name] : ParsePropertyListNames(name_data)) {
-                if (name == kFolderMusic) result.music_folder = handle;
-                else if (name == kFolderAlbums) result.albums_folder = handle;
-                else if (name == kFolderArtists) result.artists_folder = handle;
-                else if (name == kFolderPlaylists) result.playlists_folder = handle;
-                else if (name == kFolderSeries) result.series_folder = handle;
-                else if (name == kFolderPodcasts) result.podcasts_folder = handle;
-            }
+            // Compared in place: the list also names every root child
+            ForEachProperty(name_data, [&](const PropertyEntry& entry) {
+                PropertyString name = entry.String();
+                uint32_t handle = entry.handle;
+                if (name.Equals(kFolderMusic)) result.music_folder = handle;
+                else if (name.Equals(kFolderAlbums)) result.albums_folder = handle;
+                else if (name.Equals(kFolderArtists)) result.artists_folder = handle;
+                else if (name.Equals(kFolderPlaylists)) result.playlists_folder = handle;
+                else if (name.Equals(kFolderSeries)) result.series_folder = handle;
+                else if (name.Equals(kFolderPodcasts)) result.podcasts_folder = handle;
+            });
         } catch (...) {}
     }
 
     // Create missing essential folders (CreateFolder returns 0 on failure)
     if (result.music_folder == 0)
-        result.music_folder = CreateFolder(session, storageId, 0, kFolderMusic);
+        result.music_folder = CreateFolder(session, storageId, 0, kFolderMusic, folderCache);
     if (result.albums_folder == 0)
-        result.albums_folder = CreateFolder(session, storageId, 0, kFolderAlbums);
+        result.albums_folder = CreateFolder(session, storageId, 0, kFolderAlbums, folderCache);
     if (isHD && result.artists_folder == 0)
-        result.artists_folder = CreateFolder(session, storageId, 0, kFolderArtists);
+        result.artists_folder = CreateFolder(session, storageId, 0, kFolderArtists, folderCache);
     if (result.playlists_folder == 0)
-        result.playlists_folder = CreateFolder(session, storageId, 0, kFolderPlaylists);
+        result.playlists_folder = CreateFolder(session, storageId, 0, kFolderPlaylists, folderCache);
 
+    // Only a complete answer is worth repeating
+    if (folderCache && result.music_folder && result.albums_folder && result.playlists_folder &&
+        (!isHD || result.artists_folder))
+        folderCache->SetRoot(result);
     return result;
 }
 
 void MtpWriter::RootReEnum(const SessionPtr& session) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // Pcap: GetObjPropList(Device, prop=StorageID, depth=1) + GetObjPropList(Device, prop=ObjFileName, depth=1)
     // depth=1 is critical — includes immediate children of root
     try {
@@ -146,9 +168,13 @@ void MtpWriter::RootReEnum(const SessionPtr& session) {
 // ── Folder Discovery & Creation ──────────────────────────────────────────
 
 std::vector<FolderChild> MtpWriter::DiscoverFolderChildren(
-    const SessionPtr& session, uint32_t storageId, uint32_t folderId)
+    const SessionPtr& session, uint32_t storageId, uint32_t folderId,
+    FolderCache* folderCache)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     std::vector<FolderChild> children;
+    if (folderCache && folderCache->GetChildren(folderId, children))
+        return children;
     auto folderObj = mtp::ObjectId(folderId);
     auto storageObj = mtp::StorageId(storageId);
 
@@ -176,6 +202,8 @@ std::vector<FolderChild> MtpWriter::DiscoverFolderChildren(
                 children.push_back({name, handle});
             }
         }
+        // A failed listing is not cached, so the next lookup retries it
+        if (folderCache) folderCache->SetChildren(folderId, children);
     } catch (...) {}
 
     return children;
@@ -183,8 +211,9 @@ std::vector<FolderChild> MtpWriter::DiscoverFolderChildren(
 
 uint32_t MtpWriter::CreateFolder(
     const SessionPtr& session, uint32_t storageId, uint32_t parentId,
-    const std::string& name)
+    const std::string& name, FolderCache* folderCache)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try {
         mtp::ByteArray propList;
         mtp::OutputStream os(propList);
@@ -195,6 +224,8 @@ uint32_t MtpWriter::CreateFolder(
             mtp::StorageId(storageId),
             mtp::ObjectId(parentId),
             mtp::ObjectFormat::Association, 0, propList);
+        if (folderCache && resp.ObjectId.Id != 0)
+            folderCache->FolderCreated(parentId, name, resp.ObjectId.Id);
         return resp.ObjectId.Id;
     } catch (...) {
         return 0;
@@ -202,8 +233,11 @@ uint32_t MtpWriter::CreateFolder(
 }
 
 void MtpWriter::FolderReadback(
-    const SessionPtr& session, uint32_t folderId, uint32_t storageId)
+    const SessionPtr& session, uint32_t folderId, uint32_t storageId,
+    FolderCache* folderCache)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    if (folderCache && !folderCache->MarkReadBack(folderId)) return;
     auto obj = mtp::ObjectId(folderId);
     // PersistentUID read
     try { session->GetObjectPropertyList(
@@ -219,15 +253,18 @@ void MtpWriter::FolderReadback(
 }
 
 void MtpWriter::FirstFolderReadback(
-    const SessionPtr& session, uint32_t folderId, uint32_t storageId, bool isHD)
+    const SessionPtr& session, uint32_t folderId, uint32_t storageId, bool isHD,
+    DescriptorCache* cache, FolderCache* folderCache)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    if (folderCache && !folderCache->MarkReadBack(folderId)) return;
     auto obj = mtp::ObjectId(folderId);
     // Pcap: PersistentUID batch → PersistentUID read → StorageID batch → grp=4 read → GetObjectHandles
-    QueryBatchDescriptors(session, MtpProp::PersistentUID, isHD);
+    QueryBatchDescriptors(session, MtpProp::PersistentUID, isHD, cache);
     try { session->GetObjectPropertyList(
         obj, mtp::ObjectFormat(0),
         mtp::ObjectProperty(MtpProp::PersistentUID), 0, 0); } catch (...) {}
-    QueryBatchDescriptors(session, MtpProp::StorageID, isHD);
+    QueryBatchDescriptors(session, MtpProp::StorageID, isHD, cache);
     try { session->GetObjectPropertyList(
         obj, mtp::ObjectFormat(0),
         mtp::ObjectProperty(0), 4, 0); } catch (...) {}
@@ -239,8 +276,10 @@ void MtpWriter::FirstFolderReadback(
 
 uint32_t MtpWriter::CreateArtistMetadata(
     const SessionPtr& session, uint32_t storageId, uint32_t artistsFolderId,
-    const std::string& name, const uint8_t* guidBytes, size_t guidLen)
+    const std::string& name, const uint8_t* guidBytes, size_t guidLen,
+    bool readBack)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     bool hasGuid = (guidBytes != nullptr && guidLen >= 16);
     uint32_t propCount = hasGuid ? 4 : 3;
 
@@ -262,9 +301,11 @@ uint32_t MtpWriter::CreateArtistMetadata(
     session->SendObject(std::make_shared<mtp::ByteArrayObjectInputStream>(empty));
 
     // Verification read
-    try { session->GetObjectPropertyList(
-        resp.ObjectId, mtp::ObjectFormat(0),
-        mtp::ObjectProperty(0xFFFFFFFF), 0, 0); } catch (...) {}
+    if (readBack) {
+        try { session->GetObjectPropertyList(
+            resp.ObjectId, mtp::ObjectFormat(0),
+            mtp::ObjectProperty(0xFFFFFFFF), 0, 0); } catch (...) {}
+    }
 
     return resp.ObjectId.Id;
 }
@@ -275,6 +316,12 @@ uint32_t MtpWriter::CreateTrack(
     const SessionPtr& session, uint32_t storageId, uint32_t albumFolderId,
     const TrackProperties& props, uint16_t formatCode, uint64_t fileSize)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    return SendTrackPropList(session, storageId, albumFolderId,
+        BuildTrackPropList(props), formatCode, fileSize);
+}
+
+mtp::ByteArray MtpWriter::BuildTrackPropList(const TrackProperties& props) {
     // Unified-with-omission: empty/zero identity fields are omitted from the
     // property list so the device firmware auto-creates sentinel-GUID
     // placeholder artist/album/genre records (matches the original Zune
@@ -327,6 +374,14 @@ uint32_t MtpWriter::CreateTrack(
     if (hasTrack)     WritePropU16(os, MtpProp::Track, props.track_number);
     if (hasGenre)     WritePropString(os, MtpProp::Genre, props.genre);
 
+    return propList;
+}
+
+uint32_t MtpWriter::SendTrackPropList(
+    const SessionPtr& session, uint32_t storageId, uint32_t albumFolderId,
+    const mtp::ByteArray& propList, uint16_t formatCode, uint64_t fileSize)
+{
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     auto resp = session->SendObjectPropList(
         mtp::StorageId(storageId),
         mtp::ObjectId(albumFolderId),
@@ -340,6 +395,7 @@ void MtpWriter::UpdateTrackProperties(
     const SessionPtr& session, uint32_t trackMtpId,
     const TrackProperties& props)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // SetObjectPropList (0x9806). Post-create album-title/album-artist edits
     // are handled on album objects, not by rewriting track AlbumName/AlbumArtist.
     // Artist / Genre / Track / DateAuthored always sent — the caller passes an
@@ -375,6 +431,7 @@ void MtpWriter::UpdateAlbumProperties(
     const SessionPtr& session, uint32_t albumMtpId,
     const AlbumProperties& props)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // HD: Artist, DateAuthored, ZuneCollectionId, DAB9 (artist ref), Name
     // Classic: Artist, ZuneCollectionId, Name
     uint32_t propCount = props.is_hd ? 5 : 3;
@@ -395,13 +452,76 @@ void MtpWriter::UpdateAlbumProperties(
     session->SetObjectPropList(propList);
 }
 
-void MtpWriter::UploadAudioData(const SessionPtr& session, const std::string& filePath) {
-    auto stream = std::make_shared<cli::ObjectInputStream>(filePath);
-    stream->SetTotal(stream->GetSize());
+void MtpWriter::SetUserStateList(
+    const SessionPtr& session, const TrackUserState* states, size_t count)
+{
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    uint32_t propCount = 0;
+    for (size_t i = 0; i < count; ++i)
+        propCount += (states[i].play_count >= 0 ? 1 : 0) + (states[i].rating >= 0 ? 1 : 0);
+    if (propCount == 0) return;
+
+    mtp::ByteArray propList;
+    mtp::OutputStream os(propList);
+    os.Write32(propCount);
+    for (size_t i = 0; i < count; ++i) {
+        const TrackUserState& st = states[i];
+        if (st.play_count >= 0)
+            WritePropU32(os, MtpProp::UseCount, static_cast<uint32_t>(st.play_count), st.object_id);
+        if (st.rating >= 0)
+            WritePropU16(os, MtpProp::Rating, static_cast<uint16_t>(st.rating), st.object_id);
+    }
+
+    session->SetObjectPropList(propList);
+}
+
+void MtpWriter::SetArtistIdList(
+    const SessionPtr& session, uint32_t artistId, const uint32_t* trackIds, size_t count)
+{
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    if (count == 0) return;
+
+    mtp::ByteArray propList;
+    mtp::OutputStream os(propList);
+    os.Write32(static_cast<uint32_t>(count));
+    for (size_t i = 0; i < count; ++i)
+        WritePropU32(os, MtpProp::ArtistId, artistId, trackIds[i]);
+
+    session->SetObjectPropList(propList);
+}
+
+void MtpWriter::SetPlayCount(const SessionPtr& session, uint32_t objectId, uint32_t playCount) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    mtp::ByteArray data;
+    mtp::OutputStream os(data);
+    os.Write32(playCount);
+    session->SetObjectProperty(mtp::ObjectId(objectId), mtp::ObjectProperty::UseCount, data);
+}
+
+void MtpWriter::SetRating(const SessionPtr& session, uint32_t objectId, uint16_t rating) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    mtp::ByteArray data;
+    mtp::OutputStream os(data);
+    os.Write16(rating);
+    session->SetObjectProperty(mtp::ObjectId(objectId), mtp::ObjectProperty::UserRating, data);
+}
+
+void MtpWriter::UploadAudioData(const SessionPtr& session, const std::string& filePath,
+                                TransferStats* stats,
+                                const std::function<void(uint64_t, uint64_t)>& progress) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    auto stream = std::make_shared<FileInputStream>(filePath, stats, progress);
+    TransferStats::Measure(stats, ZUNE_TRANSFER_OP_SEND_OBJECT, stream->GetSize(),
+                           [&] { session->SendObject(stream); });
+}
+
+void MtpWriter::UploadObjectData(const SessionPtr& session, const mtp::IObjectInputStreamPtr& stream) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     session->SendObject(stream);
 }
 
 void MtpWriter::VerifyTrack(const SessionPtr& session, uint32_t trackId) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try { session->GetObjectPropertyList(
         mtp::ObjectId(trackId), mtp::ObjectFormat(0),
         mtp::ObjectProperty(0xFFFFFFFF), 0, 0); } catch (...) {}
@@ -413,6 +533,7 @@ uint32_t MtpWriter::CreateAlbumMetadata(
     const SessionPtr& session, uint32_t storageId, uint32_t albumsFolderId,
     const AlbumProperties& props)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     mtp::ByteArray propList;
     mtp::OutputStream os(propList);
 
@@ -455,6 +576,7 @@ void MtpWriter::SetAlbumArtwork(
     const SessionPtr& session, uint32_t albumObjId,
     const uint8_t* data, size_t size)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     auto obj = mtp::ObjectId(albumObjId);
 
     // Read current artwork value
@@ -472,6 +594,7 @@ void MtpWriter::SetAlbumArtwork(
 }
 
 void MtpWriter::ReadAlbumArtworkCurrent(const SessionPtr& session, uint32_t albumObjId) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try { session->GetObjectProperty(
         mtp::ObjectId(albumObjId), mtp::ObjectProperty(MtpProp::RepSampleData)); } catch (...) {}
 }
@@ -480,6 +603,7 @@ void MtpWriter::SetAlbumReferences(
     const SessionPtr& session, uint32_t albumObjId,
     const uint32_t* trackIds, size_t count)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     mtp::msg::ObjectHandles refs;
     for (size_t i = 0; i < count; ++i)
         refs.ObjectHandles.push_back(mtp::ObjectId(trackIds[i]));
@@ -489,6 +613,7 @@ void MtpWriter::SetAlbumReferences(
 void MtpWriter::VerifyAlbum(
     const SessionPtr& session, uint32_t albumObjId, bool includeParentDesc)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     auto obj = mtp::ObjectId(albumObjId);
     // Subset read (grp=2)
     try { session->GetObjectPropertyList(
@@ -508,33 +633,62 @@ void MtpWriter::VerifyAlbum(
 // ── Finalization ─────────────────────────────────────────────────────────
 
 void MtpWriter::RegisterTrackContext(const SessionPtr& session, const std::string& trackName) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     session->Operation922a(trackName);
 }
 
 // ── Property Descriptor Queries ──────────────────────────────────────────
 
-void MtpWriter::QueryFolderDescriptors(const SessionPtr& session) {
-    try { session->GetObjectPropertiesSupported(mtp::ObjectFormat(MtpFmt::Folder)); } catch (...) {}
+void MtpWriter::QueryPropDesc(
+    const SessionPtr& session, uint16_t prop, uint16_t format, DescriptorCache* cache)
+{
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    if (cache && cache->ShouldSkip(prop, format)) return;
+    auto start = std::chrono::steady_clock::now();
     try { session->GetObjectPropertyDesc(
-        mtp::ObjectProperty(MtpProp::ObjectFileName),
-        mtp::ObjectFormat(MtpFmt::Folder)); } catch (...) {}
+        mtp::ObjectProperty(prop), mtp::ObjectFormat(format)); } catch (...) {}
+    if (cache) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        cache->Record(prop, format, static_cast<uint64_t>(elapsed.count()));
+    }
+}
+
+void MtpWriter::QueryPropsSupported(
+    const SessionPtr& session, uint16_t format, DescriptorCache* cache)
+{
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    if (cache && cache->ShouldSkip(0, format)) return;
+    auto start = std::chrono::steady_clock::now();
+    try { session->GetObjectPropertiesSupported(mtp::ObjectFormat(format)); } catch (...) {}
+    if (cache) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        cache->Record(0, format, static_cast<uint64_t>(elapsed.count()));
+    }
+}
+
+void MtpWriter::QueryFolderDescriptors(const SessionPtr& session, DescriptorCache* cache) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    QueryPropsSupported(session, MtpFmt::Folder, cache);
+    QueryPropDesc(session, MtpProp::ObjectFileName, MtpFmt::Folder, cache);
 }
 
 void MtpWriter::QueryBatchDescriptors(
-    const SessionPtr& session, uint16_t propCode, bool isHD)
+    const SessionPtr& session, uint16_t propCode, bool isHD, DescriptorCache* cache)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     const uint16_t* formats = GetBatchFormats(isHD);
     size_t count = GetBatchFormatCount(isHD);
     for (size_t i = 0; i < count; ++i) {
-        try { session->GetObjectPropertyDesc(
-            mtp::ObjectProperty(propCode),
-            mtp::ObjectFormat(formats[i])); } catch (...) {}
+        QueryPropDesc(session, propCode, formats[i], cache);
     }
 }
 
 void MtpWriter::QueryTrackDescriptors(
-    const SessionPtr& session, uint16_t formatCode, bool isHD)
+    const SessionPtr& session, uint16_t formatCode, bool isHD, DescriptorCache* cache)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // Exact order from pcap
     const uint16_t classic_props[] = {
         MtpProp::MetaGenre, MtpProp::ObjectFileName, MtpProp::AlbumName,
@@ -552,21 +706,20 @@ void MtpWriter::QueryTrackDescriptors(
     };
     const uint16_t* props = isHD ? hd_props : classic_props;
     size_t count = isHD ? 16 : 14;
-    auto fmt = mtp::ObjectFormat(formatCode);
     for (size_t i = 0; i < count; ++i) {
-        try { session->GetObjectPropertyDesc(mtp::ObjectProperty(props[i]), fmt); } catch (...) {}
+        QueryPropDesc(session, props[i], formatCode, cache);
     }
 }
 
-void MtpWriter::QueryAlbumDescriptors(const SessionPtr& session, bool isHD) {
-    auto fmt = mtp::ObjectFormat(MtpFmt::AbstractAlbum);
+void MtpWriter::QueryAlbumDescriptors(const SessionPtr& session, bool isHD, DescriptorCache* cache) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     if (isHD) {
         const uint16_t props[] = {
             MtpProp::Artist, MtpProp::DateAuthored, MtpProp::ZuneCollectionId,
             MtpProp::ObjectFileName, MtpProp::ArtistId, MtpProp::Name,
         };
         for (auto p : props) {
-            try { session->GetObjectPropertyDesc(mtp::ObjectProperty(p), fmt); } catch (...) {}
+            QueryPropDesc(session, p, MtpFmt::AbstractAlbum, cache);
         }
     } else {
         const uint16_t props[] = {
@@ -574,28 +727,26 @@ void MtpWriter::QueryAlbumDescriptors(const SessionPtr& session, bool isHD) {
             MtpProp::ObjectFileName, MtpProp::Name,
         };
         for (auto p : props) {
-            try { session->GetObjectPropertyDesc(mtp::ObjectProperty(p), fmt); } catch (...) {}
+            QueryPropDesc(session, p, MtpFmt::AbstractAlbum, cache);
         }
     }
 }
 
-void MtpWriter::QueryArtistDescriptors(const SessionPtr& session) {
-    auto fmt = mtp::ObjectFormat(MtpFmt::ArtistMeta);
+void MtpWriter::QueryArtistDescriptors(const SessionPtr& session, DescriptorCache* cache) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     const uint16_t props[] = {
         MtpProp::ZuneCollectionId, MtpProp::ObjectFileName,
         MtpProp::DA97, MtpProp::Name,
     };
     for (auto p : props) {
-        try { session->GetObjectPropertyDesc(mtp::ObjectProperty(p), fmt); } catch (...) {}
+        QueryPropDesc(session, p, MtpFmt::ArtistMeta, cache);
     }
 }
 
-void MtpWriter::QueryArtworkDescriptors(const SessionPtr& session) {
-    auto fmt = mtp::ObjectFormat(MtpFmt::AbstractAlbum);
-    try { session->GetObjectPropertyDesc(
-        mtp::ObjectProperty(MtpProp::RepSampleData), fmt); } catch (...) {}
-    try { session->GetObjectPropertyDesc(
-        mtp::ObjectProperty(MtpProp::RepSampleFormat), fmt); } catch (...) {}
+void MtpWriter::QueryArtworkDescriptors(const SessionPtr& session, DescriptorCache* cache) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    QueryPropDesc(session, MtpProp::RepSampleData, MtpFmt::AbstractAlbum, cache);
+    QueryPropDesc(session, MtpProp::RepSampleFormat, MtpFmt::AbstractAlbum, cache);
 }
 
 // ── Property List Parsing ────────────────────────────────────────────────
@@ -604,41 +755,9 @@ std::vector<std::pair<uint32_t, std::string>> MtpWriter::ParsePropertyListNames(
     const mtp::ByteArray& data)
 {
     std::vector<std::pair<uint32_t, std::string>> entries;
-    if (data.size() < 4) return entries;
-
-    uint32_t n;
-    std::memcpy(&n, data.data(), sizeof(n));
-    size_t off = 4;
-
-    for (uint32_t i = 0; i < n && off + 8 <= data.size(); ++i) {
-        uint32_t handle;
-        std::memcpy(&handle, data.data() + off, sizeof(handle));
-        off += 4 + 2 + 2; // handle + prop code + data type
-
-        std::string name;
-        if (off < data.size()) {
-            uint8_t nchars = data[off++];
-            if (nchars > 0 && off + nchars * 2 <= data.size()) {
-                for (uint8_t c = 0; c < nchars; ++c) {
-                    uint16_t ch;
-                    std::memcpy(&ch, data.data() + off + c * 2, sizeof(ch));
-                    if (ch == 0) break;
-                    if (ch < 0x80) {
-                        name += static_cast<char>(ch);
-                    } else if (ch < 0x800) {
-                        name += static_cast<char>(0xC0 | (ch >> 6));
-                        name += static_cast<char>(0x80 | (ch & 0x3F));
-                    } else {
-                        name += static_cast<char>(0xE0 | (ch >> 12));
-                        name += static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
-                        name += static_cast<char>(0x80 | (ch & 0x3F));
-                    }
-                }
-                off += nchars * 2;
-            }
-        }
-        entries.emplace_back(handle, std::move(name));
-    }
+    ForEachProperty(data, [&](const PropertyEntry& entry) {
+        entries.emplace_back(entry.handle, entry.String().ToUtf8());
+    });
     return entries;
 }
 
@@ -648,6 +767,7 @@ uint32_t MtpWriter::CreatePodcastSeries(
     const SessionPtr& session, uint32_t storageId, uint32_t seriesFolderId,
     const PodcastSeriesProperties& props)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // 6 properties: IsPodcast, DA9D, Artist, ObjectFileName, SourceURL, Name
     mtp::ByteArray propList;
     mtp::OutputStream os(propList);
@@ -681,6 +801,7 @@ uint32_t MtpWriter::CreatePodcastEpisode(
     const SessionPtr& session, uint32_t storageId, uint32_t episodeFolderId,
     const PodcastEpisodeProperties& props, uint64_t fileSize)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // 12 properties matching pcap order
     mtp::ByteArray propList;
     mtp::OutputStream os(propList);
@@ -713,6 +834,7 @@ void MtpWriter::SetSeriesArtwork(
     const SessionPtr& session, uint32_t seriesObjId,
     const uint8_t* data, size_t size)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     auto obj = mtp::ObjectId(seriesObjId);
 
     // Read current artwork value
@@ -730,28 +852,29 @@ void MtpWriter::SetSeriesArtwork(
 }
 
 void MtpWriter::VerifySeries(const SessionPtr& session, uint32_t seriesObjId) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try { session->GetObjectPropertyList(
         mtp::ObjectId(seriesObjId), mtp::ObjectFormat(0),
         mtp::ObjectProperty(0xFFFFFFFF), 0, 0); } catch (...) {}
 }
 
-void MtpWriter::QuerySeriesDescriptors(const SessionPtr& session) {
+void MtpWriter::QuerySeriesDescriptors(const SessionPtr& session, DescriptorCache* cache) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // 5 properties observed in pcap for format 0xBA0B
-    auto fmt = mtp::ObjectFormat(MtpFmt::PodcastSeries);
     const uint16_t props[] = {
         MtpProp::IsPodcast, MtpProp::DA9D, MtpProp::Artist,
         MtpProp::ObjectFileName, MtpProp::SourceURL,
     };
     for (auto p : props) {
-        try { session->GetObjectPropertyDesc(mtp::ObjectProperty(p), fmt); } catch (...) {}
+        QueryPropDesc(session, p, MtpFmt::PodcastSeries, cache);
     }
 }
 
 void MtpWriter::QueryEpisodeDescriptors(
-    const SessionPtr& session, uint16_t formatCode)
+    const SessionPtr& session, uint16_t formatCode, DescriptorCache* cache)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     // 12 properties observed in pcap for MP3/WMV podcast episodes
-    auto fmt = mtp::ObjectFormat(formatCode);
     const uint16_t props[] = {
         MtpProp::SourceURL, MtpProp::ObjectFileName, MtpProp::DD62,
         MtpProp::SeriesName, MtpProp::DA9B, MtpProp::MetaGenre,
@@ -759,7 +882,7 @@ void MtpWriter::QueryEpisodeDescriptors(
         MtpProp::Artist, MtpProp::DateAuthored, MtpProp::Description,
     };
     for (auto p : props) {
-        try { session->GetObjectPropertyDesc(mtp::ObjectProperty(p), fmt); } catch (...) {}
+        QueryPropDesc(session, p, formatCode, cache);
     }
 }
 
@@ -803,6 +926,7 @@ uint32_t MtpWriter::CreatePlaylist(
     const std::string& name, const std::string& guid,
     const uint32_t* trackIds, size_t trackCount)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try {
         auto guidBytes = GuidStringToBytes(guid);
 
@@ -849,6 +973,7 @@ bool MtpWriter::UpdatePlaylistTracks(
     const SessionPtr& session, uint32_t playlistMtpId,
     const uint32_t* trackIds, size_t trackCount)
 {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try {
         mtp::msg::ObjectHandles handles;
         if (trackIds) {
@@ -862,22 +987,65 @@ bool MtpWriter::UpdatePlaylistTracks(
     }
 }
 
-bool MtpWriter::DeletePlaylist(const SessionPtr& session, uint32_t playlistMtpId) {
+bool MtpWriter::DeletePlaylist(const SessionPtr& session, uint32_t playlistMtpId,
+                               FolderCache* folderCache) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try {
         session->DeleteObject(mtp::ObjectId(playlistMtpId));
+        if (folderCache) folderCache->ObjectDeleted(playlistMtpId);
         return true;
     } catch (...) {
         return false;
     }
 }
 
-int MtpWriter::DeleteObject(const SessionPtr& session, uint32_t objectHandle) {
+int MtpWriter::DeleteObject(const SessionPtr& session, uint32_t objectHandle,
+                           FolderCache* folderCache) {
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
     try {
         session->DeleteObject(mtp::ObjectId(objectHandle));
+        if (folderCache) folderCache->ObjectDeleted(objectHandle);
         return 0;
     } catch (...) {
         return -1;
     }
 }
 
+std::vector<uint32_t> MtpWriter::DeleteObjects(
+    const SessionPtr& session, const DeletePlan& plan, FolderCache* folderCache,
+    const std::function<void(uint32_t)>& onDeleted)
+{
+    ZUNE_TRACE_SPAN("MtpWriter", __func__);
+    std::vector<uint32_t> failed;
+    auto deleteOne = [&](uint32_t handle) {
+        if (DeleteObject(session, handle, folderCache) != 0) return false;
+        if (onDeleted) onDeleted(handle);
+        return true;
+    };
+
+    for (const DeletePlan::Step& step : plan.steps) {
+        if (deleteOne(step.handle)) {
+            for (uint32_t handle : step.covered) {
+                if (folderCache) folderCache->ObjectDeleted(handle);
+                if (onDeleted) onDeleted(handle);
+            }
+            continue;
+        }
+        if (step.covered.empty()) {
+            failed.push_back(step.handle);
+            continue;
+        }
+
+        // The device would not take the folder with its contents
+        size_t before = failed.size();
+        for (uint32_t handle : step.covered) {
+            if (!deleteOne(handle)) failed.push_back(handle);
+        }
+        if (failed.size() != before || !deleteOne(step.handle)) {
+            failed.push_back(step.handle);
+        }
+    }
+    return failed;
+}
+
 } // namespace zune
@@ -16,77 +16,19 @@
 #include <mtp/ptp/ObjectProperty.h>
 #include <mtp/ptp/OutputStream.h>
 #include <mtp/ptp/ByteArrayObjectStream.h>
+#include "ZuneMtpWriterTypes.h"
 #include <string>
 #include <vector>
 #include <map>
 #include <cstdint>
+#include <functional>
 
 namespace zune {
 
-// ── Result Structures ────────────────────────────────────────────────────
-
-struct RootDiscoveryResult {
-    uint32_t music_folder = 0;
-    uint32_t albums_folder = 0;
-    uint32_t artists_folder = 0;
-    uint32_t playlists_folder = 0;
-    uint32_t series_folder = 0;
-    uint32_t podcasts_folder = 0;
-    uint32_t storage_id = 0;
-    int root_object_count = 0;
-};
-
-struct FolderChild {
-    std::string name;
-    uint32_t handle = 0;
-};
-
-struct TrackProperties {
-    std::string filename;
-    std::string title;
-    std::string artist;
-    std::string album_name;
-    std::string album_artist;
-    std::string genre;
-    std::string date_authored;   // Format: "YYYYMMDDTHHMMSS.0"
-    uint32_t duration_ms = 0;
-    uint16_t track_number = 0;
-    int rating = -1;             // -1 = omit, 0+ = include
-    int play_count = -1;         // -1 = omit, 0+ = UseCount (0xDC91) Uint32
-    // HD-only
-    uint32_t disc_number = 0;    // 0xDAB8 disc number (HD only, Uint32: 1=disc1, 2=disc2)
-    uint32_t artist_meta_id = 0; // 0xDAB9 reference
-    bool is_hd = false;
-};
-
-struct AlbumProperties {
-    std::string artist;
-    std::string album_name;
-    std::string date_authored;   // Format: "YYYYMMDDTHHMMSS.0" (HD only)
-    uint32_t artist_meta_id = 0; // 0xDAB9 reference (HD only)
-    bool is_hd = false;
-};
-
-struct PodcastSeriesProperties {
-    std::string name;
-    std::string artist;          // Podcast author
-    std::string feed_url;        // RSS feed URL (written as AUINT16)
-    std::string filename;        // e.g. "Series Name.ser"
-};
-
-struct PodcastEpisodeProperties {
-    std::string title;
-    std::string artist;          // Episode author
-    std::string series_name;     // Parent series name (0xDA9A)
-    std::string date_authored;   // Format: "YYYYMMDDTHHMMSS.0"
-    std::string description;     // Episode description (written as AUINT16)
-    std::string source_url;      // Episode download URL (written as AUINT16)
-    std::string filename;        // e.g. "Episode Title.mp3"
-    uint32_t duration_ms = 0;
-    uint32_t series_handle = 0;  // MTP handle of parent 0xBA0B object
-    uint16_t format_code = 0;    // MTP format: 0x3009 (MP3), 0xB981 (WMV), etc.
-    bool is_video = false;       // false=MetaGenre 64 (audio), true=MetaGenre 65 (video)
-};
+class TransferStats;
+class DescriptorCache;
+class FolderCache;
+struct DeletePlan;
 
 // ── Format Lists (from pcap) ─────────────────────────────────────────────
 
@@ -175,31 +117,51 @@ public:
 
     // ── Pre-Upload ───────────────────────────────────────────────
     static void QueryStorageInfo(const SessionPtr& session, uint32_t storageId);
-    static RootDiscoveryResult DiscoverRoot(const SessionPtr& session, uint32_t storageId, bool isHD);
+    // With a folder cache, discovery already answered this session is
+    // returned from it without touching the device, folders created or
+    // objects deleted here keep it current, and a folder is read back once.
+    static RootDiscoveryResult DiscoverRoot(
+        const SessionPtr& session, uint32_t storageId, bool isHD, FolderCache* folderCache = nullptr);
     static void RootReEnum(const SessionPtr& session);
 
     // ── Folder Discovery & Creation ──────────────────────────────
     static std::vector<FolderChild> DiscoverFolderChildren(
-        const SessionPtr& session, uint32_t storageId, uint32_t folderId);
+        const SessionPtr& session, uint32_t storageId, uint32_t folderId,
+        FolderCache* folderCache = nullptr);
     static uint32_t CreateFolder(
         const SessionPtr& session, uint32_t storageId, uint32_t parentId,
-        const std::string& name);
+        const std::string& name, FolderCache* folderCache = nullptr);
     static void FolderReadback(
-        const SessionPtr& session, uint32_t folderId, uint32_t storageId);
+        const SessionPtr& session, uint32_t folderId, uint32_t storageId,
+        FolderCache* folderCache = nullptr);
     static void FirstFolderReadback(
         const SessionPtr& session, uint32_t folderId, uint32_t storageId,
-        bool isHD);
+        bool isHD, DescriptorCache* cache = nullptr, FolderCache* folderCache = nullptr);
 
     // ── Artist Metadata (HD Only) ────────────────────────────────
+    // readBack false leaves out the property read that follows creation
+    // (bulk backfills, where nothing uses it)
     static uint32_t CreateArtistMetadata(
         const SessionPtr& session, uint32_t storageId, uint32_t artistsFolderId,
-        const std::string& name, const uint8_t* guidBytes, size_t guidLen);
+        const std::string& name, const uint8_t* guidBytes, size_t guidLen,
+        bool readBack = true);
 
     // ── Track Operations ─────────────────────────────────────────
     static uint32_t CreateTrack(
         const SessionPtr& session, uint32_t storageId, uint32_t albumFolderId,
         const TrackProperties& props, uint16_t formatCode, uint64_t fileSize);
-    static void UploadAudioData(const SessionPtr& session, const std::string& filePath);
+    // CreateTrack in two halves, so the property list can be built off the USB thread
+    static mtp::ByteArray BuildTrackPropList(const TrackProperties& props);
+    static uint32_t SendTrackPropList(
+        const SessionPtr& session, uint32_t storageId, uint32_t albumFolderId,
+        const mtp::ByteArray& propList, uint16_t formatCode, uint64_t fileSize);
+    // stats (optional) counts the SendObject and drives its progress callback;
+    // progress (optional) gets the bytes sent so far and the file size
+    static void UploadAudioData(const SessionPtr& session, const std::string& filePath,
+                                TransferStats* stats = nullptr,
+                                const std::function<void(uint64_t, uint64_t)>& progress = nullptr);
+    // UploadAudioData from any stream (e.g. a preloaded buffer)
+    static void UploadObjectData(const SessionPtr& session, const mtp::IObjectInputStreamPtr& stream);
     static void VerifyTrack(const SessionPtr& session, uint32_t trackId);
 
     // ── Property Updates (SetObjectPropList 0x9806) ───────────────
@@ -209,6 +171,17 @@ public:
     static void UpdateAlbumProperties(
         const SessionPtr& session, uint32_t albumMtpId,
         const AlbumProperties& props);
+    // Every UseCount / Rating of states in one SetObjectPropList; nothing is
+    // sent if no state has a value. Throws if the device rejects the list.
+    static void SetUserStateList(
+        const SessionPtr& session, const TrackUserState* states, size_t count);
+    // ArtistId (0xDAB9) = artistId on every track in one SetObjectPropList.
+    // Throws if the device rejects the list.
+    static void SetArtistIdList(
+        const SessionPtr& session, uint32_t artistId, const uint32_t* trackIds, size_t count);
+    // Single-property fallbacks (SetObjectPropValue 0x1016)
+    static void SetPlayCount(const SessionPtr& session, uint32_t objectId, uint32_t playCount);
+    static void SetRating(const SessionPtr& session, uint32_t objectId, uint16_t rating);
 
     // ── Album Metadata Operations ────────────────────────────────
     static uint32_t CreateAlbumMetadata(
@@ -250,11 +223,11 @@ public:
     static void VerifySeries(const SessionPtr& session, uint32_t seriesObjId);
 
     // Query property descriptors for podcast series format (0xBA0B).
-    static void QuerySeriesDescriptors(const SessionPtr& session);
+    static void QuerySeriesDescriptors(const SessionPtr& session, DescriptorCache* cache = nullptr);
 
     // Query property descriptors for podcast episode format (MP3 or WMV).
     static void QueryEpisodeDescriptors(
-        const SessionPtr& session, uint16_t formatCode);
+        const SessionPtr& session, uint16_t formatCode, DescriptorCache* cache = nullptr);
 
     // ── Playlist Operations ──────────────────────────────────────
     // Create a playlist (.pla object) on the device.
@@ -270,20 +243,33 @@ public:
         const uint32_t* trackIds, size_t trackCount);
 
     // Delete a playlist from the device.
-    static bool DeletePlaylist(const SessionPtr& session, uint32_t playlistMtpId);
+    static bool DeletePlaylist(const SessionPtr& session, uint32_t playlistMtpId,
+                               FolderCache* folderCache = nullptr);
 
     // ── Object Deletion ─────────────────────────────────────────
-    static int DeleteObject(const SessionPtr& session, uint32_t objectHandle);
+    static int DeleteObject(const SessionPtr& session, uint32_t objectHandle,
+                            FolderCache* folderCache = nullptr);
+
+    // Delete a plan's objects in its order (see ZuneDeletePlan.h). A
+    // collapsed folder the device refuses is retried once its contents
+    // have been deleted one by one. onDeleted is called for every object
+    // gone, a collapsed folder's contents included. Returns the handles
+    // still on the device.
+    static std::vector<uint32_t> DeleteObjects(
+        const SessionPtr& session, const DeletePlan& plan, FolderCache* folderCache,
+        const std::function<void(uint32_t)>& onDeleted);
 
     // ── Property Descriptor Queries ──────────────────────────────
-    static void QueryFolderDescriptors(const SessionPtr& session);
+    // With a cache, queries it already holds for this firmware are skipped
+    // (when skipping is enabled) and issued ones are recorded in it.
+    static void QueryFolderDescriptors(const SessionPtr& session, DescriptorCache* cache = nullptr);
     static void QueryBatchDescriptors(
-        const SessionPtr& session, uint16_t propCode, bool isHD);
+        const SessionPtr& session, uint16_t propCode, bool isHD, DescriptorCache* cache = nullptr);
     static void QueryTrackDescriptors(
-        const SessionPtr& session, uint16_t formatCode, bool isHD);
-    static void QueryAlbumDescriptors(const SessionPtr& session, bool isHD);
-    static void QueryArtistDescriptors(const SessionPtr& session);
-    static void QueryArtworkDescriptors(const SessionPtr& session);
+        const SessionPtr& session, uint16_t formatCode, bool isHD, DescriptorCache* cache = nullptr);
+    static void QueryAlbumDescriptors(const SessionPtr& session, bool isHD, DescriptorCache* cache = nullptr);
+    static void QueryArtistDescriptors(const SessionPtr& session, DescriptorCache* cache = nullptr);
+    static void QueryArtworkDescriptors(const SessionPtr& session, DescriptorCache* cache = nullptr);
 
 private:
     // Property list writing helpers — handle defaults to 0 for creation (SendObjPropList)
@@ -295,11 +281,16 @@ private:
     // Write a UTF-8 string as AUINT16 (array of uint16, UTF-16LE encoded)
     static void WritePropAuint16String(mtp::OutputStream& os, uint16_t prop, const std::string& value, uint32_t handle = 0);
 
+    // One GetObjectPropDesc (or GetObjectPropsSupported, prop 0), errors ignored
+    static void QueryPropDesc(const SessionPtr& session, uint16_t prop, uint16_t format, DescriptorCache* cache);
+    static void QueryPropsSupported(const SessionPtr& session, uint16_t format, DescriptorCache* cache);
+
     // Batch format helpers
     static const uint16_t* GetBatchFormats(bool isHD);
     static size_t GetBatchFormatCount(bool isHD);
 
     // Parse MTP ObjectPropertyList response into (handle, name) pairs
+    // (see ZunePropertyList.h to walk one without converting every name)
     static std::vector<std::pair<uint32_t, std::string>> ParsePropertyListNames(
         const mtp::ByteArray& data);
 
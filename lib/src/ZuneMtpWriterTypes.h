@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ * ZuneMtpWriterTypes — Plain property and result structures taken and
+ * returned by MtpWriter. Kept free of MTP headers so host-side code (the
+ * tracked library model, tests) can use them without the AFTL session types.
+ */
+
+#include <string>
+#include <cstdint>
+
+namespace zune {
+
+// ── Result Structures ────────────────────────────────────────────────────
+
+struct RootDiscoveryResult {
+    uint32_t music_folder = 0;
+    uint32_t albums_folder = 0;
+    uint32_t artists_folder = 0;
+    uint32_t playlists_folder = 0;
+    uint32_t series_folder = 0;
+    uint32_t podcasts_folder = 0;
+    uint32_t storage_id = 0;
+    int root_object_count = 0;
+};
+
+struct FolderChild {
+    std::string name;
+    uint32_t handle = 0;
+};
+
+struct TrackProperties {
+    std::string filename;
+    std::string title;
+    std::string artist;
+    std::string album_name;
+    std::string album_artist;
+    std::string genre;
+    std::string date_authored;   // Format: "YYYYMMDDTHHMMSS.0"
+    uint32_t duration_ms = 0;
+    uint16_t track_number = 0;
+    int rating = -1;             // -1 = omit, 0+ = include
+    int play_count = -1;         // -1 = omit, 0+ = UseCount (0xDC91) Uint32
+    // HD-only
+    uint32_t disc_number = 0;    // 0xDAB8 disc number (HD only, Uint32: 1=disc1, 2=disc2)
+    uint32_t artist_meta_id = 0; // 0xDAB9 reference
+    bool is_hd = false;
+};
+
+// Play count / rating written back for one track; -1 leaves a value alone
+struct TrackUserState {
+    uint32_t object_id = 0;
+    int play_count = -1;         // UseCount (0xDC91) Uint32
+    int rating = -1;             // Rating (0xDC8A) Uint16
+};
+
+struct AlbumProperties {
+    std::string artist;
+    std::string album_name;
+    std::string date_authored;   // Format: "YYYYMMDDTHHMMSS.0" (HD only)
+    uint32_t artist_meta_id = 0; // 0xDAB9 reference (HD only)
+    bool is_hd = false;
+};
+
+struct PodcastSeriesProperties {
+    std::string name;
+    std::string artist;          // Podcast author
+    std::string feed_url;        // RSS feed URL (written as AUINT16)
+    std::string filename;        // e.g. "Series Name.ser"
+};
+
+struct PodcastEpisodeProperties {
+    std::string title;
+    std::string artist;          // Episode author
+    std::string series_name;     // Parent series name (0xDA9A)
+    std::string date_authored;   // Format: "YYYYMMDDTHHMMSS.0"
+    std::string description;     // Episode description (written as AUINT16)
+    std::string source_url;      // Episode download URL (written as AUINT16)
+    std::string filename;        // e.g. "Episode Title.mp3"
+    uint32_t duration_ms = 0;
+    uint32_t series_handle = 0;  // MTP handle of parent 0xBA0B object
+    uint16_t format_code = 0;    // MTP format: 0x3009 (MP3), 0xB981 (WMV), etc.
+    bool is_video = false;       // false=MetaGenre 64 (audio), true=MetaGenre 65 (video)
+};
+
+} // namespace zune
@@ -0,0 +1,342 @@
+#include "ZuneMusicLibrarySink.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
+namespace zune {
+
+namespace {
+
+void FreeAlbum(const ZuneMusicAlbum& album) {
+    free((void*)album.title);
+    free((void*)album.artist_name);
+    free((void*)album.artist_guid);
+    free((void*)album.alb_reference);
+}
+
+void FreeArtist(const ZuneMusicArtist& artist) {
+    free((void*)artist.name);
+    free((void*)artist.filename);
+    free((void*)artist.guid);
+}
+
+void FreeGenre(const ZuneMusicGenre& genre) {
+    free((void*)genre.name);
+}
+
+void FreePodcastShow(const ZunePodcastShow& show) {
+    free((void*)show.name);
+    free((void*)show.ser_filename);
+    free((void*)show.author);
+    free((void*)show.feed_url);
+}
+
+// Move the collected records into a new exact-size array
+template <typename T>
+T* ReleaseArray(std::vector<T>& records, uint32_t& count) {
+    T* out = new T[records.size()]{};
+    std::copy(records.begin(), records.end(), out);
+    count = static_cast<uint32_t>(records.size());
+    records.clear();
+    return out;
+}
+
+} // namespace
+
+MusicLibrarySink::~MusicLibrarySink() {
+    Reset();
+}
+
+void MusicLibrarySink::Begin(const zmdb::ZMDBExtractionPlan& plan) {
+    Reset();
+    library_ = new ZuneMusicLibrary{};
+    // Zero-initialized, so a partly filled library frees safely
+    tracks_capacity_ = static_cast<uint32_t>(std::max(plan.tracks, 0));
+    library_->tracks = new ZuneMusicTrack[tracks_capacity_]{};
+    playlists_capacity_ = static_cast<uint32_t>(std::max(plan.playlists, 0));
+    library_->playlists = new ZuneMusicPlaylist[playlists_capacity_]{};
+    podcasts_capacity_ = static_cast<uint32_t>(std::max(plan.podcasts, 0));
+    library_->podcast_episodes = podcasts_capacity_ > 0
+        ? new ZunePodcastEpisode[podcasts_capacity_]{}
+        : nullptr;
+}
+
+void MusicLibrarySink::OnTrack(zmdb::ZMDBTrack&& track) {
+    AddTrack(track);
+}
+
+void MusicLibrarySink::OnPlaylist(zmdb::ZMDBPlaylist&& playlist) {
+    AddPlaylist(playlist);
+}
+
+void MusicLibrarySink::OnPodcast(zmdb::ZMDBPodcast&& podcast) {
+    AddPodcast(podcast);
+}
+
+void MusicLibrarySink::OnPodcastShow(uint32_t atom_id, zmdb::ZMDBPodcastShow&& show) {
+    AddPodcastShow(atom_id, show);
+}
+
+void MusicLibrarySink::OnAlbum(uint32_t, zmdb::ZMDBAlbum&& album) {
+    AddAlbum(album);
+}
+
+void MusicLibrarySink::OnArtist(uint32_t, zmdb::ZMDBArtist&& artist) {
+    AddArtist(artist);
+}
+
+void MusicLibrarySink::OnGenre(uint32_t, zmdb::ZMDBGenre&& genre) {
+    AddGenre(genre);
+}
+
+void MusicLibrarySink::Reset() {
+    FreeMusicLibrary(library_);
+    library_ = nullptr;
+    tracks_capacity_ = 0;
+    playlists_capacity_ = 0;
+    podcasts_capacity_ = 0;
+    for (const auto& album : albums_) FreeAlbum(album);
+    albums_.clear();
+    for (const auto& artist : artists_) FreeArtist(artist);
+    artists_.clear();
+    for (const auto& genre : genres_) FreeGenre(genre);
+    genres_.clear();
+    for (const auto& [atom_id, show] : podcast_shows_) FreePodcastShow(show);
+    podcast_shows_.clear();
+    shared_strings_.clear();
+}
+
+void MusicLibrarySink::Add(const zmdb::ZMDBLibrary& library) {
+    zmdb::ZMDBExtractionPlan plan;
+    plan.tracks = library.track_count;
+    plan.playlists = library.playlist_count;
+    plan.podcasts = library.podcast_count;
+    Begin(plan);
+
+    for (int i = 0; i < library.track_count; i++) AddTrack(library.tracks[i]);
+    for (int i = 0; i < library.playlist_count; i++) AddPlaylist(library.playlists[i]);
+    for (int i = 0; i < library.podcast_count; i++) AddPodcast(library.podcasts[i]);
+    for (const auto& [atom_id, show] : library.podcast_show_metadata) AddPodcastShow(atom_id, show);
+    for (const auto& [atom_id, album] : library.album_metadata) AddAlbum(album);
+    for (const auto& [atom_id, artist] : library.artist_metadata) AddArtist(artist);
+    for (const auto& [atom_id, genre] : library.genre_metadata) AddGenre(genre);
+}
+
+ZuneMusicLibrary* MusicLibrarySink::Release(
+    const std::unordered_map<std::string, uint32_t>& alb_to_objectid)
+{
+    // Nothing parsed (not a ZMDB): an empty library, as before
+    if (!library_) {
+        Begin(zmdb::ZMDBExtractionPlan{});
+    }
+
+    library_->albums = ReleaseArray(albums_, library_->album_count);
+    library_->artists = ReleaseArray(artists_, library_->artist_count);
+    library_->genres = ReleaseArray(genres_, library_->genre_count);
+
+    library_->podcast_shows = new ZunePodcastShow[podcast_shows_.size()]{};
+    for (const auto& [atom_id, show] : podcast_shows_) {
+        library_->podcast_shows[library_->podcast_show_count++] = show;
+    }
+    podcast_shows_.clear();
+
+    library_->artworks = new ZuneAlbumArtwork[alb_to_objectid.size()]{};
+    for (const auto& [alb_ref, object_id] : alb_to_objectid) {
+        auto& out = library_->artworks[library_->artwork_count++];
+        out.alb_reference = strdup(alb_ref.c_str());
+        out.mtp_object_id = object_id;
+    }
+
+    // Sized for the video descriptor too; no episodes means no array
+    if (library_->podcast_episode_count == 0) {
+        delete[] library_->podcast_episodes;
+        library_->podcast_episodes = nullptr;
+    }
+
+    ZuneMusicLibrary* result = library_;
+    library_ = nullptr;
+    Reset();
+    return result;
+}
+
+const char* MusicLibrarySink::StrdupShared(const zmdb::SharedString& s) {
+    auto [it, inserted] = shared_strings_.try_emplace(s.identity(), nullptr);
+    if (inserted)
+        it->second = strdup(s.c_str());
+    return it->second;
+}
+
+void MusicLibrarySink::AddTrack(const zmdb::ZMDBTrack& t) {
+    if (!library_ || library_->track_count >= tracks_capacity_) return;
+    // Counted before filling so a failure part way frees what was set
+    auto& out = library_->tracks[library_->track_count++];
+    out.title = strdup(t.title.c_str());
+    out.artist_name = StrdupShared(t.artist_name);
+    out.artist_guid = StrdupShared(t.artist_guid);
+    out.genre = StrdupShared(t.genre);
+    out.track_number = t.track_number;
+    out.disc_number = t.disc_number;
+    out.duration_ms = t.duration_ms;
+    out.file_size_bytes = t.file_size_bytes;
+    out.album_ref = t.album_ref;
+    out.atom_id = t.atom_id;
+    out.genre_ref = t.genre_ref;
+    out.playcount = t.playcount;
+    out.skip_count = t.skip_count;
+    out.codec_id = t.codec_id;
+    out.rating = t.rating;
+    out.on_device_playcount = t.on_device_playcount;
+    out.last_played_timestamp = t.last_played_timestamp;
+}
+
+void MusicLibrarySink::AddPlaylist(const zmdb::ZMDBPlaylist& p) {
+    if (!library_ || library_->playlist_count >= playlists_capacity_) return;
+    auto& out = library_->playlists[library_->playlist_count++];
+    out.name = strdup(p.name.c_str());
+    out.filename = strdup(p.filename.c_str());
+    out.guid = strdup(p.guid.c_str());
+    out.folder = strdup(p.folder.c_str());
+    out.atom_id = p.atom_id;
+
+    if (p.track_atom_ids.size() > 0) {
+        out.track_atom_ids = new uint32_t[p.track_atom_ids.size()];
+        std::copy(p.track_atom_ids.begin(), p.track_atom_ids.end(), out.track_atom_ids);
+    }
+    out.track_count = p.track_atom_ids.size();
+}
+
+void MusicLibrarySink::AddPodcast(const zmdb::ZMDBPodcast& ep) {
+    if (!library_ || library_->podcast_episode_count >= podcasts_capacity_) return;
+    auto& out = library_->podcast_episodes[library_->podcast_episode_count++];
+    out.title             = strdup(ep.title.c_str());
+    out.show_name         = strdup(ep.show_name.c_str());
+    out.author            = strdup(ep.author.c_str());
+    out.description       = strdup(ep.description.c_str());
+    out.episode_url       = strdup(ep.episode_url.c_str());
+    out.folder_name       = strdup(ep.folder_name.c_str());
+    out.episode_filename  = strdup(ep.episode_filename.c_str());
+    out.atom_id           = ep.atom_id;
+    out.filename_ref      = ep.filename_ref;
+    out.podcast_show_ref  = ep.podcast_show_ref;
+    out.duration_ms       = ep.duration_ms;
+    out.bookmark_ms       = ep.bookmark_ms;
+    out.publish_date      = ep.publish_date;
+    out.file_size_bytes   = ep.file_size_bytes;
+    out.codec_id          = ep.codec_id;
+    out.meta_genre        = ep.meta_genre();
+    out.played_flag       = ep.played_flag;
+    out.is_played         = ep.is_played();
+    out.media_type        = static_cast<uint8_t>(ep.media_type);
+}
+
+void MusicLibrarySink::AddPodcastShow(uint32_t atom_id, const zmdb::ZMDBPodcastShow& show) {
+    // Shows are ordered by atom_id; a repeated id replaces the earlier one
+    auto [it, inserted] = podcast_shows_.try_emplace(atom_id, ZunePodcastShow{});
+    if (!inserted) {
+        FreePodcastShow(it->second);
+        it->second = ZunePodcastShow{};
+    }
+    auto& out = it->second;
+    out.name          = strdup(show.name.c_str());
+    out.ser_filename  = strdup(show.ser_filename.c_str());
+    out.author        = strdup(show.author.c_str());
+    out.feed_url      = strdup(show.feed_url.c_str());
+    out.filename_ref  = show.filename_ref;
+    out.is_subscribed = show.is_subscribed;
+    out.atom_id       = show.atom_id;
+}
+
+void MusicLibrarySink::AddAlbum(const zmdb::ZMDBAlbum& album) {
+    albums_.emplace_back();
+    auto& out = albums_.back();
+    out.title = strdup(album.title.c_str());
+    out.artist_name = strdup(album.artist_name.c_str());
+    out.artist_guid = strdup(album.artist_guid.c_str());
+    out.alb_reference = strdup(album.alb_reference.c_str());
+    out.release_year = album.release_year;
+    out.atom_id = album.atom_id;
+    out.album_pid = album.album_pid;
+    out.artist_ref = album.artist_ref;
+}
+
+void MusicLibrarySink::AddArtist(const zmdb::ZMDBArtist& artist) {
+    artists_.emplace_back();
+    auto& out = artists_.back();
+    out.name = strdup(artist.name.c_str());
+    out.filename = strdup(artist.filename.c_str());
+    out.guid = strdup(artist.guid.c_str());
+    out.atom_id = artist.atom_id;
+}
+
+void MusicLibrarySink::AddGenre(const zmdb::ZMDBGenre& genre) {
+    genres_.emplace_back();
+    auto& out = genres_.back();
+    out.name = strdup(genre.name.c_str());
+    out.atom_id = genre.atom_id;
+}
+
+void FreeMusicLibrary(ZuneMusicLibrary* library) {
+    if (!library) return;
+
+    // artist_name, artist_guid and genre may be shared between tracks
+    std::unordered_set<const char*> shared_strings;
+    for (uint32_t i = 0; i < library->track_count; ++i) {
+        free((void*)library->tracks[i].title);
+        shared_strings.insert(library->tracks[i].artist_name);
+        shared_strings.insert(library->tracks[i].artist_guid);
+        shared_strings.insert(library->tracks[i].genre);
+    }
+    for (const char* s : shared_strings)
+        free((void*)s);
+    delete[] library->tracks;
+
+    for (uint32_t i = 0; i < library->album_count; ++i) {
+        FreeAlbum(library->albums[i]);
+    }
+    delete[] library->albums;
+
+    for (uint32_t i = 0; i < library->artist_count; ++i) {
+        FreeArtist(library->artists[i]);
+    }
+    delete[] library->artists;
+
+    for (uint32_t i = 0; i < library->genre_count; ++i) {
+        FreeGenre(library->genres[i]);
+    }
+    delete[] library->genres;
+
+    for (uint32_t i = 0; i < library->artwork_count; ++i) {
+        free((void*)library->artworks[i].alb_reference);
+    }
+    delete[] library->artworks;
+
+    for (uint32_t i = 0; i < library->playlist_count; ++i) {
+        free((void*)library->playlists[i].name);
+        free((void*)library->playlists[i].filename);
+        free((void*)library->playlists[i].guid);
+        free((void*)library->playlists[i].folder);
+        delete[] library->playlists[i].track_atom_ids;
+    }
+    delete[] library->playlists;
+
+    for (uint32_t i = 0; i < library->podcast_show_count; ++i) {
+        FreePodcastShow(library->podcast_shows[i]);
+    }
+    delete[] library->podcast_shows;
+
+    for (uint32_t i = 0; i < library->podcast_episode_count; ++i) {
+        free((void*)library->podcast_episodes[i].title);
+        free((void*)library->podcast_episodes[i].show_name);
+        free((void*)library->podcast_episodes[i].author);
+        free((void*)library->podcast_episodes[i].description);
+        free((void*)library->podcast_episodes[i].episode_url);
+        free((void*)library->podcast_episodes[i].folder_name);
+        free((void*)library->podcast_episodes[i].episode_filename);
+    }
+    delete[] library->podcast_episodes;
+
+    delete library;
+}
+
+} // namespace zune
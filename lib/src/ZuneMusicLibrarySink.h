@@ -0,0 +1,76 @@
+#pragma once
+
+#include "xune_sync/xune_sync_api.h"
+#include "zmdb/ZMDBParserBase.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+/// Builds the strdup ZuneMusicLibrary that MtpReader::ReadMusicLibrary
+/// returns straight from the parser (see zmdb::ZMDBRecordSink): each record
+/// is converted as it is parsed and dropped, so the library is never held
+/// as a ZMDBLibrary as well as the C structs.
+///
+/// Tracks, playlists and podcast episodes go into arrays sized from the
+/// extraction plan; albums, artists, genres and podcast shows are counted
+/// only at the end and are sized exactly by Release. Videos, pictures and
+/// audiobooks are not part of ZuneMusicLibrary and are dropped. Strings
+/// interned by the parser (track artist, artist GUID, genre) are duplicated
+/// once and shared between tracks, as FreeMusicLibrary expects.
+class MusicLibrarySink : public zmdb::ZMDBRecordSink {
+public:
+    MusicLibrarySink() = default;
+    ~MusicLibrarySink() override;
+
+    MusicLibrarySink(const MusicLibrarySink&) = delete;
+    MusicLibrarySink& operator=(const MusicLibrarySink&) = delete;
+
+    void Begin(const zmdb::ZMDBExtractionPlan& plan) override;
+    void OnTrack(zmdb::ZMDBTrack&& track) override;
+    void OnPlaylist(zmdb::ZMDBPlaylist&& playlist) override;
+    void OnPodcast(zmdb::ZMDBPodcast&& podcast) override;
+    void OnPodcastShow(uint32_t atom_id, zmdb::ZMDBPodcastShow&& show) override;
+    void OnAlbum(uint32_t atom_id, zmdb::ZMDBAlbum&& album) override;
+    void OnArtist(uint32_t atom_id, zmdb::ZMDBArtist&& artist) override;
+    void OnGenre(uint32_t atom_id, zmdb::ZMDBGenre&& genre) override;
+    void Reset() override;
+
+    /// Convert an already parsed library (what BuildMusicLibrary does);
+    /// replaces anything received before.
+    void Add(const zmdb::ZMDBLibrary& library);
+
+    /// Hand over the library built so far, with the album artwork
+    /// (.alb filename -> MTP ObjectId) entries. The sink is empty afterwards.
+    /// Free the result with FreeMusicLibrary.
+    ZuneMusicLibrary* Release(const std::unordered_map<std::string, uint32_t>& alb_to_objectid);
+
+private:
+    void AddTrack(const zmdb::ZMDBTrack& track);
+    void AddPlaylist(const zmdb::ZMDBPlaylist& playlist);
+    void AddPodcast(const zmdb::ZMDBPodcast& podcast);
+    void AddPodcastShow(uint32_t atom_id, const zmdb::ZMDBPodcastShow& show);
+    void AddAlbum(const zmdb::ZMDBAlbum& album);
+    void AddArtist(const zmdb::ZMDBArtist& artist);
+    void AddGenre(const zmdb::ZMDBGenre& genre);
+    const char* StrdupShared(const zmdb::SharedString& s);
+
+    ZuneMusicLibrary* library_ = nullptr;  // Tracks, playlists, episodes
+    uint32_t tracks_capacity_ = 0;
+    uint32_t playlists_capacity_ = 0;
+    uint32_t podcasts_capacity_ = 0;
+    std::vector<ZuneMusicAlbum> albums_;
+    std::vector<ZuneMusicArtist> artists_;
+    std::vector<ZuneMusicGenre> genres_;
+    std::map<uint32_t, ZunePodcastShow> podcast_shows_;
+    std::unordered_map<const void*, const char*> shared_strings_;  // By SharedString::identity
+};
+
+/// Release a library built by MusicLibrarySink (what MtpReader::ReadMusicLibrary
+/// and MtpReader::BuildMusicLibrary return).
+void FreeMusicLibrary(ZuneMusicLibrary* library);
+
+} // namespace zune
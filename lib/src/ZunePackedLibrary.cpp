@@ -0,0 +1,589 @@
+#include "ZunePackedLibrary.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zune {
+
+namespace {
+
+constexpr char kPackedMagic[8] = {'X', 'Z', 'P', 'K', 'L', 'I', 'B', '\0'};
+constexpr uint32_t kPackedVersion = 1;
+
+enum PackedStorage : uint32_t {
+    kStorageHeap = 0,
+    kStorageMapped = 1,
+};
+
+struct alignas(8) PackedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t storage;       // PackedStorage; how FreePackedLibrary releases the block
+    uint64_t total_size;    // Header + records + string pool
+    uint64_t layout;        // LayoutFingerprint() of the writing build
+};
+
+constexpr size_t Align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+constexpr size_t kLibraryOffset = Align(sizeof(PackedHeader), alignof(ZuneMusicLibrary));
+
+// Saved blocks are raw struct images; refuse to load one written by a build
+// whose pointer size or struct layout differs.
+uint64_t LayoutFingerprint() {
+    const size_t sizes[] = {
+        sizeof(void*), sizeof(ZuneMusicLibrary), sizeof(ZuneMusicTrack),
+        sizeof(ZuneMusicAlbum), sizeof(ZuneMusicArtist), sizeof(ZuneMusicGenre),
+        sizeof(ZuneAlbumArtwork), sizeof(ZuneMusicPlaylist), sizeof(ZunePodcastShow),
+        sizeof(ZunePodcastEpisode),
+    };
+    uint64_t fingerprint = 0;
+    for (size_t size : sizes) {
+        fingerprint = fingerprint * 131 + size;
+    }
+    return fingerprint;
+}
+
+template <typename T>
+T* ArrayAt(uint8_t* block, size_t offset, uint32_t count) {
+    return count > 0 ? reinterpret_cast<T*>(block + offset) : nullptr;
+}
+
+PackedHeader* HeaderOf(const ZuneMusicLibrary* library) {
+    return reinterpret_cast<PackedHeader*>(
+        reinterpret_cast<uint8_t*>(const_cast<ZuneMusicLibrary*>(library)) - kLibraryOffset);
+}
+
+// ── Record emission ─────────────────────────────────────────────────────
+// Each Emit* runs twice: once with StringCounter to size the pool, once
+// with StringPool to fill it, so the field lists cannot drift apart.
+// Interned (SharedString) fields are stored once per unique entry and
+// shared between records.
+
+class StringCounter {
+public:
+    const char* operator()(const std::string& s) {
+        bytes += s.size() + 1;
+        return "";
+    }
+    const char* operator()(const zmdb::SharedString& s) {
+        if (seen_.insert(s.identity()).second) {
+            bytes += s.size() + 1;
+        }
+        return "";
+    }
+    size_t bytes = 0;
+
+private:
+    std::unordered_set<const void*> seen_;
+};
+
+class StringPool {
+public:
+    explicit StringPool(char* begin) : next_(begin) {}
+
+    const char* operator()(const std::string& s) {
+        char* out = next_;
+        std::memcpy(out, s.data(), s.size());
+        out[s.size()] = '\0';
+        next_ += s.size() + 1;
+        return out;
+    }
+    const char* operator()(const zmdb::SharedString& s) {
+        auto [it, inserted] = shared_.try_emplace(s.identity(), nullptr);
+        if (inserted) {
+            it->second = (*this)(s.str());
+        }
+        return it->second;
+    }
+
+private:
+    char* next_;
+    std::unordered_map<const void*, const char*> shared_;
+};
+
+template <typename Strings>
+void EmitTrack(ZuneMusicTrack& out, const zmdb::ZMDBTrack& t, Strings& str) {
+    out.title = str(t.title);
+    out.artist_name = str(t.artist_name);
+    out.artist_guid = str(t.artist_guid);
+    out.genre = str(t.genre);
+    out.track_number = t.track_number;
+    out.disc_number = t.disc_number;
+    out.duration_ms = t.duration_ms;
+    out.file_size_bytes = t.file_size_bytes;
+    out.album_ref = t.album_ref;
+    out.atom_id = t.atom_id;
+    out.genre_ref = t.genre_ref;
+    out.playcount = t.playcount;
+    out.skip_count = t.skip_count;
+    out.codec_id = t.codec_id;
+    out.rating = t.rating;
+    out.on_device_playcount = t.on_device_playcount;
+    out.last_played_timestamp = t.last_played_timestamp;
+}
+
+template <typename Strings>
+void EmitAlbum(ZuneMusicAlbum& out, const zmdb::ZMDBAlbum& album, Strings& str) {
+    out.title = str(album.title);
+    out.artist_name = str(album.artist_name);
+    out.artist_guid = str(album.artist_guid);
+    out.alb_reference = str(album.alb_reference);
+    out.release_year = album.release_year;
+    out.atom_id = album.atom_id;
+    out.album_pid = album.album_pid;
+    out.artist_ref = album.artist_ref;
+}
+
+template <typename Strings>
+void EmitArtist(ZuneMusicArtist& out, const zmdb::ZMDBArtist& artist, Strings& str) {
+    out.name = str(artist.name);
+    out.filename = str(artist.filename);
+    out.guid = str(artist.guid);
+    out.atom_id = artist.atom_id;
+}
+
+template <typename Strings>
+void EmitGenre(ZuneMusicGenre& out, const zmdb::ZMDBGenre& genre, Strings& str) {
+    out.name = str(genre.name);
+    out.atom_id = genre.atom_id;
+}
+
+template <typename Strings>
+void EmitArtwork(ZuneAlbumArtwork& out, const std::string& alb_ref, uint32_t object_id, Strings& str) {
+    out.alb_reference = str(alb_ref);
+    out.mtp_object_id = object_id;
+}
+
+// Track ids are laid out separately (see BuildPackedLibrary)
+template <typename Strings>
+void EmitPlaylist(ZuneMusicPlaylist& out, const zmdb::ZMDBPlaylist& p, Strings& str) {
+    out.name = str(p.name);
+    out.filename = str(p.filename);
+    out.guid = str(p.guid);
+    out.folder = str(p.folder);
+    out.track_count = static_cast<uint32_t>(p.track_atom_ids.size());
+    out.atom_id = p.atom_id;
+}
+
+template <typename Strings>
+void EmitPodcastShow(ZunePodcastShow& out, const zmdb::ZMDBPodcastShow& show, Strings& str) {
+    out.name = str(show.name);
+    out.ser_filename = str(show.ser_filename);
+    out.author = str(show.author);
+    out.feed_url = str(show.feed_url);
+    out.filename_ref = show.filename_ref;
+    out.is_subscribed = show.is_subscribed;
+    out.atom_id = show.atom_id;
+}
+
+template <typename Strings>
+void EmitPodcastEpisode(ZunePodcastEpisode& out, const zmdb::ZMDBPodcast& ep, Strings& str) {
+    out.title = str(ep.title);
+    out.show_name = str(ep.show_name);
+    out.author = str(ep.author);
+    out.description = str(ep.description);
+    out.episode_url = str(ep.episode_url);
+    out.folder_name = str(ep.folder_name);
+    out.episode_filename = str(ep.episode_filename);
+    out.atom_id = ep.atom_id;
+    out.filename_ref = ep.filename_ref;
+    out.podcast_show_ref = ep.podcast_show_ref;
+    out.duration_ms = ep.duration_ms;
+    out.bookmark_ms = ep.bookmark_ms;
+    out.publish_date = ep.publish_date;
+    out.file_size_bytes = ep.file_size_bytes;
+    out.codec_id = ep.codec_id;
+    out.meta_genre = ep.meta_genre();
+    out.played_flag = ep.played_flag;
+    out.is_played = ep.is_played();
+    out.media_type = static_cast<uint8_t>(ep.media_type);
+}
+
+// Fills either the real arrays of out, or (when out has none, during the
+// sizing pass) a scratch record per type.
+template <typename Strings>
+void EmitLibrary(ZuneMusicLibrary& out,
+                 const zmdb::ZMDBLibrary& library,
+                 const std::unordered_map<std::string, uint32_t>& alb_to_objectid,
+                 Strings& str) {
+    ZuneMusicTrack scratch_track;
+    for (int i = 0; i < library.track_count; i++) {
+        EmitTrack(out.tracks ? out.tracks[i] : scratch_track, library.tracks[i], str);
+    }
+
+    ZuneMusicAlbum scratch_album;
+    size_t idx = 0;
+    for (const auto& [atom_id, album] : library.album_metadata) {
+        EmitAlbum(out.albums ? out.albums[idx++] : scratch_album, album, str);
+    }
+
+    ZuneMusicArtist scratch_artist;
+    idx = 0;
+    for (const auto& [atom_id, artist] : library.artist_metadata) {
+        EmitArtist(out.artists ? out.artists[idx++] : scratch_artist, artist, str);
+    }
+
+    ZuneMusicGenre scratch_genre;
+    idx = 0;
+    for (const auto& [atom_id, genre] : library.genre_metadata) {
+        EmitGenre(out.genres ? out.genres[idx++] : scratch_genre, genre, str);
+    }
+
+    ZuneAlbumArtwork scratch_artwork;
+    idx = 0;
+    for (const auto& [alb_ref, object_id] : alb_to_objectid) {
+        EmitArtwork(out.artworks ? out.artworks[idx++] : scratch_artwork, alb_ref, object_id, str);
+    }
+
+    ZuneMusicPlaylist scratch_playlist;
+    for (int i = 0; i < library.playlist_count; i++) {
+        EmitPlaylist(out.playlists ? out.playlists[i] : scratch_playlist, library.playlists[i], str);
+    }
+
+    ZunePodcastShow scratch_show;
+    idx = 0;
+    for (const auto& [atom_id, show] : library.podcast_show_metadata) {
+        EmitPodcastShow(out.podcast_shows ? out.podcast_shows[idx++] : scratch_show, show, str);
+    }
+
+    ZunePodcastEpisode scratch_episode;
+    for (int i = 0; i < library.podcast_count; i++) {
+        EmitPodcastEpisode(out.podcast_episodes ? out.podcast_episodes[i] : scratch_episode,
+                           library.podcasts[i], str);
+    }
+}
+
+// ── Pointer relocation ──────────────────────────────────────────────────
+// Rewrites every pointer in the block from one base address to another:
+// absolute -> offset (from = block, to = 0) when saving, offset ->
+// absolute (from = 0, to = block) when loading. block is where the records
+// physically are. When block_size is non-zero, every offset is checked to
+// stay inside the block first.
+
+class Relocator {
+public:
+    Relocator(uint8_t* block, uintptr_t from, uintptr_t to, size_t block_size)
+        : block_(block), from_(from), to_(to), block_size_(block_size) {}
+
+    // Relocates an array pointer; returns where its elements are right now.
+    template <typename T>
+    T* Array(T*& ptr, uint32_t count) {
+        if (!ptr) {
+            return nullptr;
+        }
+        uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - from_;
+        if (block_size_ != 0 &&
+            (offset < kLibraryOffset || offset % alignof(T) != 0 ||
+             offset > block_size_ || count > (block_size_ - offset) / sizeof(T))) {
+            ok_ = false;
+            return nullptr;
+        }
+        ptr = reinterpret_cast<T*>(offset + to_);
+        return reinterpret_cast<T*>(block_ + offset);
+    }
+
+    void String(const char*& ptr) {
+        if (!ptr) {
+            return;
+        }
+        uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - from_;
+        if (block_size_ != 0 && offset >= block_size_) {
+            ok_ = false;
+            return;
+        }
+        ptr = reinterpret_cast<const char*>(offset + to_);
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    uint8_t* block_;
+    uintptr_t from_;
+    uintptr_t to_;
+    size_t block_size_;
+    bool ok_ = true;
+};
+
+bool RelocateLibrary(ZuneMusicLibrary& lib, Relocator& r) {
+    if (auto* tracks = r.Array(lib.tracks, lib.track_count)) {
+        for (uint32_t i = 0; i < lib.track_count; i++) {
+            r.String(tracks[i].title);
+            r.String(tracks[i].artist_name);
+            r.String(tracks[i].artist_guid);
+            r.String(tracks[i].genre);
+        }
+    }
+    if (auto* albums = r.Array(lib.albums, lib.album_count)) {
+        for (uint32_t i = 0; i < lib.album_count; i++) {
+            r.String(albums[i].title);
+            r.String(albums[i].artist_name);
+            r.String(albums[i].artist_guid);
+            r.String(albums[i].alb_reference);
+        }
+    }
+    if (auto* artists = r.Array(lib.artists, lib.artist_count)) {
+        for (uint32_t i = 0; i < lib.artist_count; i++) {
+            r.String(artists[i].name);
+            r.String(artists[i].filename);
+            r.String(artists[i].guid);
+        }
+    }
+    if (auto* genres = r.Array(lib.genres, lib.genre_count)) {
+        for (uint32_t i = 0; i < lib.genre_count; i++) {
+            r.String(genres[i].name);
+        }
+    }
+    if (auto* artworks = r.Array(lib.artworks, lib.artwork_count)) {
+        for (uint32_t i = 0; i < lib.artwork_count; i++) {
+            r.String(artworks[i].alb_reference);
+        }
+    }
+    if (auto* playlists = r.Array(lib.playlists, lib.playlist_count)) {
+        for (uint32_t i = 0; i < lib.playlist_count; i++) {
+            r.String(playlists[i].name);
+            r.String(playlists[i].filename);
+            r.String(playlists[i].guid);
+            r.String(playlists[i].folder);
+            r.Array(playlists[i].track_atom_ids, playlists[i].track_count);
+        }
+    }
+    if (auto* shows = r.Array(lib.podcast_shows, lib.podcast_show_count)) {
+        for (uint32_t i = 0; i < lib.podcast_show_count; i++) {
+            r.String(shows[i].name);
+            r.String(shows[i].ser_filename);
+            r.String(shows[i].author);
+            r.String(shows[i].feed_url);
+        }
+    }
+    if (auto* episodes = r.Array(lib.podcast_episodes, lib.podcast_episode_count)) {
+        for (uint32_t i = 0; i < lib.podcast_episode_count; i++) {
+            r.String(episodes[i].title);
+            r.String(episodes[i].show_name);
+            r.String(episodes[i].author);
+            r.String(episodes[i].description);
+            r.String(episodes[i].episode_url);
+            r.String(episodes[i].folder_name);
+            r.String(episodes[i].episode_filename);
+        }
+    }
+    return r.ok();
+}
+
+// Validates a freshly read/mapped block and fixes its pointers up in place.
+ZuneMusicLibrary* AdoptBlock(uint8_t* block, size_t size, PackedStorage storage) {
+    auto* header = reinterpret_cast<PackedHeader*>(block);
+    if (size < kLibraryOffset + sizeof(ZuneMusicLibrary) ||
+        std::memcmp(header->magic, kPackedMagic, sizeof(kPackedMagic)) != 0 ||
+        header->version != kPackedVersion ||
+        header->layout != LayoutFingerprint() ||
+        header->total_size != size ||
+        block[size - 1] != '\0') {  // Every string ends inside the block
+        return nullptr;
+    }
+
+    auto* lib = reinterpret_cast<ZuneMusicLibrary*>(block + kLibraryOffset);
+    Relocator relocator(block, 0, reinterpret_cast<uintptr_t>(block), size);
+    if (!RelocateLibrary(*lib, relocator)) {
+        return nullptr;
+    }
+    header->storage = storage;
+    return lib;
+}
+
+} // namespace
+
+// ── Build ───────────────────────────────────────────────────────────────
+
+ZuneMusicLibrary* BuildPackedLibrary(
+    const zmdb::ZMDBLibrary& library,
+    const std::unordered_map<std::string, uint32_t>& alb_to_objectid) {
+
+    ZuneMusicLibrary counts{};
+    counts.track_count = static_cast<uint32_t>(library.track_count);
+    counts.album_count = static_cast<uint32_t>(library.album_metadata.size());
+    counts.artist_count = static_cast<uint32_t>(library.artist_metadata.size());
+    counts.genre_count = static_cast<uint32_t>(library.genre_metadata.size());
+    counts.artwork_count = static_cast<uint32_t>(alb_to_objectid.size());
+    counts.playlist_count = static_cast<uint32_t>(library.playlist_count);
+    counts.podcast_show_count = static_cast<uint32_t>(library.podcast_show_metadata.size());
+    counts.podcast_episode_count = static_cast<uint32_t>(library.podcast_count);
+
+    // Sizing pass
+    StringCounter counter;
+    EmitLibrary(counts, library, alb_to_objectid, counter);
+    size_t track_id_count = 0;
+    for (int i = 0; i < library.playlist_count; i++) {
+        track_id_count += library.playlists[i].track_atom_ids.size();
+    }
+
+    size_t offset = kLibraryOffset + sizeof(ZuneMusicLibrary);
+    auto reserve = [&offset](size_t count, size_t elem_size, size_t alignment) {
+        offset = Align(offset, alignment);
+        size_t at = offset;
+        offset += count * elem_size;
+        return at;
+    };
+    size_t tracks_at = reserve(counts.track_count, sizeof(ZuneMusicTrack), alignof(ZuneMusicTrack));
+    size_t albums_at = reserve(counts.album_count, sizeof(ZuneMusicAlbum), alignof(ZuneMusicAlbum));
+    size_t artists_at = reserve(counts.artist_count, sizeof(ZuneMusicArtist), alignof(ZuneMusicArtist));
+    size_t genres_at = reserve(counts.genre_count, sizeof(ZuneMusicGenre), alignof(ZuneMusicGenre));
+    size_t artworks_at = reserve(counts.artwork_count, sizeof(ZuneAlbumArtwork), alignof(ZuneAlbumArtwork));
+    size_t playlists_at = reserve(counts.playlist_count, sizeof(ZuneMusicPlaylist), alignof(ZuneMusicPlaylist));
+    size_t shows_at = reserve(counts.podcast_show_count, sizeof(ZunePodcastShow), alignof(ZunePodcastShow));
+    size_t episodes_at = reserve(counts.podcast_episode_count, sizeof(ZunePodcastEpisode), alignof(ZunePodcastEpisode));
+    size_t track_ids_at = reserve(track_id_count, sizeof(uint32_t), alignof(uint32_t));
+    // +1: a trailing NUL so a loaded block can be checked to end inside a string
+    size_t strings_at = reserve(counter.bytes + 1, 1, 1);
+    size_t total_size = offset;
+
+    // calloc: struct padding is zeroed, so saved files are deterministic
+    auto* block = static_cast<uint8_t*>(std::calloc(1, total_size));
+    if (!block) {
+        return nullptr;
+    }
+
+    auto* header = reinterpret_cast<PackedHeader*>(block);
+    std::memcpy(header->magic, kPackedMagic, sizeof(kPackedMagic));
+    header->version = kPackedVersion;
+    header->storage = kStorageHeap;
+    header->total_size = total_size;
+    header->layout = LayoutFingerprint();
+
+    auto* lib = reinterpret_cast<ZuneMusicLibrary*>(block + kLibraryOffset);
+    *lib = counts;
+    lib->tracks = ArrayAt<ZuneMusicTrack>(block, tracks_at, counts.track_count);
+    lib->albums = ArrayAt<ZuneMusicAlbum>(block, albums_at, counts.album_count);
+    lib->artists = ArrayAt<ZuneMusicArtist>(block, artists_at, counts.artist_count);
+    lib->genres = ArrayAt<ZuneMusicGenre>(block, genres_at, counts.genre_count);
+    lib->artworks = ArrayAt<ZuneAlbumArtwork>(block, artworks_at, counts.artwork_count);
+    lib->playlists = ArrayAt<ZuneMusicPlaylist>(block, playlists_at, counts.playlist_count);
+    lib->podcast_shows = ArrayAt<ZunePodcastShow>(block, shows_at, counts.podcast_show_count);
+    lib->podcast_episodes = ArrayAt<ZunePodcastEpisode>(block, episodes_at, counts.podcast_episode_count);
+
+    StringPool pool(reinterpret_cast<char*>(block + strings_at));
+    EmitLibrary(*lib, library, alb_to_objectid, pool);
+
+    auto* track_ids = reinterpret_cast<uint32_t*>(block + track_ids_at);
+    for (int i = 0; i < library.playlist_count; i++) {
+        const auto& ids = library.playlists[i].track_atom_ids;
+        if (ids.empty()) {
+            continue;
+        }
+        std::memcpy(track_ids, ids.data(), ids.size() * sizeof(uint32_t));
+        lib->playlists[i].track_atom_ids = track_ids;
+        track_ids += ids.size();
+    }
+
+    return lib;
+}
+
+// ── Save / Load ─────────────────────────────────────────────────────────
+
+bool SavePackedLibrary(const ZuneMusicLibrary* library, const std::string& path) {
+    if (!library) {
+        return false;
+    }
+    const PackedHeader* header = HeaderOf(library);
+    if (std::memcmp(header->magic, kPackedMagic, sizeof(kPackedMagic)) != 0) {
+        return false;
+    }
+
+    // Swizzle a copy so the live library stays usable
+    size_t size = static_cast<size_t>(header->total_size);
+    std::vector<uint8_t> image(size);
+    std::memcpy(image.data(), header, size);
+    auto* image_lib = reinterpret_cast<ZuneMusicLibrary*>(image.data() + kLibraryOffset);
+    Relocator relocator(image.data(), reinterpret_cast<uintptr_t>(header), 0, 0);
+    RelocateLibrary(*image_lib, relocator);
+    reinterpret_cast<PackedHeader*>(image.data())->storage = kStorageHeap;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(size));
+    return static_cast<bool>(out);
+}
+
+ZuneMusicLibrary* LoadPackedLibrary(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+
+    // Private writable mapping: the pointer fix-up only dirties the record
+    // pages; the string pool stays shared with the page cache.
+    void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+
+    ZuneMusicLibrary* lib = AdoptBlock(static_cast<uint8_t*>(mapped), size, kStorageMapped);
+    if (!lib) {
+        ::munmap(mapped, size);
+    }
+    return lib;
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return nullptr;
+    }
+    std::streamoff file_size = in.tellg();
+    if (file_size <= 0) {
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(file_size);
+    auto* block = static_cast<uint8_t*>(std::malloc(size));
+    if (!block) {
+        return nullptr;
+    }
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(block), file_size)) {
+        std::free(block);
+        return nullptr;
+    }
+
+    ZuneMusicLibrary* lib = AdoptBlock(block, size, kStorageHeap);
+    if (!lib) {
+        std::free(block);
+    }
+    return lib;
+#endif
+}
+
+void FreePackedLibrary(ZuneMusicLibrary* library) {
+    if (!library) {
+        return;
+    }
+    PackedHeader* header = HeaderOf(library);
+#ifndef _WIN32
+    if (header->storage == kStorageMapped) {
+        ::munmap(header, static_cast<size_t>(header->total_size));
+        return;
+    }
+#endif
+    std::free(header);
+}
+
+} // namespace zune
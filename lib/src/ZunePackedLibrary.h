@@ -0,0 +1,45 @@
+#pragma once
+
+#include "xune_sync/xune_sync_api.h"
+#include "zmdb/ZMDBTypes.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace zune {
+
+/// Packed ZuneMusicLibrary: the same public structs, but the header, every
+/// record array, the playlist track-id arrays and all strings live in one
+/// contiguous allocation. Strings are NUL-terminated in a single pool at the
+/// end of the block.
+///
+/// Building one costs a single allocation instead of one strdup per string
+/// field, and releasing it is a single free. The block can be saved to disk
+/// (pointers are stored as block offsets) and loaded back with one
+/// read/mmap plus an in-place pointer fix-up.
+///
+/// Packed libraries must be released with FreePackedLibrary, never with
+/// MtpReader::FreeLibrary. Saved files are specific to the pointer size and
+/// struct layout of the build that wrote them; LoadPackedLibrary rejects
+/// foreign files.
+
+/// Build a packed library from a parsed ZMDB library and the album artwork
+/// (.alb filename -> MTP ObjectId) map. Same contents and ordering as
+/// MtpReader::ReadMusicLibrary.
+/// @return Packed library, or nullptr on allocation failure
+ZuneMusicLibrary* BuildPackedLibrary(
+    const zmdb::ZMDBLibrary& library,
+    const std::unordered_map<std::string, uint32_t>& alb_to_objectid);
+
+/// Write a packed library to path.
+/// @return true on success; false if library is not a packed library or on I/O error
+bool SavePackedLibrary(const ZuneMusicLibrary* library, const std::string& path);
+
+/// Map (or read, where mmap is unavailable) a file written by SavePackedLibrary.
+/// @return Packed library, or nullptr if missing, truncated or from another build layout
+ZuneMusicLibrary* LoadPackedLibrary(const std::string& path);
+
+/// Release a library returned by BuildPackedLibrary or LoadPackedLibrary.
+void FreePackedLibrary(ZuneMusicLibrary* library);
+
+} // namespace zune
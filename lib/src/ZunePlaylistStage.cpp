@@ -0,0 +1,186 @@
+#include "ZunePlaylistStage.h"
+#include <algorithm>
+#include <utility>
+
+namespace zune {
+
+PlaylistStage::PlaylistStage(CreateFn create, UpdateFn update)
+    : create_(std::move(create)), update_(std::move(update)) {}
+
+PlaylistStage::~PlaylistStage() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void PlaylistStage::SetDebounce(std::chrono::milliseconds debounce) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        debounce_ = debounce;
+        if (debounce_.count() > 0 && (!pending_.empty() || !pending_new_.empty())) {
+            StartTimer();
+        }
+    }
+    cv_.notify_all();
+}
+
+void PlaylistStage::Stage(uint32_t playlist_id, std::vector<uint32_t> tracks) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& staged = pending_[playlist_id];
+        staged.tracks = std::move(tracks);
+        staged.due = Clock::now() + debounce_;
+        stats_.staged++;
+        if (debounce_.count() > 0) {
+            StartTimer();
+        }
+    }
+    cv_.notify_all();
+}
+
+void PlaylistStage::StageNew(NewPlaylist playlist) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto due = Clock::now() + debounce_;
+        auto created = created_.find(playlist.guid);
+        if (created != created_.end()) {
+            // Already on the device: an ordinary edit from here on
+            auto& staged = pending_[created->second];
+            staged.tracks = std::move(playlist.tracks);
+            staged.due = due;
+        } else {
+            auto& staged = pending_new_[playlist.guid];
+            staged.playlist = std::move(playlist);
+            staged.due = due;
+        }
+        stats_.staged++;
+        if (debounce_.count() > 0) {
+            StartTimer();
+        }
+    }
+    cv_.notify_all();
+}
+
+void PlaylistStage::Discard(uint32_t playlist_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(playlist_id);
+    for (auto it = created_.begin(); it != created_.end(); ++it) {
+        if (it->second == playlist_id) {
+            created_.erase(it);
+            break;
+        }
+    }
+}
+
+size_t PlaylistStage::Flush() {
+    return WriteDue(true);
+}
+
+uint32_t PlaylistStage::CreatedId(const std::string& guid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = created_.find(guid);
+    return it == created_.end() ? 0 : it->second;
+}
+
+size_t PlaylistStage::Pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size() + pending_new_.size();
+}
+
+PlaylistStage::Stats PlaylistStage::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PlaylistStage::StartTimer() {
+    if (!thread_.joinable() && !stop_) {
+        thread_ = std::thread(&PlaylistStage::Run, this);
+    }
+}
+
+void PlaylistStage::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (debounce_.count() <= 0 || (pending_.empty() && pending_new_.empty())) {
+            cv_.wait(lock);
+            continue;
+        }
+
+        auto next = Clock::time_point::max();
+        for (const auto& [id, staged] : pending_) next = std::min(next, staged.due);
+        for (const auto& [guid, staged] : pending_new_) next = std::min(next, staged.due);
+        if (Clock::now() < next) {
+            cv_.wait_until(lock, next);
+            continue;
+        }
+
+        lock.unlock();
+        WriteDue(false);
+        lock.lock();
+    }
+}
+
+size_t PlaylistStage::WriteDue(bool all) {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+
+    // New playlists first, so an edit staged against one after it was
+    // created cannot reach the device before the playlist does
+    std::vector<NewPlaylist> creates;
+    std::vector<std::pair<uint32_t, std::vector<uint32_t>>> updates;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+        for (auto it = pending_new_.begin(); it != pending_new_.end();) {
+            if (all || it->second.due <= now) {
+                creates.push_back(std::move(it->second.playlist));
+                it = pending_new_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (all || it->second.due <= now) {
+                updates.emplace_back(it->first, std::move(it->second.tracks));
+                it = pending_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    size_t failed = 0;
+    for (const auto& playlist : creates) {
+        uint32_t id = create_(playlist);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.written++;
+        if (id == 0) {
+            stats_.failed++;
+            failed++;
+            continue;
+        }
+        created_[playlist.guid] = id;
+        // Staged while the create was in flight
+        auto late = pending_new_.find(playlist.guid);
+        if (late != pending_new_.end()) {
+            pending_[id] = {std::move(late->second.playlist.tracks), late->second.due};
+            pending_new_.erase(late);
+        }
+    }
+    for (const auto& [id, tracks] : updates) {
+        bool ok = update_(id, tracks);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.written++;
+        if (!ok) {
+            stats_.failed++;
+            failed++;
+        }
+    }
+    return failed;
+}
+
+} // namespace zune
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+/// Write-behind buffer for interactive playlist edits.
+///
+/// Every edit to a playlist replaces its whole track list on the device
+/// (SetObjectReferences), so while a user drags tracks around only the
+/// last list matters. Staged edits keep just the latest list per playlist
+/// and write it once, on Flush() or once the playlist has gone debounce
+/// without another edit. A playlist staged as new is created with that
+/// final list in a single CreatePlaylist; edits to it after creation, still
+/// keyed by its GUID, become updates of the created object.
+///
+/// The debounce timer runs on a thread of its own, started by the first
+/// edit once a debounce is set; writes happen on that thread or on the
+/// caller of Flush(), one flush at a time. Thread-safe.
+class PlaylistStage {
+public:
+    struct NewPlaylist {
+        std::string name;
+        std::string guid;
+        uint32_t folder_id = 0;
+        std::vector<uint32_t> tracks;
+    };
+
+    /// Returns the new playlist's object id, 0 on failure
+    using CreateFn = std::function<uint32_t(const NewPlaylist& playlist)>;
+    using UpdateFn = std::function<bool(uint32_t playlist_id, const std::vector<uint32_t>& tracks)>;
+
+    struct Stats {
+        uint64_t staged = 0;     // Edits accepted
+        uint64_t written = 0;    // CreatePlaylist / SetObjectReferences sent
+        uint64_t failed = 0;     // Of those, rejected by the device
+    };
+
+    PlaylistStage(CreateFn create, UpdateFn update);
+    ~PlaylistStage();  // Stops the timer; edits not yet written are dropped
+    PlaylistStage(const PlaylistStage&) = delete;
+    PlaylistStage& operator=(const PlaylistStage&) = delete;
+
+    /// Quiet time after a playlist's last edit before it is written;
+    /// zero (the default) writes only on Flush()
+    void SetDebounce(std::chrono::milliseconds debounce);
+
+    /// Latest track list for an existing playlist
+    void Stage(uint32_t playlist_id, std::vector<uint32_t> tracks);
+
+    /// Latest contents for a playlist that does not exist yet, keyed by
+    /// guid; the name and folder of the last call are used
+    void StageNew(NewPlaylist playlist);
+
+    /// Drop staged edits for a playlist about to be deleted
+    void Discard(uint32_t playlist_id);
+
+    /// Write everything staged before the call; returns how many writes
+    /// failed. Failed edits are not retried.
+    size_t Flush();
+
+    /// Object id a playlist staged as new was created with, 0 until then
+    uint32_t CreatedId(const std::string& guid) const;
+
+    size_t Pending() const;
+    Stats GetStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct StagedTracks {
+        std::vector<uint32_t> tracks;
+        Clock::time_point due;
+    };
+    struct StagedNew {
+        NewPlaylist playlist;
+        Clock::time_point due;
+    };
+
+    void StartTimer();              // With mutex_ held
+    void Run();
+    // Take what is due by now (everything when all), then write it
+    size_t WriteDue(bool all);
+
+    CreateFn create_;
+    UpdateFn update_;
+
+    std::mutex flush_mutex_;        // One flush at a time, so writes stay in edit order
+    mutable std::mutex mutex_;      // Guards everything below
+    std::condition_variable cv_;    // Edit staged, debounce changed, or stopping
+    std::chrono::milliseconds debounce_{0};
+    std::map<uint32_t, StagedTracks> pending_;
+    std::map<std::string, StagedNew> pending_new_;
+    std::unordered_map<std::string, uint32_t> created_;
+    Stats stats_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace zune
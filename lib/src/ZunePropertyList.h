@@ -0,0 +1,150 @@
+#pragma once
+
+#include "zmdb/ZMDBTypes.h"
+#include "zmdb/ZMDBUtils.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace zune {
+
+/// MTP data type codes carried in each property list element
+namespace PropType {
+    constexpr uint16_t Int8 = 0x0001;
+    constexpr uint16_t UInt8 = 0x0002;
+    constexpr uint16_t Int16 = 0x0003;
+    constexpr uint16_t UInt16 = 0x0004;
+    constexpr uint16_t Int32 = 0x0005;
+    constexpr uint16_t UInt32 = 0x0006;
+    constexpr uint16_t Int64 = 0x0007;
+    constexpr uint16_t UInt64 = 0x0008;
+    constexpr uint16_t Int128 = 0x0009;
+    constexpr uint16_t UInt128 = 0x000A;
+    constexpr uint16_t Array = 0x4000;  // Flag: u32 count, then elements
+    constexpr uint16_t String = 0xFFFF;
+}
+
+/// Bytes in one scalar of type, 0 for strings and unknown types
+inline size_t PropertyScalarSize(uint16_t type) {
+    switch (type & ~PropType::Array) {
+        case PropType::Int8: case PropType::UInt8: return 1;
+        case PropType::Int16: case PropType::UInt16: return 2;
+        case PropType::Int32: case PropType::UInt32: return 4;
+        case PropType::Int64: case PropType::UInt64: return 8;
+        case PropType::Int128: case PropType::UInt128: return 16;
+        default: return 0;
+    }
+}
+
+/// UTF-16LE text of a string property, viewed in the property list it came
+/// from (terminator excluded). Valid while the list is.
+class PropertyString {
+public:
+    PropertyString() = default;
+    PropertyString(const uint8_t* data, size_t units) : data_(data), units_(units) {}
+
+    size_t Units() const { return units_; }
+    bool Empty() const { return units_ == 0; }
+    uint16_t At(size_t i) const { return static_cast<uint16_t>(data_[2 * i] | (data_[2 * i + 1] << 8)); }
+    zmdb::ByteView Bytes() const { return zmdb::ByteView(data_, units_ * 2); }
+
+    std::string ToUtf8() const { return units_ ? zmdb::utf16le_to_utf8(Bytes()) : std::string(); }
+
+    /// Compare with ASCII text without converting; text holding non-ASCII
+    /// bytes never matches
+    bool Equals(std::string_view ascii) const {
+        if (ascii.size() != units_) return false;
+        for (size_t i = 0; i < units_; i++) {
+            auto c = static_cast<unsigned char>(ascii[i]);
+            if (c >= 0x80 || At(i) != c) return false;
+        }
+        return true;
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t units_ = 0;
+};
+
+/// One element of a property list: value is its raw bytes (an array's
+/// count prefix and a string's length byte included)
+struct PropertyEntry {
+    uint32_t handle = 0;
+    uint16_t property = 0;
+    uint16_t type = 0;
+    zmdb::ByteView value;
+
+    bool IsInteger() const {
+        size_t width = PropertyScalarSize(type);
+        return !(type & PropType::Array) && width != 0 && width <= 8;
+    }
+
+    /// Little-endian value bits, zero-extended; 0 unless IsInteger
+    uint64_t Integer() const {
+        if (!IsInteger()) return 0;
+        uint64_t result = 0;
+        for (size_t b = 0; b < value.size(); b++) result |= static_cast<uint64_t>(value[b]) << (8 * b);
+        return result;
+    }
+
+    bool IsString() const { return type == PropType::String; }
+
+    /// The text, up to its first NUL; empty unless IsString
+    PropertyString String() const {
+        if (!IsString() || value.size() < 3) return {};
+        zmdb::ByteView text = value.subview(1);
+        return PropertyString(text.data(), zmdb::find_utf16le_null(text) / 2);
+    }
+};
+
+/// Walk a GetObjectPropertyList dataset, calling visit(const PropertyEntry&)
+/// per element in order.
+///
+/// The dataset is a u32 element count, then per element a u32 handle, u16
+/// property, u16 data type and the value. Entries view the dataset in
+/// place: integers are read on demand and strings stay UTF-16LE until the
+/// caller converts or compares them, so listing tens of thousands of
+/// objects allocates nothing per element. False if the dataset is
+/// truncated or holds a type of unknown size; the elements before the
+/// fault have been visited.
+template <typename Visitor>
+bool ForEachProperty(zmdb::ByteView data, Visitor&& visit) {
+    auto u16 = [&](size_t off) { return static_cast<uint16_t>(data[off] | (data[off + 1] << 8)); };
+    auto u32 = [&](size_t off) { return static_cast<uint32_t>(u16(off) | (uint32_t(u16(off + 2)) << 16)); };
+
+    if (data.size() < 4) return false;
+    uint32_t n = u32(0);
+    size_t off = 4;
+    for (uint32_t i = 0; i < n; i++) {
+        if (data.size() - off < 8) return false;
+        PropertyEntry entry;
+        entry.handle = u32(off);
+        entry.property = u16(off + 4);
+        entry.type = u16(off + 6);
+        off += 8;
+
+        size_t size;
+        size_t remaining = data.size() - off;
+        if (entry.type == PropType::String) {
+            // u8 character count (NUL included), UTF-16LE
+            if (remaining < 1) return false;
+            size = 1 + size_t(data[off]) * 2;
+        } else if (entry.type & PropType::Array) {
+            size_t width = PropertyScalarSize(entry.type);
+            if (width == 0 || remaining < 4) return false;
+            size = 4 + size_t(u32(off)) * width;
+        } else {
+            size = PropertyScalarSize(entry.type);
+            if (size == 0) return false;
+        }
+        if (size > remaining) return false;
+
+        entry.value = data.subview(off, size);
+        off += size;
+        visit(static_cast<const PropertyEntry&>(entry));
+    }
+    return true;
+}
+
+} // namespace zune
@@ -0,0 +1,250 @@
+#include "ZuneSyncJournal.h"
+#include "ZuneFileStore.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace zune {
+
+static constexpr char kJournalMagic[4] = {'X', 'Z', 'S', 'J'};
+static constexpr uint32_t kJournalVersion = 1;
+
+namespace {
+
+enum RecordType : uint8_t {
+    kRecordCreated = 1,
+    kRecordCommitted = 2,
+};
+
+} // namespace
+
+SyncJournal::~SyncJournal() {
+    Close();
+}
+
+std::string SyncJournal::FileName(const std::string& serial) {
+    return SerialFileName(serial, ".xzjournal");
+}
+
+bool SyncJournal::SourceIdentity(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto write_time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    size = static_cast<uint64_t>(file_size);
+    mtime = static_cast<int64_t>(write_time.time_since_epoch().count());
+    return true;
+}
+
+bool SyncJournal::Open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    entries_.clear();
+    index_.clear();
+    pending_ = 0;
+    path_.clear();
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    LoadLocked(path);
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_) return false;
+    path_ = path;
+    return true;
+}
+
+void SyncJournal::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    path_.clear();
+    entries_.clear();
+    index_.clear();
+    pending_ = 0;
+}
+
+bool SyncJournal::IsOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_ != nullptr;
+}
+
+bool SyncJournal::RecordCreated(uint32_t object_id, uint64_t object_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (object_id == 0) return false;
+    Entry& entry = EntryLocked(object_id);
+    entry = Entry{};
+    entry.object_id = object_id;
+    entry.object_size = object_size;
+    pending_ = object_id;
+
+    std::vector<uint8_t> payload;
+    Put32(payload, object_id);
+    Put64(payload, object_size);
+    return AppendLocked(kRecordCreated, payload);
+}
+
+bool SyncJournal::RecordCommitted(uint32_t object_id, const std::string& source_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (object_id == 0) return false;
+    Entry& entry = EntryLocked(object_id);
+    entry.committed = true;
+    entry.source_path = source_path;
+    if (!SourceIdentity(source_path, entry.source_size, entry.source_mtime)) {
+        entry.source_size = 0;
+        entry.source_mtime = 0;
+    }
+    if (pending_ == object_id) pending_ = 0;
+
+    std::vector<uint8_t> payload;
+    Put32(payload, object_id);
+    Put64(payload, entry.source_size);
+    Put64(payload, static_cast<uint64_t>(entry.source_mtime));
+    Put32(payload, static_cast<uint32_t>(source_path.size()));
+    payload.insert(payload.end(), source_path.begin(), source_path.end());
+    return AppendLocked(kRecordCommitted, payload);
+}
+
+uint32_t SyncJournal::PendingObject() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+std::vector<SyncJournal::Entry> SyncJournal::Entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+}
+
+SyncResume SyncJournal::Resume(const std::unordered_map<uint32_t, uint64_t>& device_sizes) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncResume resume;
+    for (const Entry& entry : entries_) {
+        auto device = device_sizes.find(entry.object_id);
+        if (device == device_sizes.end()) continue;
+
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        bool current = entry.committed &&
+            device->second == entry.source_size &&
+            SourceIdentity(entry.source_path, size, mtime) &&
+            size == entry.source_size && mtime == entry.source_mtime;
+        if (current) {
+            resume.committed[entry.source_path] = entry.object_id;
+        } else {
+            resume.stale.push_back(entry.object_id);
+        }
+    }
+    return resume;
+}
+
+void SyncJournal::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    pending_ = 0;
+    if (path_.empty()) return;
+
+    if (file_) std::fclose(file_);
+    file_ = std::fopen(path_.c_str(), "wb");
+    if (!file_) return;
+    std::fwrite(kJournalMagic, 1, sizeof(kJournalMagic), file_);
+    std::vector<uint8_t> version;
+    Put32(version, kJournalVersion);
+    std::fwrite(version.data(), 1, version.size(), file_);
+    std::fflush(file_);
+}
+
+SyncJournal::Entry& SyncJournal::EntryLocked(uint32_t object_id) {
+    auto [it, inserted] = index_.try_emplace(object_id, entries_.size());
+    if (inserted) {
+        entries_.emplace_back();
+        entries_.back().object_id = object_id;
+    }
+    return entries_[it->second];
+}
+
+// One fwrite per record, flushed, so a crash loses at most the record being written
+bool SyncJournal::AppendLocked(uint8_t type, const std::vector<uint8_t>& payload) {
+    if (!file_) return false;
+    std::vector<uint8_t> record;
+    record.reserve(payload.size() + 9);
+    record.push_back(type);
+    Put32(record, static_cast<uint32_t>(payload.size()));
+    record.insert(record.end(), payload.begin(), payload.end());
+    Put32(record, Fnv1a32(record.data(), record.size()));
+
+    if (std::fwrite(record.data(), 1, record.size(), file_) != record.size()) return false;
+    return std::fflush(file_) == 0;
+}
+
+// Keeps every record up to the first bad one and cuts the file there; a
+// missing or foreign file is replaced with an empty journal
+void SyncJournal::LoadLocked(const std::string& path) {
+    std::vector<uint8_t> data;
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (file)
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    BinaryReader r{data};
+    const uint8_t* magic = r.Take(sizeof(kJournalMagic));
+    if (!magic || std::memcmp(magic, kJournalMagic, sizeof(kJournalMagic)) != 0 ||
+        r.Get(4) != kJournalVersion) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        std::vector<uint8_t> header(kJournalMagic, kJournalMagic + sizeof(kJournalMagic));
+        Put32(header, kJournalVersion);
+        file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        return;
+    }
+
+    size_t valid_end = r.pos;
+    while (r.ok && r.pos < data.size()) {
+        size_t start = r.pos;
+        uint8_t type = static_cast<uint8_t>(r.Get(1));
+        size_t length = static_cast<size_t>(r.Get(4));
+        const uint8_t* payload = r.Take(length);
+        uint32_t checksum = static_cast<uint32_t>(r.Get(4));
+        if (!r.ok || checksum != Fnv1a32(data.data() + start, 5 + length)) break;
+
+        std::vector<uint8_t> bytes(payload, payload + length);
+        BinaryReader p{bytes};
+        uint32_t object_id = static_cast<uint32_t>(p.Get(4));
+        if (type == kRecordCreated) {
+            uint64_t object_size = p.Get(8);
+            if (!p.ok || object_id == 0) break;
+            Entry& entry = EntryLocked(object_id);
+            entry = Entry{};
+            entry.object_id = object_id;
+            entry.object_size = object_size;
+            pending_ = object_id;
+        } else if (type == kRecordCommitted) {
+            uint64_t source_size = p.Get(8);
+            int64_t source_mtime = static_cast<int64_t>(p.Get(8));
+            size_t path_size = static_cast<size_t>(p.Get(4));
+            const uint8_t* source_path = p.Take(path_size);
+            if (!p.ok || object_id == 0) break;
+            Entry& entry = EntryLocked(object_id);
+            entry.committed = true;
+            entry.source_path.assign(reinterpret_cast<const char*>(source_path), path_size);
+            entry.source_size = source_size;
+            entry.source_mtime = source_mtime;
+            if (pending_ == object_id) pending_ = 0;
+        }
+        // Unknown record types are skipped, so later versions can add some
+        valid_end = r.pos;
+    }
+
+    if (valid_end < data.size()) {
+        std::error_code ec;
+        std::filesystem::resize_file(path, valid_end, ec);
+    }
+}
+
+} // namespace zune
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+/// What a resumed sync can take from the journal (see SyncJournal::Resume)
+struct SyncResume {
+    /// Source path -> object handle: complete on the device, source unchanged
+    std::unordered_map<std::string, uint32_t> committed;
+    /// Journaled objects still on the device that are partial or out of date
+    std::vector<uint32_t> stale;
+};
+
+/// Append-only host record of the objects an upload has created, so a sync
+/// that dies part way (cable pulled, host crashed) can resume instead of
+/// starting over.
+///
+/// Each upload appends two records: Created once SendObjectPropList returns
+/// a handle, Committed once SendObject (and the verify, if any) finished,
+/// with the identity of the source file. Every record is flushed as it is
+/// written. On the next connect Resume() checks the journal against one
+/// ObjectSize property-list query: committed objects whose size and source
+/// still match are kept, and objects that never got their data are
+/// reported for deletion.
+///
+/// File layout (little-endian): "XZSJ" magic, u32 format version, then
+/// records of u8 type, u32 payload length, payload, u32 FNV-1a of type,
+/// length and payload. Created payload: u32 handle, u64 object size.
+/// Committed payload: u32 handle, u64 source size, i64 source mtime,
+/// u32 path length + bytes. A torn trailing record is cut off on Open.
+class SyncJournal {
+public:
+    struct Entry {
+        uint32_t object_id = 0;
+        uint64_t object_size = 0;   // Size declared to SendObjectPropList
+        bool committed = false;
+        std::string source_path;    // Set once committed
+        uint64_t source_size = 0;
+        int64_t source_mtime = 0;
+    };
+
+    SyncJournal() = default;
+    ~SyncJournal();
+    SyncJournal(const SyncJournal&) = delete;
+    SyncJournal& operator=(const SyncJournal&) = delete;
+
+    /// Load path (creating it if missing) and append to it from then on.
+    /// Replaces any previous binding. Returns false if the file cannot be written.
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const;
+
+    /// SendObjectPropList created object_id; its data is still to come
+    bool RecordCreated(uint32_t object_id, uint64_t object_size);
+    /// SendObject completed object_id from source_path
+    bool RecordCommitted(uint32_t object_id, const std::string& source_path);
+    /// Latest created object still waiting for its data, 0 if none. MTP
+    /// sends an object's data right after its property list, so this is the
+    /// object a bare SendObject fills.
+    uint32_t PendingObject() const;
+
+    /// Latest state of every journaled object, in journal order
+    std::vector<Entry> Entries() const;
+
+    /// Check the journal against the device (handle -> ObjectSize for every
+    /// object). Handles the device no longer has are ignored.
+    SyncResume Resume(const std::unordered_map<uint32_t, uint64_t>& device_sizes) const;
+
+    /// Forget every entry and empty the file, once a sync has completed
+    void Clear();
+
+    /// Size and modification time of a host file; false if it cannot be read
+    static bool SourceIdentity(const std::string& path, uint64_t& size, int64_t& mtime);
+    /// File name of the journal for a device serial
+    static std::string FileName(const std::string& serial);
+
+private:
+    bool AppendLocked(uint8_t type, const std::vector<uint8_t>& payload);
+    void LoadLocked(const std::string& path);
+    Entry& EntryLocked(uint32_t object_id);
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    std::FILE* file_ = nullptr;
+    std::vector<Entry> entries_;
+    std::unordered_map<uint32_t, size_t> index_;    // object_id -> entries_
+    uint32_t pending_ = 0;
+};
+
+} // namespace zune
@@ -0,0 +1,375 @@
+#include "ZuneSyncPlanner.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace zune {
+
+namespace {
+
+// Appends the normalized form of s to out
+void AppendKey(std::string& out, const char* s) {
+    if (!s) return;
+    bool pending_space = false;
+    size_t start = out.size();
+    for (; *s; s++) {
+        unsigned char c = static_cast<unsigned char>(*s);
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            pending_space = out.size() > start;
+            continue;
+        }
+        if (pending_space) {
+            out.push_back(' ');
+            pending_space = false;
+        }
+        out.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : static_cast<char>(c));
+    }
+}
+
+constexpr char kSeparator = '\x1f';
+
+void TrackKey(std::string& out, const char* album, const char* title, uint32_t track_number) {
+    out.clear();
+    AppendKey(out, album);
+    out.push_back(kSeparator);
+    AppendKey(out, title);
+    out.push_back(kSeparator);
+    out += std::to_string(track_number);
+}
+
+void AlbumKey(std::string& out, const char* artist, const char* album) {
+    out.clear();
+    AppendKey(out, artist);
+    out.push_back(kSeparator);
+    AppendKey(out, album);
+}
+
+// Compares normalized forms, using the scratch buffers to avoid allocating per track
+bool SameTag(const char* a, const char* b, std::string& scratch_a, std::string& scratch_b) {
+    scratch_a.clear();
+    scratch_b.clear();
+    AppendKey(scratch_a, a);
+    AppendKey(scratch_b, b);
+    return scratch_a == scratch_b;
+}
+
+const char* AlbumArtistOf(const ZuneHostTrack& track) {
+    return track.album_artist && *track.album_artist ? track.album_artist : track.artist;
+}
+
+uint32_t DiscOf(uint32_t disc) {
+    return disc == 0 ? 1 : disc;
+}
+
+ZuneSyncOp MakeOp(ZuneSyncOpType type, uint32_t host_index, uint32_t device_atom_id,
+                  uint32_t group = ZUNE_SYNC_NONE) {
+    return ZuneSyncOp{static_cast<int>(type), host_index, device_atom_id, group};
+}
+
+} // namespace
+
+std::string NormalizeSyncKey(const char* s) {
+    std::string out;
+    AppendKey(out, s);
+    return out;
+}
+
+ZuneSyncPlanOptions DefaultSyncPlanOptions() {
+    ZuneSyncPlanOptions options;
+    options.duration_tolerance_ms = 2000;
+    options.delete_unmatched_tracks = true;
+    options.delete_unmatched_playlists = false;
+    return options;
+}
+
+SyncPlan PlanSync(
+    const ZuneMusicLibrary& library,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const ZuneHostPlaylist* playlists, uint32_t playlist_count,
+    const ZuneSyncPlanOptions& options,
+    const SyncResume* resume,
+    const ContentIndex* content)
+{
+    SyncPlan plan;
+    plan.host_matches.assign(track_count, 0);
+    std::string key, scratch_a, scratch_b;
+
+    // ── Device side ──
+    std::unordered_map<uint32_t, uint32_t> album_by_atom;
+    album_by_atom.reserve(library.album_count);
+    std::unordered_map<std::string, uint32_t> album_by_key;
+    album_by_key.reserve(library.album_count);
+    for (uint32_t i = 0; i < library.album_count; i++) {
+        const ZuneMusicAlbum& album = library.albums[i];
+        album_by_atom.emplace(album.atom_id, i);
+        AlbumKey(key, album.artist_name, album.title);
+        album_by_key.emplace(key, album.atom_id);
+    }
+
+    std::unordered_map<std::string, std::vector<uint32_t>> device_buckets;
+    device_buckets.reserve(library.track_count);
+    for (uint32_t i = 0; i < library.track_count; i++) {
+        const ZuneMusicTrack& t = library.tracks[i];
+        auto album = album_by_atom.find(t.album_ref);
+        const char* album_title = album != album_by_atom.end() ? library.albums[album->second].title : nullptr;
+        TrackKey(key, album_title, t.title, static_cast<uint32_t>(t.track_number));
+        device_buckets[key].push_back(i);
+    }
+
+    // ── Match host tracks ──
+    std::vector<bool> claimed(library.track_count, false);
+    std::vector<bool> replaced(library.track_count, false);  // Changed files
+    std::vector<bool> is_fallback(library.track_count, false);  // Replaced on a title match alone
+    std::vector<uint32_t> adds;           // Host indices
+    std::vector<ZuneSyncOp> updates;
+
+    // ── Objects a previous, interrupted sync left behind ──
+    std::vector<bool> resumed;
+    if (resume && (!resume->committed.empty() || !resume->stale.empty())) {
+        std::unordered_map<uint32_t, uint32_t> track_by_atom;
+        track_by_atom.reserve(library.track_count);
+        for (uint32_t i = 0; i < library.track_count; i++) {
+            track_by_atom.emplace(library.tracks[i].atom_id, i);
+        }
+
+        for (uint32_t stale : resume->stale) {
+            auto d = track_by_atom.find(stale);
+            if (d != track_by_atom.end()) {
+                claimed[d->second] = true;
+                replaced[d->second] = true;
+            } else {
+                plan.ops.push_back(MakeOp(ZUNE_SYNC_OP_DELETE_TRACK, ZUNE_SYNC_NONE, stale));
+                plan.delete_count++;
+            }
+        }
+
+        resumed.assign(track_count, false);
+        for (uint32_t h = 0; h < track_count; h++) {
+            if (!tracks[h].file_path) continue;
+            auto it = resume->committed.find(tracks[h].file_path);
+            if (it == resume->committed.end()) continue;
+            auto d = track_by_atom.find(it->second);
+            if (d != track_by_atom.end()) {
+                if (claimed[d->second]) continue;
+                claimed[d->second] = true;
+            }
+            resumed[h] = true;
+            plan.host_matches[h] = it->second;
+            plan.resumed_count++;
+        }
+    }
+
+    for (uint32_t h = 0; h < track_count; h++) {
+        if (!resumed.empty() && resumed[h]) continue;
+        const ZuneHostTrack& host = tracks[h];
+        TrackKey(key, host.album, host.title, host.track_number);
+        auto bucket = device_buckets.find(key);
+        if (bucket == device_buckets.end()) {
+            adds.push_back(h);
+            continue;
+        }
+
+        uint32_t exact = ZUNE_SYNC_NONE;
+        uint32_t fallback = ZUNE_SYNC_NONE;
+        for (uint32_t d : bucket->second) {
+            if (claimed[d]) continue;
+            const ZuneMusicTrack& dev = library.tracks[d];
+            uint32_t dev_duration = static_cast<uint32_t>(std::max(dev.duration_ms, 0));
+            uint32_t delta = dev_duration > host.duration_ms ? dev_duration - host.duration_ms
+                                                             : host.duration_ms - dev_duration;
+            uint64_t dev_size = static_cast<uint64_t>(static_cast<uint32_t>(dev.file_size_bytes));
+            bool size_ok = dev_size == 0 || host.file_size == 0 || dev_size == host.file_size;
+            if (delta <= options.duration_tolerance_ms && size_ok) {
+                exact = d;
+                break;
+            }
+            if (fallback == ZUNE_SYNC_NONE) fallback = d;
+        }
+
+        if (exact != ZUNE_SYNC_NONE) {
+            claimed[exact] = true;
+            const ZuneMusicTrack& dev = library.tracks[exact];
+            plan.host_matches[h] = dev.atom_id;
+            if (!SameTag(host.artist, dev.artist_name, scratch_a, scratch_b) ||
+                !SameTag(host.genre, dev.genre, scratch_a, scratch_b) ||
+                DiscOf(host.disc_number) != DiscOf(static_cast<uint32_t>(std::max(dev.disc_number, 0)))) {
+                updates.push_back(MakeOp(ZUNE_SYNC_OP_UPDATE_TRACK, h, dev.atom_id));
+            }
+        } else {
+            if (fallback != ZUNE_SYNC_NONE) {
+                claimed[fallback] = true;
+                replaced[fallback] = true;
+                is_fallback[fallback] = true;
+            }
+            adds.push_back(h);
+        }
+    }
+
+    // ── Content identity: renamed or re-tagged copies the device already has ──
+    if (content && content->Size() > 0 && !adds.empty()) {
+        std::unordered_map<uint32_t, uint32_t> track_by_atom;
+        track_by_atom.reserve(library.track_count);
+        for (uint32_t i = 0; i < library.track_count; i++) {
+            track_by_atom.emplace(library.tracks[i].atom_id, i);
+        }
+
+        size_t kept = 0;
+        for (uint32_t h : adds) {
+            const ZuneHostTrack& host = tracks[h];
+            ContentFingerprint fingerprint;
+            uint32_t atom = 0;
+            if (host.file_path && ContentFingerprint::FromFile(host.file_path, fingerprint))
+                atom = content->Find(fingerprint);
+            auto d = atom ? track_by_atom.find(atom) : track_by_atom.end();
+            // A title-only fallback is still fair game: identical bytes beat a name match
+            if (d == track_by_atom.end() || (claimed[d->second] && !is_fallback[d->second])) {
+                adds[kept++] = h;
+                continue;
+            }
+            const ZuneMusicTrack& dev = library.tracks[d->second];
+            uint64_t dev_size = static_cast<uint64_t>(static_cast<uint32_t>(dev.file_size_bytes));
+            if (dev_size != 0 && dev_size != (fingerprint.size & 0xFFFFFFFFu)) {
+                adds[kept++] = h;
+                continue;
+            }
+
+            claimed[d->second] = true;
+            replaced[d->second] = false;
+            is_fallback[d->second] = false;
+            plan.host_matches[h] = dev.atom_id;
+            plan.identified_count++;
+            auto album = album_by_atom.find(dev.album_ref);
+            const char* album_title = album != album_by_atom.end() ? library.albums[album->second].title : nullptr;
+            if (!SameTag(host.title, dev.title, scratch_a, scratch_b) ||
+                !SameTag(host.album, album_title, scratch_a, scratch_b) ||
+                !SameTag(host.artist, dev.artist_name, scratch_a, scratch_b) ||
+                !SameTag(host.genre, dev.genre, scratch_a, scratch_b) ||
+                host.track_number != static_cast<uint32_t>(std::max(dev.track_number, 0)) ||
+                DiscOf(host.disc_number) != DiscOf(static_cast<uint32_t>(std::max(dev.disc_number, 0)))) {
+                updates.push_back(MakeOp(ZUNE_SYNC_OP_UPDATE_TRACK, h, dev.atom_id));
+            }
+        }
+        adds.resize(kept);
+    }
+
+    // ── Deletes ──
+    for (uint32_t d = 0; d < library.track_count; d++) {
+        if (replaced[d] || (!claimed[d] && options.delete_unmatched_tracks)) {
+            plan.ops.push_back(MakeOp(ZUNE_SYNC_OP_DELETE_TRACK, ZUNE_SYNC_NONE, library.tracks[d].atom_id));
+            plan.delete_count++;
+        }
+    }
+
+    // ── Playlists (matched up front so deletions precede the uploads) ──
+    std::unordered_map<std::string, std::vector<uint32_t>> device_playlists;
+    for (uint32_t i = 0; i < library.playlist_count; i++) {
+        device_playlists[NormalizeSyncKey(library.playlists[i].name)].push_back(i);
+    }
+    std::vector<bool> playlist_claimed(library.playlist_count, false);
+    std::vector<ZuneSyncOp> playlist_ops;
+    for (uint32_t p = 0; p < playlist_count; p++) {
+        const ZuneHostPlaylist& host = playlists[p];
+        uint32_t device_index = ZUNE_SYNC_NONE;
+        auto it = device_playlists.find(NormalizeSyncKey(host.name));
+        if (it != device_playlists.end()) {
+            for (uint32_t d : it->second) {
+                if (!playlist_claimed[d]) {
+                    device_index = d;
+                    break;
+                }
+            }
+        }
+        if (device_index == ZUNE_SYNC_NONE) {
+            playlist_ops.push_back(MakeOp(ZUNE_SYNC_OP_CREATE_PLAYLIST, p, 0));
+            continue;
+        }
+        playlist_claimed[device_index] = true;
+
+        const ZuneMusicPlaylist& dev = library.playlists[device_index];
+        bool same = true;
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < host.track_count && same; i++) {
+            uint32_t t = host.track_indices[i];
+            if (t >= track_count) continue;
+            uint32_t atom = plan.host_matches[t];
+            same = atom != 0 && n < dev.track_count && dev.track_atom_ids[n] == atom;
+            n++;
+        }
+        if (!same || n != dev.track_count) {
+            playlist_ops.push_back(MakeOp(ZUNE_SYNC_OP_UPDATE_PLAYLIST, p, dev.atom_id));
+        }
+    }
+    if (options.delete_unmatched_playlists) {
+        for (uint32_t d = 0; d < library.playlist_count; d++) {
+            if (!playlist_claimed[d]) {
+                plan.ops.push_back(MakeOp(ZUNE_SYNC_OP_DELETE_PLAYLIST, ZUNE_SYNC_NONE,
+                                          library.playlists[d].atom_id));
+                plan.playlist_op_count++;
+            }
+        }
+    }
+
+    // ── Album groups for the adds ──
+    std::unordered_map<std::string, uint32_t> group_by_key;
+    std::vector<std::string> group_keys;
+    std::vector<uint32_t> group_of_add(adds.size());
+    for (size_t a = 0; a < adds.size(); a++) {
+        const ZuneHostTrack& host = tracks[adds[a]];
+        AlbumKey(key, AlbumArtistOf(host), host.album);
+        auto [it, inserted] = group_by_key.try_emplace(key, static_cast<uint32_t>(plan.groups.size()));
+        if (inserted) {
+            auto device_album = album_by_key.find(key);
+            plan.groups.push_back(ZuneSyncAlbumGroup{
+                AlbumArtistOf(host), host.album,
+                device_album != album_by_key.end() ? device_album->second : 0, 0});
+            group_keys.push_back(key);
+        }
+        group_of_add[a] = it->second;
+        plan.groups[it->second].add_count++;
+    }
+
+    // Groups alphabetically by artist and album; renumber so group ids follow
+    std::vector<uint32_t> order(plan.groups.size());
+    for (uint32_t g = 0; g < order.size(); g++) order[g] = g;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return group_keys[a] < group_keys[b]; });
+    std::vector<uint32_t> renumber(order.size());
+    std::vector<ZuneSyncAlbumGroup> sorted_groups;
+    sorted_groups.reserve(order.size());
+    for (uint32_t g = 0; g < order.size(); g++) {
+        renumber[order[g]] = g;
+        sorted_groups.push_back(plan.groups[order[g]]);
+    }
+    plan.groups = std::move(sorted_groups);
+
+    std::vector<size_t> add_order(adds.size());
+    for (size_t a = 0; a < add_order.size(); a++) add_order[a] = a;
+    std::sort(add_order.begin(), add_order.end(), [&](size_t a, size_t b) {
+        const ZuneHostTrack& x = tracks[adds[a]];
+        const ZuneHostTrack& y = tracks[adds[b]];
+        uint32_t gx = renumber[group_of_add[a]], gy = renumber[group_of_add[b]];
+        if (gx != gy) return gx < gy;
+        if (DiscOf(x.disc_number) != DiscOf(y.disc_number)) return DiscOf(x.disc_number) < DiscOf(y.disc_number);
+        if (x.track_number != y.track_number) return x.track_number < y.track_number;
+        return adds[a] < adds[b];
+    });
+
+    uint32_t current_group = ZUNE_SYNC_NONE;
+    for (size_t a : add_order) {
+        uint32_t g = renumber[group_of_add[a]];
+        if (g != current_group) {
+            current_group = g;
+            if (plan.groups[g].device_album_atom_id == 0) {
+                plan.ops.push_back(MakeOp(ZUNE_SYNC_OP_CREATE_ALBUM, ZUNE_SYNC_NONE, 0, g));
+            }
+        }
+        plan.ops.push_back(MakeOp(ZUNE_SYNC_OP_ADD_TRACK, adds[a], 0, g));
+        plan.add_count++;
+    }
+
+    plan.ops.insert(plan.ops.end(), updates.begin(), updates.end());
+    plan.update_count = static_cast<uint32_t>(updates.size());
+    plan.ops.insert(plan.ops.end(), playlist_ops.begin(), playlist_ops.end());
+    plan.playlist_op_count += static_cast<uint32_t>(playlist_ops.size());
+    return plan;
+}
+
+} // namespace zune
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "xune_sync/xune_sync_api.h"
+#include "ZuneSyncJournal.h"
+#include "ZuneContentIndex.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zune {
+
+/// Output of PlanSync; backs the arrays of a ZuneSyncPlan
+struct SyncPlan {
+    std::vector<ZuneSyncOp> ops;
+    std::vector<ZuneSyncAlbumGroup> groups;
+    std::vector<uint32_t> host_matches;
+    uint32_t add_count = 0;
+    uint32_t update_count = 0;
+    uint32_t delete_count = 0;
+    uint32_t playlist_op_count = 0;
+    uint32_t resumed_count = 0;
+    uint32_t identified_count = 0;
+};
+
+/// Defaults for a NULL ZuneSyncPlanOptions
+ZuneSyncPlanOptions DefaultSyncPlanOptions();
+
+/// Diff a host manifest against a device library (see zune_sync_plan_create).
+///
+/// One hash-map pass over each side: device tracks are bucketed by
+/// normalized album / title / track number, then each host track takes the
+/// first unclaimed device track in its bucket that passes the duration and
+/// size checks. Adds are grouped by album artist + album so each album's
+/// folder and metadata are created once, ahead of its tracks.
+///
+/// With resume, host tracks whose file_path the journal committed match
+/// that object directly (whether or not the library lists it yet), and the
+/// journal's stale objects are deleted.
+///
+/// With content, each host track that would still be added is fingerprinted
+/// (only those, so a matching library costs no file reads) and matches the
+/// library track the index recorded for that fingerprint, if it is present
+/// and not already claimed; differing tags become UPDATE_TRACK as usual.
+SyncPlan PlanSync(
+    const ZuneMusicLibrary& library,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const ZuneHostPlaylist* playlists, uint32_t playlist_count,
+    const ZuneSyncPlanOptions& options,
+    const SyncResume* resume = nullptr,
+    const ContentIndex* content = nullptr);
+
+/// ASCII case-folded, whitespace-collapsed and trimmed copy of s (NULL = "")
+std::string NormalizeSyncKey(const char* s);
+
+} // namespace zune
@@ -0,0 +1,125 @@
+#include "ZuneTrace.h"
+#include <cstdio>
+#include <fstream>
+
+namespace zune {
+
+std::atomic<bool> Tracer::enabled_{false};
+
+namespace {
+
+std::atomic<uint32_t> next_thread_number{1};
+
+uint32_t ThreadNumber() {
+    thread_local uint32_t number = next_thread_number.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+uint64_t MicrosBetween(Tracer::Clock::time_point from, Tracer::Clock::time_point to) {
+    if (to <= from) return 0;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+void AppendJsonString(std::string& out, const char* s) {
+    out += '"';
+    for (; s && *s; s++) {
+        char c = *s;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+Tracer::Tracer() : epoch_(Clock::now()), ring_(kCapacity) {}
+
+Tracer& Tracer::Instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::SetEnabled(bool enable) {
+    Instance();  // Fix the epoch before the first span
+    enabled_.store(enable, std::memory_order_relaxed);
+}
+
+void Tracer::Record(const char* category, const char* name, Clock::time_point start, Clock::time_point end) {
+    Event event{category, name, MicrosBetween(epoch_, start), MicrosBetween(start, end), ThreadNumber()};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ring_[next_] = event;
+    next_ = (next_ + 1) % kCapacity;
+    if (size_ < kCapacity) {
+        size_++;
+    } else {
+        dropped_++;
+    }
+}
+
+std::vector<Tracer::Event> Tracer::GetEvents() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Event> events;
+    events.reserve(size_);
+    size_t first = (next_ + kCapacity - size_) % kCapacity;
+    for (size_t i = 0; i < size_; i++) {
+        events.push_back(ring_[(first + i) % kCapacity]);
+    }
+    return events;
+}
+
+uint64_t Tracer::GetDropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void Tracer::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_ = 0;
+    size_ = 0;
+    dropped_ = 0;
+}
+
+std::string Tracer::ToChromeJson() const {
+    std::vector<Event> events = GetEvents();
+    std::string out;
+    out.reserve(64 + events.size() * 96);
+    out += "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":";
+    out += std::to_string(GetDropped());
+    out += "},\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event& e = events[i];
+        if (i) out += ',';
+        out += "\n{\"ph\":\"X\",\"pid\":1,\"tid\":";
+        out += std::to_string(e.thread);
+        out += ",\"ts\":";
+        out += std::to_string(e.start_us);
+        out += ",\"dur\":";
+        out += std::to_string(e.duration_us);
+        out += ",\"cat\":";
+        AppendJsonString(out, e.category);
+        out += ",\"name\":";
+        AppendJsonString(out, e.name);
+        out += '}';
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool Tracer::ExportChromeJson(const std::string& path) const {
+    std::string json = ToChromeJson();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return static_cast<bool>(file);
+}
+
+} // namespace zune
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace zune {
+
+/// Process-wide span tracer for connect and sync phases and MTP operations.
+///
+/// Spans are recorded when they end into a fixed ring of kCapacity events;
+/// once it is full the oldest are overwritten and counted as dropped. A span
+/// is one lock and a copy of five words, small next to the USB round trip it
+/// times. While tracing is off a Span costs one relaxed load and reads no
+/// clock.
+///
+/// Category and name must outlive the tracer (string literals or __func__).
+/// Times are microseconds on the steady clock since the tracer was created.
+/// Nesting is implied: a span that lies inside another on the same thread
+/// is its child, which is how the Chrome trace viewer draws "X" events.
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t kCapacity = 8192;
+
+    struct Event {
+        const char* category;
+        const char* name;
+        uint64_t start_us;
+        uint64_t duration_us;
+        uint32_t thread;        // Small per-thread number, in order of first span
+    };
+
+    /// Times the enclosing scope, or until End()
+    class Span {
+    public:
+        Span(const char* category, const char* name)
+            : category_(category), name_(name), active_(Tracer::IsEnabled()) {
+            if (active_) start_ = Clock::now();
+        }
+        ~Span() { End(); }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        void End() {
+            if (active_) {
+                active_ = false;
+                Tracer::Instance().Record(category_, name_, start_, Clock::now());
+            }
+        }
+
+    private:
+        const char* category_;
+        const char* name_;
+        bool active_;
+        Clock::time_point start_;
+    };
+
+    static Tracer& Instance();
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    void SetEnabled(bool enable);
+    void Record(const char* category, const char* name, Clock::time_point start, Clock::time_point end);
+
+    /// Events held, oldest first
+    std::vector<Event> GetEvents() const;
+    uint64_t GetDropped() const;
+    void Clear();
+
+    /// Chrome trace-event JSON ("X" events), for chrome://tracing or Perfetto
+    std::string ToChromeJson() const;
+    bool ExportChromeJson(const std::string& path) const;
+
+private:
+    Tracer();
+
+    static std::atomic<bool> enabled_;
+
+    const Clock::time_point epoch_;
+    mutable std::mutex mutex_;
+    std::vector<Event> ring_;   // kCapacity slots
+    size_t next_ = 0;           // Slot the next event goes to
+    size_t size_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+} // namespace zune
+
+#define ZUNE_TRACE_CONCAT_(a, b) a##b
+#define ZUNE_TRACE_CONCAT(a, b) ZUNE_TRACE_CONCAT_(a, b)
+
+/// Trace the rest of the enclosing scope as category / name
+#define ZUNE_TRACE_SPAN(category, name) \
+    ::zune::Tracer::Span ZUNE_TRACE_CONCAT(zune_trace_span_, __LINE__)((category), (name))
@@ -0,0 +1,96 @@
+#include "ZuneTransferStats.h"
+
+namespace zune {
+
+TransferStats::Scope::~Scope() {
+    if (!stats_) return;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+    stats_->Record(op_, static_cast<uint64_t>(elapsed.count()), sent_, received_, ok_);
+}
+
+unsigned TransferStats::BucketFor(uint64_t duration_us) {
+    unsigned bucket = 0;
+    while (duration_us != 0 && bucket < ZUNE_TRANSFER_HISTOGRAM_BUCKETS - 1) {
+        duration_us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void TransferStats::Record(ZuneTransferOp op, uint64_t duration_us,
+                           uint64_t bytes_sent, uint64_t bytes_received, bool ok) {
+    if (static_cast<int>(op) < 0 || op >= ZUNE_TRANSFER_OP_COUNT) return;
+    auto& c = ops_[op];
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    c.count.fetch_add(1, relaxed);
+    if (!ok) c.failures.fetch_add(1, relaxed);
+    c.total_us.fetch_add(duration_us, relaxed);
+    c.bytes_sent.fetch_add(bytes_sent, relaxed);
+    c.bytes_received.fetch_add(bytes_received, relaxed);
+    c.histogram[BucketFor(duration_us)].fetch_add(1, relaxed);
+
+    uint64_t max = c.max_us.load(relaxed);
+    while (duration_us > max && !c.max_us.compare_exchange_weak(max, duration_us, relaxed)) {
+    }
+}
+
+void TransferStats::Snapshot(ZuneTransferStats& out) const {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    out = ZuneTransferStats{};
+    for (int op = 0; op < ZUNE_TRANSFER_OP_COUNT; op++) {
+        const auto& c = ops_[op];
+        auto& o = out.ops[op];
+        o.count = c.count.load(relaxed);
+        o.failures = c.failures.load(relaxed);
+        o.total_us = c.total_us.load(relaxed);
+        o.max_us = c.max_us.load(relaxed);
+        o.bytes_sent = c.bytes_sent.load(relaxed);
+        o.bytes_received = c.bytes_received.load(relaxed);
+        for (int b = 0; b < ZUNE_TRANSFER_HISTOGRAM_BUCKETS; b++) {
+            o.histogram[b] = c.histogram[b].load(relaxed);
+        }
+        out.bytes_sent += o.bytes_sent;
+        out.bytes_received += o.bytes_received;
+    }
+}
+
+void TransferStats::Reset() {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    for (auto& c : ops_) {
+        c.count.store(0, relaxed);
+        c.failures.store(0, relaxed);
+        c.total_us.store(0, relaxed);
+        c.max_us.store(0, relaxed);
+        c.bytes_sent.store(0, relaxed);
+        c.bytes_received.store(0, relaxed);
+        for (auto& h : c.histogram) h.store(0, relaxed);
+    }
+}
+
+void TransferStats::SetProgressCallback(zune_transfer_progress_callback_t callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(progress_mutex_);
+    progress_callback_ = callback;
+    progress_user_data_ = user_data;
+    has_progress_.store(callback != nullptr, std::memory_order_relaxed);
+}
+
+void TransferStats::ReportProgress(ZuneTransferOp op, uint64_t done, uint64_t total,
+                                   Clock::time_point started) {
+    if (!HasProgressCallback()) return;
+
+    zune_transfer_progress_callback_t callback;
+    void* user_data;
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        callback = progress_callback_;
+        user_data = progress_user_data_;
+    }
+    if (!callback) return;
+
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    double rate = seconds > 0 ? static_cast<double>(done) / seconds : 0.0;
+    callback(op, done, total, rate, user_data);
+}
+
+} // namespace zune
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "xune_sync/xune_sync_api.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace zune {
+
+/// Per-device transfer counters and the live progress callback.
+///
+/// Recording is a handful of relaxed atomic adds, so it is safe from the
+/// USB thread, upload workers and the network poller at once. Progress
+/// reporting is gated on one relaxed load: with no callback registered a
+/// data path pays nothing beyond that check.
+class TransferStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Times one operation and records it on destruction. A null stats
+    /// pointer makes the scope a no-op (no clock reads).
+    class Scope {
+    public:
+        Scope(TransferStats* stats, ZuneTransferOp op, uint64_t bytes_sent = 0)
+            : stats_(stats), op_(op), sent_(bytes_sent) {
+            if (stats_) start_ = Clock::now();
+        }
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void AddSent(uint64_t n) { sent_ += n; }
+        void AddReceived(uint64_t n) { received_ += n; }
+        /// Record the operation as successful; otherwise it counts as a failure
+        void Succeeded() { ok_ = true; }
+
+    private:
+        TransferStats* stats_;
+        ZuneTransferOp op_;
+        uint64_t sent_;
+        uint64_t received_ = 0;
+        bool ok_ = false;
+        Clock::time_point start_;
+    };
+
+    /// Run fn under a Scope. A returned container (mtp::ByteArray) counts as
+    /// bytes received; other results pass through. An exception counts as a
+    /// failure and propagates.
+    template <typename Fn>
+    static auto Measure(TransferStats* stats, ZuneTransferOp op, uint64_t bytes_sent, Fn&& fn)
+        -> decltype(fn())
+    {
+        Scope scope(stats, op, bytes_sent);
+        if constexpr (std::is_void_v<decltype(fn())>) {
+            fn();
+            scope.Succeeded();
+        } else {
+            auto result = fn();
+            if constexpr (HasSize<decltype(result)>::value) {
+                scope.AddReceived(result.size());
+            }
+            scope.Succeeded();
+            return result;
+        }
+    }
+
+    /// Histogram bucket for a latency: 0 for < 1 us, else bit width of us
+    static unsigned BucketFor(uint64_t duration_us);
+
+    void Record(ZuneTransferOp op, uint64_t duration_us,
+                uint64_t bytes_sent, uint64_t bytes_received, bool ok = true);
+
+    void Snapshot(ZuneTransferStats& out) const;
+    void Reset();
+
+    void SetProgressCallback(zune_transfer_progress_callback_t callback, void* user_data);
+    bool HasProgressCallback() const { return has_progress_.load(std::memory_order_relaxed); }
+
+    /// Invoke the progress callback, if any, with the rate since started
+    void ReportProgress(ZuneTransferOp op, uint64_t done, uint64_t total, Clock::time_point started);
+
+private:
+    template <typename T, typename = void>
+    struct HasSize : std::false_type {};
+    template <typename T>
+    struct HasSize<T, std::void_t<decltype(std::declval<const T&>().size())>> : std::true_type {};
+
+    struct OpCounters {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> total_us{0};
+        std::atomic<uint64_t> max_us{0};
+        std::atomic<uint64_t> bytes_sent{0};
+        std::atomic<uint64_t> bytes_received{0};
+        std::atomic<uint64_t> histogram[ZUNE_TRANSFER_HISTOGRAM_BUCKETS] = {};
+    };
+
+    OpCounters ops_[ZUNE_TRANSFER_OP_COUNT];
+
+    std::atomic<bool> has_progress_{false};
+    std::mutex progress_mutex_;
+    zune_transfer_progress_callback_t progress_callback_ = nullptr;
+    void* progress_user_data_ = nullptr;
+};
+
+} // namespace zune
@@ -0,0 +1,340 @@
+#include "ZuneUploadEngine.h"
+#include "ZuneMtpWriter.h"
+#include "ZuneMtpReader.h"
+#include "ZuneUploadVerifier.h"
+#include "ZuneFileSource.h"
+#include "ZuneMediaScanner.h"
+#include <mtp/ptp/ObjectFormat.h>
+#include <mtp/ptp/Response.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace zune {
+
+namespace {
+
+// SendObject source: a preloaded buffer or the mapped file, reporting
+// bytes handed to the bulk pipe
+class UploadSourceStream : public mtp::IObjectInputStream {
+public:
+    using Progress = std::function<void(uint64_t sent, uint64_t total)>;
+
+    UploadSourceStream(mtp::ByteArray data, Progress progress)
+        : data_(std::move(data)), size_(data_.size()), progress_(std::move(progress)) {}
+
+    UploadSourceStream(const std::string& path, Progress progress)
+        : progress_(std::move(progress)) {
+        file_.Open(path);
+        size_ = file_.Size();
+    }
+
+    bool IsOpen() const { return !data_.empty() || size_ == 0 || file_.IsOpen(); }
+
+    mtp::u64 GetSize() const override { return size_; }
+
+    size_t Read(mtp::u8* data, size_t size) override {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(size, size_ - sent_));
+        if (n == 0) return 0;
+
+        if (file_.IsOpen()) {
+            n = file_.Read(data, n);
+        } else {
+            std::memcpy(data, data_.data() + sent_, n);
+        }
+
+        sent_ += n;
+        if (progress_) progress_(sent_, size_);
+        return n;
+    }
+
+    void Cancel() override {}
+
+private:
+    mtp::ByteArray data_;
+    FileSource file_;
+    uint64_t size_ = 0;
+    uint64_t sent_ = 0;
+    Progress progress_;
+};
+
+// Output of the worker stage for one item
+struct PreparedItem {
+    UploadItemResult result;       // status, format_code, file_size, properties
+    mtp::ByteArray prop_list;
+    mtp::ByteArray data;           // Empty unless preloaded
+    ContentFingerprint fingerprint;  // Set when options.content_index is
+};
+
+void PrepareItem(const UploadItem& item, const UploadEngineOptions& options, PreparedItem& out) {
+    UploadItemResult& r = out.result;
+
+    std::error_code ec;
+    r.file_size = fs::file_size(item.file_path, ec);
+    if (ec) {
+        r.status = ZUNE_UPLOAD_READ_FAILED;
+        return;
+    }
+
+    if (item.has_properties) {
+        r.properties = item.properties;
+        if (r.properties.filename.empty())
+            r.properties.filename = fs::path(item.file_path).filename().string();
+    } else if (!UploadEngine::ReadTrackProperties(
+                   item.file_path, options.is_hd, item.artist_meta_id, r.properties)) {
+        r.status = ZUNE_UPLOAD_READ_FAILED;
+        return;
+    }
+
+    r.format_code = static_cast<uint16_t>(mtp::ObjectFormatFromFilename(item.file_path));
+    out.prop_list = MtpWriter::BuildTrackPropList(r.properties);
+
+    if (options.preload_data && r.file_size > 0) {
+        std::ifstream file(item.file_path, std::ios::binary);
+        out.data.resize(static_cast<size_t>(r.file_size));
+        if (!file.read(reinterpret_cast<char*>(out.data.data()),
+                       static_cast<std::streamsize>(out.data.size()))) {
+            r.status = ZUNE_UPLOAD_READ_FAILED;
+            mtp::ByteArray().swap(out.data);
+            return;
+        }
+    }
+
+    if (options.content_index) {
+        if (!out.data.empty() || r.file_size == 0)
+            out.fingerprint = ContentFingerprint::FromData(out.data.data(), out.data.size());
+        else if (!ContentFingerprint::FromFile(item.file_path, out.fingerprint))
+            r.status = ZUNE_UPLOAD_READ_FAILED;
+    }
+}
+
+} // namespace
+
+UploadEngine::UploadEngine(SessionPtr session, uint32_t storage_id, UploadEngineOptions options)
+    : session_(std::move(session)), storage_id_(storage_id), options_(options) {
+    options_.worker_threads = std::max(1u, options_.worker_threads);
+    options_.lookahead = std::max<size_t>(1, options_.lookahead);
+}
+
+bool UploadEngine::ReadTrackProperties(
+    const std::string& file_path, bool is_hd, uint32_t artist_meta_id,
+    TrackProperties& props)
+{
+    ScannedTrack scanned;
+    if (!MediaScanner::ReadTags(file_path, false, scanned))
+        return false;
+
+    props = std::move(scanned.track);
+    props.is_hd = is_hd;
+    props.artist_meta_id = artist_meta_id;
+    return true;
+}
+
+std::vector<UploadItemResult> UploadEngine::Run(
+    const std::vector<UploadItem>& items,
+    const ProgressCallback& on_progress,
+    const ResultCallback& on_result)
+{
+    const size_t count = items.size();
+    std::vector<UploadItemResult> results(count);
+    if (count == 0) return results;
+
+    std::vector<std::unique_ptr<PreparedItem>> prepared(count);
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t next_to_prepare = 0;
+    size_t next_to_send = 0;
+    bool stop = false;
+
+    // Worker stage: prepare items up to `lookahead` ahead of the sender
+    auto worker = [&] {
+        for (;;) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] {
+                    return stop || next_to_prepare >= count ||
+                           next_to_prepare < next_to_send + options_.lookahead;
+                });
+                if (stop || next_to_prepare >= count) return;
+                index = next_to_prepare++;
+            }
+
+            auto item = std::make_unique<PreparedItem>();
+            item->result.index = index;
+            try {
+                PrepareItem(items[index], options_, *item);
+            } catch (...) {
+                item->result.status = ZUNE_UPLOAD_READ_FAILED;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            prepared[index] = std::move(item);
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    unsigned worker_count = static_cast<unsigned>(std::min<size_t>(options_.worker_threads, count));
+    for (unsigned i = 0; i < worker_count; i++)
+        workers.emplace_back(worker);
+
+    // USB stage: strictly sequential, in list order
+    bool cancelled = false;
+    const bool batched = options_.verify && options_.verify_policy == ZUNE_UPLOAD_VERIFY_BATCHED;
+    UploadVerifier verifier;
+    std::vector<size_t> album_run;  // Items sent but not yet reported
+    for (size_t index = 0; index < count; index++) {
+        std::unique_ptr<PreparedItem> item;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!cancelled)
+                cv.wait(lock, [&] { return prepared[index] != nullptr; });
+            item = std::move(prepared[index]);
+        }
+
+        UploadItemResult& r = results[index];
+        if (cancelled || !item) {
+            r.index = index;
+            r.status = ZUNE_UPLOAD_CANCELLED;
+            continue;
+        }
+        r = std::move(item->result);
+
+        // SendObjectPropList, SendObject and the verify go out as one unit:
+        // the device expects the data right after the object is created.
+        // Other operations (network polls, reads) are scheduled between items.
+        MtpScheduler::Grant grant;
+        if (r.status == ZUNE_UPLOAD_OK && options_.scheduler)
+            grant = options_.scheduler->Acquire(ZUNE_MTP_CLASS_BULK);
+
+        if (r.status == ZUNE_UPLOAD_OK) {
+            try {
+                r.track_id = TransferStats::Measure(
+                    options_.stats, ZUNE_TRANSFER_OP_SEND_OBJECT_PROP_LIST, item->prop_list.size(), [&] {
+                        return MtpWriter::SendTrackPropList(
+                            session_, storage_id_, items[index].album_folder,
+                            item->prop_list, r.format_code, r.file_size);
+                    });
+                if (r.track_id == 0)
+                    r.status = ZUNE_UPLOAD_CREATE_FAILED;
+                else if (options_.journal)
+                    options_.journal->RecordCreated(r.track_id, r.file_size);
+            } catch (const mtp::InvalidResponseException& ex) {
+                r.mtp_error = static_cast<uint16_t>(ex.Type);
+                r.status = ZUNE_UPLOAD_CREATE_FAILED;
+            } catch (...) {
+                r.status = ZUNE_UPLOAD_CREATE_FAILED;
+            }
+        }
+
+        if (r.status == ZUNE_UPLOAD_OK) {
+            UploadSourceStream::Progress progress;
+            TransferStats* stats = options_.stats;
+            if (on_progress || (stats && stats->HasProgressCallback())) {
+                auto started = TransferStats::Clock::now();
+                progress = [&, stats, started](uint64_t sent, uint64_t total) {
+                    if (on_progress) on_progress(index, sent, total);
+                    if (stats) stats->ReportProgress(ZUNE_TRANSFER_OP_SEND_OBJECT, sent, total, started);
+                };
+            }
+
+            std::shared_ptr<UploadSourceStream> stream = options_.preload_data
+                ? std::make_shared<UploadSourceStream>(std::move(item->data), progress)
+                : std::make_shared<UploadSourceStream>(items[index].file_path, progress);
+            try {
+                if (!stream->IsOpen())
+                    throw std::runtime_error("cannot open " + items[index].file_path);
+                TransferStats::Measure(stats, ZUNE_TRANSFER_OP_SEND_OBJECT, r.file_size,
+                                       [&] { MtpWriter::UploadObjectData(session_, stream); });
+                if (options_.verify && options_.verify_policy == ZUNE_UPLOAD_VERIFY_PER_OBJECT) {
+                    TransferStats::Measure(stats, ZUNE_TRANSFER_OP_GET_OBJECT_PROP_LIST, 0,
+                                           [&] { MtpWriter::VerifyTrack(session_, r.track_id); });
+                }
+                if (options_.journal)
+                    options_.journal->RecordCommitted(r.track_id, items[index].file_path);
+                if (options_.content_index)
+                    options_.content_index->Record(item->fingerprint, r.track_id);
+            } catch (...) {
+                r.status = ZUNE_UPLOAD_TRANSFER_FAILED;
+            }
+        }
+        grant.Release();
+        item.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            next_to_send = index + 1;
+        }
+        cv.notify_all();
+
+        if (batched) {
+            if (r.status == ZUNE_UPLOAD_OK)
+                verifier.Expect(r.track_id, items[index].album_folder, r.file_size);
+            album_run.push_back(index);
+            bool album_end = index + 1 == count || items[index + 1].album_folder != items[index].album_folder;
+            if (!album_end) continue;
+            VerifyAlbumFolder(verifier, items[index].album_folder, album_run, results);
+        } else {
+            album_run.assign(1, index);
+        }
+
+        for (size_t reported : album_run) {
+            if (!cancelled && on_result && !on_result(results[reported])) {
+                cancelled = true;
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+                cv.notify_all();
+            }
+        }
+        album_run.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers)
+        t.join();
+
+    return results;
+}
+
+void UploadEngine::VerifyAlbumFolder(
+    UploadVerifier& verifier, uint32_t folder,
+    const std::vector<size_t>& run, std::vector<UploadItemResult>& results)
+{
+    if (verifier.Pending() == 0) return;
+
+    MtpScheduler::Grant grant;
+    if (options_.scheduler)
+        grant = options_.scheduler->Acquire(ZUNE_MTP_CLASS_BULK);
+    std::unordered_map<uint32_t, uint64_t> sizes;
+    bool listed = TransferStats::Measure(options_.stats, ZUNE_TRANSFER_OP_GET_OBJECT_PROP_LIST, 0,
+                                         [&] { return MtpReader::GetObjectSizes(session_, sizes, folder); });
+    grant.Release();
+
+    // An unreadable list proves nothing either way, as a failed
+    // per-object read did not
+    if (!listed) {
+        verifier.Clear();
+        return;
+    }
+    std::vector<uint32_t> unconfirmed = verifier.Check(sizes, folder);
+    for (size_t index : run) {
+        UploadItemResult& r = results[index];
+        if (r.status == ZUNE_UPLOAD_OK &&
+            std::binary_search(unconfirmed.begin(), unconfirmed.end(), r.track_id))
+            r.status = ZUNE_UPLOAD_TRANSFER_FAILED;
+    }
+}
+
+} // namespace zune
@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * ZuneUploadEngine — Pipelined multi-track upload.
+ *
+ * An upload is CreateTrack (SendObjectPropList) → SendObject → VerifyTrack
+ * per file, and MTP only allows one object in flight. Run() keeps that
+ * sequence on the calling thread but moves everything else off it: worker
+ * threads read tags, build the property list and (optionally) load the file
+ * into memory for the next `lookahead` items, so each SendObject follows the
+ * previous one without the bulk pipe waiting on the host.
+ *
+ * Items are sent in list order. Progress and result callbacks run on the
+ * calling thread, between MTP operations.
+ */
+
+#include <mtp/ptp/Session.h>
+#include "xune_sync/xune_sync_api.h"  // ZUNE_UPLOAD_* status codes
+#include "ZuneMtpWriterTypes.h"
+#include "ZuneSyncJournal.h"
+#include "ZuneContentIndex.h"
+#include "ZuneMtpScheduler.h"
+#include "ZuneTransferStats.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace zune {
+
+class UploadVerifier;
+
+struct UploadItem {
+    std::string file_path;
+    uint32_t album_folder = 0;     // Parent folder for the track object
+    // false: read tags from file_path on a worker thread
+    bool has_properties = false;
+    TrackProperties properties;    // Used when has_properties (empty filename = file name)
+    uint32_t artist_meta_id = 0;   // HD: applied to tag-read properties
+};
+
+struct UploadItemResult {
+    size_t index = 0;
+    int status = ZUNE_UPLOAD_OK;   // ZuneUploadStatus
+    uint32_t track_id = 0;
+    uint16_t mtp_error = 0;        // Device response code when status is ZUNE_UPLOAD_CREATE_FAILED
+    uint16_t format_code = 0;
+    uint64_t file_size = 0;
+    TrackProperties properties;    // As sent to the device
+};
+
+struct UploadEngineOptions {
+    bool is_hd = false;
+    unsigned worker_threads = 2;
+    size_t lookahead = 4;          // Items prepared ahead of the one being sent
+    bool preload_data = true;      // Read each file into memory on the worker
+    bool verify = true;            // Read uploads back, as verify_policy says
+    // Per object: VerifyTrack after each SendObject. Batched: one ObjectSize
+    // list per run of items in the same album folder, after its last item;
+    // results for the run are reported then, and tracks the list does not
+    // show at their size fail. Deferred: nothing here (the caller records
+    // the results in an UploadVerifier).
+    ZuneUploadVerifyPolicy verify_policy = ZUNE_UPLOAD_VERIFY_PER_OBJECT;
+    TransferStats* stats = nullptr;  // Device counters / progress callback; may be null
+    SyncJournal* journal = nullptr;  // Records each created / completed object; may be null
+    ContentIndex* content_index = nullptr;  // Fingerprints each completed object; may be null
+    MtpScheduler* scheduler = nullptr;  // Grant per operation, so others run between items; may be null
+};
+
+class UploadEngine {
+public:
+    using SessionPtr = std::shared_ptr<mtp::Session>;
+    using ProgressCallback = std::function<void(size_t index, uint64_t bytes_sent, uint64_t total_bytes)>;
+    // Return false to stop; the remaining items are reported as cancelled
+    using ResultCallback = std::function<bool(const UploadItemResult& result)>;
+
+    UploadEngine(SessionPtr session, uint32_t storage_id, UploadEngineOptions options);
+
+    // Upload items in order. Returns one result per item.
+    std::vector<UploadItemResult> Run(
+        const std::vector<UploadItem>& items,
+        const ProgressCallback& on_progress = nullptr,
+        const ResultCallback& on_result = nullptr);
+
+    // Track properties from the file's tags (MediaScanner::ReadTags).
+    // Untagged text fields are left empty so CreateTrack omits them.
+    // Returns false if the file cannot be opened.
+    static bool ReadTrackProperties(
+        const std::string& file_path, bool is_hd, uint32_t artist_meta_id,
+        TrackProperties& props);
+
+private:
+    // Batched verification of the items in run, all in folder
+    void VerifyAlbumFolder(UploadVerifier& verifier, uint32_t folder,
+                           const std::vector<size_t>& run, std::vector<UploadItemResult>& results);
+
+    SessionPtr session_;
+    uint32_t storage_id_;
+    UploadEngineOptions options_;
+};
+
+} // namespace zune
@@ -0,0 +1,56 @@
+#include "ZuneUploadVerifier.h"
+#include <algorithm>
+
+namespace zune {
+
+void UploadVerifier::Expect(uint32_t object, uint32_t parent, uint64_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    expected_[object] = {parent, size};
+    if (std::find(folders_.begin(), folders_.end(), parent) == folders_.end()) {
+        folders_.push_back(parent);
+    }
+}
+
+std::vector<uint32_t> UploadVerifier::Check(
+    const std::unordered_map<uint32_t, uint64_t>& sizes, uint32_t parent)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint32_t> unconfirmed;
+    for (auto it = expected_.begin(); it != expected_.end();) {
+        if (parent != 0 && it->second.parent != parent) {
+            ++it;
+            continue;
+        }
+        auto listed = sizes.find(it->first);
+        if (listed == sizes.end() || listed->second != it->second.size) {
+            unconfirmed.push_back(it->first);
+        }
+        it = expected_.erase(it);
+    }
+    std::sort(unconfirmed.begin(), unconfirmed.end());
+
+    if (parent == 0) {
+        folders_.clear();
+    } else {
+        folders_.erase(std::remove(folders_.begin(), folders_.end(), parent), folders_.end());
+    }
+    return unconfirmed;
+}
+
+std::vector<uint32_t> UploadVerifier::Folders() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return folders_;
+}
+
+size_t UploadVerifier::Pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return expected_.size();
+}
+
+void UploadVerifier::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    expected_.clear();
+    folders_.clear();
+}
+
+} // namespace zune
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace zune {
+
+/// Uploaded objects waiting for a batched or deferred read-back
+/// (ZUNE_UPLOAD_VERIFY_BATCHED / _DEFERRED).
+///
+/// Instead of a property read after every object, uploads are recorded
+/// here with the folder they went to and the size sent. One ObjectSize
+/// property list (for a folder, or for the whole device) then confirms
+/// every recorded object it covers: an object is confirmed when the
+/// device lists it at the size that was sent. Thread-safe.
+class UploadVerifier {
+public:
+    /// Expect object in parent with size bytes
+    void Expect(uint32_t object, uint32_t parent, uint64_t size);
+
+    /// Settle the objects a listing covers and forget them. sizes is an
+    /// ObjectSize list of parent's children, or of every object when
+    /// parent is 0. Returns the objects it did not confirm.
+    std::vector<uint32_t> Check(const std::unordered_map<uint32_t, uint64_t>& sizes, uint32_t parent = 0);
+
+    /// Folders with objects still expected, in the order first recorded
+    std::vector<uint32_t> Folders() const;
+
+    size_t Pending() const;
+    void Clear();
+
+private:
+    struct Expected {
+        uint32_t parent;
+        uint64_t size;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, Expected> expected_;
+    std::vector<uint32_t> folders_;
+};
+
+} // namespace zune
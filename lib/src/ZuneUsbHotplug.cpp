@@ -0,0 +1,337 @@
+#include "ZuneUsbHotplug.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <cfgmgr32.h>
+#include <initguid.h>
+#include <usbiodef.h>
+#include <cwctype>
+#elif defined(__APPLE__)
+#include <IOKit/IOKitLib.h>
+#include <IOKit/usb/IOUSBLib.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include <dispatch/dispatch.h>
+#else
+#include <libusb.h>
+#endif
+
+namespace zune {
+
+namespace {
+// libusb delivers hotplug events on the thread handling its events; this
+// bounds how long Stop() waits for that thread
+constexpr int PUMP_MS = 250;
+
+std::string ProductIdString(uint16_t product_id) {
+    char text[5];
+    snprintf(text, sizeof(text), "%04x", product_id);
+    return text;
+}
+}
+
+#define HOTPLUG_LOG(level, message) ZUNE_LOG(logger_, "zune_usb_hotplug", MTP, level, message)
+
+// ── Platform notifications ────────────────────────────────────────────────
+
+#if defined(_WIN32)
+
+struct UsbHotplug::Platform {
+    HCMNOTIFICATION handle = nullptr;
+};
+
+static DWORD CALLBACK OnDeviceChange(HCMNOTIFICATION, PVOID context, CM_NOTIFY_ACTION action,
+                                     PCM_NOTIFY_EVENT_DATA data, DWORD) {
+    if (action != CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL &&
+        action != CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL) {
+        return ERROR_SUCCESS;
+    }
+    // Symbolic links look like \\?\USB#VID_045E&PID_0710#...
+    std::wstring link = data->u.DeviceInterface.SymbolicLink;
+    std::transform(link.begin(), link.end(), link.begin(), ::towupper);
+    if (link.find(L"VID_045E") != std::wstring::npos) {
+        static_cast<UsbHotplug*>(context)->Notify();
+    }
+    return ERROR_SUCCESS;
+}
+
+bool UsbHotplug::Subscribe() {
+    CM_NOTIFY_FILTER filter = {};
+    filter.cbSize = sizeof(filter);
+    filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+    filter.u.DeviceInterface.ClassGuid = GUID_DEVINTERFACE_USB_DEVICE;
+
+    HCMNOTIFICATION handle = nullptr;
+    if (CM_Register_Notification(&filter, this, OnDeviceChange, &handle) != CR_SUCCESS) {
+        return false;
+    }
+    platform_ = std::make_unique<Platform>();
+    platform_->handle = handle;
+    return true;
+}
+
+void UsbHotplug::Unsubscribe() {
+    if (platform_) {
+        CM_Unregister_Notification(platform_->handle);
+        platform_.reset();
+    }
+}
+
+bool UsbHotplug::PumpsEvents() const { return false; }
+void UsbHotplug::PumpEvents(int) {}
+
+#elif defined(__APPLE__)
+
+struct UsbHotplug::Platform {
+    IONotificationPortRef port = nullptr;
+    dispatch_queue_t queue = nullptr;
+    io_iterator_t added = IO_OBJECT_NULL;
+    io_iterator_t removed = IO_OBJECT_NULL;
+};
+
+// Notifications are re-armed only once the iterator has been emptied
+static void DrainIterator(io_iterator_t iterator) {
+    io_object_t object;
+    while ((object = IOIteratorNext(iterator)) != IO_OBJECT_NULL) {
+        IOObjectRelease(object);
+    }
+}
+
+static void OnMatch(void* refcon, io_iterator_t iterator) {
+    DrainIterator(iterator);
+    static_cast<UsbHotplug*>(refcon)->Notify();
+}
+
+static CFMutableDictionaryRef MatchVendor(int vendor_id) {
+    CFMutableDictionaryRef match = IOServiceMatching(kIOUSBDeviceClassName);
+    if (!match) return nullptr;
+    CFNumberRef vid = CFNumberCreate(nullptr, kCFNumberIntType, &vendor_id);
+    CFDictionarySetValue(match, CFSTR(kUSBVendorID), vid);
+    CFRelease(vid);
+    return match;
+}
+
+bool UsbHotplug::Subscribe() {
+    auto platform = std::make_unique<Platform>();
+    platform->port = IONotificationPortCreate(kIOMasterPortDefault);
+    if (!platform->port) {
+        return false;
+    }
+    platform->queue = dispatch_queue_create("xune.usb-hotplug", DISPATCH_QUEUE_SERIAL);
+    IONotificationPortSetDispatchQueue(platform->port, platform->queue);
+    platform_ = std::move(platform);
+
+    // Each call consumes its matching dictionary
+    kern_return_t added = IOServiceAddMatchingNotification(platform_->port, kIOFirstMatchNotification,
+                                                           MatchVendor(VENDOR_ID), OnMatch, this, &platform_->added);
+    kern_return_t removed = IOServiceAddMatchingNotification(platform_->port, kIOTerminatedNotification,
+                                                             MatchVendor(VENDOR_ID), OnMatch, this, &platform_->removed);
+    if (added != KERN_SUCCESS || removed != KERN_SUCCESS) {
+        Unsubscribe();
+        return false;
+    }
+    // Devices already present are picked up by the first Rescan()
+    DrainIterator(platform_->added);
+    DrainIterator(platform_->removed);
+    return true;
+}
+
+void UsbHotplug::Unsubscribe() {
+    if (!platform_) {
+        return;
+    }
+    if (platform_->added != IO_OBJECT_NULL) IOObjectRelease(platform_->added);
+    if (platform_->removed != IO_OBJECT_NULL) IOObjectRelease(platform_->removed);
+    IONotificationPortDestroy(platform_->port);
+    // Let a callback already queued finish before this object can go away
+    dispatch_sync_f(platform_->queue, nullptr, [](void*) {});
+    dispatch_release(platform_->queue);
+    platform_.reset();
+}
+
+bool UsbHotplug::PumpsEvents() const { return false; }
+void UsbHotplug::PumpEvents(int) {}
+
+#else
+
+struct UsbHotplug::Platform {
+    libusb_context* context = nullptr;
+    libusb_hotplug_callback_handle handle = 0;
+};
+
+static int LIBUSB_CALL OnHotplug(libusb_context*, libusb_device*, libusb_hotplug_event, void* user_data) {
+    static_cast<UsbHotplug*>(user_data)->Notify();
+    return 0;  // Stay registered
+}
+
+bool UsbHotplug::Subscribe() {
+    if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+        return false;
+    }
+    libusb_context* context = nullptr;
+    if (libusb_init(&context) != LIBUSB_SUCCESS) {
+        return false;
+    }
+    libusb_hotplug_callback_handle handle;
+    int rc = libusb_hotplug_register_callback(
+        context,
+        static_cast<libusb_hotplug_event>(LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+        LIBUSB_HOTPLUG_NO_FLAGS, VENDOR_ID, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+        OnHotplug, this, &handle);
+    if (rc != LIBUSB_SUCCESS) {
+        libusb_exit(context);
+        return false;
+    }
+    platform_ = std::make_unique<Platform>();
+    platform_->context = context;
+    platform_->handle = handle;
+    return true;
+}
+
+void UsbHotplug::Unsubscribe() {
+    if (platform_) {
+        libusb_hotplug_deregister_callback(platform_->context, platform_->handle);
+        libusb_exit(platform_->context);
+        platform_.reset();
+    }
+}
+
+bool UsbHotplug::PumpsEvents() const { return platform_ != nullptr; }
+
+void UsbHotplug::PumpEvents(int timeout_ms) {
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    libusb_handle_events_timeout_completed(platform_->context, &tv, nullptr);
+}
+
+#endif
+
+// ── Monitor ───────────────────────────────────────────────────────────────
+
+UsbHotplug::UsbHotplug() = default;
+
+UsbHotplug::~UsbHotplug() {
+    Stop();
+}
+
+bool UsbHotplug::Start(Callback callback) {
+    if (running_) {
+        return false;
+    }
+    callback_ = std::move(callback);
+    subscribed_ = Subscribe();
+    if (!subscribed_) {
+        HOTPLUG_LOG(WARNING, "No USB notifications, enumerating every " + std::to_string(FALLBACK_POLL_MS) + " ms");
+    }
+    running_ = true;
+    thread_ = std::thread(&UsbHotplug::Run, this);
+    return true;
+}
+
+void UsbHotplug::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    Unsubscribe();
+    subscribed_ = false;
+}
+
+UsbHotplug::Snapshot UsbHotplug::GetSnapshot() const {
+    std::lock_guard<std::mutex> lock(devices_mutex_);
+    return snapshot_;
+}
+
+void UsbHotplug::Notify() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        pending_ = true;
+    }
+    wake_.notify_all();
+}
+
+void UsbHotplug::Run() {
+    Rescan();
+
+    while (running_) {
+        if (PumpsEvents()) {
+            PumpEvents(PUMP_MS);
+        } else {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            auto woken = [this] { return pending_ || !running_; };
+            if (subscribed_) {
+                wake_.wait(lock, woken);
+            } else if (!wake_.wait_for(lock, std::chrono::milliseconds(FALLBACK_POLL_MS), woken)) {
+                pending_ = true;
+            }
+        }
+
+        bool rescan;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            rescan = pending_;
+            pending_ = false;
+        }
+        if (rescan && running_) {
+            Rescan();
+        }
+    }
+}
+
+void UsbHotplug::Rescan() {
+    // Backends enumerate when the context is created, so each scan needs
+    // a new one
+    Snapshot current;
+    try {
+        current.context = std::make_shared<mtp::usb::Context>();
+        for (auto desc : current.context->GetDevices()) {
+            if (desc->GetVendorId() == VENDOR_ID) {
+                current.devices.push_back(desc);
+            }
+        }
+    } catch (const std::exception& e) {
+        HOTPLUG_LOG(WARNING, std::string("Enumeration error: ") + e.what());
+        return;
+    }
+
+    // Match by product ID; what is left over on either side changed
+    Snapshot previous;
+    {
+        std::lock_guard<std::mutex> lock(devices_mutex_);
+        previous = snapshot_;
+        snapshot_ = current;
+    }
+    std::vector<mtp::usb::DeviceDescriptorPtr> left = previous.devices;
+    std::vector<mtp::usb::DeviceDescriptorPtr> arrived;
+    for (const auto& desc : current.devices) {
+        auto match = std::find_if(left.begin(), left.end(), [&desc](const mtp::usb::DeviceDescriptorPtr& old) {
+            return old->GetProductId() == desc->GetProductId();
+        });
+        if (match != left.end()) {
+            left.erase(match);
+        } else {
+            arrived.push_back(desc);
+        }
+    }
+
+    for (const auto& desc : left) {
+        HOTPLUG_LOG(INFO, "Removed: PID " + ProductIdString(desc->GetProductId()));
+        if (callback_) callback_(false, desc);
+    }
+    for (const auto& desc : arrived) {
+        HOTPLUG_LOG(INFO, "Arrived: PID " + ProductIdString(desc->GetProductId()));
+        if (callback_) callback_(true, desc);
+    }
+}
+
+} // namespace zune
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ZuneLog.h"
+#include <usb/Context.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zune {
+
+/// Reports Zunes (USB vendor 0x045E) arriving on and leaving the bus from
+/// the platform's notifications, instead of enumerating on a timer:
+/// libusb hotplug on Linux, IOKit matching notifications on macOS and
+/// CM_Register_Notification on Windows.
+///
+/// A notification only wakes the monitor thread. The thread then enumerates
+/// once with a fresh usb::Context and reports the difference from the last
+/// enumeration, so descriptors come with the context they belong to and
+/// ZuneDevice::ConnectUSB can open them directly. Devices are told apart by
+/// product ID, so two plugged-in Zunes of the same model count as a pair.
+///
+/// Devices already plugged in are reported as arrivals by Start(). If the
+/// platform cannot notify (libusb without hotplug support, or registration
+/// failing), the thread enumerates every FALLBACK_POLL_MS instead.
+class UsbHotplug {
+public:
+    using Callback = std::function<void(bool arrived, const mtp::usb::DeviceDescriptorPtr& descriptor)>;
+
+    struct Snapshot {
+        mtp::usb::ContextPtr context;                       // Null before the first enumeration
+        std::vector<mtp::usb::DeviceDescriptorPtr> devices;  // Zunes plugged in, from context
+    };
+
+    static constexpr uint16_t VENDOR_ID = 0x045E;
+    static constexpr int FALLBACK_POLL_MS = 2000;
+
+    UsbHotplug();
+    ~UsbHotplug();
+
+    /// Log arrivals, removals and enumeration trouble under ZUNE_LOG_MTP;
+    /// may be null. Call before Start.
+    void SetLogger(Logger* logger) { logger_ = logger; }
+
+    /// Start watching; callback runs on the monitor thread. False if
+    /// already running.
+    bool Start(Callback callback);
+    void Stop();
+    bool IsRunning() const { return running_; }
+    /// False when falling back to enumerating on a timer
+    bool HasNotifications() const { return subscribed_; }
+
+    Snapshot GetSnapshot() const;
+
+    /// Wake the monitor thread to enumerate; the platform callbacks call this
+    void Notify();
+
+private:
+    struct Platform;
+
+    void Run();
+    void Rescan();
+
+    // Per platform, in the .cpp
+    bool Subscribe();
+    void Unsubscribe();
+    bool PumpsEvents() const;       // libusb: this thread must handle its events
+    void PumpEvents(int timeout_ms);
+
+    Callback callback_;
+    Logger* logger_ = nullptr;
+    std::unique_ptr<Platform> platform_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> subscribed_{false};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool pending_ = false;
+
+    mutable std::mutex devices_mutex_;
+    Snapshot snapshot_;
+};
+
+} // namespace zune
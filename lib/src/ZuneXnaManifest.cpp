@@ -0,0 +1,139 @@
+#include "ZuneXnaManifest.h"
+#include "ZuneFileStore.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+namespace zune {
+
+static constexpr char kManifestMagic[4] = {'X', 'Z', 'X', 'M'};
+static constexpr uint32_t kManifestVersion = 1;
+
+uint64_t XnaDeployManifest::Hash(const uint8_t* data, size_t size, uint64_t hash) {
+    return Fnv1a64(data, size, hash);
+}
+
+XnaDeployManifest::File XnaDeployManifest::Describe(const std::string& path, const uint8_t* data, size_t size) {
+    File file;
+    file.path = path;
+    file.size = size;
+    file.hash = Hash(data, size);
+    return file;
+}
+
+std::string XnaDeployManifest::FileName(const std::string& serial) {
+    std::string name = serial;
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+            c = '_';
+    }
+    return name + ".xnamanifest";
+}
+
+void XnaDeployManifest::Load(const std::string& path) {
+    containers_.clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(kManifestMagic) + 12) return;
+
+    size_t body = data.size() - 4;
+    BinaryReader trailer{data, data.size(), body};
+    if (static_cast<uint32_t>(trailer.Get(4)) != Fnv1a32(data.data(), body)) return;
+
+    BinaryReader r{data, body};
+    const uint8_t* magic = r.Take(sizeof(kManifestMagic));
+    if (!magic || !std::equal(magic, magic + sizeof(kManifestMagic), kManifestMagic)) return;
+    if (r.Get(4) != kManifestVersion) return;
+
+    std::vector<Container> loaded;
+    uint32_t count = static_cast<uint32_t>(r.Get(4));
+    for (uint32_t i = 0; r.ok && i < count; i++) {
+        Container container;
+        container.key = r.GetString();
+        container.schema = r.Get(8);
+        uint32_t files = static_cast<uint32_t>(r.Get(4));
+        for (uint32_t f = 0; r.ok && f < files; f++) {
+            File entry;
+            entry.path = r.GetString();
+            entry.size = r.Get(8);
+            entry.hash = r.Get(8);
+            container.files.push_back(std::move(entry));
+        }
+        loaded.push_back(std::move(container));
+    }
+    if (r.ok) containers_ = std::move(loaded);
+}
+
+bool XnaDeployManifest::Save(const std::string& path) const {
+    std::vector<uint8_t> out(kManifestMagic, kManifestMagic + sizeof(kManifestMagic));
+    Put32(out, kManifestVersion);
+    Put32(out, static_cast<uint32_t>(containers_.size()));
+    for (const auto& container : containers_) {
+        PutString(out, container.key);
+        Put64(out, container.schema);
+        Put32(out, static_cast<uint32_t>(container.files.size()));
+        for (const auto& file : container.files) {
+            PutString(out, file.path);
+            Put64(out, file.size);
+            Put64(out, file.hash);
+        }
+    }
+    Put32(out, Fnv1a32(out.data(), out.size()));
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    return WriteFileAtomic(path, out);
+}
+
+const XnaDeployManifest::Container* XnaDeployManifest::Find(const std::string& key) const {
+    for (const auto& container : containers_) {
+        if (container.key == key) return &container;
+    }
+    return nullptr;
+}
+
+void XnaDeployManifest::Record(Container container) {
+    Forget(container.key);
+    containers_.push_back(std::move(container));
+}
+
+void XnaDeployManifest::Forget(const std::string& key) {
+    containers_.erase(std::remove_if(containers_.begin(), containers_.end(),
+                                     [&](const Container& c) { return c.key == key; }),
+                      containers_.end());
+}
+
+std::vector<size_t> XnaDeployManifest::Changed(const Container* previous, uint64_t schema,
+                                               const std::vector<File>& current) {
+    std::vector<size_t> changed;
+    if (!previous || previous->schema != schema) {
+        for (size_t i = 0; i < current.size(); i++) changed.push_back(i);
+        return changed;
+    }
+
+    std::unordered_map<std::string, const File*> recorded;
+    for (const auto& file : previous->files) recorded[file.path] = &file;
+    for (size_t i = 0; i < current.size(); i++) {
+        auto it = recorded.find(current[i].path);
+        if (it == recorded.end() || it->second->size != current[i].size ||
+            it->second->hash != current[i].hash) {
+            changed.push_back(i);
+        }
+    }
+    return changed;
+}
+
+bool XnaDeployManifest::Changed(const Container* previous, uint64_t schema, const File& file) {
+    if (!previous || previous->schema != schema) return true;
+    for (const auto& recorded : previous->files) {
+        if (recorded.path == file.path) return recorded.size != file.size || recorded.hash != file.hash;
+    }
+    return true;
+}
+
+} // namespace zune
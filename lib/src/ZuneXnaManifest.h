@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ZuneFileStore.h"
+
+namespace zune {
+
+/// Host record, per device, of the game files the last completed XNA
+/// deploy left on it, so redeploying the same game sends only what
+/// changed.
+///
+/// XNAFTW has no verb to list a container's files, so the record stands in
+/// for the device: a container is recorded only after CloseGameContainer
+/// succeeds, and is forgotten (and saved) before its container is opened
+/// again, so a deploy that fails part way leaves nothing to trust. The
+/// device is checked by the fingerprint of the XNACHAN2 verb schema it
+/// sends when the channel opens; a different schema (firmware update,
+/// reset to another runtime) makes every file changed.
+///
+/// File layout (little-endian): "XZXM" magic, u32 format version, u32
+/// container count, then per container: u32 key length + bytes, u64
+/// schema fingerprint, u32 file count, and per file u32 path length +
+/// bytes, u64 size, u64 FNV-1a 64 of the content. A u32 FNV-1a of
+/// everything before it closes the file. Saved through a temporary file
+/// and rename.
+class XnaDeployManifest {
+public:
+    struct File {
+        std::string path;       // Path inside the container
+        uint64_t size = 0;
+        uint64_t hash = 0;      // FNV-1a 64 of the content
+    };
+
+    struct Container {
+        std::string key;        // Container id, plus the startup assembly for bare .exe deploys
+        uint64_t schema = 0;    // Fingerprint of the device's XNACHAN2 schema
+        std::vector<File> files;
+    };
+
+    /// Missing, truncated or corrupt files load as empty
+    void Load(const std::string& path);
+    bool Save(const std::string& path) const;
+
+    const Container* Find(const std::string& key) const;
+    /// Replaces any record under the same key
+    void Record(Container container);
+    void Forget(const std::string& key);
+    const std::vector<Container>& containers() const { return containers_; }
+
+    /// Indices into current of the files a deploy has to send: those not
+    /// in previous, or with another size or hash. Every file when there is
+    /// no previous deploy or the schema differs.
+    static std::vector<size_t> Changed(const Container* previous, uint64_t schema,
+                                       const std::vector<File>& current);
+    /// The same for a single file, for files described one at a time as
+    /// they are unpacked
+    static bool Changed(const Container* previous, uint64_t schema, const File& file);
+
+    static File Describe(const std::string& path, const uint8_t* data, size_t size);
+    static uint64_t Hash(const uint8_t* data, size_t size, uint64_t hash = kFnv1a64Offset);
+    /// File name of the manifest for a device serial
+    static std::string FileName(const std::string& serial);
+
+private:
+    std::vector<Container> containers_;
+};
+
+} // namespace zune
@@ -0,0 +1,311 @@
+#include "ZuneXnaTransport.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace zune {
+
+namespace {
+
+constexpr const char kXnaMagic[] = "XNAFTW";
+constexpr size_t kXnaMagicLen = 6;
+constexpr uint8_t kXnaftwResponse = 0x02;
+constexpr size_t kDelayedChunkHeader = 5;  // 0x00 + content size (LE32)
+
+// Below this the delay is dropped rather than halved further
+constexpr std::chrono::microseconds kMinFrameDelay{250};
+constexpr std::chrono::microseconds kFirstFrameDelay{1000};
+// Prompt acks in a row before the delay is halved
+constexpr int kPromptAcksToRelax = 2;
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::microseconds Since(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+}
+
+} // namespace
+
+XnaFrame BuildXnaFrame(uint32_t sequence, uint8_t channel, uint16_t payload_length,
+                       const uint8_t* payload, size_t size) {
+    XnaFrame frame(kXnaFrameSize, 0);
+    frame[0] = static_cast<uint8_t>((sequence >> 24) & 0xFF);
+    frame[1] = static_cast<uint8_t>((sequence >> 16) & 0xFF);
+    frame[2] = static_cast<uint8_t>((sequence >> 8) & 0xFF);
+    frame[3] = static_cast<uint8_t>(sequence & 0xFF);
+    frame[4] = channel;
+    frame[5] = static_cast<uint8_t>((payload_length >> 8) & 0xFF);
+    frame[6] = static_cast<uint8_t>(payload_length & 0xFF);
+    if (size > 0) {
+        memcpy(frame.data() + kXnaHeaderSize, payload, std::min(size, kXnaMaxPayload));
+    }
+    return frame;
+}
+
+std::optional<XnaFrameInfo> ParseXnaFrame(const XnaFrame& data) {
+    if (data.size() != kXnaFrameSize) return std::nullopt;
+
+    XnaFrameInfo frame;
+    frame.sequence = (static_cast<uint32_t>(data[0]) << 24) |
+                     (static_cast<uint32_t>(data[1]) << 16) |
+                     (static_cast<uint32_t>(data[2]) << 8) |
+                     static_cast<uint32_t>(data[3]);
+    frame.channel = data[4];
+    frame.payload_length = static_cast<uint16_t>((data[5] << 8) | data[6]);
+    frame.payload_bytes = std::min(static_cast<size_t>(frame.payload_length),
+                                   data.size() - kXnaHeaderSize);
+
+    if (frame.payload_bytes >= kXnaMagicLen &&
+        memcmp(data.data() + kXnaHeaderSize, kXnaMagic, kXnaMagicLen) == 0) {
+        frame.has_xnaftw_magic = true;
+    }
+
+    if (frame.channel == 0x00 && !frame.has_xnaftw_magic && frame.payload_bytes >= 2) {
+        frame.has_control_opcode = true;
+        frame.control_opcode = static_cast<uint16_t>(data[kXnaHeaderSize] |
+                                                     (data[kXnaHeaderSize + 1] << 8));
+        if (frame.payload_bytes >= 4) {
+            frame.has_control_value = true;
+            frame.control_value = static_cast<uint16_t>(data[kXnaHeaderSize + 2] |
+                                                        (data[kXnaHeaderSize + 3] << 8));
+        }
+    }
+
+    size_t embedded_offset = kXnaHeaderSize + frame.payload_bytes;
+    if (embedded_offset + 3 <= data.size()) {
+        uint8_t embedded_channel = data[embedded_offset];
+        uint16_t embedded_payload_length =
+            static_cast<uint16_t>((data[embedded_offset + 1] << 8) | data[embedded_offset + 2]);
+        size_t embedded_payload_offset = embedded_offset + 3;
+        if (embedded_payload_length > 0 &&
+            embedded_channel <= 0x02 &&
+            embedded_payload_offset + embedded_payload_length <= data.size()) {
+            frame.has_embedded_segment = true;
+            frame.embedded_channel = embedded_channel;
+            frame.embedded_payload_length = embedded_payload_length;
+            if (embedded_payload_length >= kXnaMagicLen &&
+                memcmp(data.data() + embedded_payload_offset, kXnaMagic, kXnaMagicLen) == 0) {
+                frame.embedded_has_xnaftw_magic = true;
+            }
+        }
+    }
+
+    return frame;
+}
+
+bool IsXnaResponse(const XnaFrame& data) {
+    if (data.size() < kXnaHeaderSize + kXnaMagicLen + 1) return false;
+    if (memcmp(data.data() + kXnaHeaderSize, kXnaMagic, kXnaMagicLen) != 0) return false;
+    return data[kXnaHeaderSize + kXnaMagicLen] == kXnaftwResponse;
+}
+
+std::optional<XnaFrame> ExtractEmbeddedXnaResponse(const XnaFrame& data) {
+    auto frame = ParseXnaFrame(data);
+    if (!frame || !frame->has_embedded_segment || !frame->embedded_has_xnaftw_magic) {
+        return std::nullopt;
+    }
+
+    size_t embedded_payload_offset = kXnaHeaderSize + frame->payload_bytes + 3;
+    XnaFrame synthetic(kXnaHeaderSize + frame->embedded_payload_length, 0);
+    std::copy(data.begin(), data.begin() + 4, synthetic.begin());
+    synthetic[4] = frame->embedded_channel;
+    synthetic[5] = static_cast<uint8_t>((frame->embedded_payload_length >> 8) & 0xFF);
+    synthetic[6] = static_cast<uint8_t>(frame->embedded_payload_length & 0xFF);
+    std::copy(data.begin() + static_cast<std::ptrdiff_t>(embedded_payload_offset),
+              data.begin() + static_cast<std::ptrdiff_t>(
+                  embedded_payload_offset + frame->embedded_payload_length),
+              synthetic.begin() + static_cast<std::ptrdiff_t>(kXnaHeaderSize));
+    if (!IsXnaResponse(synthetic)) {
+        return std::nullopt;
+    }
+    return synthetic;
+}
+
+bool IsXnaChannelClose(const XnaFrame& data) {
+    auto frame = ParseXnaFrame(data);
+    if (!frame || !frame->has_control_opcode) return false;
+    return (frame->control_opcode & 0xFF) == kXnaChannelCloseOpcode;
+}
+
+XnaTransport::XnaTransport(Link link) : XnaTransport(std::move(link), Options()) {}
+
+XnaTransport::XnaTransport(Link link, Options options)
+    : link_(std::move(link)), options_(options) {
+    options_.window_chunks = std::max<size_t>(options_.window_chunks, 1);
+    window_ = options_.window_chunks;
+}
+
+bool XnaTransport::Send(const XnaFrame& frame) {
+    auto backoff = options_.min_poll_interval;
+    for (int attempt = 0; ; attempt++) {
+        if (link_.write(frame) == WriteStatus::Sent) {
+            return true;
+        }
+        stats_.busy_writes++;
+        if (attempt == 0) BackPressure();
+        if (attempt >= options_.max_busy_retries) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::max(backoff, frame_delay_));
+        backoff = std::min(backoff * 2, options_.max_poll_interval);
+    }
+}
+
+XnaFrame XnaTransport::Receive(std::chrono::milliseconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    auto interval = options_.min_poll_interval;
+    XnaFrame data;
+    while (true) {
+        if (link_.read(data) && !data.empty()) {
+            if (link_.observe) link_.observe(data);
+            return data;
+        }
+        auto now = Clock::now();
+        if (now >= deadline) return {};
+        std::this_thread::sleep_for(std::min<Clock::duration>(interval, deadline - now));
+        interval = std::min(interval * 2, options_.max_poll_interval);
+    }
+}
+
+XnaTransport::Feedback XnaTransport::Poll(XnaFrame* response) {
+    XnaFrame data;
+    while (link_.read(data) && !data.empty()) {
+        if (link_.observe) link_.observe(data);
+        if (IsXnaResponse(data)) {
+            if (response) *response = data;
+            return Feedback::Response;
+        }
+        if (auto embedded = ExtractEmbeddedXnaResponse(data)) {
+            if (response) *response = std::move(*embedded);
+            return Feedback::Response;
+        }
+        if (IsXnaChannelClose(data)) {
+            return Feedback::ChannelClosed;
+        }
+        auto frame = ParseXnaFrame(data);
+        if (frame && frame->has_control_opcode &&
+            frame->control_opcode == kXnaDelayedStatusOpcode) {
+            return Feedback::Ack;
+        }
+        // Anything else is only logged
+    }
+    return Feedback::None;
+}
+
+XnaTransport::Feedback XnaTransport::WaitForFeedback(std::chrono::milliseconds timeout,
+                                                     XnaFrame* response) {
+    auto deadline = Clock::now() + timeout;
+    auto interval = options_.min_poll_interval;
+    while (true) {
+        Feedback feedback = Poll(response);
+        if (feedback != Feedback::None) return feedback;
+        auto now = Clock::now();
+        if (now >= deadline) return Feedback::None;
+        std::this_thread::sleep_for(std::min<Clock::duration>(interval, deadline - now));
+        interval = std::min(interval * 2, options_.max_poll_interval);
+    }
+}
+
+void XnaTransport::BackPressure() {
+    prompt_streak_ = 0;
+    window_ = 1;
+    if (frame_delay_.count() == 0) {
+        frame_delay_ = std::min(kFirstFrameDelay, options_.max_frame_delay);
+    } else {
+        frame_delay_ = std::min(frame_delay_ * 2, options_.max_frame_delay);
+    }
+}
+
+void XnaTransport::PromptAck() {
+    if (frame_delay_.count() == 0) {
+        window_ = std::min(window_ + 1, options_.window_chunks);
+        return;
+    }
+    if (++prompt_streak_ < kPromptAcksToRelax) return;
+    prompt_streak_ = 0;
+    frame_delay_ /= 2;
+    if (frame_delay_ < kMinFrameDelay) {
+        frame_delay_ = std::chrono::microseconds(0);
+    }
+}
+
+XnaTransport::Result XnaTransport::SendDelayed(uint8_t channel, const uint8_t* content, size_t size,
+                                               uint32_t& sequence, XnaFrame* response) {
+    std::vector<uint8_t> chunk;
+    chunk.reserve(kDelayedChunkHeader + std::min(size, kXnaDelayedChunkLimit));
+    size_t offset = 0;
+
+    while (offset < size) {
+        while (in_flight_ >= window_) {
+            auto start = Clock::now();
+            Feedback feedback = WaitForFeedback(options_.ack_timeout, response);
+            auto waited = Since(start);
+            stats_.waited += waited;
+            if (feedback == Feedback::Response || feedback == Feedback::ChannelClosed) {
+                // The device is done with this channel's chunks
+                in_flight_ = 0;
+                return feedback == Feedback::Response ? Result::Response : Result::ChannelClosed;
+            }
+            if (feedback == Feedback::None) {
+                // Some firmware skips the status frame; carry on, but slowly
+                stats_.missed_acks++;
+                BackPressure();
+                in_flight_ = 0;
+                break;
+            }
+            stats_.acks++;
+            in_flight_--;
+            if (waited > options_.slow_ack) {
+                stats_.slow_acks++;
+                window_ = 1;
+            } else {
+                PromptAck();
+            }
+        }
+
+        size_t delayed_size = std::min(size - offset, kXnaDelayedChunkLimit);
+        chunk.clear();
+        chunk.push_back(0x00);
+        chunk.push_back(static_cast<uint8_t>(delayed_size & 0xFF));
+        chunk.push_back(static_cast<uint8_t>((delayed_size >> 8) & 0xFF));
+        chunk.push_back(static_cast<uint8_t>((delayed_size >> 16) & 0xFF));
+        chunk.push_back(static_cast<uint8_t>((delayed_size >> 24) & 0xFF));
+        chunk.insert(chunk.end(), content + offset, content + offset + delayed_size);
+
+        for (size_t frame_offset = 0; frame_offset < chunk.size(); ) {
+            size_t frame_size = std::min(chunk.size() - frame_offset, kXnaMaxPayload);
+            if (frame_offset > 0 && frame_delay_.count() > 0) {
+                std::this_thread::sleep_for(frame_delay_);
+                stats_.paced += frame_delay_;
+            }
+            if (!Send(BuildXnaFrame(sequence++, channel, static_cast<uint16_t>(frame_size),
+                                    chunk.data() + frame_offset, frame_size))) {
+                return Result::WriteFailed;
+            }
+            stats_.frames++;
+            frame_offset += frame_size;
+        }
+
+        offset += delayed_size;
+        stats_.bytes += delayed_size;
+        stats_.chunks++;
+        in_flight_++;
+
+        // Take acks that are already waiting without blocking on them
+        if (offset < size) {
+            Feedback feedback;
+            while ((feedback = Poll(response)) != Feedback::None) {
+                if (feedback == Feedback::Response || feedback == Feedback::ChannelClosed) {
+                    in_flight_ = 0;
+                    return feedback == Feedback::Response ? Result::Response : Result::ChannelClosed;
+                }
+                stats_.acks++;
+                if (in_flight_ > 0) in_flight_--;
+                PromptAck();
+            }
+        }
+    }
+    return Result::Sent;
+}
+
+} // namespace zune
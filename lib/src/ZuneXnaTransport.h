@@ -0,0 +1,153 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace zune {
+
+// XNAFTW secure frames, as carried by MTP vendor ops 0x9222 (host to
+// device) and 0x9223 (device to host)
+constexpr size_t kXnaFrameSize = 1264;
+constexpr size_t kXnaHeaderSize = 7;      // seq(4 BE) + channel(1) + payload_length(2 BE)
+constexpr size_t kXnaMaxPayload = 1230;
+constexpr size_t kXnaDelayedChunkLimit = 0x1FFFB;  // Content bytes per delayed-parameter chunk
+constexpr uint16_t kXnaDelayedStatusOpcode = 0x01D2;
+constexpr uint8_t kXnaChannelCloseOpcode = 0xC1;   // Low byte; high byte is the channel
+
+using XnaFrame = std::vector<uint8_t>;
+
+struct XnaFrameInfo {
+    uint32_t sequence = 0;
+    uint8_t channel = 0;
+    uint16_t payload_length = 0;
+    size_t payload_bytes = 0;
+    bool has_xnaftw_magic = false;
+    bool has_control_opcode = false;
+    uint16_t control_opcode = 0;
+    bool has_control_value = false;
+    uint16_t control_value = 0;
+    bool has_embedded_segment = false;
+    uint8_t embedded_channel = 0;
+    uint16_t embedded_payload_length = 0;
+    bool embedded_has_xnaftw_magic = false;
+};
+
+/// Full-size frame; the payload is zero-padded and the MAC left zero
+XnaFrame BuildXnaFrame(uint32_t sequence, uint8_t channel, uint16_t payload_length,
+                       const uint8_t* payload, size_t size);
+
+/// Header, control opcode (channel 0 only) and any segment packed after the payload
+std::optional<XnaFrameInfo> ParseXnaFrame(const XnaFrame& data);
+
+/// XNAFTW message of type response (0x02)
+bool IsXnaResponse(const XnaFrame& data);
+
+/// A response the device packed behind another frame's payload, rebuilt as
+/// a frame of its own
+std::optional<XnaFrame> ExtractEmbeddedXnaResponse(const XnaFrame& data);
+
+bool IsXnaChannelClose(const XnaFrame& data);
+
+/// Sends XNAFTW delayed-parameter content (game assemblies, content files)
+/// at the rate the device can take it.
+///
+/// The device acknowledges each delayed chunk with a 0x01D2 status frame
+/// and closes the channel if its buffer overflows. Frames go out back to
+/// back; up to Options::window_chunks chunks may be unacknowledged, and the
+/// sender waits for a status frame only when the window is full. Waits poll
+/// with a short backoff that returns as soon as a frame arrives.
+///
+/// An ack slower than Options::slow_ack shrinks the window to one chunk;
+/// prompt acks grow it back. Frames are only paced when the device pushes
+/// back harder: a busy write, or an ack that never comes, puts a delay
+/// between frames that doubles up to Options::max_frame_delay, and prompt
+/// acks halve it again. Transfer time follows the link rather than the
+/// frame count.
+class XnaTransport {
+public:
+    enum class WriteStatus { Sent, Busy };
+
+    /// Hard failures throw out of write and read
+    struct Link {
+        std::function<WriteStatus(const XnaFrame& frame)> write;
+        /// False when the device has nothing queued
+        std::function<bool(XnaFrame& frame)> read;
+        /// Every frame read, for logging
+        std::function<void(const XnaFrame& frame)> observe;
+    };
+
+    struct Options {
+        size_t window_chunks = 1;
+        std::chrono::microseconds max_frame_delay{10000};
+        std::chrono::milliseconds slow_ack{250};
+        std::chrono::milliseconds ack_timeout{2000};
+        std::chrono::microseconds min_poll_interval{200};
+        std::chrono::microseconds max_poll_interval{5000};
+        int max_busy_retries = 50;
+    };
+
+    enum class Result {
+        Sent,           // All content written
+        Response,       // Device answered before taking everything
+        ChannelClosed,
+        WriteFailed,    // Busy past max_busy_retries
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t chunks = 0;
+        uint64_t bytes = 0;
+        uint64_t acks = 0;
+        uint64_t missed_acks = 0;   // Gave up waiting and carried on
+        uint64_t slow_acks = 0;
+        uint64_t busy_writes = 0;
+        std::chrono::microseconds paced{0};   // Time spent in frame delays
+        std::chrono::microseconds waited{0};  // Time spent waiting for acks
+    };
+
+    explicit XnaTransport(Link link);
+    XnaTransport(Link link, Options options);
+
+    /// Write one frame, retrying while the device reports busy
+    bool Send(const XnaFrame& frame);
+
+    /// Next inbound frame, or empty after timeout
+    XnaFrame Receive(std::chrono::milliseconds timeout);
+
+    /// Send content as delayed-parameter chunks on channel, numbering
+    /// frames from sequence (advanced past the last frame sent). Status
+    /// frames are consumed; the caller waits for the final response. On
+    /// Result::Response, response holds it. Chunks still unacknowledged
+    /// when it returns count against the window of the next call.
+    Result SendDelayed(uint8_t channel, const uint8_t* content, size_t size,
+                       uint32_t& sequence, XnaFrame* response = nullptr);
+
+    const Stats& stats() const { return stats_; }
+    size_t window() const { return window_; }
+    std::chrono::microseconds frame_delay() const { return frame_delay_; }
+
+private:
+    enum class Feedback { None, Ack, Response, ChannelClosed };
+
+    Feedback Poll(XnaFrame* response);
+    Feedback WaitForFeedback(std::chrono::milliseconds timeout, XnaFrame* response);
+    void BackPressure();
+    void PromptAck();
+
+    Link link_;
+    Options options_;
+    Stats stats_;
+    size_t window_;
+    // Chunks written but not yet acknowledged. Kept across SendDelayed
+    // calls: the last chunk of a transfer is usually still being processed
+    // when the call returns, and the next transfer must count it.
+    size_t in_flight_ = 0;
+    std::chrono::microseconds frame_delay_{0};
+    int prompt_streak_ = 0;
+};
+
+} // namespace zune
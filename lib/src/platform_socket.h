@@ -14,6 +14,7 @@
     inline int platform_socket_error() { return WSAGetLastError(); }
     #define PLATFORM_EAGAIN WSAEWOULDBLOCK
     #define PLATFORM_EINPROGRESS WSAEWOULDBLOCK
+    #define PLATFORM_EINTR WSAEINTR
     #define PLATFORM_SHUT_RDWR SD_BOTH
 
     // Winsock uses char* for setsockopt/getsockopt data, POSIX uses void*
@@ -35,6 +36,12 @@
     // WinSock ignores the nfds argument — pass 0
     inline int platform_select_nfds(socket_t) { return 0; }
 
+    // poll() is WSAPoll() on Winsock (Vista and later)
+    typedef WSAPOLLFD platform_pollfd;
+    inline int platform_poll(platform_pollfd* fds, size_t count, int timeout_ms) {
+        return WSAPoll(fds, static_cast<ULONG>(count), timeout_ms);
+    }
+
     // Winsock requires startup/cleanup
     inline void platform_socket_init() {
         static std::once_flag flag;
@@ -57,10 +64,27 @@
     #define SEND_CAST(x) reinterpret_cast<const char*>(x)
     #define RECV_CAST(x) reinterpret_cast<char*>(x)
 
+    // Send two buffers in one call (gather), e.g. a header and its payload
+    inline ssize_t platform_send2(socket_t s, const void* a, size_t a_len, const void* b, size_t b_len) {
+        WSABUF bufs[2];
+        bufs[0].buf = const_cast<char*>(static_cast<const char*>(a));
+        bufs[0].len = static_cast<ULONG>(a_len);
+        bufs[1].buf = const_cast<char*>(static_cast<const char*>(b));
+        bufs[1].len = static_cast<ULONG>(b_len);
+        DWORD sent = 0;
+        if (WSASend(s, bufs, 2, &sent, 0, NULL, NULL) != 0) {
+            return -1;
+        }
+        return static_cast<ssize_t>(sent);
+    }
+
 #else
     #include <sys/types.h>
     #include <sys/socket.h>
+    #include <sys/uio.h>
+    #include <poll.h>
     #include <netinet/in.h>
+    #include <netinet/tcp.h>
     #include <arpa/inet.h>
     #include <netdb.h>
     #include <unistd.h>
@@ -74,6 +98,7 @@
     inline int platform_socket_error() { return errno; }
     #define PLATFORM_EAGAIN EAGAIN
     #define PLATFORM_EINPROGRESS EINPROGRESS
+    #define PLATFORM_EINTR EINTR
     #define PLATFORM_SHUT_RDWR SHUT_RDWR
 
     #define SETSOCKOPT_CAST(x) (x)
@@ -96,9 +121,23 @@
 
     inline int platform_select_nfds(socket_t s) { return static_cast<int>(s) + 1; }
 
+    typedef struct pollfd platform_pollfd;
+    inline int platform_poll(platform_pollfd* fds, size_t count, int timeout_ms) {
+        return poll(fds, static_cast<nfds_t>(count), timeout_ms);
+    }
+
     inline void platform_socket_init() {}
     inline void platform_socket_cleanup() {}
 
     #define SEND_CAST(x) (x)
     #define RECV_CAST(x) (x)
+
+    inline ssize_t platform_send2(socket_t s, const void* a, size_t a_len, const void* b, size_t b_len) {
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<void*>(a);
+        iov[0].iov_len = a_len;
+        iov[1].iov_base = const_cast<void*>(b);
+        iov[1].iov_len = b_len;
+        return writev(s, iov, 2);
+    }
 #endif
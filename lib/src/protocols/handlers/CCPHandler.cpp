@@ -4,7 +4,23 @@
 // CCP (Compression Control Protocol) codes
 constexpr uint8_t CCP_CODE_CONFIG_REQUEST = 1;
 constexpr uint8_t CCP_CODE_CONFIG_ACK = 2;
+constexpr uint8_t CCP_CODE_CONFIG_NAK = 3;
 constexpr uint8_t CCP_CODE_CONFIG_REJECT = 4;
+constexpr uint8_t CCP_CODE_TERMINATE_REQUEST = 5;
+constexpr uint8_t CCP_CODE_TERMINATE_ACK = 6;
+constexpr uint8_t CCP_CODE_RESET_REQUEST = 14;
+
+// MPPC option (RFC 2118): type 18, four bytes of supported bits
+constexpr uint8_t CCP_OPTION_MPPC = 18;
+constexpr uint8_t CCP_OPTION_MPPC_LENGTH = 6;
+constexpr uint32_t MPPC_BIT_COMPRESSION = 0x00000001;  // C
+constexpr uint32_t MPPC_BIT_STATELESS = 0x01000000;    // H (RFC 3078)
+
+constexpr uint16_t PPP_PROTO_CCP = 0x80fd;
+constexpr uint16_t PPP_PROTO_COMPRESSED = 0x00fd;
+
+// Our empty Config-Request is sent again after a Nak or Reject at most this often
+constexpr int MAX_CONFIG_REQUESTS = 5;
 
 std::optional<mtp::ByteArray> CCPHandler::HandlePacket(const mtp::ByteArray& ccp_packet) {
     // Validate minimum packet size (code + identifier + length)
@@ -22,89 +38,242 @@ std::optional<mtp::ByteArray> CCPHandler::HandlePacket(const mtp::ByteArray& ccp
         return std::nullopt;
     }
 
-    // Only handle Config-Request
-    if (code == CCP_CODE_CONFIG_REQUEST) {
-        // RFC 1661: If Config-Request has no options (length = 4, header only),
-        // respond with Config-Ack to complete negotiation (no compression).
-        // If it has options, reject them all.
-        bool has_options = (ccp_packet.size() > 4);
+    std::lock_guard<std::mutex> lock(mutex_);
+    mtp::ByteArray response;
+
+    switch (code) {
+    case CCP_CODE_CONFIG_REQUEST:
+        HandleConfigRequest(identifier, ccp_packet, response);
+        break;
+
+    case CCP_CODE_CONFIG_ACK:
+        // The device agrees to send uncompressed; with its MPPC option
+        // acked too, CCP is open
+        if (requests_sent_ > 0 && identifier == request_id_) {
+            requests_sent_ = 0;
+            if (mppc_acked_ && !compressor_) {
+                compressor_.emplace(stateless_);
+                Log(std::string("CCP opened: MPPC compression on") + (stateless_ ? " (stateless)" : ""));
+            }
+        }
+        break;
 
-        if (has_options) {
-            Log("CCP Config-Request received (id=" + std::to_string(identifier) +
-                ", " + std::to_string(ccp_packet.size() - 4) + " bytes of options), sending Config-Reject");
+    case CCP_CODE_CONFIG_NAK:
+    case CCP_CODE_CONFIG_REJECT:
+        // Our request has no options, so there is nothing to change; ask again
+        if (requests_sent_ > 0 && identifier == request_id_) {
+            if (requests_sent_ < MAX_CONFIG_REQUESTS) {
+                AppendConfigRequest(response);
+            } else {
+                Log("CCP Config-Request not accepted after " + std::to_string(requests_sent_) +
+                    " attempts, compression stays off");
+            }
+        }
+        break;
 
-            // Build Config-Reject response
-            mtp::ByteArray ccp_reject = BuildConfigReject(identifier, ccp_packet);
+    case CCP_CODE_TERMINATE_REQUEST:
+        Log("CCP Terminate-Request received (id=" + std::to_string(identifier) + "), compression off");
+        compressor_.reset();
+        mppc_acked_ = false;
+        requests_sent_ = 0;
+        response = PPPParser::WrapPayload(BuildPacket(CCP_CODE_TERMINATE_ACK, identifier, {}), PPP_PROTO_CCP);
+        break;
 
-            // Wrap in PPP frame
-            mtp::ByteArray ppp_frame = PPPParser::WrapPayload(ccp_reject, 0x80fd);
+    case CCP_CODE_RESET_REQUEST:
+        // The device lost a packet and its history; MPPC answers with a
+        // FLUSHED packet rather than a Reset-Ack
+        if (compressor_) {
+            compressor_->Reset();
+            stats_.resets++;
+            Log("CCP Reset-Request received (id=" + std::to_string(identifier) + "), compressor history reset");
+        }
+        break;
 
-            Log("CCP Config-Reject built (PPP frame size: " + std::to_string(ppp_frame.size()) + " bytes)");
+    default:
+        // Ignore other CCP codes (Reset-Ack, Code-Reject, etc.)
+        break;
+    }
 
-            return ppp_frame;
-        } else {
-            Log("CCP Config-Request received (id=" + std::to_string(identifier) +
-                ", no options), sending Config-Ack (no compression)");
+    if (response.empty()) {
+        return std::nullopt;
+    }
+    return response;
+}
 
-            // Build Config-Ack response for empty Config-Request
-            mtp::ByteArray ccp_ack = BuildConfigAck(identifier);
+void CCPHandler::HandleConfigRequest(uint8_t identifier, const mtp::ByteArray& ccp_packet,
+                                     mtp::ByteArray& response) {
+    // A new Config-Request renegotiates: compress nothing until it is agreed again
+    if (compressor_) {
+        Log("CCP Config-Request while compressing, compression off until renegotiated");
+    }
+    compressor_.reset();
+    mppc_acked_ = false;
 
-            // Wrap in PPP frame
-            mtp::ByteArray ppp_frame = PPPParser::WrapPayload(ccp_ack, 0x80fd);
+    mtp::ByteArray options(ccp_packet.begin() + 4, ccp_packet.end());
+    mtp::ByteArray rejected;
+    mtp::ByteArray naked;
+    bool stateless = false;
 
-            Log("CCP Config-Ack built (PPP frame size: " + std::to_string(ppp_frame.size()) + " bytes)");
+    size_t offset = 0;
+    while (offset < options.size()) {
+        size_t length = offset + 1 < options.size() ? options[offset + 1] : 0;
+        if (length < 2 || offset + length > options.size()) {
+            // Malformed: reject the rest
+            rejected.insert(rejected.end(), options.begin() + offset, options.end());
+            break;
+        }
+        const uint8_t* option = options.data() + offset;
+        offset += length;
 
-            return ppp_frame;
+        if (option[0] != CCP_OPTION_MPPC || length != CCP_OPTION_MPPC_LENGTH || !compression_enabled_) {
+            rejected.insert(rejected.end(), option, option + length);
+            continue;
+        }
+        uint32_t bits = (uint32_t(option[2]) << 24) | (uint32_t(option[3]) << 16) |
+                        (uint32_t(option[4]) << 8) | option[5];
+        if (!(bits & MPPC_BIT_COMPRESSION)) {
+            // MPPE encryption only, or nothing at all
+            rejected.insert(rejected.end(), option, option + length);
+            continue;
         }
+        uint32_t supported = bits & (MPPC_BIT_COMPRESSION | MPPC_BIT_STATELESS);
+        if (supported != bits) {
+            naked.insert(naked.end(), {CCP_OPTION_MPPC, CCP_OPTION_MPPC_LENGTH,
+                                       uint8_t(supported >> 24), uint8_t(supported >> 16),
+                                       uint8_t(supported >> 8), uint8_t(supported)});
+            continue;
+        }
+        stateless = (bits & MPPC_BIT_STATELESS) != 0;
+    }
+
+    if (!rejected.empty()) {
+        Log("CCP Config-Request received (id=" + std::to_string(identifier) +
+            ", " + std::to_string(options.size()) + " bytes of options), sending Config-Reject");
+
+        mtp::ByteArray ppp_frame = PPPParser::WrapPayload(BuildConfigReject(identifier, rejected), PPP_PROTO_CCP);
+
+        Log("CCP Config-Reject built (PPP frame size: " + std::to_string(ppp_frame.size()) + " bytes)");
+        response.insert(response.end(), ppp_frame.begin(), ppp_frame.end());
+        return;
+    }
+
+    if (!naked.empty()) {
+        Log("CCP Config-Request received (id=" + std::to_string(identifier) +
+            "), sending Config-Nak for MPPC without encryption");
+        mtp::ByteArray ppp_frame = PPPParser::WrapPayload(
+            BuildPacket(CCP_CODE_CONFIG_NAK, identifier, naked), PPP_PROTO_CCP);
+        response.insert(response.end(), ppp_frame.begin(), ppp_frame.end());
+        return;
+    }
+
+    mtp::ByteArray ppp_frame = PPPParser::WrapPayload(BuildConfigAck(identifier, options), PPP_PROTO_CCP);
+    response.insert(response.end(), ppp_frame.begin(), ppp_frame.end());
+
+    if (options.empty()) {
+        Log("CCP Config-Request received (id=" + std::to_string(identifier) +
+            ", no options), sending Config-Ack (no compression)");
+        return;
     }
 
-    // Ignore other CCP codes (Config-Ack, Config-Nak, etc.)
-    return std::nullopt;
+    Log("CCP Config-Request received (id=" + std::to_string(identifier) +
+        "), sending Config-Ack for MPPC" + (stateless ? " (stateless)" : ""));
+    mppc_acked_ = true;
+    stateless_ = stateless;
+    requests_sent_ = 0;
+    AppendConfigRequest(response);
 }
 
-void CCPHandler::SetLogCallback(LogCallback callback) {
-    log_callback_ = callback;
+void CCPHandler::AppendConfigRequest(mtp::ByteArray& response) {
+    request_id_++;
+    requests_sent_++;
+    mtp::ByteArray ppp_frame = PPPParser::WrapPayload(
+        BuildPacket(CCP_CODE_CONFIG_REQUEST, request_id_, {}), PPP_PROTO_CCP);
+    response.insert(response.end(), ppp_frame.begin(), ppp_frame.end());
 }
 
-mtp::ByteArray CCPHandler::BuildConfigReject(uint8_t identifier, const mtp::ByteArray& original_packet) {
-    mtp::ByteArray ccp_reject;
+void CCPHandler::SetCompressionEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    compression_enabled_ = enabled;
+}
 
-    // CCP Config-Reject format:
-    // - Code: 0x04 (Config-Reject)
-    // - Identifier: Same as Config-Request
-    // - Length: Same as Config-Request
-    // - Options: Copy original options (we reject them all)
+bool CCPHandler::CompressFrame(const uint8_t* frame, size_t size, mtp::ByteArray& out) {
+    // Only IP frames (protocol 0x21, never stuffed) are compressed
+    if (size < 6 || frame[0] != 0x7E || frame[1] != 0x21 || frame[size - 1] != 0x7E) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!compressor_) {
+        return false;
+    }
+
+    // Unstuff behind a leading zero, so the protocol field goes in as 0x0021;
+    // drop the FCS
+    unstuffed_.resize(size);
+    unstuffed_[0] = 0x00;
+    size_t content = PPPParser::UnstuffInto(frame + 1, size - 2, unstuffed_.data() + 1);
+    if (content < 3) {
+        return false;
+    }
+    size_t length = 1 + content - 2;
 
-    ccp_reject.push_back(CCP_CODE_CONFIG_REJECT);  // Config-Reject
-    ccp_reject.push_back(identifier);              // Same identifier
+    compressor_->Compress(unstuffed_.data(), length, compressed_);
+    PPPParser::WrapPayload(compressed_.data(), compressed_.size(), PPP_PROTO_COMPRESSED, out);
 
-    // Length (2 bytes, big-endian)
-    uint16_t length = original_packet.size();
-    ccp_reject.push_back((length >> 8) & 0xFF);
-    ccp_reject.push_back(length & 0xFF);
+    stats_.frames++;
+    stats_.bytes_in += length;
+    stats_.bytes_out += compressed_.size();
+    if (!(compressed_[0] & (MPPCCompressor::kCompressed >> 8))) {
+        stats_.uncompressed++;
+    }
+    return true;
+}
+
+bool CCPHandler::IsCompressing() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return compressor_.has_value();
+}
 
-    // Copy original options (everything after the 4-byte header)
-    ccp_reject.insert(ccp_reject.end(), original_packet.begin() + 4, original_packet.end());
+CCPHandler::Stats CCPHandler::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.compressing = compressor_.has_value();
+    return stats;
+}
 
-    return ccp_reject;
+void CCPHandler::SetLogCallback(LogCallback callback) {
+    log_callback_ = callback;
 }
 
-mtp::ByteArray CCPHandler::BuildConfigAck(uint8_t identifier) {
-    mtp::ByteArray ccp_ack;
+mtp::ByteArray CCPHandler::BuildConfigReject(uint8_t identifier, const mtp::ByteArray& options) {
+    // CCP Config-Reject format:
+    // - Code: 0x04 (Config-Reject)
+    // - Identifier: Same as Config-Request
+    // - Options: Copies of the rejected options
+    return BuildPacket(CCP_CODE_CONFIG_REJECT, identifier, options);
+}
 
-    // CCP Config-Ack format (for empty Config-Request):
+mtp::ByteArray CCPHandler::BuildConfigAck(uint8_t identifier, const mtp::ByteArray& options) {
+    // CCP Config-Ack format:
     // - Code: 0x02 (Config-Ack)
     // - Identifier: Same as Config-Request
-    // - Length: 4 (header only, no options)
+    // - Options: All of the request's options (none for no compression)
+    return BuildPacket(CCP_CODE_CONFIG_ACK, identifier, options);
+}
 
-    ccp_ack.push_back(CCP_CODE_CONFIG_ACK);  // Config-Ack
-    ccp_ack.push_back(identifier);            // Same identifier
+mtp::ByteArray CCPHandler::BuildPacket(uint8_t code, uint8_t identifier, const mtp::ByteArray& data) {
+    mtp::ByteArray packet;
+    packet.reserve(4 + data.size());
+    packet.push_back(code);
+    packet.push_back(identifier);
 
-    // Length (2 bytes, big-endian) - 4 bytes for header only
-    ccp_ack.push_back(0x00);
-    ccp_ack.push_back(0x04);
+    // Length (2 bytes, big-endian), header included
+    uint16_t length = static_cast<uint16_t>(4 + data.size());
+    packet.push_back((length >> 8) & 0xFF);
+    packet.push_back(length & 0xFF);
 
-    return ccp_ack;
+    packet.insert(packet.end(), data.begin(), data.end());
+    return packet;
 }
 
 void CCPHandler::Log(const std::string& message) {
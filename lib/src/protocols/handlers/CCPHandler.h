@@ -1,27 +1,49 @@
 #pragma once
 
+#include "../ppp/MPPCCompressor.h"
 #include <mtp/ByteArray.h>
+#include <cstdint>
 #include <optional>
 #include <functional>
+#include <mutex>
 #include <string>
 
 /**
  * CCPHandler
  *
- * Handles CCP (Compression Control Protocol) negotiation for PPP.
+ * Handles CCP (Compression Control Protocol) negotiation for PPP, and
+ * compresses the IP frames sent to the device once it has been agreed.
  *
- * The Zune device may request compression capabilities via CCP Config-Request.
- * Since we don't support compression:
- * - If Config-Request has options, we respond with Config-Reject
- * - If Config-Request has no options (empty), we respond with Config-Ack
- *   to complete the negotiation (both sides agree: no compression)
+ * The Zune device proposes the compression it can decompress in its CCP
+ * Config-Request. We accept MPPC (RFC 2118), the one it offers:
+ * - MPPC with the compression bit gets Config-Ack, and we send our own
+ *   empty Config-Request (we ask for nothing compressed from the device)
+ * - MPPC asking for more than compression and stateless history (e.g.
+ *   MPPE encryption) gets Config-Nak offering just those
+ * - Any other option, or MPPC without the compression bit, gets
+ *   Config-Reject, so the device falls back to an empty Config-Request
+ * - An empty Config-Request gets Config-Ack (both sides: no compression)
  *
- * This is a stateless handler following Clean Architecture principles.
+ * Compression starts once the device has acked our Config-Request. A
+ * Reset-Request resets the compressor's history, and Terminate-Request or a
+ * new Config-Request stops compression until it is agreed again.
+ *
+ * Thread-safe: CCP packets arrive on the poll thread while the drain
+ * compresses frames.
  */
 class CCPHandler {
 public:
     using LogCallback = std::function<void(const std::string& message)>;
 
+    struct Stats {
+        bool compressing = false;
+        uint64_t frames = 0;           // IP frames compressed (or sent flushed)
+        uint64_t bytes_in = 0;         // Their protocol field and IP packet
+        uint64_t bytes_out = 0;        // After compression, with the MPPC header
+        uint64_t uncompressed = 0;     // Frames that did not shrink
+        uint64_t resets = 0;           // Reset-Requests from the device
+    };
+
     /**
      * Constructor
      */
@@ -31,10 +53,31 @@ public:
      * Handle CCP packet
      *
      * @param ccp_packet CCP packet data (without PPP framing)
-     * @return PPP-framed CCP response if a response is needed, std::nullopt otherwise
+     * @return PPP-framed CCP response if a response is needed, std::nullopt
+     *         otherwise; our own Config-Request may follow it as a second frame
      */
     std::optional<mtp::ByteArray> HandlePacket(const mtp::ByteArray& ccp_packet);
 
+    /**
+     * Accept the device's compression offer (default), or reject it as
+     * before compression was supported. Takes effect at the next Config-Request.
+     */
+    void SetCompressionEnabled(bool enabled);
+
+    /**
+     * Compress an outgoing PPP frame, if compression is in use and it
+     * carries an IP packet
+     *
+     * @param frame One whole PPP frame (with flags and FCS)
+     * @param out Replaced by the compressed frame (protocol 0x00FD)
+     * @return false to send frame unchanged
+     */
+    bool CompressFrame(const uint8_t* frame, size_t size, mtp::ByteArray& out);
+
+    bool IsCompressing() const;
+
+    Stats GetStats() const;
+
     /**
      * Set logging callback for diagnostic messages
      * @param callback Function to receive log messages
@@ -45,17 +88,33 @@ private:
     /**
      * Build Config-Reject response for CCP Config-Request with options
      * @param identifier Identifier from Config-Request
-     * @param original_packet Original CCP packet
+     * @param options Options being rejected
      * @return CCP Config-Reject packet (without PPP framing)
      */
-    mtp::ByteArray BuildConfigReject(uint8_t identifier, const mtp::ByteArray& original_packet);
+    mtp::ByteArray BuildConfigReject(uint8_t identifier, const mtp::ByteArray& options);
 
     /**
-     * Build Config-Ack response for empty CCP Config-Request (no options)
+     * Build Config-Ack response for CCP Config-Request
      * @param identifier Identifier from Config-Request
+     * @param options Options being acknowledged (empty for no compression)
      * @return CCP Config-Ack packet (without PPP framing)
      */
-    mtp::ByteArray BuildConfigAck(uint8_t identifier);
+    mtp::ByteArray BuildConfigAck(uint8_t identifier, const mtp::ByteArray& options = {});
+
+    /**
+     * Build a CCP packet of code with identifier around data
+     */
+    static mtp::ByteArray BuildPacket(uint8_t code, uint8_t identifier, const mtp::ByteArray& data);
+
+    /**
+     * Answer a Config-Request; appends PPP frames to response
+     */
+    void HandleConfigRequest(uint8_t identifier, const mtp::ByteArray& ccp_packet, mtp::ByteArray& response);
+
+    /**
+     * Append our (empty) Config-Request to response
+     */
+    void AppendConfigRequest(mtp::ByteArray& response);
 
     /**
      * Log a message via callback if set
@@ -63,4 +122,15 @@ private:
     void Log(const std::string& message);
 
     LogCallback log_callback_;
+
+    mutable std::mutex mutex_;
+    bool compression_enabled_ = true;
+    bool mppc_acked_ = false;        // We acked the device's MPPC option
+    bool stateless_ = false;         // Device asked for stateless history
+    uint8_t request_id_ = 0;         // Identifier of our last Config-Request
+    int requests_sent_ = 0;          // Config-Requests not yet acked
+    std::optional<MPPCCompressor> compressor_;  // Set while compressing
+    mtp::ByteArray unstuffed_;       // Scratch for CompressFrame
+    std::vector<uint8_t> compressed_;
+    Stats stats_;
 };
@@ -1,9 +1,54 @@
 #include "DNSHandler.h"
 #include "../ppp/PPPParser.h"  // Contains IPParser, DNSServer definitions
+#include <cctype>
 #include <random>
 
+namespace {
+
+constexpr size_t kDNSHeaderSize = 12;
+constexpr size_t kUDPHeaderSize = 8;
+constexpr size_t kIPHeaderSize = 20;  // Responses carry no IP options
+
+uint16_t NextIdentification() {
+    static std::random_device rd;
+    static std::mt19937 gen(rd());
+    static std::uniform_int_distribution<uint16_t> dist(0, 65535);
+    return dist(gen);
+}
+
+void PutU16(mtp::ByteArray& data, size_t offset, uint16_t value) {
+    data[offset] = (value >> 8) & 0xFF;
+    data[offset + 1] = value & 0xFF;
+}
+
+// Question section (name, type A, class IN) for hostname, empty if it
+// cannot be written as one
+std::string EncodeQuestion(const std::string& hostname) {
+    std::string question;
+    size_t start = 0;
+    while (start < hostname.size()) {
+        size_t dot = hostname.find('.', start);
+        size_t end = (dot == std::string::npos) ? hostname.size() : dot;
+        size_t length = end - start;
+        if (length == 0 || length >= 64) {
+            return "";
+        }
+        question += static_cast<char>(length);
+        question.append(hostname, start, length);
+        start = end + 1;
+        if (dot == hostname.size() - 1) {
+            return "";  // Trailing dot
+        }
+    }
+    question.append("\0\0\1\0\1", 5);
+    return question;
+}
+
+} // namespace
+
 DNSHandler::DNSHandler(const std::map<std::string, uint32_t>& hostname_map)
     : hostname_map_(hostname_map) {
+    CompileAnswers();
 }
 
 std::optional<mtp::ByteArray> DNSHandler::HandleQuery(const mtp::ByteArray& ip_packet) {
@@ -16,15 +61,14 @@ std::optional<mtp::ByteArray> DNSHandler::HandleQuery(const mtp::ByteArray& ip_p
             return std::nullopt;
         }
 
-        // Extract UDP segment
-        mtp::ByteArray udp_segment = IPParser::ExtractPayload(ip_packet);
-
-        if (udp_segment.size() < 8) {
+        size_t udp_offset = ip_header.header_length * 4;
+        if (ip_packet.size() < udp_offset + kUDPHeaderSize) {
             Log("UDP segment too small for DNS");
             return std::nullopt;
         }
 
         // Parse UDP header
+        const uint8_t* udp_segment = ip_packet.data() + udp_offset;
         uint16_t src_port = (udp_segment[0] << 8) | udp_segment[1];
         uint16_t dst_port = (udp_segment[2] << 8) | udp_segment[3];
 
@@ -33,8 +77,38 @@ std::optional<mtp::ByteArray> DNSHandler::HandleQuery(const mtp::ByteArray& ip_p
             return std::nullopt;
         }
 
+        const uint8_t* query = udp_segment + kUDPHeaderSize;
+        size_t query_size = ip_packet.size() - udp_offset - kUDPHeaderSize;
+
+        if (Answer* answer = FindAnswer(query, query_size)) {
+            Log("DNS query for: " + answer->hostname);
+
+            // Build the packet for this address pair once, then patch per query
+            if (answer->packet.empty() || answer->server_ip != ip_header.dst_ip ||
+                answer->device_ip != ip_header.src_ip) {
+                answer->packet = BuildUDPPacket(ip_header.dst_ip, ip_header.src_ip, dst_port, 0,
+                                                answer->dns, 0);
+                answer->server_ip = ip_header.dst_ip;
+                answer->device_ip = ip_header.src_ip;
+            }
+
+            mtp::ByteArray ip_response = answer->packet;
+            uint16_t identification = NextIdentification();
+            uint16_t checksum = (ip_response[10] << 8) | ip_response[11];
+            PutU16(ip_response, 4, identification);
+            PutU16(ip_response, 10, UpdateChecksum(checksum, 0, identification));
+            PutU16(ip_response, kIPHeaderSize + 2, src_port);  // UDP checksum is not used
+            ip_response[kIPHeaderSize + kUDPHeaderSize] = query[0];  // Transaction ID
+            ip_response[kIPHeaderSize + kUDPHeaderSize + 1] = query[1];
+
+            mtp::ByteArray ppp_frame = PPPParser::WrapPayload(ip_response, 0x0021);
+            Log("DNS response built for " + answer->hostname + " (PPP frame size: " +
+                std::to_string(ppp_frame.size()) + " bytes)");
+            return ppp_frame;
+        }
+
         // Extract DNS query (UDP payload)
-        mtp::ByteArray dns_query(udp_segment.begin() + 8, udp_segment.end());
+        mtp::ByteArray dns_query(query, query + query_size);
 
         // Parse hostname from query
         std::string hostname = DNSServer::ParseHostname(dns_query);
@@ -48,47 +122,10 @@ std::optional<mtp::ByteArray> DNSHandler::HandleQuery(const mtp::ByteArray& ip_p
             return std::nullopt;
         }
 
-        // Build UDP response (swap source and destination)
-        mtp::ByteArray udp_response;
-        udp_response.push_back((dst_port >> 8) & 0xFF);  // Src port (swap)
-        udp_response.push_back(dst_port & 0xFF);
-        udp_response.push_back((src_port >> 8) & 0xFF);  // Dst port (swap)
-        udp_response.push_back(src_port & 0xFF);
-
-        // UDP length
-        uint16_t response_length = 8 + dns_response.size();
-        udp_response.push_back((response_length >> 8) & 0xFF);
-        udp_response.push_back(response_length & 0xFF);
-
-        // UDP checksum (0 = no checksum)
-        udp_response.push_back(0x00);
-        udp_response.push_back(0x00);
-
-        // Append DNS response
-        udp_response.insert(udp_response.end(), dns_response.begin(), dns_response.end());
-
-        // Build IP response packet (swap source and destination)
-        IPParser::IPHeader response_header = {};
-        response_header.version = 4;
-        response_header.header_length = 5;
-        response_header.dscp = 0;
-        response_header.ecn = 0;
-        response_header.total_length = 0;  // Will be calculated by BuildPacket
-
-        // Generate IP identification using proper random number generation
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_int_distribution<uint16_t> dist(0, 65535);
-        response_header.identification = dist(gen);
-
-        response_header.flags_offset = 0;
-        response_header.ttl = 64;
-        response_header.protocol = 17;  // UDP
-        response_header.checksum = 0;  // Will be calculated by BuildPacket
-        response_header.src_ip = ip_header.dst_ip;  // Swap (our DNS server IP)
-        response_header.dst_ip = ip_header.src_ip;  // Swap (device IP)
-
-        mtp::ByteArray ip_response = IPParser::BuildPacket(response_header, udp_response);
+        // Swap source and destination (we are the DNS server)
+        mtp::ByteArray ip_response = BuildUDPPacket(ip_header.dst_ip, ip_header.src_ip,
+                                                    dst_port, src_port, dns_response,
+                                                    NextIdentification());
 
         // Wrap in PPP frame
         mtp::ByteArray ppp_frame = PPPParser::WrapPayload(ip_response, 0x0021);
@@ -104,12 +141,121 @@ std::optional<mtp::ByteArray> DNSHandler::HandleQuery(const mtp::ByteArray& ip_p
     }
 }
 
+mtp::ByteArray DNSHandler::BuildUDPPacket(uint32_t src_ip, uint32_t dst_ip,
+                                          uint16_t src_port, uint16_t dst_port,
+                                          const mtp::ByteArray& dns_response,
+                                          uint16_t identification) {
+    mtp::ByteArray udp_response;
+    udp_response.reserve(kUDPHeaderSize + dns_response.size());
+    udp_response.push_back((src_port >> 8) & 0xFF);
+    udp_response.push_back(src_port & 0xFF);
+    udp_response.push_back((dst_port >> 8) & 0xFF);
+    udp_response.push_back(dst_port & 0xFF);
+
+    // UDP length
+    uint16_t response_length = kUDPHeaderSize + dns_response.size();
+    udp_response.push_back((response_length >> 8) & 0xFF);
+    udp_response.push_back(response_length & 0xFF);
+
+    // UDP checksum (0 = no checksum)
+    udp_response.push_back(0x00);
+    udp_response.push_back(0x00);
+
+    // Append DNS response
+    udp_response.insert(udp_response.end(), dns_response.begin(), dns_response.end());
+
+    IPParser::IPHeader response_header = {};
+    response_header.version = 4;
+    response_header.header_length = kIPHeaderSize / 4;
+    response_header.dscp = 0;
+    response_header.ecn = 0;
+    response_header.total_length = 0;  // Will be calculated by BuildPacket
+    response_header.identification = identification;
+    response_header.flags_offset = 0;
+    response_header.ttl = 64;
+    response_header.protocol = 17;  // UDP
+    response_header.checksum = 0;  // Will be calculated by BuildPacket
+    response_header.src_ip = src_ip;
+    response_header.dst_ip = dst_ip;
+
+    return IPParser::BuildPacket(response_header, udp_response);
+}
+
+uint16_t DNSHandler::UpdateChecksum(uint16_t checksum, uint16_t old_word, uint16_t new_word) {
+    // HC' = ~(~HC + ~m + m')
+    uint32_t sum = static_cast<uint16_t>(~checksum) + static_cast<uint16_t>(~old_word) + new_word;
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+void DNSHandler::CompileAnswers() {
+    answers_.clear();
+    for (const auto& [hostname, ip] : hostname_map_) {
+        std::string question = EncodeQuestion(hostname);
+        if (question.empty()) {
+            continue;  // No query can name it, so BuildResponse never matches it either
+        }
+
+        // Answer it through BuildResponse, so both paths send the same bytes
+        mtp::ByteArray query(kDNSHeaderSize, 0);
+        query[5] = 1;  // One question
+        query.insert(query.end(), question.begin(), question.end());
+
+        Answer answer;
+        answer.hostname = hostname;
+        answer.dns = DNSServer::BuildResponse(query, hostname_map_);
+        if (!answer.dns.empty()) {
+            answers_.emplace(std::move(question), std::move(answer));
+        }
+    }
+}
+
+DNSHandler::Answer* DNSHandler::FindAnswer(const uint8_t* query, size_t size) {
+    if (answers_.empty() || size < kDNSHeaderSize) {
+        return nullptr;
+    }
+
+    // The first question, lowercased for the lookup
+    size_t idx = kDNSHeaderSize;
+    while (idx < size && query[idx] != 0) {
+        uint8_t length = query[idx];
+        if (length >= 64 || idx + length + 1 > size) {
+            return nullptr;
+        }
+        idx += length + 1;
+    }
+    idx += 1 + 4;  // Root label, type, class
+    if (idx > size) {
+        return nullptr;
+    }
+
+    bool lowercase = true;
+    std::string key(reinterpret_cast<const char*>(query) + kDNSHeaderSize, idx - kDNSHeaderSize);
+    for (char& c : key) {
+        char lower = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        if (lower != c) {
+            lowercase = false;
+            c = lower;
+        }
+    }
+
+    // A mixed-case question has to be echoed as sent: BuildResponse does that
+    auto it = answers_.find(key);
+    if (it == answers_.end() || !lowercase) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
 void DNSHandler::SetLogCallback(LogCallback callback) {
     log_callback_ = callback;
 }
 
 void DNSHandler::UpdateHostnameMap(const std::map<std::string, uint32_t>& hostname_map) {
     hostname_map_ = hostname_map;
+    CompileAnswers();
 }
 
 void DNSHandler::Log(const std::string& message) {
@@ -118,10 +264,10 @@ void DNSHandler::Log(const std::string& message) {
     }
 }
 
-bool DNSHandler::IsZuneTCPDNSQuery(const mtp::ByteArray& buffer) const {
+bool DNSHandler::IsZuneTCPDNSQuery(const uint8_t* buffer, size_t size) const {
     // Zune TCP DNS uses 8-byte framing: [ID1][0x0035][LEN][0x0000][DNS message]
     // Need at least 8 bytes for framing + 12 bytes for minimal DNS header
-    if (buffer.size() < 20) {
+    if (size < 20) {
         return false;
     }
 
@@ -131,10 +277,10 @@ bool DNSHandler::IsZuneTCPDNSQuery(const mtp::ByteArray& buffer) const {
     return (word1 == 0x0035 && reserved == 0x0000);
 }
 
-std::optional<mtp::ByteArray> DNSHandler::HandleTCPQuery(const mtp::ByteArray& buffer, size_t& bytes_consumed) {
+std::optional<mtp::ByteArray> DNSHandler::HandleTCPQuery(const uint8_t* buffer, size_t size, size_t& bytes_consumed) {
     bytes_consumed = 0;
 
-    if (!IsZuneTCPDNSQuery(buffer)) {
+    if (!IsZuneTCPDNSQuery(buffer, size)) {
         return std::nullopt;
     }
 
@@ -143,7 +289,7 @@ std::optional<mtp::ByteArray> DNSHandler::HandleTCPQuery(const mtp::ByteArray& b
     uint16_t length_field = (buffer[4] << 8) | buffer[5];
 
     // Length field IS the total TCP payload length (including 8-byte prefix)
-    if (buffer.size() < length_field) {
+    if (size < length_field) {
         // Incomplete - need more data
         return std::nullopt;
     }
@@ -151,10 +297,17 @@ std::optional<mtp::ByteArray> DNSHandler::HandleTCPQuery(const mtp::ByteArray& b
     Log("Zune TCP DNS query detected (length=" + std::to_string(length_field) + ")");
 
     // Extract DNS message (starts at byte 8)
-    mtp::ByteArray dns_query(buffer.begin() + 8, buffer.begin() + length_field);
-
-    // Use existing DNSServer to build response
-    mtp::ByteArray dns_response = DNSServer::BuildResponse(dns_query, hostname_map_);
+    mtp::ByteArray dns_query(buffer + 8, buffer + length_field);
+
+    // Use the precompiled answer, else existing DNSServer to build response
+    mtp::ByteArray dns_response;
+    if (Answer* answer = FindAnswer(dns_query.data(), dns_query.size())) {
+        dns_response = answer->dns;
+        dns_response[0] = dns_query[0];  // Transaction ID
+        dns_response[1] = dns_query[1];
+    } else {
+        dns_response = DNSServer::BuildResponse(dns_query, hostname_map_);
+    }
 
     if (dns_response.empty()) {
         std::string hostname = DNSServer::ParseHostname(dns_query);
@@ -5,6 +5,7 @@
 #include <string>
 #include <optional>
 #include <functional>
+#include <unordered_map>
 
 /**
  * DNSHandler
@@ -15,7 +16,12 @@
  * This handler extracts the DNS query, builds a response using configured hostname
  * mappings, and returns a complete PPP-framed UDP/IP/DNS response packet.
  *
- * This is a stateless handler following Clean Architecture principles.
+ * The answer to an A query for each mapped hostname is built once, when the
+ * map is set, as a complete IP/UDP/DNS packet. A query matching one is
+ * answered by copying it and patching in the transaction ID, ports and IP
+ * identification, with the IP checksum updated incrementally. Queries that
+ * do not match (other types, mixed-case names) go through
+ * DNSServer::BuildResponse as before.
  */
 class DNSHandler {
 public:
@@ -42,7 +48,10 @@ public:
      * @param buffer TCP stream reassembly buffer
      * @return true if buffer starts with Zune DNS framing
      */
-    bool IsZuneTCPDNSQuery(const mtp::ByteArray& buffer) const;
+    bool IsZuneTCPDNSQuery(const uint8_t* buffer, size_t size) const;
+    bool IsZuneTCPDNSQuery(const mtp::ByteArray& buffer) const {
+        return IsZuneTCPDNSQuery(buffer.data(), buffer.size());
+    }
 
     /**
      * Handle Zune TCP DNS query with custom framing
@@ -52,7 +61,10 @@ public:
      * @param bytes_consumed Output: number of bytes consumed from buffer
      * @return TCP payload for response (with Zune framing), or empty if incomplete/failed
      */
-    std::optional<mtp::ByteArray> HandleTCPQuery(const mtp::ByteArray& buffer, size_t& bytes_consumed);
+    std::optional<mtp::ByteArray> HandleTCPQuery(const uint8_t* buffer, size_t size, size_t& bytes_consumed);
+    std::optional<mtp::ByteArray> HandleTCPQuery(const mtp::ByteArray& buffer, size_t& bytes_consumed) {
+        return HandleTCPQuery(buffer.data(), buffer.size(), bytes_consumed);
+    }
 
     /**
      * Set logging callback for diagnostic messages
@@ -66,12 +78,41 @@ public:
      */
     void UpdateHostnameMap(const std::map<std::string, uint32_t>& hostname_map);
 
+    /**
+     * Update a 16-bit ones' complement checksum for one changed word (RFC 1624)
+     */
+    static uint16_t UpdateChecksum(uint16_t checksum, uint16_t old_word, uint16_t new_word);
+
 private:
+    // Precompiled answer to an A query for one hostname
+    struct Answer {
+        std::string hostname;
+        mtp::ByteArray dns;     // DNS response with transaction ID 0
+        mtp::ByteArray packet;  // IP/UDP around dns for the addresses below, IP ID 0
+        uint32_t server_ip = 0;
+        uint32_t device_ip = 0;
+    };
+
+    void CompileAnswers();
+
+    /**
+     * Answer for the query's question, if it has one and the question is
+     * byte-for-byte what the answer echoes
+     */
+    Answer* FindAnswer(const uint8_t* query, size_t size);
+
+    static mtp::ByteArray BuildUDPPacket(uint32_t src_ip, uint32_t dst_ip,
+                                         uint16_t src_port, uint16_t dst_port,
+                                         const mtp::ByteArray& dns_response,
+                                         uint16_t identification);
+
     /**
      * Log a message via callback if set
      */
     void Log(const std::string& message);
 
     std::map<std::string, uint32_t> hostname_map_;
+    // Keyed by the question section in wire format (name, type A, class IN)
+    std::unordered_map<std::string, Answer> answers_;
     LogCallback log_callback_;
 };
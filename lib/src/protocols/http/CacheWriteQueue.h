@@ -0,0 +1,144 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/**
+ * CacheWriteQueue
+ *
+ * Write-behind for the cache storage callback. The HTTP worker thread
+ * queues the write (owning a copy of the body) and goes straight on to
+ * send the response; one background thread runs the writes in order.
+ *
+ * The queue is bounded by both a count (depth) and the bytes it holds.
+ * A push that would go over either limit waits for the writer to catch
+ * up, so a slow disk slows requests down instead of growing memory
+ * without bound. A single write larger than the byte limit is still
+ * accepted once the queue is empty.
+ *
+ * The destructor runs every queued write before returning.
+ */
+class CacheWriteQueue {
+public:
+    struct Limits {
+        size_t max_writes = 32;
+        size_t max_bytes = 64 * 1024 * 1024;
+    };
+
+    struct Stats {
+        uint64_t queued = 0;
+        uint64_t written = 0;
+        uint64_t waits = 0;        // Pushes that hit a limit and waited
+        uint64_t peak_bytes = 0;
+    };
+
+    CacheWriteQueue() : CacheWriteQueue(Limits()) {}
+
+    explicit CacheWriteQueue(Limits limits)
+        : limits_(limits) {
+        if (limits_.max_writes == 0) {
+            limits_.max_writes = 1;
+        }
+    }
+
+    CacheWriteQueue(const CacheWriteQueue&) = delete;
+    CacheWriteQueue& operator=(const CacheWriteQueue&) = delete;
+
+    ~CacheWriteQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    /**
+     * Queue write, accounted as bytes; waits while the queue is full
+     */
+    void Push(std::function<void()> write, size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto has_room = [&] {
+            return pending_ == 0 ||
+                   (pending_ < limits_.max_writes && pending_bytes_ + bytes <= limits_.max_bytes);
+        };
+        if (!has_room()) {
+            stats_.waits++;
+            space_cv_.wait(lock, has_room);
+        }
+
+        writes_.push_back(Write{std::move(write), bytes});
+        pending_++;
+        pending_bytes_ += bytes;
+        stats_.queued++;
+        if (pending_bytes_ > stats_.peak_bytes) {
+            stats_.peak_bytes = pending_bytes_;
+        }
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&CacheWriteQueue::WriterThread, this);
+        }
+        lock.unlock();
+        work_cv_.notify_one();
+    }
+
+    /**
+     * Wait until every write queued so far has run
+     */
+    void Flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Write {
+        std::function<void()> run;
+        size_t bytes;
+    };
+
+    void WriterThread() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_cv_.wait(lock, [this] { return stop_ || !writes_.empty(); });
+            if (writes_.empty()) {
+                return;  // Stopped and drained
+            }
+            Write write = std::move(writes_.front());
+            writes_.pop_front();
+
+            lock.unlock();
+            write.run();
+            write.run = nullptr;  // Free the body before taking the lock
+            lock.lock();
+
+            // Counted down only once run, so Flush waits for the write itself
+            pending_--;
+            pending_bytes_ -= write.bytes;
+            stats_.written++;
+            space_cv_.notify_all();
+        }
+    }
+
+    Limits limits_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable space_cv_;
+    std::deque<Write> writes_;
+    size_t pending_ = 0;          // Queued plus the one running
+    size_t pending_bytes_ = 0;
+    bool stop_ = false;
+    std::thread thread_;
+    Stats stats_;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * FrameCoalescer
+ *
+ * How the 0x922c drain packs PPP frames into USB transfers. Each transfer
+ * is one MTP transaction and costs a full round trip whatever its size,
+ * so the drain concatenates queued frames up to a byte budget (the device
+ * takes several 0x7E-delimited frames per payload).
+ *
+ * A transfer that is not full may wait a little for more frames when
+ * another thread is producing them, e.g. a body streaming in from upstream
+ * while the poll thread drains. The wait adapts: it starts at zero, grows
+ * when frames turn up during a partial transfer's round trip (a wait would
+ * have caught them), and halves each time a wait ends with nothing new. A
+ * thread draining its own frames never sees any arrive mid-send, so a lone
+ * ACK or DNS reply goes straight out.
+ *
+ * Not thread-safe; only the thread holding the drain uses it.
+ */
+class FrameCoalescer {
+public:
+    using Micros = std::chrono::microseconds;
+
+    static constexpr size_t kDefaultBudget = 7680;  // Official software: ~7.6 KB per 922c
+    static constexpr Micros kDefaultMaxWait{2000};
+
+    struct Stats {
+        uint64_t transfers = 0;
+        uint64_t full_transfers = 0;  // Reached the budget
+        uint64_t bytes = 0;
+        uint64_t waits = 0;           // Partial transfers held back for more frames
+        uint64_t waits_filled = 0;    // Of those, more frames came
+    };
+
+    FrameCoalescer() = default;
+
+    FrameCoalescer(size_t budget, Micros max_wait) {
+        Configure(budget, max_wait);
+    }
+
+    /**
+     * Set the budget (bytes per transfer) and the longest wait for more
+     * frames; a zero wait sends every transfer as soon as the queue is empty
+     */
+    void Configure(size_t budget, Micros max_wait) {
+        budget_ = std::max<size_t>(budget, 1);
+        max_wait_ = std::max(max_wait, Micros(0));
+        wait_ = Micros(0);
+    }
+
+    size_t Budget() const { return budget_; }
+
+    /**
+     * How long to wait for more frames before sending payload_size bytes
+     * now; zero to send at once
+     */
+    Micros WaitFor(size_t payload_size) const {
+        if (payload_size >= budget_) {
+            return Micros(0);
+        }
+        return wait_;
+    }
+
+    void OnWaited(bool more_arrived) {
+        stats_.waits++;
+        if (more_arrived) {
+            stats_.waits_filled++;
+            return;
+        }
+        wait_ /= 2;
+        if (wait_ < MinWait()) {
+            wait_ = Micros(0);
+        }
+    }
+
+    /**
+     * After a transfer of bytes; frames_queued if more frames were queued
+     * by the time it completed
+     */
+    void OnSent(size_t bytes, bool frames_queued) {
+        stats_.transfers++;
+        stats_.bytes += bytes;
+        if (bytes >= budget_) {
+            stats_.full_transfers++;
+            return;
+        }
+        if (frames_queued && max_wait_.count() > 0) {
+            wait_ = wait_.count() == 0 ? MinWait() : std::min(wait_ * 2, max_wait_);
+        }
+    }
+
+    /** Current wait for a partial transfer */
+    Micros CurrentWait() const { return wait_; }
+
+    Stats GetStats() const { return stats_; }
+
+private:
+    Micros MinWait() const {
+        return std::max(max_wait_ / 8, Micros(1));
+    }
+
+    size_t budget_ = kDefaultBudget;
+    Micros max_wait_ = kDefaultMaxWait;
+    Micros wait_{0};
+    Stats stats_;
+};
@@ -1,7 +1,10 @@
 #include "HTTPParser.h"
+#include "../../ZuneFileStore.h"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cstdio>
+#include <cstring>
 #include <regex>
 
 // ============================================================================
@@ -35,6 +38,24 @@ bool HTTPParser::HTTPRequest::HasQueryParam(const std::string& name) const {
 // HTTPResponse Helper Methods
 // ============================================================================
 
+const uint8_t* HTTPParser::HTTPResponse::BodyData() const {
+    return mapped_body ? mapped_body : body.data();
+}
+
+size_t HTTPParser::HTTPResponse::BodySize() const {
+    return mapped_body ? mapped_body_size : body.size();
+}
+
+std::string HTTPParser::HTTPResponse::GetHeader(const std::string& name) const {
+    std::string lower_name = ToLower(name);
+    for (const auto& [key, value] : headers) {
+        if (ToLower(key) == lower_name) {
+            return value;
+        }
+    }
+    return "";
+}
+
 void HTTPParser::HTTPResponse::SetContentType(const std::string& content_type) {
     headers["Content-Type"] = content_type;
 }
@@ -52,10 +73,14 @@ void HTTPParser::HTTPResponse::SetHeader(const std::string& name, const std::str
 // ============================================================================
 
 HTTPParser::HTTPRequest HTTPParser::ParseRequest(const mtp::ByteArray& data) {
+    return ParseRequest(data.data(), data.size());
+}
+
+HTTPParser::HTTPRequest HTTPParser::ParseRequest(const uint8_t* data, size_t size) {
     HTTPRequest request;
 
     // Convert to string for parsing
-    std::string http_str(data.begin(), data.end());
+    std::string http_str(reinterpret_cast<const char*>(data), size);
     std::istringstream stream(http_str);
     std::string line;
 
@@ -113,56 +138,195 @@ HTTPParser::HTTPRequest HTTPParser::ParseRequest(const mtp::ByteArray& data) {
     return request;
 }
 
-HTTPParser::ExtractResult HTTPParser::TryExtractRequest(
-    const mtp::ByteArray& buffer,
-    HTTPRequest& request,
-    size_t& bytes_consumed) {
+namespace {
 
-    bytes_consumed = 0;
+constexpr std::string_view kWhitespace = " \t\r\n";
 
-    if (buffer.empty()) {
-        return ExtractResult::INCOMPLETE;
+std::string_view TrimView(std::string_view str) {
+    size_t first = str.find_first_not_of(kWhitespace);
+    if (first == std::string_view::npos) {
+        return {};
     }
+    size_t last = str.find_last_not_of(kWhitespace);
+    return str.substr(first, last - first + 1);
+}
 
-    // Convert buffer to string for searching
-    std::string buffer_str(buffer.begin(), buffer.end());
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Find a complete request head at the start of a stream buffer
+HTTPParser::ExtractResult FindRequestHead(const uint8_t* data, size_t size, size_t& head_size) {
+    head_size = 0;
+
+    if (size == 0) {
+        return HTTPParser::ExtractResult::INCOMPLETE;
+    }
 
     // Look for end of headers (\r\n\r\n)
-    size_t header_end = buffer_str.find("\r\n\r\n");
-    if (header_end == std::string::npos) {
-        return ExtractResult::INCOMPLETE;
+    static const uint8_t kHeaderEnd[] = {'\r', '\n', '\r', '\n'};
+    const uint8_t* end = data + size;
+    const uint8_t* header_end = std::search(data, end, kHeaderEnd, kHeaderEnd + sizeof(kHeaderEnd));
+    if (header_end == end) {
+        return HTTPParser::ExtractResult::INCOMPLETE;
     }
 
     // Verify buffer starts with valid HTTP method
-    bool valid_http_start = (
-        buffer_str.substr(0, 4) == "GET " ||
-        buffer_str.substr(0, 5) == "POST " ||
-        buffer_str.substr(0, 4) == "PUT " ||
-        buffer_str.substr(0, 7) == "DELETE " ||
-        buffer_str.substr(0, 5) == "HEAD " ||
-        buffer_str.substr(0, 8) == "OPTIONS " ||
-        buffer_str.substr(0, 6) == "PATCH "
-    );
+    static const char* const kMethods[] = {
+        "GET ", "POST ", "PUT ", "DELETE ", "HEAD ", "OPTIONS ", "PATCH "
+    };
+    bool valid_http_start = false;
+    for (const char* method : kMethods) {
+        size_t len = std::strlen(method);
+        if (size >= len && std::memcmp(data, method, len) == 0) {
+            valid_http_start = true;
+            break;
+        }
+    }
 
     if (!valid_http_start) {
-        return ExtractResult::INVALID_DATA;
+        return HTTPParser::ExtractResult::INVALID_DATA;
     }
 
-    // Calculate request size (headers + \r\n\r\n terminator)
-    bytes_consumed = header_end + 4;
+    // Request size (headers + \r\n\r\n terminator)
+    head_size = (header_end - data) + sizeof(kHeaderEnd);
+    return HTTPParser::ExtractResult::SUCCESS;
+}
+
+} // namespace
+
+std::string_view HTTPParser::RequestView::GetHeader(std::string_view name) const {
+    for (size_t i = header_count; i > 0; i--) {
+        if (EqualsIgnoreCase(headers[i - 1].name, name)) {
+            return headers[i - 1].value;
+        }
+    }
+    return {};
+}
+
+bool HTTPParser::ParseRequestView(std::string_view head, RequestView& request) {
+    request.method = {};
+    request.path = {};
+    request.query = {};
+    request.protocol = {};
+    request.header_count = 0;
+
+    // Request line: GET /path HTTP/1.1, fields separated by any whitespace
+    size_t line_end = head.find('\n');
+    std::string_view line = head.substr(0, line_end);
+    std::string_view target;
+    std::string_view* fields[] = {&request.method, &target, &request.protocol};
+    size_t pos = 0;
+    for (std::string_view* field : fields) {
+        pos = line.find_first_not_of(kWhitespace, pos);
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        size_t end = line.find_first_of(kWhitespace, pos);
+        *field = line.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        pos = end;
+    }
+
+    if (request.method.empty() || target.empty()) {
+        return false;
+    }
+
+    size_t query_pos = target.find('?');
+    request.path = target.substr(0, query_pos);
+    if (query_pos != std::string_view::npos) {
+        request.query = target.substr(query_pos + 1);
+    }
 
-    // Extract just this request from the buffer
-    mtp::ByteArray request_data(buffer.begin(), buffer.begin() + bytes_consumed);
+    // Headers, up to the empty line
+    pos = (line_end == std::string_view::npos) ? head.size() : line_end + 1;
+    while (pos < head.size()) {
+        size_t end = head.find('\n', pos);
+        line = head.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        pos = (end == std::string_view::npos) ? head.size() : end + 1;
 
-    try {
-        request = ParseRequest(request_data);
-        return ExtractResult::SUCCESS;
-    } catch (const std::exception&) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            break;
+        }
+
+        size_t colon_pos = line.find(':');
+        if (colon_pos == std::string_view::npos) {
+            continue;
+        }
+        if (request.header_count == RequestView::kMaxHeaders) {
+            return false;
+        }
+        request.headers[request.header_count++] = {
+            TrimView(line.substr(0, colon_pos)), TrimView(line.substr(colon_pos + 1))};
+    }
+    return true;
+}
+
+HTTPParser::ExtractResult HTTPParser::TryExtractRequestView(
+    const uint8_t* data,
+    size_t size,
+    RequestView& request,
+    size_t& bytes_consumed) {
+
+    ExtractResult result = FindRequestHead(data, size, bytes_consumed);
+    if (result != ExtractResult::SUCCESS) {
+        return result;
+    }
+
+    std::string_view head(reinterpret_cast<const char*>(data), bytes_consumed);
+    if (!ParseRequestView(head, request)) {
+        bytes_consumed = 0;
         return ExtractResult::INVALID_DATA;
     }
+    return ExtractResult::SUCCESS;
+}
+
+HTTPParser::ExtractResult HTTPParser::TryExtractRequest(
+    const uint8_t* data,
+    size_t size,
+    HTTPRequest& request,
+    size_t& bytes_consumed) {
+
+    RequestView view;
+    ExtractResult result = TryExtractRequestView(data, size, view, bytes_consumed);
+    if (result != ExtractResult::SUCCESS) {
+        return result;
+    }
+
+    request = HTTPRequest{};
+    request.method.assign(view.method);
+    request.path.assign(view.path);
+    request.protocol.assign(view.protocol);
+    if (!view.query.empty()) {
+        request.query_params = ParseQueryString(std::string(view.query));
+    }
+    for (size_t i = 0; i < view.header_count; i++) {
+        request.headers[std::string(view.headers[i].name)].assign(view.headers[i].value);
+    }
+    return ExtractResult::SUCCESS;
 }
 
 mtp::ByteArray HTTPParser::BuildResponse(const HTTPResponse& response) {
+    mtp::ByteArray result = BuildResponseHeader(response);
+
+    // Append body
+    result.insert(result.end(), response.BodyData(), response.BodyData() + response.BodySize());
+
+    return result;
+}
+
+mtp::ByteArray HTTPParser::BuildResponseHeader(const HTTPResponse& response) {
     std::ostringstream oss;
 
     // Status line
@@ -179,13 +343,7 @@ mtp::ByteArray HTTPParser::BuildResponse(const HTTPResponse& response) {
 
     // Convert to ByteArray
     std::string response_str = oss.str();
-    mtp::ByteArray result;
-    result.insert(result.end(), response_str.begin(), response_str.end());
-
-    // Append body
-    result.insert(result.end(), response.body.begin(), response.body.end());
-
-    return result;
+    return mtp::ByteArray(response_str.begin(), response_str.end());
 }
 
 HTTPParser::HTTPResponse HTTPParser::BuildErrorResponse(int status_code, const std::string& message) {
@@ -221,6 +379,144 @@ HTTPParser::HTTPResponse HTTPParser::BuildSuccessResponse(const std::string& con
     return response;
 }
 
+// ============================================================================
+// Conditional Requests (RFC 7232)
+// ============================================================================
+
+namespace {
+
+const char* const kWeekdays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                               "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+// Days since 1970-01-01 of a proleptic Gregorian date (month 1-12)
+int64_t DaysFromCivil(int64_t year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// An entity tag without its weakness prefix, for weak comparison
+std::string_view OpaqueTag(std::string_view tag) {
+    if (tag.size() >= 2 && tag[0] == 'W' && tag[1] == '/') {
+        tag.remove_prefix(2);
+    }
+    return tag;
+}
+
+} // namespace
+
+std::string HTTPParser::MakeETag(const uint8_t* data, size_t size) {
+    uint64_t hash = zune::Fnv1a64(data, size);
+    char tag[20];
+    snprintf(tag, sizeof(tag), "\"%016llx\"", static_cast<unsigned long long>(hash));
+    return tag;
+}
+
+std::string HTTPParser::FormatHTTPDate(int64_t unix_seconds) {
+    int64_t days = unix_seconds / 86400;
+    int64_t seconds = unix_seconds % 86400;
+    if (seconds < 0) {
+        seconds += 86400;
+        days--;
+    }
+
+    // Inverse of DaysFromCivil
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t day_of_era = z - era * 146097;
+    int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int64_t mp = (5 * day_of_year + 2) / 153;
+    int day = static_cast<int>(day_of_year - (153 * mp + 2) / 5 + 1);
+    int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    int64_t year = year_of_era + era * 400 + (month <= 2);
+    int weekday = static_cast<int>(((days % 7) + 11) % 7);  // 1970-01-01 was a Thursday
+
+    char text[40];
+    snprintf(text, sizeof(text), "%s, %02d %s %04lld %02d:%02d:%02d GMT",
+             kWeekdays[weekday], day, kMonths[month - 1], static_cast<long long>(year),
+             static_cast<int>(seconds / 3600), static_cast<int>(seconds / 60 % 60),
+             static_cast<int>(seconds % 60));
+    return text;
+}
+
+bool HTTPParser::ParseHTTPDate(const std::string& text, int64_t& unix_seconds) {
+    char weekday[4] = {};
+    char month_name[4] = {};
+    int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+    int consumed = 0;
+    if (sscanf(text.c_str(), "%3[A-Za-z], %d %3[A-Za-z] %d %d:%d:%d GMT%n",
+               weekday, &day, month_name, &year, &hour, &minute, &second, &consumed) != 7 ||
+        consumed != static_cast<int>(text.size())) {
+        return false;
+    }
+    int month = 0;
+    while (month < 12 && std::strcmp(kMonths[month], month_name) != 0) {
+        month++;
+    }
+    if (month == 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    unix_seconds = DaysFromCivil(year, month + 1, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+bool HTTPParser::IsConditional(const HTTPRequest& request) {
+    return request.HasHeader("If-None-Match") || request.HasHeader("If-Modified-Since");
+}
+
+bool HTTPParser::IsNotModified(const HTTPRequest& request, const HTTPResponse& response) {
+    if (response.status_code != 200) {
+        return false;
+    }
+
+    std::string if_none_match = request.GetHeader("If-None-Match");
+    if (!if_none_match.empty()) {
+        std::string etag = response.GetHeader("ETag");
+        std::string_view list(if_none_match);
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            std::string_view tag = TrimView(list.substr(0, comma));
+            if (tag == "*" || (!etag.empty() && OpaqueTag(tag) == OpaqueTag(etag))) {
+                return true;
+            }
+            list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+        }
+        return false;
+    }
+
+    int64_t since = 0;
+    int64_t modified = 0;
+    return ParseHTTPDate(request.GetHeader("If-Modified-Since"), since) &&
+           ParseHTTPDate(response.GetHeader("Last-Modified"), modified) &&
+           modified <= since;
+}
+
+HTTPParser::HTTPResponse HTTPParser::BuildNotModifiedResponse(const HTTPResponse& response) {
+    // What a 200 would have carried of these (RFC 7232 4.1)
+    static const char* const kKept[] = {"cache-control", "content-location", "date", "etag",
+                                        "expires", "last-modified", "vary", "connection", "server"};
+
+    HTTPResponse not_modified;
+    not_modified.status_code = 304;
+    not_modified.status_message = GetStatusMessage(304);
+    not_modified.protocol = response.protocol;
+    for (const auto& [name, value] : response.headers) {
+        std::string lower_name = ToLower(name);
+        for (const char* kept : kKept) {
+            if (lower_name == kept) {
+                not_modified.headers[name] = value;
+                break;
+            }
+        }
+    }
+    return not_modified;
+}
+
 std::string HTTPParser::ExtractArtistUUID(const std::string& path) {
     // Match patterns like: /v3.0/en-US/music/artist/{uuid}/biography
     // or /v3.0/model/artist/{uuid}
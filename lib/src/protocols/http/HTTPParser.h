@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
+#include <memory>
 #include <mtp/ByteArray.h>
 
 /**
@@ -34,6 +38,31 @@ public:
         bool HasQueryParam(const std::string& name) const;
     };
 
+    /**
+     * A request parsed in place: every field views the buffer it was parsed
+     * from and is valid only until that buffer is consumed or changes.
+     * Header names and values are trimmed but keep their case; nothing is
+     * decoded. Requests with more than kMaxHeaders headers are not parsed.
+     */
+    struct RequestView {
+        static constexpr size_t kMaxHeaders = 32;
+
+        struct Header {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        std::string_view method;
+        std::string_view path;      // Without the query
+        std::string_view query;     // After the '?', still URL-encoded
+        std::string_view protocol;
+        Header headers[kMaxHeaders];
+        size_t header_count = 0;
+
+        // Value of the last header named name (any case), empty if none
+        std::string_view GetHeader(std::string_view name) const;
+    };
+
     struct HTTPResponse {
         int status_code = 200;
         std::string status_message = "OK";
@@ -41,6 +70,20 @@ public:
         std::map<std::string, std::string> headers;
         mtp::ByteArray body;
 
+        // File-backed body (a mapped local file): when set, these bytes are
+        // sent instead of body. The owner keeps the mapping alive for as
+        // long as any copy of the response holds it.
+        std::shared_ptr<const void> mapped_body_owner;
+        const uint8_t* mapped_body = nullptr;
+        size_t mapped_body_size = 0;
+
+        // The body as sent, whichever of the two holds it
+        const uint8_t* BodyData() const;
+        size_t BodySize() const;
+
+        // Value of the header named name (any case), empty if none
+        std::string GetHeader(const std::string& name) const;
+
         // Helper method to set common headers
         void SetContentType(const std::string& content_type);
         void SetContentLength(size_t length);
@@ -54,6 +97,7 @@ public:
      * @throws std::runtime_error if request is malformed
      */
     static HTTPRequest ParseRequest(const mtp::ByteArray& data);
+    static HTTPRequest ParseRequest(const uint8_t* data, size_t size);
 
     /**
      * Result of trying to extract an HTTP request from a stream buffer
@@ -72,14 +116,35 @@ public:
      * - Complete request (possibly with more pipelined requests after)
      * - Stale/invalid data (should be cleared)
      *
-     * @param buffer Stream buffer containing accumulated TCP data
+     * The buffer is read in place (a reassembler's view works directly);
+     * only the bytes of the extracted request are copied.
+     *
+     * @param data Stream buffer containing accumulated TCP data
+     * @param size Bytes in the stream buffer
      * @param[out] request Parsed request if successful
      * @param[out] bytes_consumed Number of bytes that comprise this request
      * @return ExtractResult indicating success, incomplete, or invalid data
      */
+    static ExtractResult TryExtractRequest(
+        const uint8_t* data,
+        size_t size,
+        HTTPRequest& request,
+        size_t& bytes_consumed);
     static ExtractResult TryExtractRequest(
         const mtp::ByteArray& buffer,
         HTTPRequest& request,
+        size_t& bytes_consumed) {
+        return TryExtractRequest(buffer.data(), buffer.size(), request, bytes_consumed);
+    }
+
+    /**
+     * TryExtractRequest without copying: request views data, so whatever is
+     * needed from it must be copied before data is consumed
+     */
+    static ExtractResult TryExtractRequestView(
+        const uint8_t* data,
+        size_t size,
+        RequestView& request,
         size_t& bytes_consumed);
 
     /**
@@ -89,6 +154,13 @@ public:
      */
     static mtp::ByteArray BuildResponse(const HTTPResponse& response);
 
+    /**
+     * Build just the status line and headers, through the blank line
+     * @param response Response structure
+     * @return Bytes that precede response.body on the wire
+     */
+    static mtp::ByteArray BuildResponseHeader(const HTTPResponse& response);
+
     /**
      * Build a simple error response
      * @param status_code HTTP status code (e.g., 404, 500)
@@ -105,6 +177,41 @@ public:
      */
     static HTTPResponse BuildSuccessResponse(const std::string& content_type, const mtp::ByteArray& body);
 
+    /**
+     * Strong entity tag for a body: its 64-bit FNV-1a hash, quoted
+     */
+    static std::string MakeETag(const uint8_t* data, size_t size);
+
+    /**
+     * IMF-fixdate (RFC 7231 7.1.1.1), e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+     */
+    static std::string FormatHTTPDate(int64_t unix_seconds);
+
+    /**
+     * Parse an IMF-fixdate
+     * @return false for anything else, including the obsolete date formats
+     */
+    static bool ParseHTTPDate(const std::string& text, int64_t& unix_seconds);
+
+    /**
+     * Whether request carries If-None-Match or If-Modified-Since
+     */
+    static bool IsConditional(const HTTPRequest& request);
+
+    /**
+     * Whether a GET with request's validators can be answered 304 instead
+     * of with response (RFC 7232 6). If-None-Match, when present, decides
+     * alone, by weak comparison; otherwise If-Modified-Since is checked
+     * against Last-Modified. Only 200 responses qualify.
+     */
+    static bool IsNotModified(const HTTPRequest& request, const HTTPResponse& response);
+
+    /**
+     * 304 standing in for response: its validators and caching headers,
+     * no body and no Content-Length
+     */
+    static HTTPResponse BuildNotModifiedResponse(const HTTPResponse& response);
+
     /**
      * Extract artist UUID from Zune catalog path
      * @param path Request path (e.g., "/v3.0/en-US/music/artist/{uuid}/biography")
@@ -137,6 +244,12 @@ public:
 
 private:
 
+    /**
+     * Parse the request line and headers of a complete head in place
+     * @return false if the request line is malformed or there are too many headers
+     */
+    static bool ParseRequestView(std::string_view head, RequestView& request);
+
     /**
      * URL decode a string (e.g., "%20" -> " ")
      * @param encoded URL-encoded string
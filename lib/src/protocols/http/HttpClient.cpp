@@ -2,6 +2,7 @@
 #include <curl/curl.h>
 #include <algorithm>
 #include <cctype>
+#include <functional>
 
 // libcurl write callback - accumulates response body
 static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
@@ -49,43 +50,166 @@ static size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* use
     return total_size;
 }
 
+// CURLSH lock callbacks - user data is HttpClient::share_locks_, one mutex per curl_lock_data
+static void LockShareCallback(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+    static_cast<std::mutex*>(userp)[data].lock();
+}
+
+static void UnlockShareCallback(CURL*, curl_lock_data data, void* userp) {
+    static_cast<std::mutex*>(userp)[data].unlock();
+}
+
+// PerformGET transfer state: the body buffer and, once Begin accepted, the stream
+struct StreamingTransfer {
+    mtp::ByteArray* buffer;
+    HttpClient::ResponseStream* stream;
+    CURL* curl;
+    std::function<HTTPParser::HTTPResponse(const uint8_t*, size_t, long, curl_off_t)> build_head;
+    bool decided = false;
+    bool streaming = false;
+    curl_off_t expected = 0;
+    curl_off_t delivered = 0;
+};
+
+// libcurl write callback for PerformGET - buffers the body and feeds the stream
+static size_t StreamingWriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    size_t total_size = size * nmemb;
+    auto* transfer = static_cast<StreamingTransfer*>(userp);
+    const auto* bytes = static_cast<const uint8_t*>(contents);
+    transfer->buffer->insert(transfer->buffer->end(), bytes, bytes + total_size);
+
+    if (!transfer->stream) {
+        return total_size;
+    }
+
+    // Headers of the final response are complete by the first body write
+    if (!transfer->decided) {
+        transfer->decided = true;
+        long http_code = 0;
+        curl_off_t length = -1;
+        curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_easy_getinfo(transfer->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+        if (http_code >= 200 && http_code < 300 && length > 0) {
+            transfer->expected = length;
+            transfer->streaming = transfer->stream->Begin(
+                transfer->build_head(bytes, total_size, http_code, length), static_cast<size_t>(length));
+        }
+    }
+
+    if (transfer->streaming) {
+        size_t room = static_cast<size_t>(transfer->expected - transfer->delivered);
+        size_t n = std::min(total_size, room);
+        if (n > 0) {
+            if (!transfer->stream->Write(bytes, n)) {
+                return 0;  // Aborts the transfer with CURLE_WRITE_ERROR
+            }
+            transfer->delivered += n;
+        }
+    }
+    return total_size;
+}
+
 HttpClient::HttpClient(const ServerConfig& config)
     : config_(config) {
+    static_assert(CURL_LOCK_DATA_LAST <= kShareLockCount, "share_locks_ too small");
 
-    curl_handle_ = curl_easy_init();
-    if (!curl_handle_) {
+    CURL* probe = curl_easy_init();
+    if (!probe) {
         throw std::runtime_error("Failed to initialize libcurl");
     }
+    idle_handles_.push_back(probe);
+
+    CURLSH* share = curl_share_init();
+    if (share) {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, LockShareCallback);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, UnlockShareCallback);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, share_locks_);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        // Not available before libcurl 7.57; DNS and TLS sessions are still shared
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        share_handle_ = share;
+    }
 }
 
 HttpClient::~HttpClient() {
-    if (curl_handle_) {
-        curl_easy_cleanup(static_cast<CURL*>(curl_handle_));
+    // Easy handles go first: they hold references into the share
+    for (void* handle : idle_handles_) {
+        curl_easy_cleanup(static_cast<CURL*>(handle));
+    }
+    if (share_handle_) {
+        curl_share_cleanup(static_cast<CURLSH*>(share_handle_));
+    }
+}
+
+void* HttpClient::AcquireHandle() {
+    CURL* curl = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (!idle_handles_.empty()) {
+            curl = static_cast<CURL*>(idle_handles_.back());
+            idle_handles_.pop_back();
+        }
+    }
+    if (curl) {
+        // Clears options only; the handle keeps its share and live connections
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+        if (!curl) {
+            return nullptr;
+        }
+    }
+
+    if (share_handle_) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, static_cast<CURLSH*>(share_handle_));
+    }
+    // Timeouts must not use signals with several requests in flight
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    return curl;
+}
+
+void HttpClient::ReleaseHandle(void* handle) {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (idle_handles_.size() < kMaxIdleHandles) {
+            idle_handles_.push_back(handle);
+            return;
+        }
     }
+    curl_easy_cleanup(static_cast<CURL*>(handle));
 }
 
 HTTPParser::HTTPResponse HttpClient::PerformGET(
     const std::string& url,
-    const std::map<std::string, std::string>& headers) {
+    const std::map<std::string, std::string>& headers,
+    ResponseStream* stream) {
 
-    std::lock_guard<std::mutex> lock(curl_mutex_);
-
-    if (!curl_handle_) {
+    CURL* curl = static_cast<CURL*>(AcquireHandle());
+    if (!curl) {
         Log("libcurl error: Handle not initialized");
         return HTTPParser::BuildErrorResponse(502, "libcurl initialization failed");
     }
 
-    CURL* curl = static_cast<CURL*>(curl_handle_);
-
     mtp::ByteArray response_data;
     std::map<std::string, std::string> response_headers;
     long http_code = 0;
 
-    // Reset and configure curl
-    curl_easy_reset(curl);
+    StreamingTransfer transfer{&response_data, stream, curl, nullptr};
+    transfer.build_head = [&response_headers](const uint8_t* first, size_t first_size,
+                                              long status, curl_off_t length) {
+        // Content type is detected from the first bytes when upstream sent none
+        HTTPParser::HTTPResponse head = ParseResponse(
+            mtp::ByteArray(first, first + first_size), static_cast<int>(status), response_headers);
+        head.body.clear();
+        head.SetContentLength(static_cast<size_t>(length));
+        return head;
+    };
+
+    // Configure curl
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, StreamingWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
     curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
 
@@ -119,6 +243,11 @@ HTTPParser::HTTPResponse HttpClient::PerformGET(
 
     // Get HTTP response code
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    ReleaseHandle(curl);
+
+    if (transfer.streaming) {
+        stream->End(transfer.delivered == transfer.expected);
+    }
 
     if (res != CURLE_OK) {
         std::string error_msg = curl_easy_strerror(res);
@@ -206,28 +335,25 @@ HTTPParser::HTTPResponse HttpClient::BuildConnectivityResponse() {
 }
 
 bool HttpClient::TestConnection() {
-    std::lock_guard<std::mutex> lock(curl_mutex_);
-
-    if (config_.catalog_server.empty() || !curl_handle_) {
+    if (config_.catalog_server.empty()) {
         return false;
     }
 
-    try {
-        std::string test_url = config_.catalog_server + "/";
+    CURL* curl = static_cast<CURL*>(AcquireHandle());
+    if (!curl) {
+        return false;
+    }
 
-        CURL* curl = static_cast<CURL*>(curl_handle_);
-        curl_easy_reset(curl);
-        curl_easy_setopt(curl, CURLOPT_URL, test_url.c_str());
-        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);  // HEAD request
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    std::string test_url = config_.catalog_server + "/";
+    curl_easy_setopt(curl, CURLOPT_URL, test_url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);  // HEAD request
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 
-        CURLcode res = curl_easy_perform(curl);
+    CURLcode res = curl_easy_perform(curl);
+    ReleaseHandle(curl);
 
-        return res == CURLE_OK;
-    } catch (...) {
-        return false;
-    }
+    return res == CURLE_OK;
 }
 
 void HttpClient::SetLogCallback(LogCallback callback) {
@@ -250,7 +376,10 @@ HTTPParser::HTTPResponse HttpClient::ParseResponse(
 
     response.headers = headers;
 
-    response.SetContentLength(response_data.size());
+    // A 304 has no body; its Content-Length would describe the 200's
+    if (status_code != 304) {
+        response.SetContentLength(response_data.size());
+    }
 
     if (headers.find("content-type") == headers.end()) {
         std::string detected_type = DetectContentType(response_data);
@@ -4,6 +4,7 @@
 #include <map>
 #include <functional>
 #include <mutex>
+#include <vector>
 #include <mtp/ByteArray.h>
 #include "HTTPParser.h"
 
@@ -14,7 +15,11 @@
  * Shared HTTP client used by MetadataRequestHandler for proxied requests.
  *
  * Features:
- * - Thread-safe curl handle management
+ * - Concurrent requests: each PerformGET borrows an easy handle from a pool,
+ *   so the request worker threads fetch in parallel. The handles share one
+ *   DNS cache, connection cache and TLS session cache, so keep-alive
+ *   connections and resolved hosts are reused whichever worker issues the
+ *   next request.
  * - Zune server routing (catalog, image, art, mix)
  * - Response parsing with content-type detection
  * - Connectivity checks (fwlink handling)
@@ -46,15 +51,47 @@ public:
     HttpClient(const HttpClient&) = delete;
     HttpClient& operator=(const HttpClient&) = delete;
 
+    /**
+     * Receives a proxied body while it downloads, so the device can get its
+     * first segments before the upstream transfer finishes. Only successful
+     * responses with a known Content-Length are streamed; the sequence
+     * range for the whole response is reserved up front.
+     * Called on the thread running PerformGET.
+     */
+    class ResponseStream {
+    public:
+        virtual ~ResponseStream() = default;
+
+        /**
+         * Status and headers, with Content-Length set and an empty body.
+         * Return false to have this response buffered and returned instead.
+         */
+        virtual bool Begin(const HTTPParser::HTTPResponse& head, size_t content_length) = 0;
+
+        /**
+         * Next body bytes, never more than Content-Length in total.
+         * Return false to abort the download.
+         */
+        virtual bool Write(const uint8_t* data, size_t size) = 0;
+
+        /**
+         * After the last Write; complete is false if the body ended short
+         */
+        virtual void End(bool complete) = 0;
+    };
+
     /**
      * Perform HTTP GET request
      * @param url Full URL to request
      * @param headers Request headers to forward
-     * @return HTTP response
+     * @param stream Optional; when its Begin accepts the response, the body
+     *               is also handed to it as it arrives
+     * @return HTTP response (with the full body, streamed or not)
      */
     HTTPParser::HTTPResponse PerformGET(
         const std::string& url,
-        const std::map<std::string, std::string>& headers = {});
+        const std::map<std::string, std::string>& headers = {},
+        ResponseStream* stream = nullptr);
 
     /**
      * Select appropriate server based on Host header
@@ -146,11 +183,28 @@ private:
      */
     void Log(const std::string& message);
 
+    /**
+     * Idle easy handle (or a new one), reset and attached to the share;
+     * null if libcurl could not create one
+     */
+    void* AcquireHandle();
+
+    /**
+     * Return a handle to the pool, keeping at most kMaxIdleHandles
+     */
+    void ReleaseHandle(void* handle);
+
     // Configuration
     ServerConfig config_;
     LogCallback log_callback_;
 
-    // libcurl handle (reused for performance)
-    void* curl_handle_ = nullptr;  // CURL*
-    std::mutex curl_mutex_;  // Thread safety
+    // DNS, connection and TLS session caches shared by every pooled handle
+    void* share_handle_ = nullptr;  // CURLSH*
+    static constexpr int kShareLockCount = 8;  // >= CURL_LOCK_DATA_LAST
+    std::mutex share_locks_[kShareLockCount];
+
+    // Easy handles not in use; one per concurrent request at most
+    static constexpr size_t kMaxIdleHandles = 8;
+    std::vector<void*> idle_handles_;  // CURL*
+    std::mutex pool_mutex_;
 };
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "../../ZuneArtworkPipeline.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * ImageVariantCache
+ *
+ * Device-sized copies of the local JPEGs behind /image/{id} and
+ * deviceBackgroundImage. The device asks for width=480&resize=true, but the
+ * path resolver often points at a 1500px original; sending that over the
+ * PPP link costs several times what the device can show.
+ *
+ * The library has no image codec, so the scaling is the host's: the resize
+ * callback writes a JPEG of the image at the requested width. Each variant
+ * is made once, on whichever HTTP worker or prefetch thread asks first;
+ * others asking for it meanwhile wait for that result rather than resize
+ * the same image again. Variants are keyed by resource and width (see
+ * MakeKey) and tied to a tag of the source file (its ETag), so a rewritten
+ * file is resized again. Images no wider than asked for, and those the
+ * callback declines, are remembered as having no variant.
+ *
+ * Least recently used variants are dropped beyond the byte budget. Lives as
+ * long as the connection, like MetadataResponseCache. Thread-safe.
+ */
+class ImageVariantCache {
+public:
+    /// Write a JPEG of the image scaled to width pixels wide into out
+    /// (capacity bytes, the input size); return its size, or 0 to send the
+    /// original. May run on several threads at once.
+    using Resizer = std::function<size_t(const uint8_t* jpeg, size_t size, uint32_t width,
+                                         uint8_t* out, size_t capacity)>;
+    using Variant = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;        // Variant made (or found not needed) for the caller
+        uint64_t waits = 0;         // Callers that waited on another's resize
+        uint64_t resized = 0;       // Resize callback produced a smaller image
+        uint64_t kept = 0;          // Original sent: no wider than asked, or declined
+        uint64_t bytes_in = 0;      // Originals of the resized images
+        uint64_t bytes_out = 0;     // Those images after resizing
+        uint64_t evictions = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t capacity = 0;
+    };
+
+    static constexpr size_t kDefaultCapacity = 16 * 1024 * 1024;
+
+    explicit ImageVariantCache(size_t capacity_bytes = kDefaultCapacity)
+        : capacity_(capacity_bytes) {}
+
+    /// Key of resource (endpoint and id) at width
+    static std::string MakeKey(const std::string& resource, uint32_t width) {
+        return resource + "@" + std::to_string(width);
+    }
+
+    /// Replace the resize callback; empty disables resizing. Drops every
+    /// variant, as they came from the old callback.
+    void SetResizer(Resizer resizer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resizer_ = std::move(resizer);
+        generation_++;
+        ClearLocked();
+    }
+
+    bool CanResize() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<bool>(resizer_);
+    }
+
+    /// Whether key has been resolved already, for whatever source file
+    bool Contains(const std::string& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return index_.count(key) != 0;
+    }
+
+    /**
+     * The variant of jpeg (size bytes, source_tag identifying the file) at
+     * width: cached, or made now by the resize callback. Null means send
+     * jpeg as it is.
+     */
+    Variant Get(const std::string& key, const std::string& source_tag,
+                const uint8_t* jpeg, size_t size, uint32_t width) {
+        Resizer resizer;
+        uint64_t generation;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            bool waited = false;
+            for (;;) {
+                auto it = index_.find(key);
+                if (it != index_.end() && it->second->source_tag == source_tag) {
+                    lru_.splice(lru_.begin(), lru_, it->second);
+                    stats_.hits++;
+                    return it->second->variant;
+                }
+                if (!producing_.count(key)) {
+                    break;
+                }
+                if (!waited) {
+                    stats_.waits++;
+                    waited = true;
+                }
+                produced_cv_.wait(lock);
+            }
+            if (!resizer_) {
+                return nullptr;
+            }
+            resizer = resizer_;
+            generation = generation_;
+            producing_.insert(key);
+            stats_.misses++;
+        }
+
+        // Decoding and encoding run unlocked
+        Variant variant;
+        try {
+            variant = Resize(resizer, jpeg, size, width);
+        } catch (...) {
+            Abandon(key);
+            throw;
+        }
+        Finish(key, source_tag, variant, size, generation);
+        return variant;
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ClearLocked();
+    }
+
+    void SetCapacity(size_t capacity_bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity_bytes;
+        EvictLocked();
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats stats = stats_;
+        stats.entries = index_.size();
+        stats.bytes = bytes_;
+        stats.capacity = capacity_;
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::string source_tag;
+        Variant variant;  // Null: send the original
+        size_t cost;
+    };
+
+    static Variant Resize(const Resizer& resizer, const uint8_t* jpeg, size_t size, uint32_t width) {
+        uint32_t source_width = 0;
+        uint32_t source_height = 0;
+        if (!zune::ArtworkPipeline::JpegDimensions(jpeg, size, source_width, source_height) ||
+            source_width <= width) {
+            return nullptr;
+        }
+        auto out = std::make_shared<std::vector<uint8_t>>(size);
+        size_t n = resizer(jpeg, size, width, out->data(), out->size());
+        if (n == 0 || n >= size) {
+            return nullptr;
+        }
+        out->resize(n);
+        out->shrink_to_fit();
+        return out;
+    }
+
+    // Store the outcome, unless the resizer changed meanwhile, and wake the
+    // callers waiting on key
+    void Finish(const std::string& key, const std::string& source_tag, Variant variant,
+                size_t source_size, uint64_t generation) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            producing_.erase(key);
+            if (generation == generation_) {
+                if (variant) {
+                    stats_.resized++;
+                    stats_.bytes_in += source_size;
+                    stats_.bytes_out += variant->size();
+                } else {
+                    stats_.kept++;
+                }
+                StoreLocked(key, source_tag, std::move(variant));
+            }
+        }
+        produced_cv_.notify_all();
+    }
+
+    // Let a waiting caller resize key itself
+    void Abandon(const std::string& key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            producing_.erase(key);
+        }
+        produced_cv_.notify_all();
+    }
+
+    void StoreLocked(const std::string& key, const std::string& source_tag, Variant variant) {
+        size_t cost = key.size() + source_tag.size() + (variant ? variant->size() : 0);
+        // As in MetadataResponseCache, one image may not flush the rest
+        if (cost > capacity_ / 8) {
+            return;
+        }
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            bytes_ -= it->second->cost;
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        lru_.push_front(Entry{key, source_tag, std::move(variant), cost});
+        index_.emplace(key, lru_.begin());
+        bytes_ += cost;
+        EvictLocked();
+    }
+
+    void ClearLocked() {
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    void EvictLocked() {
+        while (bytes_ > capacity_ && !lru_.empty()) {
+            const Entry& victim = lru_.back();
+            bytes_ -= victim.cost;
+            index_.erase(victim.key);
+            lru_.pop_back();
+            stats_.evictions++;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable produced_cv_;  // A key left producing_
+    Resizer resizer_;
+    uint64_t generation_ = 0;  // SetResizer calls
+    size_t capacity_;
+    size_t bytes_ = 0;
+    std::list<Entry> lru_;  // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::unordered_set<std::string> producing_;  // Keys being resized now
+    Stats stats_;
+};
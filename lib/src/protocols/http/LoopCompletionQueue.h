@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/**
+ * LoopCompletionQueue
+ *
+ * Hands the results of work offloaded from the interceptor's poll thread
+ * back to it, for reactor mode (InterceptorConfig::reactor). The loop calls
+ * Begin when it offloads a request; the worker Posts the finished item;
+ * the loop Drains posted items at the start of its next cycle and sends
+ * them itself, so TCP state and frame sends stay on one thread.
+ *
+ * Outstanding counts work begun and not yet drained: while it is nonzero
+ * the loop keeps polling hot, and Ready lets it skip its wait altogether.
+ * One thread drains; any number post.
+ */
+template <typename Item>
+class LoopCompletionQueue {
+public:
+    LoopCompletionQueue() = default;
+    LoopCompletionQueue(const LoopCompletionQueue&) = delete;
+    LoopCompletionQueue& operator=(const LoopCompletionQueue&) = delete;
+
+    /// Work was offloaded; its Post is expected
+    void Begin() {
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// From the worker: the result, for the loop
+    void Post(Item item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        items_.push_back(std::move(item));
+        ready_.store(true, std::memory_order_release);
+    }
+
+    /**
+     * On the loop: run fn on every posted item, in posting order. Items
+     * posted meanwhile wait for the next Drain.
+     * @return Items run
+     */
+    template <typename Fn>
+    size_t Drain(Fn&& fn) {
+        if (!ready_.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        std::deque<Item> items;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items.swap(items_);
+            ready_.store(false, std::memory_order_relaxed);
+        }
+        for (Item& item : items) {
+            fn(item);
+            outstanding_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return items.size();
+    }
+
+    /// Posted items wait for Drain
+    bool Ready() const {
+        return ready_.load(std::memory_order_acquire);
+    }
+
+    /// Begun and not yet drained
+    size_t Outstanding() const {
+        return outstanding_.load(std::memory_order_relaxed);
+    }
+
+    /// Forget everything, once the workers have stopped
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        items_.clear();
+        ready_.store(false, std::memory_order_relaxed);
+        outstanding_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<Item> items_;
+    std::atomic<bool> ready_{false};
+    std::atomic<size_t> outstanding_{0};
+};
@@ -0,0 +1,317 @@
+#include "MetadataDiskCache.h"
+#include "../../ZuneFileStore.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using zune::BinaryReader;
+using zune::Fnv1a64;
+using zune::PutN;
+using zune::PutString;
+using zune::WriteFileAtomic;
+
+static constexpr char kIndexMagic[4] = {'X', 'M', 'D', 'C'};
+static constexpr uint32_t kIndexVersion = 1;
+static constexpr const char* kIndexName = "metadata.xmdc";
+static constexpr const char* kBlobDir = "blobs";
+
+namespace {
+
+std::string LowerCase(std::string s) {
+    for (char& c : s) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return s;
+}
+
+} // namespace
+
+MetadataDiskCache::MetadataDiskCache(std::function<int64_t()> clock)
+    : clock_(std::move(clock)) {}
+
+MetadataDiskCache::~MetadataDiskCache() {
+    Close();
+}
+
+bool MetadataDiskCache::Open(const std::string& directory, const Limits& limits) {
+    Close();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(directory) / kBlobDir, ec);
+    if (ec) return false;
+
+    directory_ = directory;
+    limits_ = limits;
+    LoadLocked();
+    DeleteOrphansLocked();
+    EvictLocked(std::string());
+    return true;
+}
+
+void MetadataDiskCache::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (directory_.empty()) return;
+    SaveLocked();
+    directory_.clear();
+    entries_.clear();
+    blobs_.clear();
+    bytes_ = 0;
+}
+
+bool MetadataDiskCache::IsOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !directory_.empty();
+}
+
+bool MetadataDiskCache::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SaveLocked();
+}
+
+std::string MetadataDiskCache::Lookup(const std::string& artist_uuid, const std::string& endpoint_type,
+                                      const std::string& resource_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = directory_.empty() ? entries_.end() : entries_.find(MakeKey(artist_uuid, endpoint_type, resource_id));
+    if (it == entries_.end()) {
+        stats_.misses++;
+        return std::string();
+    }
+
+    int64_t now = Now();
+    if (limits_.ttl.count() > 0 && now - it->second.stored_at >= limits_.ttl.count()) {
+        stats_.expired++;
+        stats_.misses++;
+        RemoveLocked(it);
+        return std::string();
+    }
+
+    std::string path = BlobPath(BlobName(it->second));
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        // Deleted behind our back: forget it, and the blob with it
+        stats_.misses++;
+        RemoveLocked(it);
+        return std::string();
+    }
+
+    // Saved with the next store; a lost last-served time only ages the entry
+    it->second.used_at = now;
+    stats_.hits++;
+    return path;
+}
+
+bool MetadataDiskCache::Store(const std::string& artist_uuid, const std::string& endpoint_type,
+                              const std::string& resource_id, const uint8_t* data, size_t size,
+                              const std::string& content_type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (directory_.empty() || size == 0 ||
+        (limits_.max_bytes != 0 && size > limits_.max_bytes)) {
+        return false;
+    }
+
+    Entry entry;
+    entry.hash = Fnv1a64(data, size);
+    entry.size = size;
+    entry.extension = ExtensionFor(content_type);
+    entry.stored_at = entry.used_at = Now();
+
+    std::string name = BlobName(entry);
+    if (blobs_.find(name) == blobs_.end()) {
+        if (!WriteFileAtomic(BlobPath(name), data, size)) {
+            return false;
+        }
+    }
+
+    std::string key = MakeKey(artist_uuid, endpoint_type, resource_id);
+    auto it = entries_.find(key);
+    if (it != entries_.end() && BlobName(it->second) == name) {
+        // Same body again: only the dates change
+        it->second.stored_at = it->second.used_at = entry.stored_at;
+    } else {
+        // Reference the new blob before the old one can be deleted under it
+        AddRefLocked(entry);
+        if (it != entries_.end()) {
+            RemoveLocked(it);
+        }
+        entries_[key] = std::move(entry);
+    }
+    stats_.stores++;
+    unsaved_++;
+
+    EvictLocked(key);
+    if (unsaved_ >= kSaveEvery) {
+        SaveLocked();
+    }
+    return true;
+}
+
+void MetadataDiskCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (directory_.empty()) return;
+    for (const auto& [name, blob] : blobs_) {
+        std::remove(BlobPath(name).c_str());
+    }
+    entries_.clear();
+    blobs_.clear();
+    bytes_ = 0;
+    unsaved_++;
+    SaveLocked();
+}
+
+MetadataDiskCache::Stats MetadataDiskCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.entries = entries_.size();
+    stats.blobs = blobs_.size();
+    stats.bytes = bytes_;
+    stats.capacity = limits_.max_bytes;
+    return stats;
+}
+
+std::string MetadataDiskCache::MakeKey(const std::string& artist_uuid, const std::string& endpoint_type,
+                                       const std::string& resource_id) {
+    return LowerCase(artist_uuid) + '\n' + endpoint_type + '\n' + LowerCase(resource_id);
+}
+
+std::string MetadataDiskCache::ExtensionFor(const std::string& content_type) {
+    std::string type = LowerCase(content_type.substr(0, content_type.find(';')));
+    if (type == "image/jpeg" || type == "image/jpg") return "jpg";
+    if (type == "image/png") return "png";
+    if (type == "image/gif") return "gif";
+    if (type == "image/webp") return "webp";
+    if (type.find("xml") != std::string::npos) return "xml";
+    return "bin";
+}
+
+std::string MetadataDiskCache::BlobName(const Entry& entry) {
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%llx.", static_cast<unsigned long long>(entry.hash),
+             static_cast<unsigned long long>(entry.size));
+    return name + entry.extension;
+}
+
+std::string MetadataDiskCache::BlobPath(const std::string& name) const {
+    return (std::filesystem::path(directory_) / kBlobDir / name).string();
+}
+
+int64_t MetadataDiskCache::Now() const {
+    if (clock_) return clock_();
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void MetadataDiskCache::LoadLocked() {
+    entries_.clear();
+    blobs_.clear();
+    bytes_ = 0;
+    unsaved_ = 0;
+
+    std::string path = (std::filesystem::path(directory_) / kIndexName).string();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    BinaryReader reader{data};
+    const uint8_t* magic = reader.Take(sizeof(kIndexMagic));
+    if (!magic || !std::equal(magic, magic + sizeof(kIndexMagic), kIndexMagic) ||
+        reader.Get(4) != kIndexVersion) {
+        return;
+    }
+    uint32_t count = static_cast<uint32_t>(reader.Get(4));
+    for (uint32_t i = 0; i < count && reader.ok; i++) {
+        std::string key = reader.GetString(2);
+        Entry entry;
+        entry.hash = reader.Get(8);
+        entry.size = reader.Get(8);
+        entry.extension = reader.GetString(1);
+        entry.stored_at = static_cast<int64_t>(reader.Get(8));
+        entry.used_at = static_cast<int64_t>(reader.Get(8));
+        if (reader.ok && entries_.emplace(key, entry).second) {
+            AddRefLocked(entry);
+        }
+    }
+    if (!reader.ok) {
+        // Truncated: keep what parsed, and write it back whole
+        unsaved_++;
+    }
+}
+
+bool MetadataDiskCache::SaveLocked() {
+    if (unsaved_ == 0 || directory_.empty()) return true;
+
+    std::vector<uint8_t> out;
+    out.reserve(12 + entries_.size() * 128);
+    out.insert(out.end(), kIndexMagic, kIndexMagic + sizeof(kIndexMagic));
+    PutN(out, kIndexVersion, 4);
+    PutN(out, entries_.size(), 4);
+    for (const auto& [key, entry] : entries_) {
+        PutString(out, key, 2);
+        PutN(out, entry.hash, 8);
+        PutN(out, entry.size, 8);
+        PutString(out, entry.extension, 1);
+        PutN(out, static_cast<uint64_t>(entry.stored_at), 8);
+        PutN(out, static_cast<uint64_t>(entry.used_at), 8);
+    }
+
+    if (!WriteFileAtomic((std::filesystem::path(directory_) / kIndexName).string(), out.data(), out.size())) {
+        return false;
+    }
+    unsaved_ = 0;
+    return true;
+}
+
+void MetadataDiskCache::AddRefLocked(const Entry& entry) {
+    Blob& blob = blobs_[BlobName(entry)];
+    if (blob.refs++ == 0) {
+        blob.size = entry.size;
+        bytes_ += entry.size;
+    }
+}
+
+void MetadataDiskCache::RemoveLocked(std::unordered_map<std::string, Entry>::iterator it) {
+    std::string name = BlobName(it->second);
+    entries_.erase(it);
+    unsaved_++;
+
+    auto blob = blobs_.find(name);
+    if (blob != blobs_.end() && --blob->second.refs == 0) {
+        // A response still mapping it keeps its pages (or, on Windows, the file)
+        std::remove(BlobPath(name).c_str());
+        bytes_ -= blob->second.size;
+        blobs_.erase(blob);
+    }
+}
+
+void MetadataDiskCache::EvictLocked(const std::string& keep) {
+    while (limits_.max_bytes != 0 && bytes_ > limits_.max_bytes) {
+        auto oldest = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->first != keep && (oldest == entries_.end() || it->second.used_at < oldest->second.used_at)) {
+                oldest = it;
+            }
+        }
+        if (oldest == entries_.end()) {
+            return;
+        }
+        stats_.evictions++;
+        RemoveLocked(oldest);
+    }
+}
+
+void MetadataDiskCache::DeleteOrphansLocked() {
+    std::error_code ec;
+    std::vector<std::filesystem::path> orphans;
+    for (std::filesystem::directory_iterator it(std::filesystem::path(directory_) / kBlobDir, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (blobs_.find(it->path().filename().string()) == blobs_.end()) {
+            orphans.push_back(it->path());
+        }
+    }
+    for (const auto& path : orphans) {
+        std::filesystem::remove(path, ec);
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * MetadataDiskCache
+ *
+ * Native on-disk store of artist metadata for Static and Hybrid modes,
+ * used in place of the host's path resolver and cache storage callbacks
+ * when those are not registered. A lookup is a map find and one stat on
+ * the HTTP worker, with no call into managed code and no ad-hoc path
+ * probing.
+ *
+ * Bodies are stored content-addressed under blobs/, named by a hash of
+ * their bytes and their size, so one image listed under several artists
+ * or ids is kept once. A compact index maps (artist UUID, endpoint type,
+ * resource id) to a blob, with when it was stored and last served.
+ * Entries older than the TTL are expired on lookup; past the byte budget
+ * the least recently served are evicted, and a blob no entry names any
+ * more is deleted.
+ *
+ * Index layout (little-endian): "XMDC" magic, u32 format version, u32
+ * entry count, then entries of u16 key length and key, u64 content hash,
+ * u64 size, u8 extension length and extension, i64 stored and i64 last
+ * served (Unix seconds). Saved every kSaveEvery stores and on Close, with
+ * temp file + rename; blobs the index does not name (a store cut off
+ * before the save) are deleted on Open.
+ *
+ * Thread-safe: the HTTP workers, prefetch and write-behind threads share it.
+ */
+class MetadataDiskCache {
+public:
+    struct Limits {
+        uint64_t max_bytes = 256ull * 1024 * 1024;  // Blob bytes kept; 0 = unbounded
+        std::chrono::seconds ttl{30 * 24 * 3600};   // Age at which an entry expires; 0 = never
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t expired = 0;     // Entries dropped on lookup for their age
+        uint64_t evictions = 0;   // Entries dropped to stay within max_bytes
+        uint64_t entries = 0;
+        uint64_t blobs = 0;       // Distinct bodies on disk
+        uint64_t bytes = 0;       // Their total size
+        uint64_t capacity = 0;
+    };
+
+    static constexpr size_t kSaveEvery = 16;
+
+    /// @param clock Unix seconds; the system clock if empty
+    explicit MetadataDiskCache(std::function<int64_t()> clock = nullptr);
+    ~MetadataDiskCache();
+
+    MetadataDiskCache(const MetadataDiskCache&) = delete;
+    MetadataDiskCache& operator=(const MetadataDiskCache&) = delete;
+
+    /// Bind to directory, loading its index. Closes any previous binding.
+    /// @return false if the directory cannot be created
+    bool Open(const std::string& directory, const Limits& limits);
+    /// Save the index and unbind
+    void Close();
+    bool IsOpen() const;
+    bool Save();
+
+    /// Path of the stored body, empty if none (or expired, or its blob is gone)
+    std::string Lookup(const std::string& artist_uuid, const std::string& endpoint_type,
+                       const std::string& resource_id);
+
+    /// Store a body, replacing what the key held; the extension of its blob
+    /// follows content_type, as the handler sends blobs by extension
+    bool Store(const std::string& artist_uuid, const std::string& endpoint_type,
+               const std::string& resource_id, const uint8_t* data, size_t size,
+               const std::string& content_type);
+
+    /// Delete every entry and blob
+    void Clear();
+
+    Stats GetStats() const;
+
+    /// "artist\nendpoint\nresource", the UUIDs lower-cased
+    static std::string MakeKey(const std::string& artist_uuid, const std::string& endpoint_type,
+                               const std::string& resource_id);
+    /// Blob extension for a Content-Type
+    static std::string ExtensionFor(const std::string& content_type);
+
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        uint64_t size = 0;
+        std::string extension;
+        int64_t stored_at = 0;
+        int64_t used_at = 0;
+    };
+
+    struct Blob {
+        uint64_t size = 0;
+        uint32_t refs = 0;
+    };
+
+    static std::string BlobName(const Entry& entry);
+    std::string BlobPath(const std::string& name) const;
+    int64_t Now() const;
+
+    void LoadLocked();
+    bool SaveLocked();
+    void AddRefLocked(const Entry& entry);
+    void RemoveLocked(std::unordered_map<std::string, Entry>::iterator it);
+    void EvictLocked(const std::string& keep);
+    void DeleteOrphansLocked();
+
+    std::function<int64_t()> clock_;
+    mutable std::mutex mutex_;
+    std::string directory_;
+    Limits limits_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_map<std::string, Blob> blobs_;  // By blob name
+    uint64_t bytes_ = 0;
+    size_t unsaved_ = 0;  // Changes since the last save
+    Stats stats_;
+};
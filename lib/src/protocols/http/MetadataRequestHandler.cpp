@@ -5,11 +5,18 @@
 #include <sstream>
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
 #include <sys/stat.h>
 #include <functional>
+#include <regex>
 
 #include "../../platform_compat.h"
+#include "../../ZuneLog.h"
+
+#define HANDLER_LOG(category, level, message) \
+    ZUNE_LOG(logger_, "MetadataRequestHandler", category, level, message)
 
 const char* EndpointTypeToString(EndpointType type) {
     switch (type) {
@@ -30,10 +37,62 @@ bool IsImageEndpoint(EndpointType type) {
     return type == EndpointType::Artwork || type == EndpointType::DeviceBackgroundImage;
 }
 
+static std::string LowerCase(std::string s) {
+    for (char& c : s) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return s;
+}
+
+// Set name to value, dropping any copy of it in another case (upstream
+// header names arrive lower-cased)
+static void ReplaceHeader(HTTPParser::HTTPResponse& response, const std::string& name, const std::string& value) {
+    std::string lower_name = LowerCase(name);
+    for (auto it = response.headers.begin(); it != response.headers.end();) {
+        it = LowerCase(it->first) == lower_name ? response.headers.erase(it) : std::next(it);
+    }
+    response.headers[name] = value;
+}
+
+// Validators for a proxied body that came without them: an ETag from its
+// bytes and, as RFC 7232 suggests, its Date for Last-Modified
+static void AddBodyValidators(HTTPParser::HTTPResponse& response) {
+    if (response.GetHeader("ETag").empty()) {
+        response.headers["ETag"] = HTTPParser::MakeETag(response.BodyData(), response.BodySize());
+    }
+    if (response.GetHeader("Last-Modified").empty()) {
+        std::string date = response.GetHeader("Date");
+        int64_t seconds = 0;
+        if (!HTTPParser::ParseHTTPDate(date, seconds)) {
+            seconds = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        response.headers["Last-Modified"] = HTTPParser::FormatHTTPDate(seconds);
+    }
+}
+
+// How long a proxied copy may be used without asking upstream: its max-age,
+// none under no-cache, else the default
+static std::chrono::seconds FreshnessLifetime(const HTTPParser::HTTPResponse& response,
+                                              std::chrono::seconds fallback) {
+    std::string cache_control = LowerCase(response.GetHeader("Cache-Control"));
+    if (cache_control.find("no-cache") != std::string::npos ||
+        cache_control.find("no-store") != std::string::npos) {
+        return std::chrono::seconds(0);
+    }
+    size_t pos = cache_control.find("max-age=");
+    if (pos != std::string::npos) {
+        return std::chrono::seconds(std::strtoll(cache_control.c_str() + pos + 8, nullptr, 10));
+    }
+    return fallback;
+}
+
 MetadataRequestHandler::MetadataRequestHandler(
     InterceptionMode mode,
     const ProxyModeConfig& proxy_config)
     : mode_(mode)
+    , cache_writes_(CacheWriteQueue::Limits{proxy_config.cache_write_queue_depth,
+                                            proxy_config.cache_write_queue_bytes})
 {
     if (mode != InterceptionMode::Static) {
         HttpClient::ServerConfig config;
@@ -47,16 +106,26 @@ MetadataRequestHandler::MetadataRequestHandler(
     }
 }
 
-MetadataRequestHandler::~MetadataRequestHandler() = default;
+MetadataRequestHandler::~MetadataRequestHandler() {
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        prefetch_stop_ = true;
+    }
+    prefetch_cv_.notify_all();
+    if (prefetch_thread_.joinable()) {
+        prefetch_thread_.join();
+    }
+}
 
-HTTPParser::HTTPResponse MetadataRequestHandler::HandleRequest(const HTTPParser::HTTPRequest& request) {
+HTTPParser::HTTPResponse MetadataRequestHandler::HandleRequest(const HTTPParser::HTTPRequest& request,
+                                                               HttpClient::ResponseStream* stream) {
     if (HttpClient::IsConnectivityCheck(request.path)) {
-        Log("Connectivity check: " + request.method + " " + request.path + " -> returning 200 OK");
+        HANDLER_LOG(HTTP, INFO, "Connectivity check: " + request.method + " " + request.path + " -> returning 200 OK");
         return HttpClient::BuildConnectivityResponse();
     }
 
     if (request.method != "GET") {
-        Log("Warning: Unsupported HTTP method: " + request.method);
+        HANDLER_LOG(HTTP, WARNING, "Warning: Unsupported HTTP method: " + request.method);
         return HTTPParser::BuildErrorResponse(405, "Method not allowed");
     }
 
@@ -64,32 +133,248 @@ HTTPParser::HTTPResponse MetadataRequestHandler::HandleRequest(const HTTPParser:
     auto endpoint_type = DetermineEndpointType(request.path);
     std::string resource_id = HTTPParser::ExtractImageUUID(request.path);
 
+    // Answered here, so it may be a 304: decided once the body is known
+    if (KeepsResponses() && HTTPParser::IsConditional(request)) {
+        stream = nullptr;
+    }
+
+    std::string cache_key;
+    if (response_cache_) {
+        LearnRequestTemplate(request, endpoint_type, artist_uuid, resource_id);
+        if (!artist_uuid.empty()) {
+            SchedulePrefetch(request, endpoint_type, artist_uuid);
+        }
+
+        cache_key = MetadataResponseCache::MakeKey(request.GetHeader("Host"), request.path, request.query_params);
+        HTTPParser::HTTPResponse cached;
+        MetadataResponseCache::Freshness freshness;
+        if (response_cache_->Lookup(cache_key, cached, &freshness)) {
+            if (freshness.upstream && http_client_ &&
+                freshness.age >= FreshnessLifetime(cached, kDefaultFreshness)) {
+                cached = Revalidate(request, cache_key, cached);
+            }
+            cached.headers["Date"] = GetCurrentHttpDate();
+            HANDLER_LOG(HTTP, INFO, "Served from memory cache: " + request.path);
+            return AnswerConditional(request, std::move(cached));
+        }
+    }
+
+    bool from_upstream = false;
+    auto response = ResolveRequest(request, artist_uuid, endpoint_type, resource_id, stream, from_upstream);
+
+    // Misses and errors are not kept: the file may appear or the server recover
+    if (response_cache_ && response.status_code >= 200 && response.status_code < 300) {
+        response_cache_->Insert(cache_key, response, false, from_upstream);
+    }
+    return AnswerConditional(request, std::move(response));
+}
+
+bool MetadataRequestHandler::HandleFromMemory(const HTTPParser::HTTPRequest& request,
+                                              HTTPParser::HTTPResponse& response) {
+    if (HttpClient::IsConnectivityCheck(request.path) || request.method != "GET") {
+        response = HandleRequest(request);
+        return true;
+    }
+    if (!response_cache_) {
+        return false;
+    }
+
+    // Contains first, so a miss is counted once, by HandleRequest
+    std::string cache_key = MetadataResponseCache::MakeKey(request.GetHeader("Host"), request.path,
+                                                           request.query_params);
+    HTTPParser::HTTPResponse cached;
+    MetadataResponseCache::Freshness freshness;
+    if (!response_cache_->Contains(cache_key) || !response_cache_->Lookup(cache_key, cached, &freshness)) {
+        return false;
+    }
+    if (freshness.upstream && http_client_ &&
+        freshness.age >= FreshnessLifetime(cached, kDefaultFreshness)) {
+        return false;  // Revalidated upstream by HandleRequest
+    }
+
+    std::string artist_uuid = HTTPParser::ExtractArtistUUID(request.path);
+    auto endpoint_type = DetermineEndpointType(request.path);
+    LearnRequestTemplate(request, endpoint_type, artist_uuid, HTTPParser::ExtractImageUUID(request.path));
+    if (!artist_uuid.empty()) {
+        SchedulePrefetch(request, endpoint_type, artist_uuid);
+    }
+
+    cached.headers["Date"] = GetCurrentHttpDate();
+    HANDLER_LOG(HTTP, INFO, "Served from memory cache: " + request.path);
+    response = AnswerConditional(request, std::move(cached));
+    return true;
+}
+
+HTTPParser::HTTPResponse MetadataRequestHandler::AnswerConditional(
+    const HTTPParser::HTTPRequest& request,
+    HTTPParser::HTTPResponse response) {
+
+    if (!HTTPParser::IsConditional(request) || !HTTPParser::IsNotModified(request, response)) {
+        return response;
+    }
+    HANDLER_LOG(HTTP, INFO, "Not modified: " + request.path);
+    return HTTPParser::BuildNotModifiedResponse(response);
+}
+
+HTTPParser::HTTPResponse MetadataRequestHandler::Revalidate(
+    const HTTPParser::HTTPRequest& request,
+    const std::string& cache_key,
+    const HTTPParser::HTTPResponse& cached) {
+
+    std::string server = http_client_->SelectServer(request.GetHeader("Host"));
+    if (server.empty()) {
+        return cached;
+    }
+
+    std::map<std::string, std::string> headers = UpstreamHeaders(request);
+    std::string etag = cached.GetHeader("ETag");
+    std::string last_modified = cached.GetHeader("Last-Modified");
+    if (!etag.empty()) {
+        headers["If-None-Match"] = etag;
+    }
+    if (!last_modified.empty()) {
+        headers["If-Modified-Since"] = last_modified;
+    }
+
+    auto response = http_client_->PerformGET(HttpClient::BuildURL(server, request.path, request.query_params),
+                                             headers);
+    if (response.status_code == 304) {
+        // Still current: keep the body, take the new caching headers (RFC 7234 4.3.4)
+        HTTPParser::HTTPResponse updated = cached;
+        for (const char* name : {"Cache-Control", "Expires", "ETag", "Last-Modified", "Date"}) {
+            std::string value = response.GetHeader(name);
+            if (!value.empty()) {
+                ReplaceHeader(updated, name, value);
+            }
+        }
+        response_cache_->Insert(cache_key, updated, false, true);
+        HANDLER_LOG(HTTP, INFO, "Revalidated, not modified upstream: " + request.path);
+        return updated;
+    }
+    if (response.status_code >= 200 && response.status_code < 300) {
+        AddBodyValidators(response);
+        response_cache_->Insert(cache_key, response, false, true);
+        HANDLER_LOG(HTTP, INFO, "Revalidated, changed upstream: " + request.path);
+        return response;
+    }
+
+    HANDLER_LOG(HTTP, WARNING, "Revalidation got HTTP " + std::to_string(response.status_code) +
+        ", serving the stored copy: " + request.path);
+    return cached;
+}
+
+std::map<std::string, std::string> MetadataRequestHandler::UpstreamHeaders(
+    const HTTPParser::HTTPRequest& request) const {
+    if (!KeepsResponses()) {
+        return request.headers;
+    }
+    std::map<std::string, std::string> headers;
+    for (const auto& [name, value] : request.headers) {
+        std::string lower_name = LowerCase(name);
+        if (lower_name != "if-none-match" && lower_name != "if-modified-since") {
+            headers.emplace(name, value);
+        }
+    }
+    return headers;
+}
+
+bool MetadataRequestHandler::IsFastRequest(const HTTPParser::HTTPRequest& request) const {
+    if (request.method != "GET" || HttpClient::IsConnectivityCheck(request.path)) {
+        return true;
+    }
+    if (response_cache_ &&
+        response_cache_->Contains(MetadataResponseCache::MakeKey(
+            request.GetHeader("Host"), request.path, request.query_params))) {
+        return true;
+    }
+    // Decoding and encoding a JPEG holds a worker about as long as a fetch
+    if (NeedsResize(request)) {
+        return false;
+    }
+    return mode_ == InterceptionMode::Static ||
+           DetermineEndpointType(request.path) == EndpointType::Biography;
+}
+
+uint32_t MetadataRequestHandler::RequestedWidth(const HTTPParser::HTTPRequest& request,
+                                                EndpointType endpoint_type) {
+    if (!IsImageEndpoint(endpoint_type) || LowerCase(request.GetQueryParam("resize")) != "true") {
+        return 0;
+    }
+    unsigned long width = std::strtoul(request.GetQueryParam("width").c_str(), nullptr, 10);
+    return width <= UINT32_MAX ? static_cast<uint32_t>(width) : 0;
+}
+
+std::string MetadataRequestHandler::VariantKey(
+    EndpointType endpoint_type,
+    const std::string& artist_uuid,
+    const std::string& resource_id,
+    uint32_t width) {
+    // Artwork is named by its image id, the background by its artist
+    const std::string& id = endpoint_type == EndpointType::Artwork ? resource_id : artist_uuid;
+    return ImageVariantCache::MakeKey(std::string(EndpointTypeToString(endpoint_type)) + "/" + LowerCase(id),
+                                      width);
+}
+
+bool MetadataRequestHandler::NeedsResize(const HTTPParser::HTTPRequest& request) const {
+    if (!image_variants_ || !ResolvesLocally() || mode_ == InterceptionMode::Proxy) {
+        return false;
+    }
+    EndpointType endpoint_type = DetermineEndpointType(request.path);
+    uint32_t width = RequestedWidth(request, endpoint_type);
+    if (width == 0 || !image_variants_->CanResize()) {
+        return false;
+    }
+    return !image_variants_->Contains(VariantKey(endpoint_type, HTTPParser::ExtractArtistUUID(request.path),
+                                                 HTTPParser::ExtractImageUUID(request.path), width));
+}
+
+HTTPParser::HTTPResponse MetadataRequestHandler::ResolveRequest(
+    const HTTPParser::HTTPRequest& request,
+    const std::string& artist_uuid,
+    EndpointType endpoint_type,
+    const std::string& resource_id,
+    HttpClient::ResponseStream* stream,
+    bool& from_upstream) {
+
     std::string full_url;
     std::string server;
     if (http_client_) {
         std::string host = request.GetHeader("Host");
         server = http_client_->SelectServer(host);
         if (server.empty()) {
-            Log("Error: No proxy server configured for host: " + host);
+            HANDLER_LOG(HTTP, ERROR, "Error: No proxy server configured for host: " + host);
             return HTTPParser::BuildErrorResponse(502, "No proxy server configured");
         }
         full_url = HttpClient::BuildURL(server, request.path, request.query_params);
-        Log(std::string(mode_ == InterceptionMode::Proxy ? "Proxy" : "Hybrid") +
+        HANDLER_LOG(HTTP, INFO, std::string(mode_ == InterceptionMode::Proxy ? "Proxy" : "Hybrid") +
             " mode: " + request.method + " " + full_url);
     } else {
-        Log("Static mode: " + request.method + " " + request.path);
+        HANDLER_LOG(HTTP, INFO, "Static mode: " + request.method + " " + request.path);
     }
 
+    HTTPParser::HTTPResponse response;
+    from_upstream = false;
     switch (mode_) {
         case InterceptionMode::Static:
-            return HandleStatic(artist_uuid, endpoint_type, resource_id);
+            response = HandleStatic(artist_uuid, endpoint_type, resource_id,
+                                    RequestedWidth(request, endpoint_type));
+            break;
         case InterceptionMode::Proxy:
-            return HandleProxy(request, full_url, artist_uuid, endpoint_type, resource_id);
+            response = HandleProxy(request, full_url, artist_uuid, endpoint_type, resource_id, stream);
+            from_upstream = true;
+            break;
         case InterceptionMode::Hybrid:
-            return HandleHybrid(request, full_url, server, artist_uuid, endpoint_type, resource_id);
+            response = HandleHybrid(request, full_url, server, artist_uuid, endpoint_type, resource_id, stream,
+                                    from_upstream);
+            break;
         default:
             return HTTPParser::BuildErrorResponse(503, "Service not configured");
     }
+
+    if (from_upstream && response.status_code >= 200 && response.status_code < 300) {
+        AddBodyValidators(response);
+    }
+    return response;
 }
 
 // ── Static Mode ──────────────────────────────────────────────────────────
@@ -97,10 +382,11 @@ HTTPParser::HTTPResponse MetadataRequestHandler::HandleRequest(const HTTPParser:
 HTTPParser::HTTPResponse MetadataRequestHandler::HandleStatic(
     const std::string& artist_uuid,
     EndpointType endpoint_type,
-    const std::string& resource_id) {
+    const std::string& resource_id,
+    uint32_t width) {
 
-    if (!path_resolver_callback_) {
-        Log("Static mode: no path resolver callback registered");
+    if (!ResolvesLocally()) {
+        HANDLER_LOG(HTTP, INFO, "Static mode: no path resolver callback or disk cache");
         return HTTPParser::BuildErrorResponse(503, "Path resolver not configured");
     }
 
@@ -108,12 +394,12 @@ HTTPParser::HTTPResponse MetadataRequestHandler::HandleStatic(
         return HTTPParser::BuildErrorResponse(400, "No artist UUID or resource ID in request");
     }
 
-    auto response = TryServeFromLocal(artist_uuid, endpoint_type, resource_id);
+    auto response = TryServeFromLocal(artist_uuid, endpoint_type, resource_id, width);
     if (response.status_code != 0) {
         return response;
     }
 
-    Log("Static mode: file not found locally, returning 404");
+    HANDLER_LOG(HTTP, INFO, "Static mode: file not found locally, returning 404");
     return HTTPParser::BuildErrorResponse(404, "Not found");
 }
 
@@ -124,13 +410,14 @@ HTTPParser::HTTPResponse MetadataRequestHandler::HandleProxy(
     const std::string& full_url,
     const std::string& artist_uuid,
     EndpointType endpoint_type,
-    const std::string& resource_id) {
+    const std::string& resource_id,
+    HttpClient::ResponseStream* stream) {
 
-    auto response = http_client_->PerformGET(full_url, request.headers);
+    auto response = http_client_->PerformGET(full_url, UpstreamHeaders(request), stream);
 
-    if (cache_storage_callback_ && response.status_code >= 200 && response.status_code < 300
+    if (StoresLocally() && response.status_code >= 200 && response.status_code < 300
         && (!artist_uuid.empty() || !resource_id.empty())) {
-        CacheResponse(artist_uuid, endpoint_type, resource_id, response);
+        QueueCacheResponse(artist_uuid, endpoint_type, resource_id, response);
     }
 
     return response;
@@ -144,51 +431,267 @@ HTTPParser::HTTPResponse MetadataRequestHandler::HandleHybrid(
     const std::string& server,
     const std::string& artist_uuid,
     EndpointType endpoint_type,
-    const std::string& resource_id) {
+    const std::string& resource_id,
+    HttpClient::ResponseStream* stream,
+    bool& from_upstream) {
 
-    if (path_resolver_callback_ && (!artist_uuid.empty() || !resource_id.empty())) {
-        auto local_response = TryServeFromLocal(artist_uuid, endpoint_type, resource_id);
+    uint32_t width = RequestedWidth(request, endpoint_type);
+    if (ResolvesLocally() && (!artist_uuid.empty() || !resource_id.empty())) {
+        auto local_response = TryServeFromLocal(artist_uuid, endpoint_type, resource_id, width);
         if (local_response.status_code != 0) {
-            Log("Served from local cache");
+            HANDLER_LOG(HTTP, INFO, "Served from local cache");
             return local_response;
         }
     }
 
     bool is_image = IsImageEndpoint(endpoint_type);
-    bool can_cache = cache_storage_callback_ && (!artist_uuid.empty() || !resource_id.empty());
+    bool can_cache = StoresLocally() && (!artist_uuid.empty() || !resource_id.empty());
 
-    if (is_image && can_cache && path_resolver_callback_) {
+    if (is_image && can_cache && ResolvesLocally()) {
         // Fetch full resolution for caching, serve device-sized to device
         std::map<std::string, std::string> full_res_params;
         full_res_params["full"] = "true";
         std::string full_res_url = HttpClient::BuildURL(server, request.path, full_res_params);
 
-        Log("Fetching full-resolution for caching: " + full_res_url);
-        auto proxy_response = http_client_->PerformGET(full_res_url, request.headers);
+        HANDLER_LOG(HTTP, INFO, "Fetching full-resolution for caching: " + full_res_url);
+        auto proxy_response = http_client_->PerformGET(full_res_url, UpstreamHeaders(request));
 
+        // Written synchronously: the device-sized copy is read back from it
         if (proxy_response.status_code >= 200 && proxy_response.status_code < 300) {
             CacheResponse(artist_uuid, endpoint_type, resource_id, proxy_response);
 
-            auto local_response = TryServeFromLocal(artist_uuid, endpoint_type, resource_id);
+            auto local_response = TryServeFromLocal(artist_uuid, endpoint_type, resource_id, width);
             if (local_response.status_code != 0) {
-                Log("Serving device-sized version after full-res cache");
+                HANDLER_LOG(HTTP, INFO, "Serving device-sized version after full-res cache");
                 return local_response;
             }
         }
 
+        from_upstream = true;
         return proxy_response;
     }
 
-    Log("No local file, proxying to server");
-    auto proxy_response = http_client_->PerformGET(full_url, request.headers);
+    // The full-resolution path above is not streamed: the device gets the
+    // locally resized copy, which only exists once the download is cached
+    HANDLER_LOG(HTTP, INFO, "No local file, proxying to server");
+    auto proxy_response = http_client_->PerformGET(full_url, UpstreamHeaders(request), stream);
+    from_upstream = true;
 
     if (can_cache && proxy_response.status_code >= 200 && proxy_response.status_code < 300) {
-        CacheResponse(artist_uuid, endpoint_type, resource_id, proxy_response);
+        QueueCacheResponse(artist_uuid, endpoint_type, resource_id, proxy_response);
     }
 
     return proxy_response;
 }
 
+// ── Prefetch ─────────────────────────────────────────────────────────────
+//
+// After /music/artist/{uuid}/biography the device asks for /images, then
+// /deviceBackgroundImage, then several /image/{id} from the images feed,
+// one at a time. The prefetch thread resolves the same list as soon as the
+// artist is first seen, so those requests are answered from the cache.
+
+void MetadataRequestHandler::LearnRequestTemplate(
+    const HTTPParser::HTTPRequest& request,
+    EndpointType endpoint_type,
+    const std::string& artist_uuid,
+    const std::string& resource_id) {
+
+    const std::string* id = nullptr;
+    switch (endpoint_type) {
+        case EndpointType::Biography:
+        case EndpointType::Images:
+        case EndpointType::DeviceBackgroundImage:
+            id = &artist_uuid;
+            break;
+        case EndpointType::Artwork:
+            id = &resource_id;
+            break;
+        default:
+            return;
+    }
+    size_t pos = id->empty() ? std::string::npos : request.path.find(*id);
+    if (pos == std::string::npos) {
+        return;
+    }
+
+    RequestTemplate tmpl;
+    tmpl.host = request.GetHeader("Host");
+    tmpl.path = request.path;
+    tmpl.path.replace(pos, id->size(), "{id}");
+    tmpl.query_params = request.query_params;
+
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    prefetch_templates_[endpoint_type] = std::move(tmpl);
+}
+
+void MetadataRequestHandler::SchedulePrefetch(
+    const HTTPParser::HTTPRequest& request,
+    EndpointType endpoint_type,
+    const std::string& artist_uuid) {
+    if (response_cache_->GetStats().capacity == 0) {
+        return;
+    }
+
+    std::string seen_key = LowerCase(artist_uuid);
+
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        if (prefetch_stop_ || !prefetch_seen_.insert(seen_key).second) {
+            return;
+        }
+        if (prefetch_seen_.size() > kMaxPrefetchSeen) {
+            prefetch_seen_.clear();
+            prefetch_seen_.insert(seen_key);
+        }
+
+        // Until the device has sent one of each, use the URLs it sends
+        // (HTTPParser.h) under the locale prefix of this request
+        std::string host = request.GetHeader("Host");
+        size_t artist_pos = request.path.find("/music/artist/");
+        std::string prefix = artist_pos != std::string::npos ? request.path.substr(0, artist_pos) : "/v3.0/en-US";
+        std::map<std::string, std::string> resized{
+            {"width", "480"}, {"resize", "true"}, {"contenttype", "image/jpeg"}};
+        prefetch_templates_.try_emplace(EndpointType::Biography,
+            RequestTemplate{host, prefix + "/music/artist/{id}/biography", {}});
+        prefetch_templates_.try_emplace(EndpointType::Images,
+            RequestTemplate{host, prefix + "/music/artist/{id}/images", {{"chunkSize", "10"}}});
+        prefetch_templates_.try_emplace(EndpointType::DeviceBackgroundImage,
+            RequestTemplate{host, prefix + "/music/artist/{id}/deviceBackgroundImage", resized});
+        prefetch_templates_.try_emplace(EndpointType::Artwork,
+            RequestTemplate{"image.catalog.zune.net", prefix + "/image/{id}", resized});
+
+        // Newest first: the artist on screen now matters more than the
+        // ones scrolled past
+        prefetch_queue_.push_back(PrefetchJob{artist_uuid, request.headers, endpoint_type});
+        if (prefetch_queue_.size() > kMaxPrefetchQueue) {
+            prefetch_queue_.pop_front();
+        }
+        if (!prefetch_thread_.joinable()) {
+            prefetch_thread_ = std::thread(&MetadataRequestHandler::PrefetchThread, this);
+        }
+    }
+    prefetch_cv_.notify_one();
+}
+
+void MetadataRequestHandler::PrefetchThread() {
+    while (true) {
+        PrefetchJob job;
+        {
+            std::unique_lock<std::mutex> lock(prefetch_mutex_);
+            prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+            if (prefetch_stop_) {
+                return;
+            }
+            job = std::move(prefetch_queue_.back());
+            prefetch_queue_.pop_back();
+        }
+        PrefetchArtist(job);
+    }
+}
+
+void MetadataRequestHandler::PrefetchArtist(const PrefetchJob& job) {
+    HANDLER_LOG(HTTP, INFO, "Prefetching artist " + job.artist_uuid);
+    int fetched = 0;
+    HTTPParser::HTTPResponse response;
+
+    if (job.requested != EndpointType::Biography &&
+        PrefetchResource(EndpointType::Biography, job.artist_uuid, job.headers, response)) {
+        fetched++;
+    }
+
+    // The images feed is fetched even when it is what the device asked
+    // for: its image list is needed here
+    std::vector<std::string> image_ids;
+    if (!prefetch_stop_ && PrefetchResource(EndpointType::Images, job.artist_uuid, job.headers, response)) {
+        fetched++;
+        image_ids = ParseImageIds(response.BodyData(), response.BodySize(), job.artist_uuid, kMaxPrefetchImages);
+    }
+
+    if (!prefetch_stop_ && job.requested != EndpointType::DeviceBackgroundImage &&
+        PrefetchResource(EndpointType::DeviceBackgroundImage, job.artist_uuid, job.headers, response)) {
+        fetched++;
+    }
+
+    for (const auto& image_id : image_ids) {
+        if (prefetch_stop_) {
+            return;
+        }
+        if (PrefetchResource(EndpointType::Artwork, image_id, job.headers, response)) {
+            fetched++;
+        }
+    }
+
+    HANDLER_LOG(HTTP, INFO, "Prefetched " + std::to_string(fetched) + " resources for artist " + job.artist_uuid);
+}
+
+bool MetadataRequestHandler::PrefetchResource(
+    EndpointType endpoint_type,
+    const std::string& id,
+    const std::map<std::string, std::string>& headers,
+    HTTPParser::HTTPResponse& out) {
+
+    RequestTemplate tmpl;
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        auto it = prefetch_templates_.find(endpoint_type);
+        if (it == prefetch_templates_.end()) {
+            return false;
+        }
+        tmpl = it->second;
+    }
+
+    HTTPParser::HTTPRequest request;
+    request.method = "GET";
+    request.protocol = "HTTP/1.1";
+    request.path = tmpl.path;
+    request.path.replace(request.path.find("{id}"), 4, id);
+    request.query_params = tmpl.query_params;
+    for (const auto& [name, value] : headers) {
+        if (LowerCase(name) != "host") {
+            request.headers.emplace(name, value);
+        }
+    }
+    request.headers["Host"] = tmpl.host;
+
+    std::string cache_key = MetadataResponseCache::MakeKey(tmpl.host, request.path, request.query_params);
+    if (response_cache_->Peek(cache_key, out)) {
+        return true;
+    }
+
+    bool is_artwork = endpoint_type == EndpointType::Artwork;
+    bool from_upstream = false;
+    out = ResolveRequest(request, is_artwork ? std::string() : id, endpoint_type,
+                         is_artwork ? id : std::string(), nullptr, from_upstream);
+    if (out.status_code < 200 || out.status_code >= 300) {
+        return false;
+    }
+    response_cache_->Insert(cache_key, out, true, from_upstream);
+    return true;
+}
+
+std::vector<std::string> MetadataRequestHandler::ParseImageIds(
+    const uint8_t* feed,
+    size_t feed_size,
+    const std::string& artist_uuid,
+    size_t limit) {
+
+    static const std::regex uuid_regex(
+        R"([0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12})", std::regex::icase);
+
+    std::string text(reinterpret_cast<const char*>(feed), feed_size);
+    std::unordered_set<std::string> seen{LowerCase(artist_uuid)};
+    std::vector<std::string> ids;
+    for (std::sregex_iterator it(text.begin(), text.end(), uuid_regex), end;
+         it != end && ids.size() < limit; ++it) {
+        std::string id = it->str();
+        if (seen.insert(LowerCase(id)).second) {
+            ids.push_back(std::move(id));
+        }
+    }
+    return ids;
+}
+
 // ── Shared Implementation ────────────────────────────────────────────────
 
 void MetadataRequestHandler::SetPathResolverCallback(PathResolverCallback callback, void* user_data) {
@@ -197,14 +700,27 @@ void MetadataRequestHandler::SetPathResolverCallback(PathResolverCallback callba
 }
 
 void MetadataRequestHandler::SetCacheStorageCallback(CacheStorageCallback callback, void* user_data) {
+    cache_writes_.Flush();
     cache_storage_callback_ = callback;
     cache_storage_user_data_ = user_data;
 }
 
-void MetadataRequestHandler::SetLogCallback(LogCallback callback) {
-    log_callback_ = callback;
+void MetadataRequestHandler::SetResponseCache(MetadataResponseCache* cache) {
+    response_cache_ = cache;
+}
+
+void MetadataRequestHandler::SetImageVariantCache(ImageVariantCache* cache) {
+    image_variants_ = cache;
+}
+
+void MetadataRequestHandler::SetDiskCache(MetadataDiskCache* cache) {
+    disk_cache_ = cache;
+}
+
+void MetadataRequestHandler::SetLogger(zune::Logger* logger) {
+    logger_ = logger;
     if (http_client_) {
-        http_client_->SetLogCallback(callback);
+        http_client_->SetLogCallback(zune::LogCallbackFor(logger, ZUNE_LOG_HTTP, ZUNE_LOG_INFO));
     }
 }
 
@@ -215,35 +731,54 @@ bool MetadataRequestHandler::TestConnection() {
 HTTPParser::HTTPResponse MetadataRequestHandler::TryServeFromLocal(
     const std::string& artist_uuid,
     EndpointType endpoint_type,
-    const std::string& resource_id) {
+    const std::string& resource_id,
+    uint32_t width) {
 
     HTTPParser::HTTPResponse response;
     response.status_code = 0;
 
     const char* type_str = EndpointTypeToString(endpoint_type);
-    const char* file_path = path_resolver_callback_(
-        artist_uuid.c_str(),
-        type_str,
-        resource_id.empty() ? nullptr : resource_id.c_str(),
-        path_resolver_user_data_
-    );
-
-    if (!file_path) {
-        Log("Path resolver returned null (file not found or artist not in DB)");
-        return response;
+    std::string path_str;
+    if (path_resolver_callback_) {
+        const char* file_path = path_resolver_callback_(
+            artist_uuid.c_str(),
+            type_str,
+            resource_id.empty() ? nullptr : resource_id.c_str(),
+            path_resolver_user_data_
+        );
+
+        if (!file_path) {
+            HANDLER_LOG(HTTP, INFO, "Path resolver returned null (file not found or artist not in DB)");
+            return response;
+        }
+
+        path_str = file_path;
+        free(const_cast<char*>(file_path));
+    } else {
+        path_str = disk_cache_->Lookup(artist_uuid, type_str, resource_id);
+        if (path_str.empty()) {
+            HANDLER_LOG(HTTP, INFO, std::string("Not in disk cache: ") + type_str);
+            return response;
+        }
     }
 
-    std::string path_str(file_path);
-    free(const_cast<char*>(file_path));
-    auto file_data = ReadFile(path_str);
-    if (file_data.empty()) {
-        Log("File exists in path but couldn't be read: " + path_str);
-        return response;
+    // Mapped where possible: segments are then framed straight from the
+    // page cache. Read into the body where mapping is unavailable.
+    if (auto mapped = static_files_.Open(path_str, kMaxLocalFileSize)) {
+        response.mapped_body = mapped->Data();
+        response.mapped_body_size = static_cast<size_t>(mapped->Size());
+        response.mapped_body_owner = std::move(mapped);
+    } else {
+        response.body = ReadFile(path_str);
+        if (response.body.empty()) {
+            HANDLER_LOG(HTTP, INFO, "File exists in path but couldn't be read: " + path_str);
+            return response;
+        }
     }
+    size_t file_size = response.BodySize();
 
     response.status_code = 200;
     response.status_message = "OK";
-    response.body = file_data;
 
     std::string content_type = GetContentType(path_str);
     if (content_type.find("xml") != std::string::npos) {
@@ -251,35 +786,70 @@ HTTPParser::HTTPResponse MetadataRequestHandler::TryServeFromLocal(
     }
 
     response.headers["Content-Type"] = content_type;
-    response.headers["Content-Length"] = std::to_string(file_data.size());
+    response.headers["Content-Length"] = std::to_string(file_size);
     response.headers["Connection"] = "keep-alive";
     response.headers["Server"] = "gunicorn";
     response.headers["Date"] = GetCurrentHttpDate();
+    SetFileValidators(path_str, file_size, response);
 
     if (endpoint_type == EndpointType::DeviceBackgroundImage) {
         size_t last_slash = path_str.find_last_of("/\\");
         std::string filename = (last_slash != std::string::npos) ? path_str.substr(last_slash + 1) : path_str;
         response.headers["Content-Disposition"] = "inline; filename=" + filename;
-        response.headers["Last-Modified"] = GetFileModificationDate(path_str);
         response.headers["Cache-Control"] = "no-cache";
-        response.headers["ETag"] = GenerateETag(path_str, file_data.size());
     } else {
         response.headers["Cache-Control"] = "max-age=86400";
         response.headers["Access-Control-Allow-Origin"] = "*";
         response.headers["Expires"] = "Sun, 19 Apr 2071 10:00:00 GMT";
     }
 
-    Log("Successfully served from local file: " + path_str);
+    if (width != 0 && content_type == "image/jpeg") {
+        ApplyImageVariant(artist_uuid, endpoint_type, resource_id, width, response);
+    }
+
+    HANDLER_LOG(HTTP, INFO, "Successfully served from local file: " + path_str);
     return response;
 }
 
+void MetadataRequestHandler::ApplyImageVariant(
+    const std::string& artist_uuid,
+    EndpointType endpoint_type,
+    const std::string& resource_id,
+    uint32_t width,
+    HTTPParser::HTTPResponse& response) {
+
+    if (!image_variants_) {
+        return;
+    }
+    std::string source_etag = response.headers["ETag"];
+    ImageVariantCache::Variant variant = image_variants_->Get(
+        VariantKey(endpoint_type, artist_uuid, resource_id, width), source_etag,
+        response.BodyData(), response.BodySize(), width);
+    if (!variant) {
+        return;
+    }
+
+    HANDLER_LOG(HTTP, INFO, "Resized to width " + std::to_string(width) + ": " +
+        std::to_string(response.BodySize()) + " -> " + std::to_string(variant->size()) + " bytes");
+    response.body.clear();
+    response.mapped_body = variant->data();
+    response.mapped_body_size = variant->size();
+    response.mapped_body_owner = std::move(variant);
+    response.headers["Content-Length"] = std::to_string(response.mapped_body_size);
+    // Another representation of the same file: its own tag, same Last-Modified
+    if (source_etag.size() >= 2 && source_etag.back() == '"') {
+        source_etag.insert(source_etag.size() - 1, "-w" + std::to_string(width));
+        response.headers["ETag"] = source_etag;
+    }
+}
+
 void MetadataRequestHandler::CacheResponse(
     const std::string& artist_uuid,
     EndpointType endpoint_type,
     const std::string& resource_id,
     const HTTPParser::HTTPResponse& response) {
 
-    if (!cache_storage_callback_) {
+    if (!StoresLocally()) {
         return;
     }
 
@@ -292,27 +862,45 @@ void MetadataRequestHandler::CacheResponse(
     }
 
     const char* type_str = EndpointTypeToString(endpoint_type);
-    bool cached = cache_storage_callback_(
-        artist_uuid.empty() ? nullptr : artist_uuid.c_str(),
-        type_str,
-        resource_id.empty() ? nullptr : resource_id.c_str(),
-        response.body.data(),
-        response.body.size(),
-        content_type.c_str(),
-        cache_storage_user_data_
-    );
+    bool cached;
+    if (cache_storage_callback_) {
+        cached = cache_storage_callback_(
+            artist_uuid.empty() ? nullptr : artist_uuid.c_str(),
+            type_str,
+            resource_id.empty() ? nullptr : resource_id.c_str(),
+            response.BodyData(),
+            response.BodySize(),
+            content_type.c_str(),
+            cache_storage_user_data_
+        );
+    } else {
+        cached = disk_cache_->Store(artist_uuid, type_str, resource_id,
+                                    response.BodyData(), response.BodySize(), content_type);
+    }
 
     std::string identifier = !artist_uuid.empty() ? artist_uuid :
                             (!resource_id.empty() ? "resource:" + resource_id : "unknown");
 
     if (cached) {
-        Log(std::string("Successfully cached ") + type_str + " for " + identifier +
-            " (" + std::to_string(response.body.size()) + " bytes)");
+        HANDLER_LOG(HTTP, INFO, std::string("Successfully cached ") + type_str + " for " + identifier +
+            " (" + std::to_string(response.BodySize()) + " bytes)");
     } else {
-        Log(std::string("Cache callback returned false for ") + type_str + "/" + identifier);
+        HANDLER_LOG(HTTP, INFO, std::string("Cache callback returned false for ") + type_str + "/" + identifier);
     }
 }
 
+void MetadataRequestHandler::QueueCacheResponse(
+    const std::string& artist_uuid,
+    EndpointType endpoint_type,
+    const std::string& resource_id,
+    const HTTPParser::HTTPResponse& response) {
+
+    size_t bytes = response.BodySize();
+    cache_writes_.Push([this, artist_uuid, endpoint_type, resource_id, response] {
+        CacheResponse(artist_uuid, endpoint_type, resource_id, response);
+    }, bytes);
+}
+
 EndpointType MetadataRequestHandler::DetermineEndpointType(const std::string& path) {
     if (path.find("/biography") != std::string::npos)
         return EndpointType::Biography;
@@ -340,9 +928,8 @@ mtp::ByteArray MetadataRequestHandler::ReadFile(const std::string& file_path) {
     }
 
     std::streamsize size = file.tellg();
-    const std::streamsize MAX_FILE_SIZE = 10 * 1024 * 1024;  // 10MB limit
-    if (size < 0 || size > MAX_FILE_SIZE) {
-        Log("File too large or invalid size: " + file_path);
+    if (size < 0 || size > static_cast<std::streamsize>(kMaxLocalFileSize)) {
+        HANDLER_LOG(HTTP, INFO, "File too large or invalid size: " + file_path);
         return mtp::ByteArray();
     }
 
@@ -367,33 +954,23 @@ std::string MetadataRequestHandler::GetCurrentHttpDate() {
     return std::string(buffer);
 }
 
-std::string MetadataRequestHandler::GetFileModificationDate(const std::string& file_path) {
-    struct stat file_stat;
-    if (stat(file_path.c_str(), &file_stat) != 0) {
-        return GetCurrentHttpDate();
-    }
-
-    struct tm tm_buf;
-    gmtime_r(&file_stat.st_mtime, &tm_buf);
-
-    char buffer[100];
-    strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm_buf);
-    return std::string(buffer);
-}
-
-std::string MetadataRequestHandler::GenerateETag(const std::string& file_path, size_t file_size) {
+void MetadataRequestHandler::SetFileValidators(const std::string& file_path, size_t file_size,
+                                               HTTPParser::HTTPResponse& response) {
     struct stat file_stat;
     if (stat(file_path.c_str(), &file_stat) != 0) {
-        return "\"" + std::to_string(file_size) + "\"";
+        response.headers["ETag"] = HTTPParser::MakeETag(response.BodyData(), response.BodySize());
+        response.headers["Last-Modified"] = GetCurrentHttpDate();
+        return;
     }
 
-    double mtime = static_cast<double>(file_stat.st_mtime);
+    // Size, modification time and path together change whenever the
+    // cache file is rewritten, without hashing the body on every request
     std::hash<std::string> hasher;
-    size_t path_hash = hasher(file_path);
-
-    std::ostringstream etag;
-    etag << "\"" << std::fixed << mtime << "-" << file_size << "-" << path_hash << "\"";
-    return etag.str();
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%llx-%zx-%zx\"",
+             static_cast<unsigned long long>(file_stat.st_mtime), file_size, hasher(file_path));
+    response.headers["ETag"] = etag;
+    response.headers["Last-Modified"] = HTTPParser::FormatHTTPDate(static_cast<int64_t>(file_stat.st_mtime));
 }
 
 std::string MetadataRequestHandler::GetContentType(const std::string& file_path) {
@@ -415,9 +992,3 @@ std::string MetadataRequestHandler::GetContentType(const std::string& file_path)
 
     return "application/octet-stream";
 }
-
-void MetadataRequestHandler::Log(const std::string& message) {
-    if (log_callback_) {
-        log_callback_("[MetadataRequestHandler] " + message);
-    }
-}
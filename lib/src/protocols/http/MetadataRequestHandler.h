@@ -1,15 +1,30 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 #include <mtp/ByteArray.h>
 #include "HTTPParser.h"
+#include "CacheWriteQueue.h"
+#include "HttpClient.h"
+#include "ImageVariantCache.h"
+#include "MetadataDiskCache.h"
+#include "MetadataResponseCache.h"
+#include "StaticFileCache.h"
 
 // Forward declarations
-class HttpClient;
 enum class InterceptionMode;
 struct ProxyModeConfig;
+namespace zune { class Logger; }
 
 enum class EndpointType {
     Overview,
@@ -32,6 +47,30 @@ bool IsImageEndpoint(EndpointType type);
  * - Static:  Resolve via C# callbacks only, 404 on miss.
  * - Proxy:   Forward to HTTP server, no local resolution.
  * - Hybrid:  Try local via callbacks, proxy on miss, cache response.
+ *
+ * With an open disk cache, it stands in for whichever of the two callbacks
+ * is not registered: files are found and stored natively (see
+ * MetadataDiskCache). A registered callback overrides it.
+ *
+ * Proxied responses reach the cache storage callback through a write-behind
+ * queue: the worker thread returns the response to be sent and a background
+ * thread makes the (managed, disk-bound) callback afterwards.
+ *
+ * With a response cache set, the first request naming an artist also
+ * queues that artist for prefetch: a background thread resolves its
+ * biography, images feed and background image, then the images the feed
+ * lists, into the cache, so the requests the device sends next are hits.
+ *
+ * Every 200 carries validators: local files an ETag and Last-Modified from
+ * the file, proxied bodies an ETag hashed from the body unless upstream
+ * sent one. A device request whose If-None-Match or If-Modified-Since
+ * matches is answered 304 in every mode. Proxied copies in the response
+ * cache are revalidated upstream with a conditional GET once stale, so an
+ * unchanged resource costs upstream a 304 rather than the body again.
+ *
+ * With an image variant cache that has a resize callback, local JPEGs asked
+ * for with resize=true and a width are sent as a copy at that width (see
+ * ImageVariantCache), made once per image and width.
  */
 class MetadataRequestHandler {
 public:
@@ -59,26 +98,151 @@ public:
 
     ~MetadataRequestHandler();
 
-    HTTPParser::HTTPResponse HandleRequest(const HTTPParser::HTTPRequest& request);
+    /// @param stream Optional; proxied bodies are also streamed to it as
+    ///               they download (see HttpClient::ResponseStream). The
+    ///               full response is returned either way.
+    HTTPParser::HTTPResponse HandleRequest(const HTTPParser::HTTPRequest& request,
+                                           HttpClient::ResponseStream* stream = nullptr);
+
+    /// Whether request can be answered without waiting on an upstream
+    /// server, as far as can be told before handling it: Static mode,
+    /// response-cache hits, connectivity checks and biography XML
+    bool IsFastRequest(const HTTPParser::HTTPRequest& request) const;
+
+    /// Answer request only if that needs no I/O: connectivity checks,
+    /// methods other than GET and fresh response-cache hits. Otherwise
+    /// returns false, leaving it to HandleRequest (on another thread).
+    bool HandleFromMemory(const HTTPParser::HTTPRequest& request, HTTPParser::HTTPResponse& response);
 
     void SetPathResolverCallback(PathResolverCallback callback, void* user_data);
+
+    /// Waits for queued writes to the previous callback to finish first
     void SetCacheStorageCallback(CacheStorageCallback callback, void* user_data);
-    void SetLogCallback(LogCallback callback);
+    void SetLogger(zune::Logger* logger);  // HTTP category; may be null
+
+    /// Answer repeated GETs from cache and keep successful responses in it,
+    /// and prefetch artist resources into it. Not owned; null disables both.
+    void SetResponseCache(MetadataResponseCache* cache);
+
+    /// Send local images at the width the device asks for. Not owned; null,
+    /// or a cache without a resize callback, sends the files as they are.
+    void SetImageVariantCache(ImageVariantCache* cache);
+
+    /// Find and store local files natively where no callback is registered.
+    /// Not owned; null, or a closed cache, leaves it to the callbacks.
+    void SetDiskCache(MetadataDiskCache* cache);
 
     bool TestConnection();
 
 private:
-    HTTPParser::HTTPResponse HandleStatic(
+    /// Host, path with "{id}" in place of the UUID, and query of one
+    /// prefetchable endpoint, learned from the device's own requests
+    struct RequestTemplate {
+        std::string host;
+        std::string path;
+        std::map<std::string, std::string> query_params;
+    };
+
+    struct PrefetchJob {
+        std::string artist_uuid;
+        std::map<std::string, std::string> headers;  // Of the request that named the artist
+        EndpointType requested;                      // Being fetched by that request already
+    };
+
+    static constexpr size_t kMaxPrefetchQueue = 4;     // Older artists are dropped
+    static constexpr size_t kMaxPrefetchImages = 10;   // One images feed chunk
+    static constexpr size_t kMaxPrefetchSeen = 256;
+    static constexpr size_t kMaxLocalFileSize = 10 * 1024 * 1024;
+
+    /// How long a proxied copy is used before revalidation, when upstream
+    /// gave no max-age
+    static constexpr std::chrono::seconds kDefaultFreshness{3600};
+
+    /// Mode dispatch for one request, without the response cache
+    /// @param[out] from_upstream Whether the response was proxied
+    HTTPParser::HTTPResponse ResolveRequest(
+        const HTTPParser::HTTPRequest& request,
         const std::string& artist_uuid,
         EndpointType endpoint_type,
+        const std::string& resource_id,
+        HttpClient::ResponseStream* stream,
+        bool& from_upstream);
+
+    /// The stored copy, or what a conditional GET upstream replaced it with;
+    /// the stored copy again if upstream could not be reached
+    HTTPParser::HTTPResponse Revalidate(
+        const HTTPParser::HTTPRequest& request,
+        const std::string& cache_key,
+        const HTTPParser::HTTPResponse& cached);
+
+    /// 304 for response if request's validators match it, else response
+    HTTPParser::HTTPResponse AnswerConditional(
+        const HTTPParser::HTTPRequest& request,
+        HTTPParser::HTTPResponse response);
+
+    /// Headers to forward upstream: the device's validators only when the
+    /// response will not be kept (they describe the device's copy, and a
+    /// 304 leaves nothing to cache)
+    std::map<std::string, std::string> UpstreamHeaders(const HTTPParser::HTTPRequest& request) const;
+    bool KeepsResponses() const { return response_cache_ || StoresLocally(); }
+
+    /// Local files can be looked up: a path resolver, or the disk cache
+    bool ResolvesLocally() const { return path_resolver_callback_ || (disk_cache_ && disk_cache_->IsOpen()); }
+    /// Proxied bodies can be stored: a storage callback, or the disk cache
+    bool StoresLocally() const { return cache_storage_callback_ || (disk_cache_ && disk_cache_->IsOpen()); }
+
+    /// Width asked for with resize=true on an image endpoint; 0 for none
+    static uint32_t RequestedWidth(const HTTPParser::HTTPRequest& request, EndpointType endpoint_type);
+    static std::string VariantKey(
+        EndpointType endpoint_type,
+        const std::string& artist_uuid,
+        const std::string& resource_id,
+        uint32_t width);
+    /// Whether serving request would resize an image not resized yet
+    bool NeedsResize(const HTTPParser::HTTPRequest& request) const;
+
+    void LearnRequestTemplate(
+        const HTTPParser::HTTPRequest& request,
+        EndpointType endpoint_type,
+        const std::string& artist_uuid,
         const std::string& resource_id);
 
+    void SchedulePrefetch(
+        const HTTPParser::HTTPRequest& request,
+        EndpointType endpoint_type,
+        const std::string& artist_uuid);
+    void PrefetchThread();
+    void PrefetchArtist(const PrefetchJob& job);
+
+    /// Cached or freshly resolved response for endpoint_type/id; false if
+    /// there is no template for it or it did not resolve to a 2xx
+    bool PrefetchResource(
+        EndpointType endpoint_type,
+        const std::string& id,
+        const std::map<std::string, std::string>& headers,
+        HTTPParser::HTTPResponse& out);
+
+    /// Image UUIDs listed in an images feed, in feed order, without the
+    /// artist's own UUID and at most limit of them
+    static std::vector<std::string> ParseImageIds(
+        const uint8_t* feed,
+        size_t feed_size,
+        const std::string& artist_uuid,
+        size_t limit);
+
+    HTTPParser::HTTPResponse HandleStatic(
+        const std::string& artist_uuid,
+        EndpointType endpoint_type,
+        const std::string& resource_id,
+        uint32_t width);
+
     HTTPParser::HTTPResponse HandleProxy(
         const HTTPParser::HTTPRequest& request,
         const std::string& full_url,
         const std::string& artist_uuid,
         EndpointType endpoint_type,
-        const std::string& resource_id);
+        const std::string& resource_id,
+        HttpClient::ResponseStream* stream);
 
     HTTPParser::HTTPResponse HandleHybrid(
         const HTTPParser::HTTPRequest& request,
@@ -86,12 +250,24 @@ private:
         const std::string& server,
         const std::string& artist_uuid,
         EndpointType endpoint_type,
-        const std::string& resource_id);
+        const std::string& resource_id,
+        HttpClient::ResponseStream* stream,
+        bool& from_upstream);
 
+    /// @param width Send a copy resized to this width if there is one; 0 for the file
     HTTPParser::HTTPResponse TryServeFromLocal(
         const std::string& artist_uuid,
         EndpointType endpoint_type,
-        const std::string& resource_id);
+        const std::string& resource_id,
+        uint32_t width);
+
+    /// Swap a local JPEG's body for its variant at width, if it has one
+    void ApplyImageVariant(
+        const std::string& artist_uuid,
+        EndpointType endpoint_type,
+        const std::string& resource_id,
+        uint32_t width,
+        HTTPParser::HTTPResponse& response);
 
     void CacheResponse(
         const std::string& artist_uuid,
@@ -99,13 +275,19 @@ private:
         const std::string& resource_id,
         const HTTPParser::HTTPResponse& response);
 
+    /// CacheResponse on the write-behind thread, with a copy of response
+    void QueueCacheResponse(
+        const std::string& artist_uuid,
+        EndpointType endpoint_type,
+        const std::string& resource_id,
+        const HTTPParser::HTTPResponse& response);
+
     static EndpointType DetermineEndpointType(const std::string& path);
     mtp::ByteArray ReadFile(const std::string& file_path);
     std::string GetCurrentHttpDate();
-    std::string GetFileModificationDate(const std::string& file_path);
-    std::string GenerateETag(const std::string& file_path, size_t file_size);
+    /// ETag and Last-Modified of a local file, from one stat
+    void SetFileValidators(const std::string& file_path, size_t file_size, HTTPParser::HTTPResponse& response);
     std::string GetContentType(const std::string& file_path);
-    void Log(const std::string& message);
 
     InterceptionMode mode_;
 
@@ -114,8 +296,26 @@ private:
     void* path_resolver_user_data_ = nullptr;
     CacheStorageCallback cache_storage_callback_ = nullptr;
     void* cache_storage_user_data_ = nullptr;
-    LogCallback log_callback_;
+    zune::Logger* logger_ = nullptr;
+    MetadataResponseCache* response_cache_ = nullptr;
+    ImageVariantCache* image_variants_ = nullptr;
+    MetadataDiskCache* disk_cache_ = nullptr;
+
+    // Local files served by Static + Hybrid, mapped and held open
+    StaticFileCache static_files_;
 
     // HttpClient (used by Proxy + Hybrid)
     std::unique_ptr<HttpClient> http_client_;
+
+    // Prefetch (only with a response cache); the thread starts on first use
+    std::thread prefetch_thread_;
+    std::mutex prefetch_mutex_;
+    std::condition_variable prefetch_cv_;
+    std::deque<PrefetchJob> prefetch_queue_;            // Newest last
+    std::unordered_set<std::string> prefetch_seen_;     // Lower-cased artist UUIDs
+    std::map<EndpointType, RequestTemplate> prefetch_templates_;
+    std::atomic<bool> prefetch_stop_{false};
+
+    // Last member: destroyed (and drained) while the callbacks above are intact
+    CacheWriteQueue cache_writes_;
 };
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "HTTPParser.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * MetadataResponseCache
+ *
+ * Finished metadata responses kept in memory, least recently used first
+ * out, bounded by the bytes they hold. The device asks for the same
+ * biography, image list, background and /image/{uuid} URLs on every
+ * network session and often several times within one; a hit answers them
+ * without calling the path resolver, reading the file or proxying.
+ *
+ * Responses are stored as built (headers and body), not as TCP segments:
+ * sequence and acknowledgement numbers differ per connection, so segments
+ * are rebuilt for each send. Entries are keyed by Host, path and query
+ * (see MakeKey). Each remembers when it was stored and whether it came
+ * from the upstream server, so the handler can revalidate stale upstream
+ * copies. Thread-safe; the HTTP worker threads share one cache.
+ */
+class MetadataResponseCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t prefetched = 0;     // Entries stored before the device asked for them
+        uint64_t prefetch_hits = 0;  // Prefetched entries the device then asked for
+        uint64_t evictions = 0;      // Entries dropped to stay within the byte budget
+        uint64_t entries = 0;
+        uint64_t bytes = 0;          // Body + header bytes currently held
+        uint64_t capacity = 0;
+    };
+
+    /// Of an entry found by Lookup
+    struct Freshness {
+        std::chrono::steady_clock::duration age{};  // Since stored (or refreshed)
+        bool upstream = false;                      // Proxied, not a local file
+    };
+
+    static constexpr size_t kDefaultCapacity = 32 * 1024 * 1024;
+
+    explicit MetadataResponseCache(size_t capacity_bytes = kDefaultCapacity)
+        : capacity_(capacity_bytes) {}
+
+    MetadataResponseCache(const MetadataResponseCache&) = delete;
+    MetadataResponseCache& operator=(const MetadataResponseCache&) = delete;
+
+    /**
+     * "host\npath?k=v&k=v" with the host lower-cased; query_params is
+     * already sorted, so parameter order on the wire does not matter
+     */
+    static std::string MakeKey(const std::string& host, const std::string& path,
+                               const std::map<std::string, std::string>& query_params) {
+        std::string key;
+        key.reserve(host.size() + path.size() + 16);
+        for (char c : host) {
+            key += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+        key += '\n';
+        key += path;
+        char sep = '?';
+        for (const auto& [name, value] : query_params) {
+            key += sep;
+            key += name;
+            key += '=';
+            key += value;
+            sep = '&';
+        }
+        return key;
+    }
+
+    /**
+     * Copy of the cached response into out; false (and a miss) if absent
+     * @param freshness Optional; set to the entry's age and origin
+     */
+    bool Lookup(const std::string& key, HTTPParser::HTTPResponse& out, Freshness* freshness = nullptr) {
+        std::shared_ptr<const HTTPParser::HTTPResponse> response;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it == index_.end()) {
+                stats_.misses++;
+                return false;
+            }
+            lru_.splice(lru_.begin(), lru_, it->second);
+            response = it->second->response;
+            if (freshness) {
+                freshness->age = std::chrono::steady_clock::now() - it->second->stored;
+                freshness->upstream = it->second->upstream;
+            }
+            stats_.hits++;
+            if (it->second->prefetched) {
+                it->second->prefetched = false;
+                stats_.prefetch_hits++;
+            }
+        }
+        out = *response;  // Copied outside the lock; entries are immutable
+        return true;
+    }
+
+    /**
+     * Whether key is cached, without counting or refreshing it
+     */
+    bool Contains(const std::string& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return index_.find(key) != index_.end();
+    }
+
+    /**
+     * Lookup without counting or refreshing the entry (for the prefetcher)
+     */
+    bool Peek(const std::string& key, HTTPParser::HTTPResponse& out) const {
+        std::shared_ptr<const HTTPParser::HTTPResponse> response;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it == index_.end()) {
+                return false;
+            }
+            response = it->second->response;
+        }
+        out = *response;
+        return true;
+    }
+
+    /**
+     * Store response under key, replacing any previous entry. Responses
+     * larger than an eighth of the capacity are not kept, so one large
+     * image cannot flush everything else. upstream marks a proxied response
+     * (see Freshness); storing one again after revalidation resets its age.
+     */
+    void Insert(const std::string& key, const HTTPParser::HTTPResponse& response, bool prefetched = false,
+                bool upstream = false) {
+        size_t cost = Cost(key, response);
+        auto entry = std::make_shared<const HTTPParser::HTTPResponse>(response);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cost > capacity_ / 8) {
+            return;
+        }
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            bytes_ -= it->second->cost;
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        lru_.push_front(Entry{key, std::move(entry), cost, prefetched, upstream,
+                              std::chrono::steady_clock::now()});
+        index_.emplace(key, lru_.begin());
+        bytes_ += cost;
+        if (prefetched) {
+            stats_.prefetched++;
+        }
+        EvictLocked();
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    void SetCapacity(size_t capacity_bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity_bytes;
+        EvictLocked();
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats stats = stats_;
+        stats.entries = index_.size();
+        stats.bytes = bytes_;
+        stats.capacity = capacity_;
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const HTTPParser::HTTPResponse> response;
+        size_t cost;
+        bool prefetched;  // Not yet asked for by the device
+        bool upstream;
+        std::chrono::steady_clock::time_point stored;
+    };
+
+    static size_t Cost(const std::string& key, const HTTPParser::HTTPResponse& response) {
+        size_t cost = key.size() + response.BodySize() + response.status_message.size();
+        for (const auto& [name, value] : response.headers) {
+            cost += name.size() + value.size();
+        }
+        return cost;
+    }
+
+    void EvictLocked() {
+        while (bytes_ > capacity_ && !lru_.empty()) {
+            const Entry& victim = lru_.back();
+            bytes_ -= victim.cost;
+            index_.erase(victim.key);
+            lru_.pop_back();
+            stats_.evictions++;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    size_t bytes_ = 0;
+    std::list<Entry> lru_;  // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    Stats stats_;
+};
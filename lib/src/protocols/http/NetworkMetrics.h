@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * NetworkMetrics
+ *
+ * Interceptor-wide counters for the network stats: HTTP requests, the time
+ * from each request being parsed to its response's first segment reaching
+ * TCP, and the 0x922c transfers to the device with their rate over the
+ * last full second.
+ *
+ * Recording is a few relaxed atomic operations, safe from the poll thread
+ * and every request worker at once. Per-connection TCP state, queue depths
+ * and worker queue waits are read from their owners when a snapshot is
+ * taken, so they cost nothing to keep.
+ */
+class NetworkMetrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot {
+        uint64_t http_requests = 0;
+        uint64_t responses_started = 0;       // First segment handed to TCP
+        uint64_t first_segment_us_total = 0;  // Request parsed to first segment
+        uint64_t first_segment_us_max = 0;
+        uint64_t first_segment_us_last = 0;
+        uint64_t usb_transfers = 0;           // 0x922c operations
+        uint64_t usb_bytes_sent = 0;
+        uint64_t bytes_per_second = 0;        // Sent in the last full second
+    };
+
+    void RecordRequest() {
+        http_requests_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * A response's first segment went to TCP; received is when its request
+     * was parsed
+     */
+    void RecordResponseStart(Clock::time_point received, Clock::time_point now = Clock::now()) {
+        constexpr auto relaxed = std::memory_order_relaxed;
+        uint64_t us = now > received
+            ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - received).count())
+            : 0;
+        responses_started_.fetch_add(1, relaxed);
+        first_segment_us_total_.fetch_add(us, relaxed);
+        first_segment_us_last_.store(us, relaxed);
+        uint64_t max = first_segment_us_max_.load(relaxed);
+        while (us > max && !first_segment_us_max_.compare_exchange_weak(max, us, relaxed)) {
+        }
+    }
+
+    void RecordTransfer(uint64_t bytes, Clock::time_point now = Clock::now()) {
+        constexpr auto relaxed = std::memory_order_relaxed;
+        usb_transfers_.fetch_add(1, relaxed);
+        usb_bytes_sent_.fetch_add(bytes, relaxed);
+
+        // Whoever first sends in a new second closes the previous one
+        int64_t second = SecondOf(now);
+        int64_t current = second_.load(relaxed);
+        if (second > current && second_.compare_exchange_strong(current, second, relaxed)) {
+            uint64_t finished = this_second_bytes_.exchange(0, relaxed);
+            last_second_bytes_.store(second == current + 1 ? finished : 0, relaxed);
+        }
+        this_second_bytes_.fetch_add(bytes, relaxed);
+    }
+
+    Snapshot GetSnapshot(Clock::time_point now = Clock::now()) const {
+        constexpr auto relaxed = std::memory_order_relaxed;
+        Snapshot s;
+        s.http_requests = http_requests_.load(relaxed);
+        s.responses_started = responses_started_.load(relaxed);
+        s.first_segment_us_total = first_segment_us_total_.load(relaxed);
+        s.first_segment_us_max = first_segment_us_max_.load(relaxed);
+        s.first_segment_us_last = first_segment_us_last_.load(relaxed);
+        s.usb_transfers = usb_transfers_.load(relaxed);
+        s.usb_bytes_sent = usb_bytes_sent_.load(relaxed);
+
+        // The second being filled is not over yet; report the one before it
+        int64_t second = SecondOf(now);
+        int64_t current = second_.load(relaxed);
+        if (second == current) {
+            s.bytes_per_second = last_second_bytes_.load(relaxed);
+        } else if (second == current + 1) {
+            s.bytes_per_second = this_second_bytes_.load(relaxed);
+        }
+        return s;
+    }
+
+private:
+    static int64_t SecondOf(Clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+    }
+
+    std::atomic<uint64_t> http_requests_{0};
+    std::atomic<uint64_t> responses_started_{0};
+    std::atomic<uint64_t> first_segment_us_total_{0};
+    std::atomic<uint64_t> first_segment_us_max_{0};
+    std::atomic<uint64_t> first_segment_us_last_{0};
+    std::atomic<uint64_t> usb_transfers_{0};
+    std::atomic<uint64_t> usb_bytes_sent_{0};
+    std::atomic<int64_t> second_{0};              // Second this_second_bytes_ belongs to
+    std::atomic<uint64_t> this_second_bytes_{0};
+    std::atomic<uint64_t> last_second_bytes_{0};  // The full second before it
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/**
+ * NetworkPollLoop
+ *
+ * Runs the interceptor's poll cycle on a thread of its own, for hosts that
+ * would otherwise call PollOnce in a loop across P/Invoke.
+ *
+ * Each cycle waits for a device interrupt and then reads 0x922d whether one
+ * came or not, so the wait is also how often the device is read. It adapts:
+ * while transmissions are in flight, or the last cycle found data, it polls
+ * hot with the short wait; each empty cycle with nothing in flight doubles
+ * the wait up to the idle maximum. RTO deadlines still cut any wait short.
+ *
+ * Changes between hot and idle polling, and the end of the loop, are
+ * reported through the event callback on the loop thread. The callback may
+ * call Stop(); Start() from it fails, as the loop is still running.
+ */
+class NetworkPollLoop {
+public:
+    enum class Event {
+        Active = 1,   // Data or transmissions after an idle spell; polling hot
+        Idle = 2,     // Backed off to the idle wait
+        Stopped = 3   // Loop ended: 0 if stopped, else the poll's error
+    };
+
+    using PollFn = std::function<int(int timeout_ms)>;  // PollOnce: 1 data, 0 none, <0 ends the loop
+    using ActiveFn = std::function<bool()>;             // Transmissions in flight
+    using EventFn = std::function<void(Event event, int result)>;
+
+    static constexpr int kDefaultHotWaitMs = 1;
+    static constexpr int kDefaultIdleWaitMs = 250;
+
+    NetworkPollLoop() = default;
+    NetworkPollLoop(const NetworkPollLoop&) = delete;
+    NetworkPollLoop& operator=(const NetworkPollLoop&) = delete;
+
+    ~NetworkPollLoop() {
+        Stop();
+    }
+
+    /**
+     * Start polling on a new thread
+     * @return Token that stops this loop, or 0 if one is already running
+     */
+    uint64_t Start(PollFn poll, ActiveFn active, EventFn on_event,
+                   int hot_wait_ms = kDefaultHotWaitMs,
+                   int idle_wait_ms = kDefaultIdleWaitMs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_.load()) {
+            return 0;
+        }
+        // A loop that ended by itself is joined here
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        hot_wait_ms = std::max(hot_wait_ms, 0);
+        idle_wait_ms = std::max(idle_wait_ms, hot_wait_ms);
+        stop_.store(false);
+        running_.store(true);
+        thread_ = std::thread(&NetworkPollLoop::Run, this, std::move(poll), std::move(active),
+                              std::move(on_event), hot_wait_ms, idle_wait_ms);
+        return ++token_;
+    }
+
+    /**
+     * Stop the loop started with token (0: whichever is running) and wait
+     * for it to end, unless called from its own event callback
+     * @return false if token is not the current loop's, or none was started
+     */
+    bool Stop(uint64_t token = 0) {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if ((token != 0 && token != token_) || !thread_.joinable()) {
+                return false;
+            }
+            stop_.store(true);
+            if (thread_.get_id() == std::this_thread::get_id()) {
+                return true;  // Ends once the callback returns
+            }
+            thread = std::move(thread_);
+        }
+        thread.join();
+        return true;
+    }
+
+    bool IsRunning() const {
+        return running_.load();
+    }
+
+private:
+    void Run(PollFn poll, ActiveFn active, EventFn on_event, int hot_wait_ms, int idle_wait_ms) {
+        auto emit = [&](Event event, int result) {
+            if (on_event) {
+                on_event(event, result);
+            }
+        };
+
+        int wait_ms = hot_wait_ms;
+        bool idle = false;
+        int reason = 0;
+        while (!stop_.load()) {
+            int result = poll(wait_ms);
+            if (result < 0) {
+                reason = result;
+                break;
+            }
+            if (result > 0 || (active && active())) {
+                wait_ms = hot_wait_ms;
+                if (idle) {
+                    idle = false;
+                    emit(Event::Active, result);
+                }
+            } else if (wait_ms < idle_wait_ms) {
+                wait_ms = std::min(std::max(wait_ms * 2, 1), idle_wait_ms);
+                if (wait_ms == idle_wait_ms) {
+                    idle = true;
+                    emit(Event::Idle, 0);
+                }
+            }
+        }
+
+        emit(Event::Stopped, reason);
+        running_.store(false);
+    }
+
+    std::mutex mutex_;  // Guards Start/Stop and thread_
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> running_{false};
+    uint64_t token_ = 0;
+};
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "../ppp/PPPParser.h"
+#include <mtp/ByteArray.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * PacketCapture
+ *
+ * In-memory ring of the raw PPP bytes exchanged with the device, for
+ * looking at stalls in Wireshark without the per-packet formatting of
+ * verbose logging changing the timing being looked at.
+ *
+ * Recording copies the transfer into a reused slot under a short lock and
+ * takes a steady-clock timestamp; nothing is parsed. When disabled (the
+ * default) it costs one relaxed load. Once the ring is full the oldest
+ * transfers are overwritten.
+ *
+ * WritePcap splits the transfers into frames, rejoining frames that span
+ * transfers, and writes them as a nanosecond pcap with the PPP_WITH_DIR
+ * link type: a direction byte (0 from the device, 1 to it), the two-byte
+ * protocol and the payload, unescaped and without the FCS. Frames failing
+ * the FCS check, or cut short by the ring wrapping, are left out.
+ */
+class PacketCapture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Direction : uint8_t {
+        FromDevice = 0,  // Received by the host
+        ToDevice = 1     // Sent by the host
+    };
+
+    struct Stats {
+        uint64_t transfers = 0;    // Recorded since enabled
+        uint64_t bytes = 0;
+        uint64_t overwritten = 0;  // Lost to the ring wrapping
+        uint64_t held = 0;         // In the ring now
+    };
+
+    PacketCapture() = default;
+    PacketCapture(const PacketCapture&) = delete;
+    PacketCapture& operator=(const PacketCapture&) = delete;
+
+    /**
+     * Start capturing into a ring of max_transfers 0x922c/0x922d transfers,
+     * dropping anything captured before; 0 stops capturing and frees it
+     */
+    void Enable(size_t max_transfers) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.clear();
+        slots_.shrink_to_fit();
+        slots_.resize(max_transfers);
+        next_ = 0;
+        stats_ = Stats{};
+        enabled_.store(max_transfers > 0, std::memory_order_relaxed);
+    }
+
+    bool IsEnabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void Record(Direction direction, const uint8_t* data, size_t size, Clock::time_point now = Clock::now()) {
+        if (!IsEnabled() || size == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slots_.empty()) {
+            return;
+        }
+        Slot& slot = slots_[next_];
+        slot.at = now;
+        slot.direction = direction;
+        slot.data.assign(data, data + size);  // Keeps the slot's capacity
+        next_ = (next_ + 1) % slots_.size();
+
+        stats_.transfers++;
+        stats_.bytes += size;
+        if (stats_.held == slots_.size()) {
+            stats_.overwritten++;
+        } else {
+            stats_.held++;
+        }
+    }
+
+    void Record(Direction direction, const mtp::ByteArray& data) {
+        Record(direction, data.data(), data.size());
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    /**
+     * Write the ring as a pcap file; capturing carries on meanwhile
+     * @return Frames written, or -1 if the file could not be written
+     */
+    int64_t WritePcap(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return -1;
+        }
+        int64_t frames = WritePcap(file);
+        file.flush();
+        return file ? frames : -1;
+    }
+
+    int64_t WritePcap(std::ostream& out) const {
+        // Copy the ring out so capture is held up only for the copy
+        std::vector<Slot> transfers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t held = static_cast<size_t>(stats_.held);
+            size_t first = (next_ + slots_.size() - held) % std::max<size_t>(slots_.size(), 1);
+            transfers.reserve(held);
+            for (size_t i = 0; i < held; i++) {
+                transfers.push_back(slots_[(first + i) % slots_.size()]);
+            }
+        }
+
+        // pcap global header: nanosecond timestamps, PPP with direction
+        WriteU32(out, 0xa1b23c4d);
+        WriteU16(out, 2);
+        WriteU16(out, 4);
+        WriteU32(out, 0);  // thiszone
+        WriteU32(out, 0);  // sigfigs
+        WriteU32(out, kSnapLen);
+        WriteU32(out, kLinkTypePPPWithDir);
+
+        // Steady-clock stamps become wall-clock time relative to now
+        auto wall_now = std::chrono::system_clock::now();
+        auto steady_now = Clock::now();
+
+        int64_t frames = 0;
+        mtp::ByteArray incomplete[2];
+        bool started[2] = {false, false};
+        mtp::ByteArray packet;
+        for (const Slot& transfer : transfers) {
+            size_t dir = static_cast<size_t>(transfer.direction) & 1;
+            std::vector<mtp::ByteArray> extracted;
+            if (started[dir]) {
+                extracted = PPPParser::ExtractFramesWithBuffer(transfer.data, incomplete[dir]);
+            } else {
+                started[dir] = true;
+                mtp::ByteArray from_frame(transfer.data.begin() + FirstFrameStart(transfer.data),
+                                          transfer.data.end());
+                extracted = PPPParser::ExtractFramesWithBuffer(from_frame, incomplete[dir]);
+            }
+
+            auto wall = wall_now - std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                steady_now - transfer.at);
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wall.time_since_epoch()).count();
+            uint32_t sec = static_cast<uint32_t>(ns / 1000000000);
+            uint32_t nsec = static_cast<uint32_t>(ns % 1000000000);
+
+            for (const mtp::ByteArray& raw : extracted) {
+                PPPParser::ParsedFrame frame;
+                if (!PPPParser::TryParseFrame(raw, frame)) {
+                    continue;
+                }
+                packet.clear();
+                packet.push_back(static_cast<uint8_t>(transfer.direction));
+                packet.push_back(static_cast<uint8_t>(frame.protocol >> 8));
+                packet.push_back(static_cast<uint8_t>(frame.protocol & 0xFF));
+                packet.insert(packet.end(), frame.payload.begin(), frame.payload.end());
+
+                uint32_t length = static_cast<uint32_t>(packet.size());
+                WriteU32(out, sec);
+                WriteU32(out, nsec);
+                WriteU32(out, std::min(length, kSnapLen));
+                WriteU32(out, length);
+                out.write(reinterpret_cast<const char*>(packet.data()), std::min(length, kSnapLen));
+                frames++;
+            }
+        }
+        return frames;
+    }
+
+private:
+    static constexpr uint32_t kLinkTypePPPWithDir = 204;
+    static constexpr uint32_t kSnapLen = 65535;
+    static constexpr uint8_t kFlag = 0x7E;
+
+    struct Slot {
+        Clock::time_point at;
+        Direction direction = Direction::FromDevice;
+        mtp::ByteArray data;
+    };
+
+    /**
+     * Where the first whole frame begins in a direction's oldest transfer.
+     * If the ring wrapped it may start inside a frame: skip past that
+     * frame's closing flag, unless it is shared as the next frame's opening.
+     */
+    static size_t FirstFrameStart(const mtp::ByteArray& data) {
+        if (data.empty() || data[0] == kFlag) {
+            return 0;
+        }
+        auto flag = std::find(data.begin(), data.end(), kFlag);
+        size_t at = static_cast<size_t>(flag - data.begin());
+        if (at + 1 == data.size() || (at + 1 < data.size() && data[at + 1] == kFlag)) {
+            at++;
+        }
+        return std::min(at, data.size());
+    }
+
+    // pcap is read in the writer's byte order, given by the magic
+    static void WriteU32(std::ostream& out, uint32_t value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static void WriteU16(std::ostream& out, uint16_t value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<Slot> slots_;
+    size_t next_ = 0;  // Slot the next transfer goes to
+    Stats stats_;
+    std::atomic<bool> enabled_{false};
+};
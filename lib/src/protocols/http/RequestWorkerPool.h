@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Which queue of RequestWorkerPool a request goes to
+ */
+enum class RequestLane {
+    Fast = 0,  // Answered locally: cache hits, local files, biography XML
+    Slow = 1   // Waits on an upstream server
+};
+
+/**
+ * Counters of one RequestWorkerPool lane, since Start
+ */
+struct RequestLaneStats {
+    uint64_t workers = 0;
+    uint64_t queued = 0;            // Requests pushed to this lane
+    uint64_t completed = 0;
+    uint64_t stolen = 0;            // Of those, served by the other lane's workers
+    uint64_t depth = 0;             // Waiting now
+    uint64_t wait_us_total = 0;     // Queue wait, push to start
+    uint64_t wait_us_max = 0;
+    uint64_t service_us_total = 0;  // Start to finish
+    uint64_t service_us_max = 0;
+};
+
+struct RequestWorkerStats {
+    RequestLaneStats fast;
+    RequestLaneStats slow;
+};
+
+/**
+ * RequestWorkerPool
+ *
+ * HTTP request workers in two lanes, each with its own queue and threads,
+ * so slow upstream fetches cannot occupy every worker while cheap requests
+ * wait behind them.
+ *
+ * A worker with nothing in its own lane steals from the other one. Slow
+ * workers steal fast work freely; fast workers take slow work only while
+ * another fast worker is idle, so one fast worker is always left for the
+ * next cache hit.
+ *
+ * Per lane it records how long requests waited in the queue and how long
+ * they took to serve. Stop() joins the workers; requests still queued are
+ * dropped, as the interceptor is shutting the connection down anyway.
+ */
+template <typename Item>
+class RequestWorkerPool {
+public:
+    using Handler = std::function<void(Item& item)>;
+
+    RequestWorkerPool() = default;
+    RequestWorkerPool(const RequestWorkerPool&) = delete;
+    RequestWorkerPool& operator=(const RequestWorkerPool&) = delete;
+
+    ~RequestWorkerPool() {
+        Stop();
+    }
+
+    /**
+     * Start the workers; each lane gets at least one
+     */
+    void Start(size_t fast_workers, size_t slow_workers, Handler handler) {
+        Stop();
+        std::lock_guard<std::mutex> lock(mutex_);
+        handler_ = std::move(handler);
+        stop_ = false;
+        size_t counts[2] = {std::max<size_t>(fast_workers, 1), std::max<size_t>(slow_workers, 1)};
+        for (int lane = 0; lane < 2; lane++) {
+            lanes_[lane].stats.workers = counts[lane];
+            lanes_[lane].idle = counts[lane];
+            for (size_t i = 0; i < counts[lane]; i++) {
+                threads_.emplace_back(&RequestWorkerPool::WorkerThread, this, static_cast<RequestLane>(lane));
+            }
+        }
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        threads_.clear();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Lane& lane : lanes_) {
+            lane.queue.clear();
+        }
+    }
+
+    void Push(RequestLane lane, Item item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Lane& target = lanes_[static_cast<int>(lane)];
+            target.queue.push_back(Job{std::move(item), Clock::now()});
+            target.stats.queued++;
+        }
+        // Either lane's workers may take it
+        cv_.notify_all();
+    }
+
+    RequestWorkerStats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        RequestWorkerStats stats;
+        stats.fast = lanes_[0].stats;
+        stats.fast.depth = lanes_[0].queue.size();
+        stats.slow = lanes_[1].stats;
+        stats.slow.depth = lanes_[1].queue.size();
+        return stats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        Item item;
+        Clock::time_point enqueued;
+    };
+
+    struct Lane {
+        std::deque<Job> queue;
+        size_t idle = 0;  // Workers of this lane not running a request
+        RequestLaneStats stats;
+    };
+
+    bool MayStealLocked(RequestLane home) const {
+        return home == RequestLane::Slow || lanes_[0].idle > 1;
+    }
+
+    // Lane to take from next, or -1
+    int PickLocked(RequestLane home) const {
+        int own = static_cast<int>(home);
+        if (!lanes_[own].queue.empty()) {
+            return own;
+        }
+        if (!lanes_[1 - own].queue.empty() && MayStealLocked(home)) {
+            return 1 - own;
+        }
+        return -1;
+    }
+
+    static uint64_t Micros(Clock::duration d) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    }
+
+    void WorkerThread(RequestLane home) {
+        Lane& own = lanes_[static_cast<int>(home)];
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            int from = -1;
+            cv_.wait(lock, [&] { return stop_ || (from = PickLocked(home)) >= 0; });
+            if (stop_) {
+                return;
+            }
+            Lane& lane = lanes_[from];
+            Job job = std::move(lane.queue.front());
+            lane.queue.pop_front();
+            own.idle--;
+
+            lock.unlock();
+            Clock::time_point start = Clock::now();
+            handler_(job.item);
+            Clock::time_point end = Clock::now();
+            lock.lock();
+
+            own.idle++;
+            RequestLaneStats& stats = lane.stats;
+            uint64_t wait_us = Micros(start - job.enqueued);
+            uint64_t service_us = Micros(end - start);
+            stats.completed++;
+            stats.wait_us_total += wait_us;
+            stats.wait_us_max = std::max(stats.wait_us_max, wait_us);
+            stats.service_us_total += service_us;
+            stats.service_us_max = std::max(stats.service_us_max, service_us);
+            if (&lane != &own) {
+                stats.stolen++;
+            }
+            // A fast worker coming free may let another one steal
+            if (home == RequestLane::Fast && !lanes_[1].queue.empty()) {
+                cv_.notify_all();
+            }
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    Lane lanes_[2];
+    std::vector<std::thread> threads_;
+    Handler handler_;
+    bool stop_ = false;
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include "../tcp/TCPConnectionKey.h"
+#include <mtp/ByteArray.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * ResponseFrameQueue
+ *
+ * Hands outbound PPP frames from the HTTP worker threads (and the ACK /
+ * DNS / CCP paths) to whichever thread is draining them over 0x922c.
+ *
+ * Producers copy each frame into a slot of a bounded ring; a slot keeps
+ * its buffer when it is recycled, so once the ring has warmed up a push
+ * allocates nothing. Slots are claimed with one CAS on the enqueue index
+ * and published with a per-slot sequence number (Vyukov's bounded queue),
+ * so producers never wait on each other or on the consumer.
+ *
+ * Pushes must not fail or block: the drain itself pushes frames (a fast
+ * retransmit triggered by an ACK it polled), and dropping a frame stalls the
+ * TCP stream. When the ring is full, frames go to a mutex-protected spill
+ * list instead, and keep going there until the consumer has taken it, so a
+ * producer's frames are always delivered in the order it pushed them.
+ *
+ * There is one consumer at a time: TryBeginDrain() elects it, and every
+ * other caller returns immediately, leaving its frames to the active drain.
+ * The consumer reads the oldest frame in place (Peek) and may take it in
+ * pieces (Consume), which is how the drain splits frames across USB
+ * transfers. It may also wait briefly for the next frame (WaitForFrame);
+ * producers only touch a lock to wake it while it is waiting.
+ */
+class ResponseFrameQueue {
+public:
+    explicit ResponseFrameQueue(size_t capacity = 256)
+        : mask_(RoundUpPow2(capacity) - 1)
+        , slots_(new Slot[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ResponseFrameQueue(const ResponseFrameQueue&) = delete;
+    ResponseFrameQueue& operator=(const ResponseFrameQueue&) = delete;
+
+    /**
+     * Queue a copy of frame. Safe from any thread, including the consumer.
+     */
+    void Push(const uint8_t* data, size_t size) {
+        if (spill_count_.load(std::memory_order_acquire) == 0) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = slots_[pos & mask_];
+                size_t seq = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.frame.assign(data, data + size);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        WakeConsumer();
+                        return;
+                    }
+                } else if (diff < 0) {
+                    break;  // Ring full
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(spill_mutex_);
+        spill_.emplace_back(data, data + size);
+        spill_count_.fetch_add(1, std::memory_order_release);
+        spilled_total_.fetch_add(1, std::memory_order_relaxed);
+        WakeConsumer();
+    }
+
+    void Push(const mtp::ByteArray& frame) {
+        Push(frame.data(), frame.size());
+    }
+
+    /**
+     * Frames queued and not yet fully consumed. Approximate while
+     * producers are running; used for logging and the drain's poll decision.
+     */
+    size_t SizeApprox() const {
+        size_t enq = enqueue_pos_.load(std::memory_order_relaxed);
+        size_t deq = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t ring = enq > deq ? enq - deq : 0;
+        return ring + spill_count_.load(std::memory_order_relaxed) + taken_spill_count_.load(std::memory_order_relaxed);
+    }
+
+    bool Empty() const {
+        return SizeApprox() == 0;
+    }
+
+    /**
+     * Become the consumer. False if another thread (or an outer frame of
+     * this one) is already draining.
+     */
+    bool TryBeginDrain() {
+        // Pairs with the fence in EndDrain: either this exchange sees the
+        // consumer gone, or that consumer sees the frame pushed before it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return !draining_.exchange(true, std::memory_order_acquire);
+    }
+
+    /**
+     * Give up the consumer role. True if frames became ready that a
+     * producer left for this drain; the caller should try to drain again.
+     */
+    bool EndDrain() {
+        draining_.store(false, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (taken_spill_count_.load(std::memory_order_relaxed) != 0 ||
+            spill_count_.load(std::memory_order_relaxed) != 0) {
+            return true;
+        }
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return slots_[pos & mask_].sequence.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    /**
+     * Consumer only: the untaken bytes of the oldest frame. False if empty.
+     */
+    bool Peek(const uint8_t*& data, size_t& size) {
+        const mtp::ByteArray* frame = Front();
+        if (!frame) {
+            return false;
+        }
+        data = frame->data() + front_offset_;
+        size = frame->size() - front_offset_;
+        return true;
+    }
+
+    /**
+     * Consumer only: take n bytes of the frame Peek returned. The frame is
+     * released once all of it has been taken.
+     */
+    void Consume(size_t n) {
+        const mtp::ByteArray* frame = Front();
+        if (!frame) {
+            return;
+        }
+        front_offset_ += n;
+        if (front_offset_ < frame->size()) {
+            return;
+        }
+        front_offset_ = 0;
+
+        if (!taken_spill_.empty()) {
+            taken_spill_.pop_front();
+            taken_spill_count_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        // Hand the slot, buffer and all, back to the producers
+        slots_[pos & mask_].sequence.store(pos + mask_ + 1, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Consumer only: wait up to timeout for a frame to Peek. True if one
+     * is ready.
+     */
+    bool WaitForFrame(std::chrono::microseconds timeout) {
+        if (Front()) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        // Pairs with the fence in WakeConsumer: either the producer sees
+        // the flag, or this check sees its frame
+        consumer_waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = wait_cv_.wait_for(lock, timeout, [this] { return Front() != nullptr; });
+        consumer_waiting_.store(false, std::memory_order_relaxed);
+        return ready;
+    }
+
+    /**
+     * Frames that did not fit in the ring since construction
+     */
+    uint64_t SpilledTotal() const {
+        return spilled_total_.load(std::memory_order_relaxed);
+    }
+
+    size_t Capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        mtp::ByteArray frame;
+    };
+
+    void WakeConsumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_waiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            wait_cv_.notify_one();
+        }
+    }
+
+    static size_t RoundUpPow2(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    // The spill only starts when the ring is full and is only taken once
+    // every claimed ring slot has been consumed, so each producer's spilled
+    // frames follow its ring frames. The taken batch then goes before
+    // anything pushed to the ring after it was taken.
+    const mtp::ByteArray* Front() {
+        if (!taken_spill_.empty()) {
+            return &taken_spill_.front();
+        }
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) == pos + 1) {
+            return &slot.frame;
+        }
+        if (spill_count_.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(spill_mutex_);
+        if (enqueue_pos_.load(std::memory_order_relaxed) != pos) {
+            return nullptr;  // A ring push is still being written; its producer drains after it
+        }
+        taken_spill_.swap(spill_);
+        taken_spill_count_.store(taken_spill_.size(), std::memory_order_relaxed);
+        spill_count_.store(0, std::memory_order_release);
+        return taken_spill_.empty() ? nullptr : &taken_spill_.front();
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    std::atomic<bool> draining_{false};
+
+    // Consumer state, handed between threads through draining_
+    size_t front_offset_ = 0;
+    std::deque<mtp::ByteArray> taken_spill_;
+    std::atomic<size_t> taken_spill_count_{0};
+
+    std::mutex spill_mutex_;
+    std::deque<mtp::ByteArray> spill_;
+    std::atomic<size_t> spill_count_{0};
+    std::atomic<uint64_t> spilled_total_{0};
+
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    std::atomic<bool> consumer_waiting_{false};
+};
+
+/**
+ * PendingSend - a transmission whose window opened up
+ */
+struct PendingSend {
+    TCPConnectionKey conn_key;
+    uint32_t base_seq = 0;
+
+    bool operator==(const PendingSend& other) const {
+        return conn_key == other.conn_key && base_seq == other.base_seq;
+    }
+    bool operator<(const PendingSend& other) const {
+        if (conn_key != other.conn_key) return conn_key < other.conn_key;
+        return base_seq < other.base_seq;
+    }
+};
+
+/**
+ * PendingSendList
+ *
+ * Transmissions added by the ACK and retransmit paths and collected by
+ * ProcessPendingSends. Adds push onto a lock-free stack; TakeAll detaches
+ * the whole stack at once.
+ */
+class PendingSendList {
+public:
+    PendingSendList() = default;
+    PendingSendList(const PendingSendList&) = delete;
+    PendingSendList& operator=(const PendingSendList&) = delete;
+
+    ~PendingSendList() {
+        Free(head_.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    void Add(const TCPConnectionKey& conn_key, uint32_t base_seq) {
+        Node* node = new Node{PendingSend{conn_key, base_seq}, head_.load(std::memory_order_relaxed)};
+        while (!head_.compare_exchange_weak(node->next, node,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * Every transmission added since the last call, deduplicated and sorted
+     */
+    std::vector<PendingSend> TakeAll() {
+        std::vector<PendingSend> sends;
+        Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+        for (Node* n = node; n; n = n->next) {
+            sends.push_back(n->send);
+        }
+        Free(node);
+        std::sort(sends.begin(), sends.end());
+        sends.erase(std::unique(sends.begin(), sends.end()), sends.end());
+        return sends;
+    }
+
+private:
+    struct Node {
+        PendingSend send;
+        Node* next;
+    };
+
+    static void Free(Node* node) {
+        while (node) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    std::atomic<Node*> head_{nullptr};
+};
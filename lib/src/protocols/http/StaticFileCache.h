@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../../ZuneFileSource.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <sys/stat.h>
+
+/**
+ * StaticFileCache
+ *
+ * Local files served by Static and Hybrid modes, memory-mapped and kept
+ * open between requests. A response built from one points into the
+ * mapping (HTTPResponse::mapped_body), so the only copy of the bytes is
+ * the one into the outgoing PPP frames.
+ *
+ * Entries are keyed by path and revalidated with one stat() per lookup:
+ * a changed size or modification time maps the file afresh. Mappings in
+ * use by a response stay valid after their entry is replaced or evicted.
+ * The cache files are written whole by the storage callback when a resource
+ * is missing, not rewritten in place while mapped.
+ *
+ * Thread-safe; at most max_entries files are held open, least recently
+ * used dropped first.
+ */
+class StaticFileCache {
+public:
+    static constexpr size_t kDefaultMaxEntries = 64;
+
+    explicit StaticFileCache(size_t max_entries = kDefaultMaxEntries)
+        : max_entries_(max_entries) {}
+
+    StaticFileCache(const StaticFileCache&) = delete;
+    StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+    /**
+     * The mapped file at path, or null if it cannot be opened, is empty or
+     * larger than max_size, or cannot be mapped on this platform (the
+     * caller then reads it instead)
+     */
+    std::shared_ptr<const zune::FileSource> Open(const std::string& path, uint64_t max_size) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || st.st_size <= 0 ||
+            static_cast<uint64_t>(st.st_size) > max_size) {
+            return nullptr;
+        }
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        int64_t mtime = static_cast<int64_t>(st.st_mtime);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(path);
+            if (it != index_.end()) {
+                if (it->second->size == size && it->second->mtime == mtime) {
+                    lru_.splice(lru_.begin(), lru_, it->second);
+                    hits_++;
+                    return it->second->file;
+                }
+                lru_.erase(it->second);
+                index_.erase(it);
+            }
+        }
+
+        // Mapped outside the lock; a racing open of the same path just
+        // replaces this entry
+        auto file = std::make_shared<zune::FileSource>();
+        if (!file->Open(path) || !file->IsMapped() || file->Size() != size) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(path);
+        if (it != index_.end()) {
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        lru_.push_front(Entry{path, size, mtime, file});
+        index_.emplace(path, lru_.begin());
+        maps_++;
+        while (lru_.size() > max_entries_) {
+            index_.erase(lru_.back().path);
+            lru_.pop_back();
+        }
+        return file;
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+    }
+
+    /** Lookups answered by an open mapping */
+    uint64_t Hits() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return hits_;
+    }
+
+    /** Files mapped (first use, or changed since) */
+    uint64_t Maps() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maps_;
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        int64_t mtime;
+        std::shared_ptr<const zune::FileSource> file;
+    };
+
+    const size_t max_entries_;
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t maps_ = 0;
+};
@@ -1,6 +1,7 @@
 #include "ZuneHTTPInterceptor.h"
 #include "../ppp/PPPParser.h"
 #include "../ppp/PPPFrameBuilder.h"
+#include "../ppp/PPPLinkProfile.h"
 #include "HTTPParser.h"
 #include "HttpClient.h"
 #include "MetadataRequestHandler.h"
@@ -10,11 +11,18 @@
 #include <mtp/ptp/PipePacketer.h>
 #include <mtp/usb/BulkPipe.h>
 #include <mtp/ptp/ByteArrayObjectStream.h>
+#include <algorithm>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
 #include <cstring>
 #include "../../platform_socket.h"
+#include "../../ZuneTransferStats.h"
+#include "../../ZuneMtpScheduler.h"
+#include "../../ZuneLog.h"
+
+#define INTERCEPTOR_LOG(category, level, message) \
+    ZUNE_LOG(logger_, "ZuneHTTPInterceptor", category, level, message)
 
 // --- Helper classes for bulk data streaming ---
 class ByteArrayInputStream : public mtp::IObjectInputStream {
@@ -52,6 +60,29 @@ public:
 // USB read timeout (milliseconds)
 constexpr int USB_READ_TIMEOUT_MS = 100;
 
+// Frames queued while a poll cycle handles one USB read (ACKs, DNS and CCP
+// replies, the batches its ACKs release, RTO retransmits) go out together
+// when it ends, packed into as few 0x922c transfers as they fit in
+class ZuneHTTPInterceptor::DrainHold {
+public:
+    explicit DrainHold(ZuneHTTPInterceptor& owner) : owner_(owner) {
+        owner_.drain_held_by_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    }
+
+    ~DrainHold() {
+        owner_.drain_held_by_.store(std::thread::id(), std::memory_order_relaxed);
+        try {
+            owner_.DrainResponseQueue();
+        } catch (const std::exception& e) {
+            ZUNE_LOG(owner_.logger_, "ZuneHTTPInterceptor", PPP, ERROR,
+                     "Error draining after poll: " + std::string(e.what()));
+        }
+    }
+
+private:
+    ZuneHTTPInterceptor& owner_;
+};
+
 ZuneHTTPInterceptor::ZuneHTTPInterceptor(mtp::SessionPtr session)
     : session_(session) {
 }
@@ -70,7 +101,6 @@ ZuneHTTPInterceptor::ZuneHTTPInterceptor(mtp::usb::DevicePtr device, mtp::usb::I
     if (claim_interface) {
         try {
             interface_token_ = usb_device_->ClaimInterface(usb_interface_);
-            // Log will be called when SetLogCallback is invoked
         } catch (const std::exception& e) {
             throw std::runtime_error(std::string("Failed to claim USB interface: ") + e.what());
         }
@@ -91,9 +121,11 @@ void ZuneHTTPInterceptor::Start(const InterceptorConfig& config) {
         std::lock_guard<std::mutex> lock(config_mutex_);
         config_ = config;
     }
+    coalescer_.Configure(config_.usb_transfer_budget,
+                         std::chrono::microseconds(config_.coalesce_max_wait_us));
 
     if (config_.mode == InterceptionMode::Disabled) {
-        Log("Interceptor mode is disabled");
+        INTERCEPTOR_LOG(HTTP, INFO, "Interceptor mode is disabled");
         return;
     }
 
@@ -104,7 +136,7 @@ void ZuneHTTPInterceptor::Start(const InterceptorConfig& config) {
             throw std::runtime_error("Failed to discover USB endpoints 0x01/0x81");
         }
     } else {
-        Log("Using pre-discovered endpoints");
+        INTERCEPTOR_LOG(HTTP, INFO, "Using pre-discovered endpoints");
     }
 
     // Initialize parsers
@@ -113,39 +145,53 @@ void ZuneHTTPInterceptor::Start(const InterceptorConfig& config) {
 
     // Initialize protocol handlers (Phase 5.2 extraction)
     ccp_handler_ = std::make_unique<CCPHandler>();
-    ccp_handler_->SetLogCallback(log_callback_);
+    ccp_handler_->SetLogCallback(zune::LogCallbackFor(logger_, ZUNE_LOG_PPP, ZUNE_LOG_INFO));
+    ccp_handler_->SetCompressionEnabled(config_.ppp_compression);
+    compressed_frame_.clear();
+    compressed_offset_ = 0;
 
     tcp_manager_ = std::make_unique<TCPConnectionManager>();
-    tcp_manager_->SetLogCallback(log_callback_);
+    tcp_manager_->SetLogCallback(zune::LogCallbackFor(logger_, ZUNE_LOG_TCP, ZUNE_LOG_DEBUG));
+    tcp_manager_->SetCongestionControl(config_.congestion_control);
+    if (link_profile_) {
+        // Size for the last session's load and pace from its measured rate
+        tcp_manager_->ReserveConnections(link_profile_->PeakConnections());
+        tcp_manager_->SeedLinkRate(link_profile_->LinkRate());
+    }
 
     // Initialize DNS hostname mappings
     // Resolve to the configured server IP (we intercept all traffic anyway)
     uint32_t dns_target_ip;
     if (!config_.server_ip.empty()) {
         dns_target_ip = IPParser::StringToIP(config_.server_ip);
-        Log("DNS target: " + IPParser::IPToString(dns_target_ip) +
+        INTERCEPTOR_LOG(HTTP, INFO, "DNS target: " + IPParser::IPToString(dns_target_ip) +
             " (from: " + config_.server_ip + ")");
     } else {
         dns_target_ip = IPParser::StringToIP("192.168.0.30");
-        Log("DNS target: 192.168.0.30 (default)");
+        INTERCEPTOR_LOG(HTTP, INFO, "DNS target: 192.168.0.30 (default)");
     }
 
     InitializeDNSHostnameMap(dns_target_ip);
-    Log("DNS server initialized with " + std::to_string(dns_hostname_map_.size()) + " hostname mappings");
+    INTERCEPTOR_LOG(HTTP, INFO, "DNS server initialized with " + std::to_string(dns_hostname_map_.size()) + " hostname mappings");
 
-    // Initialize DNS handler with hostname map
-    dns_handler_ = std::make_unique<DNSHandler>(dns_hostname_map_);
-    dns_handler_->SetLogCallback(log_callback_);
+    // Initialize DNS handler with hostname map (the profile's, answers already
+    // compiled, while the map is unchanged)
+    dns_handler_ = link_profile_ ? link_profile_->DNS(dns_hostname_map_)
+                                 : std::make_shared<DNSHandler>(dns_hostname_map_);
+    dns_handler_->SetLogCallback(zune::LogCallbackFor(logger_, ZUNE_LOG_HTTP, ZUNE_LOG_INFO));
 
     // Initialize metadata request handler
     if (config_.mode != InterceptionMode::Disabled) {
-        Log("Initializing metadata handler in " + std::string(
+        INTERCEPTOR_LOG(HTTP, INFO, "Initializing metadata handler in " + std::string(
             config_.mode == InterceptionMode::Static ? "static" :
             config_.mode == InterceptionMode::Proxy ? "proxy" : "hybrid") + " mode");
 
         metadata_handler_ = std::make_unique<MetadataRequestHandler>(
             config_.mode, config_.proxy_config);
-        metadata_handler_->SetLogCallback(log_callback_);
+        metadata_handler_->SetLogger(logger_);
+        metadata_handler_->SetResponseCache(response_cache_);
+        metadata_handler_->SetImageVariantCache(image_variants_);
+        metadata_handler_->SetDiskCache(disk_cache_);
 
         {
             std::lock_guard<std::mutex> lock(callback_mutex_);
@@ -159,15 +205,13 @@ void ZuneHTTPInterceptor::Start(const InterceptorConfig& config) {
     running_.store(true);
 
     // Start request worker thread pool for concurrent HTTP request processing
-    Log("Starting " + std::to_string(NUM_WORKER_THREADS) + " request worker threads");
-    request_worker_threads_.reserve(NUM_WORKER_THREADS);
-    for (size_t i = 0; i < NUM_WORKER_THREADS; ++i) {
-        request_worker_threads_.push_back(
-            std::make_unique<std::thread>(&ZuneHTTPInterceptor::RequestWorkerThread, this)
-        );
-    }
+    INTERCEPTOR_LOG(HTTP, INFO, "Starting request workers: " + std::to_string(config_.fast_lane_workers) + " fast, " +
+        std::to_string(config_.slow_lane_workers) + " slow" +
+        (config_.reactor ? " (reactor mode: responses sent from the poll thread)" : ""));
+    request_workers_.Start(config_.fast_lane_workers, config_.slow_lane_workers,
+                           [this](HTTPRequest& request) { ProcessRequest(request); });
 
-    Log("HTTP interceptor started successfully");
+    INTERCEPTOR_LOG(HTTP, INFO, "HTTP interceptor started successfully");
 }
 
 void ZuneHTTPInterceptor::Stop() {
@@ -175,28 +219,19 @@ void ZuneHTTPInterceptor::Stop() {
         return;
     }
 
-    Log("Stopping HTTP interceptor...");
+    INTERCEPTOR_LOG(HTTP, INFO, "Stopping HTTP interceptor...");
     running_.store(false);
     network_polling_enabled_.store(false);
 
-    // Stop timeout checker thread (Phase 2: RTO integration)
-    timeout_checker_running_.store(false);
-    if (timeout_checker_thread_ && timeout_checker_thread_->joinable()) {
-        timeout_checker_thread_->join();
-    }
+    // Wait for the request workers to finish what they are serving
+    request_workers_.Stop();
+    completions_.Clear();
 
-    // Notify all request worker threads to wake up and check running_ flag
-    request_queue_cv_.notify_all();
+    // No monitoring thread to join — C# drives polling via PollOnce()
 
-    // Wait for all request worker threads to finish
-    for (auto& worker_thread : request_worker_threads_) {
-        if (worker_thread && worker_thread->joinable()) {
-            worker_thread->join();
-        }
+    if (link_profile_ && tcp_manager_) {
+        link_profile_->RecordSession(tcp_manager_->GetPeakConnections(), tcp_manager_->GetLinkRate());
     }
-    request_worker_threads_.clear();
-
-    // No monitoring thread to join — C# drives polling via PollOnce()
 
     // Clean up handlers
     metadata_handler_.reset();
@@ -205,7 +240,7 @@ void ZuneHTTPInterceptor::Stop() {
 
     // Connection states managed by TCPConnectionManager (Phase 5.3)
 
-    Log("HTTP interceptor stopped");
+    INTERCEPTOR_LOG(HTTP, INFO, "HTTP interceptor stopped");
 }
 
 bool ZuneHTTPInterceptor::IsRunning() const {
@@ -217,8 +252,8 @@ InterceptorConfig ZuneHTTPInterceptor::GetConfig() const {
     return config_;
 }
 
-void ZuneHTTPInterceptor::SetLogCallback(LogCallback callback) {
-    log_callback_ = callback;
+void ZuneHTTPInterceptor::SetLogger(zune::Logger* logger) {
+    logger_ = logger;
 }
 
 
@@ -229,7 +264,7 @@ void ZuneHTTPInterceptor::SetLogCallback(LogCallback callback) {
 bool ZuneHTTPInterceptor::SendVendorCommand(const mtp::ByteArray& data) {
     try {
         if (!usb_device_ || !endpoint_out_ || !endpoint_in_) {
-            Log("Error: Invalid USB device/endpoint for vendor command");
+            INTERCEPTOR_LOG(PPP, ERROR, "Error: Invalid USB device/endpoint for vendor command");
             return false;
         }
 
@@ -259,14 +294,14 @@ bool ZuneHTTPInterceptor::SendVendorCommand(const mtp::ByteArray& data) {
             // This is not a fatal error
             std::ostringstream oss;
             oss << "Note: No response or timeout reading response (this may be normal): " << e.what();
-            Log(oss.str());
+            INTERCEPTOR_LOG(HTTP, INFO, oss.str());
         }
 
         return true;
     } catch (const std::exception& e) {
         std::ostringstream oss;
         oss << "Error sending vendor command: " << e.what();
-        Log(oss.str());
+        INTERCEPTOR_LOG(HTTP, INFO, oss.str());
         return false;
     }
 }
@@ -279,7 +314,7 @@ bool ZuneHTTPInterceptor::DiscoverEndpoints() {
             // Get the BulkPipe from the session (same pattern as GetZuneMetadata)
             auto pipe = session_->GetBulkPipe();
             if (!pipe) {
-                Log("Error: Cannot access USB pipe from session");
+                INTERCEPTOR_LOG(PPP, ERROR, "Error: Cannot access USB pipe from session");
                 return false;
             }
 
@@ -290,13 +325,13 @@ bool ZuneHTTPInterceptor::DiscoverEndpoints() {
 
         // Verify we have USB access (either from session or constructor)
         if (!usb_device_ || !usb_interface_) {
-            Log("Error: No USB device or interface available");
+            INTERCEPTOR_LOG(PPP, ERROR, "Error: No USB device or interface available");
             return false;
         }
 
         // Iterate through all endpoints on this interface
         int endpoint_count = usb_interface_->GetEndpointsCount();
-        Log("Scanning " + std::to_string(endpoint_count) + " endpoints for HTTP traffic");
+        INTERCEPTOR_LOG(HTTP, INFO, "Scanning " + std::to_string(endpoint_count) + " endpoints for HTTP traffic");
 
         auto hex_addr = [](uint8_t a) {
             std::ostringstream oss;
@@ -315,7 +350,7 @@ bool ZuneHTTPInterceptor::DiscoverEndpoints() {
                                    (type == mtp::usb::EndpointType::Interrupt) ? "Interrupt" : "Other";
             std::string dir_str = (direction == mtp::usb::EndpointDirection::Out) ? "OUT" : "IN";
 
-            Log("  Endpoint " + std::to_string(i) + ": address=" + hex_addr(address) +
+            INTERCEPTOR_LOG(HTTP, INFO, "  Endpoint " + std::to_string(i) + ": address=" + hex_addr(address) +
                 " type=" + type_str + " dir=" + dir_str);
 
             // Match bulk endpoints by type and direction (address varies by device model)
@@ -324,11 +359,11 @@ bool ZuneHTTPInterceptor::DiscoverEndpoints() {
             if (type == mtp::usb::EndpointType::Bulk) {
                 if (direction == mtp::usb::EndpointDirection::Out) {
                     endpoint_out_ = ep;
-                    Log("  → Found HTTP OUT endpoint: " + hex_addr(address));
+                    INTERCEPTOR_LOG(HTTP, INFO, "  → Found HTTP OUT endpoint: " + hex_addr(address));
                 }
                 else if (direction == mtp::usb::EndpointDirection::In) {
                     endpoint_in_ = ep;
-                    Log("  → Found HTTP IN endpoint: " + hex_addr(address));
+                    INTERCEPTOR_LOG(HTTP, INFO, "  → Found HTTP IN endpoint: " + hex_addr(address));
                 }
             }
 
@@ -336,21 +371,21 @@ bool ZuneHTTPInterceptor::DiscoverEndpoints() {
             if (type == mtp::usb::EndpointType::Interrupt &&
                 direction == mtp::usb::EndpointDirection::In) {
                 endpoint_interrupt_ = ep;
-                Log("  → Found interrupt endpoint: " + hex_addr(address));
+                INTERCEPTOR_LOG(HTTP, INFO, "  → Found interrupt endpoint: " + hex_addr(address));
             }
         }
 
         if (!endpoint_in_ || !endpoint_out_) {
-            Log("Error: HTTP endpoints not found (need one Bulk OUT and one Bulk IN)");
+            INTERCEPTOR_LOG(HTTP, ERROR, "Error: HTTP endpoints not found (need one Bulk OUT and one Bulk IN)");
             return false;
         }
 
         endpoints_discovered_ = true;
-        Log("HTTP endpoints discovered successfully");
+        INTERCEPTOR_LOG(HTTP, INFO, "HTTP endpoints discovered successfully");
         return true;
 
     } catch (const std::exception& e) {
-        Log("Error discovering endpoints: " + std::string(e.what()));
+        INTERCEPTOR_LOG(HTTP, ERROR, "Error discovering endpoints: " + std::string(e.what()));
         return false;
     }
 }
@@ -364,16 +399,27 @@ int ZuneHTTPInterceptor::PollOnce(int timeout_ms) {
         return 0;
     }
 
-    if (!session_) {
+    if (!HasDeviceLink()) {
         return -2;
     }
 
     try {
-        // Wait for interrupt from device (blocks up to timeout_ms)
-        session_->PollEvent(timeout_ms);
+        // Wait for interrupt from device (blocks up to timeout_ms, or
+        // until the next segment's RTO is due)
+        WaitForDeviceEvent(TimeoutWaitMs(timeout_ms));
+
+        // Whatever this cycle queues is sent when it returns
+        DrainHold hold(*this);
+        std::lock_guard<std::mutex> receive(receive_mutex_);  // Released before the hold drains
+
+        // Retransmit segments whose RTO has expired
+        CheckAllConnectionTimeouts();
+
+        // Reactor mode: responses the workers finished since the last cycle
+        RunCompletions();
 
         // Retrieve network data
-        mtp::ByteArray response_data = session_->Operation922d(3, 3);
+        mtp::ByteArray response_data = Poll922d();
 
         if (response_data.empty()) {
             return 0;
@@ -388,7 +434,7 @@ int ZuneHTTPInterceptor::PollOnce(int timeout_ms) {
         }
 
         // Process network packet
-        VerboseLog("PollOnce: received " + std::to_string(response_data.size()) + " bytes");
+        INTERCEPTOR_LOG(PPP, DEBUG, "PollOnce: received " + std::to_string(response_data.size()) + " bytes");
 
         ProcessPacket(response_data);
 
@@ -399,40 +445,46 @@ int ZuneHTTPInterceptor::PollOnce(int timeout_ms) {
 
     } catch (const std::exception& e) {
         if (running_.load()) {
-            Log("PollOnce error: " + std::string(e.what()));
+            INTERCEPTOR_LOG(PPP, ERROR, "PollOnce error: " + std::string(e.what()));
         }
         return -1;
     }
 }
 
 void ZuneHTTPInterceptor::ProcessPacket(const mtp::ByteArray& usb_data) {
+    if (packet_capture_) {
+        packet_capture_->Record(PacketCapture::Direction::FromDevice, usb_data);
+    }
+
     try {
-        // Log raw USB data received (truncated to 1024 bytes)
-        std::ostringstream hex_dump;
-        hex_dump << "USB DATA RECEIVED (" << usb_data.size() << " bytes): ";
-        for (size_t i = 0; i < std::min(usb_data.size(), size_t(1024)); i++) {
-            hex_dump << std::hex << std::setw(2) << std::setfill('0')
-                     << (int)usb_data[i];
-            if ((i + 1) % 32 == 0) hex_dump << "\n  ";
+        // Log raw USB data received (truncated to 1024 bytes); only formatted when verbose
+        if (ZUNE_LOG_ENABLED(logger_, PPP, DEBUG)) {
+            std::ostringstream hex_dump;
+            hex_dump << "USB DATA RECEIVED (" << usb_data.size() << " bytes): ";
+            for (size_t i = 0; i < std::min(usb_data.size(), size_t(1024)); i++) {
+                hex_dump << std::hex << std::setw(2) << std::setfill('0')
+                         << (int)usb_data[i];
+                if ((i + 1) % 32 == 0) hex_dump << "\n  ";
+            }
+            if (usb_data.size() > 1024) hex_dump << "... (truncated)";
+            INTERCEPTOR_LOG(PPP, DEBUG, hex_dump.str());
         }
-        if (usb_data.size() > 1024) hex_dump << "... (truncated)";
-        VerboseLog(hex_dump.str());
 
         // Extract PPP frames from USB packet (handles incomplete frames spanning packets)
         std::vector<mtp::ByteArray> frames = PPPParser::ExtractFramesWithBuffer(
             usb_data, incomplete_ppp_frame_buffer_);
 
         if (!incomplete_ppp_frame_buffer_.empty()) {
-            VerboseLog("Buffering incomplete PPP frame (" +
+            INTERCEPTOR_LOG(PPP, DEBUG, "Buffering incomplete PPP frame (" +
                 std::to_string(incomplete_ppp_frame_buffer_.size()) + " bytes)");
         }
 
-        VerboseLog("Found " + std::to_string(frames.size()) + " PPP frame(s) in USB packet");
+        INTERCEPTOR_LOG(PPP, DEBUG, "Found " + std::to_string(frames.size()) + " PPP frame(s) in USB packet");
 
         // Process each PPP frame - this accumulates pending_sends_ but doesn't trigger sends
         // The caller (monitoring thread or DrainResponseQueue) decides when to trigger sends
         for (size_t frame_idx = 0; frame_idx < frames.size(); frame_idx++) {
-            VerboseLog("Processing PPP frame " + std::to_string(frame_idx + 1) + "/" +
+            INTERCEPTOR_LOG(PPP, DEBUG, "Processing PPP frame " + std::to_string(frame_idx + 1) + "/" +
                 std::to_string(frames.size()) + " (" + std::to_string(frames[frame_idx].size()) + " bytes)");
             ProcessPPPFrame(frames[frame_idx]);
         }
@@ -441,7 +493,7 @@ void ZuneHTTPInterceptor::ProcessPacket(const mtp::ByteArray& usb_data) {
         // This prevents recursive drain loops when ProcessPacket is called from DrainResponseQueue
 
     } catch (const std::exception& e) {
-        Log("Error processing packet: " + std::string(e.what()));
+        INTERCEPTOR_LOG(PPP, ERROR, "Error processing packet: " + std::string(e.what()));
     }
 }
 
@@ -450,36 +502,8 @@ void ZuneHTTPInterceptor::ProcessPendingSends() {
     // This is called from the monitoring thread (NOT from within DrainResponseQueue)
     // to prevent recursive drain loops
 
-    std::set<std::string> trans_keys_to_send;
-    {
-        std::lock_guard<std::mutex> lock(pending_sends_mutex_);
-        trans_keys_to_send = pending_sends_;
-        pending_sends_.clear();
-    }
-
-    for (const std::string& trans_key : trans_keys_to_send) {
-        // Parse trans_key format: "conn_key:base_seq"
-        // conn_key format: "192.168.55.101:50120->192.168.0.30:80"
-        // trans_key format: "192.168.55.101:50120->192.168.0.30:80:3052870019"
-        size_t arrow_pos = trans_key.find("->");
-        if (arrow_pos == std::string::npos) {
-            continue;
-        }
-
-        // Find the second colon after the arrow (port separator is first, base_seq separator is second)
-        size_t first_colon = trans_key.find(':', arrow_pos);
-        if (first_colon == std::string::npos) {
-            continue;
-        }
-        size_t second_colon = trans_key.find(':', first_colon + 1);
-        if (second_colon == std::string::npos) {
-            continue;
-        }
-
-        std::string conn_key = trans_key.substr(0, second_colon);
-        uint32_t base_seq = std::stoul(trans_key.substr(second_colon + 1));
-
-        SendNextBatch(conn_key, base_seq);
+    for (const PendingSend& pending : pending_sends_.TakeAll()) {
+        SendNextBatch(pending.conn_key, pending.base_seq);
     }
 }
 
@@ -504,11 +528,8 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
             // CCP (Compression Control Protocol): Handled by CCPHandler (Phase 5.2)
             auto ccp_response = ccp_handler_->HandlePacket(payload);
             if (ccp_response.has_value()) {
-                {
-                    std::lock_guard<std::mutex> lock(response_queue_mutex_);
-                    response_queue_.push_back(ccp_response.value());
-                    VerboseLog("CCP response queued (" + std::to_string(response_queue_.size()) + " total in queue)");
-                }  // Release mutex before draining
+                response_queue_.Push(ccp_response.value());
+                INTERCEPTOR_LOG(PPP, DEBUG, "CCP response queued (" + std::to_string(response_queue_.SizeApprox()) + " total in queue)");
 
                 // Drain immediately after queueing CCP response
                 DrainResponseQueue();
@@ -520,7 +541,7 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
             std::ostringstream hex_proto;
             hex_proto << "0x" << std::hex << std::setw(4) << std::setfill('0') << ppp_protocol
                      << " (" << PPPParser::GetProtocolName(ppp_protocol) << ")";
-            Log("Ignoring PPP protocol " + hex_proto.str());
+            INTERCEPTOR_LOG(PPP, INFO, "Ignoring PPP protocol " + hex_proto.str());
             return;
         }
 
@@ -535,7 +556,7 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
                                    (ip_header.protocol == 17) ? "UDP" :
                                    (ip_header.protocol == 1) ? "ICMP" :
                                    "OTHER(" + std::to_string(ip_header.protocol) + ")";
-        VerboseLog("IP packet: " + IPParser::IPToString(ip_header.src_ip) + " -> " +
+        INTERCEPTOR_LOG(PPP, DEBUG, "IP packet: " + IPParser::IPToString(ip_header.src_ip) + " -> " +
             IPParser::IPToString(ip_header.dst_ip) + " protocol=" + protocol_name);
 
         // Handle UDP (protocol 17) for DNS queries
@@ -547,7 +568,7 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
 
                 if (dst_port == 53) {
                     // DNS query
-                    Log("DNS query detected from port " + std::to_string(src_port));
+                    INTERCEPTOR_LOG(HTTP, INFO, "DNS query detected from port " + std::to_string(src_port));
                     HandleDNSQuery(ip_packet);
                 }
             }
@@ -563,15 +584,16 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
 
         // Step 4: Parse TCP header and extract HTTP data
         TCPParser::TCPHeader tcp_header = TCPParser::ParseHeader(tcp_segment);
+        TCPParser::Options tcp_options = TCPParser::ParseOptions(tcp_segment);
 
-        VerboseLog("TCP packet: " + IPParser::IPToString(ip_header.src_ip) + ":" +
+        INTERCEPTOR_LOG(TCP, DEBUG, "TCP packet: " + IPParser::IPToString(ip_header.src_ip) + ":" +
             std::to_string(tcp_header.src_port) + " -> " +
             IPParser::IPToString(ip_header.dst_ip) + ":" +
             std::to_string(tcp_header.dst_port) + " [" +
             TCPParser::FlagsToString(tcp_header.flags) + "]");
 
         // Update connection state
-        std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+        TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
             ip_header.src_ip, tcp_header.src_port,
             ip_header.dst_ip, tcp_header.dst_port);
 
@@ -584,7 +606,7 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
             ip_header.dst_ip, tcp_header.dst_port,
             tcp_header.seq_num, tcp_header.ack_num,
             tcp_header.flags, tcp_header.window_size,
-            tcp_payload
+            tcp_payload, tcp_options
         );
 
         // Send TCP response if manager generated one
@@ -612,37 +634,19 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
             // Delegate ALL ACK processing to TCPConnectionManager (SINGLE SOURCE OF TRUTH)
 
             uint32_t base_seq = tcp_manager_->ProcessACKForTransmission(
-                conn_key, tcp_header.ack_num, tcp_header.window_size);
+                conn_key, tcp_header.ack_num, tcp_header.window_size, tcp_options);
+
+            // Resend what the ACK showed lost, even once everything has been
+            // sent (the tail of a response would otherwise wait for the RTO)
+            SendRetransmits(conn_key);
 
             if (base_seq != 0) {
                 // TCPConnectionManager says we should send more segments
-                std::string trans_key = conn_key + ":" + std::to_string(base_seq);
-
-                VerboseLog("ACK processed by TCPConnectionManager: trans_key=" + trans_key);
-
-                // Check if fast retransmit is needed
-                uint32_t retransmit_base_seq;
-                size_t retransmit_segment_index;
-                if (tcp_manager_->CheckRetransmitNeeded(conn_key, retransmit_base_seq, retransmit_segment_index)) {
-                    // Handle fast retransmit
-                    mtp::ByteArray retransmit_frame = tcp_manager_->GetRetransmitSegment(
-                        conn_key, retransmit_base_seq, retransmit_segment_index);
-
-                    if (!retransmit_frame.empty()) {
-                        Log("Fast retransmit: segment " + std::to_string(retransmit_segment_index));
-                        {
-                            std::lock_guard<std::mutex> lock(response_queue_mutex_);
-                            response_queue_.push_back(retransmit_frame);
-                        }
-                        // CRITICAL: Actually send the retransmit frame!
-                        DrainResponseQueue();
-                    }
-                    tcp_manager_->ClearRetransmitFlag(conn_key);
-                }
+                INTERCEPTOR_LOG(TCP, DEBUG, "ACK processed by TCPConnectionManager: conn=" + conn_key.ToString() +
+                    " base_seq=" + std::to_string(base_seq));
 
                 // Add to pending sends for next batch
-                std::lock_guard<std::mutex> lock(pending_sends_mutex_);
-                pending_sends_.insert(trans_key);
+                pending_sends_.Add(conn_key, base_seq);
             }
 
             return;
@@ -650,25 +654,26 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
 
         // At this point, TCPConnectionManager has already added the payload to the reassembler.
         // The reassembler was initialized during HandleSYN with the correct initial sequence (seq_num + 1).
-        // We just use GetBuffer() to access the accumulated HTTP data.
+        // GetBuffer() views the accumulated HTTP data in place in its ring.
 
         // Sanity check: reassembler should always exist for ESTABLISHED connections
         if (!tcp_conn->reassembler) {
-            Log("ERROR: No reassembler for ESTABLISHED connection! This should never happen.");
+            INTERCEPTOR_LOG(TCP, ERROR, "ERROR: No reassembler for ESTABLISHED connection! This should never happen.");
             return;
         }
 
         // Check for Zune custom DNS protocol BEFORE HTTP (delegated to DNSHandler)
-        if (dns_handler_ && dns_handler_->IsZuneTCPDNSQuery(tcp_conn->reassembler->GetBuffer())) {
+        TCPStreamReassembler::StreamView stream = tcp_conn->reassembler->GetBuffer();
+        if (dns_handler_ && dns_handler_->IsZuneTCPDNSQuery(stream.data(), stream.size())) {
             size_t bytes_consumed = 0;
-            auto dns_response = dns_handler_->HandleTCPQuery(tcp_conn->reassembler->GetBuffer(), bytes_consumed);
+            auto dns_response = dns_handler_->HandleTCPQuery(stream.data(), stream.size(), bytes_consumed);
 
             if (dns_response) {
                 // Update connection state for response
                 tcp_conn->ack_num = tcp_header.seq_num + bytes_consumed;
 
                 // Send TCP response with DNS data
-                Log("Sending DNS response (" + std::to_string(dns_response->size()) + " bytes)");
+                INTERCEPTOR_LOG(HTTP, INFO, "Sending DNS response (" + std::to_string(dns_response->size()) + " bytes)");
                 SendTCPResponseWithData(
                     ip_header.dst_ip, tcp_header.dst_port,
                     ip_header.src_ip, tcp_header.src_port,
@@ -690,163 +695,319 @@ void ZuneHTTPInterceptor::ProcessPPPFrame(const mtp::ByteArray& frame_data) {
         // Process all complete HTTP requests in buffer (support HTTP pipelining)
         int pipelined_request_count = 0;
         while (true) {
-            HTTPParser::HTTPRequest parsed_request;
+            HTTPParser::RequestView parsed_request;
             size_t bytes_consumed = 0;
 
-            auto result = HTTPParser::TryExtractRequest(
-                tcp_conn->reassembler->GetBuffer(), parsed_request, bytes_consumed);
+            stream = tcp_conn->reassembler->GetBuffer();
+            auto result = HTTPParser::TryExtractRequestView(
+                stream.data(), stream.size(), parsed_request, bytes_consumed);
 
             if (result == HTTPParser::ExtractResult::INCOMPLETE) {
                 if (pipelined_request_count == 0 && !tcp_payload.empty()) {
-                    VerboseLog("TCP stream: buffering " + std::to_string(tcp_payload.size()) +
-                        " bytes (total: " + std::to_string(tcp_conn->reassembler->GetBuffer().size()) + " bytes)");
+                    INTERCEPTOR_LOG(TCP, DEBUG, "TCP stream: buffering " + std::to_string(tcp_payload.size()) +
+                        " bytes (total: " + std::to_string(stream.size()) + " bytes)");
                 }
                 break;
             }
 
             if (result == HTTPParser::ExtractResult::INVALID_DATA) {
-                VerboseLog("TCP stream: clearing stale data (" +
-                    std::to_string(tcp_conn->reassembler->GetBuffer().size()) + " bytes)");
+                INTERCEPTOR_LOG(TCP, DEBUG, "TCP stream: clearing stale data (" +
+                    std::to_string(stream.size()) + " bytes)");
                 tcp_conn->reassembler->ClearContiguousBuffer();
                 break;
             }
 
             // SUCCESS - process the request
             pipelined_request_count++;
-            VerboseLog("HTTP request received (" + std::to_string(bytes_consumed) + " bytes)" +
+            INTERCEPTOR_LOG(HTTP, DEBUG, "HTTP request received (" + std::to_string(bytes_consumed) + " bytes)" +
                 (pipelined_request_count > 1 ? " [pipelined #" + std::to_string(pipelined_request_count) + "]" : ""));
 
-            // Remove processed request from buffer
-            tcp_conn->reassembler->EraseProcessedBytes(bytes_consumed);
-
-            // Build interceptor request with TCP/IP context
+            // Build interceptor request with TCP/IP context, copied straight
+            // out of the buffer (the query is kept as sent)
             HTTPRequest interceptor_request;
-            interceptor_request.method = parsed_request.method;
-            interceptor_request.path = parsed_request.path;
-            interceptor_request.protocol = parsed_request.protocol;
-            interceptor_request.headers = parsed_request.headers;
-            interceptor_request.host = parsed_request.GetHeader("Host");
+            interceptor_request.method.assign(parsed_request.method);
+            interceptor_request.path.assign(parsed_request.path);
+            interceptor_request.protocol.assign(parsed_request.protocol);
+            if (!parsed_request.query.empty()) {
+                interceptor_request.query_string.reserve(parsed_request.query.size() + 1);
+                interceptor_request.query_string.assign("?").append(parsed_request.query);
+            }
+            for (size_t i = 0; i < parsed_request.header_count; i++) {
+                const auto& header = parsed_request.headers[i];
+                interceptor_request.headers[std::string(header.name)].assign(header.value);
+            }
+            interceptor_request.host.assign(parsed_request.GetHeader("Host"));
             interceptor_request.src_ip = ip_header.src_ip;
             interceptor_request.src_port = tcp_header.src_port;
             interceptor_request.dst_ip = ip_header.dst_ip;
             interceptor_request.dst_port = tcp_header.dst_port;
-            interceptor_request.seq_num = tcp_header.seq_num;
+            // A segment may carry several pipelined requests, or part of
+            // one: its response acknowledges up to the request's own end
+            interceptor_request.seq_num = tcp_conn->reassembler->GetNextExpectedSeq() -
+                                          static_cast<uint32_t>(stream.size());
             interceptor_request.ack_num = tcp_header.ack_num;
             interceptor_request.http_request_size = bytes_consumed;
+            interceptor_request.received_at = std::chrono::steady_clock::now();
+            interceptor_request.pipeline_index = tcp_conn->response_order.Assign();
 
-            // Reconstruct query string from query_params
-            if (!parsed_request.query_params.empty()) {
-                interceptor_request.query_string = "?";
-                bool first = true;
-                for (const auto& param : parsed_request.query_params) {
-                    if (!first) interceptor_request.query_string += "&";
-                    interceptor_request.query_string += param.first + "=" + param.second;
-                    first = false;
-                }
-            }
+            // Remove processed request from buffer (parsed_request views it)
+            tcp_conn->reassembler->Consume(bytes_consumed);
 
             HandleHTTPRequest(interceptor_request);
         }
 
     } catch (const std::exception& e) {
-        Log("Error processing packet: " + std::string(e.what()));
+        INTERCEPTOR_LOG(PPP, ERROR, "Error processing packet: " + std::string(e.what()));
     }
 }
 
 void ZuneHTTPInterceptor::HandleHTTPRequest(const HTTPRequest& request) {
-    Log("HTTP Request: " + request.method + " " + request.path);
-    Log("  Host: " + request.host);
+    INTERCEPTOR_LOG(HTTP, INFO, "HTTP Request: " + request.method + " " + request.path);
+    INTERCEPTOR_LOG(HTTP, INFO, "  Host: " + request.host);
+    metrics_.RecordRequest();
+
+    // Queue request for concurrent processing by worker thread pool.
+    // Pipelined requests on one connection are served in parallel; their
+    // responses are committed in request order (see ResponseSequencer).
+    // External hosts and anything the metadata handler cannot answer
+    // locally wait on a server, so they go to the slow lane.
+    bool external = request.host.find("microsoft.com") != std::string::npos;
+    HTTPParser::HTTPRequest handler_request = ToHandlerRequest(request);
+
+    if (config_.reactor && !external && metadata_handler_) {
+        // Reactor mode: answered here on the poll thread when no I/O is needed
+        HTTPParser::HTTPResponse response;
+        if (metadata_handler_->HandleFromMemory(handler_request, response)) {
+            SendHTTPResponse(request, std::move(response));
+            return;
+        }
+        completions_.Begin();
+    } else if (config_.reactor) {
+        completions_.Begin();
+    }
 
-    // Queue request for concurrent processing by worker thread pool
-    // TCP flow control prevents segment interleaving per connection
-    {
-        std::lock_guard<std::mutex> lock(request_queue_mutex_);
-        request_queue_.push(request);
-        request_queue_cv_.notify_one();  // Wake one worker to process this request
+    bool slow = external || (metadata_handler_ && !metadata_handler_->IsFastRequest(handler_request));
+    request_workers_.Push(slow ? RequestLane::Slow : RequestLane::Fast, request);
+}
+
+HTTPParser::HTTPRequest ZuneHTTPInterceptor::ToHandlerRequest(const HTTPRequest& request) {
+    HTTPParser::HTTPRequest simple_request;
+    simple_request.method = request.method;
+    simple_request.path = request.path;
+    simple_request.protocol = request.protocol;
+    simple_request.headers = request.headers;
+    if (!request.query_string.empty() && request.query_string[0] == '?') {
+        simple_request.query_params = HTTPParser::ParseQueryString(request.query_string.substr(1));
     }
+    return simple_request;
 }
 
-void ZuneHTTPInterceptor::RequestWorkerThread() {
-    while (running_.load()) {
-        HTTPRequest request;
+// ============================================================================
+// Streamed proxy responses
+// ============================================================================
 
-        // Wait for a request to be queued
-        {
-            std::unique_lock<std::mutex> lock(request_queue_mutex_);
-            request_queue_cv_.wait(lock, [this] {
-                return !request_queue_.empty() || !running_.load();
-            });
+/**
+ * Frames a proxied body into TCP segments while HttpClient downloads it.
+ * Begin reserves the SEQ range for header + Content-Length and starts the
+ * transmission with the header segment; each Write frames every complete
+ * MSS slice (and the final short one) and hands them to the transmission,
+ * so the device receives the start of the body before the download ends.
+ * A body that ends short cannot be completed: the connection is reset.
+ * A pipelined response streams only if every earlier response on the
+ * connection has committed; otherwise it is buffered and sent in turn.
+ */
+class ZuneHTTPInterceptor::StreamedResponse : public HttpClient::ResponseStream {
+public:
+    StreamedResponse(ZuneHTTPInterceptor& owner, const HTTPRequest& request)
+        : owner_(owner)
+        , request_(request)
+        , conn_key_(TCPConnectionManager::MakeConnectionKey(
+              request.src_ip, request.src_port, request.dst_ip, request.dst_port)) {}
+
+    bool Started() const { return started_; }
+
+    bool Begin(const HTTPParser::HTTPResponse& head, size_t content_length) override {
+        ResponseSequencer* order = owner_.ResponseOrder(request_);
+        if (!order) {
+            return Commit(head, content_length);
+        }
+        bool committed = false;
+        order->TryCommit(request_.pipeline_index, [&] { committed = Commit(head, content_length); });
+        return committed;
+    }
 
-            // Check if we're shutting down
-            if (!running_.load()) {
-                break;
-            }
+    // Reserve the whole response's SEQ range and start it with the header segment
+    bool Commit(const HTTPParser::HTTPResponse& head, size_t content_length) {
+        mtp::ByteArray header = HTTPParser::BuildResponseHeader(head);
 
-            // Get the next request
-            request = request_queue_.front();
-            request_queue_.pop();
+        std::vector<size_t> payload_sizes;
+        payload_sizes.reserve(1 + (content_length + TCPFlowController::MSS - 1) / TCPFlowController::MSS);
+        payload_sizes.push_back(header.size());
+        for (size_t offset = 0; offset < content_length; offset += TCPFlowController::MSS) {
+            payload_sizes.push_back(std::min(TCPFlowController::MSS, content_length - offset));
         }
 
-        // Process the request (outside the lock to allow new requests to be queued)
-        HTTPParser::HTTPResponse response;
+        if (!owner_.ReserveResponseRange(request_, header.size() + content_length, base_seq_, ack_num_)) {
+            return false;
+        }
+
+        // CCP frames queued earlier go ahead of the response, as in SendHTTPResponse
+        owner_.DrainResponseQueue();
+
+        std::vector<mtp::ByteArray> frames(1);
+        owner_.BuildResponseSegment(request_, base_seq_, ack_num_, false,
+                                    header.data(), header.size(), frames[0]);
+        next_seq_ = base_seq_ + static_cast<uint32_t>(header.size());
+        remaining_ = content_length;
+
+        ZUNE_LOG(owner_.logger_, "ZuneHTTPInterceptor", HTTP, INFO,
+                 "Streaming " + std::to_string(head.status_code) + " response (" +
+                 std::to_string(content_length) + " bytes, " +
+                 std::to_string(payload_sizes.size()) + " segments) as it downloads");
+        owner_.tcp_manager_->StartHTTPTransmission(conn_key_, base_seq_,
+                                                   std::move(frames), std::move(payload_sizes));
+        started_ = true;
+        owner_.metrics_.RecordResponseStart(request_.received_at);
+        owner_.SendNextBatch(conn_key_, base_seq_);
+        return true;
+    }
 
-        // Check if this is a request to an external server (go.microsoft.com, etc.)
-        if (request.host == "go.microsoft.com" || request.host.find("microsoft.com") != std::string::npos) {
-            std::string url = "http://" + request.host + request.path + request.query_string;
-            Log("Proxying external request: " + url);
-            response = HttpClient::FetchExternal(url);
+    bool Write(const uint8_t* data, size_t size) override {
+        // Slice straight from the download buffer; only a partial tail is kept
+        const uint8_t* bytes = data;
+        size_t available = size;
+        if (!pending_.empty()) {
+            pending_.insert(pending_.end(), data, data + size);
+            bytes = pending_.data();
+            available = pending_.size();
         }
-        else {
-            // Build simple_request ONCE for all handlers (was duplicated 3 times)
-            HTTPParser::HTTPRequest simple_request;
-            simple_request.method = request.method;
-            simple_request.path = request.path;
-            simple_request.protocol = request.protocol;
-            simple_request.headers = request.headers;
-            if (!request.query_string.empty() && request.query_string[0] == '?') {
-                simple_request.query_params = HTTPParser::ParseQueryString(request.query_string.substr(1));
-            }
 
-            if (metadata_handler_) {
-                response = metadata_handler_->HandleRequest(simple_request);
-            } else {
-                response = HTTPParser::BuildErrorResponse(503, "Service not configured");
-            }
+        std::vector<mtp::ByteArray> frames;
+        size_t offset = 0;
+        while (available - offset >= TCPFlowController::MSS ||
+               (offset < available && available - offset == remaining_)) {
+            size_t n = std::min(TCPFlowController::MSS, available - offset);
+            frames.emplace_back();
+            owner_.BuildResponseSegment(request_, next_seq_, ack_num_, n == remaining_,
+                                        bytes + offset, n, frames.back());
+            next_seq_ += static_cast<uint32_t>(n);
+            remaining_ -= n;
+            offset += n;
+        }
+
+        if (bytes == pending_.data()) {
+            pending_.erase(pending_.begin(), pending_.begin() + offset);
+        } else {
+            pending_.assign(bytes + offset, bytes + available);
+        }
+
+        if (frames.empty()) {
+            return true;
+        }
+        if (!owner_.tcp_manager_->AddHTTPSegments(conn_key_, base_seq_, std::move(frames))) {
+            ZUNE_LOG(owner_.logger_, "ZuneHTTPInterceptor", HTTP, INFO,
+                     "Streamed response: connection closed by device, stopping download");
+            return false;
         }
+        owner_.SendNextBatch(conn_key_, base_seq_);
+        return true;
+    }
+
+    void End(bool complete) override {
+        if (complete) {
+            return;
+        }
+        ZUNE_LOG(owner_.logger_, "ZuneHTTPInterceptor", HTTP, WARNING,
+                 "Streamed response ended " + std::to_string(remaining_ + pending_.size()) +
+                 " bytes short, resetting " + conn_key_.ToString());
+        owner_.tcp_manager_->ResetConnection(conn_key_);
+        owner_.SendTCPResponse(request_.dst_ip, request_.dst_port,
+                               request_.src_ip, request_.src_port,
+                               next_seq_, ack_num_,
+                               TCPParser::TCP_FLAG_RST | TCPParser::TCP_FLAG_ACK);
+    }
+
+private:
+    ZuneHTTPInterceptor& owner_;
+    const HTTPRequest& request_;
+    TCPConnectionKey conn_key_;
+    bool started_ = false;
+    uint32_t base_seq_ = 0;
+    uint32_t ack_num_ = 0;
+    uint32_t next_seq_ = 0;     // SEQ of the next body segment to frame
+    size_t remaining_ = 0;      // Body bytes not yet framed
+    mtp::ByteArray pending_;    // Body bytes short of a full segment
+};
+
+void ZuneHTTPInterceptor::ProcessRequest(const HTTPRequest& request) {
+    if (!running_.load()) {
+        return;
+    }
 
-        // Send HTTP response (flow control is handled by TCP layer)
-        SendHTTPResponse(request, response);
+    if (config_.reactor) {
+        // The poll thread sends it, with everything else it sends
+        completions_.Post(Completion{request, ResolveResponse(request, nullptr)});
+        return;
+    }
 
+    // Proxied bodies go out while they download; the rest are sent below
+    StreamedResponse stream(*this, request);
+    HTTPParser::HTTPResponse response = ResolveResponse(request, &stream);
+    if (stream.Started()) {
+        return;
     }
+
+    // Send HTTP response (flow control is handled by TCP layer)
+    SendHTTPResponse(request, std::move(response));
 }
 
-void ZuneHTTPInterceptor::SendNextBatch(const std::string& conn_key, uint32_t base_seq) {
-    try {
-        // Check for fast retransmit first
-        uint32_t retransmit_base_seq;
-        size_t retransmit_segment_index;
-        if (tcp_manager_->CheckRetransmitNeeded(conn_key, retransmit_base_seq, retransmit_segment_index)) {
-            VerboseLog("SendNextBatch: Fast retransmit needed for segment " +
-                std::to_string(retransmit_segment_index));
-
-            mtp::ByteArray retransmit_frame = tcp_manager_->GetRetransmitSegment(
-                conn_key, retransmit_base_seq, retransmit_segment_index);
-
-            if (!retransmit_frame.empty()) {
-                // Queue and send retransmit immediately
-                {
-                    std::lock_guard<std::mutex> queue_lock(response_queue_mutex_);
-                    response_queue_.push_back(retransmit_frame);
-                    VerboseLog("SendNextBatch: Queued retransmit frame (total in queue: " +
-                        std::to_string(response_queue_.size()) + ")");
-                }
-                DrainResponseQueue();
+HTTPParser::HTTPResponse ZuneHTTPInterceptor::ResolveResponse(const HTTPRequest& request,
+                                                              StreamedResponse* stream) {
+    // Check if this is a request to an external server (go.microsoft.com, etc.)
+    if (request.host == "go.microsoft.com" || request.host.find("microsoft.com") != std::string::npos) {
+        std::string url = "http://" + request.host + request.path + request.query_string;
+        INTERCEPTOR_LOG(HTTP, INFO, "Proxying external request: " + url);
+        return HttpClient::FetchExternal(url);
+    }
+    if (!metadata_handler_) {
+        return HTTPParser::BuildErrorResponse(503, "Service not configured");
+    }
+    return metadata_handler_->HandleRequest(ToHandlerRequest(request), stream);
+}
 
-                // Clear retransmit flag
-                tcp_manager_->ClearRetransmitFlag(conn_key);
-            }
-            // After retransmit, continue to send new segments (RFC 5681)
-        }
+void ZuneHTTPInterceptor::RunCompletions() {
+    size_t sent = completions_.Drain([this](Completion& done) {
+        SendHTTPResponse(done.request, std::move(done.response));
+    });
+    if (sent > 0) {
+        INTERCEPTOR_LOG(HTTP, DEBUG, "Sent " + std::to_string(sent) + " response(s) from the request workers");
+    }
+}
+
+RequestWorkerStats ZuneHTTPInterceptor::GetWorkerStats() const {
+    return request_workers_.GetStats();
+}
+
+InterceptorNetworkStats ZuneHTTPInterceptor::GetNetworkStats() const {
+    InterceptorNetworkStats stats;
+    stats.metrics = metrics_.GetSnapshot();
+    stats.response_queue_depth = response_queue_.SizeApprox();
+    stats.workers = request_workers_.GetStats();
+    if (ccp_handler_) {
+        stats.compression = ccp_handler_->GetStats();
+    }
+    if (tcp_manager_) {
+        stats.fast_retransmits = tcp_manager_->GetFastRetransmitCount();
+        stats.rto_retransmits = tcp_manager_->GetRTORetransmitCount();
+        stats.connections = tcp_manager_->GetConnectionStats();
+    }
+    return stats;
+}
+
+void ZuneHTTPInterceptor::SendNextBatch(const TCPConnectionKey& conn_key, uint32_t base_seq) {
+    try {
+        // Retransmits first (fast retransmit or RTO), then new segments (RFC 5681)
+        SendRetransmits(conn_key);
 
         // Get next batch of segments from TCPConnectionManager
         std::vector<mtp::ByteArray> frames_to_send;
@@ -855,149 +1016,186 @@ void ZuneHTTPInterceptor::SendNextBatch(const std::string& conn_key, uint32_t ba
         size_t num_segments = tcp_manager_->GetNextBatch(conn_key, base_seq, frames_to_send, is_last_batch);
 
         if (num_segments == 0) {
-            VerboseLog("SendNextBatch: No segments to send (window full or complete)");
+            INTERCEPTOR_LOG(TCP, DEBUG, "SendNextBatch: No segments to send (window full or complete)");
             return;
         }
 
-        VerboseLog("SendNextBatch: Sending batch of " + std::to_string(num_segments) +
-            " segments for " + conn_key + (is_last_batch ? " (LAST BATCH)" : ""));
+        INTERCEPTOR_LOG(TCP, DEBUG, "SendNextBatch: Sending batch of " + std::to_string(num_segments) +
+            " segments for " + conn_key.ToString() + (is_last_batch ? " (LAST BATCH)" : ""));
 
         // Queue the frames
-        {
-            std::lock_guard<std::mutex> queue_lock(response_queue_mutex_);
-            for (const auto& frame : frames_to_send) {
-                response_queue_.push_back(frame);
-            }
-            VerboseLog("SendNextBatch: Queued " + std::to_string(frames_to_send.size()) +
-                " frames (total in queue: " + std::to_string(response_queue_.size()) + ")");
+        for (const auto& frame : frames_to_send) {
+            response_queue_.Push(frame);
         }
+        INTERCEPTOR_LOG(PPP, DEBUG, "SendNextBatch: Queued " + std::to_string(frames_to_send.size()) +
+            " frames (total in queue: " + std::to_string(response_queue_.SizeApprox()) + ")");
 
         // Drain the queue to send frames immediately
         DrainResponseQueue();
 
     } catch (const std::exception& e) {
-        Log("Error in SendNextBatch: " + std::string(e.what()));
+        INTERCEPTOR_LOG(HTTP, ERROR, "Error in SendNextBatch: " + std::string(e.what()));
     }
 }
 
 void ZuneHTTPInterceptor::SendHTTPResponse(const HTTPRequest& request,
-                                          const HTTPParser::HTTPResponse& response) {
-    VerboseLog("Queueing HTTP response: " + std::to_string(response.status_code) +
-        " (" + std::to_string(response.body.size()) + " bytes)");
+                                          HTTPParser::HTTPResponse response) {
+    ResponseSequencer* order = ResponseOrder(request);
+    if (!order) {
+        CommitHTTPResponse(request, std::move(response));
+        return;
+    }
+    if (order->TryCommit(request.pipeline_index, [&] { CommitHTTPResponse(request, std::move(response)); })) {
+        return;
+    }
 
-    try {
-        // Build complete HTTP response (headers + body)
-        mtp::ByteArray http_data = HTTPParser::BuildResponse(response);
+    // An earlier response on this connection is still being served: park it
+    // for whoever commits that one
+    INTERCEPTOR_LOG(HTTP, DEBUG, "Holding pipelined response #" + std::to_string(request.pipeline_index) +
+        " until earlier responses are sent");
+    order->Submit(request.pipeline_index, [this, request, response = std::move(response)]() mutable {
+        CommitHTTPResponse(request, std::move(response));
+    });
+}
+
+ResponseSequencer* ZuneHTTPInterceptor::ResponseOrder(const HTTPRequest& request) {
+    if (request.pipeline_index == 0) {
+        return nullptr;
+    }
+    TCPConnectionInfo* tcp_conn = tcp_manager_->GetConnection(TCPConnectionManager::MakeConnectionKey(
+        request.src_ip, request.src_port, request.dst_ip, request.dst_port));
+    return tcp_conn ? &tcp_conn->response_order : nullptr;
+}
 
-        // TCP segmentation: split into header segment + body chunks
-        std::vector<mtp::ByteArray> segments = TCPConnectionManager::SegmentHTTPPayload(http_data);
+namespace {
+
+// What a lazily framed transmission frames from, held until it ends: the
+// response (a mapped body is shared, not copied) and its header segment
+struct FramedResponse {
+    HTTPRequest request;
+    HTTPParser::HTTPResponse response;
+    mtp::ByteArray header;
+    uint32_t base_seq = 0;
+    uint32_t ack_num = 0;
+    size_t segments = 0;
+};
 
-        VerboseLog("TCP segmentation: " + std::to_string(segments.size()) + " segments " +
-            "(header: " + std::to_string(segments[0].size()) + " bytes, " +
-            "body: " + std::to_string(http_data.size() - segments[0].size()) + " bytes in " +
-            std::to_string(segments.size() - 1) + " segments)");
+} // namespace
 
-        // Calculate total payload size for atomic sequence number range reservation
-        size_t total_payload_size = 0;
-        for (const auto& segment : segments) {
-            total_payload_size += segment.size();
+void ZuneHTTPInterceptor::CommitHTTPResponse(const HTTPRequest& request,
+                                            HTTPParser::HTTPResponse response) {
+    INTERCEPTOR_LOG(HTTP, DEBUG, "Queueing HTTP response: " + std::to_string(response.status_code) +
+        " (" + std::to_string(response.BodySize()) + " bytes)");
+
+    try {
+        // TCP segmentation: headers alone in the first segment, then MSS-sized
+        // slices of the body. Nothing is framed here: the transmission frames
+        // each slice straight from the body (or the mapped file behind it)
+        // as the window opens, and again for a retransmit.
+        auto framed = std::make_shared<FramedResponse>();
+        framed->header = HTTPParser::BuildResponseHeader(response);
+        size_t body_size = response.BodySize();
+
+        std::vector<size_t> payload_sizes;
+        payload_sizes.reserve(1 + (body_size + TCPFlowController::MSS - 1) / TCPFlowController::MSS);
+        payload_sizes.push_back(framed->header.size());
+        for (size_t offset = 0; offset < body_size; offset += TCPFlowController::MSS) {
+            payload_sizes.push_back(std::min(TCPFlowController::MSS, body_size - offset));
         }
 
-        std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+        INTERCEPTOR_LOG(TCP, DEBUG, "TCP segmentation: " + std::to_string(payload_sizes.size()) + " segments " +
+            "(header: " + std::to_string(framed->header.size()) + " bytes, " +
+            "body: " + std::to_string(body_size) + " bytes in " +
+            std::to_string(payload_sizes.size() - 1) + " segments)");
+
+        // Total payload size for atomic sequence number range reservation
+        size_t total_payload_size = framed->header.size() + body_size;
+
+        TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
             request.src_ip, request.src_port,  // Client (request source)
             request.dst_ip, request.dst_port   // Server (request destination)
         );
 
-        // Phase 5.3: Get TCP connection info for seq/ack numbers
-        TCPConnectionInfo* tcp_conn = tcp_manager_->GetConnection(conn_key);
-        if (!tcp_conn) {
-            Log("Error: TCP connection not found for HTTP response");
-            return;
-        }
-
         // CRITICAL: Atomically reserve the entire sequence number range
         // This allows multiple threads to send responses on the same connection concurrently
         // Each thread gets a non-overlapping sequence number range
-        uint32_t current_seq;
-        uint32_t final_ack_num;
-        {
-            std::lock_guard<std::mutex> seq_lock(tcp_conn->seq_num_mutex);
-            current_seq = tcp_conn->seq_num;  // Read current SEQ
-            final_ack_num = request.seq_num + request.http_request_size;
-            tcp_conn->seq_num = current_seq + total_payload_size;  // Reserve range
-            tcp_conn->ack_num = final_ack_num;
+        if (!ReserveResponseRange(request, total_payload_size, framed->base_seq, framed->ack_num)) {
+            return;
         }
 
-        std::lock_guard<std::mutex> drain_lock(drain_mutex_);
-
-
         // CCP Config-Reject frames can be queued asynchronously from the monitoring thread.
-        // If we don't drain them first, they'll get mixed with HTTP segments causing corruption.
+        // The queue is FIFO, so flushing them now keeps them ahead of the HTTP segments;
+        // if another thread is already draining, it sends them first.
         DrainResponseQueue();
 
-        // Build all PPP frames for this HTTP response using PPPFrameBuilder
-        std::vector<mtp::ByteArray> ppp_frames;
-        std::vector<size_t> payload_sizes;
-        uint32_t base_seq = current_seq;
-
-        for (size_t i = 0; i < segments.size(); i++) {
-            const auto& segment_data = segments[i];
-
-            // TCP flags: ACK on all, PSH only on last segment
-            uint8_t flags = TCPParser::TCP_FLAG_ACK;
-            if (i == segments.size() - 1) {
-                flags |= TCPParser::TCP_FLAG_PSH;
-            }
-
-            // Use PPPFrameBuilder (SINGLE SOURCE OF TRUTH for frame building)
-            mtp::ByteArray ppp_frame = PPPFrameBuilder::BuildTCPFrame(
-                request.dst_ip, request.dst_port,  // Swap: server as source
-                request.src_ip, request.src_port,  // Swap: client as dest
-                current_seq, final_ack_num,
-                flags, segment_data
-            );
-
-            ppp_frames.push_back(ppp_frame);
-            payload_sizes.push_back(segment_data.size());
-
-            VerboseLog("  Segment " + std::to_string(i+1) + "/" + std::to_string(segments.size()) +
-                ": SEQ=" + std::to_string(current_seq) + ", " + std::to_string(segment_data.size()) +
-                " bytes payload, " + std::to_string(ppp_frame.size()) + " bytes PPP frame");
-
-            // Diagnostic: dump frame header and FCS for segments around index 20-24
-            if (i >= 20 && i <= 25 && ppp_frame.size() >= 10) {
-                std::ostringstream dump;
-                dump << "  [DEBUG] Segment " << (i+1) << " frame: start=[";
-                for (size_t j = 0; j < std::min(size_t(10), ppp_frame.size()); j++) {
-                    dump << std::hex << std::setw(2) << std::setfill('0') << (int)ppp_frame[j] << " ";
-                }
-                dump << "], end=[";
-                size_t end_start = (ppp_frame.size() > 10) ? ppp_frame.size() - 10 : 0;
-                for (size_t j = end_start; j < ppp_frame.size(); j++) {
-                    dump << std::hex << std::setw(2) << std::setfill('0') << (int)ppp_frame[j] << " ";
-                }
-                dump << "]";
-                Log(dump.str());
+        framed->request = request;
+        framed->response = std::move(response);
+        framed->segments = payload_sizes.size();
+        uint32_t base_seq = framed->base_seq;
+
+        SegmentFramer framer = [framed](size_t index, mtp::ByteArray& frame) {
+            const uint8_t* payload = framed->header.data();
+            size_t size = framed->header.size();
+            uint32_t seq = framed->base_seq;
+            if (index > 0) {
+                size_t offset = (index - 1) * TCPFlowController::MSS;
+                payload = framed->response.BodyData() + offset;
+                size = std::min(TCPFlowController::MSS, framed->response.BodySize() - offset);
+                seq += static_cast<uint32_t>(framed->header.size() + offset);
             }
-
-            current_seq += segment_data.size();
-        }
-
-        VerboseLog("HTTP response prepared: " + std::to_string(segments.size()) + " segments ready for transmission");
+            BuildResponseSegment(framed->request, seq, framed->ack_num, index + 1 == framed->segments,
+                                 payload, size, frame);
+        };
 
         // Register transmission with TCPConnectionManager (SINGLE SOURCE OF TRUTH)
         // The manager handles all flow control, congestion control, and retransmission
-        tcp_manager_->StartHTTPTransmission(conn_key, base_seq,
-                                            std::move(ppp_frames), std::move(payload_sizes));
+        tcp_manager_->StartHTTPTransmission(conn_key, base_seq, std::move(framer), std::move(payload_sizes));
 
-        VerboseLog("Transmission registered with TCPConnectionManager: base_seq=" + std::to_string(base_seq));
+        INTERCEPTOR_LOG(TCP, DEBUG, "Transmission registered with TCPConnectionManager: base_seq=" + std::to_string(base_seq));
 
         // Send the first batch immediately
+        metrics_.RecordResponseStart(request.received_at);
         SendNextBatch(conn_key, base_seq);
 
     } catch (const std::exception& e) {
-        Log("Error queueing response: " + std::string(e.what()));
+        INTERCEPTOR_LOG(HTTP, ERROR, "Error queueing response: " + std::string(e.what()));
+    }
+}
+
+bool ZuneHTTPInterceptor::ReserveResponseRange(const HTTPRequest& request, size_t total_payload_size,
+                                               uint32_t& base_seq, uint32_t& ack_num) {
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
+        request.src_ip, request.src_port, request.dst_ip, request.dst_port);
+
+    // Phase 5.3: Get TCP connection info for seq/ack numbers
+    TCPConnectionInfo* tcp_conn = tcp_manager_->GetConnection(conn_key);
+    if (!tcp_conn) {
+        INTERCEPTOR_LOG(TCP, ERROR, "Error: TCP connection not found for HTTP response");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> seq_lock(tcp_conn->seq_num_mutex);
+    base_seq = tcp_conn->seq_num;  // Read current SEQ
+    ack_num = static_cast<uint32_t>(request.seq_num + request.http_request_size);
+    tcp_conn->seq_num = base_seq + static_cast<uint32_t>(total_payload_size);  // Reserve range
+    tcp_conn->ack_num = ack_num;
+    return true;
+}
+
+void ZuneHTTPInterceptor::BuildResponseSegment(const HTTPRequest& request, uint32_t seq_num, uint32_t ack_num,
+                                               bool last, const uint8_t* payload, size_t size,
+                                               mtp::ByteArray& frame) {
+    // TCP flags: ACK on all, PSH only on last segment
+    uint8_t flags = TCPParser::TCP_FLAG_ACK;
+    if (last) {
+        flags |= TCPParser::TCP_FLAG_PSH;
     }
+
+    // Use PPPFrameBuilder (SINGLE SOURCE OF TRUTH for frame building)
+    PPPFrameBuilder::BuildTCPFrame(
+        request.dst_ip, request.dst_port,  // Swap: server as source
+        request.src_ip, request.src_port,  // Swap: client as dest
+        seq_num, ack_num, flags, payload, size, frame);
 }
 
 void ZuneHTTPInterceptor::SendTCPResponse(uint32_t src_ip, uint16_t src_port,
@@ -1008,37 +1206,35 @@ void ZuneHTTPInterceptor::SendTCPResponse(uint32_t src_ip, uint16_t src_port,
         mtp::ByteArray ppp_frame = PPPFrameBuilder::BuildTCPFrame(
             src_ip, src_port, dst_ip, dst_port, seq_num, ack_num, flags);
 
-        {
-            std::lock_guard<std::mutex> lock(response_queue_mutex_);
-            response_queue_.push_back(ppp_frame);
-            VerboseLog("TCP " + TCPParser::FlagsToString(flags) + " queued: " +
-                IPParser::IPToString(src_ip) + ":" + std::to_string(src_port) + " -> " +
-                IPParser::IPToString(dst_ip) + ":" + std::to_string(dst_port) +
-                " (" + std::to_string(response_queue_.size()) + " total in queue)");
-        }
+        response_queue_.Push(ppp_frame);
+        INTERCEPTOR_LOG(TCP, DEBUG, "TCP " + TCPParser::FlagsToString(flags) + " queued: " +
+            IPParser::IPToString(src_ip) + ":" + std::to_string(src_port) + " -> " +
+            IPParser::IPToString(dst_ip) + ":" + std::to_string(dst_port) +
+            " (" + std::to_string(response_queue_.SizeApprox()) + " total in queue)");
         DrainResponseQueue();
     } catch (const std::exception& e) {
-        Log("Error queueing TCP response: " + std::string(e.what()));
+        INTERCEPTOR_LOG(TCP, ERROR, "Error queueing TCP response: " + std::string(e.what()));
     }
 }
 
 void ZuneHTTPInterceptor::SendTCPPacket(const TCPPacket& packet) {
     try {
-        mtp::ByteArray ppp_frame = PPPFrameBuilder::BuildTCPFrame(
-            packet.src_ip, packet.src_port, packet.dst_ip, packet.dst_port,
-            packet.seq_num, packet.ack_num, packet.flags, packet.payload);
-
-        {
-            std::lock_guard<std::mutex> lock(response_queue_mutex_);
-            response_queue_.push_back(ppp_frame);
-            VerboseLog("TCP " + TCPParser::FlagsToString(packet.flags) + " queued: " +
-                IPParser::IPToString(packet.src_ip) + ":" + std::to_string(packet.src_port) + " -> " +
-                IPParser::IPToString(packet.dst_ip) + ":" + std::to_string(packet.dst_port) +
-                " (" + std::to_string(response_queue_.size()) + " total in queue)");
-        }
+        mtp::ByteArray ppp_frame = packet.options.empty()
+            ? PPPFrameBuilder::BuildTCPFrame(
+                  packet.src_ip, packet.src_port, packet.dst_ip, packet.dst_port,
+                  packet.seq_num, packet.ack_num, packet.flags, packet.payload)
+            : PPPFrameBuilder::BuildTCPFrameWithOptions(
+                  packet.src_ip, packet.src_port, packet.dst_ip, packet.dst_port,
+                  packet.seq_num, packet.ack_num, packet.flags, packet.options, packet.payload);
+
+        response_queue_.Push(ppp_frame);
+        INTERCEPTOR_LOG(TCP, DEBUG, "TCP " + TCPParser::FlagsToString(packet.flags) + " queued: " +
+            IPParser::IPToString(packet.src_ip) + ":" + std::to_string(packet.src_port) + " -> " +
+            IPParser::IPToString(packet.dst_ip) + ":" + std::to_string(packet.dst_port) +
+            " (" + std::to_string(response_queue_.SizeApprox()) + " total in queue)");
         DrainResponseQueue();
     } catch (const std::exception& e) {
-        Log("Error sending TCP packet: " + std::string(e.what()));
+        INTERCEPTOR_LOG(TCP, ERROR, "Error sending TCP packet: " + std::string(e.what()));
     }
 }
 
@@ -1050,35 +1246,45 @@ void ZuneHTTPInterceptor::SendTCPResponseWithData(uint32_t src_ip, uint16_t src_
         mtp::ByteArray ppp_frame = PPPFrameBuilder::BuildTCPFrame(
             src_ip, src_port, dst_ip, dst_port, seq_num, ack_num, flags, data);
 
-        {
-            std::lock_guard<std::mutex> lock(response_queue_mutex_);
-            response_queue_.push_back(ppp_frame);
-            VerboseLog("TCP " + TCPParser::FlagsToString(flags) + " with data queued: " +
-                IPParser::IPToString(src_ip) + ":" + std::to_string(src_port) + " -> " +
-                IPParser::IPToString(dst_ip) + ":" + std::to_string(dst_port) +
-                " (data: " + std::to_string(data.size()) + " bytes, " +
-                std::to_string(response_queue_.size()) + " total in queue)");
-        }
+        response_queue_.Push(ppp_frame);
+        INTERCEPTOR_LOG(TCP, DEBUG, "TCP " + TCPParser::FlagsToString(flags) + " with data queued: " +
+            IPParser::IPToString(src_ip) + ":" + std::to_string(src_port) + " -> " +
+            IPParser::IPToString(dst_ip) + ":" + std::to_string(dst_port) +
+            " (data: " + std::to_string(data.size()) + " bytes, " +
+            std::to_string(response_queue_.SizeApprox()) + " total in queue)");
         DrainResponseQueue();
     } catch (const std::exception& e) {
-        Log("Error queueing TCP response with data: " + std::string(e.what()));
+        INTERCEPTOR_LOG(TCP, ERROR, "Error queueing TCP response with data: " + std::string(e.what()));
     }
 }
 
 void ZuneHTTPInterceptor::DrainResponseQueue() {
-
-    // Check initial queue size outside lock to avoid holding mutex during entire drain
-    size_t initial_queue_size = 0;
-    {
-        std::lock_guard<std::mutex> lock(response_queue_mutex_);
-        initial_queue_size = response_queue_.size();
+    // Inside a poll cycle: its DrainHold sends everything at the end
+    if (drain_held_by_.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+        return;
     }
 
+    // One drain at a time. Anyone else's frames are already in the queue and
+    // the active drain sends them; a drain re-entered through ProcessPacket
+    // below returns here and the outer loop picks its frames up.
+    do {
+        if (!response_queue_.TryBeginDrain()) {
+            return;
+        }
+        if (!DrainQueuedFrames()) {
+            response_queue_.EndDrain();
+            return;  // USB error: leave the rest for the next drain
+        }
+    } while (response_queue_.EndDrain());
+}
+
+bool ZuneHTTPInterceptor::DrainQueuedFrames() {
+    size_t initial_queue_size = response_queue_.SizeApprox();
     if (initial_queue_size == 0) {
-        return;  // Nothing to drain
+        return true;  // Nothing to drain
     }
 
-    VerboseLog("Draining " + std::to_string(initial_queue_size) + " queued frame(s) via 0x922c");
+    INTERCEPTOR_LOG(PPP, DEBUG, "Draining " + std::to_string(initial_queue_size) + " queued frame(s) via 0x922c");
 
     // REACTIVE SEND LOOP - matches official Zune software behavior:
     // Analysis of official captures shows:
@@ -1087,117 +1293,143 @@ void ZuneHTTPInterceptor::DrainResponseQueue() {
     // - 86.5% of sends happen AFTER receiving an ACK
     // - Max 2-3 back-to-back sends without ACK
 
-    constexpr size_t USB_MAX_TRANSFER = 7680;  // Match official: ~7600-7627 bytes per operation
+    // Frames are packed up to the transfer budget (official: ~7600-7627
+    // bytes per operation); see FrameCoalescer
+    const size_t usb_max_transfer = coalescer_.Budget();
     int consecutive_sends = 0;
     constexpr int MAX_CONSECUTIVE_SENDS = 2;  // Official does max 2-3 back-to-back
 
-    while (true) {
-        mtp::ByteArray combined_payload;
+    mtp::ByteArray& combined_payload = drain_buffer_;
+    combined_payload.reserve(usb_max_transfer);
 
-        {
-            std::lock_guard<std::mutex> lock(response_queue_mutex_);
-            if (response_queue_.empty()) {
-                break;  // Queue drained
-            }
+    while (true) {
+        combined_payload.clear();
 
-            while (!response_queue_.empty()) {
-                const size_t space_left = USB_MAX_TRANSFER - combined_payload.size();
-                const auto& front_frame = response_queue_.front();
-
-                if (front_frame.size() <= space_left) {
-                    // Whole frame fits - append and pop
-                    combined_payload.insert(combined_payload.end(),
-                                           front_frame.begin(),
-                                           front_frame.end());
-                    response_queue_.pop_front();  // O(1) with deque
-                } else if (space_left > 0) {
-                    // Frame too large - split it
-                    combined_payload.insert(combined_payload.end(),
-                                           front_frame.begin(),
-                                           front_frame.begin() + space_left);
-
-                    // Replace front with remainder
-                    response_queue_.front() = mtp::ByteArray(
-                        front_frame.begin() + space_left,
-                        front_frame.end());
-
-                    VerboseLog("  Split frame: sent " + std::to_string(space_left) +
-                              " bytes, " + std::to_string(response_queue_.front().size()) +
+        while (true) {
+            const uint8_t* frame_data = nullptr;
+            size_t frame_size = 0;
+            while (combined_payload.size() < usb_max_transfer &&
+                   PeekOutboundFrame(frame_data, frame_size)) {
+                const size_t space_left = usb_max_transfer - combined_payload.size();
+                const size_t take = std::min(frame_size, space_left);
+                combined_payload.insert(combined_payload.end(), frame_data, frame_data + take);
+                ConsumeOutboundFrame(take);
+
+                if (take < frame_size) {
+                    // Frame too large - the rest goes out in the next transfer
+                    INTERCEPTOR_LOG(PPP, DEBUG, "  Split frame: sent " + std::to_string(take) +
+                              " bytes, " + std::to_string(frame_size - take) +
                               " bytes remaining");
                     break;
-                } else {
-                    break;  // Transfer full
                 }
             }
+
+            // Room left and the queue is empty: wait briefly for more frames
+            // if another thread has been producing them
+            if (combined_payload.empty() || combined_payload.size() >= usb_max_transfer) {
+                break;
+            }
+            auto wait = coalescer_.WaitFor(combined_payload.size());
+            if (wait.count() == 0) {
+                break;
+            }
+            bool more = response_queue_.WaitForFrame(wait);
+            coalescer_.OnWaited(more);
+            if (!more) {
+                break;
+            }
+        }
+
+        if (combined_payload.empty()) {
+            break;  // Queue drained
         }
 
-        if (!combined_payload.empty()) {
-            try {
-                // Send via Operation922c
-                session_->Operation922c(combined_payload, 3, 3);
-                consecutive_sends++;
+        try {
+            // Send via Operation922c
+            Send922c(combined_payload);
+            coalescer_.OnSent(combined_payload.size(),
+                              !response_queue_.Empty() || compressed_offset_ < compressed_frame_.size());
+            metrics_.RecordTransfer(combined_payload.size());
+            consecutive_sends++;
+
+            size_t remaining_frames = response_queue_.SizeApprox();
+
+            INTERCEPTOR_LOG(PPP, DEBUG, "  [OK] Sent " + std::to_string(combined_payload.size()) + " bytes via 0x922c" +
+                " (send #" + std::to_string(consecutive_sends) + ")" +
+                (remaining_frames == 0 ? "" : " (" + std::to_string(remaining_frames) + " frames remaining)"));
+
+            // REACTIVE: Poll for incoming data after each send
+            // This matches official software behavior where 922d polls happen after 922c sends
+            // (unless the poll thread is reading the device: it processes the ACKs then)
+            std::unique_lock<std::mutex> receive(receive_mutex_, std::try_to_lock);
+            if (remaining_frames > 0 && HasDeviceLink() && receive.owns_lock()) {
+                try {
+                    mtp::ByteArray poll_response = Poll922d();
 
-                size_t remaining_frames = 0;
-                {
-                    std::lock_guard<std::mutex> lock(response_queue_mutex_);
-                    remaining_frames = response_queue_.size();
+                    if (!poll_response.empty() && poll_response.size() > 6) {
+                        // Process any incoming data (ACKs will update TCP window)
+                        INTERCEPTOR_LOG(PPP, DEBUG, "  Poll returned " + std::to_string(poll_response.size()) + " bytes");
+                        ProcessPacket(poll_response);
+                        consecutive_sends = 0;  // Reset counter after receiving data
+                    }
+                } catch (const std::exception& e) {
+                    // Poll failed - continue sending
+                    INTERCEPTOR_LOG(PPP, DEBUG, "  Poll failed: " + std::string(e.what()));
                 }
 
-                VerboseLog("  [OK] Sent " + std::to_string(combined_payload.size()) + " bytes via 0x922c" +
-                    " (send #" + std::to_string(consecutive_sends) + ")" +
-                    (remaining_frames == 0 ? "" : " (" + std::to_string(remaining_frames) + " frames remaining)"));
-
-                // REACTIVE: Poll for incoming data after each send
-                // This matches official software behavior where 922d polls happen after 922c sends
-                if (remaining_frames > 0 && session_) {
+                // After MAX_CONSECUTIVE_SENDS, do an extra poll to allow device to catch up
+                // This matches official behavior of rarely sending more than 2-3 back-to-back
+                if (consecutive_sends >= MAX_CONSECUTIVE_SENDS && remaining_frames > 0) {
+                    INTERCEPTOR_LOG(PPP, DEBUG, "  Reached " + std::to_string(MAX_CONSECUTIVE_SENDS) +
+                              " consecutive sends, extra poll for device to catch up");
                     try {
-                        mtp::ByteArray poll_response = session_->Operation922d(3, 3);
-
-                        if (!poll_response.empty() && poll_response.size() > 6) {
-                            // Process any incoming data (ACKs will update TCP window)
-                            VerboseLog("  Poll returned " + std::to_string(poll_response.size()) + " bytes");
-                            ProcessPacket(poll_response);
-                            consecutive_sends = 0;  // Reset counter after receiving data
+                        mtp::ByteArray extra_response = Poll922d();
+                        if (!extra_response.empty() && extra_response.size() > 6) {
+                            ProcessPacket(extra_response);
                         }
-                    } catch (const std::exception& e) {
-                        // Poll failed - continue sending
-                        VerboseLog("  Poll failed: " + std::string(e.what()));
-                    }
-
-                    // After MAX_CONSECUTIVE_SENDS, do an extra poll to allow device to catch up
-                    // This matches official behavior of rarely sending more than 2-3 back-to-back
-                    if (consecutive_sends >= MAX_CONSECUTIVE_SENDS && remaining_frames > 0) {
-                        VerboseLog("  Reached " + std::to_string(MAX_CONSECUTIVE_SENDS) +
-                                  " consecutive sends, extra poll for device to catch up");
-                        try {
-                            mtp::ByteArray extra_response = session_->Operation922d(3, 3);
-                            if (!extra_response.empty() && extra_response.size() > 6) {
-                                ProcessPacket(extra_response);
-                            }
-                        } catch (...) {}
-                        consecutive_sends = 0;
-                    }
+                    } catch (...) {}
+                    consecutive_sends = 0;
                 }
-
-            } catch (const std::exception& e) {
-                Log("Error sending via 0x922c: " + std::string(e.what()));
-                break;  // Stop draining on error
             }
+
+        } catch (const std::exception& e) {
+            INTERCEPTOR_LOG(PPP, ERROR, "Error sending via 0x922c: " + std::string(e.what()));
+            return false;  // Stop draining on error
         }
     }
 
-    VerboseLog("Queue drained - reactive send loop complete");
+    INTERCEPTOR_LOG(PPP, DEBUG, "Queue drained - reactive send loop complete");
+    return true;
 }
 
-void ZuneHTTPInterceptor::Log(const std::string& message) {
-    if (log_callback_) {
-        log_callback_("[ZuneHTTPInterceptor] " + message);
+bool ZuneHTTPInterceptor::PeekOutboundFrame(const uint8_t*& data, size_t& size) {
+    if (compressed_offset_ < compressed_frame_.size()) {
+        data = compressed_frame_.data() + compressed_offset_;
+        size = compressed_frame_.size() - compressed_offset_;
+        return true;
+    }
+    if (!response_queue_.Peek(data, size)) {
+        return false;
+    }
+
+    // Compress whole frames only, in send order. The rest of a split frame
+    // never starts with a flag followed by more bytes: stuffed content has
+    // no 0x7E, so that is just the closing flag.
+    if (size > 1 && data[0] == 0x7E && ccp_handler_ &&
+        ccp_handler_->CompressFrame(data, size, compressed_frame_)) {
+        response_queue_.Consume(size);
+        compressed_offset_ = 0;
+        data = compressed_frame_.data();
+        size = compressed_frame_.size();
     }
+    return true;
 }
 
-void ZuneHTTPInterceptor::VerboseLog(const std::string& message) {
-    if (verbose_logging_) {
-        Log(message);
+void ZuneHTTPInterceptor::ConsumeOutboundFrame(size_t n) {
+    if (compressed_offset_ < compressed_frame_.size()) {
+        compressed_offset_ += n;
+    } else {
+        response_queue_.Consume(n);
     }
 }
 
@@ -1210,13 +1442,71 @@ void ZuneHTTPInterceptor::InitializeDNSHostnameMap(uint32_t dns_target_ip) {
     dns_hostname_map_["go.microsoft.com"] = dns_target_ip;
 }
 
-void ZuneHTTPInterceptor::SetVerboseLogging(bool enable) {
-    verbose_logging_ = enable;
-    if (!enable) {
-        Log("Verbose network logging disabled");
-    } else {
-        Log("Verbose network logging enabled");
+void ZuneHTTPInterceptor::SetTransferStats(zune::TransferStats* stats) {
+    transfer_stats_ = stats;
+}
+
+void ZuneHTTPInterceptor::SetMtpScheduler(zune::MtpScheduler* scheduler) {
+    mtp_scheduler_ = scheduler;
+}
+
+void ZuneHTTPInterceptor::SetResponseCache(MetadataResponseCache* cache) {
+    response_cache_ = cache;
+}
+
+void ZuneHTTPInterceptor::SetImageVariantCache(ImageVariantCache* cache) {
+    image_variants_ = cache;
+}
+
+void ZuneHTTPInterceptor::SetDiskCache(MetadataDiskCache* cache) {
+    disk_cache_ = cache;
+}
+
+void ZuneHTTPInterceptor::SetPacketCapture(PacketCapture* capture) {
+    packet_capture_ = capture;
+}
+
+void ZuneHTTPInterceptor::SetLinkProfile(PPPLinkProfile* profile) {
+    link_profile_ = profile;
+}
+
+void ZuneHTTPInterceptor::Send922c(const mtp::ByteArray& payload) {
+    if (packet_capture_) {
+        packet_capture_->Record(PacketCapture::Direction::ToDevice, payload);
     }
+    zune::MtpScheduler::Run(mtp_scheduler_, ZUNE_MTP_CLASS_NETWORK, [&] {
+        auto start = std::chrono::steady_clock::now();
+        zune::TransferStats::Measure(transfer_stats_, ZUNE_TRANSFER_OP_NETWORK_SEND, payload.size(),
+                                     [&] { DeviceOperation922c(payload); });
+        // Completion rate paces the USB link congestion control
+        if (tcp_manager_) {
+            tcp_manager_->RecordLinkTransfer(payload.size(),
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+        }
+    });
+}
+
+mtp::ByteArray ZuneHTTPInterceptor::Poll922d() {
+    return zune::MtpScheduler::Run(mtp_scheduler_, ZUNE_MTP_CLASS_NETWORK, [&] {
+        return zune::TransferStats::Measure(transfer_stats_, ZUNE_TRANSFER_OP_NETWORK_POLL, 0,
+                                            [&] { return DeviceOperation922d(); });
+    });
+}
+
+bool ZuneHTTPInterceptor::HasDeviceLink() const {
+    return session_ != nullptr;
+}
+
+void ZuneHTTPInterceptor::WaitForDeviceEvent(int timeout_ms) {
+    session_->PollEvent(timeout_ms);
+}
+
+void ZuneHTTPInterceptor::DeviceOperation922c(const mtp::ByteArray& payload) {
+    session_->Operation922c(payload, 3, 3);
+}
+
+mtp::ByteArray ZuneHTTPInterceptor::DeviceOperation922d() {
+    return session_->Operation922d(3, 3);
 }
 
 void ZuneHTTPInterceptor::HandleIPCPPacket(const mtp::ByteArray& ipcp_data) {
@@ -1225,10 +1515,10 @@ void ZuneHTTPInterceptor::HandleIPCPPacket(const mtp::ByteArray& ipcp_data) {
     // wasn't completed properly. Just log it for debugging.
     try {
         IPCPParser::IPCPPacket packet = IPCPParser::ParsePacket(ipcp_data);
-        VerboseLog("IPCP packet received in monitoring thread: code=" + std::to_string(packet.code) +
+        INTERCEPTOR_LOG(PPP, DEBUG, "IPCP packet received in monitoring thread: code=" + std::to_string(packet.code) +
             " id=" + std::to_string(packet.identifier) + " (unexpected - negotiation should be complete)");
     } catch (const std::exception& e) {
-        Log("Error parsing IPCP packet: " + std::string(e.what()));
+        INTERCEPTOR_LOG(PPP, ERROR, "Error parsing IPCP packet: " + std::string(e.what()));
     }
 }
 
@@ -1238,16 +1528,9 @@ void ZuneHTTPInterceptor::InitializeDNSForTesting(const std::string& server_ip)
 }
 
 void ZuneHTTPInterceptor::EnableNetworkPolling() {
-    // Start timeout checker thread (Phase 2: RTO integration)
-    if (!timeout_checker_thread_) {
-        Log("Starting timeout checker thread...");
-        timeout_checker_running_.store(true);
-        timeout_checker_thread_ = std::make_unique<std::thread>(&ZuneHTTPInterceptor::TimeoutCheckerThread, this);
-        Log("Timeout checker thread started");
-    }
-
-    // C# drives polling via PollOnce() — no native monitoring thread
-    Log("Network polling enabled — C# will drive via PollOnce()");
+    // C# drives polling via PollOnce() — no native monitoring thread.
+    // PollOnce also fires RTO retransmits, so there is no timer thread either.
+    INTERCEPTOR_LOG(PPP, INFO, "Network polling enabled — C# will drive via PollOnce()");
     network_polling_enabled_.store(true);
 }
 
@@ -1255,58 +1538,78 @@ void ZuneHTTPInterceptor::EnableNetworkPolling() {
 // RTO Timeout Checking (Phase 2: RTO Integration)
 // ============================================================================
 
-void ZuneHTTPInterceptor::TimeoutCheckerThread() {
-    Log("Timeout checker thread started - checking every 100ms");
-
-    while (timeout_checker_running_.load()) {
-        try {
-            // Check all active connections for timeouts
-            CheckAllConnectionTimeouts();
-
-            // Sleep for 100ms (check 10 times per second)
-            // RTO minimum is 1000ms, so 100ms granularity is sufficient
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-        } catch (const std::exception& e) {
-            if (timeout_checker_running_.load()) {
-                Log("Error in timeout checker thread: " + std::string(e.what()));
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
-        }
+bool ZuneHTTPInterceptor::HasActiveTransmissions() const {
+    if (!running_.load() || !tcp_manager_) {
+        return false;
     }
+    return !response_queue_.Empty() || tcp_manager_->NextTimeoutDeadline().has_value() ||
+           completions_.Outstanding() > 0;
+}
 
-    Log("Timeout checker thread stopped");
+int ZuneHTTPInterceptor::TimeoutWaitMs(int timeout_ms) const {
+    if (completions_.Ready()) {
+        return 0;  // Responses to send
+    }
+    auto deadline = tcp_manager_->NextTimeoutDeadline();
+    if (!deadline) {
+        return timeout_ms;  // Nothing in flight
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (*deadline <= now) {
+        return 0;
+    }
+    // Rounded up, so the wakeup is never before the deadline
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(*deadline - now).count();
+    if (timeout_ms >= 0 && wait >= timeout_ms) {
+        return timeout_ms;
+    }
+    return static_cast<int>(wait);
 }
 
 void ZuneHTTPInterceptor::CheckAllConnectionTimeouts() {
-    // Delegate timeout checking to TCPConnectionManager
-    auto timed_out_map = tcp_manager_->CheckAllTimeouts();
+    // Only the RTO timers due by now; nothing is scanned while idle
+    auto timed_out = tcp_manager_->CheckAllTimeouts();
+    if (timed_out.empty()) {
+        return;
+    }
 
     // Handle each timed-out segment
-    for (const auto& [conn_key, segments] : timed_out_map) {
+    for (const auto& [conn_key, segments] : timed_out) {
         for (const auto& segment : segments) {
             RetransmitSegment(conn_key, segment);
         }
     }
+
+    ProcessPendingSends();
+}
+
+void ZuneHTTPInterceptor::SendRetransmits(const TCPConnectionKey& conn_key) {
+    std::vector<mtp::ByteArray> frames;
+    if (tcp_manager_->TakeRetransmitFrames(conn_key, frames) == 0) {
+        return;
+    }
+
+    INTERCEPTOR_LOG(TCP, INFO, "Retransmitting " + std::to_string(frames.size()) + " segment(s): conn=" +
+        conn_key.ToString());
+    for (const mtp::ByteArray& frame : frames) {
+        response_queue_.Push(frame);
+    }
+    DrainResponseQueue();
 }
 
-void ZuneHTTPInterceptor::RetransmitSegment(const std::string& conn_key, const SentSegment& segment) {
-    Log("RTO timeout - retransmitting segment: conn=" + conn_key +
+void ZuneHTTPInterceptor::RetransmitSegment(const TCPConnectionKey& conn_key, const SentSegment& segment) {
+    INTERCEPTOR_LOG(TCP, INFO, "RTO timeout - retransmitting segment: conn=" + conn_key.ToString() +
         " SEQ=" + std::to_string(segment.seq_start) +
-        " size=" + std::to_string(segment.data.size()) + " bytes");
+        " size=" + std::to_string(segment.seq_end - segment.seq_start) + " bytes");
 
     // Delegate to TCPConnectionManager to find and mark the segment
     uint32_t base_seq;
     size_t segment_index;
     if (tcp_manager_->HandleRTORetransmit(conn_key, segment, base_seq, segment_index)) {
         // Queue the send for this connection
-        std::string trans_key = conn_key + ":" + std::to_string(base_seq);
-        {
-            std::lock_guard<std::mutex> pending_lock(pending_sends_mutex_);
-            pending_sends_.insert(trans_key);
-        }
+        pending_sends_.Add(conn_key, base_seq);
     } else {
-        Log("WARNING: Could not find transmission state for timed-out segment");
+        INTERCEPTOR_LOG(TCP, WARNING, "WARNING: Could not find transmission state for timed-out segment");
     }
 }
 
@@ -1315,11 +1618,8 @@ void ZuneHTTPInterceptor::HandleDNSQuery(const mtp::ByteArray& ip_packet) {
     auto dns_response = dns_handler_->HandleQuery(ip_packet);
 
     if (dns_response.has_value()) {
-        {
-            std::lock_guard<std::mutex> lock(response_queue_mutex_);
-            response_queue_.push_back(dns_response.value());
-            VerboseLog("DNS response queued (" + std::to_string(response_queue_.size()) + " total in queue)");
-        }  // Release mutex before draining
+        response_queue_.Push(dns_response.value());
+        INTERCEPTOR_LOG(HTTP, DEBUG, "DNS response queued (" + std::to_string(response_queue_.SizeApprox()) + " total in queue)");
 
         // Drain immediately after queueing DNS response
         DrainResponseQueue();
@@ -7,7 +7,6 @@
 #include <mutex>
 #include <functional>
 #include <map>
-#include <queue>
 #include <deque>
 #include <set>
 #include <condition_variable>
@@ -20,12 +19,23 @@
 
 // Forward declarations
 class MetadataRequestHandler;
+class MetadataResponseCache;
+class ImageVariantCache;
+class MetadataDiskCache;
 class PPPParser;
-class CCPHandler;
+class PPPLinkProfile;
 class DNSHandler;
+namespace zune { class TransferStats; class MtpScheduler; class Logger; }
 
 // Need full definitions for used types
 #include "HTTPParser.h"
+#include "FrameCoalescer.h"
+#include "LoopCompletionQueue.h"
+#include "NetworkMetrics.h"
+#include "PacketCapture.h"
+#include "RequestWorkerPool.h"
+#include "ResponseFrameQueue.h"
+#include "../handlers/CCPHandler.h"
 #include "../tcp/TCPConnectionManager.h"  // Includes TCPFlowController, HTTPTransmission
 
 // Configuration enums
@@ -43,12 +53,35 @@ struct ProxyModeConfig {
     std::string art_server;      // Can be empty to use catalog_server
     std::string mix_server;      // Can be empty to use catalog_server
     int timeout_ms = 30000;      // HTTP request timeout (30 seconds for proxied image fetches)
+
+    // Write-behind for the cache storage callback: requests wait once this
+    // many writes, or this many body bytes, are still queued
+    size_t cache_write_queue_depth = 32;
+    size_t cache_write_queue_bytes = 64 * 1024 * 1024;
 };
 
 struct InterceptorConfig {
     InterceptionMode mode = InterceptionMode::Disabled;
     ProxyModeConfig proxy_config;
     std::string server_ip;  // IP address for DNS resolution (e.g., "192.168.0.30")
+
+    // HTTP request workers (see RequestWorkerPool); at least one per lane
+    size_t fast_lane_workers = 2;  // Cache hits, local files, biography XML
+    size_t slow_lane_workers = 4;  // Upstream fetches
+
+    // PPP frames packed into each 0x922c transfer (see FrameCoalescer)
+    size_t usb_transfer_budget = FrameCoalescer::kDefaultBudget;  // Bytes per transfer
+    uint32_t coalesce_max_wait_us = 2000;  // Longest wait to fill a transfer; 0 = never wait
+
+    // Congestion control for response segments (see CongestionControl)
+    CongestionControlKind congestion_control = CongestionControlKind::USB_LINK;
+
+    // Accept the device's offer of MPPC compression in CCP (see CCPHandler)
+    bool ppp_compression = true;
+
+    // Reactor mode: serve from the poll thread, offloading only what does
+    // I/O (see ZuneHTTPInterceptor)
+    bool reactor = false;
 };
 
 // HTTP Request structure
@@ -65,9 +98,24 @@ struct HTTPRequest {
     uint16_t src_port;
     uint32_t dst_ip;
     uint16_t dst_port;
-    uint32_t seq_num;
+    uint32_t seq_num;          // SEQ of the request's first byte
     uint32_t ack_num;
     size_t http_request_size;  // Size of the HTTP request data for ACK calculation
+    uint64_t pipeline_index = 0;  // Order on its connection (ResponseSequencer); 0 = not ordered
+    std::chrono::steady_clock::time_point received_at;  // When parsed, for time to first segment
+};
+
+/**
+ * Network stats of a running interceptor (see NetworkMetrics)
+ */
+struct InterceptorNetworkStats {
+    NetworkMetrics::Snapshot metrics;
+    uint64_t fast_retransmits = 0;
+    uint64_t rto_retransmits = 0;
+    uint64_t response_queue_depth = 0;  // PPP frames waiting for 0x922c
+    RequestWorkerStats workers;         // Queue wait per lane
+    std::vector<TCPConnectionStats> connections;
+    CCPHandler::Stats compression;      // MPPC on frames to the device
 };
 
 // Zune device TCP window size (observed from ACK packets)
@@ -89,6 +137,15 @@ constexpr uint16_t ZUNE_TCP_WINDOW_SIZE = 33580;
  *
  * All TCP connection state, flow control, and transmission tracking is
  * managed by TCPConnectionManager. This class is purely a coordinator.
+ *
+ * By default every HTTP request goes to the request workers, which send
+ * their responses themselves. In reactor mode (InterceptorConfig::reactor)
+ * the poll thread answers whatever needs no I/O (response-cache hits,
+ * connectivity checks) as it parses the request. Local files and upstream
+ * fetches still go to the workers, but their responses are posted back
+ * and sent by the poll thread at the start of its next cycle, so TCP state
+ * and 0x922c sends stay on that one thread and the locks between them go
+ * uncontended. Proxied bodies are then sent once downloaded, not streamed.
  */
 class ZuneHTTPInterceptor {
 public:
@@ -118,8 +175,16 @@ public:
     void Stop();
     bool IsRunning() const;
     InterceptorConfig GetConfig() const;
-    void SetLogCallback(LogCallback callback);
-    void SetVerboseLogging(bool enable);
+    void SetLogger(zune::Logger* logger);  // Levels per category decide what is logged; may be null
+    void SetTransferStats(zune::TransferStats* stats);  // Counts 0x922c/0x922d; may be null
+    void SetMtpScheduler(zune::MtpScheduler* scheduler);  // Schedules 0x922c/0x922d; may be null
+    void SetResponseCache(MetadataResponseCache* cache);  // Metadata responses kept across sessions; may be null
+    void SetImageVariantCache(ImageVariantCache* cache);  // Device-sized local images; may be null
+    void SetDiskCache(MetadataDiskCache* cache);  // Native stand-in for the hybrid callbacks; may be null
+    void SetPacketCapture(PacketCapture* capture);  // Records PPP traffic both ways; may be null
+    void SetLinkProfile(PPPLinkProfile* profile);  // Warm start from the device's last session; may be null
+    RequestWorkerStats GetWorkerStats() const;  // Queue wait and service time per lane
+    InterceptorNetworkStats GetNetworkStats() const;
     // Public for testing
     void HandleIPCPPacket(const mtp::ByteArray& ipcp_data);
     void HandleDNSQuery(const mtp::ByteArray& ip_packet);
@@ -129,10 +194,16 @@ public:
 
     /// Perform one polling cycle: PollEvent → Op922d → ProcessPacket → ProcessPendingSends.
     /// Called from C# in a loop for clean cancellation (no native monitoring thread).
+    /// The wait ends early when a sent segment's retransmission timeout is due,
+    /// and due retransmits are sent before reading the device.
     /// @param timeout_ms USB interrupt timeout in milliseconds (0 = non-blocking)
     /// @return 1 = processed data, 0 = timeout (no data), -1 = not running, -2 = session unavailable
     int PollOnce(int timeout_ms);
 
+    /// True while segments are in flight or frames wait for 0x922c; the
+    /// native poll loop polls hot until this and PollOnce both go quiet
+    bool HasActiveTransmissions() const;
+
     // Hybrid mode callbacks (C# interop)
     using PathResolverCallback = const char* (*)(
         const char* artist_uuid,
@@ -154,28 +225,80 @@ public:
     void SetPathResolverCallback(PathResolverCallback callback, void* user_data);
     void SetCacheStorageCallback(CacheStorageCallback callback, void* user_data);
 
+protected:
+    // The device end of the USB link, by default the MTP session's vendor
+    // operations; a simulated device overrides these (bench_network_stack)
+    virtual bool DiscoverEndpoints();
+    virtual bool HasDeviceLink() const;
+    virtual void WaitForDeviceEvent(int timeout_ms);                 // Interrupt endpoint
+    virtual void DeviceOperation922c(const mtp::ByteArray& payload); // Frames to the device
+    virtual mtp::ByteArray DeviceOperation922d();                    // Frames from the device
+
 private:
-    void TimeoutCheckerThread();
+    class DrainHold;  // Defers a poll cycle's drains to its end
+    int TimeoutWaitMs(int timeout_ms) const;  // timeout_ms, shortened to the next RTO deadline
     void CheckAllConnectionTimeouts();
-    void RetransmitSegment(const std::string& conn_key, const SentSegment& segment);
-    bool DiscoverEndpoints();
+    void RetransmitSegment(const TCPConnectionKey& conn_key, const SentSegment& segment);
+    void SendRetransmits(const TCPConnectionKey& conn_key);  // Every segment marked lost, at once
     void ProcessPacket(const mtp::ByteArray& usb_data);
     void ProcessPendingSends();
     void ProcessPPPFrame(const mtp::ByteArray& frame_data);
     void HandleHTTPRequest(const HTTPRequest& request);
-    void RequestWorkerThread();
+    void ProcessRequest(const HTTPRequest& request);  // On a request worker
+    void RunCompletions();  // Reactor mode: send the responses workers posted
+    static HTTPParser::HTTPRequest ToHandlerRequest(const HTTPRequest& request);
 
     /**
      * Build and queue HTTP response for transmission
      * Delegates all TCP state management to TCPConnectionManager
      */
-    void SendHTTPResponse(const HTTPRequest& request, const HTTPParser::HTTPResponse& response);
+    void SendHTTPResponse(const HTTPRequest& request, HTTPParser::HTTPResponse response);
+
+    /**
+     * Reserve the SEQ range of a response and start its transmission
+     * (SendHTTPResponse, once the request's turn comes). The transmission
+     * keeps the response and frames its segments as they are sent.
+     */
+    void CommitHTTPResponse(const HTTPRequest& request, HTTPParser::HTTPResponse response);
+
+    /**
+     * The response order of request's connection; nullptr if the request
+     * is not ordered or the connection is gone
+     */
+    ResponseSequencer* ResponseOrder(const HTTPRequest& request);
+
+    /**
+     * HttpClient::ResponseStream that frames a proxied body into the
+     * request's TCP transmission as it downloads
+     */
+    class StreamedResponse;
+
+    /**
+     * The response to request: proxied, or from the metadata handler
+     * @param stream Frames a proxied body as it downloads; may be null
+     */
+    HTTPParser::HTTPResponse ResolveResponse(const HTTPRequest& request, StreamedResponse* stream);
+
+    /**
+     * Atomically reserve the SEQ range for a response of total_payload_size
+     * bytes and record the request as acknowledged
+     * @return false if the connection is gone
+     */
+    bool ReserveResponseRange(const HTTPRequest& request, size_t total_payload_size,
+                              uint32_t& base_seq, uint32_t& ack_num);
+
+    /**
+     * Build the PPP frame of one response segment into frame
+     * (ACK on every segment, PSH on the last)
+     */
+    static void BuildResponseSegment(const HTTPRequest& request, uint32_t seq_num, uint32_t ack_num,
+                                     bool last, const uint8_t* payload, size_t size, mtp::ByteArray& frame);
 
     /**
      * Send next batch of segments for a transmission
      * Gets segments from TCPConnectionManager and queues them for USB transmission
      */
-    void SendNextBatch(const std::string& conn_key, uint32_t base_seq);
+    void SendNextBatch(const TCPConnectionKey& conn_key, uint32_t base_seq);
 
     void SendTCPResponse(uint32_t src_ip, uint16_t src_port,
                         uint32_t dst_ip, uint16_t dst_port,
@@ -190,15 +313,25 @@ private:
                                  uint8_t flags, const mtp::ByteArray& data);
 
     void DrainResponseQueue();
-    void Log(const std::string& message);
-    void VerboseLog(const std::string& message);
+    bool DrainQueuedFrames();  // Caller is the queue's consumer; false on a 0x922c error
+    // The drain's view of the queue: frames as sent, compressed if CCP agreed
+    bool PeekOutboundFrame(const uint8_t*& data, size_t& size);
+    void ConsumeOutboundFrame(size_t n);
     void InitializeDNSHostnameMap(uint32_t dns_target_ip);
+    void Send922c(const mtp::ByteArray& payload);
+    mtp::ByteArray Poll922d();
 
     // Member variables
     mtp::SessionPtr session_;
     InterceptorConfig config_;
-    LogCallback log_callback_;
-    bool verbose_logging_ = true;
+    zune::Logger* logger_ = nullptr;
+    zune::TransferStats* transfer_stats_ = nullptr;
+    zune::MtpScheduler* mtp_scheduler_ = nullptr;
+    MetadataResponseCache* response_cache_ = nullptr;
+    ImageVariantCache* image_variants_ = nullptr;
+    MetadataDiskCache* disk_cache_ = nullptr;
+    PacketCapture* packet_capture_ = nullptr;
+    PPPLinkProfile* link_profile_ = nullptr;
 
     // USB infrastructure
     mtp::usb::DevicePtr usb_device_;
@@ -209,12 +342,10 @@ private:
     mtp::usb::EndpointPtr endpoint_interrupt_;
     bool endpoints_discovered_ = false;
 
-    // Threads (worker threads for HTTP requests, timeout checker for RTO)
-    // No monitoring thread — C# drives polling via PollOnce()
+    // No monitoring or timer thread — C# (or NetworkManager's native poll
+    // loop) drives polling via PollOnce(), which also fires RTO retransmits
     std::atomic<bool> running_{false};
     std::atomic<bool> network_polling_enabled_{false};
-    std::unique_ptr<std::thread> timeout_checker_thread_;
-    std::atomic<bool> timeout_checker_running_{false};
 
     // Parsers
     std::unique_ptr<PPPParser> ppp_parser_;
@@ -222,7 +353,7 @@ private:
 
     // Protocol handlers - THE ACTUAL COMPONENTS
     std::unique_ptr<CCPHandler> ccp_handler_;
-    std::unique_ptr<DNSHandler> dns_handler_;
+    std::shared_ptr<DNSHandler> dns_handler_;  // Kept by link_profile_ across sessions, if set
     std::unique_ptr<TCPConnectionManager> tcp_manager_;  // SINGLE SOURCE OF TRUTH for TCP state
 
     // Mode handlers
@@ -234,24 +365,36 @@ private:
     // DNS hostname mappings
     std::map<std::string, uint32_t> dns_hostname_map_;
 
-    // Response queue for PPP frames (deque for O(1) pop_front)
-    std::deque<mtp::ByteArray> response_queue_;
-    std::mutex response_queue_mutex_;
-    std::mutex drain_mutex_;
+    // PPP frames waiting for 0x922c; one thread drains at a time
+    ResponseFrameQueue response_queue_;
+    mtp::ByteArray drain_buffer_;  // Combined 922c payload, reused by each drain
+    FrameCoalescer coalescer_;     // Used by the thread holding the drain
+    mtp::ByteArray compressed_frame_;  // Queue's front frame compressed, being sent (drain only)
+    size_t compressed_offset_ = 0;     // Bytes of it sent
+    std::atomic<std::thread::id> drain_held_by_{};  // Poll thread inside a DrainHold
+
+    // Counters behind GetNetworkStats
+    NetworkMetrics metrics_;
 
     // Buffer for incomplete PPP frames
     mtp::ByteArray incomplete_ppp_frame_buffer_;
 
-    // HTTP request queue for worker threads
-    std::queue<HTTPRequest> request_queue_;
-    std::mutex request_queue_mutex_;
-    std::condition_variable request_queue_cv_;
-    std::vector<std::unique_ptr<std::thread>> request_worker_threads_;
-    static constexpr size_t NUM_WORKER_THREADS = 4;
+    // Held while device frames are read and processed: by the poll cycle, or
+    // by a drain's reactive 0x922d poll when the poll thread is not reading
+    std::mutex receive_mutex_;
+
+    // HTTP request workers, fast and slow lanes
+    RequestWorkerPool<HTTPRequest> request_workers_;
+
+    // Reactor mode: responses made by the workers, for the poll thread to send
+    struct Completion {
+        HTTPRequest request;
+        HTTPParser::HTTPResponse response;
+    };
+    LoopCompletionQueue<Completion> completions_;
 
     // Pending sends tracking
-    std::set<std::string> pending_sends_;
-    std::mutex pending_sends_mutex_;
+    PendingSendList pending_sends_;
 
     // Hybrid mode callbacks
     PathResolverCallback path_resolver_callback_ = nullptr;
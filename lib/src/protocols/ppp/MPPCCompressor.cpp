@@ -0,0 +1,185 @@
+#include "MPPCCompressor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/**
+ * MSB-first bit packer; the last byte is padded with zero bits
+ */
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* out) : out_(out), start_(out) {}
+
+    void Put(uint32_t value, int bits) {
+        acc_ = (acc_ << bits) | value;
+        pending_ += bits;
+        while (pending_ >= 8) {
+            pending_ -= 8;
+            *out_++ = static_cast<uint8_t>(acc_ >> pending_);
+        }
+    }
+
+    size_t Finish() {
+        if (pending_ > 0) {
+            *out_++ = static_cast<uint8_t>(acc_ << (8 - pending_));
+            pending_ = 0;
+        }
+        return out_ - start_;
+    }
+
+private:
+    uint8_t* out_;
+    uint8_t* start_;
+    uint64_t acc_ = 0;
+    int pending_ = 0;
+};
+
+// RFC 2118 section 4.2: literals
+void PutLiteral(BitWriter& bits, uint8_t byte) {
+    if (byte < 0x80) {
+        bits.Put(byte, 8);                  // 0 + 7 bits
+    } else {
+        bits.Put(0x100 | (byte & 0x7F), 9);  // 10 + lower 7 bits
+    }
+}
+
+// Copy offsets, counted back from the current position
+void PutOffset(BitWriter& bits, size_t offset) {
+    if (offset < 64) {
+        bits.Put(0x3C0 | static_cast<uint32_t>(offset), 10);           // 1111 + 6 bits
+    } else if (offset < 320) {
+        bits.Put(0xE00 | static_cast<uint32_t>(offset - 64), 12);      // 1110 + 8 bits
+    } else {
+        bits.Put(0xC000 | static_cast<uint32_t>(offset - 320), 16);    // 110 + 13 bits
+    }
+}
+
+// Copy lengths: 3 is a single 0; a length in [2^k, 2^(k+1)) is k-1 ones and
+// a zero, then its low k bits
+void PutLength(BitWriter& bits, size_t length) {
+    if (length == 3) {
+        bits.Put(0, 1);
+        return;
+    }
+    int k = 2;
+    while ((size_t(1) << (k + 1)) <= length) {
+        k++;
+    }
+    uint32_t prefix = ((1u << (k - 1)) - 1) << 1;
+    bits.Put((prefix << k) | static_cast<uint32_t>(length - (size_t(1) << k)), 2 * k);
+}
+
+} // namespace
+
+MPPCCompressor::MPPCCompressor(bool stateless)
+    : stateless_(stateless)
+    , history_(kHistorySize)
+    , head_(size_t(1) << kHashBits, -1)
+    , prev_(kHistorySize, -1) {}
+
+void MPPCCompressor::Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    uint16_t flags = 0;
+    if (stateless_ || flush_next_) {
+        ClearHistory();
+        flags |= kFlushed | kAtFront;
+        flush_next_ = false;
+    } else if (pos_ + size > kHistorySize) {
+        // Start over at the front; the device keeps the old bytes, but
+        // nothing refers back past the start of this packet
+        ClearHistory();
+        flags |= kAtFront;
+    }
+
+    // Worst case is 9 bits per byte
+    out.resize(kHeaderSize + size + size / 8 + 1);
+    size_t encoded = size + 1;
+    if (size > 0 && size <= kHistorySize - pos_) {
+        std::memcpy(history_.data() + pos_, data, size);
+        encoded = Encode(pos_, pos_ + size, out.data() + kHeaderSize);
+    }
+
+    uint16_t header;
+    if (encoded < size) {
+        pos_ += size;
+        header = flags | kCompressed | count_;
+        out.resize(kHeaderSize + encoded);
+    } else {
+        // No gain: send the packet as it is, and both sides start over
+        ClearHistory();
+        flush_next_ = true;
+        header = kFlushed | count_;
+        out.resize(kHeaderSize + size);
+        std::copy(data, data + size, out.data() + kHeaderSize);
+    }
+    out[0] = static_cast<uint8_t>(header >> 8);
+    out[1] = static_cast<uint8_t>(header);
+    count_ = (count_ + 1) & kCountMask;
+}
+
+void MPPCCompressor::Reset() {
+    ClearHistory();
+    flush_next_ = true;
+}
+
+size_t MPPCCompressor::Encode(size_t start, size_t end, uint8_t* out) {
+    BitWriter bits(out);
+    const uint8_t* h = history_.data();
+    size_t i = start;
+    while (i < end) {
+        size_t best_length = 0;
+        size_t best_offset = 0;
+        if (end - i >= kMinMatch) {
+            int chain = kMaxChain;
+            size_t limit = std::min(kMaxMatch, end - i);
+            for (int32_t candidate = head_[Hash(h + i)];
+                 candidate >= 0 && chain-- > 0; candidate = prev_[candidate]) {
+                const uint8_t* a = h + candidate;
+                const uint8_t* b = h + i;
+                if (a[best_length] != b[best_length] || a[0] != b[0]) {
+                    continue;
+                }
+                size_t length = 0;
+                while (length < limit && a[length] == b[length]) {
+                    length++;
+                }
+                if (length > best_length) {
+                    best_length = length;
+                    best_offset = i - candidate;
+                    if (length == limit) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (best_length >= kMinMatch) {
+            PutOffset(bits, best_offset);
+            PutLength(bits, best_length);
+            size_t match_end = i + best_length;
+            for (; i < match_end; i++) {
+                if (end - i >= kMinMatch) {
+                    Insert(i);
+                }
+            }
+        } else {
+            PutLiteral(bits, h[i]);
+            if (end - i >= kMinMatch) {
+                Insert(i);
+            }
+            i++;
+        }
+    }
+    return bits.Finish();
+}
+
+void MPPCCompressor::Insert(size_t pos) {
+    size_t hash = Hash(history_.data() + pos);
+    prev_[pos] = head_[hash];
+    head_[hash] = static_cast<int32_t>(pos);
+}
+
+void MPPCCompressor::ClearHistory() {
+    pos_ = 0;
+    std::fill(head_.begin(), head_.end(), -1);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * MPPCCompressor
+ *
+ * Sending side of Microsoft Point-to-Point Compression (RFC 2118), the
+ * compression the Zune firmware offers in its CCP Config-Request.
+ *
+ * Packets are LZ77-coded against an 8 KB history shared with the device's
+ * decompressor: each packet is appended to the history and may copy from
+ * anything before it, including earlier packets, so repeated XML markup and
+ * HTTP headers shrink to a few bits. Matches are found through a hash chain
+ * of three-byte prefixes.
+ *
+ * Each packet starts with a two-byte header: flags and a 12-bit coherency
+ * count that goes up by one per packet. A packet that would not shrink is
+ * sent as it is, with the history reset (FLUSHED set, COMPRESSED clear).
+ * In stateless mode the history is reset before every packet.
+ *
+ * Not thread-safe; CCPHandler serializes access.
+ */
+class MPPCCompressor {
+public:
+    static constexpr size_t kHistorySize = 8192;
+    static constexpr size_t kHeaderSize = 2;
+
+    // Header flags (high byte of the header)
+    static constexpr uint16_t kFlushed = 0x8000;     // A: history reset before this packet
+    static constexpr uint16_t kAtFront = 0x4000;     // B: packet placed at the start of the history
+    static constexpr uint16_t kCompressed = 0x2000;  // C: data is compressed
+    static constexpr uint16_t kCountMask = 0x0FFF;
+
+    explicit MPPCCompressor(bool stateless = false);
+
+    /**
+     * Compress one packet (the PPP protocol field and information)
+     * @param out Replaced by the header followed by the compressed or
+     *            original data; reuses its storage
+     */
+    void Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+    /**
+     * Reset the history, as asked by a CCP Reset-Request; the next packet
+     * is marked FLUSHED
+     */
+    void Reset();
+
+    bool Stateless() const { return stateless_; }
+
+private:
+    size_t Encode(size_t start, size_t end, uint8_t* out);
+    void Insert(size_t pos);
+    static size_t Hash(const uint8_t* p) {
+        return (size_t(p[0]) << 4 ^ size_t(p[1]) << 2 ^ p[2]) & ((size_t(1) << kHashBits) - 1);
+    }
+    void ClearHistory();
+
+    static constexpr size_t kHashBits = 12;
+    static constexpr int kMaxChain = 16;       // Candidates tried per position
+    static constexpr size_t kMinMatch = 3;
+    static constexpr size_t kMaxMatch = 8191;
+
+    bool stateless_;
+    std::vector<uint8_t> history_;
+    size_t pos_ = 0;               // End of the history
+    uint16_t count_ = 0;           // Coherency count of the next packet
+    bool flush_next_ = true;       // Set FLUSHED and AT_FRONT on the next packet
+    std::vector<int32_t> head_;    // Latest position of each prefix hash, -1 if none
+    std::vector<int32_t> prev_;    // Previous position with the same hash
+};
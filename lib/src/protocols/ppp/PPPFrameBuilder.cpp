@@ -2,6 +2,97 @@
 #include "PPPParser.h"
 #include "../http/HTTPParser.h"  // For TCPParser and IPParser
 #include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kIPHeaderSize = 20;
+constexpr size_t kTCPHeaderSize = 20;
+constexpr size_t kMaxTCPOptionsSize = 40;
+
+// Add big-endian 16-bit words to a ones-complement running sum (RFC 1071);
+// an odd trailing byte is padded with zero
+uint64_t SumWords(const uint8_t* data, size_t size, uint64_t sum) {
+    size_t i = 0;
+    for (; i + 1 < size; i += 2) {
+        sum += (static_cast<uint32_t>(data[i]) << 8) | data[i + 1];
+    }
+    if (i < size) {
+        sum += static_cast<uint32_t>(data[i]) << 8;
+    }
+    return sum;
+}
+
+uint16_t FoldChecksum(uint64_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+void PutU16(uint8_t* p, uint16_t v) {
+    p[0] = (v >> 8) & 0xFF;
+    p[1] = v & 0xFF;
+}
+
+void PutU32(uint8_t* p, uint32_t v) {
+    p[0] = (v >> 24) & 0xFF;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+// Build a TCP/IP/PPP frame into out; options_size is a multiple of 4, at most 40
+void BuildTCPFrameInto(
+    uint32_t src_ip, uint16_t src_port,
+    uint32_t dst_ip, uint16_t dst_port,
+    uint32_t seq_num, uint32_t ack_num,
+    uint8_t flags,
+    const uint8_t* options, size_t options_size,
+    const uint8_t* payload, size_t size,
+    mtp::ByteArray& out
+) {
+    // Same layout IPParser::BuildPacket / TCPParser::BuildSegment produce
+    uint8_t headers[kIPHeaderSize + kTCPHeaderSize + kMaxTCPOptionsSize] = {};
+    uint8_t* ip = headers;
+    uint8_t* tcp = headers + kIPHeaderSize;
+    const size_t tcp_header_size = kTCPHeaderSize + options_size;
+
+    // IP header: version 4, 20 bytes, don't-fragment clear, TTL 64, TCP
+    ip[0] = 0x45;
+    PutU16(ip + 2, static_cast<uint16_t>(kIPHeaderSize + tcp_header_size + size));
+    PutU16(ip + 4, static_cast<uint16_t>(rand() % 65536));
+    ip[8] = 64;
+    ip[9] = 6;
+    PutU32(ip + 12, src_ip);
+    PutU32(ip + 16, dst_ip);
+    PutU16(ip + 10, IPParser::CalculateChecksum(ip, kIPHeaderSize));
+
+    // TCP header: 20 bytes, then the options
+    PutU16(tcp + 0, src_port);
+    PutU16(tcp + 2, dst_port);
+    PutU32(tcp + 4, seq_num);
+    PutU32(tcp + 8, ack_num);
+    tcp[12] = static_cast<uint8_t>((tcp_header_size / 4) << 4);
+    tcp[13] = flags;
+    PutU16(tcp + 14, 65535);
+    if (options_size > 0) {
+        std::memcpy(tcp + kTCPHeaderSize, options, options_size);
+    }
+
+    // TCP checksum: pseudo-header, header, then the payload where it lies
+    uint64_t sum = (src_ip >> 16) + (src_ip & 0xFFFF) +
+                   (dst_ip >> 16) + (dst_ip & 0xFFFF) +
+                   6 + tcp_header_size + size;
+    sum = SumWords(tcp, tcp_header_size, sum);
+    sum = SumWords(payload, size, sum);
+    PutU16(tcp + 16, FoldChecksum(sum));
+
+    PPPParser::WrapPayload(headers, kIPHeaderSize + tcp_header_size, payload, size, 0x0021, out);
+}
+
+} // namespace
 
 mtp::ByteArray PPPFrameBuilder::BuildTCPFrame(
     uint32_t src_ip, uint16_t src_port,
@@ -10,40 +101,39 @@ mtp::ByteArray PPPFrameBuilder::BuildTCPFrame(
     uint8_t flags,
     const mtp::ByteArray& payload
 ) {
-    // Build TCP header
-    TCPParser::TCPHeader tcp_header = {};
-    tcp_header.src_port = src_port;
-    tcp_header.dst_port = dst_port;
-    tcp_header.seq_num = seq_num;
-    tcp_header.ack_num = ack_num;
-    tcp_header.data_offset = 5;  // 20 bytes (no options)
-    tcp_header.flags = flags;
-    tcp_header.window_size = 65535;
-    tcp_header.checksum = 0;  // Will be calculated by BuildSegment
-    tcp_header.urgent_pointer = 0;
-
-    mtp::ByteArray tcp_segment = TCPParser::BuildSegment(
-        tcp_header, payload, src_ip, dst_ip);
-
-    // Build IP header
-    IPParser::IPHeader ip_header = {};
-    ip_header.version = 4;
-    ip_header.header_length = 5;  // 20 bytes
-    ip_header.dscp = 0;
-    ip_header.ecn = 0;
-    ip_header.total_length = 0;  // Will be calculated by BuildPacket
-    ip_header.identification = rand() % 65536;
-    ip_header.flags_offset = 0;  // Don't fragment
-    ip_header.ttl = 64;
-    ip_header.protocol = 6;  // TCP
-    ip_header.checksum = 0;  // Will be calculated by BuildPacket
-    ip_header.src_ip = src_ip;
-    ip_header.dst_ip = dst_ip;
+    mtp::ByteArray frame;
+    BuildTCPFrame(src_ip, src_port, dst_ip, dst_port, seq_num, ack_num, flags,
+                  payload.data(), payload.size(), frame);
+    return frame;
+}
 
-    mtp::ByteArray ip_packet = IPParser::BuildPacket(ip_header, tcp_segment);
+void PPPFrameBuilder::BuildTCPFrame(
+    uint32_t src_ip, uint16_t src_port,
+    uint32_t dst_ip, uint16_t dst_port,
+    uint32_t seq_num, uint32_t ack_num,
+    uint8_t flags,
+    const uint8_t* payload, size_t size,
+    mtp::ByteArray& out
+) {
+    BuildTCPFrameInto(src_ip, src_port, dst_ip, dst_port, seq_num, ack_num, flags,
+                      nullptr, 0, payload, size, out);
+}
 
-    // Wrap in PPP frame
-    return PPPParser::WrapPayload(ip_packet, 0x0021);
+mtp::ByteArray PPPFrameBuilder::BuildTCPFrameWithOptions(
+    uint32_t src_ip, uint16_t src_port,
+    uint32_t dst_ip, uint16_t dst_port,
+    uint32_t seq_num, uint32_t ack_num,
+    uint8_t flags,
+    const mtp::ByteArray& options,
+    const mtp::ByteArray& payload
+) {
+    if (options.size() % 4 != 0 || options.size() > kMaxTCPOptionsSize) {
+        throw std::invalid_argument("TCP options must be padded to 4 bytes, at most 40");
+    }
+    mtp::ByteArray frame;
+    BuildTCPFrameInto(src_ip, src_port, dst_ip, dst_port, seq_num, ack_num, flags,
+                      options.data(), options.size(), payload.data(), payload.size(), frame);
+    return frame;
 }
 
 mtp::ByteArray PPPFrameBuilder::BuildUDPFrame(
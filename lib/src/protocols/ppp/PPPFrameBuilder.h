@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mtp/ByteArray.h>
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -33,6 +34,42 @@ public:
         const mtp::ByteArray& payload = mtp::ByteArray()
     );
 
+    /**
+     * Build a TCP frame into out in one pass
+     *
+     * The IP and TCP headers are built on the stack, the checksums are
+     * summed over the payload slice where it lies, and the payload is
+     * byte-stuffed straight from the caller's buffer into out, so each
+     * payload byte is copied once.
+     *
+     * @param payload TCP payload (e.g. a slice of an HTTP response body)
+     * @param size Payload bytes
+     * @param out Resized to exactly the frame; its storage is reused
+     */
+    static void BuildTCPFrame(
+        uint32_t src_ip, uint16_t src_port,
+        uint32_t dst_ip, uint16_t dst_port,
+        uint32_t seq_num, uint32_t ack_num,
+        uint8_t flags,
+        const uint8_t* payload, size_t size,
+        mtp::ByteArray& out
+    );
+
+    /**
+     * Build a TCP frame whose header carries options (the SYN-ACK's)
+     *
+     * @param options TCP options, padded to a multiple of 4 bytes, at most 40
+     * @return Complete PPP frame ready for transmission
+     */
+    static mtp::ByteArray BuildTCPFrameWithOptions(
+        uint32_t src_ip, uint16_t src_port,
+        uint32_t dst_ip, uint16_t dst_port,
+        uint32_t seq_num, uint32_t ack_num,
+        uint8_t flags,
+        const mtp::ByteArray& options,
+        const mtp::ByteArray& payload = mtp::ByteArray()
+    );
+
     /**
      * Build a complete PPP frame containing a UDP segment
      *
@@ -0,0 +1,135 @@
+#include "PPPLinkProfile.h"
+#include "../handlers/DNSHandler.h"
+
+namespace {
+
+// LCP Config-Request + Config-Ack, as Windows sends them (stuffed, with FCS)
+const uint8_t kLCPResponse[] = {
+    0x7e, 0xff, 0x7d, 0x23, 0xc0, 0x21, 0x7d, 0x22, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x2e, 0x7d, 0x22,
+    0x7d, 0x26, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x27, 0x7d, 0x22, 0x7d, 0x28,
+    0x7d, 0x22, 0xe3, 0xb2, 0x7e, 0x7e, 0xff, 0x7d, 0x23, 0xc0, 0x21, 0x7d, 0x21, 0x7d, 0x21, 0x7d,
+    0x20, 0x7d, 0x2e, 0x7d, 0x22, 0x7d, 0x26, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d,
+    0x27, 0x7d, 0x22, 0x7d, 0x28, 0x7d, 0x22, 0x70, 0x34, 0x7e
+};
+
+constexpr uint16_t kIPCPProtocol = 0x8021;
+constexpr uint16_t kCCPProtocol = 0x80fd;
+
+void AppendIPAddressOption(mtp::ByteArray& packet, uint32_t ip) {
+    packet.push_back(IPCPParser::IPCP_OPT_IP_ADDRESS);
+    packet.push_back(0x06);
+    packet.push_back((ip >> 24) & 0xFF);
+    packet.push_back((ip >> 16) & 0xFF);
+    packet.push_back((ip >> 8) & 0xFF);
+    packet.push_back(ip & 0xFF);
+}
+
+void Append(mtp::ByteArray& out, const mtp::ByteArray& frame) {
+    out.insert(out.end(), frame.begin(), frame.end());
+}
+
+} // namespace
+
+PPPLinkProfile::PPPLinkProfile()
+    : lcp_response_(kLCPResponse, kLCPResponse + sizeof(kLCPResponse)) {
+    // Config-Request ID 1: IP-Compression (Van Jacobson, 15 slots) and IP-Address
+    mtp::ByteArray request = {0x01, 0x01, 0x00, 0x10, 0x02, 0x06, 0x00, 0x2d, 0x0f, 0x01};
+    AppendIPAddressOption(request, kHostIP);
+    ipcp_request_ = PPPParser::WrapPayload(request, kIPCPProtocol);
+
+    // Config-Request ID 2: IP-Address only, once the device rejected compression
+    mtp::ByteArray second = {0x01, 0x02, 0x00, 0x0a};
+    AppendIPAddressOption(second, kHostIP);
+    ipcp_second_request_ = PPPParser::WrapPayload(second, kIPCPProtocol);
+
+    // CCP Config-Request ID 1: MPPC
+    mtp::ByteArray ccp = {0x01, 0x01, 0x00, 0x0a, 0x12, 0x06, 0x00, 0x00, 0x00, 0x01};
+    ccp_request_ = PPPParser::WrapPayload(ccp, kCCPProtocol);
+}
+
+PPPLinkProfile::~PPPLinkProfile() = default;
+
+template <typename BuildFn>
+mtp::ByteArray PPPLinkProfile::Lookup(Reply& reply, const IPCPParser::IPCPPacket& device_request,
+                                      BuildFn&& build) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reply.valid && reply.identifier == device_request.identifier &&
+        reply.options == device_request.options) {
+        stats_.replies_reused++;
+        return reply.payload;
+    }
+    reply.payload.clear();
+    build(reply.payload);
+    reply.identifier = device_request.identifier;
+    reply.options = device_request.options;
+    reply.valid = true;
+    stats_.replies_built++;
+    return reply.payload;
+}
+
+mtp::ByteArray PPPLinkProfile::NakReply(const IPCPParser::IPCPPacket& device_request) {
+    return Lookup(nak_reply_, device_request, [&](mtp::ByteArray& payload) {
+        // Windows order: Config-Request + CCP + Config-Nak
+        Append(payload, ipcp_request_);
+        Append(payload, ccp_request_);
+        Append(payload, PPPParser::WrapPayload(
+            IPCPParser::BuildConfigNak(device_request.identifier, kDeviceIP, kDNSIP), kIPCPProtocol));
+    });
+}
+
+mtp::ByteArray PPPLinkProfile::AckReply(const IPCPParser::IPCPPacket& device_request) {
+    return Lookup(ack_reply_, device_request, [&](mtp::ByteArray& payload) {
+        // Windows order: Config-Request + CCP + Config-Ack
+        Append(payload, ipcp_request_);
+        Append(payload, ccp_request_);
+        Append(payload, PPPParser::WrapPayload(IPCPParser::BuildConfigAck(device_request), kIPCPProtocol));
+    });
+}
+
+mtp::ByteArray PPPLinkProfile::SecondReply(const IPCPParser::IPCPPacket& device_request) {
+    return Lookup(second_reply_, device_request, [&](mtp::ByteArray& payload) {
+        Append(payload, ipcp_second_request_);
+        Append(payload, PPPParser::WrapPayload(IPCPParser::BuildConfigAck(device_request), kIPCPProtocol));
+    });
+}
+
+void PPPLinkProfile::RecordNegotiation(bool nak_path, std::chrono::microseconds elapsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.negotiations++;
+    stats_.nak_path = nak_path;
+    stats_.last_negotiation = elapsed;
+}
+
+std::shared_ptr<DNSHandler> PPPLinkProfile::DNS(const std::map<std::string, uint32_t>& hostname_map) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dns_handler_ || dns_hostname_map_ != hostname_map) {
+        dns_handler_ = std::make_shared<DNSHandler>(hostname_map);
+        dns_hostname_map_ = hostname_map;
+    }
+    return dns_handler_;
+}
+
+void PPPLinkProfile::RecordSession(size_t peak_connections, uint64_t link_rate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (peak_connections > 0) {
+        stats_.peak_connections = peak_connections;
+    }
+    if (link_rate > 0) {
+        stats_.link_rate = link_rate;
+    }
+}
+
+size_t PPPLinkProfile::PeakConnections() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.peak_connections;
+}
+
+uint64_t PPPLinkProfile::LinkRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.link_rate;
+}
+
+PPPLinkProfile::Stats PPPLinkProfile::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
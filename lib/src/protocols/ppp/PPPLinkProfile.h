@@ -0,0 +1,129 @@
+#pragma once
+
+#include "PPPParser.h"
+#include <mtp/ByteArray.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class DNSHandler;
+
+/**
+ * PPPLinkProfile
+ *
+ * What one device's PPP link settled on, kept across network-mode
+ * sessions (NetworkManager owns one per device) so re-entering network
+ * mode after a sync starts warm.
+ *
+ * The device walks LCP and IPCP from scratch every time, so the round
+ * trips stay, but none of the host's answers has to be built while the
+ * device waits:
+ * - The LCP response and our IPCP / CCP Config-Requests are fixed and
+ *   built once
+ * - The IPCP replies (Config-Request + CCP + Config-Nak or Config-Ack) are
+ *   kept for the device Config-Request they answered; the device sends the
+ *   same requests each session, so later sessions reuse them as they are
+ * - The DNS handler, with its compiled answers and the UDP packet for the
+ *   device's address pair, is handed to the next interceptor
+ * - The next TCPConnectionManager starts with tables sized for the last
+ *   session's peak connections and with its measured link rate, so the
+ *   USB_LINK pacing does not start blind
+ *
+ * Thread-safe: negotiation runs on the thread calling TriggerNetworkMode,
+ * interceptor sessions start and stop on others.
+ */
+class PPPLinkProfile {
+public:
+    // Addresses the host negotiates (the device queries the host for DNS)
+    static constexpr uint32_t kHostIP = 0xC0A83764;    // 192.168.55.100
+    static constexpr uint32_t kDeviceIP = 0xC0A83765;  // 192.168.55.101
+    static constexpr uint32_t kDNSIP = kHostIP;
+
+    struct Stats {
+        uint64_t negotiations = 0;     // Completed IPCP negotiations
+        uint64_t replies_built = 0;    // IPCP replies built for a new device request
+        uint64_t replies_reused = 0;   // IPCP replies sent as kept
+        bool nak_path = false;         // Last negotiation corrected the device's address
+        std::chrono::microseconds last_negotiation{0};  // Trigger to IPCP Config-Ack
+        size_t peak_connections = 0;   // Concurrent TCP connections, last session
+        uint64_t link_rate = 0;        // USB link bytes per second, last session
+    };
+
+    PPPLinkProfile();
+    ~PPPLinkProfile();
+
+    /**
+     * LCP Config-Request + Config-Ack sent after the device's first LCP frame
+     */
+    const mtp::ByteArray& LCPResponse() const { return lcp_response_; }
+
+    /**
+     * Our Config-Request (with IP-Compression), CCP Config-Request, and a
+     * Config-Nak assigning kDeviceIP, for a device request with no address
+     */
+    mtp::ByteArray NakReply(const IPCPParser::IPCPPacket& device_request);
+
+    /**
+     * Our Config-Request (with IP-Compression), CCP Config-Request, and a
+     * Config-Ack of the device's request
+     */
+    mtp::ByteArray AckReply(const IPCPParser::IPCPPacket& device_request);
+
+    /**
+     * Our second Config-Request (no IP-Compression, after the device
+     * rejected it) and a Config-Ack of the device's corrected request
+     */
+    mtp::ByteArray SecondReply(const IPCPParser::IPCPPacket& device_request);
+
+    /**
+     * Record a completed negotiation
+     * @param nak_path The device's address was corrected with a Config-Nak
+     * @param elapsed From the trigger to the device's IPCP Config-Ack
+     */
+    void RecordNegotiation(bool nak_path, std::chrono::microseconds elapsed);
+
+    /**
+     * The DNS handler for hostname_map: the kept one if the map is the
+     * same, else a new one that is kept from now on
+     */
+    std::shared_ptr<DNSHandler> DNS(const std::map<std::string, uint32_t>& hostname_map);
+
+    /**
+     * Record an interceptor session's peak TCP connections and link rate
+     * (0 = nothing measured, the previous value stays)
+     */
+    void RecordSession(size_t peak_connections, uint64_t link_rate);
+
+    size_t PeakConnections() const;
+    uint64_t LinkRate() const;
+    Stats GetStats() const;
+
+private:
+    // A reply kept for the device Config-Request it answered
+    struct Reply {
+        bool valid = false;
+        uint8_t identifier = 0;
+        mtp::ByteArray options;
+        mtp::ByteArray payload;
+    };
+
+    template <typename BuildFn>
+    mtp::ByteArray Lookup(Reply& reply, const IPCPParser::IPCPPacket& device_request, BuildFn&& build);
+
+    mtp::ByteArray lcp_response_;
+    mtp::ByteArray ipcp_request_;         // PPP frame, ID 1, IP-Compression + IP-Address
+    mtp::ByteArray ipcp_second_request_;  // PPP frame, ID 2, IP-Address only
+    mtp::ByteArray ccp_request_;          // PPP frame
+
+    mutable std::mutex mutex_;
+    Reply nak_reply_;
+    Reply ack_reply_;
+    Reply second_reply_;
+    std::shared_ptr<DNSHandler> dns_handler_;
+    std::map<std::string, uint32_t> dns_hostname_map_;
+    Stats stats_;
+};
@@ -5,8 +5,176 @@
 #include <cstring>
 #include "../../platform_socket.h"
 
-// Forward declaration
-static uint16_t CalculatePPPFCS(const uint8_t* data, size_t length);
+// Vector scan for bytes that need escaping. SSE2 is baseline on x86-64;
+// NEON's horizontal max (vmaxvq) is AArch64-only. Everything else uses
+// the 64-bit word path.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PPP_STUFF_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PPP_STUFF_NEON 1
+#endif
+
+namespace {
+
+constexpr uint8_t kFlag = 0x7E;
+constexpr uint8_t kEscape = 0x7D;
+
+#if defined(PPP_STUFF_SSE2) || defined(PPP_STUFF_NEON)
+constexpr size_t kScanBlock = 16;  // Bytes per vector
+#else
+constexpr size_t kScanBlock = 8;   // Bytes per uint64_t
+#endif
+
+/**
+ * True if any of the kScanBlock bytes at p is 0x7D or 0x7E.
+ */
+inline bool block_needs_escape(const uint8_t* p) {
+#if defined(PPP_STUFF_SSE2)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(kEscape)),
+                               _mm_cmpeq_epi8(v, _mm_set1_epi8(kFlag)));
+    return _mm_movemask_epi8(hit) != 0;
+#elif defined(PPP_STUFF_NEON)
+    uint8x16_t v = vld1q_u8(p);
+    uint8x16_t hit = vorrq_u8(vceqq_u8(v, vdupq_n_u8(kEscape)), vceqq_u8(v, vdupq_n_u8(kFlag)));
+    return vmaxvq_u8(hit) != 0;
+#else
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    // Has-zero test on w with each target byte XORed out
+    uint64_t a = w ^ 0x7D7D7D7D7D7D7D7DULL;
+    uint64_t b = w ^ 0x7E7E7E7E7E7E7E7EULL;
+    return (((a - 0x0101010101010101ULL) & ~a) |
+            ((b - 0x0101010101010101ULL) & ~b)) & 0x8080808080808080ULL;
+#endif
+}
+
+/**
+ * First byte in [p, end) that must be escaped, or end.
+ */
+inline const uint8_t* find_escape(const uint8_t* p, const uint8_t* end) {
+    while (static_cast<size_t>(end - p) >= kScanBlock && !block_needs_escape(p)) {
+        p += kScanBlock;
+    }
+    while (p < end && *p != kEscape && *p != kFlag) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * Byte-stuff [data, data + size) into out; clean runs are copied whole.
+ * @return One past the last byte written (at most out + 2 * size)
+ */
+uint8_t* stuff(const uint8_t* data, size_t size, uint8_t* out) {
+    const uint8_t* end = data + size;
+    while (data < end) {
+        const uint8_t* special = find_escape(data, end);
+        std::memcpy(out, data, special - data);
+        out += special - data;
+        if (special == end) {
+            break;
+        }
+        *out++ = kEscape;
+        *out++ = *special ^ 0x20;
+        data = special + 1;
+    }
+    return out;
+}
+
+/**
+ * Length of [data, data + size) once byte-stuffed
+ */
+size_t stuffed_size(const uint8_t* data, size_t size) {
+    const uint8_t* end = data + size;
+    size_t escapes = 0;
+    for (const uint8_t* p = find_escape(data, end); p != end; p = find_escape(p + 1, end)) {
+        escapes++;
+    }
+    return size + escapes;
+}
+
+/**
+ * Undo byte stuffing of [data, data + size) into out. A trailing 0x7D
+ * with nothing after it is kept as is.
+ * @return One past the last byte written (at most out + size)
+ */
+uint8_t* unstuff(const uint8_t* data, size_t size, uint8_t* out) {
+    const uint8_t* end = data + size;
+    while (data < end) {
+        const void* hit = std::memchr(data, kEscape, end - data);
+        const uint8_t* escape = hit ? static_cast<const uint8_t*>(hit) : end;
+        std::memcpy(out, data, escape - data);
+        out += escape - data;
+        if (escape == end) {
+            break;
+        }
+        if (escape + 1 < end) {
+            *out++ = escape[1] ^ 0x20;
+            data = escape + 2;
+        } else {
+            *out++ = *escape;
+            data = end;
+        }
+    }
+    return out;
+}
+
+/**
+ * CRC-16-CCITT (reflected, poly 0x8408) tables for slicing-by-8:
+ * t[k][b] is the CRC contribution of byte b followed by k zero bytes.
+ */
+struct FCSTables {
+    uint16_t t[8][256];
+};
+
+constexpr FCSTables make_fcs_tables() {
+    FCSTables tables{};
+    for (unsigned i = 0; i < 256; i++) {
+        uint16_t v = static_cast<uint16_t>(i);
+        for (int bit = 0; bit < 8; bit++) {
+            v = (v & 1) ? static_cast<uint16_t>((v >> 1) ^ 0x8408) : static_cast<uint16_t>(v >> 1);
+        }
+        tables.t[0][i] = v;
+    }
+    for (int k = 1; k < 8; k++) {
+        for (unsigned i = 0; i < 256; i++) {
+            uint16_t prev = tables.t[k - 1][i];
+            tables.t[k][i] = static_cast<uint16_t>((prev >> 8) ^ tables.t[0][prev & 0xFF]);
+        }
+    }
+    return tables;
+}
+
+constexpr FCSTables kFCSTables = make_fcs_tables();
+
+/**
+ * Fold data into a running (non-inverted) FCS
+ */
+uint16_t update_fcs(uint16_t fcs, const uint8_t* data, size_t length) {
+    const auto& t = kFCSTables.t;
+    while (length >= 8) {
+        uint64_t x = 0;
+        for (int k = 0; k < 8; k++) {
+            x |= static_cast<uint64_t>(data[k]) << (8 * k);  // Little-endian, folds to one load
+        }
+        x ^= fcs;
+        fcs = t[7][x & 0xFF] ^ t[6][(x >> 8) & 0xFF] ^
+              t[5][(x >> 16) & 0xFF] ^ t[4][(x >> 24) & 0xFF] ^
+              t[3][(x >> 32) & 0xFF] ^ t[2][(x >> 40) & 0xFF] ^
+              t[1][(x >> 48) & 0xFF] ^ t[0][x >> 56];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        fcs = (fcs >> 8) ^ t[0][(fcs ^ *data++) & 0xFF];
+    }
+    return fcs;
+}
+
+} // namespace
 
 // ============================================================================
 // PPPParser Implementation
@@ -26,29 +194,18 @@ mtp::ByteArray PPPParser::ExtractPayload(const mtp::ByteArray& data, uint16_t* p
     // IMPORTANT: Escape sequences apply to the ENTIRE frame content, including protocol field
     // Must un-stuff BEFORE reading protocol
 
-    // Step 1: Extract raw frame content (between 0x7E delimiters)
-    mtp::ByteArray raw_frame;
-    raw_frame.insert(raw_frame.end(), data.begin() + 1, data.end() - 1);
-
-    // Step 2: Un-stuff PPP escape sequences
+    // Un-stuff the frame content (between 0x7E delimiters) in one pass
     // PPP uses 0x7D as escape: 0x7D 0xXX → XX ^ 0x20
     // Common escapes: 0x7D 0x5D → 0x7D, 0x7D 0x5E → 0x7E, 0x7D 0x23 → 0xC0 (for LCP)
-    mtp::ByteArray unstuffed_frame;
-    for (size_t i = 0; i < raw_frame.size(); i++) {
-        if (raw_frame[i] == 0x7D && i + 1 < raw_frame.size()) {
-            // Un-stuff: next byte XOR 0x20
-            unstuffed_frame.push_back(raw_frame[i + 1] ^ 0x20);
-            i++;  // Skip the escaped byte
-        } else {
-            unstuffed_frame.push_back(raw_frame[i]);
-        }
-    }
+    mtp::ByteArray unstuffed_frame(data.size() - 2);
+    uint8_t* unstuffed_end = unstuff(data.data() + 1, data.size() - 2, unstuffed_frame.data());
+    unstuffed_frame.resize(unstuffed_end - unstuffed_frame.data());
 
     if (unstuffed_frame.size() < 3) {
         throw std::runtime_error("PPP frame too short after un-stuffing");
     }
 
-    // Step 3: Read protocol from un-stuffed data (1 or 2 bytes)
+    // Read protocol from un-stuffed data (1 or 2 bytes)
     // PPP protocol compression: if first byte has LSB of first octet set to 1,
     // it's a single byte protocol. Otherwise it's 2 bytes.
     // Control protocols (IPCP=0x8021, LCP=0xC021) are always 2 bytes.
@@ -74,14 +231,14 @@ mtp::ByteArray PPPParser::ExtractPayload(const mtp::ByteArray& data, uint16_t* p
         *protocol = proto;
     }
 
-    // Step 4: Verify FCS (Frame Check Sequence)
+    // Verify FCS (Frame Check Sequence)
     // Extract FCS from frame (last 2 bytes, little-endian)
     uint16_t received_fcs = static_cast<uint16_t>(unstuffed_frame[unstuffed_frame.size() - 2]) |
                            (static_cast<uint16_t>(unstuffed_frame[unstuffed_frame.size() - 1]) << 8);
 
     // Calculate FCS over frame data (everything except the FCS itself)
-    uint16_t calculated_fcs = CalculatePPPFCS(unstuffed_frame.data(),
-                                              unstuffed_frame.size() - 2);
+    uint16_t calculated_fcs = CalculateFCS(unstuffed_frame.data(),
+                                           unstuffed_frame.size() - 2);
 
     // Verify FCS matches
     if (received_fcs != calculated_fcs) {
@@ -91,111 +248,101 @@ mtp::ByteArray PPPParser::ExtractPayload(const mtp::ByteArray& data, uint16_t* p
         throw std::runtime_error(err.str());
     }
 
-    // Step 5: Extract payload (everything between protocol and FCS)
+    // Extract payload (everything between protocol and FCS)
     // Un-stuffed frame: [protocol 1-2 bytes] [payload] [FCS 2 bytes]
     if (offset >= unstuffed_frame.size() - 2) {
         return mtp::ByteArray();  // Empty payload (only protocol + FCS)
     }
 
-    // Extract payload (exclude FCS which is last 2 bytes)
-    mtp::ByteArray payload;
-    payload.insert(payload.end(),
-                   unstuffed_frame.begin() + offset,
-                   unstuffed_frame.end() - 2);
-
-    return payload;
+    // Trim FCS and protocol in place rather than copying the payload out
+    unstuffed_frame.resize(unstuffed_frame.size() - 2);
+    unstuffed_frame.erase(unstuffed_frame.begin(), unstuffed_frame.begin() + offset);
+    return unstuffed_frame;
 }
 
-// Calculate PPP FCS (Frame Check Sequence) using CRC-16-CCITT
-static uint16_t CalculatePPPFCS(const uint8_t* data, size_t length) {
-    uint16_t fcs = 0xFFFF;  // Initial FCS value
-    static const uint16_t fcstab[256] = {
-        0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
-        0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
-        0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
-        0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
-        0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
-        0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
-        0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
-        0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
-        0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
-        0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
-        0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
-        0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
-        0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
-        0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
-        0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
-        0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
-        0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
-        0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
-        0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
-        0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
-        0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
-        0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
-        0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
-        0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
-        0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
-        0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
-        0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
-        0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
-        0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
-        0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
-        0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
-        0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
-    };
-
-    for (size_t i = 0; i < length; i++) {
-        fcs = (fcs >> 8) ^ fcstab[(fcs ^ data[i]) & 0xFF];
-    }
-
-    return fcs ^ 0xFFFF;  // Final XOR
+size_t PPPParser::UnstuffInto(const uint8_t* data, size_t size, uint8_t* out) {
+    return unstuff(data, size, out) - out;
 }
 
-mtp::ByteArray PPPParser::WrapPayload(const mtp::ByteArray& payload, uint16_t protocol) {
-    mtp::ByteArray frame_data;
-
-    // Build frame data (protocol + payload) for FCS calculation (UNSTUFFED)
-    if (protocol == PPP_PROTO_IPV4) {
-        frame_data.push_back(0x21);
-    } else if ((protocol & 0xFF00) == 0) {
-        // Single-byte protocol
-        frame_data.push_back(protocol & 0xFF);
-    } else {
-        // Two-byte protocol
-        frame_data.push_back((protocol >> 8) & 0xFF);
-        frame_data.push_back(protocol & 0xFF);
-    }
+// Calculate PPP FCS (Frame Check Sequence) using CRC-16-CCITT, 8 bytes per step
+uint16_t PPPParser::CalculateFCS(const uint8_t* data, size_t length) {
+    return update_fcs(0xFFFF, data, length) ^ 0xFFFF;  // Initial value, final XOR
+}
 
-    // Add payload (unstuffed)
-    frame_data.insert(frame_data.end(), payload.begin(), payload.end());
+// Unstuffed protocol field and FCS of a frame whose content is head + body
+struct PPPParser::FrameFields {
+    uint8_t protocol[2];
+    size_t protocol_size = 0;
+    uint8_t fcs[2];
+
+    FrameFields(uint16_t proto, const uint8_t* head, size_t head_size,
+                const uint8_t* body, size_t body_size) {
+        if (proto == PPP_PROTO_IPV4) {
+            protocol[protocol_size++] = 0x21;
+        } else if ((proto & 0xFF00) == 0) {
+            // Single-byte protocol
+            protocol[protocol_size++] = proto & 0xFF;
+        } else {
+            // Two-byte protocol
+            protocol[protocol_size++] = (proto >> 8) & 0xFF;
+            protocol[protocol_size++] = proto & 0xFF;
+        }
 
-    // Calculate FCS over unstuffed protocol + payload
-    uint16_t fcs = CalculatePPPFCS(frame_data.data(), frame_data.size());
+        // Calculate FCS over unstuffed protocol + content, piece by piece
+        uint16_t value = update_fcs(0xFFFF, protocol, protocol_size);
+        value = update_fcs(value, head, head_size);
+        value = update_fcs(value, body, body_size) ^ 0xFFFF;
 
-    // Add FCS to frame_data (little-endian) BEFORE byte stuffing
-    // RFC 1662: The FCS is transmitted with the LSB first
-    frame_data.push_back(fcs & 0xFF);        // FCS low byte
-    frame_data.push_back((fcs >> 8) & 0xFF); // FCS high byte
+        // RFC 1662: The FCS is transmitted with the LSB first
+        fcs[0] = value & 0xFF;         // FCS low byte
+        fcs[1] = (value >> 8) & 0xFF;  // FCS high byte
+    }
+};
 
-    // Now stuff the ENTIRE frame_data (including FCS) for transmission
+size_t PPPParser::WriteFrame(const FrameFields& fields,
+                             const uint8_t* head, size_t head_size,
+                             const uint8_t* body, size_t body_size,
+                             uint8_t* out) {
+    // Stuff the ENTIRE frame content (including FCS) for transmission
     // PPP byte stuffing: escape 0x7D and 0x7E as 0x7D 0xXX (XX = original ^ 0x20)
     // This is CRITICAL: FCS bytes containing 0x7D or 0x7E would corrupt the frame!
-    mtp::ByteArray stuffed_frame_data;
-    for (uint8_t byte : frame_data) {
-        if (byte == 0x7D || byte == 0x7E) {
-            stuffed_frame_data.push_back(0x7D);
-            stuffed_frame_data.push_back(byte ^ 0x20);
-        } else {
-            stuffed_frame_data.push_back(byte);
-        }
-    }
+    uint8_t* p = out;
+    *p++ = PPP_FLAG;
+    p = stuff(fields.protocol, fields.protocol_size, p);
+    p = stuff(head, head_size, p);
+    p = stuff(body, body_size, p);
+    p = stuff(fields.fcs, sizeof(fields.fcs), p);
+    *p++ = PPP_FLAG;
+    return p - out;
+}
 
-    // Build final frame: 0x7E + stuffed(protocol + payload + FCS) + 0x7E
-    mtp::ByteArray frame;
-    frame.push_back(PPP_FLAG);
-    frame.insert(frame.end(), stuffed_frame_data.begin(), stuffed_frame_data.end());
-    frame.push_back(PPP_FLAG);
+size_t PPPParser::WrapPayloadInto(const uint8_t* payload, size_t size, uint16_t protocol, uint8_t* out) {
+    FrameFields fields(protocol, payload, size, nullptr, 0);
+    return WriteFrame(fields, payload, size, nullptr, 0, out);
+}
+
+void PPPParser::WrapPayload(const uint8_t* head, size_t head_size,
+                            const uint8_t* body, size_t body_size,
+                            uint16_t protocol, mtp::ByteArray& out) {
+    FrameFields fields(protocol, head, head_size, body, body_size);
+
+    // Size the frame exactly, so stored frames carry no worst-case slack
+    size_t frame_size = 2 +
+        stuffed_size(fields.protocol, fields.protocol_size) +
+        stuffed_size(head, head_size) +
+        stuffed_size(body, body_size) +
+        stuffed_size(fields.fcs, sizeof(fields.fcs));
+    out.resize(frame_size);
+    WriteFrame(fields, head, head_size, body, body_size, out.data());
+}
+
+void PPPParser::WrapPayload(const uint8_t* payload, size_t size, uint16_t protocol, mtp::ByteArray& out) {
+    WrapPayload(payload, size, nullptr, 0, protocol, out);
+}
 
+mtp::ByteArray PPPParser::WrapPayload(const mtp::ByteArray& payload, uint16_t protocol) {
+    mtp::ByteArray frame;
+    WrapPayload(payload.data(), payload.size(), protocol, frame);
     return frame;
 }
 
@@ -209,40 +356,37 @@ std::string PPPParser::GetProtocolName(uint16_t protocol) {
     }
 }
 
-std::vector<mtp::ByteArray> PPPParser::ExtractFrames(const mtp::ByteArray& data) {
-    std::vector<mtp::ByteArray> frames;
-
-    if (data.empty()) {
-        return frames;
-    }
-
-    size_t i = 0;
-    while (i < data.size()) {
+// Append every complete frame in [data, end) to frames; returns the start of
+// a trailing unterminated frame, or end. Flags are found with memchr.
+static const uint8_t* SplitFrames(const uint8_t* data, const uint8_t* end,
+                                  std::vector<mtp::ByteArray>& frames) {
+    const uint8_t* p = data;
+    while (p < end) {
         // Find start of frame (0x7E)
-        if (data[i] != PPP_FLAG) {
-            i++;
-            continue;
+        const void* start_hit = std::memchr(p, kFlag, end - p);
+        if (!start_hit) {
+            return end;
         }
-
-        // Found start, now find end
-        size_t start = i;
-        i++;  // Skip start flag
+        const uint8_t* start = static_cast<const uint8_t*>(start_hit);
 
         // Find end of frame (next 0x7E)
-        while (i < data.size() && data[i] != PPP_FLAG) {
-            i++;
+        const void* end_hit = std::memchr(start + 1, kFlag, end - start - 1);
+        if (!end_hit) {
+            return start;
         }
+        const uint8_t* stop = static_cast<const uint8_t*>(end_hit);
 
-        if (i < data.size()) {
-            // Include the end flag
-            mtp::ByteArray frame(data.begin() + start, data.begin() + i + 1);
-            if (frame.size() > 2) {  // More than just two flags
-                frames.push_back(frame);
-            }
-            i++;  // Move past end flag (which might be start of next frame)
+        if (stop - start > 1) {  // More than just two flags
+            frames.emplace_back(start, stop + 1);
         }
+        p = stop + 1;  // Move past end flag (which might be start of next frame)
     }
+    return end;
+}
 
+std::vector<mtp::ByteArray> PPPParser::ExtractFrames(const mtp::ByteArray& data) {
+    std::vector<mtp::ByteArray> frames;
+    SplitFrames(data.data(), data.data() + data.size(), frames);
     return frames;
 }
 
@@ -252,55 +396,22 @@ std::vector<mtp::ByteArray> PPPParser::ExtractFramesWithBuffer(
 
     std::vector<mtp::ByteArray> frames;
 
-    // Step 1: Combine incomplete buffer with new data
-    mtp::ByteArray combined_data;
-    if (!incomplete_buffer.empty()) {
-        combined_data.insert(combined_data.end(),
-                           incomplete_buffer.begin(),
-                           incomplete_buffer.end());
-        combined_data.insert(combined_data.end(), data.begin(), data.end());
-        incomplete_buffer.clear();
-    } else {
-        combined_data = data;
-    }
-
-    if (combined_data.empty()) {
+    if (incomplete_buffer.empty()) {
+        // Common case: scan the new data in place
+        const uint8_t* end = data.data() + data.size();
+        const uint8_t* rest = SplitFrames(data.data(), end, frames);
+        incomplete_buffer.assign(rest, end);
         return frames;
     }
 
-    // Step 2: Extract complete frames, buffer incomplete ones
-    size_t i = 0;
-    while (i < combined_data.size()) {
-        // Find frame start (0x7E)
-        if (combined_data[i] != PPP_FLAG) {
-            i++;
-            continue;
-        }
-
-        size_t frame_start = i;
-        i++;  // Skip start flag
-
-        // Find frame end (next 0x7E)
-        while (i < combined_data.size() && combined_data[i] != PPP_FLAG) {
-            i++;
-        }
-
-        if (i < combined_data.size()) {
-            // Found complete frame (includes both 0x7E delimiters)
-            mtp::ByteArray frame(combined_data.begin() + frame_start,
-                                combined_data.begin() + i + 1);
-            if (frame.size() > 2) {  // More than just two flags
-                frames.push_back(frame);
-            }
-            i++;  // Move past end flag
-        } else {
-            // Incomplete frame - save for next call
-            incomplete_buffer.assign(combined_data.begin() + frame_start,
-                                    combined_data.end());
-            break;
-        }
-    }
+    // Continue the incomplete frame from the previous call
+    mtp::ByteArray combined_data;
+    combined_data.swap(incomplete_buffer);
+    combined_data.insert(combined_data.end(), data.begin(), data.end());
 
+    const uint8_t* end = combined_data.data() + combined_data.size();
+    const uint8_t* rest = SplitFrames(combined_data.data(), end, frames);
+    incomplete_buffer.assign(rest, end);
     return frames;
 }
 
@@ -575,6 +686,56 @@ TCPParser::TCPHeader TCPParser::ParseHeader(const mtp::ByteArray& data) {
     return header;
 }
 
+TCPParser::Options TCPParser::ParseOptions(const mtp::ByteArray& data) {
+    Options options;
+    if (data.size() < 20) {
+        return options;
+    }
+    size_t header_size = static_cast<size_t>((data[12] >> 4) & 0x0F) * 4;
+    if (header_size <= 20 || header_size > data.size()) {
+        return options;
+    }
+
+    size_t i = 20;
+    while (i < header_size) {
+        uint8_t kind = data[i];
+        if (kind == TCP_OPTION_END) {
+            break;
+        }
+        if (kind == TCP_OPTION_NOP) {
+            i++;
+            continue;
+        }
+        if (i + 1 >= header_size) {
+            break;
+        }
+        uint8_t length = data[i + 1];
+        if (length < 2 || i + length > header_size) {
+            break;  // Malformed: keep what was read before it
+        }
+
+        if (kind == TCP_OPTION_SACK_PERMITTED && length == 2) {
+            options.sack_permitted = true;
+        } else if (kind == TCP_OPTION_SACK && (length - 2) % 8 == 0) {
+            for (size_t b = i + 2; b + 8 <= i + length &&
+                 options.sack_block_count < Options::kMaxSACKBlocks; b += 8) {
+                SACKBlock& block = options.sack_blocks[options.sack_block_count++];
+                block.left_edge = (static_cast<uint32_t>(data[b]) << 24) |
+                                  (static_cast<uint32_t>(data[b + 1]) << 16) |
+                                  (static_cast<uint32_t>(data[b + 2]) << 8) |
+                                  static_cast<uint32_t>(data[b + 3]);
+                block.right_edge = (static_cast<uint32_t>(data[b + 4]) << 24) |
+                                   (static_cast<uint32_t>(data[b + 5]) << 16) |
+                                   (static_cast<uint32_t>(data[b + 6]) << 8) |
+                                   static_cast<uint32_t>(data[b + 7]);
+            }
+        }
+        i += length;
+    }
+
+    return options;
+}
+
 mtp::ByteArray TCPParser::ExtractPayload(const mtp::ByteArray& data) {
     TCPHeader header = ParseHeader(data);
     size_t header_size = header.data_offset * 4;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mtp/ByteArray.h>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <map>
@@ -49,6 +50,48 @@ public:
      */
     static mtp::ByteArray WrapPayload(const mtp::ByteArray& payload, uint16_t protocol = 0x0021);
 
+    /**
+     * Wrap payload into out, reusing its storage
+     * @param out Resized to exactly the frame
+     */
+    static void WrapPayload(const uint8_t* payload, size_t size, uint16_t protocol, mtp::ByteArray& out);
+
+    /**
+     * Wrap head followed by body as one frame, without joining them first
+     * (e.g. IP/TCP headers built on the stack and a slice of a response body).
+     * Each byte is stuffed straight into out, which is sized exactly.
+     */
+    static void WrapPayload(const uint8_t* head, size_t head_size,
+                            const uint8_t* body, size_t body_size,
+                            uint16_t protocol, mtp::ByteArray& out);
+
+    /**
+     * Wrap payload into a caller-provided buffer
+     * @param out At least MaxFrameSize(size) bytes
+     * @return Frame length written to out
+     */
+    static size_t WrapPayloadInto(const uint8_t* payload, size_t size, uint16_t protocol, uint8_t* out);
+
+    /**
+     * Worst-case frame length for a payload: two flags, and a two-byte
+     * protocol, the payload and the FCS with every byte escaped
+     */
+    static constexpr size_t MaxFrameSize(size_t payload_size) {
+        return 2 + 2 * (2 + payload_size + 2);
+    }
+
+    /**
+     * Undo byte stuffing of frame content (without the flags)
+     * @param out At least size bytes
+     * @return Bytes written to out
+     */
+    static size_t UnstuffInto(const uint8_t* data, size_t size, uint8_t* out);
+
+    /**
+     * PPP FCS-16 (RFC 1662) of data, with the initial value and final XOR applied
+     */
+    static uint16_t CalculateFCS(const uint8_t* data, size_t length);
+
     /**
      * Get protocol name for debugging
      * @param protocol PPP protocol value
@@ -101,6 +144,13 @@ public:
     static bool TryParseFrame(const mtp::ByteArray& data, ParsedFrame& frame);
 
 private:
+    struct FrameFields;
+
+    static size_t WriteFrame(const FrameFields& fields,
+                             const uint8_t* head, size_t head_size,
+                             const uint8_t* body, size_t body_size,
+                             uint8_t* out);
+
     // PPP frame delimiters and protocols
     static constexpr uint8_t PPP_FLAG = 0x7E;
     static constexpr uint16_t PPP_PROTO_IPV4 = 0x0021;
@@ -204,6 +254,31 @@ public:
     static constexpr uint8_t TCP_FLAG_ACK = 0x10;
     static constexpr uint8_t TCP_FLAG_URG = 0x20;
 
+    // TCP option kinds
+    static constexpr uint8_t TCP_OPTION_END = 0;
+    static constexpr uint8_t TCP_OPTION_NOP = 1;
+    static constexpr uint8_t TCP_OPTION_SACK_PERMITTED = 4;  // RFC 2018, SYN only
+    static constexpr uint8_t TCP_OPTION_SACK = 5;
+
+    /**
+     * SACK block (RFC 2018): the receiver holds [left_edge, right_edge)
+     */
+    struct SACKBlock {
+        uint32_t left_edge;
+        uint32_t right_edge;
+    };
+
+    /**
+     * Options of one segment that the stack acts on; others are skipped
+     */
+    struct Options {
+        static constexpr size_t kMaxSACKBlocks = 4;  // 40 option bytes hold at most 4
+
+        bool sack_permitted = false;
+        SACKBlock sack_blocks[kMaxSACKBlocks] = {};
+        size_t sack_block_count = 0;
+    };
+
     /**
      * Parse TCP header from segment
      * @param data TCP segment data
@@ -212,6 +287,13 @@ public:
      */
     static TCPHeader ParseHeader(const mtp::ByteArray& data);
 
+    /**
+     * Parse the options between the fixed header and the payload
+     * @param data TCP segment data
+     * @return Options found; empty if the segment has none or they are malformed
+     */
+    static Options ParseOptions(const mtp::ByteArray& data);
+
     /**
      * Extract payload from TCP segment
      * @param data TCP segment data
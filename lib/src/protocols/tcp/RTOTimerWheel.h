@@ -0,0 +1,189 @@
+#pragma once
+
+#include "TCPConnectionKey.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * RTOTimer - One segment's retransmission deadline
+ */
+struct RTOTimer {
+    TCPConnectionKey conn_key;
+    uint32_t seq_start = 0;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+/**
+ * RTOTimerWheel
+ *
+ * Hierarchical timer wheel of segment retransmission deadlines: three
+ * levels of 64 slots, 10 ms ticks at the bottom, covering 640 ms, 41 s and
+ * 44 min. Scheduling is constant time and expiry touches only the slots
+ * between the last call and now, so nothing is scanned while no segment
+ * is in flight, and NextDeadline() tells the poller how long it may sleep.
+ *
+ * Timers are not cancelled: an ACKed or resent segment leaves its timer in
+ * the wheel, and the caller drops it when it expires (the segment is gone,
+ * or its deadline has moved). RTOs are at least a second, so each sent
+ * segment costs one small entry for about that long.
+ *
+ * Not thread-safe; TCPConnectionManager guards it with connections_mutex_.
+ */
+class RTOTimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    static constexpr std::chrono::milliseconds kTick{10};
+
+    explicit RTOTimerWheel(TimePoint origin = Clock::now())
+        : origin_(origin) {}
+
+    void Schedule(const TCPConnectionKey& conn_key, uint32_t seq_start, TimePoint deadline) {
+        Insert(RTOTimer{conn_key, seq_start, deadline});
+    }
+
+    /**
+     * Remove and return the timers due by now, earliest first
+     */
+    std::vector<RTOTimer> Expire(TimePoint now) {
+        std::vector<RTOTimer> due;
+        uint64_t now_tick = TickOf(now);
+        if (size_ == 0) {
+            // Idle: nothing to walk past
+            current_tick_ = std::max(current_tick_, now_tick);
+            return due;
+        }
+
+        while (current_tick_ < now_tick) {
+            DrainSlot(levels_[0][current_tick_ & kSlotMask], now, due);
+            current_tick_++;
+            Cascade();
+        }
+        DrainSlot(levels_[0][current_tick_ & kSlotMask], now, due);
+
+        std::sort(due.begin(), due.end(), [](const RTOTimer& a, const RTOTimer& b) {
+            return a.deadline < b.deadline;
+        });
+        return due;
+    }
+
+    /**
+     * Earliest deadline in the wheel (possibly already past), or nullopt
+     * if empty
+     */
+    std::optional<TimePoint> NextDeadline() const {
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+        std::optional<TimePoint> next;
+        for (int level = 0; level < kLevels; level++) {
+            // Each slot holds one span of ticks, so the first occupied slot
+            // after the current position has this level's earliest timers
+            uint64_t first = (current_tick_ >> (level * kSlotBits)) + (level == 0 ? 0 : 1);
+            for (uint64_t i = 0; i < kSlots; i++) {
+                const std::vector<RTOTimer>& slot = levels_[level][(first + i) & kSlotMask];
+                if (slot.empty()) {
+                    continue;
+                }
+                for (const RTOTimer& timer : slot) {
+                    if (!next || timer.deadline < *next) {
+                        next = timer.deadline;
+                    }
+                }
+                break;
+            }
+        }
+        return next;
+    }
+
+    size_t Size() const { return size_; }
+
+    void Clear() {
+        for (auto& level : levels_) {
+            for (auto& slot : level) {
+                slot.clear();
+            }
+        }
+        size_ = 0;
+    }
+
+private:
+    static constexpr int kLevels = 3;
+    static constexpr int kSlotBits = 6;
+    static constexpr uint64_t kSlots = uint64_t(1) << kSlotBits;
+    static constexpr uint64_t kSlotMask = kSlots - 1;
+
+    uint64_t TickOf(TimePoint t) const {
+        if (t <= origin_) {
+            return 0;
+        }
+        return static_cast<uint64_t>((t - origin_) / kTick);
+    }
+
+    void Insert(RTOTimer timer) {
+        // Past deadlines go in the current slot and fire on the next Expire;
+        // anything beyond the top level waits in its last slot and is
+        // re-filed when that comes round
+        uint64_t tick = std::max(TickOf(timer.deadline), current_tick_);
+        uint64_t delta = tick - current_tick_;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (uint64_t(1) << ((level + 1) * kSlotBits))) {
+            level++;
+        }
+        uint64_t span = uint64_t(1) << ((level + 1) * kSlotBits);
+        if (delta >= span) {
+            tick = current_tick_ + span - 1;
+        }
+        levels_[level][(tick >> (level * kSlotBits)) & kSlotMask].push_back(std::move(timer));
+        size_++;
+    }
+
+    // Fire what is due; anything not yet due (the current, partly elapsed
+    // tick, or a deadline clamped into the top level) is filed again
+    void DrainSlot(std::vector<RTOTimer>& slot, TimePoint now, std::vector<RTOTimer>& due) {
+        if (slot.empty()) {
+            return;
+        }
+        std::vector<RTOTimer> timers;
+        timers.swap(slot);
+        size_ -= timers.size();
+        for (RTOTimer& timer : timers) {
+            if (timer.deadline <= now) {
+                due.push_back(std::move(timer));
+            } else {
+                Insert(std::move(timer));
+            }
+        }
+    }
+
+    // On entering a new span of a level, move its timers down a level
+    void Cascade() {
+        for (int level = kLevels - 1; level >= 1; level--) {
+            uint64_t shift = level * kSlotBits;
+            if ((current_tick_ & ((uint64_t(1) << shift) - 1)) != 0) {
+                continue;
+            }
+            std::vector<RTOTimer>& slot = levels_[level][(current_tick_ >> shift) & kSlotMask];
+            if (slot.empty()) {
+                continue;
+            }
+            std::vector<RTOTimer> timers;
+            timers.swap(slot);
+            size_ -= timers.size();
+            for (RTOTimer& timer : timers) {
+                Insert(std::move(timer));
+            }
+        }
+    }
+
+    TimePoint origin_;
+    uint64_t current_tick_ = 0;  // Ticks before this have been expired
+    std::vector<RTOTimer> levels_[kLevels][kSlots];
+    size_t size_ = 0;
+};
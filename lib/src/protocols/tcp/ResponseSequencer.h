@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+
+/**
+ * ResponseSequencer
+ *
+ * Puts the responses to one connection's pipelined HTTP requests onto its
+ * send stream in request order (RFC 7230 6.3.2), however the workers
+ * serving them finish.
+ *
+ * The receive path numbers each request with Assign(). A worker whose
+ * response is ready calls TryCommit(): in turn, the response commits at
+ * once (its SEQ range is reserved and its transmission started); otherwise
+ * the worker parks a copy with Submit() and returns. Whichever worker
+ * commits the response ahead of a parked one runs the parked commit too,
+ * in order, so a slow image fetch holds back only the bytes behind it on
+ * the wire, never a worker. A request that produces no response submits an
+ * empty commit so its successors are not held back.
+ *
+ * Reset() drops what is parked and retires every number assigned so far:
+ * a late commit for a request on a previous use of the connection is
+ * discarded rather than sent on the new one.
+ *
+ * Thread-safe. Commits run outside the lock, one at a time.
+ */
+class ResponseSequencer {
+public:
+    using Commit = std::function<void()>;
+
+    /**
+     * Number the next request received on the connection (from 1)
+     */
+    uint64_t Assign() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return next_assigned_++;
+    }
+
+    /**
+     * Run commit if request index is next, then any parked successors
+     * @return false (commit not run) if an earlier response is outstanding
+     */
+    bool TryCommit(uint64_t index, const Commit& commit) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (index != next_commit_ || committing_) {
+            return false;
+        }
+        committing_ = true;
+        lock.unlock();
+        if (commit) {
+            commit();
+        }
+        lock.lock();
+        Advance(index);
+        RunParked(lock);
+        return true;
+    }
+
+    /**
+     * Commit request index in turn: now if it is next, else when the
+     * response ahead of it commits. Discarded if the index was retired
+     * by Reset().
+     */
+    void Submit(uint64_t index, Commit commit) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (index < next_commit_) {
+            return;
+        }
+        parked_[index] = std::move(commit);
+        if (!committing_) {
+            RunParked(lock);
+        }
+    }
+
+    /**
+     * Drop parked commits and retire every index assigned so far
+     */
+    void Reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        parked_.clear();
+        next_commit_ = next_assigned_;
+    }
+
+    /**
+     * Responses ready but waiting for an earlier one
+     */
+    size_t Parked() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return parked_.size();
+    }
+
+private:
+    // Run parked commits while the next one is ready; lock is held on entry and exit
+    void RunParked(std::unique_lock<std::mutex>& lock) {
+        committing_ = true;
+        auto it = parked_.begin();
+        while (it != parked_.end() && it->first == next_commit_) {
+            uint64_t index = it->first;
+            Commit commit = std::move(it->second);
+            parked_.erase(it);
+            lock.unlock();
+            if (commit) {
+                commit();
+            }
+            lock.lock();
+            Advance(index);
+            it = parked_.begin();
+        }
+        committing_ = false;
+    }
+
+    // index has committed; unless a Reset() meanwhile moved past it
+    void Advance(uint64_t index) {
+        if (next_commit_ == index) {
+            next_commit_++;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    uint64_t next_assigned_ = 1;
+    uint64_t next_commit_ = 1;
+    bool committing_ = false;  // A thread is running commits
+    std::map<uint64_t, Commit> parked_;
+};
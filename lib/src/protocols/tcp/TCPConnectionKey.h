@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * TCPConnectionKey
+ *
+ * TCP 4-tuple identifying a connection, as seen in packets from the device
+ * (device = src, virtual server = dst). 96 bits of addresses and ports,
+ * compared and hashed as integers so per-segment lookups never format or
+ * allocate a string. ToString() renders the old "ip:port->ip:port" text
+ * for logs only.
+ */
+struct TCPConnectionKey {
+    uint32_t src_ip = 0;
+    uint32_t dst_ip = 0;
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+
+    bool operator==(const TCPConnectionKey& other) const {
+        return src_ip == other.src_ip && dst_ip == other.dst_ip &&
+               src_port == other.src_port && dst_port == other.dst_port;
+    }
+    bool operator!=(const TCPConnectionKey& other) const { return !(*this == other); }
+    bool operator<(const TCPConnectionKey& other) const {
+        return std::tie(src_ip, src_port, dst_ip, dst_port) <
+               std::tie(other.src_ip, other.src_port, other.dst_ip, other.dst_port);
+    }
+
+    size_t Hash() const {
+        // splitmix64 finalizer over both addresses, then the ports
+        uint64_t h = (uint64_t(src_ip) << 32) | dst_ip;
+        h ^= (uint64_t(src_port) << 16 | dst_port) * 0x9E3779B97F4A7C15ull;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<size_t>(h ^ (h >> 31));
+    }
+
+    /**
+     * "192.168.55.101:50120->192.168.0.30:80" (debug rendering)
+     */
+    std::string ToString() const {
+        char buf[48];
+        std::snprintf(buf, sizeof(buf), "%u.%u.%u.%u:%u->%u.%u.%u.%u:%u",
+                      (src_ip >> 24) & 0xFF, (src_ip >> 16) & 0xFF, (src_ip >> 8) & 0xFF, src_ip & 0xFF,
+                      unsigned(src_port),
+                      (dst_ip >> 24) & 0xFF, (dst_ip >> 16) & 0xFF, (dst_ip >> 8) & 0xFF, dst_ip & 0xFF,
+                      unsigned(dst_port));
+        return buf;
+    }
+};
+
+/**
+ * TCPConnectionTable
+ *
+ * Open-addressing table of connections keyed by TCPConnectionKey: linear
+ * probing over a power-of-two slot array kept at most half full, with
+ * backward-shift deletion so no tombstones build up as connections come
+ * and go. The device keeps only a handful of connections open, so a lookup
+ * is usually one probe of a slot array that fits in a few cache lines.
+ *
+ * Values are heap-allocated once per connection and never move, so
+ * pointers returned by Find stay valid until that key is erased. Not
+ * thread-safe; TCPConnectionManager guards it with connections_mutex_.
+ */
+template <typename T>
+class TCPConnectionTable {
+public:
+    TCPConnectionTable() : slots_(kInitialSlots) {}
+
+    T* Find(const TCPConnectionKey& key) const {
+        size_t mask = slots_.size() - 1;
+        for (size_t i = key.Hash() & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots_[i];
+            if (!slot.value) {
+                return nullptr;
+            }
+            if (slot.key == key) {
+                return slot.value.get();
+            }
+        }
+    }
+
+    /**
+     * Existing entry, or a default-constructed one
+     */
+    T& FindOrCreate(const TCPConnectionKey& key) {
+        if (T* existing = Find(key)) {
+            return *existing;
+        }
+        if ((size_ + 1) * 2 > slots_.size()) {
+            Grow();
+        }
+        Slot& slot = slots_[FreeSlot(key)];
+        slot.key = key;
+        slot.value = std::make_unique<T>();
+        size_++;
+        peak_ = std::max(peak_, size_);
+        return *slot.value;
+    }
+
+    bool Erase(const TCPConnectionKey& key) {
+        size_t mask = slots_.size() - 1;
+        size_t i = key.Hash() & mask;
+        while (true) {
+            if (!slots_[i].value) {
+                return false;
+            }
+            if (slots_[i].key == key) {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+
+        slots_[i].value.reset();
+        size_--;
+
+        // Shift later members of the probe run back into the hole
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask; slots_[j].value; j = (j + 1) & mask) {
+            size_t home = slots_[j].key.Hash() & mask;
+            // Movable unless its home lies cyclically in (hole, j]
+            bool stays = (hole <= j) ? (home > hole && home <= j)
+                                     : (home > hole || home <= j);
+            if (!stays) {
+                slots_[hole] = std::move(slots_[j]);
+                hole = j;
+            }
+        }
+        return true;
+    }
+
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+    size_t Peak() const { return peak_; }  // Most entries held at once
+
+    /**
+     * Grow the slot array so count entries fit without growing again
+     */
+    void Reserve(size_t count) {
+        while (count * 2 > slots_.size()) {
+            Grow();
+        }
+    }
+
+    /**
+     * fn(const TCPConnectionKey&, T&) for every entry, in slot order
+     */
+    template <typename Fn>
+    void ForEach(Fn&& fn) {
+        for (Slot& slot : slots_) {
+            if (slot.value) {
+                const TCPConnectionKey& key = slot.key;
+                fn(key, *slot.value);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kInitialSlots = 16;
+
+    struct Slot {
+        TCPConnectionKey key;
+        std::unique_ptr<T> value;  // Null: empty slot
+    };
+
+    size_t FreeSlot(const TCPConnectionKey& key) const {
+        size_t mask = slots_.size() - 1;
+        size_t i = key.Hash() & mask;
+        while (slots_[i].value) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void Grow() {
+        std::vector<Slot> old(slots_.size() * 2);
+        old.swap(slots_);
+        for (Slot& slot : old) {
+            if (slot.value) {
+                slots_[FreeSlot(slot.key)] = std::move(slot);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+    size_t peak_ = 0;
+};
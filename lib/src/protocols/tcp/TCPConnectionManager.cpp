@@ -5,6 +5,27 @@
 #include <random>
 #include <algorithm>
 
+namespace {
+
+// Locate the segment starting at seq among the transmissions
+bool FindSegment(std::map<uint32_t, HTTPTransmission>& transmissions, uint32_t seq,
+                 HTTPTransmission*& trans_out, size_t& index_out) {
+    for (auto& [base_seq, trans] : transmissions) {
+        uint32_t segment_start = base_seq;
+        for (size_t i = 0; i < trans.segment_payload_sizes.size(); i++) {
+            if (segment_start == seq) {
+                trans_out = &trans;
+                index_out = i;
+                return true;
+            }
+            segment_start += trans.segment_payload_sizes[i];
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 // ============================================================================
 // TCPConnectionInfo - State Machine Implementation
 // ============================================================================
@@ -69,15 +90,17 @@ bool TCPConnectionInfo::CanTransitionTo(TCPState new_state) const {
 // TCPConnectionInfo - RTO Implementation
 // ============================================================================
 
-void TCPConnectionInfo::RecordSentSegment(uint32_t seq_start, const mtp::ByteArray& data, bool is_retransmit) {
+std::chrono::steady_clock::time_point TCPConnectionInfo::RecordSentSegment(uint32_t seq_start, size_t payload_size,
+                                                                         bool is_retransmit) {
     SentSegment segment;
     segment.seq_start = seq_start;
-    segment.seq_end = seq_start + data.size();
+    segment.seq_end = seq_start + static_cast<uint32_t>(payload_size);
     segment.send_time = std::chrono::steady_clock::now();
+    segment.deadline = segment.send_time + rto_manager.GetRTO();
     segment.is_retransmit = is_retransmit;
-    segment.data = data;
 
     unacked_segments[seq_start] = segment;
+    return segment.deadline;
 }
 
 void TCPConnectionInfo::ProcessACKForRTO(uint32_t ack_num) {
@@ -116,31 +139,53 @@ void TCPConnectionInfo::ProcessACKForRTO(uint32_t ack_num) {
     }
 }
 
-std::vector<SentSegment> TCPConnectionInfo::CheckTimeouts() {
+std::vector<SentSegment> TCPConnectionInfo::CheckTimeouts(const std::vector<RTOTimer>& due,
+                                                          std::chrono::steady_clock::time_point now) {
     std::vector<SentSegment> timed_out;
-    auto now = std::chrono::steady_clock::now();
-    auto rto = rto_manager.GetRTO();
 
-    for (const auto& [seq, segment] : unacked_segments) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - segment.send_time);
-
-        if (elapsed >= rto) {
-            timed_out.push_back(segment);
-
-            if (log_callback && *log_callback) {
-                std::ostringstream oss;
-                oss << "Segment timeout: SEQ=" << segment.seq_start
-                    << " size=" << segment.data.size()
-                    << " elapsed=" << elapsed.count() << "ms"
-                    << " RTO=" << rto.count() << "ms";
-                (*log_callback)(oss.str());
-            }
+    for (const RTOTimer& timer : due) {
+        // Timers are not cancelled: skip segments since ACKed or re-armed
+        auto it = unacked_segments.find(timer.seq_start);
+        if (it == unacked_segments.end() || it->second.deadline != timer.deadline) {
+            continue;
+        }
+        const SentSegment& segment = it->second;
+        timed_out.push_back(segment);
+
+        if (log_callback && *log_callback) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - segment.send_time);
+            auto rto = std::chrono::duration_cast<std::chrono::milliseconds>(segment.deadline - segment.send_time);
+            std::ostringstream oss;
+            oss << "Segment timeout: SEQ=" << segment.seq_start
+                << " size=" << (segment.seq_end - segment.seq_start)
+                << " elapsed=" << elapsed.count() << "ms"
+                << " RTO=" << rto.count() << "ms";
+            (*log_callback)(oss.str());
         }
     }
 
-    if (!timed_out.empty()) {
-        rto_manager.OnRetransmit();
+    if (timed_out.empty()) {
+        return timed_out;
+    }
+
+    // Back off once per expiry, then restart each timer with the new RTO.
+    // Marked as retransmits so their ACKs give no RTT sample (Karn).
+    rto_manager.OnRetransmit();
+    auto deadline = now + rto_manager.GetRTO();
+
+    // An RTO ends any loss recovery, and SACK information is not trusted
+    // past it (RFC 2018: the receiver may renege)
+    recovery_point = 0;
+    for (auto& [seq, segment] : unacked_segments) {
+        segment.sacked = false;
+        segment.recovery_resent = false;
+    }
+    for (SentSegment& segment : timed_out) {
+        SentSegment& tracked = unacked_segments[segment.seq_start];
+        tracked.send_time = now;
+        tracked.deadline = deadline;
+        tracked.is_retransmit = true;
+        segment = tracked;
     }
 
     return timed_out;
@@ -151,6 +196,13 @@ std::vector<SentSegment> TCPConnectionInfo::CheckTimeouts() {
 // ============================================================================
 
 void TCPConnectionInfo::InitializeFlowControl() {
+    if (congestion_control == CongestionControlKind::USB_LINK) {
+        // The whole advertised window from the first segment (see UsbLinkCongestionControl)
+        flow_controller = std::make_unique<TCPFlowController>(
+            std::make_unique<UsbLinkCongestionControl>(receiver_window));
+        return;
+    }
+
     // Congestion control tuned from capture analysis of official Zune software:
     // - Official software sends max 4 segments per USB transfer (50% of cases)
     // - Max TCP payload observed: 5888 bytes = 4 * 1472
@@ -165,7 +217,8 @@ void TCPConnectionInfo::InitializeFlowControl() {
     );
 }
 
-bool TCPConnectionInfo::ProcessACK(uint32_t ack_num, uint16_t window_size) {
+bool TCPConnectionInfo::ProcessACK(uint32_t ack_num, uint16_t window_size,
+                                   const TCPParser::Options& options) {
     if (!flow_controller) {
         InitializeFlowControl();
     }
@@ -182,43 +235,86 @@ bool TCPConnectionInfo::ProcessACK(uint32_t ack_num, uint16_t window_size) {
     // Also process for RTO tracking
     ProcessACKForRTO(ack_num);
 
-    // Check for fast retransmit trigger
-    if (flow_controller->NeedsRetransmit()) {
-        // Find which transmission this ACK belongs to and calculate segment index
-        // using that transmission's segment boundaries (not the flow controller's
-        // which might be from a different transmission)
-        std::lock_guard<std::mutex> lock(transmissions_mutex);
-        for (auto& [base_seq, trans] : active_transmissions) {
-            // Check if ACK falls within this transmission's range
-            uint32_t trans_end = base_seq;
-            for (size_t payload : trans.segment_payload_sizes) {
-                trans_end += payload;
-            }
+    if (sack_permitted) {
+        ApplySACKBlocks(ack_num, options);
+    }
 
-            // ACK must be within or at the end of this transmission's range
-            if (ack_num > base_seq && ack_num <= trans_end) {
-                // Found the transmission - calculate which segment to retransmit
-                // The ACK indicates data received up to ack_num, so the lost segment
-                // is the one starting at ack_num
-                uint32_t expected_seq = base_seq;
-                for (size_t i = 0; i < trans.segment_payload_sizes.size(); i++) {
-                    uint32_t segment_end = expected_seq + trans.segment_payload_sizes[i];
-                    if (segment_end == ack_num && (i + 1) < trans.segment_payload_sizes.size()) {
-                        // Found: ACK acknowledges up to segment i, so segment i+1 is lost
-                        trans.state = TransmissionState::NEEDS_RETRANSMIT;
-                        trans.retransmit_segment_index = i + 1;
-                        break;
-                    }
-                    expected_seq = segment_end;
-                }
-                break;  // Only process one transmission per ACK
+    if (flow_controller->NeedsRetransmit()) {
+        // Fast retransmit (3 duplicate ACKs): recovery lasts until everything
+        // in flight now is ACKed. Later duplicates only add SACKed holes.
+        if (recovery_point == 0 && !unacked_segments.empty()) {
+            recovery_point = unacked_segments.rbegin()->second.seq_end;
+        }
+        if (MarkLostSegments(ack_num) > 0) {
+            fast_retransmits++;
+        }
+    } else if (recovery_point != 0 && new_data_acked) {
+        if (ack_num >= recovery_point) {
+            recovery_point = 0;
+            for (auto& [seq, segment] : unacked_segments) {
+                segment.recovery_resent = false;
             }
+        } else {
+            // Partial ACK: the next hole is lost too (NewReno), no need to
+            // wait for three more duplicates
+            MarkLostSegments(ack_num);
         }
     }
 
     return new_data_acked;
 }
 
+void TCPConnectionInfo::ApplySACKBlocks(uint32_t ack_num, const TCPParser::Options& options) {
+    for (size_t i = 0; i < options.sack_block_count; i++) {
+        const TCPParser::SACKBlock& block = options.sack_blocks[i];
+        // A block at or below the ACK is a D-SACK or stale; either way nothing to learn
+        if (block.left_edge >= block.right_edge || block.right_edge <= ack_num) {
+            continue;
+        }
+        for (auto it = unacked_segments.lower_bound(block.left_edge);
+             it != unacked_segments.end() && it->second.seq_end <= block.right_edge; ++it) {
+            it->second.sacked = true;
+        }
+    }
+}
+
+size_t TCPConnectionInfo::MarkLostSegments(uint32_t ack_num) {
+    // Everything the receiver skipped below its highest SACKed byte is lost
+    // (RFC 6675 is more patient, but reordering does not happen on USB)
+    uint32_t sacked_end = ack_num;
+    for (const auto& [seq, segment] : unacked_segments) {
+        if (segment.sacked && segment.seq_end > sacked_end) {
+            sacked_end = segment.seq_end;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(transmissions_mutex);
+    size_t marked = 0;
+    for (auto& [seq, segment] : unacked_segments) {
+        if (seq != ack_num && segment.seq_end > sacked_end) {
+            break;
+        }
+        if (segment.sacked || segment.recovery_resent) {
+            continue;
+        }
+
+        HTTPTransmission* trans = nullptr;
+        size_t index = 0;
+        if (!FindSegment(active_transmissions, seq, trans, index)) {
+            continue;
+        }
+        if (trans->retransmit_segments.empty()) {
+            trans->retransmit_segment_index = index;
+        }
+        trans->retransmit_segments.push_back(index);
+        trans->state = TransmissionState::NEEDS_RETRANSMIT;
+        segment.recovery_resent = true;
+        segment.is_retransmit = true;  // No RTT sample from its ACK (Karn)
+        marked++;
+    }
+    return marked;
+}
+
 void TCPConnectionInfo::RecordBytesSent(size_t payload_size, uint32_t seq_num) {
     if (!flow_controller) {
         InitializeFlowControl();
@@ -232,13 +328,11 @@ size_t TCPConnectionInfo::GetAvailableWindow() const {
     // - receiver_window: total buffer capacity the device advertises (32KB)
     // - cwnd: congestion window that grows based on ACK feedback
     //
-    // Even on USB, cwnd provides essential ACK-clocked pacing:
-    // 1. Initial cwnd is small (3 segments = ~4KB)
-    // 2. Each successful ACK grows cwnd (slow start, then linear)
-    // 3. Duplicate ACKs shrink cwnd (fast recovery)
-    //
-    // This lets ACK feedback naturally control our send rate.
-    // No hardcoded limits - the device's ACKs ARE the signal.
+    // Even on USB, cwnd provides essential ACK-clocked pacing. How it
+    // starts and moves is up to the connection's CongestionControl:
+    // - Reno: starts small, grows per ACK (slow start, then linear)
+    // - USB link: starts at the receiver window, halves on a loss
+    // Either way duplicate ACKs shrink cwnd (fast recovery).
 
     size_t bytes_in_flight = flow_controller ? flow_controller->GetBytesInFlight() : 0;
     size_t cwnd = flow_controller ? flow_controller->GetCongestionWindow() : receiver_window;
@@ -273,9 +367,10 @@ void TCPConnectionInfo::ClearRetransmitFlag() {
 
     std::lock_guard<std::mutex> lock(transmissions_mutex);
     for (auto& [base_seq, trans] : active_transmissions) {
+        trans.retransmit_segments.clear();
         if (trans.state == TransmissionState::NEEDS_RETRANSMIT) {
             // If all segments already sent, go to AWAITING_ACKS, not IN_PROGRESS
-            if (trans.next_segment_index >= trans.queued_segments.size()) {
+            if (trans.next_segment_index >= trans.SegmentCount()) {
                 trans.state = TransmissionState::AWAITING_ACKS;
             } else {
                 trans.state = TransmissionState::IN_PROGRESS;
@@ -288,6 +383,15 @@ void TCPConnectionInfo::ClearRetransmitFlag() {
 // TCPConnectionInfo - HTTP Transmission Implementation
 // ============================================================================
 
+mtp::ByteArray HTTPTransmission::Frame(size_t index) const {
+    if (!framer) {
+        return queued_segments[index];
+    }
+    mtp::ByteArray frame;
+    framer(index, frame);
+    return frame;
+}
+
 void TCPConnectionInfo::StartTransmission(uint32_t base_seq,
                                           std::vector<mtp::ByteArray> segments,
                                           std::vector<size_t> payload_sizes) {
@@ -297,6 +401,10 @@ void TCPConnectionInfo::StartTransmission(uint32_t base_seq,
     trans.base_seq = base_seq;
     trans.queued_segments = std::move(segments);
     trans.segment_payload_sizes = std::move(payload_sizes);
+    trans.ready_segments = trans.queued_segments.size();
+    if (trans.queued_segments.size() < trans.segment_payload_sizes.size()) {
+        trans.queued_segments.resize(trans.segment_payload_sizes.size());  // Filled by AddHTTPSegments
+    }
     trans.next_segment_index = 0;
     trans.state = TransmissionState::PENDING;
     trans.last_ack_time = std::chrono::steady_clock::now();
@@ -309,6 +417,26 @@ void TCPConnectionInfo::StartTransmission(uint32_t base_seq,
     active_transmissions[base_seq] = std::move(trans);
 }
 
+void TCPConnectionInfo::StartTransmission(uint32_t base_seq, SegmentFramer framer,
+                                          std::vector<size_t> payload_sizes) {
+    std::lock_guard<std::mutex> lock(transmissions_mutex);
+
+    HTTPTransmission trans;
+    trans.base_seq = base_seq;
+    trans.framer = std::move(framer);
+    trans.segment_payload_sizes = std::move(payload_sizes);
+    trans.ready_segments = trans.segment_payload_sizes.size();  // Every frame can be built now
+    trans.next_segment_index = 0;
+    trans.state = TransmissionState::PENDING;
+    trans.last_ack_time = std::chrono::steady_clock::now();
+
+    if (flow_controller) {
+        flow_controller->SetSegmentBoundaries(base_seq, trans.segment_payload_sizes);
+    }
+
+    active_transmissions[base_seq] = std::move(trans);
+}
+
 HTTPTransmission* TCPConnectionInfo::GetTransmissionForACK(uint32_t ack_num) {
     std::lock_guard<std::mutex> lock(transmissions_mutex);
 
@@ -327,21 +455,26 @@ HTTPTransmission* TCPConnectionInfo::GetTransmissionForACK(uint32_t ack_num) {
     return nullptr;
 }
 
-size_t TCPConnectionInfo::CalculateSegmentsToSend(const HTTPTransmission& trans, size_t max_batch) const {
+size_t TCPConnectionInfo::CalculateSegmentsToSend(const HTTPTransmission& trans, size_t max_batch,
+                                                  uint64_t link_bytes_per_sec) const {
     size_t available_window = GetAvailableWindow();
     if (available_window == 0) {
         return 0;
     }
 
+    // Pacing caps the batch below the window, but always lets one segment out
+    size_t pacing_budget = flow_controller ? flow_controller->GetPacingBudget(link_bytes_per_sec) : SIZE_MAX;
+
     size_t segments_to_send = 0;
     size_t bytes_to_send = 0;
 
     for (size_t i = trans.next_segment_index;
-         i < trans.queued_segments.size() && segments_to_send < max_batch;
+         i < trans.ready_segments && segments_to_send < max_batch;
          i++) {
         size_t payload_size = trans.segment_payload_sizes[i];
 
-        if (bytes_to_send + payload_size <= available_window) {
+        if (bytes_to_send + payload_size <= available_window &&
+            (segments_to_send == 0 || bytes_to_send + payload_size <= pacing_budget)) {
             segments_to_send++;
             bytes_to_send += payload_size;
         } else {
@@ -383,7 +516,7 @@ bool TCPConnectionInfo::UpdateTransmissionAfterACK(HTTPTransmission& trans, uint
     trans.last_ack_time = std::chrono::steady_clock::now();
 
     // All segments sent - check if all ACKed
-    if (trans.next_segment_index >= trans.queued_segments.size()) {
+    if (trans.next_segment_index >= trans.SegmentCount()) {
         trans.state = TransmissionState::COMPLETE;
         return true;
     }
@@ -415,9 +548,10 @@ std::optional<TCPPacket> TCPConnectionManager::HandlePacket(
     uint32_t dst_ip, uint16_t dst_port,
     uint32_t seq_num, uint32_t ack_num,
     uint8_t flags, uint16_t window_size,
-    const mtp::ByteArray& payload) {
+    const mtp::ByteArray& payload,
+    const TCPParser::Options& options) {
 
-    std::string conn_key = MakeConnectionKey(src_ip, src_port, dst_ip, dst_port);
+    TCPConnectionKey conn_key = MakeConnectionKey(src_ip, src_port, dst_ip, dst_port);
 
     // Priority order: RST > SYN > FIN > ACK
     if (flags & TCPParser::TCP_FLAG_RST) {
@@ -426,7 +560,8 @@ std::optional<TCPPacket> TCPConnectionManager::HandlePacket(
 
     if (flags & TCPParser::TCP_FLAG_SYN) {
         if (!(flags & TCPParser::TCP_FLAG_ACK)) {
-            return HandleSYN(conn_key, src_ip, src_port, dst_ip, dst_port, seq_num, window_size);
+            return HandleSYN(conn_key, src_ip, src_port, dst_ip, dst_port, seq_num, window_size,
+                             options.sack_permitted);
         }
         Log("SYN-ACK received from device");
         return std::nullopt;
@@ -444,14 +579,14 @@ std::optional<TCPPacket> TCPConnectionManager::HandlePacket(
 }
 
 std::optional<TCPPacket> TCPConnectionManager::HandleSYN(
-    const std::string& conn_key,
+    const TCPConnectionKey& conn_key,
     uint32_t src_ip, uint16_t src_port,
     uint32_t dst_ip, uint16_t dst_port,
-    uint32_t seq_num, uint16_t window_size) {
+    uint32_t seq_num, uint16_t window_size, bool sack_permitted) {
 
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    TCPConnectionInfo& conn = connections_[conn_key];
+    TCPConnectionInfo& conn = connections_.FindOrCreate(conn_key);
     conn.log_callback = &log_callback_;
 
     if (!conn.TransitionTo(TCPState::SYN_RECEIVED)) {
@@ -465,9 +600,8 @@ std::optional<TCPPacket> TCPConnectionManager::HandleSYN(
     if (log_callback_) {
         conn.reassembler->SetLogCallback(log_callback_);
     }
-
-    // Initialize flow controller for this connection
-    conn.InitializeFlowControl();
+    // Responses still owed on a previous use of this connection are not sent on this one
+    conn.response_order.Reset();
 
     // CRITICAL: Set the receiver window from the SYN packet
     // This is the client's advertised window and must be respected to avoid buffer overflow!
@@ -476,6 +610,11 @@ std::optional<TCPPacket> TCPConnectionManager::HandleSYN(
     conn.receiver_window = window_size;
     Log("SYN window_size=" + std::to_string(window_size) + " - receiver window set");
 
+    // Initialize flow controller for this connection (the USB link strategy
+    // starts from the receiver window, so it is set first)
+    conn.congestion_control = congestion_control_.load(std::memory_order_relaxed);
+    conn.InitializeFlowControl();
+
     // Generate random ISN
     std::random_device rd;
     std::uniform_int_distribution<uint32_t> dist(0, 0xFFFFFFFF);
@@ -493,11 +632,18 @@ std::optional<TCPPacket> TCPConnectionManager::HandleSYN(
     response.ack_num = conn.ack_num;
     response.flags = TCPParser::TCP_FLAG_SYN | TCPParser::TCP_FLAG_ACK;
 
+    // Echo SACK-permitted if offered, so the device reports every hole at once
+    conn.sack_permitted = sack_permitted;
+    if (sack_permitted) {
+        response.options = {TCPParser::TCP_OPTION_NOP, TCPParser::TCP_OPTION_NOP,
+                            TCPParser::TCP_OPTION_SACK_PERMITTED, 2};
+    }
+
     return response;
 }
 
 std::optional<TCPPacket> TCPConnectionManager::HandleACK(
-    const std::string& conn_key,
+    const TCPConnectionKey& conn_key,
     uint32_t src_ip, uint16_t src_port,
     uint32_t dst_ip, uint16_t dst_port,
     uint32_t seq_num, uint32_t ack_num,
@@ -505,12 +651,12 @@ std::optional<TCPPacket> TCPConnectionManager::HandleACK(
 
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
         return std::nullopt;
     }
 
-    TCPConnectionInfo& conn = it->second;
+    TCPConnectionInfo& conn = *found;
     conn.log_callback = &log_callback_;
 
     // Handle final ACK of handshake
@@ -542,6 +688,10 @@ std::optional<TCPPacket> TCPConnectionManager::HandleACK(
             }
 
             conn.ack_num = conn.reassembler->GetNextExpectedSeq();
+
+            // The next request on a kept-alive connection carries the ACK
+            // for the last response; stop those segments' RTO timers
+            conn.ProcessACKForRTO(ack_num);
         }
 
         return std::nullopt;
@@ -564,20 +714,20 @@ std::optional<TCPPacket> TCPConnectionManager::HandleACK(
 }
 
 std::optional<TCPPacket> TCPConnectionManager::HandleFIN(
-    const std::string& conn_key,
+    const TCPConnectionKey& conn_key,
     uint32_t src_ip, uint16_t src_port,
     uint32_t dst_ip, uint16_t dst_port,
     uint32_t seq_num) {
 
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
         Log("FIN received for non-existent connection - ignoring");
         return std::nullopt;
     }
 
-    TCPConnectionInfo& conn = it->second;
+    TCPConnectionInfo& conn = *found;
     conn.log_callback = &log_callback_;
 
     Log("FIN received (current state: " + TCPStateToString(conn.state) + ")");
@@ -610,20 +760,18 @@ std::optional<TCPPacket> TCPConnectionManager::HandleFIN(
     return response;
 }
 
-std::optional<TCPPacket> TCPConnectionManager::HandleRST(const std::string& conn_key) {
+std::optional<TCPPacket> TCPConnectionManager::HandleRST(const TCPConnectionKey& conn_key) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it != connections_.end()) {
-        TCPConnectionInfo& conn = it->second;
-        conn.log_callback = &log_callback_;
+    if (TCPConnectionInfo* conn = connections_.Find(conn_key)) {
+        conn->log_callback = &log_callback_;
 
         Log("RST received, closing connection (current state: " +
-            TCPStateToString(conn.state) + ")");
+            TCPStateToString(conn->state) + ")");
 
-        conn.TransitionTo(TCPState::CLOSED);
-        conn.reassembler.reset();
-        connections_.erase(it);
+        conn->TransitionTo(TCPState::CLOSED);
+        conn->reassembler.reset();
+        connections_.Erase(conn_key);
     }
 
     return std::nullopt;
@@ -633,23 +781,28 @@ std::optional<TCPPacket> TCPConnectionManager::HandleRST(const std::string& conn
 // TCPConnectionManager - HTTP Transmission Methods
 // ============================================================================
 
-uint32_t TCPConnectionManager::ProcessACKForTransmission(const std::string& conn_key,
-                                                          uint32_t ack_num, uint16_t window_size) {
+uint32_t TCPConnectionManager::ProcessACKForTransmission(const TCPConnectionKey& conn_key,
+                                                          uint32_t ack_num, uint16_t window_size,
+                                                          const TCPParser::Options& options) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
         return 0;
     }
 
-    TCPConnectionInfo& conn = it->second;
+    TCPConnectionInfo& conn = *found;
 
     // Log flow control state before processing
     size_t bytes_in_flight_before = conn.flow_controller ? conn.flow_controller->GetBytesInFlight() : 0;
     uint32_t last_acked_before = conn.flow_controller ? conn.flow_controller->GetLastAckedSeq() : 0;
 
     // Process ACK through flow controller
-    bool new_data_acked = conn.ProcessACK(ack_num, window_size);
+    uint32_t fast_retransmits_before = conn.fast_retransmits;
+    bool new_data_acked = conn.ProcessACK(ack_num, window_size, options);
+    if (conn.fast_retransmits != fast_retransmits_before) {
+        fast_retransmits_.fetch_add(1, std::memory_order_relaxed);
+    }
 
     // Log flow control state after processing
     size_t bytes_in_flight_after = conn.flow_controller ? conn.flow_controller->GetBytesInFlight() : 0;
@@ -667,7 +820,7 @@ uint32_t TCPConnectionManager::ProcessACKForTransmission(const std::string& conn
         trans->last_ack_time = std::chrono::steady_clock::now();
 
         // Check if all segments have been sent
-        bool all_segments_sent = (trans->next_segment_index >= trans->queued_segments.size());
+        bool all_segments_sent = (trans->next_segment_index >= trans->SegmentCount());
 
         if (all_segments_sent) {
             // Calculate end sequence (base_seq + total payload)
@@ -682,6 +835,9 @@ uint32_t TCPConnectionManager::ProcessACKForTransmission(const std::string& conn
                 trans->state = TransmissionState::COMPLETE;
                 Log("Transmission COMPLETE: base_seq=" + std::to_string(trans->base_seq) +
                     ", end_seq=" + std::to_string(end_seq) + ", ack=" + std::to_string(ack_num));
+                // Nothing left to resend: release the body or frames it holds
+                // now rather than when the keep-alive connection closes
+                conn.RemoveTransmission(trans->base_seq);
                 return 0;
             }
 
@@ -698,36 +854,94 @@ uint32_t TCPConnectionManager::ProcessACKForTransmission(const std::string& conn
     return 0;
 }
 
-void TCPConnectionManager::StartHTTPTransmission(const std::string& conn_key,
+void TCPConnectionManager::StartHTTPTransmission(const TCPConnectionKey& conn_key,
                                                   uint32_t base_seq,
                                                   std::vector<mtp::ByteArray> segments,
                                                   std::vector<size_t> payload_sizes) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
-        Log("StartHTTPTransmission: connection not found: " + conn_key);
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
+        Log("StartHTTPTransmission: connection not found: " + conn_key.ToString());
         return;
     }
 
-    TCPConnectionInfo& conn = it->second;
+    TCPConnectionInfo& conn = *found;
     conn.StartTransmission(base_seq, std::move(segments), std::move(payload_sizes));
 
     Log("Started HTTP transmission: base_seq=" + std::to_string(base_seq) +
-        ", segments=" + std::to_string(conn.active_transmissions[base_seq].queued_segments.size()));
+        ", segments=" + std::to_string(conn.active_transmissions[base_seq].SegmentCount()));
+}
+
+void TCPConnectionManager::StartHTTPTransmission(const TCPConnectionKey& conn_key,
+                                                  uint32_t base_seq,
+                                                  SegmentFramer framer,
+                                                  std::vector<size_t> payload_sizes) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
+        Log("StartHTTPTransmission: connection not found: " + conn_key.ToString());
+        return;
+    }
+
+    size_t segments = payload_sizes.size();
+    found->StartTransmission(base_seq, std::move(framer), std::move(payload_sizes));
+
+    Log("Started HTTP transmission: base_seq=" + std::to_string(base_seq) +
+        ", segments=" + std::to_string(segments) + " (framed on demand)");
+}
+
+bool TCPConnectionManager::AddHTTPSegments(const TCPConnectionKey& conn_key, uint32_t base_seq,
+                                           std::vector<mtp::ByteArray> segments) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> trans_lock(found->transmissions_mutex);
+    auto trans_it = found->active_transmissions.find(base_seq);
+    if (trans_it == found->active_transmissions.end()) {
+        return false;
+    }
+
+    HTTPTransmission& trans = trans_it->second;
+    for (auto& segment : segments) {
+        if (trans.ready_segments >= trans.SegmentCount()) {
+            break;  // More than the reserved range; the caller sized it from Content-Length
+        }
+        trans.queued_segments[trans.ready_segments++] = std::move(segment);
+    }
+    return true;
 }
 
-size_t TCPConnectionManager::GetNextBatch(const std::string& conn_key, uint32_t base_seq,
+void TCPConnectionManager::ResetConnection(const TCPConnectionKey& conn_key) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+
+    if (TCPConnectionInfo* conn = connections_.Find(conn_key)) {
+        conn->log_callback = &log_callback_;
+        Log("Resetting connection " + conn_key.ToString() + " (current state: " +
+            TCPStateToString(conn->state) + ")");
+
+        conn->TransitionTo(TCPState::CLOSED);
+        conn->reassembler.reset();
+        connections_.Erase(conn_key);
+    }
+}
+
+size_t TCPConnectionManager::GetNextBatch(const TCPConnectionKey& conn_key, uint32_t base_seq,
                                            std::vector<mtp::ByteArray>& segments_out,
                                            bool& is_last_batch) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
         return 0;
     }
 
-    TCPConnectionInfo& conn = it->second;
+    TCPConnectionInfo& conn = *found;
 
     std::lock_guard<std::mutex> trans_lock(conn.transmissions_mutex);
     auto trans_it = conn.active_transmissions.find(base_seq);
@@ -738,18 +952,24 @@ size_t TCPConnectionManager::GetNextBatch(const std::string& conn_key, uint32_t
     HTTPTransmission& trans = trans_it->second;
 
     if (trans.IsComplete() ||
-        trans.next_segment_index >= trans.queued_segments.size()) {
+        trans.next_segment_index >= trans.SegmentCount()) {
         is_last_batch = true;
         return 0;
     }
 
+    // Streamed body: the next segment has not arrived yet; AddHTTPSegments resumes
+    if (trans.next_segment_index >= trans.ready_segments) {
+        return 0;
+    }
+
     // Transition to IN_PROGRESS on first send
     if (trans.state == TransmissionState::PENDING) {
         trans.state = TransmissionState::IN_PROGRESS;
     }
 
     // Determine batch size based on receiver window (the device tells us what it can accept)
-    size_t segments_to_send = conn.CalculateSegmentsToSend(trans, trans.queued_segments.size() - trans.next_segment_index);
+    size_t segments_to_send = conn.CalculateSegmentsToSend(trans, trans.ready_segments - trans.next_segment_index,
+                                                           GetLinkRate());
     if (segments_to_send == 0) {
         // Debug: why is window full?
         size_t avail = conn.GetAvailableWindow();
@@ -758,7 +978,7 @@ size_t TCPConnectionManager::GetNextBatch(const std::string& conn_key, uint32_t
             ", bytes_in_flight=" + std::to_string(bif) +
             ", receiver_window=" + std::to_string(conn.receiver_window) +
             ", next_idx=" + std::to_string(trans.next_segment_index) +
-            ", total=" + std::to_string(trans.queued_segments.size()) +
+            ", total=" + std::to_string(trans.SegmentCount()) +
             ", state=" + TransmissionStateToString(trans.state));
         return 0;
     }
@@ -770,7 +990,7 @@ size_t TCPConnectionManager::GetNextBatch(const std::string& conn_key, uint32_t
 
     for (size_t i = 0; i < segments_to_send; i++) {
         size_t idx = trans.next_segment_index + i;
-        segments_out.push_back(trans.queued_segments[idx]);
+        segments_out.push_back(trans.Frame(idx));
         bytes_to_send += trans.segment_payload_sizes[idx];
     }
 
@@ -786,12 +1006,15 @@ size_t TCPConnectionManager::GetNextBatch(const std::string& conn_key, uint32_t
         size_t idx = trans.next_segment_index + i;
         size_t payload = trans.segment_payload_sizes[idx];
         conn.RecordBytesSent(payload, current_seq);
+        if (payload > 0) {
+            rto_timers_.Schedule(conn_key, current_seq, conn.RecordSentSegment(current_seq, payload));
+        }
         current_seq += payload;
     }
 
     trans.next_segment_index += segments_to_send;
 
-    is_last_batch = (trans.next_segment_index >= trans.queued_segments.size());
+    is_last_batch = (trans.next_segment_index >= trans.SegmentCount());
 
     // Transition to AWAITING_ACKS when all segments sent
     if (is_last_batch && trans.state == TransmissionState::IN_PROGRESS) {
@@ -801,21 +1024,18 @@ size_t TCPConnectionManager::GetNextBatch(const std::string& conn_key, uint32_t
     return segments_to_send;
 }
 
-bool TCPConnectionManager::CheckRetransmitNeeded(const std::string& conn_key,
+bool TCPConnectionManager::CheckRetransmitNeeded(const TCPConnectionKey& conn_key,
                                                   uint32_t& base_seq, size_t& segment_index) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
         return false;
     }
 
-    TCPConnectionInfo& conn = it->second;
-
-    if (!conn.NeedsFastRetransmit()) {
-        return false;
-    }
+    TCPConnectionInfo& conn = *found;
 
+    // Set by fast retransmit (ProcessACK) or an RTO (HandleRTORetransmit)
     std::lock_guard<std::mutex> trans_lock(conn.transmissions_mutex);
     for (auto& [seq, trans] : conn.active_transmissions) {
         if (trans.NeedsRetransmit()) {
@@ -828,16 +1048,16 @@ bool TCPConnectionManager::CheckRetransmitNeeded(const std::string& conn_key,
     return false;
 }
 
-mtp::ByteArray TCPConnectionManager::GetRetransmitSegment(const std::string& conn_key,
+mtp::ByteArray TCPConnectionManager::GetRetransmitSegment(const TCPConnectionKey& conn_key,
                                                            uint32_t base_seq, size_t segment_index) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
         return {};
     }
 
-    TCPConnectionInfo& conn = it->second;
+    TCPConnectionInfo& conn = *found;
 
     std::lock_guard<std::mutex> trans_lock(conn.transmissions_mutex);
     auto trans_it = conn.active_transmissions.find(base_seq);
@@ -846,51 +1066,86 @@ mtp::ByteArray TCPConnectionManager::GetRetransmitSegment(const std::string& con
     }
 
     HTTPTransmission& trans = trans_it->second;
-    if (segment_index >= trans.queued_segments.size()) {
+    if (segment_index >= trans.ready_segments) {
         return {};
     }
 
-    return trans.queued_segments[segment_index];
+    return trans.Frame(segment_index);
 }
 
-void TCPConnectionManager::ClearRetransmitFlag(const std::string& conn_key) {
+void TCPConnectionManager::ClearRetransmitFlag(const TCPConnectionKey& conn_key) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it != connections_.end()) {
-        it->second.ClearRetransmitFlag();
+    if (TCPConnectionInfo* conn = connections_.Find(conn_key)) {
+        conn->ClearRetransmitFlag();
     }
 }
 
+size_t TCPConnectionManager::TakeRetransmitFrames(const TCPConnectionKey& conn_key,
+                                                  std::vector<mtp::ByteArray>& frames_out) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
+        return 0;
+    }
+
+    TCPConnectionInfo& conn = *found;
+    size_t taken = 0;
+    {
+        std::lock_guard<std::mutex> trans_lock(conn.transmissions_mutex);
+        for (auto& [seq, trans] : conn.active_transmissions) {
+            if (!trans.NeedsRetransmit()) {
+                continue;
+            }
+            if (trans.retransmit_segments.empty()) {
+                trans.retransmit_segments.push_back(trans.retransmit_segment_index);
+            }
+            std::sort(trans.retransmit_segments.begin(), trans.retransmit_segments.end());
+            for (size_t index : trans.retransmit_segments) {
+                if (index < trans.ready_segments) {
+                    frames_out.push_back(trans.Frame(index));
+                    taken++;
+                }
+            }
+        }
+    }
+
+    // Takes transmissions_mutex itself
+    conn.ClearRetransmitFlag();
+    return taken;
+}
+
 // ============================================================================
 // TCPConnectionManager - Utility Methods
 // ============================================================================
 
-TCPConnectionInfo* TCPConnectionManager::GetConnection(const std::string& conn_key) {
+TCPConnectionInfo* TCPConnectionManager::GetConnection(const TCPConnectionKey& conn_key) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it != connections_.end()) {
-        return &it->second;
-    }
-    return nullptr;
+    return connections_.Find(conn_key);
 }
 
-TCPConnectionInfo& TCPConnectionManager::GetOrCreateConnection(const std::string& conn_key) {
+TCPConnectionInfo& TCPConnectionManager::GetOrCreateConnection(const TCPConnectionKey& conn_key) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
-    TCPConnectionInfo& conn = connections_[conn_key];
+    TCPConnectionInfo& conn = connections_.FindOrCreate(conn_key);
     conn.log_callback = &log_callback_;
+    if (!conn.flow_controller) {
+        conn.congestion_control = congestion_control_.load(std::memory_order_relaxed);
+    }
     return conn;
 }
 
-std::string TCPConnectionManager::MakeConnectionKey(
+TCPConnectionKey TCPConnectionManager::MakeConnectionKey(
     uint32_t src_ip, uint16_t src_port,
     uint32_t dst_ip, uint16_t dst_port) {
 
-    std::ostringstream oss;
-    oss << IPParser::IPToString(src_ip) << ":" << src_port << "->"
-        << IPParser::IPToString(dst_ip) << ":" << dst_port;
-    return oss.str();
+    TCPConnectionKey key;
+    key.src_ip = src_ip;
+    key.dst_ip = dst_ip;
+    key.src_port = src_port;
+    key.dst_port = dst_port;
+    return key;
 }
 
 std::vector<mtp::ByteArray> TCPConnectionManager::SegmentHTTPPayload(
@@ -939,53 +1194,149 @@ void TCPConnectionManager::SetLogCallback(LogCallback callback) {
     log_callback_ = callback;
 }
 
+void TCPConnectionManager::SetCongestionControl(CongestionControlKind kind) {
+    congestion_control_.store(kind, std::memory_order_relaxed);
+}
+
+void TCPConnectionManager::RecordLinkTransfer(size_t bytes, std::chrono::microseconds elapsed) {
+    if (bytes == 0 || elapsed.count() <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(link_mutex_);
+    link_bytes_ = link_bytes_ * 7 / 8 + static_cast<double>(bytes);
+    link_us_ = link_us_ * 7 / 8 + static_cast<double>(elapsed.count());
+    link_rate_.store(static_cast<uint64_t>(link_bytes_ * 1e6 / link_us_), std::memory_order_relaxed);
+}
+
+void TCPConnectionManager::SeedLinkRate(uint64_t bytes_per_sec) {
+    if (bytes_per_sec == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(link_mutex_);
+    link_bytes_ = static_cast<double>(bytes_per_sec) / 1000;
+    link_us_ = 1000;
+    link_rate_.store(bytes_per_sec, std::memory_order_relaxed);
+}
+
+void TCPConnectionManager::ReserveConnections(size_t count) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connections_.Reserve(count);
+}
+
+size_t TCPConnectionManager::GetPeakConnections() const {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    return connections_.Peak();
+}
+
 void TCPConnectionManager::Log(const std::string& message) {
     if (log_callback_) {
         log_callback_(message);
     }
 }
 
-std::vector<std::string> TCPConnectionManager::GetActiveConnectionKeys() {
+std::vector<TCPConnectionKey> TCPConnectionManager::GetActiveConnectionKeys() {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    std::vector<std::string> keys;
-    keys.reserve(connections_.size());
+    std::vector<TCPConnectionKey> keys;
+    keys.reserve(connections_.Size());
 
-    for (const auto& [key, conn] : connections_) {
+    connections_.ForEach([&](const TCPConnectionKey& key, TCPConnectionInfo& conn) {
         // Only include connections with active transmissions
         if (!conn.active_transmissions.empty()) {
             keys.push_back(key);
         }
-    }
+    });
 
     return keys;
 }
 
-std::map<std::string, std::vector<SentSegment>> TCPConnectionManager::CheckAllTimeouts() {
+std::vector<TCPConnectionStats> TCPConnectionManager::GetConnectionStats() {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    std::map<std::string, std::vector<SentSegment>> result;
+    std::vector<TCPConnectionStats> stats;
+    stats.reserve(connections_.Size());
+
+    connections_.ForEach([&](const TCPConnectionKey& key, TCPConnectionInfo& conn) {
+        TCPConnectionStats s;
+        s.conn_key = key;
+        s.state = conn.state;
+        if (conn.flow_controller) {
+            s.cwnd = conn.flow_controller->GetCongestionWindow();
+            s.ssthresh = conn.flow_controller->GetSlowStartThreshold();
+            s.bytes_in_flight = conn.flow_controller->GetBytesInFlight();
+        }
+        s.receiver_window = conn.receiver_window;
+        s.srtt = conn.rto_manager.GetSRTT();
+        s.rto = conn.rto_manager.GetRTO();
+        s.unacked_segments = conn.unacked_segments.size();
+        {
+            std::lock_guard<std::mutex> trans_lock(conn.transmissions_mutex);
+            s.active_transmissions = conn.active_transmissions.size();
+        }
+        s.sack_permitted = conn.sack_permitted;
+        s.fast_retransmits = conn.fast_retransmits;
+        s.rto_retransmits = conn.rto_retransmits;
+        stats.push_back(s);
+    });
+
+    return stats;
+}
+
+std::vector<std::pair<TCPConnectionKey, std::vector<SentSegment>>> TCPConnectionManager::CheckAllTimeouts(
+    std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+
+    std::vector<std::pair<TCPConnectionKey, std::vector<SentSegment>>> result;
+    std::vector<RTOTimer> due = rto_timers_.Expire(now);
+    if (due.empty()) {
+        return result;
+    }
 
-    for (auto& [conn_key, conn] : connections_) {
-        std::vector<SentSegment> timed_out = conn.CheckTimeouts();
-        if (!timed_out.empty()) {
-            result[conn_key] = std::move(timed_out);
+    // Group by connection, keeping deadline order within each
+    std::vector<std::pair<TCPConnectionKey, std::vector<RTOTimer>>> by_conn;
+    for (RTOTimer& timer : due) {
+        auto it = std::find_if(by_conn.begin(), by_conn.end(),
+                               [&](const auto& entry) { return entry.first == timer.conn_key; });
+        if (it == by_conn.end()) {
+            by_conn.emplace_back(timer.conn_key, std::vector<RTOTimer>());
+            it = by_conn.end() - 1;
         }
+        it->second.push_back(std::move(timer));
+    }
+
+    for (const auto& [conn_key, timers] : by_conn) {
+        TCPConnectionInfo* conn = connections_.Find(conn_key);
+        if (!conn) {
+            continue;  // Closed since; its timers just lapse
+        }
+        std::vector<SentSegment> timed_out = conn->CheckTimeouts(timers, now);
+        if (timed_out.empty()) {
+            continue;
+        }
+        for (const SentSegment& segment : timed_out) {
+            rto_timers_.Schedule(conn_key, segment.seq_start, segment.deadline);
+        }
+        result.emplace_back(conn_key, std::move(timed_out));
     }
 
     return result;
 }
 
-bool TCPConnectionManager::HandleRTORetransmit(const std::string& conn_key, const SentSegment& segment,
+std::optional<std::chrono::steady_clock::time_point> TCPConnectionManager::NextTimeoutDeadline() const {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    return rto_timers_.NextDeadline();
+}
+
+bool TCPConnectionManager::HandleRTORetransmit(const TCPConnectionKey& conn_key, const SentSegment& segment,
                                                 uint32_t& base_seq, size_t& segment_index) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
-    auto it = connections_.find(conn_key);
-    if (it == connections_.end()) {
+    TCPConnectionInfo* found = connections_.Find(conn_key);
+    if (!found) {
         return false;
     }
 
-    TCPConnectionInfo& conn = it->second;
+    TCPConnectionInfo& conn = *found;
     std::lock_guard<std::mutex> trans_lock(conn.transmissions_mutex);
 
     // Find which transmission contains this segment
@@ -1000,7 +1351,7 @@ bool TCPConnectionManager::HandleRTORetransmit(const std::string& conn_key, cons
         if (segment.seq_start >= trans_start && segment.seq_start < trans_end) {
             // Found the transmission - find segment index
             uint32_t current_seq = trans_start;
-            for (size_t i = 0; i < trans.queued_segments.size(); i++) {
+            for (size_t i = 0; i < trans.SegmentCount(); i++) {
                 uint32_t seg_start = current_seq;
                 uint32_t seg_end = current_seq + trans.segment_payload_sizes[i];
 
@@ -1009,13 +1360,21 @@ bool TCPConnectionManager::HandleRTORetransmit(const std::string& conn_key, cons
                     base_seq = seq;
                     segment_index = i;
 
-                    // Mark for retransmit
+                    // Mark for retransmit (after any already marked)
+                    if (trans.retransmit_segments.empty()) {
+                        trans.retransmit_segment_index = i;
+                    }
+                    if (std::find(trans.retransmit_segments.begin(), trans.retransmit_segments.end(), i) ==
+                        trans.retransmit_segments.end()) {
+                        trans.retransmit_segments.push_back(i);
+                    }
                     trans.state = TransmissionState::NEEDS_RETRANSMIT;
-                    trans.retransmit_segment_index = i;
+                    conn.rto_retransmits++;
+                    rto_retransmits_.fetch_add(1, std::memory_order_relaxed);
 
-                    Log("RTO retransmit: conn=" + conn_key +
+                    Log("RTO retransmit: conn=" + conn_key.ToString() +
                         " segment " + std::to_string(i) + "/" +
-                        std::to_string(trans.queued_segments.size()));
+                        std::to_string(trans.SegmentCount()));
 
                     return true;
                 }
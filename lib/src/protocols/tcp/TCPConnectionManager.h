@@ -1,10 +1,15 @@
 #pragma once
 
 #include "TCPState.h"
+#include "TCPConnectionKey.h"
 #include "TCPStreamReassembler.h"
 #include "TCPFlowController.h"
 #include "RTOManager.h"
+#include "RTOTimerWheel.h"
+#include "ResponseSequencer.h"
+#include "../ppp/PPPParser.h"  // TCPParser::Options
 #include <mtp/ByteArray.h>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <map>
@@ -22,8 +27,11 @@ struct SentSegment {
     uint32_t seq_start;     // Starting sequence number
     uint32_t seq_end;       // Ending sequence number (exclusive)
     std::chrono::steady_clock::time_point send_time;  // When segment was sent
+    std::chrono::steady_clock::time_point deadline;   // send_time + RTO; its timer fires then
     bool is_retransmit;     // True if this is a retransmission
-    mtp::ByteArray data;    // Segment data for retransmission
+    bool sacked = false;    // Held by the receiver per a SACK block; never resent
+    bool recovery_resent = false;  // Resent by the current loss recovery
+    // The frame itself is rebuilt, or kept, by its HTTPTransmission
 };
 
 /**
@@ -32,8 +40,8 @@ struct SentSegment {
  * State transitions:
  *   PENDING → IN_PROGRESS (first segment sent)
  *   IN_PROGRESS → AWAITING_ACKS (all segments sent)
- *   IN_PROGRESS → NEEDS_RETRANSMIT (3 duplicate ACKs)
- *   AWAITING_ACKS → NEEDS_RETRANSMIT (3 duplicate ACKs)
+ *   IN_PROGRESS → NEEDS_RETRANSMIT (3 duplicate ACKs, a partial ACK, or an RTO)
+ *   AWAITING_ACKS → NEEDS_RETRANSMIT (3 duplicate ACKs, a partial ACK, or an RTO)
  *   NEEDS_RETRANSMIT → IN_PROGRESS (retransmit sent)
  *   AWAITING_ACKS → COMPLETE (all ACKed)
  */
@@ -56,24 +64,43 @@ inline std::string TransmissionStateToString(TransmissionState state) {
     }
 }
 
+/**
+ * Builds the PPP frame of segment index of a transmission into frame. It
+ * holds the response body it frames from; called with the connection's
+ * transmissions locked, whenever the segment is sent or resent.
+ */
+using SegmentFramer = std::function<void(size_t index, mtp::ByteArray& frame)>;
+
 /**
  * HTTPTransmission - Tracks a single HTTP response transmission
  *
  * Each HTTP response is split into TCP segments and tracked separately.
  * Multiple transmissions can exist on the same connection (HTTP keep-alive).
+ *
+ * A response whose body is at hand is framed lazily: framer builds each
+ * segment as the window opens and again for a retransmit, so only the
+ * body and the frames in flight are held. A streamed body keeps its
+ * frames in queued_segments as they arrive.
  */
 struct HTTPTransmission {
     uint32_t base_seq = 0;                            // Starting SEQ for this response
-    std::vector<mtp::ByteArray> queued_segments;      // Pre-built PPP frames
+    SegmentFramer framer;                             // Builds frames on demand; empty for stored frames
+    std::vector<mtp::ByteArray> queued_segments;      // Stored PPP frames; empty with a framer
     std::vector<size_t> segment_payload_sizes;        // HTTP payload size per segment
+    size_t ready_segments = 0;                        // Frames available so far (streamed bodies fill in later)
     size_t next_segment_index = 0;                    // Next segment to send
     TransmissionState state = TransmissionState::PENDING;  // Explicit state machine
-    size_t retransmit_segment_index = 0;              // Which segment to retransmit
+    size_t retransmit_segment_index = 0;              // First segment to retransmit
+    std::vector<size_t> retransmit_segments;          // Every segment to retransmit, in order
     std::chrono::steady_clock::time_point last_ack_time;
 
     // State query helpers
     bool IsComplete() const { return state == TransmissionState::COMPLETE; }
     bool NeedsRetransmit() const { return state == TransmissionState::NEEDS_RETRANSMIT; }
+    size_t SegmentCount() const { return segment_payload_sizes.size(); }
+
+    /// Frame of a ready segment, built by framer or copied from queued_segments
+    mtp::ByteArray Frame(size_t index) const;
 };
 
 /**
@@ -95,6 +122,7 @@ struct TCPConnectionInfo {
 
     // ==== Flow control (RFC 5681) - SINGLE SOURCE OF TRUTH ====
     std::unique_ptr<TCPFlowController> flow_controller;
+    CongestionControlKind congestion_control = CongestionControlKind::RENO;  // Strategy for flow_controller
 
     // ==== HTTP stream reassembler ====
     std::unique_ptr<TCPStreamReassembler> reassembler;
@@ -103,10 +131,19 @@ struct TCPConnectionInfo {
     RTOManager rto_manager;
     std::map<uint32_t, SentSegment> unacked_segments;  // Key: seq_start
 
+    // ==== Loss recovery (SACK, RFC 2018 / 6675; NewReno, RFC 6582) ====
+    bool sack_permitted = false;   // The device offered SACK in its SYN and we echoed it
+    uint32_t recovery_point = 0;   // End of the data in flight when recovery began; 0 outside recovery
+
+    // ==== Retransmit counts, for the network stats ====
+    uint32_t fast_retransmits = 0;  // Triggered by 3 duplicate ACKs
+    uint32_t rto_retransmits = 0;   // Triggered by an RTO
+
     // ==== HTTP transmission tracking ====
     // Maps base_seq to transmission state (supports multiple HTTP responses on same connection)
     std::map<uint32_t, HTTPTransmission> active_transmissions;
     std::mutex transmissions_mutex;
+    ResponseSequencer response_order;  // Commits pipelined responses in request order
 
     // ==== Receiver window ====
     uint16_t receiver_window = 65535;  // Advertised window from remote
@@ -120,24 +157,57 @@ struct TCPConnectionInfo {
     bool CanTransitionTo(TCPState new_state) const;
 
     // ==== RTO methods ====
-    void RecordSentSegment(uint32_t seq_start, const mtp::ByteArray& data, bool is_retransmit = false);
+    /**
+     * Track a sent segment until ACKed
+     * @return Its RTO deadline, for the connection manager's timer wheel
+     */
+    std::chrono::steady_clock::time_point RecordSentSegment(uint32_t seq_start, size_t payload_size,
+                                                            bool is_retransmit = false);
     void ProcessACKForRTO(uint32_t ack_num);
-    std::vector<SentSegment> CheckTimeouts();
+
+    /**
+     * Mark the segments wholly inside SACK blocks above ack_num as held
+     */
+    void ApplySACKBlocks(uint32_t ack_num, const TCPParser::Options& options);
+
+    /**
+     * Mark the segments loss recovery should resend (see ProcessACK)
+     * @return Segments newly marked
+     */
+    size_t MarkLostSegments(uint32_t ack_num);
+
+    /**
+     * Segments among due whose RTO has expired (not ACKed or resent since
+     * the timer was set). Backs the RTO off once and restarts their timers
+     * with it (RFC 6298 5.5-5.6); the returned copies carry the new deadlines.
+     */
+    std::vector<SentSegment> CheckTimeouts(const std::vector<RTOTimer>& due,
+                                           std::chrono::steady_clock::time_point now);
 
     // ==== Flow control methods ====
 
     /**
-     * Initialize flow controller for this connection
+     * Initialize flow controller for this connection, running the
+     * congestion_control strategy from the current receiver_window
      */
     void InitializeFlowControl();
 
     /**
      * Process an ACK packet - updates flow control, detects duplicates, triggers retransmit
+     *
+     * Loss recovery starts on the third duplicate ACK and lasts until the
+     * data in flight at that point is ACKed. It marks for retransmit the
+     * segment at the ACK and, once SACK blocks arrived, every segment below
+     * the highest SACKed byte the receiver does not hold. Without SACK a
+     * partial ACK during recovery marks the next segment (NewReno).
+     *
      * @param ack_num ACK number from packet
      * @param window_size Receiver's advertised window
+     * @param options The ACK's SACK blocks; ignored unless sack_permitted
      * @return true if new data was ACKed
      */
-    bool ProcessACK(uint32_t ack_num, uint16_t window_size);
+    bool ProcessACK(uint32_t ack_num, uint16_t window_size,
+                    const TCPParser::Options& options = TCPParser::Options());
 
     /**
      * Record bytes sent for flow control tracking
@@ -173,13 +243,23 @@ struct TCPConnectionInfo {
     /**
      * Start a new HTTP response transmission
      * @param base_seq Starting sequence number
-     * @param segments Pre-built PPP frames
-     * @param payload_sizes HTTP payload size per segment
+     * @param segments Pre-built PPP frames; may be fewer than payload_sizes
+     *                 when the rest of the body is still arriving
+     * @param payload_sizes HTTP payload size per segment, for the whole response
      */
     void StartTransmission(uint32_t base_seq,
                           std::vector<mtp::ByteArray> segments,
                           std::vector<size_t> payload_sizes);
 
+    /**
+     * Start a new HTTP response transmission framed on demand
+     * @param base_seq Starting sequence number
+     * @param framer Builds each segment's PPP frame when it is (re)sent
+     * @param payload_sizes HTTP payload size per segment
+     */
+    void StartTransmission(uint32_t base_seq, SegmentFramer framer,
+                          std::vector<size_t> payload_sizes);
+
     /**
      * Get the transmission that matches an ACK number
      * @param ack_num ACK number received
@@ -191,9 +271,11 @@ struct TCPConnectionInfo {
      * Calculate how many segments can be sent for a transmission
      * @param trans Transmission to check
      * @param max_batch Maximum segments per batch
+     * @param link_bytes_per_sec Measured USB link rate for pacing, 0 if unknown
      * @return Number of segments that can be sent now
      */
-    size_t CalculateSegmentsToSend(const HTTPTransmission& trans, size_t max_batch = 3) const;
+    size_t CalculateSegmentsToSend(const HTTPTransmission& trans, size_t max_batch = 3,
+                                   uint64_t link_bytes_per_sec = 0) const;
 
     /**
      * Mark segments as sent and update tracking
@@ -223,6 +305,25 @@ struct TCPConnectionInfo {
     size_t GetBytesInFlight() const;
 };
 
+/**
+ * TCPConnectionStats - Snapshot of one connection's congestion and RTO state
+ */
+struct TCPConnectionStats {
+    TCPConnectionKey conn_key;
+    TCPState state = TCPState::CLOSED;
+    size_t cwnd = 0;
+    size_t ssthresh = 0;
+    size_t bytes_in_flight = 0;
+    uint16_t receiver_window = 0;
+    std::optional<std::chrono::milliseconds> srtt;  // nullopt before the first RTT sample
+    std::chrono::milliseconds rto{0};
+    size_t unacked_segments = 0;
+    size_t active_transmissions = 0;
+    bool sack_permitted = false;
+    uint32_t fast_retransmits = 0;
+    uint32_t rto_retransmits = 0;
+};
+
 /**
  * TCPPacket
  *
@@ -237,6 +338,7 @@ struct TCPPacket {
     uint32_t ack_num;
     uint8_t flags;
     mtp::ByteArray payload;  // Optional payload (empty for handshake)
+    mtp::ByteArray options;  // TCP options, padded to 4 bytes (the SYN-ACK's SACK-permitted)
 };
 
 /**
@@ -269,7 +371,8 @@ public:
         uint32_t dst_ip, uint16_t dst_port,
         uint32_t seq_num, uint32_t ack_num,
         uint8_t flags, uint16_t window_size,
-        const mtp::ByteArray& payload);
+        const mtp::ByteArray& payload,
+        const TCPParser::Options& options = TCPParser::Options());
 
     /**
      * Process an ACK for flow control (called by interceptor)
@@ -278,43 +381,74 @@ public:
      * @param conn_key Connection key
      * @param ack_num ACK number
      * @param window_size Receiver's advertised window
-     * @return Transmission base_seq that needs SendNextBatch, or 0 if none
+     * @param options The ACK's options, for its SACK blocks
+     * @return Transmission base_seq that needs SendNextBatch, or 0 if none;
+     *         retransmits it marked are taken with TakeRetransmitFrames
      */
-    uint32_t ProcessACKForTransmission(const std::string& conn_key,
-                                        uint32_t ack_num, uint16_t window_size);
+    uint32_t ProcessACKForTransmission(const TCPConnectionKey& conn_key,
+                                        uint32_t ack_num, uint16_t window_size,
+                                        const TCPParser::Options& options = TCPParser::Options());
 
     /**
      * Start HTTP response transmission
      * @param conn_key Connection key
      * @param base_seq Starting sequence number
-     * @param segments Pre-built PPP frames
-     * @param payload_sizes HTTP payload size per segment
+     * @param segments Pre-built PPP frames; a streamed response passes the
+     *                 ones built so far and adds the rest with AddHTTPSegments
+     * @param payload_sizes HTTP payload size per segment, for the whole response
      */
-    void StartHTTPTransmission(const std::string& conn_key,
+    void StartHTTPTransmission(const TCPConnectionKey& conn_key,
                                uint32_t base_seq,
                                std::vector<mtp::ByteArray> segments,
                                std::vector<size_t> payload_sizes);
 
+    /**
+     * Start HTTP response transmission framed as the window opens: no
+     * frame is stored, retransmits are framed again from the body
+     * @param conn_key Connection key
+     * @param base_seq Starting sequence number
+     * @param framer Builds segment index's PPP frame
+     * @param payload_sizes HTTP payload size per segment, for the whole response
+     */
+    void StartHTTPTransmission(const TCPConnectionKey& conn_key,
+                               uint32_t base_seq,
+                               SegmentFramer framer,
+                               std::vector<size_t> payload_sizes);
+
+    /**
+     * Append the next built frames of a streamed response, in segment order
+     * @return false if the transmission is gone (connection reset or closed)
+     */
+    bool AddHTTPSegments(const TCPConnectionKey& conn_key, uint32_t base_seq,
+                         std::vector<mtp::ByteArray> segments);
+
+    /**
+     * Drop a connection whose response cannot be completed (a streamed
+     * body ended short); the caller sends the RST
+     */
+    void ResetConnection(const TCPConnectionKey& conn_key);
+
     /**
      * Get next batch of segments to send
      * @param conn_key Connection key
      * @param base_seq Transmission base sequence
      * @param[out] segments_out Vector to fill with segments to send
      * @param[out] is_last_batch Set to true if this is the final batch
-     * @return Number of segments to send (0 if window full or complete)
+     * @return Number of segments to send (0 if window full, complete, or
+     *         the next segment of a streamed body has not arrived yet)
      */
-    size_t GetNextBatch(const std::string& conn_key, uint32_t base_seq,
+    size_t GetNextBatch(const TCPConnectionKey& conn_key, uint32_t base_seq,
                         std::vector<mtp::ByteArray>& segments_out,
                         bool& is_last_batch);
 
     /**
-     * Check if fast retransmit is needed for a connection
+     * Check if a retransmit (fast, or after an RTO) is needed for a connection
      * @param conn_key Connection key
      * @param[out] base_seq Transmission that needs retransmit
      * @param[out] segment_index Segment to retransmit
      * @return true if retransmit needed
      */
-    bool CheckRetransmitNeeded(const std::string& conn_key,
+    bool CheckRetransmitNeeded(const TCPConnectionKey& conn_key,
                                 uint32_t& base_seq, size_t& segment_index);
 
     /**
@@ -324,33 +458,42 @@ public:
      * @param segment_index Segment index
      * @return PPP frame to retransmit, or empty if not found
      */
-    mtp::ByteArray GetRetransmitSegment(const std::string& conn_key,
+    mtp::ByteArray GetRetransmitSegment(const TCPConnectionKey& conn_key,
                                          uint32_t base_seq, size_t segment_index);
 
     /**
      * Clear retransmit flag after handling
      * @param conn_key Connection key
      */
-    void ClearRetransmitFlag(const std::string& conn_key);
+    void ClearRetransmitFlag(const TCPConnectionKey& conn_key);
+
+    /**
+     * Take every frame marked for retransmit on a connection (loss recovery
+     * or an RTO), in sequence order per transmission, and clear the marks
+     * @param conn_key Connection key
+     * @param[out] frames_out PPP frames to resend
+     * @return Number of frames
+     */
+    size_t TakeRetransmitFrames(const TCPConnectionKey& conn_key, std::vector<mtp::ByteArray>& frames_out);
 
     /**
      * Get connection information
      * @param conn_key Connection key
      * @return Connection info, or nullptr if not found
      */
-    TCPConnectionInfo* GetConnection(const std::string& conn_key);
+    TCPConnectionInfo* GetConnection(const TCPConnectionKey& conn_key);
 
     /**
      * Get or create connection
      * @param conn_key Connection key
      * @return Reference to connection info
      */
-    TCPConnectionInfo& GetOrCreateConnection(const std::string& conn_key);
+    TCPConnectionInfo& GetOrCreateConnection(const TCPConnectionKey& conn_key);
 
     /**
-     * Make connection key from TCP 4-tuple
+     * Make connection key from TCP 4-tuple (device side as src)
      */
-    static std::string MakeConnectionKey(uint32_t src_ip, uint16_t src_port,
+    static TCPConnectionKey MakeConnectionKey(uint32_t src_ip, uint16_t src_port,
                                          uint32_t dst_ip, uint16_t dst_port);
 
     /**
@@ -370,17 +513,68 @@ public:
 
     void SetLogCallback(LogCallback callback);
 
+    /**
+     * Congestion control for connections opened from now on (RENO by default)
+     */
+    void SetCongestionControl(CongestionControlKind kind);
+    CongestionControlKind GetCongestionControl() const { return congestion_control_.load(std::memory_order_relaxed); }
+
+    /**
+     * Record a completed 0x922c transfer. The byte-weighted rate over recent
+     * transfers paces strategies that use it (see CongestionControl::PacingBudget).
+     * @param bytes Transfer size
+     * @param elapsed Time the operation took
+     */
+    void RecordLinkTransfer(size_t bytes, std::chrono::microseconds elapsed);
+
+    /**
+     * Measured USB link rate in bytes per second, 0 before any transfer
+     */
+    uint64_t GetLinkRate() const { return link_rate_.load(std::memory_order_relaxed); }
+
+    /**
+     * Start from a rate measured in an earlier session (see PPPLinkProfile).
+     * It weighs as one 1 ms transfer, so real transfers soon outweigh it.
+     */
+    void SeedLinkRate(uint64_t bytes_per_sec);
+
+    /**
+     * Size the connection table for count concurrent connections
+     */
+    void ReserveConnections(size_t count);
+
+    /**
+     * Most connections open at once since construction
+     */
+    size_t GetPeakConnections() const;
+
     /**
      * Get all active connection keys
      * @return Vector of connection keys with active transmissions
      */
-    std::vector<std::string> GetActiveConnectionKeys();
+    std::vector<TCPConnectionKey> GetActiveConnectionKeys();
+
+    /**
+     * Expire the RTO timers due by now
+     * @return (conn_key, timed-out segments) for each connection with any
+     */
+    std::vector<std::pair<TCPConnectionKey, std::vector<SentSegment>>> CheckAllTimeouts(
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
 
     /**
-     * Check all connections for RTO timeouts
-     * @return Map of conn_key -> vector of timed-out segments
+     * When CheckAllTimeouts next has work, or nullopt while no segment is
+     * in flight; the poller sleeps until then
      */
-    std::map<std::string, std::vector<SentSegment>> CheckAllTimeouts();
+    std::optional<std::chrono::steady_clock::time_point> NextTimeoutDeadline() const;
+
+    /**
+     * Congestion window, RTT and RTO of every connection
+     */
+    std::vector<TCPConnectionStats> GetConnectionStats();
+
+    // Retransmits since construction, including connections since closed
+    uint64_t GetFastRetransmitCount() const { return fast_retransmits_.load(std::memory_order_relaxed); }
+    uint64_t GetRTORetransmitCount() const { return rto_retransmits_.load(std::memory_order_relaxed); }
 
     /**
      * Handle RTO retransmission for a connection
@@ -390,34 +584,44 @@ public:
      * @param[out] segment_index Index of segment to retransmit
      * @return true if retransmit can be performed
      */
-    bool HandleRTORetransmit(const std::string& conn_key, const SentSegment& segment,
+    bool HandleRTORetransmit(const TCPConnectionKey& conn_key, const SentSegment& segment,
                              uint32_t& base_seq, size_t& segment_index);
 
 private:
     std::optional<TCPPacket> HandleSYN(
-        const std::string& conn_key,
+        const TCPConnectionKey& conn_key,
         uint32_t src_ip, uint16_t src_port,
         uint32_t dst_ip, uint16_t dst_port,
-        uint32_t seq_num, uint16_t window_size);
+        uint32_t seq_num, uint16_t window_size, bool sack_permitted);
 
     std::optional<TCPPacket> HandleACK(
-        const std::string& conn_key,
+        const TCPConnectionKey& conn_key,
         uint32_t src_ip, uint16_t src_port,
         uint32_t dst_ip, uint16_t dst_port,
         uint32_t seq_num, uint32_t ack_num,
         const mtp::ByteArray& payload);
 
     std::optional<TCPPacket> HandleFIN(
-        const std::string& conn_key,
+        const TCPConnectionKey& conn_key,
         uint32_t src_ip, uint16_t src_port,
         uint32_t dst_ip, uint16_t dst_port,
         uint32_t seq_num);
 
-    std::optional<TCPPacket> HandleRST(const std::string& conn_key);
+    std::optional<TCPPacket> HandleRST(const TCPConnectionKey& conn_key);
 
     void Log(const std::string& message);
 
-    std::map<std::string, TCPConnectionInfo> connections_;
+    TCPConnectionTable<TCPConnectionInfo> connections_;
+    RTOTimerWheel rto_timers_;  // One timer per sent segment, guarded by connections_mutex_
     mutable std::mutex connections_mutex_;
     LogCallback log_callback_;
+    std::atomic<uint64_t> fast_retransmits_{0};
+    std::atomic<uint64_t> rto_retransmits_{0};
+    std::atomic<CongestionControlKind> congestion_control_{CongestionControlKind::RENO};
+
+    // Link rate: transfer bytes and microseconds, each decayed by 1/8 per transfer
+    std::mutex link_mutex_;
+    double link_bytes_ = 0;
+    double link_us_ = 0;
+    std::atomic<uint64_t> link_rate_{0};
 };
@@ -1,11 +1,108 @@
 #include "TCPFlowController.h"
 #include <algorithm>
+#include <cstdint>
+
+// ============================================================================
+// CongestionControl
+// ============================================================================
+
+void CongestionControl::OnRecoveryExit(Window& window, size_t bytes_in_flight) {
+    // RFC 5681: Deflate cwnd to ssthresh when exiting fast recovery
+    size_t min_cwnd = std::max(window.ssthresh, bytes_in_flight);
+    if (window.cwnd > min_cwnd) {
+        window.cwnd = min_cwnd;
+    }
+}
+
+size_t CongestionControl::PacingBudget(uint64_t) const {
+    return SIZE_MAX;
+}
+
+RenoCongestionControl::RenoCongestionControl(size_t initial_cwnd, size_t initial_ssthresh)
+    : initial_cwnd_(initial_cwnd),
+      initial_ssthresh_(initial_ssthresh) {
+}
+
+void RenoCongestionControl::OnNewAck(Window& window, size_t bytes_acked) {
+    if (window.cwnd < window.ssthresh) {
+        // RFC 3465: Slow start increases cwnd by min(bytes_acked, 2*MSS)
+        window.cwnd += std::min(bytes_acked, 2 * TCPFlowController::MSS);
+        return;
+    }
+
+    // RFC 3465: Appropriate Byte Counting (ABC)
+    // Accumulate bytes, grow by 1 MSS per cwnd bytes ACKed
+    bytes_acked_accumulator_ += bytes_acked;
+    if (bytes_acked_accumulator_ >= window.cwnd) {
+        bytes_acked_accumulator_ -= window.cwnd;
+        window.cwnd += TCPFlowController::MSS;
+    }
+}
+
+void RenoCongestionControl::OnFastRetransmit(Window& window, size_t bytes_in_flight) {
+    // RFC 5681: Set ssthresh = max(FlightSize/2, 2*MSS)
+    window.ssthresh = std::max(bytes_in_flight / 2, 2 * TCPFlowController::MSS);
+
+    // Inflate cwnd (accounts for 3 buffered segments at receiver)
+    window.cwnd = window.ssthresh + 3 * TCPFlowController::MSS;
+}
+
+void RenoCongestionControl::OnRecoveryDuplicateAck(Window& window) {
+    // RFC 5681: Additional duplicate ACKs inflate cwnd during fast recovery
+    window.cwnd += TCPFlowController::MSS;
+}
+
+UsbLinkCongestionControl::UsbLinkCongestionControl(size_t receiver_window)
+    : ceiling_(std::max(receiver_window, 2 * TCPFlowController::MSS)) {
+}
+
+void UsbLinkCongestionControl::OnNewAck(Window& window, size_t bytes_acked) {
+    if (window.cwnd < window.ssthresh) {
+        // No burst losses on the link: refill by everything ACKed
+        window.cwnd = std::min(window.cwnd + bytes_acked, window.ssthresh);
+        return;
+    }
+
+    // After a loss, creep back towards the receiver window one MSS per window
+    bytes_acked_accumulator_ += bytes_acked;
+    if (bytes_acked_accumulator_ >= window.cwnd) {
+        bytes_acked_accumulator_ -= window.cwnd;
+        window.cwnd = std::min(window.cwnd + TCPFlowController::MSS, ceiling_);
+    }
+}
+
+void UsbLinkCongestionControl::OnFastRetransmit(Window& window, size_t bytes_in_flight) {
+    // The device dropped a segment it had no room for: halve, and send
+    // nothing new until the retransmit is ACKed
+    window.ssthresh = std::max(bytes_in_flight / 2, 2 * TCPFlowController::MSS);
+    window.cwnd = window.ssthresh;
+}
+
+void UsbLinkCongestionControl::OnRecoveryDuplicateAck(Window&) {
+    // Each further duplicate ACK is the same loss reported again, not a
+    // segment leaving the device's buffer
+}
+
+size_t UsbLinkCongestionControl::PacingBudget(uint64_t link_bytes_per_sec) const {
+    if (link_bytes_per_sec == 0) {
+        return SIZE_MAX;  // No transfer measured yet
+    }
+    uint64_t budget = link_bytes_per_sec * kPacingInterval.count() / 1000000;
+    return std::max(static_cast<size_t>(budget), 2 * TCPFlowController::MSS);
+}
+
+// ============================================================================
+// TCPFlowController
+// ============================================================================
 
 TCPFlowController::TCPFlowController(size_t initial_cwnd, size_t initial_ssthresh)
+    : TCPFlowController(std::make_unique<RenoCongestionControl>(initial_cwnd, initial_ssthresh)) {
+}
+
+TCPFlowController::TCPFlowController(std::unique_ptr<CongestionControl> congestion_control)
     : state_(FlowControlState::INITIAL),
-      cwnd_(initial_cwnd),
-      ssthresh_(initial_ssthresh),
-      bytes_acked_accumulator_(0),
+      congestion_control_(std::move(congestion_control)),
+      window_(congestion_control_->InitialWindow()),
       bytes_in_flight_(0),
       last_acked_seq_(0),
       duplicate_ack_count_(0),
@@ -50,9 +147,9 @@ bool TCPFlowController::ProcessACK(uint32_t ack_num, uint16_t window_size) {
             return false;  // No new data ACKed
         }
 
-        // RFC 5681: Additional duplicate ACKs inflate cwnd during fast recovery
+        // Additional duplicate ACKs during fast recovery (Reno inflates cwnd)
         if (duplicate_ack_count_ > 3 && IsInFastRecovery()) {
-            cwnd_ += MSS;
+            congestion_control_->OnRecoveryDuplicateAck(window_);
         }
 
         return false;  // No new data ACKed
@@ -87,11 +184,7 @@ bool TCPFlowController::ProcessACK(uint32_t ack_num, uint16_t window_size) {
 
             // Grow cwnd if not in fast recovery
             if (!IsInFastRecovery()) {
-                if (state_ == FlowControlState::SLOW_START || cwnd_ < ssthresh_) {
-                    GrowSlowStart(bytes_acked);
-                } else {
-                    GrowCongestionAvoidance(bytes_acked);
-                }
+                GrowWindow(bytes_acked);
             }
         }
 
@@ -150,6 +243,10 @@ bool TCPFlowController::IsComplete() const {
     return state_ == FlowControlState::COMPLETE;
 }
 
+size_t TCPFlowController::GetPacingBudget(uint64_t link_bytes_per_sec) const {
+    return congestion_control_->PacingBudget(link_bytes_per_sec);
+}
+
 void TCPFlowController::EnterSlowStart() {
     state_ = FlowControlState::SLOW_START;
 }
@@ -161,46 +258,21 @@ void TCPFlowController::EnterCongestionAvoidance() {
 void TCPFlowController::EnterFastRecovery() {
     // Enter pending state - retransmit needed before transitioning to active recovery
     state_ = FlowControlState::FAST_RECOVERY_PENDING;
-
-    // RFC 5681: Set ssthresh = max(FlightSize/2, 2*MSS)
-    ssthresh_ = std::max(bytes_in_flight_ / 2, 2 * MSS);
-
-    // Inflate cwnd (accounts for 3 buffered segments at receiver)
-    cwnd_ = ssthresh_ + 3 * MSS;
+    congestion_control_->OnFastRetransmit(window_, bytes_in_flight_);
 }
 
 void TCPFlowController::ExitFastRecovery() {
-    // RFC 5681: Deflate cwnd to ssthresh when exiting fast recovery
-    // BUT: Don't set cwnd below bytes_in_flight - this would create a deadlock
-    // where we can't send anything until the pipe drains (which may never happen
-    // if the receiver is waiting for more data).
-    size_t min_cwnd = std::max(ssthresh_, bytes_in_flight_);
-    if (cwnd_ > min_cwnd) {
-        cwnd_ = min_cwnd;
-    }
+    congestion_control_->OnRecoveryExit(window_, bytes_in_flight_);
 
     // Transition to congestion avoidance
     EnterCongestionAvoidance();
 }
 
-void TCPFlowController::GrowSlowStart(size_t bytes_acked) {
-    // RFC 3465: Slow start increases cwnd by min(bytes_acked, 2*MSS)
-    size_t increase = std::min(bytes_acked, 2 * MSS);
-    cwnd_ += increase;
+void TCPFlowController::GrowWindow(size_t bytes_acked) {
+    congestion_control_->OnNewAck(window_, bytes_acked);
 
     // Transition to congestion avoidance when cwnd >= ssthresh
-    if (cwnd_ >= ssthresh_) {
+    if (state_ == FlowControlState::SLOW_START && window_.cwnd >= window_.ssthresh) {
         EnterCongestionAvoidance();
     }
 }
-
-void TCPFlowController::GrowCongestionAvoidance(size_t bytes_acked) {
-    // RFC 3465: Appropriate Byte Counting (ABC)
-    // Accumulate bytes, grow by 1 MSS per cwnd bytes ACKed
-    bytes_acked_accumulator_ += bytes_acked;
-
-    if (bytes_acked_accumulator_ >= cwnd_) {
-        bytes_acked_accumulator_ -= cwnd_;
-        cwnd_ += MSS;
-    }
-}
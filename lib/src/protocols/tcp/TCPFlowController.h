@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -50,17 +52,140 @@ inline std::string FlowControlStateToString(FlowControlState state) {
     }
 }
 
+/**
+ * CongestionControlKind
+ *
+ * The congestion control strategies a connection can run (see CongestionControl).
+ */
+enum class CongestionControlKind : uint8_t {
+    USB_LINK = 0,   // Full receiver window from the start, paced by the USB link
+    RENO = 1,       // RFC 5681 slow start and congestion avoidance
+};
+
+/**
+ * CongestionControl
+ *
+ * Strategy deciding the congestion window of a TCPFlowController.
+ *
+ * The flow controller classifies ACKs, tracks bytes in flight and drives the
+ * FlowControlState machine; the strategy picks the starting window, how it
+ * grows on new ACKs, what duplicate ACKs do to it, and how many bytes one
+ * batch may release.
+ */
+class CongestionControl {
+public:
+    struct Window {
+        size_t cwnd;        // Congestion window (bytes)
+        size_t ssthresh;    // Slow start threshold (bytes)
+    };
+
+    virtual ~CongestionControl() = default;
+
+    virtual CongestionControlKind Kind() const = 0;
+
+    /**
+     * Window before the first ACK
+     */
+    virtual Window InitialWindow() const = 0;
+
+    /**
+     * New data ACKed outside fast recovery
+     * @param bytes_acked Number of bytes ACKed
+     */
+    virtual void OnNewAck(Window& window, size_t bytes_acked) = 0;
+
+    /**
+     * The duplicate ACK that triggers fast retransmit
+     * @param bytes_in_flight Bytes sent but not ACKed
+     */
+    virtual void OnFastRetransmit(Window& window, size_t bytes_in_flight) = 0;
+
+    /**
+     * Each further duplicate ACK during fast recovery
+     */
+    virtual void OnRecoveryDuplicateAck(Window& window) = 0;
+
+    /**
+     * First new ACK after fast retransmit. Deflates cwnd to ssthresh, but
+     * never below bytes_in_flight: that would stall sending until the pipe
+     * drains, which may never happen if the receiver waits for more data.
+     */
+    virtual void OnRecoveryExit(Window& window, size_t bytes_in_flight);
+
+    /**
+     * Most payload bytes one batch may release
+     * @param link_bytes_per_sec Measured USB link rate, 0 before any transfer
+     * @return Byte budget, SIZE_MAX for none (the window alone limits)
+     */
+    virtual size_t PacingBudget(uint64_t link_bytes_per_sec) const;
+};
+
+/**
+ * RenoCongestionControl
+ *
+ * RFC 5681 with ABC (RFC 3465): slow start by min(bytes_acked, 2*MSS),
+ * congestion avoidance by one MSS per cwnd bytes ACKed, ssthresh halved and
+ * cwnd inflated by one MSS per duplicate ACK in fast recovery. Unpaced.
+ */
+class RenoCongestionControl : public CongestionControl {
+public:
+    RenoCongestionControl(size_t initial_cwnd, size_t initial_ssthresh);
+
+    CongestionControlKind Kind() const override { return CongestionControlKind::RENO; }
+    Window InitialWindow() const override { return {initial_cwnd_, initial_ssthresh_}; }
+    void OnNewAck(Window& window, size_t bytes_acked) override;
+    void OnFastRetransmit(Window& window, size_t bytes_in_flight) override;
+    void OnRecoveryDuplicateAck(Window& window) override;
+
+private:
+    size_t initial_cwnd_;
+    size_t initial_ssthresh_;
+    size_t bytes_acked_accumulator_ = 0;  // For ABC (congestion avoidance)
+};
+
+/**
+ * UsbLinkCongestionControl
+ *
+ * For the USB pipe to the device, which neither reorders nor loses segments
+ * to congestion; the receiver window is the only real limit.
+ *
+ * - Starts at the full receiver window, so a response skips slow start
+ * - Paces each batch to what the link completes in kPacingInterval, from
+ *   the measured 0x922c rate, so a full window is not queued at once
+ * - A lost segment means the device ran short of buffer: fast retransmit
+ *   halves the window without the 3*MSS inflation, duplicate ACKs during
+ *   recovery do not inflate it, and it grows back linearly to the ceiling
+ */
+class UsbLinkCongestionControl : public CongestionControl {
+public:
+    static constexpr std::chrono::microseconds kPacingInterval{4000};
+
+    /**
+     * @param receiver_window Window the device advertised; cwnd never grows past it
+     */
+    explicit UsbLinkCongestionControl(size_t receiver_window);
+
+    CongestionControlKind Kind() const override { return CongestionControlKind::USB_LINK; }
+    Window InitialWindow() const override { return {ceiling_, ceiling_}; }
+    void OnNewAck(Window& window, size_t bytes_acked) override;
+    void OnFastRetransmit(Window& window, size_t bytes_in_flight) override;
+    void OnRecoveryDuplicateAck(Window& window) override;
+    size_t PacingBudget(uint64_t link_bytes_per_sec) const override;
+
+private:
+    size_t ceiling_;
+    size_t bytes_acked_accumulator_ = 0;
+};
+
 /**
  * TCPFlowController
  *
  * Manages TCP congestion control following RFC 5681.
  *
  * Implements:
- * - Slow start (exponential cwnd growth)
- * - Congestion avoidance (linear cwnd growth)
- * - Fast retransmit (3 duplicate ACKs)
- * - Fast recovery (cwnd inflation)
- * - ABC (Appropriate Byte Counting, RFC 3465)
+ * - Duplicate ACK detection and fast retransmit (3 duplicate ACKs)
+ * - Bytes in flight and the FlowControlState machine
+ * - Window changes through a CongestionControl strategy (Reno by default)
  *
  * This class is NOT thread-safe. Caller must provide synchronization.
  */
@@ -75,6 +200,12 @@ public:
      */
     TCPFlowController(size_t initial_cwnd = 3 * MSS, size_t initial_ssthresh = 65535);
 
+    /**
+     * Constructor with a congestion control strategy
+     * @param congestion_control Strategy deciding the window
+     */
+    explicit TCPFlowController(std::unique_ptr<CongestionControl> congestion_control);
+
     /**
      * Process ACK packet
      *
@@ -132,6 +263,12 @@ public:
      */
     void SetComplete();
 
+    /**
+     * Most payload bytes the next batch may release (see CongestionControl::PacingBudget)
+     * @param link_bytes_per_sec Measured USB link rate, 0 if unknown
+     */
+    size_t GetPacingBudget(uint64_t link_bytes_per_sec) const;
+
     /**
      * Check if transmission is complete
      * @return true if all data sent and ACKed
@@ -140,8 +277,9 @@ public:
 
     // State queries
     FlowControlState GetState() const { return state_; }
-    size_t GetCongestionWindow() const { return cwnd_; }
-    size_t GetSlowStartThreshold() const { return ssthresh_; }
+    CongestionControlKind GetCongestionControlKind() const { return congestion_control_->Kind(); }
+    size_t GetCongestionWindow() const { return window_.cwnd; }
+    size_t GetSlowStartThreshold() const { return window_.ssthresh; }
     size_t GetBytesInFlight() const { return bytes_in_flight_; }
     uint32_t GetLastAckedSeq() const { return last_acked_seq_; }
     uint32_t GetDuplicateAckCount() const { return duplicate_ack_count_; }
@@ -172,24 +310,17 @@ private:
     void ExitFastRecovery();
 
     /**
-     * Grow cwnd during slow start
-     * @param bytes_acked Number of bytes ACKed
-     */
-    void GrowSlowStart(size_t bytes_acked);
-
-    /**
-     * Grow cwnd during congestion avoidance (ABC algorithm)
+     * Grow cwnd on new data ACKed, leaving slow start once cwnd >= ssthresh
      * @param bytes_acked Number of bytes ACKed
      */
-    void GrowCongestionAvoidance(size_t bytes_acked);
+    void GrowWindow(size_t bytes_acked);
 
     // State
     FlowControlState state_;
 
     // Congestion control
-    size_t cwnd_;                       // Congestion window (bytes)
-    size_t ssthresh_;                   // Slow start threshold (bytes)
-    size_t bytes_acked_accumulator_;    // For ABC algorithm (congestion avoidance)
+    std::unique_ptr<CongestionControl> congestion_control_;
+    CongestionControl::Window window_;
 
     // Flow control
     size_t bytes_in_flight_;            // Bytes sent but not ACKed
@@ -1,61 +1,84 @@
 #include "TCPStreamReassembler.h"
+#include <algorithm>
+#include <cstring>
 #include <sstream>
-#include <iomanip>
 
 TCPStreamReassembler::TCPStreamReassembler(uint32_t initial_seq)
     : next_expected_seq_(initial_seq) {
 }
 
-bool TCPStreamReassembler::AddSegment(uint32_t seq, const mtp::ByteArray& data) {
-    if (data.empty()) {
+bool TCPStreamReassembler::AddSegment(uint32_t seq, const uint8_t* data, size_t size) {
+    if (size == 0) {
         return true;  // Empty segment is always "accepted" (no-op)
     }
 
-    uint32_t seg_end = seq + data.size();
+    uint32_t seg_end = seq + static_cast<uint32_t>(size);
 
     // Case 1: Segment starts BEFORE next_expected_seq (overlap or retransmit)
     if (IsSeqBefore(seq, next_expected_seq_)) {
         // Check if this is entirely before next_expected (true retransmit)
-        if (IsSeqBefore(seg_end, next_expected_seq_) || seg_end == next_expected_seq_) {
-            std::ostringstream oss;
-            oss << "TCP retransmit: SEQ=" << seq
-                << " end=" << seg_end
-                << " < expected=" << next_expected_seq_
-                << " (" << data.size() << " bytes, duplicate)";
-            Log(oss.str());
+        if (!IsSeqBefore(next_expected_seq_, seg_end)) {
+            if (log_callback_) {
+                std::ostringstream oss;
+                oss << "TCP retransmit: SEQ=" << seq
+                    << " end=" << seg_end
+                    << " < expected=" << next_expected_seq_
+                    << " (" << size << " bytes, duplicate)";
+                Log(oss.str());
+            }
             stats_.segments_rejected++;
             return false;  // Reject: duplicate data
         }
 
-        // Partial overlap: extract new data past next_expected_seq
+        // Partial overlap: keep only the new data past next_expected_seq
         uint32_t overlap_bytes = next_expected_seq_ - seq;
-        if (overlap_bytes >= data.size()) {
-            // Should not happen (already handled above), but be defensive
-            stats_.segments_rejected++;
-            return false;
+        if (log_callback_) {
+            std::ostringstream oss;
+            oss << "TCP partial retransmit: SEQ=" << seq
+                << " overlaps by " << overlap_bytes << " bytes, accepting " << (size - overlap_bytes) << " new bytes";
+            Log(oss.str());
         }
+        data += overlap_bytes;
+        size -= overlap_bytes;
+        seq = next_expected_seq_;
+    }
 
-        std::ostringstream oss;
-        oss << "TCP partial retransmit: SEQ=" << seq
-            << " overlaps by " << overlap_bytes << " bytes, accepting " << (data.size() - overlap_bytes) << " new bytes";
-        Log(oss.str());
-
-        // Create new segment with only the non-overlapping data
-        mtp::ByteArray new_data(data.begin() + overlap_bytes, data.end());
-        return AddSegment(next_expected_seq_, new_data);  // Recursively add non-overlapping part
+    // Anything past the receive window has nowhere to go
+    size_t offset = seq - next_expected_seq_;
+    size_t room = kCapacity - size_;
+    if (offset >= room) {
+        if (log_callback_) {
+            std::ostringstream oss;
+            oss << "TCP segment beyond receive window: SEQ=" << seq
+                << " is " << offset << " bytes past expected=" << next_expected_seq_
+                << " (" << room << " bytes free), rejecting";
+            Log(oss.str());
+        }
+        stats_.segments_rejected++;
+        return false;
     }
+    if (size > room - offset) {
+        if (log_callback_) {
+            Log("TCP segment truncated to receive window: dropping " +
+                std::to_string(size - (room - offset)) + " bytes");
+        }
+        size = room - offset;
+    }
+    seg_end = seq + static_cast<uint32_t>(size);
 
     // Case 2: Segment starts exactly at next_expected_seq (in-order)
-    if (seq == next_expected_seq_) {
-        // Append to contiguous buffer
-        contiguous_buffer_.insert(contiguous_buffer_.end(), data.begin(), data.end());
+    if (offset == 0) {
+        Write(size_, data, size);
+        size_ += size;
         next_expected_seq_ = seg_end;
         stats_.segments_accepted++;
 
-        std::ostringstream oss;
-        oss << "TCP in-order: SEQ=" << seq
-            << " (" << data.size() << " bytes), next_expected=" << next_expected_seq_;
-        Log(oss.str());
+        if (log_callback_) {
+            std::ostringstream oss;
+            oss << "TCP in-order: SEQ=" << seq
+                << " (" << size << " bytes), next_expected=" << next_expected_seq_;
+            Log(oss.str());
+        }
 
         // Try to flush any buffered out-of-order data
         TryFlushOutOfOrderData();
@@ -63,61 +86,97 @@ bool TCPStreamReassembler::AddSegment(uint32_t seq, const mtp::ByteArray& data)
     }
 
     // Case 3: Segment starts AFTER next_expected_seq (out-of-order, gap exists)
-    // Check if we already have this data buffered
-    for (const auto& [buffered_seq, buffered_data] : out_of_order_buffer_) {
-        uint32_t buffered_end = buffered_seq + buffered_data.size();
-
-        // Check if new segment overlaps with buffered segment
-        if (IsSeqInRange(seq, buffered_seq, buffered_end) ||
-            IsSeqInRange(buffered_seq, seq, seg_end)) {
-            // Overlap detected - for now, reject (could merge in future)
+    if (!AddInterval(seq, seg_end)) {
+        if (log_callback_) {
             std::ostringstream oss;
-            oss << "TCP out-of-order overlap: SEQ=" << seq
-                << " overlaps with buffered SEQ=" << buffered_seq
-                << ", rejecting";
+            oss << "TCP out-of-order duplicate: SEQ=" << seq
+                << " (" << size << " bytes) already buffered, rejecting";
             Log(oss.str());
-            stats_.segments_rejected++;
-            return false;
         }
+        stats_.segments_rejected++;
+        return false;
     }
-
-    // Buffer this out-of-order segment
-    out_of_order_buffer_[seq] = data;
+    Write(size_ + offset, data, size);
     stats_.segments_accepted++;
+    stats_.out_of_order_buffered = out_of_order_.size();
 
-    std::ostringstream oss;
-    oss << "TCP out-of-order: SEQ=" << seq
-        << " (" << data.size() << " bytes), gap of " << (seq - next_expected_seq_)
-        << " bytes, buffered (total buffered: " << out_of_order_buffer_.size() << ")";
-    Log(oss.str());
+    if (log_callback_) {
+        std::ostringstream oss;
+        oss << "TCP out-of-order: SEQ=" << seq
+            << " (" << size << " bytes), gap of " << offset
+            << " bytes, buffered (total buffered: " << out_of_order_.size() << ")";
+        Log(oss.str());
+    }
+    return true;
+}
+
+void TCPStreamReassembler::Write(size_t offset, const uint8_t* data, size_t size) {
+    if (!storage_) {
+        storage_.reset(new uint8_t[kCapacity * 2]);
+    }
+
+    // offset + size <= kCapacity, so this wraps at most once
+    size_t pos = (head_ + offset) & (kCapacity - 1);
+    size_t first = std::min(size, kCapacity - pos);
+    std::memcpy(storage_.get() + pos, data, first);
+    std::memcpy(storage_.get() + kCapacity + pos, data, first);
+    if (first < size) {
+        std::memcpy(storage_.get(), data + first, size - first);
+        std::memcpy(storage_.get() + kCapacity, data + first, size - first);
+    }
+}
+
+bool TCPStreamReassembler::AddInterval(uint32_t start, uint32_t end) {
+    // Ranges are ordered by distance from next_expected_seq_, which is
+    // well defined because they all lie inside the window
+    auto distance = [this](uint32_t seq) { return seq - next_expected_seq_; };
+
+    auto it = out_of_order_.begin();
+    while (it != out_of_order_.end() && distance(it->end) < distance(start)) {
+        ++it;
+    }
+    if (it != out_of_order_.end() &&
+        distance(it->start) <= distance(start) && distance(end) <= distance(it->end)) {
+        return false;  // Nothing new
+    }
 
-    stats_.out_of_order_buffered = out_of_order_buffer_.size();
+    // Absorb every range that overlaps or abuts [start, end)
+    auto last = it;
+    while (last != out_of_order_.end() && distance(last->start) <= distance(end)) {
+        if (distance(last->start) < distance(start)) start = last->start;
+        if (distance(last->end) > distance(end)) end = last->end;
+        ++last;
+    }
+    it = out_of_order_.erase(it, last);
+    out_of_order_.insert(it, Interval{start, end});
     return true;
 }
 
 void TCPStreamReassembler::TryFlushOutOfOrderData() {
-    // Repeatedly try to flush segments that now start at next_expected_seq
-    while (!out_of_order_buffer_.empty()) {
-        auto it = out_of_order_buffer_.find(next_expected_seq_);
-        if (it == out_of_order_buffer_.end()) {
-            break;  // No segment starts at next_expected_seq, gap still exists
+    // The bytes are already in place; closing a gap just extends the readable region
+    size_t flushed = 0;
+    while (flushed < out_of_order_.size() &&
+           !IsSeqBefore(next_expected_seq_, out_of_order_[flushed].start)) {
+        const Interval& range = out_of_order_[flushed++];
+        if (!IsSeqBefore(next_expected_seq_, range.end)) {
+            continue;  // Fully covered by the segment that just arrived
         }
 
-        // Found a buffered segment that fills the gap!
-        const mtp::ByteArray& data = it->second;
-        contiguous_buffer_.insert(contiguous_buffer_.end(), data.begin(), data.end());
-        next_expected_seq_ += data.size();
+        uint32_t added = range.end - next_expected_seq_;
+        size_ += added;
+        next_expected_seq_ = range.end;
         stats_.gaps_filled++;
 
-        std::ostringstream oss;
-        oss << "TCP gap filled: flushed " << data.size()
-            << " bytes from buffer, next_expected=" << next_expected_seq_;
-        Log(oss.str());
-
-        out_of_order_buffer_.erase(it);
+        if (log_callback_) {
+            std::ostringstream oss;
+            oss << "TCP gap filled: flushed " << added
+                << " bytes from buffer, next_expected=" << next_expected_seq_;
+            Log(oss.str());
+        }
     }
+    out_of_order_.erase(out_of_order_.begin(), out_of_order_.begin() + flushed);
 
-    stats_.out_of_order_buffered = out_of_order_buffer_.size();
+    stats_.out_of_order_buffered = out_of_order_.size();
 }
 
 bool TCPStreamReassembler::IsSeqBefore(uint32_t seq, uint32_t ref_seq) {
@@ -126,38 +185,20 @@ bool TCPStreamReassembler::IsSeqBefore(uint32_t seq, uint32_t ref_seq) {
     return static_cast<int32_t>(seq - ref_seq) < 0;
 }
 
-bool TCPStreamReassembler::IsSeqInRange(uint32_t seq, uint32_t start, uint32_t end) {
-    // Check if seq is in range [start, end) considering wraparound
-    // seq is in range if: start <= seq < end (with wraparound handling)
-    if (start <= end) {
-        // Normal case (no wraparound)
-        return seq >= start && seq < end;
-    } else {
-        // Wraparound case
-        return seq >= start || seq < end;
-    }
-}
-
 void TCPStreamReassembler::Reset(uint32_t new_initial_seq) {
     next_expected_seq_ = new_initial_seq;
-    contiguous_buffer_.clear();
-    out_of_order_buffer_.clear();
+    head_ = 0;
+    size_ = 0;
+    out_of_order_.clear();
     stats_ = Stats();
 }
 
-void TCPStreamReassembler::ClearContiguousBuffer() {
-    contiguous_buffer_.clear();
-    // Note: next_expected_seq stays the same - we're just clearing processed data
-    // Out-of-order buffer remains intact
-}
-
-void TCPStreamReassembler::EraseProcessedBytes(size_t num_bytes) {
-    if (num_bytes >= contiguous_buffer_.size()) {
-        contiguous_buffer_.clear();
-    } else {
-        contiguous_buffer_.erase(contiguous_buffer_.begin(),
-                                 contiguous_buffer_.begin() + num_bytes);
-    }
+void TCPStreamReassembler::Consume(size_t num_bytes) {
+    // next_expected_seq stays the same - only the read position moves;
+    // out-of-order data keeps its place in the ring
+    num_bytes = std::min(num_bytes, size_);
+    head_ = (head_ + num_bytes) & (kCapacity - 1);
+    size_ -= num_bytes;
 }
 
 void TCPStreamReassembler::Log(const std::string& message) {
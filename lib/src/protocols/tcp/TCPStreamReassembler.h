@@ -1,11 +1,12 @@
 #pragma once
 
 #include <mtp/ByteArray.h>
+#include <cstddef>
 #include <cstdint>
-#include <map>
-#include <optional>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 /**
  * TCPStreamReassembler
@@ -24,11 +25,47 @@
  *   Receive SEQ=1000, 10 bytes → Accept, fill gap, next_expected=1010
  *   Deliver buffered packet (SEQ=1010), next_expected=1020
  *   Receive SEQ=1000, 10 bytes → Reject (true retransmit)
+ *
+ * Storage is a fixed ring the size of the receive window we advertise
+ * (PPPFrameBuilder sends 65535). Every segment is copied once, straight to
+ * its offset from the unread head: in-order data extends the readable
+ * region, out-of-order data lands past it and is remembered as a SEQ
+ * interval until the gap closes. Consume() advances the head, so taking a
+ * request off the front moves no bytes.
+ *
+ * The ring is mirrored (each byte is also written one capacity further
+ * on), which keeps the readable region contiguous in memory even when it
+ * wraps: GetBuffer() is always a single span that parsers read in place.
  */
 class TCPStreamReassembler {
 public:
     using LogCallback = std::function<void(const std::string& message)>;
 
+    // Receive window: bytes buffered (unread + out-of-order) never exceed this
+    static constexpr size_t kCapacity = 65536;
+
+    /**
+     * StreamView - the readable bytes, in place in the ring
+     *
+     * Valid until the next AddSegment, Consume or Reset.
+     */
+    class StreamView {
+    public:
+        StreamView() = default;
+        StreamView(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+        const uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const uint8_t* begin() const { return data_; }
+        const uint8_t* end() const { return data_ + size_; }
+        uint8_t operator[](size_t i) const { return data_[i]; }
+
+    private:
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
     /**
      * Constructor
      * @param initial_seq Initial sequence number (from SYN handshake)
@@ -38,17 +75,25 @@ public:
     /**
      * Add a TCP segment to the reassembler
      *
+     * Data past the receive window is dropped; a segment that starts past
+     * it is rejected.
+     *
      * @param seq Sequence number of this segment
      * @param data Payload data
      * @return true if data was accepted (new or filled gap), false if rejected (duplicate)
      */
-    bool AddSegment(uint32_t seq, const mtp::ByteArray& data);
+    bool AddSegment(uint32_t seq, const uint8_t* data, size_t size);
+    bool AddSegment(uint32_t seq, const mtp::ByteArray& data) {
+        return AddSegment(seq, data.data(), data.size());
+    }
 
     /**
-     * Get the contiguous data buffer (all in-order data received so far)
-     * @return Reference to the reassembled data buffer
+     * Get the contiguous data (all in-order data received and not yet consumed)
+     * @return View of the readable bytes
      */
-    const mtp::ByteArray& GetBuffer() const { return contiguous_buffer_; }
+    StreamView GetBuffer() const {
+        return StreamView(storage_ ? storage_.get() + head_ : nullptr, size_);
+    }
 
     /**
      * Get next expected sequence number
@@ -60,7 +105,7 @@ public:
      * Check if there are buffered out-of-order segments
      * @return true if there are gaps in the stream
      */
-    bool HasOutOfOrderData() const { return !out_of_order_buffer_.empty(); }
+    bool HasOutOfOrderData() const { return !out_of_order_.empty(); }
 
     /**
      * Get statistics for debugging
@@ -68,7 +113,7 @@ public:
     struct Stats {
         size_t segments_accepted = 0;      // New segments added
         size_t segments_rejected = 0;      // Duplicates rejected
-        size_t out_of_order_buffered = 0;  // Currently buffered out-of-order
+        size_t out_of_order_buffered = 0;  // Currently buffered out-of-order ranges
         size_t gaps_filled = 0;            // Times out-of-order data filled a gap
     };
 
@@ -84,19 +129,32 @@ public:
      */
     void Reset(uint32_t new_initial_seq);
 
+    /**
+     * Drop num_bytes from the front of the readable data
+     */
+    void Consume(size_t num_bytes);
+
     /**
      * Clear the contiguous buffer (used after HTTP request is processed)
      * Note: This does NOT clear out-of-order buffered data
      */
-    void ClearContiguousBuffer();
+    void ClearContiguousBuffer() { Consume(size_); }
 
     /**
      * Erase processed data from the front of the contiguous buffer
      * @param num_bytes Number of bytes to remove from the front
      */
-    void EraseProcessedBytes(size_t num_bytes);
+    void EraseProcessedBytes(size_t num_bytes) { Consume(num_bytes); }
 
 private:
+    /**
+     * Out-of-order range [start, end) already written to the ring
+     */
+    struct Interval {
+        uint32_t start;
+        uint32_t end;
+    };
+
     /**
      * Check if SEQ is before a reference SEQ (handles wraparound)
      * @param seq Sequence number to check
@@ -106,9 +164,15 @@ private:
     static bool IsSeqBefore(uint32_t seq, uint32_t ref_seq);
 
     /**
-     * Check if SEQ is in range [start, end) (handles wraparound)
+     * Copy data into the ring at offset bytes past the head (and its mirror)
+     */
+    void Write(size_t offset, const uint8_t* data, size_t size);
+
+    /**
+     * Record an out-of-order range, merging it with ranges it touches
+     * @return false if the range was already fully buffered
      */
-    static bool IsSeqInRange(uint32_t seq, uint32_t start, uint32_t end);
+    bool AddInterval(uint32_t start, uint32_t end);
 
     /**
      * Try to flush buffered out-of-order data to contiguous buffer
@@ -121,15 +185,16 @@ private:
      */
     void Log(const std::string& message);
 
-    // Next contiguous sequence number we expect
+    // Next contiguous sequence number we expect (the byte at head_ + size_)
     uint32_t next_expected_seq_;
 
-    // Contiguous data received in order (ready for application)
-    mtp::ByteArray contiguous_buffer_;
+    // kCapacity bytes plus their mirror; allocated on the first segment
+    std::unique_ptr<uint8_t[]> storage_;
+    size_t head_ = 0;  // Ring offset of the first unread byte
+    size_t size_ = 0;  // Contiguous unread bytes
 
-    // Out-of-order segments buffered until gaps are filled
-    // Key: starting sequence number, Value: data
-    std::map<uint32_t, mtp::ByteArray> out_of_order_buffer_;
+    // Out-of-order ranges past next_expected_seq_, disjoint, in SEQ order
+    std::vector<Interval> out_of_order_;
 
     // Statistics
     Stats stats_;
@@ -11,6 +11,8 @@
 #include <iomanip>
 #include <thread>
 #include <chrono>
+#include <fstream>
+#include <deque>
 
 namespace ptpip {
 
@@ -64,6 +66,9 @@ bool PTPIPClient::connect() {
                 throw std::runtime_error("Failed to create command socket");
             }
 
+            // Before connecting, so the window scale offered in the SYN covers them
+            set_socket_options(cmd_socket_);
+
             // Set socket to non-blocking
             platform_set_nonblocking(cmd_socket_, true);
 
@@ -124,8 +129,8 @@ bool PTPIPClient::connect() {
         std::cout << "  [OK] Sent Init Command Request" << std::endl;
 
         // 3. Receive Init Command Ack
-        auto init_ack = recv_packet(cmd_socket_);
-        connection_number_ = parse_init_ack(init_ack);
+        recv_packet(cmd_socket_, packet_buffer_);
+        connection_number_ = parse_init_ack(packet_buffer_);
         std::cout << "  [OK] Command channel established (ConnID=" << connection_number_ << ")" << std::endl;
 
         // 4. Connect event channel
@@ -134,6 +139,7 @@ bool PTPIPClient::connect() {
         if (event_socket_ == INVALID_SOCKET_VALUE) {
             throw std::runtime_error("Failed to create event socket");
         }
+        set_socket_options(event_socket_);
 
         if (::connect(event_socket_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
             throw std::runtime_error("Failed to connect event socket");
@@ -144,13 +150,12 @@ bool PTPIPClient::connect() {
         send_raw(event_socket_, init_event);
 
         // 6. Receive Init Event Ack
-        auto event_ack = recv_raw(event_socket_, 8);
-        if (event_ack.size() >= 8) {
-            uint32_t evt_type;
-            memcpy(&evt_type, &event_ack[4], 4);
-            if (evt_type == static_cast<uint32_t>(PacketType::INIT_EVENT_ACK)) {
-                std::cout << "  [OK] Event channel established" << std::endl;
-            }
+        uint8_t event_ack[8];
+        recv_exact(event_socket_, event_ack, sizeof(event_ack));
+        uint32_t evt_type;
+        memcpy(&evt_type, &event_ack[4], 4);
+        if (evt_type == static_cast<uint32_t>(PacketType::INIT_EVENT_ACK)) {
+            std::cout << "  [OK] Event channel established" << std::endl;
         }
 
         connected_ = true;
@@ -202,7 +207,7 @@ bool PTPIPClient::close_session() {
 
 std::vector<uint8_t> PTPIPClient::get_device_info() {
     auto resp = send_operation(OperationCode::GET_DEVICE_INFO, {});
-    return resp.data;
+    return std::move(resp.data);
 }
 
 std::vector<uint32_t> PTPIPClient::get_storage_ids() {
@@ -241,7 +246,26 @@ std::vector<uint32_t> PTPIPClient::get_object_handles(uint32_t storage_id, uint3
 
 ObjectInfo PTPIPClient::get_object_info(uint32_t handle) {
     auto resp = send_operation(OperationCode::GET_OBJECT_INFO, {handle});
+    return parse_object_info(handle, resp);
+}
+
+std::vector<ObjectInfo> PTPIPClient::get_object_infos(const std::vector<uint32_t>& handles) {
+    std::vector<PipelinedOperation> ops;
+    ops.reserve(handles.size());
+    for (uint32_t handle : handles) {
+        ops.push_back({OperationCode::GET_OBJECT_INFO, {handle}});
+    }
+
+    auto responses = send_pipelined(ops);
+    std::vector<ObjectInfo> infos;
+    infos.reserve(handles.size());
+    for (size_t i = 0; i < handles.size(); i++) {
+        infos.push_back(parse_object_info(handles[i], responses[i]));
+    }
+    return infos;
+}
 
+ObjectInfo PTPIPClient::parse_object_info(uint32_t handle, const OperationResponse& resp) {
     ObjectInfo info = {};
     info.handle = handle;
 
@@ -285,61 +309,283 @@ ObjectInfo PTPIPClient::get_object_info(uint32_t handle) {
 
 std::vector<uint8_t> PTPIPClient::get_object(uint32_t handle) {
     auto resp = send_operation(OperationCode::GET_OBJECT, {handle});
-    return resp.data;
+    return std::move(resp.data);
 }
 
-OperationResponse PTPIPClient::send_operation(OperationCode opcode, const std::vector<uint32_t>& params, const std::vector<uint8_t>& send_data) {
-    transaction_id_++;
+bool PTPIPClient::get_object(uint32_t handle, std::vector<uint8_t>& out) {
+    auto resp = send_operation(OperationCode::GET_OBJECT, {handle}, {}, &out);
+    return resp.response_code == ResponseCode::OK;
+}
 
-    // Determine data phase
-    uint32_t data_phase = send_data.empty() ? 0x00000000 : 0x00000001;
+bool PTPIPClient::get_object(uint32_t handle, const DataSink& sink) {
+    // Once the sink refuses, it is not called again
+    bool accepted = true;
+    DataSink guarded = [&](const uint8_t* data, size_t size) {
+        accepted = accepted && sink(data, size);
+        return accepted;
+    };
+
+    send_request(OperationCode::GET_OBJECT, {handle});
+    std::vector<uint8_t> unused;
+    auto resp = recv_response(unused, &guarded);
+    return accepted && resp.response_code == ResponseCode::OK;
+}
 
-    // Send operation request
-    auto op_req = build_operation_request(opcode, transaction_id_, params);
-    send_raw(cmd_socket_, op_req);
+bool PTPIPClient::get_object(uint32_t handle, const std::string& path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Cannot open " << path << " for writing" << std::endl;
+        return false;
+    }
+    bool ok = get_object(handle, [&file](const uint8_t* data, size_t size) {
+        file.write(reinterpret_cast<const char*>(data), size);
+        return static_cast<bool>(file);
+    });
+    file.close();
+    return ok && !file.fail();
+}
+
+bool PTPIPClient::send_object(uint64_t size, const DataSource& source) {
+    send_request(OperationCode::SEND_OBJECT, {});
+    send_data_phase(size, nullptr, &source);
+    std::vector<uint8_t> unused;
+    auto resp = recv_response(unused, nullptr);
+    return resp.response_code == ResponseCode::OK;
+}
+
+bool PTPIPClient::send_object(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return false;
+    }
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    return send_object(size, [&file](uint8_t* out, size_t size) {
+        file.read(reinterpret_cast<char*>(out), size);
+        return static_cast<size_t>(file.gcount());
+    });
+}
+
+OperationResponse PTPIPClient::send_operation(OperationCode opcode, const std::vector<uint32_t>& params,
+                                              const std::vector<uint8_t>& send_data, std::vector<uint8_t>* data_in) {
+    send_request(opcode, params);
 
     // If sending data, send it now
     if (!send_data.empty()) {
-        auto start_data = build_start_data(transaction_id_, send_data.size());
-        send_raw(cmd_socket_, start_data);
+        send_data_phase(send_data.size(), send_data.data(), nullptr);
+    }
 
-        auto data_pkt = build_data_packet(transaction_id_, send_data);
-        send_raw(cmd_socket_, data_pkt);
+    if (data_in) {
+        return recv_response(*data_in, nullptr);
+    }
+    std::vector<uint8_t> received_data;
+    OperationResponse op_resp = recv_response(received_data, nullptr);
+    op_resp.data = std::move(received_data);
+    return op_resp;
+}
+
+void PTPIPClient::send_request(OperationCode opcode, const std::vector<uint32_t>& params) {
+    transaction_id_++;
+    auto op_req = build_operation_request(opcode, transaction_id_, params);
+    send_raw(cmd_socket_, op_req);
+}
+
+void PTPIPClient::send_data_phase(uint64_t size, const uint8_t* data, const DataSource* source) {
+    auto start_data = build_start_data(transaction_id_, size);
+    send_raw(cmd_socket_, start_data);
 
-        auto end_data = build_end_data(transaction_id_);
-        send_raw(cmd_socket_, end_data);
+    uint8_t header[12];
+    uint32_t packet_type = static_cast<uint32_t>(PacketType::DATA);
+    memcpy(&header[4], &packet_type, 4);
+    memcpy(&header[8], &transaction_id_, 4);
+
+    uint64_t sent = 0;
+    while (sent < size) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(size - sent, DATA_CHUNK_SIZE));
+        const uint8_t* payload;
+        if (data) {
+            payload = data + sent;
+        } else {
+            chunk_buffer_.resize(DATA_CHUNK_SIZE);
+            chunk = (*source)(chunk_buffer_.data(), chunk);
+            if (chunk == 0) {
+                // StartData promised more; the device would wait for it
+                throw std::runtime_error("Data source ended early");
+            }
+            payload = chunk_buffer_.data();
+        }
+
+        uint32_t length = static_cast<uint32_t>(12 + chunk);
+        memcpy(&header[0], &length, 4);
+        send_gather(cmd_socket_, header, sizeof(header), payload, chunk);
+        sent += chunk;
     }
 
-    // Receive response (may include data packets)
-    std::vector<uint8_t> received_data;
-    OperationResponse op_resp;
+    auto end_data = build_end_data(transaction_id_);
+    send_raw(cmd_socket_, end_data);
+}
+
+OperationResponse PTPIPClient::recv_response(std::vector<uint8_t>& data, const DataSink* sink) {
+    // Receive response (may include data packets). Data packet payloads are
+    // received straight into the data buffer, after their 12-byte header,
+    // or passed to the sink a chunk at a time.
+    data.clear();
 
     while (true) {
-        auto packet = recv_packet(cmd_socket_);
-        auto pkt_type = get_packet_type(packet);
+        uint8_t header[12];
+        recv_exact(cmd_socket_, header, 8);
+        uint32_t length;
+        uint32_t type;
+        memcpy(&length, &header[0], 4);
+        memcpy(&type, &header[4], 4);
+        if (length < 8) {
+            throw std::runtime_error("Invalid packet length");
+        }
+        auto pkt_type = static_cast<PacketType>(type);
+
+        if ((pkt_type == PacketType::DATA || pkt_type == PacketType::END_DATA) && length >= 12) {
+            recv_exact(cmd_socket_, &header[8], 4);  // Transaction ID
+            size_t payload = length - 12;
+            if (sink) {
+                chunk_buffer_.resize(DATA_CHUNK_SIZE);
+                while (payload > 0) {
+                    size_t chunk = std::min(payload, DATA_CHUNK_SIZE);
+                    recv_exact(cmd_socket_, chunk_buffer_.data(), chunk);
+                    (*sink)(chunk_buffer_.data(), chunk);
+                    payload -= chunk;
+                }
+                continue;
+            }
+            size_t offset = data.size();
+            data.resize(offset + payload);
+            recv_exact(cmd_socket_, data.data() + offset, payload);
+            continue;
+        }
+
+        // Other packets are small: read whole
+        packet_buffer_.resize(length);
+        memcpy(packet_buffer_.data(), header, 8);
+        recv_exact(cmd_socket_, packet_buffer_.data() + 8, length - 8);
 
         if (pkt_type == PacketType::OPERATION_RESPONSE) {
-            op_resp = parse_operation_response(packet);
-            break;
-        } else if (pkt_type == PacketType::DATA || pkt_type == PacketType::END_DATA) {
+            return parse_operation_response(packet_buffer_);
+        }
+        if (pkt_type == PacketType::START_DATA && length >= 20 && !sink) {
+            // Total length, or all ones when the device does not know it
+            uint64_t total_length;
+            memcpy(&total_length, &packet_buffer_[12], 8);
+            if (total_length <= UINT32_MAX) {
+                data.reserve(static_cast<size_t>(total_length));
+            }
+        }
+    }
+}
+
+std::vector<OperationResponse> PTPIPClient::send_pipelined(const std::vector<PipelinedOperation>& ops, size_t depth) {
+    struct InFlight {
+        size_t index;
+        uint32_t transaction_id;
+        bool sent_ahead;  // Before the previous one was answered
+    };
+
+    std::vector<OperationResponse> results(ops.size());
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < ops.size(); i++) {
+        pending.push_back(i);
+    }
+    std::deque<InFlight> in_flight;
+    std::vector<uint8_t> batch;
+    depth = std::max<size_t>(depth, 1);
+
+    auto find = [&in_flight](uint32_t transaction_id) {
+        return std::find_if(in_flight.begin(), in_flight.end(),
+                            [transaction_id](const InFlight& f) { return f.transaction_id == transaction_id; });
+    };
+
+    while (!pending.empty() || !in_flight.empty()) {
+        // Top up the window; the requests go out together
+        batch.clear();
+        while (!pending.empty() && in_flight.size() < depth) {
+            size_t index = pending.front();
+            pending.pop_front();
+            transaction_id_++;
+            auto op_req = build_operation_request(ops[index].opcode, transaction_id_, ops[index].params);
+            batch.insert(batch.end(), op_req.begin(), op_req.end());
+            in_flight.push_back({index, transaction_id_, !in_flight.empty()});
+            results[index].data.clear();
+        }
+        if (!batch.empty()) {
+            send_raw(cmd_socket_, batch);
+        }
+
+        uint8_t header[12];
+        recv_exact(cmd_socket_, header, 8);
+        uint32_t length;
+        uint32_t type;
+        memcpy(&length, &header[0], 4);
+        memcpy(&type, &header[4], 4);
+        if (length < 8) {
+            throw std::runtime_error("Invalid packet length");
+        }
+        auto pkt_type = static_cast<PacketType>(type);
+
+        if ((pkt_type == PacketType::DATA || pkt_type == PacketType::END_DATA) && length >= 12) {
+            recv_exact(cmd_socket_, &header[8], 4);
             uint32_t tid;
-            auto data = parse_data_packet(packet, tid);
-            received_data.insert(received_data.end(), data.begin(), data.end());
-
-            if (pkt_type == PacketType::END_DATA) {
-                // Get final response
-                packet = recv_packet(cmd_socket_);
-                op_resp = parse_operation_response(packet);
-                break;
+            memcpy(&tid, &header[8], 4);
+            auto it = find(tid);
+            std::vector<uint8_t>& data = it != in_flight.end() ? results[it->index].data : packet_buffer_;
+            if (it == in_flight.end()) {
+                data.clear();  // Not ours: read and drop
             }
-        } else if (pkt_type == PacketType::START_DATA) {
-            // Just skip, data follows
+            size_t payload = length - 12;
+            size_t offset = data.size();
+            data.resize(offset + payload);
+            recv_exact(cmd_socket_, data.data() + offset, payload);
+            continue;
+        }
+
+        packet_buffer_.resize(length);
+        memcpy(packet_buffer_.data(), header, 8);
+        recv_exact(cmd_socket_, packet_buffer_.data() + 8, length - 8);
+
+        if (pkt_type == PacketType::START_DATA && length >= 20) {
+            uint32_t tid;
+            uint64_t total_length;
+            memcpy(&tid, &packet_buffer_[8], 4);
+            memcpy(&total_length, &packet_buffer_[12], 8);
+            auto it = find(tid);
+            if (it != in_flight.end() && total_length <= UINT32_MAX) {
+                results[it->index].data.reserve(static_cast<size_t>(total_length));
+            }
+            continue;
+        }
+        if (pkt_type != PacketType::OPERATION_RESPONSE) {
             continue;
         }
+
+        OperationResponse op_resp = parse_operation_response(packet_buffer_);
+        auto it = find(op_resp.transaction_id);
+        if (it == in_flight.end()) {
+            throw std::runtime_error("Operation Response for unknown transaction");
+        }
+        size_t index = it->index;
+        bool sent_ahead = it->sent_ahead;
+        in_flight.erase(it);
+
+        if (op_resp.response_code == ResponseCode::DEVICE_BUSY && sent_ahead) {
+            // The device takes one transaction at a time: retry this one,
+            // and send the rest only once the previous has been answered
+            depth = 1;
+            pending.push_front(index);
+            continue;
+        }
+        op_resp.data = std::move(results[index].data);
+        results[index] = std::move(op_resp);
     }
 
-    op_resp.data = received_data;
-    return op_resp;
+    return results;
 }
 
 // Packet builders
@@ -430,21 +676,6 @@ std::vector<uint8_t> PTPIPClient::build_start_data(uint32_t transaction_id, uint
     return packet;
 }
 
-std::vector<uint8_t> PTPIPClient::build_data_packet(uint32_t transaction_id, const std::vector<uint8_t>& data) {
-    uint32_t length = 12 + data.size();
-    uint32_t packet_type = static_cast<uint32_t>(PacketType::DATA);
-
-    std::vector<uint8_t> packet(length);
-    memcpy(&packet[0], &length, 4);
-    memcpy(&packet[4], &packet_type, 4);
-    memcpy(&packet[8], &transaction_id, 4);
-    if (!data.empty()) {
-        memcpy(&packet[12], data.data(), data.size());
-    }
-
-    return packet;
-}
-
 std::vector<uint8_t> PTPIPClient::build_end_data(uint32_t transaction_id) {
     uint32_t length = 12;
     uint32_t packet_type = static_cast<uint32_t>(PacketType::END_DATA);
@@ -498,21 +729,6 @@ OperationResponse PTPIPClient::parse_operation_response(const std::vector<uint8_
     return resp;
 }
 
-std::vector<uint8_t> PTPIPClient::parse_data_packet(const std::vector<uint8_t>& packet, uint32_t& transaction_id) {
-    if (packet.size() < 12) {
-        return {};
-    }
-
-    memcpy(&transaction_id, &packet[8], 4);
-
-    std::vector<uint8_t> data;
-    if (packet.size() > 12) {
-        data.insert(data.end(), packet.begin() + 12, packet.end());
-    }
-
-    return data;
-}
-
 // Low-level I/O
 void PTPIPClient::send_raw(socket_t sock, const std::vector<uint8_t>& data) {
     size_t sent = 0;
@@ -525,40 +741,61 @@ void PTPIPClient::send_raw(socket_t sock, const std::vector<uint8_t>& data) {
     }
 }
 
-std::vector<uint8_t> PTPIPClient::recv_raw(socket_t sock, size_t size) {
-    std::vector<uint8_t> data;
-    data.reserve(size);
-
-    while (data.size() < size) {
-        uint8_t buffer[BUFFER_SIZE];
-        ssize_t n = recv(sock, RECV_CAST(buffer), std::min(size - data.size(), BUFFER_SIZE), 0);
-        if (n <= 0) {
-            break;
+void PTPIPClient::send_gather(socket_t sock, const uint8_t* header, size_t header_size,
+                              const uint8_t* payload, size_t payload_size) {
+    // One call for both while the header is unsent, then the rest of the payload
+    size_t sent = 0;
+    size_t total = header_size + payload_size;
+    while (sent < total) {
+        ssize_t n;
+        if (sent < header_size) {
+            n = platform_send2(sock, header + sent, header_size - sent, payload, payload_size);
+        } else {
+            size_t offset = sent - header_size;
+            n = send(sock, SEND_CAST(payload + offset), payload_size - offset, 0);
         }
-        data.insert(data.end(), buffer, buffer + n);
+        if (n < 0) {
+            throw std::runtime_error("Send failed");
+        }
+        sent += n;
     }
+}
 
-    return data;
+void PTPIPClient::set_socket_options(socket_t sock) {
+    int recv_buffer = SOCKET_RECV_BUFFER;
+    int send_buffer = SOCKET_SEND_BUFFER;
+    int nodelay = 1;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, SETSOCKOPT_CAST(&recv_buffer), sizeof(recv_buffer));
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, SETSOCKOPT_CAST(&send_buffer), sizeof(send_buffer));
+    // Requests and the EndData after a data phase are small; don't hold
+    // them back waiting for an ACK
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, SETSOCKOPT_CAST(&nodelay), sizeof(nodelay));
 }
 
-std::vector<uint8_t> PTPIPClient::recv_packet(socket_t sock) {
-    // Read header (8 bytes)
-    auto header = recv_raw(sock, 8);
-    if (header.size() < 8) {
-        throw std::runtime_error("Connection closed");
+void PTPIPClient::recv_exact(socket_t sock, uint8_t* out, size_t size) {
+    size_t received = 0;
+    while (received < size) {
+        ssize_t n = recv(sock, RECV_CAST(out + received), size - received, 0);
+        if (n <= 0) {
+            throw std::runtime_error("Connection closed");
+        }
+        received += n;
     }
+}
 
-    uint32_t length;
-    memcpy(&length, &header[0], 4);
+void PTPIPClient::recv_packet(socket_t sock, std::vector<uint8_t>& packet) {
+    // Read header (8 bytes), then the rest of the packet behind it
+    packet.resize(8);
+    recv_exact(sock, packet.data(), 8);
 
-    // Read rest of packet
-    uint32_t remaining = length - 8;
-    if (remaining > 0) {
-        auto body = recv_raw(sock, remaining);
-        header.insert(header.end(), body.begin(), body.end());
+    uint32_t length;
+    memcpy(&length, &packet[0], 4);
+    if (length < 8) {
+        throw std::runtime_error("Invalid packet length");
     }
 
-    return header;
+    packet.resize(length);
+    recv_exact(sock, packet.data() + 8, length - 8);
 }
 
 } // namespace ptpip
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <cstdint>
 
 namespace ptpip {
@@ -42,7 +43,9 @@ enum class OperationCode : uint16_t {
     GET_NUM_OBJECTS = 0x1006,
     GET_OBJECT_HANDLES = 0x1007,
     GET_OBJECT_INFO = 0x1008,
-    GET_OBJECT = 0x1009
+    GET_OBJECT = 0x1009,
+    SEND_OBJECT_INFO = 0x100C,
+    SEND_OBJECT = 0x100D
 };
 
 // MTP response codes
@@ -55,7 +58,8 @@ enum class ResponseCode : uint16_t {
     PARAMETER_NOT_SUPPORTED = 0x2006,
     INCOMPLETE_TRANSFER = 0x2007,
     INVALID_STORAGE_ID = 0x2008,
-    INVALID_OBJECT_HANDLE = 0x2009
+    INVALID_OBJECT_HANDLE = 0x2009,
+    DEVICE_BUSY = 0x2019
 };
 
 struct OperationResponse {
@@ -65,6 +69,12 @@ struct OperationResponse {
     std::vector<uint8_t> data;
 };
 
+// One operation of a pipelined batch; it must not depend on another's result
+struct PipelinedOperation {
+    OperationCode opcode;
+    std::vector<uint32_t> params;
+};
+
 struct ObjectInfo {
     uint32_t storage_id;
     uint16_t format;
@@ -75,10 +85,21 @@ struct ObjectInfo {
     std::string filename;
 };
 
+// Receives the data phase in pieces as it arrives; return false to stop
+// (the rest is read and dropped, and the operation fails)
+using DataSink = std::function<bool(const uint8_t* data, size_t size)>;
+
+// Fills out with up to size bytes of the data phase; returns how many,
+// 0 at the end
+using DataSource = std::function<size_t(uint8_t* out, size_t size)>;
+
 class PTPIPClient {
 public:
     static constexpr int PTPIP_PORT = 15740;
-    static constexpr size_t BUFFER_SIZE = 65536;
+    static constexpr int SOCKET_RECV_BUFFER = 1 << 20;  // Room for a Wi-Fi window of object data
+    static constexpr int SOCKET_SEND_BUFFER = 1 << 20;
+    static constexpr size_t DATA_CHUNK_SIZE = 256 * 1024;  // Payload per Data packet we send, and per sink call
+    static constexpr size_t PIPELINE_DEPTH = 4;  // Requests on the wire at once in send_pipelined()
 
     PTPIPClient(const std::string& host, const std::string& session_guid, const std::string& pc_name = "ZuneWirelessSync");
     ~PTPIPClient();
@@ -97,30 +118,64 @@ public:
     std::vector<uint32_t> get_storage_ids();
     std::vector<uint32_t> get_object_handles(uint32_t storage_id, uint32_t object_format = 0, uint32_t parent = 0xFFFFFFFF);
     ObjectInfo get_object_info(uint32_t handle);
+    std::vector<ObjectInfo> get_object_infos(const std::vector<uint32_t>& handles);  // Pipelined
     std::vector<uint8_t> get_object(uint32_t handle);
 
+    // Reads the object into out, reusing its capacity: data packets are
+    // received straight into it, sized from StartData's total length.
+    // Returns false unless the device answered OK.
+    bool get_object(uint32_t handle, std::vector<uint8_t>& out);
+
+    // Streams the object to sink without holding it in memory
+    bool get_object(uint32_t handle, const DataSink& sink);
+    bool get_object(uint32_t handle, const std::string& path);  // To a file
+
+    // SendObject after a SendObjectInfo: size bytes are read from source as
+    // they are sent
+    bool send_object(uint64_t size, const DataSource& source);
+    bool send_object(const std::string& path);  // From a file
+
+    // Runs independent data-in operations with up to depth requests on the
+    // wire at once, matching data and responses to them by transaction ID.
+    // If the device answers Device Busy to one sent ahead, it is sent again
+    // and the rest go one at a time. Responses are in the order of ops.
+    std::vector<OperationResponse> send_pipelined(const std::vector<PipelinedOperation>& ops,
+                                                  size_t depth = PIPELINE_DEPTH);
+
 private:
-    // Low-level packet operations
-    OperationResponse send_operation(OperationCode opcode, const std::vector<uint32_t>& params = {}, const std::vector<uint8_t>& send_data = {});
+    // Low-level packet operations. The data phase lands in data_in if given
+    // (its capacity reused), otherwise in the response's data.
+    OperationResponse send_operation(OperationCode opcode, const std::vector<uint32_t>& params = {},
+                                     const std::vector<uint8_t>& send_data = {},
+                                     std::vector<uint8_t>* data_in = nullptr);
+
+    // Streaming pieces of send_operation. The data phase goes out as Data
+    // packets of at most DATA_CHUNK_SIZE, header and payload in one gather
+    // send; data, if given, is sent in place, otherwise source is read.
+    void send_request(OperationCode opcode, const std::vector<uint32_t>& params);
+    void send_data_phase(uint64_t size, const uint8_t* data, const DataSource* source);
+    OperationResponse recv_response(std::vector<uint8_t>& data, const DataSink* sink);
+
+    void set_socket_options(socket_t sock);  // Buffer sizes, TCP_NODELAY
 
     void send_packet(socket_t sock, const std::vector<uint8_t>& packet);
-    std::vector<uint8_t> recv_packet(socket_t sock);
+    void recv_packet(socket_t sock, std::vector<uint8_t>& packet);  // Whole packet, header included
     void send_raw(socket_t sock, const std::vector<uint8_t>& data);
-    std::vector<uint8_t> recv_raw(socket_t sock, size_t size);
+    void send_gather(socket_t sock, const uint8_t* header, size_t header_size, const uint8_t* payload, size_t payload_size);
+    void recv_exact(socket_t sock, uint8_t* out, size_t size);  // Throws if the connection closes first
 
     // Packet builders
     std::vector<uint8_t> build_init_command_request();
     std::vector<uint8_t> build_init_event_request(uint32_t connection_number);
     std::vector<uint8_t> build_operation_request(OperationCode opcode, uint32_t transaction_id, const std::vector<uint32_t>& params);
     std::vector<uint8_t> build_start_data(uint32_t transaction_id, uint64_t total_length);
-    std::vector<uint8_t> build_data_packet(uint32_t transaction_id, const std::vector<uint8_t>& data);
     std::vector<uint8_t> build_end_data(uint32_t transaction_id);
 
     // Packet parsers
     PacketType get_packet_type(const std::vector<uint8_t>& packet);
     uint32_t parse_init_ack(const std::vector<uint8_t>& packet);
     OperationResponse parse_operation_response(const std::vector<uint8_t>& packet);
-    std::vector<uint8_t> parse_data_packet(const std::vector<uint8_t>& packet, uint32_t& transaction_id);
+    static ObjectInfo parse_object_info(uint32_t handle, const OperationResponse& resp);
 
     std::string host_;
     std::string session_guid_;  // Session GUID from device property 0xd221 (hex string, 36 chars with dashes)
@@ -133,6 +188,9 @@ private:
     uint32_t connection_number_;
     uint32_t session_id_;
     uint32_t transaction_id_;
+
+    std::vector<uint8_t> packet_buffer_;  // Non-data packets, reused
+    std::vector<uint8_t> chunk_buffer_;   // Between the socket and a sink or source
 };
 
 } // namespace ptpip
@@ -9,11 +9,17 @@
 #include <algorithm>
 #include <ctime>
 
+#ifndef _WIN32
+#include <ifaddrs.h>
+#include <net/if.h>
+#endif
+
 namespace ssdp {
 
 SSDPDiscovery::SSDPDiscovery()
     : socket_fd_(INVALID_SOCKET_VALUE)
     , running_(false)
+    , search_requested_(false)
 {
     platform_socket_init();
 }
@@ -59,22 +65,143 @@ bool SSDPDiscovery::create_socket() {
         return false;
     }
 
-    // Join multicast group
+    // Join multicast group on each interface, and open the search sockets
+    interfaces_.clear();
+    update_interfaces();
+    if (search_sockets_.empty()) {
+        std::cerr << "Failed to open an M-SEARCH socket" << std::endl;
+        close_sockets();
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<uint32_t> SSDPDiscovery::list_interfaces() {
+    std::vector<uint32_t> result;
+#ifndef _WIN32
+    struct ifaddrs* list = nullptr;
+    if (getifaddrs(&list) == 0) {
+        for (struct ifaddrs* ifa = list; ifa; ifa = ifa->ifa_next) {
+            if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_INET) continue;
+            if (!(ifa->ifa_flags & IFF_UP) || !(ifa->ifa_flags & IFF_MULTICAST)) continue;
+            if (ifa->ifa_flags & IFF_LOOPBACK) continue;
+            result.push_back(reinterpret_cast<struct sockaddr_in*>(ifa->ifa_addr)->sin_addr.s_addr);
+        }
+        freeifaddrs(list);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+#endif
+    // Let the system pick when interfaces can't be listed
+    if (result.empty()) {
+        result.push_back(htonl(INADDR_ANY));
+    }
+    return result;
+}
+
+bool SSDPDiscovery::update_interfaces() {
+    std::vector<uint32_t> current = list_interfaces();
+    if (current == interfaces_) {
+        return false;
+    }
+
     struct ip_mreq mreq;
     mreq.imr_multiaddr.s_addr = inet_addr(SSDP_ADDR);
-    mreq.imr_interface.s_addr = INADDR_ANY;
 
-    if (setsockopt(socket_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, SETSOCKOPT_CAST(&mreq), sizeof(mreq)) < 0) {
-        std::cerr << "Failed to join multicast group" << std::endl;
+    // Interfaces that went away
+    for (uint32_t addr : interfaces_) {
+        if (std::find(current.begin(), current.end(), addr) != current.end()) continue;
+        mreq.imr_interface.s_addr = addr;
+        setsockopt(socket_fd_, IPPROTO_IP, IP_DROP_MEMBERSHIP, SETSOCKOPT_CAST(&mreq), sizeof(mreq));
+        for (auto it = search_sockets_.begin(); it != search_sockets_.end(); ++it) {
+            if (it->interface_addr == addr) {
+                platform_close_socket(it->fd);
+                search_sockets_.erase(it);
+                break;
+            }
+        }
+    }
+
+    // New ones
+    for (uint32_t addr : current) {
+        if (std::find(interfaces_.begin(), interfaces_.end(), addr) != interfaces_.end()) continue;
+
+        char ip[INET_ADDRSTRLEN];
+        struct in_addr in;
+        in.s_addr = addr;
+        inet_ntop(AF_INET, &in, ip, sizeof(ip));
+
+        mreq.imr_interface.s_addr = addr;
+        if (setsockopt(socket_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, SETSOCKOPT_CAST(&mreq), sizeof(mreq)) < 0) {
+            std::cerr << "Failed to join multicast group on " << ip << std::endl;
+        }
+
+        // Responses come back unicast to this socket's address and port
+        socket_t fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd == INVALID_SOCKET_VALUE) {
+            continue;
+        }
+        struct sockaddr_in bind_addr;
+        memset(&bind_addr, 0, sizeof(bind_addr));
+        bind_addr.sin_family = AF_INET;
+        bind_addr.sin_addr.s_addr = addr;
+        bind_addr.sin_port = 0;
+        if (bind(fd, (struct sockaddr*)&bind_addr, sizeof(bind_addr)) < 0) {
+            std::cerr << "Failed to bind M-SEARCH socket on " << ip << std::endl;
+            platform_close_socket(fd);
+            continue;
+        }
+        if (addr != htonl(INADDR_ANY)) {
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, SETSOCKOPT_CAST(&in), sizeof(in));
+        }
+        int ttl = 2;  // UPnP's default
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, SETSOCKOPT_CAST(&ttl), sizeof(ttl));
+        search_sockets_.push_back({addr, fd});
+    }
+
+    interfaces_ = current;
+    return true;
+}
+
+void SSDPDiscovery::close_sockets() {
+    for (const auto& search : search_sockets_) {
+        platform_close_socket(search.fd);
+    }
+    search_sockets_.clear();
+    interfaces_.clear();
+
+    if (socket_fd_ != INVALID_SOCKET_VALUE) {
         platform_close_socket(socket_fd_);
         socket_fd_ = INVALID_SOCKET_VALUE;
-        return false;
     }
+}
 
-    // Set receive timeout so we can check running flag periodically
-    platform_set_socket_timeout(socket_fd_, SO_RCVTIMEO, 1);
+void SSDPDiscovery::send_search() {
+    // ssdp:all rather than a Zune-specific target: responses are filtered
+    // on the Zune server string like NOTIFY packets are
+    std::ostringstream request;
+    request << "M-SEARCH * HTTP/1.1\r\n"
+            << "HOST: " << SSDP_ADDR << ":" << SSDP_PORT << "\r\n"
+            << "MAN: \"ssdp:discover\"\r\n"
+            << "MX: " << SEARCH_MX << "\r\n"
+            << "ST: ssdp:all\r\n"
+            << "\r\n";
+    std::string message = request.str();
+
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_addr.s_addr = inet_addr(SSDP_ADDR);
+    dest.sin_port = htons(SSDP_PORT);
+
+    for (const auto& search : search_sockets_) {
+        sendto(search.fd, SEND_CAST(message.data()), message.size(), 0, (struct sockaddr*)&dest, sizeof(dest));
+    }
+}
 
-    return true;
+void SSDPDiscovery::search() {
+    search_requested_ = true;
 }
 
 std::string SSDPDiscovery::extract_mac_from_uuid(const std::string& uuid) {
@@ -103,12 +230,15 @@ std::string SSDPDiscovery::extract_mac_from_uuid(const std::string& uuid) {
     return formatted;
 }
 
-bool SSDPDiscovery::parse_notify(const char* data, size_t len, const std::string& source_ip, ZuneDevice& device) {
+bool SSDPDiscovery::parse_notify(const char* data, size_t len, const std::string& source_ip, ZuneDevice& device,
+                                 int& max_age) {
     std::string packet(data, len);
+    max_age = 0;
 
-    // Check if it's a NOTIFY packet
+    // Check if it's a NOTIFY packet, or a response to our M-SEARCH
     if (packet.find("NOTIFY * HTTP/1.1") == std::string::npos &&
-        packet.find("NOTIFY *") == std::string::npos) {
+        packet.find("NOTIFY *") == std::string::npos &&
+        packet.compare(0, 15, "HTTP/1.1 200 OK") != 0) {
         return false;
     }
 
@@ -154,6 +284,12 @@ bool SSDPDiscovery::parse_notify(const char* data, size_t len, const std::string
             }
         } else if (header == "LOCATION") {
             location = value;
+        } else if (header == "CACHE-CONTROL") {
+            size_t age = value.find("max-age");
+            size_t equals = value.find('=', age);
+            if (age != std::string::npos && equals != std::string::npos) {
+                max_age = atoi(value.c_str() + equals + 1);
+            }
         }
     }
 
@@ -185,93 +321,155 @@ bool SSDPDiscovery::parse_notify(const char* data, size_t len, const std::string
     return true;
 }
 
-void SSDPDiscovery::cleanup_expired_devices() {
+SSDPDiscovery::Clock::time_point SSDPDiscovery::cleanup_expired_devices() {
     std::lock_guard<std::mutex> lock(devices_mutex_);
 
-    time_t now = time(nullptr);
-    auto it = devices_.begin();
-    while (it != devices_.end()) {
-        if (now - it->second.last_seen > DEVICE_TIMEOUT) {
+    Clock::time_point now = Clock::now();
+    while (!expiry_queue_.empty() && expiry_queue_.top().first <= now) {
+        std::string uuid = expiry_queue_.top().second;
+        expiry_queue_.pop();
+
+        auto expires = expires_.find(uuid);
+        if (expires == expires_.end() || expires->second > now) {
+            continue;  // Seen again since
+        }
+        expires_.erase(expires);
+
+        auto it = devices_.find(uuid);
+        if (it != devices_.end()) {
             std::cout << "Device expired: " << it->second.ip_address
                       << " (UUID: " << it->second.uuid << ")" << std::endl;
-            it = devices_.erase(it);
-        } else {
-            ++it;
+            devices_.erase(it);
         }
     }
+
+    return expiry_queue_.empty() ? Clock::time_point::max() : expiry_queue_.top().first;
+}
+
+void SSDPDiscovery::handle_packet(const char* data, size_t len, const struct sockaddr_in& sender,
+                                  const DeviceCallback& callback) {
+    // Get source IP
+    char sender_ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &sender.sin_addr, sender_ip, sizeof(sender_ip));
+
+    // Parse packet
+    ZuneDevice device;
+    int max_age;
+    if (!parse_notify(data, len, sender_ip, device, max_age)) {
+        return;
+    }
+
+    bool is_new = false;
+
+    {
+        std::lock_guard<std::mutex> lock(devices_mutex_);
+
+        // Check if this is a new device
+        auto it = devices_.find(device.uuid);
+        if (it == devices_.end()) {
+            is_new = true;
+            std::cout << "\n=== Zune Device Discovered ===" << std::endl;
+            std::cout << "  IP Address: " << device.ip_address << std::endl;
+            std::cout << "  UUID:       " << device.uuid << std::endl;
+            std::cout << "  MAC:        " << device.mac_address << std::endl;
+            if (!device.location_url.empty()) {
+                std::cout << "  Location:   " << device.location_url << std::endl;
+            }
+            std::cout << "==============================\n" << std::endl;
+        }
+
+        devices_[device.uuid] = device;
+
+        // Twice the advertised lifetime, as with DEVICE_TIMEOUT
+        int lifetime = max_age > 0 ? 2 * max_age : DEVICE_TIMEOUT;
+        Clock::time_point expires = Clock::now() + std::chrono::seconds(lifetime);
+        expires_[device.uuid] = expires;
+        expiry_queue_.push({expires, device.uuid});
+    }
+
+    // Call callback
+    if (callback) {
+        callback(device, is_new);
+    }
 }
 
 void SSDPDiscovery::listen_loop(DeviceCallback callback) {
+    using std::chrono::milliseconds;
+
     char buffer[BUFFER_SIZE];
-    struct sockaddr_in sender_addr;
-    socklen_t sender_len = sizeof(sender_addr);
+    const size_t burst_length = sizeof(SEARCH_BURST_MS) / sizeof(SEARCH_BURST_MS[0]);
 
     std::cout << "SSDP Discovery listening on " << SSDP_ADDR << ":" << SSDP_PORT << std::endl;
-    std::cout << "Waiting for Zune devices to announce themselves..." << std::endl;
+    std::cout << "Searching for Zune devices..." << std::endl;
+
+    Clock::time_point burst_start = Clock::now();
+    size_t burst_sent = 0;
+    Clock::time_point next_interface_check = burst_start + milliseconds(INTERFACE_CHECK_MS);
+    std::vector<platform_pollfd> fds;
 
     while (running_) {
-        ssize_t recv_len = recvfrom(socket_fd_, RECV_CAST(buffer), BUFFER_SIZE - 1, 0,
-                                     (struct sockaddr*)&sender_addr, &sender_len);
+        Clock::time_point now = Clock::now();
 
-        if (recv_len < 0) {
-            // Check if it's a timeout (expected) or real error
+        if (search_requested_.exchange(false)) {
+            burst_start = now;
+            burst_sent = 0;
+        }
+        if (now >= next_interface_check) {
+            if (update_interfaces()) {
+                std::cout << "Network interfaces changed, searching again" << std::endl;
+                burst_start = now;
+                burst_sent = 0;
+            }
+            next_interface_check = now + milliseconds(INTERFACE_CHECK_MS);
+        }
+        while (burst_sent < burst_length && now >= burst_start + milliseconds(SEARCH_BURST_MS[burst_sent])) {
+            send_search();
+            burst_sent++;
+        }
+        Clock::time_point next_expiry = cleanup_expired_devices();
+
+        // Sleep until the next timer, or a packet
+        Clock::time_point wake = std::min({now + milliseconds(MAX_WAIT_MS), next_interface_check, next_expiry});
+        if (burst_sent < burst_length) {
+            wake = std::min(wake, burst_start + milliseconds(SEARCH_BURST_MS[burst_sent]));
+        }
+        auto wait = std::chrono::duration_cast<milliseconds>(wake - now + milliseconds(1)).count();
+
+        fds.clear();
+        fds.push_back({socket_fd_, POLLIN, 0});
+        for (const auto& search : search_sockets_) {
+            fds.push_back({search.fd, POLLIN, 0});
+        }
+
+        int ready = platform_poll(fds.data(), fds.size(), static_cast<int>(std::max<long long>(wait, 0)));
+        if (ready < 0) {
             int err = platform_socket_error();
-            if (err == PLATFORM_EAGAIN) {
-                // Timeout - just continue loop to check running flags
+            if (err == PLATFORM_EINTR) {
                 continue;
             }
-
             if (running_) {
-                std::cerr << "Error receiving packet (error " << err << ")" << std::endl;
+                std::cerr << "Error waiting for packets (error " << err << ")" << std::endl;
             }
             break;
         }
 
-        buffer[recv_len] = '\0';
-
-        // Get source IP
-        char sender_ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &sender_addr.sin_addr, sender_ip, sizeof(sender_ip));
-
-        // Parse packet
-        ZuneDevice device;
-        if (parse_notify(buffer, recv_len, sender_ip, device)) {
-            bool is_new = false;
-
-            {
-                std::lock_guard<std::mutex> lock(devices_mutex_);
-
-                // Check if this is a new device
-                auto it = devices_.find(device.uuid);
-                if (it == devices_.end()) {
-                    is_new = true;
-                    std::cout << "\n=== Zune Device Discovered ===" << std::endl;
-                    std::cout << "  IP Address: " << device.ip_address << std::endl;
-                    std::cout << "  UUID:       " << device.uuid << std::endl;
-                    std::cout << "  MAC:        " << device.mac_address << std::endl;
-                    if (!device.location_url.empty()) {
-                        std::cout << "  Location:   " << device.location_url << std::endl;
-                    }
-                    std::cout << "==============================\n" << std::endl;
-                }
-
-                devices_[device.uuid] = device;
+        for (const auto& pfd : fds) {
+            if (!(pfd.revents & POLLIN)) {
+                continue;
             }
-
-            // Call callback
-            if (callback) {
-                callback(device, is_new);
+            struct sockaddr_in sender_addr;
+            socklen_t sender_len = sizeof(sender_addr);
+            ssize_t recv_len = recvfrom(pfd.fd, RECV_CAST(buffer), BUFFER_SIZE - 1, 0,
+                                        (struct sockaddr*)&sender_addr, &sender_len);
+            if (recv_len <= 0) {
+                continue;
             }
-        }
-
-        // Periodically cleanup expired devices
-        static time_t last_cleanup = time(nullptr);
-        time_t now = time(nullptr);
-        if (now - last_cleanup > 60) { // Every minute
-            cleanup_expired_devices();
-            last_cleanup = now;
+            buffer[recv_len] = '\0';
+            handle_packet(buffer, recv_len, sender_addr, callback);
         }
     }
+
+    close_sockets();
 }
 
 void SSDPDiscovery::start_listening(DeviceCallback on_device_found) {
@@ -307,14 +505,9 @@ void SSDPDiscovery::stop() {
         return;
     }
 
+    // The loop notices within MAX_WAIT_MS and closes its sockets
     running_ = false;
 
-    if (socket_fd_ != INVALID_SOCKET_VALUE) {
-        shutdown(socket_fd_, PLATFORM_SHUT_RDWR);
-        platform_close_socket(socket_fd_);
-        socket_fd_ = INVALID_SOCKET_VALUE;
-    }
-
     if (listen_thread_.joinable()) {
         listen_thread_.join();
     }
@@ -1,9 +1,11 @@
 /*
- * SSDP Discovery - Listen for Zune device advertisements
+ * SSDP Discovery - Find Zune devices on the local network
  *
  * The Zune device broadcasts SSDP NOTIFY packets on 239.255.255.250:1900
- * announcing its presence. This module listens for those packets and
- * extracts device information.
+ * announcing its presence, but one that has just woken may not announce
+ * for a while. So besides listening for those packets, this module sends
+ * M-SEARCH requests (a short burst at start, and again when the network
+ * interfaces change) and reads the devices' unicast responses.
  */
 
 #pragma once
@@ -16,6 +18,9 @@
 #include <atomic>
 #include <mutex>
 #include <map>
+#include <queue>
+#include <chrono>
+#include <cstdint>
 
 namespace ssdp {
 
@@ -53,27 +58,67 @@ public:
     // Get all currently known devices
     std::vector<ZuneDevice> get_devices() const;
 
+    // Send another M-SEARCH burst (e.g. when the user asks to look again)
+    void search();
+
     // Check if currently listening
     bool is_running() const { return running_; }
 
 private:
+    using Clock = std::chrono::steady_clock;
+
     // SSDP multicast address and port
     static constexpr const char* SSDP_ADDR = "239.255.255.250";
     static constexpr uint16_t SSDP_PORT = 1900;
     static constexpr int BUFFER_SIZE = 2048;
     static constexpr int DEVICE_TIMEOUT = 600; // 10 minutes (2x cache-control max-age)
-
-    socket_t socket_fd_;
+    static constexpr int SEARCH_MX = 1;        // Seconds a device may wait before answering
+    static constexpr int SEARCH_BURST_MS[] = {0, 150, 500};  // M-SEARCH send times, from the burst start
+    static constexpr int INTERFACE_CHECK_MS = 2000;
+    static constexpr int MAX_WAIT_MS = 250;    // Longest poll, so stop() is noticed
+
+    // One per IPv4 interface, sending M-SEARCH and receiving the responses
+    struct SearchSocket {
+        uint32_t interface_addr;  // Network byte order
+        socket_t fd;
+    };
+
+    socket_t socket_fd_;                      // Bound to 1900, receives NOTIFY
+    std::vector<SearchSocket> search_sockets_;
+    std::vector<uint32_t> interfaces_;        // Joined to the multicast group on these
     std::atomic<bool> running_;
+    std::atomic<bool> search_requested_;
     std::thread listen_thread_;
     mutable std::mutex devices_mutex_;
     std::map<std::string, ZuneDevice> devices_; // UUID -> Device
 
+    // Expiry times; the queue may hold stale entries for devices seen again
+    // since, which are skipped when they come up
+    std::map<std::string, Clock::time_point> expires_;
+    using Expiry = std::pair<Clock::time_point, std::string>;
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>> expiry_queue_;
+
     // Create and configure socket
     bool create_socket();
 
-    // Parse SSDP NOTIFY packet
-    bool parse_notify(const char* data, size_t len, const std::string& source_ip, ZuneDevice& device);
+    // Current IPv4 multicast-capable interfaces (INADDR_ANY if unknown)
+    static std::vector<uint32_t> list_interfaces();
+
+    // Join the multicast group and open search sockets on interfaces that
+    // are new, and drop those that are gone. Returns true if any changed.
+    bool update_interfaces();
+
+    void close_sockets();
+
+    // Send one M-SEARCH on every interface
+    void send_search();
+
+    // Parse SSDP NOTIFY packet or M-SEARCH response; max_age is 0 if absent
+    bool parse_notify(const char* data, size_t len, const std::string& source_ip, ZuneDevice& device,
+                      int& max_age);
+
+    // Record a device from a received packet and report it
+    void handle_packet(const char* data, size_t len, const struct sockaddr_in& sender, const DeviceCallback& callback);
 
     // Extract MAC address from UUID
     std::string extract_mac_from_uuid(const std::string& uuid);
@@ -81,8 +126,8 @@ private:
     // Listening loop
     void listen_loop(DeviceCallback callback);
 
-    // Cleanup expired devices
-    void cleanup_expired_devices();
+    // Remove devices whose expiry time has passed; returns the next one due
+    Clock::time_point cleanup_expired_devices();
 };
 
 } // namespace ssdp
@@ -3,8 +3,18 @@
 #include "ZuneDeviceIdentification.h"
 #include "ZuneMtpWriter.h"
 #include "ZuneMtpReader.h"
+#include "ZunePackedLibrary.h"
+#include "ZuneLibraryIndex.h"
+#include "ZuneUploadEngine.h"
+#include "ZuneSyncPlanner.h"
+#include "ZuneMediaScanner.h"
+#include "ZuneFileInputStream.h"
+#include "zmdb/ZMDBUtils.h"
 #include "protocols/http/ZuneHTTPInterceptor.h"
 #include "ssdp_discovery.h"
+#include "ZuneUsbHotplug.h"
+#include "ZuneTrace.h"
+#include <algorithm>
 #include <vector>
 #include <cstring>
 #include <iostream>
@@ -13,8 +23,14 @@
 #include <mtp/ptp/Session.h>
 #include <mtp/ptp/OutputStream.h>
 #include <mtp/ptp/ByteArrayObjectStream.h>
-#include <cli/PosixStreams.h>
 #include <usb/Context.h>
+#include <algorithm>
+#include <cerrno>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #ifdef __APPLE__
 #include <IOKit/IOKitLib.h>
@@ -29,6 +45,8 @@
 #endif
 
 static std::unique_ptr<ssdp::SSDPDiscovery> g_discovery;
+static zune::Logger g_usb_hotplug_logger;   // Declared first so it outlives g_usb_hotplug
+static std::unique_ptr<zune::UsbHotplug> g_usb_hotplug;
 static thread_local std::string g_last_error;
 
 extern "C" {
@@ -45,9 +63,33 @@ XUNE_SYNC_API void zune_device_destroy(zune_device_handle_t handle) {
     delete static_cast<ZuneDevice*>(handle);
 }
 
+static bool ConnectToZune(ZuneDevice* device, const std::string& serial) {
+    // Hotplug already knows the devices: open one without enumerating. Each
+    // is tried in turn, as those other handles have open refuse the claim.
+    if (g_usb_hotplug && g_usb_hotplug->IsRunning()) {
+        auto snapshot = g_usb_hotplug->GetSnapshot();
+        if (!snapshot.devices.empty()) {
+            for (const auto& descriptor : snapshot.devices) {
+                if (device->ConnectUSB(snapshot.context, descriptor, serial)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return device->ConnectUSB(serial);
+}
+
 XUNE_SYNC_API bool zune_device_connect_usb(zune_device_handle_t handle) {
     if (handle) {
-        return static_cast<ZuneDevice*>(handle)->ConnectUSB();
+        return ConnectToZune(static_cast<ZuneDevice*>(handle), "");
+    }
+    return false;
+}
+
+XUNE_SYNC_API bool zune_device_connect_usb_serial(zune_device_handle_t handle, const char* serial) {
+    if (handle && serial && *serial) {
+        return ConnectToZune(static_cast<ZuneDevice*>(handle), serial);
     }
     return false;
 }
@@ -85,6 +127,15 @@ XUNE_SYNC_API void zune_device_set_log_callback(zune_device_handle_t handle, log
     }
 }
 
+XUNE_SYNC_API int zune_device_set_log_level(
+    zune_device_handle_t handle, ZuneLogCategory category, ZuneLogLevel level)
+{
+    if (!handle || category < 0 || category > ZUNE_LOG_CATEGORY_COUNT ||
+        level < ZUNE_LOG_ERROR || level > ZUNE_LOG_DEBUG) return -1;
+    static_cast<ZuneDevice*>(handle)->SetLogLevel(category, level);
+    return 0;
+}
+
 XUNE_SYNC_API void zune_device_set_mtpz_data_path(zune_device_handle_t handle, const char* path) {
     if (handle && path) {
         static_cast<ZuneDevice*>(handle)->SetMtpzDataPath(path);
@@ -216,6 +267,47 @@ XUNE_SYNC_API int zune_device_download_file(zune_device_handle_t handle, uint32_
     return -1;
 }
 
+XUNE_SYNC_API int zune_device_download_artwork_batch(
+    zune_device_handle_t handle,
+    const uint32_t* object_handles,
+    const char* const* destination_paths,
+    uint32_t count,
+    zune_artwork_data_callback_t callback,
+    void* user_data,
+    int* out_results
+) {
+    if (out_results) {
+        std::fill(out_results, out_results + count, static_cast<int>(ZUNE_ARTWORK_FAILED));
+    }
+    if (!handle || (count > 0 && !object_handles)) {
+        return -1;
+    }
+
+    std::vector<uint32_t> handles(object_handles, object_handles + count);
+    std::vector<std::string> paths(count);
+    if (destination_paths) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (destination_paths[i]) paths[i] = destination_paths[i];
+        }
+    }
+
+    std::function<bool(size_t, const uint8_t*, size_t)> sink;
+    if (callback) {
+        sink = [&](size_t index, const uint8_t* data, size_t size) {
+            return callback(static_cast<uint32_t>(index), handles[index], data,
+                            static_cast<uint32_t>(size), user_data);
+        };
+    }
+
+    std::vector<int> results;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    int rc = device->DownloadArtworkBatch(handles, paths, sink, &results);
+    if (out_results) {
+        std::copy(results.begin(), results.end(), out_results);
+    }
+    return rc;
+}
+
 XUNE_SYNC_API int zune_device_delete_file(zune_device_handle_t handle, uint32_t object_handle) {
     if (handle) {
         return static_cast<ZuneDevice*>(handle)->DeleteFile(object_handle);
@@ -223,6 +315,34 @@ XUNE_SYNC_API int zune_device_delete_file(zune_device_handle_t handle, uint32_t
     return -1;
 }
 
+XUNE_SYNC_API int zune_device_delete_objects(
+    zune_device_handle_t handle,
+    const uint32_t* object_handles,
+    uint32_t count,
+    uint32_t flags,
+    int* out_results
+) {
+    if (out_results) {
+        std::fill(out_results, out_results + count, -1);
+    }
+    if (!handle || (count > 0 && !object_handles)) {
+        return -1;
+    }
+
+    try {
+        std::vector<uint32_t> handles(object_handles, object_handles + count);
+        std::vector<int> results;
+        auto* device = static_cast<ZuneDevice*>(handle);
+        int rc = device->DeleteObjects(handles, (flags & ZUNE_DELETE_COLLAPSE_FOLDERS) != 0, &results);
+        if (out_results) {
+            std::copy(results.begin(), results.end(), out_results);
+        }
+        return rc;
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
 
 
 XUNE_SYNC_API ZuneMusicLibrary* zune_device_get_music_library(zune_device_handle_t handle) {
@@ -233,10 +353,156 @@ XUNE_SYNC_API ZuneMusicLibrary* zune_device_get_music_library(zune_device_handle
     return device->GetMusicLibrary();
 }
 
+XUNE_SYNC_API void zune_device_set_parallel_library_parsing(zune_device_handle_t handle, bool enable) {
+    if (!handle) {
+        return;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->SetParallelLibraryParsing(enable);
+}
+
+XUNE_SYNC_API void zune_device_set_streaming_library_read(zune_device_handle_t handle, bool enable) {
+    if (!handle) {
+        return;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->SetStreamingLibraryRead(enable);
+}
+
+XUNE_SYNC_API void zune_device_set_library_cache_dir(zune_device_handle_t handle, const char* directory) {
+    if (!handle) {
+        return;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->SetLibraryCacheDirectory(directory ? directory : "");
+}
+
+XUNE_SYNC_API void zune_device_set_library_fingerprint_check(zune_device_handle_t handle, bool enable) {
+    if (!handle) {
+        return;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->SetLibraryFingerprintCheck(enable);
+}
+
+XUNE_SYNC_API void zune_device_set_deferred_media_details(zune_device_handle_t handle, bool enable) {
+    if (!handle) {
+        return;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->SetDeferredMediaDetails(enable);
+}
+
 XUNE_SYNC_API void zune_device_free_music_library(ZuneMusicLibrary* library) {
     zune::MtpReader::FreeLibrary(library);
 }
 
+XUNE_SYNC_API ZuneMusicLibrary* zune_device_get_packed_music_library(zune_device_handle_t handle) {
+    if (!handle) {
+        return nullptr;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    return device->GetPackedMusicLibrary();
+}
+
+XUNE_SYNC_API void zune_device_set_library_tracking(zune_device_handle_t handle, bool enable) {
+    if (!handle) {
+        return;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->SetLibraryTracking(enable);
+}
+
+XUNE_SYNC_API ZuneMusicLibrary* zune_device_get_tracked_music_library(zune_device_handle_t handle) {
+    if (!handle) {
+        return nullptr;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    return device->GetTrackedMusicLibrary();
+}
+
+XUNE_SYNC_API ZuneLibraryDelta* zune_device_take_library_delta(zune_device_handle_t handle) {
+    if (!handle) {
+        return nullptr;
+    }
+    auto* device = static_cast<ZuneDevice*>(handle);
+    return device->TakeLibraryDelta();
+}
+
+XUNE_SYNC_API void zune_library_delta_free(ZuneLibraryDelta* delta) {
+    zune::MtpReader::FreeLibraryDelta(delta);
+}
+
+XUNE_SYNC_API int zune_device_refresh_user_states(zune_device_handle_t handle) {
+    if (!handle) return -2;
+    try {
+        return static_cast<ZuneDevice*>(handle)->RefreshUserStates();
+    } catch (...) {
+        return -1;
+    }
+}
+
+XUNE_SYNC_API zune_library_index_t zune_library_index_create(const ZuneMusicLibrary* library) {
+    if (!library) {
+        return nullptr;
+    }
+    try {
+        return new zune::LibraryIndex(*library);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+XUNE_SYNC_API void zune_library_index_free(zune_library_index_t index) {
+    delete static_cast<zune::LibraryIndex*>(index);
+}
+
+XUNE_SYNC_API ZuneIndexRange zune_library_tracks_for_album(zune_library_index_t index, uint32_t album_atom_id) {
+    if (!index) {
+        return ZuneIndexRange{nullptr, 0};
+    }
+    return static_cast<zune::LibraryIndex*>(index)->TracksForAlbum(album_atom_id);
+}
+
+XUNE_SYNC_API ZuneIndexRange zune_library_albums_for_artist(zune_library_index_t index, uint32_t artist_atom_id) {
+    if (!index) {
+        return ZuneIndexRange{nullptr, 0};
+    }
+    return static_cast<zune::LibraryIndex*>(index)->AlbumsForArtist(artist_atom_id);
+}
+
+XUNE_SYNC_API ZuneIndexRange zune_library_tracks_for_genre(zune_library_index_t index, uint32_t genre_atom_id) {
+    if (!index) {
+        return ZuneIndexRange{nullptr, 0};
+    }
+    return static_cast<zune::LibraryIndex*>(index)->TracksForGenre(genre_atom_id);
+}
+
+XUNE_SYNC_API int32_t zune_library_find_track_by_atom(zune_library_index_t index, uint32_t atom_id) {
+    if (!index) {
+        return -1;
+    }
+    return static_cast<zune::LibraryIndex*>(index)->FindTrackByAtom(atom_id);
+}
+
+XUNE_SYNC_API int zune_packed_music_library_save(const ZuneMusicLibrary* library, const char* path) {
+    if (!library || !path) {
+        return -1;
+    }
+    return zune::SavePackedLibrary(library, path) ? 0 : -1;
+}
+
+XUNE_SYNC_API ZuneMusicLibrary* zune_packed_music_library_load(const char* path) {
+    if (!path) {
+        return nullptr;
+    }
+    return zune::LoadPackedLibrary(path);
+}
+
+XUNE_SYNC_API void zune_packed_music_library_free(ZuneMusicLibrary* library) {
+    zune::FreePackedLibrary(library);
+}
+
 XUNE_SYNC_API int zune_device_get_partial_object(
     zune_device_handle_t handle,
     uint32_t object_id,
@@ -282,6 +548,62 @@ XUNE_SYNC_API uint64_t zune_device_get_object_size(zune_device_handle_t handle,
     return 0;
 }
 
+XUNE_SYNC_API int zune_device_download_object(
+    zune_device_handle_t handle,
+    uint32_t object_id,
+    uint64_t offset,
+    uint32_t chunk_size,
+    zune_download_chunk_callback_t callback,
+    void* user_data,
+    uint64_t* out_next_offset
+) {
+    if (out_next_offset) *out_next_offset = offset;
+    if (!handle || !callback) {
+        return -1;
+    }
+
+    auto* device = static_cast<ZuneDevice*>(handle);
+    zune::StreamObjectOptions options;
+    options.offset = offset;
+    if (chunk_size) options.chunk_size = chunk_size;
+    return device->StreamObject(object_id, options,
+        [&](const uint8_t* data, size_t size, uint64_t chunk_offset) {
+            return callback(data, static_cast<uint32_t>(size), chunk_offset, user_data);
+        }, out_next_offset);
+}
+
+XUNE_SYNC_API int zune_device_download_object_to_fd(
+    zune_device_handle_t handle,
+    uint32_t object_id,
+    int fd,
+    uint64_t offset,
+    uint64_t* out_next_offset
+) {
+    if (out_next_offset) *out_next_offset = offset;
+    if (!handle || fd < 0) {
+        return -1;
+    }
+
+    auto* device = static_cast<ZuneDevice*>(handle);
+    zune::StreamObjectOptions options;
+    options.offset = offset;
+    return device->StreamObject(object_id, options,
+        [fd](const uint8_t* data, size_t size, uint64_t) {
+            while (size > 0) {
+#ifdef _WIN32
+                int written = _write(fd, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+#else
+                ssize_t written = ::write(fd, data, size);
+                if (written < 0 && errno == EINTR) continue;
+#endif
+                if (written <= 0) return false;
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }, out_next_offset);
+}
+
 XUNE_SYNC_API const char* zune_device_get_object_filename(zune_device_handle_t handle, uint32_t object_id) {
     if (handle) {
         static thread_local std::string filename;
@@ -291,6 +613,15 @@ XUNE_SYNC_API const char* zune_device_get_object_filename(zune_device_handle_t h
     return "";
 }
 
+XUNE_SYNC_API const char* zune_device_get_media_detail(zune_device_handle_t handle, uint32_t object_id, ZuneMediaDetail detail) {
+    if (handle) {
+        static thread_local std::string text;
+        text = static_cast<ZuneDevice*>(handle)->GetMediaDetail(object_id, detail);
+        return text.c_str();
+    }
+    return "";
+}
+
 XUNE_SYNC_API uint32_t zune_device_get_audio_track_object_id(zune_device_handle_t handle, const char* track_title, uint32_t album_object_id) {
     if (handle && track_title) {
         return static_cast<ZuneDevice*>(handle)->GetAudioTrackObjectId(track_title, album_object_id);
@@ -298,6 +629,24 @@ XUNE_SYNC_API uint32_t zune_device_get_audio_track_object_id(zune_device_handle_
     return 0;
 }
 
+XUNE_SYNC_API int zune_device_prewarm_track_cache(zune_device_handle_t handle, const uint32_t* album_object_ids, uint32_t count) {
+    if (!handle) {
+        return -1;
+    }
+    std::vector<uint32_t> albums;
+    if (album_object_ids) {
+        if (count == 0) {
+            return 0;
+        }
+        albums.assign(album_object_ids, album_object_ids + count);
+    }
+    try {
+        return static_cast<ZuneDevice*>(handle)->PrewarmTrackObjectIdCache(albums);
+    } catch (...) {
+        return -1;
+    }
+}
+
 // ============================================================================
 // Playlist Management API
 // ============================================================================
@@ -373,6 +722,65 @@ XUNE_SYNC_API int zune_device_delete_playlist(
     }
 }
 
+XUNE_SYNC_API int zune_device_stage_playlist_tracks(
+    zune_device_handle_t handle,
+    uint32_t playlist_id,
+    const uint32_t* track_ids,
+    size_t track_count
+) {
+    if (!handle || playlist_id == 0 || (!track_ids && track_count > 0)) {
+        return -1;
+    }
+
+    std::vector<uint32_t> track_vec;
+    if (track_ids && track_count > 0) {
+        track_vec.assign(track_ids, track_ids + track_count);
+    }
+    static_cast<ZuneDevice*>(handle)->StagePlaylistTracks(playlist_id, std::move(track_vec));
+    return 0;
+}
+
+XUNE_SYNC_API int zune_device_stage_new_playlist(
+    zune_device_handle_t handle,
+    const char* name,
+    const char* guid,
+    const uint32_t* track_ids,
+    size_t track_count,
+    uint32_t playlists_folder_id
+) {
+    if (!handle || !name || !guid || playlists_folder_id == 0 || (!track_ids && track_count > 0)) {
+        return -1;
+    }
+
+    std::vector<uint32_t> track_vec;
+    if (track_ids && track_count > 0) {
+        track_vec.assign(track_ids, track_ids + track_count);
+    }
+    static_cast<ZuneDevice*>(handle)->StageNewPlaylist(name, guid, std::move(track_vec), playlists_folder_id);
+    return 0;
+}
+
+XUNE_SYNC_API int zune_device_commit_playlists(zune_device_handle_t handle) {
+    if (!handle) {
+        return -1;
+    }
+    return static_cast<int>(static_cast<ZuneDevice*>(handle)->CommitPlaylists());
+}
+
+XUNE_SYNC_API uint32_t zune_device_get_staged_playlist_id(zune_device_handle_t handle, const char* guid) {
+    if (!handle || !guid) {
+        return 0;
+    }
+    return static_cast<ZuneDevice*>(handle)->GetStagedPlaylistId(guid);
+}
+
+XUNE_SYNC_API void zune_device_set_playlist_debounce(zune_device_handle_t handle, uint32_t milliseconds) {
+    if (!handle) {
+        return;
+    }
+    static_cast<ZuneDevice*>(handle)->SetPlaylistDebounce(milliseconds);
+}
+
 XUNE_SYNC_API int zune_device_set_track_user_state(
     zune_device_handle_t handle,
     uint32_t zmdb_atom_id,
@@ -391,6 +799,53 @@ XUNE_SYNC_API int zune_device_set_track_user_state(
     }
 }
 
+XUNE_SYNC_API int zune_device_set_track_user_states(
+    zune_device_handle_t handle,
+    const ZuneTrackUserState* states,
+    uint32_t count,
+    int* out_status
+) {
+    if (!handle) {
+        return -2;  // Device not connected
+    }
+    if ((!states || !out_status) && count > 0) {
+        return -1;
+    }
+
+    try {
+        return static_cast<ZuneDevice*>(handle)->SetTrackUserStates(states, count, out_status);
+    } catch (...) {
+        return -1;
+    }
+}
+
+XUNE_SYNC_API int zune_device_backfill_artist_metadata(
+    zune_device_handle_t handle,
+    uint32_t artists_folder,
+    ZuneArtistBackfillItem* items,
+    uint32_t count,
+    zune_artist_backfill_callback_t callback,
+    void* user_data
+) {
+    if (!handle) return -2;
+    if (!items && count > 0) return -1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!items[i].track_ids && items[i].track_count > 0) return -1;
+    }
+
+    ZuneDevice::ArtistBackfillProgress progress;
+    if (callback) {
+        progress = [&](uint32_t artists_done, uint32_t artist_count, uint64_t tracks_done, uint64_t track_total) {
+            return callback(artists_done, artist_count, tracks_done, track_total, user_data);
+        };
+    }
+    try {
+        return static_cast<ZuneDevice*>(handle)->BackfillArtistMetadata(artists_folder, items, count, progress);
+    } catch (...) {
+        return -1;
+    }
+}
+
 XUNE_SYNC_API void zune_ssdp_start_discovery(device_discovered_callback_t callback) {
     if (!g_discovery) {
         g_discovery = std::make_unique<ssdp::SSDPDiscovery>();
@@ -410,9 +865,10 @@ XUNE_SYNC_API void zune_ssdp_stop_discovery() {
 }
 
 XUNE_SYNC_API bool zune_device_find_on_usb(const char** uuid, const char** device_name) {
-    // Log state transitions only (not every poll) to avoid log spam
-    static bool last_found = false;
-    static std::string last_error;
+    // Log state transitions only (not every poll) to avoid log spam. Per
+    // thread, as each device's host may poll from its own.
+    thread_local bool last_found = false;
+    thread_local std::string last_error;
 
     try {
         mtp::usb::ContextPtr ctx = std::make_shared<mtp::usb::Context>();
@@ -475,9 +931,46 @@ XUNE_SYNC_API bool zune_device_find_on_usb(const char** uuid, const char** devic
     return false;
 }
 
+XUNE_SYNC_API int zune_device_list_usb(const char** serials, int capacity) {
+    if (capacity > 0 && !serials) return -1;
+    thread_local std::vector<std::string> found;
+    found.clear();
+    try {
+        mtp::usb::ContextPtr ctx = std::make_shared<mtp::usb::Context>();
+        for (auto desc : ctx->GetDevices()) {
+            if (desc->GetVendorId() != 0x045E) continue;
+            try {
+                // Fails for a Zune a handle has open: it cannot be connected anyway
+                auto device = mtp::Device::Open(ctx, desc, true, false);
+                if (device) {
+                    found.push_back(device->GetInfo().SerialNumber);
+                }
+            } catch (const std::exception&) {
+            }
+        }
+    } catch (const std::exception& e) {
+        g_last_error = e.what();
+        return -1;
+    }
+    for (int i = 0; i < capacity && i < static_cast<int>(found.size()); i++) {
+        serials[i] = found[i].c_str();
+    }
+    return static_cast<int>(found.size());
+}
+
 XUNE_SYNC_API bool zune_device_detect_on_usb() {
     static bool last_detected = false;
 
+    if (g_usb_hotplug && g_usb_hotplug->IsRunning()) {
+        for (const auto& desc : g_usb_hotplug->GetSnapshot().devices) {
+            auto pid = desc->GetProductId();
+            if (pid == 0x0710 || pid == 0x063e) {
+                return true;
+            }
+        }
+        return false;
+    }
+
 #ifdef __APPLE__
     // Pure IORegistry match — no plugin interfaces, no user-client allocation.
     // Avoids kIOReturnNoResources errors on suspended devices after sleep/wake.
@@ -532,6 +1025,36 @@ XUNE_SYNC_API bool zune_device_detect_on_usb() {
     return found;
 }
 
+XUNE_SYNC_API bool zune_usb_hotplug_start(usb_hotplug_callback_t callback, void* user_data) {
+    if (g_usb_hotplug && g_usb_hotplug->IsRunning()) {
+        return false;
+    }
+    g_usb_hotplug = std::make_unique<zune::UsbHotplug>();
+    g_usb_hotplug->SetLogger(&g_usb_hotplug_logger);
+    return g_usb_hotplug->Start([callback, user_data](bool arrived, const mtp::usb::DeviceDescriptorPtr& desc) {
+        if (callback) {
+            callback(arrived, desc->GetProductId(), user_data);
+        }
+    });
+}
+
+XUNE_SYNC_API void zune_usb_hotplug_stop() {
+    if (g_usb_hotplug) {
+        g_usb_hotplug->Stop();
+        g_usb_hotplug.reset();
+    }
+}
+
+XUNE_SYNC_API void zune_usb_hotplug_set_log_callback(log_callback_t callback) {
+    if (callback) {
+        g_usb_hotplug_logger.SetSink([callback](const std::string& message) {
+            callback(message.c_str());
+        });
+    } else {
+        g_usb_hotplug_logger.SetSink(nullptr);
+    }
+}
+
 // ============================================================================
 // Artist Metadata HTTP Interception API
 // ============================================================================
@@ -558,6 +1081,30 @@ XUNE_SYNC_API int zune_device_start_artist_metadata_interceptor(
             config->proxy_mix_server ? config->proxy_mix_server : cpp_config.proxy_config.catalog_server;
         cpp_config.proxy_config.timeout_ms =
             config->proxy_timeout_ms > 0 ? config->proxy_timeout_ms : 5000;
+        if (config->cache_write_queue_depth > 0) {
+            cpp_config.proxy_config.cache_write_queue_depth = config->cache_write_queue_depth;
+        }
+        if (config->cache_write_queue_limit_kb > 0) {
+            cpp_config.proxy_config.cache_write_queue_bytes = size_t(config->cache_write_queue_limit_kb) * 1024;
+        }
+        if (config->fast_lane_workers > 0) {
+            cpp_config.fast_lane_workers = config->fast_lane_workers;
+        }
+        if (config->slow_lane_workers > 0) {
+            cpp_config.slow_lane_workers = config->slow_lane_workers;
+        }
+        if (config->usb_transfer_budget > 0) {
+            cpp_config.usb_transfer_budget = config->usb_transfer_budget;
+        }
+        if (config->coalesce_max_wait_us > 0) {
+            cpp_config.coalesce_max_wait_us = config->coalesce_max_wait_us;
+        } else if (config->coalesce_max_wait_us < 0) {
+            cpp_config.coalesce_max_wait_us = 0;
+        }
+        cpp_config.congestion_control = config->congestion_control == ZUNE_CONGESTION_CONTROL_RENO
+            ? CongestionControlKind::RENO : CongestionControlKind::USB_LINK;
+        cpp_config.ppp_compression = config->disable_ppp_compression == 0;
+        cpp_config.reactor = config->reactor_mode != 0;
 
         if (config->server_ip) {
             cpp_config.server_ip = config->server_ip;
@@ -602,6 +1149,17 @@ XUNE_SYNC_API int zune_device_get_artist_metadata_config(
         config->proxy_art_server = strdup(cpp_config.proxy_config.art_server.c_str());
         config->proxy_mix_server = strdup(cpp_config.proxy_config.mix_server.c_str());
         config->proxy_timeout_ms = cpp_config.proxy_config.timeout_ms;
+        config->cache_write_queue_depth = static_cast<int>(cpp_config.proxy_config.cache_write_queue_depth);
+        config->cache_write_queue_limit_kb = static_cast<int>(cpp_config.proxy_config.cache_write_queue_bytes / 1024);
+        config->fast_lane_workers = static_cast<int>(cpp_config.fast_lane_workers);
+        config->slow_lane_workers = static_cast<int>(cpp_config.slow_lane_workers);
+        config->usb_transfer_budget = static_cast<int>(cpp_config.usb_transfer_budget);
+        config->coalesce_max_wait_us = cpp_config.coalesce_max_wait_us > 0
+            ? static_cast<int>(cpp_config.coalesce_max_wait_us) : -1;
+        config->congestion_control = cpp_config.congestion_control == CongestionControlKind::RENO
+            ? ZUNE_CONGESTION_CONTROL_RENO : ZUNE_CONGESTION_CONTROL_USB_LINK;
+        config->disable_ppp_compression = cpp_config.ppp_compression ? 0 : 1;
+        config->reactor_mode = cpp_config.reactor ? 1 : 0;
 
         return 0;
     }
@@ -671,6 +1229,178 @@ XUNE_SYNC_API void zune_device_set_cache_storage_callback(
     }
 }
 
+XUNE_SYNC_API int zune_device_get_metadata_cache_stats(
+    zune_device_handle_t handle, ZuneMetadataCacheStats* out)
+{
+    if (!handle || !out) return -1;
+    auto stats = static_cast<ZuneDevice*>(handle)->GetMetadataCacheStats();
+    out->hits = stats.hits;
+    out->misses = stats.misses;
+    out->evictions = stats.evictions;
+    out->entries = stats.entries;
+    out->bytes = stats.bytes;
+    out->capacity = stats.capacity;
+    out->prefetched = stats.prefetched;
+    out->prefetch_hits = stats.prefetch_hits;
+    return 0;
+}
+
+XUNE_SYNC_API void zune_device_clear_metadata_cache(zune_device_handle_t handle) {
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->ClearMetadataCache();
+}
+
+XUNE_SYNC_API void zune_device_set_metadata_cache_capacity(
+    zune_device_handle_t handle, uint64_t capacity_bytes)
+{
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetMetadataCacheCapacity(static_cast<size_t>(capacity_bytes));
+}
+
+XUNE_SYNC_API int zune_device_set_metadata_disk_cache(
+    zune_device_handle_t handle, const char* directory, uint64_t max_bytes, uint64_t ttl_seconds)
+{
+    if (!handle) return -1;
+    MetadataDiskCache::Limits limits;
+    limits.max_bytes = max_bytes;
+    limits.ttl = std::chrono::seconds(static_cast<int64_t>(std::min<uint64_t>(ttl_seconds, INT64_MAX)));
+    bool ok = static_cast<ZuneDevice*>(handle)->SetMetadataDiskCache(directory ? directory : "", limits);
+    return ok ? 0 : -1;
+}
+
+XUNE_SYNC_API int zune_device_get_metadata_disk_cache_stats(
+    zune_device_handle_t handle, ZuneMetadataDiskCacheStats* out)
+{
+    if (!handle || !out) return -1;
+    auto stats = static_cast<ZuneDevice*>(handle)->GetMetadataDiskCacheStats();
+    out->hits = stats.hits;
+    out->misses = stats.misses;
+    out->stores = stats.stores;
+    out->expired = stats.expired;
+    out->evictions = stats.evictions;
+    out->entries = stats.entries;
+    out->blobs = stats.blobs;
+    out->bytes = stats.bytes;
+    out->capacity = stats.capacity;
+    return 0;
+}
+
+XUNE_SYNC_API void zune_device_set_image_resize_callback(
+    zune_device_handle_t handle, zune_image_resize_callback_t callback, void* user_data)
+{
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetImageResizeCallback(callback, user_data);
+}
+
+XUNE_SYNC_API int zune_device_get_image_variant_stats(
+    zune_device_handle_t handle, ZuneImageVariantStats* out)
+{
+    if (!handle || !out) return -1;
+    auto stats = static_cast<ZuneDevice*>(handle)->GetImageVariantStats();
+    out->hits = stats.hits;
+    out->misses = stats.misses;
+    out->waits = stats.waits;
+    out->resized = stats.resized;
+    out->kept = stats.kept;
+    out->bytes_in = stats.bytes_in;
+    out->bytes_out = stats.bytes_out;
+    out->entries = stats.entries;
+    out->bytes = stats.bytes;
+    return 0;
+}
+
+static void CopyLaneStats(const RequestLaneStats& from, ZuneHTTPWorkerLaneStats* to) {
+    to->workers = from.workers;
+    to->queued = from.queued;
+    to->completed = from.completed;
+    to->stolen = from.stolen;
+    to->depth = from.depth;
+    to->wait_us_total = from.wait_us_total;
+    to->wait_us_max = from.wait_us_max;
+    to->service_us_total = from.service_us_total;
+    to->service_us_max = from.service_us_max;
+}
+
+XUNE_SYNC_API int zune_device_get_http_worker_stats(
+    zune_device_handle_t handle,
+    ZuneHTTPWorkerLaneStats* fast_lane,
+    ZuneHTTPWorkerLaneStats* slow_lane)
+{
+    if (!handle || !fast_lane || !slow_lane) return -1;
+    RequestWorkerStats stats = static_cast<ZuneDevice*>(handle)->GetRequestWorkerStats();
+    CopyLaneStats(stats.fast, fast_lane);
+    CopyLaneStats(stats.slow, slow_lane);
+    return 0;
+}
+
+XUNE_SYNC_API int zune_device_get_network_stats(
+    zune_device_handle_t handle,
+    ZuneNetworkStats* out,
+    ZuneTCPConnectionStats* connections,
+    uint32_t capacity)
+{
+    if (!handle || !out || (capacity > 0 && !connections)) return -1;
+    InterceptorNetworkStats stats = static_cast<ZuneDevice*>(handle)->GetNetworkStats();
+
+    *out = ZuneNetworkStats{};
+    out->http_requests = stats.metrics.http_requests;
+    out->responses_started = stats.metrics.responses_started;
+    out->first_segment_us_total = stats.metrics.first_segment_us_total;
+    out->first_segment_us_max = stats.metrics.first_segment_us_max;
+    out->first_segment_us_last = stats.metrics.first_segment_us_last;
+    out->requests_completed = stats.workers.fast.completed + stats.workers.slow.completed;
+    out->request_wait_us_total = stats.workers.fast.wait_us_total + stats.workers.slow.wait_us_total;
+    out->request_wait_us_max = std::max(stats.workers.fast.wait_us_max, stats.workers.slow.wait_us_max);
+    out->fast_retransmits = stats.fast_retransmits;
+    out->rto_retransmits = stats.rto_retransmits;
+    out->response_queue_depth = stats.response_queue_depth;
+    out->usb_transfers = stats.metrics.usb_transfers;
+    out->usb_bytes_sent = stats.metrics.usb_bytes_sent;
+    out->bytes_per_second = stats.metrics.bytes_per_second;
+    out->compressed_frames = stats.compression.frames;
+    out->compression_bytes_in = stats.compression.bytes_in;
+    out->compression_bytes_out = stats.compression.bytes_out;
+    out->connection_count = static_cast<uint32_t>(stats.connections.size());
+    out->ppp_compression = stats.compression.compressing ? 1 : 0;
+
+    uint32_t written = 0;
+    for (const TCPConnectionStats& conn : stats.connections) {
+        if (written == capacity) break;
+        ZuneTCPConnectionStats& to = connections[written++];
+        to.device_ip = conn.conn_key.src_ip;
+        to.device_port = conn.conn_key.src_port;
+        to.server_ip = conn.conn_key.dst_ip;
+        to.server_port = conn.conn_key.dst_port;
+        to.state = static_cast<uint32_t>(conn.state);
+        to.receiver_window = conn.receiver_window;
+        to.cwnd = conn.cwnd;
+        to.ssthresh = conn.ssthresh;
+        to.bytes_in_flight = conn.bytes_in_flight;
+        to.srtt_ms = conn.srtt ? static_cast<int32_t>(conn.srtt->count()) : -1;
+        to.rto_ms = static_cast<uint32_t>(conn.rto.count());
+        to.unacked_segments = static_cast<uint32_t>(conn.unacked_segments);
+        to.active_transmissions = static_cast<uint32_t>(conn.active_transmissions);
+        to.fast_retransmits = conn.fast_retransmits;
+        to.rto_retransmits = conn.rto_retransmits;
+        to.sack_permitted = conn.sack_permitted ? 1 : 0;
+    }
+    return static_cast<int>(written);
+}
+
+XUNE_SYNC_API int zune_device_set_packet_capture(
+    zune_device_handle_t handle, uint32_t max_transfers)
+{
+    if (!handle) return -1;
+    return static_cast<ZuneDevice*>(handle)->SetPacketCapture(max_transfers) ? 0 : -1;
+}
+
+XUNE_SYNC_API int64_t zune_device_write_packet_capture(
+    zune_device_handle_t handle, const char* path)
+{
+    if (!handle || !path) return -1;
+    return static_cast<ZuneDevice*>(handle)->WritePacketCapture(path);
+}
+
 XUNE_SYNC_API bool zune_device_initialize_http_subsystem(zune_device_handle_t handle)
 {
     if (!handle) return false;
@@ -717,7 +1447,45 @@ XUNE_SYNC_API int zune_device_poll_network_data(zune_device_handle_t handle, int
         auto* device = static_cast<ZuneDevice*>(handle);
         return device->PollNetworkData(timeout_ms);
     } catch (const std::exception& e) {
-        return -1;
+        return -1;
+    }
+}
+
+XUNE_SYNC_API uint64_t zune_device_start_network_poll_loop(
+    zune_device_handle_t handle,
+    int hot_wait_ms,
+    int idle_wait_ms,
+    zune_network_poll_event_callback_t callback,
+    void* user_data)
+{
+    if (!handle) return 0;
+
+    try {
+        auto* device = static_cast<ZuneDevice*>(handle);
+        NetworkPollLoop::EventFn on_event;
+        if (callback) {
+            on_event = [callback, user_data](NetworkPollLoop::Event event, int result) {
+                callback(static_cast<ZuneNetworkPollEvent>(event), result, user_data);
+            };
+        }
+        return device->StartNetworkPollLoop(
+            std::move(on_event),
+            hot_wait_ms >= 0 ? hot_wait_ms : NetworkPollLoop::kDefaultHotWaitMs,
+            idle_wait_ms > 0 ? idle_wait_ms : NetworkPollLoop::kDefaultIdleWaitMs);
+    } catch (const std::exception& e) {
+        return 0;
+    }
+}
+
+XUNE_SYNC_API bool zune_device_stop_network_poll_loop(zune_device_handle_t handle, uint64_t token)
+{
+    if (!handle || token == 0) return false;
+
+    try {
+        auto* device = static_cast<ZuneDevice*>(handle);
+        return device->StopNetworkPollLoop(token);
+    } catch (const std::exception& e) {
+        return false;
     }
 }
 
@@ -797,6 +1565,7 @@ XUNE_SYNC_API bool zune_device_open_idle_session(zune_device_handle_t handle)
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return false;
         session->Operation922b(3, 1, 0);
         session->Operation9230(1);
@@ -813,6 +1582,7 @@ XUNE_SYNC_API bool zune_device_read_sync_status(zune_device_handle_t handle)
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return false;
         // GetDevicePropValue(0xD217) x2 — reads device sync status
         try { session->GetDeviceProperty(mtp::DeviceProperty(0xD217)); } catch (...) {}
@@ -830,6 +1600,7 @@ XUNE_SYNC_API bool zune_device_close_session(zune_device_handle_t handle)
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return false;
         session->Operation922b(3, 2, 0);
         return true;
@@ -838,6 +1609,77 @@ XUNE_SYNC_API bool zune_device_close_session(zune_device_handle_t handle)
     }
 }
 
+// ============================================================================
+// Transfer Statistics Implementation
+// ============================================================================
+
+XUNE_SYNC_API int zune_device_get_transfer_stats(zune_device_handle_t handle, ZuneTransferStats* out) {
+    if (!handle || !out) return -1;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->GetTransferStats().Snapshot(*out);
+    return 0;
+}
+
+XUNE_SYNC_API void zune_device_reset_transfer_stats(zune_device_handle_t handle) {
+    if (!handle) return;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->GetTransferStats().Reset();
+}
+
+XUNE_SYNC_API void zune_device_set_transfer_progress_callback(
+    zune_device_handle_t handle, zune_transfer_progress_callback_t callback, void* user_data)
+{
+    if (!handle) return;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->GetTransferStats().SetProgressCallback(callback, user_data);
+}
+
+XUNE_SYNC_API void zune_trace_set_enabled(bool enable) {
+    zune::Tracer::Instance().SetEnabled(enable);
+}
+
+XUNE_SYNC_API size_t zune_trace_get_spans(ZuneTraceSpan* out, size_t capacity) {
+    auto events = zune::Tracer::Instance().GetEvents();
+    if (!out) return events.size();
+    size_t count = std::min(capacity, events.size());
+    for (size_t i = 0; i < count; i++) {
+        out[i].category = events[i].category;
+        out[i].name = events[i].name;
+        out[i].start_us = events[i].start_us;
+        out[i].duration_us = events[i].duration_us;
+        out[i].thread = events[i].thread;
+    }
+    return count;
+}
+
+XUNE_SYNC_API void zune_trace_clear() {
+    zune::Tracer::Instance().Clear();
+}
+
+XUNE_SYNC_API int zune_trace_export_chrome(const char* path) {
+    if (!path || !*path) return -1;
+    return zune::Tracer::Instance().ExportChromeJson(path) ? 0 : -1;
+}
+
+XUNE_SYNC_API int zune_device_get_mtp_scheduler_stats(zune_device_handle_t handle, ZuneMtpSchedulerStats* out) {
+    if (!handle || !out) return -1;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->GetMtpScheduler().Snapshot(*out);
+    return 0;
+}
+
+XUNE_SYNC_API void zune_device_reset_mtp_scheduler_stats(zune_device_handle_t handle) {
+    if (!handle) return;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->GetMtpScheduler().Reset();
+}
+
+XUNE_SYNC_API void zune_device_set_mtp_scheduler_fairness(zune_device_handle_t handle, uint32_t max_bypass) {
+    if (!handle) return;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    device->GetMtpScheduler().SetMaxBypass(max_bypass);
+}
+
 // ============================================================================
 // Low-Level MTP Primitives Implementation
 // ============================================================================
@@ -860,6 +1702,7 @@ XUNE_SYNC_API ZuneMtpCreateResult zune_mtp_send_object_prop_list(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) {
             result.status = -2;  // Not connected
             return result;
@@ -927,12 +1770,15 @@ XUNE_SYNC_API ZuneMtpCreateResult zune_mtp_send_object_prop_list(
             }
         }
 
-        auto response = session->SendObjectPropList(
-            mtpStorage,
-            mtp::ObjectId(parent_id),
-            static_cast<mtp::ObjectFormat>(format),
-            object_size,
-            propList);
+        auto response = zune::TransferStats::Measure(
+            &device->GetTransferStats(), ZUNE_TRANSFER_OP_SEND_OBJECT_PROP_LIST, propList.size(), [&] {
+                return session->SendObjectPropList(
+                    mtpStorage,
+                    mtp::ObjectId(parent_id),
+                    static_cast<mtp::ObjectFormat>(format),
+                    object_size,
+                    propList);
+            });
 
         result.object_id = response.ObjectId.Id;
         result.storage_id = response.StorageId.Id;
@@ -957,8 +1803,10 @@ XUNE_SYNC_API int zune_mtp_send_object(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_BULK);
         if (!session) return -2;
 
+        zune::TransferStats::Scope scope(&device->GetTransferStats(), ZUNE_TRANSFER_OP_SEND_OBJECT);
         if (size == 0 || !data) {
             // Send empty object
             mtp::ByteArray empty;
@@ -969,7 +1817,9 @@ XUNE_SYNC_API int zune_mtp_send_object(
                                   static_cast<const uint8_t*>(data) + size);
             auto stream = std::make_shared<mtp::ByteArrayObjectInputStream>(bytes);
             session->SendObject(stream);
+            scope.AddSent(size);
         }
+        scope.Succeeded();
 
         return 0;
     } catch (const std::exception& e) {
@@ -986,10 +1836,13 @@ XUNE_SYNC_API int zune_mtp_send_object_from_file(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_BULK);
         if (!session) return -2;
 
-        auto stream = std::make_shared<cli::ObjectInputStream>(file_path);
-        session->SendObject(stream);
+        auto* stats = &device->GetTransferStats();
+        auto stream = std::make_shared<zune::FileInputStream>(file_path, stats);
+        zune::TransferStats::Measure(stats, ZUNE_TRANSFER_OP_SEND_OBJECT, stream->GetSize(),
+                                     [&] { session->SendObject(stream); });
 
         return 0;
     } catch (const std::exception& e) {
@@ -1009,6 +1862,7 @@ XUNE_SYNC_API int zune_mtp_set_object_references(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         mtp::msg::ObjectHandles handles;
@@ -1041,6 +1895,7 @@ XUNE_SYNC_API int zune_mtp_get_object_references(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         auto handles = session->GetObjectReferences(mtp::ObjectId(object_id));
@@ -1070,6 +1925,7 @@ XUNE_SYNC_API int zune_mtp_update_track_properties(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         zune::TrackProperties tp;
@@ -1085,6 +1941,8 @@ XUNE_SYNC_API int zune_mtp_update_track_properties(
         tp.is_hd         = props->is_hd;
 
         zune::MtpWriter::UpdateTrackProperties(session, track_mtp_id, tp);
+        device->GetLibraryModel().TrackPropertiesUpdated(track_mtp_id, tp);
+        device->InvalidateLibrarySnapshot();
         return 0;
 
     } catch (const mtp::InvalidResponseException& e) {
@@ -1104,6 +1962,7 @@ XUNE_SYNC_API int zune_mtp_update_album_properties(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         zune::AlbumProperties ap;
@@ -1114,6 +1973,8 @@ XUNE_SYNC_API int zune_mtp_update_album_properties(
         ap.is_hd         = props->is_hd;
 
         zune::MtpWriter::UpdateAlbumProperties(session, album_mtp_id, ap);
+        device->GetLibraryModel().AlbumPropertiesUpdated(album_mtp_id, ap);
+        device->InvalidateLibrarySnapshot();
         return 0;
 
     } catch (const mtp::InvalidResponseException& e) {
@@ -1134,12 +1995,14 @@ XUNE_SYNC_API int zune_mtp_set_object_property_string(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         session->SetObjectProperty(
             mtp::ObjectId(object_id),
             static_cast<mtp::ObjectProperty>(property_code),
             std::string(value ? value : ""));
+        device->InvalidateLibrarySnapshot();
 
         return 0;
 
@@ -1161,12 +2024,14 @@ XUNE_SYNC_API int zune_mtp_set_object_property_int(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         session->SetObjectProperty(
             mtp::ObjectId(object_id),
             static_cast<mtp::ObjectProperty>(property_code),
             value);
+        device->InvalidateLibrarySnapshot();
 
         return 0;
 
@@ -1189,6 +2054,7 @@ XUNE_SYNC_API int zune_mtp_set_object_property_array(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         mtp::ByteArray bytes;
@@ -1201,6 +2067,7 @@ XUNE_SYNC_API int zune_mtp_set_object_property_array(
             mtp::ObjectId(object_id),
             static_cast<mtp::ObjectProperty>(property_code),
             bytes);
+        device->InvalidateLibrarySnapshot();
 
         return 0;
 
@@ -1225,6 +2092,7 @@ XUNE_SYNC_API int zune_mtp_get_object_handles(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         mtp::StorageId mtpStorage(storage_id ? storage_id : device->GetDefaultStorageId());
@@ -1259,12 +2127,14 @@ XUNE_SYNC_API uint32_t zune_mtp_create_directory(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return 0;
 
         mtp::StorageId mtpStorage(storage_id ? storage_id : device->GetDefaultStorageId());
         mtp::ObjectId mtpParent = (parent_id == 0) ? mtp::Session::Root : mtp::ObjectId(parent_id);
 
         auto info = session->CreateDirectory(std::string(name), mtpParent, mtpStorage);
+        if (auto* folders = device->GetFolderCache()) folders->FolderCreated(parent_id, name, info.ObjectId.Id);
         return info.ObjectId.Id;
 
     } catch (const std::exception& e) {
@@ -1282,6 +2152,7 @@ XUNE_SYNC_API int zune_mtp_get_storage_ids(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         auto storages = session->GetStorageIDs();
@@ -1322,9 +2193,13 @@ XUNE_SYNC_API int zune_mtp_delete_object(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         session->DeleteObject(mtp::ObjectId(object_id));
+        device->GetLibraryModel().ObjectDeleted(object_id);
+        if (auto* folders = device->GetFolderCache()) folders->ObjectDeleted(object_id);
+        if (auto* index = device->GetContentIndex()) index->Remove(object_id);
         return 0;
 
     } catch (const std::exception& e) {
@@ -1343,6 +2218,7 @@ XUNE_SYNC_API int zune_mtp_operation_9217(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         // Use the Session's proper Operation9217 method which passes param
@@ -1365,6 +2241,7 @@ XUNE_SYNC_API int zune_mtp_operation_922a(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         // Use the Session's proper Operation922a method which builds the correct
@@ -1388,6 +2265,7 @@ XUNE_SYNC_API int zune_mtp_operation_9802(
     try {
         auto* device = static_cast<ZuneDevice*>(handle);
         auto session = device->GetMtpSession();
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
         if (!session) return -2;
 
         // Use the Session's proper Operation9802 method which passes params
@@ -1406,17 +2284,32 @@ XUNE_SYNC_API int zune_mtp_operation_9802(
 // ═══════════════════════════════════════════════════════════════════════════
 
 // Helper: get session + determine if HD
-#define UPLOAD_SESSION_GUARD(handle) \
+// The guards also take the session from the device's MTP scheduler for the
+// rest of the call; UPLOAD_SESSION_CHECK leaves scheduling to the callee.
+#define UPLOAD_SESSION_CHECK(handle) \
     if (!handle) return -1; \
     auto* _device = static_cast<ZuneDevice*>(handle); \
     auto _session = _device->GetMtpSession(); \
     if (!_session) return -2;
 
+#define UPLOAD_SESSION_GUARD_CLASS(handle, op_class) \
+    UPLOAD_SESSION_CHECK(handle) \
+    auto _grant = _device->GetMtpScheduler().Acquire(op_class);
+
+#define UPLOAD_SESSION_GUARD(handle) UPLOAD_SESSION_GUARD_CLASS(handle, ZUNE_MTP_CLASS_CONTROL)
+
 #define UPLOAD_SESSION_GUARD_VAL(handle, fail_val) \
     if (!handle) return fail_val; \
     auto* _device = static_cast<ZuneDevice*>(handle); \
     auto _session = _device->GetMtpSession(); \
-    if (!_session) return fail_val;
+    if (!_session) return fail_val; \
+    auto _grant = _device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
+
+// An object other than a folder was created in folder: its cached listing
+// no longer holds every child
+static void InvalidateFolderListing(ZuneDevice* device, uint32_t folder) {
+    if (auto* folders = device->GetFolderCache()) folders->Invalidate(folder);
+}
 
 // --- Pre-Upload ---
 
@@ -1425,9 +2318,11 @@ XUNE_SYNC_API ZuneRootDiscovery zune_upload_discover_root(zune_device_handle_t h
     if (!handle) return result;
     auto* device = static_cast<ZuneDevice*>(handle);
     auto session = device->GetMtpSession();
+    auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!session) return result;
     try {
-        auto r = zune::MtpWriter::DiscoverRoot(session, device->GetDefaultStorageId(), is_hd != 0);
+        auto r = zune::MtpWriter::DiscoverRoot(
+            session, device->GetDefaultStorageId(), is_hd != 0, device->GetFolderCache());
         result.music_folder = r.music_folder;
         result.albums_folder = r.albums_folder;
         result.artists_folder = r.artists_folder;
@@ -1455,10 +2350,11 @@ XUNE_SYNC_API ZuneFolderDiscovery zune_upload_discover_folder(
     if (!handle) return result;
     auto* device = static_cast<ZuneDevice*>(handle);
     auto session = device->GetMtpSession();
+    auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_CONTROL);
     if (!session) return result;
     try {
         auto children = zune::MtpWriter::DiscoverFolderChildren(
-            session, device->GetDefaultStorageId(), folder_id);
+            session, device->GetDefaultStorageId(), folder_id, device->GetFolderCache());
         result.count = std::min(static_cast<int>(children.size()), 64);
         for (int i = 0; i < result.count; ++i) {
             result.children[i].handle = children[i].handle;
@@ -1475,7 +2371,8 @@ XUNE_SYNC_API uint32_t zune_upload_create_folder(
     UPLOAD_SESSION_GUARD_VAL(handle, 0);
     try {
         return zune::MtpWriter::CreateFolder(
-            _session, _device->GetDefaultStorageId(), parent_id, name ? name : "");
+            _session, _device->GetDefaultStorageId(), parent_id, name ? name : "",
+            _device->GetFolderCache());
     } catch (...) { return 0; }
 }
 
@@ -1485,7 +2382,7 @@ XUNE_SYNC_API int zune_upload_folder_readback(
     UPLOAD_SESSION_GUARD(handle);
     try {
         zune::MtpWriter::FolderReadback(
-            _session, folder_id, _device->GetDefaultStorageId());
+            _session, folder_id, _device->GetDefaultStorageId(), _device->GetFolderCache());
         return 0;
     } catch (...) { return -1; }
 }
@@ -1497,7 +2394,8 @@ XUNE_SYNC_API int zune_upload_first_folder_readback(
     bool isHD = (_device->GetDeviceFamily() == zune::DeviceFamily::Pavo);
     try {
         zune::MtpWriter::FirstFolderReadback(
-            _session, folder_id, _device->GetDefaultStorageId(), isHD);
+            _session, folder_id, _device->GetDefaultStorageId(), isHD,
+            _device->GetDescriptorCache(), _device->GetFolderCache());
         return 0;
     } catch (...) { return -1; }
 }
@@ -1510,14 +2408,42 @@ XUNE_SYNC_API uint32_t zune_upload_create_artist_metadata(
 {
     UPLOAD_SESSION_GUARD_VAL(handle, 0);
     try {
-        return zune::MtpWriter::CreateArtistMetadata(
+        std::string artist_name = name ? name : "";
+        uint32_t artist_id = zune::MtpWriter::CreateArtistMetadata(
             _session, _device->GetDefaultStorageId(), artists_folder,
-            name ? name : "", guid_bytes, guid_len);
+            artist_name, guid_bytes, guid_len);
+        if (artist_id != 0) {
+            std::string guid = guid_bytes
+                ? zmdb::parse_windows_guid(zmdb::ByteView(guid_bytes, guid_len))
+                : "";
+            _device->GetLibraryModel().ArtistCreated(artist_id, artist_name, guid);
+            InvalidateFolderListing(_device, artists_folder);
+        }
+        return artist_id;
     } catch (...) { return 0; }
 }
 
 // --- Track Operations ---
 
+static zune::TrackProperties ToTrackProperties(const ZuneTrackProps& props) {
+    zune::TrackProperties tp;
+    tp.filename = props.filename ? props.filename : "";
+    tp.title = props.title ? props.title : "";
+    tp.artist = props.artist ? props.artist : "";
+    tp.album_name = props.album_name ? props.album_name : "";
+    tp.album_artist = props.album_artist ? props.album_artist : "";
+    tp.genre = props.genre ? props.genre : "";
+    tp.date_authored = props.date_authored ? props.date_authored : "";
+    tp.duration_ms = props.duration_ms;
+    tp.track_number = props.track_number;
+    tp.rating = props.rating;
+    tp.play_count = props.play_count;
+    tp.disc_number = props.disc_number;
+    tp.artist_meta_id = props.artist_meta_id;
+    tp.is_hd = props.is_hd;
+    return tp;
+}
+
 XUNE_SYNC_API uint32_t zune_upload_create_track(
     zune_device_handle_t handle, uint32_t album_folder,
     const ZuneTrackProps* props, uint16_t format_code, uint64_t file_size,
@@ -1527,49 +2453,404 @@ XUNE_SYNC_API uint32_t zune_upload_create_track(
     if (out_mtp_error) *out_mtp_error = 0;
     if (!props) return 0;
     try {
-        zune::TrackProperties tp;
-        tp.filename = props->filename ? props->filename : "";
-        tp.title = props->title ? props->title : "";
-        tp.artist = props->artist ? props->artist : "";
-        tp.album_name = props->album_name ? props->album_name : "";
-        tp.album_artist = props->album_artist ? props->album_artist : "";
-        tp.genre = props->genre ? props->genre : "";
-        tp.date_authored = props->date_authored ? props->date_authored : "";
-        tp.duration_ms = props->duration_ms;
-        tp.track_number = props->track_number;
-        tp.rating = props->rating;
-        tp.play_count = props->play_count;
-        tp.disc_number = props->disc_number;
-        tp.artist_meta_id = props->artist_meta_id;
-        tp.is_hd = props->is_hd;
-        return zune::MtpWriter::CreateTrack(
-            _session, _device->GetDefaultStorageId(), album_folder,
-            tp, format_code, file_size);
+        zune::TrackProperties tp = ToTrackProperties(*props);
+        mtp::ByteArray propList = zune::MtpWriter::BuildTrackPropList(tp);
+        uint32_t track_id = zune::TransferStats::Measure(
+            &_device->GetTransferStats(), ZUNE_TRANSFER_OP_SEND_OBJECT_PROP_LIST, propList.size(), [&] {
+                return zune::MtpWriter::SendTrackPropList(
+                    _session, _device->GetDefaultStorageId(), album_folder,
+                    propList, format_code, file_size);
+            });
+        if (track_id != 0) {
+            _device->GetLibraryModel().TrackCreated(track_id, tp, format_code, file_size);
+            if (auto* journal = _device->GetSyncJournal()) journal->RecordCreated(track_id, file_size);
+            if (auto* index = _device->GetContentIndex()) index->SetPendingObject(track_id);
+            InvalidateFolderListing(_device, album_folder);
+            if (_device->GetUploadVerifyPolicy() != ZUNE_UPLOAD_VERIFY_PER_OBJECT)
+                _device->GetUploadVerifier().Expect(track_id, album_folder, file_size);
+        }
+        return track_id;
     } catch (const mtp::InvalidResponseException& ex) {
         if (out_mtp_error) *out_mtp_error = static_cast<uint16_t>(ex.Type);
         return 0;
     } catch (...) { return 0; }
 }
 
-XUNE_SYNC_API int zune_upload_send_audio(
-    zune_device_handle_t handle, const char* file_path)
+// SendObject for the track just created, then journal and index it
+static int SendAudio(ZuneDevice* device, const mtp::SessionPtr& session, const char* file_path,
+                     const std::function<void(uint64_t, uint64_t)>& progress = nullptr)
 {
-    UPLOAD_SESSION_GUARD(handle);
-    if (!file_path) return -1;
     try {
-        zune::MtpWriter::UploadAudioData(_session, file_path);
+        zune::MtpWriter::UploadAudioData(session, file_path, &device->GetTransferStats(), progress);
+        if (auto* journal = device->GetSyncJournal()) journal->RecordCommitted(journal->PendingObject(), file_path);
+        if (auto* index = device->GetContentIndex()) {
+            zune::ContentFingerprint fingerprint;
+            if (zune::ContentFingerprint::FromFile(file_path, fingerprint))
+                index->Record(fingerprint, index->PendingObject());
+            index->SetPendingObject(0);
+        }
         return 0;
     } catch (...) { return -1; }
 }
 
+XUNE_SYNC_API int zune_upload_send_audio(
+    zune_device_handle_t handle, const char* file_path)
+{
+    UPLOAD_SESSION_GUARD_CLASS(handle, ZUNE_MTP_CLASS_BULK);
+    if (!file_path) return -1;
+    return SendAudio(_device, _session, file_path);
+}
+
+XUNE_SYNC_API void zune_device_set_upload_verify_policy(
+    zune_device_handle_t handle, ZuneUploadVerifyPolicy policy)
+{
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetUploadVerifyPolicy(policy);
+}
+
 XUNE_SYNC_API int zune_upload_verify_track(
     zune_device_handle_t handle, uint32_t track_id)
 {
     UPLOAD_SESSION_GUARD(handle);
-    try { zune::MtpWriter::VerifyTrack(_session, track_id); return 0; }
+    if (_device->GetUploadVerifyPolicy() != ZUNE_UPLOAD_VERIFY_PER_OBJECT) return 0;
+    try {
+        zune::TransferStats::Measure(&_device->GetTransferStats(), ZUNE_TRANSFER_OP_GET_OBJECT_PROP_LIST, 0,
+                                     [&] { zune::MtpWriter::VerifyTrack(_session, track_id); });
+        return 0;
+    }
     catch (...) { return -1; }
 }
 
+// Settle the device's expected uploads under parent (0 = all) with one
+// ObjectSize list; unconfirmed count, or -1 if the list could not be read
+static int CheckExpectedUploads(ZuneDevice* device, const mtp::SessionPtr& session, uint32_t parent) {
+    auto& verifier = device->GetUploadVerifier();
+    std::unordered_map<uint32_t, uint64_t> sizes;
+    bool listed = zune::TransferStats::Measure(&device->GetTransferStats(), ZUNE_TRANSFER_OP_GET_OBJECT_PROP_LIST, 0,
+                                               [&] { return zune::MtpReader::GetObjectSizes(session, sizes, parent); });
+    if (!listed) return -1;
+    return static_cast<int>(verifier.Check(sizes, parent).size());
+}
+
+XUNE_SYNC_API int zune_upload_verify_session(zune_device_handle_t handle)
+{
+    UPLOAD_SESSION_GUARD(handle);
+    if (_device->GetUploadVerifier().Pending() == 0) return 0;
+    return CheckExpectedUploads(_device, _session, 0);
+}
+
+// --- Batch Track Upload ---
+
+// Run batch through the upload engine. index_map (optional) translates the
+// engine's item index to the one reported to the callbacks.
+static int RunUploadBatch(
+    ZuneDevice* device, const mtp::SessionPtr& session,
+    const std::vector<zune::UploadItem>& batch, bool is_hd,
+    const std::vector<uint32_t>* index_map,
+    zune_upload_progress_callback_t progress_callback,
+    zune_upload_result_callback_t result_callback, void* user_data)
+{
+    auto report_index = [&](size_t index) {
+        return index_map ? (*index_map)[index] : static_cast<uint32_t>(index);
+    };
+
+    zune::UploadEngineOptions options;
+    options.is_hd = is_hd;
+    options.stats = &device->GetTransferStats();
+    options.journal = device->GetSyncJournal();
+    options.content_index = device->GetContentIndex();
+    options.scheduler = &device->GetMtpScheduler();
+    options.verify_policy = device->GetUploadVerifyPolicy();
+    zune::UploadEngine engine(session, device->GetDefaultStorageId(), options);
+
+    zune::UploadEngine::ProgressCallback on_progress;
+    if (progress_callback) {
+        on_progress = [&](size_t index, uint64_t sent, uint64_t total) {
+            progress_callback(report_index(index), sent, total, user_data);
+        };
+    }
+
+    int uploaded = 0;
+    auto on_result = [&](const zune::UploadItemResult& r) {
+        if (r.status == ZUNE_UPLOAD_OK) {
+            device->GetLibraryModel().TrackCreated(r.track_id, r.properties, r.format_code, r.file_size);
+            InvalidateFolderListing(device, batch[r.index].album_folder);
+            if (options.verify_policy == ZUNE_UPLOAD_VERIFY_DEFERRED)
+                device->GetUploadVerifier().Expect(r.track_id, batch[r.index].album_folder, r.file_size);
+            uploaded++;
+        }
+        if (!result_callback) return true;
+        ZuneUploadItemResult out = {};
+        out.index = report_index(r.index);
+        out.track_id = r.track_id;
+        out.status = r.status;
+        out.mtp_error = r.mtp_error;
+        out.format_code = r.format_code;
+        out.file_size = r.file_size;
+        return result_callback(&out, user_data);
+    };
+
+    try {
+        engine.Run(batch, on_progress, on_result);
+    } catch (...) {
+        if (options.content_index) options.content_index->Save();
+        return -1;
+    }
+    if (options.content_index) options.content_index->Save();
+    return uploaded;
+}
+
+XUNE_SYNC_API int zune_upload_tracks(
+    zune_device_handle_t handle, const ZuneUploadItem* items, uint32_t count,
+    uint8_t is_hd, zune_upload_progress_callback_t progress_callback,
+    zune_upload_result_callback_t result_callback, void* user_data)
+{
+    UPLOAD_SESSION_CHECK(handle);
+    if (!items && count > 0) return -1;
+
+    std::vector<zune::UploadItem> batch(count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (!items[i].file_path) return -1;
+        batch[i].file_path = items[i].file_path;
+        batch[i].album_folder = items[i].album_folder;
+        batch[i].artist_meta_id = items[i].artist_meta_id;
+        if (items[i].props) {
+            batch[i].has_properties = true;
+            batch[i].properties = ToTrackProperties(*items[i].props);
+        }
+    }
+
+    return RunUploadBatch(_device, _session, batch, is_hd != 0, nullptr,
+                          progress_callback, result_callback, user_data);
+}
+
+// --- Sync Planning ---
+
+namespace {
+
+// The C view followed by the arrays it points into
+struct SyncPlanHandle : ZuneSyncPlan {
+    zune::SyncPlan plan;
+};
+
+ZuneSyncPlan* CreateSyncPlan(
+    const ZuneMusicLibrary* library,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const ZuneHostPlaylist* playlists, uint32_t playlist_count,
+    const ZuneSyncPlanOptions* options, const zune::SyncResume* resume,
+    const zune::ContentIndex* content)
+{
+    if (!library || (track_count > 0 && !tracks) || (playlist_count > 0 && !playlists)) {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < playlist_count; i++) {
+        if (playlists[i].track_count > 0 && !playlists[i].track_indices) return nullptr;
+    }
+
+    try {
+        auto* handle = new SyncPlanHandle();
+        handle->plan = zune::PlanSync(*library, tracks, track_count, playlists, playlist_count,
+                                      options ? *options : zune::DefaultSyncPlanOptions(), resume, content);
+        const zune::SyncPlan& plan = handle->plan;
+        handle->ops = plan.ops.data();
+        handle->op_count = static_cast<uint32_t>(plan.ops.size());
+        handle->groups = plan.groups.data();
+        handle->group_count = static_cast<uint32_t>(plan.groups.size());
+        handle->host_matches = plan.host_matches.data();
+        handle->host_track_count = static_cast<uint32_t>(plan.host_matches.size());
+        handle->add_count = plan.add_count;
+        handle->update_count = plan.update_count;
+        handle->delete_count = plan.delete_count;
+        handle->playlist_op_count = plan.playlist_op_count;
+        handle->resumed_count = plan.resumed_count;
+        handle->identified_count = plan.identified_count;
+        return handle;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+} // namespace
+
+XUNE_SYNC_API ZuneSyncPlan* zune_sync_plan_create(
+    const ZuneMusicLibrary* library,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const ZuneHostPlaylist* playlists, uint32_t playlist_count,
+    const ZuneSyncPlanOptions* options)
+{
+    return CreateSyncPlan(library, tracks, track_count, playlists, playlist_count, options, nullptr, nullptr);
+}
+
+XUNE_SYNC_API ZuneSyncPlan* zune_sync_plan_create_resumed(
+    zune_device_handle_t handle, const ZuneMusicLibrary* library,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const ZuneHostPlaylist* playlists, uint32_t playlist_count,
+    const ZuneSyncPlanOptions* options)
+{
+    if (!handle) return nullptr;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    zune::SyncResume resume;
+    try {
+        device->ResumeSyncJournal(resume);
+    } catch (...) {
+        resume = zune::SyncResume{};
+    }
+    return CreateSyncPlan(library, tracks, track_count, playlists, playlist_count, options, &resume,
+                          device->GetContentIndex());
+}
+
+XUNE_SYNC_API void zune_sync_plan_free(ZuneSyncPlan* plan) {
+    delete static_cast<SyncPlanHandle*>(plan);
+}
+
+XUNE_SYNC_API void zune_device_set_sync_journal_dir(
+    zune_device_handle_t handle, const char* directory)
+{
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetSyncJournalDirectory(directory ? directory : "");
+}
+
+XUNE_SYNC_API void zune_device_clear_sync_journal(zune_device_handle_t handle) {
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->ClearSyncJournal();
+}
+
+XUNE_SYNC_API void zune_device_set_content_index_dir(
+    zune_device_handle_t handle, const char* directory)
+{
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetContentIndexDirectory(directory ? directory : "");
+}
+
+XUNE_SYNC_API int zune_sync_plan_upload(
+    zune_device_handle_t handle, const ZuneSyncPlan* plan,
+    const ZuneHostTrack* tracks, uint32_t track_count,
+    const uint32_t* group_folders, const uint32_t* group_artist_meta_ids,
+    zune_upload_progress_callback_t progress_callback,
+    zune_upload_result_callback_t result_callback, void* user_data)
+{
+    UPLOAD_SESSION_CHECK(handle);
+    if (!plan || (plan->group_count > 0 && !group_folders) || (track_count > 0 && !tracks)) return -1;
+    bool is_hd = (_device->GetDeviceFamily() == zune::DeviceFamily::Pavo);
+
+    std::vector<zune::UploadItem> batch;
+    std::vector<uint32_t> host_index;
+    batch.reserve(plan->add_count);
+    host_index.reserve(plan->add_count);
+    for (uint32_t i = 0; i < plan->op_count; i++) {
+        const ZuneSyncOp& op = plan->ops[i];
+        if (op.type != ZUNE_SYNC_OP_ADD_TRACK) continue;
+        if (op.host_index >= track_count || op.group >= plan->group_count ||
+            !tracks[op.host_index].file_path) return -1;
+
+        const ZuneHostTrack& host = tracks[op.host_index];
+        zune::UploadItem item;
+        item.file_path = host.file_path;
+        item.album_folder = group_folders[op.group];
+        item.has_properties = true;
+        zune::TrackProperties& tp = item.properties;
+        tp.title = host.title ? host.title : "";
+        tp.artist = host.artist ? host.artist : "";
+        tp.album_name = host.album ? host.album : "";
+        tp.album_artist = host.album_artist && *host.album_artist ? host.album_artist : tp.artist;
+        tp.genre = host.genre ? host.genre : "";
+        tp.date_authored = host.date_authored ? host.date_authored : "";
+        tp.duration_ms = host.duration_ms;
+        tp.track_number = static_cast<uint16_t>(host.track_number);
+        tp.disc_number = host.disc_number;
+        tp.artist_meta_id = group_artist_meta_ids ? group_artist_meta_ids[op.group] : 0;
+        tp.is_hd = is_hd;
+        batch.push_back(std::move(item));
+        host_index.push_back(op.host_index);
+    }
+
+    return RunUploadBatch(_device, _session, batch, is_hd, &host_index,
+                          progress_callback, result_callback, user_data);
+}
+
+// --- Host Collection Scanning ---
+
+namespace {
+
+// The C view followed by the tracks its strings point into
+struct MediaScanHandle : ZuneMediaScan {
+    std::vector<zune::ScannedTrack> scanned;
+    std::vector<ZuneHostTrack> host;
+    std::vector<ZuneMediaTrackInfo> extra;
+};
+
+} // namespace
+
+XUNE_SYNC_API ZuneMediaScan* zune_media_scan(const char* root, const ZuneMediaScanOptions* options) {
+    if (!root || !*root) return nullptr;
+    try {
+        zune::MediaScanner::Options scan_options;
+        if (options) {
+            if (options->worker_threads > 0) scan_options.worker_threads = options->worker_threads;
+            scan_options.read_artwork = options->read_artwork;
+        }
+        zune::MediaScanner scanner(scan_options);
+        if (options && options->cache_path && *options->cache_path)
+            scanner.OpenCache(options->cache_path);
+
+        auto* handle = new MediaScanHandle();
+        handle->scanned = scanner.Scan(root);
+        const size_t count = handle->scanned.size();
+        handle->host.resize(count);
+        handle->extra.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const zune::ScannedTrack& t = handle->scanned[i];
+            ZuneHostTrack& h = handle->host[i];
+            h.file_path = t.path.c_str();
+            h.title = t.track.title.c_str();
+            h.artist = t.track.artist.c_str();
+            h.album = t.track.album_name.c_str();
+            h.album_artist = t.track.album_artist.c_str();
+            h.genre = t.track.genre.c_str();
+            h.date_authored = t.track.date_authored.c_str();
+            h.track_number = t.track.track_number;
+            h.disc_number = t.track.disc_number;
+            h.duration_ms = t.track.duration_ms;
+            h.file_size = t.file_size;
+
+            ZuneMediaTrackInfo& e = handle->extra[i];
+            e.rating = t.track.rating;
+            e.year = t.year;
+            e.artist_guid = t.artist_guid.c_str();
+            e.artwork_size = t.artwork_size;
+            e.modified_time = t.mtime;
+            e.tagged = t.tagged;
+        }
+
+        zune::MediaScanner::Stats stats = scanner.GetStats();
+        handle->tracks = handle->host.data();
+        handle->info = handle->extra.data();
+        handle->track_count = static_cast<uint32_t>(count);
+        handle->cache_hits = static_cast<uint32_t>(stats.cache_hits);
+        handle->parsed = static_cast<uint32_t>(stats.parsed);
+        handle->failed = static_cast<uint32_t>(stats.failed);
+        return handle;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+XUNE_SYNC_API void zune_media_scan_free(ZuneMediaScan* scan) {
+    delete static_cast<MediaScanHandle*>(scan);
+}
+
+XUNE_SYNC_API int64_t zune_media_read_artwork(const char* file_path, uint8_t* buffer, uint32_t capacity) {
+    if (!file_path || (capacity > 0 && !buffer)) return -1;
+    try {
+        std::vector<uint8_t> artwork = zune::MediaScanner::ExtractArtwork(file_path);
+        if (!artwork.empty() && artwork.size() <= capacity)
+            std::memcpy(buffer, artwork.data(), artwork.size());
+        return static_cast<int64_t>(artwork.size());
+    } catch (...) {
+        return -1;
+    }
+}
+
 // --- Album Metadata ---
 
 XUNE_SYNC_API uint32_t zune_upload_create_album(
@@ -1585,11 +2866,42 @@ XUNE_SYNC_API uint32_t zune_upload_create_album(
         ap.date_authored = props->date_authored ? props->date_authored : "";
         ap.artist_meta_id = props->artist_meta_id;
         ap.is_hd = props->is_hd;
-        return zune::MtpWriter::CreateAlbumMetadata(
+        uint32_t album_id = zune::MtpWriter::CreateAlbumMetadata(
             _session, _device->GetDefaultStorageId(), albums_folder, ap);
+        if (album_id != 0) {
+            _device->GetLibraryModel().AlbumCreated(album_id, ap);
+            InvalidateFolderListing(_device, albums_folder);
+        }
+        return album_id;
     } catch (...) { return 0; }
 }
 
+// Album or series artwork, through the device's artwork pipeline when enabled
+static int SendArtwork(
+    ZuneDevice* device, const mtp::SessionPtr& session, uint32_t object_id,
+    const uint8_t* data, uint32_t size,
+    void (*set)(const zune::MtpWriter::SessionPtr&, uint32_t, const uint8_t*, size_t))
+{
+    zune::ArtworkPipeline* pipeline = device->GetArtworkPipeline();
+    if (!pipeline) {
+        set(session, object_id, data, size);
+        return 0;
+    }
+
+    zune::ArtworkPipeline::Prepared prepared = pipeline->Prepare(data, size);
+    if (!pipeline->ShouldSend(object_id, prepared.key)) return 0;
+    try {
+        if (prepared.data)
+            set(session, object_id, prepared.data->data(), prepared.data->size());
+        else
+            set(session, object_id, data, size);
+    } catch (...) {
+        pipeline->ForgetSend(object_id);
+        throw;
+    }
+    return 0;
+}
+
 XUNE_SYNC_API int zune_upload_set_artwork(
     zune_device_handle_t handle, uint32_t album_id,
     const uint8_t* data, uint32_t size)
@@ -1597,8 +2909,7 @@ XUNE_SYNC_API int zune_upload_set_artwork(
     UPLOAD_SESSION_GUARD(handle);
     if (!data || size == 0) return 0;
     try {
-        zune::MtpWriter::SetAlbumArtwork(_session, album_id, data, size);
-        return 0;
+        return SendArtwork(_device, _session, album_id, data, size, &zune::MtpWriter::SetAlbumArtwork);
     } catch (...) { return -1; }
 }
 
@@ -1610,6 +2921,8 @@ XUNE_SYNC_API int zune_upload_set_album_refs(
     if (!track_ids || count == 0) return 0;
     try {
         zune::MtpWriter::SetAlbumReferences(_session, album_id, track_ids, count);
+        _device->GetLibraryModel().AlbumReferencesSet(album_id, track_ids, count);
+        _device->InvalidateLibrarySnapshot();
         return 0;
     } catch (...) { return -1; }
 }
@@ -1618,6 +2931,20 @@ XUNE_SYNC_API int zune_upload_verify_album(
     zune_device_handle_t handle, uint32_t album_id, bool include_parent_desc)
 {
     UPLOAD_SESSION_GUARD(handle);
+    switch (_device->GetUploadVerifyPolicy()) {
+    case ZUNE_UPLOAD_VERIFY_DEFERRED:
+        return 0;
+    case ZUNE_UPLOAD_VERIFY_BATCHED: {
+        // Normally one folder: the album's tracks
+        int result = 0;
+        for (uint32_t folder : _device->GetUploadVerifier().Folders()) {
+            if (CheckExpectedUploads(_device, _session, folder) != 0) result = -1;
+        }
+        return result;
+    }
+    default:
+        break;
+    }
     try {
         zune::MtpWriter::VerifyAlbum(_session, album_id, include_parent_desc);
         return 0;
@@ -1636,6 +2963,103 @@ XUNE_SYNC_API int zune_upload_read_album_subset(
     } catch (...) { return -1; }
 }
 
+// --- Command Buffers ---
+
+// Handle for a command argument: a literal, or an earlier command's result.
+// False for a reference forward, out of range, or to a command without one.
+static bool ResolveCommandHandle(
+    uint32_t literal, uint32_t from, uint32_t index,
+    const ZuneCommandResult* results, uint32_t& handle)
+{
+    if (from == 0) {
+        handle = literal;
+        return true;
+    }
+    if (from > index) return false;
+    const ZuneCommandResult& earlier = results[from - 1];
+    if (earlier.status != ZUNE_CMD_OK || earlier.handle == 0) return false;
+    handle = earlier.handle;
+    return true;
+}
+
+static int32_t RunCommand(
+    zune_device_handle_t handle, const ZuneCommand& cmd, uint32_t index,
+    ZuneCommandResult* results)
+{
+    ZuneCommandResult& result = results[index];
+    uint32_t object = 0;
+    if (!ResolveCommandHandle(cmd.object, cmd.object_from, index, results, object))
+        return ZUNE_CMD_BAD_ARGUMENT;
+
+    switch (cmd.type) {
+    case ZUNE_CMD_CREATE_FOLDER:
+        result.handle = zune_upload_create_folder(handle, object, cmd.text);
+        return result.handle ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_FOLDER_READBACK:
+        return zune_upload_folder_readback(handle, object) == 0 ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_ROOT_RE_ENUM:
+        return zune_upload_root_re_enum(handle) == 0 ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_CREATE_TRACK:
+        if (!cmd.track) return ZUNE_CMD_BAD_ARGUMENT;
+        result.handle = zune_upload_create_track(
+            handle, object, cmd.track, cmd.format_code, cmd.file_size, &result.mtp_error);
+        return result.handle ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_SEND_AUDIO:
+        if (!cmd.text) return ZUNE_CMD_BAD_ARGUMENT;
+        return zune_upload_send_audio(handle, cmd.text) == 0 ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_VERIFY_TRACK:
+        return zune_upload_verify_track(handle, object) == 0 ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_CREATE_ALBUM:
+        if (!cmd.album) return ZUNE_CMD_BAD_ARGUMENT;
+        result.handle = zune_upload_create_album(handle, object, cmd.album);
+        return result.handle ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_SET_ARTWORK:
+        return zune_upload_set_artwork(handle, object, cmd.data, cmd.size) == 0 ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    case ZUNE_CMD_SET_ALBUM_REFS: {
+        if (cmd.ref_count > 0 && !cmd.refs && !cmd.refs_from) return ZUNE_CMD_BAD_ARGUMENT;
+        std::vector<uint32_t> tracks(cmd.ref_count);
+        for (uint32_t i = 0; i < cmd.ref_count; i++) {
+            uint32_t literal = cmd.refs ? cmd.refs[i] : 0;
+            uint32_t from = cmd.refs_from ? cmd.refs_from[i] : 0;
+            if (!ResolveCommandHandle(literal, from, index, results, tracks[i]))
+                return ZUNE_CMD_BAD_ARGUMENT;
+        }
+        return zune_upload_set_album_refs(handle, object, tracks.data(), cmd.ref_count) == 0
+            ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    }
+    case ZUNE_CMD_VERIFY_ALBUM:
+        return zune_upload_verify_album(handle, object, cmd.flag) == 0 ? ZUNE_CMD_OK : ZUNE_CMD_FAILED;
+    }
+    return ZUNE_CMD_BAD_ARGUMENT;
+}
+
+XUNE_SYNC_API int32_t zune_upload_execute(
+    zune_device_handle_t handle, const ZuneCommand* commands, uint32_t count,
+    ZuneCommandResult* results, uint32_t flags)
+{
+    if (!handle || (count > 0 && (!commands || !results))) return -1;
+    if (!static_cast<ZuneDevice*>(handle)->GetMtpSession()) return -1;
+
+    // Each command takes its own scheduler grant, as the separate calls
+    // did, so network polling still runs between the steps of an album
+    int32_t succeeded = 0;
+    bool stopped = false;
+    for (uint32_t i = 0; i < count; i++) {
+        results[i] = ZuneCommandResult{};
+        if (stopped) {
+            results[i].status = ZUNE_CMD_NOT_RUN;
+            continue;
+        }
+        results[i].status = RunCommand(handle, commands[i], i, results);
+        if (results[i].status == ZUNE_CMD_OK) {
+            succeeded++;
+        } else if (flags & ZUNE_CMD_STOP_ON_ERROR) {
+            stopped = true;
+        }
+    }
+    return succeeded;
+}
+
 // --- Podcast Series ---
 
 XUNE_SYNC_API uint32_t zune_upload_create_podcast_series(
@@ -1650,8 +3074,10 @@ XUNE_SYNC_API uint32_t zune_upload_create_podcast_series(
         sp.artist = props->artist ? props->artist : "";
         sp.feed_url = props->feed_url ? props->feed_url : "";
         sp.filename = props->filename ? props->filename : "";
-        return zune::MtpWriter::CreatePodcastSeries(
+        uint32_t series_id = zune::MtpWriter::CreatePodcastSeries(
             _session, _device->GetDefaultStorageId(), series_folder, sp);
+        if (series_id != 0) InvalidateFolderListing(_device, series_folder);
+        return series_id;
     } catch (...) { return 0; }
 }
 
@@ -1676,8 +3102,10 @@ XUNE_SYNC_API uint32_t zune_upload_create_podcast_episode(
         ep.series_handle = props->series_handle;
         ep.format_code = props->format_code;
         ep.is_video = props->is_video != 0;
-        return zune::MtpWriter::CreatePodcastEpisode(
+        uint32_t episode_id = zune::MtpWriter::CreatePodcastEpisode(
             _session, _device->GetDefaultStorageId(), episode_folder, ep, file_size);
+        if (episode_id != 0) InvalidateFolderListing(_device, episode_folder);
+        return episode_id;
     } catch (const mtp::InvalidResponseException& ex) {
         if (out_mtp_error) *out_mtp_error = static_cast<uint16_t>(ex.Type);
         return 0;
@@ -1691,8 +3119,7 @@ XUNE_SYNC_API int zune_upload_set_series_artwork(
     UPLOAD_SESSION_GUARD(handle);
     if (!data || size == 0) return 0;
     try {
-        zune::MtpWriter::SetSeriesArtwork(_session, series_id, data, size);
-        return 0;
+        return SendArtwork(_device, _session, series_id, data, size, &zune::MtpWriter::SetSeriesArtwork);
     } catch (...) { return -1; }
 }
 
@@ -1706,7 +3133,7 @@ XUNE_SYNC_API int zune_upload_verify_series(
 
 XUNE_SYNC_API int zune_upload_query_series_descs(zune_device_handle_t handle) {
     UPLOAD_SESSION_GUARD(handle);
-    try { zune::MtpWriter::QuerySeriesDescriptors(_session); return 0; }
+    try { zune::MtpWriter::QuerySeriesDescriptors(_session, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
@@ -1714,7 +3141,7 @@ XUNE_SYNC_API int zune_upload_query_episode_descs(
     zune_device_handle_t handle, uint16_t format_code)
 {
     UPLOAD_SESSION_GUARD(handle);
-    try { zune::MtpWriter::QueryEpisodeDescriptors(_session, format_code); return 0; }
+    try { zune::MtpWriter::QueryEpisodeDescriptors(_session, format_code, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
@@ -1735,7 +3162,7 @@ XUNE_SYNC_API int zune_upload_register_track_ctx(
 
 XUNE_SYNC_API int zune_upload_query_folder_descs(zune_device_handle_t handle) {
     UPLOAD_SESSION_GUARD(handle);
-    try { zune::MtpWriter::QueryFolderDescriptors(_session); return 0; }
+    try { zune::MtpWriter::QueryFolderDescriptors(_session, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
@@ -1744,14 +3171,14 @@ XUNE_SYNC_API int zune_upload_query_batch_descs(
 {
     UPLOAD_SESSION_GUARD(handle);
     bool isHD = (_device->GetDeviceFamily() == zune::DeviceFamily::Pavo);
-    try { zune::MtpWriter::QueryBatchDescriptors(_session, prop_code, isHD); return 0; }
+    try { zune::MtpWriter::QueryBatchDescriptors(_session, prop_code, isHD, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
 XUNE_SYNC_API int zune_upload_query_object_format_descs(zune_device_handle_t handle) {
     UPLOAD_SESSION_GUARD(handle);
     bool isHD = (_device->GetDeviceFamily() == zune::DeviceFamily::Pavo);
-    try { zune::MtpWriter::QueryBatchDescriptors(_session, 0xDC02, isHD); return 0; }
+    try { zune::MtpWriter::QueryBatchDescriptors(_session, 0xDC02, isHD, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
@@ -1760,27 +3187,220 @@ XUNE_SYNC_API int zune_upload_query_track_descs(
 {
     UPLOAD_SESSION_GUARD(handle);
     bool isHD = (_device->GetDeviceFamily() == zune::DeviceFamily::Pavo);
-    try { zune::MtpWriter::QueryTrackDescriptors(_session, format_code, isHD); return 0; }
+    try { zune::MtpWriter::QueryTrackDescriptors(_session, format_code, isHD, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
 XUNE_SYNC_API int zune_upload_query_album_descs(zune_device_handle_t handle) {
     UPLOAD_SESSION_GUARD(handle);
     bool isHD = (_device->GetDeviceFamily() == zune::DeviceFamily::Pavo);
-    try { zune::MtpWriter::QueryAlbumDescriptors(_session, isHD); return 0; }
+    try { zune::MtpWriter::QueryAlbumDescriptors(_session, isHD, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
 XUNE_SYNC_API int zune_upload_query_artist_descs(zune_device_handle_t handle) {
     UPLOAD_SESSION_GUARD(handle);
-    try { zune::MtpWriter::QueryArtistDescriptors(_session); return 0; }
+    try { zune::MtpWriter::QueryArtistDescriptors(_session, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
 XUNE_SYNC_API int zune_upload_query_artwork_descs(zune_device_handle_t handle) {
     UPLOAD_SESSION_GUARD(handle);
-    try { zune::MtpWriter::QueryArtworkDescriptors(_session); return 0; }
+    try { zune::MtpWriter::QueryArtworkDescriptors(_session, _device->GetDescriptorCache()); return 0; }
     catch (...) { return -1; }
 }
 
+XUNE_SYNC_API void zune_device_set_descriptor_cache_dir(
+    zune_device_handle_t handle, const char* directory, bool skip_cached)
+{
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetDescriptorCacheDirectory(
+        directory ? directory : "", skip_cached);
+}
+
+XUNE_SYNC_API void zune_device_clear_descriptor_cache(zune_device_handle_t handle) {
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->ClearDescriptorCache();
+}
+
+XUNE_SYNC_API int zune_device_get_descriptor_cache_stats(
+    zune_device_handle_t handle, ZuneDescriptorCacheStats* out)
+{
+    if (!handle || !out) return -1;
+    auto stats = static_cast<ZuneDevice*>(handle)->GetDescriptorCacheStats();
+    out->queries_issued = stats.queries_issued;
+    out->queries_skipped = stats.queries_skipped;
+    out->query_us = stats.query_us;
+    out->saved_us = stats.saved_us;
+    return 0;
+}
+
+XUNE_SYNC_API void zune_device_set_folder_cache(zune_device_handle_t handle, bool enabled) {
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetFolderCacheEnabled(enabled);
+}
+
+XUNE_SYNC_API int zune_device_get_folder_cache_stats(
+    zune_device_handle_t handle, ZuneFolderCacheStats* out)
+{
+    if (!handle || !out) return -1;
+    auto stats = static_cast<ZuneDevice*>(handle)->GetFolderCacheStats();
+    out->hits = stats.hits;
+    out->misses = stats.misses;
+    return 0;
+}
+
+XUNE_SYNC_API void zune_device_set_profile_dir(
+    zune_device_handle_t handle, const char* directory)
+{
+    if (!handle) return;
+    static_cast<ZuneDevice*>(handle)->SetDeviceProfileDirectory(directory ? directory : "");
+}
+
+XUNE_SYNC_API void zune_device_set_artwork_pipeline(
+    zune_device_handle_t handle, const ZuneArtworkPipelineOptions* options)
+{
+    if (!handle) return;
+    zune::ArtworkPipeline::Options opts;
+    if (options) {
+        if (options->resize) {
+            auto resize = options->resize;
+            void* user_data = options->user_data;
+            opts.resize = [resize, user_data](const uint8_t* jpeg, size_t size, uint32_t max_dimension,
+                                              uint8_t* out, size_t capacity) -> size_t {
+                if (size > UINT32_MAX) return 0;
+                return resize(jpeg, static_cast<uint32_t>(size), max_dimension,
+                              out, static_cast<uint32_t>(capacity), user_data);
+            };
+        }
+        opts.cache_dir = options->cache_dir ? options->cache_dir : "";
+        opts.max_dimension = options->max_dimension;
+        if (options->worker_threads > 0) opts.worker_threads = options->worker_threads;
+    }
+    static_cast<ZuneDevice*>(handle)->SetArtworkPipeline(options != nullptr, opts);
+}
+
+XUNE_SYNC_API int zune_device_prepare_artwork(
+    zune_device_handle_t handle, const uint8_t* const* images,
+    const uint32_t* sizes, uint32_t count)
+{
+    if (!handle || (count > 0 && (!images || !sizes))) return -1;
+    zune::ArtworkPipeline* pipeline = static_cast<ZuneDevice*>(handle)->GetArtworkPipeline();
+    if (!pipeline) return -1;
+    std::vector<std::pair<const uint8_t*, size_t>> batch(count);
+    for (uint32_t i = 0; i < count; i++) batch[i] = {images[i], sizes[i]};
+    try {
+        pipeline->PrepareBatch(batch);
+        return 0;
+    } catch (...) { return -1; }
+}
+
+XUNE_SYNC_API int zune_device_get_artwork_pipeline_stats(
+    zune_device_handle_t handle, ZuneArtworkPipelineStats* out)
+{
+    if (!handle || !out) return -1;
+    zune::ArtworkPipeline* pipeline = static_cast<ZuneDevice*>(handle)->GetArtworkPipeline();
+    if (!pipeline) return -1;
+    auto stats = pipeline->GetStats();
+    out->images = stats.images;
+    out->duplicates = stats.duplicates;
+    out->resized = stats.resized;
+    out->disk_hits = stats.disk_hits;
+    out->sends_skipped = stats.sends_skipped;
+    out->bytes_in = stats.bytes_in;
+    out->bytes_out = stats.bytes_out;
+    return 0;
+}
+
+// --- Asynchronous Operations ---
+
+// Queue work on the device's executor, adapting the C callbacks
+static zune_async_op_t SubmitAsync(
+    ZuneDevice* device, zune::AsyncExecutor::Work work,
+    zune_async_progress_callback_t progress, zune_async_complete_callback_t complete,
+    void* user_data)
+{
+    zune::AsyncExecutor::ProgressFn on_progress;
+    if (progress) {
+        on_progress = [progress, user_data](uint64_t id, uint64_t done, uint64_t total) {
+            progress(id, done, total, user_data);
+        };
+    }
+    zune::AsyncExecutor::CompleteFn on_complete;
+    if (complete) {
+        on_complete = [complete, user_data](uint64_t id, zune::AsyncExecutor::Status status,
+                                            int result, void* data) {
+            complete(id, static_cast<ZuneAsyncStatus>(status), result, data, user_data);
+        };
+    }
+    return device->GetAsyncExecutor().Submit(std::move(work), std::move(on_progress), std::move(on_complete));
+}
+
+XUNE_SYNC_API zune_async_op_t zune_device_get_music_library_async(
+    zune_device_handle_t handle, zune_async_complete_callback_t complete, void* user_data)
+{
+    if (!handle) return 0;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    return SubmitAsync(device, [device](zune::AsyncExecutor::Context& context) {
+        ZuneMusicLibrary* library = device->GetMusicLibrary();
+        if (context.Cancelled()) {
+            zune::MtpReader::FreeLibrary(library);
+            return context.Stopped();
+        }
+        context.SetData(library);
+        return library ? 0 : -1;
+    }, nullptr, complete, user_data);
+}
+
+XUNE_SYNC_API zune_async_op_t zune_upload_send_audio_async(
+    zune_device_handle_t handle, const char* file_path,
+    zune_async_progress_callback_t progress, zune_async_complete_callback_t complete,
+    void* user_data)
+{
+    if (!handle || !file_path) return 0;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    std::string path = file_path;
+    return SubmitAsync(device, [device, path](zune::AsyncExecutor::Context& context) {
+        auto session = device->GetMtpSession();
+        if (!session) return -1;
+        auto grant = device->GetMtpScheduler().Acquire(ZUNE_MTP_CLASS_BULK);
+        if (context.Cancelled()) return context.Stopped();  // The grant may have taken a while
+        return SendAudio(device, session, path.c_str(), [&context](uint64_t done, uint64_t total) {
+            context.Progress(done, total);
+        });
+    }, progress, complete, user_data);
+}
+
+XUNE_SYNC_API zune_async_op_t zune_device_download_file_async(
+    zune_device_handle_t handle, uint32_t object_handle, const char* destination_path,
+    zune_async_complete_callback_t complete, void* user_data)
+{
+    if (!handle || !destination_path) return 0;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    std::string path = destination_path;
+    return SubmitAsync(device, [device, object_handle, path](zune::AsyncExecutor::Context&) {
+        return device->DownloadFile(object_handle, path);
+    }, nullptr, complete, user_data);
+}
+
+XUNE_SYNC_API zune_async_op_t zune_device_erase_all_content_async(
+    zune_device_handle_t handle, zune_async_complete_callback_t complete, void* user_data)
+{
+    if (!handle) return 0;
+    auto* device = static_cast<ZuneDevice*>(handle);
+    return SubmitAsync(device, [device](zune::AsyncExecutor::Context&) {
+        return device->EraseAllContent();
+    }, nullptr, complete, user_data);
+}
+
+XUNE_SYNC_API bool zune_async_cancel(zune_device_handle_t handle, zune_async_op_t op) {
+    if (!handle || op == 0) return false;
+    return static_cast<ZuneDevice*>(handle)->GetAsyncExecutor().Cancel(op);
+}
+
+XUNE_SYNC_API uint32_t zune_async_pending(zune_device_handle_t handle) {
+    if (!handle) return 0;
+    return static_cast<uint32_t>(static_cast<ZuneDevice*>(handle)->GetAsyncExecutor().Pending());
+}
+
 } // extern "C"
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace zmdb {
+
+/**
+ * Flat atom_id-keyed table, partitioned by schema.
+ *
+ * Atom IDs are dense per schema (top 8 bits = schema, low 24 bits = entry
+ * id), so each schema gets a vector indexed directly by entry id. A lookup
+ * is two array indexes instead of a std::map tree walk. Entry ids beyond
+ * kMaxDenseEntry (never seen on real devices) spill into an overflow hash
+ * map so a corrupt id cannot force a huge allocation.
+ *
+ * Offers the subset of the std::map interface the parsers use (count,
+ * operator[], insert) so it is a drop-in replacement for the index table
+ * and the reference caches.
+ */
+template <typename T>
+class AtomMap {
+public:
+    static constexpr uint32_t kMaxDenseEntry = 1u << 20;
+
+    /**
+     * Pointer to the value for atom_id, or nullptr if absent.
+     */
+    const T* find(uint32_t atom_id) const {
+        uint32_t entry = atom_id & 0x00FFFFFF;
+        if (entry < kMaxDenseEntry) {
+            const auto& slots = schemas_[atom_id >> 24];
+            if (entry < slots.size() && slots[entry].has_value()) {
+                return &*slots[entry];
+            }
+            return nullptr;
+        }
+        auto it = overflow_.find(atom_id);
+        return it != overflow_.end() ? &it->second : nullptr;
+    }
+
+    T* find(uint32_t atom_id) {
+        return const_cast<T*>(static_cast<const AtomMap*>(this)->find(atom_id));
+    }
+
+    size_t count(uint32_t atom_id) const {
+        return find(atom_id) != nullptr ? 1 : 0;
+    }
+
+    /**
+     * Value for atom_id, default-constructing it if absent.
+     */
+    T& operator[](uint32_t atom_id) {
+        uint32_t entry = atom_id & 0x00FFFFFF;
+        if (entry < kMaxDenseEntry) {
+            auto& slots = schemas_[atom_id >> 24];
+            if (entry >= slots.size()) {
+                slots.resize(entry + 1);
+            }
+            if (!slots[entry].has_value()) {
+                slots[entry].emplace();
+                size_++;
+            }
+            return *slots[entry];
+        }
+        auto result = overflow_.try_emplace(atom_id);
+        if (result.second) {
+            size_++;
+        }
+        return result.first->second;
+    }
+
+    /**
+     * Copy in every entry of other that is not already present.
+     */
+    void insert(const AtomMap& other) {
+        other.for_each([this](uint32_t atom_id, const T& value) {
+            if (!count(atom_id)) {
+                (*this)[atom_id] = value;
+            }
+        });
+    }
+
+    /**
+     * Pre-size a schema partition for entry ids [0, entry_count).
+     */
+    void reserve_schema(uint8_t schema, uint32_t entry_count) {
+        auto& slots = schemas_[schema];
+        if (entry_count > slots.size() && entry_count <= kMaxDenseEntry) {
+            slots.resize(entry_count);
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void clear() {
+        for (auto& slots : schemas_) {
+            slots.clear();
+        }
+        overflow_.clear();
+        size_ = 0;
+    }
+
+    /**
+     * Visit dense entries in ascending atom_id order, then overflow entries.
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (size_t schema = 0; schema < schemas_.size(); schema++) {
+            const auto& slots = schemas_[schema];
+            for (size_t entry = 0; entry < slots.size(); entry++) {
+                if (slots[entry].has_value()) {
+                    fn(static_cast<uint32_t>((schema << 24) | entry), *slots[entry]);
+                }
+            }
+        }
+        for (const auto& [atom_id, value] : overflow_) {
+            fn(atom_id, value);
+        }
+    }
+
+    /**
+     * Move each entry out to fn(atom_id, T&&) in ascending atom_id order
+     * (the order of release_to_map). Leaves this table empty.
+     */
+    template <typename Fn>
+    void release_each(Fn&& fn) {
+        std::vector<uint32_t> spilled;
+        spilled.reserve(overflow_.size());
+        for (const auto& entry : overflow_) {
+            spilled.push_back(entry.first);
+        }
+        std::sort(spilled.begin(), spilled.end());
+
+        size_t next_spilled = 0;
+        for (size_t schema = 0; schema < schemas_.size(); schema++) {
+            auto& slots = schemas_[schema];
+            for (size_t entry = 0; entry < slots.size(); entry++) {
+                if (slots[entry].has_value()) {
+                    fn(static_cast<uint32_t>((schema << 24) | entry), std::move(*slots[entry]));
+                }
+            }
+            // Overflow ids sort after every dense id of their schema
+            for (; next_spilled < spilled.size() && (spilled[next_spilled] >> 24) == schema; next_spilled++) {
+                fn(spilled[next_spilled], std::move(overflow_.at(spilled[next_spilled])));
+            }
+        }
+        clear();
+    }
+
+    /**
+     * Move the contents into an ordered std::map (what ZMDBLibrary exposes).
+     * Leaves this table empty.
+     */
+    std::map<uint32_t, T> release_to_map() {
+        std::map<uint32_t, T> out;
+        // Ascending: hinted insert is O(1)
+        release_each([&out](uint32_t atom_id, T&& value) {
+            out.emplace_hint(out.end(), atom_id, std::move(value));
+        });
+        return out;
+    }
+
+private:
+    std::array<std::vector<std::optional<T>>, 256> schemas_;
+    std::unordered_map<uint32_t, T> overflow_;
+    size_t size_ = 0;
+};
+
+} // namespace zmdb
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "ZMDBTypes.h"
+#include "ZMDBUtils.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace zmdb {
+
+/**
+ * Compile-time set of backwards-varint field IDs a record parser reads.
+ * Every other field in the trailer is skipped without being stored.
+ */
+template <uint32_t... FieldIds>
+struct VarintFieldSet {
+    static constexpr size_t count = sizeof...(FieldIds);
+
+    static constexpr bool contains(uint32_t field_id) {
+        return ((field_id == FieldIds) || ...);
+    }
+};
+
+/**
+ * Per-record-type trailer descriptions, shared by the Classic and HD
+ * parsers. entry_size is where the varint section starts for records with
+ * a fixed header; records whose variable section follows an inline title
+ * (podcasts, Classic albums) pass their own start offset instead.
+ */
+namespace RecordSchema {
+
+struct MusicTrack {
+    static constexpr size_t entry_size = get_entry_size_for_schema(Schema::Music);
+    using Fields = VarintFieldSet<0x62, 0x63, 0x6c, 0x70>;
+};
+
+struct Video {
+    static constexpr size_t entry_size = get_entry_size_for_schema(Schema::Video);
+    using Fields = VarintFieldSet<
+        VideoFieldId::Description, VideoFieldId::Filename, VideoFieldId::Artist,
+        VideoFieldId::Season, VideoFieldId::Episode,
+        VideoFieldId::OnDevicePlays, VideoFieldId::LastPlayed>;
+};
+
+struct PodcastEpisode {
+    static constexpr size_t entry_size = get_entry_size_for_schema(Schema::PodcastEpisode);
+    using Fields = VarintFieldSet<
+        PodcastFieldId::Description, PodcastFieldId::Filename,
+        PodcastFieldId::Url, PodcastFieldId::Author>;
+};
+
+struct PodcastShow {
+    static constexpr size_t entry_size = get_entry_size_for_schema(Schema::PodcastShow);
+    using Fields = VarintFieldSet<
+        PodcastFieldId::Filename, PodcastFieldId::Url, PodcastFieldId::Author>;
+};
+
+struct AudiobookTrack {
+    static constexpr size_t entry_size = get_entry_size_for_schema(Schema::AudiobookTrack);
+    using Fields = VarintFieldSet<0x44, 0x46, 0x70>;
+};
+
+struct Album {
+    static constexpr size_t entry_size = get_entry_size_for_schema(Schema::Album);
+    using Fields = VarintFieldSet<0x44>;
+};
+
+struct Artist {
+    static constexpr size_t entry_size = get_entry_size_for_schema(Schema::Artist);
+    using Fields = VarintFieldSet<0x14, 0x44>;
+};
+
+// Album/Artist records resolved only for their UTF-16LE filename (0x44)
+struct FilenameReference {
+    using Fields = VarintFieldSet<0x44>;
+};
+
+} // namespace RecordSchema
+
+/**
+ * Walk the backwards-varint section of a record from its end towards
+ * entry_size, calling sink(const BackwardsVarintField&) for each field in
+ * the order it is decoded (last field in the record first). field_data
+ * views into record_data. Stops at the 0x00 end marker or the first field
+ * that would run past entry_size.
+ */
+template <typename Sink>
+void walk_backwards_varints(ByteView record_data, size_t entry_size, Sink&& sink) {
+    if (record_data.size() <= entry_size) {
+        return;  // No varint section
+    }
+
+    size_t pos = record_data.size() - 1;
+
+    while (pos >= entry_size) {
+        // Read field_id (1-2 bytes)
+        uint8_t field_id_byte1 = record_data[pos--];
+
+        if (field_id_byte1 == 0) {  // End marker
+            break;
+        }
+
+        uint32_t field_id = field_id_byte1;
+
+        if (field_id_byte1 & 0x80) {  // Multi-byte encoding
+            if (pos < entry_size) break;
+            uint8_t field_id_byte2 = record_data[pos--];
+            field_id = (field_id_byte2 << 7) | (field_id_byte1 & 0x7F);
+        }
+
+        // Read field_size (1-3 bytes)
+        if (pos < entry_size) break;
+
+        uint8_t size_byte1 = record_data[pos--];
+        uint32_t field_size = size_byte1;
+
+        // LEB128-style varint, walked backward. Continuation bit is set on
+        // every non-terminal byte. The previous gate `size_byte2 != 0`
+        // mis-fired on any 2-byte size with a non-zero high chunk
+        // (i.e. anything ≥ 128), shifting subsequent reads by one byte.
+        if (size_byte1 & 0x80) {
+            if (pos < entry_size) break;
+            uint8_t size_byte2 = record_data[pos--];
+            field_size = (size_byte2 << 7) | (size_byte1 & 0x7F);
+
+            if (size_byte2 & 0x80) {
+                if (pos < entry_size) break;
+                uint8_t size_byte3 = record_data[pos--];
+                field_size = (size_byte3 << 14) | (field_size & 0x3FFF);
+            }
+        }
+
+        // Extract field data
+        size_t field_end = pos + 1;
+        if (field_size > field_end || field_end - field_size < entry_size) {
+            break;  // Invalid field size
+        }
+
+        size_t field_start = field_end - field_size;
+
+        BackwardsVarintField field;
+        field.field_id = field_id;
+        field.field_size = field_size;
+        field.offset = field_start;
+        field.field_data = record_data.subview(field_start, field_size);
+
+        sink(field);
+
+        if (field_start == 0) {
+            break;  // Reached the start of the record (entry_size 0)
+        }
+        pos = field_start - 1;
+    }
+}
+
+/**
+ * Visit the fields of Record::Fields present in a record's varint section,
+ * in record order (as parse_backwards_varints returns them), without
+ * allocating. Fields with other IDs are skipped during the walk.
+ *
+ * visit(const BackwardsVarintField&) may return bool; false stops the
+ * visit (first-match lookups).
+ *
+ * Matches are buffered on the stack; a record carrying more than
+ * kMaxVarintMatches wanted fields keeps the last ones in record order.
+ */
+constexpr size_t kMaxVarintMatches = 16;
+
+template <typename Record, typename Visitor>
+void for_each_varint_field(ByteView record_data, size_t entry_size, Visitor&& visit) {
+    using Fields = typename Record::Fields;
+
+    std::array<BackwardsVarintField, kMaxVarintMatches> matches;
+    size_t count = 0;
+    walk_backwards_varints(record_data, entry_size, [&](const BackwardsVarintField& field) {
+        if (count < matches.size() && Fields::contains(field.field_id)) {
+            matches[count++] = field;
+        }
+    });
+
+    // Walk order is last-field-first; replay in record order
+    while (count > 0) {
+        const BackwardsVarintField& field = matches[--count];
+        if constexpr (std::is_same_v<std::invoke_result_t<Visitor&, const BackwardsVarintField&>, bool>) {
+            if (!visit(field)) {
+                return;
+            }
+        } else {
+            visit(field);
+        }
+    }
+}
+
+template <typename Record, typename Visitor>
+void for_each_varint_field(ByteView record_data, Visitor&& visit) {
+    for_each_varint_field<Record>(record_data, Record::entry_size, std::forward<Visitor>(visit));
+}
+
+} // namespace zmdb
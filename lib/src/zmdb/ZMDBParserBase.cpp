@@ -1,16 +1,375 @@
 #include "ZMDBParserBase.h"
 #include "ZMDBUtils.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 
 namespace zmdb {
 
-std::optional<std::pair<RecordHeader, std::vector<uint8_t>>>
-ZMDBParserBase::read_record_at_offset(const std::vector<uint8_t>& data, size_t offset) const {
+// Records per parallel extraction chunk. Fixed (not derived from the thread
+// count) so chunk boundaries, and therefore output, are the same however
+// many workers run.
+static constexpr uint32_t kParallelChunkRecords = 4096;
+static constexpr unsigned kMaxParallelThreads = 8;
+
+template <typename T>
+static T* allocate_records(int capacity) {
+    return static_cast<T*>(::operator new[](capacity * sizeof(T)));
+}
+
+// Allocate the arrays a chunk of `count` records of `schema` can produce.
+// Schema 0x02 also yields promoted video-podcast episodes.
+static void allocate_chunk_library(ZMDBLibrary& lib, uint8_t schema, uint32_t count) {
+    int n = static_cast<int>(count);
+    switch (schema) {
+        case Schema::Music:
+            lib.tracks_capacity = n;
+            lib.tracks = allocate_records<ZMDBTrack>(n);
+            break;
+        case Schema::Video:
+            lib.videos_capacity = n;
+            lib.videos = allocate_records<ZMDBVideo>(n);
+            lib.podcasts_capacity = n;
+            lib.podcasts = allocate_records<ZMDBPodcast>(n);
+            break;
+        case Schema::Picture:
+            lib.pictures_capacity = n;
+            lib.pictures = allocate_records<ZMDBPicture>(n);
+            break;
+        case Schema::Playlist:
+            lib.playlists_capacity = n;
+            lib.playlists = allocate_records<ZMDBPlaylist>(n);
+            break;
+        case Schema::PodcastEpisode:
+            lib.podcasts_capacity = n;
+            lib.podcasts = allocate_records<ZMDBPodcast>(n);
+            break;
+        case Schema::AudiobookTrack:
+            lib.audiobooks_capacity = n;
+            lib.audiobooks = allocate_records<ZMDBAudiobook>(n);
+            break;
+        default:
+            break;  // PodcastShow → map only
+    }
+}
+
+// Allocate `capacity` records of T for library (nothing for 0)
+template <typename T>
+static void allocate_capacity(T*& records, int& capacity, int n) {
+    capacity = n;
+    if (n > 0) {
+        records = allocate_records<T>(n);
+    }
+}
+
+// Move-construct record onto the end of records; dropped past capacity
+template <typename T>
+static void append_record(T* records, int& count, int capacity, T&& record) {
+    if (count < capacity) {
+        new (&records[count]) T(std::move(record));
+        count++;
+    }
+}
+
+// Workers intern into their own tables; re-point their tracks at the main
+// table's entries so each unique string is still stored once.
+static void reintern_tracks(ZMDBLibrary& lib, StringInternTable& strings) {
+    for (int i = 0; i < lib.track_count; i++) {
+        ZMDBTrack& t = lib.tracks[i];
+        t.artist_name = strings.intern(t.artist_name.str());
+        t.artist_guid = strings.intern(t.artist_guid.str());
+        t.genre = strings.intern(t.genre.str());
+        t.album_alb_ref = strings.intern(t.album_alb_ref.str());
+    }
+}
+
+// Move a library's records into sink, media in array order, then shows
+static void emit_records(ZMDBLibrary& lib, ZMDBRecordSink& sink) {
+    for (int i = 0; i < lib.track_count; i++) sink.OnTrack(std::move(lib.tracks[i]));
+    for (int i = 0; i < lib.video_count; i++) sink.OnVideo(std::move(lib.videos[i]));
+    for (int i = 0; i < lib.picture_count; i++) sink.OnPicture(std::move(lib.pictures[i]));
+    for (int i = 0; i < lib.playlist_count; i++) sink.OnPlaylist(std::move(lib.playlists[i]));
+    for (int i = 0; i < lib.podcast_count; i++) sink.OnPodcast(std::move(lib.podcasts[i]));
+    for (int i = 0; i < lib.audiobook_count; i++) sink.OnAudiobook(std::move(lib.audiobooks[i]));
+    for (auto& [atom_id, show] : lib.podcast_show_metadata) {
+        sink.OnPodcastShow(atom_id, std::move(show));
+    }
+}
+
+void ZMDBRecordSink::OnLibrary(ZMDBLibrary&& library) {
+    ZMDBExtractionPlan plan;
+    plan.tracks = library.track_count;
+    plan.videos = library.video_count;
+    plan.pictures = library.picture_count;
+    plan.playlists = library.playlist_count;
+    plan.podcasts = library.podcast_count;
+    plan.audiobooks = library.audiobook_count;
+    plan.details_deferred = library.details_deferred;
+    Begin(plan);
+
+    emit_records(library, *this);
+    for (auto& [atom_id, album] : library.album_metadata) OnAlbum(atom_id, std::move(album));
+    for (auto& [atom_id, artist] : library.artist_metadata) OnArtist(atom_id, std::move(artist));
+    for (auto& [atom_id, genre] : library.genre_metadata) OnGenre(atom_id, std::move(genre));
+    Finish(std::move(library.strings));
+}
+
+void ZMDBLibrarySink::Begin(const ZMDBExtractionPlan& plan) {
+    library_.details_deferred = plan.details_deferred;
+    allocate_capacity(library_.tracks, library_.tracks_capacity, plan.tracks);
+    allocate_capacity(library_.videos, library_.videos_capacity, plan.videos);
+    allocate_capacity(library_.pictures, library_.pictures_capacity, plan.pictures);
+    allocate_capacity(library_.playlists, library_.playlists_capacity, plan.playlists);
+    allocate_capacity(library_.podcasts, library_.podcasts_capacity, plan.podcasts);
+    allocate_capacity(library_.audiobooks, library_.audiobooks_capacity, plan.audiobooks);
+}
+
+void ZMDBLibrarySink::OnTrack(ZMDBTrack&& track) {
+    append_record(library_.tracks, library_.track_count, library_.tracks_capacity, std::move(track));
+}
+
+void ZMDBLibrarySink::OnVideo(ZMDBVideo&& video) {
+    append_record(library_.videos, library_.video_count, library_.videos_capacity, std::move(video));
+}
+
+void ZMDBLibrarySink::OnPicture(ZMDBPicture&& picture) {
+    append_record(library_.pictures, library_.picture_count, library_.pictures_capacity, std::move(picture));
+}
+
+void ZMDBLibrarySink::OnPlaylist(ZMDBPlaylist&& playlist) {
+    append_record(library_.playlists, library_.playlist_count, library_.playlists_capacity, std::move(playlist));
+}
+
+void ZMDBLibrarySink::OnPodcast(ZMDBPodcast&& podcast) {
+    append_record(library_.podcasts, library_.podcast_count, library_.podcasts_capacity, std::move(podcast));
+}
+
+void ZMDBLibrarySink::OnAudiobook(ZMDBAudiobook&& audiobook) {
+    append_record(library_.audiobooks, library_.audiobook_count, library_.audiobooks_capacity,
+                  std::move(audiobook));
+}
+
+void ZMDBLibrarySink::OnPodcastShow(uint32_t atom_id, ZMDBPodcastShow&& show) {
+    library_.podcast_show_metadata[atom_id] = std::move(show);
+    library_.podcast_show_count++;
+}
+
+void ZMDBLibrarySink::OnAlbum(uint32_t atom_id, ZMDBAlbum&& album) {
+    library_.album_metadata.insert_or_assign(library_.album_metadata.end(), atom_id, std::move(album));
+}
+
+void ZMDBLibrarySink::OnArtist(uint32_t atom_id, ZMDBArtist&& artist) {
+    library_.artist_metadata.insert_or_assign(library_.artist_metadata.end(), atom_id, std::move(artist));
+}
+
+void ZMDBLibrarySink::OnGenre(uint32_t atom_id, ZMDBGenre&& genre) {
+    library_.genre_metadata.insert_or_assign(library_.genre_metadata.end(), atom_id, std::move(genre));
+}
+
+void ZMDBLibrarySink::Finish(StringInternTable&& strings) {
+    library_.strings = std::move(strings);
+    library_.album_count = static_cast<int>(library_.album_metadata.size());
+    library_.artist_count = static_cast<int>(library_.artist_metadata.size());
+    library_.genre_count = static_cast<int>(library_.genre_metadata.size());
+}
+
+void ZMDBLibrarySink::OnLibrary(ZMDBLibrary&& library) {
+    library_ = std::move(library);
+}
+
+void ZMDBLibrarySink::Reset() {
+    zune::DeviceFamily family = library_.device_family;
+    library_ = ZMDBLibrary();
+    library_.device_family = family;
+}
+
+void ZMDBParserBase::SetParallelExtraction(bool enabled, unsigned max_threads) {
+    parallel_extraction_ = enabled;
+    max_threads_ = max_threads;
+}
+
+void ZMDBParserBase::SetDeferredDetails(bool enabled) {
+    deferred_details_ = enabled;
+}
+
+ZMDBLibrary ZMDBParserBase::ExtractLibrary(ByteView zmdb_data) {
+    ZMDBLibrary library;
+    library.device_family = library_family();
+    ZMDBLibrarySink sink(library);
+    extract_records(zmdb_data, sink);
+    return library;
+}
+
+void ZMDBParserBase::Extract(ByteView zmdb_data, ZMDBRecordSink& sink) {
+    extract_records(zmdb_data, sink);
+}
+
+void ZMDBParserBase::run_extraction(const std::vector<ExtractionJob>& jobs, ZMDBRecordSink& sink) {
+    unsigned thread_count = max_threads_;
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+
+    // A single worker would only add per-chunk cache warm-up cost
+    if (parallel_extraction_ && thread_count > 1) {
+        run_extraction_parallel(jobs, sink, std::min(thread_count, kMaxParallelThreads));
+        return;
+    }
+
+    for (const auto& job : jobs) {
+        if (job.descriptor_idx >= descriptors_.size()) {
+            continue;
+        }
+        try {
+            extract_media_range(job.descriptor_idx, 0,
+                                descriptors_[job.descriptor_idx].entry_count, sink);
+        } catch (const std::exception& e) {
+            throw std::runtime_error(std::string(job.label) + " parsing failed: " + e.what());
+        }
+    }
+}
+
+void ZMDBParserBase::run_extraction_parallel(
+    const std::vector<ExtractionJob>& jobs, ZMDBRecordSink& sink, unsigned thread_count)
+{
+    struct Chunk {
+        const ExtractionJob* job;
+        uint32_t begin;
+        uint32_t end;
+        std::unique_ptr<ZMDBParserBase> worker;
+        ZMDBLibrary partial;
+        std::exception_ptr error;
+    };
+
+    std::vector<Chunk> chunks;
+    for (const auto& job : jobs) {
+        if (job.descriptor_idx >= descriptors_.size()) {
+            continue;
+        }
+        uint32_t count = descriptors_[job.descriptor_idx].entry_count;
+        for (uint32_t begin = 0; begin < count; begin += kParallelChunkRecords) {
+            Chunk chunk;
+            chunk.job = &job;
+            chunk.begin = begin;
+            chunk.end = std::min(count, begin + kParallelChunkRecords);
+            chunks.push_back(std::move(chunk));
+        }
+    }
+
+    if (chunks.empty()) {
+        return;
+    }
+
+    // Workers and staging arrays are created up front on the calling thread
+    for (auto& chunk : chunks) {
+        chunk.worker = create_worker();
+        allocate_chunk_library(chunk.partial, chunk.job->expected_schema, chunk.end - chunk.begin);
+    }
+
+    thread_count = std::min(thread_count, static_cast<unsigned>(chunks.size()));
+
+    std::atomic<size_t> next_chunk{0};
+    auto run_chunks = [&]() {
+        for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            auto& chunk = chunks[i];
+            try {
+                ZMDBLibrarySink partial(chunk.partial);
+                chunk.worker->extract_media_range(
+                    chunk.job->descriptor_idx, chunk.begin, chunk.end, partial);
+            } catch (...) {
+                chunk.error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (unsigned t = 1; t < thread_count; t++) {
+        threads.emplace_back(run_chunks);
+    }
+    run_chunks();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Merge in descriptor/chunk order so output matches a serial walk
+    for (auto& chunk : chunks) {
+        if (chunk.error) {
+            try {
+                std::rethrow_exception(chunk.error);
+            } catch (const std::exception& e) {
+                throw std::runtime_error(std::string(chunk.job->label) + " parsing failed: " + e.what());
+            }
+        }
+        reintern_tracks(chunk.partial, strings_);
+        emit_records(chunk.partial, sink);
+        merge_worker_caches(*chunk.worker);
+    }
+}
+
+void ZMDBParserBase::release_strings(ZMDBRecordSink& sink) {
+    sink.Finish(std::exchange(strings_, StringInternTable()));
+    interned_refs_.clear();
+    interned_guids_.clear();
+}
+
+void ZMDBParserBase::share_parse_state(ZMDBParserBase& worker) const {
+    worker.zmdb_data_ = zmdb_data_;
+    worker.index_table_ = index_table_;
+    worker.descriptors_ = descriptors_;
+    worker.stream_ = stream_;
+    worker.deferred_details_ = deferred_details_;
+}
+
+ZMDBLibrary ZMDBParserBase::ExtractLibraryStreaming(const ZMDBStreamBuffer& stream) {
+    ZMDBLibrary library;
+    library.device_family = library_family();
+    ZMDBLibrarySink sink(library);
+    ExtractStreaming(stream, sink);
+    return library;
+}
+
+void ZMDBParserBase::ExtractStreaming(const ZMDBStreamBuffer& stream, ZMDBRecordSink& sink) {
+    struct StreamScope {
+        ZMDBParserBase& parser;
+        ~StreamScope() { parser.stream_ = nullptr; }
+    } scope{*this};
+
+    stream_ = &stream;
+    extract_records(stream.View(), sink);
+}
+
+void ZMDBParserBase::wait_for_bytes_slow(size_t end) const {
+    if (!stream_->WaitFor(end)) {
+        throw std::runtime_error("ZMDB transfer ended at " + std::to_string(stream_->Received()) +
+                                 " of " + std::to_string(stream_->TotalSize()) + " bytes");
+    }
+}
+
+bool ZMDBParserBase::find_record_offset(uint32_t atom_id, uint32_t& record_offset) const {
+    if (!index_table_) {
+        return false;
+    }
+    const uint32_t* offset = index_table_->find(atom_id);
+    if (!offset) {
+        return false;
+    }
+    record_offset = *offset;
+    return true;
+}
+
+std::optional<std::pair<RecordHeader, ByteView>>
+ZMDBParserBase::read_record_at_offset(ByteView data, size_t offset) const {
     if (offset < 4 || offset >= data.size()) {
         return std::nullopt;
     }
 
     // Read 4-byte header at offset-4
+    wait_for_bytes(offset);
     uint32_t header_value = read_uint32_le(data, offset - 4);
 
     // Check sign bit (bit 31 must be 0)
@@ -26,28 +385,25 @@ ZMDBParserBase::read_record_at_offset(const std::vector<uint8_t>& data, size_t o
     if (offset + header.record_size > data.size()) {
         return std::nullopt;
     }
+    wait_for_bytes(offset + header.record_size);
 
-    std::vector<uint8_t> record_data(
-        data.begin() + offset,
-        data.begin() + offset + header.record_size
-    );
-
-    return std::make_pair(header, record_data);
+    return std::make_pair(header, data.subview(offset, header.record_size));
 }
 
-uint32_t ZMDBParserBase::extract_atom_id(const std::vector<uint8_t>& record_data) const {
+uint32_t ZMDBParserBase::extract_atom_id(ByteView record_data) const {
     if (record_data.size() < 4) {
         return 0;
     }
     return read_uint32_le(record_data, 0);
 }
 
-std::map<uint32_t, uint32_t> ZMDBParserBase::build_index_table(
-    const std::vector<uint8_t>& data,
+ZMDBParserBase::IndexTable ZMDBParserBase::build_index_table(
+    ByteView data,
     size_t descriptor_offset,
     uint32_t entry_count
 ) const {
-    std::map<uint32_t, uint32_t> index;
+    IndexTable index;
+    wait_for_bytes(descriptor_offset + static_cast<size_t>(entry_count) * 8);
 
     for (uint32_t i = 0; i < entry_count; i++) {
         size_t entry_offset = descriptor_offset + (i * 8);
@@ -66,7 +422,7 @@ std::map<uint32_t, uint32_t> ZMDBParserBase::build_index_table(
 }
 
 std::string ZMDBParserBase::read_utf8_string(
-    const std::vector<uint8_t>& data,
+    ByteView data,
     size_t offset,
     size_t max_len
 ) const {
@@ -74,7 +430,7 @@ std::string ZMDBParserBase::read_utf8_string(
 }
 
 std::string ZMDBParserBase::read_utf16le_string(
-    const std::vector<uint8_t>& data,
+    ByteView data,
     size_t offset,
     size_t max_len
 ) const {
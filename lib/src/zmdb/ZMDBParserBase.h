@@ -1,13 +1,188 @@
 #pragma once
 
 #include "ZMDBTypes.h"
+#include "ZMDBAtomMap.h"
+#include "ZMDBStream.h"
 #include <vector>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <optional>
+#include <type_traits>
+#include <utility>
 
 namespace zmdb {
 
+/**
+ * Upper bounds on the records one extraction produces, per collection
+ * (descriptor entry counts), so a sink can size its output once.
+ */
+struct ZMDBExtractionPlan {
+    int tracks = 0;
+    int videos = 0;
+    int pictures = 0;
+    int playlists = 0;
+    int podcasts = 0;  // Audio episodes plus video podcasts promoted out of Schema 0x02
+    int audiobooks = 0;
+    bool details_deferred = false;  // See ZMDBParserBase::SetDeferredDetails
+};
+
+/**
+ * Receiver of parsed records (see ZMDBParserBase::Extract).
+ *
+ * Parsers hand each record over as soon as it is parsed, so a consumer
+ * builds its own representation (the C structs, an export, a snapshot)
+ * without a ZMDBLibrary in between. Calls arrive in this order: Begin,
+ * the media records (each collection in library order), the podcast
+ * shows, then albums, artists and genres in atom_id order, and Finish.
+ * Nothing is called for a blob that is not a ZMDB. Every method drops its
+ * input by default.
+ */
+class ZMDBRecordSink {
+public:
+    virtual ~ZMDBRecordSink() = default;
+
+    virtual void Begin(const ZMDBExtractionPlan&) {}
+
+    virtual void OnTrack(ZMDBTrack&&) {}
+    virtual void OnVideo(ZMDBVideo&&) {}
+    virtual void OnPicture(ZMDBPicture&&) {}
+    virtual void OnPlaylist(ZMDBPlaylist&&) {}
+    virtual void OnPodcast(ZMDBPodcast&&) {}
+    virtual void OnAudiobook(ZMDBAudiobook&&) {}
+    virtual void OnPodcastShow(uint32_t, ZMDBPodcastShow&&) {}
+    virtual void OnAlbum(uint32_t, ZMDBAlbum&&) {}
+    virtual void OnArtist(uint32_t, ZMDBArtist&&) {}
+    virtual void OnGenre(uint32_t, ZMDBGenre&&) {}
+
+    /**
+     * Last call. strings holds the interned strings the track records
+     * share; entries are reference counted, so records kept without it
+     * stay valid.
+     */
+    virtual void Finish(StringInternTable&&) {}
+
+    /**
+     * Take a library that was materialized anyway (built by hand, or kept
+     * from an earlier read). The default replays it through the calls
+     * above, moving each record out.
+     */
+    virtual void OnLibrary(ZMDBLibrary&& library);
+
+    /**
+     * Drop everything received so far: the records are about to be sent
+     * again (a streaming parse whose transfer failed is redone from a
+     * buffered read).
+     */
+    virtual void Reset() {}
+};
+
+/**
+ * Sink that fills a ZMDBLibrary, as ExtractLibrary returns it. Begin
+ * allocates the record arrays; records past their capacity are dropped.
+ */
+class ZMDBLibrarySink : public ZMDBRecordSink {
+public:
+    explicit ZMDBLibrarySink(ZMDBLibrary& library) : library_(library) {}
+
+    void Begin(const ZMDBExtractionPlan& plan) override;
+    void OnTrack(ZMDBTrack&& track) override;
+    void OnVideo(ZMDBVideo&& video) override;
+    void OnPicture(ZMDBPicture&& picture) override;
+    void OnPlaylist(ZMDBPlaylist&& playlist) override;
+    void OnPodcast(ZMDBPodcast&& podcast) override;
+    void OnAudiobook(ZMDBAudiobook&& audiobook) override;
+    void OnPodcastShow(uint32_t atom_id, ZMDBPodcastShow&& show) override;
+    void OnAlbum(uint32_t atom_id, ZMDBAlbum&& album) override;
+    void OnArtist(uint32_t atom_id, ZMDBArtist&& artist) override;
+    void OnGenre(uint32_t atom_id, ZMDBGenre&& genre) override;
+    void Finish(StringInternTable&& strings) override;
+    void OnLibrary(ZMDBLibrary&& library) override;  // Moved in whole
+    void Reset() override;  // Keeps device_family
+
+private:
+    ZMDBLibrary& library_;
+};
+
+namespace sink_detail {
+// HasX<C>: C declares the sink call X with ZMDBRecordSink's parameters
+#define ZMDB_DETECT_SINK_CALL(Name, ...) \
+    template <typename C, typename = void> struct Has##Name : std::false_type {}; \
+    template <typename C> \
+    struct Has##Name<C, std::void_t<decltype(std::declval<C&>().Name(__VA_ARGS__))>> : std::true_type {};
+ZMDB_DETECT_SINK_CALL(Begin, std::declval<const ZMDBExtractionPlan&>())
+ZMDB_DETECT_SINK_CALL(OnTrack, std::declval<ZMDBTrack&&>())
+ZMDB_DETECT_SINK_CALL(OnVideo, std::declval<ZMDBVideo&&>())
+ZMDB_DETECT_SINK_CALL(OnPicture, std::declval<ZMDBPicture&&>())
+ZMDB_DETECT_SINK_CALL(OnPlaylist, std::declval<ZMDBPlaylist&&>())
+ZMDB_DETECT_SINK_CALL(OnPodcast, std::declval<ZMDBPodcast&&>())
+ZMDB_DETECT_SINK_CALL(OnAudiobook, std::declval<ZMDBAudiobook&&>())
+ZMDB_DETECT_SINK_CALL(OnPodcastShow, uint32_t(), std::declval<ZMDBPodcastShow&&>())
+ZMDB_DETECT_SINK_CALL(OnAlbum, uint32_t(), std::declval<ZMDBAlbum&&>())
+ZMDB_DETECT_SINK_CALL(OnArtist, uint32_t(), std::declval<ZMDBArtist&&>())
+ZMDB_DETECT_SINK_CALL(OnGenre, uint32_t(), std::declval<ZMDBGenre&&>())
+ZMDB_DETECT_SINK_CALL(Finish, std::declval<StringInternTable&&>())
+#undef ZMDB_DETECT_SINK_CALL
+template <typename C, typename = void> struct HasReset : std::false_type {};
+template <typename C>
+struct HasReset<C, std::void_t<decltype(std::declval<C&>().Reset())>> : std::true_type {};
+} // namespace sink_detail
+
+/**
+ * ZMDBRecordSink over any consumer type: forwards the calls Consumer
+ * declares (same names and parameters) and drops the rest, so e.g. a
+ * consumer that only exports tracks defines OnTrack alone. A library
+ * passed to OnLibrary is replayed record by record.
+ */
+template <typename Consumer>
+class ZMDBSinkAdapter final : public ZMDBRecordSink {
+public:
+    explicit ZMDBSinkAdapter(Consumer& consumer) : consumer_(consumer) {}
+
+    void Begin(const ZMDBExtractionPlan& plan) override {
+        if constexpr (sink_detail::HasBegin<Consumer>::value) consumer_.Begin(plan);
+    }
+    void OnTrack(ZMDBTrack&& track) override {
+        if constexpr (sink_detail::HasOnTrack<Consumer>::value) consumer_.OnTrack(std::move(track));
+    }
+    void OnVideo(ZMDBVideo&& video) override {
+        if constexpr (sink_detail::HasOnVideo<Consumer>::value) consumer_.OnVideo(std::move(video));
+    }
+    void OnPicture(ZMDBPicture&& picture) override {
+        if constexpr (sink_detail::HasOnPicture<Consumer>::value) consumer_.OnPicture(std::move(picture));
+    }
+    void OnPlaylist(ZMDBPlaylist&& playlist) override {
+        if constexpr (sink_detail::HasOnPlaylist<Consumer>::value) consumer_.OnPlaylist(std::move(playlist));
+    }
+    void OnPodcast(ZMDBPodcast&& podcast) override {
+        if constexpr (sink_detail::HasOnPodcast<Consumer>::value) consumer_.OnPodcast(std::move(podcast));
+    }
+    void OnAudiobook(ZMDBAudiobook&& audiobook) override {
+        if constexpr (sink_detail::HasOnAudiobook<Consumer>::value) consumer_.OnAudiobook(std::move(audiobook));
+    }
+    void OnPodcastShow(uint32_t atom_id, ZMDBPodcastShow&& show) override {
+        if constexpr (sink_detail::HasOnPodcastShow<Consumer>::value) consumer_.OnPodcastShow(atom_id, std::move(show));
+    }
+    void OnAlbum(uint32_t atom_id, ZMDBAlbum&& album) override {
+        if constexpr (sink_detail::HasOnAlbum<Consumer>::value) consumer_.OnAlbum(atom_id, std::move(album));
+    }
+    void OnArtist(uint32_t atom_id, ZMDBArtist&& artist) override {
+        if constexpr (sink_detail::HasOnArtist<Consumer>::value) consumer_.OnArtist(atom_id, std::move(artist));
+    }
+    void OnGenre(uint32_t atom_id, ZMDBGenre&& genre) override {
+        if constexpr (sink_detail::HasOnGenre<Consumer>::value) consumer_.OnGenre(atom_id, std::move(genre));
+    }
+    void Finish(StringInternTable&& strings) override {
+        if constexpr (sink_detail::HasFinish<Consumer>::value) consumer_.Finish(std::move(strings));
+    }
+    void Reset() override {
+        if constexpr (sink_detail::HasReset<Consumer>::value) consumer_.Reset();
+    }
+
+private:
+    Consumer& consumer_;
+};
+
 /**
  * Abstract base class for ZMDB parsers.
  *
@@ -21,12 +196,171 @@ public:
     /**
      * Extract complete library from ZMDB data.
      *
-     * @param zmdb_data Raw ZMDB file bytes
+     * The parser reads directly from the caller's buffer — no copy of the
+     * blob or of individual records is taken, so zmdb_data must stay alive
+     * and unmodified for the duration of the call. A std::vector<uint8_t>
+     * (e.g. from MtpReader::ReadZuneMetadata) converts implicitly.
+     *
+     * @param zmdb_data Raw ZMDB file bytes (non-owning view)
      * @return Parsed library with all media types
      */
-    virtual ZMDBLibrary ExtractLibrary(const std::vector<uint8_t>& zmdb_data) = 0;
+    ZMDBLibrary ExtractLibrary(ByteView zmdb_data);
+
+    /**
+     * Extract ZMDB data into sink instead of a ZMDBLibrary.
+     *
+     * Each record is moved into the sink as it is parsed, so a consumer
+     * with its own representation builds only that one. ExtractLibrary is
+     * this with a ZMDBLibrarySink. Same buffer rules as ExtractLibrary.
+     *
+     * @param zmdb_data Raw ZMDB file bytes (non-owning view)
+     * @param sink Receives the records
+     */
+    void Extract(ByteView zmdb_data, ZMDBRecordSink& sink);
+
+    /**
+     * Extract into any consumer type: a ZMDBRecordSink is used as is,
+     * anything else through ZMDBSinkAdapter.
+     */
+    template <typename Consumer>
+    void Extract(ByteView zmdb_data, Consumer& consumer) {
+        if constexpr (std::is_base_of_v<ZMDBRecordSink, Consumer>) {
+            Extract(zmdb_data, static_cast<ZMDBRecordSink&>(consumer));
+        } else {
+            ZMDBSinkAdapter<Consumer> sink(consumer);
+            Extract(zmdb_data, static_cast<ZMDBRecordSink&>(sink));
+        }
+    }
+
+    /**
+     * Extract a library from a ZMDB that is still being transferred.
+     *
+     * Parses stream.View() like ExtractLibrary, but every read first waits
+     * for the bytes it touches to arrive, so header, descriptor, index and
+     * record parsing run while the rest of the blob is still coming in.
+     * Output is identical to ExtractLibrary on the complete blob.
+     *
+     * @param stream Buffer filled concurrently by the transfer thread
+     * @return Parsed library
+     * @throws std::runtime_error if the transfer finishes before bytes the
+     *         parser needs have arrived
+     */
+    ZMDBLibrary ExtractLibraryStreaming(const ZMDBStreamBuffer& stream);
+
+    /**
+     * ExtractLibraryStreaming into sink (see Extract)
+     */
+    void ExtractStreaming(const ZMDBStreamBuffer& stream, ZMDBRecordSink& sink);
+
+    /**
+     * Opt into parallel extraction (off by default).
+     *
+     * When enabled, descriptors are split into fixed-size record chunks
+     * and extracted on a small pool of worker threads after the index table
+     * has been built. Each chunk is parsed by its own worker with private
+     * reference caches, and results are merged into the library in
+     * descriptor/chunk order, so output does not depend on thread timing
+     * or on the number of threads.
+     *
+     * @param enabled true to fan extraction out over worker threads
+     * @param max_threads Worker thread cap (0 = hardware concurrency, max 8).
+     *                    Falls back to serial extraction when this is 1.
+     */
+    void SetParallelExtraction(bool enabled, unsigned max_threads = 0);
+
+    /**
+     * Leave long optional text undecoded (off by default).
+     *
+     * When enabled, video descriptions and podcast episode descriptions and
+     * URLs are skipped while walking the varint section, and the library is
+     * marked details_deferred. The text is fetched per object from the
+     * device when it is needed (see MtpReader::GetObjectText). Filenames
+     * and other short fields are still decoded.
+     *
+     * @param enabled true to skip description/URL decoding
+     */
+    void SetDeferredDetails(bool enabled);
 
 protected:
+    using IndexTable = AtomMap<uint32_t>;
+
+    /**
+     * Parse zmdb_data into sink: header, descriptors and index table, then
+     * Begin, run_extraction, the album/artist/genre caches and
+     * release_strings.
+     */
+    virtual void extract_records(ByteView zmdb_data, ZMDBRecordSink& sink) = 0;
+
+    /**
+     * device_family of the libraries ExtractLibrary returns
+     */
+    virtual zune::DeviceFamily library_family() const = 0;
+
+    // One descriptor's worth of work for run_extraction(). label is used in
+    // the "<label> parsing failed: ..." error for that descriptor.
+    struct ExtractionJob {
+        uint32_t descriptor_idx;
+        uint8_t expected_schema;
+        const char* label;
+    };
+
+    /**
+     * Extract every job's descriptor into sink, in job order.
+     *
+     * Runs serially by default; see SetParallelExtraction(). Any exception
+     * from a descriptor is rethrown as runtime_error prefixed with its label.
+     *
+     * @param jobs Descriptors to extract, in output order
+     * @param sink Destination, after Begin
+     */
+    void run_extraction(const std::vector<ExtractionJob>& jobs, ZMDBRecordSink& sink);
+
+    /**
+     * Extract records [begin, end) of a descriptor into sink.
+     *
+     * Must only read shared parser state (zmdb_data_, index_table_,
+     * descriptors_); mutable state belongs to the parser's own caches.
+     */
+    virtual void extract_media_range(
+        uint32_t descriptor_idx,
+        uint32_t begin,
+        uint32_t end,
+        ZMDBRecordSink& sink
+    ) = 0;
+
+    /**
+     * Create a worker parser for parallel extraction sharing this parser's
+     * data view, index table and descriptors, with empty caches.
+     */
+    virtual std::unique_ptr<ZMDBParserBase> create_worker() const = 0;
+
+    /**
+     * Fold a finished worker's reference caches into this parser's caches.
+     * Entries already present are kept (earlier chunks win).
+     */
+    virtual void merge_worker_caches(ZMDBParserBase& worker) = 0;
+
+    /**
+     * Look up a record offset in the index table.
+     *
+     * @param atom_id Atom to look up
+     * @param record_offset Set to the record offset when found
+     * @return true if atom_id is in the index
+     */
+    bool find_record_offset(uint32_t atom_id, uint32_t& record_offset) const;
+
+    /**
+     * Ensure zmdb_data_[0, end) is readable. A no-op unless parsing through
+     * ExtractLibraryStreaming; then blocks until the bytes have arrived.
+     *
+     * @throws std::runtime_error if the transfer ended short of end
+     */
+    void wait_for_bytes(size_t end) const {
+        if (stream_ && !stream_->IsAvailable(end)) {
+            wait_for_bytes_slow(end);
+        }
+    }
+
     /**
      * Read record header and data at given offset.
      *
@@ -37,10 +371,11 @@ protected:
      *
      * @param data ZMDB file data
      * @param offset Offset to record data (header is at offset-4)
-     * @return Record header and data, or nullopt if invalid
+     * @return Record header and a view of the record data within data,
+     *         or nullopt if invalid
      */
-    std::optional<std::pair<RecordHeader, std::vector<uint8_t>>>
-    read_record_at_offset(const std::vector<uint8_t>& data, size_t offset) const;
+    std::optional<std::pair<RecordHeader, ByteView>>
+    read_record_at_offset(ByteView data, size_t offset) const;
 
     /**
      * Extract atom_id from record data at offset 0.
@@ -52,7 +387,7 @@ protected:
      * @param record_data Record data bytes
      * @return atom_id, or 0 if record too small
      */
-    uint32_t extract_atom_id(const std::vector<uint8_t>& record_data) const;
+    uint32_t extract_atom_id(ByteView record_data) const;
 
     /**
      * Extract schema type from atom_id.
@@ -83,10 +418,10 @@ protected:
      * @param data ZMDB file data
      * @param descriptor_offset Offset to descriptor 0 data
      * @param entry_count Number of entries
-     * @return Map of atom_id -> record_offset
+     * @return Flat atom_id -> record_offset table
      */
-    std::map<uint32_t, uint32_t> build_index_table(
-        const std::vector<uint8_t>& data,
+    IndexTable build_index_table(
+        ByteView data,
         size_t descriptor_offset,
         uint32_t entry_count
     ) const;
@@ -100,7 +435,7 @@ protected:
      * @return UTF-8 string
      */
     std::string read_utf8_string(
-        const std::vector<uint8_t>& data,
+        ByteView data,
         size_t offset,
         size_t max_len = 256
     ) const;
@@ -114,16 +449,70 @@ protected:
      * @return UTF-8 string (converted from UTF-16LE)
      */
     std::string read_utf16le_string(
-        const std::vector<uint8_t>& data,
+        ByteView data,
         size_t offset,
         size_t max_len = 512
     ) const;
 
-    // ZMDB file data (set by derived class)
-    std::vector<uint8_t> zmdb_data_;
+    // View of the ZMDB file data being parsed (set by derived class; only
+    // valid during an extraction)
+    ByteView zmdb_data_;
+
+    // Index table (atom_id -> record_offset). Shared read-only with
+    // parallel extraction workers.
+    std::shared_ptr<const IndexTable> index_table_;
+
+    // Parsed ZArr descriptors
+    std::vector<Descriptor> descriptors_;
+
+    // Source of zmdb_data_ while streaming (see ExtractLibraryStreaming)
+    const ZMDBStreamBuffer* stream_ = nullptr;
+
+    // Interned track strings; handed to the sink's Finish by the derived
+    // extract_records
+    StringInternTable strings_;
+
+    // Per-atom memo of interned strings, so repeat references skip hashing:
+    // names/filenames by their atom, artist GUIDs by the artist atom
+    AtomMap<SharedString> interned_refs_;
+    AtomMap<SharedString> interned_guids_;
+
+    /**
+     * Hand the interned strings to sink (Finish) and reset the per-atom memos.
+     */
+    void release_strings(ZMDBRecordSink& sink);
+
+    /**
+     * Interned string for atom_id, resolving it on first use.
+     *
+     * @param memo interned_refs_ or interned_guids_
+     * @param resolve Callable returning the string (std::string or view);
+     *                only invoked on the first reference to atom_id
+     */
+    template <typename Resolve>
+    SharedString intern_reference(AtomMap<SharedString>& memo, uint32_t atom_id, Resolve&& resolve) {
+        if (const auto* shared = memo.find(atom_id)) {
+            return *shared;
+        }
+        SharedString shared = strings_.intern(resolve());
+        memo[atom_id] = shared;
+        return shared;
+    }
+
+    // Copy the shared (read-only) parse state into a freshly created worker
+    void share_parse_state(ZMDBParserBase& worker) const;
+
+    // Skip description/URL varint fields (see SetDeferredDetails)
+    bool deferred_details_ = false;
+
+private:
+    void run_extraction_parallel(
+        const std::vector<ExtractionJob>& jobs, ZMDBRecordSink& sink, unsigned thread_count);
+
+    void wait_for_bytes_slow(size_t end) const;
 
-    // Index table (atom_id -> record_offset)
-    std::map<uint32_t, uint32_t> index_table_;
+    bool parallel_extraction_ = false;
+    unsigned max_threads_ = 0;
 };
 
 } // namespace zmdb
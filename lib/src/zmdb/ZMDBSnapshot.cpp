@@ -0,0 +1,646 @@
+#include "ZMDBSnapshot.h"
+#include "../ZuneFileStore.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace zmdb {
+
+static constexpr char kSnapshotMagic[4] = {'X', 'Z', 'S', 'N'};
+// Bump whenever a ZMDB* struct gains, loses or reorders a field.
+static constexpr uint32_t kSnapshotVersion = 4;
+// Offset of the device fingerprint: magic, version, family, hash, size
+static constexpr std::streamoff kFingerprintOffset = 28;
+
+// ── Hash ────────────────────────────────────────────────────────────────
+
+uint64_t hash_zmdb(ByteView data) {
+    uint64_t hash = zune::kFnv1a64Offset;
+    const uint8_t* p = data.data();
+    size_t remaining = data.size();
+
+    // Word-at-a-time keeps this well under the USB read time for the
+    // multi-megabyte ZMDBs of large libraries.
+    while (remaining >= 8) {
+        uint64_t word = 0;
+        for (int i = 7; i >= 0; i--) {
+            word = (word << 8) | p[i];
+        }
+        hash ^= word;
+        hash *= zune::kFnv1a64Prime;
+        hash ^= hash >> 29;
+        p += 8;
+        remaining -= 8;
+    }
+    return zune::Fnv1a64(p, remaining, hash);
+}
+
+// ── Encoding ────────────────────────────────────────────────────────────
+
+namespace {
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(size_t size_hint = 0) { buffer_.reserve(size_hint); }
+
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>> operator()(const T& value) {
+        using U = std::make_unsigned_t<T>;
+        U v = static_cast<U>(value);
+        size_t pos = buffer_.size();
+        buffer_.resize(pos + sizeof(T));
+        for (size_t i = 0; i < sizeof(T); i++) {
+            buffer_[pos + i] = static_cast<uint8_t>(v >> (8 * i));
+        }
+    }
+
+    void operator()(const bool& value) {
+        (*this)(static_cast<uint8_t>(value ? 1 : 0));
+    }
+
+    void operator()(const PodcastMediaType& value) {
+        (*this)(static_cast<uint8_t>(value));
+    }
+
+    void operator()(const std::string& value) {
+        (*this)(static_cast<uint32_t>(value.size()));
+        buffer_.insert(buffer_.end(), value.begin(), value.end());
+    }
+
+    void operator()(const SharedString& value) {
+        (*this)(value.str());
+    }
+
+    void operator()(const std::vector<uint32_t>& values) {
+        (*this)(static_cast<uint32_t>(values.size()));
+        for (uint32_t v : values) {
+            (*this)(v);
+        }
+    }
+
+    void raw(const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    const std::vector<uint8_t>& buffer() const { return buffer_; }
+
+private:
+    std::vector<uint8_t> buffer_;
+};
+
+class SnapshotReader {
+public:
+    // Shared strings are interned into strings, so a loaded library shares
+    // entries the same way a freshly parsed one does
+    SnapshotReader(ByteView data, StringInternTable& strings) : data_(data), strings_(strings) {}
+
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>> operator()(T& value) {
+        using U = std::make_unsigned_t<T>;
+        const uint8_t* p = take(sizeof(T));
+        U v = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            v |= static_cast<U>(static_cast<U>(p[i]) << (8 * i));
+        }
+        value = static_cast<T>(v);
+    }
+
+    void operator()(bool& value) {
+        uint8_t v = 0;
+        (*this)(v);
+        value = v != 0;
+    }
+
+    void operator()(PodcastMediaType& value) {
+        uint8_t v = 0;
+        (*this)(v);
+        value = static_cast<PodcastMediaType>(v);
+    }
+
+    void operator()(std::string& value) {
+        uint32_t size = 0;
+        (*this)(size);
+        const uint8_t* p = take(size);
+        value.assign(reinterpret_cast<const char*>(p), size);
+    }
+
+    void operator()(SharedString& value) {
+        uint32_t size = 0;
+        (*this)(size);
+        const uint8_t* p = take(size);
+        value = strings_.intern(std::string_view(reinterpret_cast<const char*>(p), size));
+    }
+
+    void operator()(std::vector<uint32_t>& values) {
+        uint32_t size = 0;
+        (*this)(size);
+        check(static_cast<size_t>(size) * sizeof(uint32_t));
+        values.resize(size);
+        for (uint32_t& v : values) {
+            (*this)(v);
+        }
+    }
+
+    const uint8_t* take(size_t size) {
+        check(size);
+        const uint8_t* p = data_.data() + pos_;
+        pos_ += size;
+        return p;
+    }
+
+    size_t remaining() const { return data_.size() - pos_; }
+    bool at_end() const { return pos_ == data_.size(); }
+
+private:
+    void check(size_t size) const {
+        if (size > data_.size() - pos_) {
+            throw std::runtime_error("Snapshot truncated");
+        }
+    }
+
+    ByteView data_;
+    StringInternTable& strings_;
+    size_t pos_ = 0;
+};
+
+// Field lists shared by the writer (const records) and reader (mutable
+// records). Keep in sync with ZMDBTypes.h and bump kSnapshotVersion.
+
+template <typename Io, typename Track>
+void visit_fields(Io& io, Track& t, ZMDBTrack*) {
+    io(t.title); io(t.artist_name); io(t.artist_guid); io(t.genre);
+    io(t.track_number); io(t.disc_number); io(t.duration_ms); io(t.file_size_bytes);
+    io(t.playcount); io(t.skip_count); io(t.on_device_playcount); io(t.codec_id);
+    io(t.rating); io(t.last_played_timestamp);
+    io(t.atom_id); io(t.album_ref); io(t.genre_ref); io(t.album_alb_ref);
+}
+
+template <typename Io, typename Video>
+void visit_fields(Io& io, Video& v, ZMDBVideo*) {
+    io(v.title); io(v.episode_title); io(v.folder);
+    io(v.ref2); io(v.duration_ms); io(v.unknown_0x10); io(v.release_date_filetime);
+    io(v.file_size_bytes); io(v.codec_id); io(v.playcount); io(v.category);
+    io(v.filename); io(v.description); io(v.artist_name);
+    io(v.season_number); io(v.episode_number); io(v.on_device_playcount);
+    io(v.last_played_timestamp); io(v.atom_id);
+}
+
+template <typename Io, typename Picture>
+void visit_fields(Io& io, Picture& p, ZMDBPicture*) {
+    io(p.title); io(p.photo_album); io(p.user_album); io(p.collection);
+    io(p.filename); io(p.timestamp); io(p.atom_id);
+}
+
+template <typename Io, typename Playlist>
+void visit_fields(Io& io, Playlist& p, ZMDBPlaylist*) {
+    io(p.name); io(p.filename); io(p.guid); io(p.folder);
+    io(p.track_count); io(p.track_atom_ids); io(p.atom_id);
+}
+
+template <typename Io, typename Podcast>
+void visit_fields(Io& io, Podcast& p, ZMDBPodcast*) {
+    io(p.media_type); io(p.title); io(p.show_name); io(p.author);
+    io(p.description); io(p.episode_url); io(p.folder_name); io(p.episode_filename);
+    io(p.atom_id); io(p.filename_ref); io(p.podcast_show_ref);
+    io(p.duration_ms); io(p.bookmark_ms); io(p.publish_date);
+    io(p.file_size_bytes); io(p.codec_id); io(p.played_flag);
+}
+
+template <typename Io, typename Audiobook>
+void visit_fields(Io& io, Audiobook& a, ZMDBAudiobook*) {
+    io(a.title); io(a.audiobook_name); io(a.author); io(a.filename);
+    io(a.duration_ms); io(a.playback_position_ms); io(a.file_size_bytes);
+    io(a.track_number); io(a.playcount); io(a.format_code);
+    io(a.last_played_timestamp); io(a.atom_id); io(a.title_ref); io(a.filename_ref);
+}
+
+template <typename Io, typename Album>
+void visit_fields(Io& io, Album& a, ZMDBAlbum*) {
+    io(a.title); io(a.artist_name); io(a.artist_guid); io(a.release_year);
+    io(a.alb_reference); io(a.album_pid); io(a.atom_id); io(a.artist_ref);
+}
+
+template <typename Io, typename Artist>
+void visit_fields(Io& io, Artist& a, ZMDBArtist*) {
+    io(a.name); io(a.filename); io(a.guid); io(a.atom_id);
+}
+
+template <typename Io, typename Genre>
+void visit_fields(Io& io, Genre& g, ZMDBGenre*) {
+    io(g.name); io(g.atom_id);
+}
+
+template <typename Io, typename Show>
+void visit_fields(Io& io, Show& s, ZMDBPodcastShow*) {
+    io(s.name); io(s.ser_filename); io(s.author); io(s.feed_url);
+    io(s.filename_ref); io(s.is_subscribed); io(s.atom_id);
+}
+
+template <typename Io, typename T>
+void visit(Io& io, T& record) {
+    visit_fields(io, record, static_cast<std::remove_const_t<T>*>(nullptr));
+}
+
+// One encoded section: its entry count and the entries
+struct SnapshotSection {
+    SnapshotWriter out;
+    uint32_t count = 0;
+
+    template <typename T>
+    void add(const T& record) {
+        visit(out, record);
+        count++;
+    }
+
+    template <typename T>
+    void add(uint32_t atom_id, const T& record) {
+        out(atom_id);
+        add(record);
+    }
+};
+
+// A library's sections, filled in ZMDBRecordSink call order
+struct SnapshotSections {
+    bool details_deferred = false;
+    SnapshotSection tracks, videos, pictures, playlists, podcasts, audiobooks;
+    SnapshotSection podcast_shows, albums, artists, genres;
+
+    std::vector<uint8_t> assemble(zune::DeviceFamily device_family, uint64_t zmdb_hash,
+                                  uint64_t zmdb_size, uint64_t device_fingerprint) const {
+        const SnapshotSection* const media[] = {&tracks, &videos, &pictures, &playlists, &podcasts, &audiobooks};
+        const SnapshotSection* const maps[] = {&podcast_shows, &albums, &artists, &genres};
+        size_t size = 64;
+        for (const SnapshotSection* section : media) size += section->out.buffer().size() + 4;
+        for (const SnapshotSection* section : maps) size += section->out.buffer().size() + 4;
+
+        SnapshotWriter w(size);
+        w.raw(kSnapshotMagic, sizeof(kSnapshotMagic));
+        w(kSnapshotVersion);
+        w(static_cast<uint32_t>(device_family));
+        w(zmdb_hash);
+        w(zmdb_size);
+        w(device_fingerprint);
+        w(details_deferred);
+
+        // Media counts up front: they are the extraction plan on reading
+        for (const SnapshotSection* section : media) w(section->count);
+        for (const SnapshotSection* section : media) {
+            w.raw(section->out.buffer().data(), section->out.buffer().size());
+        }
+        for (const SnapshotSection* section : maps) {
+            w(section->count);
+            w.raw(section->out.buffer().data(), section->out.buffer().size());
+        }
+        return w.buffer();
+    }
+};
+
+template <typename T>
+void add_array(SnapshotSection& section, const T* records, int count) {
+    for (int i = 0; i < count; i++) {
+        section.add(records[i]);
+    }
+}
+
+template <typename T>
+void add_map(SnapshotSection& section, const std::map<uint32_t, T>& map) {
+    for (const auto& [atom_id, value] : map) {
+        section.add(atom_id, value);
+    }
+}
+
+// Decodes count records, handing each to emit
+template <typename T, typename Emit>
+void read_records(SnapshotReader& r, uint32_t count, Emit emit) {
+    for (uint32_t i = 0; i < count; i++) {
+        T record;
+        visit(r, record);
+        emit(std::move(record));
+    }
+}
+
+template <typename T, typename Emit>
+void read_map(SnapshotReader& r, Emit emit) {
+    uint32_t n = 0;
+    r(n);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t atom_id = 0;
+        r(atom_id);
+        T value;
+        visit(r, value);
+        emit(atom_id, std::move(value));
+    }
+}
+
+} // namespace
+
+// ── Snapshot I/O ────────────────────────────────────────────────────────
+
+bool write_library_snapshot(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    const ZMDBLibrary& library,
+    uint64_t device_fingerprint) {
+
+    SnapshotSections sections;
+    sections.details_deferred = library.details_deferred;
+    add_array(sections.tracks, library.tracks, library.track_count);
+    add_array(sections.videos, library.videos, library.video_count);
+    add_array(sections.pictures, library.pictures, library.picture_count);
+    add_array(sections.playlists, library.playlists, library.playlist_count);
+    add_array(sections.podcasts, library.podcasts, library.podcast_count);
+    add_array(sections.audiobooks, library.audiobooks, library.audiobook_count);
+    add_map(sections.podcast_shows, library.podcast_show_metadata);
+    add_map(sections.albums, library.album_metadata);
+    add_map(sections.artists, library.artist_metadata);
+    add_map(sections.genres, library.genre_metadata);
+
+    return zune::WriteFileAtomic(path, sections.assemble(
+        library.device_family, zmdb_hash, zmdb_size, device_fingerprint));
+}
+
+// ── Snapshot sink ───────────────────────────────────────────────────────
+
+struct ZMDBSnapshotSink::Sections : SnapshotSections {};
+
+ZMDBSnapshotSink::ZMDBSnapshotSink(ZMDBRecordSink& next, zune::DeviceFamily device_family)
+    : next_(next), device_family_(device_family), sections_(std::make_unique<Sections>()) {}
+
+ZMDBSnapshotSink::~ZMDBSnapshotSink() = default;
+
+void ZMDBSnapshotSink::Begin(const ZMDBExtractionPlan& plan) {
+    sections_->details_deferred = plan.details_deferred;
+    next_.Begin(plan);
+}
+
+void ZMDBSnapshotSink::OnTrack(ZMDBTrack&& track) {
+    sections_->tracks.add(track);
+    next_.OnTrack(std::move(track));
+}
+
+void ZMDBSnapshotSink::OnVideo(ZMDBVideo&& video) {
+    sections_->videos.add(video);
+    next_.OnVideo(std::move(video));
+}
+
+void ZMDBSnapshotSink::OnPicture(ZMDBPicture&& picture) {
+    sections_->pictures.add(picture);
+    next_.OnPicture(std::move(picture));
+}
+
+void ZMDBSnapshotSink::OnPlaylist(ZMDBPlaylist&& playlist) {
+    sections_->playlists.add(playlist);
+    next_.OnPlaylist(std::move(playlist));
+}
+
+void ZMDBSnapshotSink::OnPodcast(ZMDBPodcast&& podcast) {
+    sections_->podcasts.add(podcast);
+    next_.OnPodcast(std::move(podcast));
+}
+
+void ZMDBSnapshotSink::OnAudiobook(ZMDBAudiobook&& audiobook) {
+    sections_->audiobooks.add(audiobook);
+    next_.OnAudiobook(std::move(audiobook));
+}
+
+void ZMDBSnapshotSink::OnPodcastShow(uint32_t atom_id, ZMDBPodcastShow&& show) {
+    sections_->podcast_shows.add(atom_id, show);
+    next_.OnPodcastShow(atom_id, std::move(show));
+}
+
+void ZMDBSnapshotSink::OnAlbum(uint32_t atom_id, ZMDBAlbum&& album) {
+    sections_->albums.add(atom_id, album);
+    next_.OnAlbum(atom_id, std::move(album));
+}
+
+void ZMDBSnapshotSink::OnArtist(uint32_t atom_id, ZMDBArtist&& artist) {
+    sections_->artists.add(atom_id, artist);
+    next_.OnArtist(atom_id, std::move(artist));
+}
+
+void ZMDBSnapshotSink::OnGenre(uint32_t atom_id, ZMDBGenre&& genre) {
+    sections_->genres.add(atom_id, genre);
+    next_.OnGenre(atom_id, std::move(genre));
+}
+
+void ZMDBSnapshotSink::Finish(StringInternTable&& strings) {
+    finished_ = true;
+    next_.Finish(std::move(strings));
+}
+
+void ZMDBSnapshotSink::Reset() {
+    sections_ = std::make_unique<Sections>();
+    finished_ = false;
+    next_.Reset();
+}
+
+bool ZMDBSnapshotSink::Write(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    uint64_t device_fingerprint) const {
+
+    if (!finished_) {
+        return false;
+    }
+    return zune::WriteFileAtomic(path, sections_->assemble(
+        device_family_, zmdb_hash, zmdb_size, device_fingerprint));
+}
+
+namespace {
+
+// Decodes the snapshot at path into sink when accept(zmdb hash, zmdb size,
+// device fingerprint) approves its header
+bool read_snapshot(
+    const std::string& path,
+    zune::DeviceFamily device_family,
+    bool accept_deferred,
+    const std::function<bool(uint64_t, uint64_t, uint64_t)>& accept,
+    ZMDBRecordSink& sink) {
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return false;
+    }
+    std::streamoff file_size = in.tellg();
+    if (file_size <= 0) {
+        return false;
+    }
+    std::vector<uint8_t> data(static_cast<size_t>(file_size));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(data.data()), file_size)) {
+        return false;
+    }
+
+    StringInternTable strings;
+    SnapshotReader r(data, strings);
+    ZMDBExtractionPlan plan;
+    uint32_t counts[6] = {};
+    try {
+        if (std::memcmp(r.take(sizeof(kSnapshotMagic)), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+            return false;
+        }
+        uint32_t version = 0, family = 0;
+        uint64_t hash = 0, size = 0, fingerprint = 0;
+        r(version);
+        if (version != kSnapshotVersion) {
+            return false;
+        }
+        r(family);
+        r(hash);
+        r(size);
+        r(fingerprint);
+        if (family != static_cast<uint32_t>(device_family) || !accept(hash, size, fingerprint)) {
+            return false;
+        }
+        r(plan.details_deferred);
+        if (plan.details_deferred && !accept_deferred) {
+            return false;
+        }
+        // Every record encodes to at least one byte; reject counts a
+        // corrupt file could use to force a huge allocation in the sink
+        for (uint32_t& count : counts) {
+            r(count);
+            if (count > r.remaining()) {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    plan.tracks = static_cast<int>(counts[0]);
+    plan.videos = static_cast<int>(counts[1]);
+    plan.pictures = static_cast<int>(counts[2]);
+    plan.playlists = static_cast<int>(counts[3]);
+    plan.podcasts = static_cast<int>(counts[4]);
+    plan.audiobooks = static_cast<int>(counts[5]);
+
+    sink.Begin(plan);
+    try {
+        read_records<ZMDBTrack>(r, counts[0], [&](ZMDBTrack&& t) { sink.OnTrack(std::move(t)); });
+        read_records<ZMDBVideo>(r, counts[1], [&](ZMDBVideo&& v) { sink.OnVideo(std::move(v)); });
+        read_records<ZMDBPicture>(r, counts[2], [&](ZMDBPicture&& p) { sink.OnPicture(std::move(p)); });
+        read_records<ZMDBPlaylist>(r, counts[3], [&](ZMDBPlaylist&& p) { sink.OnPlaylist(std::move(p)); });
+        read_records<ZMDBPodcast>(r, counts[4], [&](ZMDBPodcast&& p) { sink.OnPodcast(std::move(p)); });
+        read_records<ZMDBAudiobook>(r, counts[5], [&](ZMDBAudiobook&& a) { sink.OnAudiobook(std::move(a)); });
+
+        read_map<ZMDBPodcastShow>(r, [&](uint32_t id, ZMDBPodcastShow&& s) { sink.OnPodcastShow(id, std::move(s)); });
+        read_map<ZMDBAlbum>(r, [&](uint32_t id, ZMDBAlbum&& a) { sink.OnAlbum(id, std::move(a)); });
+        read_map<ZMDBArtist>(r, [&](uint32_t id, ZMDBArtist&& a) { sink.OnArtist(id, std::move(a)); });
+        read_map<ZMDBGenre>(r, [&](uint32_t id, ZMDBGenre&& g) { sink.OnGenre(id, std::move(g)); });
+
+        if (!r.at_end()) {
+            throw std::runtime_error("Snapshot has trailing bytes");
+        }
+    } catch (const std::exception&) {
+        sink.Reset();
+        return false;
+    }
+    sink.Finish(std::move(strings));
+    return true;
+}
+
+// The library a sink read produced, or nullopt on a miss
+template <typename Read>
+std::optional<ZMDBLibrary> read_library(zune::DeviceFamily device_family, Read read) {
+    ZMDBLibrary library;
+    library.device_family = device_family;
+    ZMDBLibrarySink sink(library);
+    if (!read(sink)) {
+        return std::nullopt;
+    }
+    return library;
+}
+
+} // namespace
+
+std::optional<ZMDBLibrary> read_library_snapshot(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    zune::DeviceFamily device_family) {
+
+    return read_library(device_family, [&](ZMDBRecordSink& sink) {
+        return read_library_snapshot(path, zmdb_hash, zmdb_size, device_family, sink);
+    });
+}
+
+bool read_library_snapshot(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    zune::DeviceFamily device_family,
+    ZMDBRecordSink& sink,
+    bool accept_deferred) {
+
+    return read_snapshot(path, device_family, accept_deferred, [&](uint64_t hash, uint64_t size, uint64_t) {
+        return hash == zmdb_hash && size == zmdb_size;
+    }, sink);
+}
+
+std::optional<ZMDBLibrary> read_library_snapshot_for_device(
+    const std::string& path,
+    uint64_t device_fingerprint,
+    zune::DeviceFamily device_family) {
+
+    return read_library(device_family, [&](ZMDBRecordSink& sink) {
+        return read_library_snapshot_for_device(path, device_fingerprint, device_family, sink);
+    });
+}
+
+bool read_library_snapshot_for_device(
+    const std::string& path,
+    uint64_t device_fingerprint,
+    zune::DeviceFamily device_family,
+    ZMDBRecordSink& sink,
+    bool accept_deferred) {
+
+    if (device_fingerprint == 0) {
+        return false;
+    }
+    return read_snapshot(path, device_family, accept_deferred, [&](uint64_t, uint64_t, uint64_t fingerprint) {
+        return fingerprint == device_fingerprint;
+    }, sink);
+}
+
+bool update_snapshot_fingerprint(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    uint64_t device_fingerprint) {
+
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file) {
+        return false;
+    }
+    uint8_t header[kFingerprintOffset + 8];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    auto field = [&](size_t offset, size_t width) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < width; i++) value |= static_cast<uint64_t>(header[offset + i]) << (8 * i);
+        return value;
+    };
+    if (std::memcmp(header, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+        field(4, 4) != kSnapshotVersion || field(12, 8) != zmdb_hash || field(20, 8) != zmdb_size) {
+        return false;
+    }
+    if (field(kFingerprintOffset, 8) == device_fingerprint) {
+        return true;
+    }
+
+    uint8_t value[8];
+    for (size_t i = 0; i < sizeof(value); i++) value[i] = static_cast<uint8_t>(device_fingerprint >> (8 * i));
+    file.seekp(kFingerprintOffset);
+    file.write(reinterpret_cast<const char*>(value), sizeof(value));
+    return static_cast<bool>(file);
+}
+
+} // namespace zmdb
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "ZMDBTypes.h"
+#include "ZMDBParserBase.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace zmdb {
+
+/**
+ * On-host snapshot of a parsed ZMDBLibrary.
+ *
+ * Reconnecting a device whose library has not changed still means reading
+ * the ZMDB over USB, but the parse can be skipped: the raw ZMDB bytes are
+ * hashed and, if a snapshot written for the same hash and device family
+ * exists, the library is decoded from it instead.
+ *
+ * A snapshot can also carry a device fingerprint (see
+ * MtpReader::ReadLibraryFingerprint), a cheap summary of the device's
+ * contents taken before the ZMDB was read. When the device still reports
+ * the same fingerprint, the snapshot stands in for the ZMDB read itself.
+ *
+ * File layout (little-endian):
+ *   "XZSN" magic, u32 format version, u32 device family, u64 ZMDB hash,
+ *   u64 ZMDB size, u64 device fingerprint (0 = none), u8 details deferred,
+ *   u32 record count per media collection, the records of each collection,
+ *   then the podcast show, album, artist and genre maps (u32 count, then
+ *   u32 atom_id + record each). Strings are u32 length + UTF-8 bytes.
+ *
+ * Sections follow ZMDBRecordSink's call order, so a snapshot is written
+ * from the records passing through a sink (ZMDBSnapshotSink) and read
+ * back straight into one, without a ZMDBLibrary on either side.
+ *
+ * A snapshot that is missing, truncated, from another format version, or
+ * keyed to different ZMDB bytes is reported as a miss; callers fall back to
+ * parsing.
+ */
+
+/**
+ * 64-bit hash of the raw ZMDB bytes (FNV-1a over 8-byte words).
+ *
+ * Not cryptographic; used only to detect whether the device library
+ * changed since the snapshot was written.
+ *
+ * @param data Raw ZMDB bytes
+ * @return Hash value
+ */
+uint64_t hash_zmdb(ByteView data);
+
+/**
+ * Write library to path, keyed by the hash and size of the ZMDB it was
+ * parsed from. Written to a temporary file and renamed into place so a
+ * crash mid-write never leaves a half-written snapshot behind.
+ *
+ * @param path Snapshot file path
+ * @param zmdb_hash hash_zmdb() of the source ZMDB
+ * @param zmdb_size Size of the source ZMDB in bytes
+ * @param library Parsed library
+ * @param device_fingerprint Device fingerprint taken before the ZMDB was
+ *        read, 0 if none
+ * @return true on success
+ */
+bool write_library_snapshot(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    const ZMDBLibrary& library,
+    uint64_t device_fingerprint = 0
+);
+
+/**
+ * Sink that records a snapshot of the records passing through it.
+ *
+ * Each call is encoded, then forwarded to next, so a parse that refreshes
+ * the snapshot still hands every record to the consumer once, as it is
+ * parsed. Only the encoded bytes are kept (about the size of the ZMDB);
+ * Write stores them once the extraction has finished.
+ */
+class ZMDBSnapshotSink : public ZMDBRecordSink {
+public:
+    ZMDBSnapshotSink(ZMDBRecordSink& next, zune::DeviceFamily device_family);
+    ~ZMDBSnapshotSink() override;
+
+    void Begin(const ZMDBExtractionPlan& plan) override;
+    void OnTrack(ZMDBTrack&& track) override;
+    void OnVideo(ZMDBVideo&& video) override;
+    void OnPicture(ZMDBPicture&& picture) override;
+    void OnPlaylist(ZMDBPlaylist&& playlist) override;
+    void OnPodcast(ZMDBPodcast&& podcast) override;
+    void OnAudiobook(ZMDBAudiobook&& audiobook) override;
+    void OnPodcastShow(uint32_t atom_id, ZMDBPodcastShow&& show) override;
+    void OnAlbum(uint32_t atom_id, ZMDBAlbum&& album) override;
+    void OnArtist(uint32_t atom_id, ZMDBArtist&& artist) override;
+    void OnGenre(uint32_t atom_id, ZMDBGenre&& genre) override;
+    void Finish(StringInternTable&& strings) override;
+    void Reset() override;
+
+    /**
+     * Write the records received so far to path, like
+     * write_library_snapshot. Does nothing unless Finish was called.
+     *
+     * @return true on success
+     */
+    bool Write(
+        const std::string& path,
+        uint64_t zmdb_hash,
+        uint64_t zmdb_size,
+        uint64_t device_fingerprint = 0
+    ) const;
+
+private:
+    struct Sections;
+
+    ZMDBRecordSink& next_;
+    zune::DeviceFamily device_family_;
+    std::unique_ptr<Sections> sections_;
+    bool finished_ = false;
+};
+
+/**
+ * Load a library snapshot if it matches the given ZMDB.
+ *
+ * @param path Snapshot file path
+ * @param zmdb_hash hash_zmdb() of the current ZMDB
+ * @param zmdb_size Size of the current ZMDB in bytes
+ * @param device_family Family the library would be parsed as
+ * @return Library, or nullopt on miss / unreadable snapshot
+ */
+std::optional<ZMDBLibrary> read_library_snapshot(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    zune::DeviceFamily device_family
+);
+
+/**
+ * Decode a matching library snapshot straight into sink, with the calls
+ * a parse of the same ZMDB would make.
+ *
+ * The header is checked before anything reaches sink. A snapshot found
+ * corrupt part way through calls sink.Reset() and reports a miss.
+ *
+ * @param sink Receives the records
+ * @param accept_deferred false to treat a snapshot written without
+ *        details (ZMDBParserBase::SetDeferredDetails) as a miss
+ * @return true if sink received the library
+ */
+bool read_library_snapshot(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    zune::DeviceFamily device_family,
+    ZMDBRecordSink& sink,
+    bool accept_deferred = true
+);
+
+/**
+ * Load a library snapshot without the ZMDB, if it was written with the
+ * given device fingerprint.
+ *
+ * @param path Snapshot file path
+ * @param device_fingerprint Fingerprint the device reports now (0 never matches)
+ * @param device_family Family the library would be parsed as
+ * @return Library, or nullopt on miss / unreadable snapshot
+ */
+std::optional<ZMDBLibrary> read_library_snapshot_for_device(
+    const std::string& path,
+    uint64_t device_fingerprint,
+    zune::DeviceFamily device_family
+);
+
+/**
+ * read_library_snapshot_for_device into sink (see read_library_snapshot)
+ */
+bool read_library_snapshot_for_device(
+    const std::string& path,
+    uint64_t device_fingerprint,
+    zune::DeviceFamily device_family,
+    ZMDBRecordSink& sink,
+    bool accept_deferred = true
+);
+
+/**
+ * Re-key a snapshot that still matches the ZMDB to a new device
+ * fingerprint, in place (for a fingerprint that moved without the
+ * library changing, e.g. after copying a non-media file).
+ *
+ * @param path Snapshot file path
+ * @param zmdb_hash hash_zmdb() of the current ZMDB
+ * @param zmdb_size Size of the current ZMDB in bytes
+ * @param device_fingerprint Fingerprint taken before the ZMDB was read
+ * @return true if the snapshot now carries device_fingerprint
+ */
+bool update_snapshot_fingerprint(
+    const std::string& path,
+    uint64_t zmdb_hash,
+    uint64_t zmdb_size,
+    uint64_t device_fingerprint
+);
+
+} // namespace zmdb
@@ -0,0 +1,57 @@
+#include "ZMDBStream.h"
+#include <cstring>
+
+namespace zmdb {
+
+ZMDBStreamBuffer::ZMDBStreamBuffer(size_t total_size)
+    : data_(total_size) {}
+
+size_t ZMDBStreamBuffer::Append(const uint8_t* data, size_t size) {
+    size_t received = received_.load(std::memory_order_relaxed);
+    size_t accepted = std::min(size, data_.size() - received);
+    if (accepted == 0) {
+        return 0;
+    }
+
+    std::memcpy(data_.data() + received, data, accepted);
+    {
+        // Publish under the lock so a reader between its check and its
+        // wait cannot miss the notification
+        std::lock_guard<std::mutex> lock(mutex_);
+        received_.store(received + accepted, std::memory_order_release);
+    }
+    cv_.notify_all();
+    return accepted;
+}
+
+void ZMDBStreamBuffer::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    cv_.notify_all();
+}
+
+bool ZMDBStreamBuffer::WaitFor(size_t end) const {
+    end = std::min(end, data_.size());
+    if (Received() >= end) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return finished_ || Received() >= end; });
+    return Received() >= end;
+}
+
+bool ZMDBStreamBuffer::Complete() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_ && Received() == data_.size();
+}
+
+std::vector<uint8_t> ZMDBStreamBuffer::Release() {
+    std::vector<uint8_t> out;
+    out.swap(data_);
+    received_.store(0, std::memory_order_release);
+    return out;
+}
+
+} // namespace zmdb
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ZMDBTypes.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace zmdb {
+
+/**
+ * ZMDB blob that is filled while it is being parsed.
+ *
+ * The full size is known from the 12-byte ZMDB transfer header, so the
+ * buffer is allocated once up front and never moves: the transfer thread
+ * appends chunks as they arrive off the bulk pipe, and the parser (see
+ * ZMDBParserBase::ExtractLibraryStreaming) reads the same bytes through
+ * View(), blocking in WaitFor() only when it needs a byte that hasn't
+ * arrived yet.
+ *
+ * One writer, any number of readers. Bytes below Received() are never
+ * written again, so readers access them without locking.
+ */
+class ZMDBStreamBuffer {
+public:
+    explicit ZMDBStreamBuffer(size_t total_size);
+
+    ZMDBStreamBuffer(const ZMDBStreamBuffer&) = delete;
+    ZMDBStreamBuffer& operator=(const ZMDBStreamBuffer&) = delete;
+
+    /**
+     * View over the whole blob, including bytes not yet received.
+     */
+    ByteView View() const { return ByteView(data_.data(), data_.size()); }
+
+    size_t TotalSize() const { return data_.size(); }
+    size_t Received() const { return received_.load(std::memory_order_acquire); }
+
+    /**
+     * True once [0, end) has arrived. end is clamped to the total size.
+     */
+    bool IsAvailable(size_t end) const {
+        return Received() >= std::min(end, data_.size());
+    }
+
+    /**
+     * Append the next chunk of the transfer (writer thread only). Bytes
+     * beyond the total size are dropped.
+     *
+     * @return Number of bytes accepted
+     */
+    size_t Append(const uint8_t* data, size_t size);
+
+    /**
+     * Mark the transfer finished, successfully or not, and wake all waiters.
+     */
+    void Finish();
+
+    /**
+     * Block until [0, end) has arrived or the transfer has finished.
+     *
+     * @param end Exclusive end offset (clamped to the total size)
+     * @return true if the bytes are available; false if the transfer
+     *         finished short of end
+     */
+    bool WaitFor(size_t end) const;
+
+    /**
+     * True once Finish() was called and every byte arrived.
+     */
+    bool Complete() const;
+
+    /**
+     * Take ownership of the bytes. Only valid after Finish(), and once no
+     * parser is reading View() any more.
+     */
+    std::vector<uint8_t> Release();
+
+private:
+    std::vector<uint8_t> data_;
+    std::atomic<size_t> received_{0};
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    bool finished_ = false;
+};
+
+} // namespace zmdb
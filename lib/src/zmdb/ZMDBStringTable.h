@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace zmdb {
+
+/**
+ * Immutable, reference-counted string shared between records.
+ *
+ * Track fields that repeat across a library (artist, genre, album .alb
+ * reference) hold a SharedString handed out by a StringInternTable, so a
+ * library with 40k tracks but 2k artists stores each artist name once.
+ * Reads like a const std::string (implicit conversion, c_str, empty, ==).
+ *
+ * Assigning a std::string or literal directly creates a private,
+ * un-interned copy - fine for tests and hand-built libraries, but parsers
+ * should go through StringInternTable::intern.
+ */
+class SharedString {
+public:
+    SharedString() = default;
+    SharedString(std::string value)
+        : node_(value.empty() ? nullptr : std::make_shared<const std::string>(std::move(value))) {}
+    SharedString(const char* value) : SharedString(std::string(value)) {}
+
+    const std::string& str() const { return node_ ? *node_ : empty_string(); }
+    operator const std::string&() const { return str(); }
+
+    const char* c_str() const { return str().c_str(); }
+    size_t size() const { return str().size(); }
+    bool empty() const { return !node_; }
+
+    /**
+     * Address of the shared entry: equal for copies of the same interned
+     * string, nullptr for the empty string. Lets consumers convert each
+     * unique entry once.
+     */
+    const void* identity() const { return node_.get(); }
+
+    friend bool operator==(const SharedString& a, const SharedString& b) {
+        return a.node_ == b.node_ || a.str() == b.str();
+    }
+    friend bool operator==(const SharedString& a, const std::string& b) { return a.str() == b; }
+    friend bool operator==(const std::string& a, const SharedString& b) { return a == b.str(); }
+    friend bool operator==(const SharedString& a, const char* b) { return a.str() == b; }
+    friend bool operator==(const char* a, const SharedString& b) { return a == b.str(); }
+    friend bool operator!=(const SharedString& a, const SharedString& b) { return !(a == b); }
+    friend bool operator!=(const SharedString& a, const std::string& b) { return !(a == b); }
+    friend bool operator!=(const std::string& a, const SharedString& b) { return !(a == b); }
+    friend bool operator!=(const SharedString& a, const char* b) { return !(a == b); }
+    friend bool operator!=(const char* a, const SharedString& b) { return !(a == b); }
+
+    friend std::ostream& operator<<(std::ostream& os, const SharedString& s) {
+        return os << s.str();
+    }
+
+private:
+    friend class StringInternTable;
+
+    static const std::string& empty_string() {
+        static const std::string empty;
+        return empty;
+    }
+
+    std::shared_ptr<const std::string> node_;
+};
+
+/**
+ * Content-keyed table of SharedStrings.
+ *
+ * intern() returns the existing entry for equal content, so every record
+ * referring to the same artist/genre shares one allocation. Entries are
+ * reference counted: records stay valid if the table is cleared or
+ * destroyed first. Not thread-safe; parallel parser workers each intern
+ * into their own table and their records are re-interned into the main
+ * table when chunks are merged.
+ */
+class StringInternTable {
+public:
+    SharedString intern(std::string_view value) {
+        if (value.empty()) {
+            return SharedString();
+        }
+        auto it = entries_.find(value);
+        if (it != entries_.end()) {
+            return it->second;
+        }
+        SharedString entry;
+        entry.node_ = std::make_shared<const std::string>(value);
+        // Key views the entry's own bytes, which never move
+        entries_.emplace(std::string_view(*entry.node_), entry);
+        return entry;
+    }
+
+    size_t size() const { return entries_.size(); }
+    void clear() { entries_.clear(); }
+
+private:
+    std::unordered_map<std::string_view, SharedString> entries_;
+};
+
+} // namespace zmdb
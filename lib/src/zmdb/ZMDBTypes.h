@@ -1,10 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
 #include "../ZuneDeviceIdentification.h"
+#include "ZMDBStringTable.h"
 
 namespace zmdb {
 
@@ -38,9 +40,10 @@ namespace Schema {
 // Music track structure
 struct ZMDBTrack {
     std::string title;
-    std::string artist_name;
-    std::string artist_guid;        // Artist GUID from field 0x14 (optional)
-    std::string genre;
+    // Repeated across tracks; interned in ZMDBLibrary::strings
+    SharedString artist_name;
+    SharedString artist_guid;       // Artist GUID from field 0x14 (optional)
+    SharedString genre;
     int track_number = 0;           // Track number (offset 24-25)
     int disc_number = 1;            // Disc number (varint field 0x6c, default=1 if absent)
     int duration_ms = 0;            // Duration in milliseconds (offset 16-19)
@@ -58,7 +61,7 @@ struct ZMDBTrack {
     // .alb filename (e.g. "Unknown Album.alb"). ZMDB track records do NOT
     // store a per-file track filename; the authoritative track filename is
     // the MTP ObjectInfo.Filename property, outside ZMDB.
-    std::string album_alb_ref;
+    SharedString album_alb_ref;
 };
 
 // Album structure (metadata only - tracks are grouped separately)
@@ -170,7 +173,9 @@ struct ZMDBPlaylist {
     std::string guid;
     std::string folder;             // Folder reference (usually "Playlists")
     int track_count = 0;
-    std::vector<uint32_t> track_atom_ids;  // Track atom_ids (no need to resolve full tracks)
+    // Entries as track atom_ids, never re-parsed tracks: each names a record
+    // already in ZMDBLibrary::tracks (zune::LibraryIndex::FindTrackByAtom)
+    std::vector<uint32_t> track_atom_ids;
     uint32_t atom_id = 0;
 };
 
@@ -265,6 +270,10 @@ struct ZMDBLibrary {
     // Podcast show metadata (atom_id = MTP handle of .ser object)
     std::map<uint32_t, ZMDBPodcastShow> podcast_show_metadata;
 
+    // Interned strings shared by the track records (artist, genre, .alb
+    // reference). Entries are reference counted, so records outlive it safely.
+    StringInternTable strings;
+
     // Counts
     int album_count = 0;
     int track_count = 0;
@@ -277,6 +286,10 @@ struct ZMDBLibrary {
     int genre_count = 0;
     int audiobook_count = 0;
 
+    // Video descriptions and podcast episode descriptions/URLs were left
+    // undecoded (ZMDBParserBase::SetDeferredDetails); those strings are empty
+    bool details_deferred = false;
+
     // Capacities (for tracking allocated sizes)
     int tracks_capacity = 0;
     int videos_capacity = 0;
@@ -342,6 +355,7 @@ struct ZMDBLibrary {
           artist_metadata(std::move(other.artist_metadata)),
           genre_metadata(std::move(other.genre_metadata)),
           podcast_show_metadata(std::move(other.podcast_show_metadata)),
+          strings(std::move(other.strings)),
           album_count(other.album_count),
           track_count(other.track_count),
           video_count(other.video_count),
@@ -352,6 +366,7 @@ struct ZMDBLibrary {
           artist_count(other.artist_count),
           genre_count(other.genre_count),
           audiobook_count(other.audiobook_count),
+          details_deferred(other.details_deferred),
           tracks_capacity(other.tracks_capacity),
           videos_capacity(other.videos_capacity),
           pictures_capacity(other.pictures_capacity),
@@ -396,11 +411,54 @@ struct ZMDBLibrary {
     ZMDBLibrary() = default;
 };
 
+/**
+ * Non-owning view over a contiguous byte range.
+ *
+ * Records, varint fields and string payloads are handed around as views into
+ * the caller's ZMDB buffer so the parsers never copy per record. A view is
+ * only valid while the buffer it was taken from is alive and unmodified.
+ * Implicitly constructible from std::vector<uint8_t> so existing callers
+ * passing vectors keep working.
+ */
+class ByteView {
+public:
+    ByteView() = default;
+    ByteView(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+    ByteView(const std::vector<uint8_t>& vec) : data_(vec.data()), size_(vec.size()) {}
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const uint8_t* begin() const { return data_; }
+    const uint8_t* end() const { return data_ + size_; }
+
+    uint8_t operator[](size_t i) const { return data_[i]; }
+    uint8_t front() const { return data_[0]; }
+    uint8_t back() const { return data_[size_ - 1]; }
+
+    /**
+     * Sub-range starting at offset, clamped to the end of this view.
+     */
+    ByteView subview(size_t offset, size_t length = SIZE_MAX) const {
+        if (offset >= size_) return ByteView(data_ + size_, 0);
+        return ByteView(data_ + offset, std::min(length, size_ - offset));
+    }
+
+    std::vector<uint8_t> to_vector() const {
+        return std::vector<uint8_t>(data_, data_ + size_);
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
 // Parsed field from backwards varint section
 struct BackwardsVarintField {
     uint32_t field_id = 0;
     uint32_t field_size = 0;
-    std::vector<uint8_t> field_data;
+    ByteView field_data;  // View into the record the field was parsed from
     size_t offset = 0;  // Offset within record
 };
 
@@ -1,85 +1,97 @@
 #include "ZMDBUtils.h"
+#include "ZMDBFieldSchema.h"
 #include <cstring>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
 
-namespace zmdb {
+// Vector paths for UTF-16LE decoding. SSE2 is baseline on x86-64; NEON's
+// horizontal min/max (vminvq/vmaxvq) are AArch64-only. Everything else
+// uses the 64-bit word path.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZMDB_UTF16_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ZMDB_UTF16_NEON 1
+#endif
 
-std::vector<BackwardsVarintField> parse_backwards_varints(
-    const std::vector<uint8_t>& record_data,
-    size_t entry_size
-) {
-    std::vector<BackwardsVarintField> fields;
+namespace zmdb {
 
-    if (record_data.size() <= entry_size) {
-        return fields;  // No varint section
+namespace {
+
+#if defined(ZMDB_UTF16_SSE2) || defined(ZMDB_UTF16_NEON)
+constexpr size_t kUtf16Block = 8;  // Code units per vector
+#else
+constexpr size_t kUtf16Block = 4;  // Code units per uint64_t
+#endif
+
+/**
+ * Convert kUtf16Block code units at src to ASCII bytes at dst if every unit
+ * is in 0x01-0x7F. Writes nothing and returns false otherwise (non-ASCII or
+ * a terminator in the block), leaving the block to the scalar path.
+ */
+inline bool convert_ascii_block(const uint8_t* src, char* dst) {
+#if defined(ZMDB_UTF16_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80))), zero);
+    __m128i ok = _mm_andnot_si128(_mm_cmpeq_epi16(v, zero), ascii);
+    if (_mm_movemask_epi8(ok) != 0xFFFF) {
+        return false;
     }
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(v, v));
+    return true;
+#elif defined(ZMDB_UTF16_NEON)
+    uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src));
+    if (vmaxvq_u16(v) >= 0x80 || vminvq_u16(v) == 0) {
+        return false;
+    }
+    vst1_u8(reinterpret_cast<uint8_t*>(dst), vmovn_u16(v));
+    return true;
+#else
+    uint64_t w;
+    std::memcpy(&w, src, sizeof(w));
+    // Any unit >= 0x80, or any zero unit (classic has-zero test on 16-bit
+    // lanes; exact here because no lane has bit 15 set)
+    if ((w & 0xFF80FF80FF80FF80ULL) != 0 ||
+        ((w - 0x0001000100010001ULL) & ~w & 0x8000800080008000ULL) != 0) {
+        return false;
+    }
+    for (size_t k = 0; k < 4; k++) {
+        dst[k] = static_cast<char>(w >> (16 * k));  // Little-endian host, as read_uint32_le
+    }
+    return true;
+#endif
+}
 
-    // Start from end of record and read backwards
-    size_t pos = record_data.size() - 1;
-
-    while (pos >= entry_size) {
-        // Read field_id (1-2 bytes)
-        if (pos < entry_size) break;
-
-        uint8_t field_id_byte1 = record_data[pos--];
-
-        if (field_id_byte1 == 0) {  // End marker
-            break;
-        }
-
-        uint32_t field_id = field_id_byte1;
-
-        if (field_id_byte1 & 0x80) {  // Multi-byte encoding
-            if (pos < entry_size) break;
-            uint8_t field_id_byte2 = record_data[pos--];
-            field_id = (field_id_byte2 << 7) | (field_id_byte1 & 0x7F);
-        }
-
-        // Read field_size (1-3 bytes)
-        if (pos < entry_size) break;
-
-        uint8_t size_byte1 = record_data[pos--];
-        uint32_t field_size = size_byte1;
-
-        // LEB128-style varint, walked backward. Continuation bit is set on
-        // every non-terminal byte. The previous gate `size_byte2 != 0`
-        // mis-fired on any 2-byte size with a non-zero high chunk
-        // (i.e. anything ≥ 128), shifting subsequent reads by one byte.
-        if (size_byte1 & 0x80) {
-            if (pos < entry_size) break;
-            uint8_t size_byte2 = record_data[pos--];
-            field_size = (size_byte2 << 7) | (size_byte1 & 0x7F);
-
-            if (size_byte2 & 0x80) {
-                if (pos < entry_size) break;
-                uint8_t size_byte3 = record_data[pos--];
-                field_size = (size_byte3 << 14) | (field_size & 0x3FFF);
-            }
-        }
-
-        // Extract field data
-        size_t field_end = pos + 1;
-        if (field_size > field_end || field_end - field_size < entry_size) {
-            break;  // Invalid field size
-        }
-
-        size_t field_start = field_end - field_size;
+/**
+ * True if any of the kUtf16Block code units at src is zero.
+ */
+inline bool block_has_null(const uint8_t* src) {
+#if defined(ZMDB_UTF16_SSE2)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_setzero_si128())) != 0;
+#elif defined(ZMDB_UTF16_NEON)
+    uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src));
+    return vminvq_u16(v) == 0;
+#else
+    uint64_t w;
+    std::memcpy(&w, src, sizeof(w));
+    return ((w - 0x0001000100010001ULL) & ~w & 0x8000800080008000ULL) != 0;
+#endif
+}
 
-        BackwardsVarintField field;
-        field.field_id = field_id;
-        field.field_size = field_size;
-        field.offset = field_start;
-        field.field_data.assign(
-            record_data.begin() + field_start,
-            record_data.begin() + field_end
-        );
+} // namespace
 
+std::vector<BackwardsVarintField> parse_backwards_varints(
+    ByteView record_data,
+    size_t entry_size
+) {
+    std::vector<BackwardsVarintField> fields;
+    walk_backwards_varints(record_data, entry_size, [&](const BackwardsVarintField& field) {
         fields.push_back(field);
-
-        pos = field_start - 1;
-    }
+    });
 
     // Reverse to get original order
     std::reverse(fields.begin(), fields.end());
@@ -87,57 +99,28 @@ std::vector<BackwardsVarintField> parse_backwards_varints(
     return fields;
 }
 
-size_t get_entry_size_for_schema(uint8_t schema_type) {
-    // Based on Python parser analysis and ZMDB wiki documentation
-    switch (schema_type) {
-        case Schema::Music:         return 32;  // 0x01
-        case Schema::Video:         return 32;  // 0x02 (variable, use conservative estimate)
-        case Schema::Picture:       return 24;  // 0x03
-        case Schema::Filename:      return 8;   // 0x05
-        case Schema::Album:         return 20;  // 0x06
-        case Schema::Playlist:      return 12;  // 0x07
-        case Schema::Artist:        return 4;   // 0x08
-        case Schema::Genre:         return 1;   // 0x09
-        case Schema::VideoTitle:    return 4;   // 0x0a
-        case Schema::PhotoAlbum:    return 12;  // 0x0b
-        case Schema::Collection:    return 12;  // 0x0c
-        case Schema::PodcastShow:   return 8;   // 0x0f
-        case Schema::PodcastEpisode: return 32; // 0x10
-        case Schema::AudiobookTitle: return 8;  // 0x11 (ref0, ref1 + title string)
-        case Schema::AudiobookTrack: return 36; // 0x12 (fixed fields before strings)
-        case Schema::AudiobookRef:  return 12;  // 0x19 (type/counter, title_ref, reserved)
-        default:
-            return 0;  // Unknown schema
-    }
-}
-
 // UTF-16LE backwards-varint strings on video records sometimes carry a leading
 // 0x00 padding byte plus a trailing 0x00 byte around the actual UTF-16LE
 // payload. Strip them when present before conversion.
-static std::string video_utf16le_field_to_utf8(const std::vector<uint8_t>& data) {
+static std::string video_utf16le_field_to_utf8(ByteView data) {
     if (data.size() >= 2 && data[0] == 0x00 && data[data.size() - 1] == 0x00) {
-        return utf16le_to_utf8(std::vector<uint8_t>(data.begin() + 1, data.end() - 1));
+        return utf16le_to_utf8(data.subview(1, data.size() - 2));
     }
     return utf16le_to_utf8(data);
 }
 
 void parse_video_trailing_fields(
-    const std::vector<uint8_t>& record_data,
-    ZMDBVideo& video
+    ByteView record_data,
+    ZMDBVideo& video,
+    bool skip_description
 ) {
-    size_t entry_size = get_entry_size_for_schema(Schema::Video);
-    if (entry_size == 0 || record_data.size() <= entry_size) {
-        return;
-    }
-
-    auto fields = parse_backwards_varints(record_data, entry_size);
-    for (const auto& f : fields) {
+    for_each_varint_field<RecordSchema::Video>(record_data, [&](const BackwardsVarintField& f) {
         switch (f.field_id) {
             case VideoFieldId::Filename:
                 if (f.field_size > 2) video.filename = video_utf16le_field_to_utf8(f.field_data);
                 break;
             case VideoFieldId::Description:
-                if (f.field_size > 2) video.description = video_utf16le_field_to_utf8(f.field_data);
+                if (f.field_size > 2 && !skip_description) video.description = video_utf16le_field_to_utf8(f.field_data);
                 break;
             case VideoFieldId::Artist:
                 if (f.field_size > 2) video.artist_name = video_utf16le_field_to_utf8(f.field_data);
@@ -160,15 +143,30 @@ void parse_video_trailing_fields(
             default:
                 break;
         }
-    }
+    });
 }
 
-std::string utf16le_to_utf8(const std::vector<uint8_t>& data) {
-    std::string result;
-    result.reserve(data.size() / 2);  // Estimate
+std::string utf16le_to_utf8(ByteView data) {
+    const uint8_t* src = data.data();
+    const size_t units = data.size() / 2;
+
+    // Sized for all-ASCII output; widened to the 3-bytes-per-unit worst case
+    // for the remainder on the first non-ASCII unit
+    std::string result(units, '\0');
+    char* out = &result[0];
+    size_t written = 0;
+    bool widened = false;
+
+    size_t i = 0;
+    while (i < units) {
+        // ASCII fast path: a whole block per step
+        if (i + kUtf16Block <= units && convert_ascii_block(src + 2 * i, out + written)) {
+            i += kUtf16Block;
+            written += kUtf16Block;
+            continue;
+        }
 
-    for (size_t i = 0; i + 1 < data.size(); i += 2) {
-        uint16_t code_unit = data[i] | (data[i + 1] << 8);
+        uint16_t code_unit = src[2 * i] | (src[2 * i + 1] << 8);
 
         if (code_unit == 0) {
             break;  // Null terminator
@@ -176,22 +174,47 @@ std::string utf16le_to_utf8(const std::vector<uint8_t>& data) {
 
         // Basic UTF-16 to UTF-8 conversion (BMP only)
         if (code_unit < 0x80) {
-            result += static_cast<char>(code_unit);
-        } else if (code_unit < 0x800) {
-            result += static_cast<char>(0xC0 | (code_unit >> 6));
-            result += static_cast<char>(0x80 | (code_unit & 0x3F));
+            out[written++] = static_cast<char>(code_unit);
         } else {
-            result += static_cast<char>(0xE0 | (code_unit >> 12));
-            result += static_cast<char>(0x80 | ((code_unit >> 6) & 0x3F));
-            result += static_cast<char>(0x80 | (code_unit & 0x3F));
+            if (!widened) {
+                result.resize(written + (units - i) * 3);
+                out = &result[0];
+                widened = true;
+            }
+            if (code_unit < 0x800) {
+                out[written++] = static_cast<char>(0xC0 | (code_unit >> 6));
+                out[written++] = static_cast<char>(0x80 | (code_unit & 0x3F));
+            } else {
+                out[written++] = static_cast<char>(0xE0 | (code_unit >> 12));
+                out[written++] = static_cast<char>(0x80 | ((code_unit >> 6) & 0x3F));
+                out[written++] = static_cast<char>(0x80 | (code_unit & 0x3F));
+            }
         }
+        i++;
     }
 
+    result.resize(written);
     return result;
 }
 
+size_t find_utf16le_null(ByteView data) {
+    const uint8_t* src = data.data();
+    const size_t units = data.size() / 2;
+
+    size_t i = 0;
+    while (i + kUtf16Block <= units && !block_has_null(src + 2 * i)) {
+        i += kUtf16Block;
+    }
+    for (; i < units; i++) {
+        if (src[2 * i] == 0 && src[2 * i + 1] == 0) {
+            return 2 * i;
+        }
+    }
+    return 2 * units;
+}
+
 std::string read_null_terminated_utf8(
-    const std::vector<uint8_t>& data,
+    ByteView data,
     size_t offset,
     size_t max_length
 ) {
@@ -211,13 +234,13 @@ std::string read_null_terminated_utf8(
     }
 
     return std::string(
-        reinterpret_cast<const char*>(&data[offset]),
+        reinterpret_cast<const char*>(data.data() + offset),
         end - offset
     );
 }
 
 std::string read_utf16le_until_double_null(
-    const std::vector<uint8_t>& data,
+    ByteView data,
     size_t offset,
     size_t max_length
 ) {
@@ -225,74 +248,68 @@ std::string read_utf16le_until_double_null(
         return "";
     }
 
-    std::vector<uint8_t> utf16_data;
-    size_t pos = offset;
     size_t limit = std::min(offset + max_length, data.size() - 1);
 
-    while (pos + 1 < limit) {
-        uint16_t code_unit = data[pos] | (data[pos + 1] << 8);
-
-        if (code_unit == 0) {
-            break;  // Double-null terminator
-        }
-
-        utf16_data.push_back(data[pos]);
-        utf16_data.push_back(data[pos + 1]);
-        pos += 2;
+    // Double-null terminator, or the last whole code unit before limit
+    size_t pos = offset;
+    if (limit > offset) {
+        pos += find_utf16le_null(data.subview(offset, limit - offset));
     }
 
     // Strip leading/trailing null bytes (padding)
-    while (!utf16_data.empty() && utf16_data.front() == 0) {
-        utf16_data.erase(utf16_data.begin());
+    size_t start = offset;
+    while (start < pos && data[start] == 0) {
+        start++;
     }
-    while (!utf16_data.empty() && utf16_data.back() == 0) {
-        utf16_data.pop_back();
+    while (pos > start && data[pos - 1] == 0) {
+        pos--;
     }
 
+    ByteView utf16_data = data.subview(start, pos - start);
     return utf16le_to_utf8(utf16_data);
 }
 
-uint32_t read_uint32_le(const std::vector<uint8_t>& data, size_t offset) {
+uint32_t read_uint32_le(ByteView data, size_t offset) {
     if (offset + 4 > data.size()) {
         return 0;
     }
 
     uint32_t value;
-    std::memcpy(&value, &data[offset], 4);
+    std::memcpy(&value, data.data() + offset, 4);
     return value;  // Assuming little-endian host
 }
 
-uint64_t read_uint64_le(const std::vector<uint8_t>& data, size_t offset) {
+uint64_t read_uint64_le(ByteView data, size_t offset) {
     if (offset + 8 > data.size()) {
         return 0;
     }
 
     uint64_t value;
-    std::memcpy(&value, &data[offset], 8);
+    std::memcpy(&value, data.data() + offset, 8);
     return value;  // Assuming little-endian host
 }
 
-int32_t read_int32_le(const std::vector<uint8_t>& data, size_t offset) {
+int32_t read_int32_le(ByteView data, size_t offset) {
     if (offset + 4 > data.size()) {
         return 0;
     }
 
     int32_t value;
-    std::memcpy(&value, &data[offset], 4);
+    std::memcpy(&value, data.data() + offset, 4);
     return value;  // Assuming little-endian host
 }
 
-uint16_t read_uint16_le(const std::vector<uint8_t>& data, size_t offset) {
+uint16_t read_uint16_le(ByteView data, size_t offset) {
     if (offset + 2 > data.size()) {
         return 0;
     }
 
     uint16_t value;
-    std::memcpy(&value, &data[offset], 2);
+    std::memcpy(&value, data.data() + offset, 2);
     return value;  // Assuming little-endian host
 }
 
-std::string parse_windows_guid(const std::vector<uint8_t>& data) {
+std::string parse_windows_guid(ByteView data) {
     if (data.size() < 16) {
         return "";
     }
@@ -18,10 +18,13 @@ namespace zmdb {
  *
  * @param record_data Complete record data
  * @param entry_size Size of fixed/comparable section (varints start here)
- * @return Vector of parsed fields
+ * @return Vector of parsed fields; field_data views into record_data
+ *
+ * Parsers use the allocation-free for_each_varint_field (ZMDBFieldSchema.h)
+ * instead; this remains for tools that want every field.
  */
 std::vector<BackwardsVarintField> parse_backwards_varints(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     size_t entry_size
 );
 
@@ -33,15 +36,49 @@ std::vector<BackwardsVarintField> parse_backwards_varints(
  * @param schema_type Schema type (0x01-0x10, etc.)
  * @return Entry size in bytes, or 0 if unknown schema
  */
-size_t get_entry_size_for_schema(uint8_t schema_type);
+constexpr size_t get_entry_size_for_schema(uint8_t schema_type) {
+    // Based on Python parser analysis and ZMDB wiki documentation
+    switch (schema_type) {
+        case Schema::Music:         return 32;  // 0x01
+        case Schema::Video:         return 32;  // 0x02 (variable, use conservative estimate)
+        case Schema::Picture:       return 24;  // 0x03
+        case Schema::Filename:      return 8;   // 0x05
+        case Schema::Album:         return 20;  // 0x06
+        case Schema::Playlist:      return 12;  // 0x07
+        case Schema::Artist:        return 4;   // 0x08
+        case Schema::Genre:         return 1;   // 0x09
+        case Schema::VideoTitle:    return 4;   // 0x0a
+        case Schema::PhotoAlbum:    return 12;  // 0x0b
+        case Schema::Collection:    return 12;  // 0x0c
+        case Schema::PodcastShow:   return 8;   // 0x0f
+        case Schema::PodcastEpisode: return 32; // 0x10
+        case Schema::AudiobookTitle: return 8;  // 0x11 (ref0, ref1 + title string)
+        case Schema::AudiobookTrack: return 36; // 0x12 (fixed fields before strings)
+        case Schema::AudiobookRef:  return 12;  // 0x19 (type/counter, title_ref, reserved)
+        default:
+            return 0;  // Unknown schema
+    }
+}
 
 /**
  * Convert UTF-16LE bytes to UTF-8 string.
  *
+ * Stops at the first zero code unit. ASCII runs are converted a vector
+ * block (SSE2/NEON, or 64-bit words elsewhere) at a time.
+ *
  * @param data UTF-16LE encoded bytes
  * @return UTF-8 string
  */
-std::string utf16le_to_utf8(const std::vector<uint8_t>& data);
+std::string utf16le_to_utf8(ByteView data);
+
+/**
+ * Find the first zero UTF-16LE code unit (two zero bytes at an even offset).
+ *
+ * @param data UTF-16LE encoded bytes
+ * @return Byte offset of the terminator, or the length of the whole code
+ *         units in data if there is none
+ */
+size_t find_utf16le_null(ByteView data);
 
 /**
  * Read null-terminated UTF-8 string from buffer.
@@ -52,7 +89,7 @@ std::string utf16le_to_utf8(const std::vector<uint8_t>& data);
  * @return UTF-8 string (empty if null found immediately or out of bounds)
  */
 std::string read_null_terminated_utf8(
-    const std::vector<uint8_t>& data,
+    ByteView data,
     size_t offset,
     size_t max_length = 256
 );
@@ -66,7 +103,7 @@ std::string read_null_terminated_utf8(
  * @return UTF-8 string (converted from UTF-16LE)
  */
 std::string read_utf16le_until_double_null(
-    const std::vector<uint8_t>& data,
+    ByteView data,
     size_t offset,
     size_t max_length = 512
 );
@@ -101,10 +138,12 @@ namespace VideoFieldId {
  *
  * @param record_data Complete video record data
  * @param video Output struct; fields corresponding to discovered varints set
+ * @param skip_description Leave video.description empty (deferred details)
  */
 void parse_video_trailing_fields(
-    const std::vector<uint8_t>& record_data,
-    ZMDBVideo& video
+    ByteView record_data,
+    ZMDBVideo& video,
+    bool skip_description = false
 );
 
 /**
@@ -114,7 +153,7 @@ void parse_video_trailing_fields(
  * @param offset Offset to read from
  * @return uint32 value, or 0 if out of bounds
  */
-uint32_t read_uint32_le(const std::vector<uint8_t>& data, size_t offset);
+uint32_t read_uint32_le(ByteView data, size_t offset);
 
 /**
  * Read uint64 little-endian from buffer.
@@ -123,7 +162,7 @@ uint32_t read_uint32_le(const std::vector<uint8_t>& data, size_t offset);
  * @param offset Offset to read from
  * @return uint64 value, or 0 if out of bounds
  */
-uint64_t read_uint64_le(const std::vector<uint8_t>& data, size_t offset);
+uint64_t read_uint64_le(ByteView data, size_t offset);
 
 /**
  * Read int32 little-endian from buffer (signed).
@@ -132,7 +171,7 @@ uint64_t read_uint64_le(const std::vector<uint8_t>& data, size_t offset);
  * @param offset Offset to read from
  * @return int32 value, or 0 if out of bounds
  */
-int32_t read_int32_le(const std::vector<uint8_t>& data, size_t offset);
+int32_t read_int32_le(ByteView data, size_t offset);
 
 /**
  * Read uint16 little-endian from buffer.
@@ -141,7 +180,7 @@ int32_t read_int32_le(const std::vector<uint8_t>& data, size_t offset);
  * @param offset Offset to read from
  * @return uint16 value, or 0 if out of bounds
  */
-uint16_t read_uint16_le(const std::vector<uint8_t>& data, size_t offset);
+uint16_t read_uint16_le(ByteView data, size_t offset);
 
 /**
  * Parse Windows GUID from 16 bytes to string format.
@@ -157,6 +196,6 @@ uint16_t read_uint16_le(const std::vector<uint8_t>& data, size_t offset);
  * @param data 16-byte GUID data
  * @return GUID string or empty string if invalid
  */
-std::string parse_windows_guid(const std::vector<uint8_t>& data);
+std::string parse_windows_guid(ByteView data);
 
 } // namespace zmdb
@@ -1,5 +1,7 @@
 #include "ZuneClassicParser.h"
 #include "ZMDBUtils.h"
+#include "ZMDBFieldSchema.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <sstream>
@@ -7,32 +9,34 @@
 
 namespace zmdb {
 
-ZMDBLibrary ZuneClassicParser::ExtractLibrary(const std::vector<uint8_t>& zmdb_data) {
-    ZMDBLibrary library;
-    library.device_family = zune::DeviceFamily::Unknown;
+zune::DeviceFamily ZuneClassicParser::library_family() const {
+    return zune::DeviceFamily::Unknown;
+}
 
+void ZuneClassicParser::extract_records(ByteView zmdb_data, ZMDBRecordSink& sink) {
     if (zmdb_data.empty()) {
-        return library;
+        return;
     }
 
     zmdb_data_ = zmdb_data;
+    wait_for_bytes(0x100);  // Headers and the window searched for ZArr
 
     if (zmdb_data_.size() < 0x10) {
-        return library;
+        return;
     }
 
     if (zmdb_data_[0] != 'Z' || zmdb_data_[1] != 'M' ||
         zmdb_data_[2] != 'D' || zmdb_data_[3] != 'B') {
-        return library;
+        return;
     }
 
     if (zmdb_data_.size() < 0x30) {
-        return library;
+        return;
     }
 
     if (zmdb_data_[0x20] != 'Z' || zmdb_data_[0x21] != 'M' ||
         zmdb_data_[0x22] != 'e' || zmdb_data_[0x23] != 'd') {
-        return library;
+        return;
     }
 
     // ZMed version: 2 = Classic, 5 = HD. Mismatch is non-fatal — caller picks
@@ -51,9 +55,10 @@ ZMDBLibrary ZuneClassicParser::ExtractLibrary(const std::vector<uint8_t>& zmdb_d
     }
 
     if (descriptor_offset == 0) {
-        return library;
+        return;
     }
 
+    wait_for_bytes(descriptor_offset + 96 * 20);
     descriptors_.resize(96);
     for (int i = 0; i < 96; i++) {
         size_t desc_offset = descriptor_offset + (i * 20);
@@ -67,121 +72,74 @@ ZMDBLibrary ZuneClassicParser::ExtractLibrary(const std::vector<uint8_t>& zmdb_d
     }
 
     if (descriptors_[0].entry_count > 0 && descriptors_[0].entry_size == 8) {
-        index_table_ = build_index_table(
+        index_table_ = std::make_shared<const IndexTable>(build_index_table(
             zmdb_data_,
             descriptors_[0].data_offset,
             descriptors_[0].entry_count
-        );
-    }
-
-    // Descriptor → schema mappings differ from Zune HD. Capacities sized
-    // from descriptor entry_count to avoid reallocation during parsing.
-    if (descriptors_.size() > 1 && descriptors_[1].entry_count > 0) {
-        library.tracks_capacity = descriptors_[1].entry_count;
-        library.tracks = static_cast<ZMDBTrack*>(::operator new[](library.tracks_capacity * sizeof(ZMDBTrack)));
-    }
-    if (descriptors_.size() > 11 && descriptors_[11].entry_count > 0) {
-        // Playlists use descriptor 11 (same as Zune HD)
-        library.playlists_capacity = descriptors_[11].entry_count;
-        library.playlists = static_cast<ZMDBPlaylist*>(::operator new[](library.playlists_capacity * sizeof(ZMDBPlaylist)));
-    }
-    if (descriptors_.size() > 12 && descriptors_[12].entry_count > 0) {
-        library.videos_capacity = descriptors_[12].entry_count;
-        library.videos = static_cast<ZMDBVideo*>(::operator new[](library.videos_capacity * sizeof(ZMDBVideo)));
-    }
-    if (descriptors_.size() > 16 && descriptors_[16].entry_count > 0) {
-        library.pictures_capacity = descriptors_[16].entry_count;
-        library.pictures = static_cast<ZMDBPicture*>(::operator new[](library.pictures_capacity * sizeof(ZMDBPicture)));
-    }
+        ));
+    }
+
+    // Descriptor → schema mappings differ from Zune HD (audiobooks on 27,
+    // not 26). Capacities sized from descriptor entry_count to avoid
+    // reallocation during parsing.
+    auto entries = [this](size_t idx) {
+        return idx < descriptors_.size() ? static_cast<int>(descriptors_[idx].entry_count) : 0;
+    };
+    ZMDBExtractionPlan plan;
+    plan.tracks = entries(1);
+    plan.playlists = entries(11);
+    plan.videos = entries(12);
+    plan.pictures = entries(16);
     // Audio episodes (descriptor 19) plus video-podcast records promoted
     // out of Schema 0x02 (descriptor 12). Over-allocates by the number of
     // non-podcast videos in descriptor 12; cheap and avoids a pre-pass.
     if (descriptors_.size() > 19) {
-        size_t audio_episodes = descriptors_[19].entry_count;
-        size_t potential_video_podcasts =
-            (descriptors_.size() > 12) ? descriptors_[12].entry_count : 0;
-        library.podcasts_capacity =
-            static_cast<int>(audio_episodes + potential_video_podcasts);
-        if (library.podcasts_capacity > 0) {
-            library.podcasts = static_cast<ZMDBPodcast*>(::operator new[](
-                library.podcasts_capacity * sizeof(ZMDBPodcast)));
-        }
-    }
-    if (descriptors_.size() > 27 && descriptors_[27].entry_count > 0) {
-        // Audiobooks on Classic use descriptor 27 (vs 26 on HD)
-        library.audiobooks_capacity = descriptors_[27].entry_count;
-        library.audiobooks = static_cast<ZMDBAudiobook*>(::operator new[](library.audiobooks_capacity * sizeof(ZMDBAudiobook)));
-    }
-
-    try {
-        extract_media_from_descriptor(1, Schema::Music, library);
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Music parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(11, Schema::Playlist, library);
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Playlist parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(12, Schema::Video, library);
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Video parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(16, Schema::Picture, library);
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Picture parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(19, Schema::PodcastEpisode, library);
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Podcast parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(20, Schema::PodcastShow, library);
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("PodcastShow parsing failed: ") + e.what());
-    }
-
-    try {
+        plan.podcasts = entries(19) + entries(12);
+    }
+    plan.audiobooks = entries(27);
+    plan.details_deferred = deferred_details_;
+    sink.Begin(plan);
+
+    run_extraction({
+        {1,  Schema::Music,          "Music"},
+        {11, Schema::Playlist,       "Playlist"},
+        {12, Schema::Video,          "Video"},
+        {16, Schema::Picture,        "Picture"},
+        {19, Schema::PodcastEpisode, "Podcast"},
+        {20, Schema::PodcastShow,    "PodcastShow"},
         // Audiobook tracks live in descriptor 27 on Classic, 26 on HD.
-        extract_media_from_descriptor(27, Schema::AudiobookTrack, library);
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Audiobook parsing failed: ") + e.what());
-    }
+        {27, Schema::AudiobookTrack, "Audiobook"},
+    }, sink);
 
     try {
-        library.album_metadata = std::move(album_cache_);
-        library.album_count = library.album_metadata.size();
+        album_cache_.release_each([&sink](uint32_t atom_id, ZMDBAlbum&& album) {
+            sink.OnAlbum(atom_id, std::move(album));
+        });
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Album metadata move failed: ") + e.what());
     }
 
     try {
-        library.artist_metadata = std::move(artist_cache_);
-        library.artist_count = library.artist_metadata.size();
+        artist_cache_.release_each([&sink](uint32_t atom_id, ZMDBArtist&& artist) {
+            sink.OnArtist(atom_id, std::move(artist));
+        });
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Artist metadata move failed: ") + e.what());
     }
 
     try {
-        library.genre_metadata = std::move(genre_cache_);
-        library.genre_count = library.genre_metadata.size();
+        genre_cache_.release_each([&sink](uint32_t atom_id, ZMDBGenre&& genre) {
+            sink.OnGenre(atom_id, std::move(genre));
+        });
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Genre metadata move failed: ") + e.what());
     }
 
-    return library;
+    release_strings(sink);
 }
 
 bool ZuneClassicParser::should_filter_record(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint8_t schema_type
 ) const {
     if (record_data.size() < 12) {
@@ -208,7 +166,7 @@ size_t ZuneClassicParser::get_entry_size_for_schema(uint8_t schema_type) const {
 }
 
 std::optional<ZMDBTrack> ZuneClassicParser::parse_music_track(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 28) {
@@ -277,8 +235,8 @@ std::optional<ZMDBTrack> ZuneClassicParser::parse_music_track(
 
     if (artist_ref != 0) {
         if (!artist_cache_.count(artist_ref)) {
-            if (index_table_.count(artist_ref)) {
-                uint32_t record_offset = index_table_[artist_ref];
+            uint32_t record_offset = 0;
+            if (find_record_offset(artist_ref, record_offset)) {
                 auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
                 if (record_opt.has_value()) {
                     auto artist = parse_artist(record_opt->second, artist_ref);
@@ -289,14 +247,17 @@ std::optional<ZMDBTrack> ZuneClassicParser::parse_music_track(
             }
         }
 
-        if (artist_cache_.count(artist_ref)) {
-            track.artist_name = artist_cache_[artist_ref].name;
-            track.artist_guid = artist_cache_[artist_ref].guid;
+        if (const auto* artist = artist_cache_.find(artist_ref)) {
+            track.artist_name = intern_reference(interned_refs_, artist_ref,
+                [&]() -> const std::string& { return artist->name; });
+            track.artist_guid = intern_reference(interned_guids_, artist_ref,
+                [&]() -> const std::string& { return artist->guid; });
         }
     }
 
     if (genre_ref != 0) {
-        track.genre = resolve_genre(genre_ref);
+        track.genre = intern_reference(interned_refs_, genre_ref,
+            [&] { return resolve_genre(genre_ref); });
         track.genre_ref = genre_ref;  // Store for genre entity tracking
     }
 
@@ -304,7 +265,8 @@ std::optional<ZMDBTrack> ZuneClassicParser::parse_music_track(
         // This resolves to the album's .alb filename (e.g. "Unknown Album.alb"),
         // not the track's on-disk filename. Track filenames live in MTP
         // ObjectInfo.Filename, not in ZMDB.
-        track.album_alb_ref = resolve_string_reference(album_filename_ref);
+        track.album_alb_ref = intern_reference(interned_refs_, album_filename_ref,
+            [&] { return resolve_string_reference(album_filename_ref); });
     }
 
     // Parse backwards varints for optional fields
@@ -334,10 +296,7 @@ std::optional<ZMDBTrack> ZuneClassicParser::parse_music_track(
                     if (field.field_size > 2) {
                         // Handle padding bytes
                         if (field.field_data[0] == 0x00 && field.field_data[field.field_size - 1] == 0x00) {
-                            track.filename = utf16le_to_utf8(std::vector<uint8_t>(
-                                field.field_data.begin() + 1,
-                                field.field_data.end() - 1
-                            ));
+                            track.filename = utf16le_to_utf8(field.field_data.subview(1, field.field_size - 2));
                         } else {
                             track.filename = utf16le_to_utf8(field.field_data);
                         }
@@ -356,7 +315,7 @@ std::optional<ZMDBTrack> ZuneClassicParser::parse_music_track(
 }
 
 std::optional<ZMDBVideo> ZuneClassicParser::parse_video(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 16) {
@@ -395,12 +354,12 @@ std::optional<ZMDBVideo> ZuneClassicParser::parse_video(
         video.episode_title = read_null_terminated_utf8(record_data, 0x28);
     }
 
-    parse_video_trailing_fields(record_data, video);
+    parse_video_trailing_fields(record_data, video, deferred_details_);
     return video;
 }
 
 std::optional<ZMDBPicture> ZuneClassicParser::parse_picture(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 24) {
@@ -445,7 +404,7 @@ std::optional<ZMDBPicture> ZuneClassicParser::parse_picture(
 }
 
 std::optional<ZMDBPlaylist> ZuneClassicParser::parse_playlist(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 12) {
@@ -479,7 +438,7 @@ std::optional<ZMDBPlaylist> ZuneClassicParser::parse_playlist(
     }
 
     playlist.name = std::string(
-        reinterpret_cast<const char*>(&record_data[12]),
+        reinterpret_cast<const char*>(record_data.data() + 12),
         null_pos - 12
     );
 
@@ -514,10 +473,7 @@ std::optional<ZMDBPlaylist> ZuneClassicParser::parse_playlist(
     }
 
     if (pos > utf16_start) {
-        std::vector<uint8_t> utf16_data(
-            record_data.begin() + utf16_start,
-            record_data.begin() + pos
-        );
+        ByteView utf16_data = record_data.subview(utf16_start, pos - utf16_start);
         playlist.filename = utf16le_to_utf8(utf16_data);
     }
 
@@ -543,7 +499,7 @@ std::optional<ZMDBPlaylist> ZuneClassicParser::parse_playlist(
 }
 
 std::optional<ZMDBPodcast> ZuneClassicParser::parse_podcast_episode(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     // Classic audio podcast episode (Schema 0x10) — 32-byte fixed header.
@@ -576,20 +532,19 @@ std::optional<ZMDBPodcast> ZuneClassicParser::parse_podcast_episode(
 
     podcast.title = read_null_terminated_utf8(record_data, 0x20);
     size_t variable_start = 0x20 + podcast.title.size() + 1;
-    auto fields = parse_backwards_varints(record_data, variable_start);
-    for (const auto& field : fields) {
+    for_each_varint_field<RecordSchema::PodcastEpisode>(record_data, variable_start, [&](const BackwardsVarintField& field) {
         switch (field.field_id) {
             case PodcastFieldId::Author:
                 podcast.author = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Description:
-                podcast.description = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.description = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Url:
-                podcast.episode_url = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.episode_url = utf16le_to_utf8(field.field_data);
                 break;
         }
-    }
+    });
 
     if (podcast.podcast_show_ref != 0) {
         podcast.show_name = resolve_string_reference(podcast.podcast_show_ref);
@@ -602,7 +557,7 @@ std::optional<ZMDBPodcast> ZuneClassicParser::parse_podcast_episode(
 }
 
 std::optional<ZMDBPodcast> ZuneClassicParser::parse_video_podcast_episode(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     // Classic video podcast episode (Schema 0x02 with non-zero show_ref) —
@@ -635,8 +590,7 @@ std::optional<ZMDBPodcast> ZuneClassicParser::parse_video_podcast_episode(
 
     podcast.title = read_null_terminated_utf8(record_data, 0x28);
     size_t variable_start = 0x28 + podcast.title.size() + 1;
-    auto fields = parse_backwards_varints(record_data, variable_start);
-    for (const auto& field : fields) {
+    for_each_varint_field<RecordSchema::PodcastEpisode>(record_data, variable_start, [&](const BackwardsVarintField& field) {
         switch (field.field_id) {
             case PodcastFieldId::Filename:
                 podcast.episode_filename = utf16le_to_utf8(field.field_data);
@@ -645,13 +599,13 @@ std::optional<ZMDBPodcast> ZuneClassicParser::parse_video_podcast_episode(
                 podcast.author = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Description:
-                podcast.description = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.description = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Url:
-                podcast.episode_url = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.episode_url = utf16le_to_utf8(field.field_data);
                 break;
         }
-    }
+    });
 
     if (podcast.podcast_show_ref != 0) {
         podcast.show_name = resolve_string_reference(podcast.podcast_show_ref);
@@ -664,7 +618,7 @@ std::optional<ZMDBPodcast> ZuneClassicParser::parse_video_podcast_episode(
 }
 
 std::optional<ZMDBPodcastShow> ZuneClassicParser::parse_podcast_show(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     // PodcastShow layout is identical on Classic and HD.
@@ -679,8 +633,7 @@ std::optional<ZMDBPodcastShow> ZuneClassicParser::parse_podcast_show(
     show.name          = read_null_terminated_utf8(record_data, 0x08);
 
     size_t variable_start = 0x08 + show.name.size() + 1;
-    auto fields = parse_backwards_varints(record_data, variable_start);
-    for (const auto& field : fields) {
+    for_each_varint_field<RecordSchema::PodcastShow>(record_data, variable_start, [&](const BackwardsVarintField& field) {
         switch (field.field_id) {
             case PodcastFieldId::Filename:
                 show.ser_filename = utf16le_to_utf8(field.field_data);
@@ -692,13 +645,13 @@ std::optional<ZMDBPodcastShow> ZuneClassicParser::parse_podcast_show(
                 show.feed_url = utf16le_to_utf8(field.field_data);
                 break;
         }
-    }
+    });
 
     return show;
 }
 
 std::optional<ZMDBAudiobook> ZuneClassicParser::parse_audiobook_track(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 36) {
@@ -739,43 +692,36 @@ std::optional<ZMDBAudiobook> ZuneClassicParser::parse_audiobook_track(
     }
 
     // Parse backwards varints for optional fields
-    size_t entry_size = get_entry_size_for_schema(Schema::AudiobookTrack);
-    if (entry_size > 0) {
-        auto fields = parse_backwards_varints(record_data, entry_size);
-        for (const auto& field : fields) {
-            switch (field.field_id) {
-                case 0x46:  // Author (UTF-16LE)
-                    if (field.field_size > 2) {
-                        audiobook.author = utf16le_to_utf8(field.field_data);
-                    }
-                    break;
-                case 0x44:  // Filename (UTF-16LE)
-                    if (field.field_size > 2) {
-                        // Handle padding bytes
-                        if (field.field_data[0] == 0x00 && field.field_data[field.field_size - 1] == 0x00) {
-                            audiobook.filename = utf16le_to_utf8(std::vector<uint8_t>(
-                                field.field_data.begin() + 1,
-                                field.field_data.end() - 1
-                            ));
-                        } else {
-                            audiobook.filename = utf16le_to_utf8(field.field_data);
-                        }
-                    }
-                    break;
-                case 0x70:  // Last played timestamp
-                    if (field.field_size == 8) {
-                        audiobook.last_played_timestamp = read_uint64_le(field.field_data, 0);
+    for_each_varint_field<RecordSchema::AudiobookTrack>(record_data, [&](const BackwardsVarintField& field) {
+        switch (field.field_id) {
+            case 0x46:  // Author (UTF-16LE)
+                if (field.field_size > 2) {
+                    audiobook.author = utf16le_to_utf8(field.field_data);
+                }
+                break;
+            case 0x44:  // Filename (UTF-16LE)
+                if (field.field_size > 2) {
+                    // Handle padding bytes
+                    if (field.field_data[0] == 0x00 && field.field_data[field.field_size - 1] == 0x00) {
+                        audiobook.filename = utf16le_to_utf8(field.field_data.subview(1, field.field_size - 2));
+                    } else {
+                        audiobook.filename = utf16le_to_utf8(field.field_data);
                     }
-                    break;
-            }
+                }
+                break;
+            case 0x70:  // Last played timestamp
+                if (field.field_size == 8) {
+                    audiobook.last_played_timestamp = read_uint64_le(field.field_data, 0);
+                }
+                break;
         }
-    }
+    });
 
     return audiobook;
 }
 
 std::optional<ZMDBAlbum> ZuneClassicParser::parse_album(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 12) {
@@ -808,14 +754,13 @@ std::optional<ZMDBAlbum> ZuneClassicParser::parse_album(
     // Resolve artist name and GUID
     if (album.artist_ref != 0) {
         // Try to get artist info from cache first
-        if (artist_cache_.count(album.artist_ref)) {
-            auto& artist = artist_cache_[album.artist_ref];
-            album.artist_name = artist.name;
-            album.artist_guid = artist.guid;
+        if (const auto* artist = artist_cache_.find(album.artist_ref)) {
+            album.artist_name = artist->name;
+            album.artist_guid = artist->guid;
         } else {
             // Lookup and parse artist record
-            if (index_table_.count(album.artist_ref)) {
-                uint32_t record_offset = index_table_[album.artist_ref];
+            uint32_t record_offset = 0;
+            if (find_record_offset(album.artist_ref, record_offset)) {
                 auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
                 if (record_opt.has_value()) {
                     auto artist = parse_artist(record_opt->second, album.artist_ref);
@@ -833,19 +778,19 @@ std::optional<ZMDBAlbum> ZuneClassicParser::parse_album(
     // GUID), fid=0x44 (.alb reference as UTF-16LE), and fid=0x1e (constant).
     // Variable section starts at title_end — for short titles ("III", "IV")
     // this can be below the default Schema::Album entry_size of 20.
-    auto fields = parse_backwards_varints(record_data, title_end);
-    for (const auto& field : fields) {
+    for_each_varint_field<RecordSchema::Album>(record_data, title_end, [&](const BackwardsVarintField& field) -> bool {
         if (field.field_id == 0x44 && field.field_size > 2) {
             album.alb_reference = utf16le_to_utf8(field.field_data);
-            break;
+            return false;
         }
-    }
+        return true;
+    });
 
     return album;
 }
 
 std::optional<ZMDBArtist> ZuneClassicParser::parse_artist(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 4) {
@@ -869,24 +814,20 @@ std::optional<ZMDBArtist> ZuneClassicParser::parse_artist(
     }
 
     // Parse artist filename and GUID from backwards varints
-    size_t entry_size = get_entry_size_for_schema(Schema::Artist);
-    if (entry_size > 0) {
-        auto fields = parse_backwards_varints(record_data, entry_size);
-        for (const auto& field : fields) {
-            switch (field.field_id) {
-                case 0x44:  // Artist filename with .art extension
-                    if (field.field_size > 2) {
-                        artist.filename = utf16le_to_utf8(field.field_data);
-                    }
-                    break;
-                case 0x14:  // Artist GUID (16 bytes)
-                    if (field.field_size == 16) {
-                        artist.guid = parse_windows_guid(field.field_data);
-                    }
-                    break;
-            }
+    for_each_varint_field<RecordSchema::Artist>(record_data, [&](const BackwardsVarintField& field) {
+        switch (field.field_id) {
+            case 0x44:  // Artist filename with .art extension
+                if (field.field_size > 2) {
+                    artist.filename = utf16le_to_utf8(field.field_data);
+                }
+                break;
+            case 0x14:  // Artist GUID (16 bytes)
+                if (field.field_size == 16) {
+                    artist.guid = parse_windows_guid(field.field_data);
+                }
+                break;
         }
-    }
+    });
 
     return artist;
 }
@@ -894,16 +835,14 @@ std::optional<ZMDBArtist> ZuneClassicParser::parse_artist(
 // Reference resolution methods
 std::string ZuneClassicParser::resolve_string_reference(uint32_t atom_id) {
     // Check cache first
-    if (string_cache_.count(atom_id)) {
-        return string_cache_[atom_id];
+    if (const auto* cached = string_cache_.find(atom_id)) {
+        return *cached;
     }
 
-    // Lookup record in index table
-    if (!index_table_.count(atom_id)) {
+    uint32_t record_offset = 0;
+    if (!find_record_offset(atom_id, record_offset)) {
         return "";
     }
-
-    uint32_t record_offset = index_table_[atom_id];
     auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
     if (!record_opt.has_value()) {
         return "";
@@ -945,16 +884,15 @@ std::string ZuneClassicParser::resolve_string_reference(uint32_t atom_id) {
 
 std::string ZuneClassicParser::resolve_artist_name(uint32_t atom_id) {
     // Check cache
-    if (artist_cache_.count(atom_id)) {
-        return artist_cache_[atom_id].name;
+    if (const auto* cached = artist_cache_.find(atom_id)) {
+        return cached->name;
     }
 
     // Lookup and parse artist record
-    if (!index_table_.count(atom_id)) {
+    uint32_t record_offset = 0;
+    if (!find_record_offset(atom_id, record_offset)) {
         return "";
     }
-
-    uint32_t record_offset = index_table_[atom_id];
     auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
     if (!record_opt.has_value()) {
         return "";
@@ -974,8 +912,8 @@ std::string ZuneClassicParser::resolve_artist_name(uint32_t atom_id) {
 
 std::string ZuneClassicParser::resolve_genre(uint32_t atom_id) {
     // Check cache first
-    if (genre_cache_.count(atom_id)) {
-        return genre_cache_[atom_id].name;
+    if (const auto* cached = genre_cache_.find(atom_id)) {
+        return cached->name;
     }
 
     std::string name = resolve_string_reference(atom_id);
@@ -992,16 +930,14 @@ std::string ZuneClassicParser::resolve_genre(uint32_t atom_id) {
 }
 
 std::optional<std::pair<uint32_t, std::string>> ZuneClassicParser::resolve_album_info(uint32_t atom_id) {
-    if (album_cache_.count(atom_id)) {
-        auto& album = album_cache_[atom_id];
-        return std::make_pair(album.atom_id, album.title);
+    if (const auto* album = album_cache_.find(atom_id)) {
+        return std::make_pair(album->atom_id, album->title);
     }
 
-    if (!index_table_.count(atom_id)) {
+    uint32_t record_offset = 0;
+    if (!find_record_offset(atom_id, record_offset)) {
         return std::nullopt;
     }
-
-    uint32_t record_offset = index_table_[atom_id];
     auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
     if (!record_opt.has_value()) {
         return std::nullopt;
@@ -1016,36 +952,35 @@ std::optional<std::pair<uint32_t, std::string>> ZuneClassicParser::resolve_album
     return std::nullopt;
 }
 
-std::optional<ZMDBTrack> ZuneClassicParser::resolve_track(uint32_t track_atom_id) {
-    // Lookup track record
-    if (!index_table_.count(track_atom_id)) {
-        return std::nullopt;
-    }
-
-    uint32_t record_offset = index_table_[track_atom_id];
-    auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
-    if (!record_opt.has_value()) {
-        return std::nullopt;
-    }
+std::unique_ptr<ZMDBParserBase> ZuneClassicParser::create_worker() const {
+    auto worker = std::make_unique<ZuneClassicParser>();
+    share_parse_state(*worker);
+    return worker;
+}
 
-    return parse_music_track(record_opt->second, track_atom_id);
+void ZuneClassicParser::merge_worker_caches(ZMDBParserBase& worker) {
+    auto& w = static_cast<ZuneClassicParser&>(worker);
+    string_cache_.insert(w.string_cache_);
+    artist_cache_.insert(w.artist_cache_);
+    album_cache_.insert(w.album_cache_);
+    genre_cache_.insert(w.genre_cache_);
 }
 
-void ZuneClassicParser::extract_media_from_descriptor(
+void ZuneClassicParser::extract_media_range(
     uint32_t descriptor_idx,
-    uint8_t expected_schema,
-    ZMDBLibrary& library
+    uint32_t begin,
+    uint32_t end,
+    ZMDBRecordSink& sink
 ) {
     if (descriptor_idx >= descriptors_.size()) {
         return;
     }
 
     const auto& desc = descriptors_[descriptor_idx];
-    if (desc.entry_count == 0) {
-        return;
-    }
+    end = std::min(end, desc.entry_count);
+    wait_for_bytes(desc.data_offset + static_cast<size_t>(end) * desc.entry_size);
 
-    for (uint32_t i = 0; i < desc.entry_count; i++) {
+    for (uint32_t i = begin; i < end; i++) {
         size_t entry_offset = desc.data_offset + (i * desc.entry_size);
         if (entry_offset + 4 > zmdb_data_.size()) {
             break;
@@ -1054,11 +989,10 @@ void ZuneClassicParser::extract_media_from_descriptor(
         uint32_t atom_id = read_uint32_le(zmdb_data_, entry_offset);
         uint8_t schema_type = (atom_id >> 24) & 0xFF;
 
-        if (!index_table_.count(atom_id)) {
+        uint32_t record_offset = 0;
+        if (!find_record_offset(atom_id, record_offset)) {
             continue;
         }
-
-        uint32_t record_offset = index_table_[atom_id];
         auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
         if (!record_opt.has_value()) {
             continue;
@@ -1070,16 +1004,13 @@ void ZuneClassicParser::extract_media_from_descriptor(
             continue;
         }
 
-        // Placement new into pre-allocated arrays — no reallocation.
+        // The sink stores each record (no reallocation in ZMDBLibrarySink).
         switch (schema_type) {
             case Schema::Music:
             {
-                if (library.track_count < library.tracks_capacity) {
-                    auto track = parse_music_track(record_data, atom_id);
-                    if (track.has_value()) {
-                        new (&library.tracks[library.track_count]) ZMDBTrack(std::move(track.value()));
-                        library.track_count++;
-                    }
+                auto track = parse_music_track(record_data, atom_id);
+                if (track.has_value()) {
+                    sink.OnTrack(std::move(track.value()));
                 }
                 break;
             }
@@ -1096,19 +1027,14 @@ void ZuneClassicParser::extract_media_from_descriptor(
                     show_ref != 0 && ((show_ref >> 24) & 0xff) == Schema::PodcastShow;
 
                 if (is_video_podcast) {
-                    if (library.podcast_count < library.podcasts_capacity) {
-                        auto podcast = parse_video_podcast_episode(record_data, atom_id);
-                        if (podcast.has_value()) {
-                            new (&library.podcasts[library.podcast_count])
-                                ZMDBPodcast(std::move(podcast.value()));
-                            library.podcast_count++;
-                        }
+                    auto podcast = parse_video_podcast_episode(record_data, atom_id);
+                    if (podcast.has_value()) {
+                        sink.OnPodcast(std::move(podcast.value()));
                     }
-                } else if (library.video_count < library.videos_capacity) {
+                } else {
                     auto video = parse_video(record_data, atom_id);
                     if (video.has_value()) {
-                        new (&library.videos[library.video_count]) ZMDBVideo(std::move(video.value()));
-                        library.video_count++;
+                        sink.OnVideo(std::move(video.value()));
                     }
                 }
                 break;
@@ -1116,24 +1042,18 @@ void ZuneClassicParser::extract_media_from_descriptor(
 
             case Schema::Picture:
             {
-                if (library.picture_count < library.pictures_capacity) {
-                    auto picture = parse_picture(record_data, atom_id);
-                    if (picture.has_value()) {
-                        new (&library.pictures[library.picture_count]) ZMDBPicture(std::move(picture.value()));
-                        library.picture_count++;
-                    }
+                auto picture = parse_picture(record_data, atom_id);
+                if (picture.has_value()) {
+                    sink.OnPicture(std::move(picture.value()));
                 }
                 break;
             }
 
             case Schema::Playlist:
             {
-                if (library.playlist_count < library.playlists_capacity) {
-                    auto playlist = parse_playlist(record_data, atom_id);
-                    if (playlist.has_value()) {
-                        new (&library.playlists[library.playlist_count]) ZMDBPlaylist(std::move(playlist.value()));
-                        library.playlist_count++;
-                    }
+                auto playlist = parse_playlist(record_data, atom_id);
+                if (playlist.has_value()) {
+                    sink.OnPlaylist(std::move(playlist.value()));
                 }
                 break;
             }
@@ -1142,32 +1062,25 @@ void ZuneClassicParser::extract_media_from_descriptor(
             {
                 auto show = parse_podcast_show(record_data, atom_id);
                 if (show.has_value()) {
-                    library.podcast_show_metadata[atom_id] = std::move(show.value());
-                    library.podcast_show_count++;
+                    sink.OnPodcastShow(atom_id, std::move(show.value()));
                 }
                 break;
             }
 
             case Schema::PodcastEpisode:
             {
-                if (library.podcast_count < library.podcasts_capacity) {
-                    auto podcast = parse_podcast_episode(record_data, atom_id);
-                    if (podcast.has_value()) {
-                        new (&library.podcasts[library.podcast_count]) ZMDBPodcast(std::move(podcast.value()));
-                        library.podcast_count++;
-                    }
+                auto podcast = parse_podcast_episode(record_data, atom_id);
+                if (podcast.has_value()) {
+                    sink.OnPodcast(std::move(podcast.value()));
                 }
                 break;
             }
 
             case Schema::AudiobookTrack:
             {
-                if (library.audiobook_count < library.audiobooks_capacity) {
-                    auto audiobook = parse_audiobook_track(record_data, atom_id);
-                    if (audiobook.has_value()) {
-                        new (&library.audiobooks[library.audiobook_count]) ZMDBAudiobook(std::move(audiobook.value()));
-                        library.audiobook_count++;
-                    }
+                auto audiobook = parse_audiobook_track(record_data, atom_id);
+                if (audiobook.has_value()) {
+                    sink.OnAudiobook(std::move(audiobook.value()));
                 }
                 break;
             }
@@ -1,6 +1,8 @@
 #include "ZuneHDParser.h"
 #include "ZMDBUtils.h"
+#include "ZMDBFieldSchema.h"
 #include "../platform_compat.h"
+#include <algorithm>
 #include <cstring>
 #include <ctime>
 #include <iostream>
@@ -9,35 +11,37 @@
 
 namespace zmdb {
 
-ZMDBLibrary ZuneHDParser::ExtractLibrary(const std::vector<uint8_t>& zmdb_data) {
-    ZMDBLibrary library;
-    library.device_family = zune::DeviceFamily::Pavo;
+zune::DeviceFamily ZuneHDParser::library_family() const {
+    return zune::DeviceFamily::Pavo;
+}
 
+void ZuneHDParser::extract_records(ByteView zmdb_data, ZMDBRecordSink& sink) {
     if (zmdb_data.empty()) {
-        return library;
+        return;
     }
 
     zmdb_data_ = zmdb_data;
+    wait_for_bytes(0x100);  // Headers and the window searched for ZArr
 
     // Parse ZMDB header
     if (zmdb_data_.size() < 0x10) {
-        return library;
+        return;
     }
 
     // Verify ZMDB magic
     if (zmdb_data_[0] != 'Z' || zmdb_data_[1] != 'M' ||
         zmdb_data_[2] != 'D' || zmdb_data_[3] != 'B') {
-        return library;
+        return;
     }
 
     // Parse ZMed header at offset 0x20
     if (zmdb_data_.size() < 0x30) {
-        return library;
+        return;
     }
 
     if (zmdb_data_[0x20] != 'Z' || zmdb_data_[0x21] != 'M' ||
         zmdb_data_[0x22] != 'e' || zmdb_data_[0x23] != 'd') {
-        return library;
+        return;
     }
 
     // Find ZArr descriptors - search for first "ZArr" after ZMed header
@@ -51,9 +55,11 @@ ZMDBLibrary ZuneHDParser::ExtractLibrary(const std::vector<uint8_t>& zmdb_data)
     }
 
     if (descriptor_offset == 0) {
-        return library;
+        return;
     }
 
+    wait_for_bytes(descriptor_offset + 96 * 20);
+
     // Parse 96 descriptors
     descriptors_.resize(96);
     for (int i = 0; i < 96; i++) {
@@ -69,121 +75,75 @@ ZMDBLibrary ZuneHDParser::ExtractLibrary(const std::vector<uint8_t>& zmdb_data)
 
     // Build index table from descriptor 0
     if (descriptors_[0].entry_count > 0 && descriptors_[0].entry_size == 8) {
-        index_table_ = build_index_table(
+        index_table_ = std::make_shared<const IndexTable>(build_index_table(
             zmdb_data_,
             descriptors_[0].data_offset,
             descriptors_[0].entry_count
-        );
-    }
-
-    // Allocate arrays with exact sizes from descriptors (single allocation, no reallocation)
-    if (descriptors_.size() > 1 && descriptors_[1].entry_count > 0) {
-        library.tracks_capacity = descriptors_[1].entry_count;
-        library.tracks = static_cast<ZMDBTrack*>(::operator new[](library.tracks_capacity * sizeof(ZMDBTrack)));
-    }
-    if (descriptors_.size() > 11 && descriptors_[11].entry_count > 0) {
-        library.playlists_capacity = descriptors_[11].entry_count;
-        library.playlists = static_cast<ZMDBPlaylist*>(::operator new[](library.playlists_capacity * sizeof(ZMDBPlaylist)));
-    }
-    if (descriptors_.size() > 12 && descriptors_[12].entry_count > 0) {
-        library.videos_capacity = descriptors_[12].entry_count;
-        library.videos = static_cast<ZMDBVideo*>(::operator new[](library.videos_capacity * sizeof(ZMDBVideo)));
-    }
-    if (descriptors_.size() > 16 && descriptors_[16].entry_count > 0) {
-        library.pictures_capacity = descriptors_[16].entry_count;
-        library.pictures = static_cast<ZMDBPicture*>(::operator new[](library.pictures_capacity * sizeof(ZMDBPicture)));
-    }
+        ));
+    }
+
+    // Size the sink from descriptor entry counts (single allocation, no reallocation)
+    auto entries = [this](size_t idx) {
+        return idx < descriptors_.size() ? static_cast<int>(descriptors_[idx].entry_count) : 0;
+    };
+    ZMDBExtractionPlan plan;
+    plan.tracks = entries(1);
+    plan.playlists = entries(11);
+    plan.videos = entries(12);
+    plan.pictures = entries(16);
     // Audio episodes (descriptor 19) plus video-podcast records promoted
     // out of Schema 0x02 (descriptor 12). Over-allocates by the number of
     // non-podcast videos in descriptor 12; cheap and avoids a pre-pass.
     if (descriptors_.size() > 19) {
-        size_t audio_episodes = descriptors_[19].entry_count;
-        size_t potential_video_podcasts =
-            (descriptors_.size() > 12) ? descriptors_[12].entry_count : 0;
-        library.podcasts_capacity =
-            static_cast<int>(audio_episodes + potential_video_podcasts);
-        if (library.podcasts_capacity > 0) {
-            library.podcasts = static_cast<ZMDBPodcast*>(::operator new[](
-                library.podcasts_capacity * sizeof(ZMDBPodcast)));
-        }
-    }
-    if (descriptors_.size() > 26 && descriptors_[26].entry_count > 0) {
-        library.audiobooks_capacity = descriptors_[26].entry_count;
-        library.audiobooks = static_cast<ZMDBAudiobook*>(::operator new[](library.audiobooks_capacity * sizeof(ZMDBAudiobook)));
-    }
-
-    // Parse directly into arrays (no intermediate vectors, no reallocation)
-    try {
-        extract_media_from_descriptor(1, Schema::Music, library);      // Music tracks
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Music parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(11, Schema::Playlist, library);  // Playlists
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Playlist parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(12, Schema::Video, library);     // Videos
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Video parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(16, Schema::Picture, library);   // Pictures
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Picture parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(19, Schema::PodcastEpisode, library); // Podcast episodes
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Podcast parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(20, Schema::PodcastShow, library); // Podcast shows
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("PodcastShow parsing failed: ") + e.what());
-    }
-
-    try {
-        extract_media_from_descriptor(26, Schema::AudiobookTrack, library); // Audiobook tracks (descriptor 26, not 25)
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Audiobook parsing failed: ") + e.what());
-    }
+        plan.podcasts = entries(19) + entries(12);
+    }
+    plan.audiobooks = entries(26);
+    plan.details_deferred = deferred_details_;
+    sink.Begin(plan);
+
+    // Records go straight to the sink as they are parsed
+    run_extraction({
+        {1,  Schema::Music,          "Music"},
+        {11, Schema::Playlist,       "Playlist"},
+        {12, Schema::Video,          "Video"},
+        {16, Schema::Picture,        "Picture"},
+        {19, Schema::PodcastEpisode, "Podcast"},
+        {20, Schema::PodcastShow,    "PodcastShow"},
+        {26, Schema::AudiobookTrack, "Audiobook"},  // descriptor 26, not 25
+    }, sink);
 
     // Move album metadata from cache (no tracks - consumer groups by album_ref)
     try {
-        library.album_metadata = std::move(album_cache_);
-        library.album_count = library.album_metadata.size();
+        album_cache_.release_each([&sink](uint32_t atom_id, ZMDBAlbum&& album) {
+            sink.OnAlbum(atom_id, std::move(album));
+        });
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Album metadata move failed: ") + e.what());
     }
 
     // Move artist metadata from cache
     try {
-        library.artist_metadata = std::move(artist_cache_);
-        library.artist_count = library.artist_metadata.size();
+        artist_cache_.release_each([&sink](uint32_t atom_id, ZMDBArtist&& artist) {
+            sink.OnArtist(atom_id, std::move(artist));
+        });
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Artist metadata move failed: ") + e.what());
     }
 
     // Move genre metadata from cache
     try {
-        library.genre_metadata = std::move(genre_cache_);
-        library.genre_count = library.genre_metadata.size();
+        genre_cache_.release_each([&sink](uint32_t atom_id, ZMDBGenre&& genre) {
+            sink.OnGenre(atom_id, std::move(genre));
+        });
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Genre metadata move failed: ") + e.what());
     }
 
-    return library;
+    release_strings(sink);
 }
 
 bool ZuneHDParser::should_filter_record(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint8_t schema_type
 ) const {
     if (record_data.size() < 12) {
@@ -205,7 +165,7 @@ bool ZuneHDParser::should_filter_record(
 }
 
 std::optional<ZMDBTrack> ZuneHDParser::parse_music_track(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 32) {
@@ -241,36 +201,32 @@ std::optional<ZMDBTrack> ZuneHDParser::parse_music_track(
     }
 
     // Parse backwards varints for optional fields (0x62, 0x63, 0x6c, 0x70)
-    size_t entry_size = get_entry_size_for_schema(Schema::Music);
-    if (entry_size > 0) {
-        auto fields = parse_backwards_varints(record_data, entry_size);
-        for (const auto& field : fields) {
-            switch (field.field_id) {
-                case 0x63:  // Skip count
-                    if (field.field_size >= 1 && field.field_size <= 4) {
-                        track.skip_count = static_cast<uint16_t>(read_uint32_le(field.field_data, 0));
-                    }
-                    break;
-                case 0x6c:  // Disc number
-                    if (field.field_size >= 1 && field.field_size <= 4) {
-                        track.disc_number = static_cast<int>(read_uint32_le(field.field_data, 0));
-                    }
-                    break;
-                case 0x70:  // Last played/skipped timestamp (Windows FILETIME)
-                    if (field.field_size == 8) {
-                        track.last_played_timestamp = read_uint64_le(field.field_data, 0);
-                    }
-                    break;
-                case 0x62:
-                    if (field.field_size >= 1 && field.field_size <= 4) {
-                        track.on_device_playcount = read_uint32_le(field.field_data, 0);
-                    }
-                    break;
-                default:
-                    break;
-            }
+    for_each_varint_field<RecordSchema::MusicTrack>(record_data, [&](const BackwardsVarintField& field) {
+        switch (field.field_id) {
+            case 0x63:  // Skip count
+                if (field.field_size >= 1 && field.field_size <= 4) {
+                    track.skip_count = static_cast<uint16_t>(read_uint32_le(field.field_data, 0));
+                }
+                break;
+            case 0x6c:  // Disc number
+                if (field.field_size >= 1 && field.field_size <= 4) {
+                    track.disc_number = static_cast<int>(read_uint32_le(field.field_data, 0));
+                }
+                break;
+            case 0x70:  // Last played/skipped timestamp (Windows FILETIME)
+                if (field.field_size == 8) {
+                    track.last_played_timestamp = read_uint64_le(field.field_data, 0);
+                }
+                break;
+            case 0x62:
+                if (field.field_size >= 1 && field.field_size <= 4) {
+                    track.on_device_playcount = read_uint32_le(field.field_data, 0);
+                }
+                break;
+            default:
+                break;
         }
-    }
+    });
 
     // Resolve album reference to populate album_cache_ (via side effect). Albums
     // reachable only through track references enter the output library_metadata
@@ -282,8 +238,8 @@ std::optional<ZMDBTrack> ZuneHDParser::parse_music_track(
     if (artist_ref != 0) {
         // Ensure artist is fully parsed and cached
         if (!artist_cache_.count(artist_ref)) {
-            if (index_table_.count(artist_ref)) {
-                uint32_t record_offset = index_table_[artist_ref];
+            uint32_t record_offset = 0;
+            if (find_record_offset(artist_ref, record_offset)) {
                 auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
                 if (record_opt.has_value()) {
                     const auto& rec_data = record_opt->second;
@@ -297,28 +253,32 @@ std::optional<ZMDBTrack> ZuneHDParser::parse_music_track(
         }
 
         // Get artist name and GUID from cache
-        if (artist_cache_.count(artist_ref)) {
-            track.artist_name = artist_cache_[artist_ref].name;
-            track.artist_guid = artist_cache_[artist_ref].guid;
+        if (const auto* artist = artist_cache_.find(artist_ref)) {
+            track.artist_name = intern_reference(interned_refs_, artist_ref,
+                [&]() -> const std::string& { return artist->name; });
+            track.artist_guid = intern_reference(interned_guids_, artist_ref,
+                [&]() -> const std::string& { return artist->guid; });
         }
     }
 
     if (genre_ref != 0) {
-        track.genre = resolve_genre(genre_ref);
+        track.genre = intern_reference(interned_refs_, genre_ref,
+            [&] { return resolve_genre(genre_ref); });
     }
 
     if (album_filename_ref != 0) {
         // This resolves to the album's .alb filename (e.g. "Unknown Album.alb"),
         // not the track's on-disk filename. Track filenames live in MTP
         // ObjectInfo.Filename, not in ZMDB.
-        track.album_alb_ref = resolve_string_reference(album_filename_ref);
+        track.album_alb_ref = intern_reference(interned_refs_, album_filename_ref,
+            [&] { return resolve_string_reference(album_filename_ref); });
     }
 
     return track;
 }
 
 std::optional<ZMDBVideo> ZuneHDParser::parse_video(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 16) {
@@ -357,12 +317,12 @@ std::optional<ZMDBVideo> ZuneHDParser::parse_video(
         video.episode_title = read_null_terminated_utf8(record_data, 0x2c);
     }
 
-    parse_video_trailing_fields(record_data, video);
+    parse_video_trailing_fields(record_data, video, deferred_details_);
     return video;
 }
 
 std::optional<ZMDBPicture> ZuneHDParser::parse_picture(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 24) {
@@ -407,7 +367,7 @@ std::optional<ZMDBPicture> ZuneHDParser::parse_picture(
 }
 
 std::optional<ZMDBPlaylist> ZuneHDParser::parse_playlist(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 12) {
@@ -443,7 +403,7 @@ std::optional<ZMDBPlaylist> ZuneHDParser::parse_playlist(
     }
 
     playlist.name = std::string(
-        reinterpret_cast<const char*>(&record_data[12]),
+        reinterpret_cast<const char*>(record_data.data() + 12),
         null_pos - 12
     );
 
@@ -480,10 +440,7 @@ std::optional<ZMDBPlaylist> ZuneHDParser::parse_playlist(
     }
 
     if (pos > utf16_start) {
-        std::vector<uint8_t> utf16_data(
-            record_data.begin() + utf16_start,
-            record_data.begin() + pos
-        );
+        ByteView utf16_data = record_data.subview(utf16_start, pos - utf16_start);
         playlist.filename = utf16le_to_utf8(utf16_data);
     }
 
@@ -509,7 +466,7 @@ std::optional<ZMDBPlaylist> ZuneHDParser::parse_playlist(
 }
 
 std::optional<ZMDBPodcast> ZuneHDParser::parse_podcast_episode(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     // HD audio podcast episode (Schema 0x10) — 36-byte fixed header.
@@ -541,20 +498,19 @@ std::optional<ZMDBPodcast> ZuneHDParser::parse_podcast_episode(
 
     podcast.title = read_null_terminated_utf8(record_data, 0x24);
     size_t variable_start = 0x24 + podcast.title.size() + 1;
-    auto fields = parse_backwards_varints(record_data, variable_start);
-    for (const auto& field : fields) {
+    for_each_varint_field<RecordSchema::PodcastEpisode>(record_data, variable_start, [&](const BackwardsVarintField& field) {
         switch (field.field_id) {
             case PodcastFieldId::Author:
                 podcast.author = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Description:
-                podcast.description = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.description = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Url:
-                podcast.episode_url = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.episode_url = utf16le_to_utf8(field.field_data);
                 break;
         }
-    }
+    });
 
     if (podcast.podcast_show_ref != 0) {
         podcast.show_name = resolve_string_reference(podcast.podcast_show_ref);
@@ -567,7 +523,7 @@ std::optional<ZMDBPodcast> ZuneHDParser::parse_podcast_episode(
 }
 
 std::optional<ZMDBPodcast> ZuneHDParser::parse_video_podcast_episode(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     // HD video podcast episode (Schema 0x02 with non-zero show_ref) —
@@ -603,8 +559,7 @@ std::optional<ZMDBPodcast> ZuneHDParser::parse_video_podcast_episode(
 
     podcast.title = read_null_terminated_utf8(record_data, 0x2c);
     size_t variable_start = 0x2c + podcast.title.size() + 1;
-    auto fields = parse_backwards_varints(record_data, variable_start);
-    for (const auto& field : fields) {
+    for_each_varint_field<RecordSchema::PodcastEpisode>(record_data, variable_start, [&](const BackwardsVarintField& field) {
         switch (field.field_id) {
             case PodcastFieldId::Filename:
                 podcast.episode_filename = utf16le_to_utf8(field.field_data);
@@ -613,13 +568,13 @@ std::optional<ZMDBPodcast> ZuneHDParser::parse_video_podcast_episode(
                 podcast.author = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Description:
-                podcast.description = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.description = utf16le_to_utf8(field.field_data);
                 break;
             case PodcastFieldId::Url:
-                podcast.episode_url = utf16le_to_utf8(field.field_data);
+                if (!deferred_details_) podcast.episode_url = utf16le_to_utf8(field.field_data);
                 break;
         }
-    }
+    });
 
     if (podcast.podcast_show_ref != 0) {
         podcast.show_name = resolve_string_reference(podcast.podcast_show_ref);
@@ -632,7 +587,7 @@ std::optional<ZMDBPodcast> ZuneHDParser::parse_video_podcast_episode(
 }
 
 std::optional<ZMDBPodcastShow> ZuneHDParser::parse_podcast_show(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     // PodcastShow (Schema 0x0f) — same layout on Classic and HD.
@@ -651,8 +606,7 @@ std::optional<ZMDBPodcastShow> ZuneHDParser::parse_podcast_show(
     show.name          = read_null_terminated_utf8(record_data, 0x08);
 
     size_t variable_start = 0x08 + show.name.size() + 1;
-    auto fields = parse_backwards_varints(record_data, variable_start);
-    for (const auto& field : fields) {
+    for_each_varint_field<RecordSchema::PodcastShow>(record_data, variable_start, [&](const BackwardsVarintField& field) {
         switch (field.field_id) {
             case PodcastFieldId::Filename:
                 show.ser_filename = utf16le_to_utf8(field.field_data);
@@ -664,13 +618,13 @@ std::optional<ZMDBPodcastShow> ZuneHDParser::parse_podcast_show(
                 show.feed_url = utf16le_to_utf8(field.field_data);
                 break;
         }
-    }
+    });
 
     return show;
 }
 
 std::optional<ZMDBAudiobook> ZuneHDParser::parse_audiobook_track(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     // Schema 0x12 - Audiobook Track
@@ -707,41 +661,35 @@ std::optional<ZMDBAudiobook> ZuneHDParser::parse_audiobook_track(
     }
 
     // Parse backwards varints for additional fields
-    size_t entry_size = get_entry_size_for_schema(Schema::AudiobookTrack);
-    if (entry_size > 0) {
-        auto fields = parse_backwards_varints(record_data, entry_size);
-        for (const auto& field : fields) {
-            // Field 0x44: Filename (UTF-16LE)
-            if (field.field_id == 0x44 && field.field_size > 2) {
-                std::vector<uint8_t> utf16_data = field.field_data;
-                // Handle padding bytes
-                if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
-                    utf16_data.erase(utf16_data.begin());
-                    utf16_data.pop_back();
-                }
-                audiobook.filename = utf16le_to_utf8(utf16_data);
-            }
-            // Field 0x46: Author name (UTF-16LE)
-            else if (field.field_id == 0x46 && field.field_size > 2) {
-                std::vector<uint8_t> utf16_data = field.field_data;
-                if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
-                    utf16_data.erase(utf16_data.begin());
-                    utf16_data.pop_back();
-                }
-                audiobook.author = utf16le_to_utf8(utf16_data);
+    for_each_varint_field<RecordSchema::AudiobookTrack>(record_data, [&](const BackwardsVarintField& field) {
+        // Field 0x44: Filename (UTF-16LE)
+        if (field.field_id == 0x44 && field.field_size > 2) {
+            ByteView utf16_data = field.field_data;
+            // Handle padding bytes
+            if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
+                utf16_data = utf16_data.subview(1, utf16_data.size() - 2);
             }
-            // Field 0x70: Last played/skipped timestamp (Windows FILETIME)
-            else if (field.field_id == 0x70 && field.field_size == 8) {
-                audiobook.last_played_timestamp = read_uint64_le(field.field_data, 0);
+            audiobook.filename = utf16le_to_utf8(utf16_data);
+        }
+        // Field 0x46: Author name (UTF-16LE)
+        else if (field.field_id == 0x46 && field.field_size > 2) {
+            ByteView utf16_data = field.field_data;
+            if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
+                utf16_data = utf16_data.subview(1, utf16_data.size() - 2);
             }
+            audiobook.author = utf16le_to_utf8(utf16_data);
         }
-    }
+        // Field 0x70: Last played/skipped timestamp (Windows FILETIME)
+        else if (field.field_id == 0x70 && field.field_size == 8) {
+            audiobook.last_played_timestamp = read_uint64_le(field.field_data, 0);
+        }
+    });
 
     return audiobook;
 }
 
 std::optional<ZMDBAlbum> ZuneHDParser::parse_album(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 20) {
@@ -784,35 +732,31 @@ std::optional<ZMDBAlbum> ZuneHDParser::parse_album(
         album.artist_name = resolve_artist_name(album.artist_ref);
 
         // Get artist GUID from cache if available
-        if (artist_cache_.count(album.artist_ref)) {
-            album.artist_guid = artist_cache_[album.artist_ref].guid;
+        if (const auto* artist = artist_cache_.find(album.artist_ref)) {
+            album.artist_guid = artist->guid;
         }
     }
 
     // Parse filename from backwards varints (field 0x44)
-    size_t entry_size = get_entry_size_for_schema(Schema::Album);
-    if (entry_size > 0) {
-        auto fields = parse_backwards_varints(record_data, entry_size);
-        for (const auto& field : fields) {
-            if (field.field_id == 0x44 && field.field_size > 2) {
-                // Handle padding bytes
-                std::vector<uint8_t> utf16_data = field.field_data;
-                if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
-                    utf16_data.erase(utf16_data.begin());
-                    utf16_data.pop_back();
-                }
-                // Store as alb_reference for MTP correlation
-                album.alb_reference = utf16le_to_utf8(utf16_data);
-                break;
+    for_each_varint_field<RecordSchema::Album>(record_data, [&](const BackwardsVarintField& field) -> bool {
+        if (field.field_id == 0x44 && field.field_size > 2) {
+            // Handle padding bytes
+            ByteView utf16_data = field.field_data;
+            if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
+                utf16_data = utf16_data.subview(1, utf16_data.size() - 2);
             }
+            // Store as alb_reference for MTP correlation
+            album.alb_reference = utf16le_to_utf8(utf16_data);
+            return false;
         }
-    }
+        return true;
+    });
 
     return album;
 }
 
 std::optional<ZMDBArtist> ZuneHDParser::parse_artist(
-    const std::vector<uint8_t>& record_data,
+    ByteView record_data,
     uint32_t atom_id
 ) {
     if (record_data.size() < 4) {
@@ -828,41 +772,35 @@ std::optional<ZMDBArtist> ZuneHDParser::parse_artist(
     }
 
     // Parse backwards varints for field 0x44 (filename) and 0x14 (GUID)
-    size_t entry_size = get_entry_size_for_schema(Schema::Artist);
-    if (entry_size > 0) {
-        auto fields = parse_backwards_varints(record_data, entry_size);
-        for (const auto& field : fields) {
-            // Field 0x44: UTF-16LE filename (.art reference)
-            if (field.field_id == 0x44 && field.field_size > 2) {
-                std::vector<uint8_t> utf16_data = field.field_data;
-                if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
-                    utf16_data.erase(utf16_data.begin());
-                    utf16_data.pop_back();
-                }
-                artist.filename = utf16le_to_utf8(utf16_data);
-            }
-            // Field 0x14: Artist GUID (16 bytes, optional)
-            else if (field.field_id == 0x14 && field.field_size == 16) {
-                artist.guid = parse_windows_guid(field.field_data);
+    for_each_varint_field<RecordSchema::Artist>(record_data, [&](const BackwardsVarintField& field) {
+        // Field 0x44: UTF-16LE filename (.art reference)
+        if (field.field_id == 0x44 && field.field_size > 2) {
+            ByteView utf16_data = field.field_data;
+            if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
+                utf16_data = utf16_data.subview(1, utf16_data.size() - 2);
             }
+            artist.filename = utf16le_to_utf8(utf16_data);
         }
-    }
+        // Field 0x14: Artist GUID (16 bytes, optional)
+        else if (field.field_id == 0x14 && field.field_size == 16) {
+            artist.guid = parse_windows_guid(field.field_data);
+        }
+    });
 
     return artist;
 }
 
 std::string ZuneHDParser::resolve_string_reference(uint32_t atom_id) {
     // Check cache
-    if (string_cache_.count(atom_id)) {
-        return string_cache_[atom_id];
+    if (const auto* cached = string_cache_.find(atom_id)) {
+        return *cached;
     }
 
     // Lookup in index table
-    if (!index_table_.count(atom_id)) {
+    uint32_t record_offset = 0;
+    if (!find_record_offset(atom_id, record_offset)) {
         return "";
     }
-
-    uint32_t record_offset = index_table_[atom_id];
     auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
     if (!record_opt.has_value()) {
         return "";
@@ -917,20 +855,17 @@ std::string ZuneHDParser::resolve_string_reference(uint32_t atom_id) {
         {
             // These use backwards varint field 0x44
             size_t entry_size = get_entry_size_for_schema(schema_type);
-            if (entry_size > 0) {
-                auto fields = parse_backwards_varints(record_data, entry_size);
-                for (const auto& field : fields) {
-                    if (field.field_id == 0x44 && field.field_size > 2) {
-                        std::vector<uint8_t> utf16_data = field.field_data;
-                        if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
-                            utf16_data.erase(utf16_data.begin());
-                            utf16_data.pop_back();
-                        }
-                        result = utf16le_to_utf8(utf16_data);
-                        break;
+            for_each_varint_field<RecordSchema::FilenameReference>(record_data, entry_size, [&](const BackwardsVarintField& field) -> bool {
+                if (field.field_id == 0x44 && field.field_size > 2) {
+                    ByteView utf16_data = field.field_data;
+                    if (!utf16_data.empty() && utf16_data[0] == 0x00 && utf16_data.back() == 0x00) {
+                        utf16_data = utf16_data.subview(1, utf16_data.size() - 2);
                     }
+                    result = utf16le_to_utf8(utf16_data);
+                    return false;
                 }
-            }
+                return true;
+            });
             break;
         }
 
@@ -945,16 +880,15 @@ std::string ZuneHDParser::resolve_string_reference(uint32_t atom_id) {
 
 std::string ZuneHDParser::resolve_artist_name(uint32_t atom_id) {
     // Check cache
-    if (artist_cache_.count(atom_id)) {
-        return artist_cache_[atom_id].name;
+    if (const auto* cached = artist_cache_.find(atom_id)) {
+        return cached->name;
     }
 
     // Lookup and parse artist record
-    if (!index_table_.count(atom_id)) {
+    uint32_t record_offset = 0;
+    if (!find_record_offset(atom_id, record_offset)) {
         return "";
     }
-
-    uint32_t record_offset = index_table_[atom_id];
     auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
     if (!record_opt.has_value()) {
         return "";
@@ -974,8 +908,8 @@ std::string ZuneHDParser::resolve_artist_name(uint32_t atom_id) {
 
 std::string ZuneHDParser::resolve_genre(uint32_t atom_id) {
     // Check cache first
-    if (genre_cache_.count(atom_id)) {
-        return genre_cache_[atom_id].name;
+    if (const auto* cached = genre_cache_.find(atom_id)) {
+        return cached->name;
     }
 
     std::string name = resolve_string_reference(atom_id);
@@ -993,17 +927,15 @@ std::string ZuneHDParser::resolve_genre(uint32_t atom_id) {
 
 std::optional<std::pair<uint32_t, std::string>> ZuneHDParser::resolve_album_info(uint32_t atom_id) {
     // Check cache
-    if (album_cache_.count(atom_id)) {
-        auto& album = album_cache_[atom_id];
-        return std::make_pair(album.atom_id, album.title);
+    if (const auto* album = album_cache_.find(atom_id)) {
+        return std::make_pair(album->atom_id, album->title);
     }
 
     // Lookup and parse album record
-    if (!index_table_.count(atom_id)) {
+    uint32_t record_offset = 0;
+    if (!find_record_offset(atom_id, record_offset)) {
         return std::nullopt;
     }
-
-    uint32_t record_offset = index_table_[atom_id];
     auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
     if (!record_opt.has_value()) {
         return std::nullopt;
@@ -1018,36 +950,35 @@ std::optional<std::pair<uint32_t, std::string>> ZuneHDParser::resolve_album_info
     return std::nullopt;
 }
 
-std::optional<ZMDBTrack> ZuneHDParser::resolve_track(uint32_t track_atom_id) {
-    // Lookup track record
-    if (!index_table_.count(track_atom_id)) {
-        return std::nullopt;
-    }
-
-    uint32_t record_offset = index_table_[track_atom_id];
-    auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
-    if (!record_opt.has_value()) {
-        return std::nullopt;
-    }
+std::unique_ptr<ZMDBParserBase> ZuneHDParser::create_worker() const {
+    auto worker = std::make_unique<ZuneHDParser>();
+    share_parse_state(*worker);
+    return worker;
+}
 
-    return parse_music_track(record_opt->second, track_atom_id);
+void ZuneHDParser::merge_worker_caches(ZMDBParserBase& worker) {
+    auto& w = static_cast<ZuneHDParser&>(worker);
+    string_cache_.insert(w.string_cache_);
+    artist_cache_.insert(w.artist_cache_);
+    album_cache_.insert(w.album_cache_);
+    genre_cache_.insert(w.genre_cache_);
 }
 
-void ZuneHDParser::extract_media_from_descriptor(
+void ZuneHDParser::extract_media_range(
     uint32_t descriptor_idx,
-    uint8_t expected_schema,
-    ZMDBLibrary& library
+    uint32_t begin,
+    uint32_t end,
+    ZMDBRecordSink& sink
 ) {
     if (descriptor_idx >= descriptors_.size()) {
         return;
     }
 
     const auto& desc = descriptors_[descriptor_idx];
-    if (desc.entry_count == 0) {
-        return;
-    }
+    end = std::min(end, desc.entry_count);
+    wait_for_bytes(desc.data_offset + static_cast<size_t>(end) * desc.entry_size);
 
-    for (uint32_t i = 0; i < desc.entry_count; i++) {
+    for (uint32_t i = begin; i < end; i++) {
         size_t entry_offset = desc.data_offset + (i * desc.entry_size);
         if (entry_offset + 4 > zmdb_data_.size()) {
             break;
@@ -1057,11 +988,10 @@ void ZuneHDParser::extract_media_from_descriptor(
         uint8_t schema_type = (atom_id >> 24) & 0xFF;
 
         // Lookup record in index table
-        if (!index_table_.count(atom_id)) {
+        uint32_t record_offset = 0;
+        if (!find_record_offset(atom_id, record_offset)) {
             continue;
         }
-
-        uint32_t record_offset = index_table_[atom_id];
         auto record_opt = read_record_at_offset(zmdb_data_, record_offset);
         if (!record_opt.has_value()) {
             continue;
@@ -1074,16 +1004,13 @@ void ZuneHDParser::extract_media_from_descriptor(
             continue;
         }
 
-        // Parse based on schema type (use placement new to construct in pre-allocated array)
+        // Parse based on schema type; the sink stores the record
         switch (schema_type) {
             case Schema::Music:
             {
-                if (library.track_count < library.tracks_capacity) {
-                    auto track = parse_music_track(record_data, atom_id);
-                    if (track.has_value()) {
-                        new (&library.tracks[library.track_count]) ZMDBTrack(std::move(track.value()));
-                        library.track_count++;
-                    }
+                auto track = parse_music_track(record_data, atom_id);
+                if (track.has_value()) {
+                    sink.OnTrack(std::move(track.value()));
                 }
                 break;
             }
@@ -1100,19 +1027,14 @@ void ZuneHDParser::extract_media_from_descriptor(
                     show_ref != 0 && ((show_ref >> 24) & 0xff) == Schema::PodcastShow;
 
                 if (is_video_podcast) {
-                    if (library.podcast_count < library.podcasts_capacity) {
-                        auto podcast = parse_video_podcast_episode(record_data, atom_id);
-                        if (podcast.has_value()) {
-                            new (&library.podcasts[library.podcast_count])
-                                ZMDBPodcast(std::move(podcast.value()));
-                            library.podcast_count++;
-                        }
+                    auto podcast = parse_video_podcast_episode(record_data, atom_id);
+                    if (podcast.has_value()) {
+                        sink.OnPodcast(std::move(podcast.value()));
                     }
-                } else if (library.video_count < library.videos_capacity) {
+                } else {
                     auto video = parse_video(record_data, atom_id);
                     if (video.has_value()) {
-                        new (&library.videos[library.video_count]) ZMDBVideo(std::move(video.value()));
-                        library.video_count++;
+                        sink.OnVideo(std::move(video.value()));
                     }
                 }
                 break;
@@ -1120,24 +1042,18 @@ void ZuneHDParser::extract_media_from_descriptor(
 
             case Schema::Picture:
             {
-                if (library.picture_count < library.pictures_capacity) {
-                    auto picture = parse_picture(record_data, atom_id);
-                    if (picture.has_value()) {
-                        new (&library.pictures[library.picture_count]) ZMDBPicture(std::move(picture.value()));
-                        library.picture_count++;
-                    }
+                auto picture = parse_picture(record_data, atom_id);
+                if (picture.has_value()) {
+                    sink.OnPicture(std::move(picture.value()));
                 }
                 break;
             }
 
             case Schema::Playlist:
             {
-                if (library.playlist_count < library.playlists_capacity) {
-                    auto playlist = parse_playlist(record_data, atom_id);
-                    if (playlist.has_value()) {
-                        new (&library.playlists[library.playlist_count]) ZMDBPlaylist(std::move(playlist.value()));
-                        library.playlist_count++;
-                    }
+                auto playlist = parse_playlist(record_data, atom_id);
+                if (playlist.has_value()) {
+                    sink.OnPlaylist(std::move(playlist.value()));
                 }
                 break;
             }
@@ -1146,32 +1062,25 @@ void ZuneHDParser::extract_media_from_descriptor(
             {
                 auto show = parse_podcast_show(record_data, atom_id);
                 if (show.has_value()) {
-                    library.podcast_show_metadata[atom_id] = std::move(show.value());
-                    library.podcast_show_count++;
+                    sink.OnPodcastShow(atom_id, std::move(show.value()));
                 }
                 break;
             }
 
             case Schema::PodcastEpisode:
             {
-                if (library.podcast_count < library.podcasts_capacity) {
-                    auto podcast = parse_podcast_episode(record_data, atom_id);
-                    if (podcast.has_value()) {
-                        new (&library.podcasts[library.podcast_count]) ZMDBPodcast(std::move(podcast.value()));
-                        library.podcast_count++;
-                    }
+                auto podcast = parse_podcast_episode(record_data, atom_id);
+                if (podcast.has_value()) {
+                    sink.OnPodcast(std::move(podcast.value()));
                 }
                 break;
             }
 
             case Schema::AudiobookTrack:
             {
-                if (library.audiobook_count < library.audiobooks_capacity) {
-                    auto audiobook = parse_audiobook_track(record_data, atom_id);
-                    if (audiobook.has_value()) {
-                        new (&library.audiobooks[library.audiobook_count]) ZMDBAudiobook(std::move(audiobook.value()));
-                        library.audiobook_count++;
-                    }
+                auto audiobook = parse_audiobook_track(record_data, atom_id);
+                if (audiobook.has_value()) {
+                    sink.OnAudiobook(std::move(audiobook.value()));
                 }
                 break;
             }
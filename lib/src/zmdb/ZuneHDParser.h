@@ -24,63 +24,55 @@ public:
     ZuneHDParser() = default;
     ~ZuneHDParser() override = default;
 
-    /**
-     * Extract complete library from Zune HD ZMDB file.
-     *
-     * @param zmdb_data Raw ZMDB file bytes
-     * @return Parsed library with all media types
-     */
-    ZMDBLibrary ExtractLibrary(const std::vector<uint8_t>& zmdb_data) override;
-
 private:
     // Schema parsers
     std::optional<ZMDBTrack> parse_music_track(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBVideo> parse_video(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBPicture> parse_picture(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBPlaylist> parse_playlist(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBPodcast> parse_podcast_episode(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBPodcast> parse_video_podcast_episode(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBPodcastShow> parse_podcast_show(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBAudiobook> parse_audiobook_track(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBAlbum> parse_album(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
     std::optional<ZMDBArtist> parse_artist(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint32_t atom_id
     );
 
@@ -90,30 +82,29 @@ private:
     std::string resolve_genre(uint32_t atom_id);
     std::optional<std::pair<uint32_t, std::string>> resolve_album_info(uint32_t atom_id);
 
-    // Track resolution for playlists
-    std::optional<ZMDBTrack> resolve_track(uint32_t track_atom_id);
-
     // Filter implementation
     bool should_filter_record(
-        const std::vector<uint8_t>& record_data,
+        ByteView record_data,
         uint8_t schema_type
     ) const;
 
-    // Descriptor extraction
-    void extract_media_from_descriptor(
+    // Library extraction from a Zune HD ZMDB file (ZMDBParserBase hooks)
+    void extract_records(ByteView zmdb_data, ZMDBRecordSink& sink) override;
+    zune::DeviceFamily library_family() const override;
+    void extract_media_range(
         uint32_t descriptor_idx,
-        uint8_t expected_schema,
-        ZMDBLibrary& library
-    );
-
-    // Caches for resolved references
-    std::map<uint32_t, std::string> string_cache_;
-    std::map<uint32_t, ZMDBArtist> artist_cache_;
-    std::map<uint32_t, ZMDBAlbum> album_cache_;
-    std::map<uint32_t, ZMDBGenre> genre_cache_;
-
-    // Parsed descriptors
-    std::vector<Descriptor> descriptors_;
+        uint32_t begin,
+        uint32_t end,
+        ZMDBRecordSink& sink
+    ) override;
+    std::unique_ptr<ZMDBParserBase> create_worker() const override;
+    void merge_worker_caches(ZMDBParserBase& worker) override;
+
+    // Caches for resolved references (flat, schema-partitioned)
+    AtomMap<std::string> string_cache_;
+    AtomMap<ZMDBArtist> artist_cache_;
+    AtomMap<ZMDBAlbum> album_cache_;
+    AtomMap<ZMDBGenre> genre_cache_;
 };
 
 } // namespace zmdb
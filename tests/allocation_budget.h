@@ -0,0 +1,124 @@
+/**
+ * allocation_budget.h
+ *
+ * Counting allocator for tests and benchmarks. Including this header
+ * replaces the global allocation functions for the whole executable, so
+ * every std::string / std::vector / map node is counted: include it from
+ * exactly one translation unit, the executable's own .cpp (a second copy
+ * fails to link).
+ *
+ * Allocations are counted process-wide and per thread. AllocationScope
+ * measures the calling thread only, so request workers and other threads
+ * running alongside do not disturb a budget on, say, the poll thread.
+ * WithinBudget checks an average per operation and prints the measurement
+ * either way, so a test's output shows how close each path runs to its
+ * budget:
+ *
+ *     alloc_budget::AllocationScope scope;
+ *     for (int i = 0; i < kRuns; i++) Operation();
+ *     ASSERT_TRUE(alloc_budget::WithinBudget("Operation", scope.Allocations(), kRuns, 2.0),
+ *                 "Operation allocation budget");
+ *
+ * Measure after a warm-up run: first-use allocations (maps gaining their
+ * first node, buffers reaching their working size) belong to setup, not to
+ * the steady state a budget describes.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace alloc_budget {
+
+struct Counts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+inline std::atomic<uint64_t> g_allocations{0};
+inline std::atomic<uint64_t> g_bytes{0};
+inline thread_local Counts t_counts;
+
+inline void* CountedAllocate(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+    t_counts.allocations++;
+    t_counts.bytes += size;
+    return std::malloc(size ? size : 1);
+}
+
+/// Every thread's allocations since the process started
+inline Counts ProcessCounts() {
+    return {g_allocations.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed)};
+}
+
+/// The calling thread's allocations since it started
+inline Counts ThreadCounts() {
+    return t_counts;
+}
+
+/// Allocations made by the calling thread since construction (or Reset)
+class AllocationScope {
+public:
+    AllocationScope() : start_(ThreadCounts()) {}
+
+    uint64_t Allocations() const { return ThreadCounts().allocations - start_.allocations; }
+    uint64_t Bytes() const { return ThreadCounts().bytes - start_.bytes; }
+    void Reset() { start_ = ThreadCounts(); }
+
+private:
+    Counts start_;
+};
+
+/**
+ * True if allocations over operations runs stay within budget_per_op on
+ * average. Prints the measurement, and a FAIL line when over budget.
+ */
+inline bool WithinBudget(const std::string& what, uint64_t allocations, uint64_t operations,
+                         double budget_per_op) {
+    double per_op = operations ? double(allocations) / double(operations) : double(allocations);
+    bool within = per_op <= budget_per_op;
+    std::cout << "  " << what << ": " << per_op << " allocations each (budget " << budget_per_op
+              << ", " << operations << " measured)" << std::endl;
+    if (!within) {
+        std::cerr << "FAIL: " << what << " over its allocation budget: " << per_op << " > "
+                  << budget_per_op << std::endl;
+    }
+    return within;
+}
+
+} // namespace alloc_budget
+
+// GCC sees these inlined into the standard allocators and takes the
+// free() as mismatched with operator new
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    if (void* p = alloc_budget::CountedAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_budget::CountedAllocate(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_budget::CountedAllocate(size);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
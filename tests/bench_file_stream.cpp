@@ -0,0 +1,171 @@
+/**
+ * bench_file_stream.cpp
+ *
+ * Throughput of the SendObject file sources on a large file. Compares the
+ * buffered stdio reads cli::ObjectInputStream does (fopen + fread) against
+ * zune::FileSource, both mapped and with unbuffered reads, at the request
+ * sizes a bulk writer issues. Each Read() lands in a reused transfer buffer
+ * the way SendObject's USB packets do.
+ *
+ * With no path, a 500 MB file of pseudo-random bytes (the size of a long
+ * WMV video podcast) is written to the current directory and removed
+ * afterwards. --cold drops the file from the page cache before every run
+ * (POSIX only), which approximates the first upload of a freshly copied file.
+ *
+ * Usage: bench_file_stream [--cold] [path] [size_mb]
+ */
+
+#include "lib/src/ZuneFileSource.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool WriteFixture(const std::string& path, uint64_t size) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::vector<uint32_t> block((4u << 20) / sizeof(uint32_t));
+    std::mt19937 rng(500);
+    for (uint64_t written = 0; written < size;) {
+        for (auto& w : block) w = rng();
+        size_t n = static_cast<size_t>(std::min<uint64_t>(block.size() * sizeof(uint32_t), size - written));
+        if (std::fwrite(block.data(), 1, n, f) != n) {
+            std::fclose(f);
+            return false;
+        }
+        written += n;
+    }
+    return std::fclose(f) == 0;
+}
+
+void DropFromCache(const std::string& path) {
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+// Fold the transfer buffer so the copies cannot be elided
+uint64_t Touch(const uint8_t* data, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i += 4096) sum += data[i];
+    return sum;
+}
+
+struct Result {
+    double seconds = 0;
+    uint64_t bytes = 0;
+    uint64_t checksum = 0;
+};
+
+Result RunStdio(const std::string& path, size_t chunk) {
+    Result r;
+    std::vector<uint8_t> buffer(chunk);
+    auto start = std::chrono::steady_clock::now();
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return r;
+    size_t n;
+    while ((n = std::fread(buffer.data(), 1, chunk, f)) > 0) {
+        r.bytes += n;
+        r.checksum += Touch(buffer.data(), n);
+    }
+    std::fclose(f);
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return r;
+}
+
+Result RunFileSource(const std::string& path, size_t chunk, bool allow_map) {
+    Result r;
+    std::vector<uint8_t> buffer(chunk);
+    auto start = std::chrono::steady_clock::now();
+    zune::FileSource source;
+    if (!source.Open(path, allow_map)) return r;
+    size_t n;
+    while ((n = source.Read(buffer.data(), chunk)) > 0) {
+        r.bytes += n;
+        r.checksum += Touch(buffer.data(), n);
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool cold = false;
+    std::string path;
+    uint64_t size_mb = 500;
+    int arg = 1;
+    if (arg < argc && std::strcmp(argv[arg], "--cold") == 0) {
+        cold = true;
+        arg++;
+    }
+    if (arg < argc) path = argv[arg++];
+    if (arg < argc) size_mb = std::strtoull(argv[arg++], nullptr, 10);
+
+    bool owns_fixture = path.empty();
+    if (owns_fixture) {
+        path = "bench_file_stream.tmp";
+        std::cout << "Writing " << size_mb << " MB fixture to " << path << "...\n";
+        if (!WriteFixture(path, size_mb << 20)) {
+            std::cerr << "Cannot write " << path << "\n";
+            return 1;
+        }
+    }
+
+    const size_t chunks[] = {16u << 10, 64u << 10, 256u << 10, 1u << 20};
+    struct Mode {
+        const char* name;
+        int kind;
+    } modes[] = {{"stdio fread", 0}, {"FileSource read", 1}, {"FileSource mmap", 2}};
+
+    std::cout << (cold ? "Cold" : "Warm") << " page cache, " << path << "\n";
+    std::cout << std::left << std::setw(18) << "source" << std::right
+              << std::setw(10) << "chunk" << std::setw(12) << "MB/s" << std::setw(10) << "ms" << "\n";
+
+    bool ok = true;
+    uint64_t expected = 0;
+    // One untimed pass so warm runs all start from a populated cache
+    if (!cold) RunStdio(path, 1u << 20);
+
+    for (size_t chunk : chunks) {
+        for (const auto& mode : modes) {
+            if (cold) DropFromCache(path);
+            Result r = mode.kind == 0 ? RunStdio(path, chunk)
+                                      : RunFileSource(path, chunk, mode.kind == 2);
+            if (expected == 0) expected = r.checksum;
+            if (r.bytes == 0 || r.checksum != expected) ok = false;
+            double mbs = r.seconds > 0 ? (r.bytes / 1048576.0) / r.seconds : 0;
+            std::cout << std::left << std::setw(18) << mode.name << std::right
+                      << std::setw(9) << (chunk >> 10) << "K"
+                      << std::setw(12) << std::fixed << std::setprecision(0) << mbs
+                      << std::setw(10) << std::setprecision(1) << r.seconds * 1000 << "\n";
+        }
+    }
+
+    if (owns_fixture) std::remove(path.c_str());
+    if (!ok) {
+        std::cerr << "FAIL: sources returned different data\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,656 @@
+/**
+ * bench_network_stack.cpp
+ *
+ * Replays device request traces through the whole network stack, PPP to
+ * HTTP and back, against a simulated Zune at the other end of the 0x922c /
+ * 0x922d link. No device or server is needed: requests are answered in
+ * static mode from fixture files written to a temporary directory.
+ *
+ * The simulated device behaves like the Zune's TCP client: it opens one
+ * connection per request (SYN with SACK-permitted), sends the GET, ACKs
+ * every data segment with the configured window (SACK blocks for holes),
+ * and closes with FIN once Content-Length bytes of body have arrived.
+ * Data segments to the device are dropped at the configured rate; which
+ * ones is a hash of the seed, connection, stream offset and attempt, so
+ * every run loses the same segments however the request workers interleave.
+ * Frames from the device reach the host after the configured latency, as
+ * 0x922d would return them once the device has queued them.
+ *
+ * Traces: "biography" (one artist page after another), "images" (artwork
+ * one at a time), "burst" (eight images of an artist requested together),
+ * or a file of "<offset_ms> <path>" lines recorded from a device (requests
+ * with the same offset go out together). Unless --paced, each group goes
+ * out as soon as the previous one has finished.
+ *
+ * Reports requests per second, p50/p99 time to last byte, retransmits and
+ * process CPU time per MB of response.
+ *
+ * Usage: bench_network_stack [--trace biography|images|burst|FILE]
+ *            [--loss PERCENT] [--latency MS] [--window BYTES]
+ *            [--repeat N] [--seed N] [--paced]
+ */
+
+#include "lib/src/protocols/ppp/PPPParser.h"
+#include "lib/src/protocols/http/ZuneHTTPInterceptor.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+constexpr uint32_t kDeviceIP = 0xC0A83765;   // 192.168.55.101, as IPCP assigns
+constexpr uint32_t kServerIP = 0xC0A83764;   // 192.168.55.100
+constexpr uint16_t kHttpPort = 80;
+constexpr int kPollMs = 5;
+constexpr auto kStallTimeout = std::chrono::seconds(30);
+
+struct LinkProfile {
+    double loss = 0.0;         // Fraction of data segments to the device dropped
+    int latency_ms = 0;        // Before the host sees a device frame
+    uint16_t window = ZUNE_TCP_WINDOW_SIZE;
+    uint64_t seed = 54;
+};
+
+struct TraceEntry {
+    int64_t offset_ms;
+    std::string path;
+};
+
+/**
+ * The device end of the link. Frames the interceptor sends arrive in
+ * DeviceOperation922c (or SendVendorCommand); the device's answers queue
+ * up and are returned by DeviceOperation922d once their latency has passed.
+ */
+class SimulatedZune : public ZuneHTTPInterceptor {
+public:
+    struct Totals {
+        size_t completed = 0;
+        size_t failed = 0;             // Status other than 200
+        uint64_t body_bytes = 0;       // Response bytes delivered in order
+        uint64_t dropped = 0;          // Data segments lost on the way to the device
+        uint64_t duplicates = 0;       // Data segments the device already had
+        std::vector<double> ttlb_ms;   // GET sent to last byte received
+    };
+
+    explicit SimulatedZune(const LinkProfile& link)
+        : ZuneHTTPInterceptor(mtp::SessionPtr()), link_(link), rng_(link.seed) {}
+
+    // Stop before the device goes away: request workers may still be sending
+    ~SimulatedZune() { Stop(); }
+
+    bool SendVendorCommand(const mtp::ByteArray& data) override {
+        DeviceOperation922c(data);
+        return true;
+    }
+
+    /// Open a connection and send the GET once it is established
+    void Request(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint16_t port = next_port_++;
+        Connection& conn = connections_[port];
+        conn.path = path;
+        conn.snd_nxt = static_cast<uint32_t>(rng_());
+        outstanding_++;
+
+        // MSS is left to the host; SACK-permitted as the device offers it
+        const uint8_t options[] = {TCPParser::TCP_OPTION_NOP, TCPParser::TCP_OPTION_NOP,
+                                   TCPParser::TCP_OPTION_SACK_PERMITTED, 2};
+        ToHost(port, conn.snd_nxt++, 0, TCPParser::TCP_FLAG_SYN, options, sizeof(options), nullptr, 0);
+    }
+
+    size_t Outstanding() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return outstanding_;
+    }
+
+    Totals GetTotals() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return totals_;
+    }
+
+protected:
+    bool DiscoverEndpoints() override { return true; }
+    bool HasDeviceLink() const override { return true; }
+
+    void WaitForDeviceEvent(int timeout_ms) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            auto now = Clock::now();
+            if (!to_host_.empty() && to_host_.front().ready <= now) {
+                return;
+            }
+            if (now >= deadline) {
+                return;
+            }
+            auto wake = deadline;
+            if (!to_host_.empty()) {
+                wake = std::min(wake, to_host_.front().ready);
+            }
+            ready_.wait_until(lock, wake);
+        }
+    }
+
+    void DeviceOperation922c(const mtp::ByteArray& payload) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& frame : PPPParser::ExtractFramesWithBuffer(payload, incomplete_)) {
+            ReceiveFrame(frame);
+        }
+    }
+
+    mtp::ByteArray DeviceOperation922d() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mtp::ByteArray data;
+        auto now = Clock::now();
+        while (!to_host_.empty() && to_host_.front().ready <= now) {
+            const mtp::ByteArray& frame = to_host_.front().frame;
+            data.insert(data.end(), frame.begin(), frame.end());
+            to_host_.pop_front();
+        }
+        return data;
+    }
+
+private:
+    struct Connection {
+        std::string path;
+        uint32_t snd_nxt = 0;
+        uint32_t irs = 0;                  // Host's initial sequence number
+        bool established = false;
+        bool done = false;
+        uint32_t received = 0;             // Contiguous response bytes
+        std::map<uint32_t, mtp::ByteArray> out_of_order;  // By stream offset
+        std::map<uint32_t, uint8_t> attempts;              // Times each offset was sent
+        uint32_t latest = 0;               // Offset of the last segment received
+        std::string head;                  // Response header, until parsed
+        size_t expected = 0;               // Header and body, once the header is known
+        int status = 0;
+        Clock::time_point requested;
+    };
+
+    struct PendingFrame {
+        Clock::time_point ready;
+        mtp::ByteArray frame;
+    };
+
+    void ReceiveFrame(const mtp::ByteArray& frame) {
+        uint16_t protocol = 0;
+        mtp::ByteArray ip_packet = PPPParser::ExtractPayload(frame, &protocol);
+        if (protocol != 0x0021 || ip_packet.size() < 40) {
+            return;  // CCP, IPCP and the like: the simulated device needs none
+        }
+        IPParser::IPHeader ip = IPParser::ParseHeader(ip_packet);
+        if (ip.protocol != 6) {
+            return;
+        }
+        mtp::ByteArray segment = IPParser::ExtractPayload(ip_packet);
+        TCPParser::TCPHeader tcp = TCPParser::ParseHeader(segment);
+        auto it = connections_.find(tcp.dst_port);
+        if (it == connections_.end()) {
+            return;
+        }
+        Connection& conn = it->second;
+        uint16_t port = it->first;
+
+        if ((tcp.flags & TCPParser::TCP_FLAG_SYN) && (tcp.flags & TCPParser::TCP_FLAG_ACK)) {
+            if (!conn.established) {
+                conn.established = true;
+                conn.irs = tcp.seq_num;
+                SendRequest(port, conn);
+            }
+            return;
+        }
+
+        mtp::ByteArray payload = TCPParser::ExtractPayload(segment);
+        if (!payload.empty()) {
+            uint32_t offset = tcp.seq_num - conn.irs - 1;
+            if (Dropped(port, conn, offset)) {
+                totals_.dropped++;
+                return;
+            }
+            ReceiveData(port, conn, offset, payload);
+        }
+        if (tcp.flags & TCPParser::TCP_FLAG_FIN) {
+            ToHost(port, conn.snd_nxt, tcp.seq_num + static_cast<uint32_t>(payload.size()) + 1,
+                   TCPParser::TCP_FLAG_ACK, nullptr, 0, nullptr, 0);
+        }
+    }
+
+    void SendRequest(uint16_t port, Connection& conn) {
+        bool image = conn.path.find("/image/") != std::string::npos;
+        std::string request = "GET " + conn.path + " HTTP/1.1\r\n"
+                              "Accept: */*\r\n"
+                              "User-Agent: Zune/4.8\r\n"
+                              "Host: " + std::string(image ? "image.catalog.zune.net" : "catalog.zune.net") + "\r\n"
+                              "Connection: Keep-Alive\r\n"
+                              "\r\n";
+        uint32_t ack = conn.irs + 1;
+        ToHost(port, conn.snd_nxt, ack, TCPParser::TCP_FLAG_ACK, nullptr, 0, nullptr, 0);
+        ToHost(port, conn.snd_nxt, ack, TCPParser::TCP_FLAG_ACK | TCPParser::TCP_FLAG_PSH, nullptr, 0,
+               reinterpret_cast<const uint8_t*>(request.data()), request.size());
+        conn.snd_nxt += static_cast<uint32_t>(request.size());
+        conn.requested = Clock::now();
+    }
+
+    void ReceiveData(uint16_t port, Connection& conn, uint32_t offset, const mtp::ByteArray& data) {
+        uint32_t end = offset + static_cast<uint32_t>(data.size());
+        conn.latest = offset;
+        if (end <= conn.received) {
+            totals_.duplicates++;
+        } else if (offset > conn.received) {
+            auto& held = conn.out_of_order[offset];
+            if (held.size() < data.size()) {
+                held = data;
+            }
+        } else {
+            Deliver(conn, data.data() + (conn.received - offset), end - conn.received);
+            // Whatever was held that now continues the stream
+            for (auto held = conn.out_of_order.begin();
+                 held != conn.out_of_order.end() && held->first <= conn.received;
+                 held = conn.out_of_order.erase(held)) {
+                uint32_t held_end = held->first + static_cast<uint32_t>(held->second.size());
+                if (held_end > conn.received) {
+                    Deliver(conn, held->second.data() + (conn.received - held->first), held_end - conn.received);
+                }
+            }
+        }
+
+        Acknowledge(port, conn);
+
+        if (!conn.done && conn.expected != 0 && conn.received >= conn.expected) {
+            conn.done = true;
+            outstanding_--;
+            totals_.completed++;
+            if (conn.status != 200) {
+                totals_.failed++;
+            }
+            totals_.ttlb_ms.push_back(
+                std::chrono::duration<double, std::milli>(Clock::now() - conn.requested).count());
+            ToHost(port, conn.snd_nxt++, conn.irs + 1 + conn.received,
+                   TCPParser::TCP_FLAG_FIN | TCPParser::TCP_FLAG_ACK, nullptr, 0, nullptr, 0);
+        }
+    }
+
+    void Deliver(Connection& conn, const uint8_t* data, uint32_t size) {
+        conn.received += size;
+        totals_.body_bytes += size;
+        if (conn.expected != 0) {
+            return;
+        }
+        conn.head.append(reinterpret_cast<const char*>(data), size);
+        size_t header_end = conn.head.find("\r\n\r\n");
+        if (header_end == std::string::npos) {
+            return;
+        }
+        conn.status = std::atoi(conn.head.c_str() + conn.head.find(' ') + 1);
+        std::string lower = conn.head.substr(0, header_end);
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        size_t length = lower.find("\r\ncontent-length:");
+        size_t body = length == std::string::npos ? 0 : std::strtoul(lower.c_str() + length + 17, nullptr, 10);
+        conn.expected = header_end + 4 + body;
+        conn.head.clear();
+    }
+
+    // Cumulative ACK, with the holes the device has filled past it as SACK
+    // blocks: the newest first, as RFC 2018 asks
+    void Acknowledge(uint16_t port, Connection& conn) {
+        std::vector<std::pair<uint32_t, uint32_t>> blocks;
+        for (const auto& held : conn.out_of_order) {
+            uint32_t end = held.first + static_cast<uint32_t>(held.second.size());
+            if (!blocks.empty() && held.first <= blocks.back().second) {
+                blocks.back().second = std::max(blocks.back().second, end);
+            } else {
+                blocks.emplace_back(held.first, end);
+            }
+        }
+        auto newest = std::find_if(blocks.begin(), blocks.end(), [&](const auto& block) {
+            return conn.latest >= block.first && conn.latest < block.second;
+        });
+        if (newest != blocks.end()) {
+            std::rotate(blocks.begin(), newest, newest + 1);
+        }
+        blocks.resize(std::min<size_t>(blocks.size(), 3));
+
+        uint8_t options[2 + 2 + 8 * 3];
+        size_t length = 0;
+        if (!blocks.empty()) {
+            options[length++] = TCPParser::TCP_OPTION_NOP;
+            options[length++] = TCPParser::TCP_OPTION_NOP;
+            options[length++] = TCPParser::TCP_OPTION_SACK;
+            options[length++] = static_cast<uint8_t>(2 + 8 * blocks.size());
+            for (const auto& block : blocks) {
+                for (uint32_t edge : {conn.irs + 1 + block.first, conn.irs + 1 + block.second}) {
+                    options[length++] = static_cast<uint8_t>(edge >> 24);
+                    options[length++] = static_cast<uint8_t>(edge >> 16);
+                    options[length++] = static_cast<uint8_t>(edge >> 8);
+                    options[length++] = static_cast<uint8_t>(edge);
+                }
+            }
+        }
+        ToHost(port, conn.snd_nxt, conn.irs + 1 + conn.received, TCPParser::TCP_FLAG_ACK,
+               options, length, nullptr, 0);
+    }
+
+    bool Dropped(uint16_t port, Connection& conn, uint32_t offset) {
+        if (link_.loss <= 0) {
+            return false;
+        }
+        uint64_t attempt = conn.attempts[offset]++;
+        uint64_t x = link_.seed ^ (uint64_t(port) << 48) ^ (attempt << 32) ^ offset;
+        // splitmix64 finalizer
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return static_cast<double>(x >> 11) * 0x1.0p-53 < link_.loss;
+    }
+
+    // Queue a device segment for the host; options are whole 32-bit words
+    void ToHost(uint16_t port, uint32_t seq, uint32_t ack, uint8_t flags,
+                const uint8_t* options, size_t options_size, const uint8_t* data, size_t size) {
+        TCPParser::TCPHeader tcp{};
+        tcp.src_port = port;
+        tcp.dst_port = kHttpPort;
+        tcp.seq_num = seq;
+        tcp.ack_num = ack;
+        tcp.data_offset = static_cast<uint8_t>(5 + options_size / 4);
+        tcp.flags = flags;
+        tcp.window_size = link_.window;
+
+        // Options ride in front of the payload: the checksum covers both
+        mtp::ByteArray body(options, options + options_size);
+        if (size > 0) {
+            body.insert(body.end(), data, data + size);
+        }
+
+        IPParser::IPHeader ip{};
+        ip.version = 4;
+        ip.header_length = 5;
+        ip.identification = ip_id_++;
+        ip.flags_offset = 0x4000;  // Don't fragment
+        ip.ttl = 64;
+        ip.protocol = 6;
+        ip.src_ip = kDeviceIP;
+        ip.dst_ip = kServerIP;
+
+        mtp::ByteArray packet = IPParser::BuildPacket(
+            ip, TCPParser::BuildSegment(tcp, body, kDeviceIP, kServerIP));
+        to_host_.push_back({Clock::now() + std::chrono::milliseconds(link_.latency_ms),
+                            PPPParser::WrapPayload(packet)});
+        ready_.notify_all();
+    }
+
+    LinkProfile link_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::mt19937_64 rng_;
+    mtp::ByteArray incomplete_;
+    std::deque<PendingFrame> to_host_;
+    std::map<uint16_t, Connection> connections_;
+    uint16_t next_port_ = 49152;
+    uint16_t ip_id_ = 1;
+    size_t outstanding_ = 0;
+    Totals totals_;
+};
+
+// ── Fixtures ─────────────────────────────────────────────────────────────
+
+struct Fixtures {
+    fs::path dir;
+    std::string biography;
+    std::vector<std::string> images;  // Picked by resource id
+};
+
+Fixtures* g_fixtures = nullptr;
+
+bool WriteFile(const fs::path& path, const std::string& data) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+bool WriteFixtures(Fixtures& fixtures) {
+    fixtures.dir = fs::temp_directory_path() / ("bench_network_stack_" + std::to_string(std::random_device()()));
+    std::error_code ec;
+    fs::create_directories(fixtures.dir, ec);
+    if (ec) return false;
+
+    // An artist biography: Atom feed around a few KB of prose
+    std::ostringstream xml;
+    xml << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        << "<a:entry xmlns:a=\"http://www.w3.org/2005/Atom\" xmlns=\"http://schemas.zune.net/catalog/music/2007/10\">"
+        << "<a:link rel=\"self\" type=\"application/atom+xml\" href=\"/v3.0/en-US/music/artist/biography\" />"
+        << "<a:updated>2010-06-01T00:00:00Z</a:updated><a:title type=\"text\">Biography</a:title><a:content type=\"html\">";
+    for (int i = 0; i < 40; i++) {
+        xml << "Formed in " << (1970 + i) << ", the band recorded " << (i % 7 + 2)
+            << " albums before the lineup changed again &lt;br /&gt;";
+    }
+    xml << "</a:content></a:entry>\n";
+    fixtures.biography = (fixtures.dir / "biography.xml").string();
+    if (!WriteFile(fixtures.biography, xml.str())) return false;
+
+    // JPEG-sized, incompressible bodies: a thumbnail, a device-sized
+    // artwork and a background
+    std::mt19937 rng(2118);
+    for (size_t size : {12 * 1024, 45 * 1024, 120 * 1024}) {
+        std::string body(size, '\0');
+        body[0] = '\xFF';
+        body[1] = '\xD8';
+        for (size_t i = 2; i < size; i++) body[i] = static_cast<char>(rng());
+        std::string path = (fixtures.dir / ("image_" + std::to_string(size / 1024) + "k.jpg")).string();
+        if (!WriteFile(path, body)) return false;
+        fixtures.images.push_back(path);
+    }
+    return true;
+}
+
+const char* ResolvePath(const char* artist_uuid, const char* endpoint_type, const char* resource_id, void*) {
+    (void)artist_uuid;
+    std::string type = endpoint_type ? endpoint_type : "";
+    if (type == "biography") {
+        return strdup(g_fixtures->biography.c_str());
+    }
+    if (!resource_id) {
+        return nullptr;
+    }
+    size_t pick = std::hash<std::string>()(resource_id) % g_fixtures->images.size();
+    return strdup(g_fixtures->images[pick].c_str());
+}
+
+// ── Traces ───────────────────────────────────────────────────────────────
+
+std::string Uuid(std::mt19937& rng) {
+    std::ostringstream out;
+    out << std::hex << std::setfill('0');
+    for (int part : {8, 4, 4, 4, 12}) {
+        if (out.tellp() > 0) out << '-';
+        for (int i = 0; i < part; i++) out << (rng() & 0xF);
+    }
+    return out.str();
+}
+
+std::vector<TraceEntry> BuiltInTrace(const std::string& name) {
+    std::mt19937 rng(54);
+    std::vector<TraceEntry> trace;
+    if (name == "biography") {
+        for (int i = 0; i < 24; i++) {
+            trace.push_back({i * 150, "/v3.0/en-US/music/artist/" + Uuid(rng) + "/biography"});
+        }
+    } else if (name == "images") {
+        for (int i = 0; i < 24; i++) {
+            trace.push_back({i * 80, "/v3.0/en-US/image/" + Uuid(rng) + "?width=240&height=240"});
+        }
+    } else if (name == "burst") {
+        for (int group = 0; group < 6; group++) {
+            for (int i = 0; i < 8; i++) {
+                trace.push_back({group * 400, "/v3.0/en-US/image/" + Uuid(rng) + "?width=480&resize=true"});
+            }
+        }
+    }
+    return trace;
+}
+
+std::vector<TraceEntry> LoadTrace(const std::string& path) {
+    std::vector<TraceEntry> trace;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        TraceEntry entry;
+        if (line.empty() || line[0] == '#' || !(fields >> entry.offset_ms >> entry.path)) {
+            continue;
+        }
+        trace.push_back(entry);
+    }
+    std::stable_sort(trace.begin(), trace.end(),
+                     [](const TraceEntry& a, const TraceEntry& b) { return a.offset_ms < b.offset_ms; });
+    return trace;
+}
+
+double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(rank, values.size() - 1)];
+}
+
+// Serve the trace; false if a group did not finish in time
+bool Replay(SimulatedZune& device, const std::vector<TraceEntry>& trace, bool paced) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < trace.size();) {
+        int64_t offset = trace[i].offset_ms;
+        if (paced) {
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(offset));
+        }
+        for (; i < trace.size() && trace[i].offset_ms == offset; i++) {
+            device.Request(trace[i].path);
+        }
+        auto deadline = Clock::now() + kStallTimeout;
+        while (device.Outstanding() > 0) {
+            device.PollOnce(kPollMs);
+            if (Clock::now() > deadline) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    LinkProfile link;
+    std::string trace_name = "biography";
+    int repeat = 5;
+    bool paced = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--trace" && has_value) {
+            trace_name = argv[++i];
+        } else if (arg == "--loss" && has_value) {
+            link.loss = std::strtod(argv[++i], nullptr) / 100.0;
+        } else if (arg == "--latency" && has_value) {
+            link.latency_ms = std::atoi(argv[++i]);
+        } else if (arg == "--window" && has_value) {
+            link.window = static_cast<uint16_t>(std::min(std::strtoul(argv[++i], nullptr, 10), 65535ul));
+        } else if (arg == "--repeat" && has_value) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && has_value) {
+            link.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--paced") {
+            paced = true;
+        } else {
+            std::cerr << "Usage: bench_network_stack [--trace biography|images|burst|FILE]\n"
+                      << "           [--loss PERCENT] [--latency MS] [--window BYTES]\n"
+                      << "           [--repeat N] [--seed N] [--paced]\n";
+            return 2;
+        }
+    }
+
+    std::vector<TraceEntry> trace = BuiltInTrace(trace_name);
+    if (trace.empty()) {
+        trace = LoadTrace(trace_name);
+    }
+    if (trace.empty()) {
+        std::cerr << "No requests in trace " << trace_name << "\n";
+        return 2;
+    }
+
+    Fixtures fixtures;
+    if (!WriteFixtures(fixtures)) {
+        std::cerr << "Could not write fixtures to " << fixtures.dir << "\n";
+        return 1;
+    }
+    g_fixtures = &fixtures;
+
+    InterceptorConfig config;
+    config.mode = InterceptionMode::Static;
+    config.server_ip = IPParser::IPToString(kServerIP);
+
+    int status = 0;
+    {
+        SimulatedZune device(link);
+        device.SetPathResolverCallback(ResolvePath, nullptr);
+        device.Start(config);
+        device.EnableNetworkPolling();
+
+        std::cout << "Trace " << trace_name << ": " << trace.size() << " requests x " << repeat
+                  << ", loss " << link.loss * 100 << "%, latency " << link.latency_ms
+                  << " ms, window " << link.window << (paced ? ", paced" : "") << "\n";
+
+        std::clock_t cpu_start = std::clock();
+        auto wall_start = Clock::now();
+        bool finished = true;
+        for (int r = 0; r < repeat && finished; r++) {
+            finished = Replay(device, trace, paced);
+        }
+        double wall = std::chrono::duration<double>(Clock::now() - wall_start).count();
+        double cpu = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        SimulatedZune::Totals totals = device.GetTotals();
+        InterceptorNetworkStats stats = device.GetNetworkStats();
+        device.Stop();
+
+        double mb = static_cast<double>(totals.body_bytes) / (1024.0 * 1024.0);
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  requests        " << totals.completed << " (" << totals.failed << " not 200)\n"
+                  << "  requests/s      " << (wall > 0 ? static_cast<double>(totals.completed) / wall : 0) << "\n"
+                  << "  ttlb p50        " << Percentile(totals.ttlb_ms, 0.50) << " ms\n"
+                  << "  ttlb p99        " << Percentile(totals.ttlb_ms, 0.99) << " ms\n"
+                  << "  retransmits     " << stats.fast_retransmits + stats.rto_retransmits
+                  << " (" << stats.fast_retransmits << " fast, " << stats.rto_retransmits << " RTO; "
+                  << totals.dropped << " segments dropped, " << totals.duplicates << " duplicates)\n"
+                  << "  delivered       " << mb << " MB in " << wall << " s\n"
+                  << "  cpu             " << (mb > 0 ? cpu * 1000.0 / mb : 0) << " ms/MB\n";
+
+        if (!finished) {
+            std::cerr << "Stalled: " << device.Outstanding() << " requests unanswered after "
+                      << kStallTimeout.count() << " s\n";
+            status = 1;
+        }
+    }
+
+    std::error_code ec;
+    fs::remove_all(fixtures.dir, ec);
+    return status;
+}
@@ -0,0 +1,411 @@
+/**
+ * bench_sync.cpp
+ *
+ * End-to-end sync benchmark against the simulated device
+ * (tests/zune_simulated_device.h), no hardware needed. For each model (HD,
+ * Classic) it runs three syncs of a generated host library:
+ *
+ *   initial      empty device, every track uploaded
+ *   incremental  a week of changes: 5% new tracks, 2% re-tagged, 2% removed,
+ *                playlists edited
+ *   no-op        host and device already agree
+ *
+ * Each sync reads the library (ZMDB read, parse, packed library build),
+ * plans it with zune::PlanSync and executes the plan with the operation
+ * sequence the upload API sends: artist and album folders, the album
+ * object and its artwork, CreateTrack + SendObject + verify per track,
+ * album references, tag updates, deletes and playlists. Host time and
+ * simulated device time are reported separately, along with transactions
+ * and bytes; --realtime sleeps the device time instead, for a wall-clock
+ * figure. After every sync the library is read back and re-planned, and a
+ * plan that is not empty fails the run.
+ *
+ * Usage: bench_sync [tracks] [hd|classic] [--realtime]
+ *   tracks   host library size (default 5000)
+ */
+
+#include "tests/zune_simulated_device.h"
+#include "lib/src/ZuneSyncPlanner.h"
+#include "lib/src/ZunePackedLibrary.h"
+#include "lib/src/zmdb/ZuneHDParser.h"
+#include "lib/src/zmdb/ZuneClassicParser.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using zune_sim::Layout;
+using zune_sim::SimulatedDevice;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// ── Host library ────────────────────────────────────────────────────────
+
+struct HostTrack {
+    std::string path, title, artist, album, genre;
+    uint32_t track_number = 0;
+    uint32_t disc_number = 1;
+    uint32_t duration_ms = 0;
+    uint64_t size = 0;
+    uint16_t format = zune_sim::kFormatWma;
+};
+
+struct HostPlaylist {
+    std::string name;
+    std::vector<uint32_t> tracks;  // Host indices
+};
+
+struct HostLibrary {
+    std::vector<HostTrack> tracks;
+    std::vector<HostPlaylist> playlists;
+    uint32_t next_id = 1;
+
+    // Ten tracks an album, two albums an artist, 3-9 MB a track
+    void AddTracks(uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t id = next_id++;
+            uint32_t album = (id - 1) / 10 + 1;
+            HostTrack t;
+            t.artist = zmdb_synthetic::detail::ArtistName((album - 1) / 2 + 1);
+            t.album = zmdb_synthetic::detail::AlbumTitle(album);
+            t.title = "Track " + std::to_string(id);
+            t.genre = "Genre " + std::to_string(album % 30 + 1);
+            t.track_number = (id - 1) % 10 + 1;
+            t.duration_ms = 150000 + (id * 7919) % 150000;
+            t.size = 3000000 + (uint64_t(id) * 104729) % 6000000;
+            t.format = id % 3 == 0 ? zune_sim::kFormatMp3 : zune_sim::kFormatWma;
+            t.path = "/music/" + t.artist + "/" + t.album + "/" + std::to_string(t.track_number) + ".wma";
+            tracks.push_back(std::move(t));
+        }
+    }
+
+    void BuildPlaylists(uint32_t count, uint32_t length) {
+        playlists.clear();
+        for (uint32_t p = 1; p <= count && !tracks.empty(); p++) {
+            HostPlaylist pl;
+            pl.name = "Playlist " + std::to_string(p);
+            for (uint32_t i = 0; i < length; i++) {
+                pl.tracks.push_back((p * 37 + i * 11) % static_cast<uint32_t>(tracks.size()));
+            }
+            playlists.push_back(std::move(pl));
+        }
+    }
+};
+
+// C views of a HostLibrary for PlanSync; valid while the library is unchanged
+struct HostManifest {
+    std::vector<ZuneHostTrack> tracks;
+    std::vector<ZuneHostPlaylist> playlists;
+
+    explicit HostManifest(const HostLibrary& host) {
+        for (const HostTrack& t : host.tracks) {
+            ZuneHostTrack h{};
+            h.file_path = t.path.c_str();
+            h.title = t.title.c_str();
+            h.artist = t.artist.c_str();
+            h.album = t.album.c_str();
+            h.genre = t.genre.c_str();
+            h.track_number = t.track_number;
+            h.disc_number = t.disc_number;
+            h.duration_ms = t.duration_ms;
+            h.file_size = t.size;
+            tracks.push_back(h);
+        }
+        for (const HostPlaylist& p : host.playlists) {
+            ZuneHostPlaylist h{};
+            h.name = p.name.c_str();
+            h.track_indices = p.tracks.data();
+            h.track_count = static_cast<uint32_t>(p.tracks.size());
+            playlists.push_back(h);
+        }
+    }
+};
+
+// ── One sync ────────────────────────────────────────────────────────────
+
+struct Phase {
+    double host_ms = 0;
+    uint64_t device_us = 0;
+};
+
+struct SyncResult {
+    Phase read, plan, execute;
+    uint32_t ops = 0, adds = 0, updates = 0, deletes = 0, playlist_ops = 0;
+    uint64_t transactions = 0;
+    uint64_t bytes_written = 0;
+    uint32_t failures = 0;
+    uint32_t remaining_ops = 0;  // Plan after the sync; 0 when it converged
+};
+
+ZuneMusicLibrary* ReadLibrary(SimulatedDevice& device) {
+    std::vector<uint8_t> blob = device.ReadZmdb();
+    auto alb_to_objectid = device.AlbumObjectIds();
+    zmdb::ZMDBLibrary parsed;
+    if (device.is_hd()) {
+        zmdb::ZuneHDParser parser;
+        parsed = parser.ExtractLibrary(zmdb::ByteView(blob.data(), blob.size()));
+    } else {
+        zmdb::ZuneClassicParser parser;
+        parsed = parser.ExtractLibrary(zmdb::ByteView(blob.data(), blob.size()));
+    }
+    return zune::BuildPackedLibrary(parsed, alb_to_objectid);
+}
+
+zune::TrackProperties ToProperties(const HostTrack& t, bool is_hd) {
+    zune::TrackProperties props;
+    props.filename = t.title + (t.format == zune_sim::kFormatMp3 ? ".mp3" : ".wma");
+    props.title = t.title;
+    props.artist = t.artist;
+    props.album_name = t.album;
+    props.album_artist = t.artist;
+    props.genre = t.genre;
+    props.duration_ms = t.duration_ms;
+    props.track_number = static_cast<uint16_t>(t.track_number);
+    props.disc_number = t.disc_number;
+    props.is_hd = is_hd;
+    return props;
+}
+
+// Run plan ops in order, as the upload API would issue them
+uint32_t ExecutePlan(SimulatedDevice& device, const zune::SyncPlan& plan, const HostLibrary& host) {
+    const bool hd = device.is_hd();
+    const zune::RootDiscoveryResult roots = device.RootFolders();
+    uint32_t failures = 0;
+    auto check = [&](uint16_t response) {
+        if (response != zune_sim::kOk) failures++;
+        return response == zune_sim::kOk;
+    };
+
+    std::vector<uint32_t> handles(host.tracks.size(), 0);  // Host index -> device track
+    for (size_t h = 0; h < handles.size() && h < plan.host_matches.size(); h++) {
+        handles[h] = plan.host_matches[h];
+    }
+
+    std::unordered_map<std::string, uint32_t> artist_folders;
+    uint32_t group = ZUNE_SYNC_NONE;
+    uint32_t album_folder = 0;
+    uint32_t album_object = 0;
+    std::vector<uint32_t> album_tracks;
+    auto finish_album = [&] {
+        if (album_object && !album_tracks.empty()) {
+            check(device.SetObjectReferences(album_object, album_tracks));
+            check(device.GetObjectPropList(album_object));
+        }
+        album_tracks.clear();
+    };
+
+    for (const ZuneSyncOp& op : plan.ops) {
+        if (op.group != group && op.type != ZUNE_SYNC_OP_CREATE_ALBUM) {
+            finish_album();
+        }
+        switch (op.type) {
+        case ZUNE_SYNC_OP_DELETE_TRACK:
+        case ZUNE_SYNC_OP_DELETE_PLAYLIST:
+            check(device.DeleteObject(op.device_atom_id));
+            break;
+        case ZUNE_SYNC_OP_CREATE_ALBUM: {
+            finish_album();
+            group = op.group;
+            const ZuneSyncAlbumGroup& g = plan.groups[op.group];
+            auto folder = artist_folders.find(g.artist);
+            if (folder == artist_folders.end()) {
+                uint32_t handle = 0;
+                check(device.CreateFolder(roots.music_folder, g.artist, handle));
+                folder = artist_folders.emplace(g.artist, handle).first;
+            }
+            check(device.CreateFolder(folder->second, g.album, album_folder));
+            zune::AlbumProperties album;
+            album.artist = g.artist;
+            album.album_name = g.album;
+            album.is_hd = hd;
+            if (check(device.CreateAlbum(roots.albums_folder, album, album_object))) {
+                check(device.SetArtwork(album_object, 48 * 1024));
+            }
+            break;
+        }
+        case ZUNE_SYNC_OP_ADD_TRACK: {
+            if (op.group != group) {
+                // Existing album. A firmware placeholder has no object to
+                // reference; the tracks join it by name.
+                group = op.group;
+                album_object = plan.groups[op.group].device_album_atom_id;
+                if (!device.objects().count(album_object)) album_object = 0;
+                album_folder = roots.music_folder;
+            }
+            const HostTrack& t = host.tracks[op.host_index];
+            uint32_t handle = 0;
+            if (!check(device.CreateTrack(album_folder, ToProperties(t, hd), t.format, t.size, handle))) break;
+            if (!check(device.SendObject(t.size))) break;
+            check(device.GetObjectPropList(handle));
+            handles[op.host_index] = handle;
+            album_tracks.push_back(handle);
+            break;
+        }
+        case ZUNE_SYNC_OP_UPDATE_TRACK:
+            check(device.UpdateTrack(op.device_atom_id, ToProperties(host.tracks[op.host_index], hd)));
+            break;
+        case ZUNE_SYNC_OP_CREATE_PLAYLIST:
+        case ZUNE_SYNC_OP_UPDATE_PLAYLIST: {
+            const HostPlaylist& p = host.playlists[op.host_index];
+            uint32_t playlist = op.device_atom_id;
+            if (op.type == ZUNE_SYNC_OP_CREATE_PLAYLIST &&
+                !check(device.CreatePlaylist(roots.playlists_folder, p.name, playlist))) {
+                break;
+            }
+            std::vector<uint32_t> refs;
+            for (uint32_t h : p.tracks) {
+                if (handles[h]) refs.push_back(handles[h]);
+            }
+            check(device.SetObjectReferences(playlist, refs));
+            break;
+        }
+        }
+    }
+    finish_album();
+    return failures;
+}
+
+template <typename Fn>
+Phase Time(SimulatedDevice& device, Fn&& fn) {
+    uint64_t device_before = device.stats().device_us;
+    auto start = Clock::now();
+    fn();
+    return Phase{MsSince(start), device.stats().device_us - device_before};
+}
+
+SyncResult Sync(SimulatedDevice& device, const HostLibrary& host) {
+    SyncResult r;
+    HostManifest manifest(host);
+    ZuneSyncPlanOptions options = zune::DefaultSyncPlanOptions();
+    options.delete_unmatched_playlists = true;
+    uint64_t transactions_before = device.stats().transactions;
+    uint64_t written_before = device.stats().bytes_written;
+
+    ZuneMusicLibrary* library = nullptr;
+    r.read = Time(device, [&] { library = ReadLibrary(device); });
+    zune::SyncPlan plan;
+    r.plan = Time(device, [&] {
+        plan = zune::PlanSync(*library, manifest.tracks.data(), static_cast<uint32_t>(manifest.tracks.size()),
+                              manifest.playlists.data(), static_cast<uint32_t>(manifest.playlists.size()),
+                              options);
+    });
+    zune::FreePackedLibrary(library);
+    r.execute = Time(device, [&] { r.failures = ExecutePlan(device, plan, host); });
+
+    r.ops = static_cast<uint32_t>(plan.ops.size());
+    r.adds = plan.add_count;
+    r.updates = plan.update_count;
+    r.deletes = plan.delete_count;
+    r.playlist_ops = plan.playlist_op_count;
+    r.transactions = device.stats().transactions - transactions_before;
+    r.bytes_written = device.stats().bytes_written - written_before;
+
+    // Converged: the device now reads back as the host library
+    library = ReadLibrary(device);
+    zune::SyncPlan check = zune::PlanSync(
+        *library, manifest.tracks.data(), static_cast<uint32_t>(manifest.tracks.size()),
+        manifest.playlists.data(), static_cast<uint32_t>(manifest.playlists.size()), options);
+    zune::FreePackedLibrary(library);
+    r.remaining_ops = static_cast<uint32_t>(check.ops.size());
+    return r;
+}
+
+void PrintPhase(const char* name, const Phase& p) {
+    std::cout << "    " << std::left << std::setw(10) << name << std::right
+              << std::setw(10) << p.host_ms << " ms host"
+              << std::setw(12) << p.device_us / 1000000.0 << " s device" << std::endl;
+}
+
+bool Report(const char* name, const SyncResult& r) {
+    double device_s = (r.read.device_us + r.plan.device_us + r.execute.device_us) / 1000000.0;
+    double host_s = (r.read.host_ms + r.plan.host_ms + r.execute.host_ms) / 1000.0;
+    double mb = r.bytes_written / 1048576.0;
+    std::cout << "  " << name << ": " << r.ops << " ops (" << r.adds << " add, " << r.updates << " update, "
+              << r.deletes << " delete, " << r.playlist_ops << " playlist), " << r.transactions
+              << " transactions, " << mb << " MB" << std::endl;
+    PrintPhase("read", r.read);
+    PrintPhase("plan", r.plan);
+    PrintPhase("execute", r.execute);
+    std::cout << "    total     " << std::setw(10) << (host_s + device_s) << " s end to end";
+    if (device_s > 0 && mb > 0) {
+        std::cout << ", " << mb / (host_s + device_s) << " MB/s effective";
+    }
+    std::cout << std::endl;
+
+    bool ok = true;
+    if (r.failures) {
+        std::cerr << "FAIL: " << name << ": " << r.failures << " operations failed" << std::endl;
+        ok = false;
+    }
+    if (r.remaining_ops) {
+        std::cerr << "FAIL: " << name << ": re-plan after sync has " << r.remaining_ops << " ops" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t track_count = 5000;
+    std::string only;
+    bool realtime = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (std::strcmp(argv[i], "hd") == 0 || std::strcmp(argv[i], "classic") == 0) {
+            only = argv[i];
+        } else {
+            track_count = static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10));
+        }
+    }
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Sync benchmark (simulated device)" << std::endl;
+    std::cout << " " << track_count << " host tracks" << (realtime ? ", realtime" : "") << std::endl;
+    std::cout << "======================================" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    bool ok = true;
+    for (Layout layout : {Layout::HD, Layout::Classic}) {
+        bool hd = layout == Layout::HD;
+        if ((only == "hd" && !hd) || (only == "classic" && hd)) {
+            continue;
+        }
+        std::cout << std::endl << (hd ? "HD" : "Classic") << std::endl;
+
+        SimulatedDevice device(layout, zune_sim::Timing::For(layout), 256ULL << 30);
+        device.SetRealtime(realtime);
+        HostLibrary host;
+        host.AddTracks(track_count);
+        host.BuildPlaylists(track_count / 100 + 1, 25);
+        ok &= Report("initial", Sync(device, host));
+
+        // A week of changes
+        uint32_t changed = track_count / 50;
+        for (uint32_t i = 0; i < changed && i < host.tracks.size(); i++) {
+            host.tracks[i * 7 % host.tracks.size()].genre = "Retagged";
+        }
+        for (uint32_t i = 0; i < changed && !host.tracks.empty(); i++) {
+            host.tracks.pop_back();
+        }
+        host.AddTracks(track_count / 20);
+        host.BuildPlaylists(track_count / 100 + 2, 30);
+        ok &= Report("incremental", Sync(device, host));
+
+        ok &= Report("no-op", Sync(device, host));
+    }
+
+    return ok ? 0 : 1;
+}
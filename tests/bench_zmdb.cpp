@@ -0,0 +1,235 @@
+/**
+ * bench_zmdb.cpp
+ *
+ * ZMDB parser benchmark on synthetic libraries (tests/zmdb_synthetic.h), no
+ * device needed. For each layout (HD, Classic) and library size it reports
+ * parse time, peak RSS growth and heap allocations per record for
+ * ZuneHDParser / ZuneClassicParser and the legacy
+ * zmdb_legacy::ZMDBLibraryExtractor, and checks the parsers return every
+ * generated record. The parsers must also stay within kParserAllocBudget
+ * heap allocations per record (tests/allocation_budget.h); either failure
+ * makes the exit status nonzero.
+ *
+ * The legacy extractor's codec-marker scan finds the synthetic tracks, but its
+ * property-map lookups expect the older (ptr, pid) table and resolve no
+ * album metadata, so its numbers measure the scan rather than a full
+ * extraction.
+ *
+ * Usage: bench_zmdb [passes] [max_tracks] [hd|classic]
+ *   passes      timed runs per case, best reported (default 3)
+ *   max_tracks  largest fixture to run: 1000, 10000, 50000, 200000 (default 200000)
+ */
+
+#include "tests/allocation_budget.h"
+#include "tests/zmdb_synthetic.h"
+#include "lib/src/zmdb/ZuneHDParser.h"
+#include "lib/src/zmdb/ZuneClassicParser.h"
+#include "lib/src/ZMDBLibraryExtractor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+using zmdb_synthetic::Layout;
+using zmdb_synthetic::LibraryShape;
+
+// Heap allocations per parsed media record, for ZuneHDParser /
+// ZuneClassicParser with or without deferred details: strings and the
+// record arrays, not per-property temporaries
+constexpr double kParserAllocBudget = 2.0;
+
+// ── Peak RSS ────────────────────────────────────────────────────────────
+// Linux lets us reset the high-water mark per case (clear_refs 5) and read
+// VmHWM back; elsewhere the process-wide ru_maxrss is the best available,
+// so only the growth over the previous peak shows up.
+
+#if defined(__linux__)
+long ReadStatusKb(const char* key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t key_len = std::strlen(key);
+    while (std::getline(status, line)) {
+        if (line.compare(0, key_len, key) == 0) {
+            return std::strtol(line.c_str() + key_len, nullptr, 10);
+        }
+    }
+    return 0;
+}
+#endif
+
+void ResetPeakRss() {
+#if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+long PeakRssKb() {
+#if defined(__linux__)
+    return ReadStatusKb("VmHWM:");
+#elif !defined(_WIN32)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+long CurrentRssKb() {
+#if defined(__linux__)
+    return ReadStatusKb("VmRSS:");
+#else
+    return PeakRssKb();
+#endif
+}
+
+struct Result {
+    double best_ms = 0;
+    uint64_t allocs = 0;
+    uint64_t alloc_bytes = 0;
+    long peak_rss_kb = 0;
+    uint64_t records = 0;
+};
+
+// Time `passes` runs of fn, keeping the fastest; allocations and peak RSS
+// come from the first run. fn returns the number of records it produced.
+template <typename Fn>
+Result Measure(int passes, Fn&& fn) {
+    Result r;
+    for (int p = 0; p < passes; p++) {
+        ResetPeakRss();
+        long rss_before = CurrentRssKb();
+        alloc_budget::Counts before = alloc_budget::ProcessCounts();
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t records = fn();
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        if (p == 0) {
+            alloc_budget::Counts after = alloc_budget::ProcessCounts();
+            r.allocs = after.allocations - before.allocations;
+            r.alloc_bytes = after.bytes - before.bytes;
+            r.peak_rss_kb = std::max(0L, PeakRssKb() - rss_before);
+            r.records = records;
+            r.best_ms = ms;
+        } else {
+            r.best_ms = std::min(r.best_ms, ms);
+        }
+    }
+    return r;
+}
+
+uint64_t MediaRecords(const zmdb::ZMDBLibrary& lib) {
+    return static_cast<uint64_t>(lib.track_count) + lib.video_count + lib.podcast_count +
+           lib.playlist_count;
+}
+
+template <typename Parser>
+uint64_t RunParser(const std::vector<uint8_t>& blob, bool deferred_details = false) {
+    Parser parser;
+    parser.SetDeferredDetails(deferred_details);
+    auto lib = parser.ExtractLibrary(zmdb::ByteView(blob.data(), blob.size()));
+    return MediaRecords(lib);
+}
+
+uint64_t RunLegacy(const mtp::ByteArray& blob, zune::DeviceFamily family) {
+    // The legacy extractor still logs its summaries to stdout; drop them.
+    std::ostringstream sink;
+    std::streambuf* saved = std::cout.rdbuf(sink.rdbuf());
+    zmdb_legacy::ZMDBLibraryExtractor extractor;
+    auto lib = extractor.ExtractLibrary(blob, family);
+    std::cout.rdbuf(saved);
+    return static_cast<uint64_t>(lib.track_count);
+}
+
+void PrintRow(const char* name, const Result& r, uint64_t denominator) {
+    double per_record = denominator ? double(r.allocs) / denominator : 0.0;
+    std::cout << "  " << std::left << std::setw(20) << name << std::right
+              << std::setw(10) << r.best_ms << " ms"
+              << std::setw(12) << per_record << " allocs/rec"
+              << std::setw(10) << (r.alloc_bytes / 1024.0 / 1024.0) << " MB alloc"
+              << std::setw(10) << (r.peak_rss_kb / 1024.0) << " MB rss"
+              << std::setw(10) << r.records << " records" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int passes = argc > 1 ? std::max(1, std::atoi(argv[1])) : 3;
+    uint32_t max_tracks = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 200000;
+    std::string only = argc > 3 ? argv[3] : "";
+
+    const uint32_t sizes[] = {1000, 10000, 50000, 200000};
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " ZMDB parser benchmark (synthetic)" << std::endl;
+    std::cout << " " << passes << " passes, best time reported" << std::endl;
+    std::cout << "======================================" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    bool ok = true;
+    for (Layout layout : {Layout::HD, Layout::Classic}) {
+        bool hd = layout == Layout::HD;
+        if ((only == "hd" && !hd) || (only == "classic" && hd)) {
+            continue;
+        }
+
+        for (uint32_t tracks : sizes) {
+            if (tracks > max_tracks) {
+                continue;
+            }
+
+            LibraryShape shape = LibraryShape::ForTracks(tracks);
+            std::vector<uint8_t> blob = zmdb_synthetic::BuildZmdb(layout, shape);
+            mtp::ByteArray legacy_blob(blob.begin(), blob.end());
+            uint64_t expected = shape.media_records();
+
+            std::cout << std::endl << (hd ? "HD" : "Classic") << ", " << tracks << " tracks ("
+                      << expected << " media records, " << (blob.size() / 1024) << " KB)" << std::endl;
+
+            Result parser = hd
+                ? Measure(passes, [&] { return RunParser<zmdb::ZuneHDParser>(blob); })
+                : Measure(passes, [&] { return RunParser<zmdb::ZuneClassicParser>(blob); });
+            PrintRow(hd ? "ZuneHDParser" : "ZuneClassicParser", parser, expected);
+
+            Result deferred = hd
+                ? Measure(passes, [&] { return RunParser<zmdb::ZuneHDParser>(blob, true); })
+                : Measure(passes, [&] { return RunParser<zmdb::ZuneClassicParser>(blob, true); });
+            PrintRow("deferred details", deferred, expected);
+
+            zune::DeviceFamily family = hd ? zune::DeviceFamily::Pavo : zune::DeviceFamily::Draco;
+            Result legacy = Measure(passes, [&] { return RunLegacy(legacy_blob, family); });
+            PrintRow("legacy extractor", legacy, expected);
+
+            if (parser.records != expected || deferred.records != expected) {
+                std::cerr << "FAIL: parser returned " << parser.records << " of " << expected
+                          << " records" << std::endl;
+                ok = false;
+            }
+            ok = alloc_budget::WithinBudget(hd ? "ZuneHDParser" : "ZuneClassicParser", parser.allocs,
+                                            expected, kParserAllocBudget) && ok;
+            ok = alloc_budget::WithinBudget("deferred details", deferred.allocs, expected,
+                                            kParserAllocBudget) && ok;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
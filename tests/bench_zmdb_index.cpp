@@ -0,0 +1,167 @@
+/**
+ * bench_zmdb_index.cpp
+ *
+ * Micro-benchmark for the ZMDB atom index / reference cache container.
+ * Compares std::map<uint32_t, ...> (the previous index_table_ and resolve_*
+ * caches) against zmdb::AtomMap on a synthetic 50k-track atom population,
+ * replaying the lookup pattern parse_music_track uses: one index lookup per
+ * track record plus album/artist/genre cache lookups.
+ *
+ * Usage: bench_zmdb_index [track_count] [passes]
+ */
+
+#include "lib/src/zmdb/ZMDBAtomMap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TrackRefs {
+    uint32_t track;
+    uint32_t album;
+    uint32_t artist;
+    uint32_t genre;
+};
+
+// A 50k-track Zune 120 library: ~10 tracks per album, ~2 albums per artist,
+// a few dozen genres, plus the Schema 0x05 filename atoms every track has.
+struct Fixture {
+    std::vector<std::pair<uint32_t, uint32_t>> index_entries;  // atom_id -> offset
+    std::vector<TrackRefs> tracks;
+};
+
+Fixture BuildFixture(uint32_t track_count) {
+    Fixture f;
+    uint32_t album_count = track_count / 10 + 1;
+    uint32_t artist_count = album_count / 2 + 1;
+    uint32_t genre_count = 30;
+    uint32_t offset = 0x1000;
+
+    auto add = [&](uint8_t schema, uint32_t count) {
+        for (uint32_t i = 1; i <= count; i++) {
+            f.index_entries.emplace_back((uint32_t(schema) << 24) | i, offset);
+            offset += 64;
+        }
+    };
+    add(0x01, track_count);
+    add(0x05, track_count);
+    add(0x06, album_count);
+    add(0x08, artist_count);
+    add(0x09, genre_count);
+
+    // Descriptor 0 is sorted by atom_id on device; shuffle the track order so
+    // lookups interleave schemas the way a real parse does.
+    std::mt19937 rng(1234);
+    for (uint32_t i = 1; i <= track_count; i++) {
+        uint32_t album = (i - 1) / 10 + 1;
+        f.tracks.push_back({0x01000000 | i, 0x06000000 | album,
+                            0x08000000 | ((album - 1) / 2 + 1),
+                            0x09000000 | static_cast<uint32_t>(rng() % genre_count + 1)});
+    }
+    std::shuffle(f.tracks.begin(), f.tracks.end(), rng);
+    return f;
+}
+
+struct CacheEntry {
+    std::string name;
+    uint32_t atom_id = 0;
+};
+
+template <typename Fn>
+double TimeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+volatile uint64_t g_sink = 0;
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t track_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 50000;
+    int passes = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " ZMDB index/cache lookup benchmark" << std::endl;
+    std::cout << " " << track_count << " tracks, " << passes << " passes" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    Fixture f = BuildFixture(track_count);
+
+    // ── Build ───────────────────────────────────────────────────────────
+    std::map<uint32_t, uint32_t> map_index;
+    zmdb::AtomMap<uint32_t> flat_index;
+    double map_build = TimeMs([&] {
+        for (const auto& [atom_id, offset] : f.index_entries) map_index[atom_id] = offset;
+    });
+    double flat_build = TimeMs([&] {
+        for (const auto& [atom_id, offset] : f.index_entries) flat_index[atom_id] = offset;
+    });
+
+    std::map<uint32_t, CacheEntry> map_cache;
+    zmdb::AtomMap<CacheEntry> flat_cache;
+    for (const auto& t : f.tracks) {
+        for (uint32_t ref : {t.album, t.artist, t.genre}) {
+            map_cache[ref] = {"name", ref};
+            flat_cache[ref] = {"name", ref};
+        }
+    }
+
+    // ── Lookup (parse_music_track pattern) ──────────────────────────────
+    double map_lookup = TimeMs([&] {
+        uint64_t sum = 0;
+        for (int p = 0; p < passes; p++) {
+            for (const auto& t : f.tracks) {
+                if (map_index.count(t.track)) sum += map_index[t.track];
+                for (uint32_t ref : {t.album, t.artist, t.genre}) {
+                    auto it = map_cache.find(ref);
+                    if (it != map_cache.end()) sum += it->second.atom_id;
+                }
+            }
+        }
+        g_sink = sum;
+    });
+    uint64_t map_sum = g_sink;
+
+    double flat_lookup = TimeMs([&] {
+        uint64_t sum = 0;
+        for (int p = 0; p < passes; p++) {
+            for (const auto& t : f.tracks) {
+                if (const uint32_t* offset = flat_index.find(t.track)) sum += *offset;
+                for (uint32_t ref : {t.album, t.artist, t.genre}) {
+                    if (const auto* entry = flat_cache.find(ref)) sum += entry->atom_id;
+                }
+            }
+        }
+        g_sink = sum;
+    });
+
+    if (g_sink != map_sum) {
+        std::cerr << "FAIL: lookup results differ between std::map and AtomMap" << std::endl;
+        return 1;
+    }
+
+    double lookups = double(passes) * f.tracks.size() * 4;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Index build (" << f.index_entries.size() << " atoms)" << std::endl;
+    std::cout << "  std::map  " << std::setw(10) << map_build << " ms" << std::endl;
+    std::cout << "  AtomMap   " << std::setw(10) << flat_build << " ms" << std::endl;
+    std::cout << "Lookups (" << static_cast<uint64_t>(lookups) << ")" << std::endl;
+    std::cout << "  std::map  " << std::setw(10) << map_lookup << " ms  "
+              << (map_lookup * 1e6 / lookups) << " ns/lookup" << std::endl;
+    std::cout << "  AtomMap   " << std::setw(10) << flat_lookup << " ms  "
+              << (flat_lookup * 1e6 / lookups) << " ns/lookup" << std::endl;
+    std::cout << "  speedup   " << std::setw(10) << (map_lookup / flat_lookup) << "x" << std::endl;
+
+    return 0;
+}
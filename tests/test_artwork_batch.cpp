@@ -0,0 +1,214 @@
+/**
+ * test_artwork_batch.cpp
+ *
+ * Unit tests for zune::ArtworkBatch
+ * Tests downloads to files and to the sink, cache hits on a second run,
+ * stale and unrelated files of the wrong size, unknown artwork sizes and
+ * stopping from the sink
+ */
+
+#include "lib/src/ZuneArtworkBatch.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+using zune::ArtworkBatch;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_artwork_batch";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+// Artwork per handle, as RepresentativeSampleData would return it
+struct FakeDevice {
+    std::map<uint32_t, std::vector<uint8_t>> artwork;
+    bool reports_size = true;   // Answers RepresentativeSampleSize
+    int size_queries = 0;
+    int fetches = 0;
+
+    ArtworkBatch::Source Source() {
+        ArtworkBatch::Source source;
+        source.size = [this](uint32_t handle) -> uint64_t {
+            size_queries++;
+            auto it = artwork.find(handle);
+            return reports_size && it != artwork.end() ? it->second.size() : 0;
+        };
+        source.fetch = [this](uint32_t handle, std::vector<uint8_t>& data) {
+            fetches++;
+            auto it = artwork.find(handle);
+            if (it == artwork.end()) return false;
+            data = it->second;
+            return true;
+        };
+        return source;
+    }
+};
+
+static std::vector<uint8_t> Bytes(size_t size, uint8_t seed) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = static_cast<uint8_t>(seed + i * 7);
+    return data;
+}
+
+static std::vector<uint8_t> ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+bool TestDownloadThenCacheHit() {
+    std::cout << "Testing downloads and a cached second run..." << std::endl;
+    std::string dir = TempDir();
+    FakeDevice device;
+    device.artwork[0x101] = Bytes(3000, 1);
+    device.artwork[0x102] = Bytes(4500, 2);
+    std::vector<uint32_t> handles = {0x101, 0x102};
+    std::vector<std::string> paths = {dir + "/a.jpg", dir + "/b.jpg"};
+
+    std::vector<int> results;
+    ASSERT_EQ(ArtworkBatch::Run(device.Source(), handles, paths, nullptr, &results), 0, "First run completes");
+    ASSERT_TRUE(results == std::vector<int>({ArtworkBatch::Downloaded, ArtworkBatch::Downloaded}), "Both downloaded");
+    ASSERT_EQ(device.fetches, 2, "Both fetched");
+    ASSERT_TRUE(ReadFile(paths[0]) == device.artwork[0x101], "First file holds the artwork");
+    ASSERT_TRUE(ReadFile(paths[1]) == device.artwork[0x102], "Second file holds the artwork");
+
+    // The files just written are exactly the artwork, so nothing is fetched again
+    ASSERT_EQ(ArtworkBatch::Run(device.Source(), handles, paths, nullptr, &results), 0, "Second run completes");
+    ASSERT_TRUE(results == std::vector<int>({ArtworkBatch::Cached, ArtworkBatch::Cached}), "Both cached");
+    ASSERT_EQ(device.fetches, 2, "No fetch on the second run");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestWrongSizeRefetched() {
+    std::cout << "Testing stale and unrelated files..." << std::endl;
+    std::string dir = TempDir();
+    FakeDevice device;
+    device.artwork[0x201] = Bytes(2048, 3);
+    device.artwork[0x202] = Bytes(1024, 4);
+    std::vector<uint32_t> handles = {0x201, 0x202};
+    std::vector<std::string> paths = {dir + "/stale.jpg", dir + "/other.jpg"};
+    // Artwork that changed size on the device, and a file whose size is
+    // some other object's (a track's, say) rather than this artwork's
+    WriteFile(paths[0], Bytes(2000, 9));
+    WriteFile(paths[1], Bytes(3072, 9));
+
+    std::vector<int> results;
+    ASSERT_EQ(ArtworkBatch::Run(device.Source(), handles, paths, nullptr, &results), 0, "Run completes");
+    ASSERT_TRUE(results == std::vector<int>({ArtworkBatch::Downloaded, ArtworkBatch::Downloaded}), "Both refetched");
+    ASSERT_TRUE(ReadFile(paths[0]) == device.artwork[0x201], "Stale file replaced");
+    ASSERT_TRUE(ReadFile(paths[1]) == device.artwork[0x202], "Unrelated file replaced");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestUnknownSizeFetches() {
+    std::cout << "Testing artwork without a reported size..." << std::endl;
+    std::string dir = TempDir();
+    FakeDevice device;
+    device.reports_size = false;
+    device.artwork[0x301] = Bytes(700, 5);
+    std::vector<uint32_t> handles = {0x301, 0x302};
+    std::vector<std::string> paths = {dir + "/c.jpg", dir + "/missing.jpg"};
+    WriteFile(paths[0], device.artwork[0x301]);
+
+    std::vector<int> results;
+    ASSERT_EQ(ArtworkBatch::Run(device.Source(), handles, paths, nullptr, &results), 0, "Run completes");
+    ASSERT_TRUE(results == std::vector<int>({ArtworkBatch::Downloaded, ArtworkBatch::Failed}),
+                "Fetched without a size; no artwork fails");
+    ASSERT_EQ(device.fetches, 2, "Both fetched");
+    ASSERT_TRUE(!std::filesystem::exists(paths[1]), "Nothing written for a failure");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestSinkAndStop() {
+    std::cout << "Testing the sink and stopping..." << std::endl;
+    FakeDevice device;
+    device.artwork[0x401] = Bytes(100, 6);
+    device.artwork[0x402] = Bytes(200, 7);
+    device.artwork[0x403] = Bytes(300, 8);
+    std::vector<uint32_t> handles = {0x401, 0x402, 0x403};
+
+    std::vector<size_t> sizes;
+    auto sink = [&](size_t index, const uint8_t* data, size_t size) {
+        if (std::vector<uint8_t>(data, data + size) != device.artwork[handles[index]]) return false;
+        sizes.push_back(size);
+        return index < 1;
+    };
+    std::vector<int> results;
+    ASSERT_EQ(ArtworkBatch::Run(device.Source(), handles, {}, sink, &results), -2, "Sink stops");
+    ASSERT_TRUE(sizes == std::vector<size_t>({100, 200}), "Sink saw the first two");
+    ASSERT_TRUE(results == std::vector<int>({ArtworkBatch::Downloaded, ArtworkBatch::Downloaded, ArtworkBatch::Failed}),
+                "Item after the stop not reached");
+    ASSERT_EQ(device.size_queries, 0, "No size query without a file");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Artwork Batch Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestDownloadThenCacheHit, "Download Then Cache Hit");
+    run_test(TestWrongSizeRefetched, "Wrong Size Refetched");
+    run_test(TestUnknownSizeFetches, "Unknown Size Fetches");
+    run_test(TestSinkAndStop, "Sink And Stop");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_artwork_batch");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
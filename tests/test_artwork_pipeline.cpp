@@ -0,0 +1,251 @@
+/**
+ * test_artwork_pipeline.cpp
+ *
+ * Unit tests for the host-side artwork stage
+ * Tests JPEG header parsing, dedup, resize gating, the disk cache,
+ * batch preparation and repeated sends
+ */
+
+#include "lib/src/ZuneArtworkPipeline.h"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::ArtworkPipeline;
+using zune::DeviceFamily;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_artwork_pipeline";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+// Minimal JPEG: SOI, APP0, SOF0 with the given size, then `padding` bytes of scan data
+static std::vector<uint8_t> FakeJpeg(uint16_t width, uint16_t height, size_t padding, uint8_t fill = 0x11) {
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8,
+        0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0,
+        0xFF, 0xC0, 0x00, 0x11, 0x08,
+        static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+        static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+        0x03, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+    jpeg.insert(jpeg.end(), padding, fill);
+    jpeg.push_back(0xFF);
+    jpeg.push_back(0xD9);
+    return jpeg;
+}
+
+// Resizer that "encodes" a 64-byte thumbnail and counts its calls
+struct FakeResizer {
+    std::shared_ptr<std::atomic<int>> calls = std::make_shared<std::atomic<int>>(0);
+
+    ArtworkPipeline::Resizer Get() const {
+        auto counter = calls;
+        return [counter](const uint8_t*, size_t, uint32_t max_dimension, uint8_t* out, size_t capacity) -> size_t {
+            (*counter)++;
+            auto thumb = FakeJpeg(static_cast<uint16_t>(max_dimension), static_cast<uint16_t>(max_dimension), 16);
+            if (thumb.size() > capacity) return 0;
+            std::memcpy(out, thumb.data(), thumb.size());
+            return thumb.size();
+        };
+    }
+};
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestJpegDimensions() {
+    std::cout << "Testing JPEG header parsing..." << std::endl;
+    auto jpeg = FakeJpeg(1000, 800, 32);
+    uint32_t w = 0, h = 0;
+    ASSERT_TRUE(ArtworkPipeline::JpegDimensions(jpeg.data(), jpeg.size(), w, h), "SOF0 found");
+    ASSERT_EQ(w, 1000u, "Width");
+    ASSERT_EQ(h, 800u, "Height");
+
+    jpeg[20 + 1] = 0xC2;    // Progressive
+    ASSERT_TRUE(ArtworkPipeline::JpegDimensions(jpeg.data(), jpeg.size(), w, h), "SOF2 found");
+
+    const uint8_t png[] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    ASSERT_FALSE(ArtworkPipeline::JpegDimensions(png, sizeof(png), w, h), "Not a JPEG");
+    ASSERT_FALSE(ArtworkPipeline::JpegDimensions(jpeg.data(), 24, w, h), "Truncated header");
+
+    ASSERT_EQ(ArtworkPipeline::DefaultMaxDimension(DeviceFamily::Pavo), 272u, "HD screen");
+    ASSERT_EQ(ArtworkPipeline::DefaultMaxDimension(DeviceFamily::Draco), 240u, "Classic screen");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDedupAndResize() {
+    std::cout << "Testing dedup and resize gating..." << std::endl;
+    FakeResizer resizer;
+    ArtworkPipeline pipeline;
+    ArtworkPipeline::Options options;
+    options.resize = resizer.Get();
+    pipeline.Configure(options, DeviceFamily::Pavo);
+
+    auto big = FakeJpeg(1200, 1200, 4096);
+    auto cover = pipeline.Prepare(big.data(), big.size());
+    ASSERT_TRUE(cover.data != nullptr, "Large cover resized");
+    uint32_t w = 0, h = 0;
+    ArtworkPipeline::JpegDimensions(cover.data->data(), cover.data->size(), w, h);
+    ASSERT_EQ(w, 272u, "Resized to the HD screen");
+
+    // The same bytes again (compilation): no second resize
+    auto copy = big;
+    auto again = pipeline.Prepare(copy.data(), copy.size());
+    ASSERT_EQ(again.key, cover.key, "Same key");
+    ASSERT_TRUE(again.data == cover.data, "Shared result");
+    ASSERT_EQ(resizer.calls->load(), 1, "Resized once");
+
+    // Already small: sent as is, callback not called
+    auto small = FakeJpeg(200, 200, 512);
+    ASSERT_TRUE(pipeline.Prepare(small.data(), small.size()).data == nullptr, "Small cover unchanged");
+    ASSERT_EQ(resizer.calls->load(), 1, "No resize for a small cover");
+
+    auto stats = pipeline.GetStats();
+    ASSERT_EQ(stats.images, uint64_t(3), "Three images seen");
+    ASSERT_EQ(stats.duplicates, uint64_t(1), "One duplicate");
+    ASSERT_EQ(stats.resized, uint64_t(1), "One resized");
+    ASSERT_EQ(stats.bytes_in, uint64_t(big.size() + small.size()), "Distinct input bytes");
+    ASSERT_EQ(stats.bytes_out, uint64_t(cover.data->size() + small.size()), "Distinct output bytes");
+
+    // Without a resizer the stage only dedups
+    ArtworkPipeline dedup_only;
+    dedup_only.Configure(ArtworkPipeline::Options{}, DeviceFamily::Pavo);
+    ASSERT_TRUE(dedup_only.Prepare(big.data(), big.size()).data == nullptr, "No resizer: original");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDiskCache() {
+    std::cout << "Testing the resized image disk cache..." << std::endl;
+    std::string dir = TempDir();
+    FakeResizer resizer;
+    ArtworkPipeline::Options options;
+    options.resize = resizer.Get();
+    options.cache_dir = dir;
+    auto big = FakeJpeg(1500, 1500, 8192);
+
+    ArtworkPipeline first;
+    first.Configure(options, DeviceFamily::Keel);
+    auto a = first.Prepare(big.data(), big.size());
+    ASSERT_TRUE(a.data != nullptr, "Resized");
+    ASSERT_EQ(resizer.calls->load(), 1, "First session resizes");
+
+    // Next session: same image comes from disk
+    ArtworkPipeline second;
+    second.Configure(options, DeviceFamily::Keel);
+    auto b = second.Prepare(big.data(), big.size());
+    ASSERT_TRUE(b.data != nullptr && *b.data == *a.data, "Cached bytes match");
+    ASSERT_EQ(resizer.calls->load(), 1, "No second resize");
+    ASSERT_EQ(second.GetStats().disk_hits, uint64_t(1), "Disk hit counted");
+
+    // A different target size is a different cache entry
+    options.max_dimension = 120;
+    ArtworkPipeline third;
+    third.Configure(options, DeviceFamily::Keel);
+    third.Prepare(big.data(), big.size());
+    ASSERT_EQ(resizer.calls->load(), 2, "New dimension resizes");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestBatchAndSends() {
+    std::cout << "Testing batch preparation and repeated sends..." << std::endl;
+    FakeResizer resizer;
+    ArtworkPipeline pipeline;
+    ArtworkPipeline::Options options;
+    options.resize = resizer.Get();
+    options.worker_threads = 4;
+    pipeline.Configure(options, DeviceFamily::Pavo);
+
+    // 40 albums sharing 8 covers
+    std::vector<std::vector<uint8_t>> covers;
+    for (int i = 0; i < 8; i++) covers.push_back(FakeJpeg(1000, 1000, 2048, static_cast<uint8_t>(i)));
+    std::vector<std::pair<const uint8_t*, size_t>> batch;
+    for (int i = 0; i < 40; i++) batch.emplace_back(covers[i % 8].data(), covers[i % 8].size());
+    pipeline.PrepareBatch(batch);
+    ASSERT_EQ(resizer.calls->load(), 8, "Each distinct cover resized once");
+
+    auto stats = pipeline.GetStats();
+    ASSERT_EQ(stats.images, uint64_t(40), "Every entry seen");
+    ASSERT_EQ(stats.duplicates, uint64_t(32), "Repeats counted");
+
+    // Album creation afterwards: only cache hits
+    auto prepared = pipeline.Prepare(covers[3].data(), covers[3].size());
+    ASSERT_TRUE(prepared.data != nullptr, "Prepared during the batch");
+    ASSERT_EQ(resizer.calls->load(), 8, "No further resizing");
+
+    ASSERT_TRUE(pipeline.ShouldSend(0x0601, prepared.key), "First send");
+    ASSERT_FALSE(pipeline.ShouldSend(0x0601, prepared.key), "Same image to the same album skipped");
+    ASSERT_TRUE(pipeline.ShouldSend(0x0602, prepared.key), "Another album still gets it");
+    pipeline.ForgetSend(0x0601);
+    ASSERT_TRUE(pipeline.ShouldSend(0x0601, prepared.key), "Resent after a failed send");
+    ASSERT_EQ(pipeline.GetStats().sends_skipped, uint64_t(1), "One send skipped");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Artwork Pipeline Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestJpegDimensions, "JPEG Dimensions");
+    run_test(TestDedupAndResize, "Dedup / Resize");
+    run_test(TestDiskCache, "Disk Cache");
+    run_test(TestBatchAndSends, "Batch / Sends");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_artwork_pipeline");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
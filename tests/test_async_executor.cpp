@@ -0,0 +1,284 @@
+/**
+ * test_async_executor.cpp
+ *
+ * Unit tests for zune::AsyncExecutor
+ * Tests submission order, cancelling queued and running work, failures,
+ * progress, WaitIdle, callbacks that call back in, and teardown
+ */
+
+#include "lib/src/ZuneAsyncExecutor.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using zune::AsyncExecutor;
+using Status = AsyncExecutor::Status;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+// Completions in the order they arrived
+struct Completions {
+    std::mutex mutex;
+    std::vector<uint64_t> ids;
+    std::vector<Status> statuses;
+    std::vector<int> results;
+
+    AsyncExecutor::CompleteFn Fn() {
+        return [this](uint64_t id, Status status, int result, void*) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.push_back(id);
+            statuses.push_back(status);
+            results.push_back(result);
+        };
+    }
+};
+
+// Holds the worker until released
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool entered = false;
+    bool open = false;
+
+    int Hold() {
+        std::unique_lock<std::mutex> lock(mutex);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [this] { return open; });
+        return 0;
+    }
+    void WaitEntered() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return entered; });
+    }
+    void Open() {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        cv.notify_all();
+    }
+};
+
+bool TestOrderAndResults() {
+    std::cout << "Testing submission order and results..." << std::endl;
+    AsyncExecutor executor;
+    Completions done;
+
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 5; i++) {
+        ids.push_back(executor.Submit([i](AsyncExecutor::Context&) { return i * 10; }, nullptr, done.Fn()));
+    }
+    executor.WaitIdle();
+
+    ASSERT_EQ(done.ids.size(), size_t(5), "Every operation completed");
+    ASSERT_TRUE(ids[0] != 0, "Ids are never 0");
+    for (size_t i = 0; i < 5; i++) {
+        ASSERT_EQ(done.ids[i], ids[i], "Completed in submission order");
+        ASSERT_TRUE(done.statuses[i] == Status::Done, "Status Done");
+        ASSERT_EQ(done.results[i], static_cast<int>(i * 10), "Result passed through");
+    }
+    ASSERT_EQ(executor.Pending(), size_t(0), "Nothing pending");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestCancelQueued() {
+    std::cout << "Testing cancelling queued work..." << std::endl;
+    AsyncExecutor executor;
+    Completions done;
+    Gate gate;
+    std::atomic<bool> ran{false};
+
+    uint64_t first = executor.Submit([&](AsyncExecutor::Context&) { return gate.Hold(); }, nullptr, done.Fn());
+    gate.WaitEntered();
+    uint64_t second = executor.Submit([&](AsyncExecutor::Context&) { ran = true; return 0; }, nullptr, done.Fn());
+    ASSERT_EQ(executor.Pending(), size_t(2), "One running, one queued");
+    ASSERT_TRUE(executor.Cancel(second), "Queued operation found");
+    gate.Open();
+    executor.WaitIdle();
+
+    ASSERT_FALSE(ran.load(), "Cancelled work never ran");
+    ASSERT_EQ(done.ids.size(), size_t(2), "Both completed");
+    ASSERT_EQ(done.ids[0], first, "First completes first");
+    ASSERT_TRUE(done.statuses[1] == Status::Cancelled, "Second cancelled");
+    ASSERT_EQ(done.results[1], -1, "Cancelled result");
+    ASSERT_FALSE(executor.Cancel(second), "Completed operation is unknown");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestCancelRunning() {
+    std::cout << "Testing cancelling running work..." << std::endl;
+    AsyncExecutor executor;
+    Completions done;
+    std::atomic<bool> started{false};
+
+    uint64_t id = executor.Submit([&](AsyncExecutor::Context& context) {
+        started = true;
+        while (!context.Cancelled()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return context.Stopped();
+    }, nullptr, done.Fn());
+    while (!started) std::this_thread::yield();
+    ASSERT_TRUE(executor.Cancel(id), "Running operation found");
+    executor.WaitIdle();
+    ASSERT_TRUE(done.statuses[0] == Status::Cancelled, "Stopped work reports cancelled");
+
+    // Work that ignores the request finishes normally
+    Gate gate;
+    id = executor.Submit([&](AsyncExecutor::Context&) { gate.Hold(); return 7; }, nullptr, done.Fn());
+    gate.WaitEntered();
+    executor.Cancel(id);
+    gate.Open();
+    executor.WaitIdle();
+    ASSERT_TRUE(done.statuses[1] == Status::Done, "Uninterruptible work completes");
+    ASSERT_EQ(done.results[1], 7, "With its result");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFailureProgressAndData() {
+    std::cout << "Testing failures, progress and data..." << std::endl;
+    AsyncExecutor executor;
+    Completions done;
+
+    executor.Submit([](AsyncExecutor::Context&) -> int { throw std::runtime_error("device gone"); },
+                    nullptr, done.Fn());
+
+    std::vector<uint64_t> reported;
+    static int payload = 42;
+    void* data_seen = nullptr;
+    executor.Submit([](AsyncExecutor::Context& context) {
+        for (uint64_t i = 1; i <= 3; i++) context.Progress(i, 3);
+        context.SetData(&payload);
+        return 0;
+    }, [&](uint64_t, uint64_t done_bytes, uint64_t total) {
+        if (total == 3) reported.push_back(done_bytes);
+    }, [&](uint64_t, Status, int, void* data) { data_seen = data; });
+    executor.WaitIdle();
+
+    ASSERT_TRUE(done.statuses[0] == Status::Failed, "Exception reports failed");
+    ASSERT_EQ(reported.size(), size_t(3), "Progress delivered");
+    ASSERT_EQ(reported.back(), uint64_t(3), "Last progress");
+    ASSERT_TRUE(data_seen == &payload, "Data handed to completion");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestReentrantCallbacks() {
+    std::cout << "Testing callbacks that call back in..." << std::endl;
+    AsyncExecutor executor;
+    Completions done;
+    std::atomic<int> chained{0};
+
+    executor.Submit([](AsyncExecutor::Context&) { return 1; }, nullptr,
+        [&](uint64_t, Status, int, void*) {
+            executor.WaitIdle();  // Must not deadlock on the worker
+            executor.Submit([&](AsyncExecutor::Context&) { chained = 2; return 0; }, nullptr, done.Fn());
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    executor.WaitIdle();
+    ASSERT_EQ(chained.load(), 2, "Work submitted from a callback runs");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestTeardown() {
+    std::cout << "Testing teardown..." << std::endl;
+    Completions done;
+    Gate gate;
+    std::thread opener;
+    {
+        AsyncExecutor executor;
+        executor.Submit([&](AsyncExecutor::Context&) { return gate.Hold(); }, nullptr, done.Fn());
+        gate.WaitEntered();
+        for (int i = 0; i < 3; i++) {
+            executor.Submit([](AsyncExecutor::Context&) { return 0; }, nullptr, done.Fn());
+        }
+        // Released only once the destructor is waiting
+        opener = std::thread([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            gate.Open();
+        });
+    }
+    opener.join();
+    ASSERT_EQ(done.ids.size(), size_t(4), "Every operation completed before destruction");
+    ASSERT_TRUE(done.statuses[0] == Status::Done, "Running operation finished");
+    for (size_t i = 1; i < 4; i++) {
+        ASSERT_TRUE(done.statuses[i] == Status::Cancelled, "Queued operations cancelled");
+    }
+
+    AsyncExecutor unused;  // Never started: nothing to join
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Async Executor Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestOrderAndResults, "Order / Results");
+    run_test(TestCancelQueued, "Cancel Queued");
+    run_test(TestCancelRunning, "Cancel Running");
+    run_test(TestFailureProgressAndData, "Failure / Progress / Data");
+    run_test(TestReentrantCallbacks, "Reentrant Callbacks");
+    run_test(TestTeardown, "Teardown");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
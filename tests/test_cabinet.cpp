@@ -0,0 +1,378 @@
+/**
+ * test_cabinet.cpp
+ *
+ * Unit tests for the in-memory cabinet reader
+ * Tests stored and MSZIP folders, checksums, malformed input and the
+ * prefetcher
+ */
+
+#include "lib/src/ZuneCabinet.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::Cabinet;
+using zune::CabinetPrefetcher;
+
+namespace {
+
+struct Block {
+    std::vector<uint8_t> payload;
+    uint16_t uncompressed = 0;
+};
+
+void Put16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void Put32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+uint32_t Checksum(const uint8_t* data, size_t size, uint32_t sum) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        sum ^= data[i] | (data[i + 1] << 8) | (data[i + 2] << 16) | (static_cast<uint32_t>(data[i + 3]) << 24);
+    }
+    uint32_t tail = 0;
+    for (; i < size; i++) tail = (tail << 8) | data[i];
+    return sum ^ tail;
+}
+
+// One folder holding every file back to back, split into the given blocks.
+// With reserve set, the header carries a reserve area and each CFFOLDER
+// and CFDATA reserved bytes, which the reader has to step over.
+std::vector<uint8_t> BuildCabinet(const std::vector<std::pair<std::string, std::string>>& files,
+                                  const std::vector<Block>& blocks, uint16_t compression,
+                                  bool reserve = false) {
+    const uint8_t folder_reserve = reserve ? 3 : 0;
+    const uint8_t data_reserve = reserve ? 2 : 0;
+    std::vector<uint8_t> header_reserve;
+    if (reserve) {
+        Put16(header_reserve, 2);
+        header_reserve.push_back(folder_reserve);
+        header_reserve.push_back(data_reserve);
+        header_reserve.push_back(0xAA);
+        header_reserve.push_back(0xBB);
+    }
+
+    std::vector<uint8_t> file_table;
+    uint32_t offset = 0;
+    for (const auto& [name, content] : files) {
+        Put32(file_table, static_cast<uint32_t>(content.size()));
+        Put32(file_table, offset);
+        Put16(file_table, 0);       // Folder
+        Put16(file_table, 0);       // Date
+        Put16(file_table, 0);       // Time
+        Put16(file_table, 0x20);    // Archive
+        file_table.insert(file_table.end(), name.begin(), name.end());
+        file_table.push_back(0);
+        offset += static_cast<uint32_t>(content.size());
+    }
+
+    uint32_t folders_at = 36 + static_cast<uint32_t>(header_reserve.size());
+    uint32_t files_at = folders_at + 8 + folder_reserve;
+    uint32_t data_at = files_at + static_cast<uint32_t>(file_table.size());
+
+    std::vector<uint8_t> data;
+    for (const auto& block : blocks) {
+        std::vector<uint8_t> sizes;
+        Put16(sizes, static_cast<uint16_t>(block.payload.size()));
+        Put16(sizes, block.uncompressed);
+        Put32(data, Checksum(sizes.data(), 4, Checksum(block.payload.data(), block.payload.size(), 0)));
+        data.insert(data.end(), sizes.begin(), sizes.end());
+        data.insert(data.end(), data_reserve, 0xEE);
+        data.insert(data.end(), block.payload.begin(), block.payload.end());
+    }
+
+    std::vector<uint8_t> cab = {'M', 'S', 'C', 'F'};
+    Put32(cab, 0);
+    Put32(cab, data_at + static_cast<uint32_t>(data.size()));
+    Put32(cab, 0);
+    Put32(cab, files_at);
+    Put32(cab, 0);
+    cab.push_back(3);   // Version 1.3
+    cab.push_back(1);
+    Put16(cab, 1);      // Folders
+    Put16(cab, static_cast<uint16_t>(files.size()));
+    Put16(cab, reserve ? 0x0004 : 0);
+    Put16(cab, 0x1234); // Set id
+    Put16(cab, 0);      // Index in set
+    cab.insert(cab.end(), header_reserve.begin(), header_reserve.end());
+    Put32(cab, data_at);
+    Put16(cab, static_cast<uint16_t>(blocks.size()));
+    Put16(cab, compression);
+    cab.insert(cab.end(), folder_reserve, 0xCC);
+    cab.insert(cab.end(), file_table.begin(), file_table.end());
+    cab.insert(cab.end(), data.begin(), data.end());
+    return cab;
+}
+
+std::vector<uint8_t> Hex(const std::string& hex) {
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    return out;
+}
+
+std::string Text(const std::vector<uint8_t>& data) {
+    return std::string(data.begin(), data.end());
+}
+
+std::string Pangrams() {
+    std::string line = "The quick brown fox jumps over the lazy dog. "
+                       "Pack my box with five dozen liquor jugs! 0123456789";
+    return line + line + line;
+}
+
+// Two MSZIP blocks from zlib (level 9, raw deflate, dynamic Huffman). The
+// second was compressed with the first as its dictionary, so it only
+// decodes with the window carried over.
+std::vector<uint8_t> MszipBlock(const std::string& deflate) {
+    std::vector<uint8_t> payload = {'C', 'K'};
+    auto bytes = Hex(deflate);
+    payload.insert(payload.end(), bytes.begin(), bytes.end());
+    return payload;
+}
+
+const char* kDynamicBlock1 =
+    "d58cc915403014455b791a70cc4317161a0882983e2141aaf7dbb0be433d4a1c46b5331a4df7869e1e4c66dd4f90951a"
+    "17e345b8171d0d3e2ac1defaa261e956d7885e59c9c8c90d8b3a0c696e87d34310467192667951d63fff7f";
+const char* kDynamicBlock2 =
+    "cd90c919403018055b791af0d9972e1c34600909929f1044f5d280bbf3bc7987298b3c4b93380a0378fb682668329b58"
+    "a0d8433dd82906f0435cb8a9859598bba6823f3a649f6601e307343b09fb2a9d7bd30075916edd4e98cde1faebff9fdd5e";
+
+std::string DynamicContent() {
+    std::string first = Pangrams();
+    std::string reversed(first.rbegin(), first.rend());
+    return first + reversed.substr(0, 120) + first.substr(0, 150);
+}
+
+std::vector<uint8_t> DynamicCabinet(const std::vector<std::pair<std::string, std::string>>& files) {
+    return BuildCabinet(files, {{MszipBlock(kDynamicBlock1), 288}, {MszipBlock(kDynamicBlock2), 270}}, 1, true);
+}
+
+std::vector<Block> StoredBlocks(const std::string& content, size_t size) {
+    std::vector<Block> blocks;
+    for (size_t at = 0; at < content.size(); at += size) {
+        std::string piece = content.substr(at, size);
+        blocks.push_back({std::vector<uint8_t>(piece.begin(), piece.end()), static_cast<uint16_t>(piece.size())});
+    }
+    return blocks;
+}
+
+} // namespace
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestStoredFolder() {
+    std::cout << "Testing stored folders..." << std::endl;
+    std::string exe(250, 'x');
+    std::string level = "level data spanning blocks";
+    std::string xcab = "XCabInfo";
+    Cabinet cab;
+    ASSERT_TRUE(cab.Open(BuildCabinet({{"Game.exe", exe}, {"Content\\level1.xnb", level}, {"XCabInfo.resources", xcab}},
+                                      StoredBlocks(exe + level + xcab, 100), 0)),
+                "Opened");
+    ASSERT_EQ(cab.files().size(), size_t(3), "Three files");
+    ASSERT_EQ(cab.files()[1].name, std::string("Content\\level1.xnb"), "Name");
+    ASSERT_EQ(cab.files()[1].size, uint32_t(level.size()), "Size");
+    ASSERT_EQ(cab.Find("xcabinfo.RESOURCES"), 2, "Found ignoring case");
+    ASSERT_EQ(cab.Find("missing"), -1, "Missing file");
+
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(cab.Read(0, out), "Read first");
+    ASSERT_EQ(Text(out), exe, "First spans three blocks");
+    ASSERT_TRUE(cab.Read(1, out), "Read second");
+    ASSERT_EQ(Text(out), level, "Second straddles a block boundary");
+
+    // Going back rewinds the folder
+    ASSERT_TRUE(cab.Read(2, out), "Read last");
+    ASSERT_EQ(Text(out), xcab, "Last");
+    ASSERT_TRUE(cab.Read(1, out), "Read backwards");
+    ASSERT_EQ(Text(out), level, "Same content after rewinding");
+    ASSERT_FALSE(cab.Read(3, out), "No fourth file");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMszipFolder() {
+    std::cout << "Testing MSZIP folders..." << std::endl;
+    std::string content = DynamicContent();
+    ASSERT_EQ(content.size(), size_t(558), "Vector content");
+    std::vector<std::pair<std::string, std::string>> files = {
+        {"Game.exe", content.substr(0, 200)},
+        {"Content\\empty.xnb", ""},
+        {"Content\\level1.xnb", content.substr(200)},
+    };
+    Cabinet cab;
+    ASSERT_TRUE(cab.Open(DynamicCabinet(files)), "Opened with reserve fields");
+
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(cab.Read(2, out), cab.error());
+    ASSERT_EQ(Text(out), files[2].second, "Needs the first block's window");
+    ASSERT_TRUE(cab.Read(1, out), "Read empty");
+    ASSERT_EQ(out.size(), size_t(0), "Empty");
+    ASSERT_TRUE(cab.Read(0, out), "Read first");
+    ASSERT_EQ(Text(out), files[0].second, "First");
+
+    // Deflate stored blocks inside MSZIP
+    std::string small = "stored deflate";
+    std::vector<uint8_t> payload = {'C', 'K', 0x01};
+    Put16(payload, static_cast<uint16_t>(small.size()));
+    Put16(payload, static_cast<uint16_t>(~small.size()));
+    payload.insert(payload.end(), small.begin(), small.end());
+    ASSERT_TRUE(cab.Open(BuildCabinet({{"a.txt", small}}, {{payload, static_cast<uint16_t>(small.size())}}, 1)),
+                "Opened");
+    ASSERT_TRUE(cab.Read(0, out), cab.error());
+    ASSERT_EQ(Text(out), small, "Stored deflate block");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMalformed() {
+    std::cout << "Testing malformed cabinets..." << std::endl;
+    std::vector<std::pair<std::string, std::string>> files = {{"Game.exe", DynamicContent()}};
+    auto good = DynamicCabinet(files);
+    Cabinet cab;
+    std::vector<uint8_t> out;
+
+    // A flipped bit in the second block's compressed data
+    auto corrupt = good;
+    corrupt[corrupt.size() - 20] ^= 0x10;
+    ASSERT_TRUE(cab.Open(corrupt), "Data is not read by Open");
+    ASSERT_FALSE(cab.Read(0, out), "Checksum caught");
+    ASSERT_EQ(cab.error(), std::string("data block checksum mismatch"), "Checksum error");
+    ASSERT_EQ(out.size(), size_t(0), "Nothing half read");
+
+    // Same without a checksum reaches the inflater
+    auto unchecked = BuildCabinet({{"a", "aaaaaaaa"}}, {{{'C', 'K', 0xFF, 0xFF}, 8}}, 1);
+    ASSERT_TRUE(cab.Open(unchecked), "Opened");
+    ASSERT_FALSE(cab.Read(0, out), "Bad deflate");
+    ASSERT_EQ(cab.error(), std::string("corrupt MSZIP block"), "Inflate error");
+
+    auto truncated = good;
+    truncated.resize(truncated.size() - 30);
+    ASSERT_TRUE(cab.Open(truncated), "Tables intact");
+    ASSERT_FALSE(cab.Read(0, out), "Truncated data");
+
+    auto lzx = BuildCabinet(files, {}, 0x1503);
+    ASSERT_FALSE(cab.Open(lzx), "LZX refused");
+    ASSERT_EQ(cab.files().size(), size_t(0), "No files from a refused cabinet");
+
+    auto set = good;
+    set[30] |= 0x02;    // Continued in a next cabinet
+    ASSERT_FALSE(cab.Open(set), "Cabinet sets refused");
+
+    ASSERT_FALSE(cab.Open(std::vector<uint8_t>(good.begin(), good.begin() + 40)), "Truncated tables");
+    ASSERT_FALSE(cab.Open({'P', 'K', 3, 4}), "Not a cabinet");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPrefetcher() {
+    std::cout << "Testing prefetcher..." << std::endl;
+    std::string content = DynamicContent();
+    std::vector<std::pair<std::string, std::string>> files = {
+        {"a", content.substr(0, 100)}, {"b", content.substr(100, 250)}, {"c", content.substr(350)}};
+    Cabinet cab;
+    ASSERT_TRUE(cab.Open(DynamicCabinet(files)), "Opened");
+
+    {
+        // Less than one file of buffer still moves one file at a time
+        CabinetPrefetcher prefetcher(cab, {2, 0, 1}, 10);
+        std::vector<size_t> seen;
+        CabinetPrefetcher::Entry entry;
+        while (prefetcher.Next(entry)) {
+            ASSERT_EQ(Text(entry.data), files[entry.index].second, "Content");
+            seen.push_back(entry.index);
+        }
+        ASSERT_FALSE(prefetcher.failed(), "Not failed");
+        ASSERT_EQ(seen.size(), size_t(3), "Every file");
+        ASSERT_EQ(seen[0], size_t(2), "In the order asked");
+        ASSERT_EQ(seen[2], size_t(1), "In the order asked");
+    }
+
+    {
+        // Abandoned part way
+        CabinetPrefetcher prefetcher(cab, {0, 1, 2}, 1 << 20);
+        CabinetPrefetcher::Entry entry;
+        ASSERT_TRUE(prefetcher.Next(entry), "First");
+    }
+
+    auto corrupt = DynamicCabinet(files);
+    corrupt[corrupt.size() - 20] ^= 0x10;
+    ASSERT_TRUE(cab.Open(corrupt), "Opened");
+    {
+        CabinetPrefetcher prefetcher(cab, {0, 1, 2}, 1 << 20);
+        CabinetPrefetcher::Entry entry;
+        ASSERT_TRUE(prefetcher.Next(entry), "First block is intact");
+        ASSERT_EQ(entry.index, size_t(0), "First");
+        ASSERT_FALSE(prefetcher.Next(entry), "Stops at the corrupt block");
+        ASSERT_TRUE(prefetcher.failed(), "Failed");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Cabinet Reader Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestStoredFolder, "Stored Folder");
+    run_test(TestMszipFolder, "MSZIP Folder");
+    run_test(TestMalformed, "Malformed");
+    run_test(TestPrefetcher, "Prefetcher");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+/**
+ * test_cache_write_queue.cpp
+ *
+ * Unit tests for the cache storage write-behind queue
+ * Tests write order, waiting at the depth and byte limits, Flush, and
+ * draining on destruction
+ */
+
+#include "lib/src/protocols/http/CacheWriteQueue.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+bool TestOrderAndFlush() {
+    std::cout << "Testing write order and flush..." << std::endl;
+    CacheWriteQueue queue;
+    std::mutex mutex;
+    std::vector<int> order;
+
+    for (int i = 0; i < 20; i++) {
+        queue.Push([&, i] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(i);
+        }, 100);
+    }
+    queue.Flush();
+
+    ASSERT_EQ(order.size(), size_t(20), "Every write ran before Flush returned");
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQ(order[i], i, "Writes run in queue order");
+    }
+    CacheWriteQueue::Stats stats = queue.GetStats();
+    ASSERT_EQ(stats.queued, uint64_t(20), "Queued counted");
+    ASSERT_EQ(stats.written, uint64_t(20), "Written counted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDepthLimit() {
+    std::cout << "Testing depth limit..." << std::endl;
+    CacheWriteQueue::Limits limits;
+    limits.max_writes = 2;
+    CacheWriteQueue queue(limits);
+    std::atomic<bool> release{false};
+    std::atomic<int> written{0};
+
+    auto slow_write = [&] {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        written++;
+    };
+    queue.Push(slow_write, 1);
+    queue.Push(slow_write, 1);
+
+    // Third push has to wait for the writer
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.Push(slow_write, 1);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(!pushed, "Push waits at the depth limit");
+
+    release = true;
+    producer.join();
+    queue.Flush();
+    ASSERT_EQ(written.load(), 3, "All writes ran");
+    ASSERT_EQ(queue.GetStats().waits, uint64_t(1), "Wait counted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestByteLimit() {
+    std::cout << "Testing byte limit..." << std::endl;
+    CacheWriteQueue::Limits limits;
+    limits.max_bytes = 1000;
+    CacheWriteQueue queue(limits);
+    std::atomic<bool> release{false};
+
+    auto slow_write = [&] {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    // Larger than the limit on its own: accepted into an empty queue
+    queue.Push(slow_write, 5000);
+    ASSERT_EQ(queue.GetStats().waits, uint64_t(0), "Oversized write into empty queue");
+
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.Push(slow_write, 10);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(!pushed, "Push waits while over the byte limit");
+
+    release = true;
+    producer.join();
+    queue.Flush();
+    CacheWriteQueue::Stats stats = queue.GetStats();
+    ASSERT_EQ(stats.written, uint64_t(2), "Both written");
+    ASSERT_EQ(stats.peak_bytes, uint64_t(5000), "Peak bytes");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDrainOnDestroy() {
+    std::cout << "Testing drain on destruction..." << std::endl;
+    std::atomic<int> written{0};
+    {
+        CacheWriteQueue queue;
+        for (int i = 0; i < 5; i++) {
+            queue.Push([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                written++;
+            }, 1);
+        }
+    }
+    ASSERT_EQ(written.load(), 5, "Queued writes ran before destruction finished");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Cache Write Queue Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestOrderAndFlush, "Order and Flush");
+    run_test(TestDepthLimit, "Depth Limit");
+    run_test(TestByteLimit, "Byte Limit");
+    run_test(TestDrainOnDestroy, "Drain on Destroy");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
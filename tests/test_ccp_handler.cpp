@@ -2,11 +2,15 @@
  * test_ccp_handler.cpp
  *
  * Unit tests for CCPHandler (Phase 5.2)
- * Tests CCP (Compression Control Protocol) negotiation
+ * Tests CCP (Compression Control Protocol) negotiation, and MPPC
+ * compression of outgoing IP frames once it has been agreed
  */
 
 #include "lib/src/protocols/handlers/CCPHandler.h"
+#include "lib/src/protocols/ppp/PPPParser.h"
 #include <iostream>
+#include <string>
+#include <vector>
 
 template<typename T>
 bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
@@ -427,6 +431,195 @@ bool TestCCPLengthFieldValidation() {
     return true;
 }
 
+// MPPC Config-Request from the device with the given supported bits
+static mtp::ByteArray MPPCRequest(uint8_t id, uint32_t bits) {
+    return {0x01, id, 0x00, 0x0A, 0x12, 0x06,
+            uint8_t(bits >> 24), uint8_t(bits >> 16), uint8_t(bits >> 8), uint8_t(bits)};
+}
+
+// CCP packets in a response of one or more PPP frames
+static std::vector<mtp::ByteArray> CCPPackets(const mtp::ByteArray& response) {
+    std::vector<mtp::ByteArray> packets;
+    for (const auto& frame : PPPParser::ExtractFrames(response)) {
+        uint16_t protocol = 0;
+        mtp::ByteArray packet = PPPParser::ExtractPayload(frame, &protocol);
+        if (protocol == 0x80fd) {
+            packets.push_back(packet);
+        }
+    }
+    return packets;
+}
+
+// A PPP frame carrying an IP packet with a text body
+static mtp::ByteArray IPFrame(const std::string& body) {
+    mtp::ByteArray packet = {0x45, 0x00, 0x00, 0x00, 0x12, 0x34, 0x40, 0x00, 0x40, 0x06, 0x00, 0x00,
+                             192, 168, 55, 100, 192, 168, 55, 101};
+    packet.insert(packet.end(), body.begin(), body.end());
+    return PPPParser::WrapPayload(packet, 0x0021);
+}
+
+// Bring handler to compressing: device's MPPC request acked, ours acked
+static bool OpenMPPC(CCPHandler& handler, uint32_t bits) {
+    auto response = handler.HandlePacket(MPPCRequest(0x07, bits));
+    if (!response) return false;
+    auto packets = CCPPackets(*response);
+    if (packets.size() != 2 || packets[0][0] != 0x02 || packets[1][0] != 0x01) return false;
+    mtp::ByteArray ack = packets[1];
+    ack[0] = 0x02;
+    return !handler.HandlePacket(ack).has_value() && handler.IsCompressing();
+}
+
+// Test: MPPC offer is acked, and compression starts once our request is acked
+bool TestMPPCNegotiation() {
+    std::cout << "Testing MPPC negotiation..." << std::endl;
+
+    CCPHandler handler;
+    auto response = handler.HandlePacket(MPPCRequest(0x07, 0x00000001));
+    ASSERT_TRUE(response.has_value(), "Should answer the MPPC offer");
+
+    auto packets = CCPPackets(*response);
+    ASSERT_EQ(packets.size(), size_t(2), "Config-Ack followed by our Config-Request");
+    ASSERT_EQ(packets[0][0], uint8_t(0x02), "Config-Ack");
+    ASSERT_EQ(packets[0][1], uint8_t(0x07), "Ack keeps the identifier");
+    mtp::ByteArray request = MPPCRequest(0x07, 0x00000001);
+    ASSERT_TRUE(mtp::ByteArray(packets[0].begin() + 4, packets[0].end()) ==
+                mtp::ByteArray(request.begin() + 4, request.end()), "Ack echoes the MPPC option");
+    ASSERT_EQ(packets[1][0], uint8_t(0x01), "Our Config-Request");
+    ASSERT_EQ(packets[1].size(), size_t(4), "Asking for nothing compressed");
+    ASSERT_FALSE(handler.IsCompressing(), "Not until our request is acked");
+
+    // An Ack with the wrong identifier does not open CCP
+    mtp::ByteArray stale = {0x02, uint8_t(packets[1][1] + 1), 0x00, 0x04};
+    handler.HandlePacket(stale);
+    ASSERT_FALSE(handler.IsCompressing(), "Stale Ack ignored");
+
+    // A Nak asks again
+    mtp::ByteArray nak = packets[1];
+    nak[0] = 0x03;
+    auto again = handler.HandlePacket(nak);
+    ASSERT_TRUE(again.has_value(), "Config-Request sent again after a Nak");
+    auto retry = CCPPackets(*again);
+    ASSERT_TRUE(retry.size() == 1 && retry[0][0] == 0x01 && retry[0][1] != packets[1][1],
+                "New identifier");
+
+    mtp::ByteArray ack = retry[0];
+    ack[0] = 0x02;
+    ASSERT_FALSE(handler.HandlePacket(ack).has_value(), "No response to the Ack");
+    ASSERT_TRUE(handler.IsCompressing(), "Compressing once both sides acked");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: MPPC with encryption bits is Nak'd, offering compression only
+bool TestMPPCNakForEncryption() {
+    std::cout << "Testing MPPC offer with MPPE bits..." << std::endl;
+
+    CCPHandler handler;
+    auto response = handler.HandlePacket(MPPCRequest(0x03, 0x01000061));
+    ASSERT_TRUE(response.has_value(), "Should answer");
+    auto packets = CCPPackets(*response);
+    ASSERT_EQ(packets.size(), size_t(1), "Nak only, no request of ours yet");
+    ASSERT_EQ(packets[0][0], uint8_t(0x03), "Config-Nak");
+    ASSERT_TRUE(packets[0] == mtp::ByteArray({0x03, 0x03, 0x00, 0x0A, 0x12, 0x06, 0x01, 0x00, 0x00, 0x01}),
+                "Offers MPPC and stateless history only");
+
+    // Rejected alongside an unknown option, only the unknown one goes back
+    mtp::ByteArray mixed = {0x01, 0x04, 0x00, 0x0E, 0x1A, 0x04, 0x00, 0x0F,
+                            0x12, 0x06, 0x00, 0x00, 0x00, 0x01};
+    packets = CCPPackets(*handler.HandlePacket(mixed));
+    ASSERT_TRUE(packets.size() == 1 && packets[0] == mtp::ByteArray({0x04, 0x04, 0x00, 0x08, 0x1A, 0x04, 0x00, 0x0F}),
+                "Only Deflate rejected");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: with compression disabled the MPPC offer is rejected as before
+bool TestCompressionDisabled() {
+    std::cout << "Testing MPPC with compression disabled..." << std::endl;
+
+    CCPHandler handler;
+    handler.SetCompressionEnabled(false);
+    auto response = handler.HandlePacket(MPPCRequest(0x09, 0x00000001));
+    ASSERT_TRUE(response.has_value(), "Should answer");
+    auto packets = CCPPackets(*response);
+    ASSERT_TRUE(packets.size() == 1 && packets[0][0] == 0x04, "Config-Reject only");
+
+    mtp::ByteArray frame = IPFrame("<artist>text</artist>");
+    mtp::ByteArray out;
+    ASSERT_FALSE(handler.CompressFrame(frame.data(), frame.size(), out), "Nothing compressed");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: IP frames are compressed into protocol 0x00FD frames
+bool TestCompressFrame() {
+    std::cout << "Testing frame compression..." << std::endl;
+
+    CCPHandler handler;
+    std::string body;
+    for (int i = 0; i < 20; i++) {
+        body += "<entry><title>Track " + std::to_string(i) + "</title><link href=\"http://catalog.zune.net/\"/></entry>";
+    }
+    mtp::ByteArray frame = IPFrame(body);
+    mtp::ByteArray out;
+    ASSERT_FALSE(handler.CompressFrame(frame.data(), frame.size(), out), "Not before CCP is open");
+
+    ASSERT_TRUE(OpenMPPC(handler, 0x00000001), "MPPC agreed");
+    ASSERT_TRUE(handler.CompressFrame(frame.data(), frame.size(), out), "Compressed");
+    uint16_t protocol = 0;
+    mtp::ByteArray packet = PPPParser::ExtractPayload(out, &protocol);
+    ASSERT_EQ(protocol, uint16_t(0x00fd), "Compressed datagram protocol");
+    ASSERT_TRUE(packet[0] & 0x20, "COMPRESSED bit set");
+    ASSERT_TRUE(out.size() * 2 < frame.size(), "Frame shrinks to under half");
+
+    // CCP frames are sent as they are
+    mtp::ByteArray ccp_frame = PPPParser::WrapPayload(mtp::ByteArray{0x01, 0x01, 0x00, 0x04}, 0x80fd);
+    ASSERT_FALSE(handler.CompressFrame(ccp_frame.data(), ccp_frame.size(), out), "Only IP frames");
+
+    CCPHandler::Stats stats = handler.GetStats();
+    ASSERT_TRUE(stats.compressing, "Compressing");
+    ASSERT_EQ(stats.frames, uint64_t(1), "One frame");
+    ASSERT_TRUE(stats.bytes_out * 2 < stats.bytes_in, "Bytes counted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: Reset-Request flushes the history; Terminate and a new request stop compression
+bool TestResetAndTerminate() {
+    std::cout << "Testing Reset-Request and Terminate-Request..." << std::endl;
+
+    CCPHandler handler;
+    ASSERT_TRUE(OpenMPPC(handler, 0x00000001), "MPPC agreed");
+    mtp::ByteArray frame = IPFrame("<biography>Some text about the artist, some text.</biography>");
+    mtp::ByteArray out;
+    ASSERT_TRUE(handler.CompressFrame(frame.data(), frame.size(), out), "Compressed");
+
+    mtp::ByteArray reset = {0x0E, 0x21, 0x00, 0x04};
+    ASSERT_FALSE(handler.HandlePacket(reset).has_value(), "No Reset-Ack for MPPC");
+    ASSERT_TRUE(handler.CompressFrame(frame.data(), frame.size(), out), "Still compressing");
+    mtp::ByteArray packet = PPPParser::ExtractPayload(out);
+    ASSERT_TRUE(packet[0] & 0x80, "FLUSHED after the reset");
+    ASSERT_EQ(handler.GetStats().resets, uint64_t(1), "Reset counted");
+
+    mtp::ByteArray terminate = {0x05, 0x22, 0x00, 0x04};
+    auto response = handler.HandlePacket(terminate);
+    ASSERT_TRUE(response.has_value(), "Terminate-Ack");
+    auto packets = CCPPackets(*response);
+    ASSERT_TRUE(packets.size() == 1 && packets[0] == mtp::ByteArray({0x06, 0x22, 0x00, 0x04}), "Terminate-Ack");
+    ASSERT_FALSE(handler.IsCompressing(), "Stopped by Terminate-Request");
+
+    ASSERT_TRUE(OpenMPPC(handler, 0x01000001), "Agreed again, stateless");
+    handler.HandlePacket(mtp::ByteArray{0x01, 0x30, 0x00, 0x04});
+    ASSERT_FALSE(handler.IsCompressing(), "Stopped by a new Config-Request");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "======================================" << std::endl;
     std::cout << " CCPHandler Unit Tests" << std::endl;
@@ -463,6 +656,13 @@ int main() {
     run_test(TestCCPMultipleOptions, "CCP Multiple Options");
     run_test(TestCCPLengthFieldValidation, "CCP Length Field Validation");
 
+    // MPPC compression
+    run_test(TestMPPCNegotiation, "MPPC Negotiation");
+    run_test(TestMPPCNakForEncryption, "MPPC Nak for Encryption");
+    run_test(TestCompressionDisabled, "Compression Disabled");
+    run_test(TestCompressFrame, "Compress Frame");
+    run_test(TestResetAndTerminate, "Reset and Terminate");
+
     std::cout << "======================================" << std::endl;
     std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
     std::cout << "======================================" << std::endl;
@@ -0,0 +1,244 @@
+/**
+ * test_content_index.cpp
+ *
+ * Unit tests for the content-identity index
+ * Tests fingerprints, persistence, removal and planning against
+ * renamed or re-tagged copies of tracks already on the device
+ */
+
+#include "lib/src/ZuneContentIndex.h"
+#include "lib/src/ZuneSyncPlanner.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::ContentFingerprint;
+using zune::ContentIndex;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_content_index";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+// Host file of size bytes, each byte derived from seed and its offset
+static std::string WriteSource(const std::string& dir, const std::string& name, size_t size, uint8_t seed) {
+    std::string path = (std::filesystem::path(dir) / name).string();
+    std::vector<char> bytes(size);
+    for (size_t i = 0; i < size; i++) bytes[i] = static_cast<char>(seed + i * 31);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return path;
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestFingerprint() {
+    std::cout << "Testing file fingerprints..." << std::endl;
+    std::string dir = TempDir();
+    std::string a = WriteSource(dir, "a.mp3", 300000, 1);
+    std::string copy = WriteSource(dir, "renamed copy.mp3", 300000, 1);
+    std::string other = WriteSource(dir, "b.mp3", 300000, 2);
+    std::string tiny = WriteSource(dir, "tiny.mp3", 100, 1);
+
+    ContentFingerprint fa, fcopy, fother, ftiny;
+    ASSERT_TRUE(ContentFingerprint::FromFile(a, fa), "File read");
+    ASSERT_TRUE(ContentFingerprint::FromFile(copy, fcopy), "Copy read");
+    ASSERT_TRUE(ContentFingerprint::FromFile(other, fother), "Other read");
+    ASSERT_TRUE(ContentFingerprint::FromFile(tiny, ftiny), "Short file read");
+    ASSERT_FALSE(ContentFingerprint::FromFile(dir + "/missing.mp3", fa), "Missing file");
+
+    ASSERT_EQ(fa.size, uint64_t(300000), "Size");
+    ASSERT_TRUE(fa == fcopy, "Name does not matter");
+    ASSERT_FALSE(fa == fother, "Different content");
+    ASSERT_EQ(ftiny.head, ftiny.tail, "Short file: one block");
+
+    // The in-memory path used on preloaded uploads agrees with the file path
+    std::ifstream file(a, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_TRUE(ContentFingerprint::FromData(data.data(), data.size()) == fa, "Buffer matches file");
+
+    // A middle block change is not seen; an edited tail (e.g. re-tagged ID3v1) is
+    data[150000] ^= 0xFF;
+    ASSERT_TRUE(ContentFingerprint::FromData(data.data(), data.size()) == fa, "Middle not hashed");
+    data[data.size() - 1] ^= 0xFF;
+    ASSERT_FALSE(ContentFingerprint::FromData(data.data(), data.size()) == fa, "Tail hashed");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPersistence() {
+    std::cout << "Testing the index survives a reopen..." << std::endl;
+    std::string dir = TempDir();
+    std::string path = (std::filesystem::path(dir) / ContentIndex::FileName("SER/1")).string();
+    ASSERT_EQ(ContentIndex::FileName("SER/1"), std::string("SER_1.xzcontent"), "Serial sanitized");
+
+    ContentFingerprint f1{1000, 11, 12};
+    ContentFingerprint f2{2000, 21, 22};
+    {
+        ContentIndex index;
+        index.Open(path);
+        ASSERT_TRUE(index.IsOpen(), "Bound");
+        index.Record(f1, 0x01000010);
+        index.Record(f2, 0x01000011);
+        index.Record(ContentFingerprint{3000, 31, 32}, 0);     // Ignored
+        ASSERT_EQ(index.Size(), size_t(2), "Two entries");
+        index.Close();
+    }
+
+    ContentIndex index;
+    index.Open(path);
+    ASSERT_EQ(index.Find(f1), 0x01000010u, "First kept");
+    ASSERT_EQ(index.Find(f2), 0x01000011u, "Second kept");
+    ASSERT_EQ(index.Find(ContentFingerprint{1000, 11, 13}), 0u, "Unknown fingerprint");
+
+    index.Remove(0x01000010);
+    ASSERT_EQ(index.Find(f1), 0u, "Removed");
+    ASSERT_TRUE(index.Save(), "Saved");
+
+    // Truncated file: ignored rather than half loaded
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    ContentIndex damaged;
+    damaged.Open(path);
+    ASSERT_EQ(damaged.Size(), size_t(0), "Damaged file ignored");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestIdentifiedPlan() {
+    std::cout << "Testing planning against fingerprints..." << std::endl;
+    std::string dir = TempDir();
+
+    // Device has two tracks uploaded from the old library
+    ZuneMusicAlbum album{};
+    album.title = "Old Album";
+    album.artist_name = "Artist";
+    album.atom_id = 0x01000001;
+    ZuneMusicTrack dev[2] = {};
+    const char* dev_titles[] = {"Intro", "Outro"};
+    for (int i = 0; i < 2; i++) {
+        dev[i].title = dev_titles[i];
+        dev[i].artist_name = "Artist";
+        dev[i].track_number = i + 1;
+        dev[i].disc_number = 1;
+        dev[i].duration_ms = 60000;
+        dev[i].file_size_bytes = 200000;
+        dev[i].album_ref = album.atom_id;
+        dev[i].atom_id = 0x01000010 + i;
+    }
+    ZuneMusicLibrary library{};
+    library.tracks = dev;
+    library.track_count = 2;
+    library.albums = &album;
+    library.album_count = 1;
+
+    // Restored library: same files under new names and tags, plus one new
+    std::string paths[3] = {
+        WriteSource(dir, "01 intro.mp3", 200000, 1),
+        WriteSource(dir, "02 outro.mp3", 200000, 2),
+        WriteSource(dir, "03 new.mp3", 200000, 3),
+    };
+    const char* titles[] = {"Intro (Remastered)", "Outro", "New"};
+    std::vector<ZuneHostTrack> host(3);
+    for (uint32_t i = 0; i < 3; i++) {
+        host[i].file_path = paths[i].c_str();
+        host[i].title = titles[i];
+        host[i].artist = "Artist";
+        host[i].album = "Old Album (Deluxe)";
+        host[i].track_number = i + 1;
+        host[i].duration_ms = 60000;
+        host[i].file_size = 200000;
+    }
+
+    ContentIndex index;
+    index.Open((std::filesystem::path(dir) / "index.xzcontent").string());
+    for (int i = 0; i < 2; i++) {
+        ContentFingerprint f;
+        ASSERT_TRUE(ContentFingerprint::FromFile(paths[i], f), "Fingerprinted");
+        index.Record(f, dev[i].atom_id);
+    }
+    // Stale entry for an object no longer on the device
+    ContentFingerprint gone;
+    ContentFingerprint::FromFile(paths[2], gone);
+    index.Record(gone, 0x01000099);
+
+    ZuneSyncPlanOptions options = zune::DefaultSyncPlanOptions();
+    zune::SyncPlan plan = zune::PlanSync(library, host.data(), 3, nullptr, 0, options, nullptr, &index);
+    ASSERT_EQ(plan.identified_count, 2u, "Both copies identified");
+    ASSERT_EQ(plan.host_matches[0], 0x01000010u, "Renamed track matched");
+    ASSERT_EQ(plan.host_matches[1], 0x01000011u, "Re-tagged track matched");
+    ASSERT_EQ(plan.host_matches[2], 0u, "Stale entry ignored");
+    ASSERT_EQ(plan.add_count, 1u, "Only the new track uploaded");
+    ASSERT_EQ(plan.delete_count, 0u, "Nothing deleted");
+    ASSERT_EQ(plan.update_count, 2u, "New tags become updates");
+
+    // Without the index every track is uploaded and the old ones deleted
+    zune::SyncPlan plain = zune::PlanSync(library, host.data(), 3, nullptr, 0, options);
+    ASSERT_EQ(plain.add_count, 3u, "All added without the index");
+    ASSERT_EQ(plain.delete_count, 2u, "Old copies deleted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Content Index Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestFingerprint, "Fingerprint");
+    run_test(TestPersistence, "Persistence");
+    run_test(TestIdentifiedPlan, "Identified Plan");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_content_index");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
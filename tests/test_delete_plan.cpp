@@ -0,0 +1,158 @@
+/**
+ * test_delete_plan.cpp
+ *
+ * Unit tests for zune::DeletePlan
+ * Tests file / reference / folder ordering, nested folder depth, missing
+ * and duplicate handles, and collapsing whole folders
+ */
+
+#include "lib/src/ZuneDeletePlan.h"
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using zune::DeletePlan;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+// Music (0x10) / Artist (0x20) / Album (0x30) holding two tracks and a
+// cover, the album's .alb object in Albums (0x11), and a second album
+// folder (0x31) with one track that is not being deleted
+struct Device {
+    std::unordered_map<uint32_t, uint16_t> formats;
+    std::unordered_map<uint32_t, uint32_t> parents;
+
+    void Add(uint32_t handle, uint16_t format, uint32_t parent) {
+        formats[handle] = format;
+        parents[handle] = parent;
+    }
+
+    Device() {
+        Add(0x10, 0x3001, 0);
+        Add(0x11, 0x3001, 0);
+        Add(0x20, 0x3001, 0x10);
+        Add(0x30, 0x3001, 0x20);
+        Add(0x31, 0x3001, 0x20);
+        Add(0x100, 0xB901, 0x30);  // WMA
+        Add(0x101, 0x3009, 0x30);  // MP3
+        Add(0x102, 0x3801, 0x30);  // Cover JPEG
+        Add(0x200, 0xBA03, 0x11);  // .alb
+        Add(0x300, 0x3009, 0x31);
+    }
+};
+
+static std::vector<uint32_t> Handles(const DeletePlan& plan) {
+    std::vector<uint32_t> handles;
+    for (const auto& step : plan.steps) handles.push_back(step.handle);
+    return handles;
+}
+
+bool TestOrder() {
+    std::cout << "Testing files, then references, then folders..." << std::endl;
+    Device device;
+    // Caller's order: folders and the album first, as a UI might list them
+    DeletePlan plan = DeletePlan::Build({0x20, 0x200, 0x30, 0x102, 0x100, 0x101}, device.formats,
+                                        device.parents, false);
+    ASSERT_TRUE(Handles(plan) == std::vector<uint32_t>({0x102, 0x100, 0x101, 0x200, 0x30, 0x20}),
+                "Files in caller order, the album, then the deeper folder first");
+    ASSERT_TRUE(plan.missing.empty(), "All present");
+    ASSERT_EQ(plan.ObjectCount(), size_t(6), "One step per object");
+    for (const auto& step : plan.steps) {
+        ASSERT_TRUE(step.covered.empty(), "Nothing collapsed");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMissingAndDuplicates() {
+    std::cout << "Testing missing and duplicate handles..." << std::endl;
+    Device device;
+    DeletePlan plan = DeletePlan::Build({0x100, 0x999, 0x100, 0x101}, device.formats, device.parents, false);
+    ASSERT_TRUE(Handles(plan) == std::vector<uint32_t>({0x100, 0x101}), "Each object once");
+    ASSERT_TRUE(plan.missing == std::vector<uint32_t>({0x999}), "Already gone");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestCollapse() {
+    std::cout << "Testing whole folders collapsed..." << std::endl;
+    Device device;
+
+    // The album folder and everything in it: one delete
+    DeletePlan plan = DeletePlan::Build({0x100, 0x101, 0x102, 0x30, 0x200}, device.formats,
+                                        device.parents, true);
+    ASSERT_TRUE(Handles(plan) == std::vector<uint32_t>({0x200, 0x30}), "The .alb, then the folder alone");
+    ASSERT_TRUE(plan.steps[1].covered == std::vector<uint32_t>({0x100, 0x101, 0x102}),
+                "Its contents, in plan order for a fallback");
+    ASSERT_EQ(plan.ObjectCount(), size_t(5), "Every object accounted for");
+
+    // The artist folder still holds the second album's track: only the
+    // first album folder is whole
+    plan = DeletePlan::Build({0x20, 0x30, 0x31, 0x100, 0x101, 0x102}, device.formats, device.parents, true);
+    ASSERT_TRUE(Handles(plan) == std::vector<uint32_t>({0x30, 0x31, 0x20}),
+                "Album folders, then the artist, deepest first");
+    ASSERT_EQ(plan.steps[0].covered.size(), size_t(3), "First album collapsed");
+    ASSERT_TRUE(plan.steps[2].covered.empty(), "Artist folder not whole");
+
+    // With that track too, the artist folder takes everything
+    plan = DeletePlan::Build({0x20, 0x30, 0x31, 0x100, 0x101, 0x102, 0x300}, device.formats,
+                             device.parents, true);
+    ASSERT_TRUE(Handles(plan) == std::vector<uint32_t>({0x20}), "One delete for the artist");
+    ASSERT_TRUE(plan.steps[0].covered ==
+                    std::vector<uint32_t>({0x100, 0x101, 0x102, 0x300, 0x30, 0x31}),
+                "Files, then the nested folders");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Delete Plan Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestOrder, "Order");
+    run_test(TestMissingAndDuplicates, "Missing And Duplicates");
+    run_test(TestCollapse, "Collapse");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
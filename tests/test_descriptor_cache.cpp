@@ -0,0 +1,200 @@
+/**
+ * test_descriptor_cache.cpp
+ *
+ * Unit tests for the per-firmware descriptor query cache
+ * Tests skip gating, persistence across sessions, firmware keying and Clear
+ */
+
+#include "lib/src/ZuneDescriptorCache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using zune::DescriptorCache;
+using zune::DeviceFamily;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_descriptor_cache";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestSkipGating() {
+    std::cout << "Testing skip gating..." << std::endl;
+    std::string dir = TempDir();
+
+    DescriptorCache cache;
+    ASSERT_FALSE(cache.ShouldSkip(0xDC47, 0x3009), "Unbound cache never skips");
+
+    cache.Open(dir, DeviceFamily::Draco, "3.3");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC47, 0x3009), "Empty cache does not skip");
+    cache.Record(0xDC47, 0x3009, 400);
+    ASSERT_FALSE(cache.ShouldSkip(0xDC47, 0x3009), "Skipping is off by default");
+
+    cache.SetSkipCached(true);
+    ASSERT_TRUE(cache.ShouldSkip(0xDC47, 0x3009), "Recorded query is skipped");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC47, 0x3001), "Other format is still queried");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC44, 0x3009), "Other property is still queried");
+
+    auto stats = cache.GetStats();
+    ASSERT_EQ(stats.queries_issued, uint64_t(1), "One issued query");
+    ASSERT_EQ(stats.queries_skipped, uint64_t(1), "One skipped query");
+    ASSERT_EQ(stats.query_us, uint64_t(400), "Issued query time");
+    ASSERT_EQ(stats.saved_us, uint64_t(400), "Saved time uses the mean latency");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPersistence() {
+    std::cout << "Testing persistence across sessions..." << std::endl;
+    std::string dir = TempDir();
+
+    {
+        DescriptorCache cache;
+        cache.Open(dir, DeviceFamily::Pavo, "4.5 (Build 407)");
+        cache.Record(0xDC44, 0xBA03, 300);
+        cache.Record(0xDC07, 0xBA03, 500);
+        cache.Record(0, 0x3001, 1000);
+        cache.Close();
+    }
+    std::string file = (std::filesystem::path(dir) /
+        DescriptorCache::FileName(DeviceFamily::Pavo, "4.5 (Build 407)")).string();
+    ASSERT_TRUE(std::filesystem::exists(file), "Close writes the cache file");
+    ASSERT_TRUE(DescriptorCache::FileName(DeviceFamily::Pavo, "4.5 (Build 407)").find(' ') == std::string::npos,
+                "File name has no spaces");
+
+    DescriptorCache cache;
+    cache.SetSkipCached(true);
+    cache.Open(dir, DeviceFamily::Pavo, "4.5 (Build 407)");
+    ASSERT_TRUE(cache.ShouldSkip(0xDC44, 0xBA03), "First entry reloaded");
+    ASSERT_TRUE(cache.ShouldSkip(0xDC07, 0xBA03), "Second entry reloaded");
+    ASSERT_TRUE(cache.ShouldSkip(0, 0x3001), "PropsSupported entry reloaded");
+    ASSERT_EQ(cache.GetStats().saved_us, uint64_t(1800), "Three skips at the 600 us mean");
+    ASSERT_EQ(cache.GetStats().queries_issued, uint64_t(0), "Stats are per session");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFirmwareKeying() {
+    std::cout << "Testing family / firmware keying..." << std::endl;
+    std::string dir = TempDir();
+
+    {
+        DescriptorCache cache;
+        cache.Open(dir, DeviceFamily::Scorpius, "3.2");
+        cache.Record(0xDC44, 0xBA03, 100);
+        cache.Close();
+    }
+
+    DescriptorCache cache;
+    cache.SetSkipCached(true);
+    cache.Open(dir, DeviceFamily::Scorpius, "3.3");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC44, 0xBA03), "New firmware starts empty");
+    cache.Open(dir, DeviceFamily::Draco, "3.2");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC44, 0xBA03), "Other family starts empty");
+    cache.Open(dir, DeviceFamily::Scorpius, "3.2");
+    ASSERT_TRUE(cache.ShouldSkip(0xDC44, 0xBA03), "Original key still cached");
+
+    // A file copied under another firmware's name is rejected
+    std::filesystem::copy_file(
+        std::filesystem::path(dir) / DescriptorCache::FileName(DeviceFamily::Scorpius, "3.2"),
+        std::filesystem::path(dir) / DescriptorCache::FileName(DeviceFamily::Scorpius, "3.4"));
+    cache.Open(dir, DeviceFamily::Scorpius, "3.4");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC44, 0xBA03), "Mismatched header is a miss");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestClearAndCorruption() {
+    std::cout << "Testing Clear and corrupt files..." << std::endl;
+    std::string dir = TempDir();
+    std::string file = (std::filesystem::path(dir) /
+        DescriptorCache::FileName(DeviceFamily::Keel, "1.4")).string();
+
+    DescriptorCache cache;
+    cache.SetSkipCached(true);
+    cache.Open(dir, DeviceFamily::Keel, "1.4");
+    cache.Record(0xDC44, 0x3009, 100);
+    ASSERT_TRUE(cache.Save(), "Save succeeds");
+    ASSERT_TRUE(std::filesystem::exists(file), "Save writes the file");
+
+    cache.Clear();
+    ASSERT_FALSE(std::filesystem::exists(file), "Clear deletes the file");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC44, 0x3009), "Clear forgets entries");
+
+    cache.Record(0xDC44, 0x3009, 100);
+    cache.Close();
+    auto size = std::filesystem::file_size(file);
+    std::filesystem::resize_file(file, size - 2);
+    cache.Open(dir, DeviceFamily::Keel, "1.4");
+    ASSERT_FALSE(cache.ShouldSkip(0xDC44, 0x3009), "Truncated file is a miss");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Descriptor Cache Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestSkipGating, "Skip Gating");
+    run_test(TestPersistence, "Persistence");
+    run_test(TestFirmwareKeying, "Firmware Keying");
+    run_test(TestClearAndCorruption, "Clear / Corruption");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_descriptor_cache");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
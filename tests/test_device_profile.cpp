@@ -0,0 +1,179 @@
+/**
+ * test_device_profile.cpp
+ *
+ * Unit tests for persisted device profiles
+ * Tests round trip, Matches, serial keying and corrupt files
+ */
+
+#include "lib/src/ZuneDeviceProfile.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using zune::DeviceProfile;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_device_profile";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+static DeviceProfile SampleProfile() {
+    DeviceProfile profile;
+    profile.serial = "0123 4567/89AB";
+    profile.firmware = "4.5 (Build 407)";
+    profile.identification = 0x00020105;
+    profile.capacity_bytes = 31998623744ULL;
+    profile.storage_ids = {0x00010001, 0x00020001};
+    return profile;
+}
+
+bool TestRoundTrip() {
+    std::cout << "Testing round trip..." << std::endl;
+    std::string dir = TempDir();
+
+    DeviceProfile saved = SampleProfile();
+    ASSERT_TRUE(saved.Save(dir), "Save succeeds");
+    ASSERT_TRUE(DeviceProfile::FileName(saved.serial).find('/') == std::string::npos,
+                "File name has no path separators");
+
+    DeviceProfile loaded;
+    ASSERT_TRUE(DeviceProfile::Load(dir, saved.serial, loaded), "Load finds the profile");
+    ASSERT_EQ(loaded.serial, saved.serial, "Serial");
+    ASSERT_EQ(loaded.firmware, saved.firmware, "Firmware");
+    ASSERT_EQ(loaded.identification, saved.identification, "Identification");
+    ASSERT_EQ(loaded.capacity_bytes, saved.capacity_bytes, "Capacity");
+    ASSERT_EQ(loaded.storage_ids.size(), size_t(2), "Storage ID count");
+    ASSERT_EQ(loaded.storage_ids[1], uint32_t(0x00020001), "Second storage ID");
+
+    saved.capacity_bytes = 7864320000ULL;
+    ASSERT_TRUE(saved.Save(dir), "Save replaces an existing file");
+    ASSERT_TRUE(DeviceProfile::Load(dir, saved.serial, loaded), "Reload");
+    ASSERT_EQ(loaded.capacity_bytes, uint64_t(7864320000ULL), "Replaced capacity");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMatches() {
+    std::cout << "Testing Matches..." << std::endl;
+    DeviceProfile profile = SampleProfile();
+
+    ASSERT_TRUE(profile.Matches("4.5 (Build 407)", 0x00020105), "Same firmware and identification");
+    ASSERT_FALSE(profile.Matches("4.5 (Build 408)", 0x00020105), "Firmware update invalidates");
+    ASSERT_FALSE(profile.Matches("4.5 (Build 407)", 0x00020106), "Different identification invalidates");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestSerialKeying() {
+    std::cout << "Testing serial keying..." << std::endl;
+    std::string dir = TempDir();
+
+    DeviceProfile profile = SampleProfile();
+    ASSERT_TRUE(profile.Save(dir), "Save succeeds");
+
+    DeviceProfile loaded;
+    ASSERT_FALSE(DeviceProfile::Load(dir, "FEDCBA", loaded), "Other serial has no profile");
+
+    // Serials that sanitize to the same file name must not share a profile
+    std::string alias = "0123_4567_89AB";
+    ASSERT_EQ(DeviceProfile::FileName(alias), DeviceProfile::FileName(profile.serial), "Names collide");
+    ASSERT_FALSE(DeviceProfile::Load(dir, alias, loaded), "Stored serial is checked");
+
+    DeviceProfile empty;
+    ASSERT_FALSE(empty.Save(dir), "No serial, no file");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestCorruption() {
+    std::cout << "Testing corrupt files..." << std::endl;
+    std::string dir = TempDir();
+    DeviceProfile profile = SampleProfile();
+    std::string file = (std::filesystem::path(dir) / DeviceProfile::FileName(profile.serial)).string();
+
+    ASSERT_TRUE(profile.Save(dir), "Save succeeds");
+    auto size = std::filesystem::file_size(file);
+    std::filesystem::resize_file(file, size - 2);
+    DeviceProfile loaded;
+    ASSERT_FALSE(DeviceProfile::Load(dir, profile.serial, loaded), "Truncated file is a miss");
+
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out << "XZDC\x01\x00\x00\x00";
+    }
+    ASSERT_FALSE(DeviceProfile::Load(dir, profile.serial, loaded), "Wrong magic is a miss");
+
+    profile.storage_ids.clear();
+    ASSERT_TRUE(profile.Save(dir), "Save without storage");
+    ASSERT_FALSE(DeviceProfile::Load(dir, profile.serial, loaded), "Profile without storage is a miss");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Device Profile Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestRoundTrip, "Round Trip");
+    run_test(TestMatches, "Matches");
+    run_test(TestSerialKeying, "Serial Keying");
+    run_test(TestCorruption, "Corruption");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_device_profile");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -6,6 +6,7 @@
  */
 
 #include "lib/src/protocols/handlers/DNSHandler.h"
+#include "lib/src/protocols/ppp/PPPParser.h"
 #include <iostream>
 #include <map>
 
@@ -544,6 +545,132 @@ bool TestEmptyHostname() {
     return true;
 }
 
+// UDP/IP query from device_ip:src_port for name (wire format) with the given ID
+static mtp::ByteArray BuildQueryPacket(uint32_t device_ip, uint16_t src_port, uint16_t id,
+                                       const std::vector<uint8_t>& name) {
+    mtp::ByteArray packet = {
+        0x45, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x40, 0x11, 0x00, 0x00,
+        static_cast<uint8_t>(device_ip >> 24), static_cast<uint8_t>(device_ip >> 16),
+        static_cast<uint8_t>(device_ip >> 8), static_cast<uint8_t>(device_ip),
+        0xC0, 0xA8, 0x37, 0x64,
+        static_cast<uint8_t>(src_port >> 8), static_cast<uint8_t>(src_port), 0x00, 0x35,
+        0x00, 0x00, 0x00, 0x00,
+        static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id),
+        0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+    packet.insert(packet.end(), name.begin(), name.end());
+    packet.insert(packet.end(), {0x00, 0x01, 0x00, 0x01});
+    return packet;
+}
+
+// Test: precompiled answers send what BuildResponse would, with valid headers
+bool TestPrecompiledAnswers() {
+    std::cout << "Testing precompiled DNS answers..." << std::endl;
+
+    std::map<std::string, uint32_t> hostname_map = {
+        {"catalog.zune.net", 0xC0A83764},
+        {"zune.net", 0xC0A83765}
+    };
+    DNSHandler handler(hostname_map);
+    std::vector<uint8_t> name = {7, 'c', 'a', 't', 'a', 'l', 'o', 'g', 4, 'z', 'u', 'n', 'e', 3, 'n', 'e', 't', 0};
+
+    struct Case { uint32_t device_ip; uint16_t port; uint16_t id; };
+    const Case cases[] = {
+        {0xC0A83765, 0xC000, 0x1234},
+        {0xC0A83765, 0xC001, 0xBEEF},
+        {0xC0A83766, 0xD000, 0x0001}  // New device address
+    };
+    for (const Case& c : cases) {
+        mtp::ByteArray query_packet = BuildQueryPacket(c.device_ip, c.port, c.id, name);
+        auto response = handler.HandleQuery(query_packet);
+        ASSERT_TRUE(response.has_value(), "Should answer");
+
+        PPPParser::ParsedFrame frame;
+        ASSERT_TRUE(PPPParser::TryParseFrame(*response, frame), "Valid PPP frame");
+        const mtp::ByteArray& ip = frame.payload;
+        ASSERT_TRUE(ip.size() > 28, "IP and UDP headers");
+
+        // IP header: checksum over the whole header folds to 0xFFFF
+        uint32_t sum = 0;
+        for (size_t i = 0; i < 20; i += 2) {
+            sum += (ip[i] << 8) | ip[i + 1];
+        }
+        while (sum >> 16) {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        ASSERT_EQ(sum, uint32_t(0xFFFF), "IP header checksum valid");
+        ASSERT_EQ(size_t((ip[2] << 8) | ip[3]), ip.size(), "IP total length");
+        uint32_t dst_ip = (uint32_t(ip[16]) << 24) | (ip[17] << 16) | (ip[18] << 8) | ip[19];
+        ASSERT_EQ(dst_ip, c.device_ip, "Sent to the device");
+
+        // UDP header: ports swapped
+        ASSERT_EQ((ip[20] << 8) | ip[21], 53, "From port 53");
+        ASSERT_EQ((ip[22] << 8) | ip[23], int(c.port), "To the query's port");
+        ASSERT_EQ(size_t((ip[24] << 8) | ip[25]), ip.size() - 20, "UDP length");
+
+        // DNS: what BuildResponse builds for the same query
+        mtp::ByteArray query(query_packet.begin() + 28, query_packet.end());
+        mtp::ByteArray expected = DNSServer::BuildResponse(query, hostname_map);
+        mtp::ByteArray dns(ip.begin() + 28, ip.end());
+        ASSERT_TRUE(dns == expected, "DNS response matches BuildResponse");
+    }
+
+    // TCP framing uses the same answer
+    mtp::ByteArray tcp_query = {0x12, 0x34, 0x00, 0x35, 0x00, 0x00, 0x00, 0x00,
+                                0xAB, 0xCD, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    tcp_query.insert(tcp_query.end(), name.begin(), name.end());
+    tcp_query.insert(tcp_query.end(), {0x00, 0x01, 0x00, 0x01});
+    tcp_query[5] = static_cast<uint8_t>(tcp_query.size());
+    size_t consumed = 0;
+    auto tcp_response = handler.HandleTCPQuery(tcp_query, consumed);
+    ASSERT_TRUE(tcp_response.has_value(), "TCP query answered");
+    ASSERT_EQ(consumed, tcp_query.size(), "TCP query consumed");
+    mtp::ByteArray expected = DNSServer::BuildResponse(
+        mtp::ByteArray(tcp_query.begin() + 8, tcp_query.end()), hostname_map);
+    ASSERT_TRUE(mtp::ByteArray(tcp_response->begin() + 8, tcp_response->end()) == expected,
+                "TCP DNS response matches BuildResponse");
+
+    // A remapped hostname gets the new address
+    handler.UpdateHostnameMap({{"catalog.zune.net", 0x0A000001}});
+    auto remapped = handler.HandleQuery(BuildQueryPacket(0xC0A83765, 0xC000, 1, name));
+    ASSERT_TRUE(remapped.has_value(), "Answered after update");
+    bool found = false;
+    for (size_t i = 0; i + 4 <= remapped->size(); i++) {
+        if ((*remapped)[i] == 0x0A && (*remapped)[i + 1] == 0x00 &&
+            (*remapped)[i + 2] == 0x00 && (*remapped)[i + 3] == 0x01) {
+            found = true;
+        }
+    }
+    ASSERT_TRUE(found, "New address in the answer");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: incremental checksum update agrees with a full recompute
+bool TestIncrementalChecksum() {
+    std::cout << "Testing incremental checksum update..." << std::endl;
+
+    uint8_t header[20] = {0x45, 0x00, 0x00, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x40, 0x11,
+                          0x00, 0x00, 0xC0, 0xA8, 0x37, 0x64, 0xC0, 0xA8, 0x37, 0x65};
+    uint16_t checksum = IPParser::CalculateChecksum(header, sizeof(header));
+    uint16_t old_word = 0;
+    for (uint32_t id : {0x0000u, 0x0001u, 0x1234u, 0xFFFEu, 0xFFFFu, 0x8000u}) {
+        uint16_t updated = DNSHandler::UpdateChecksum(checksum, old_word, static_cast<uint16_t>(id));
+        header[4] = (id >> 8) & 0xFF;
+        header[5] = id & 0xFF;
+        uint16_t full = IPParser::CalculateChecksum(header, sizeof(header));
+        // 0x0000 and 0xFFFF are both zero in ones' complement
+        ASSERT_TRUE(updated == full || (updated ^ full) == 0xFFFF,
+                    "Incremental matches full for ID " + std::to_string(id));
+        checksum = updated;
+        old_word = static_cast<uint16_t>(id);
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "======================================" << std::endl;
     std::cout << " DNSHandler Unit Tests" << std::endl;
@@ -575,6 +702,8 @@ int main() {
     run_test(TestDNSCaseInsensitivity, "DNS Case Insensitivity (RFC 1035)");
     run_test(TestUnsupportedRecordType, "Unsupported DNS Record Type");
     run_test(TestEmptyHostname, "Empty Hostname Query");
+    run_test(TestPrecompiledAnswers, "Precompiled DNS Answers");
+    run_test(TestIncrementalChecksum, "Incremental Checksum Update");
 
     std::cout << "======================================" << std::endl;
     std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
@@ -0,0 +1,162 @@
+/**
+ * test_folder_cache.cpp
+ *
+ * Unit tests for zune::FolderCache
+ * Tests root and folder listings, hit / miss counting, created and deleted
+ * objects, invalidation, one-time readback and Clear
+ */
+
+#include "lib/src/ZuneFolderCache.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::FolderCache;
+using zune::FolderChild;
+using zune::RootDiscoveryResult;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+static RootDiscoveryResult SampleRoot() {
+    RootDiscoveryResult root;
+    root.music_folder = 0x10;
+    root.albums_folder = 0x11;
+    root.artists_folder = 0x12;
+    root.playlists_folder = 0x13;
+    root.storage_id = 0x10001;
+    return root;
+}
+
+bool TestRoot() {
+    std::cout << "Testing root discovery..." << std::endl;
+    FolderCache cache;
+    RootDiscoveryResult root;
+    ASSERT_TRUE(!cache.GetRoot(root), "Unknown at first");
+
+    cache.SetRoot(SampleRoot());
+    ASSERT_TRUE(cache.GetRoot(root), "Known once set");
+    ASSERT_EQ(root.music_folder, uint32_t(0x10), "Music folder");
+    ASSERT_EQ(root.storage_id, uint32_t(0x10001), "Storage");
+
+    // A new root folder or a deleted one changes the answer
+    cache.FolderCreated(0, "Podcasts", 0x14);
+    ASSERT_TRUE(!cache.GetRoot(root), "Forgotten after a root folder is created");
+    cache.SetRoot(SampleRoot());
+    cache.ObjectDeleted(0x13);
+    ASSERT_TRUE(!cache.GetRoot(root), "Forgotten after a root folder is deleted");
+
+    auto stats = cache.GetStats();
+    ASSERT_EQ(stats.hits, uint64_t(1), "One hit");
+    ASSERT_EQ(stats.misses, uint64_t(3), "Three misses");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestChildren() {
+    std::cout << "Testing folder listings..." << std::endl;
+    FolderCache cache;
+    std::vector<FolderChild> children;
+    ASSERT_TRUE(!cache.GetChildren(0x10, children), "Unknown at first");
+
+    cache.SetChildren(0x10, {{"Artist A", 0x20}, {"Artist B", 0x21}});
+    ASSERT_TRUE(cache.GetChildren(0x10, children), "Known once listed");
+    ASSERT_EQ(children.size(), size_t(2), "Two children");
+    ASSERT_EQ(cache.Find(0x10, "Artist B"), uint32_t(0x21), "Found by name");
+    ASSERT_EQ(cache.Find(0x10, "Artist C"), uint32_t(0), "Unknown name");
+    ASSERT_EQ(cache.Find(0x99, "Artist A"), uint32_t(0), "Unlisted folder");
+
+    // A created folder joins its parent's listing and is known to be empty
+    cache.FolderCreated(0x10, "Artist C", 0x22);
+    ASSERT_EQ(cache.Find(0x10, "Artist C"), uint32_t(0x22), "Created folder listed");
+    ASSERT_TRUE(cache.GetChildren(0x22, children), "New folder listed");
+    ASSERT_TRUE(children.empty(), "And empty");
+    cache.FolderCreated(0x22, "Album", 0x30);
+    ASSERT_EQ(cache.Find(0x22, "Album"), uint32_t(0x30), "Nested folder listed");
+
+    // Deleting drops the object from listings, and its own listing
+    cache.ObjectDeleted(0x22);
+    ASSERT_EQ(cache.Find(0x10, "Artist C"), uint32_t(0), "Deleted folder unlisted");
+    ASSERT_TRUE(!cache.GetChildren(0x22, children), "Its listing is gone");
+    ASSERT_TRUE(cache.GetChildren(0x10, children), "Parent still known");
+    ASSERT_EQ(children.size(), size_t(2), "Two children again");
+
+    // Another kind of object created in the folder: listing must be re-read
+    cache.Invalidate(0x10);
+    ASSERT_TRUE(!cache.GetChildren(0x10, children), "Invalidated");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestReadBackAndClear() {
+    std::cout << "Testing readback and Clear..." << std::endl;
+    FolderCache cache;
+    ASSERT_TRUE(cache.MarkReadBack(0x30), "First readback goes out");
+    ASSERT_TRUE(!cache.MarkReadBack(0x30), "Second is skipped");
+    ASSERT_TRUE(cache.MarkReadBack(0x31), "Other folders still read back");
+
+    // Deleting a folder forgets its readback along with its listing
+    cache.ObjectDeleted(0x31);
+    ASSERT_TRUE(cache.MarkReadBack(0x31), "Deleted folder forgotten");
+
+    cache.SetRoot(SampleRoot());
+    cache.SetChildren(0x10, {{"Artist A", 0x20}});
+    cache.Clear();
+    RootDiscoveryResult root;
+    std::vector<FolderChild> children;
+    ASSERT_TRUE(!cache.GetRoot(root), "Root forgotten");
+    ASSERT_TRUE(!cache.GetChildren(0x10, children), "Listings forgotten");
+    ASSERT_TRUE(cache.MarkReadBack(0x30), "Readbacks forgotten");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Folder Cache Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestRoot, "Root");
+    run_test(TestChildren, "Children");
+    run_test(TestReadBackAndClear, "Readback And Clear");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
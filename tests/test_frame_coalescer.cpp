@@ -0,0 +1,174 @@
+/**
+ * test_frame_coalescer.cpp
+ *
+ * Unit tests for packing PPP frames into 0x922c transfers
+ * Tests the adaptive wait of FrameCoalescer (growing when frames arrive
+ * during partial transfers, shrinking when waits come up empty), its
+ * transfer accounting, and ResponseFrameQueue::WaitForFrame waking on a
+ * push from another thread
+ */
+
+#include "lib/src/protocols/http/FrameCoalescer.h"
+#include "lib/src/protocols/http/ResponseFrameQueue.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+using Micros = FrameCoalescer::Micros;
+
+bool TestAdaptiveWait() {
+    std::cout << "Testing the adaptive wait..." << std::endl;
+    FrameCoalescer coalescer(7680, Micros(2000));
+
+    // A thread draining its own frames: nothing turns up mid-send, no wait
+    ASSERT_EQ(coalescer.WaitFor(1500).count(), int64_t(0), "No wait at first");
+    coalescer.OnSent(1500, false);
+    ASSERT_EQ(coalescer.WaitFor(1500).count(), int64_t(0), "Still none");
+
+    // Frames arriving during partial transfers: wait, doubling up to the maximum
+    coalescer.OnSent(1500, true);
+    ASSERT_EQ(coalescer.WaitFor(1500).count(), int64_t(250), "Starts at an eighth");
+    coalescer.OnWaited(true);
+    coalescer.OnSent(3000, true);
+    ASSERT_EQ(coalescer.WaitFor(1500).count(), int64_t(500), "Doubles");
+    for (int i = 0; i < 5; i++) {
+        coalescer.OnSent(3000, true);
+    }
+    ASSERT_EQ(coalescer.CurrentWait().count(), int64_t(2000), "Capped at the maximum");
+
+    // Full transfers never wait, and say nothing about the producers
+    ASSERT_EQ(coalescer.WaitFor(7680).count(), int64_t(0), "Full transfer sent at once");
+    coalescer.OnSent(7680, true);
+    ASSERT_EQ(coalescer.CurrentWait().count(), int64_t(2000), "Unchanged by a full transfer");
+
+    // Waits that come up empty halve it back to zero
+    coalescer.OnWaited(false);
+    ASSERT_EQ(coalescer.CurrentWait().count(), int64_t(1000), "Halved");
+    coalescer.OnWaited(false);
+    coalescer.OnWaited(false);
+    coalescer.OnWaited(false);
+    ASSERT_EQ(coalescer.CurrentWait().count(), int64_t(0), "Back to sending at once");
+    ASSERT_EQ(coalescer.WaitFor(100).count(), int64_t(0), "Lone frame goes straight out");
+
+    FrameCoalescer::Stats stats = coalescer.GetStats();
+    ASSERT_EQ(stats.transfers, uint64_t(9), "Transfers counted");
+    ASSERT_EQ(stats.full_transfers, uint64_t(1), "Full transfer counted");
+    ASSERT_EQ(stats.bytes, uint64_t(1500 * 2 + 3000 * 6 + 7680), "Bytes counted");
+    ASSERT_EQ(stats.waits, uint64_t(5), "Waits counted");
+    ASSERT_EQ(stats.waits_filled, uint64_t(1), "Filled waits counted");
+
+    // Zero maximum disables waiting; the budget is at least one byte
+    coalescer.Configure(0, Micros(0));
+    ASSERT_EQ(coalescer.Budget(), size_t(1), "Budget floor");
+    coalescer.Configure(4096, Micros(0));
+    coalescer.OnSent(10, true);
+    ASSERT_EQ(coalescer.WaitFor(10).count(), int64_t(0), "Waiting disabled");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestWaitForFrame() {
+    std::cout << "Testing the drain waiting for a frame..." << std::endl;
+    ResponseFrameQueue queue(4);
+    ASSERT_TRUE(queue.TryBeginDrain(), "Drain elected");
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_FALSE(queue.WaitForFrame(Micros(2000)), "Empty queue times out");
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start >= Micros(2000), "Waited the full timeout");
+
+    uint8_t first = 1;
+    queue.Push(&first, 1);
+    ASSERT_TRUE(queue.WaitForFrame(Micros(0)), "Queued frame ready without waiting");
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    ASSERT_TRUE(queue.Peek(data, size), "Peek");
+    queue.Consume(size);
+
+    // A push from another thread wakes the wait well before its timeout
+    start = std::chrono::steady_clock::now();
+    std::thread producer([&queue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint8_t frame[3] = {7, 8, 9};
+        queue.Push(frame, sizeof(frame));
+    });
+    bool ready = queue.WaitForFrame(std::chrono::seconds(10));
+    auto waited = std::chrono::steady_clock::now() - start;
+    producer.join();
+    ASSERT_TRUE(ready, "Woken by the push");
+    ASSERT_TRUE(waited < std::chrono::seconds(5), "Before the timeout");
+    ASSERT_TRUE(queue.Peek(data, size) && size == 3 && data[0] == 7, "The pushed frame");
+    queue.Consume(size);
+
+    // Frames past the ring's capacity go to the spill, which wakes it too
+    for (uint8_t i = 0; i < 6; i++) {
+        queue.Push(&i, 1);
+    }
+    for (uint8_t i = 0; i < 6; i++) {
+        ASSERT_TRUE(queue.WaitForFrame(Micros(0)), "Ring and spill frames ready");
+        ASSERT_TRUE(queue.Peek(data, size) && data[0] == i, "In push order");
+        queue.Consume(size);
+    }
+    ASSERT_FALSE(queue.EndDrain(), "Drained");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Frame Coalescer Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestAdaptiveWait, "Adaptive Wait");
+    run_test(TestWaitForFrame, "Wait For Frame");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -15,9 +15,21 @@
 #include "../lib/src/protocols/handlers/CCPHandler.h"
 #include "../lib/src/protocols/tcp/TCPConnectionManager.h"
 #include "../lib/src/protocols/tcp/TCPState.h"
+#include "../lib/src/protocols/http/ResponseFrameQueue.h"
+#include "allocation_budget.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <random>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 template<typename T>
 bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
@@ -402,7 +414,7 @@ bool TestTCPSequentialDataPackets() {
                         1001, server_seq + 1, TCPParser::TCP_FLAG_ACK, 65535,
                         mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_TRUE(conn != nullptr, "Connection should exist");
@@ -469,7 +481,7 @@ bool TestTCPOutOfOrderData() {
                         2001, server_seq + 1, TCPParser::TCP_FLAG_ACK, 65535,
                         mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
 
@@ -526,7 +538,7 @@ bool TestTCPSequenceWraparound() {
                         start_seq + 1, server_seq + 1, TCPParser::TCP_FLAG_ACK, 65535,
                         mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_EQ(conn->state, TCPState::ESTABLISHED, "Should handle wraparound in handshake");
@@ -553,6 +565,462 @@ bool TestTCPSequenceWraparound() {
     return true;
 }
 
+// Test 6: Response queue under worker contention
+//
+// Replays an artist-image burst: four request-worker producers each queue
+// runs of ~1.5 KB PPP frames and try to drain after every run, the way
+// SendNextBatch does, with at most a 64 KB TCP window of frames each in
+// flight, while the drain packs frames into 7680-byte 0x922c payloads. Checks every frame arrives once and in its producer's order, and
+// times the lock-free queue against the deque + two mutexes it replaced.
+namespace {
+
+constexpr int kContentionWorkers = 4;
+constexpr uint32_t kFramesPerWorker = 20000;
+constexpr size_t kFrameBytes = 1500;
+constexpr size_t kUsbMaxTransfer = 7680;
+constexpr uint32_t kFramesPerBatch = 6;
+constexpr uint32_t kWindowFrames = 44;  // 64 KB of 1460-byte segments
+
+void FillFrame(mtp::ByteArray& frame, uint32_t worker, uint32_t seq) {
+    frame.assign(kFrameBytes, static_cast<uint8_t>(seq));
+    std::memcpy(frame.data(), &worker, 4);
+    std::memcpy(frame.data() + 4, &seq, 4);
+}
+
+// Reassembles frames from the combined payloads and checks their order
+struct FrameChecker {
+    std::atomic<uint32_t> next_seq[kContentionWorkers] = {};
+    mtp::ByteArray partial;
+    uint64_t frames = 0;
+    bool in_order = true;
+
+    void Feed(const uint8_t* data, size_t size) {
+        partial.insert(partial.end(), data, data + size);
+        size_t offset = 0;
+        while (partial.size() - offset >= kFrameBytes) {
+            uint32_t worker = 0;
+            uint32_t seq = 0;
+            std::memcpy(&worker, partial.data() + offset, 4);
+            std::memcpy(&seq, partial.data() + offset + 4, 4);
+            if (worker >= kContentionWorkers || seq != next_seq[worker].load(std::memory_order_relaxed)) {
+                in_order = false;
+            } else {
+                next_seq[worker].store(seq + 1, std::memory_order_release);
+            }
+            frames++;
+            offset += kFrameBytes;
+        }
+        partial.erase(partial.begin(), partial.begin() + offset);
+    }
+
+    // The worker's window is full until the drain has sent its older frames
+    bool WindowFull(uint32_t worker, uint32_t seq) const {
+        return seq - next_seq[worker].load(std::memory_order_acquire) >= kWindowFrames;
+    }
+};
+
+// The previous scheme: deque + response_queue_mutex_, serialized by drain_mutex_
+double RunMutexQueue(FrameChecker& checker) {
+    std::deque<mtp::ByteArray> queue;
+    std::mutex queue_mutex;
+    std::mutex drain_mutex;
+
+    auto drain = [&]() {
+        std::lock_guard<std::mutex> drain_lock(drain_mutex);
+        while (true) {
+            mtp::ByteArray combined;
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                while (!queue.empty()) {
+                    const size_t space_left = kUsbMaxTransfer - combined.size();
+                    const auto& front = queue.front();
+                    if (front.size() <= space_left) {
+                        combined.insert(combined.end(), front.begin(), front.end());
+                        queue.pop_front();
+                    } else if (space_left > 0) {
+                        combined.insert(combined.end(), front.begin(), front.begin() + space_left);
+                        queue.front() = mtp::ByteArray(front.begin() + space_left, front.end());
+                        break;
+                    } else {
+                        break;
+                    }
+                }
+            }
+            if (combined.empty()) break;
+            checker.Feed(combined.data(), combined.size());
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < kContentionWorkers; w++) {
+        workers.emplace_back([&, w]() {
+            mtp::ByteArray frame;
+            for (uint32_t seq = 0; seq < kFramesPerWorker; seq++) {
+                while (checker.WindowFull(w, seq)) {
+                    drain();
+                    std::this_thread::yield();
+                }
+                FillFrame(frame, w, seq);
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex);
+                    queue.push_back(frame);
+                }
+                if ((seq + 1) % kFramesPerBatch == 0) drain();
+            }
+            drain();
+        });
+    }
+    for (auto& t : workers) t.join();
+    drain();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double RunFrameQueue(FrameChecker& checker, uint64_t& spilled) {
+    ResponseFrameQueue queue;
+    mtp::ByteArray combined;
+    combined.reserve(kUsbMaxTransfer);
+
+    // Same shape as DrainResponseQueue / DrainQueuedFrames
+    auto drain = [&]() {
+        do {
+            if (!queue.TryBeginDrain()) return;
+            while (true) {
+                combined.clear();
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+                while (combined.size() < kUsbMaxTransfer && queue.Peek(data, size)) {
+                    const size_t take = std::min(size, kUsbMaxTransfer - combined.size());
+                    combined.insert(combined.end(), data, data + take);
+                    queue.Consume(take);
+                    if (take < size) break;
+                }
+                if (combined.empty()) break;
+                checker.Feed(combined.data(), combined.size());
+            }
+        } while (queue.EndDrain());
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < kContentionWorkers; w++) {
+        workers.emplace_back([&, w]() {
+            mtp::ByteArray frame;
+            for (uint32_t seq = 0; seq < kFramesPerWorker; seq++) {
+                while (checker.WindowFull(w, seq)) {
+                    drain();
+                    std::this_thread::yield();
+                }
+                FillFrame(frame, w, seq);
+                queue.Push(frame);
+                if ((seq + 1) % kFramesPerBatch == 0) drain();
+            }
+            drain();
+        });
+    }
+    for (auto& t : workers) t.join();
+    drain();
+    spilled = queue.SpilledTotal();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+bool TestResponseQueueContention() {
+    std::cout << "Testing response queue under worker contention..." << std::endl;
+
+    const uint64_t expected = uint64_t(kContentionWorkers) * kFramesPerWorker;
+
+    FrameChecker mutex_checker;
+    double mutex_ms = RunMutexQueue(mutex_checker);
+    ASSERT_EQ(mutex_checker.frames, expected, "Mutex queue delivers every frame");
+
+    FrameChecker ring_checker;
+    uint64_t spilled = 0;
+    double ring_ms = RunFrameQueue(ring_checker, spilled);
+    ASSERT_EQ(ring_checker.frames, expected, "Frame queue delivers every frame");
+    ASSERT_TRUE(ring_checker.in_order, "Frame queue keeps each worker's frames in order");
+    ASSERT_TRUE(ring_checker.partial.empty(), "No partial frame left over");
+
+    // A few frames queued from inside the drain, past the ring's capacity
+    ResponseFrameQueue small(4);
+    ASSERT_TRUE(small.TryBeginDrain(), "First drain elected");
+    ASSERT_FALSE(small.TryBeginDrain(), "Nested drain refused");
+    for (uint8_t i = 0; i < 10; i++) {
+        small.Push(&i, 1);
+    }
+    ASSERT_EQ(small.SizeApprox(), size_t(10), "Ring and spill counted");
+    ASSERT_EQ(small.SpilledTotal(), uint64_t(6), "Overflow spilled");
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    for (uint8_t i = 0; i < 10; i++) {
+        ASSERT_TRUE(small.Peek(data, size), "Frame available");
+        ASSERT_EQ(int(data[0]), int(i), "Ring then spill, in push order");
+        small.Consume(size);
+    }
+    ASSERT_FALSE(small.Peek(data, size), "Drained");
+    ASSERT_FALSE(small.EndDrain(), "Nothing left for another drain");
+
+    PendingSendList pending;
+    std::vector<std::thread> adders;
+    for (int w = 0; w < kContentionWorkers; w++) {
+        adders.emplace_back([&pending]() {
+            TCPConnectionKey key = TCPConnectionManager::MakeConnectionKey(0xC0A83765, 49152, 0xC0A8001E, 80);
+            for (uint32_t i = 0; i < 1000; i++) pending.Add(key, 1000 + i % 8);
+        });
+    }
+    for (auto& t : adders) t.join();
+    ASSERT_EQ(pending.TakeAll().size(), size_t(8), "Pending sends deduplicated");
+    ASSERT_TRUE(pending.TakeAll().empty(), "Pending sends taken once");
+
+    std::cout << "  " << expected << " frames from " << kContentionWorkers << " workers: "
+              << "deque+mutex " << mutex_ms << " ms, lock-free ring " << ring_ms << " ms"
+              << " (" << spilled << " spilled)" << std::endl;
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test 7: Allocation budgets on the poll thread
+//
+// Drives the whole interceptor, PPP to HTTP and back, against a device
+// simulated in the test, in reactor mode so every frame is received and
+// every response sent on the thread calling PollOnce. Allocations are
+// counted on that thread only, inside PollOnce, and checked against
+// budgets: per PPP frame received (ProcessPacket) and per response served
+// (SendHTTPResponse, with its connection's handshake, request and ACKs).
+namespace {
+
+constexpr uint32_t kDeviceIP = 0xC0A83765;  // 192.168.55.101
+constexpr uint32_t kServerIP = 0xC0A8001E;  // 192.168.0.30
+constexpr int kBudgetExchanges = 16;
+constexpr int kBudgetFrames = 256;
+
+// Budgets, in allocations: a received frame is taken out of the 0x922d
+// transfer and unwrapped to its TCP segment; a response is parsed, framed
+// segment by segment as the window opens and tracked until ACKed
+constexpr double kReceivedFrameBudget = 8.0;
+constexpr double kServedResponseBudget = 160.0;
+
+// The device end of 0x922c / 0x922d. Frames from the host are only
+// appended to a reserved buffer, so the device adds nothing to the
+// allocations counted on the poll thread.
+class LoopbackZune : public ZuneHTTPInterceptor {
+public:
+    LoopbackZune() : ZuneHTTPInterceptor(mtp::SessionPtr()) {
+        from_host_.reserve(1 << 20);
+    }
+
+    // Stop before the device goes away: request workers may still be running
+    ~LoopbackZune() { Stop(); }
+
+    bool SendVendorCommand(const mtp::ByteArray& data) override {
+        DeviceOperation922c(data);
+        return true;
+    }
+
+    /// Queue a frame for the next 0x922d
+    void ToHost(const mtp::ByteArray& frame) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        to_host_.insert(to_host_.end(), frame.begin(), frame.end());
+    }
+
+    /// PPP frames the host has sent since the last call
+    std::vector<mtp::ByteArray> TakeFromHost() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<mtp::ByteArray> frames = PPPParser::ExtractFramesWithBuffer(from_host_, incomplete_);
+        from_host_.clear();
+        return frames;
+    }
+
+protected:
+    bool DiscoverEndpoints() override { return true; }
+    bool HasDeviceLink() const override { return true; }
+    void WaitForDeviceEvent(int) override {}
+
+    void DeviceOperation922c(const mtp::ByteArray& payload) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        from_host_.insert(from_host_.end(), payload.begin(), payload.end());
+    }
+
+    mtp::ByteArray DeviceOperation922d() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mtp::ByteArray data;
+        data.swap(to_host_);
+        return data;
+    }
+
+private:
+    std::mutex mutex_;
+    mtp::ByteArray from_host_;
+    mtp::ByteArray to_host_;
+    mtp::ByteArray incomplete_;
+};
+
+std::string g_biography_path;
+
+const char* ResolveBiography(const char*, const char* endpoint_type, const char*, void*) {
+    if (!endpoint_type || std::string(endpoint_type) != "biography") {
+        return nullptr;
+    }
+    return strdup(g_biography_path.c_str());
+}
+
+// One PollOnce, returning the allocations it made on this thread
+uint64_t CountedPoll(LoopbackZune& zune) {
+    alloc_budget::AllocationScope scope;
+    zune.PollOnce(0);
+    return scope.Allocations();
+}
+
+struct Exchange {
+    int status = 0;
+    uint32_t snd_nxt = 0;  // Device's next sequence number
+    uint32_t rcv_nxt = 0;  // Host's, all ACKed
+};
+
+// Open a connection from port, GET the biography and ACK the response as it
+// arrives. Adds the allocations PollOnce made to allocations.
+bool ServeBiography(LoopbackZune& zune, uint16_t port, uint64_t& allocations, Exchange& exchange) {
+    const uint32_t iss = 1000;
+    zune.ToHost(BuildTCPSYNFrame(kDeviceIP, port, kServerIP, 80, iss));
+    allocations += CountedPoll(zune);
+
+    uint32_t irs = 0;
+    bool established = false;
+    for (const auto& frame : zune.TakeFromHost()) {
+        uint16_t protocol = 0;
+        mtp::ByteArray ip_packet = PPPParser::ExtractPayload(frame, &protocol);
+        TCPParser::TCPHeader tcp = TCPParser::ParseHeader(IPParser::ExtractPayload(ip_packet));
+        if (protocol == 0x0021 && tcp.dst_port == port &&
+            (tcp.flags & TCPParser::TCP_FLAG_SYN) && (tcp.flags & TCPParser::TCP_FLAG_ACK)) {
+            irs = tcp.seq_num;
+            established = true;
+        }
+    }
+    if (!established) {
+        return false;
+    }
+
+    std::string request = "GET /v3.0/en-US/music/artist/3c1e5b52-8b2c-4a9b-9e21-2c7a9c4f6d10/biography HTTP/1.1\r\n"
+                          "Host: catalog.zune.net\r\n"
+                          "\r\n";
+    zune.ToHost(BuildTCPACKFrame(kDeviceIP, port, kServerIP, 80, iss + 1, irs + 1));
+    zune.ToHost(BuildTCPDataFrame(kDeviceIP, port, kServerIP, 80, iss + 1, irs + 1, request));
+    const uint32_t snd_nxt = iss + 1 + static_cast<uint32_t>(request.size());
+
+    // Receive in order (nothing is lost here), ACKing each batch
+    std::string response;
+    size_t expected = 0;
+    for (int cycle = 0; cycle < 2000 && (expected == 0 || response.size() < expected); cycle++) {
+        allocations += CountedPoll(zune);
+
+        bool received = false;
+        for (const auto& frame : zune.TakeFromHost()) {
+            uint16_t protocol = 0;
+            mtp::ByteArray ip_packet = PPPParser::ExtractPayload(frame, &protocol);
+            if (protocol != 0x0021) {
+                continue;
+            }
+            mtp::ByteArray segment = IPParser::ExtractPayload(ip_packet);
+            TCPParser::TCPHeader tcp = TCPParser::ParseHeader(segment);
+            mtp::ByteArray payload = TCPParser::ExtractPayload(segment);
+            if (tcp.dst_port != port || tcp.seq_num != irs + 1 + response.size()) {
+                continue;
+            }
+            response.append(payload.begin(), payload.end());
+            received = received || !payload.empty();
+        }
+        if (received) {
+            zune.ToHost(BuildTCPACKFrame(kDeviceIP, port, kServerIP, 80, snd_nxt,
+                                         irs + 1 + static_cast<uint32_t>(response.size())));
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));  // The worker is reading the file
+        }
+
+        size_t header_end = response.find("\r\n\r\n");
+        if (expected == 0 && header_end != std::string::npos) {
+            exchange.status = std::atoi(response.c_str() + response.find(' ') + 1);
+            size_t length = response.find("Content-Length: ");
+            size_t body = length < header_end ? std::strtoul(response.c_str() + length + 16, nullptr, 10) : 0;
+            expected = header_end + 4 + body;
+        }
+    }
+
+    // The last ACK
+    allocations += CountedPoll(zune);
+    exchange.snd_nxt = snd_nxt;
+    exchange.rcv_nxt = irs + 1 + static_cast<uint32_t>(response.size());
+    return expected != 0 && response.size() == expected;
+}
+
+} // namespace
+
+bool TestPollThreadAllocationBudgets() {
+    std::cout << "Testing allocation budgets on the poll thread..." << std::endl;
+
+    std::string fixture = (std::filesystem::temp_directory_path() /
+                           ("test_interceptor_budget_" + std::to_string(std::random_device()()) + ".xml")).string();
+    {
+        std::ofstream out(fixture, std::ios::binary);
+        out << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<a:entry xmlns:a=\"http://www.w3.org/2005/Atom\">"
+            << "<a:content type=\"html\">";
+        for (int i = 0; i < 120; i++) {
+            out << "Formed in " << (1970 + i) << ", the band recorded " << (i % 7 + 2) << " albums. ";
+        }
+        out << "</a:content></a:entry>\n";
+    }
+    g_biography_path = fixture;
+
+    InterceptorConfig config;
+    config.mode = InterceptionMode::Static;
+    config.server_ip = "192.168.0.30";
+    config.reactor = true;
+
+    bool served = true;
+    Exchange exchange;
+    uint64_t response_allocations = 0;
+    uint64_t frame_allocations = 0;
+    {
+        LoopbackZune zune;
+        zune.SetPathResolverCallback(ResolveBiography, nullptr);
+        zune.Start(config);
+        zune.EnableNetworkPolling();
+
+        // Warm up: first-use allocations belong to setup, not to a budget
+        uint64_t warm_up = 0;
+        served = ServeBiography(zune, 49000, warm_up, exchange) &&
+                 ServeBiography(zune, 49001, warm_up, exchange);
+
+        for (int i = 0; served && i < kBudgetExchanges; i++) {
+            served = ServeBiography(zune, static_cast<uint16_t>(49100 + i), response_allocations, exchange);
+        }
+
+        // Window updates on the last connection, eight frames to a transfer:
+        // received, unwrapped and ACK-processed, with nothing sent back
+        for (int i = 0; served && i < kBudgetFrames; i += 8) {
+            for (int j = 0; j < 8; j++) {
+                zune.ToHost(BuildTCPACKFrame(kDeviceIP, static_cast<uint16_t>(49100 + kBudgetExchanges - 1),
+                                             kServerIP, 80, exchange.snd_nxt, exchange.rcv_nxt));
+            }
+            frame_allocations += CountedPoll(zune);
+            zune.TakeFromHost();
+        }
+    }
+    std::filesystem::remove(fixture);
+
+    ASSERT_TRUE(served, "Every biography served in full");
+    ASSERT_EQ(exchange.status, 200, "Served from the fixture");
+    ASSERT_TRUE(alloc_budget::WithinBudget("Served response", response_allocations, kBudgetExchanges,
+                                           kServedResponseBudget),
+                "Served response allocation budget");
+    ASSERT_TRUE(alloc_budget::WithinBudget("Received PPP frame", frame_allocations, kBudgetFrames,
+                                           kReceivedFrameBudget),
+                "Received frame allocation budget");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "======================================" << std::endl;
     std::cout << " HTTP Interceptor Integration Tests" << std::endl;
@@ -581,6 +1049,12 @@ int main() {
     run_test(TestTCPOutOfOrderData, "TCP Out-of-Order Data Handling");
     run_test(TestTCPSequenceWraparound, "TCP Sequence Number Wraparound");
 
+    // Worker / drain hand-off
+    run_test(TestResponseQueueContention, "Response Queue Contention");
+
+    // Allocations per received frame and per served response
+    run_test(TestPollThreadAllocationBudgets, "Poll Thread Allocation Budgets");
+
     std::cout << "======================================" << std::endl;
     std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
     std::cout << "======================================" << std::endl;
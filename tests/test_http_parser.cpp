@@ -0,0 +1,270 @@
+/**
+ * test_http_parser.cpp
+ *
+ * Unit tests for HTTP request extraction
+ * Tests the in-place RequestView parse (views into the buffer, header
+ * lookup, pipelined requests, the header limit), that TryExtractRequest
+ * built on it keeps its results, and the conditional request helpers
+ * (entity tags, HTTP dates, 304 decisions)
+ */
+
+#include "lib/src/protocols/http/HTTPParser.h"
+#include <iostream>
+#include <string>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+using Result = HTTPParser::ExtractResult;
+using View = std::string_view;
+
+static mtp::ByteArray Bytes(const std::string& text) {
+    return mtp::ByteArray(text.begin(), text.end());
+}
+
+static bool InBuffer(View view, const mtp::ByteArray& buffer) {
+    auto begin = reinterpret_cast<const char*>(buffer.data());
+    return view.data() >= begin && view.data() + view.size() <= begin + buffer.size();
+}
+
+bool TestRequestView() {
+    std::cout << "Testing the in-place request view..." << std::endl;
+    mtp::ByteArray buffer = Bytes(
+        "GET /v3.0/en-US/music/artist/abc/images?chunkSize=10&contenttype=image%2Fjpeg HTTP/1.1\r\n"
+        "Host:  catalog.zune.net \r\n"
+        "User-Agent: Zune/4.8\r\n"
+        "Not a header\r\n"
+        "If-None-Match: \"etag\"\r\n"
+        "\r\n");
+
+    HTTPParser::RequestView request;
+    size_t consumed = 0;
+    Result result = HTTPParser::TryExtractRequestView(buffer.data(), buffer.size(), request, consumed);
+    ASSERT_TRUE(result == Result::SUCCESS, "Parsed");
+    ASSERT_EQ(consumed, buffer.size(), "Whole head consumed");
+    ASSERT_EQ(request.method, View("GET"), "Method");
+    ASSERT_EQ(request.path, View("/v3.0/en-US/music/artist/abc/images"), "Path");
+    ASSERT_EQ(request.query, View("chunkSize=10&contenttype=image%2Fjpeg"), "Query left encoded");
+    ASSERT_EQ(request.protocol, View("HTTP/1.1"), "Protocol");
+    ASSERT_EQ(request.header_count, size_t(3), "Line without a colon skipped");
+    ASSERT_EQ(request.GetHeader("host"), View("catalog.zune.net"), "Host, trimmed, any case");
+    ASSERT_EQ(request.GetHeader("IF-NONE-MATCH"), View("\"etag\""), "If-None-Match");
+    ASSERT_TRUE(request.GetHeader("Accept").empty(), "Missing header");
+    ASSERT_TRUE(InBuffer(request.path, buffer) && InBuffer(request.headers[1].value, buffer),
+                "Fields view the buffer");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPipelined() {
+    std::cout << "Testing pipelined and partial requests..." << std::endl;
+    std::string first = "GET /a HTTP/1.1\r\nHost: one\r\n\r\n";
+    std::string second = "GET /b?x=1 HTTP/1.1\r\nHost: two\r\n\r\n";
+    mtp::ByteArray buffer = Bytes(first + second + "GET /c HTTP/1.1\r\nHo");
+
+    HTTPParser::RequestView request;
+    size_t consumed = 0;
+    ASSERT_TRUE(HTTPParser::TryExtractRequestView(buffer.data(), buffer.size(), request, consumed) ==
+                Result::SUCCESS, "First");
+    ASSERT_EQ(consumed, first.size(), "First size");
+    ASSERT_EQ(request.GetHeader("Host"), View("one"), "First host");
+
+    size_t offset = consumed;
+    ASSERT_TRUE(HTTPParser::TryExtractRequestView(buffer.data() + offset, buffer.size() - offset,
+                                                  request, consumed) == Result::SUCCESS, "Second");
+    ASSERT_EQ(consumed, second.size(), "Second size");
+    ASSERT_EQ(request.path, View("/b"), "Second path");
+    ASSERT_EQ(request.query, View("x=1"), "Second query");
+
+    offset += consumed;
+    ASSERT_TRUE(HTTPParser::TryExtractRequestView(buffer.data() + offset, buffer.size() - offset,
+                                                  request, consumed) == Result::INCOMPLETE, "Partial third");
+
+    mtp::ByteArray stale = Bytes("\x16\x03\x01 garbage\r\n\r\n");
+    ASSERT_TRUE(HTTPParser::TryExtractRequestView(stale.data(), stale.size(), request, consumed) ==
+                Result::INVALID_DATA, "Not HTTP");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestHeaderLimit() {
+    std::cout << "Testing the header limit..." << std::endl;
+    std::string head = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i < HTTPParser::RequestView::kMaxHeaders; i++) {
+        head += "X-" + std::to_string(i) + ": v\r\n";
+    }
+    mtp::ByteArray at_limit = Bytes(head + "\r\n");
+    mtp::ByteArray over_limit = Bytes(head + "X-More: v\r\n\r\n");
+
+    HTTPParser::RequestView request;
+    size_t consumed = 0;
+    ASSERT_TRUE(HTTPParser::TryExtractRequestView(at_limit.data(), at_limit.size(), request, consumed) ==
+                Result::SUCCESS, "At the limit");
+    ASSERT_EQ(request.header_count, HTTPParser::RequestView::kMaxHeaders, "All held");
+    ASSERT_TRUE(HTTPParser::TryExtractRequestView(over_limit.data(), over_limit.size(), request, consumed) ==
+                Result::INVALID_DATA, "Over the limit");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestExtractRequest() {
+    std::cout << "Testing TryExtractRequest on the view..." << std::endl;
+    mtp::ByteArray buffer = Bytes(
+        "GET  /v3.0/en-US/image/xyz?width=480&resize=true&contenttype=image%2Fjpeg  HTTP/1.1\r\n"
+        "Host: image.catalog.zune.net\r\n"
+        "Accept: */*\r\n"
+        "Accept: image/jpeg\r\n"
+        "\r\n"
+        "GET /next HTTP/1.1\r\n\r\n");
+
+    HTTPParser::HTTPRequest request;
+    size_t consumed = 0;
+    ASSERT_TRUE(HTTPParser::TryExtractRequest(buffer, request, consumed) == Result::SUCCESS, "Parsed");
+    ASSERT_EQ(request.method, std::string("GET"), "Method");
+    ASSERT_EQ(request.path, std::string("/v3.0/en-US/image/xyz"), "Path");
+    ASSERT_EQ(request.protocol, std::string("HTTP/1.1"), "Protocol");
+    ASSERT_EQ(request.GetQueryParam("contenttype"), std::string("image/jpeg"), "Query decoded");
+    ASSERT_EQ(request.query_params.size(), size_t(3), "Query params");
+    ASSERT_EQ(request.GetHeader("host"), std::string("image.catalog.zune.net"), "Host");
+    ASSERT_EQ(request.headers.size(), size_t(2), "Repeated header kept once");
+    ASSERT_EQ(request.GetHeader("Accept"), std::string("image/jpeg"), "Last value wins");
+    ASSERT_TRUE(request.body.empty(), "No body");
+
+    mtp::ByteArray no_path = Bytes("GET \r\nHost: x\r\n\r\n");
+    ASSERT_TRUE(HTTPParser::TryExtractRequest(no_path, request, consumed) == Result::INVALID_DATA,
+                "Missing path");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestValidators() {
+    std::cout << "Testing entity tags and HTTP dates..." << std::endl;
+    mtp::ByteArray body = Bytes("<feed/>");
+    std::string etag = HTTPParser::MakeETag(body.data(), body.size());
+    ASSERT_EQ(etag.size(), size_t(18), "Quoted 16 hex digits");
+    ASSERT_TRUE(etag.front() == '"' && etag.back() == '"', "Quoted");
+    ASSERT_EQ(HTTPParser::MakeETag(body.data(), body.size()), etag, "Stable");
+    mtp::ByteArray other = Bytes("<feed />");
+    ASSERT_TRUE(HTTPParser::MakeETag(other.data(), other.size()) != etag, "Differs with the body");
+
+    ASSERT_EQ(HTTPParser::FormatHTTPDate(784111777), std::string("Sun, 06 Nov 1994 08:49:37 GMT"), "Format");
+    int64_t seconds = 0;
+    ASSERT_TRUE(HTTPParser::ParseHTTPDate("Sun, 06 Nov 1994 08:49:37 GMT", seconds), "Parse");
+    ASSERT_EQ(seconds, int64_t(784111777), "Parsed value");
+    ASSERT_TRUE(HTTPParser::ParseHTTPDate(HTTPParser::FormatHTTPDate(1709251199), seconds) &&
+                seconds == 1709251199, "Round trip on a leap day");
+    ASSERT_TRUE(!HTTPParser::ParseHTTPDate("Sunday, 06-Nov-94 08:49:37 GMT", seconds), "Obsolete format");
+    ASSERT_TRUE(!HTTPParser::ParseHTTPDate("Sun, 06 Foo 1994 08:49:37 GMT", seconds), "Bad month");
+    ASSERT_TRUE(!HTTPParser::ParseHTTPDate("", seconds), "Empty");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+static HTTPParser::HTTPRequest Request(const std::string& headers) {
+    HTTPParser::HTTPRequest request;
+    size_t consumed = 0;
+    HTTPParser::TryExtractRequest(Bytes("GET /feed HTTP/1.1\r\nHost: x\r\n" + headers + "\r\n"),
+                                  request, consumed);
+    return request;
+}
+
+bool TestNotModified() {
+    std::cout << "Testing 304 decisions..." << std::endl;
+    HTTPParser::HTTPResponse response = HTTPParser::BuildSuccessResponse("application/atom+xml", Bytes("<feed/>"));
+    response.SetHeader("ETag", "\"abc\"");
+    response.SetHeader("Last-Modified", "Sun, 06 Nov 1994 08:49:37 GMT");
+    response.SetHeader("Cache-Control", "max-age=60");
+
+    ASSERT_TRUE(!HTTPParser::IsConditional(Request("")), "Plain GET");
+    ASSERT_TRUE(!HTTPParser::IsNotModified(Request(""), response), "Plain GET gets the body");
+    ASSERT_TRUE(HTTPParser::IsConditional(Request("If-None-Match: \"abc\"\r\n")), "Conditional");
+    ASSERT_TRUE(HTTPParser::IsNotModified(Request("If-None-Match: \"abc\"\r\n"), response), "Tag matches");
+    ASSERT_TRUE(HTTPParser::IsNotModified(Request("If-None-Match: \"x\", W/\"abc\"\r\n"), response),
+                "Weak match in a list");
+    ASSERT_TRUE(HTTPParser::IsNotModified(Request("If-None-Match: *\r\n"), response), "Any tag");
+    ASSERT_TRUE(!HTTPParser::IsNotModified(Request("If-None-Match: \"old\"\r\n"), response), "Tag differs");
+    // If-None-Match decides alone
+    ASSERT_TRUE(!HTTPParser::IsNotModified(Request("If-None-Match: \"old\"\r\n"
+                                                   "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n"),
+                                           response), "Date ignored beside a tag");
+
+    ASSERT_TRUE(HTTPParser::IsNotModified(Request("If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n"),
+                                          response), "Same date");
+    ASSERT_TRUE(HTTPParser::IsNotModified(Request("If-Modified-Since: Mon, 07 Nov 1994 00:00:00 GMT\r\n"),
+                                          response), "Later date");
+    ASSERT_TRUE(!HTTPParser::IsNotModified(Request("If-Modified-Since: Sat, 05 Nov 1994 00:00:00 GMT\r\n"),
+                                           response), "Modified since");
+    ASSERT_TRUE(!HTTPParser::IsNotModified(Request("If-Modified-Since: yesterday\r\n"), response),
+                "Unparseable date");
+
+    HTTPParser::HTTPResponse missing = HTTPParser::BuildSuccessResponse("text/plain", Bytes("gone"));
+    missing.status_code = 404;
+    missing.SetHeader("ETag", "\"abc\"");
+    ASSERT_TRUE(!HTTPParser::IsNotModified(Request("If-None-Match: \"abc\"\r\n"), missing), "Only 200");
+
+    HTTPParser::HTTPResponse not_modified = HTTPParser::BuildNotModifiedResponse(response);
+    ASSERT_EQ(not_modified.status_code, 304, "Status");
+    ASSERT_EQ(not_modified.GetHeader("etag"), std::string("\"abc\""), "ETag kept");
+    ASSERT_EQ(not_modified.GetHeader("Cache-Control"), std::string("max-age=60"), "Cache-Control kept");
+    ASSERT_TRUE(not_modified.GetHeader("Content-Length").empty(), "No Content-Length");
+    ASSERT_TRUE(not_modified.GetHeader("Content-Type").empty(), "No Content-Type");
+    ASSERT_EQ(not_modified.BodySize(), size_t(0), "No body");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " HTTP Parser Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestRequestView, "Request View");
+    run_test(TestPipelined, "Pipelined");
+    run_test(TestHeaderLimit, "Header Limit");
+    run_test(TestExtractRequest, "Extract Request");
+    run_test(TestValidators, "Validators");
+    run_test(TestNotModified, "Not Modified");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+/**
+ * test_image_variant_cache.cpp
+ *
+ * Unit tests for the device-sized image variant cache
+ * Tests resizing only images wider than asked, reuse per resource and
+ * width, resizing again when the source file changes, one resize for
+ * concurrent requests, and swapping the resize callback
+ */
+
+#include "lib/src/protocols/http/ImageVariantCache.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal JPEG: SOI, APP0, SOF0 with the given size, then `padding` bytes of scan data
+static std::vector<uint8_t> FakeJpeg(uint16_t width, uint16_t height, size_t padding) {
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8,
+        0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0,
+        0xFF, 0xC0, 0x00, 0x11, 0x08,
+        static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+        static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+        0x03, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+    jpeg.insert(jpeg.end(), padding, 0x11);
+    jpeg.push_back(0xFF);
+    jpeg.push_back(0xD9);
+    return jpeg;
+}
+
+// Resizer that "encodes" a small JPEG of the width asked for, counting calls
+struct FakeResizer {
+    std::shared_ptr<std::atomic<int>> calls = std::make_shared<std::atomic<int>>(0);
+    std::chrono::milliseconds delay{0};
+
+    ImageVariantCache::Resizer Get() const {
+        auto counter = calls;
+        auto wait = delay;
+        return [counter, wait](const uint8_t*, size_t, uint32_t width, uint8_t* out, size_t capacity) -> size_t {
+            (*counter)++;
+            std::this_thread::sleep_for(wait);
+            auto small = FakeJpeg(static_cast<uint16_t>(width), static_cast<uint16_t>(width / 2), 16);
+            if (small.size() > capacity) return 0;
+            std::memcpy(out, small.data(), small.size());
+            return small.size();
+        };
+    }
+};
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestResize() {
+    std::cout << "Testing resizing and reuse..." << std::endl;
+    ImageVariantCache cache;
+    FakeResizer resizer;
+    std::vector<uint8_t> original = FakeJpeg(1500, 1000, 4000);
+    std::string key = ImageVariantCache::MakeKey("artwork/abc", 480);
+
+    // No callback: sent as is, nothing remembered
+    ASSERT_FALSE(cache.CanResize(), "No resizer");
+    ASSERT_FALSE(cache.Get(key, "\"v1\"", original.data(), original.size(), 480), "Original without resizer");
+    ASSERT_FALSE(cache.Contains(key), "Nothing stored");
+
+    cache.SetResizer(resizer.Get());
+    ImageVariantCache::Variant variant = cache.Get(key, "\"v1\"", original.data(), original.size(), 480);
+    ASSERT_TRUE(variant != nullptr, "Resized");
+    uint32_t width = 0;
+    uint32_t height = 0;
+    ASSERT_TRUE(zune::ArtworkPipeline::JpegDimensions(variant->data(), variant->size(), width, height) &&
+                width == 480, "At the width asked for");
+    ASSERT_TRUE(cache.Contains(key), "Stored");
+
+    ASSERT_TRUE(cache.Get(key, "\"v1\"", original.data(), original.size(), 480) == variant, "Reused");
+    ASSERT_EQ(resizer.calls->load(), 1, "Resized once");
+
+    // Another width is another variant; a rewritten file is resized again
+    ASSERT_TRUE(cache.Get(ImageVariantCache::MakeKey("artwork/abc", 240), "\"v1\"",
+                          original.data(), original.size(), 240) != nullptr, "Second width");
+    ASSERT_TRUE(cache.Get(key, "\"v2\"", original.data(), original.size(), 480) != nullptr, "New source");
+    ASSERT_EQ(resizer.calls->load(), 3, "Resized per width and source");
+
+    // Narrow images are not resized, and that is remembered too
+    std::vector<uint8_t> narrow = FakeJpeg(480, 270, 4000);
+    std::string narrow_key = ImageVariantCache::MakeKey("devicebackgroundimage/def", 480);
+    ASSERT_FALSE(cache.Get(narrow_key, "\"n\"", narrow.data(), narrow.size(), 480), "Narrow sent as is");
+    ASSERT_FALSE(cache.Get(narrow_key, "\"n\"", narrow.data(), narrow.size(), 480), "Again");
+    ASSERT_TRUE(cache.Contains(narrow_key), "Remembered");
+    ASSERT_EQ(resizer.calls->load(), 3, "Resizer not called for narrow images");
+
+    ImageVariantCache::Stats stats = cache.GetStats();
+    ASSERT_EQ(stats.resized, uint64_t(3), "Resized counted");
+    ASSERT_EQ(stats.kept, uint64_t(1), "Kept counted");
+    ASSERT_EQ(stats.hits, uint64_t(2), "Hits counted");
+    ASSERT_EQ(stats.bytes_in, uint64_t(original.size() * 3), "Bytes in");
+    ASSERT_TRUE(stats.bytes_out < stats.bytes_in / 10, "Bytes out");
+
+    // A new callback drops what the old one made
+    FakeResizer other;
+    cache.SetResizer(other.Get());
+    ASSERT_FALSE(cache.Contains(key), "Cleared by a new resizer");
+    cache.SetResizer(nullptr);
+    ASSERT_FALSE(cache.CanResize(), "Disabled");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestConcurrentRequests() {
+    std::cout << "Testing one resize for concurrent requests..." << std::endl;
+    ImageVariantCache cache;
+    FakeResizer resizer;
+    resizer.delay = std::chrono::milliseconds(50);
+    cache.SetResizer(resizer.Get());
+    std::vector<uint8_t> original = FakeJpeg(1500, 1000, 4000);
+    std::string key = ImageVariantCache::MakeKey("artwork/abc", 480);
+
+    std::vector<ImageVariantCache::Variant> results(8);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < results.size(); i++) {
+        workers.emplace_back([&, i] {
+            results[i] = cache.Get(key, "\"v1\"", original.data(), original.size(), 480);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    ASSERT_EQ(resizer.calls->load(), 1, "Resized once");
+    for (const auto& result : results) {
+        ASSERT_TRUE(result != nullptr && result == results[0], "Every request got the same variant");
+    }
+    ImageVariantCache::Stats stats = cache.GetStats();
+    ASSERT_EQ(stats.misses, uint64_t(1), "One miss");
+    ASSERT_EQ(stats.hits, uint64_t(results.size() - 1), "The rest hits");
+    ASSERT_TRUE(stats.waits > 0, "Some waited");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestEviction() {
+    std::cout << "Testing the byte budget..." << std::endl;
+    FakeResizer resizer;
+    ImageVariantCache cache(8 * 100);
+    cache.SetResizer(resizer.Get());
+    std::vector<uint8_t> original = FakeJpeg(1500, 1000, 4000);
+
+    for (int i = 0; i < 20; i++) {
+        std::string key = ImageVariantCache::MakeKey("artwork/" + std::to_string(i), 480);
+        ASSERT_TRUE(cache.Get(key, "\"v\"", original.data(), original.size(), 480) != nullptr, "Resized");
+    }
+    ImageVariantCache::Stats stats = cache.GetStats();
+    ASSERT_TRUE(stats.bytes <= stats.capacity, "Within budget");
+    ASSERT_TRUE(stats.evictions > 0, "Evicted");
+    ASSERT_TRUE(cache.Contains(ImageVariantCache::MakeKey("artwork/19", 480)), "Newest kept");
+    ASSERT_FALSE(cache.Contains(ImageVariantCache::MakeKey("artwork/0", 480)), "Oldest dropped");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Image Variant Cache Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestResize, "Resize");
+    run_test(TestConcurrentRequests, "Concurrent Requests");
+    run_test(TestEviction, "Eviction");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
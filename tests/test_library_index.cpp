@@ -0,0 +1,174 @@
+/**
+ * test_library_index.cpp
+ *
+ * Unit tests for the ZuneMusicLibrary lookup indexes
+ * Tests album / artist / genre grouping, unset references and atom_id lookup
+ */
+
+#include "lib/src/ZuneLibraryIndex.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+// Nine tracks over three albums, two of them by one artist, interleaved so
+// the groups are not contiguous in the track array.
+struct Fixture {
+    std::vector<ZuneMusicTrack> tracks;
+    std::vector<ZuneMusicAlbum> albums;
+    ZuneMusicLibrary library{};
+
+    Fixture() {
+        const uint32_t album_of[] = {0x0601, 0x0602, 0x0601, 0x0603, 0x0602, 0x0601, 0, 0x0603, 0x0601};
+        const uint32_t genre_of[] = {0x0701, 0x0701, 0x0702, 0, 0x0701, 0x0702, 0x0702, 0x0701, 0x0701};
+        for (uint32_t i = 0; i < 9; i++) {
+            ZuneMusicTrack t{};
+            t.atom_id = 0x01000001 + i;
+            t.album_ref = album_of[i];
+            t.genre_ref = genre_of[i];
+            tracks.push_back(t);
+        }
+
+        const uint32_t artist_of[] = {0x0501, 0x0502, 0x0501};
+        for (uint32_t i = 0; i < 3; i++) {
+            ZuneMusicAlbum a{};
+            a.atom_id = 0x0601 + i;
+            a.artist_ref = artist_of[i];
+            albums.push_back(a);
+        }
+
+        library.tracks = tracks.data();
+        library.track_count = static_cast<uint32_t>(tracks.size());
+        library.albums = albums.data();
+        library.album_count = static_cast<uint32_t>(albums.size());
+    }
+};
+
+static std::vector<uint32_t> ToVector(const ZuneIndexRange& range) {
+    return std::vector<uint32_t>(range.indices, range.indices + range.count);
+}
+
+static std::string Join(const std::vector<uint32_t>& v) {
+    std::string s;
+    for (uint32_t x : v) {
+        s += (s.empty() ? "" : ",") + std::to_string(x);
+    }
+    return s;
+}
+
+bool TestGroupings() {
+    std::cout << "Testing album / artist / genre groupings..." << std::endl;
+
+    Fixture f;
+    zune::LibraryIndex index(f.library);
+
+    ASSERT_EQ(Join(ToVector(index.TracksForAlbum(0x0601))), std::string("0,2,5,8"), "Album 0x0601 tracks in device order");
+    ASSERT_EQ(Join(ToVector(index.TracksForAlbum(0x0602))), std::string("1,4"), "Album 0x0602 tracks");
+    ASSERT_EQ(Join(ToVector(index.TracksForAlbum(0x0603))), std::string("3,7"), "Album 0x0603 tracks");
+    ASSERT_EQ(Join(ToVector(index.AlbumsForArtist(0x0501))), std::string("0,2"), "Artist 0x0501 albums");
+    ASSERT_EQ(Join(ToVector(index.AlbumsForArtist(0x0502))), std::string("1"), "Artist 0x0502 albums");
+    ASSERT_EQ(Join(ToVector(index.TracksForGenre(0x0701))), std::string("0,1,4,7,8"), "Genre 0x0701 tracks");
+    ASSERT_EQ(Join(ToVector(index.TracksForGenre(0x0702))), std::string("2,5,6"), "Genre 0x0702 tracks");
+
+    // Each returned index points back at a matching record
+    ZuneIndexRange range = index.TracksForAlbum(0x0601);
+    for (uint32_t i = 0; i < range.count; i++) {
+        ASSERT_EQ(f.library.tracks[range.indices[i]].album_ref, uint32_t(0x0601), "Indexed track belongs to the album");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMissingKeys() {
+    std::cout << "Testing unknown and unset references..." << std::endl;
+
+    Fixture f;
+    zune::LibraryIndex index(f.library);
+
+    ZuneIndexRange none = index.TracksForAlbum(0x06FF);
+    ASSERT_EQ(none.count, uint32_t(0), "Unknown album");
+    ASSERT_TRUE(none.indices == nullptr, "Empty range has no indices");
+    ASSERT_EQ(index.TracksForAlbum(0).count, uint32_t(0), "Unset album_ref is not indexed");
+    ASSERT_EQ(index.TracksForGenre(0).count, uint32_t(0), "Unset genre_ref is not indexed");
+    ASSERT_EQ(index.AlbumsForArtist(0x05FF).count, uint32_t(0), "Unknown artist");
+
+    ZuneMusicLibrary empty{};
+    zune::LibraryIndex empty_index(empty);
+    ASSERT_EQ(empty_index.TracksForAlbum(0x0601).count, uint32_t(0), "Empty library");
+    ASSERT_EQ(empty_index.FindTrackByAtom(0x01000001), -1, "Empty library has no tracks");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFindTrackByAtom() {
+    std::cout << "Testing atom_id lookup..." << std::endl;
+
+    Fixture f;
+    zune::LibraryIndex index(f.library);
+
+    for (uint32_t i = 0; i < f.library.track_count; i++) {
+        ASSERT_EQ(index.FindTrackByAtom(f.library.tracks[i].atom_id), int32_t(i), "Track found by atom_id");
+    }
+    ASSERT_EQ(index.FindTrackByAtom(0x0601), -1, "Album atom is not a track");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Library Index Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestGroupings, "Album / Artist / Genre Groupings");
+    run_test(TestMissingKeys, "Unknown and Unset References");
+    run_test(TestFindTrackByAtom, "Track by atom_id");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
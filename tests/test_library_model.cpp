@@ -0,0 +1,420 @@
+/**
+ * test_library_model.cpp
+ *
+ * Unit tests for zune::LibraryModel, the host-side library kept current
+ * across uploads. Tests seeding, applying track/album/artist writes,
+ * user state refreshes, album references, deletions and taking deltas
+ */
+
+#include "lib/src/ZuneLibraryModel.h"
+#include <algorithm>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+static const uint32_t kArtistId = 0x05000001;
+static const uint32_t kGenreId = 0x07000001;
+static const uint32_t kAlbumAtom = 0x06000001;
+static const uint32_t kAlbumAlbObject = 0x0600A001;  // MTP handle of "Artist--Album.alb"
+
+static zmdb::ZMDBLibrary BuildLibrary() {
+    zmdb::ZMDBLibrary lib;
+    lib.device_family = zune::DeviceFamily::Pavo;
+
+    lib.tracks = static_cast<zmdb::ZMDBTrack*>(::operator new[](2 * sizeof(zmdb::ZMDBTrack)));
+    lib.track_count = lib.tracks_capacity = 2;
+    for (int i = 0; i < 2; i++) {
+        new (&lib.tracks[i]) zmdb::ZMDBTrack();
+        lib.tracks[i].title = "Track " + std::to_string(i + 1);
+        lib.tracks[i].artist_name = lib.strings.intern("Artist");
+        lib.tracks[i].track_number = i + 1;
+        lib.tracks[i].atom_id = 0x01000001 + i;
+        lib.tracks[i].album_ref = kAlbumAtom;
+        lib.tracks[i].album_alb_ref = lib.strings.intern("Artist--Album.alb");
+    }
+
+    zmdb::ZMDBAlbum album;
+    album.title = "Album";
+    album.artist_name = "Artist";
+    album.alb_reference = "Artist--Album.alb";
+    album.atom_id = kAlbumAtom;
+    lib.album_metadata[kAlbumAtom] = album;
+    lib.album_count = 1;
+
+    zmdb::ZMDBArtist artist;
+    artist.name = "Artist";
+    artist.guid = "11111111-2222-3333-4444-555555555555";
+    artist.atom_id = kArtistId;
+    lib.artist_metadata[kArtistId] = artist;
+    lib.artist_count = 1;
+
+    zmdb::ZMDBGenre genre;
+    genre.name = "Rock";
+    genre.atom_id = kGenreId;
+    lib.genre_metadata[kGenreId] = genre;
+
+    return lib;
+}
+
+static void Seed(zune::LibraryModel& model) {
+    model.Reset(BuildLibrary(), {{"Artist--Album.alb", kAlbumAlbObject}});
+}
+
+static zune::TrackProperties MakeTrack(const std::string& title, const std::string& album) {
+    zune::TrackProperties props;
+    props.title = title;
+    props.artist = "Artist";
+    props.album_name = album;
+    props.genre = "Rock";
+    props.duration_ms = 180000;
+    props.track_number = 3;
+    props.disc_number = 2;
+    props.artist_meta_id = kArtistId;
+    props.is_hd = true;
+    return props;
+}
+
+// Copy of the model's tracks, in device order
+static std::vector<zmdb::ZMDBTrack> Tracks(const zune::LibraryModel& model) {
+    std::vector<zmdb::ZMDBTrack> tracks;
+    model.Visit([&](const zmdb::ZMDBLibrary& lib, const zune::LibraryModel::AlbumArtworkMap&) {
+        tracks.assign(lib.tracks, lib.tracks + lib.track_count);
+    });
+    return tracks;
+}
+
+bool TestUnseeded() {
+    std::cout << "Testing unseeded model..." << std::endl;
+
+    zune::LibraryModel model;
+    model.TrackCreated(0x01000010, MakeTrack("New", "Album"), 0x3009, 1000);
+
+    ASSERT_FALSE(model.HasLibrary(), "Writes alone do not seed the model");
+    zune::LibraryDelta delta;
+    ASSERT_FALSE(model.TakeDelta(delta), "No delta before Reset");
+    bool visited = false;
+    ASSERT_FALSE(model.Visit([&](const zmdb::ZMDBLibrary&, const zune::LibraryModel::AlbumArtworkMap&) {
+        visited = true;
+    }), "Visit fails before Reset");
+    ASSERT_FALSE(visited, "Visitor not called");
+
+    Seed(model);
+    ASSERT_TRUE(model.HasLibrary(), "Seeded");
+    model.Clear();
+    ASSERT_FALSE(model.HasLibrary(), "Clear drops the library");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestTrackCreated() {
+    std::cout << "Testing track creation..." << std::endl;
+
+    zune::LibraryModel model;
+    Seed(model);
+
+    // More tracks than the seeded capacity, so the array has to grow
+    for (uint32_t i = 0; i < 20; i++) {
+        zune::TrackProperties props = MakeTrack("New " + std::to_string(i), "Album");
+        props.rating = 8;
+        model.TrackCreated(0x01000010 + i, props, 0x3009, 4000000);
+    }
+
+    auto tracks = Tracks(model);
+    ASSERT_EQ(tracks.size(), size_t(22), "Seeded tracks plus uploads");
+    ASSERT_EQ(tracks[0].title, std::string("Track 1"), "Seeded tracks keep their place");
+
+    const zmdb::ZMDBTrack& t = tracks[2];
+    ASSERT_EQ(t.title, std::string("New 0"), "Title");
+    ASSERT_EQ(t.atom_id, uint32_t(0x01000010), "atom_id is the MTP handle");
+    ASSERT_EQ(t.artist_name.str(), std::string("Artist"), "Artist");
+    ASSERT_EQ(t.artist_guid.str(), std::string("11111111-2222-3333-4444-555555555555"), "Artist GUID from artist_meta_id");
+    ASSERT_EQ(t.genre.str(), std::string("Rock"), "Genre");
+    ASSERT_EQ(t.genre_ref, kGenreId, "Genre resolved by name");
+    ASSERT_EQ(t.album_ref, kAlbumAtom, "Filed under the existing album");
+    ASSERT_EQ(t.album_alb_ref.str(), std::string("Artist--Album.alb"), "Album .alb reference");
+    ASSERT_EQ(t.disc_number, 2, "HD disc number");
+    ASSERT_EQ(t.duration_ms, 180000, "Duration");
+    ASSERT_EQ(t.file_size_bytes, 4000000, "File size");
+    ASSERT_EQ(t.codec_id, uint16_t(0x3009), "Format code");
+    ASSERT_EQ(int(t.rating), 8, "Rating");
+    ASSERT_TRUE(t.artist_name.identity() == tracks[0].artist_name.identity(), "Artist interned with the parsed tracks");
+
+    zune::LibraryDelta delta;
+    ASSERT_TRUE(model.TakeDelta(delta), "Delta available");
+    ASSERT_EQ(delta.changed.track_count, 20, "Delta holds only the new tracks");
+    ASSERT_TRUE(delta.removed.empty(), "Nothing removed");
+
+    ASSERT_TRUE(model.TakeDelta(delta), "Second delta");
+    ASSERT_EQ(delta.changed.track_count, 0, "Taking a delta starts a new one");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestTrackPropertiesUpdated() {
+    std::cout << "Testing track property updates..." << std::endl;
+
+    zune::LibraryModel model;
+    Seed(model);
+
+    zune::TrackProperties props = MakeTrack("Renamed", "");
+    props.is_hd = false;
+    model.TrackPropertiesUpdated(0x01000002, props);
+    model.TrackPropertiesUpdated(0x0100FFFF, props);  // Unknown track: ignored
+
+    auto tracks = Tracks(model);
+    ASSERT_EQ(tracks.size(), size_t(2), "No track added");
+    ASSERT_EQ(tracks[1].title, std::string("Renamed"), "Title updated");
+    ASSERT_EQ(tracks[1].track_number, 3, "Track number updated");
+    ASSERT_EQ(tracks[1].disc_number, 1, "Classic update leaves the disc number");
+    ASSERT_EQ(tracks[1].album_ref, kAlbumAtom, "Album link untouched");
+    ASSERT_EQ(tracks[1].artist_guid.str(), std::string("11111111-2222-3333-4444-555555555555"),
+              "Classic artist GUID resolved by name");
+
+    zune::LibraryDelta delta;
+    ASSERT_TRUE(model.TakeDelta(delta), "Delta available");
+    ASSERT_EQ(delta.changed.track_count, 1, "One track changed");
+    ASSERT_EQ(delta.changed.tracks[0].atom_id, uint32_t(0x01000002), "Changed track");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestUserStatesRead() {
+    std::cout << "Testing user state refresh..." << std::endl;
+
+    zune::LibraryModel model;
+    ASSERT_EQ(model.UserStatesRead({{0x01000001, 5, 8}}), size_t(0), "Unseeded model ignores states");
+    Seed(model);
+
+    std::vector<zune::TrackUserState> states = {
+        {0x01000001, 5, 8},     // Both changed
+        {0x01000002, 0, -1},    // Unchanged play count, rating not reported
+        {0x0600A001, 3, -1},    // Not a track: ignored
+    };
+    ASSERT_EQ(model.UserStatesRead(states), size_t(1), "One track changed");
+
+    auto tracks = Tracks(model);
+    ASSERT_EQ(tracks[0].playcount, uint16_t(5), "Play count merged");
+    ASSERT_EQ(tracks[0].rating, uint8_t(8), "Rating merged");
+    ASSERT_EQ(tracks[0].title, std::string("Track 1"), "Other fields untouched");
+    ASSERT_EQ(tracks[1].playcount, uint16_t(0), "Unchanged track");
+
+    zune::LibraryDelta delta;
+    ASSERT_TRUE(model.TakeDelta(delta), "Delta available");
+    ASSERT_EQ(delta.changed.track_count, 1, "Only the changed track in the delta");
+    ASSERT_EQ(delta.changed.tracks[0].atom_id, uint32_t(0x01000001), "Changed track");
+
+    ASSERT_EQ(model.UserStatesRead(states), size_t(0), "Same states again change nothing");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestNewAlbum() {
+    std::cout << "Testing new album and references..." << std::endl;
+
+    zune::LibraryModel model;
+    Seed(model);
+
+    const uint32_t album_id = 0x0600A002;
+    zune::AlbumProperties album;
+    album.artist = "Artist";
+    album.album_name = "Second";
+    album.date_authored = "20091015T000000.0";
+    album.artist_meta_id = kArtistId;
+    album.is_hd = true;
+    model.AlbumCreated(album_id, album);
+
+    const uint32_t track_ids[] = {0x01000010, 0x01000011};
+    model.TrackCreated(track_ids[0], MakeTrack("A", "Second"), 0x3009, 1000);
+    model.TrackCreated(track_ids[1], MakeTrack("B", "Second"), 0x3009, 1000);
+    model.AlbumReferencesSet(album_id, track_ids, 2);
+
+    bool album_ok = false;
+    model.Visit([&](const zmdb::ZMDBLibrary& lib, const zune::LibraryModel::AlbumArtworkMap& artworks) {
+        auto it = lib.album_metadata.find(album_id);
+        auto artwork = artworks.find("Artist--Second.alb");
+        album_ok = it != lib.album_metadata.end() &&
+                   it->second.alb_reference == "Artist--Second.alb" &&
+                   it->second.release_year == 2009 &&
+                   it->second.artist_guid == "11111111-2222-3333-4444-555555555555" &&
+                   artwork != artworks.end() && artwork->second == album_id &&
+                   lib.album_count == 2;
+    });
+    ASSERT_TRUE(album_ok, "Album added with .alb name, year, artist GUID and artwork entry");
+
+    auto tracks = Tracks(model);
+    ASSERT_EQ(tracks.size(), size_t(4), "Tracks added");
+    ASSERT_EQ(tracks[2].album_ref, album_id, "New album linked by its handle");
+    ASSERT_EQ(tracks[3].album_alb_ref.str(), std::string("Artist--Second.alb"), "New album .alb reference");
+
+    zune::LibraryDelta delta;
+    ASSERT_TRUE(model.TakeDelta(delta), "Delta available");
+    ASSERT_EQ(delta.changed.album_count, 1, "One album in the delta");
+    ASSERT_TRUE(delta.changed.album_metadata.count(album_id) == 1, "New album in the delta");
+    ASSERT_EQ(delta.alb_to_objectid.size(), size_t(1), "Artwork entry for the new album");
+    ASSERT_EQ(delta.changed.track_count, 2, "Tracks in the delta");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestExistingAlbumByArtworkHandle() {
+    std::cout << "Testing writes addressed by .alb handle..." << std::endl;
+
+    zune::LibraryModel model;
+    Seed(model);
+
+    // Parsed albums are addressed by their .alb ObjectId, not the ZMDB atom
+    zune::AlbumProperties album;
+    album.artist = "Artist";
+    album.album_name = "Album (Remastered)";
+    model.AlbumPropertiesUpdated(kAlbumAlbObject, album);
+
+    model.TrackCreated(0x01000010, MakeTrack("Bonus", "Other"), 0x3009, 1000);
+    const uint32_t track_id = 0x01000010;
+    model.AlbumReferencesSet(kAlbumAlbObject, &track_id, 1);
+
+    std::string title;
+    model.Visit([&](const zmdb::ZMDBLibrary& lib, const zune::LibraryModel::AlbumArtworkMap&) {
+        title = lib.album_metadata.at(kAlbumAtom).title;
+    });
+    ASSERT_EQ(title, std::string("Album (Remastered)"), "Album found through the artwork map");
+
+    auto tracks = Tracks(model);
+    ASSERT_EQ(tracks[2].album_ref, kAlbumAtom, "Track linked to the ZMDB album atom");
+
+    zune::LibraryDelta delta;
+    ASSERT_TRUE(model.TakeDelta(delta), "Delta available");
+    ASSERT_TRUE(delta.changed.album_metadata.count(kAlbumAtom) == 1, "Updated album in the delta");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDeletions() {
+    std::cout << "Testing deletions..." << std::endl;
+
+    zune::LibraryModel model;
+    Seed(model);
+
+    model.ArtistCreated(0x05000002, "Other", "aaaaaaaa-bbbb-cccc-dddd-eeeeeeeeeeee");
+    model.TrackCreated(0x01000010, MakeTrack("New", "Album"), 0x3009, 1000);
+
+    model.ObjectDeleted(0x01000001);      // Seeded track
+    model.ObjectDeleted(0x01000010);      // Track uploaded since the last delta
+    model.ObjectDeleted(kAlbumAlbObject); // Seeded album, by .alb handle
+    model.ObjectDeleted(0x05000002);      // New artist
+    model.ObjectDeleted(0x0900FFFF);      // Not in the library
+
+    auto tracks = Tracks(model);
+    ASSERT_EQ(tracks.size(), size_t(1), "Two tracks removed");
+    ASSERT_EQ(tracks[0].atom_id, uint32_t(0x01000002), "Remaining track");
+
+    // Index still valid after the shift
+    zune::TrackProperties props = MakeTrack("Still here", "");
+    model.TrackPropertiesUpdated(0x01000002, props);
+    ASSERT_EQ(Tracks(model)[0].title, std::string("Still here"), "Update after removal");
+
+    bool album_gone = false;
+    model.Visit([&](const zmdb::ZMDBLibrary& lib, const zune::LibraryModel::AlbumArtworkMap& artworks) {
+        album_gone = lib.album_metadata.empty() && artworks.empty() && lib.album_count == 0 &&
+                     lib.artist_metadata.size() == 1;
+    });
+    ASSERT_TRUE(album_gone, "Album, artwork entry and artist removed");
+
+    zune::LibraryDelta delta;
+    ASSERT_TRUE(model.TakeDelta(delta), "Delta available");
+    ASSERT_EQ(delta.removed.size(), size_t(4), "Four records removed");
+    ASSERT_TRUE(std::find(delta.removed.begin(), delta.removed.end(), kAlbumAtom) != delta.removed.end(),
+                "Album reported by its ZMDB atom");
+    ASSERT_EQ(delta.changed.track_count, 1, "Only the updated track remains changed");
+    ASSERT_EQ(delta.changed.artist_count, 0, "Deleted artist dropped from the changes");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestResetDiscardsDelta() {
+    std::cout << "Testing reset discards pending changes..." << std::endl;
+
+    zune::LibraryModel model;
+    Seed(model);
+    model.TrackCreated(0x01000010, MakeTrack("New", "Album"), 0x3009, 1000);
+    model.ObjectDeleted(0x01000001);
+
+    Seed(model);
+    zune::LibraryDelta delta;
+    ASSERT_TRUE(model.TakeDelta(delta), "Delta available");
+    ASSERT_EQ(delta.changed.track_count, 0, "No changed tracks");
+    ASSERT_TRUE(delta.removed.empty(), "No removals");
+    ASSERT_EQ(Tracks(model).size(), size_t(2), "Fresh library");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Library Model Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestUnseeded, "Unseeded Model");
+    run_test(TestTrackCreated, "Track Creation");
+    run_test(TestTrackPropertiesUpdated, "Track Property Updates");
+    run_test(TestUserStatesRead, "User State Refresh");
+    run_test(TestNewAlbum, "New Album and References");
+    run_test(TestExistingAlbumByArtworkHandle, "Writes Addressed by .alb Handle");
+    run_test(TestDeletions, "Deletions");
+    run_test(TestResetDiscardsDelta, "Reset Discards Pending Changes");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+/**
+ * test_logger.cpp
+ *
+ * Unit tests for zune::Logger
+ * Tests level gating per category (a disabled line is never built), delivery
+ * order and the source prefix, Flush, dropping when the sink falls behind,
+ * and swapping the sink while lines are queued
+ */
+
+#include "lib/src/ZuneLog.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+// Sink collecting the lines it is given
+struct Collected {
+    std::mutex mutex;
+    std::vector<std::string> lines;
+
+    zune::Logger::Sink Sink() {
+        return [this](const std::string& message) {
+            std::lock_guard<std::mutex> lock(mutex);
+            lines.push_back(message);
+        };
+    }
+
+    std::vector<std::string> Take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::move(lines);
+    }
+};
+
+static std::string Built(int& builds, const std::string& text) {
+    builds++;
+    return text;
+}
+
+bool TestLevels() {
+    std::cout << "Testing levels per category..." << std::endl;
+    zune::Logger logger;
+    Collected collected;
+    int builds = 0;
+
+    // Nothing is built without a sink, even at ERROR
+    ZUNE_LOG(&logger, nullptr, MTP, ERROR, Built(builds, "no sink"));
+    ASSERT_EQ(builds, 0, "Not built without a sink");
+
+    logger.SetSink(collected.Sink());
+    ASSERT_EQ(logger.GetLevel(ZUNE_LOG_TCP), ZUNE_LOG_INFO, "INFO by default");
+    ZUNE_LOG(&logger, nullptr, TCP, DEBUG, Built(builds, "tcp debug"));
+    ASSERT_EQ(builds, 0, "DEBUG not built at INFO");
+    ASSERT_FALSE(ZUNE_LOG_ENABLED(&logger, TCP, DEBUG), "DEBUG disabled");
+
+    logger.SetLevel(ZUNE_LOG_TCP, ZUNE_LOG_DEBUG);
+    logger.SetLevel(ZUNE_LOG_MTP, ZUNE_LOG_ERROR);
+    ZUNE_LOG(&logger, nullptr, TCP, DEBUG, Built(builds, "tcp debug"));
+    ZUNE_LOG(&logger, nullptr, MTP, WARNING, Built(builds, "mtp warning"));
+    ZUNE_LOG(&logger, nullptr, MTP, ERROR, Built(builds, "mtp error"));
+    ZUNE_LOG(&logger, nullptr, PPP, DEBUG, Built(builds, "ppp debug"));
+    ASSERT_EQ(builds, 2, "Only enabled lines built");
+
+    logger.SetLevel(ZUNE_LOG_DEBUG);
+    ASSERT_TRUE(ZUNE_LOG_ENABLED(&logger, PPP, DEBUG), "All categories set");
+
+    zune::Logger* none = nullptr;
+    ZUNE_LOG(none, nullptr, MTP, ERROR, Built(builds, "null logger"));
+    ASSERT_FALSE(ZUNE_LOG_ENABLED(none, MTP, ERROR), "Null logger disabled");
+    ASSERT_EQ(builds, 2, "Null logger builds nothing");
+
+    logger.Flush();
+    std::vector<std::string> lines = collected.Take();
+    ASSERT_EQ(lines.size(), size_t(2), "Delivered");
+    ASSERT_EQ(lines[0], std::string("tcp debug"), "First line");
+    ASSERT_EQ(lines[1], std::string("mtp error"), "Second line");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestOrderAndSource() {
+    std::cout << "Testing order and source prefix..." << std::endl;
+    Collected collected;
+    {
+        zune::Logger logger;
+        logger.SetSink(collected.Sink());
+        for (int i = 0; i < 1000; i++) {
+            ZUNE_LOG(&logger, (i % 2 ? "Odd" : nullptr), HTTP, INFO, std::to_string(i));
+        }
+        // Destruction delivers what is still queued
+    }
+
+    std::vector<std::string> lines = collected.Take();
+    ASSERT_EQ(lines.size(), size_t(1000), "All delivered");
+    for (int i = 0; i < 1000; i++) {
+        std::string expected = (i % 2 ? "[Odd] " : "") + std::to_string(i);
+        ASSERT_EQ(lines[i], expected, "Line " + std::to_string(i));
+    }
+
+    zune::Logger logger;
+    logger.SetSink(collected.Sink());
+    auto callback = zune::LogCallbackFor(&logger, ZUNE_LOG_TCP, ZUNE_LOG_DEBUG);
+    callback("dropped at INFO");
+    logger.SetLevel(ZUNE_LOG_TCP, ZUNE_LOG_DEBUG);
+    callback("kept at DEBUG");
+    logger.Flush();
+    lines = collected.Take();
+    ASSERT_EQ(lines.size(), size_t(1), "Callback gated on the level");
+    ASSERT_EQ(lines[0], std::string("kept at DEBUG"), "Callback line");
+    ASSERT_FALSE(static_cast<bool>(zune::LogCallbackFor(nullptr, ZUNE_LOG_TCP, ZUNE_LOG_INFO)),
+                 "No callback without a logger");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestSlowSinkDrops() {
+    std::cout << "Testing a slow sink..." << std::endl;
+    zune::Logger logger;
+    std::atomic<bool> release{false};
+    Collected collected;
+    auto inner = collected.Sink();
+    logger.SetSink([&](const std::string& message) {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        inner(message);
+    });
+
+    // The writer is never held up by the blocked sink
+    size_t total = zune::Logger::kMaxQueued * 2;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < total; i++) {
+        ZUNE_LOG(&logger, nullptr, PPP, INFO, "line");
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(elapsed < std::chrono::seconds(5), "Writes did not wait on the sink");
+
+    release.store(true);
+    logger.Flush();
+
+    zune::Logger::Stats stats = logger.GetStats();
+    ASSERT_TRUE(stats.dropped > 0, "Some dropped");
+    ASSERT_EQ(stats.written + stats.dropped, uint64_t(total), "Every line counted");
+    ASSERT_EQ(stats.delivered, stats.written, "Queued lines delivered");
+
+    std::vector<std::string> lines = collected.Take();
+    ASSERT_EQ(lines.size(), size_t(stats.delivered + 1), "Lines plus the drop note");
+    ASSERT_EQ(lines.back(), "[log] " + std::to_string(stats.dropped) +
+              " lines dropped, the log callback fell behind", "Drop note");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestSinkSwap() {
+    std::cout << "Testing sink swaps with concurrent writers..." << std::endl;
+    zune::Logger logger;
+    Collected first;
+    Collected second;
+    logger.SetSink(first.Sink());
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&] {
+            while (!stop.load()) {
+                ZUNE_LOG(&logger, "Writer", TCP, INFO, "line");
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    logger.SetSink(second.Sink());
+    size_t after_swap = first.Take().size();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_EQ(first.Take().size(), size_t(0), "Old sink not called after the swap");
+    ASSERT_TRUE(after_swap > 0, "Old sink got lines before the swap");
+
+    // A sink may replace itself
+    logger.SetSink([&](const std::string&) { logger.SetSink(second.Sink()); });
+    stop.store(true);
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    ZUNE_LOG(&logger, nullptr, TCP, INFO, "last");
+    logger.Flush();
+    ASSERT_TRUE(second.Take().size() > 0, "New sink got lines");
+
+    logger.SetSink(nullptr);
+    ASSERT_FALSE(ZUNE_LOG_ENABLED(&logger, MTP, ERROR), "Disabled without a sink");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Logger Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestLevels, "Levels");
+    run_test(TestOrderAndSource, "Order And Source");
+    run_test(TestSlowSinkDrops, "Slow Sink Drops");
+    run_test(TestSinkSwap, "Sink Swap");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/**
+ * test_loop_completion_queue.cpp
+ *
+ * Unit tests for LoopCompletionQueue
+ * Tests posting order, outstanding work, items posted while draining,
+ * Clear, and workers posting while the loop drains
+ */
+
+#include "lib/src/protocols/http/LoopCompletionQueue.h"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestPostAndDrain() {
+    std::cout << "Testing posting order and outstanding work..." << std::endl;
+    LoopCompletionQueue<int> queue;
+    std::vector<int> ran;
+    ASSERT_EQ(queue.Drain([&](int& item) { ran.push_back(item); }), size_t(0), "Nothing posted");
+
+    queue.Begin();
+    queue.Begin();
+    queue.Begin();
+    ASSERT_EQ(queue.Outstanding(), size_t(3), "Three offloaded");
+    ASSERT_FALSE(queue.Ready(), "None finished");
+
+    queue.Post(2);
+    queue.Post(1);
+    ASSERT_TRUE(queue.Ready(), "Two finished");
+    ASSERT_EQ(queue.Drain([&](int& item) { ran.push_back(item); }), size_t(2), "Both run");
+    ASSERT_TRUE(ran == std::vector<int>({2, 1}), "In posting order");
+    ASSERT_EQ(queue.Outstanding(), size_t(1), "One still out");
+    ASSERT_FALSE(queue.Ready(), "Drained");
+
+    queue.Post(3);
+    queue.Drain([&](int& item) { ran.push_back(item); });
+    ASSERT_EQ(queue.Outstanding(), size_t(0), "All back");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPostWhileDraining() {
+    std::cout << "Testing items posted while draining..." << std::endl;
+    LoopCompletionQueue<int> queue;
+    std::vector<int> ran;
+    queue.Begin();
+    queue.Begin();
+    queue.Post(1);
+
+    // An item's handler offloading and finishing more work waits a cycle
+    size_t n = queue.Drain([&](int& item) {
+        ran.push_back(item);
+        queue.Post(2);
+    });
+    ASSERT_EQ(n, size_t(1), "Only what was posted before");
+    ASSERT_TRUE(queue.Ready(), "The new item waits");
+    queue.Drain([&](int& item) { ran.push_back(item); });
+    ASSERT_TRUE(ran == std::vector<int>({1, 2}), "Next cycle");
+
+    queue.Begin();
+    queue.Post(3);
+    queue.Clear();
+    ASSERT_FALSE(queue.Ready(), "Cleared");
+    ASSERT_EQ(queue.Outstanding(), size_t(0), "Nothing outstanding");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestConcurrentWorkers() {
+    std::cout << "Testing workers posting while the loop drains..." << std::endl;
+    constexpr int kWorkers = 4;
+    constexpr int kPerWorker = 2000;
+    LoopCompletionQueue<int> queue;
+    for (int i = 0; i < kWorkers * kPerWorker; i++) {
+        queue.Begin();
+    }
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < kWorkers; w++) {
+        workers.emplace_back([&, w] {
+            for (int i = 0; i < kPerWorker; i++) {
+                queue.Post(w * kPerWorker + i);
+            }
+        });
+    }
+
+    // The loop: each worker's items must come back in its own order
+    std::vector<int> last(kWorkers, -1);
+    bool ordered = true;
+    size_t drained = 0;
+    while (queue.Outstanding() > 0) {
+        drained += queue.Drain([&](int& item) {
+            int w = item / kPerWorker;
+            ordered = ordered && item > last[w];
+            last[w] = item;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    ASSERT_EQ(drained, size_t(kWorkers * kPerWorker), "Every item drained once");
+    ASSERT_TRUE(ordered, "Per-worker order kept");
+    ASSERT_FALSE(queue.Ready(), "Nothing left");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Loop Completion Queue Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestPostAndDrain, "Post And Drain");
+    run_test(TestPostWhileDraining, "Post While Draining");
+    run_test(TestConcurrentWorkers, "Concurrent Workers");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/**
+ * test_media_scanner.cpp
+ *
+ * Unit tests for the host media scanner
+ * Tests the folder walk, the worker pool, the path/mtime tag cache and
+ * the TagLib reader's fallbacks for files without readable tags
+ */
+
+#include "lib/src/ZuneMediaScanner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::MediaScanner;
+using zune::ScannedTrack;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_media_scanner";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+static std::string WriteFile(const std::string& dir, const std::string& name, const std::string& contents) {
+    auto path = std::filesystem::path(dir) / name;
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+    return path.string();
+}
+
+// Stand-in for TagLib: the file holds "title|artist|album", "fail" is unreadable
+static MediaScanner::TagReader CountingReader(std::atomic<int>& calls) {
+    return [&calls](const std::string& path, bool, ScannedTrack& out) {
+        calls++;
+        std::ifstream file(path, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (text == "fail") return false;
+        size_t a = text.find('|');
+        size_t b = text.find('|', a + 1);
+        out.track.filename = std::filesystem::path(path).filename().string();
+        out.track.title = text.substr(0, a);
+        out.track.artist = text.substr(a + 1, b - a - 1);
+        out.track.album_name = text.substr(b + 1);
+        out.track.track_number = static_cast<uint16_t>(text.size());
+        out.year = 1999;
+        out.tagged = true;
+        return true;
+    };
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestScan() {
+    std::cout << "Testing folder walk..." << std::endl;
+    std::string dir = TempDir();
+    for (int i = 0; i < 20; i++)
+        WriteFile(dir, "Artist/Album/" + std::to_string(100 + i) + ".mp3", "T" + std::to_string(i) + "|Artist|Album");
+    WriteFile(dir, "Other/b.FLAC", "B|Other|Second");
+    WriteFile(dir, "Other/cover.jpg", "not audio");
+    WriteFile(dir, "Other/broken.wma", "fail");
+
+    std::atomic<int> calls{0};
+    MediaScanner::Options options;
+    options.worker_threads = 4;
+    options.read = CountingReader(calls);
+    MediaScanner scanner(options);
+
+    size_t progress_calls = 0;
+    size_t last_done = 0;
+    auto tracks = scanner.Scan(dir, [&](size_t done, size_t total) {
+        progress_calls++;
+        last_done = std::max(last_done, done);
+        (void)total;
+    });
+
+    ASSERT_EQ(tracks.size(), size_t(21), "Audio files found, unreadable one left out");
+    ASSERT_EQ(calls.load(), 22, "Every audio file parsed once");
+    ASSERT_EQ(progress_calls, size_t(22), "Progress per parsed file");
+    ASSERT_EQ(last_done, size_t(22), "Progress reaches the total");
+    for (size_t i = 1; i < tracks.size(); i++)
+        ASSERT_TRUE(tracks[i - 1].path < tracks[i].path, "Sorted by path");
+
+    ASSERT_EQ(tracks[0].track.title, std::string("T0"), "First track title");
+    ASSERT_TRUE(tracks[0].file_size > 0, "File size recorded");
+    ASSERT_EQ(tracks.back().track.album_name, std::string("Second"), "Upper-case extension accepted");
+
+    MediaScanner::Stats stats = scanner.GetStats();
+    ASSERT_EQ(stats.files, uint64_t(22), "Files counted");
+    ASSERT_EQ(stats.parsed, uint64_t(21), "Parsed counted");
+    ASSERT_EQ(stats.failed, uint64_t(1), "Failure counted");
+    ASSERT_EQ(stats.cache_hits, uint64_t(0), "No cache");
+
+    // A single file is scanned on its own, from the scanner's memory
+    calls = 0;
+    auto single = scanner.Scan(dir + "/Other/b.FLAC");
+    ASSERT_EQ(single.size(), size_t(1), "Single file");
+    ASSERT_EQ(calls.load(), 0, "Single file remembered");
+    ASSERT_EQ(scanner.GetStats().cache_hits, uint64_t(1), "Single file cache hit");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestCache() {
+    std::cout << "Testing the path/mtime cache..." << std::endl;
+    std::string dir = TempDir();
+    std::string music = dir + "/music";
+    std::string cache = dir + "/cache/tags.xzscan";
+    WriteFile(music, "a.mp3", "A|X|Y");
+    std::string b = WriteFile(music, "b.mp3", "B|X|Y");
+    WriteFile(music, "c.mp3", "C|X|Y");
+    WriteFile(dir, "elsewhere/d.mp3", "D|X|Y");
+
+    std::atomic<int> calls{0};
+    MediaScanner::Options options;
+    options.read = CountingReader(calls);
+    {
+        MediaScanner scanner(options);
+        scanner.OpenCache(cache);
+        ASSERT_EQ(scanner.Scan(music).size(), size_t(3), "First scan");
+        ASSERT_EQ(scanner.Scan(dir + "/elsewhere").size(), size_t(1), "Second root");
+        ASSERT_EQ(calls.load(), 4, "All parsed the first time");
+    }
+    ASSERT_TRUE(std::filesystem::exists(cache), "Cache written by Scan");
+
+    // A new scanner answers unchanged files from disk
+    calls = 0;
+    MediaScanner scanner(options);
+    scanner.OpenCache(cache);
+    auto tracks = scanner.Scan(music);
+    ASSERT_EQ(tracks.size(), size_t(3), "Rescan");
+    ASSERT_EQ(calls.load(), 0, "Nothing reparsed");
+    ASSERT_EQ(scanner.GetStats().cache_hits, uint64_t(3), "Cache hits");
+    ASSERT_EQ(tracks[1].track.title, std::string("B"), "Cached title");
+    ASSERT_EQ(tracks[1].year, 1999u, "Cached year");
+    ASSERT_TRUE(tracks[1].tagged, "Cached flags");
+
+    // Changed and removed files
+    WriteFile(music, "a.mp3", "A2|X|Longer album");
+    auto old_time = std::filesystem::last_write_time(b);
+    WriteFile(music, "b.mp3", "Q|X|Y");
+    std::filesystem::last_write_time(b, old_time + std::chrono::seconds(5));
+    std::filesystem::remove(music + "/c.mp3");
+    tracks = scanner.Scan(music);
+    ASSERT_EQ(tracks.size(), size_t(2), "Removed file gone");
+    ASSERT_EQ(calls.load(), 2, "Changed size and changed mtime reparsed");
+    ASSERT_EQ(tracks[0].track.title, std::string("A2"), "New tags");
+    ASSERT_EQ(tracks[1].track.title, std::string("Q"), "Same size, new mtime");
+    ASSERT_EQ(scanner.GetStats().dropped, uint64_t(1), "Removed file dropped");
+    scanner.CloseCache();
+
+    // The other root's entry survives the drop
+    calls = 0;
+    MediaScanner again(options);
+    again.OpenCache(cache);
+    ASSERT_EQ(again.Scan(dir + "/elsewhere").size(), size_t(1), "Other root");
+    ASSERT_EQ(calls.load(), 0, "Other root still cached");
+
+    // Asking for artwork reparses entries cached without it
+    options.read_artwork = true;
+    MediaScanner with_art(options);
+    with_art.OpenCache(cache);
+    calls = 0;
+    with_art.Scan(music);
+    ASSERT_EQ(calls.load(), 2, "Artwork probe reparses");
+
+    // A foreign file is ignored
+    WriteFile(dir, "cache/bad.xzscan", "garbage");
+    MediaScanner fresh(MediaScanner::Options{1, false, CountingReader(calls)});
+    fresh.OpenCache(dir + "/cache/bad.xzscan");
+    calls = 0;
+    fresh.Scan(music);
+    ASSERT_EQ(calls.load(), 2, "Foreign cache ignored");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestTagLibFallbacks() {
+    std::cout << "Testing TagLib reader fallbacks..." << std::endl;
+    std::string dir = TempDir();
+    std::string path = WriteFile(dir, "Untagged Song.mp3", std::string(512, '\0'));
+
+    ScannedTrack t;
+    ASSERT_TRUE(MediaScanner::ReadTags(path, true, t), "Existing file reads");
+    ASSERT_EQ(t.track.title, std::string("Untagged Song"), "Title from stem");
+    ASSERT_EQ(t.track.filename, std::string("Untagged Song.mp3"), "Filename");
+    ASSERT_TRUE(t.track.artist.empty(), "Artist left empty");
+    ASSERT_EQ(t.track.date_authored, std::string("20000101T160100.0"), "Default track date");
+    ASSERT_EQ(t.album.date_authored, std::string("20000102T000100.0"), "Default album date");
+    ASSERT_EQ(t.artwork_size, 0u, "No cover");
+    ASSERT_TRUE(MediaScanner::ExtractArtwork(path).empty(), "No cover bytes");
+
+    ASSERT_FALSE(MediaScanner::ReadTags(dir + "/missing.mp3", false, t), "Missing file");
+
+    ASSERT_EQ(MediaScanner::TrackDate(1987), std::string("19870101T160100.0"), "Track date");
+    ASSERT_EQ(MediaScanner::AlbumDate(2009), std::string("20090102T000100.0"), "Album date");
+    ASSERT_TRUE(MediaScanner::IsAudioFile("x/Song.M4A"), "Extension case");
+    ASSERT_FALSE(MediaScanner::IsAudioFile("x/folder.jpg"), "Image");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Media Scanner Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestScan, "Scan");
+    run_test(TestCache, "Cache");
+    run_test(TestTagLibFallbacks, "TagLib Fallbacks");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_media_scanner");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
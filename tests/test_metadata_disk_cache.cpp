@@ -0,0 +1,215 @@
+/**
+ * test_metadata_disk_cache.cpp
+ *
+ * Unit tests for MetadataDiskCache
+ * Tests store and lookup, shared blobs, persistence across Open, TTL
+ * expiry, eviction by size, orphaned blobs and Clear
+ */
+
+#include "lib/src/protocols/http/MetadataDiskCache.h"
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+static const char* kArtist = "8E66EA2B-B57B-47D9-8DF5-DF4E7F31A6D5";
+static const char* kImage = "0a1b2c3d-0000-4000-8000-000000000001";
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_metadata_disk_cache";
+    std::filesystem::remove_all(dir);
+    return dir.string();
+}
+
+static std::vector<uint8_t> Body(size_t size, uint8_t seed) {
+    std::vector<uint8_t> body(size);
+    for (size_t i = 0; i < size; i++) body[i] = static_cast<uint8_t>(seed + i * 7);
+    return body;
+}
+
+static std::vector<uint8_t> ReadAll(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static size_t BlobFiles(const std::string& dir) {
+    size_t n = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(dir) / "blobs")) {
+        (void)entry;
+        n++;
+    }
+    return n;
+}
+
+bool TestStoreAndLookup() {
+    std::cout << "Testing store, lookup and shared blobs..." << std::endl;
+    std::string dir = TempDir();
+    MetadataDiskCache cache;
+    ASSERT_TRUE(cache.Lookup(kArtist, "biography", "").empty(), "Closed: nothing found");
+    ASSERT_TRUE(cache.Open(dir, MetadataDiskCache::Limits{}), "Opens");
+
+    auto xml = Body(300, 1);
+    ASSERT_TRUE(cache.Store(kArtist, "biography", "", xml.data(), xml.size(), "application/atom+xml; charset=utf-8"),
+                "Stored");
+    std::string path = cache.Lookup(kArtist, "biography", "");
+    ASSERT_TRUE(!path.empty(), "Found");
+    ASSERT_EQ(path.substr(path.size() - 4), std::string(".xml"), "Extension from the content type");
+    ASSERT_TRUE(ReadAll(path) == xml, "Body as stored");
+
+    // UUIDs match in any case; other endpoints and ids do not
+    std::string lower(kArtist);
+    for (char& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    ASSERT_EQ(cache.Lookup(lower, "biography", ""), path, "Case-insensitive UUID");
+    ASSERT_TRUE(cache.Lookup(kArtist, "images", "").empty(), "Other endpoint");
+
+    // The same image as the background and by its own id: one blob
+    auto jpeg = Body(1000, 2);
+    cache.Store(kArtist, "devicebackgroundimage", "", jpeg.data(), jpeg.size(), "image/jpeg");
+    cache.Store("", "artwork", kImage, jpeg.data(), jpeg.size(), "image/jpeg");
+    ASSERT_EQ(cache.Lookup("", "artwork", kImage), cache.Lookup(kArtist, "devicebackgroundimage", ""),
+              "Shared blob");
+    auto stats = cache.GetStats();
+    ASSERT_EQ(stats.entries, uint64_t(3), "Three entries");
+    ASSERT_EQ(stats.blobs, uint64_t(2), "Two blobs");
+    ASSERT_EQ(stats.bytes, uint64_t(1300), "Bytes of distinct bodies");
+    ASSERT_EQ(BlobFiles(dir), size_t(2), "Two files");
+
+    // Replacing a body drops the old blob once nothing names it
+    auto xml2 = Body(200, 3);
+    cache.Store(kArtist, "biography", "", xml2.data(), xml2.size(), "text/xml");
+    ASSERT_TRUE(ReadAll(cache.Lookup(kArtist, "biography", "")) == xml2, "New body");
+    ASSERT_EQ(BlobFiles(dir), size_t(2), "Old blob deleted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPersistence() {
+    std::cout << "Testing persistence and orphaned blobs..." << std::endl;
+    std::string dir = TempDir();
+    auto body = Body(500, 4);
+    std::string path;
+    {
+        MetadataDiskCache cache;
+        cache.Open(dir, MetadataDiskCache::Limits{});
+        cache.Store(kArtist, "images", "", body.data(), body.size(), "application/atom+xml");
+        path = cache.Lookup(kArtist, "images", "");
+    }
+
+    // A blob written by a store whose index save never happened
+    std::ofstream(std::filesystem::path(dir) / "blobs" / "0000000000000000-1.bin") << "x";
+
+    MetadataDiskCache cache;
+    cache.Open(dir, MetadataDiskCache::Limits{});
+    ASSERT_EQ(cache.Lookup(kArtist, "images", ""), path, "Found after reopening");
+    ASSERT_EQ(cache.GetStats().bytes, uint64_t(500), "Sizes reloaded");
+    ASSERT_EQ(BlobFiles(dir), size_t(1), "Orphan deleted");
+
+    // A blob deleted outside the cache is a miss, not a broken path
+    std::filesystem::remove(path);
+    ASSERT_TRUE(cache.Lookup(kArtist, "images", "").empty(), "Missing blob forgotten");
+    ASSERT_EQ(cache.GetStats().entries, uint64_t(0), "No entries left");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestExpiryAndEviction() {
+    std::cout << "Testing TTL expiry and eviction by size..." << std::endl;
+    std::string dir = TempDir();
+    int64_t now = 1000000;
+    MetadataDiskCache cache([&] { return now; });
+    MetadataDiskCache::Limits limits;
+    limits.max_bytes = 3000;
+    limits.ttl = std::chrono::seconds(100);
+    cache.Open(dir, limits);
+
+    auto a = Body(1000, 5), b = Body(1000, 6), c = Body(1000, 7), d = Body(1000, 8);
+    cache.Store("", "artwork", "a", a.data(), a.size(), "image/jpeg");
+    now += 10;
+    cache.Store("", "artwork", "b", b.data(), b.size(), "image/jpeg");
+    now += 10;
+    cache.Store("", "artwork", "c", c.data(), c.size(), "image/jpeg");
+
+    // a is served, so b is now the least recently used
+    now += 10;
+    ASSERT_TRUE(!cache.Lookup("", "artwork", "a").empty(), "a found");
+    cache.Store("", "artwork", "d", d.data(), d.size(), "image/jpeg");
+    ASSERT_TRUE(cache.Lookup("", "artwork", "b").empty(), "b evicted");
+    ASSERT_TRUE(!cache.Lookup("", "artwork", "a").empty(), "a kept");
+    auto stats = cache.GetStats();
+    ASSERT_EQ(stats.evictions, uint64_t(1), "One eviction");
+    ASSERT_EQ(stats.bytes, uint64_t(3000), "Within the budget");
+
+    // Too large to keep at all
+    auto big = Body(4000, 9);
+    ASSERT_TRUE(!cache.Store("", "artwork", "big", big.data(), big.size(), "image/jpeg"), "Over budget refused");
+
+    // Age counts from when it was stored, not served
+    now += 80;
+    ASSERT_TRUE(cache.Lookup("", "artwork", "a").empty(), "a expired");
+    ASSERT_TRUE(!cache.Lookup("", "artwork", "d").empty(), "d still fresh");
+    ASSERT_EQ(cache.GetStats().expired, uint64_t(1), "One expired");
+
+    cache.Clear();
+    ASSERT_EQ(cache.GetStats().entries, uint64_t(0), "Cleared");
+    ASSERT_EQ(BlobFiles(dir), size_t(0), "Blobs deleted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Metadata Disk Cache Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestStoreAndLookup, "Store And Lookup");
+    run_test(TestPersistence, "Persistence");
+    run_test(TestExpiryAndEviction, "Expiry And Eviction");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_metadata_disk_cache");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+/**
+ * test_metadata_response_cache.cpp
+ *
+ * Unit tests for the in-memory metadata response cache
+ * Tests key normalization, hit/miss counting, prefetch accounting, entry
+ * age and origin, least-recently-used eviction under the byte budget and concurrent use
+ * from several worker threads
+ */
+
+#include "lib/src/protocols/http/MetadataResponseCache.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+static HTTPParser::HTTPResponse MakeResponse(size_t body_size, uint8_t fill) {
+    HTTPParser::HTTPResponse response;
+    response.headers["Content-Type"] = "image/jpeg";
+    response.body.assign(body_size, fill);
+    return response;
+}
+
+bool TestKeys() {
+    std::cout << "Testing cache keys..." << std::endl;
+    std::map<std::string, std::string> query{{"chunkSize", "10"}, {"full", "true"}};
+    std::string key = MetadataResponseCache::MakeKey("Catalog.Zune.NET", "/v3.0/en-US/music/artist/x/images", query);
+    ASSERT_EQ(key, std::string("catalog.zune.net\n/v3.0/en-US/music/artist/x/images?chunkSize=10&full=true"),
+              "Host lower-cased, query appended in order");
+    ASSERT_EQ(MetadataResponseCache::MakeKey("image.catalog.zune.net", "/image/abc", {}),
+              std::string("image.catalog.zune.net\n/image/abc"), "No query");
+    ASSERT_TRUE(MetadataResponseCache::MakeKey("a", "/p", {}) != MetadataResponseCache::MakeKey("b", "/p", {}),
+                "Hosts kept apart");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestHitsAndMisses() {
+    std::cout << "Testing hits and misses..." << std::endl;
+    MetadataResponseCache cache;
+    HTTPParser::HTTPResponse out;
+
+    ASSERT_FALSE(cache.Lookup("k", out), "Empty cache misses");
+    cache.Insert("k", MakeResponse(100, 0xAB));
+    ASSERT_TRUE(cache.Lookup("k", out), "Inserted entry hits");
+    ASSERT_EQ(out.body.size(), size_t(100), "Body returned");
+    ASSERT_EQ(int(out.body[99]), 0xAB, "Body contents");
+    ASSERT_EQ(out.headers["Content-Type"], std::string("image/jpeg"), "Headers returned");
+
+    // Changing the copy leaves the entry alone
+    out.headers["Date"] = "changed";
+    HTTPParser::HTTPResponse again;
+    ASSERT_TRUE(cache.Lookup("k", again), "Second hit");
+    ASSERT_TRUE(again.headers.find("Date") == again.headers.end(), "Entry unchanged by caller");
+
+    // Replacing keeps one entry
+    cache.Insert("k", MakeResponse(50, 0x01));
+    ASSERT_TRUE(cache.Lookup("k", out), "Replaced entry hits");
+    ASSERT_EQ(out.body.size(), size_t(50), "Replacement body");
+
+    MetadataResponseCache::Stats stats = cache.GetStats();
+    ASSERT_EQ(stats.hits, uint64_t(3), "Hits counted");
+    ASSERT_EQ(stats.misses, uint64_t(1), "Misses counted");
+    ASSERT_EQ(stats.entries, uint64_t(1), "One entry");
+    ASSERT_TRUE(stats.bytes >= 50 && stats.bytes < 100, "Bytes of the replacement only");
+
+    cache.Clear();
+    ASSERT_FALSE(cache.Lookup("k", out), "Cleared");
+    ASSERT_EQ(cache.GetStats().bytes, uint64_t(0), "No bytes after clear");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPrefetchAccounting() {
+    std::cout << "Testing prefetched entries..." << std::endl;
+    MetadataResponseCache cache;
+    HTTPParser::HTTPResponse out;
+
+    ASSERT_FALSE(cache.Peek("bio", out), "Peek on empty cache");
+    cache.Insert("bio", MakeResponse(10, 1), true);
+    cache.Insert("images", MakeResponse(10, 2), true);
+    cache.Insert("own", MakeResponse(10, 3));
+
+    // Peeks are the prefetcher's own reads: not hits, not misses
+    ASSERT_TRUE(cache.Peek("images", out), "Peek finds entry");
+    ASSERT_EQ(out.body.size(), size_t(10), "Peek copies body");
+    MetadataResponseCache::Stats stats = cache.GetStats();
+    ASSERT_EQ(stats.hits + stats.misses, uint64_t(0), "Peek not counted");
+    ASSERT_EQ(stats.prefetched, uint64_t(2), "Prefetched inserts counted");
+
+    // A prefetched entry counts once, on the device's first request for it
+    ASSERT_TRUE(cache.Lookup("bio", out), "Prefetched entry hits");
+    ASSERT_TRUE(cache.Lookup("bio", out), "Again");
+    ASSERT_TRUE(cache.Lookup("own", out), "Ordinary entry hits");
+    stats = cache.GetStats();
+    ASSERT_EQ(stats.hits, uint64_t(3), "All hits counted");
+    ASSERT_EQ(stats.prefetch_hits, uint64_t(1), "Prefetch hit counted once");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFreshness() {
+    std::cout << "Testing entry age and origin..." << std::endl;
+    MetadataResponseCache cache;
+    HTTPParser::HTTPResponse out;
+    MetadataResponseCache::Freshness freshness;
+
+    cache.Insert("local", MakeResponse(10, 1));
+    cache.Insert("proxied", MakeResponse(10, 2), false, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    ASSERT_TRUE(cache.Lookup("local", out, &freshness), "Local entry hits");
+    ASSERT_FALSE(freshness.upstream, "Local entry not upstream");
+    ASSERT_TRUE(cache.Lookup("proxied", out, &freshness), "Proxied entry hits");
+    ASSERT_TRUE(freshness.upstream, "Proxied entry upstream");
+    ASSERT_TRUE(freshness.age >= std::chrono::milliseconds(20), "Age since stored");
+
+    // Storing again after revalidation starts the age over
+    cache.Insert("proxied", out, false, true);
+    ASSERT_TRUE(cache.Lookup("proxied", out, &freshness), "Refreshed entry hits");
+    ASSERT_TRUE(freshness.age < std::chrono::milliseconds(20), "Age reset");
+    ASSERT_TRUE(freshness.upstream, "Still upstream");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestEviction() {
+    std::cout << "Testing least-recently-used eviction..." << std::endl;
+    MetadataResponseCache cache(8000);
+    HTTPParser::HTTPResponse out;
+
+    cache.Insert("a", MakeResponse(900, 1));
+    cache.Insert("b", MakeResponse(900, 2));
+    cache.Insert("c", MakeResponse(900, 3));
+    ASSERT_TRUE(cache.Lookup("a", out), "a recently used");
+
+    // Fills past the budget: b is the oldest untouched entry
+    for (int i = 0; i < 6; i++) {
+        cache.Insert("x" + std::to_string(i), MakeResponse(900, 9));
+    }
+    ASSERT_FALSE(cache.Lookup("b", out), "Least recently used evicted");
+    ASSERT_TRUE(cache.Lookup("a", out), "Touched entry kept");
+
+    MetadataResponseCache::Stats stats = cache.GetStats();
+    ASSERT_TRUE(stats.bytes <= stats.capacity, "Within budget");
+    ASSERT_TRUE(stats.evictions >= 1, "Evictions counted");
+
+    // Larger than an eighth of the budget: not kept
+    cache.Insert("big", MakeResponse(1500, 7));
+    ASSERT_FALSE(cache.Lookup("big", out), "Oversized response skipped");
+
+    // Shrinking evicts down to the new budget; zero disables
+    cache.SetCapacity(2000);
+    ASSERT_TRUE(cache.GetStats().bytes <= 2000, "Shrunk");
+    ASSERT_EQ(cache.GetStats().entries, uint64_t(2), "Two entries fit");
+    ASSERT_TRUE(cache.Lookup("a", out), "Most recently used survives");
+    cache.SetCapacity(0);
+    ASSERT_EQ(cache.GetStats().entries, uint64_t(0), "Zero capacity holds nothing");
+    cache.Insert("z", MakeResponse(1, 0));
+    ASSERT_FALSE(cache.Lookup("z", out), "Zero capacity stores nothing");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestConcurrentWorkers() {
+    std::cout << "Testing concurrent worker threads..." << std::endl;
+    MetadataResponseCache cache(64 * 1024);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&cache, t] {
+            HTTPParser::HTTPResponse out;
+            for (int i = 0; i < 2000; i++) {
+                std::string key = "/image/" + std::to_string((i * 7 + t) % 40);
+                if (!cache.Lookup(key, out)) {
+                    cache.Insert(key, MakeResponse(1000, static_cast<uint8_t>(key.size())));
+                } else if (out.body.empty() || out.body[0] != static_cast<uint8_t>(key.size())) {
+                    std::abort();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    MetadataResponseCache::Stats stats = cache.GetStats();
+    ASSERT_EQ(stats.hits + stats.misses, uint64_t(8000), "Every lookup counted");
+    ASSERT_TRUE(stats.hits > stats.misses, "Repeated keys mostly hit");
+    ASSERT_TRUE(stats.bytes <= stats.capacity, "Within budget");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Metadata Response Cache Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestKeys, "Keys");
+    run_test(TestHitsAndMisses, "Hits and Misses");
+    run_test(TestPrefetchAccounting, "Prefetch Accounting");
+    run_test(TestFreshness, "Freshness");
+    run_test(TestEviction, "Eviction");
+    run_test(TestConcurrentWorkers, "Concurrent Workers");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
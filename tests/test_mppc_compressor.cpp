@@ -0,0 +1,377 @@
+/**
+ * test_mppc_compressor.cpp
+ *
+ * Unit tests for the MPPC (RFC 2118) compressor
+ * Each packet is decoded by a reference decompressor written from the RFC:
+ * tests round trips across packets sharing the history, the header flags
+ * and coherency count, incompressible packets, wrapping at the end of the
+ * history, resets, stateless mode, and every literal, offset and length code
+ */
+
+#include "lib/src/protocols/ppp/MPPCCompressor.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Decompressor side of RFC 2118, as the device runs it
+class ReferenceDecompressor {
+public:
+    ReferenceDecompressor() : history_(MPPCCompressor::kHistorySize, 0) {}
+
+    bool Decompress(const std::vector<uint8_t>& packet, std::vector<uint8_t>& out) {
+        if (packet.size() < MPPCCompressor::kHeaderSize) {
+            return false;
+        }
+        uint16_t header = static_cast<uint16_t>(packet[0] << 8 | packet[1]);
+        if ((header & MPPCCompressor::kCountMask) != count_) {
+            return false;
+        }
+        count_ = (count_ + 1) & MPPCCompressor::kCountMask;
+
+        if (header & MPPCCompressor::kFlushed) {
+            std::fill(history_.begin(), history_.end(), 0);
+            pos_ = 0;
+        }
+        if (header & MPPCCompressor::kAtFront) {
+            pos_ = 0;
+        }
+        if (!(header & MPPCCompressor::kCompressed)) {
+            out.assign(packet.begin() + MPPCCompressor::kHeaderSize, packet.end());
+            return true;
+        }
+
+        data_ = packet.data() + MPPCCompressor::kHeaderSize;
+        bits_left_ = (packet.size() - MPPCCompressor::kHeaderSize) * 8;
+        bit_ = 0;
+        size_t start = pos_;
+        // Every code is at least 8 bits; fewer left is padding
+        while (bits_left_ >= 8) {
+            if (Bit() == 0) {
+                Append(static_cast<uint8_t>(Bits(7)));
+                continue;
+            }
+            if (Bit() == 0) {
+                Append(static_cast<uint8_t>(0x80 | Bits(7)));
+                continue;
+            }
+            size_t offset;
+            if (Bit() == 0) {
+                offset = Bits(13) + 320;
+            } else if (Bit() == 0) {
+                offset = Bits(8) + 64;
+            } else {
+                offset = Bits(6);
+            }
+            int ones = 0;
+            while (Bit() == 1) {
+                ones++;
+            }
+            size_t length = ones == 0 ? 3 : (size_t(1) << (ones + 1)) + Bits(ones + 1);
+            if (offset == 0 || offset > pos_ || pos_ + length > history_.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < length; i++) {
+                Append(history_[pos_ - offset]);
+            }
+        }
+        out.assign(history_.begin() + start, history_.begin() + pos_);
+        return true;
+    }
+
+private:
+    int Bit() {
+        if (bits_left_ == 0) {
+            return 0;
+        }
+        int value = (data_[bit_ / 8] >> (7 - bit_ % 8)) & 1;
+        bit_++;
+        bits_left_--;
+        return value;
+    }
+
+    uint32_t Bits(int n) {
+        uint32_t value = 0;
+        for (int i = 0; i < n; i++) {
+            value = (value << 1) | Bit();
+        }
+        return value;
+    }
+
+    void Append(uint8_t byte) {
+        if (pos_ < history_.size()) {
+            history_[pos_++] = byte;
+        }
+    }
+
+    std::vector<uint8_t> history_;
+    size_t pos_ = 0;
+    uint16_t count_ = 0;
+    const uint8_t* data_ = nullptr;
+    size_t bits_left_ = 0;
+    size_t bit_ = 0;
+};
+
+static std::vector<uint8_t> Bytes(const std::string& text) {
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// Deterministic incompressible bytes
+static std::vector<uint8_t> Noise(size_t size, uint32_t seed) {
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(seed >> 16);
+    }
+    return data;
+}
+
+static std::string BiographyChunk(int i) {
+    return "<entry><id>urn:uuid:" + std::to_string(1000 + i) + "</id>"
+           "<title type=\"text\">Album " + std::to_string(i) + "</title>"
+           "<link rel=\"related\" type=\"application/atom+xml\" href=\"http://catalog.zune.net/v3.0/en-US/music/album/"
+           + std::to_string(i) + "\" /><updated>2008-11-0" + std::to_string(i % 9 + 1) + "T00:00:00Z</updated></entry>";
+}
+
+static uint16_t Header(const std::vector<uint8_t>& packet) {
+    return static_cast<uint16_t>(packet[0] << 8 | packet[1]);
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestRoundTrip() {
+    std::cout << "Testing round trips across packets..." << std::endl;
+    MPPCCompressor compressor;
+    ReferenceDecompressor decompressor;
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> decoded;
+    size_t bytes_in = 0;
+    size_t bytes_out = 0;
+
+    for (int i = 0; i < 12; i++) {
+        std::vector<uint8_t> data = Bytes(BiographyChunk(i) + BiographyChunk(i + 1) + BiographyChunk(i + 2));
+        compressor.Compress(data.data(), data.size(), packet);
+        uint16_t header = Header(packet);
+        ASSERT_EQ(int(header & MPPCCompressor::kCountMask), i, "Coherency count per packet");
+        ASSERT_TRUE(header & MPPCCompressor::kCompressed, "Compressed");
+        if (i == 0) {
+            ASSERT_TRUE((header & MPPCCompressor::kFlushed) && (header & MPPCCompressor::kAtFront),
+                        "First packet starts a new history");
+        } else {
+            ASSERT_FALSE(header & MPPCCompressor::kFlushed, "Later packets build on the history");
+        }
+        ASSERT_TRUE(decompressor.Decompress(packet, decoded), "Decodes");
+        ASSERT_TRUE(decoded == data, "Round trip of packet " + std::to_string(i));
+        bytes_in += data.size();
+        bytes_out += packet.size();
+    }
+    std::cout << "  " << bytes_in << " -> " << bytes_out << " bytes" << std::endl;
+    ASSERT_TRUE(bytes_out * 3 < bytes_in, "Markup shrinks to under a third");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestIncompressible() {
+    std::cout << "Testing packets that do not shrink..." << std::endl;
+    MPPCCompressor compressor;
+    ReferenceDecompressor decompressor;
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> decoded;
+
+    std::vector<uint8_t> text = Bytes(BiographyChunk(1) + BiographyChunk(2));
+    compressor.Compress(text.data(), text.size(), packet);
+    ASSERT_TRUE(decompressor.Decompress(packet, decoded) && decoded == text, "Text round trip");
+
+    std::vector<uint8_t> noise = Noise(1400, 7);
+    compressor.Compress(noise.data(), noise.size(), packet);
+    uint16_t header = Header(packet);
+    ASSERT_FALSE(header & MPPCCompressor::kCompressed, "Sent as it is");
+    ASSERT_TRUE(header & MPPCCompressor::kFlushed, "History reset");
+    ASSERT_EQ(packet.size(), noise.size() + MPPCCompressor::kHeaderSize, "Header and data only");
+    ASSERT_TRUE(decompressor.Decompress(packet, decoded) && decoded == noise, "Noise round trip");
+
+    // The next packet starts over rather than referring to the text
+    compressor.Compress(text.data(), text.size(), packet);
+    header = Header(packet);
+    ASSERT_TRUE((header & MPPCCompressor::kCompressed) && (header & MPPCCompressor::kFlushed), "Fresh history");
+    ASSERT_TRUE(decompressor.Decompress(packet, decoded) && decoded == text, "Text after noise");
+
+    std::vector<uint8_t> empty;
+    compressor.Compress(empty.data(), 0, packet);
+    ASSERT_TRUE(decompressor.Decompress(packet, decoded) && decoded.empty(), "Empty packet");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestHistoryWrap() {
+    std::cout << "Testing wrapping at the end of the history..." << std::endl;
+    MPPCCompressor compressor;
+    ReferenceDecompressor decompressor;
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> decoded;
+    int at_front = 0;
+
+    for (int i = 0; i < 60; i++) {
+        std::string text;
+        for (int j = 0; j < 6; j++) {
+            text += BiographyChunk(i * 6 + j);
+        }
+        std::vector<uint8_t> data = Bytes(text);
+        compressor.Compress(data.data(), data.size(), packet);
+        uint16_t header = Header(packet);
+        if (i > 0 && (header & MPPCCompressor::kAtFront)) {
+            ASSERT_FALSE(header & MPPCCompressor::kFlushed, "Moving to the front is not a flush");
+            at_front++;
+        }
+        ASSERT_TRUE(decompressor.Decompress(packet, decoded), "Decodes");
+        ASSERT_TRUE(decoded == data, "Round trip of packet " + std::to_string(i));
+    }
+    ASSERT_TRUE(at_front >= 2, "Wrapped more than once");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestResetAndStateless() {
+    std::cout << "Testing reset and stateless mode..." << std::endl;
+    std::vector<uint8_t> data = Bytes(BiographyChunk(3) + BiographyChunk(4));
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> decoded;
+
+    MPPCCompressor compressor;
+    ReferenceDecompressor decompressor;
+    compressor.Compress(data.data(), data.size(), packet);
+    ASSERT_TRUE(decompressor.Decompress(packet, decoded), "First");
+    compressor.Compress(data.data(), data.size(), packet);
+    size_t with_history = packet.size();
+    ASSERT_FALSE(Header(packet) & MPPCCompressor::kFlushed, "Builds on the history");
+    ASSERT_TRUE(decompressor.Decompress(packet, decoded) && decoded == data, "Second");
+
+    // The device lost its history: the next packet must not need it
+    compressor.Reset();
+    ReferenceDecompressor restarted;
+    compressor.Compress(data.data(), data.size(), packet);
+    ASSERT_TRUE(Header(packet) & MPPCCompressor::kFlushed, "Flushed after reset");
+    ASSERT_TRUE(packet.size() > with_history, "Repeat no longer found");
+
+    MPPCCompressor stateless(true);
+    ASSERT_TRUE(stateless.Stateless(), "Stateless");
+    ReferenceDecompressor stateless_decompressor;
+    for (int i = 0; i < 3; i++) {
+        stateless.Compress(data.data(), data.size(), packet);
+        ASSERT_TRUE(Header(packet) & MPPCCompressor::kFlushed, "Every packet flushed");
+        ASSERT_TRUE(stateless_decompressor.Decompress(packet, decoded) && decoded == data, "Stateless round trip");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestAllCodes() {
+    std::cout << "Testing every literal, offset and length code..." << std::endl;
+
+    // All byte values, then copies at short, medium and long offsets of
+    // lengths from 3 up to the longest a packet allows
+    std::vector<uint8_t> data;
+    for (int b = 0; b < 256; b++) {
+        data.push_back(static_cast<uint8_t>(b));
+    }
+    std::vector<uint8_t> noise = Noise(1200, 99);
+    data.insert(data.end(), noise.begin(), noise.end());
+    size_t lengths[] = {3, 4, 7, 8, 15, 16, 31, 32, 63, 64, 127, 128, 255, 256, 511, 512};
+    size_t offsets[] = {40, 200, 1000};
+    uint32_t seed = 5;
+    for (size_t length : lengths) {
+        for (size_t offset : offsets) {
+            size_t from = data.size() - offset;
+            for (size_t i = 0; i < length; i++) {
+                data.push_back(data[from + i]);
+            }
+            std::vector<uint8_t> separator = Noise(3, seed++);
+            data.insert(data.end(), separator.begin(), separator.end());
+        }
+    }
+    data.resize(std::min(data.size(), size_t(6000)));
+    std::vector<uint8_t> run(MPPCCompressor::kHistorySize - data.size(), 'x');
+    data.insert(data.end(), run.begin(), run.end());
+
+    MPPCCompressor compressor;
+    ReferenceDecompressor decompressor;
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> decoded;
+    compressor.Compress(data.data(), data.size(), packet);
+    ASSERT_TRUE(Header(packet) & MPPCCompressor::kCompressed, "Compressed");
+    ASSERT_TRUE(decompressor.Decompress(packet, decoded), "Decodes");
+    ASSERT_TRUE(decoded == data, "Round trip of a full history");
+
+    // A whole history of one byte: the longest copies
+    std::vector<uint8_t> zeros(MPPCCompressor::kHistorySize, 0);
+    MPPCCompressor runs;
+    ReferenceDecompressor runs_decompressor;
+    runs.Compress(zeros.data(), zeros.size(), packet);
+    ASSERT_TRUE(packet.size() < 16, "8 KB of zeros in a few bytes");
+    ASSERT_TRUE(runs_decompressor.Decompress(packet, decoded) && decoded == zeros, "Run round trip");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " MPPC Compressor Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestRoundTrip, "Round Trip");
+    run_test(TestIncompressible, "Incompressible");
+    run_test(TestHistoryWrap, "History Wrap");
+    run_test(TestResetAndStateless, "Reset and Stateless");
+    run_test(TestAllCodes, "All Codes");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
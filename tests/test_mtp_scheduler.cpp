@@ -0,0 +1,244 @@
+/**
+ * test_mtp_scheduler.cpp
+ *
+ * Unit tests for the MTP operation scheduler
+ * Tests priority order, FIFO within a class, fairness aging, reentrant
+ * grants and the queue-wait counters
+ */
+
+#include "lib/src/ZuneMtpScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using zune::MtpScheduler;
+
+// Threads that each take one grant and note when they got it
+struct Contenders {
+    explicit Contenders(MtpScheduler& s) : scheduler(s) {}
+
+    MtpScheduler& scheduler;
+    std::mutex mutex;
+    std::vector<std::string> order;
+    std::vector<std::thread> threads;
+
+    // Start a waiter and return once it is queued, so queue order is deterministic
+    void Queue(ZuneMtpOpClass op_class, const std::string& name) {
+        uint32_t before = Waiting();
+        threads.emplace_back([this, op_class, name] {
+            auto grant = scheduler.Acquire(op_class);
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        });
+        while (Waiting() == before) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    uint32_t Waiting() const {
+        ZuneMtpSchedulerStats stats;
+        scheduler.Snapshot(stats);
+        uint32_t n = 0;
+        for (const auto& c : stats.classes) n += c.waiting;
+        return n;
+    }
+
+    std::string Join() {
+        for (auto& t : threads) t.join();
+        std::string joined;
+        for (const auto& name : order) joined += (joined.empty() ? "" : " ") + name;
+        return joined;
+    }
+};
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestPriorityOrder() {
+    std::cout << "Testing priority order between operations..." << std::endl;
+    MtpScheduler scheduler;
+    Contenders contenders{scheduler};
+
+    // A SendObject holds the session while the others queue up behind it
+    auto send = scheduler.Acquire(ZUNE_MTP_CLASS_BULK);
+    contenders.Queue(ZUNE_MTP_CLASS_BULK, "bulk");
+    contenders.Queue(ZUNE_MTP_CLASS_READ, "read");
+    contenders.Queue(ZUNE_MTP_CLASS_CONTROL, "control1");
+    contenders.Queue(ZUNE_MTP_CLASS_NETWORK, "network");
+    contenders.Queue(ZUNE_MTP_CLASS_CONTROL, "control2");
+    send.Release();
+
+    ASSERT_EQ(contenders.Join(), std::string("network control1 control2 read bulk"),
+              "Highest class first, FIFO within a class");
+
+    ZuneMtpSchedulerStats stats;
+    scheduler.Snapshot(stats);
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_BULK].count, uint64_t(2), "Two bulk grants");
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_BULK].queued, uint64_t(1), "Only the second queued");
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_CONTROL].queued, uint64_t(2), "Both controls queued");
+    ASSERT_TRUE(stats.classes[ZUNE_MTP_CLASS_NETWORK].total_wait_us > 0, "Wait measured");
+    ASSERT_TRUE(stats.classes[ZUNE_MTP_CLASS_BULK].total_hold_us > 0, "Hold measured");
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_BULK].bypassed, uint64_t(4), "Bulk overtaken four times");
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_NETWORK].waiting, 0u, "Queues drained");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFairness() {
+    std::cout << "Testing that a steady stream of polls cannot starve an upload..." << std::endl;
+    MtpScheduler scheduler;
+    scheduler.SetMaxBypass(2);
+    Contenders contenders{scheduler};
+
+    auto send = scheduler.Acquire(ZUNE_MTP_CLASS_BULK);
+    contenders.Queue(ZUNE_MTP_CLASS_BULK, "bulk");
+    for (int i = 1; i <= 4; i++) contenders.Queue(ZUNE_MTP_CLASS_NETWORK, "poll" + std::to_string(i));
+    send.Release();
+    ASSERT_EQ(contenders.Join(), std::string("poll1 poll2 bulk poll3 poll4"), "Bulk goes after two bypasses");
+
+    // Strict priority: the upload waits for every poll
+    MtpScheduler strict;
+    strict.SetMaxBypass(0);
+    Contenders strict_contenders{strict};
+    auto hold = strict.Acquire(ZUNE_MTP_CLASS_BULK);
+    strict_contenders.Queue(ZUNE_MTP_CLASS_BULK, "bulk");
+    for (int i = 1; i <= 4; i++) strict_contenders.Queue(ZUNE_MTP_CLASS_NETWORK, "poll" + std::to_string(i));
+    hold.Release();
+    ASSERT_EQ(strict_contenders.Join(), std::string("poll1 poll2 poll3 poll4 bulk"), "No aging");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestReentrantGrants() {
+    std::cout << "Testing reentrant grants on the holding thread..." << std::endl;
+    MtpScheduler scheduler;
+    ASSERT_FALSE(scheduler.HeldByCurrentThread(), "Idle");
+    {
+        auto outer = scheduler.Acquire(ZUNE_MTP_CLASS_READ);
+        ASSERT_TRUE(scheduler.HeldByCurrentThread(), "Held");
+        // A scheduled method calling another one, or a callback calling back in
+        int value = MtpScheduler::Run(&scheduler, ZUNE_MTP_CLASS_CONTROL, [&] {
+            return MtpScheduler::Run(&scheduler, ZUNE_MTP_CLASS_NETWORK, [] { return 7; });
+        });
+        ASSERT_EQ(value, 7, "Nested grants run");
+        ASSERT_TRUE(scheduler.HeldByCurrentThread(), "Still held after nested release");
+
+        // Another thread still has to wait for the outer grant
+        std::atomic<bool> other_ran{false};
+        std::thread other([&] {
+            auto grant = scheduler.Acquire(ZUNE_MTP_CLASS_NETWORK);
+            other_ran = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ASSERT_FALSE(other_ran.load(), "Other thread blocked");
+        outer.Release();
+        other.join();
+        ASSERT_TRUE(other_ran.load(), "Runs once released");
+    }
+    ASSERT_FALSE(scheduler.HeldByCurrentThread(), "Released");
+
+    ZuneMtpSchedulerStats stats;
+    scheduler.Snapshot(stats);
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_CONTROL].count, uint64_t(0), "Nested grants not counted");
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_NETWORK].count, uint64_t(1), "Only the other thread's");
+
+    // Null scheduler: Run is a plain call
+    ASSERT_EQ(MtpScheduler::Run(nullptr, ZUNE_MTP_CLASS_BULK, [] { return 3; }), 3, "Unscheduled");
+
+    scheduler.Reset();
+    scheduler.Snapshot(stats);
+    ASSERT_EQ(stats.classes[ZUNE_MTP_CLASS_READ].count, uint64_t(0), "Counters reset");
+    ASSERT_EQ(stats.max_bypass, MtpScheduler::kDefaultMaxBypass, "Default fairness");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMutualExclusion() {
+    std::cout << "Testing that grants never overlap under load..." << std::endl;
+    MtpScheduler scheduler;
+    scheduler.SetMaxBypass(3);
+    int inside = 0;
+    bool overlapped = false;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 200; i++) {
+                MtpScheduler::Run(&scheduler, static_cast<ZuneMtpOpClass>((t + i) % ZUNE_MTP_CLASS_COUNT), [&] {
+                    if (++inside != 1) overlapped = true;
+                    --inside;
+                });
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    ASSERT_FALSE(overlapped, "One holder at a time");
+
+    ZuneMtpSchedulerStats stats;
+    scheduler.Snapshot(stats);
+    uint64_t total = 0;
+    for (const auto& c : stats.classes) total += c.count;
+    ASSERT_EQ(total, uint64_t(1600), "Every grant counted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " MTP Scheduler Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestPriorityOrder, "Priority Order");
+    run_test(TestFairness, "Fairness");
+    run_test(TestReentrantGrants, "Reentrant Grants");
+    run_test(TestMutualExclusion, "Mutual Exclusion");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/**
+ * test_network_metrics.cpp
+ *
+ * Unit tests for the interceptor's network counters
+ * Tests time to first segment (total, max, last), 0x922c transfer counts,
+ * the bytes-per-second gauge over whole seconds, and counting from many
+ * threads at once
+ */
+
+#include "lib/src/protocols/http/NetworkMetrics.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+using std::chrono::milliseconds;
+
+// A whole second on the steady clock, so the window boundaries are known
+static NetworkMetrics::Clock::time_point SecondStart() {
+    auto now = NetworkMetrics::Clock::now();
+    return NetworkMetrics::Clock::time_point(
+        std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()) + std::chrono::seconds(1));
+}
+
+bool TestFirstSegment() {
+    std::cout << "Testing time to first segment..." << std::endl;
+    NetworkMetrics metrics;
+    auto t = SecondStart();
+
+    metrics.RecordRequest();
+    metrics.RecordRequest();
+    metrics.RecordResponseStart(t, t + milliseconds(40));
+    metrics.RecordResponseStart(t, t + milliseconds(10));
+
+    NetworkMetrics::Snapshot s = metrics.GetSnapshot(t + milliseconds(50));
+    ASSERT_EQ(s.http_requests, uint64_t(2), "Requests");
+    ASSERT_EQ(s.responses_started, uint64_t(2), "Responses started");
+    ASSERT_EQ(s.first_segment_us_total, uint64_t(50000), "Total");
+    ASSERT_EQ(s.first_segment_us_max, uint64_t(40000), "Max");
+    ASSERT_EQ(s.first_segment_us_last, uint64_t(10000), "Last");
+
+    // A clock that moved backwards counts as zero
+    metrics.RecordResponseStart(t + milliseconds(5), t);
+    ASSERT_EQ(metrics.GetSnapshot(t).first_segment_us_last, uint64_t(0), "Never negative");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestBytesPerSecond() {
+    std::cout << "Testing bytes per second..." << std::endl;
+    NetworkMetrics metrics;
+    auto t = SecondStart();
+
+    metrics.RecordTransfer(7680, t + milliseconds(100));
+    metrics.RecordTransfer(320, t + milliseconds(900));
+    NetworkMetrics::Snapshot s = metrics.GetSnapshot(t + milliseconds(950));
+    ASSERT_EQ(s.usb_transfers, uint64_t(2), "Transfers");
+    ASSERT_EQ(s.usb_bytes_sent, uint64_t(8000), "Bytes");
+    ASSERT_EQ(s.bytes_per_second, uint64_t(0), "First second not over yet");
+
+    // Read in the next second: the finished one
+    ASSERT_EQ(metrics.GetSnapshot(t + milliseconds(1500)).bytes_per_second, uint64_t(8000), "Last full second");
+
+    // Sending in the next second closes the first
+    metrics.RecordTransfer(1000, t + milliseconds(1200));
+    ASSERT_EQ(metrics.GetSnapshot(t + milliseconds(1300)).bytes_per_second, uint64_t(8000), "Still the first");
+    ASSERT_EQ(metrics.GetSnapshot(t + milliseconds(2100)).bytes_per_second, uint64_t(1000), "Then the second");
+
+    // Idle seconds in between read as zero
+    ASSERT_EQ(metrics.GetSnapshot(t + milliseconds(3100)).bytes_per_second, uint64_t(0), "Idle second");
+    metrics.RecordTransfer(500, t + milliseconds(5000));
+    ASSERT_EQ(metrics.GetSnapshot(t + milliseconds(5500)).bytes_per_second, uint64_t(0), "Gap before it");
+    ASSERT_EQ(metrics.GetSnapshot(t + milliseconds(6000)).bytes_per_second, uint64_t(500), "After it");
+    ASSERT_EQ(metrics.GetSnapshot(t).usb_bytes_sent, uint64_t(9500), "Bytes total");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestConcurrentRecording() {
+    std::cout << "Testing counting from many threads..." << std::endl;
+    NetworkMetrics metrics;
+    auto t = SecondStart();
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 10000;
+
+    // Open the second first, so no thread's bytes race the window's opening
+    metrics.RecordTransfer(0, t);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([&metrics, t, i] {
+            for (int n = 0; n < kPerThread; n++) {
+                metrics.RecordRequest();
+                metrics.RecordResponseStart(t, t + std::chrono::microseconds(i * kPerThread + n));
+                metrics.RecordTransfer(10, t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    NetworkMetrics::Snapshot s = metrics.GetSnapshot(t + std::chrono::seconds(1));
+    ASSERT_EQ(s.http_requests, uint64_t(kThreads * kPerThread), "Every request");
+    ASSERT_EQ(s.first_segment_us_max, uint64_t(kThreads * kPerThread - 1), "Largest kept");
+    ASSERT_EQ(s.usb_transfers, uint64_t(kThreads * kPerThread + 1), "Every transfer");
+    ASSERT_EQ(s.bytes_per_second, uint64_t(kThreads * kPerThread * 10), "Every byte in its second");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Network Metrics Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestFirstSegment, "First Segment");
+    run_test(TestBytesPerSecond, "Bytes Per Second");
+    run_test(TestConcurrentRecording, "Concurrent Recording");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
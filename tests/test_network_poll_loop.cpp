@@ -0,0 +1,219 @@
+/**
+ * test_network_poll_loop.cpp
+ *
+ * Unit tests for the native network poll loop
+ * Tests the adaptive wait (doubling to the idle wait on empty cycles, back
+ * to hot polling on data or transmissions in flight), the events reported
+ * to the host, ending on a poll error, and stopping by token, including
+ * from the event callback
+ */
+
+#include "lib/src/protocols/http/NetworkPollLoop.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+using Event = NetworkPollLoop::Event;
+
+struct Recorded {
+    Event event;
+    int result;
+    size_t after_polls;  // Polls made when it was reported
+};
+
+// Waits for the loop to end by itself
+static bool WaitStopped(const NetworkPollLoop& loop) {
+    for (int i = 0; i < 500 && loop.IsRunning(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return !loop.IsRunning();
+}
+
+bool TestAdaptiveWait() {
+    std::cout << "Testing the adaptive wait and events..." << std::endl;
+
+    // Scripted poll results; the script ends the loop with -2
+    const std::vector<int> script = {0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, -2};
+    // Transmissions in flight after the 10th poll
+    const size_t active_from = 10, active_until = 11;
+
+    std::vector<int> waits;
+    std::vector<Recorded> events;
+    std::mutex mutex;
+    NetworkPollLoop loop;
+
+    uint64_t token = loop.Start(
+        [&](int timeout_ms) {
+            std::lock_guard<std::mutex> lock(mutex);
+            waits.push_back(timeout_ms);
+            return script[waits.size() - 1];
+        },
+        [&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return waits.size() >= active_from && waits.size() < active_until;
+        },
+        [&](Event event, int result) {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.push_back(Recorded{event, result, waits.size()});
+        },
+        1, 8);
+    ASSERT_TRUE(token != 0, "Started");
+    ASSERT_TRUE(WaitStopped(loop), "Ended on the poll error");
+
+    // Hot at 1 ms, doubling to 8 on empty polls; data and transmissions reset it
+    const std::vector<int> expected = {1, 2, 4, 8, 8, 8, 1, 2, 4, 8, 1, 2, 4, 8};
+    ASSERT_EQ(waits.size(), expected.size(), "Poll count");
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(waits[i], expected[i], "Wait of poll " + std::to_string(i + 1));
+    }
+
+    ASSERT_EQ(events.size(), size_t(6), "Event count");
+    ASSERT_TRUE(events[0].event == Event::Idle && events[0].after_polls == 3, "Idle once backed off");
+    ASSERT_TRUE(events[1].event == Event::Active && events[1].result == 1, "Active on data");
+    ASSERT_TRUE(events[2].event == Event::Idle && events[2].after_polls == 9, "Idle again");
+    ASSERT_TRUE(events[3].event == Event::Active && events[3].result == 0, "Active on transmissions");
+    ASSERT_TRUE(events[4].event == Event::Idle, "Idle after them");
+    ASSERT_TRUE(events[5].event == Event::Stopped && events[5].result == -2, "Stopped with the poll error");
+
+    ASSERT_TRUE(loop.Stop(token), "Ended loop joined by Stop");
+    ASSERT_FALSE(loop.Stop(token), "Nothing left to stop");
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStopByToken() {
+    std::cout << "Testing stopping by token..." << std::endl;
+    NetworkPollLoop loop;
+    std::atomic<int> polls{0};
+    std::atomic<int> stopped_result{1};
+    auto poll = [&](int timeout_ms) {
+        polls++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        return 0;
+    };
+    auto on_event = [&](Event event, int result) {
+        if (event == Event::Stopped) {
+            stopped_result = result;
+        }
+    };
+
+    uint64_t first = loop.Start(poll, nullptr, on_event, 0, 5);
+    ASSERT_TRUE(first != 0, "Started");
+    ASSERT_EQ(loop.Start(poll, nullptr, on_event), uint64_t(0), "Second start refused while running");
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_TRUE(polls.load() > 0, "Polling");
+
+    ASSERT_FALSE(loop.Stop(first + 1), "Unknown token ignored");
+    ASSERT_TRUE(loop.IsRunning(), "Still running");
+    ASSERT_TRUE(loop.Stop(first), "Stopped by its token");
+    ASSERT_FALSE(loop.IsRunning(), "Ended when Stop returns");
+    ASSERT_EQ(stopped_result.load(), 0, "Stopped event with no error");
+
+    uint64_t second = loop.Start(poll, nullptr, on_event, 0, 5);
+    ASSERT_TRUE(second != 0 && second != first, "Restarted with a new token");
+    ASSERT_FALSE(loop.Stop(first), "Stale token leaves the new loop running");
+    ASSERT_TRUE(loop.IsRunning(), "New loop running");
+    ASSERT_TRUE(loop.Stop(0), "Zero stops any loop");
+    ASSERT_FALSE(loop.IsRunning(), "Ended");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStopFromCallback() {
+    std::cout << "Testing stopping from the event callback..." << std::endl;
+    NetworkPollLoop loop;
+    std::atomic<uint64_t> token{0};
+    std::atomic<int> polls{0};
+    std::atomic<bool> stopped{false};
+    std::atomic<bool> stop_result{false};
+
+    token = loop.Start(
+        [&](int) { polls++; return 0; },
+        nullptr,
+        [&](Event event, int) {
+            if (event == Event::Idle) {
+                while (token.load() == 0) {
+                    std::this_thread::yield();
+                }
+                stop_result = loop.Stop(token.load());
+            } else if (event == Event::Stopped) {
+                stopped = true;
+            }
+        },
+        0, 4);
+    ASSERT_TRUE(token.load() != 0, "Started");
+    ASSERT_TRUE(WaitStopped(loop), "Ended after the callback");
+    ASSERT_TRUE(stop_result.load(), "Stop from the callback accepted");
+    ASSERT_TRUE(stopped.load(), "Stopped event still reported");
+    ASSERT_EQ(polls.load(), 3, "No poll after the stop");
+
+    // The finished thread is joined by the next start
+    uint64_t next = loop.Start([](int) { return -1; }, nullptr, nullptr);
+    ASSERT_TRUE(next != 0, "Restarted");
+    ASSERT_TRUE(WaitStopped(loop), "Ended on error");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Network Poll Loop Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestAdaptiveWait, "Adaptive Wait");
+    run_test(TestStopByToken, "Stop By Token");
+    run_test(TestStopFromCallback, "Stop From Callback");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+/**
+ * test_packed_library.cpp
+ *
+ * Unit tests for the packed (single-block) ZuneMusicLibrary export
+ * Tests building, saving, memory-mapping back and rejecting corrupt files
+ */
+
+#include "lib/src/ZunePackedLibrary.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+static const std::string kPackedPath = "test_packed_library.bin";
+
+template <typename T>
+static T* AllocateRecords(int count) {
+    T* records = static_cast<T*>(::operator new[](count * sizeof(T)));
+    for (int i = 0; i < count; i++) {
+        new (&records[i]) T();
+    }
+    return records;
+}
+
+static zmdb::ZMDBLibrary BuildLibrary() {
+    zmdb::ZMDBLibrary lib;
+
+    lib.tracks = AllocateRecords<zmdb::ZMDBTrack>(3);
+    lib.track_count = lib.tracks_capacity = 3;
+    for (int i = 0; i < 3; i++) {
+        lib.tracks[i].title = "Track " + std::to_string(i + 1);
+        lib.tracks[i].artist_name = "Artist";
+        lib.tracks[i].track_number = i + 1;
+        lib.tracks[i].atom_id = 0x01000001 + i;
+        lib.tracks[i].album_ref = 0x06000001;
+        lib.tracks[i].last_played_timestamp = 0x01D9000000000000ULL + i;
+    }
+
+    lib.playlists = AllocateRecords<zmdb::ZMDBPlaylist>(2);
+    lib.playlist_count = lib.playlists_capacity = 2;
+    lib.playlists[0].name = "Empty";
+    lib.playlists[1].name = "Mix";
+    lib.playlists[1].track_atom_ids = {0x01000003, 0x01000001};
+
+    lib.podcasts = AllocateRecords<zmdb::ZMDBPodcast>(1);
+    lib.podcast_count = lib.podcasts_capacity = 1;
+    lib.podcasts[0].title = "Episode";
+    lib.podcasts[0].codec_id = 0xB981;
+    lib.podcasts[0].played_flag = 0x200;
+    lib.podcasts[0].media_type = zmdb::PodcastMediaType::Video;
+
+    zmdb::ZMDBAlbum album;
+    album.title = "Album";
+    album.alb_reference = "Artist--Album.alb";
+    album.atom_id = 0x06000001;
+    lib.album_metadata[album.atom_id] = album;
+
+    zmdb::ZMDBGenre genre;
+    genre.name = "Rock";
+    genre.atom_id = 0x09000001;
+    lib.genre_metadata[genre.atom_id] = genre;
+
+    return lib;
+}
+
+static const std::unordered_map<std::string, uint32_t> kArtwork = {
+    {"Artist--Album.alb", 0x0500000a},
+};
+
+static bool ContainsPointer(const void* block_begin, size_t size, const void* p) {
+    auto* begin = static_cast<const uint8_t*>(block_begin);
+    auto* ptr = static_cast<const uint8_t*>(p);
+    return ptr >= begin && ptr < begin + size;
+}
+
+static bool CheckContents(const ZuneMusicLibrary* lib) {
+    ASSERT_EQ(lib->track_count, 3u, "Track count");
+    ASSERT_EQ(std::string(lib->tracks[1].title), std::string("Track 2"), "Track title");
+    ASSERT_EQ(std::string(lib->tracks[2].artist_guid), std::string(""), "Empty string is non-null");
+    ASSERT_EQ(lib->tracks[2].track_number, 3, "Track number");
+    ASSERT_EQ(lib->tracks[2].last_played_timestamp, static_cast<uint64_t>(0x01D9000000000002ULL), "Last played");
+
+    ASSERT_EQ(lib->album_count, 1u, "Album count");
+    ASSERT_EQ(std::string(lib->albums[0].alb_reference), std::string("Artist--Album.alb"), "Album ref");
+    ASSERT_EQ(lib->artist_count, 0u, "Artist count");
+    ASSERT_TRUE(lib->artists == nullptr, "Empty section has no array");
+    ASSERT_EQ(std::string(lib->genres[0].name), std::string("Rock"), "Genre name");
+
+    ASSERT_EQ(lib->artwork_count, 1u, "Artwork count");
+    ASSERT_EQ(lib->artworks[0].mtp_object_id, 0x0500000au, "Artwork object id");
+
+    ASSERT_EQ(lib->playlist_count, 2u, "Playlist count");
+    ASSERT_EQ(lib->playlists[0].track_count, 0u, "Empty playlist");
+    ASSERT_TRUE(lib->playlists[0].track_atom_ids == nullptr, "Empty playlist has no ids");
+    ASSERT_EQ(lib->playlists[1].track_count, 2u, "Playlist track count");
+    ASSERT_EQ(lib->playlists[1].track_atom_ids[0], 0x01000003u, "Playlist order");
+    ASSERT_EQ(lib->playlists[1].track_atom_ids[1], 0x01000001u, "Playlist order");
+
+    ASSERT_EQ(lib->podcast_episode_count, 1u, "Episode count");
+    ASSERT_EQ(lib->podcast_episodes[0].meta_genre, static_cast<uint16_t>(65), "Video meta genre");
+    ASSERT_TRUE(lib->podcast_episodes[0].is_played, "Episode played");
+    ASSERT_EQ(lib->podcast_episodes[0].media_type, static_cast<uint8_t>(1), "Episode media type");
+    return true;
+}
+
+// Test: Build produces the same data as the strdup export, in one block
+bool TestBuild() {
+    std::cout << "Testing packed library build..." << std::endl;
+
+    ZuneMusicLibrary* lib = zune::BuildPackedLibrary(BuildLibrary(), kArtwork);
+    ASSERT_TRUE(lib != nullptr, "Build should succeed");
+    if (!CheckContents(lib)) {
+        zune::FreePackedLibrary(lib);
+        return false;
+    }
+
+    // Everything the library points at lives just after the header. 64 KiB
+    // of slack is far more than this library needs.
+    const size_t kSlack = 64 * 1024;
+    ASSERT_TRUE(ContainsPointer(lib, kSlack, lib->tracks), "Tracks inside block");
+    ASSERT_TRUE(ContainsPointer(lib, kSlack, lib->tracks[0].title), "Strings inside block");
+    ASSERT_TRUE(ContainsPointer(lib, kSlack, lib->playlists[1].track_atom_ids), "Ids inside block");
+
+    zune::FreePackedLibrary(lib);
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: Save, then memory-map back at a different address
+bool TestSaveLoad() {
+    std::cout << "Testing packed library save/load..." << std::endl;
+
+    ZuneMusicLibrary* built = zune::BuildPackedLibrary(BuildLibrary(), kArtwork);
+    ASSERT_TRUE(built != nullptr, "Build should succeed");
+    ASSERT_TRUE(zune::SavePackedLibrary(built, kPackedPath), "Save should succeed");
+    // The live library must still be intact after saving
+    bool built_ok = CheckContents(built);
+    zune::FreePackedLibrary(built);
+    ASSERT_TRUE(built_ok, "Saving must not modify the library");
+
+    ZuneMusicLibrary* loaded = zune::LoadPackedLibrary(kPackedPath);
+    ASSERT_TRUE(loaded != nullptr, "Load should succeed");
+    bool loaded_ok = CheckContents(loaded);
+    zune::FreePackedLibrary(loaded);
+    ASSERT_TRUE(loaded_ok, "Loaded library should match");
+
+    std::remove(kPackedPath.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: Interned track strings are stored once and shared between tracks
+bool TestSharedStrings() {
+    std::cout << "Testing shared interned strings..." << std::endl;
+
+    zmdb::ZMDBLibrary source = BuildLibrary();
+    for (int i = 0; i < source.track_count; i++) {
+        source.tracks[i].artist_name = source.strings.intern("Shared Artist");
+        source.tracks[i].genre = source.strings.intern("Rock");
+    }
+    ASSERT_EQ(source.strings.size(), static_cast<size_t>(2), "Two unique interned strings");
+
+    ZuneMusicLibrary* lib = zune::BuildPackedLibrary(source, kArtwork);
+    ASSERT_TRUE(lib != nullptr, "Build should succeed");
+    bool shared = lib->tracks[0].artist_name == lib->tracks[2].artist_name &&
+                  lib->tracks[0].genre == lib->tracks[1].genre;
+    std::string artist = lib->tracks[1].artist_name;
+    std::string title = lib->tracks[1].title;
+    zune::FreePackedLibrary(lib);
+
+    ASSERT_TRUE(shared, "Interned strings share one pool entry");
+    ASSERT_EQ(artist, std::string("Shared Artist"), "Shared artist name");
+    ASSERT_EQ(title, std::string("Track 2"), "Plain strings unaffected");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: Truncated or tampered files are rejected
+bool TestCorruptFile() {
+    std::cout << "Testing corrupt packed library files..." << std::endl;
+
+    ZuneMusicLibrary* built = zune::BuildPackedLibrary(BuildLibrary(), kArtwork);
+    ASSERT_TRUE(built != nullptr, "Build should succeed");
+    ASSERT_TRUE(zune::SavePackedLibrary(built, kPackedPath), "Save should succeed");
+    zune::FreePackedLibrary(built);
+
+    std::vector<char> contents;
+    {
+        std::ifstream in(kPackedPath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    auto load_with = [&](const std::vector<char>& bytes) {
+        {
+            std::ofstream out(kPackedPath, std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+        ZuneMusicLibrary* lib = zune::LoadPackedLibrary(kPackedPath);
+        bool loaded = lib != nullptr;
+        zune::FreePackedLibrary(lib);
+        return loaded;
+    };
+
+    std::vector<char> truncated(contents.begin(), contents.end() - 1);
+    ASSERT_FALSE(load_with(truncated), "Truncated file should be rejected");
+
+    std::vector<char> bad_magic = contents;
+    bad_magic[0] = 'Q';
+    ASSERT_FALSE(load_with(bad_magic), "Bad magic should be rejected");
+
+    // Point the track array (first pointer after the 32-byte header) far
+    // outside the block
+    std::vector<char> bad_offset = contents;
+    uint64_t huge = 0x7fffffff;
+    std::memcpy(bad_offset.data() + 32, &huge, sizeof(huge));
+    ASSERT_FALSE(load_with(bad_offset), "Out-of-range offset should be rejected");
+
+    ASSERT_TRUE(load_with(contents), "Original file still loads");
+
+    std::remove(kPackedPath.c_str());
+    ASSERT_TRUE(zune::LoadPackedLibrary(kPackedPath) == nullptr, "Missing file");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Packed Library Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestBuild, "Packed Library Build");
+    run_test(TestSaveLoad, "Packed Library Save/Load");
+    run_test(TestSharedStrings, "Shared Interned Strings");
+    run_test(TestCorruptFile, "Corrupt Packed Library Files");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
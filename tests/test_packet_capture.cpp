@@ -0,0 +1,250 @@
+/**
+ * test_packet_capture.cpp
+ *
+ * Unit tests for the PPP packet capture ring
+ * Tests the pcap it writes (header, direction byte, protocol and payload
+ * per frame), frames spanning transfers, frames with a bad FCS left out,
+ * the ring overwriting its oldest transfers, and disabling
+ */
+
+#include "lib/src/protocols/http/PacketCapture.h"
+#include "lib/src/protocols/ppp/PPPParser.h"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+using Direction = PacketCapture::Direction;
+
+constexpr uint16_t kProtoIPv4 = 0x0021;
+constexpr uint16_t kProtoLCP = 0xC021;
+
+struct PcapRecord {
+    uint32_t sec;
+    uint32_t nsec;
+    std::vector<uint8_t> data;
+};
+
+struct Pcap {
+    uint32_t magic = 0;
+    uint32_t link_type = 0;
+    std::vector<PcapRecord> records;
+};
+
+static uint32_t ReadU32(const std::string& bytes, size_t offset) {
+    uint32_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+static bool ParsePcap(const std::string& bytes, Pcap& pcap) {
+    if (bytes.size() < 24) {
+        return false;
+    }
+    pcap.magic = ReadU32(bytes, 0);
+    pcap.link_type = ReadU32(bytes, 20);
+    size_t offset = 24;
+    while (offset < bytes.size()) {
+        if (bytes.size() - offset < 16) {
+            return false;
+        }
+        PcapRecord record;
+        record.sec = ReadU32(bytes, offset);
+        record.nsec = ReadU32(bytes, offset + 4);
+        uint32_t length = ReadU32(bytes, offset + 8);
+        offset += 16;
+        if (bytes.size() - offset < length) {
+            return false;
+        }
+        record.data.assign(bytes.begin() + offset, bytes.begin() + offset + length);
+        offset += length;
+        pcap.records.push_back(std::move(record));
+    }
+    return true;
+}
+
+static Pcap Dump(const PacketCapture& capture, int64_t* frames = nullptr) {
+    std::ostringstream out;
+    int64_t written = capture.WritePcap(out);
+    if (frames) {
+        *frames = written;
+    }
+    Pcap pcap;
+    ParsePcap(out.str(), pcap);
+    return pcap;
+}
+
+// Payload bytes 0x7E and 0x7D force escaping
+static mtp::ByteArray Frame(uint8_t tag, uint16_t protocol = kProtoIPv4) {
+    mtp::ByteArray payload = {0x45, tag, 0x7E, 0x7D, 0x01};
+    return PPPParser::WrapPayload(payload, protocol);
+}
+
+static std::vector<uint8_t> Expected(Direction direction, uint8_t tag,
+                                     uint16_t protocol = kProtoIPv4) {
+    return {static_cast<uint8_t>(direction), static_cast<uint8_t>(protocol >> 8),
+            static_cast<uint8_t>(protocol & 0xFF), 0x45, tag, 0x7E, 0x7D, 0x01};
+}
+
+bool TestPcapOutput() {
+    std::cout << "Testing the pcap written..." << std::endl;
+    PacketCapture capture;
+    capture.Enable(16);
+    ASSERT_TRUE(capture.IsEnabled(), "Enabled");
+
+    // Two frames packed into one 0x922c transfer, one LCP frame back
+    mtp::ByteArray sent = Frame(1);
+    mtp::ByteArray second = Frame(2);
+    sent.insert(sent.end(), second.begin(), second.end());
+    capture.Record(Direction::ToDevice, sent);
+    capture.Record(Direction::FromDevice, Frame(3, kProtoLCP));
+
+    // A frame split across two reads, with a frame sent in between
+    mtp::ByteArray split = Frame(4);
+    size_t half = split.size() / 2;
+    capture.Record(Direction::FromDevice, split.data(), half);
+    capture.Record(Direction::ToDevice, Frame(5));
+    capture.Record(Direction::FromDevice, split.data() + half, split.size() - half);
+
+    // A corrupted FCS is left out
+    mtp::ByteArray corrupt = Frame(6);
+    corrupt[corrupt.size() - 2] ^= 0x01;
+    capture.Record(Direction::FromDevice, corrupt);
+
+    int64_t frames = 0;
+    Pcap pcap = Dump(capture, &frames);
+    ASSERT_EQ(pcap.magic, uint32_t(0xa1b23c4d), "Nanosecond magic");
+    ASSERT_EQ(pcap.link_type, uint32_t(204), "PPP with direction");
+    ASSERT_EQ(frames, int64_t(5), "Frames written");
+    ASSERT_EQ(pcap.records.size(), size_t(5), "Records");
+    ASSERT_TRUE(pcap.records[0].data == Expected(Direction::ToDevice, 1), "First packed frame");
+    ASSERT_TRUE(pcap.records[1].data == Expected(Direction::ToDevice, 2), "Second packed frame");
+    ASSERT_TRUE(pcap.records[2].data == Expected(Direction::FromDevice, 3, kProtoLCP), "LCP frame");
+    ASSERT_TRUE(pcap.records[3].data == Expected(Direction::ToDevice, 5), "Frame sent mid-split");
+    ASSERT_TRUE(pcap.records[4].data == Expected(Direction::FromDevice, 4), "Split frame rejoined");
+    ASSERT_TRUE(pcap.records[0].sec > 1000000000, "Wall-clock time");
+    ASSERT_TRUE(pcap.records[0].nsec < 1000000000, "Nanoseconds in range");
+
+    PacketCapture::Stats stats = capture.GetStats();
+    ASSERT_EQ(stats.transfers, uint64_t(6), "Transfers recorded");
+    ASSERT_EQ(stats.held, uint64_t(6), "All held");
+    ASSERT_EQ(stats.overwritten, uint64_t(0), "None overwritten");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestRingWraps() {
+    std::cout << "Testing the ring overwriting its oldest..." << std::endl;
+    PacketCapture capture;
+    capture.Enable(3);
+    for (uint8_t tag = 1; tag <= 5; tag++) {
+        capture.Record(Direction::FromDevice, Frame(tag));
+    }
+
+    Pcap pcap = Dump(capture);
+    ASSERT_EQ(pcap.records.size(), size_t(3), "Ring size");
+    ASSERT_TRUE(pcap.records[0].data == Expected(Direction::FromDevice, 3), "Oldest kept");
+    ASSERT_TRUE(pcap.records[2].data == Expected(Direction::FromDevice, 5), "Newest");
+
+    PacketCapture::Stats stats = capture.GetStats();
+    ASSERT_EQ(stats.transfers, uint64_t(5), "Transfers recorded");
+    ASSERT_EQ(stats.overwritten, uint64_t(2), "Overwritten");
+    ASSERT_EQ(stats.held, uint64_t(3), "Held");
+
+    // A frame cut by the wrap is left out, the rest still read
+    capture.Enable(2);
+    mtp::ByteArray split = Frame(7);
+    capture.Record(Direction::FromDevice, split.data(), 4);
+    capture.Record(Direction::FromDevice, split.data() + 4, split.size() - 4);
+    capture.Record(Direction::FromDevice, Frame(8));
+    pcap = Dump(capture);
+    ASSERT_EQ(pcap.records.size(), size_t(1), "Only the whole frame");
+    ASSERT_TRUE(pcap.records[0].data == Expected(Direction::FromDevice, 8), "Whole frame");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDisabled() {
+    std::cout << "Testing disabled capture..." << std::endl;
+    PacketCapture capture;
+    ASSERT_FALSE(capture.IsEnabled(), "Off by default");
+    capture.Record(Direction::ToDevice, Frame(1));
+    ASSERT_EQ(capture.GetStats().transfers, uint64_t(0), "Nothing recorded");
+
+    int64_t frames = -1;
+    Pcap pcap = Dump(capture, &frames);
+    ASSERT_EQ(frames, int64_t(0), "Empty capture");
+    ASSERT_EQ(pcap.link_type, uint32_t(204), "Still a valid pcap");
+
+    capture.Enable(4);
+    capture.Record(Direction::ToDevice, Frame(1));
+    capture.Enable(0);
+    ASSERT_FALSE(capture.IsEnabled(), "Stopped");
+    capture.Record(Direction::ToDevice, Frame(2));
+    ASSERT_EQ(Dump(capture).records.size(), size_t(0), "Dropped on stop");
+
+    ASSERT_EQ(capture.WritePcap("/nonexistent-dir/capture.pcap"), int64_t(-1), "Unwritable path");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Packet Capture Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestPcapOutput, "Pcap Output");
+    run_test(TestRingWraps, "Ring Wraps");
+    run_test(TestDisabled, "Disabled");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+/**
+ * test_playlist_stage.cpp
+ *
+ * Unit tests for zune::PlaylistStage
+ * Tests coalescing on Flush, single-call creation of new playlists, edits
+ * after creation, discards, failures and the debounce timer
+ */
+
+#include "lib/src/ZunePlaylistStage.h"
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using zune::PlaylistStage;
+using namespace std::chrono_literals;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+// Stand-in for the device: records every write
+struct FakeDevice {
+    struct Write {
+        bool create;
+        uint32_t id;
+        std::string name;
+        std::vector<uint32_t> tracks;
+    };
+
+    std::mutex mutex;
+    std::vector<Write> writes;
+    uint32_t next_id = 0x1000;
+    bool fail = false;
+
+    PlaylistStage::CreateFn Create() {
+        return [this](const PlaylistStage::NewPlaylist& playlist) -> uint32_t {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (fail) return 0;
+            uint32_t id = next_id++;
+            writes.push_back({true, id, playlist.name, playlist.tracks});
+            return id;
+        };
+    }
+    PlaylistStage::UpdateFn Update() {
+        return [this](uint32_t id, const std::vector<uint32_t>& tracks) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (fail) return false;
+            writes.push_back({false, id, "", tracks});
+            return true;
+        };
+    }
+    size_t Count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return writes.size();
+    }
+};
+
+bool TestCoalescing() {
+    std::cout << "Testing coalesced updates..." << std::endl;
+    FakeDevice device;
+    PlaylistStage stage(device.Create(), device.Update());
+
+    stage.Stage(7, {1, 2, 3});
+    stage.Stage(7, {3, 1, 2});
+    stage.Stage(7, {3, 2, 1});
+    stage.Stage(9, {4});
+    ASSERT_EQ(device.Count(), size_t(0), "Nothing written before a flush");
+    ASSERT_EQ(stage.Pending(), size_t(2), "One pending edit per playlist");
+
+    ASSERT_EQ(stage.Flush(), size_t(0), "No failures");
+    ASSERT_EQ(device.writes.size(), size_t(2), "One write per playlist");
+    ASSERT_EQ(device.writes[0].id, uint32_t(7), "First playlist");
+    ASSERT_TRUE(device.writes[0].tracks == std::vector<uint32_t>({3, 2, 1}), "Latest order wins");
+    ASSERT_EQ(device.writes[1].id, uint32_t(9), "Second playlist");
+    ASSERT_EQ(stage.Pending(), size_t(0), "Nothing left");
+
+    ASSERT_EQ(stage.Flush(), size_t(0), "Empty flush");
+    ASSERT_EQ(device.writes.size(), size_t(2), "Empty flush writes nothing");
+
+    auto stats = stage.GetStats();
+    ASSERT_EQ(stats.staged, uint64_t(4), "Edits staged");
+    ASSERT_EQ(stats.written, uint64_t(2), "Writes sent");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestNewPlaylist() {
+    std::cout << "Testing new playlists..." << std::endl;
+    FakeDevice device;
+    PlaylistStage stage(device.Create(), device.Update());
+
+    const std::string guid = "01234567-89ab-cdef-0123-456789abcdef";
+    stage.StageNew({"Draft", guid, 0x20, {1}});
+    stage.StageNew({"Road Trip", guid, 0x20, {1, 2, 5}});
+    ASSERT_EQ(stage.CreatedId(guid), uint32_t(0), "Not created yet");
+    stage.Flush();
+
+    ASSERT_EQ(device.writes.size(), size_t(1), "Created in one call");
+    ASSERT_TRUE(device.writes[0].create, "A create");
+    ASSERT_EQ(device.writes[0].name, std::string("Road Trip"), "Latest name");
+    ASSERT_TRUE(device.writes[0].tracks == std::vector<uint32_t>({1, 2, 5}), "With its final tracks");
+    uint32_t id = stage.CreatedId(guid);
+    ASSERT_EQ(id, device.writes[0].id, "Created id known by guid");
+
+    // Later edits by guid update the created playlist
+    stage.StageNew({"Road Trip", guid, 0x20, {5}});
+    stage.Flush();
+    ASSERT_EQ(device.writes.size(), size_t(2), "One more write");
+    ASSERT_TRUE(!device.writes[1].create, "An update");
+    ASSERT_EQ(device.writes[1].id, id, "Of the created playlist");
+
+    // Discarded before its flush, e.g. deleted
+    stage.Stage(id, {1});
+    stage.Discard(id);
+    stage.Flush();
+    ASSERT_EQ(device.writes.size(), size_t(2), "Discarded edit not written");
+    ASSERT_EQ(stage.CreatedId(guid), uint32_t(0), "Forgotten once discarded");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFailures() {
+    std::cout << "Testing failed writes..." << std::endl;
+    FakeDevice device;
+    PlaylistStage stage(device.Create(), device.Update());
+
+    device.fail = true;
+    stage.Stage(7, {1});
+    stage.StageNew({"New", "guid", 0x20, {2}});
+    ASSERT_EQ(stage.Flush(), size_t(2), "Both failed");
+    ASSERT_EQ(stage.Pending(), size_t(0), "Failures are not retried");
+    ASSERT_EQ(stage.CreatedId("guid"), uint32_t(0), "No id for a failed create");
+    ASSERT_EQ(stage.GetStats().failed, uint64_t(2), "Counted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDebounce() {
+    std::cout << "Testing debounce..." << std::endl;
+    FakeDevice device;
+    PlaylistStage stage(device.Create(), device.Update());
+    stage.SetDebounce(50ms);
+
+    // A burst of edits, each well inside the debounce
+    for (uint32_t i = 1; i <= 5; i++) {
+        stage.Stage(7, {i});
+        std::this_thread::sleep_for(5ms);
+    }
+    ASSERT_EQ(device.Count(), size_t(0), "Held while edits keep coming");
+
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (device.Count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    ASSERT_EQ(device.Count(), size_t(1), "Written once after going quiet");
+    ASSERT_TRUE(device.writes[0].tracks == std::vector<uint32_t>({5}), "Last edit");
+    ASSERT_EQ(stage.Pending(), size_t(0), "Nothing left");
+
+    // Edits still pending at destruction are dropped without blocking
+    stage.SetDebounce(10s);
+    stage.Stage(8, {1});
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Playlist Stage Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestCoalescing, "Coalescing");
+    run_test(TestNewPlaylist, "New Playlist");
+    run_test(TestFailures, "Failures");
+    run_test(TestDebounce, "Debounce");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
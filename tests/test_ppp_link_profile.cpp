@@ -0,0 +1,207 @@
+/**
+ * test_ppp_link_profile.cpp
+ *
+ * Unit tests for PPPLinkProfile
+ * Tests that kept IPCP replies match freshly built ones, when they are
+ * rebuilt, DNS handler reuse, and the TCP state carried to the next session
+ */
+
+#include "lib/src/protocols/ppp/PPPLinkProfile.h"
+#include "lib/src/protocols/ppp/PPPParser.h"
+#include "lib/src/protocols/handlers/DNSHandler.h"
+#include "lib/src/protocols/tcp/TCPConnectionManager.h"
+#include <iostream>
+#include <map>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+IPCPParser::IPCPPacket DeviceRequest(uint8_t identifier, uint32_t ip) {
+    IPCPParser::IPCPPacket request;
+    request.code = IPCPParser::IPCP_CODE_CONFIG_REQUEST;
+    request.identifier = identifier;
+    request.options = {IPCPParser::IPCP_OPT_IP_ADDRESS, 0x06,
+                       static_cast<uint8_t>(ip >> 24), static_cast<uint8_t>(ip >> 16),
+                       static_cast<uint8_t>(ip >> 8), static_cast<uint8_t>(ip)};
+    request.length = static_cast<uint16_t>(4 + request.options.size());
+    return request;
+}
+
+void Append(mtp::ByteArray& out, const mtp::ByteArray& frame) {
+    out.insert(out.end(), frame.begin(), frame.end());
+}
+
+// Our Config-Request and CCP Config-Request, built as NetworkManager did inline
+mtp::ByteArray ColdPrefix() {
+    mtp::ByteArray out;
+    Append(out, PPPParser::WrapPayload({0x01, 0x01, 0x00, 0x10, 0x02, 0x06, 0x00, 0x2d, 0x0f, 0x01,
+                                        0x03, 0x06, 0xC0, 0xA8, 0x37, 0x64}, 0x8021));
+    Append(out, PPPParser::WrapPayload({0x01, 0x01, 0x00, 0x0a, 0x12, 0x06, 0x00, 0x00, 0x00, 0x01}, 0x80fd));
+    return out;
+}
+
+} // namespace
+
+bool TestRepliesMatchColdBuild() {
+    std::cout << "Testing kept replies match freshly built ones..." << std::endl;
+    PPPLinkProfile profile;
+
+    auto first = DeviceRequest(1, 0);
+    mtp::ByteArray nak = ColdPrefix();
+    Append(nak, PPPParser::WrapPayload(
+        IPCPParser::BuildConfigNak(1, PPPLinkProfile::kDeviceIP, PPPLinkProfile::kDNSIP), 0x8021));
+    ASSERT_TRUE(profile.NakReply(first) == nak, "Config-Request + CCP + Config-Nak");
+
+    auto corrected = DeviceRequest(3, PPPLinkProfile::kDeviceIP);
+    mtp::ByteArray second = PPPParser::WrapPayload({0x01, 0x02, 0x00, 0x0a,
+                                                    0x03, 0x06, 0xC0, 0xA8, 0x37, 0x64}, 0x8021);
+    Append(second, PPPParser::WrapPayload(IPCPParser::BuildConfigAck(corrected), 0x8021));
+    ASSERT_TRUE(profile.SecondReply(corrected) == second, "Second Config-Request + Config-Ack");
+
+    mtp::ByteArray ack = ColdPrefix();
+    Append(ack, PPPParser::WrapPayload(IPCPParser::BuildConfigAck(corrected), 0x8021));
+    ASSERT_TRUE(profile.AckReply(corrected) == ack, "Config-Request + CCP + Config-Ack");
+
+    ASSERT_TRUE(PPPParser::IsValidFrame(profile.LCPResponse()), "LCP response is framed");
+    ASSERT_EQ(profile.GetStats().replies_built, uint64_t(3), "Each built once");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestReplyReuse() {
+    std::cout << "Testing reply reuse across sessions..." << std::endl;
+    PPPLinkProfile profile;
+
+    mtp::ByteArray first = profile.NakReply(DeviceRequest(1, 0));
+    mtp::ByteArray again = profile.NakReply(DeviceRequest(1, 0));
+    ASSERT_TRUE(first == again, "Same request, same reply");
+    ASSERT_EQ(profile.GetStats().replies_reused, uint64_t(1), "Reused");
+
+    // The device numbers its requests differently: the Nak must echo the new ID
+    mtp::ByteArray renumbered = profile.NakReply(DeviceRequest(7, 0));
+    ASSERT_TRUE(renumbered != first, "Identifier change rebuilds");
+    IPCPParser::IPCPPacket nak;
+    ASSERT_TRUE(PPPParserHelpers::FindIPCPFrame(renumbered, IPCPParser::IPCP_CODE_CONFIG_NAK, nak),
+                "Carries a Config-Nak");
+    ASSERT_EQ(static_cast<int>(nak.identifier), 7, "Echoes the device's identifier");
+
+    // Different options (a different requested address) rebuild too
+    mtp::ByteArray ack = profile.AckReply(DeviceRequest(1, PPPLinkProfile::kDeviceIP));
+    mtp::ByteArray other = profile.AckReply(DeviceRequest(1, 0xC0A83766));
+    ASSERT_TRUE(ack != other, "Options change rebuilds");
+
+    profile.RecordNegotiation(true, std::chrono::microseconds(1500));
+    PPPLinkProfile::Stats stats = profile.GetStats();
+    ASSERT_EQ(stats.replies_built, uint64_t(4), "Built");
+    ASSERT_EQ(stats.replies_reused, uint64_t(1), "Reused once");
+    ASSERT_EQ(stats.negotiations, uint64_t(1), "Negotiations");
+    ASSERT_TRUE(stats.nak_path, "Nak path");
+    ASSERT_EQ(stats.last_negotiation.count(), int64_t(1500), "Negotiation time");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDNSHandlerKept() {
+    std::cout << "Testing DNS handler reuse..." << std::endl;
+    PPPLinkProfile profile;
+    std::map<std::string, uint32_t> hostnames = {{"catalog.zune.net", 0xC0A8001E}};
+
+    auto first = profile.DNS(hostnames);
+    ASSERT_TRUE(first != nullptr, "Created");
+    ASSERT_TRUE(profile.DNS(hostnames) == first, "Same map, same handler");
+
+    hostnames["social.zune.net"] = 0xC0A8001E;
+    auto changed = profile.DNS(hostnames);
+    ASSERT_TRUE(changed != first, "Changed map, new handler");
+    ASSERT_TRUE(profile.DNS(hostnames) == changed, "Kept from then on");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestSessionCarryOver() {
+    std::cout << "Testing TCP state carried to the next session..." << std::endl;
+    PPPLinkProfile profile;
+    ASSERT_EQ(profile.PeakConnections(), size_t(0), "Nothing measured yet");
+
+    profile.RecordSession(12, 4000000);
+    profile.RecordSession(0, 0);  // A session that never carried traffic
+    ASSERT_EQ(profile.PeakConnections(), size_t(12), "Peak kept");
+    ASSERT_EQ(profile.LinkRate(), uint64_t(4000000), "Rate kept");
+
+    TCPConnectionManager manager;
+    manager.ReserveConnections(profile.PeakConnections());
+    manager.SeedLinkRate(profile.LinkRate());
+    ASSERT_EQ(manager.GetLinkRate(), uint64_t(4000000), "Pacing starts from the kept rate");
+    ASSERT_EQ(manager.GetPeakConnections(), size_t(0), "Reserving opens nothing");
+
+    // A real transfer soon outweighs the seed
+    for (int i = 0; i < 20; i++) {
+        manager.RecordLinkTransfer(1000, std::chrono::microseconds(1000));
+    }
+    ASSERT_TRUE(manager.GetLinkRate() < 1100000, "Measured rate takes over");
+
+    TCPConnectionTable<int> table;
+    table.Reserve(12);
+    for (uint16_t port = 1; port <= 12; port++) {
+        table.FindOrCreate(TCPConnectionKey{PPPLinkProfile::kDeviceIP, PPPLinkProfile::kHostIP, port, 80});
+    }
+    table.Erase(TCPConnectionKey{PPPLinkProfile::kDeviceIP, PPPLinkProfile::kHostIP, 1, 80});
+    ASSERT_EQ(table.Size(), size_t(11), "Size");
+    ASSERT_EQ(table.Peak(), size_t(12), "Peak");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " PPPLinkProfile Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestRepliesMatchColdBuild, "Replies Match Cold Build");
+    run_test(TestReplyReuse, "Reply Reuse");
+    run_test(TestDNSHandlerKept, "DNS Handler Kept");
+    run_test(TestSessionCarryOver, "Session Carry Over");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+/**
+ * test_ppp_parser.cpp
+ *
+ * Unit tests for PPP framing
+ * Tests byte stuffing and un-stuffing against a byte-at-a-time reference,
+ * the FCS-16 check values, frame splitting across USB packets and the
+ * one-pass TCP frame builder, and TCP options (SACK) both ways
+ */
+
+#include "lib/src/protocols/ppp/PPPParser.h"
+#include "lib/src/protocols/ppp/PPPFrameBuilder.h"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+// RFC 1662 appendix C, one byte at a time
+static uint16_t ReferenceFCS(const uint8_t* data, size_t length) {
+    uint16_t fcs = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        fcs ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            fcs = (fcs & 1) ? (fcs >> 1) ^ 0x8408 : fcs >> 1;
+        }
+    }
+    return fcs ^ 0xFFFF;
+}
+
+static mtp::ByteArray ReferenceWrap(const mtp::ByteArray& payload, uint16_t protocol) {
+    mtp::ByteArray content;
+    if ((protocol & 0xFF00) == 0) {
+        content.push_back(protocol & 0xFF);
+    } else {
+        content.push_back(protocol >> 8);
+        content.push_back(protocol & 0xFF);
+    }
+    content.insert(content.end(), payload.begin(), payload.end());
+    uint16_t fcs = ReferenceFCS(content.data(), content.size());
+    content.push_back(fcs & 0xFF);
+    content.push_back(fcs >> 8);
+
+    mtp::ByteArray frame{0x7E};
+    for (uint8_t byte : content) {
+        if (byte == 0x7D || byte == 0x7E) {
+            frame.push_back(0x7D);
+            frame.push_back(byte ^ 0x20);
+        } else {
+            frame.push_back(byte);
+        }
+    }
+    frame.push_back(0x7E);
+    return frame;
+}
+
+// Random payload; escape_every > 0 plants a 0x7D/0x7E about that often
+static mtp::ByteArray RandomPayload(std::mt19937& rng, size_t size, int escape_every) {
+    mtp::ByteArray payload(size);
+    for (auto& byte : payload) {
+        byte = static_cast<uint8_t>(rng());
+        if (escape_every > 0 && rng() % escape_every == 0) {
+            byte = (rng() & 1) ? 0x7D : 0x7E;
+        }
+    }
+    return payload;
+}
+
+bool TestFCS() {
+    std::cout << "Testing FCS-16..." << std::endl;
+
+    const std::string check = "123456789";
+    const uint8_t* check_data = reinterpret_cast<const uint8_t*>(check.data());
+    ASSERT_EQ(PPPParser::CalculateFCS(check_data, check.size()), uint16_t(0x906E), "CRC-16/X-25 check value");
+
+    std::mt19937 rng(7);
+    for (size_t size = 0; size < 300; size++) {
+        mtp::ByteArray data = RandomPayload(rng, size, 0);
+        uint16_t fcs = PPPParser::CalculateFCS(data.data(), data.size());
+        ASSERT_EQ(fcs, ReferenceFCS(data.data(), data.size()), "Matches bytewise FCS at size " + std::to_string(size));
+
+        // RFC 1662: FCS over data plus its FCS leaves the good residue
+        data.push_back(fcs & 0xFF);
+        data.push_back(fcs >> 8);
+        ASSERT_EQ(ReferenceFCS(data.data(), data.size()) ^ 0xFFFF, 0xF0B8, "Good FCS residue");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStuffingRoundTrip() {
+    std::cout << "Testing byte stuffing round trip..." << std::endl;
+
+    std::mt19937 rng(11);
+    const uint16_t protocols[] = {0x0021, 0x8021, 0xC021, 0x80FD};
+    const int densities[] = {0, 200, 16, 3, 1};
+    mtp::ByteArray reused;
+    for (int density : densities) {
+        for (size_t size : {size_t(0), size_t(1), size_t(15), size_t(16), size_t(17), size_t(63), size_t(1500), size_t(4133)}) {
+            uint16_t protocol = protocols[rng() % 4];
+            mtp::ByteArray payload = RandomPayload(rng, size, density);
+
+            mtp::ByteArray frame = PPPParser::WrapPayload(payload, protocol);
+            ASSERT_TRUE(frame == ReferenceWrap(payload, protocol), "Frame matches reference stuffing");
+            ASSERT_TRUE(frame.size() <= PPPParser::MaxFrameSize(size), "Within worst-case size");
+
+            PPPParser::WrapPayload(payload.data(), payload.size(), protocol, reused);
+            ASSERT_TRUE(reused == frame, "Reused buffer frame");
+
+            if (size == 0) {
+                continue;
+            }
+            uint16_t parsed_protocol = 0;
+            mtp::ByteArray unwrapped = PPPParser::ExtractPayload(frame, &parsed_protocol);
+            ASSERT_EQ(parsed_protocol, protocol, "Protocol survives");
+            ASSERT_TRUE(unwrapped == payload, "Payload survives stuffing");
+        }
+    }
+
+    // Every escaped byte value, and a corrupted frame
+    mtp::ByteArray all(256);
+    for (int i = 0; i < 256; i++) all[i] = static_cast<uint8_t>(i);
+    mtp::ByteArray frame = PPPParser::WrapPayload(all);
+    ASSERT_TRUE(PPPParser::ExtractPayload(frame) == all, "All byte values");
+    frame[40] ^= 0x01;
+    bool threw = false;
+    try {
+        PPPParser::ExtractPayload(frame);
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw, "FCS mismatch detected");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFrameSplitting() {
+    std::cout << "Testing frame splitting across packets..." << std::endl;
+
+    std::mt19937 rng(3);
+    std::vector<mtp::ByteArray> sent;
+    mtp::ByteArray stream{0x11, 0x22};  // Junk before the first flag is skipped
+    for (size_t i = 0; i < 20; i++) {
+        sent.push_back(PPPParser::WrapPayload(RandomPayload(rng, 1 + rng() % 700, 20)));
+        stream.insert(stream.end(), sent.back().begin(), sent.back().end());
+        if (i == 5) {
+            stream.insert(stream.end(), {0x7E, 0x7E});  // Empty frame is dropped
+        }
+    }
+
+    ASSERT_EQ(PPPParser::ExtractFrames(stream).size(), sent.size(), "Whole buffer");
+
+    for (size_t packet : {size_t(1), size_t(7), size_t(64), size_t(512), size_t(5000)}) {
+        std::vector<mtp::ByteArray> received;
+        mtp::ByteArray incomplete;
+        for (size_t pos = 0; pos < stream.size(); pos += packet) {
+            mtp::ByteArray chunk(stream.begin() + pos, stream.begin() + std::min(stream.size(), pos + packet));
+            for (auto& frame : PPPParser::ExtractFramesWithBuffer(chunk, incomplete)) {
+                received.push_back(std::move(frame));
+            }
+        }
+        ASSERT_EQ(received.size(), sent.size(), "Frame count with packet size " + std::to_string(packet));
+        for (size_t i = 0; i < sent.size(); i++) {
+            ASSERT_TRUE(received[i] == sent[i], "Frame intact across packets");
+        }
+        ASSERT_TRUE(incomplete.empty(), "Nothing left over");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestTCPFrameBuilder() {
+    std::cout << "Testing one-pass TCP frame building..." << std::endl;
+
+    std::mt19937 rng(5);
+    mtp::ByteArray body = RandomPayload(rng, 4000, 40);
+    mtp::ByteArray frame;
+    for (size_t size : {size_t(0), size_t(1), size_t(2), size_t(1459), size_t(1460), size_t(4000)}) {
+        uint32_t src_ip = 0xC0A8001E, dst_ip = 0xC0A83765;
+        uint8_t flags = TCPParser::TCP_FLAG_ACK | TCPParser::TCP_FLAG_PSH;
+
+        // The layered path: BuildSegment, BuildPacket, then WrapPayload
+        mtp::ByteArray slice(body.begin(), body.begin() + size);
+        TCPParser::TCPHeader tcp = {};
+        tcp.src_port = 80;
+        tcp.dst_port = 50120;
+        tcp.seq_num = 0xFFFFF000u + static_cast<uint32_t>(size);
+        tcp.ack_num = 12345;
+        tcp.data_offset = 5;
+        tcp.flags = flags;
+        tcp.window_size = 65535;
+        IPParser::IPHeader ip = {};
+        ip.version = 4;
+        ip.header_length = 5;
+        ip.ttl = 64;
+        ip.protocol = 6;
+        ip.src_ip = src_ip;
+        ip.dst_ip = dst_ip;
+        srand(static_cast<unsigned>(size));
+        ip.identification = rand() % 65536;
+        mtp::ByteArray layered = PPPParser::WrapPayload(
+            IPParser::BuildPacket(ip, TCPParser::BuildSegment(tcp, slice, src_ip, dst_ip)));
+
+        srand(static_cast<unsigned>(size));
+        PPPFrameBuilder::BuildTCPFrame(src_ip, 80, dst_ip, 50120, tcp.seq_num, tcp.ack_num, flags,
+                                       body.data(), size, frame);
+        ASSERT_TRUE(frame == layered, "Same bytes as the layered builders for " + std::to_string(size) + " bytes");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestTCPOptions() {
+    std::cout << "Testing TCP options (SACK)..." << std::endl;
+
+    // SYN-ACK echoing SACK-permitted, through the whole frame
+    uint32_t src_ip = 0xC0A8001E, dst_ip = 0xC0A83765;
+    mtp::ByteArray payload{'h', 'i'};
+    mtp::ByteArray frame = PPPFrameBuilder::BuildTCPFrameWithOptions(
+        src_ip, 80, dst_ip, 50120, 1000, 2000, TCPParser::TCP_FLAG_SYN | TCPParser::TCP_FLAG_ACK,
+        mtp::ByteArray{1, 1, 4, 2}, payload);
+    mtp::ByteArray ip_packet = PPPParser::ExtractPayload(frame);
+    mtp::ByteArray segment = IPParser::ExtractPayload(ip_packet);
+    TCPParser::TCPHeader header = TCPParser::ParseHeader(segment);
+    ASSERT_EQ(int(header.data_offset), 6, "Header grew by the options");
+    ASSERT_TRUE(TCPParser::ExtractPayload(segment) == payload, "Payload after the options");
+    ASSERT_EQ(TCPParser::CalculateChecksum(segment.data(), segment.size(), src_ip, dst_ip),
+              uint16_t((segment[16] << 8) | segment[17]), "Checksum covers the options");
+    ASSERT_TRUE(TCPParser::ParseOptions(segment).sack_permitted, "SACK-permitted parsed");
+
+    // An ACK with two SACK blocks, as the device sends them
+    mtp::ByteArray options{1, 1, 5, 18,
+                           0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x20, 0x00,
+                           0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x01, 0x00};
+    frame = PPPFrameBuilder::BuildTCPFrameWithOptions(src_ip, 80, dst_ip, 50120, 1000, 2000,
+                                                      TCPParser::TCP_FLAG_ACK, options);
+    segment = IPParser::ExtractPayload(PPPParser::ExtractPayload(frame));
+    TCPParser::Options parsed = TCPParser::ParseOptions(segment);
+    ASSERT_EQ(parsed.sack_block_count, size_t(2), "Two blocks");
+    ASSERT_EQ(parsed.sack_blocks[0].left_edge, uint32_t(0x1000), "First left edge");
+    ASSERT_EQ(parsed.sack_blocks[0].right_edge, uint32_t(0x2000), "First right edge");
+    ASSERT_EQ(parsed.sack_blocks[1].left_edge, uint32_t(0xFFFFF000), "Second left edge");
+    ASSERT_EQ(parsed.sack_blocks[1].right_edge, uint32_t(0x100), "Second right edge, wrapped");
+    ASSERT_TRUE(!parsed.sack_permitted, "No SACK-permitted on an ACK");
+
+    // A truncated option ends the walk; unpadded options are refused
+    segment[20 + 3] = 30;
+    ASSERT_EQ(TCPParser::ParseOptions(segment).sack_block_count, size_t(0), "Length past the header");
+    bool refused = false;
+    try {
+        PPPFrameBuilder::BuildTCPFrameWithOptions(src_ip, 80, dst_ip, 50120, 1, 2, TCPParser::TCP_FLAG_ACK,
+                                                  mtp::ByteArray{4, 2});
+    } catch (const std::invalid_argument&) {
+        refused = true;
+    }
+    ASSERT_TRUE(refused, "Options not a multiple of 4");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " PPP Framing Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestFCS, "FCS-16");
+    run_test(TestStuffingRoundTrip, "Stuffing Round Trip");
+    run_test(TestFrameSplitting, "Frame Splitting");
+    run_test(TestTCPFrameBuilder, "TCP Frame Builder");
+    run_test(TestTCPOptions, "TCP Options");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
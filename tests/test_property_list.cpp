@@ -0,0 +1,244 @@
+/**
+ * test_property_list.cpp
+ *
+ * Unit tests for the GetObjectPropertyList decoder (ZunePropertyList.h)
+ * Tests integer widths, strings as views, arrays, malformed datasets, and
+ * that walking a list allocates nothing per element
+ */
+
+#include "tests/allocation_budget.h"
+#include "lib/src/ZunePropertyList.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::ForEachProperty;
+using zune::PropertyEntry;
+namespace PropType = zune::PropType;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+// Builds a dataset the way the device sends one
+struct ListBuilder {
+    std::vector<uint8_t> data{0, 0, 0, 0};
+    uint32_t count = 0;
+
+    void Put(uint64_t value, size_t width) {
+        for (size_t b = 0; b < width; b++) data.push_back(static_cast<uint8_t>(value >> (8 * b)));
+    }
+    void Header(uint32_t handle, uint16_t property, uint16_t type) {
+        Put(handle, 4);
+        Put(property, 2);
+        Put(type, 2);
+        count++;
+        for (size_t b = 0; b < 4; b++) data[b] = static_cast<uint8_t>(count >> (8 * b));
+    }
+    ListBuilder& Integer(uint32_t handle, uint16_t property, uint16_t type, uint64_t value) {
+        Header(handle, property, type);
+        Put(value, zune::PropertyScalarSize(type));
+        return *this;
+    }
+    ListBuilder& String(uint32_t handle, uint16_t property, const std::u16string& text) {
+        Header(handle, property, PropType::String);
+        if (text.empty()) {
+            data.push_back(0);
+            return *this;
+        }
+        data.push_back(static_cast<uint8_t>(text.size() + 1));
+        for (char16_t c : text) Put(c, 2);
+        Put(0, 2);
+        return *this;
+    }
+};
+
+bool TestIntegers() {
+    std::cout << "Testing integer widths..." << std::endl;
+    ListBuilder list;
+    list.Integer(1, 0xDC04, PropType::UInt64, 0x123456789ABCull)
+        .Integer(2, 0xDC03, PropType::UInt16, 0x3009)
+        .Integer(3, 0xDC0B, PropType::UInt32, 0x10)
+        .Integer(4, 0xDC8B, PropType::UInt8, 7)
+        .Integer(5, 0xDC90, PropType::Int64, 0x1122334455667788ull);
+
+    std::vector<uint64_t> values;
+    std::vector<uint32_t> handles;
+    bool integers = true;
+    bool ok = ForEachProperty(list.data, [&](const PropertyEntry& entry) {
+        integers = integers && entry.IsInteger();
+        handles.push_back(entry.handle);
+        values.push_back(entry.Integer());
+    });
+    ASSERT_TRUE(ok, "Well formed");
+    ASSERT_TRUE(integers, "Integer types");
+    ASSERT_TRUE(handles == std::vector<uint32_t>({1, 2, 3, 4, 5}), "Every element, in order");
+    ASSERT_EQ(values[0], uint64_t(0x123456789ABCull), "UInt64");
+    ASSERT_EQ(values[1], uint64_t(0x3009), "UInt16");
+    ASSERT_EQ(values[2], uint64_t(0x10), "UInt32");
+    ASSERT_EQ(values[3], uint64_t(7), "UInt8");
+    ASSERT_EQ(values[4], uint64_t(0x1122334455667788ull), "Int64 is 8 bytes, not 4");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStrings() {
+    std::cout << "Testing strings as views..." << std::endl;
+    ListBuilder list;
+    list.String(0x10, 0xDC07, u"Music")
+        .String(0x11, 0xDC07, u"")
+        .String(0x12, 0xDC07, u"Björk")
+        .Integer(0x13, 0xDC07, PropType::UInt32, 5);
+
+    std::vector<PropertyEntry> entries;
+    ASSERT_TRUE(ForEachProperty(list.data, [&](const PropertyEntry& entry) { entries.push_back(entry); }),
+                "Well formed");
+    ASSERT_EQ(entries.size(), size_t(4), "Four elements");
+
+    ASSERT_TRUE(entries[0].IsString() && entries[0].String().Equals("Music"), "Compared in place");
+    ASSERT_TRUE(!entries[0].String().Equals("Musi") && !entries[0].String().Equals("Music!"),
+                "Length mismatch");
+    ASSERT_EQ(entries[0].String().Units(), size_t(5), "Terminator excluded");
+    ASSERT_EQ(entries[0].String().ToUtf8(), std::string("Music"), "Converted on request");
+    ASSERT_TRUE(entries[0].String().Bytes().data() > list.data.data() &&
+                    entries[0].String().Bytes().end() < list.data.data() + list.data.size(),
+                "A view into the dataset");
+
+    ASSERT_TRUE(entries[1].IsString() && entries[1].String().Empty(), "Zero-length string");
+    ASSERT_EQ(entries[2].String().ToUtf8(), std::string("Bj\xC3\xB6rk"), "Non-ASCII to UTF-8");
+    ASSERT_TRUE(!entries[2].String().Equals("Bj\xC3\xB6rk"), "Equals is ASCII only");
+    ASSERT_TRUE(!entries[3].IsString() && entries[3].String().Empty(), "Not a string");
+    ASSERT_EQ(entries[0].Integer(), uint64_t(0), "Not an integer");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestArraysAndMalformed() {
+    std::cout << "Testing arrays and malformed lists..." << std::endl;
+    // AUINT16 (e.g. a URL), then an integer after it
+    ListBuilder list;
+    list.Header(0x20, 0xDC7D, PropType::Array | PropType::UInt16);
+    list.Put(3, 4);
+    list.Put('a', 2);
+    list.Put('b', 2);
+    list.Put('c', 2);
+    list.Integer(0x21, 0xDC04, PropType::UInt32, 42);
+
+    std::vector<PropertyEntry> entries;
+    ASSERT_TRUE(ForEachProperty(list.data, [&](const PropertyEntry& entry) { entries.push_back(entry); }),
+                "Well formed");
+    ASSERT_EQ(entries.size(), size_t(2), "Array skipped as a whole");
+    ASSERT_EQ(entries[0].value.size(), size_t(10), "Count prefix and three units");
+    ASSERT_TRUE(!entries[0].IsInteger(), "Arrays are not integers");
+    ASSERT_EQ(entries[1].Integer(), uint64_t(42), "Element after the array");
+
+    // Truncated value: the first element is still visited
+    ListBuilder truncated;
+    truncated.Integer(1, 0xDC04, PropType::UInt32, 1).Integer(2, 0xDC04, PropType::UInt64, 2);
+    truncated.data.resize(truncated.data.size() - 3);
+    size_t visited = 0;
+    ASSERT_TRUE(!ForEachProperty(truncated.data, [&](const PropertyEntry&) { visited++; }), "Truncated");
+    ASSERT_EQ(visited, size_t(1), "Elements before the fault");
+
+    // More elements promised than sent
+    ListBuilder short_list;
+    short_list.Integer(1, 0xDC04, PropType::UInt32, 1);
+    short_list.data[0] = 2;
+    ASSERT_TRUE(!ForEachProperty(short_list.data, [](const PropertyEntry&) {}), "Count exceeds data");
+
+    // Unknown type: its size is unknown, so nothing after it can be read
+    ListBuilder unknown;
+    unknown.Header(1, 0xDC04, 0x0042);
+    ASSERT_TRUE(!ForEachProperty(unknown.data, [](const PropertyEntry&) {}), "Unknown type");
+
+    // String running past the end
+    ListBuilder long_string;
+    long_string.String(1, 0xDC07, u"Playlists");
+    long_string.data.resize(long_string.data.size() - 4);
+    ASSERT_TRUE(!ForEachProperty(long_string.data, [](const PropertyEntry&) {}), "String overrun");
+
+    std::vector<uint8_t> empty;
+    ASSERT_TRUE(!ForEachProperty(empty, [](const PropertyEntry&) {}), "No count");
+    std::vector<uint8_t> none{0, 0, 0, 0};
+    ASSERT_TRUE(ForEachProperty(none, [](const PropertyEntry&) {}), "Empty list");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestNoAllocations() {
+    std::cout << "Testing allocations while walking a large list..." << std::endl;
+    // A full-device name list: tens of thousands of objects
+    constexpr uint32_t kObjects = 20000;
+    ListBuilder list;
+    for (uint32_t i = 0; i < kObjects; i++) {
+        list.String(i + 1, 0xDC44, i % 7 ? u"Track name that is not short" : u"Albums");
+    }
+
+    size_t strings = 0;
+    uint32_t albums = 0;
+    alloc_budget::AllocationScope scope;
+    bool ok = ForEachProperty(list.data, [&](const PropertyEntry& entry) {
+        zune::PropertyString name = entry.String();
+        strings += name.Units();
+        if (name.Equals("Albums")) albums++;
+    });
+    uint64_t allocations = scope.Allocations();
+    ASSERT_TRUE(ok, "Well formed");
+    ASSERT_EQ(albums, (kObjects + 6) / 7, "Matched in place");
+    ASSERT_TRUE(strings > 0, "Names seen");
+    ASSERT_TRUE(alloc_budget::WithinBudget("Property list walk", allocations, kObjects, 0.0),
+                "No allocation per element");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Property List Decoder Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestIntegers, "Integers");
+    run_test(TestStrings, "Strings");
+    run_test(TestArraysAndMalformed, "Arrays And Malformed");
+    run_test(TestNoAllocations, "No Allocations");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
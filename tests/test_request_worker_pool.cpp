@@ -0,0 +1,176 @@
+/**
+ * test_request_worker_pool.cpp
+ *
+ * Unit tests for the two-lane HTTP request worker pool
+ * Tests that fast requests are not stuck behind slow ones, work stealing
+ * in both directions, per-lane timing counters and shutdown
+ */
+
+#include "lib/src/protocols/http/RequestWorkerPool.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+// Item: how long to take, and a flag to set when done
+struct TestRequest {
+    int millis = 0;
+    std::atomic<bool>* done = nullptr;
+};
+
+static void Serve(TestRequest& request) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(request.millis));
+    if (request.done) {
+        *request.done = true;
+    }
+}
+
+static bool WaitFor(const std::atomic<bool>& flag, int millis) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(millis);
+    while (!flag && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return flag;
+}
+
+bool TestFastLaneNotBlocked() {
+    std::cout << "Testing fast lane beside busy slow lane..." << std::endl;
+    RequestWorkerPool<TestRequest> pool;
+    pool.Start(1, 2, Serve);
+
+    // More slow work than slow workers; the lone fast worker must not take it
+    for (int i = 0; i < 4; i++) {
+        pool.Push(RequestLane::Slow, TestRequest{300, nullptr});
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::atomic<bool> fast_done{false};
+    pool.Push(RequestLane::Fast, TestRequest{0, &fast_done});
+    ASSERT_TRUE(WaitFor(fast_done, 100), "Fast request served while slow lane is busy");
+
+    RequestWorkerStats stats = pool.GetStats();
+    ASSERT_EQ(stats.fast.workers, uint64_t(1), "Fast workers");
+    ASSERT_EQ(stats.slow.workers, uint64_t(2), "Slow workers");
+    ASSERT_EQ(stats.fast.completed, uint64_t(1), "Fast completed");
+    ASSERT_EQ(stats.slow.stolen, uint64_t(0), "Single fast worker does not steal");
+    ASSERT_TRUE(stats.fast.wait_us_max < 100000, "Fast wait short");
+
+    pool.Stop();
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStealing() {
+    std::cout << "Testing work stealing..." << std::endl;
+    RequestWorkerPool<TestRequest> pool;
+    pool.Start(2, 1, Serve);
+
+    // Slow lane: one worker, two requests; an idle fast worker takes the
+    // second while the other fast worker stays free
+    std::atomic<bool> first{false}, second{false};
+    pool.Push(RequestLane::Slow, TestRequest{200, &first});
+    pool.Push(RequestLane::Slow, TestRequest{200, &second});
+    ASSERT_TRUE(WaitFor(first, 1000) && WaitFor(second, 1000), "Both slow requests served");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    RequestWorkerStats stats = pool.GetStats();
+    ASSERT_EQ(stats.slow.completed, uint64_t(2), "Slow completed");
+    ASSERT_EQ(stats.slow.stolen, uint64_t(1), "One stolen by a fast worker");
+    ASSERT_TRUE(stats.slow.wait_us_max < 150000, "Stolen request did not wait for the slow worker");
+    pool.Stop();
+
+    // Fast lane with one worker: the slow worker helps out
+    RequestWorkerPool<TestRequest> helper;
+    helper.Start(1, 1, Serve);
+    std::atomic<bool> a{false}, b{false};
+    helper.Push(RequestLane::Fast, TestRequest{200, &a});
+    helper.Push(RequestLane::Fast, TestRequest{200, &b});
+    ASSERT_TRUE(WaitFor(a, 1000) && WaitFor(b, 1000), "Both fast requests served");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    stats = helper.GetStats();
+    ASSERT_EQ(stats.fast.stolen, uint64_t(1), "Slow worker stole fast work");
+    ASSERT_TRUE(stats.fast.service_us_total >= 400000, "Service time recorded");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStop() {
+    std::cout << "Testing stop..." << std::endl;
+    std::atomic<int> served{0};
+    RequestWorkerPool<TestRequest> pool;
+    pool.Start(1, 1, [&served](TestRequest& request) {
+        Serve(request);
+        served++;
+    });
+    for (int i = 0; i < 10; i++) {
+        pool.Push(RequestLane::Slow, TestRequest{50, nullptr});
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pool.Stop();
+
+    int after_stop = served.load();
+    ASSERT_TRUE(after_stop < 10, "Queued requests dropped on stop");
+    ASSERT_EQ(pool.GetStats().slow.depth, uint64_t(0), "Queue empty after stop");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(served.load(), after_stop, "Nothing served after stop");
+
+    // Restartable (the interceptor starts it per session)
+    std::atomic<bool> done{false};
+    pool.Start(1, 1, Serve);
+    pool.Push(RequestLane::Fast, TestRequest{0, &done});
+    ASSERT_TRUE(WaitFor(done, 500), "Served after restart");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Request Worker Pool Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestFastLaneNotBlocked, "Fast Lane Not Blocked");
+    run_test(TestStealing, "Stealing");
+    run_test(TestStop, "Stop");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
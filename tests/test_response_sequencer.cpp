@@ -0,0 +1,199 @@
+/**
+ * test_response_sequencer.cpp
+ *
+ * Unit tests for ResponseSequencer
+ * Tests commits in turn, parked responses committed by the one ahead of
+ * them, requests without a response, Reset on connection reuse, and
+ * workers finishing in random order
+ */
+
+#include "lib/src/protocols/tcp/ResponseSequencer.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestInTurn() {
+    std::cout << "Testing commits in turn..." << std::endl;
+    ResponseSequencer order;
+    std::vector<int> sent;
+    uint64_t first = order.Assign();
+    uint64_t second = order.Assign();
+    ASSERT_EQ(first, uint64_t(1), "Numbered from 1");
+    ASSERT_EQ(second, uint64_t(2), "Then 2");
+
+    ASSERT_FALSE(order.TryCommit(second, [&] { sent.push_back(2); }), "Second waits for the first");
+    ASSERT_TRUE(sent.empty(), "Nothing sent out of turn");
+    ASSERT_TRUE(order.TryCommit(first, [&] { sent.push_back(1); }), "First commits");
+    ASSERT_TRUE(order.TryCommit(second, [&] { sent.push_back(2); }), "Then the second");
+    ASSERT_TRUE(sent == std::vector<int>({1, 2}), "Request order");
+    ASSERT_EQ(order.Parked(), size_t(0), "Nothing parked");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestParked() {
+    std::cout << "Testing parked responses..." << std::endl;
+    ResponseSequencer order;
+    std::vector<int> sent;
+    for (int i = 0; i < 4; i++) {
+        order.Assign();
+    }
+
+    // 3 and 2 finish before the slow 1; 4 has not finished
+    order.Submit(3, [&] { sent.push_back(3); });
+    order.Submit(2, [&] { sent.push_back(2); });
+    ASSERT_TRUE(sent.empty(), "Held behind the first");
+    ASSERT_EQ(order.Parked(), size_t(2), "Two parked");
+
+    // Committing the first runs the parked ones behind it
+    ASSERT_TRUE(order.TryCommit(1, [&] { sent.push_back(1); }), "First commits");
+    ASSERT_TRUE(sent == std::vector<int>({1, 2, 3}), "Parked ones follow in order");
+    ASSERT_EQ(order.Parked(), size_t(0), "None left");
+
+    order.Submit(4, [&] { sent.push_back(4); });
+    ASSERT_TRUE(sent == std::vector<int>({1, 2, 3, 4}), "In turn: committed at once");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestNoResponse() {
+    std::cout << "Testing requests without a response..." << std::endl;
+    ResponseSequencer order;
+    std::vector<int> sent;
+    order.Assign();
+    order.Assign();
+    order.Submit(2, [&] { sent.push_back(2); });
+    order.Submit(1, nullptr);
+    ASSERT_TRUE(sent == std::vector<int>({2}), "An empty commit lets the next one go");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestReset() {
+    std::cout << "Testing Reset on connection reuse..." << std::endl;
+    ResponseSequencer order;
+    std::vector<int> sent;
+    order.Assign();
+    order.Assign();
+    order.Submit(2, [&] { sent.push_back(2); });
+
+    // New connection: what the old one owed is dropped
+    order.Reset();
+    ASSERT_EQ(order.Parked(), size_t(0), "Parked response dropped");
+    uint64_t next = order.Assign();
+    ASSERT_EQ(next, uint64_t(3), "Numbers are not reused");
+
+    order.Submit(1, [&] { sent.push_back(1); });
+    ASSERT_FALSE(order.TryCommit(2, [&] { sent.push_back(2); }), "Retired index cannot commit");
+    ASSERT_TRUE(order.TryCommit(next, [&] { sent.push_back(3); }), "New request in turn");
+    ASSERT_TRUE(sent == std::vector<int>({3}), "Only the new connection's response");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestConcurrentWorkers() {
+    std::cout << "Testing workers finishing in random order..." << std::endl;
+    constexpr int kRequests = 2000;
+    constexpr int kWorkers = 6;
+    ResponseSequencer order;
+    std::vector<uint64_t> indices(kRequests);
+    for (auto& index : indices) {
+        index = order.Assign();
+    }
+    std::shuffle(indices.begin(), indices.end(), std::mt19937(77));
+
+    std::mutex sent_mutex;
+    std::vector<uint64_t> sent;
+    std::vector<std::thread> workers;
+    for (int w = 0; w < kWorkers; w++) {
+        workers.emplace_back([&, w] {
+            for (int i = w; i < kRequests; i += kWorkers) {
+                uint64_t index = indices[i];
+                auto commit = [&, index] {
+                    std::lock_guard<std::mutex> lock(sent_mutex);
+                    sent.push_back(index);
+                };
+                if (!order.TryCommit(index, commit)) {
+                    order.Submit(index, commit);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    ASSERT_EQ(sent.size(), size_t(kRequests), "Every response committed once");
+    ASSERT_TRUE(std::is_sorted(sent.begin(), sent.end()), "In request order");
+    ASSERT_EQ(order.Parked(), size_t(0), "Nothing left parked");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Response Sequencer Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestInTurn, "In Turn");
+    run_test(TestParked, "Parked");
+    run_test(TestNoResponse, "No Response");
+    run_test(TestReset, "Reset");
+    run_test(TestConcurrentWorkers, "Concurrent Workers");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
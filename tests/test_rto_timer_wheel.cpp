@@ -0,0 +1,210 @@
+/**
+ * test_rto_timer_wheel.cpp
+ *
+ * Unit tests for the hierarchical RTO timer wheel
+ * Tests exact expiry at each level, cascading between levels, the next
+ * deadline reported to the poller, idle gaps and deadlines past the top
+ * level, and checks random schedules against a sorted reference
+ */
+
+#include "lib/src/protocols/tcp/RTOTimerWheel.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+static TCPConnectionKey Key(uint16_t port) {
+    TCPConnectionKey key;
+    key.src_ip = 0xC0A83765;
+    key.dst_ip = 0xC0A83764;
+    key.src_port = port;
+    key.dst_port = 80;
+    return key;
+}
+
+bool TestExactExpiry() {
+    std::cout << "Testing expiry at the deadline..." << std::endl;
+    auto t0 = RTOTimerWheel::Clock::now();
+    RTOTimerWheel wheel(t0);
+
+    ASSERT_FALSE(wheel.NextDeadline().has_value(), "Empty wheel has no deadline");
+    ASSERT_TRUE(wheel.Expire(t0 + seconds(10)).empty(), "Nothing to expire");
+
+    // Levels 0, 1 and 2, with deadlines inside a tick
+    auto t = t0 + seconds(10);
+    wheel.Schedule(Key(1), 100, t + milliseconds(205));
+    wheel.Schedule(Key(1), 200, t + milliseconds(3007));
+    wheel.Schedule(Key(2), 300, t + milliseconds(61003));
+    ASSERT_EQ(wheel.Size(), size_t(3), "Three timers");
+    ASSERT_TRUE(wheel.NextDeadline() == t + milliseconds(205), "Earliest deadline");
+
+    ASSERT_TRUE(wheel.Expire(t + milliseconds(204)).empty(), "Not before its deadline");
+    auto due = wheel.Expire(t + milliseconds(205));
+    ASSERT_EQ(due.size(), size_t(1), "Fires at its deadline");
+    ASSERT_EQ(due[0].seq_start, uint32_t(100), "First timer");
+
+    ASSERT_TRUE(wheel.NextDeadline() == t + milliseconds(3007), "Next from level 1");
+    ASSERT_TRUE(wheel.Expire(t + milliseconds(3006)).empty(), "Cascaded, not early");
+    due = wheel.Expire(t + milliseconds(3007));
+    ASSERT_EQ(due.size(), size_t(1), "Level 1 timer fires");
+    ASSERT_TRUE(due[0].conn_key == Key(1), "Key kept");
+
+    ASSERT_TRUE(wheel.NextDeadline() == t + milliseconds(61003), "Next from level 2");
+    due = wheel.Expire(t + seconds(120));
+    ASSERT_EQ(due.size(), size_t(1), "Level 2 timer fires late poll");
+    ASSERT_EQ(due[0].seq_start, uint32_t(300), "Third timer");
+    ASSERT_EQ(wheel.Size(), size_t(0), "Empty again");
+    ASSERT_FALSE(wheel.NextDeadline().has_value(), "No deadline when idle");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPastAndFarDeadlines() {
+    std::cout << "Testing past and far deadlines..." << std::endl;
+    auto t0 = RTOTimerWheel::Clock::now();
+    RTOTimerWheel wheel(t0);
+
+    // An hour idle, then a deadline already passed
+    auto t = t0 + std::chrono::hours(1);
+    ASSERT_TRUE(wheel.Expire(t).empty(), "Idle hour");
+    wheel.Schedule(Key(1), 1, t - seconds(1));
+    ASSERT_TRUE(wheel.NextDeadline() == t - seconds(1), "Past deadline reported as is");
+    ASSERT_EQ(wheel.Expire(t).size(), size_t(1), "Past deadline fires on the next expiry");
+
+    // Beyond the top level (44 min): held, never fired early
+    auto far = t + std::chrono::hours(2);
+    wheel.Schedule(Key(1), 2, far);
+    ASSERT_TRUE(wheel.NextDeadline() == far, "Far deadline reported");
+    ASSERT_TRUE(wheel.Expire(far - milliseconds(1)).empty(), "Not early");
+    ASSERT_EQ(wheel.Expire(far).size(), size_t(1), "Fires at its deadline");
+
+    // Several due at once come back earliest first
+    wheel.Schedule(Key(1), 30, far + milliseconds(300));
+    wheel.Schedule(Key(1), 10, far + milliseconds(100));
+    wheel.Schedule(Key(1), 20, far + milliseconds(200));
+    auto due = wheel.Expire(far + seconds(1));
+    ASSERT_EQ(due.size(), size_t(3), "All three");
+    ASSERT_TRUE(due[0].seq_start == 10 && due[1].seq_start == 20 && due[2].seq_start == 30, "In deadline order");
+
+    wheel.Schedule(Key(1), 40, far + seconds(5));
+    wheel.Clear();
+    ASSERT_EQ(wheel.Size(), size_t(0), "Cleared");
+    ASSERT_TRUE(wheel.Expire(far + seconds(10)).empty(), "Nothing left to fire");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestRandomAgainstReference() {
+    std::cout << "Testing random schedules against a sorted reference..." << std::endl;
+    auto t0 = RTOTimerWheel::Clock::now();
+    RTOTimerWheel wheel(t0);
+    std::vector<RTOTimer> reference;
+
+    std::mt19937 rng(41);
+    std::uniform_int_distribution<int> rto_ms(1, 90000);
+    std::uniform_int_distribution<int> step_ms(0, 700);
+    auto now = t0;
+    uint32_t seq = 0;
+
+    for (int round = 0; round < 3000; round++) {
+        for (int i = 0; i < 3; i++) {
+            auto deadline = now + milliseconds(rto_ms(rng));
+            wheel.Schedule(Key(1), seq, deadline);
+            reference.push_back(RTOTimer{Key(1), seq, deadline});
+            seq++;
+        }
+
+        // Next deadline must be exact
+        auto earliest = std::min_element(reference.begin(), reference.end(),
+            [](const RTOTimer& a, const RTOTimer& b) { return a.deadline < b.deadline; });
+        auto next = wheel.NextDeadline();
+        ASSERT_TRUE(next.has_value() && *next == earliest->deadline, "Next deadline matches reference");
+
+        now += milliseconds(step_ms(rng));
+        std::vector<RTOTimer> due = wheel.Expire(now);
+        std::vector<uint32_t> expected;
+        for (auto it = reference.begin(); it != reference.end();) {
+            if (it->deadline <= now) {
+                expected.push_back(it->seq_start);
+                it = reference.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        std::vector<uint32_t> got;
+        for (const RTOTimer& timer : due) {
+            got.push_back(timer.seq_start);
+        }
+        std::sort(got.begin(), got.end());
+        std::sort(expected.begin(), expected.end());
+        ASSERT_TRUE(got == expected, "Expired set matches reference at round " + std::to_string(round));
+        ASSERT_EQ(wheel.Size(), reference.size(), "Sizes agree");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " RTO Timer Wheel Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestExactExpiry, "Exact Expiry");
+    run_test(TestPastAndFarDeadlines, "Past and Far Deadlines");
+    run_test(TestRandomAgainstReference, "Random Against Reference");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+/**
+ * test_static_file_cache.cpp
+ *
+ * Unit tests for memory-mapped static file serving
+ * Tests mapping reuse, revalidation when a file changes, size limits,
+ * eviction, and responses whose body is a mapped file
+ */
+
+#include "lib/src/protocols/http/StaticFileCache.h"
+#include "lib/src/protocols/http/HTTPParser.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+static std::string TempPath(const std::string& name) {
+    return "test_static_file_cache_" + name + ".tmp";
+}
+
+static void WriteFile(const std::string& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+}
+
+static std::string Contents(const zune::FileSource& file) {
+    return std::string(reinterpret_cast<const char*>(file.Data()), static_cast<size_t>(file.Size()));
+}
+
+bool TestMappingReuse() {
+    std::cout << "Testing mapping reuse..." << std::endl;
+    std::string path = TempPath("reuse");
+    WriteFile(path, "<biography>text</biography>");
+    StaticFileCache cache;
+
+    auto first = cache.Open(path, 1024);
+    ASSERT_TRUE(first != nullptr, "File mapped");
+    ASSERT_EQ(Contents(*first), std::string("<biography>text</biography>"), "Mapped contents");
+
+    auto second = cache.Open(path, 1024);
+    ASSERT_TRUE(second == first, "Second open reuses the mapping");
+    ASSERT_EQ(cache.Hits(), uint64_t(1), "Hit counted");
+    ASSERT_EQ(cache.Maps(), uint64_t(1), "Mapped once");
+
+    std::remove(path.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestRevalidation() {
+    std::cout << "Testing revalidation of changed files..." << std::endl;
+    std::string path = TempPath("changed");
+    WriteFile(path, "old");
+    StaticFileCache cache;
+
+    auto old_file = cache.Open(path, 1024);
+    ASSERT_TRUE(old_file != nullptr, "Old version mapped");
+
+    // Replaced (new inode), as the storage callback writes it
+    std::string replacement = path + ".new";
+    WriteFile(replacement, "new contents");
+    std::rename(replacement.c_str(), path.c_str());
+
+    auto new_file = cache.Open(path, 1024);
+    ASSERT_TRUE(new_file != nullptr && new_file != old_file, "Changed file mapped afresh");
+    ASSERT_EQ(Contents(*new_file), std::string("new contents"), "New contents");
+    ASSERT_EQ(Contents(*old_file), std::string("old"), "Mapping in use stays valid");
+
+    std::remove(path.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestLimits() {
+    std::cout << "Testing size limits and eviction..." << std::endl;
+    StaticFileCache cache(2);
+
+    ASSERT_TRUE(cache.Open(TempPath("missing"), 1024) == nullptr, "Missing file");
+
+    std::string empty = TempPath("empty");
+    WriteFile(empty, "");
+    ASSERT_TRUE(cache.Open(empty, 1024) == nullptr, "Empty file not mapped");
+
+    std::string large = TempPath("large");
+    WriteFile(large, std::string(2048, 'x'));
+    ASSERT_TRUE(cache.Open(large, 1024) == nullptr, "Over the size limit");
+
+    std::string a = TempPath("a"), b = TempPath("b"), c = TempPath("c");
+    WriteFile(a, "a");
+    WriteFile(b, "b");
+    WriteFile(c, "c");
+    auto held = cache.Open(a, 1024);
+    cache.Open(b, 1024);
+    cache.Open(c, 1024);  // Drops a, the least recently used
+    auto again = cache.Open(a, 1024);
+    ASSERT_TRUE(again != nullptr && again != held, "Evicted file mapped again");
+    ASSERT_EQ(Contents(*held), std::string("a"), "Evicted mapping still usable by its holder");
+    ASSERT_EQ(cache.Maps(), uint64_t(4), "Four mappings made");
+
+    for (const auto& path : {empty, large, a, b, c}) {
+        std::remove(path.c_str());
+    }
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMappedResponseBody() {
+    std::cout << "Testing responses with a mapped body..." << std::endl;
+    std::string path = TempPath("body");
+    WriteFile(path, "JPEGDATA");
+    StaticFileCache cache;
+
+    HTTPParser::HTTPResponse response;
+    response.SetContentType("image/jpeg");
+    {
+        auto file = cache.Open(path, 1024);
+        ASSERT_TRUE(file != nullptr, "Mapped");
+        response.mapped_body = file->Data();
+        response.mapped_body_size = static_cast<size_t>(file->Size());
+        response.mapped_body_owner = file;
+    }
+    cache.Clear();  // The response alone keeps the mapping now
+
+    ASSERT_TRUE(response.body.empty(), "Nothing copied into body");
+    ASSERT_EQ(response.BodySize(), size_t(8), "Body size from the mapping");
+    HTTPParser::HTTPResponse copy = response;
+    ASSERT_TRUE(copy.BodyData() == response.BodyData(), "Copies share the mapping");
+
+    mtp::ByteArray wire = HTTPParser::BuildResponse(copy);
+    std::string text(wire.begin(), wire.end());
+    ASSERT_TRUE(text.size() > 8 && text.compare(text.size() - 8, 8, "JPEGDATA") == 0,
+                "Mapped body follows the headers");
+
+    HTTPParser::HTTPResponse plain;
+    plain.body = {'a', 'b'};
+    ASSERT_EQ(plain.BodySize(), size_t(2), "Ordinary body size");
+    ASSERT_TRUE(plain.BodyData() == plain.body.data(), "Ordinary body data");
+
+    std::remove(path.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Static File Cache Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestMappingReuse, "Mapping Reuse");
+    run_test(TestRevalidation, "Revalidation");
+    run_test(TestLimits, "Limits");
+    run_test(TestMappedResponseBody, "Mapped Response Body");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+/**
+ * test_sync_journal.cpp
+ *
+ * Unit tests for the resumable sync journal
+ * Tests persistence, torn trailing records, verification against device
+ * object sizes, Clear and resumed planning
+ */
+
+#include "lib/src/ZuneSyncJournal.h"
+#include "lib/src/ZuneSyncPlanner.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::SyncJournal;
+using zune::SyncResume;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_sync_journal";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+// Host source file of the given size
+static std::string WriteSource(const std::string& dir, const std::string& name, size_t size) {
+    std::string path = (std::filesystem::path(dir) / name).string();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << std::string(size, 'a');
+    return path;
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestRecordAndReopen() {
+    std::cout << "Testing records survive a reopen..." << std::endl;
+    std::string dir = TempDir();
+    std::string a = WriteSource(dir, "a.mp3", 100);
+    std::string path = (std::filesystem::path(dir) / SyncJournal::FileName("SER/1")).string();
+    ASSERT_EQ(SyncJournal::FileName("SER/1"), std::string("SER_1.xzjournal"), "Serial sanitized");
+
+    {
+        SyncJournal journal;
+        ASSERT_TRUE(journal.Open(path), "Journal opened");
+        ASSERT_TRUE(journal.RecordCreated(0x01000010, 100), "Created recorded");
+        ASSERT_EQ(journal.PendingObject(), 0x01000010u, "Awaiting data");
+        ASSERT_TRUE(journal.RecordCommitted(0x01000010, a), "Committed recorded");
+        ASSERT_EQ(journal.PendingObject(), 0u, "Nothing pending");
+        journal.RecordCreated(0x01000011, 200);
+        // Process dies here: no Close
+    }
+
+    SyncJournal journal;
+    ASSERT_TRUE(journal.Open(path), "Journal reopened");
+    auto entries = journal.Entries();
+    ASSERT_EQ(entries.size(), size_t(2), "Both objects journaled");
+    ASSERT_TRUE(entries[0].committed, "First object complete");
+    ASSERT_EQ(entries[0].source_path, a, "Source path kept");
+    ASSERT_EQ(entries[0].source_size, uint64_t(100), "Source size kept");
+    ASSERT_FALSE(entries[1].committed, "Second object never got its data");
+    ASSERT_EQ(entries[1].object_size, uint64_t(200), "Declared size kept");
+    ASSERT_EQ(journal.PendingObject(), 0x01000011u, "Pending restored");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestTornRecord() {
+    std::cout << "Testing a torn trailing record..." << std::endl;
+    std::string dir = TempDir();
+    std::string a = WriteSource(dir, "a.mp3", 100);
+    std::string path = (std::filesystem::path(dir) / "torn.xzjournal").string();
+
+    uintmax_t good_size;
+    {
+        SyncJournal journal;
+        journal.Open(path);
+        journal.RecordCreated(0x01000020, 100);
+        journal.RecordCommitted(0x01000020, a);
+        good_size = std::filesystem::file_size(path);
+        journal.RecordCreated(0x01000021, 300);
+    }
+    // Cut the last record short, as a crash mid-write would
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+    {
+        SyncJournal journal;
+        ASSERT_TRUE(journal.Open(path), "Journal reopened");
+        ASSERT_EQ(journal.Entries().size(), size_t(1), "Torn record dropped");
+        ASSERT_EQ(std::filesystem::file_size(path), good_size, "File cut at the last good record");
+        journal.RecordCreated(0x01000022, 400);
+    }
+
+    SyncJournal journal;
+    journal.Open(path);
+    auto entries = journal.Entries();
+    ASSERT_EQ(entries.size(), size_t(2), "Appends after the cut are readable");
+    ASSERT_EQ(entries[1].object_id, 0x01000022u, "New record follows");
+
+    // A foreign file is replaced rather than appended to
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a journal";
+    SyncJournal fresh;
+    ASSERT_TRUE(fresh.Open(path), "Foreign file replaced");
+    ASSERT_TRUE(fresh.Entries().empty(), "No entries");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestResumeVerification() {
+    std::cout << "Testing verification against the device..." << std::endl;
+    std::string dir = TempDir();
+    std::string done = WriteSource(dir, "done.mp3", 100);
+    WriteSource(dir, "partial.mp3", 200);
+    std::string short_copy = WriteSource(dir, "short.mp3", 300);
+    std::string edited = WriteSource(dir, "edited.mp3", 400);
+    std::string deleted = WriteSource(dir, "deleted.mp3", 500);
+
+    SyncJournal journal;
+    journal.Open((std::filesystem::path(dir) / "j.xzjournal").string());
+    journal.RecordCreated(1, 100);
+    journal.RecordCommitted(1, done);
+    journal.RecordCreated(3, 300);
+    journal.RecordCommitted(3, short_copy);
+    journal.RecordCreated(4, 400);
+    journal.RecordCommitted(4, edited);
+    journal.RecordCreated(5, 500);
+    journal.RecordCommitted(5, deleted);
+    journal.RecordCreated(2, 200);          // Cable pulled during SendObject
+    WriteSource(dir, "edited.mp3", 401);    // Re-tagged since
+
+    std::unordered_map<uint32_t, uint64_t> device = {
+        {1, 100}, {2, 64}, {3, 299}, {4, 400}, {99, 1}};  // 5 deleted on the device
+    SyncResume resume = journal.Resume(device);
+
+    ASSERT_EQ(resume.committed.size(), size_t(1), "One object kept");
+    ASSERT_EQ(resume.committed[done], 1u, "Complete, unchanged object kept");
+    std::vector<uint32_t> stale = resume.stale;
+    std::sort(stale.begin(), stale.end());
+    ASSERT_EQ(stale.size(), size_t(3), "Three objects to delete");
+    ASSERT_EQ(stale[0], 2u, "Partial object deleted");
+    ASSERT_EQ(stale[1], 3u, "Short object deleted");
+    ASSERT_EQ(stale[2], 4u, "Out-of-date object deleted");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestClear() {
+    std::cout << "Testing Clear..." << std::endl;
+    std::string dir = TempDir();
+    std::string a = WriteSource(dir, "a.mp3", 100);
+    std::string path = (std::filesystem::path(dir) / "c.xzjournal").string();
+    {
+        SyncJournal journal;
+        journal.Open(path);
+        journal.RecordCreated(1, 100);
+        journal.RecordCommitted(1, a);
+        journal.Clear();
+        ASSERT_TRUE(journal.Entries().empty(), "Entries forgotten");
+        journal.RecordCreated(2, 100);
+    }
+    SyncJournal journal;
+    journal.Open(path);
+    auto entries = journal.Entries();
+    ASSERT_EQ(entries.size(), size_t(1), "Only the record after Clear");
+    ASSERT_EQ(entries[0].object_id, 2u, "Record after Clear kept");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestResumedPlan() {
+    std::cout << "Testing a resumed plan..." << std::endl;
+    // Device library read before the interrupted sync: one old track
+    ZuneMusicAlbum album{};
+    album.title = "Alpha";
+    album.artist_name = "Band";
+    album.atom_id = 0x0601;
+    ZuneMusicTrack old_track{};
+    old_track.title = "Old";
+    old_track.artist_name = "Band";
+    old_track.track_number = 9;
+    old_track.album_ref = 0x0601;
+    old_track.atom_id = 0x01000009;
+    ZuneMusicLibrary library{};
+    library.tracks = &old_track;
+    library.track_count = 1;
+    library.albums = &album;
+    library.album_count = 1;
+
+    std::vector<ZuneHostTrack> host(3);
+    const char* paths[] = {"/m/one.mp3", "/m/two.mp3", "/m/three.mp3"};
+    const char* titles[] = {"One", "Two", "Three"};
+    for (uint32_t i = 0; i < 3; i++) {
+        host[i].file_path = paths[i];
+        host[i].title = titles[i];
+        host[i].artist = "Band";
+        host[i].album = "Alpha";
+        host[i].track_number = i + 1;
+        host[i].file_size = 100;
+    }
+
+    SyncResume resume;
+    resume.committed["/m/one.mp3"] = 0x01000010;   // Uploaded before the crash
+    resume.stale = {0x01000011, 0x01000009};       // Partial upload; a listed track re-sent
+
+    ZuneSyncPlanOptions options = zune::DefaultSyncPlanOptions();
+    options.delete_unmatched_tracks = false;
+    zune::SyncPlan plan = zune::PlanSync(library, host.data(), 3, nullptr, 0, options, &resume);
+
+    ASSERT_EQ(plan.resumed_count, 1u, "One track resumed");
+    ASSERT_EQ(plan.host_matches[0], 0x01000010u, "Resumed track matches its object");
+    ASSERT_EQ(plan.add_count, 2u, "Only the rest uploaded");
+    ASSERT_EQ(plan.delete_count, 2u, "Both stale objects deleted");
+    ASSERT_EQ(plan.ops[0].type, int(ZUNE_SYNC_OP_DELETE_TRACK), "Journal delete first");
+    ASSERT_EQ(plan.ops[0].device_atom_id, 0x01000011u, "Unlisted partial object deleted");
+    ASSERT_EQ(plan.ops[1].device_atom_id, 0x01000009u, "Listed stale track deleted");
+    for (const auto& op : plan.ops) {
+        ASSERT_FALSE(op.type == ZUNE_SYNC_OP_ADD_TRACK && op.host_index == 0, "Resumed track not re-added");
+    }
+
+    // Without the journal the same manifest uploads everything
+    zune::SyncPlan fresh = zune::PlanSync(library, host.data(), 3, nullptr, 0, options);
+    ASSERT_EQ(fresh.add_count, 3u, "Fresh plan adds all");
+    ASSERT_EQ(fresh.resumed_count, 0u, "Nothing resumed");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Sync Journal Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestRecordAndReopen, "Record / Reopen");
+    run_test(TestTornRecord, "Torn Record");
+    run_test(TestResumeVerification, "Resume Verification");
+    run_test(TestClear, "Clear");
+    run_test(TestResumedPlan, "Resumed Plan");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_sync_journal");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
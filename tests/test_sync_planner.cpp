@@ -0,0 +1,358 @@
+/**
+ * test_sync_planner.cpp
+ *
+ * Unit tests for the host-vs-device sync planner
+ * Tests matching, tag updates, changed files, album grouping, deletes,
+ * playlist diffs and planning time on a 40k-track library
+ */
+
+#include "lib/src/ZuneSyncPlanner.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::PlanSync;
+using zune::SyncPlan;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+// Device library with two albums: "Alpha" (3 tracks) and "Beta" (2 tracks)
+struct Fixture {
+    std::vector<ZuneMusicTrack> tracks;
+    std::vector<ZuneMusicAlbum> albums;
+    std::vector<ZuneMusicPlaylist> playlists;
+    std::vector<uint32_t> playlist_atoms;
+    ZuneMusicLibrary library{};
+
+    Fixture() {
+        albums.push_back(MakeAlbum("Alpha", "The Band", 0x0601));
+        albums.push_back(MakeAlbum("Beta", "Solo Artist", 0x0602));
+
+        tracks.push_back(MakeTrack("One", "The Band", "Rock", 1, 0x0601, 0x01000001));
+        tracks.push_back(MakeTrack("Two", "The Band", "Rock", 2, 0x0601, 0x01000002));
+        tracks.push_back(MakeTrack("Three", "The Band", "Rock", 3, 0x0601, 0x01000003));
+        tracks.push_back(MakeTrack("Intro", "Solo Artist", "Jazz", 1, 0x0602, 0x01000004));
+        tracks.push_back(MakeTrack("Outro", "Solo Artist", "Jazz", 2, 0x0602, 0x01000005));
+
+        playlist_atoms = {0x01000002, 0x01000004};
+        ZuneMusicPlaylist p{};
+        p.name = "Mix";
+        p.track_atom_ids = playlist_atoms.data();
+        p.track_count = static_cast<uint32_t>(playlist_atoms.size());
+        p.atom_id = 0x0901;
+        playlists.push_back(p);
+        Bind();
+    }
+
+    void Bind() {
+        library.tracks = tracks.data();
+        library.track_count = static_cast<uint32_t>(tracks.size());
+        library.albums = albums.data();
+        library.album_count = static_cast<uint32_t>(albums.size());
+        library.playlists = playlists.data();
+        library.playlist_count = static_cast<uint32_t>(playlists.size());
+    }
+
+    static ZuneMusicAlbum MakeAlbum(const char* title, const char* artist, uint32_t atom) {
+        ZuneMusicAlbum a{};
+        a.title = title;
+        a.artist_name = artist;
+        a.atom_id = atom;
+        return a;
+    }
+
+    static ZuneMusicTrack MakeTrack(const char* title, const char* artist, const char* genre,
+                                    int number, uint32_t album, uint32_t atom) {
+        ZuneMusicTrack t{};
+        t.title = title;
+        t.artist_name = artist;
+        t.genre = genre;
+        t.track_number = number;
+        t.disc_number = 1;
+        t.duration_ms = 180000 + number * 1000;
+        t.file_size_bytes = 4000000 + number;
+        t.album_ref = album;
+        t.atom_id = atom;
+        return t;
+    }
+};
+
+// Host copy of a device track, as a tag scan would report it
+static ZuneHostTrack HostFrom(const ZuneMusicTrack& t, const char* album) {
+    ZuneHostTrack h{};
+    h.file_path = t.title;
+    h.title = t.title;
+    h.artist = t.artist_name;
+    h.album = album;
+    h.genre = t.genre;
+    h.track_number = static_cast<uint32_t>(t.track_number);
+    h.disc_number = 1;
+    h.duration_ms = static_cast<uint32_t>(t.duration_ms);
+    h.file_size = static_cast<uint64_t>(t.file_size_bytes);
+    return h;
+}
+
+static std::vector<ZuneHostTrack> HostMirror(const Fixture& f) {
+    std::vector<ZuneHostTrack> host;
+    for (const auto& t : f.tracks) {
+        host.push_back(HostFrom(t, t.album_ref == 0x0601 ? "Alpha" : "Beta"));
+    }
+    return host;
+}
+
+static uint32_t CountOps(const SyncPlan& plan, ZuneSyncOpType type) {
+    uint32_t n = 0;
+    for (const auto& op : plan.ops) {
+        if (op.type == type) n++;
+    }
+    return n;
+}
+
+bool TestNoChanges() {
+    std::cout << "Testing identical collections..." << std::endl;
+    Fixture f;
+    auto host = HostMirror(f);
+    // Case and spacing differences still match; durations within tolerance
+    host[0].title = "  ONE ";
+    host[1].album = "alpha";
+    host[2].duration_ms += 1500;
+
+    const uint32_t mix[] = {1, 3};
+    ZuneHostPlaylist playlist{"mix", mix, 2};
+
+    SyncPlan plan = PlanSync(f.library, host.data(), uint32_t(host.size()), &playlist, 1,
+                             zune::DefaultSyncPlanOptions());
+    ASSERT_EQ(plan.ops.size(), size_t(0), "No operations");
+    for (size_t i = 0; i < host.size(); i++) {
+        ASSERT_EQ(plan.host_matches[i], f.tracks[i].atom_id, "Host track matched in place");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestUpdatesAndChangedFiles() {
+    std::cout << "Testing tag updates and changed files..." << std::endl;
+    Fixture f;
+    auto host = HostMirror(f);
+    host[0].genre = "Alternative";      // Same file, new tag
+    host[3].disc_number = 2;            // Same file, new disc
+    host[4].file_size += 100;           // Re-encoded
+
+    SyncPlan plan = PlanSync(f.library, host.data(), uint32_t(host.size()), nullptr, 0,
+                             zune::DefaultSyncPlanOptions());
+    ASSERT_EQ(plan.update_count, 2u, "Two tag updates");
+    ASSERT_EQ(plan.delete_count, 1u, "Changed file deleted");
+    ASSERT_EQ(plan.add_count, 1u, "Changed file re-added");
+    ASSERT_EQ(plan.ops[0].type, int(ZUNE_SYNC_OP_DELETE_TRACK), "Delete first");
+    ASSERT_EQ(plan.ops[0].device_atom_id, 0x01000005u, "Old copy deleted");
+    ASSERT_EQ(plan.ops[1].type, int(ZUNE_SYNC_OP_ADD_TRACK), "Existing album: no CREATE_ALBUM");
+    ASSERT_EQ(plan.groups[plan.ops[1].group].device_album_atom_id, 0x0602u, "Added into Beta");
+    ASSERT_EQ(plan.host_matches[4], 0u, "Changed file is not a match");
+    ASSERT_EQ(plan.ops[2].type, int(ZUNE_SYNC_OP_UPDATE_TRACK), "Updates after adds");
+    ASSERT_EQ(plan.ops[2].host_index, 0u, "Genre update");
+    ASSERT_EQ(plan.ops[3].device_atom_id, 0x01000004u, "Disc update");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestAlbumGrouping() {
+    std::cout << "Testing album grouping of adds..." << std::endl;
+    Fixture f;
+    auto host = HostMirror(f);
+
+    // Two new albums, interleaved and out of order in the manifest
+    const char* zeta = "Zeta";
+    const char* gamma = "Gamma";
+    for (uint32_t n : {3u, 1u, 2u}) {
+        ZuneHostTrack z{};
+        z.file_path = "z"; z.title = "Z"; z.artist = "Zed"; z.album = zeta;
+        z.track_number = n; z.duration_ms = 1000; z.file_size = 10;
+        host.push_back(z);
+        ZuneHostTrack g{};
+        g.file_path = "g"; g.title = "G"; g.artist = "Guest"; g.album_artist = "Various"; g.album = gamma;
+        g.track_number = n; g.disc_number = n == 1 ? 2 : 1; g.duration_ms = 1000; g.file_size = 10;
+        host.push_back(g);
+    }
+
+    SyncPlan plan = PlanSync(f.library, host.data(), uint32_t(host.size()), nullptr, 0,
+                             zune::DefaultSyncPlanOptions());
+    ASSERT_EQ(plan.groups.size(), size_t(2), "Two album groups");
+    ASSERT_EQ(std::string(plan.groups[0].artist), std::string("Various"), "Album artist groups Gamma");
+    ASSERT_EQ(std::string(plan.groups[1].album), std::string("Zeta"), "Sorted by artist");
+    ASSERT_EQ(plan.groups[0].add_count, 3u, "Gamma has three adds");
+    ASSERT_EQ(CountOps(plan, ZUNE_SYNC_OP_CREATE_ALBUM), 2u, "One CREATE_ALBUM per new album");
+    ASSERT_EQ(plan.ops.size(), size_t(8), "Two creates and six adds");
+
+    ASSERT_EQ(plan.ops[0].type, int(ZUNE_SYNC_OP_CREATE_ALBUM), "Create precedes its tracks");
+    // Gamma: disc 1 tracks 2, 3, then disc 2 track 1
+    ASSERT_EQ(host[plan.ops[1].host_index].track_number, 2u, "Disc 1 track 2");
+    ASSERT_EQ(host[plan.ops[2].host_index].track_number, 3u, "Disc 1 track 3");
+    ASSERT_EQ(host[plan.ops[3].host_index].disc_number, 2u, "Disc 2 last");
+    ASSERT_EQ(plan.ops[4].type, int(ZUNE_SYNC_OP_CREATE_ALBUM), "Second album created");
+    ASSERT_EQ(plan.ops[4].group, 1u, "Group ids follow plan order");
+    ASSERT_EQ(host[plan.ops[5].host_index].track_number, 1u, "Zeta in track order");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDeletes() {
+    std::cout << "Testing deletes of unmatched device content..." << std::endl;
+    Fixture f;
+    auto host = HostMirror(f);
+    host.pop_back();                    // Outro no longer on the host
+
+    SyncPlan plan = PlanSync(f.library, host.data(), uint32_t(host.size()), nullptr, 0,
+                             zune::DefaultSyncPlanOptions());
+    ASSERT_EQ(plan.delete_count, 1u, "Outro deleted");
+    ASSERT_EQ(plan.ops[0].device_atom_id, 0x01000005u, "Deleted the right track");
+    ASSERT_EQ(plan.playlist_op_count, 0u, "Playlists kept by default");
+
+    ZuneSyncPlanOptions options = zune::DefaultSyncPlanOptions();
+    options.delete_unmatched_tracks = false;
+    options.delete_unmatched_playlists = true;
+    plan = PlanSync(f.library, host.data(), uint32_t(host.size()), nullptr, 0, options);
+    ASSERT_EQ(plan.delete_count, 0u, "Unmatched tracks kept");
+    ASSERT_EQ(plan.ops.size(), size_t(1), "Only the playlist delete");
+    ASSERT_EQ(plan.ops[0].type, int(ZUNE_SYNC_OP_DELETE_PLAYLIST), "Playlist deleted");
+    ASSERT_EQ(plan.ops[0].device_atom_id, 0x0901u, "Deleted Mix");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPlaylists() {
+    std::cout << "Testing playlist diffs..." << std::endl;
+    Fixture f;
+    auto host = HostMirror(f);
+    ZuneHostTrack fresh{};
+    fresh.file_path = "new"; fresh.title = "New"; fresh.artist = "The Band"; fresh.album = "Alpha";
+    fresh.track_number = 4; fresh.duration_ms = 1000;
+    host.push_back(fresh);
+
+    const uint32_t reordered[] = {3, 1};
+    const uint32_t with_new[] = {1, 3, 5};
+    const uint32_t same[] = {1, 3};
+    ZuneHostPlaylist lists[] = {{"Mix", reordered, 2}, {"Fresh", with_new, 3}};
+    SyncPlan plan = PlanSync(f.library, host.data(), uint32_t(host.size()), lists, 2,
+                             zune::DefaultSyncPlanOptions());
+    ASSERT_EQ(plan.playlist_op_count, 2u, "Update and create");
+    const auto& update = plan.ops[plan.ops.size() - 2];
+    const auto& create = plan.ops.back();
+    ASSERT_EQ(update.type, int(ZUNE_SYNC_OP_UPDATE_PLAYLIST), "Reordered playlist updated");
+    ASSERT_EQ(update.device_atom_id, 0x0901u, "Updates Mix");
+    ASSERT_EQ(create.type, int(ZUNE_SYNC_OP_CREATE_PLAYLIST), "New playlist created");
+    ASSERT_EQ(create.host_index, 1u, "Creates Fresh");
+    ASSERT_EQ(plan.ops[0].type, int(ZUNE_SYNC_OP_ADD_TRACK), "Track added before playlists");
+
+    ZuneHostPlaylist unchanged[] = {{"Mix", same, 2}};
+    plan = PlanSync(f.library, host.data(), uint32_t(host.size()), unchanged, 1,
+                    zune::DefaultSyncPlanOptions());
+    ASSERT_EQ(plan.playlist_op_count, 0u, "Unchanged playlist left alone");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestLargeLibrary() {
+    std::cout << "Testing a 40k-track library..." << std::endl;
+    const uint32_t kTracks = 40000;
+    const uint32_t kPerAlbum = 12;
+
+    std::vector<std::string> names;
+    names.reserve(kTracks + kTracks / kPerAlbum + 1);
+    std::vector<ZuneMusicAlbum> albums;
+    std::vector<ZuneMusicTrack> tracks;
+    std::vector<ZuneHostTrack> host;
+    for (uint32_t a = 0; a * kPerAlbum < kTracks; a++) {
+        names.push_back("Album " + std::to_string(a));
+        albums.push_back(Fixture::MakeAlbum(names.back().c_str(), "Artist", 0x06000000 + a));
+    }
+    for (uint32_t i = 0; i < kTracks; i++) {
+        names.push_back("Track " + std::to_string(i));
+        uint32_t a = i / kPerAlbum;
+        tracks.push_back(Fixture::MakeTrack(names.back().c_str(), "Artist", "Pop",
+                                            int(i % kPerAlbum + 1), 0x06000000 + a, 0x01000000 + i));
+        host.push_back(HostFrom(tracks.back(), albums[a].title));
+    }
+    // Host holds every track, in reverse order
+    std::vector<ZuneHostTrack> reversed(host.rbegin(), host.rend());
+    ZuneMusicLibrary library{};
+    library.tracks = tracks.data();
+    library.track_count = kTracks;
+    library.albums = albums.data();
+    library.album_count = static_cast<uint32_t>(albums.size());
+
+    auto start = std::chrono::steady_clock::now();
+    SyncPlan plan = PlanSync(library, reversed.data(), uint32_t(reversed.size()), nullptr, 0,
+                             zune::DefaultSyncPlanOptions());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  Planned " << kTracks << " tracks in " << ms << " ms" << std::endl;
+
+    ASSERT_EQ(plan.ops.size(), size_t(0), "Everything matched");
+    ASSERT_EQ(plan.host_matches.front(), 0x01000000u + kTracks - 1, "Reverse order matched");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Sync Planner Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestNoChanges, "No Changes");
+    run_test(TestUpdatesAndChangedFiles, "Updates / Changed Files");
+    run_test(TestAlbumGrouping, "Album Grouping");
+    run_test(TestDeletes, "Deletes");
+    run_test(TestPlaylists, "Playlists");
+    run_test(TestLargeLibrary, "40k Library");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -8,6 +8,8 @@
 #include "lib/src/protocols/tcp/TCPConnectionManager.h"
 #include "lib/src/protocols/ppp/PPPParser.h"  // For TCPParser
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <vector>
 
 template<typename T>
@@ -80,7 +82,7 @@ bool TestThreeWayHandshake() {
               "Response should be SYN-ACK");
     ASSERT_EQ(syn_ack->ack_num, uint32_t(client_seq + 1), "ACK should be client SEQ + 1");
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_TRUE(conn != nullptr, "Connection should exist");
@@ -120,7 +122,7 @@ bool TestConnectionTermination() {
     manager.HandlePacket(client_ip, client_port, server_ip, server_port,
                         1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_EQ(conn->state, TCPState::ESTABLISHED, "Should be ESTABLISHED");
@@ -159,7 +161,7 @@ bool TestConnectionReset() {
     manager.HandlePacket(client_ip, client_port, server_ip, server_port,
                         1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_EQ(conn->state, TCPState::ESTABLISHED, "Should be ESTABLISHED");
@@ -200,7 +202,7 @@ bool TestInvalidStateTransitions() {
         65535, mtp::ByteArray()
     );
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         0xC0A83765, 49152, 0xC0A83764, 80);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
 
@@ -228,7 +230,7 @@ bool TestInvalidStateTransitions() {
         {'H', 'E', 'L', 'L', 'O'}  // Data without connection
     );
 
-    std::string data_conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey data_conn_key = TCPConnectionManager::MakeConnectionKey(
         0xC0A83765, 49153, 0xC0A83764, 80);
     TCPConnectionInfo* data_conn = manager2.GetConnection(data_conn_key);
 
@@ -254,7 +256,7 @@ bool TestHTTPBufferManagement() {
     manager.HandlePacket(0xC0A83765, 49152, 0xC0A83764, 80,
                         1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         0xC0A83765, 49152, 0xC0A83764, 80);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
 
@@ -285,7 +287,7 @@ bool TestMultipleConnections() {
     // Verify all 3 connections exist
     int connection_count = 0;
     for (uint16_t port = 49152; port < 49155; port++) {
-        std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+        TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
             0xC0A83765, port, 0xC0A83764, 80);
         if (manager.GetConnection(conn_key) != nullptr) {
             connection_count++;
@@ -322,7 +324,7 @@ bool TestSequenceNumberManagement() {
                         1001, server_seq + 1, TCPParser::TCP_FLAG_ACK,
                         65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         0xC0A83765, 49152, 0xC0A83764, 80);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
 
@@ -397,7 +399,7 @@ bool TestDuplicateSYN() {
     );
 
     // Should handle gracefully (either resend SYN-ACK or ignore)
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_TRUE(conn != nullptr, "Connection should still exist");
@@ -436,7 +438,7 @@ bool TestTCPSequenceWraparound() {
         65535, mtp::ByteArray()
     );
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_TRUE(conn != nullptr, "Connection should exist");
@@ -458,7 +460,7 @@ bool TestHTTPBufferFragmentation() {
     manager.HandlePacket(0xC0A83765, 49152, 0xC0A83764, 80,
                         1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         0xC0A83765, 49152, 0xC0A83764, 80);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
 
@@ -499,7 +501,7 @@ bool TestSimultaneousClose() {
     manager.HandlePacket(client_ip, client_port, server_ip, server_port,
                         1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         client_ip, client_port, server_ip, server_port);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_EQ(conn->state, TCPState::ESTABLISHED, "Should be ESTABLISHED");
@@ -535,7 +537,7 @@ bool TestOutOfOrderPackets() {
     manager.HandlePacket(0xC0A83765, 49152, 0xC0A83764, 80,
                         1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         0xC0A83765, 49152, 0xC0A83764, 80);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
 
@@ -601,7 +603,7 @@ bool TestInvalidACKNumber() {
                         1001, server_seq + 1, TCPParser::TCP_FLAG_ACK,
                         65535, mtp::ByteArray());
 
-    std::string conn_key = TCPConnectionManager::MakeConnectionKey(
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
         0xC0A83765, 49152, 0xC0A83764, 80);
     TCPConnectionInfo* conn = manager.GetConnection(conn_key);
     ASSERT_EQ(conn->state, TCPState::ESTABLISHED, "Should be ESTABLISHED");
@@ -640,6 +642,487 @@ bool TestInvalidACKNumber() {
     return true;
 }
 
+// Test: Integer connection keys and the open-addressing connection table
+bool TestConnectionTable() {
+    std::cout << "Testing connection keys and table..." << std::endl;
+
+    TCPConnectionKey key = TCPConnectionManager::MakeConnectionKey(0xC0A83765, 50120, 0xC0A8001E, 80);
+    ASSERT_EQ(key.ToString(), std::string("192.168.55.101:50120->192.168.0.30:80"), "Debug rendering");
+    TCPConnectionKey reversed = TCPConnectionManager::MakeConnectionKey(0xC0A8001E, 80, 0xC0A83765, 50120);
+    ASSERT_TRUE(key != reversed, "Direction matters");
+
+    // Enough keys to force several grows, then erase every third
+    TCPConnectionTable<int> table;
+    std::vector<int*> values;
+    for (uint16_t port = 0; port < 300; port++) {
+        int& value = table.FindOrCreate(TCPConnectionManager::MakeConnectionKey(0xC0A83765, 40000 + port, 0xC0A8001E, 80));
+        value = port;
+        values.push_back(&value);
+    }
+    ASSERT_EQ(table.Size(), size_t(300), "All inserted");
+    for (uint16_t port = 0; port < 300; port++) {
+        int* found = table.Find(TCPConnectionManager::MakeConnectionKey(0xC0A83765, 40000 + port, 0xC0A8001E, 80));
+        ASSERT_TRUE(found == values[port], "Values stay put across grows");
+    }
+    for (uint16_t port = 0; port < 300; port += 3) {
+        ASSERT_TRUE(table.Erase(TCPConnectionManager::MakeConnectionKey(0xC0A83765, 40000 + port, 0xC0A8001E, 80)), "Erase");
+    }
+    ASSERT_FALSE(table.Erase(TCPConnectionManager::MakeConnectionKey(0xC0A83765, 40000, 0xC0A8001E, 80)), "Erase twice");
+    ASSERT_EQ(table.Size(), size_t(200), "Erased");
+    for (uint16_t port = 0; port < 300; port++) {
+        int* found = table.Find(TCPConnectionManager::MakeConnectionKey(0xC0A83765, 40000 + port, 0xC0A8001E, 80));
+        if (port % 3 == 0) {
+            ASSERT_TRUE(found == nullptr, "Erased key gone");
+        } else {
+            ASSERT_TRUE(found && *found == port, "Survivor still reachable after backward shift");
+        }
+    }
+    size_t visited = 0;
+    table.ForEach([&](const TCPConnectionKey&, int&) { visited++; });
+    ASSERT_EQ(visited, size_t(200), "ForEach visits every entry");
+
+    // RST removes the connection from the manager's table
+    TCPConnectionManager manager;
+    manager.HandlePacket(0xC0A83765, 50120, 0xC0A8001E, 80, 1000, 0, TCPParser::TCP_FLAG_SYN, 65535, mtp::ByteArray());
+    ASSERT_TRUE(manager.GetConnection(key) != nullptr, "Connection created by SYN");
+    manager.HandlePacket(0xC0A83765, 50120, 0xC0A8001E, 80, 1001, 0, TCPParser::TCP_FLAG_RST, 0, mtp::ByteArray());
+    ASSERT_TRUE(manager.GetConnection(key) == nullptr, "Connection erased by RST");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStreamReassemblerRing() {
+    std::cout << "Testing ring-buffer stream reassembly..." << std::endl;
+
+    auto bytes = [](const std::string& text) { return mtp::ByteArray(text.begin(), text.end()); };
+    auto text = [](const TCPStreamReassembler::StreamView& view) { return std::string(view.begin(), view.end()); };
+
+    // Out-of-order ranges merge in place and flush when the gap closes
+    TCPStreamReassembler r(1000);
+    ASSERT_TRUE(r.AddSegment(1010, bytes("KLMNO")), "Out-of-order range");
+    ASSERT_TRUE(r.AddSegment(1020, bytes("UVWXY")), "Second range");
+    ASSERT_TRUE(r.AddSegment(1013, bytes("NOPQRSTU")), "Overlap bridges both ranges");
+    ASSERT_FALSE(r.AddSegment(1012, bytes("MNOP")), "Already buffered");
+    ASSERT_EQ(r.GetStats().out_of_order_buffered, size_t(1), "Merged into one range");
+    ASSERT_TRUE(r.GetBuffer().empty(), "Nothing readable across the gap");
+    ASSERT_TRUE(r.AddSegment(1000, bytes("ABCDEFGHIJKL")), "Gap filled, overlapping the range");
+    ASSERT_EQ(text(r.GetBuffer()), std::string("ABCDEFGHIJKLMNOPQRSTUVWXY"), "Contiguous stream");
+    ASSERT_EQ(r.GetNextExpectedSeq(), uint32_t(1025), "Next expected past the flushed range");
+    ASSERT_FALSE(r.HasOutOfOrderData(), "No gaps left");
+
+    // Consuming moves the head; later data keeps the view contiguous across the wrap
+    r.Consume(20);
+    ASSERT_EQ(text(r.GetBuffer()), std::string("UVWXY"), "Consumed from the front");
+    uint32_t seq = r.GetNextExpectedSeq();
+    mtp::ByteArray block(TCPStreamReassembler::kCapacity - 1000, 'x');
+    ASSERT_TRUE(r.AddSegment(seq, block), "Large in-order block");
+    seq += block.size();
+    r.Consume(r.GetBuffer().size() - 4);
+    ASSERT_TRUE(r.AddSegment(seq, bytes("wrapped past the end")), "Write across the ring end");
+    ASSERT_EQ(text(r.GetBuffer()), std::string("xxxxwrapped past the end"), "View spans the wrap in one piece");
+    seq += 20;
+
+    // The receive window bounds what is kept
+    r.ClearContiguousBuffer();
+    ASSERT_FALSE(r.AddSegment(seq + TCPStreamReassembler::kCapacity, bytes("far")), "Past the window");
+    mtp::ByteArray oversized(TCPStreamReassembler::kCapacity + 100, 'y');
+    ASSERT_TRUE(r.AddSegment(seq, oversized), "Window-sized prefix accepted");
+    ASSERT_EQ(r.GetBuffer().size(), TCPStreamReassembler::kCapacity, "Tail past the window dropped");
+    ASSERT_FALSE(r.AddSegment(seq - 10, bytes("0123456789")), "True retransmit");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestStreamedTransmission() {
+    std::cout << "Testing a transmission filled while it is sent..." << std::endl;
+
+    TCPConnectionManager manager;
+    uint32_t client_ip = 0xC0A83765;
+    uint16_t client_port = 49200;
+    uint32_t server_ip = 0xC0A83764;
+    uint16_t server_port = 80;
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1000, 0, TCPParser::TCP_FLAG_SYN, 65535, mtp::ByteArray());
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
+        client_ip, client_port, server_ip, server_port);
+
+    // Header frame now, three body segments to come
+    uint32_t base_seq = 2001;
+    std::vector<mtp::ByteArray> header_frame{mtp::ByteArray(10, 'H')};
+    manager.StartHTTPTransmission(conn_key, base_seq, std::move(header_frame), {100, 200, 200, 50});
+
+    std::vector<mtp::ByteArray> batch;
+    bool is_last = false;
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(1), "Header segment sent");
+    ASSERT_FALSE(is_last, "Body still to come");
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(0), "Waits for the body");
+    ASSERT_FALSE(is_last, "Waiting is not the end");
+
+    std::vector<mtp::ByteArray> first{mtp::ByteArray(20, 'a'), mtp::ByteArray(20, 'b')};
+    ASSERT_TRUE(manager.AddHTTPSegments(conn_key, base_seq, std::move(first)), "First body segments");
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(2), "Arrived segments sent");
+    ASSERT_EQ(batch[1][0], uint8_t('b'), "In order");
+    ASSERT_FALSE(is_last, "One segment left");
+
+    std::vector<mtp::ByteArray> rest{mtp::ByteArray(20, 'c'), mtp::ByteArray(20, 'x')};
+    ASSERT_TRUE(manager.AddHTTPSegments(conn_key, base_seq, std::move(rest)), "Last segment");
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(1), "Extra frame beyond the range ignored");
+    ASSERT_TRUE(is_last, "Complete");
+    ASSERT_EQ(manager.GetRetransmitSegment(conn_key, base_seq, 3)[0], uint8_t('c'), "Retransmit sees streamed frames");
+
+    // A body that ends short resets the connection
+    manager.ResetConnection(conn_key);
+    ASSERT_TRUE(manager.GetConnection(conn_key) == nullptr, "Connection dropped");
+    ASSERT_FALSE(manager.AddHTTPSegments(conn_key, base_seq, {mtp::ByteArray(1)}), "Nothing to add to");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFramedOnDemand() {
+    std::cout << "Testing a transmission framed as the window opens..." << std::endl;
+
+    TCPConnectionManager manager;
+    uint32_t client_ip = 0xC0A83765;
+    uint16_t client_port = 49206;
+    uint32_t server_ip = 0xC0A83764;
+    uint16_t server_port = 80;
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1000, 0, TCPParser::TCP_FLAG_SYN, 65535, mtp::ByteArray());
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
+        client_ip, client_port, server_ip, server_port);
+
+    // The body the framer slices, and a count of frames it built
+    auto body = std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>{'A', 'B', 'C', 'D', 'E'});
+    std::weak_ptr<std::vector<uint8_t>> held = body;
+    auto built = std::make_shared<size_t>(0);
+    SegmentFramer framer = [body, built](size_t index, mtp::ByteArray& frame) {
+        (*built)++;
+        frame.assign(1, (*body)[index]);
+    };
+    body.reset();
+
+    uint32_t base_seq = 2001;
+    manager.StartHTTPTransmission(conn_key, base_seq, std::move(framer), std::vector<size_t>(5, 1000));
+    ASSERT_EQ(*built, size_t(0), "Nothing framed up front");
+
+    std::vector<mtp::ByteArray> batch;
+    bool is_last = false;
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(1), "One segment in the first window");
+    ASSERT_EQ(*built, size_t(1), "Only what was sent is framed");
+    ASSERT_EQ(batch[0][0], uint8_t('A'), "First slice");
+
+    manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535);
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(2), "Window grew");
+    ASSERT_EQ(batch[1][0], uint8_t('C'), "In order");
+
+    // A resend is framed again from the body
+    ASSERT_EQ(manager.GetRetransmitSegment(conn_key, base_seq, 2)[0], uint8_t('C'), "Reframed");
+    ASSERT_EQ(*built, size_t(4), "No stored copy");
+
+    manager.ProcessACKForTransmission(conn_key, base_seq + 3000, 65535);
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(2), "The rest");
+    ASSERT_TRUE(is_last, "All sent");
+    ASSERT_FALSE(held.expired(), "Body held until ACKed");
+
+    manager.ProcessACKForTransmission(conn_key, base_seq + 5000, 65535);
+    ASSERT_TRUE(held.expired(), "Body released on completion");
+    ASSERT_EQ(manager.GetConnectionStats()[0].active_transmissions, size_t(0), "Transmission removed");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestRTOTimers() {
+    std::cout << "Testing RTO timers of sent segments..." << std::endl;
+
+    TCPConnectionManager manager;
+    uint32_t client_ip = 0xC0A83765;
+    uint16_t client_port = 49201;
+    uint32_t server_ip = 0xC0A83764;
+    uint16_t server_port = 80;
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1000, 0, TCPParser::TCP_FLAG_SYN, 65535, mtp::ByteArray());
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
+        client_ip, client_port, server_ip, server_port);
+
+    ASSERT_FALSE(manager.NextTimeoutDeadline().has_value(), "No timer while idle");
+
+    uint32_t base_seq = 2001;
+    std::vector<mtp::ByteArray> frames{mtp::ByteArray(10, 'H')};
+    manager.StartHTTPTransmission(conn_key, base_seq, std::move(frames), {100});
+    auto sent = std::chrono::steady_clock::now();
+    std::vector<mtp::ByteArray> batch;
+    bool is_last = false;
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(1), "Segment sent");
+
+    // Initial RTO is 3 s
+    auto deadline = manager.NextTimeoutDeadline();
+    ASSERT_TRUE(deadline.has_value(), "Timer set on send");
+    ASSERT_TRUE(*deadline >= sent + std::chrono::seconds(3) &&
+                *deadline < sent + std::chrono::seconds(4), "Deadline one RTO out");
+    ASSERT_TRUE(manager.CheckAllTimeouts(*deadline - std::chrono::milliseconds(1)).empty(), "Not due early");
+
+    auto timed_out = manager.CheckAllTimeouts(*deadline);
+    ASSERT_EQ(timed_out.size(), size_t(1), "Due at its deadline");
+    ASSERT_TRUE(timed_out[0].first == conn_key, "Of this connection");
+    ASSERT_EQ(timed_out[0].second.size(), size_t(1), "One segment");
+    ASSERT_EQ(timed_out[0].second[0].seq_start, base_seq, "The sent segment");
+    ASSERT_TRUE(timed_out[0].second[0].is_retransmit, "Marked as retransmitted");
+
+    // Re-armed with the backed-off RTO
+    auto rearmed = manager.NextTimeoutDeadline();
+    ASSERT_TRUE(rearmed.has_value() && *rearmed == *deadline + std::chrono::seconds(6), "RTO doubled");
+
+    // The RTO marks the transmission for retransmit without a fast-retransmit trigger
+    uint32_t retransmit_base = 0;
+    size_t retransmit_index = 99;
+    ASSERT_TRUE(manager.HandleRTORetransmit(conn_key, timed_out[0].second[0], retransmit_base, retransmit_index),
+                "Segment found");
+    ASSERT_TRUE(manager.CheckRetransmitNeeded(conn_key, retransmit_base, retransmit_index), "Retransmit needed");
+    ASSERT_EQ(retransmit_index, size_t(0), "First segment");
+    manager.ClearRetransmitFlag(conn_key);
+
+    // ACKed: the timer lapses without firing
+    manager.ProcessACKForTransmission(conn_key, base_seq + 100, 65535);
+    ASSERT_TRUE(manager.CheckAllTimeouts(*rearmed).empty(), "ACKed segment not retransmitted");
+    ASSERT_FALSE(manager.NextTimeoutDeadline().has_value(), "Idle again");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestConnectionStats() {
+    std::cout << "Testing connection stats and retransmit counts..." << std::endl;
+
+    TCPConnectionManager manager;
+    uint32_t client_ip = 0xC0A83765;
+    uint16_t client_port = 49202;
+    uint32_t server_ip = 0xC0A83764;
+    uint16_t server_port = 80;
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1000, 0, TCPParser::TCP_FLAG_SYN, 65535, mtp::ByteArray());
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
+        client_ip, client_port, server_ip, server_port);
+
+    uint32_t base_seq = 2001;
+    std::vector<mtp::ByteArray> frames(5, mtp::ByteArray(10, 'H'));
+    manager.StartHTTPTransmission(conn_key, base_seq, std::move(frames), std::vector<size_t>(5, 1000));
+    std::vector<mtp::ByteArray> batch;
+    bool is_last = false;
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(1), "One segment in the first window");
+
+    auto stats = manager.GetConnectionStats();
+    ASSERT_EQ(stats.size(), size_t(1), "One connection");
+    ASSERT_TRUE(stats[0].conn_key == conn_key, "Its key");
+    ASSERT_TRUE(stats[0].state == TCPState::ESTABLISHED, "Established");
+    ASSERT_EQ(stats[0].cwnd, size_t(TCPFlowController::MSS), "Initial cwnd");
+    ASSERT_EQ(stats[0].ssthresh, size_t(4 * TCPFlowController::MSS), "Initial ssthresh");
+    ASSERT_EQ(stats[0].bytes_in_flight, size_t(1000), "Bytes in flight");
+    ASSERT_EQ(stats[0].unacked_segments, size_t(1), "Unacked segments");
+    ASSERT_EQ(stats[0].active_transmissions, size_t(1), "One transmission");
+    ASSERT_FALSE(stats[0].srtt.has_value(), "No RTT sample yet");
+    ASSERT_EQ(stats[0].rto.count(), int64_t(3000), "Initial RTO");
+
+    // First segment ACKed, the window grows, then three duplicates of that ACK
+    manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535);
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(2), "Two segments next");
+    for (int i = 0; i < 3; i++) {
+        manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535);
+    }
+    ASSERT_EQ(manager.GetFastRetransmitCount(), uint64_t(1), "One fast retransmit");
+    manager.ClearRetransmitFlag(conn_key);
+
+    // An RTO on a segment still in flight
+    auto timed_out = manager.CheckAllTimeouts(std::chrono::steady_clock::now() + std::chrono::seconds(4));
+    ASSERT_FALSE(timed_out.empty(), "Segment timed out");
+    uint32_t retransmit_base = 0;
+    size_t retransmit_index = 0;
+    ASSERT_TRUE(manager.HandleRTORetransmit(conn_key, timed_out[0].second[0], retransmit_base, retransmit_index),
+                "Marked for retransmit");
+    ASSERT_EQ(manager.GetRTORetransmitCount(), uint64_t(1), "One RTO retransmit");
+
+    stats = manager.GetConnectionStats();
+    ASSERT_EQ(stats[0].fast_retransmits, uint32_t(1), "Fast retransmit on the connection");
+    ASSERT_EQ(stats[0].rto_retransmits, uint32_t(1), "RTO retransmit on the connection");
+    ASSERT_TRUE(stats[0].srtt.has_value(), "RTT sampled from the ACK");
+    ASSERT_EQ(stats[0].rto.count(), int64_t(2000), "RTO backed off from its 1 s floor");
+
+    // Totals outlive the connection
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1001, base_seq, TCPParser::TCP_FLAG_RST, 65535, mtp::ByteArray());
+    ASSERT_TRUE(manager.GetConnectionStats().empty(), "Connection gone");
+    ASSERT_EQ(manager.GetFastRetransmitCount(), uint64_t(1), "Fast retransmits kept");
+    ASSERT_EQ(manager.GetRTORetransmitCount(), uint64_t(1), "RTO retransmits kept");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestUsbLinkCongestionControl() {
+    std::cout << "Testing the USB link congestion control..." << std::endl;
+
+    TCPConnectionManager manager;
+    manager.SetCongestionControl(CongestionControlKind::USB_LINK);
+    uint32_t client_ip = 0xC0A83765;
+    uint16_t client_port = 49203;
+    uint32_t server_ip = 0xC0A83764;
+    uint16_t server_port = 80;
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1000, 0, TCPParser::TCP_FLAG_SYN, 33580, mtp::ByteArray());
+    manager.HandlePacket(client_ip, client_port, server_ip, server_port,
+                        1001, 2001, TCPParser::TCP_FLAG_ACK, 33580, mtp::ByteArray());
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(
+        client_ip, client_port, server_ip, server_port);
+
+    auto stats = manager.GetConnectionStats();
+    ASSERT_EQ(stats[0].cwnd, size_t(33580), "Starts at the SYN's window");
+
+    // Unpaced before the link is measured: the whole window in one batch
+    uint32_t base_seq = 2001;
+    std::vector<mtp::ByteArray> frames(40, mtp::ByteArray(10, 'H'));
+    manager.StartHTTPTransmission(conn_key, base_seq, std::move(frames),
+                                  std::vector<size_t>(40, TCPFlowController::MSS));
+    std::vector<mtp::ByteArray> batch;
+    bool is_last = false;
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(23), "Full window at once");
+
+    // 7300 bytes in 1 ms is 7.3 MB/s: 29200 bytes per 4 ms, 20 segments
+    ASSERT_EQ(manager.GetLinkRate(), uint64_t(0), "Not measured yet");
+    manager.RecordLinkTransfer(7300, std::chrono::microseconds(1000));
+    ASSERT_EQ(manager.GetLinkRate(), uint64_t(7300000), "Measured rate");
+    manager.ProcessACKForTransmission(conn_key, base_seq + 23 * TCPFlowController::MSS, 33580);
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(17), "Rest, under the budget");
+
+    // Reno stays the manager default, for comparison
+    TCPConnectionManager reno;
+    ASSERT_TRUE(reno.GetCongestionControl() == CongestionControlKind::RENO, "Reno by default");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Connection sending 1000-byte segments whose frames are 'A', 'B', ...
+static TCPConnectionKey StartLettered(TCPConnectionManager& manager, uint16_t client_port, bool offer_sack,
+                                      size_t segments, std::optional<TCPPacket>& syn_ack) {
+    uint32_t client_ip = 0xC0A83765;
+    uint32_t server_ip = 0xC0A83764;
+    TCPParser::Options syn_options;
+    syn_options.sack_permitted = offer_sack;
+    syn_ack = manager.HandlePacket(client_ip, client_port, server_ip, 80,
+                                   1000, 0, TCPParser::TCP_FLAG_SYN, 65535, mtp::ByteArray(), syn_options);
+    manager.HandlePacket(client_ip, client_port, server_ip, 80,
+                        1001, 2001, TCPParser::TCP_FLAG_ACK, 65535, mtp::ByteArray());
+    TCPConnectionKey conn_key = TCPConnectionManager::MakeConnectionKey(client_ip, client_port, server_ip, 80);
+
+    std::vector<mtp::ByteArray> frames;
+    for (size_t i = 0; i < segments; i++) {
+        frames.push_back(mtp::ByteArray(1, static_cast<uint8_t>('A' + i)));
+    }
+    manager.StartHTTPTransmission(conn_key, 2001, std::move(frames), std::vector<size_t>(segments, 1000));
+    return conn_key;
+}
+
+static std::string TakeRetransmits(TCPConnectionManager& manager, const TCPConnectionKey& conn_key) {
+    std::vector<mtp::ByteArray> frames;
+    manager.TakeRetransmitFrames(conn_key, frames);
+    std::string letters;
+    for (const mtp::ByteArray& frame : frames) {
+        letters += static_cast<char>(frame[0]);
+    }
+    return letters;
+}
+
+bool TestSACKRecovery() {
+    std::cout << "Testing SACK negotiation and hole retransmits..." << std::endl;
+
+    TCPConnectionManager manager;
+    manager.SetCongestionControl(CongestionControlKind::USB_LINK);
+    std::optional<TCPPacket> syn_ack;
+    TCPConnectionKey conn_key = StartLettered(manager, 49204, true, 8, syn_ack);
+    ASSERT_TRUE(syn_ack.has_value(), "SYN-ACK");
+    ASSERT_TRUE(syn_ack->options == mtp::ByteArray({1, 1, 4, 2}), "SACK-permitted echoed");
+    ASSERT_TRUE(manager.GetConnectionStats()[0].sack_permitted, "Negotiated");
+
+    uint32_t base_seq = 2001;
+    std::vector<mtp::ByteArray> batch;
+    bool is_last = false;
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(8), "All eight sent");
+
+    // B and E lost: the device holds C-D and F-H
+    manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535);
+    TCPParser::Options sack;
+    sack.sack_blocks[0] = {base_seq + 2000, base_seq + 4000};
+    sack.sack_blocks[1] = {base_seq + 5000, base_seq + 8000};
+    sack.sack_block_count = 2;
+    for (int i = 0; i < 2; i++) {
+        manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535, sack);
+        ASSERT_EQ(TakeRetransmits(manager, conn_key), std::string(), "Nothing before the third duplicate");
+    }
+    manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535, sack);
+    ASSERT_EQ(TakeRetransmits(manager, conn_key), std::string("BE"), "Both holes at once");
+    ASSERT_EQ(manager.GetFastRetransmitCount(), uint64_t(1), "One recovery");
+
+    // B arrived: a partial ACK, E already resent
+    manager.ProcessACKForTransmission(conn_key, base_seq + 4000, 65535, sack);
+    ASSERT_EQ(TakeRetransmits(manager, conn_key), std::string(), "Nothing resent twice");
+
+    manager.ProcessACKForTransmission(conn_key, base_seq + 8000, 65535);
+    ASSERT_EQ(manager.GetConnectionStats()[0].unacked_segments, size_t(0), "All ACKed");
+    ASSERT_EQ(manager.GetFastRetransmitCount(), uint64_t(1), "Still one recovery");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestNewRenoPartialACK() {
+    std::cout << "Testing partial ACKs without SACK (NewReno)..." << std::endl;
+
+    TCPConnectionManager manager;
+    manager.SetCongestionControl(CongestionControlKind::USB_LINK);
+    std::optional<TCPPacket> syn_ack;
+    TCPConnectionKey conn_key = StartLettered(manager, 49205, false, 6, syn_ack);
+    ASSERT_TRUE(syn_ack.has_value() && syn_ack->options.empty(), "No SACK offered, none echoed");
+
+    uint32_t base_seq = 2001;
+    std::vector<mtp::ByteArray> batch;
+    bool is_last = false;
+    ASSERT_EQ(manager.GetNextBatch(conn_key, base_seq, batch, is_last), size_t(6), "All six sent");
+
+    // B and D lost; SACK blocks are ignored when it was not negotiated
+    manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535);
+    TCPParser::Options sack;
+    sack.sack_blocks[0] = {base_seq + 4000, base_seq + 6000};
+    sack.sack_block_count = 1;
+    for (int i = 0; i < 3; i++) {
+        manager.ProcessACKForTransmission(conn_key, base_seq + 1000, 65535, sack);
+    }
+    ASSERT_EQ(TakeRetransmits(manager, conn_key), std::string("B"), "The segment at the ACK");
+
+    // B arrived, D is next: resent on the partial ACK, no more duplicates needed
+    manager.ProcessACKForTransmission(conn_key, base_seq + 3000, 65535);
+    ASSERT_EQ(TakeRetransmits(manager, conn_key), std::string("D"), "Next hole");
+    ASSERT_EQ(manager.GetFastRetransmitCount(), uint64_t(1), "Same recovery");
+
+    // Recovery over: a later loss starts a new one
+    manager.ProcessACKForTransmission(conn_key, base_seq + 6000, 65535);
+    ASSERT_EQ(manager.GetConnectionStats()[0].unacked_segments, size_t(0), "All ACKed");
+    ASSERT_EQ(TakeRetransmits(manager, conn_key), std::string(), "Nothing left");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "======================================" << std::endl;
     std::cout << " TCPConnectionManager Unit Tests" << std::endl;
@@ -675,6 +1158,15 @@ int main() {
     run_test(TestSimultaneousClose, "Simultaneous Close");
     run_test(TestOutOfOrderPackets, "Out-of-Order Packet Handling");
     run_test(TestInvalidACKNumber, "Invalid ACK Number Handling");
+    run_test(TestConnectionTable, "Connection Keys and Table");
+    run_test(TestStreamReassemblerRing, "Stream Reassembler Ring");
+    run_test(TestStreamedTransmission, "Streamed Transmission");
+    run_test(TestFramedOnDemand, "Framed On Demand");
+    run_test(TestRTOTimers, "RTO Timers");
+    run_test(TestConnectionStats, "Connection Stats");
+    run_test(TestUsbLinkCongestionControl, "USB Link Congestion Control");
+    run_test(TestSACKRecovery, "SACK Recovery");
+    run_test(TestNewRenoPartialACK, "NewReno Partial ACK");
 
     std::cout << "======================================" << std::endl;
     std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
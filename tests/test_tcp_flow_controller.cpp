@@ -2,7 +2,8 @@
  * test_tcp_flow_controller.cpp
  *
  * Unit tests for TCPFlowController (Phase 5.3)
- * Tests RFC 5681/3465 compliant congestion control implementation
+ * Tests RFC 5681/3465 compliant congestion control implementation, and the
+ * USB link strategy against it
  */
 
 #include "lib/src/protocols/tcp/TCPFlowController.h"
@@ -415,6 +416,84 @@ bool TestMultipleFastRetransmitCycles() {
     return true;
 }
 
+// Test: USB link profile starts at the receiver window and keeps it
+bool TestUsbLinkProfile() {
+    std::cout << "Testing the USB link congestion control..." << std::endl;
+
+    const size_t window = 33580;
+    TCPFlowController fc(std::make_unique<UsbLinkCongestionControl>(window));
+    ASSERT_TRUE(fc.GetCongestionControlKind() == CongestionControlKind::USB_LINK, "USB link strategy");
+    ASSERT_EQ(fc.GetCongestionWindow(), window, "Starts at the receiver window");
+
+    // A full window goes out, and ACKs do not grow cwnd past the receiver window
+    fc.SetSegmentBoundaries(1000, std::vector<size_t>(23, TCPFlowController::MSS));
+    for (uint32_t i = 0; i < 23; i++) {
+        fc.RecordSegmentSent(TCPFlowController::MSS, 1000 + i * TCPFlowController::MSS);
+    }
+    for (uint32_t i = 1; i <= 23; i++) {
+        ASSERT_TRUE(fc.ProcessACK(1000 + i * TCPFlowController::MSS, 33580), "New data ACKed");
+    }
+    ASSERT_EQ(fc.GetCongestionWindow(), window, "Capped at the receiver window");
+    ASSERT_EQ(fc.GetState(), FlowControlState::CONGESTION_AVOIDANCE, "No slow start");
+
+    // Pacing: unlimited until the link is measured, then what it completes
+    // in the pacing interval, never under two segments
+    ASSERT_EQ(fc.GetPacingBudget(0), size_t(SIZE_MAX), "Unpaced before a measurement");
+    ASSERT_EQ(fc.GetPacingBudget(5000000), size_t(20000), "5 MB/s for 4 ms");
+    ASSERT_EQ(fc.GetPacingBudget(100000), 2 * TCPFlowController::MSS, "Floor of two segments");
+
+    TCPFlowController reno(3 * TCPFlowController::MSS, 65535);
+    ASSERT_TRUE(reno.GetCongestionControlKind() == CongestionControlKind::RENO, "Reno by default");
+    ASSERT_EQ(reno.GetPacingBudget(5000000), size_t(SIZE_MAX), "Reno is unpaced");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: USB link profile on duplicate ACKs - halves without inflation
+bool TestUsbLinkDuplicateAcks() {
+    std::cout << "Testing USB link duplicate ACK handling..." << std::endl;
+
+    const size_t mss = TCPFlowController::MSS;
+    TCPFlowController usb(std::make_unique<UsbLinkCongestionControl>(33580));
+    TCPFlowController reno(33580, 33580);
+    for (TCPFlowController* fc : {&usb, &reno}) {
+        fc->SetSegmentBoundaries(1000, std::vector<size_t>(20, mss));
+        for (uint32_t i = 0; i < 20; i++) {
+            fc->RecordSegmentSent(mss, 1000 + i * mss);
+        }
+        fc->ProcessACK(1000 + mss, 33580);
+        for (int i = 0; i < 3; i++) {
+            fc->ProcessACK(1000 + mss, 33580);
+        }
+        ASSERT_TRUE(fc->NeedsRetransmit(), "Fast retransmit on the third duplicate");
+        fc->ClearRetransmitFlag();
+    }
+
+    size_t flight = 19 * mss;
+    ASSERT_EQ(usb.GetSlowStartThreshold(), flight / 2, "Halved");
+    ASSERT_EQ(usb.GetCongestionWindow(), flight / 2, "No 3*MSS inflation");
+    ASSERT_EQ(reno.GetCongestionWindow(), flight / 2 + 3 * mss, "Reno inflates");
+
+    // Further duplicates only inflate Reno's window
+    for (int i = 0; i < 4; i++) {
+        usb.ProcessACK(1000 + mss, 33580);
+        reno.ProcessACK(1000 + mss, 33580);
+    }
+    ASSERT_EQ(usb.GetCongestionWindow(), flight / 2, "Duplicates do not inflate");
+    ASSERT_EQ(reno.GetCongestionWindow(), flight / 2 + 7 * mss, "Reno: one MSS per duplicate");
+
+    // The retransmit is ACKed: back to congestion avoidance, then linear regrowth
+    ASSERT_TRUE(usb.ProcessACK(1000 + 10 * mss, 33580), "Recovery ACK");
+    ASSERT_EQ(usb.GetState(), FlowControlState::CONGESTION_AVOIDANCE, "Out of recovery");
+    size_t cwnd = usb.GetCongestionWindow();
+    ASSERT_TRUE(usb.ProcessACK(1000 + 20 * mss, 33580), "Rest ACKed");
+    ASSERT_EQ(usb.GetCongestionWindow(), cwnd + mss, "One MSS per window ACKed");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "======================================" << std::endl;
     std::cout << " TCPFlowController Unit Tests" << std::endl;
@@ -452,6 +531,10 @@ int main() {
     run_test(TestSsthreshCalculation, "RFC 5681 ssthresh Calculation");
     run_test(TestMultipleFastRetransmitCycles, "Multiple Fast Retransmit Cycles");
 
+    // Congestion control strategies
+    run_test(TestUsbLinkProfile, "USB Link Profile");
+    run_test(TestUsbLinkDuplicateAcks, "USB Link Duplicate ACKs");
+
     std::cout << "======================================" << std::endl;
     std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
     std::cout << "======================================" << std::endl;
@@ -0,0 +1,183 @@
+/**
+ * test_trace.cpp
+ *
+ * Unit tests for zune::Tracer
+ * Tests that nothing is recorded while disabled, span timing and nesting,
+ * per-thread numbers, ring overflow and the Chrome trace-event JSON
+ */
+
+#include "lib/src/ZuneTrace.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using zune::Tracer;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestDisabled() {
+    std::cout << "Testing disabled tracer..." << std::endl;
+    Tracer& tracer = Tracer::Instance();
+    tracer.SetEnabled(false);
+    tracer.Clear();
+
+    {
+        ZUNE_TRACE_SPAN("test", "ignored");
+    }
+    ASSERT_EQ(tracer.GetEvents().size(), size_t(0), "Disabled spans are not recorded");
+
+    // A span started while disabled stays unrecorded even if tracing starts
+    {
+        Tracer::Span span("test", "started_disabled");
+        tracer.SetEnabled(true);
+    }
+    tracer.SetEnabled(false);
+    ASSERT_EQ(tracer.GetEvents().size(), size_t(0), "Span decides when it starts");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestNesting() {
+    std::cout << "Testing span timing and nesting..." << std::endl;
+    Tracer& tracer = Tracer::Instance();
+    tracer.Clear();
+    tracer.SetEnabled(true);
+
+    {
+        ZUNE_TRACE_SPAN("connect", "outer");
+        Tracer::Span inner("connect", "inner");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        inner.End();
+        inner.End();  // Once only
+    }
+    tracer.SetEnabled(false);
+
+    auto events = tracer.GetEvents();
+    ASSERT_EQ(events.size(), size_t(2), "Two spans");
+    ASSERT_EQ(std::string(events[0].name), std::string("inner"), "Inner ends first");
+    ASSERT_EQ(std::string(events[1].name), std::string("outer"), "Outer ends last");
+    ASSERT_TRUE(events[0].duration_us >= 5000, "Inner covers the sleep");
+    ASSERT_TRUE(events[1].start_us <= events[0].start_us, "Outer starts first");
+    ASSERT_TRUE(events[1].start_us + events[1].duration_us >= events[0].start_us + events[0].duration_us,
+                "Inner lies inside outer");
+    ASSERT_EQ(events[0].thread, events[1].thread, "Same thread number");
+
+    tracer.SetEnabled(true);
+    uint32_t other = 0;
+    std::thread([&] {
+        { ZUNE_TRACE_SPAN("test", "other_thread"); }
+        other = tracer.GetEvents().back().thread;
+    }).join();
+    tracer.SetEnabled(false);
+    ASSERT_TRUE(other != events[0].thread, "Other thread gets its own number");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestOverflow() {
+    std::cout << "Testing ring overflow..." << std::endl;
+    Tracer& tracer = Tracer::Instance();
+    tracer.Clear();
+    tracer.SetEnabled(true);
+
+    static const char* names[] = {"first", "later"};
+    { ZUNE_TRACE_SPAN("test", names[0]); }
+    for (size_t i = 0; i < Tracer::kCapacity + 9; i++) {
+        ZUNE_TRACE_SPAN("test", names[1]);
+    }
+    tracer.SetEnabled(false);
+
+    auto events = tracer.GetEvents();
+    ASSERT_EQ(events.size(), Tracer::kCapacity, "Ring holds kCapacity events");
+    ASSERT_EQ(tracer.GetDropped(), uint64_t(10), "Oldest events are dropped");
+    ASSERT_EQ(std::string(events.front().name), std::string("later"), "First event overwritten");
+
+    tracer.Clear();
+    ASSERT_EQ(tracer.GetEvents().size(), size_t(0), "Clear empties the ring");
+    ASSERT_EQ(tracer.GetDropped(), uint64_t(0), "Clear resets dropped");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestChromeJson() {
+    std::cout << "Testing Chrome trace-event JSON..." << std::endl;
+    Tracer& tracer = Tracer::Instance();
+    tracer.Clear();
+    tracer.SetEnabled(true);
+    { ZUNE_TRACE_SPAN("MtpReader", "Read\"Quoted\""); }
+    tracer.SetEnabled(false);
+
+    std::string json = tracer.ToChromeJson();
+    ASSERT_TRUE(json.find("\"traceEvents\":[") != std::string::npos, "Has traceEvents");
+    ASSERT_TRUE(json.find("\"ph\":\"X\"") != std::string::npos, "Complete events");
+    ASSERT_TRUE(json.find("\"cat\":\"MtpReader\"") != std::string::npos, "Category");
+    ASSERT_TRUE(json.find("\"name\":\"Read\\\"Quoted\\\"\"") != std::string::npos, "Name escaped");
+    ASSERT_TRUE(json.find("\"dropped\":0") != std::string::npos, "Dropped count");
+
+    tracer.Clear();
+    ASSERT_FALSE(tracer.ToChromeJson().find("\"ph\"") != std::string::npos, "Empty trace has no events");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Tracer Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestDisabled, "Disabled");
+    run_test(TestNesting, "Nesting");
+    run_test(TestOverflow, "Overflow");
+    run_test(TestChromeJson, "Chrome JSON");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/**
+ * test_transfer_stats.cpp
+ *
+ * Unit tests for the per-device transfer counters
+ * Tests histogram bucketing, Scope/Measure recording, reset and progress gating
+ */
+
+#include "lib/src/ZuneTransferStats.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestBuckets() {
+    std::cout << "Testing latency buckets..." << std::endl;
+
+    ASSERT_EQ(zune::TransferStats::BucketFor(0), 0u, "Under 1 us");
+    ASSERT_EQ(zune::TransferStats::BucketFor(1), 1u, "[1, 2) us");
+    ASSERT_EQ(zune::TransferStats::BucketFor(3), 2u, "[2, 4) us");
+    ASSERT_EQ(zune::TransferStats::BucketFor(1000), 10u, "1 ms in [512, 1024) us");
+    ASSERT_EQ(zune::TransferStats::BucketFor(1ull << 22),
+              unsigned(ZUNE_TRANSFER_HISTOGRAM_BUCKETS - 1), "4.2 s in the last bucket");
+    ASSERT_EQ(zune::TransferStats::BucketFor(~0ull),
+              unsigned(ZUNE_TRANSFER_HISTOGRAM_BUCKETS - 1), "Clamped to the last bucket");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestRecordAndSnapshot() {
+    std::cout << "Testing record, snapshot and reset..." << std::endl;
+
+    zune::TransferStats stats;
+    stats.Record(ZUNE_TRANSFER_OP_SEND_OBJECT, 1500, 1000000, 0);
+    stats.Record(ZUNE_TRANSFER_OP_SEND_OBJECT, 500, 2000000, 0);
+    stats.Record(ZUNE_TRANSFER_OP_NETWORK_POLL, 10, 0, 64, false);
+
+    ZuneTransferStats out;
+    stats.Snapshot(out);
+    const auto& send = out.ops[ZUNE_TRANSFER_OP_SEND_OBJECT];
+    ASSERT_EQ(send.count, uint64_t(2), "Two SendObjects");
+    ASSERT_EQ(send.total_us, uint64_t(2000), "Total latency");
+    ASSERT_EQ(send.max_us, uint64_t(1500), "Max latency");
+    ASSERT_EQ(send.bytes_sent, uint64_t(3000000), "SendObject bytes");
+    ASSERT_EQ(send.histogram[zune::TransferStats::BucketFor(1500)], uint64_t(1), "1.5 ms bucket");
+    ASSERT_EQ(send.histogram[zune::TransferStats::BucketFor(500)], uint64_t(1), "0.5 ms bucket");
+    ASSERT_EQ(out.ops[ZUNE_TRANSFER_OP_NETWORK_POLL].failures, uint64_t(1), "Failed poll counted");
+    ASSERT_EQ(out.bytes_sent, uint64_t(3000000), "Total bytes sent");
+    ASSERT_EQ(out.bytes_received, uint64_t(64), "Total bytes received");
+
+    stats.Reset();
+    stats.Snapshot(out);
+    ASSERT_EQ(out.ops[ZUNE_TRANSFER_OP_SEND_OBJECT].count, uint64_t(0), "Reset clears counts");
+    ASSERT_EQ(out.bytes_sent, uint64_t(0), "Reset clears bytes");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMeasure() {
+    std::cout << "Testing Scope and Measure..." << std::endl;
+
+    zune::TransferStats stats;
+    std::vector<uint8_t> reply = zune::TransferStats::Measure(
+        &stats, ZUNE_TRANSFER_OP_NETWORK_POLL, 0, [] { return std::vector<uint8_t>(42); });
+    ASSERT_EQ(reply.size(), size_t(42), "Result passed through");
+
+    uint32_t id = zune::TransferStats::Measure(
+        &stats, ZUNE_TRANSFER_OP_SEND_OBJECT_PROP_LIST, 120, [] { return 0x1234u; });
+    ASSERT_EQ(id, 0x1234u, "Scalar result passed through");
+
+    bool threw = false;
+    try {
+        zune::TransferStats::Measure(&stats, ZUNE_TRANSFER_OP_NETWORK_SEND, 8,
+                                     [] { throw std::runtime_error("stall"); });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw, "Exception propagates");
+
+    // Null stats: no recording, no crash
+    zune::TransferStats::Measure(nullptr, ZUNE_TRANSFER_OP_SEND_OBJECT, 1, [] {});
+    { zune::TransferStats::Scope scope(nullptr, ZUNE_TRANSFER_OP_SEND_OBJECT); scope.Succeeded(); }
+
+    ZuneTransferStats out;
+    stats.Snapshot(out);
+    ASSERT_EQ(out.ops[ZUNE_TRANSFER_OP_NETWORK_POLL].bytes_received, uint64_t(42), "Container counts as received");
+    ASSERT_EQ(out.ops[ZUNE_TRANSFER_OP_SEND_OBJECT_PROP_LIST].bytes_sent, uint64_t(120), "Bytes sent recorded");
+    ASSERT_EQ(out.ops[ZUNE_TRANSFER_OP_NETWORK_SEND].count, uint64_t(1), "Failed send still counted");
+    ASSERT_EQ(out.ops[ZUNE_TRANSFER_OP_NETWORK_SEND].failures, uint64_t(1), "Failed send is a failure");
+    ASSERT_EQ(out.ops[ZUNE_TRANSFER_OP_SEND_OBJECT].count, uint64_t(0), "Null stats records nothing");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+struct ProgressLog {
+    int calls = 0;
+    int op = -1;
+    uint64_t done = 0;
+    uint64_t total = 0;
+};
+
+void OnProgress(int op, uint64_t done, uint64_t total, double bytes_per_second, void* user_data) {
+    auto* log = static_cast<ProgressLog*>(user_data);
+    log->calls++;
+    log->op = op;
+    log->done = done;
+    log->total = total;
+    (void)bytes_per_second;
+}
+
+bool TestProgressCallback() {
+    std::cout << "Testing progress callback gating..." << std::endl;
+
+    zune::TransferStats stats;
+    ProgressLog log;
+    auto started = zune::TransferStats::Clock::now();
+
+    ASSERT_FALSE(stats.HasProgressCallback(), "No callback by default");
+    stats.ReportProgress(ZUNE_TRANSFER_OP_SEND_OBJECT, 10, 100, started);
+
+    stats.SetProgressCallback(OnProgress, &log);
+    ASSERT_TRUE(stats.HasProgressCallback(), "Callback registered");
+    stats.ReportProgress(ZUNE_TRANSFER_OP_SEND_OBJECT, 50, 100, started);
+    ASSERT_EQ(log.calls, 1, "Callback invoked once");
+    ASSERT_EQ(log.op, int(ZUNE_TRANSFER_OP_SEND_OBJECT), "Op passed");
+    ASSERT_EQ(log.done, uint64_t(50), "Bytes done passed");
+    ASSERT_EQ(log.total, uint64_t(100), "Bytes total passed");
+
+    stats.SetProgressCallback(nullptr, nullptr);
+    ASSERT_FALSE(stats.HasProgressCallback(), "Callback cleared");
+    stats.ReportProgress(ZUNE_TRANSFER_OP_SEND_OBJECT, 100, 100, started);
+    ASSERT_EQ(log.calls, 1, "No call after clearing");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Transfer Stats Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestBuckets, "Latency Buckets");
+    run_test(TestRecordAndSnapshot, "Record / Snapshot / Reset");
+    run_test(TestMeasure, "Scope and Measure");
+    run_test(TestProgressCallback, "Progress Callback Gating");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
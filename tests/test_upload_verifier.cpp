@@ -0,0 +1,132 @@
+/**
+ * test_upload_verifier.cpp
+ *
+ * Unit tests for zune::UploadVerifier
+ * Tests per-folder and whole-device checks, size mismatches, missing
+ * objects, folder order and Clear
+ */
+
+#include "lib/src/ZuneUploadVerifier.h"
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using zune::UploadVerifier;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+bool TestFolderCheck() {
+    std::cout << "Testing per-folder checks..." << std::endl;
+    UploadVerifier verifier;
+    verifier.Expect(0x101, 0x20, 1000);
+    verifier.Expect(0x102, 0x20, 2000);
+    verifier.Expect(0x103, 0x20, 3000);
+    verifier.Expect(0x201, 0x30, 4000);
+    ASSERT_EQ(verifier.Pending(), size_t(4), "Four expected");
+
+    // 0x102 short, 0x103 missing; 0x999 is someone else's object
+    std::unordered_map<uint32_t, uint64_t> listed = {
+        {0x101, 1000}, {0x102, 1999}, {0x999, 5}};
+    auto unconfirmed = verifier.Check(listed, 0x20);
+    ASSERT_TRUE(unconfirmed == std::vector<uint32_t>({0x102, 0x103}), "Short and missing objects unconfirmed");
+    ASSERT_EQ(verifier.Pending(), size_t(1), "Folder 0x20 settled");
+    ASSERT_TRUE(verifier.Folders() == std::vector<uint32_t>({0x30}), "Only 0x30 left");
+
+    // A check of another folder leaves nothing behind
+    unconfirmed = verifier.Check({{0x201, 4000}}, 0x30);
+    ASSERT_TRUE(unconfirmed.empty(), "Confirmed");
+    ASSERT_EQ(verifier.Pending(), size_t(0), "Nothing left");
+    ASSERT_TRUE(verifier.Folders().empty(), "No folders left");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDeviceCheck() {
+    std::cout << "Testing whole-device checks..." << std::endl;
+    UploadVerifier verifier;
+    verifier.Expect(0x101, 0x20, 1000);
+    verifier.Expect(0x201, 0x30, 4000);
+    verifier.Expect(0x301, 0x40, 0);
+
+    auto unconfirmed = verifier.Check({{0x101, 1000}, {0x201, 4000}});
+    ASSERT_TRUE(unconfirmed == std::vector<uint32_t>({0x301}), "Missing object unconfirmed");
+    ASSERT_EQ(verifier.Pending(), size_t(0), "Everything settled");
+    ASSERT_TRUE(verifier.Folders().empty(), "No folders left");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestFoldersAndClear() {
+    std::cout << "Testing folder order and Clear..." << std::endl;
+    UploadVerifier verifier;
+    verifier.Expect(0x101, 0x40, 1);
+    verifier.Expect(0x201, 0x20, 1);
+    verifier.Expect(0x102, 0x40, 1);
+    verifier.Expect(0x301, 0x30, 1);
+    ASSERT_TRUE(verifier.Folders() == std::vector<uint32_t>({0x40, 0x20, 0x30}), "Order first recorded");
+
+    // Re-recording an object replaces its size
+    verifier.Expect(0x101, 0x40, 2);
+    ASSERT_EQ(verifier.Pending(), size_t(4), "Still four expected");
+    auto unconfirmed = verifier.Check({{0x101, 2}, {0x102, 1}}, 0x40);
+    ASSERT_TRUE(unconfirmed.empty(), "Latest size confirmed");
+
+    verifier.Clear();
+    ASSERT_EQ(verifier.Pending(), size_t(0), "Cleared");
+    ASSERT_TRUE(verifier.Folders().empty(), "No folders after Clear");
+    ASSERT_TRUE(verifier.Check({}).empty(), "Nothing to settle");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " Upload Verifier Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestFolderCheck, "Folder Check");
+    run_test(TestDeviceCheck, "Device Check");
+    run_test(TestFoldersAndClear, "Folders And Clear");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
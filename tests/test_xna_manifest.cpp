@@ -0,0 +1,216 @@
+/**
+ * test_xna_manifest.cpp
+ *
+ * Unit tests for the XNA deploy manifest
+ * Tests persistence, corrupt files, change detection and schema changes
+ */
+
+#include "lib/src/ZuneXnaManifest.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using zune::XnaDeployManifest;
+
+static std::string TempDir() {
+    auto dir = std::filesystem::temp_directory_path() / "xune_test_xna_manifest";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+static XnaDeployManifest::File Describe(const std::string& path, const std::string& content) {
+    return XnaDeployManifest::Describe(path, reinterpret_cast<const uint8_t*>(content.data()), content.size());
+}
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+bool TestPersistence() {
+    std::cout << "Testing save and load..." << std::endl;
+    std::string path = TempDir() + "/" + XnaDeployManifest::FileName("SN 12/34");
+    ASSERT_TRUE(path.find("SN_12_34.xnamanifest") != std::string::npos, "Serial made safe");
+
+    XnaDeployManifest manifest;
+    manifest.Load(path);
+    ASSERT_EQ(manifest.containers().size(), size_t(0), "Missing file loads empty");
+
+    XnaDeployManifest::Container game;
+    game.key = "0f1e2d3c";
+    game.schema = 0xABCDEF;
+    game.files = {Describe("Game.exe", "code"), Describe("Content/level1.xnb", "level")};
+    manifest.Record(game);
+    XnaDeployManifest::Container other;
+    other.key = "other";
+    manifest.Record(other);
+    ASSERT_TRUE(manifest.Save(path), "Saved");
+
+    XnaDeployManifest loaded;
+    loaded.Load(path);
+    ASSERT_EQ(loaded.containers().size(), size_t(2), "Both containers");
+    const auto* found = loaded.Find("0f1e2d3c");
+    ASSERT_TRUE(found != nullptr, "Found by key");
+    ASSERT_EQ(found->schema, uint64_t(0xABCDEF), "Schema");
+    ASSERT_EQ(found->files.size(), size_t(2), "Files");
+    ASSERT_EQ(found->files[1].path, std::string("Content/level1.xnb"), "Path");
+    ASSERT_EQ(found->files[1].size, uint64_t(5), "Size");
+    ASSERT_EQ(found->files[1].hash, game.files[1].hash, "Hash");
+
+    // Record replaces, Forget removes
+    game.files.pop_back();
+    loaded.Record(game);
+    ASSERT_EQ(loaded.containers().size(), size_t(2), "Replaced in place");
+    ASSERT_EQ(loaded.Find("0f1e2d3c")->files.size(), size_t(1), "Latest record");
+    loaded.Forget("other");
+    ASSERT_TRUE(loaded.Find("other") == nullptr, "Forgotten");
+    ASSERT_TRUE(loaded.Save(path), "Saved again");
+    ASSERT_FALSE(std::filesystem::exists(path + ".tmp"), "No temporary left behind");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestCorruptFiles() {
+    std::cout << "Testing corrupt files..." << std::endl;
+    std::string path = TempDir() + "/device.xnamanifest";
+    XnaDeployManifest manifest;
+    XnaDeployManifest::Container game;
+    game.key = "game";
+    game.files = {Describe("Game.exe", "code")};
+    manifest.Record(game);
+    ASSERT_TRUE(manifest.Save(path), "Saved");
+
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // One flipped byte
+    auto flipped = bytes;
+    flipped[12] ^= 0x01;
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(flipped.data(), static_cast<std::streamsize>(flipped.size()));
+    }
+    XnaDeployManifest loaded;
+    loaded.Load(path);
+    ASSERT_EQ(loaded.containers().size(), size_t(0), "Checksum mismatch loads empty");
+
+    // Truncated
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 6));
+    }
+    loaded.Load(path);
+    ASSERT_EQ(loaded.containers().size(), size_t(0), "Truncated file loads empty");
+
+    // Not a manifest
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "not a manifest at all";
+    }
+    loaded.Load(path);
+    ASSERT_EQ(loaded.containers().size(), size_t(0), "Foreign file loads empty");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestChanged() {
+    std::cout << "Testing change detection..." << std::endl;
+    XnaDeployManifest::Container previous;
+    previous.key = "game";
+    previous.schema = 7;
+    previous.files = {Describe("Game.exe", "code v1"), Describe("a.xnb", "aaaa"),
+                      Describe("b.xnb", "bbbb"), Describe("gone.xnb", "old")};
+
+    std::vector<XnaDeployManifest::File> current = {
+        Describe("Game.exe", "code v2"),   // Same size, new content
+        Describe("a.xnb", "aaaa"),         // Unchanged
+        Describe("b.xnb", "bbbbb"),        // Resized
+        Describe("new.xnb", "new"),        // Added
+    };
+
+    auto changed = XnaDeployManifest::Changed(&previous, 7, current);
+    ASSERT_EQ(changed.size(), size_t(3), "Three to send");
+    ASSERT_EQ(changed[0], size_t(0), "Rewritten assembly");
+    ASSERT_EQ(changed[1], size_t(2), "Resized content");
+    ASSERT_EQ(changed[2], size_t(3), "New content");
+
+    current[0] = Describe("Game.exe", "code v1");
+    current[2] = Describe("b.xnb", "bbbb");
+    current.pop_back();
+    ASSERT_EQ(XnaDeployManifest::Changed(&previous, 7, current).size(), size_t(0), "Same game sends nothing");
+
+    ASSERT_EQ(XnaDeployManifest::Changed(&previous, 8, current).size(), current.size(), "New schema sends everything");
+    ASSERT_EQ(XnaDeployManifest::Changed(nullptr, 7, current).size(), current.size(), "First deploy sends everything");
+
+    // One file at a time
+    ASSERT_FALSE(XnaDeployManifest::Changed(&previous, 7, Describe("a.xnb", "aaaa")), "Single unchanged");
+    ASSERT_TRUE(XnaDeployManifest::Changed(&previous, 7, Describe("a.xnb", "aaab")), "Single rewritten");
+    ASSERT_TRUE(XnaDeployManifest::Changed(&previous, 7, Describe("new.xnb", "new")), "Single added");
+    ASSERT_TRUE(XnaDeployManifest::Changed(&previous, 8, Describe("a.xnb", "aaaa")), "Single, new schema");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " XNA Deploy Manifest Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestPersistence, "Persistence");
+    run_test(TestCorruptFiles, "Corrupt Files");
+    run_test(TestChanged, "Changed");
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "xune_test_xna_manifest");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,411 @@
+/**
+ * test_xna_transport.cpp
+ *
+ * Unit tests for zune::XnaTransport and the XNAFTW frame helpers
+ * Tests frame layout, delayed-content framing, ack-driven windows, pacing
+ * on busy writes and slow or missing acks, early responses and channel close
+ */
+
+#include "lib/src/ZuneXnaTransport.h"
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using zune::XnaFrame;
+using zune::XnaTransport;
+using Clock = std::chrono::steady_clock;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+XnaFrame ControlFrame(uint16_t opcode, uint16_t value) {
+    uint8_t payload[4] = {
+        static_cast<uint8_t>(opcode & 0xFF), static_cast<uint8_t>(opcode >> 8),
+        static_cast<uint8_t>(value & 0xFF), static_cast<uint8_t>(value >> 8),
+    };
+    return zune::BuildXnaFrame(0, 0x00, 4, payload, 4);
+}
+
+std::vector<uint8_t> ResponsePayload() {
+    std::vector<uint8_t> payload = {'X', 'N', 'A', 'F', 'T', 'W', 0x02, 0x00, 0x00};
+    return payload;
+}
+
+std::vector<uint8_t> Content(size_t size) {
+    std::vector<uint8_t> content(size);
+    for (size_t i = 0; i < size; i++) {
+        content[i] = static_cast<uint8_t>((i * 31 + i / 251) & 0xFF);
+    }
+    return content;
+}
+
+// Reassembles delayed chunks and acks each one once it has "processed" it.
+// Starting a chunk while capacity chunks are still unprocessed overflows:
+// the device answers busy or closes the channel.
+struct FakeDevice {
+    size_t capacity_chunks = 1;
+    std::chrono::milliseconds process_time{0};
+    bool send_acks = true;
+    bool busy_when_full = false;
+    size_t respond_after_chunks = 0;   // 0: never answers early
+
+    std::vector<uint8_t> received;
+    size_t chunks = 0;
+    size_t writes = 0;
+    uint32_t next_sequence = 0;
+    bool sequence_ok = true;
+    bool frames_ok = true;
+    bool overflowed = false;
+
+    std::vector<uint8_t> current;
+    size_t expected = 0;
+    std::deque<Clock::time_point> processing;
+    std::deque<XnaFrame> outbound;
+
+    XnaTransport::Link Link() {
+        XnaTransport::Link link;
+        link.write = [this](const XnaFrame& frame) { return Write(frame); };
+        link.read = [this](XnaFrame& frame) { return Read(frame); };
+        return link;
+    }
+
+    void Process() {
+        auto now = Clock::now();
+        while (!processing.empty() && processing.front() <= now) {
+            processing.pop_front();
+            if (send_acks) outbound.push_back(ControlFrame(zune::kXnaDelayedStatusOpcode, 0));
+        }
+    }
+
+    XnaTransport::WriteStatus Write(const XnaFrame& frame) {
+        Process();
+        auto info = zune::ParseXnaFrame(frame);
+        if (!info) {
+            frames_ok = false;
+            return XnaTransport::WriteStatus::Sent;
+        }
+        const uint8_t* payload = frame.data() + zune::kXnaHeaderSize;
+        size_t length = info->payload_length;
+
+        if (current.empty() && expected == 0) {
+            if (processing.size() >= capacity_chunks) {
+                if (busy_when_full) return XnaTransport::WriteStatus::Busy;
+                if (!overflowed) outbound.push_back(ControlFrame(0x01C1, 0));
+                overflowed = true;
+            }
+            if (length < 5 || payload[0] != 0x00) frames_ok = false;
+            expected = static_cast<size_t>(payload[1]) | (static_cast<size_t>(payload[2]) << 8) |
+                       (static_cast<size_t>(payload[3]) << 16) | (static_cast<size_t>(payload[4]) << 24);
+            payload += 5;
+            length -= 5;
+        }
+        writes++;
+        if (info->sequence != next_sequence++) sequence_ok = false;
+        current.insert(current.end(), payload, payload + length);
+        if (current.size() > expected) frames_ok = false;
+        if (current.size() >= expected) {
+            received.insert(received.end(), current.begin(), current.end());
+            current.clear();
+            expected = 0;
+            chunks++;
+            processing.push_back(Clock::now() + process_time);
+            if (respond_after_chunks != 0 && chunks == respond_after_chunks) {
+                auto response = ResponsePayload();
+                outbound.push_back(zune::BuildXnaFrame(0, 0x01, static_cast<uint16_t>(response.size()),
+                                                       response.data(), response.size()));
+            }
+        }
+        return XnaTransport::WriteStatus::Sent;
+    }
+
+    bool Read(XnaFrame& frame) {
+        Process();
+        if (outbound.empty()) return false;
+        frame = std::move(outbound.front());
+        outbound.pop_front();
+        return true;
+    }
+};
+
+bool TestFrames() {
+    std::cout << "Testing frame layout and parsing..." << std::endl;
+    uint8_t payload[3] = {1, 2, 3};
+    XnaFrame frame = zune::BuildXnaFrame(0x01020304, 0x02, 3, payload, 3);
+    ASSERT_EQ(frame.size(), zune::kXnaFrameSize, "Frames are full size");
+    ASSERT_TRUE(frame[0] == 0x01 && frame[3] == 0x04, "Sequence is big-endian");
+    ASSERT_TRUE(frame[5] == 0x00 && frame[6] == 0x03, "Length is big-endian");
+    ASSERT_TRUE(frame[7] == 1 && frame[9] == 3 && frame[10] == 0, "Payload then padding");
+
+    auto info = zune::ParseXnaFrame(frame);
+    ASSERT_TRUE(info.has_value(), "Parses");
+    ASSERT_EQ(info->sequence, uint32_t(0x01020304), "Sequence");
+    ASSERT_EQ(static_cast<int>(info->channel), 2, "Channel");
+    ASSERT_FALSE(info->has_control_opcode, "Only channel 0 carries control opcodes");
+    ASSERT_FALSE(zune::ParseXnaFrame(XnaFrame(10)).has_value(), "Short frame rejected");
+
+    auto status = zune::ParseXnaFrame(ControlFrame(zune::kXnaDelayedStatusOpcode, 0x1234));
+    ASSERT_TRUE(status->has_control_opcode, "Control frame");
+    ASSERT_EQ(status->control_opcode, zune::kXnaDelayedStatusOpcode, "Status opcode");
+    ASSERT_EQ(status->control_value, uint16_t(0x1234), "Status value");
+    ASSERT_TRUE(zune::IsXnaChannelClose(ControlFrame(0x02C1, 0)), "Close on any channel");
+    ASSERT_FALSE(zune::IsXnaChannelClose(ControlFrame(zune::kXnaDelayedStatusOpcode, 0)), "Status is not close");
+
+    // A response packed behind a status frame's payload
+    auto response = ResponsePayload();
+    XnaFrame packed = ControlFrame(zune::kXnaDelayedStatusOpcode, 0);
+    size_t at = zune::kXnaHeaderSize + 4;
+    packed[at] = 0x01;
+    packed[at + 1] = 0x00;
+    packed[at + 2] = static_cast<uint8_t>(response.size());
+    std::copy(response.begin(), response.end(), packed.begin() + static_cast<std::ptrdiff_t>(at + 3));
+    ASSERT_FALSE(zune::IsXnaResponse(packed), "Outer frame is not a response");
+    auto embedded = zune::ExtractEmbeddedXnaResponse(packed);
+    ASSERT_TRUE(embedded.has_value(), "Embedded response found");
+    ASSERT_TRUE(zune::IsXnaResponse(*embedded), "Rebuilt as a response frame");
+    ASSERT_EQ(embedded->size(), zune::kXnaHeaderSize + response.size(), "Rebuilt length");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPromptAcksNeverSleep() {
+    std::cout << "Testing prompt acks send back to back..." << std::endl;
+    FakeDevice device;
+    XnaTransport transport(device.Link());
+    auto content = Content(zune::kXnaDelayedChunkLimit * 12 + 777);
+    uint32_t sequence = 40;
+    device.next_sequence = 40;
+
+    auto start = Clock::now();
+    auto result = transport.SendDelayed(0x01, content.data(), content.size(), sequence);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+
+    ASSERT_TRUE(result == XnaTransport::Result::Sent, "All content sent");
+    ASSERT_TRUE(device.received == content, "Content reassembles");
+    ASSERT_TRUE(device.sequence_ok && device.frames_ok, "Frames numbered and framed");
+    ASSERT_FALSE(device.overflowed, "Device never overflowed");
+    ASSERT_EQ(transport.stats().chunks, uint64_t(13), "Chunks");
+    ASSERT_EQ(transport.stats().frames, uint64_t(device.writes), "Frames counted");
+    ASSERT_EQ(sequence, uint32_t(40 + device.writes), "Sequence advanced");
+    ASSERT_EQ(transport.stats().paced.count(), int64_t(0), "No pacing");
+    ASSERT_EQ(transport.stats().missed_acks, uint64_t(0), "No missed acks");
+    // The fixed 10 ms per frame took over 14 s for this
+    ASSERT_TRUE(elapsed.count() < 2000, "Time follows the link, not the frame count");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestWindowKeepsChunksInFlight() {
+    std::cout << "Testing a window of several chunks..." << std::endl;
+    FakeDevice device;
+    device.capacity_chunks = 3;
+    device.process_time = std::chrono::milliseconds(4);
+    XnaTransport::Options options;
+    options.window_chunks = 3;
+    XnaTransport transport(device.Link(), options);
+    auto content = Content(zune::kXnaDelayedChunkLimit * 8);
+    uint32_t sequence = 0;
+
+    auto result = transport.SendDelayed(0x01, content.data(), content.size(), sequence);
+    ASSERT_TRUE(result == XnaTransport::Result::Sent, "All content sent");
+    ASSERT_TRUE(device.received == content, "Content reassembles");
+    ASSERT_FALSE(device.overflowed, "Window never exceeds the device buffer");
+    ASSERT_TRUE(transport.stats().acks >= 5, "Advanced on acks");
+    ASSERT_EQ(transport.stats().paced.count(), int64_t(0), "No pacing");
+
+    // The same window against a one-chunk device closes the channel
+    FakeDevice small;
+    small.process_time = std::chrono::milliseconds(20);
+    XnaTransport greedy(small.Link(), options);
+    sequence = 0;
+    result = greedy.SendDelayed(0x01, content.data(), content.size(), sequence);
+    ASSERT_TRUE(result == XnaTransport::Result::ChannelClosed, "Overflow surfaces as channel close");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestBusyWritesPace() {
+    std::cout << "Testing busy writes slow the sender..." << std::endl;
+    FakeDevice device;
+    device.busy_when_full = true;
+    device.process_time = std::chrono::milliseconds(6);
+    XnaTransport::Options options;
+    options.window_chunks = 4;   // More than the device holds
+    XnaTransport transport(device.Link(), options);
+    auto content = Content(zune::kXnaDelayedChunkLimit * 6);
+    uint32_t sequence = 0;
+
+    auto result = transport.SendDelayed(0x01, content.data(), content.size(), sequence);
+    ASSERT_TRUE(result == XnaTransport::Result::Sent, "All content sent");
+    ASSERT_TRUE(device.received == content, "Content reassembles");
+    ASSERT_TRUE(device.sequence_ok, "Retried frames keep their sequence");
+    ASSERT_TRUE(transport.stats().busy_writes > 0, "Device pushed back");
+    ASSERT_TRUE(transport.stats().paced.count() > 0, "Pacing engaged");
+
+    // Busy for good: give up
+    FakeDevice stuck;
+    stuck.busy_when_full = true;
+    stuck.send_acks = false;
+    stuck.process_time = std::chrono::hours(1);
+    options.max_busy_retries = 3;
+    XnaTransport blocked(stuck.Link(), options);
+    sequence = 0;
+    result = blocked.SendDelayed(0x01, content.data(), content.size(), sequence);
+    ASSERT_TRUE(result == XnaTransport::Result::WriteFailed, "Busy past the retries fails");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestSlowAndMissingAcks() {
+    std::cout << "Testing slow and missing acks..." << std::endl;
+    auto content = Content(zune::kXnaDelayedChunkLimit * 4);
+
+    FakeDevice slow;
+    slow.capacity_chunks = 3;
+    slow.process_time = std::chrono::milliseconds(15);
+    XnaTransport::Options options;
+    options.window_chunks = 3;
+    options.slow_ack = std::chrono::milliseconds(5);
+    XnaTransport paced(slow.Link(), options);
+    uint32_t sequence = 0;
+    auto result = paced.SendDelayed(0x01, content.data(), content.size(), sequence);
+    ASSERT_TRUE(result == XnaTransport::Result::Sent, "Slow device still gets everything");
+    ASSERT_TRUE(slow.received == content, "Content reassembles");
+    ASSERT_TRUE(paced.stats().slow_acks > 0, "Slow acks counted");
+    ASSERT_EQ(paced.stats().paced.count(), int64_t(0), "Slow acks alone never pace frames");
+
+    FakeDevice mute;
+    mute.send_acks = false;
+    options = XnaTransport::Options();
+    options.ack_timeout = std::chrono::milliseconds(10);
+    XnaTransport tolerant(mute.Link(), options);
+    sequence = 0;
+    result = tolerant.SendDelayed(0x01, content.data(), content.size(), sequence);
+    ASSERT_TRUE(result == XnaTransport::Result::Sent, "Missing acks do not stall the transfer");
+    ASSERT_TRUE(mute.received == content, "Content reassembles");
+    ASSERT_EQ(tolerant.stats().missed_acks, uint64_t(3), "Every wait timed out");
+    ASSERT_TRUE(tolerant.frame_delay().count() > 0, "Pacing engaged");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPacingRelaxes() {
+    std::cout << "Testing pacing relaxes on prompt acks..." << std::endl;
+    FakeDevice device;
+    device.busy_when_full = true;
+    device.process_time = std::chrono::milliseconds(3);
+    XnaTransport::Options options;
+    options.window_chunks = 2;
+    XnaTransport transport(device.Link(), options);
+    auto content = Content(zune::kXnaDelayedChunkLimit * 2);
+    uint32_t sequence = 0;
+
+    ASSERT_TRUE(transport.SendDelayed(0x01, content.data(), content.size(), sequence) ==
+                XnaTransport::Result::Sent, "First transfer sent");
+    ASSERT_TRUE(transport.frame_delay().count() > 0, "Busy write engaged pacing");
+
+    // Acks the moment a chunk lands
+    device.process_time = std::chrono::milliseconds(0);
+    device.busy_when_full = false;
+    auto more = Content(zune::kXnaDelayedChunkLimit * 16);
+    ASSERT_TRUE(transport.SendDelayed(0x01, more.data(), more.size(), sequence) ==
+                XnaTransport::Result::Sent, "Second transfer sent");
+    ASSERT_EQ(transport.frame_delay().count(), int64_t(0), "Delay back to zero");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestEarlyResponse() {
+    std::cout << "Testing an early response..." << std::endl;
+    FakeDevice device;
+    device.respond_after_chunks = 2;
+    XnaTransport transport(device.Link());
+    auto content = Content(zune::kXnaDelayedChunkLimit * 5);
+    uint32_t sequence = 0;
+    XnaFrame response;
+
+    auto result = transport.SendDelayed(0x01, content.data(), content.size(), sequence, &response);
+    ASSERT_TRUE(result == XnaTransport::Result::Response, "Stopped on the response");
+    ASSERT_TRUE(zune::IsXnaResponse(response), "Response handed back");
+    ASSERT_EQ(device.chunks, size_t(2), "Nothing sent after it");
+
+    // Receive
+    device.outbound.clear();
+    device.processing.clear();
+    ASSERT_TRUE(transport.Receive(std::chrono::milliseconds(5)).empty(), "Nothing queued times out");
+    device.outbound.push_back(ControlFrame(0x0042, 0));
+    int observed = 0;
+    XnaTransport::Link link = device.Link();
+    link.observe = [&](const XnaFrame&) { observed++; };
+    XnaTransport watched(link);
+    ASSERT_EQ(watched.Receive(std::chrono::milliseconds(5)).size(), zune::kXnaFrameSize, "Frame received");
+    ASSERT_EQ(observed, 1, "Observer saw it");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " XNA Transport Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestFrames, "Frames");
+    run_test(TestPromptAcksNeverSleep, "Prompt Acks");
+    run_test(TestWindowKeepsChunksInFlight, "Window");
+    run_test(TestBusyWritesPace, "Busy Writes");
+    run_test(TestSlowAndMissingAcks, "Slow / Missing Acks");
+    run_test(TestPacingRelaxes, "Pacing Relaxes");
+    run_test(TestEarlyResponse, "Early Response / Receive");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
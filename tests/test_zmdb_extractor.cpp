@@ -7,6 +7,7 @@
 #include <cstring>
 #include <algorithm>
 #include <memory>
+#include <cctype>
 
 #include "lib/src/ZuneDevice.h"
 #include "lib/src/ZuneDeviceIdentification.h"
@@ -380,6 +381,7 @@ static void PrintUsage(const char* prog) {
     std::cout << "  --output <path>       JSON output path (default: library.json)\n";
     std::cout << "  --device-type <type>  Override: Zune30 / Zune80 / ZuneHD\n";
     std::cout << "  --verbose             Enable verbose device logging\n";
+    std::cout << "  --parallel [N]        Parallel extraction (N threads, default: all cores)\n";
     std::cout << "  --help                Show this help\n";
 }
 
@@ -393,6 +395,8 @@ int main(int argc, char* argv[]) {
     std::string output_file = "library.json";
     std::string device_type_override;
     bool verbose = false;
+    bool parallel = false;
+    unsigned parallel_threads = 0;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -402,6 +406,12 @@ int main(int argc, char* argv[]) {
         else if (arg == "--output" && i + 1 < argc) { output_file = argv[++i]; }
         else if (arg == "--device-type" && i + 1 < argc) { device_type_override = argv[++i]; }
         else if (arg == "--verbose") { verbose = true; }
+        else if (arg == "--parallel") {
+            parallel = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                parallel_threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+        }
         else if (!arg.empty() && arg[0] != '-' && file_path.empty()) {
             source_mode = "file"; file_path = arg;
         } else {
@@ -460,6 +470,8 @@ int main(int argc, char* argv[]) {
         std::cerr << "ERROR: no parser available for this device family\n"; return 1;
     }
 
+    parser->SetParallelExtraction(parallel, parallel_threads);
+
     zmdb::ZMDBLibrary library;
     try {
         library = parser->ExtractLibrary(zmdb_data);
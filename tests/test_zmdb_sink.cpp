@@ -0,0 +1,379 @@
+/**
+ * test_zmdb_sink.cpp
+ *
+ * Unit tests for parsing into a ZMDBRecordSink (ZMDBParserBase::Extract)
+ * Tests that the library sink matches ExtractLibrary on both layouts, serial
+ * and parallel, consumers with only some calls, snapshot replay, and that
+ * the ZuneMusicLibrary built while parsing matches the one built from a
+ * parsed library
+ */
+
+#include "tests/zmdb_synthetic.h"
+#include "lib/src/ZuneMusicLibrarySink.h"
+#include "lib/src/zmdb/ZuneClassicParser.h"
+#include "lib/src/zmdb/ZuneHDParser.h"
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using zmdb_synthetic::Layout;
+using zmdb_synthetic::LibraryShape;
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+namespace {
+
+constexpr uint32_t kTracks = 9000;  // Several parallel chunks
+
+std::unique_ptr<zmdb::ZMDBParserBase> MakeParser(Layout layout, bool parallel) {
+    std::unique_ptr<zmdb::ZMDBParserBase> parser;
+    if (layout == Layout::HD) {
+        parser = std::make_unique<zmdb::ZuneHDParser>();
+    } else {
+        parser = std::make_unique<zmdb::ZuneClassicParser>();
+    }
+    parser->SetParallelExtraction(parallel, 4);
+    return parser;
+}
+
+const char* Name(Layout layout) {
+    return layout == Layout::HD ? "HD" : "Classic";
+}
+
+bool SameLibrary(const zmdb::ZMDBLibrary& a, const zmdb::ZMDBLibrary& b, const std::string& what) {
+    ASSERT_TRUE(a.device_family == b.device_family, what + ": family");
+    ASSERT_EQ(a.track_count, b.track_count, what + ": tracks");
+    ASSERT_EQ(a.video_count, b.video_count, what + ": videos");
+    ASSERT_EQ(a.picture_count, b.picture_count, what + ": pictures");
+    ASSERT_EQ(a.playlist_count, b.playlist_count, what + ": playlists");
+    ASSERT_EQ(a.podcast_count, b.podcast_count, what + ": podcasts");
+    ASSERT_EQ(a.audiobook_count, b.audiobook_count, what + ": audiobooks");
+    ASSERT_EQ(a.podcast_show_count, b.podcast_show_count, what + ": podcast shows");
+    ASSERT_EQ(a.album_count, b.album_count, what + ": albums");
+    ASSERT_EQ(a.artist_count, b.artist_count, what + ": artists");
+    ASSERT_EQ(a.genre_count, b.genre_count, what + ": genres");
+    ASSERT_TRUE(a.details_deferred == b.details_deferred, what + ": details_deferred");
+    ASSERT_EQ(a.tracks_capacity, b.tracks_capacity, what + ": track capacity");
+    ASSERT_EQ(a.podcasts_capacity, b.podcasts_capacity, what + ": podcast capacity");
+
+    for (int i = 0; i < a.track_count; i++) {
+        const auto& x = a.tracks[i];
+        const auto& y = b.tracks[i];
+        if (x.atom_id != y.atom_id || x.title != y.title || x.artist_name.str() != y.artist_name.str() ||
+            x.genre.str() != y.genre.str() || x.album_ref != y.album_ref) {
+            std::cerr << "FAIL: " << what << ": track " << i << " differs" << std::endl;
+            return false;
+        }
+    }
+    for (int i = 0; i < a.video_count; i++) {
+        ASSERT_EQ(a.videos[i].title, b.videos[i].title, what + ": video");
+    }
+    for (int i = 0; i < a.playlist_count; i++) {
+        ASSERT_TRUE(a.playlists[i].track_atom_ids == b.playlists[i].track_atom_ids, what + ": playlist");
+    }
+    for (int i = 0; i < a.podcast_count; i++) {
+        ASSERT_EQ(a.podcasts[i].atom_id, b.podcasts[i].atom_id, what + ": podcast");
+        ASSERT_EQ(a.podcasts[i].show_name, b.podcasts[i].show_name, what + ": podcast show name");
+    }
+
+    auto album = b.album_metadata.begin();
+    for (const auto& [atom_id, value] : a.album_metadata) {
+        ASSERT_EQ(album->first, atom_id, what + ": album order");
+        ASSERT_EQ(album->second.title, value.title, what + ": album title");
+        ++album;
+    }
+    auto artist = b.artist_metadata.begin();
+    for (const auto& [atom_id, value] : a.artist_metadata) {
+        ASSERT_EQ(artist->first, atom_id, what + ": artist order");
+        ASSERT_EQ(artist->second.name, value.name, what + ": artist name");
+        ++artist;
+    }
+    auto genre = b.genre_metadata.begin();
+    for (const auto& [atom_id, value] : a.genre_metadata) {
+        ASSERT_EQ(genre->first, atom_id, what + ": genre order");
+        ++genre;
+    }
+    auto show = b.podcast_show_metadata.begin();
+    for (const auto& [atom_id, value] : a.podcast_show_metadata) {
+        ASSERT_EQ(show->first, atom_id, what + ": show order");
+        ASSERT_EQ(show->second.name, value.name, what + ": show name");
+        ++show;
+    }
+    return true;
+}
+
+bool SameString(const char* a, const char* b) {
+    return a && b && std::strcmp(a, b) == 0;
+}
+
+bool SameMusicLibrary(const ZuneMusicLibrary& a, const ZuneMusicLibrary& b, const std::string& what) {
+    ASSERT_EQ(a.track_count, b.track_count, what + ": tracks");
+    ASSERT_EQ(a.album_count, b.album_count, what + ": albums");
+    ASSERT_EQ(a.artist_count, b.artist_count, what + ": artists");
+    ASSERT_EQ(a.genre_count, b.genre_count, what + ": genres");
+    ASSERT_EQ(a.artwork_count, b.artwork_count, what + ": artworks");
+    ASSERT_EQ(a.playlist_count, b.playlist_count, what + ": playlists");
+    ASSERT_EQ(a.podcast_show_count, b.podcast_show_count, what + ": podcast shows");
+    ASSERT_EQ(a.podcast_episode_count, b.podcast_episode_count, what + ": podcast episodes");
+    ASSERT_TRUE((a.podcast_episodes == nullptr) == (b.podcast_episodes == nullptr), what + ": episode array");
+
+    for (uint32_t i = 0; i < a.track_count; i++) {
+        const auto& x = a.tracks[i];
+        const auto& y = b.tracks[i];
+        if (x.atom_id != y.atom_id || !SameString(x.title, y.title) ||
+            !SameString(x.artist_name, y.artist_name) || !SameString(x.artist_guid, y.artist_guid) ||
+            !SameString(x.genre, y.genre) || x.album_ref != y.album_ref ||
+            x.duration_ms != y.duration_ms || x.track_number != y.track_number) {
+            std::cerr << "FAIL: " << what << ": track " << i << " differs" << std::endl;
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < a.album_count; i++) {
+        ASSERT_EQ(a.albums[i].atom_id, b.albums[i].atom_id, what + ": album order");
+        ASSERT_TRUE(SameString(a.albums[i].title, b.albums[i].title), what + ": album title");
+        ASSERT_TRUE(SameString(a.albums[i].alb_reference, b.albums[i].alb_reference), what + ": album .alb");
+    }
+    for (uint32_t i = 0; i < a.artist_count; i++) {
+        ASSERT_EQ(a.artists[i].atom_id, b.artists[i].atom_id, what + ": artist order");
+        ASSERT_TRUE(SameString(a.artists[i].guid, b.artists[i].guid), what + ": artist guid");
+    }
+    for (uint32_t i = 0; i < a.genre_count; i++) {
+        ASSERT_TRUE(SameString(a.genres[i].name, b.genres[i].name), what + ": genre");
+    }
+    for (uint32_t i = 0; i < a.playlist_count; i++) {
+        ASSERT_EQ(a.playlists[i].track_count, b.playlists[i].track_count, what + ": playlist length");
+        ASSERT_TRUE(std::memcmp(a.playlists[i].track_atom_ids, b.playlists[i].track_atom_ids,
+                                a.playlists[i].track_count * sizeof(uint32_t)) == 0,
+                    what + ": playlist entries");
+    }
+    for (uint32_t i = 0; i < a.podcast_show_count; i++) {
+        ASSERT_EQ(a.podcast_shows[i].atom_id, b.podcast_shows[i].atom_id, what + ": show order");
+        ASSERT_TRUE(SameString(a.podcast_shows[i].name, b.podcast_shows[i].name), what + ": show name");
+    }
+    for (uint32_t i = 0; i < a.podcast_episode_count; i++) {
+        ASSERT_EQ(a.podcast_episodes[i].atom_id, b.podcast_episodes[i].atom_id, what + ": episode");
+        ASSERT_EQ(a.podcast_episodes[i].media_type, b.podcast_episodes[i].media_type, what + ": media type");
+    }
+    return true;
+}
+
+// Consumer declaring only some of the sink calls (used through ZMDBSinkAdapter)
+struct TrackCounter {
+    int planned = -1;
+    int tracks = 0;
+    uint64_t duration_ms = 0;
+
+    void Begin(const zmdb::ZMDBExtractionPlan& plan) { planned = plan.tracks; }
+    void OnTrack(zmdb::ZMDBTrack&& track) {
+        tracks++;
+        duration_ms += static_cast<uint64_t>(track.duration_ms);
+    }
+};
+
+} // namespace
+
+bool TestLibrarySinkMatchesExtract() {
+    std::cout << "Testing library sink against ExtractLibrary..." << std::endl;
+    for (Layout layout : {Layout::HD, Layout::Classic}) {
+        std::vector<uint8_t> blob = zmdb_synthetic::BuildZmdb(layout, LibraryShape::ForTracks(kTracks));
+        zmdb::ZMDBLibrary expected = MakeParser(layout, false)->ExtractLibrary(blob);
+        ASSERT_EQ(expected.track_count, static_cast<int>(kTracks), std::string(Name(layout)) + ": parsed");
+
+        for (bool parallel : {false, true}) {
+            std::string what = std::string(Name(layout)) + (parallel ? " parallel" : " serial");
+            auto parser = MakeParser(layout, parallel);
+
+            zmdb::ZMDBLibrary library;
+            library.device_family = expected.device_family;
+            zmdb::ZMDBLibrarySink sink(library);
+            parser->Extract(blob, sink);
+            if (!SameLibrary(expected, library, what)) return false;
+
+            // And ExtractLibrary itself is unchanged by the worker path
+            if (!SameLibrary(expected, parser->ExtractLibrary(blob), what + " ExtractLibrary")) return false;
+        }
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestPartialConsumer() {
+    std::cout << "Testing a consumer with only some calls..." << std::endl;
+    std::vector<uint8_t> blob = zmdb_synthetic::BuildZmdb(Layout::HD, LibraryShape::ForTracks(kTracks));
+    zmdb::ZMDBLibrary expected = MakeParser(Layout::HD, false)->ExtractLibrary(blob);
+    uint64_t expected_duration = 0;
+    for (int i = 0; i < expected.track_count; i++) {
+        expected_duration += static_cast<uint64_t>(expected.tracks[i].duration_ms);
+    }
+
+    for (bool parallel : {false, true}) {
+        TrackCounter counter;
+        MakeParser(Layout::HD, parallel)->Extract(blob, counter);
+        ASSERT_EQ(counter.planned, expected.tracks_capacity, "Begin forwarded");
+        ASSERT_EQ(counter.tracks, expected.track_count, "Every track");
+        ASSERT_EQ(counter.duration_ms, expected_duration, "Track contents");
+    }
+
+    // Not a ZMDB: nothing is called
+    std::vector<uint8_t> junk(4096, 0x5A);
+    TrackCounter counter;
+    MakeParser(Layout::HD, false)->Extract(junk, counter);
+    ASSERT_EQ(counter.planned, -1, "No Begin");
+    ASSERT_EQ(counter.tracks, 0, "No records");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestLibraryReplay() {
+    std::cout << "Testing replay of a materialized library..." << std::endl;
+    for (Layout layout : {Layout::HD, Layout::Classic}) {
+        std::vector<uint8_t> blob = zmdb_synthetic::BuildZmdb(layout, LibraryShape::ForTracks(2000));
+        zmdb::ZMDBLibrary expected = MakeParser(layout, false)->ExtractLibrary(blob);
+
+        // The default OnLibrary replays record by record
+        zmdb::ZMDBLibrary replayed;
+        replayed.device_family = expected.device_family;
+        zmdb::ZMDBLibrarySink sink(replayed);
+        sink.ZMDBRecordSink::OnLibrary(MakeParser(layout, false)->ExtractLibrary(blob));
+        // Sized from the counts, not from the descriptors
+        ASSERT_TRUE(replayed.podcasts_capacity <= expected.podcasts_capacity, "Exact capacity");
+        replayed.tracks_capacity = expected.tracks_capacity;
+        replayed.podcasts_capacity = expected.podcasts_capacity;
+        if (!SameLibrary(expected, replayed, std::string(Name(layout)) + " replay")) return false;
+
+        // Reset drops what was received but keeps the family
+        sink.Reset();
+        ASSERT_EQ(replayed.track_count, 0, "Reset");
+        ASSERT_TRUE(replayed.tracks == nullptr && replayed.album_metadata.empty(), "Reset frees");
+        ASSERT_TRUE(replayed.device_family == expected.device_family, "Family kept");
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMusicLibrarySink() {
+    std::cout << "Testing ZuneMusicLibrary built while parsing..." << std::endl;
+    std::unordered_map<std::string, uint32_t> alb_to_objectid = {
+        {"Artist 1--Album 1.alb", 0x1001}, {"Artist 1--Album 2.alb", 0x1002}};
+
+    for (Layout layout : {Layout::HD, Layout::Classic}) {
+        std::vector<uint8_t> blob = zmdb_synthetic::BuildZmdb(layout, LibraryShape::ForTracks(kTracks));
+        for (bool parallel : {false, true}) {
+            std::string what = std::string(Name(layout)) + (parallel ? " parallel" : " serial");
+
+            zune::MusicLibrarySink from_library;
+            from_library.Add(MakeParser(layout, parallel)->ExtractLibrary(blob));
+            std::unique_ptr<ZuneMusicLibrary, decltype(&zune::FreeMusicLibrary)> expected(
+                from_library.Release(alb_to_objectid), &zune::FreeMusicLibrary);
+
+            zune::MusicLibrarySink direct;
+            MakeParser(layout, parallel)->Extract(blob, direct);
+            std::unique_ptr<ZuneMusicLibrary, decltype(&zune::FreeMusicLibrary)> built(
+                direct.Release(alb_to_objectid), &zune::FreeMusicLibrary);
+
+            ASSERT_TRUE(expected && built, what + ": built");
+            ASSERT_EQ(built->track_count, kTracks, what + ": tracks");
+            ASSERT_EQ(built->artwork_count, uint32_t(2), what + ": artworks");
+            if (!SameMusicLibrary(*expected, *built, what)) return false;
+
+            // Interned track strings are duplicated once and shared
+            bool shared = false;
+            for (uint32_t i = 1; i < built->track_count && !shared; i++) {
+                shared = SameString(built->tracks[i].genre, built->tracks[0].genre) &&
+                         built->tracks[i].genre == built->tracks[0].genre;
+            }
+            ASSERT_TRUE(shared, what + ": genre shared between tracks");
+        }
+    }
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestMusicLibrarySinkReset() {
+    std::cout << "Testing ZuneMusicLibrary sink reset and empty input..." << std::endl;
+    std::vector<uint8_t> blob = zmdb_synthetic::BuildZmdb(Layout::HD, LibraryShape::ForTracks(1000));
+
+    // A transfer that failed part way is parsed again from the start
+    zune::MusicLibrarySink sink;
+    MakeParser(Layout::HD, false)->Extract(blob, sink);
+    sink.Reset();
+    MakeParser(Layout::HD, false)->Extract(blob, sink);
+    ZuneMusicLibrary* library = sink.Release({});
+    ASSERT_TRUE(library != nullptr, "Built");
+    ASSERT_EQ(library->track_count, uint32_t(1000), "Tracks once");
+    ASSERT_EQ(library->artwork_count, uint32_t(0), "No artworks");
+    zune::FreeMusicLibrary(library);
+
+    // Nothing parsed: empty arrays, no episode array
+    zune::MusicLibrarySink empty;
+    std::vector<uint8_t> junk(64, 0);
+    MakeParser(Layout::Classic, false)->Extract(junk, empty);
+    library = empty.Release({});
+    ASSERT_TRUE(library != nullptr, "Empty library");
+    ASSERT_EQ(library->track_count, uint32_t(0), "No tracks");
+    ASSERT_TRUE(library->tracks != nullptr && library->albums != nullptr, "Zero-size arrays");
+    ASSERT_TRUE(library->podcast_episodes == nullptr, "No episode array");
+    zune::FreeMusicLibrary(library);
+
+    // Abandoned part way: the destructor frees it
+    zune::MusicLibrarySink abandoned;
+    MakeParser(Layout::HD, true)->Extract(blob, abandoned);
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " ZMDB Record Sink Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestLibrarySinkMatchesExtract, "Library Sink Matches Extract");
+    run_test(TestPartialConsumer, "Partial Consumer");
+    run_test(TestLibraryReplay, "Library Replay");
+    run_test(TestMusicLibrarySink, "Music Library Sink");
+    run_test(TestMusicLibrarySinkReset, "Music Library Sink Reset");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,427 @@
+/**
+ * test_zmdb_snapshot.cpp
+ *
+ * Unit tests for the on-host ZMDB library snapshot (ZMDBSnapshot)
+ * Tests round-tripping a parsed library, rejecting stale/corrupt files,
+ * lookup by device fingerprint, and writing and reading through sinks
+ */
+
+#include "lib/src/zmdb/ZMDBSnapshot.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+static const std::string kSnapshotPath = "test_zmdb_snapshot.bin";
+static const std::vector<uint8_t> kZmdb = {'Z', 'M', 'D', 'B', 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+template <typename T>
+static T* AllocateRecords(int count) {
+    T* records = static_cast<T*>(::operator new[](count * sizeof(T)));
+    for (int i = 0; i < count; i++) {
+        new (&records[i]) T();
+    }
+    return records;
+}
+
+// Small library touching every section the snapshot encodes
+static zmdb::ZMDBLibrary BuildLibrary() {
+    zmdb::ZMDBLibrary lib;
+    lib.device_family = zune::DeviceFamily::Pavo;
+
+    lib.tracks = AllocateRecords<zmdb::ZMDBTrack>(2);
+    lib.track_count = lib.tracks_capacity = 2;
+    lib.tracks[0].title = "Welcome to the Social";
+    lib.tracks[0].artist_name = "Zune Artist";
+    lib.tracks[0].genre = "Electronic";
+    lib.tracks[0].track_number = 3;
+    lib.tracks[0].duration_ms = 215000;
+    lib.tracks[0].playcount = 12;
+    lib.tracks[0].rating = 8;
+    lib.tracks[0].last_played_timestamp = 0x01D9ABCDEF012345ULL;
+    lib.tracks[0].atom_id = 0x01000001;
+    lib.tracks[0].album_ref = 0x06000001;
+    lib.tracks[0].album_alb_ref = "Album.alb";
+    lib.tracks[1].title = "";  // Empty strings must round-trip too
+    lib.tracks[1].artist_name = "Zune Artist";
+    lib.tracks[1].atom_id = 0x01000002;
+
+    lib.videos = AllocateRecords<zmdb::ZMDBVideo>(1);
+    lib.video_count = lib.videos_capacity = 1;
+    lib.videos[0].title = "Series";
+    lib.videos[0].episode_title = "Pilot";
+    lib.videos[0].category = 4;
+    lib.videos[0].season_number = 1;
+    lib.videos[0].atom_id = 0x02000001;
+
+    lib.playlists = AllocateRecords<zmdb::ZMDBPlaylist>(1);
+    lib.playlist_count = lib.playlists_capacity = 1;
+    lib.playlists[0].name = "Favorites";
+    lib.playlists[0].track_count = 2;
+    lib.playlists[0].track_atom_ids = {0x01000002, 0x01000001};
+    lib.playlists[0].atom_id = 0x0b000001;
+
+    lib.podcasts = AllocateRecords<zmdb::ZMDBPodcast>(1);
+    lib.podcast_count = lib.podcasts_capacity = 1;
+    lib.podcasts[0].media_type = zmdb::PodcastMediaType::Video;
+    lib.podcasts[0].title = "Episode 1";
+    lib.podcasts[0].played_flag = 0x200;
+    lib.podcasts[0].atom_id = 0x02000002;
+
+    zmdb::ZMDBAlbum album;
+    album.title = "Album";
+    album.release_year = 2009;
+    album.atom_id = 0x06000001;
+    lib.album_metadata[album.atom_id] = album;
+    lib.album_count = 1;
+
+    zmdb::ZMDBArtist artist;
+    artist.name = "Zune Artist";
+    artist.atom_id = 0x08000001;
+    lib.artist_metadata[artist.atom_id] = artist;
+    lib.artist_count = 1;
+
+    zmdb::ZMDBPodcastShow show;
+    show.name = "Show";
+    show.is_subscribed = false;
+    show.atom_id = 0x0f000001;
+    lib.podcast_show_metadata[show.atom_id] = show;
+    lib.podcast_show_count = 1;
+
+    return lib;
+}
+
+// Records the sink calls it receives, one letter each
+struct CallLog : zmdb::ZMDBRecordSink {
+    std::string calls;
+    zmdb::ZMDBExtractionPlan plan;
+    int resets = 0;
+
+    void Begin(const zmdb::ZMDBExtractionPlan& p) override { plan = p; calls += 'B'; }
+    void OnTrack(zmdb::ZMDBTrack&&) override { calls += 'T'; }
+    void OnVideo(zmdb::ZMDBVideo&&) override { calls += 'V'; }
+    void OnPicture(zmdb::ZMDBPicture&&) override { calls += 'I'; }
+    void OnPlaylist(zmdb::ZMDBPlaylist&&) override { calls += 'L'; }
+    void OnPodcast(zmdb::ZMDBPodcast&&) override { calls += 'P'; }
+    void OnAudiobook(zmdb::ZMDBAudiobook&&) override { calls += 'K'; }
+    void OnPodcastShow(uint32_t, zmdb::ZMDBPodcastShow&&) override { calls += 'S'; }
+    void OnAlbum(uint32_t, zmdb::ZMDBAlbum&&) override { calls += 'a'; }
+    void OnArtist(uint32_t, zmdb::ZMDBArtist&&) override { calls += 'r'; }
+    void OnGenre(uint32_t, zmdb::ZMDBGenre&&) override { calls += 'g'; }
+    void Finish(zmdb::StringInternTable&&) override { calls += 'F'; }
+    void Reset() override { calls.clear(); resets++; }
+};
+
+static std::vector<char> ReadSnapshotFile() {
+    std::ifstream in(kSnapshotPath, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static bool WriteSnapshot() {
+    return zmdb::write_library_snapshot(
+        kSnapshotPath, zmdb::hash_zmdb(kZmdb), kZmdb.size(), BuildLibrary());
+}
+
+// Test: Library round-trips through a snapshot
+bool TestRoundTrip() {
+    std::cout << "Testing snapshot round trip..." << std::endl;
+
+    ASSERT_TRUE(WriteSnapshot(), "Snapshot should be written");
+    auto lib = zmdb::read_library_snapshot(
+        kSnapshotPath, zmdb::hash_zmdb(kZmdb), kZmdb.size(), zune::DeviceFamily::Pavo);
+    ASSERT_TRUE(lib.has_value(), "Matching snapshot should load");
+
+    ASSERT_EQ(lib->track_count, 2, "Track count");
+    ASSERT_EQ(lib->tracks[0].title, std::string("Welcome to the Social"), "Track title");
+    ASSERT_EQ(lib->tracks[0].duration_ms, 215000, "Track duration");
+    ASSERT_EQ(lib->tracks[0].playcount, static_cast<uint16_t>(12), "Track playcount");
+    ASSERT_EQ(lib->tracks[0].rating, static_cast<uint8_t>(8), "Track rating");
+    ASSERT_EQ(lib->tracks[0].last_played_timestamp, static_cast<uint64_t>(0x01D9ABCDEF012345ULL), "Track last played");
+    ASSERT_EQ(lib->tracks[0].album_alb_ref.str(), std::string("Album.alb"), "Track album ref");
+    ASSERT_EQ(lib->tracks[0].disc_number, 1, "Track disc number default preserved");
+    ASSERT_EQ(lib->tracks[1].title, std::string(""), "Empty title");
+    ASSERT_EQ(lib->tracks[1].atom_id, 0x01000002u, "Second track atom_id");
+    ASSERT_TRUE(lib->tracks[1].artist_name.identity() == lib->tracks[0].artist_name.identity(),
+                "Loaded artist names are interned");
+
+    ASSERT_EQ(lib->video_count, 1, "Video count");
+    ASSERT_EQ(lib->videos[0].episode_title, std::string("Pilot"), "Video episode title");
+    ASSERT_EQ(lib->videos[0].category, static_cast<uint16_t>(4), "Video category");
+
+    ASSERT_EQ(lib->picture_count, 0, "Picture count");
+    ASSERT_TRUE(lib->pictures == nullptr, "No picture array for empty section");
+
+    ASSERT_EQ(lib->playlist_count, 1, "Playlist count");
+    ASSERT_EQ(lib->playlists[0].track_atom_ids.size(), static_cast<size_t>(2), "Playlist entries");
+    ASSERT_EQ(lib->playlists[0].track_atom_ids[0], 0x01000002u, "Playlist order preserved");
+
+    ASSERT_EQ(lib->podcast_count, 1, "Podcast count");
+    ASSERT_TRUE(lib->podcasts[0].media_type == zmdb::PodcastMediaType::Video, "Podcast media type");
+    ASSERT_TRUE(lib->podcasts[0].is_played(), "Podcast played flag");
+
+    ASSERT_EQ(lib->album_count, 1, "Album count");
+    ASSERT_EQ(lib->album_metadata.at(0x06000001).release_year, 2009, "Album year");
+    ASSERT_EQ(lib->artist_metadata.at(0x08000001).name, std::string("Zune Artist"), "Artist name");
+    ASSERT_FALSE(lib->podcast_show_metadata.at(0x0f000001).is_subscribed, "Show subscription");
+    ASSERT_TRUE(lib->device_family == zune::DeviceFamily::Pavo, "Device family");
+
+    std::remove(kSnapshotPath.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: A changed ZMDB misses the snapshot
+bool TestHashMismatch() {
+    std::cout << "Testing snapshot miss on changed ZMDB..." << std::endl;
+
+    ASSERT_TRUE(WriteSnapshot(), "Snapshot should be written");
+    std::vector<uint8_t> changed = kZmdb;
+    changed[9] ^= 0x01;
+    ASSERT_TRUE(zmdb::hash_zmdb(changed) != zmdb::hash_zmdb(kZmdb), "One-bit change alters hash");
+
+    auto lib = zmdb::read_library_snapshot(
+        kSnapshotPath, zmdb::hash_zmdb(changed), changed.size(), zune::DeviceFamily::Pavo);
+    ASSERT_FALSE(lib.has_value(), "Changed ZMDB should miss");
+
+    lib = zmdb::read_library_snapshot(
+        kSnapshotPath, zmdb::hash_zmdb(kZmdb), kZmdb.size(), zune::DeviceFamily::Draco);
+    ASSERT_FALSE(lib.has_value(), "Different device family should miss");
+
+    std::remove(kSnapshotPath.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: Truncated or missing snapshot files are a miss, not a crash
+bool TestTruncatedSnapshot() {
+    std::cout << "Testing truncated snapshot..." << std::endl;
+
+    ASSERT_TRUE(WriteSnapshot(), "Snapshot should be written");
+    std::vector<char> contents;
+    {
+        std::ifstream in(kSnapshotPath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    ASSERT_TRUE(contents.size() > 64, "Snapshot has content");
+
+    for (size_t len : {size_t(0), size_t(4), size_t(24), contents.size() / 2, contents.size() - 1}) {
+        {
+            std::ofstream out(kSnapshotPath, std::ios::binary | std::ios::trunc);
+            out.write(contents.data(), static_cast<std::streamsize>(len));
+        }
+        auto lib = zmdb::read_library_snapshot(
+            kSnapshotPath, zmdb::hash_zmdb(kZmdb), kZmdb.size(), zune::DeviceFamily::Pavo);
+        ASSERT_FALSE(lib.has_value(), "Truncated snapshot (" + std::to_string(len) + " bytes) should miss");
+    }
+
+    std::remove(kSnapshotPath.c_str());
+    auto lib = zmdb::read_library_snapshot(
+        kSnapshotPath, zmdb::hash_zmdb(kZmdb), kZmdb.size(), zune::DeviceFamily::Pavo);
+    ASSERT_FALSE(lib.has_value(), "Missing snapshot should miss");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: A snapshot found by device fingerprint, without the ZMDB
+bool TestDeviceFingerprint() {
+    std::cout << "Testing device fingerprint..." << std::endl;
+    const uint64_t hash = zmdb::hash_zmdb(kZmdb);
+
+    ASSERT_TRUE(WriteSnapshot(), "Snapshot without a fingerprint");
+    ASSERT_FALSE(zmdb::read_library_snapshot_for_device(kSnapshotPath, 0, zune::DeviceFamily::Pavo).has_value(),
+                 "No fingerprint never matches");
+
+    ASSERT_TRUE(zmdb::write_library_snapshot(kSnapshotPath, hash, kZmdb.size(), BuildLibrary(), 0xF00D),
+                "Snapshot with a fingerprint");
+    auto lib = zmdb::read_library_snapshot_for_device(kSnapshotPath, 0xF00D, zune::DeviceFamily::Pavo);
+    ASSERT_TRUE(lib.has_value(), "Same fingerprint loads");
+    ASSERT_EQ(lib->tracks[0].title, std::string("Welcome to the Social"), "Track title");
+    ASSERT_FALSE(zmdb::read_library_snapshot_for_device(kSnapshotPath, 0xBEEF, zune::DeviceFamily::Pavo).has_value(),
+                 "Other fingerprint misses");
+    ASSERT_FALSE(zmdb::read_library_snapshot_for_device(kSnapshotPath, 0xF00D, zune::DeviceFamily::Draco).has_value(),
+                 "Other family misses");
+    ASSERT_TRUE(zmdb::read_library_snapshot(kSnapshotPath, hash, kZmdb.size(), zune::DeviceFamily::Pavo).has_value(),
+                "Still found by ZMDB hash");
+
+    // Re-keyed in place only while the ZMDB matches
+    ASSERT_FALSE(zmdb::update_snapshot_fingerprint(kSnapshotPath, hash ^ 1, kZmdb.size(), 0xBEEF),
+                 "Stale snapshot not re-keyed");
+    ASSERT_TRUE(zmdb::update_snapshot_fingerprint(kSnapshotPath, hash, kZmdb.size(), 0xBEEF), "Re-keyed");
+    ASSERT_TRUE(zmdb::read_library_snapshot_for_device(kSnapshotPath, 0xBEEF, zune::DeviceFamily::Pavo).has_value(),
+                "New fingerprint loads");
+    ASSERT_FALSE(zmdb::read_library_snapshot_for_device(kSnapshotPath, 0xF00D, zune::DeviceFamily::Pavo).has_value(),
+                 "Old fingerprint misses");
+
+    std::remove(kSnapshotPath.c_str());
+    ASSERT_FALSE(zmdb::update_snapshot_fingerprint(kSnapshotPath, hash, kZmdb.size(), 0xBEEF),
+                 "Missing snapshot not re-keyed");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+bool TestDeferredDetails() {
+    std::cout << "Testing deferred details flag..." << std::endl;
+    const uint64_t hash = zmdb::hash_zmdb(kZmdb);
+
+    ASSERT_TRUE(WriteSnapshot(), "Snapshot with details");
+    auto lib = zmdb::read_library_snapshot(kSnapshotPath, hash, kZmdb.size(), zune::DeviceFamily::Pavo);
+    ASSERT_TRUE(lib.has_value(), "Loads");
+    ASSERT_FALSE(lib->details_deferred, "Details present");
+
+    zmdb::ZMDBLibrary deferred = BuildLibrary();
+    deferred.details_deferred = true;
+    ASSERT_TRUE(zmdb::write_library_snapshot(kSnapshotPath, hash, kZmdb.size(), deferred), "Snapshot without details");
+    lib = zmdb::read_library_snapshot(kSnapshotPath, hash, kZmdb.size(), zune::DeviceFamily::Pavo);
+    ASSERT_TRUE(lib.has_value(), "Loads");
+    ASSERT_TRUE(lib->details_deferred, "Deferral recorded");
+    ASSERT_EQ(lib->podcast_count, 1, "Records follow the flag");
+
+    std::remove(kSnapshotPath.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: A snapshot written by the sink a parse passes through
+bool TestSnapshotSink() {
+    std::cout << "Testing snapshot sink..." << std::endl;
+    const uint64_t hash = zmdb::hash_zmdb(kZmdb);
+
+    ASSERT_TRUE(WriteSnapshot(), "Snapshot from a library");
+    std::vector<char> expected = ReadSnapshotFile();
+    std::remove(kSnapshotPath.c_str());
+
+    zmdb::ZMDBLibrary out;
+    out.device_family = zune::DeviceFamily::Pavo;
+    zmdb::ZMDBLibrarySink next(out);
+    zmdb::ZMDBSnapshotSink tee(next, zune::DeviceFamily::Pavo);
+    ASSERT_FALSE(tee.Write(kSnapshotPath, hash, kZmdb.size()), "Nothing written before Finish");
+
+    tee.OnLibrary(BuildLibrary());
+    ASSERT_EQ(out.track_count, 2, "Tracks passed through");
+    ASSERT_EQ(out.tracks[0].title, std::string("Welcome to the Social"), "Track title passed through");
+    ASSERT_EQ(out.album_count, 1, "Albums passed through");
+    ASSERT_EQ(out.podcast_show_count, 1, "Shows passed through");
+
+    ASSERT_TRUE(tee.Write(kSnapshotPath, hash, kZmdb.size()), "Snapshot from the sink");
+    ASSERT_TRUE(ReadSnapshotFile() == expected, "Same bytes as from the library");
+
+    // A redone extraction starts the snapshot over
+    tee.Reset();
+    ASSERT_EQ(out.track_count, 0, "Reset passed through");
+    ASSERT_FALSE(tee.Write(kSnapshotPath, hash, kZmdb.size()), "Nothing to write after Reset");
+
+    std::remove(kSnapshotPath.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: Snapshots decode straight into a sink, in parse order
+bool TestReadIntoSink() {
+    std::cout << "Testing snapshot read into a sink..." << std::endl;
+    const uint64_t hash = zmdb::hash_zmdb(kZmdb);
+
+    ASSERT_TRUE(zmdb::write_library_snapshot(kSnapshotPath, hash, kZmdb.size(), BuildLibrary(), 0xF00D),
+                "Snapshot with a fingerprint");
+    CallLog log;
+    ASSERT_TRUE(zmdb::read_library_snapshot(kSnapshotPath, hash, kZmdb.size(), zune::DeviceFamily::Pavo, log),
+                "Read by ZMDB hash");
+    ASSERT_EQ(log.calls, std::string("BTTVLPSarF"), "Sink call order");
+    ASSERT_EQ(log.plan.tracks, 2, "Plan track count");
+    ASSERT_EQ(log.plan.podcasts, 1, "Plan podcast count");
+
+    log = CallLog();
+    ASSERT_TRUE(zmdb::read_library_snapshot_for_device(kSnapshotPath, 0xF00D, zune::DeviceFamily::Pavo, log),
+                "Read by fingerprint");
+    ASSERT_EQ(log.calls, std::string("BTTVLPSarF"), "Same calls by fingerprint");
+
+    // A snapshot without details misses a read that wants them, before any call
+    zmdb::ZMDBLibrary deferred = BuildLibrary();
+    deferred.details_deferred = true;
+    ASSERT_TRUE(zmdb::write_library_snapshot(kSnapshotPath, hash, kZmdb.size(), deferred), "Snapshot without details");
+    log = CallLog();
+    ASSERT_FALSE(zmdb::read_library_snapshot(kSnapshotPath, hash, kZmdb.size(), zune::DeviceFamily::Pavo, log, false),
+                 "Deferred snapshot refused");
+    ASSERT_EQ(log.calls, std::string(""), "Sink untouched");
+
+    // Corruption past the header undoes what the sink received
+    ASSERT_TRUE(WriteSnapshot(), "Snapshot should be written");
+    std::vector<char> contents = ReadSnapshotFile();
+    {
+        std::ofstream out(kSnapshotPath, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), static_cast<std::streamsize>(contents.size() - 1));
+    }
+    log = CallLog();
+    ASSERT_FALSE(zmdb::read_library_snapshot(kSnapshotPath, hash, kZmdb.size(), zune::DeviceFamily::Pavo, log),
+                 "Truncated snapshot misses");
+    ASSERT_EQ(log.resets, 1, "Sink reset");
+    ASSERT_EQ(log.calls, std::string(""), "Nothing left in the sink");
+
+    std::remove(kSnapshotPath.c_str());
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " ZMDB Snapshot Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestRoundTrip, "Snapshot Round Trip");
+    run_test(TestHashMismatch, "Snapshot Miss on Changed ZMDB");
+    run_test(TestTruncatedSnapshot, "Truncated Snapshot");
+    run_test(TestDeviceFingerprint, "Device Fingerprint");
+    run_test(TestDeferredDetails, "Deferred Details");
+    run_test(TestSnapshotSink, "Snapshot Sink");
+    run_test(TestReadIntoSink, "Read Into Sink");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/**
+ * test_zmdb_stream.cpp
+ *
+ * Unit tests for the streaming ZMDB transfer buffer (ZMDBStreamBuffer)
+ * Tests incremental availability, clamping and short transfers
+ */
+
+#include "lib/src/zmdb/ZMDBStream.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+bool AssertEqual(const T& actual, const T& expected, const std::string& msg) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << msg << std::endl;
+        std::cerr << "  Expected: " << expected << std::endl;
+        std::cerr << "  Got:      " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#define ASSERT_EQ(actual, expected, msg) \
+    if (!AssertEqual(actual, expected, msg)) return false;
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to false" << std::endl; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition, msg) \
+    if (condition) { \
+        std::cerr << "FAIL: " << msg << std::endl; \
+        std::cerr << "  Condition evaluated to true (expected false)" << std::endl; \
+        return false; \
+    }
+
+static std::vector<uint8_t> Pattern(size_t size) {
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return bytes;
+}
+
+// Test: Bytes become available as they are appended
+bool TestIncrementalAppend() {
+    std::cout << "Testing incremental append..." << std::endl;
+
+    std::vector<uint8_t> bytes = Pattern(100);
+    zmdb::ZMDBStreamBuffer buffer(bytes.size());
+    ASSERT_EQ(buffer.TotalSize(), static_cast<size_t>(100), "Total size");
+    ASSERT_EQ(buffer.Received(), static_cast<size_t>(0), "Nothing received yet");
+    ASSERT_TRUE(buffer.IsAvailable(0), "Empty range is always available");
+    ASSERT_FALSE(buffer.IsAvailable(1), "First byte not yet available");
+
+    ASSERT_EQ(buffer.Append(bytes.data(), 40), static_cast<size_t>(40), "First chunk accepted");
+    ASSERT_TRUE(buffer.IsAvailable(40), "First chunk available");
+    ASSERT_FALSE(buffer.IsAvailable(41), "Second chunk not yet available");
+
+    // The tail of an oversized write is dropped
+    ASSERT_EQ(buffer.Append(bytes.data() + 40, 80), static_cast<size_t>(60), "Write clamped to total");
+    ASSERT_TRUE(buffer.IsAvailable(1000), "End offsets clamp to total size");
+    ASSERT_FALSE(buffer.Complete(), "Not complete before Finish");
+
+    buffer.Finish();
+    ASSERT_TRUE(buffer.Complete(), "Complete after Finish");
+    ASSERT_TRUE(buffer.View()[99] == bytes[99], "View sees appended bytes");
+
+    std::vector<uint8_t> released = buffer.Release();
+    ASSERT_TRUE(released == bytes, "Released bytes match");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: WaitFor blocks until a writer thread delivers the range
+bool TestWaitForWriter() {
+    std::cout << "Testing wait for writer thread..." << std::endl;
+
+    std::vector<uint8_t> bytes = Pattern(64 * 1024);
+    zmdb::ZMDBStreamBuffer buffer(bytes.size());
+
+    std::thread writer([&] {
+        for (size_t offset = 0; offset < bytes.size(); offset += 4096) {
+            buffer.Append(bytes.data() + offset, 4096);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        buffer.Finish();
+    });
+
+    bool tail_ok = buffer.WaitFor(bytes.size());
+    bool middle_ok = buffer.WaitFor(bytes.size() / 2);
+    writer.join();
+
+    ASSERT_TRUE(tail_ok, "Whole transfer arrives");
+    ASSERT_TRUE(middle_ok, "Earlier ranges stay available");
+    ASSERT_TRUE(buffer.Complete(), "Transfer complete");
+    ASSERT_TRUE(buffer.View()[bytes.size() - 1] == bytes.back(), "Last byte intact");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+// Test: A transfer that finishes short releases waiters with false
+bool TestShortTransfer() {
+    std::cout << "Testing short transfer..." << std::endl;
+
+    std::vector<uint8_t> bytes = Pattern(32);
+    zmdb::ZMDBStreamBuffer buffer(64);
+
+    std::thread writer([&] {
+        buffer.Append(bytes.data(), bytes.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        buffer.Finish();
+    });
+
+    bool short_ok = buffer.WaitFor(64);
+    writer.join();
+
+    ASSERT_FALSE(short_ok, "Missing bytes are reported");
+    ASSERT_TRUE(buffer.WaitFor(32), "Received prefix still available");
+    ASSERT_FALSE(buffer.Complete(), "Short transfer is not complete");
+
+    std::cout << "  PASS" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << " ZMDB Stream Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl << std::endl;
+
+    int passed = 0;
+    int total = 0;
+
+    auto run_test = [&](bool (*test_func)(), const std::string& name) {
+        total++;
+        if (test_func()) {
+            passed++;
+        } else {
+            std::cout << "  TEST FAILED: " << name << std::endl;
+        }
+        std::cout << std::endl;
+    };
+
+    run_test(TestIncrementalAppend, "Incremental Append");
+    run_test(TestWaitForWriter, "Wait for Writer Thread");
+    run_test(TestShortTransfer, "Short Transfer");
+
+    std::cout << "======================================" << std::endl;
+    std::cout << " Test Results: " << passed << "/" << total << " passed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,538 @@
+/**
+ * zmdb_synthetic.h
+ *
+ * Synthetic ZMDB blobs for benchmarks and device-free tests. Builds a
+ * complete file - ZMDB/ZMed headers, the ZArr descriptor table, the atom
+ * index (descriptor 0) and the per-schema atom lists - in either the Zune HD
+ * (Pavo) or Classic record layout, using the fixed headers and
+ * backwards-varint trailers ZuneHDParser and ZuneClassicParser read.
+ *
+ * Libraries are deterministic for a given shape: the same call always
+ * produces the same bytes.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace zmdb_synthetic {
+
+enum class Layout {
+    HD,       // Zune HD (Pavo), ZMed version 5
+    Classic,  // Zune 30/80/120/4/8/16, ZMed version 2
+};
+
+/// Entity counts for one synthetic library.
+struct LibraryShape {
+    uint32_t tracks = 0;
+    uint32_t albums = 0;
+    uint32_t artists = 0;
+    uint32_t genres = 0;
+    uint32_t videos = 0;
+    uint32_t podcast_shows = 0;
+    uint32_t podcast_episodes = 0;   // Schema 0x10 audio episodes
+    uint32_t video_podcasts = 0;     // Schema 0x02 records with a show ref
+    uint32_t playlists = 0;
+    uint32_t playlist_length = 0;
+
+    /// Proportions of a typical device library: ~10 tracks per album, ~2
+    /// albums per artist, a video per 50 tracks, a podcast episode per 40,
+    /// a playlist per 100.
+    static LibraryShape ForTracks(uint32_t track_count) {
+        LibraryShape s;
+        s.tracks = track_count;
+        s.albums = track_count / 10 + 1;
+        s.artists = s.albums / 2 + 1;
+        s.genres = 30;
+        s.videos = track_count / 50;
+        s.podcast_shows = track_count / 500 + 1;
+        s.podcast_episodes = track_count / 40;
+        s.video_podcasts = track_count / 200;
+        s.playlists = track_count / 100 + 1;
+        s.playlist_length = std::min<uint32_t>(track_count, 25);
+        return s;
+    }
+
+    /// Records the parsers return in ZMDBLibrary arrays.
+    uint32_t media_records() const {
+        return tracks + videos + podcast_episodes + video_podcasts + playlists;
+    }
+};
+
+// The legacy extractor skips this prefix of Classic files (stale data on
+// Zune 30 dumps); Classic records are written past it.
+constexpr size_t kClassicRecordRegion = 0x312B0;
+
+namespace detail {
+
+// Descriptor slots the parsers read (same on both families except audiobooks)
+constexpr int kIndexDescriptor = 0;
+constexpr int kMusicDescriptor = 1;
+constexpr int kPlaylistDescriptor = 11;
+constexpr int kVideoDescriptor = 12;
+constexpr int kPodcastDescriptor = 19;
+constexpr int kPodcastShowDescriptor = 20;
+
+constexpr uint32_t Atom(uint8_t schema, uint32_t index) {
+    return (static_cast<uint32_t>(schema) << 24) | (index & 0x00FFFFFF);
+}
+
+class Record {
+public:
+    explicit Record(size_t fixed_size = 0) : bytes_(fixed_size, 0) {}
+
+    void U8(size_t offset, uint8_t v) { bytes_[offset] = v; }
+    void U16(size_t offset, uint16_t v) { std::memcpy(&bytes_[offset], &v, 2); }
+    void U32(size_t offset, uint32_t v) { std::memcpy(&bytes_[offset], &v, 4); }
+    void U64(size_t offset, uint64_t v) { std::memcpy(&bytes_[offset], &v, 8); }
+
+    void AppendU8(uint8_t v) { bytes_.push_back(v); }
+    void AppendU16(uint16_t v) { Append(&v, 2); }
+    void AppendU32(uint32_t v) { Append(&v, 4); }
+
+    void AppendUtf8(const std::string& s) {
+        Append(s.data(), s.size());
+        bytes_.push_back(0);
+    }
+
+    void AppendUtf16(const std::string& s) {
+        auto units = Utf16(s);
+        Append(units.data(), units.size());
+        bytes_.push_back(0);
+        bytes_.push_back(0);
+    }
+
+    // Backwards-varint trailer field: data, size (LEB128 read backwards), id
+    void Field(uint8_t id, const void* data, size_t size) {
+        Append(data, size);
+        if (size >= 0x80) {
+            bytes_.push_back(static_cast<uint8_t>(size >> 7));
+            bytes_.push_back(static_cast<uint8_t>(0x80 | (size & 0x7F)));
+        } else {
+            bytes_.push_back(static_cast<uint8_t>(size));
+        }
+        bytes_.push_back(id);
+    }
+
+    void FieldU32(uint8_t id, uint32_t v) { Field(id, &v, 4); }
+    void FieldU64(uint8_t id, uint64_t v) { Field(id, &v, 8); }
+    void FieldUtf16(uint8_t id, const std::string& s) {
+        auto units = Utf16(s);
+        Field(id, units.data(), units.size());
+    }
+
+    const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+private:
+    void Append(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        bytes_.insert(bytes_.end(), p, p + size);
+    }
+
+    // UTF-8 -> UTF-16LE for the BMP, which is all the fixtures use
+    static std::vector<uint8_t> Utf16(const std::string& s) {
+        std::vector<uint8_t> out;
+        for (size_t i = 0; i < s.size();) {
+            uint8_t c = static_cast<uint8_t>(s[i]);
+            uint32_t cp = c;
+            if (c >= 0xE0 && i + 2 < s.size()) {
+                cp = ((c & 0x0F) << 12) | ((s[i + 1] & 0x3F) << 6) | (s[i + 2] & 0x3F);
+                i += 3;
+            } else if (c >= 0xC0 && i + 1 < s.size()) {
+                cp = ((c & 0x1F) << 6) | (s[i + 1] & 0x3F);
+                i += 2;
+            } else {
+                i += 1;
+            }
+            out.push_back(static_cast<uint8_t>(cp & 0xFF));
+            out.push_back(static_cast<uint8_t>(cp >> 8));
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> bytes_;
+};
+
+class Writer {
+public:
+    explicit Writer(Layout layout) : layout_(layout), data_(0x30 + 96 * 20, 0) {
+        std::memcpy(&data_[0x00], "ZMDB", 4);
+        std::memcpy(&data_[0x20], "ZMed", 4);
+        uint16_t version = layout == Layout::HD ? 5 : 2;
+        std::memcpy(&data_[0x24], &version, 2);
+        std::memcpy(&data_[0x30], "ZArr", 4);
+        if (layout == Layout::Classic) {
+            data_.resize(kClassicRecordRegion, 0);
+        }
+    }
+
+    void Add(uint32_t atom_id, const Record& record, int descriptor = -1) {
+        const auto& body = record.bytes();
+        uint32_t header = static_cast<uint32_t>(body.size()) & 0x00FFFFFF;
+        size_t offset = data_.size() + 4;
+        data_.resize(offset);
+        std::memcpy(&data_[offset - 4], &header, 4);
+        data_.insert(data_.end(), body.begin(), body.end());
+        // Keep records 4-byte aligned like device files
+        data_.resize((data_.size() + 3) & ~size_t(3), 0);
+
+        index_.emplace_back(atom_id, static_cast<uint32_t>(offset));
+        if (descriptor >= 0) {
+            lists_[descriptor].push_back(atom_id);
+        }
+    }
+
+    std::vector<uint8_t> Finish() {
+        std::sort(index_.begin(), index_.end());
+        size_t index_offset = data_.size();
+        for (const auto& [atom_id, offset] : index_) {
+            Put(atom_id);
+            Put(offset);
+        }
+        SetDescriptor(kIndexDescriptor, 8, index_.size(), index_offset);
+
+        for (int d = 1; d < 96; d++) {
+            if (lists_[d].empty()) {
+                continue;
+            }
+            size_t list_offset = data_.size();
+            for (uint32_t atom_id : lists_[d]) {
+                Put(atom_id);
+            }
+            SetDescriptor(d, 4, lists_[d].size(), list_offset);
+        }
+        return std::move(data_);
+    }
+
+    Layout layout() const { return layout_; }
+
+private:
+    void Put(uint32_t v) {
+        size_t o = data_.size();
+        data_.resize(o + 4);
+        std::memcpy(&data_[o], &v, 4);
+    }
+
+    void SetDescriptor(int d, uint16_t entry_size, size_t count, size_t offset) {
+        size_t base = 0x30 + d * 20;
+        uint32_t count32 = static_cast<uint32_t>(count);
+        uint32_t offset32 = static_cast<uint32_t>(offset);
+        std::memcpy(&data_[base + 6], &entry_size, 2);
+        std::memcpy(&data_[base + 8], &count32, 4);
+        std::memcpy(&data_[base + 16], &offset32, 4);
+    }
+
+    Layout layout_;
+    std::vector<uint8_t> data_;
+    std::vector<std::pair<uint32_t, uint32_t>> index_;
+    std::vector<uint32_t> lists_[96];
+};
+
+inline std::string ArtistName(uint32_t i) {
+    // Every 17th name carries non-ASCII text so UTF-16 slow paths run too
+    return i % 17 == 0 ? "Sigur R\xC3\xB3s " + std::to_string(i) : "Artist " + std::to_string(i);
+}
+
+inline std::string AlbumTitle(uint32_t i) { return "Album " + std::to_string(i); }
+
+inline uint64_t FileTime(uint32_t day) {
+    // 2008-01-01 plus `day` days, as Windows FILETIME
+    return (12850531200ULL + uint64_t(day) * 86400ULL) * 10000000ULL;
+}
+
+constexpr uint8_t kMusic = 0x01, kVideo = 0x02, kFilename = 0x05, kAlbum = 0x06,
+                  kPlaylist = 0x07, kArtist = 0x08, kGenre = 0x09, kVideoTitle = 0x0a,
+                  kPodcastShow = 0x0f, kPodcastEpisode = 0x10;
+
+// Per-entity records, shared by BuildZmdb and the simulated device
+// (tests/zune_simulated_device.h), which renders its object store with them
+
+inline Record FilenameRecord(const std::string& name) {
+    Record r(8);
+    r.AppendUtf8(name);
+    return r;
+}
+
+inline Record GenreRecord(const std::string& name) {
+    Record r(1);
+    r.U8(0, 0x01);
+    r.AppendUtf8(name);
+    return r;
+}
+
+/// guid_seed picks the artist GUID bytes
+inline Record ArtistRecord(bool hd, const std::string& name, uint32_t guid_seed) {
+    Record r(hd ? 4 : 1);
+    if (hd) {
+        r.U32(0, 0x0c000001);
+    } else {
+        r.U8(0, 0x01);  // Classic name starts at +1; u32 at +0 must be non-zero
+    }
+    r.AppendUtf8(name);
+    uint8_t guid[16];
+    for (int i = 0; i < 16; i++) {
+        guid[i] = static_cast<uint8_t>(guid_seed * 31 + i);
+    }
+    r.Field(0x14, guid, sizeof(guid));
+    r.FieldUtf16(0x44, name + ".art");
+    return r;
+}
+
+/// index picks the release date (HD) and album GUID (Classic)
+inline Record AlbumRecord(bool hd, uint32_t artist_atom, const std::string& title,
+                          const std::string& alb, uint32_t index) {
+    Record r(hd ? 20 : 12);
+    r.U32(0, artist_atom);
+    if (hd) {
+        r.U64(12, FileTime(index % 3650));
+    } else {
+        r.U32(8, 0x0c000001);
+    }
+    r.AppendUtf8(title);
+    if (!hd) {
+        uint8_t guid[16] = {};
+        std::memcpy(guid, &index, 4);
+        r.Field(0x14, guid, sizeof(guid));
+    }
+    r.FieldUtf16(0x44, alb);
+    r.FieldU32(0x1e, 1);
+    return r;
+}
+
+struct MusicFields {
+    uint32_t album_atom = 0;
+    uint32_t artist_atom = 0;
+    uint32_t genre_atom = 0;
+    uint32_t alb_atom = 0;       // Album's .alb filename atom
+    uint32_t duration_ms = 0;
+    uint32_t file_size = 0;      // HD only
+    uint16_t track_number = 0;
+    uint16_t play_count = 0;
+    uint16_t codec = 0xB901;
+    uint8_t rating = 0;
+    uint32_t disc_number = 1;    // HD only
+    uint64_t last_played = 0;    // HD only; 0 = none
+    std::string title;
+};
+
+inline Record MusicRecord(bool hd, const MusicFields& f) {
+    Record r(hd ? 32 : 28);
+    r.U32(0, f.album_atom);
+    r.U32(4, f.artist_atom);
+    r.U32(8, f.genre_atom);
+    r.U32(12, f.alb_atom);
+    r.U32(16, f.duration_ms);
+    if (hd) {
+        r.U32(20, f.file_size);
+        r.U16(24, f.track_number);
+        r.U16(26, f.play_count);
+        r.U16(28, f.codec);
+        r.U8(30, f.rating);
+    } else {
+        r.U8(20, static_cast<uint8_t>(f.track_number));
+        r.U8(22, static_cast<uint8_t>(f.play_count));
+        r.U16(24, f.codec);
+        r.U8(26, f.rating);
+    }
+    r.AppendUtf8(f.title);
+    if (hd) {
+        r.FieldU32(0x6c, f.disc_number);
+        r.FieldU32(0x62, f.play_count);
+        if (f.last_played) {
+            r.FieldU64(0x70, f.last_played);
+        }
+    } else {
+        // Classic trailer: 6-byte (u32 value, 0x04 marker, type) records
+        r.AppendU32(f.play_count);
+        r.AppendU8(0x04);
+        r.AppendU8(0x62);
+    }
+    return r;
+}
+
+inline Record PlaylistRecord(const std::string& name, uint32_t folder_atom,
+                             const std::vector<uint32_t>& track_atoms) {
+    Record r(12);
+    r.U32(0x00, static_cast<uint32_t>(track_atoms.size()));
+    r.U32(0x08, folder_atom);
+    r.AppendUtf8(name);
+    r.AppendUtf16(name + ".zpl");
+    r.AppendU16(0);  // pre-track field
+    for (uint32_t atom : track_atoms) {
+        r.AppendU32(atom);
+    }
+    r.AppendU32(0);
+    return r;
+}
+
+} // namespace detail
+
+/**
+ * Build a ZMDB blob with the entities in shape, laid out for layout.
+ * Tracks reference albums/artists/genres round-robin; every album gets a
+ * Schema 0x05 .alb filename, every artist a .art filename and GUID.
+ */
+inline std::vector<uint8_t> BuildZmdb(Layout layout, const LibraryShape& shape) {
+    using namespace detail;
+    const bool hd = layout == Layout::HD;
+    Writer w(layout);
+
+    // Filename atoms: 1 = Videos folder, 2 = Playlists folder,
+    // 3.. = per-show podcast folders, then one .alb per album
+    uint32_t next_filename = 1;
+    auto add_filename = [&](const std::string& name) {
+        uint32_t atom = Atom(kFilename, next_filename++);
+        w.Add(atom, FilenameRecord(name));
+        return atom;
+    };
+    uint32_t videos_folder = add_filename("Videos");
+    uint32_t playlists_folder = add_filename("Playlists");
+
+    for (uint32_t g = 1; g <= shape.genres; g++) {
+        w.Add(Atom(kGenre, g), GenreRecord("Genre " + std::to_string(g)));
+    }
+
+    for (uint32_t a = 1; a <= shape.artists; a++) {
+        w.Add(Atom(kArtist, a), ArtistRecord(hd, ArtistName(a), a));
+    }
+
+    std::vector<uint32_t> alb_refs(shape.albums + 1, 0);
+    for (uint32_t a = 1; a <= shape.albums; a++) {
+        uint32_t artist = shape.artists ? (a - 1) % shape.artists + 1 : 0;
+        std::string title = AlbumTitle(a);
+        std::string alb = ArtistName(artist) + "--" + title + ".alb";
+        alb_refs[a] = add_filename(alb);
+        w.Add(Atom(kAlbum, a), AlbumRecord(hd, Atom(kArtist, artist), title, alb, a));
+    }
+
+    for (uint32_t t = 1; t <= shape.tracks; t++) {
+        uint32_t album = shape.albums ? (t - 1) / 10 % shape.albums + 1 : 0;
+        uint32_t artist = shape.artists ? (album - 1) % shape.artists + 1 : 0;
+        uint32_t genre = shape.genres ? t % shape.genres + 1 : 0;
+
+        MusicFields f;
+        f.album_atom = Atom(kAlbum, album);
+        f.artist_atom = Atom(kArtist, artist);
+        f.genre_atom = Atom(kGenre, genre);
+        f.alb_atom = alb_refs.size() > album ? alb_refs[album] : 0;
+        f.duration_ms = 180000 + t % 120000;
+        f.file_size = 4000000 + t;
+        f.track_number = static_cast<uint16_t>((t - 1) % 10 + 1);
+        f.play_count = static_cast<uint16_t>(t % 7);
+        f.codec = (t % 3 == 0) ? 0x3009 : 0xB901;  // MP3 / WMA
+        f.rating = (t % 5 == 0) ? 8 : 0;
+        f.last_played = (t % 4 == 0) ? FileTime(t % 3650) : 0;
+        f.title = "Track " + std::to_string(t);
+        w.Add(Atom(kMusic, t), MusicRecord(hd, f), kMusicDescriptor);
+    }
+
+    for (uint32_t v = 1; v <= shape.videos; v++) {
+        Record title(4);
+        title.U32(0, videos_folder);
+        title.AppendUtf8("Video " + std::to_string(v));
+        uint32_t title_atom = Atom(kVideoTitle, v);
+        w.Add(title_atom, title);
+
+        Record r(hd ? 0x2c : 0x28);
+        r.U32(0x00, videos_folder);
+        r.U32(0x04, title_atom);
+        r.U32(0x0c, 1200000 + v);
+        r.U64(0x18, FileTime(v % 3650));
+        if (hd) {
+            r.U32(0x20, 50000000 + v);
+            r.U16(0x24, 0xB981);
+            r.U16(0x26, static_cast<uint16_t>(v % 3));
+            r.U16(0x2a, 1);
+        } else {
+            r.U16(0x20, 0xB981);
+            r.U16(0x22, static_cast<uint16_t>(v % 3));
+            r.U16(0x26, 1);
+        }
+        r.AppendUtf8("Episode " + std::to_string(v));
+        r.FieldUtf16(0x44, "video" + std::to_string(v) + ".wmv");
+        r.FieldUtf16(0x41, "Synthetic video " + std::to_string(v));
+        r.FieldU32(0x1e, 1);
+        r.FieldU32(0x62, v % 3);
+        w.Add(Atom(kVideo, v), r, kVideoDescriptor);
+    }
+
+    std::vector<uint32_t> shows;
+    std::vector<uint32_t> show_folders;
+    for (uint32_t s = 1; s <= shape.podcast_shows; s++) {
+        std::string name = "Show " + std::to_string(s);
+        uint32_t folder = add_filename(name);
+        Record r(8);
+        r.U32(0x00, folder);
+        r.U8(0x05, 1);
+        r.U8(0x06, 1);
+        r.AppendUtf8(name);
+        r.FieldU32(0x1e, 1);
+        r.FieldUtf16(0x44, name + ".ser");
+        r.FieldUtf16(0x45, "http://example.com/feed/" + std::to_string(s));
+        r.FieldUtf16(0x46, "Host " + std::to_string(s));
+        uint32_t atom = Atom(kPodcastShow, s);
+        w.Add(atom, r, kPodcastShowDescriptor);
+        shows.push_back(atom);
+        show_folders.push_back(folder);
+    }
+
+    for (uint32_t e = 1; e <= shape.podcast_episodes; e++) {
+        size_t show = (e - 1) % shows.size();
+        Record r(hd ? 0x24 : 0x20);
+        r.U32(0x00, show_folders[show]);
+        r.U32(0x04, shows[show]);
+        r.U32(0x08, 2400000 + e);
+        r.U64(0x10, FileTime(e % 3650));
+        if (hd) {
+            r.U32(0x18, 20000000 + e);
+            r.U16(0x1e, 0x3009);
+            r.U32(0x20, (e % 2) ? 0x200 : 0);
+        } else {
+            r.U16(0x1a, 0x3009);
+            r.U32(0x1c, (e % 2) ? 0x200 : 0);
+        }
+        r.AppendUtf8("Episode " + std::to_string(e));
+        r.FieldUtf16(0x41, "Synthetic episode " + std::to_string(e));
+        r.FieldUtf16(0x45, "http://example.com/ep/" + std::to_string(e) + ".mp3");
+        r.FieldUtf16(0x46, "Host");
+        w.Add(Atom(kPodcastEpisode, e), r, kPodcastDescriptor);
+    }
+
+    for (uint32_t p = 1; p <= shape.video_podcasts; p++) {
+        size_t show = (p - 1) % shows.size();
+        Record r(hd ? 0x2c : 0x28);
+        r.U32(0x00, show_folders[show]);
+        r.U32(0x08, shows[show]);
+        r.U32(0x0c, 600000 + p);
+        r.U64(0x18, FileTime(p % 3650));
+        if (hd) {
+            r.U32(0x20, 80000000 + p);
+            r.U16(0x24, 0xB981);
+        } else {
+            r.U16(0x20, 0xB981);
+        }
+        r.AppendUtf8("Video episode " + std::to_string(p));
+        r.FieldUtf16(0x44, "vpod" + std::to_string(p) + ".wmv");
+        r.FieldUtf16(0x46, "Host");
+        w.Add(Atom(kVideo, shape.videos + p), r, kVideoDescriptor);
+    }
+
+    for (uint32_t p = 1; p <= shape.playlists; p++) {
+        std::vector<uint32_t> entries;
+        for (uint32_t i = 0; i < shape.playlist_length && shape.tracks > 0; i++) {
+            uint32_t track = (p * 37 + i * 11) % shape.tracks + 1;
+            entries.push_back(Atom(kMusic, track));
+        }
+        w.Add(Atom(kPlaylist, p), PlaylistRecord("Playlist " + std::to_string(p), playlists_folder, entries),
+              kPlaylistDescriptor);
+    }
+
+    return w.Finish();
+}
+
+} // namespace zmdb_synthetic
@@ -0,0 +1,559 @@
+/**
+ * zune_simulated_device.h
+ *
+ * An in-process stand-in for a Zune, for benchmarks and device-free tests
+ * of the sync paths. It keeps an MTP object store (folders, tracks, album
+ * and playlist objects with their references), answers the operations
+ * MtpWriter and MtpReader issue with the arguments they take, and renders
+ * the store as the ZMDB the firmware would return, in the HD or Classic
+ * layout, using the record builders in tests/zmdb_synthetic.h.
+ *
+ * mtp::Session is a concrete AFTL class, so the simulator does not replace
+ * one: callers drive it with the same sequence of operations they send a
+ * session (see tests/bench_sync.cpp).
+ *
+ * Every operation charges its Timing cost to a simulated clock: one
+ * transaction, plus firmware time for creates and deletes, plus data-phase
+ * bytes over the link bandwidth. With realtime set the cost is also slept,
+ * so host threads overlap it as they would a device; otherwise benchmarks
+ * run at host speed and report host and device time separately.
+ *
+ * Model differences follow the property lists MtpWriter builds: HD takes
+ * DiscNumber (0xDAB8) and ArtistId (0xDAB9) and records file size; Classic
+ * rejects those properties with ObjectProp_Not_Supported and keeps no size.
+ * As on the device, a track only appears in the ZMDB once its SendObject
+ * has completed, albums are linked by name at create time or by
+ * SetObjectReferences, and a SendObjectPropList with an unsent object
+ * pending discards that object.
+ */
+
+#pragma once
+
+#include "tests/zmdb_synthetic.h"
+#include "lib/src/ZuneMtpWriterTypes.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace zune_sim {
+
+using zmdb_synthetic::Layout;
+
+// MTP response codes the simulator returns
+constexpr uint16_t kOk = 0x2001;
+constexpr uint16_t kGeneralError = 0x2002;
+constexpr uint16_t kInvalidObjectHandle = 0x2009;
+constexpr uint16_t kStoreFull = 0x200C;
+constexpr uint16_t kNoValidObjectInfo = 0x2015;
+constexpr uint16_t kInvalidParentObject = 0x201A;
+constexpr uint16_t kObjectPropNotSupported = 0xA80A;
+
+// Object formats
+constexpr uint16_t kFormatAssociation = 0x3001;
+constexpr uint16_t kFormatMp3 = 0x3009;
+constexpr uint16_t kFormatWma = 0xB901;
+constexpr uint16_t kFormatAbstractAlbum = 0xBA03;
+constexpr uint16_t kFormatPlaylist = 0xBA05;
+
+/// Cost of each operation on the simulated device.
+struct Timing {
+    uint32_t transaction_us = 0;    // Command and response phases of any operation
+    uint32_t create_object_us = 0;  // Firmware database insert
+    uint32_t delete_object_us = 0;
+    double write_bytes_per_us = 0;  // SendObject data phase; 0 = free
+    double read_bytes_per_us = 0;   // GetObject data phase; 0 = free
+
+    /// Ballpark figures for USB 2.0 high speed: flash HD writes faster and
+    /// commits objects sooner than the hard-drive Classics. Substitute
+    /// numbers from zune_device_get_transfer_stats for a particular device.
+    static Timing For(Layout layout) {
+        Timing t;
+        if (layout == Layout::HD) {
+            t.transaction_us = 1500;
+            t.create_object_us = 8000;
+            t.delete_object_us = 4000;
+            t.write_bytes_per_us = 18.0;
+            t.read_bytes_per_us = 22.0;
+        } else {
+            t.transaction_us = 2000;
+            t.create_object_us = 15000;
+            t.delete_object_us = 6000;
+            t.write_bytes_per_us = 12.0;
+            t.read_bytes_per_us = 15.0;
+        }
+        return t;
+    }
+};
+
+struct Stats {
+    uint64_t transactions = 0;
+    uint64_t objects_created = 0;
+    uint64_t objects_deleted = 0;
+    uint64_t bytes_written = 0;
+    uint64_t bytes_read = 0;
+    uint64_t device_us = 0;         // Simulated time spent on the device
+};
+
+class SimulatedDevice {
+public:
+    struct Object {
+        uint32_t handle = 0;
+        uint32_t parent = 0;
+        uint16_t format = 0;
+        std::string name;           // ObjectFileName, or folder / playlist name
+        std::string title;
+        std::string artist;
+        std::string album_name;
+        std::string album_artist;
+        std::string genre;
+        std::string date_authored;
+        uint32_t duration_ms = 0;
+        uint16_t track_number = 0;
+        uint32_t disc_number = 0;
+        uint32_t artist_meta_id = 0;
+        uint64_t size = 0;
+        bool complete = false;      // Data phase received
+        uint32_t album = 0;         // Tracks: album object the firmware linked
+        std::vector<uint32_t> refs; // Albums and playlists: tracks
+        uint64_t artwork_bytes = 0;
+    };
+
+    explicit SimulatedDevice(Layout layout, Timing timing = Timing(), uint64_t capacity = 16ULL << 30)
+        : layout_(layout), timing_(timing), capacity_(capacity) {
+        roots_.storage_id = 0x00010001;
+        roots_.music_folder = AddFolder(0, "Music");
+        roots_.albums_folder = AddFolder(0, "Albums");
+        roots_.artists_folder = AddFolder(0, "Artists");
+        roots_.playlists_folder = AddFolder(0, "Playlists");
+        roots_.podcasts_folder = AddFolder(0, "Podcasts");
+        roots_.series_folder = AddFolder(0, "Series");
+        roots_.root_object_count = 6;
+    }
+
+    Layout layout() const { return layout_; }
+    bool is_hd() const { return layout_ == Layout::HD; }
+    const Stats& stats() const { return stats_; }
+    void ResetStats() { stats_ = Stats(); }
+    /// Sleep for each operation's cost as well as counting it
+    void SetRealtime(bool realtime) { realtime_ = realtime; }
+    void SetTiming(const Timing& timing) { timing_ = timing; }
+    const std::map<uint32_t, Object>& objects() const { return objects_; }
+    uint64_t used_bytes() const { return used_; }
+
+    // ── Reads ──
+
+    /// Root folder enumeration: GetObjectHandles, then a property read per child
+    zune::RootDiscoveryResult RootFolders() {
+        Charge(1 + static_cast<uint64_t>(roots_.root_object_count), 0, 0, 0);
+        return roots_;
+    }
+
+    /// GetObjectPropList on one object (VerifyTrack / VerifyAlbum)
+    uint16_t GetObjectPropList(uint32_t handle) {
+        Charge(1, 0, 0, 256);
+        return objects_.count(handle) ? kOk : kInvalidObjectHandle;
+    }
+
+    /// GetObject on the ZMDB: the library as the firmware indexes it
+    std::vector<uint8_t> ReadZmdb() {
+        std::vector<uint8_t> zmdb = RenderZmdb();
+        Charge(1, 0, 0, zmdb.size());
+        return zmdb;
+    }
+
+    /// Album .alb filename -> ObjectId, as ReadMusicLibrary queries for artwork
+    std::unordered_map<std::string, uint32_t> AlbumObjectIds() {
+        std::unordered_map<std::string, uint32_t> ids;
+        for (const auto& [handle, o] : objects_) {
+            if (o.format == kFormatAbstractAlbum) {
+                ids.emplace(o.name, handle);
+            }
+        }
+        Charge(1, 0, 0, ids.size() * 64);
+        return ids;
+    }
+
+    // ── Writes ──
+
+    uint16_t CreateFolder(uint32_t parent, const std::string& name, uint32_t& handle) {
+        handle = 0;
+        if (!IsFolder(parent)) return Fail(1, kInvalidParentObject);
+        DiscardPending();
+        Charge(1, 1, 0, 0);
+        handle = AddFolder(parent, name);
+        return kOk;
+    }
+
+    /// SendObjectPropList for a track (MtpWriter::CreateTrack)
+    uint16_t CreateTrack(uint32_t parent, const zune::TrackProperties& props,
+                         uint16_t format, uint64_t size, uint32_t& handle) {
+        handle = 0;
+        if (!IsFolder(parent)) return Fail(1, kInvalidParentObject);
+        if (props.is_hd && !is_hd()) return Fail(1, kObjectPropNotSupported);
+        if (used_ + size > capacity_) return Fail(1, kStoreFull);
+        DiscardPending();
+        Charge(1, 1, 0, 0);
+
+        Object o;
+        o.parent = parent;
+        o.format = format;
+        o.name = props.filename;
+        o.size = size;
+        ApplyTrackProperties(o, props);
+        handle = Add(zmdb_synthetic::detail::kMusic, std::move(o));
+        Object& track = objects_[handle];
+        track.album = FindAlbum(AlbumArtistOf(track), track.album_name);
+        pending_ = handle;
+        used_ += size;
+        return kOk;
+    }
+
+    /// SendObject for the object the last SendObjectPropList created
+    uint16_t SendObject(uint64_t bytes) {
+        auto it = objects_.find(pending_);
+        pending_ = 0;
+        if (it == objects_.end()) return Fail(1, kNoValidObjectInfo);
+        Charge(1, 0, bytes, 0);
+        if (bytes != it->second.size) {
+            Erase(it->first);  // Firmware drops a short or long transfer
+            return kGeneralError;
+        }
+        it->second.complete = true;
+        return kOk;
+    }
+
+    /// SetObjectPropList for a track (MtpWriter::UpdateTrackProperties)
+    uint16_t UpdateTrack(uint32_t handle, const zune::TrackProperties& props) {
+        auto it = objects_.find(handle);
+        if (it == objects_.end()) return Fail(1, kInvalidObjectHandle);
+        if (props.is_hd && !is_hd()) return Fail(1, kObjectPropNotSupported);
+        Charge(1, 0, 0, 0);
+        zune::TrackProperties merged = props;
+        merged.filename = it->second.name;       // Immutable after create
+        merged.album_name = it->second.album_name;
+        merged.album_artist = it->second.album_artist;
+        ApplyTrackProperties(it->second, merged);
+        return kOk;
+    }
+
+    /// SendObjectPropList + empty SendObject for an album (MtpWriter::CreateAlbumMetadata)
+    uint16_t CreateAlbum(uint32_t parent, const zune::AlbumProperties& props, uint32_t& handle) {
+        handle = 0;
+        if (!IsFolder(parent)) return Fail(1, kInvalidParentObject);
+        if (props.is_hd && !is_hd()) return Fail(1, kObjectPropNotSupported);
+        DiscardPending();
+        Charge(2, 1, 0, 0);
+
+        Object o;
+        o.parent = parent;
+        o.format = kFormatAbstractAlbum;
+        o.name = props.artist + "--" + props.album_name + ".alb";
+        o.title = props.album_name;
+        o.artist = props.artist;
+        o.date_authored = props.date_authored;
+        o.artist_meta_id = is_hd() ? props.artist_meta_id : 0;
+        o.complete = true;
+        handle = Add(zmdb_synthetic::detail::kAlbum, std::move(o));
+
+        // Tracks uploaded before their album object link to it now
+        std::string key = Key(props.artist, props.album_name);
+        albums_by_key_.emplace(key, handle);
+        for (auto& [h, t] : objects_) {
+            if (IsTrack(t) && t.album == 0 && Key(AlbumArtistOf(t), t.album_name) == key) {
+                t.album = handle;
+            }
+        }
+        return kOk;
+    }
+
+    /// SetObjectPropData for album artwork
+    uint16_t SetArtwork(uint32_t album, uint64_t bytes) {
+        auto it = objects_.find(album);
+        if (it == objects_.end()) return Fail(1, kInvalidObjectHandle);
+        Charge(1, 0, bytes, 0);
+        it->second.artwork_bytes = bytes;
+        return kOk;
+    }
+
+    /// SetObjectReferences on an album or playlist
+    uint16_t SetObjectReferences(uint32_t handle, const std::vector<uint32_t>& refs) {
+        auto it = objects_.find(handle);
+        if (it == objects_.end()) return Fail(1, kInvalidObjectHandle);
+        Charge(1, 0, refs.size() * 4, 0);
+        for (uint32_t ref : refs) {
+            auto t = objects_.find(ref);
+            if (t == objects_.end() || !IsTrack(t->second)) return kInvalidObjectHandle;
+        }
+        it->second.refs = refs;
+        if (it->second.format == kFormatAbstractAlbum) {
+            for (uint32_t ref : refs) {
+                objects_[ref].album = handle;
+            }
+        }
+        return kOk;
+    }
+
+    /// SendObjectPropList + empty SendObject for a playlist
+    uint16_t CreatePlaylist(uint32_t parent, const std::string& name, uint32_t& handle) {
+        handle = 0;
+        if (!IsFolder(parent)) return Fail(1, kInvalidParentObject);
+        DiscardPending();
+        Charge(2, 1, 0, 0);
+        Object o;
+        o.parent = parent;
+        o.format = kFormatPlaylist;
+        o.name = name;
+        o.complete = true;
+        handle = Add(zmdb_synthetic::detail::kPlaylist, std::move(o));
+        return kOk;
+    }
+
+    uint16_t DeleteObject(uint32_t handle) {
+        if (!objects_.count(handle)) return Fail(1, kInvalidObjectHandle);
+        Charge(1, 0, 0, 0);
+        stats_.device_us += timing_.delete_object_us;
+        Sleep(timing_.delete_object_us);
+        stats_.objects_deleted++;
+        Erase(handle);
+        return kOk;
+    }
+
+    // ── Seeding ──
+
+    /// Add a completed track directly, at no cost (a device synced earlier)
+    uint32_t SeedTrack(uint32_t parent, const zune::TrackProperties& props, uint16_t format, uint64_t size) {
+        Object o;
+        o.parent = parent;
+        o.format = format;
+        o.name = props.filename;
+        o.size = size;
+        o.complete = true;
+        ApplyTrackProperties(o, props);
+        uint32_t handle = Add(zmdb_synthetic::detail::kMusic, std::move(o));
+        Object& track = objects_[handle];
+        track.album = FindAlbum(AlbumArtistOf(track), track.album_name);
+        used_ += size;
+        return handle;
+    }
+
+    // ── ZMDB ──
+
+    /// The store as the firmware's ZMDB, in this device's layout. Artists,
+    /// genres and albums a track names without an album object become
+    /// records of their own, as the firmware's placeholders do.
+    std::vector<uint8_t> RenderZmdb() const {
+        using namespace zmdb_synthetic::detail;
+        const bool hd = is_hd();
+        Writer w(layout_);
+
+        uint32_t next_filename = 1;
+        auto add_filename = [&](const std::string& name) {
+            uint32_t atom = Atom(kFilename, next_filename++);
+            w.Add(atom, FilenameRecord(name));
+            return atom;
+        };
+        uint32_t playlists_folder = add_filename("Playlists");
+
+        std::unordered_map<std::string, uint32_t> genres;
+        auto genre_atom = [&](const std::string& name) -> uint32_t {
+            if (name.empty()) return 0;
+            auto [it, inserted] = genres.try_emplace(name, Atom(kGenre, static_cast<uint32_t>(genres.size() + 1)));
+            if (inserted) w.Add(it->second, GenreRecord(name));
+            return it->second;
+        };
+        std::unordered_map<std::string, uint32_t> artists;
+        auto artist_atom = [&](const std::string& name) -> uint32_t {
+            if (name.empty()) return 0;
+            uint32_t index = static_cast<uint32_t>(artists.size() + 1);
+            auto [it, inserted] = artists.try_emplace(name, Atom(kArtist, index));
+            if (inserted) w.Add(it->second, ArtistRecord(hd, name, index));
+            return it->second;
+        };
+
+        // Album objects keep their handle as atom id; placeholders count
+        // down from the top of the index range so they never collide
+        std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> album_atoms;  // handle -> (atom, .alb atom)
+        std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> placeholders;
+        uint32_t next_placeholder = 0x00FFFFFF;
+        uint32_t album_index = 0;
+        auto add_album = [&](uint32_t atom, const std::string& artist, const std::string& title) {
+            std::string alb = artist + "--" + title + ".alb";
+            uint32_t alb_atom = add_filename(alb);
+            w.Add(atom, AlbumRecord(hd, artist_atom(artist), title, alb, ++album_index));
+            return std::make_pair(atom, alb_atom);
+        };
+        for (const auto& [handle, o] : objects_) {
+            if (o.format == kFormatAbstractAlbum) {
+                album_atoms.emplace(handle, add_album(handle, o.artist, o.title));
+            }
+        }
+
+        for (const auto& [handle, o] : objects_) {
+            if (!IsTrack(o) || !o.complete) continue;
+            std::pair<uint32_t, uint32_t> album{0, 0};
+            if (o.album) {
+                album = album_atoms[o.album];
+            } else if (!o.album_name.empty()) {
+                std::string artist = AlbumArtistOf(o);
+                auto it = placeholders.find(Key(artist, o.album_name));
+                if (it == placeholders.end()) {
+                    it = placeholders.emplace(Key(artist, o.album_name),
+                                              add_album(Atom(kAlbum, next_placeholder--), artist, o.album_name)).first;
+                }
+                album = it->second;
+            }
+
+            MusicFields f;
+            f.album_atom = album.first;
+            f.alb_atom = album.second;
+            f.artist_atom = artist_atom(o.artist);
+            f.genre_atom = genre_atom(o.genre);
+            f.duration_ms = o.duration_ms;
+            f.file_size = hd ? static_cast<uint32_t>(o.size) : 0;
+            f.track_number = o.track_number;
+            f.codec = o.format;
+            f.disc_number = o.disc_number ? o.disc_number : 1;
+            f.title = o.title;
+            w.Add(handle, MusicRecord(hd, f), kMusicDescriptor);
+        }
+
+        for (const auto& [handle, o] : objects_) {
+            if (o.format != kFormatPlaylist) continue;
+            std::vector<uint32_t> entries;
+            for (uint32_t ref : o.refs) {
+                auto t = objects_.find(ref);
+                if (t != objects_.end() && t->second.complete) entries.push_back(ref);
+            }
+            w.Add(handle, PlaylistRecord(o.name, playlists_folder, entries), kPlaylistDescriptor);
+        }
+        return w.Finish();
+    }
+
+private:
+    static bool IsTrack(const Object& o) {
+        return o.format == kFormatMp3 || o.format == kFormatWma;
+    }
+
+    static const std::string& AlbumArtistOf(const Object& o) {
+        return o.album_artist.empty() ? o.artist : o.album_artist;
+    }
+
+    static std::string Key(const std::string& artist, const std::string& album) {
+        std::string key;
+        key.reserve(artist.size() + album.size() + 1);
+        for (char c : artist) key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        key += '\x1f';
+        for (char c : album) key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return key;
+    }
+
+    void ApplyTrackProperties(Object& o, const zune::TrackProperties& props) const {
+        o.title = props.title;
+        o.artist = props.artist;
+        o.album_name = props.album_name;
+        o.album_artist = props.album_artist;
+        o.genre = props.genre;
+        o.date_authored = props.date_authored;
+        o.duration_ms = props.duration_ms;
+        o.track_number = props.track_number;
+        // Classic firmware has neither property; HD defaults the disc to 1
+        o.disc_number = is_hd() ? (props.disc_number ? props.disc_number : 1) : 0;
+        o.artist_meta_id = is_hd() ? props.artist_meta_id : 0;
+    }
+
+    uint32_t FindAlbum(const std::string& artist, const std::string& album) const {
+        if (album.empty()) return 0;
+        auto it = albums_by_key_.find(Key(artist, album));
+        return it != albums_by_key_.end() ? it->second : 0;
+    }
+
+    bool IsFolder(uint32_t handle) const {
+        auto it = objects_.find(handle);
+        return it != objects_.end() && it->second.format == kFormatAssociation;
+    }
+
+    uint32_t AddFolder(uint32_t parent, const std::string& name) {
+        Object o;
+        o.parent = parent;
+        o.format = kFormatAssociation;
+        o.name = name;
+        o.complete = true;
+        return Add(zmdb_synthetic::detail::kFilename, std::move(o));
+    }
+
+    uint32_t Add(uint8_t schema, Object o) {
+        uint32_t handle = zmdb_synthetic::detail::Atom(schema, ++next_index_[schema]);
+        o.handle = handle;
+        objects_.emplace(handle, std::move(o));
+        return handle;
+    }
+
+    void Erase(uint32_t handle) {
+        auto it = objects_.find(handle);
+        if (it == objects_.end()) return;
+        if (IsTrack(it->second)) {
+            used_ -= std::min(used_, it->second.size);
+        } else if (it->second.format == kFormatAbstractAlbum) {
+            albums_by_key_.erase(Key(it->second.artist, it->second.title));
+        }
+        objects_.erase(it);
+        for (auto& [h, o] : objects_) {
+            o.refs.erase(std::remove(o.refs.begin(), o.refs.end(), handle), o.refs.end());
+            if (o.album == handle) o.album = 0;
+            if (o.parent == handle) o.parent = 0;
+        }
+    }
+
+    // An unsent object does not survive the next SendObjectPropList
+    void DiscardPending() {
+        if (pending_) {
+            Erase(pending_);
+            pending_ = 0;
+        }
+    }
+
+    uint16_t Fail(uint64_t transactions, uint16_t response) {
+        Charge(transactions, 0, 0, 0);
+        return response;
+    }
+
+    void Charge(uint64_t transactions, uint64_t creates, uint64_t written, uint64_t read) {
+        double us = double(transactions) * timing_.transaction_us + double(creates) * timing_.create_object_us;
+        if (written && timing_.write_bytes_per_us > 0) us += written / timing_.write_bytes_per_us;
+        if (read && timing_.read_bytes_per_us > 0) us += read / timing_.read_bytes_per_us;
+        stats_.transactions += transactions;
+        stats_.objects_created += creates;
+        stats_.bytes_written += written;
+        stats_.bytes_read += read;
+        stats_.device_us += static_cast<uint64_t>(us);
+        Sleep(static_cast<uint64_t>(us));
+    }
+
+    void Sleep(uint64_t us) const {
+        if (realtime_ && us) {
+            std::this_thread::sleep_for(std::chrono::microseconds(us));
+        }
+    }
+
+    Layout layout_;
+    Timing timing_;
+    uint64_t capacity_;
+    uint64_t used_ = 0;
+    bool realtime_ = false;
+    std::map<uint32_t, Object> objects_;
+    std::unordered_map<std::string, uint32_t> albums_by_key_;  // Album artist + title, folded
+    uint32_t next_index_[256] = {};
+    uint32_t pending_ = 0;
+    zune::RootDiscoveryResult roots_;
+    Stats stats_;
+};
+
+} // namespace zune_sim
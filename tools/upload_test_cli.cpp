@@ -23,7 +23,6 @@
 #include <string>
 #include <vector>
 #include <map>
-#include <set>
 #include <filesystem>
 #include <cstring>
 #include <iomanip>
@@ -32,22 +31,9 @@
 #include <sstream>
 #include <algorithm>
 
-#include <taglib/fileref.h>
-#include <taglib/tag.h>
-#include <taglib/tpropertymap.h>
-#include <taglib/mpegfile.h>
-#include <taglib/id3v2tag.h>
-#include <taglib/attachedpictureframe.h>
-#include <taglib/asffile.h>
-#include <taglib/asftag.h>
-#include <taglib/mp4file.h>
-#include <taglib/mp4tag.h>
-#include <taglib/mp4coverart.h>
-#include <taglib/flacfile.h>
-#include <taglib/flacpicture.h>
-
 #include "lib/src/ZuneDevice.h"
 #include "lib/src/ZuneDeviceIdentification.h"
+#include "lib/src/ZuneMediaScanner.h"
 #include <mtp/ptp/OutputStream.h>
 #include <mtp/ptp/ByteArrayObjectStream.h>
 #include <cli/PosixStreams.h>
@@ -109,11 +95,6 @@ static const uint16_t HD_FORMATS[] = {
     0xBA05, 0xB211, 0x3000, 0xB802, 0xBA0B, 0xB218, 0xB217,
 };
 
-// Supported audio extensions
-static const std::set<std::string> AUDIO_EXTENSIONS = {
-    ".mp3", ".wma", ".m4a", ".flac", ".aac", ".ogg",
-};
-
 // ── Data Structures ──────────────────────────────────────────────────────
 
 struct TrackInfo {
@@ -246,114 +227,31 @@ std::vector<uint8_t> parse_guid(const std::string& guid_str) {
     return bytes;
 }
 
-// ── Artwork Extraction ───────────────────────────────────────────────────
-
-std::vector<uint8_t> extract_artwork(const std::string& file_path) {
-    std::vector<uint8_t> artwork;
-    TagLib::FileRef fileRef(file_path.c_str());
-    if (fileRef.isNull()) return artwork;
-
-    if (auto* f = dynamic_cast<TagLib::MPEG::File*>(fileRef.file())) {
-        if (f->ID3v2Tag()) {
-            auto frames = f->ID3v2Tag()->frameList("APIC");
-            if (!frames.isEmpty()) {
-                if (auto* pic = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front())) {
-                    auto data = pic->picture();
-                    artwork.assign(data.begin(), data.end());
-                    return artwork;
-                }
-            }
-        }
-    }
-    if (auto* f = dynamic_cast<TagLib::ASF::File*>(fileRef.file())) {
-        if (f->tag()) {
-            auto& m = f->tag()->attributeListMap();
-            if (m.contains("WM/Picture") && !m["WM/Picture"].isEmpty()) {
-                auto data = m["WM/Picture"][0].toPicture().picture();
-                artwork.assign(data.begin(), data.end());
-                return artwork;
-            }
-        }
-    }
-    if (auto* f = dynamic_cast<TagLib::MP4::File*>(fileRef.file())) {
-        if (f->tag() && f->tag()->contains("covr")) {
-            auto covers = f->tag()->item("covr").toCoverArtList();
-            if (!covers.isEmpty()) {
-                auto data = covers[0].data();
-                artwork.assign(data.begin(), data.end());
-                return artwork;
-            }
-        }
-    }
-    if (auto* f = dynamic_cast<TagLib::FLAC::File*>(fileRef.file())) {
-        auto pictures = f->pictureList();
-        if (!pictures.isEmpty()) {
-            auto data = pictures[0]->data();
-            artwork.assign(data.begin(), data.end());
-            return artwork;
-        }
-    }
-    return artwork;
-}
-
 // ── Metadata Extraction ──────────────────────────────────────────────────
 
-TrackInfo extract_track_info(const std::string& path, bool extract_art) {
+TrackInfo to_track_info(const zune::ScannedTrack& scanned, bool extract_art) {
     TrackInfo t;
-    t.file_path = path;
-    t.filename = fs::path(path).filename().string();
-    t.file_size = fs::file_size(path);
-    t.format_code = static_cast<uint16_t>(mtp::ObjectFormatFromFilename(path));
-
-    TagLib::FileRef fileRef(path.c_str());
-    if (fileRef.isNull()) {
-        t.title = fs::path(path).stem().string();
-        t.artist = "Unknown Artist";
-        t.album = "Unknown Album";
-        return t;
+    t.file_path = scanned.path;
+    t.filename = scanned.track.filename;
+    t.file_size = scanned.file_size;
+    t.format_code = static_cast<uint16_t>(mtp::ObjectFormatFromFilename(scanned.path));
+
+    if (scanned.tagged) {
+        t.artist = scanned.track.artist;
+        t.album = scanned.track.album_name;
+        t.genre = scanned.track.genre;
+        t.year = static_cast<int>(scanned.year);
+        t.track_num = scanned.track.track_number;
+        t.disc_num = static_cast<int>(scanned.track.disc_number);
+        t.rating = scanned.track.rating;
+        t.duration_ms = scanned.track.duration_ms;
+        t.artist_guid = scanned.artist_guid;
+        if (extract_art)
+            t.artwork = zune::MediaScanner::ExtractArtwork(scanned.path);
     }
+    t.title = scanned.track.title;
 
-    if (fileRef.tag()) {
-        auto* tag = fileRef.tag();
-        t.artist = tag->artist().toCString(true);
-        t.album = tag->album().toCString(true);
-        t.title = tag->title().toCString(true);
-        t.genre = tag->genre().toCString(true);
-        t.year = tag->year();
-        t.track_num = tag->track();
-    }
-    if (fileRef.audioProperties())
-        t.duration_ms = static_cast<uint32_t>(fileRef.audioProperties()->lengthInMilliseconds());
-
-    auto props = fileRef.file()->properties();
-    if (props.contains("DISCNUMBER"))
-        t.disc_num = props["DISCNUMBER"][0].toInt();
-
-    // Rating: check for explicit rating tag
-    if (props.contains("RATING"))
-        t.rating = props["RATING"][0].toInt();
-
-    // Artist GUID from WMA or ID3v2
-    if (auto* asfFile = dynamic_cast<TagLib::ASF::File*>(fileRef.file())) {
-        if (asfFile->tag()) {
-            auto& m = asfFile->tag()->attributeListMap();
-            if (m.contains("ZuneAlbumArtistMediaID"))
-                t.artist_guid = m["ZuneAlbumArtistMediaID"][0].toString().toCString(true);
-            else if (m.contains("MusicBrainz/Artist ID"))
-                t.artist_guid = m["MusicBrainz/Artist ID"][0].toString().toCString(true);
-        }
-    } else if (auto* mpegFile = dynamic_cast<TagLib::MPEG::File*>(fileRef.file())) {
-        if (mpegFile->tag()) {
-            auto tagProps = mpegFile->tag()->properties();
-            if (tagProps.contains("MUSICBRAINZ_ARTISTID"))
-                t.artist_guid = tagProps["MUSICBRAINZ_ARTISTID"].front().to8Bit();
-        }
-    }
-
-    if (extract_art)
-        t.artwork = extract_artwork(path);
-
-    if (t.title.empty()) t.title = fs::path(path).stem().string();
+    if (t.title.empty()) t.title = fs::path(scanned.path).stem().string();
     if (t.artist.empty()) t.artist = "Unknown Artist";
     if (t.album.empty()) t.album = "Unknown Album";
 
@@ -363,20 +261,11 @@ TrackInfo extract_track_info(const std::string& path, bool extract_art) {
 // ── File Scanning & Grouping ─────────────────────────────────────────────
 
 std::vector<ArtistGroup> scan_and_group(const std::string& input_path, bool extract_art) {
+    // Tags are read on the library's scanner pool
+    zune::MediaScanner scanner;
     std::vector<TrackInfo> all_tracks;
-
-    if (fs::is_directory(input_path)) {
-        for (auto& entry : fs::recursive_directory_iterator(input_path)) {
-            if (!entry.is_regular_file()) continue;
-            auto ext = entry.path().extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-            if (AUDIO_EXTENSIONS.count(ext)) {
-                all_tracks.push_back(extract_track_info(entry.path().string(), extract_art));
-            }
-        }
-    } else {
-        all_tracks.push_back(extract_track_info(input_path, extract_art));
-    }
+    for (const auto& scanned : scanner.Scan(input_path))
+        all_tracks.push_back(to_track_info(scanned, extract_art));
 
     // Group: artist → album → tracks (sorted by track number)
     std::map<std::string, std::map<std::string, std::vector<TrackInfo>>> grouped;
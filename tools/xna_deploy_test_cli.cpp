@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <deque>
 #include <optional>
+#include <memory>
 #include <unordered_map>
 #include <cctype>
 #include <cstdlib>
@@ -30,20 +31,17 @@
 #include <mtp/ptp/ByteArrayObjectStream.h>
 #include <mtp/mtpz/TrustedApp.h>
 
+#include "lib/src/ZuneCabinet.h"
+#include "lib/src/ZuneXnaManifest.h"
+#include "lib/src/ZuneXnaTransport.h"
+
 namespace fs = std::filesystem;
 
 static bool g_verbose = false;
 
 // ── XNAFTW Constants ────────────────────────────────────────────────────
 
-static constexpr size_t XNA_FRAME_SIZE = 1264;
-static constexpr size_t XNA_HEADER_SIZE = 7;
-static constexpr size_t XNA_MAX_PAYLOAD = 1230;
-static constexpr size_t XNA_DELAYED_CHUNK_LIMIT = 0x1FFFB;
-static constexpr int XNA_DELAYED_FRAME_DELAY_MS = 10;
-static constexpr int XNA_DELAYED_DRAIN_MAX_POLLS = 20;
-static constexpr int XNA_DELAYED_DRAIN_IDLE_POLLS = 2;
-static constexpr int XNA_DELAYED_DRAIN_DELAY_MS = 10;
+static constexpr size_t XNA_HEADER_SIZE = zune::kXnaHeaderSize;
 static constexpr const char* XNA_MAGIC = "XNAFTW";
 static constexpr size_t XNA_MAGIC_LEN = 6;
 
@@ -65,8 +63,10 @@ static constexpr uint8_t MSG_CHANNEL_CLOSE = 0xC1;
 static constexpr uint8_t MSG_REGISTRATION  = 0xC5;
 static constexpr uint8_t MSG_NAMED_CHANNEL = 0x01;
 
-static constexpr int MAX_POLLS = 300;
-static constexpr int POLL_DELAY_MS = 5;
+static constexpr int RESPONSE_TIMEOUT_MS = 1500;
+static constexpr uint16_t MTP_RESPONSE_DEVICE_BUSY = 0x2019;
+// Unpacked package files allowed to wait for the transport
+static constexpr size_t CABINET_PREFETCH_BYTES = 16 * 1024 * 1024;
 
 // ── Logging ─────────────────────────────────────────────────────────────
 
@@ -120,6 +120,7 @@ struct CcgamePayload {
     struct FileEntry {
         std::string relative_path;
         std::vector<uint8_t> data;
+        int cabinet_index = -1;     // Still packed in cabinet when data is empty
     };
 
     std::string startup_assembly;
@@ -131,6 +132,7 @@ struct CcgamePayload {
     std::vector<uint8_t> app_data;
     std::vector<uint8_t> thumbnail_data;
     std::vector<FileEntry> files;
+    std::unique_ptr<zune::Cabinet> cabinet;     // Unless extracted by cabextract
 };
 
 struct RuntimePayload {
@@ -921,7 +923,18 @@ fs::path make_temp_directory(const std::string& prefix) {
     throw std::runtime_error("Failed to create temporary directory");
 }
 
-std::optional<CcgamePayload> load_ccgame_payload(const fs::path& package_path) {
+// Members of a .ccgame other than XCabInfo.resources, relative_path holding
+// the name in the cabinet. Packages XNA Game Studio writes (stored or MSZIP
+// folders) are read in process and their members left compressed, with
+// cabinet_index set, until the deploy streams them; anything else goes
+// through cabextract and a temporary directory.
+struct CcgameContents {
+    std::vector<CcgamePayload::FileEntry> members;
+    std::optional<std::vector<uint8_t>> resources;
+    std::unique_ptr<zune::Cabinet> cabinet;
+};
+
+std::optional<CcgameContents> extract_ccgame_contents(const fs::path& package_path) {
     fs::path temp_dir;
     try {
         temp_dir = make_temp_directory("xune_ccgame");
@@ -943,19 +956,65 @@ std::optional<CcgamePayload> load_ccgame_payload(const fs::path& package_path) {
         return std::nullopt;
     }
 
-    std::vector<fs::path> extracted_files;
+    CcgameContents contents;
     for (const auto& entry : fs::directory_iterator(temp_dir)) {
         if (!entry.is_regular_file()) continue;
-        if (entry.path().filename() == "XCabInfo.resources") continue;
-        extracted_files.push_back(entry.path());
+        if (entry.path().filename() == "XCabInfo.resources") {
+            contents.resources = read_binary_file(entry.path());
+            continue;
+        }
+        contents.members.push_back({entry.path().filename().string(), read_binary_file(entry.path())});
+    }
+    cleanup();
+    return contents;
+}
+
+std::optional<CcgameContents> read_ccgame_contents(const fs::path& package_path) {
+    auto cabinet = std::make_unique<zune::Cabinet>();
+    if (!cabinet->Open(read_binary_file(package_path))) {
+        if (g_verbose) {
+            std::cout << "[ccgame] in-process read failed (" << cabinet->error()
+                      << "), using cabextract" << std::endl;
+        }
+        return extract_ccgame_contents(package_path);
+    }
+
+    CcgameContents contents;
+    const auto& files = cabinet->files();
+    for (size_t i = 0; i < files.size(); i++) {
+        // cabextract would put these in subdirectories, which were never listed
+        if (files[i].name.find_first_of("\\/") != std::string::npos) continue;
+        if (files[i].name == "XCabInfo.resources") {
+            std::vector<uint8_t> resources;
+            if (!cabinet->Read(i, resources)) {
+                std::cerr << "ERROR: Failed to unpack XCabInfo.resources (" << cabinet->error()
+                          << "): " << package_path << std::endl;
+                return std::nullopt;
+            }
+            contents.resources = std::move(resources);
+            continue;
+        }
+        CcgamePayload::FileEntry member;
+        member.relative_path = files[i].name;
+        member.cabinet_index = static_cast<int>(i);
+        contents.members.push_back(std::move(member));
     }
-    std::sort(extracted_files.begin(), extracted_files.end());
+    contents.cabinet = std::move(cabinet);
+    return contents;
+}
+
+std::optional<CcgamePayload> load_ccgame_payload(const fs::path& package_path) {
+    auto contents = read_ccgame_contents(package_path);
+    if (!contents) return std::nullopt;
+    auto member_size = [&](const CcgamePayload::FileEntry& member) -> uint64_t {
+        return member.cabinet_index >= 0
+                   ? contents->cabinet->files()[static_cast<size_t>(member.cabinet_index)].size
+                   : member.data.size();
+    };
 
     CcgamePayload payload;
-    auto resource_path = temp_dir / "XCabInfo.resources";
-    if (fs::exists(resource_path)) {
-        auto resource_bytes = read_binary_file(resource_path);
-        auto resource_entries = parse_dotnet_resources(resource_bytes);
+    if (contents->resources) {
+        auto resource_entries = parse_dotnet_resources(*contents->resources);
 
         if (auto* entry = find_dotnet_resource(resource_entries, "GameTitle")) {
             payload.product_name = decode_dotnet_resource_string(entry);
@@ -977,7 +1036,6 @@ std::optional<CcgamePayload> load_ccgame_payload(const fs::path& package_path) {
             if (!files_entry) {
                 std::cerr << "ERROR: Package is missing Files resource: "
                           << package_path << std::endl;
-                cleanup();
                 return std::nullopt;
             }
 
@@ -985,15 +1043,14 @@ std::optional<CcgamePayload> load_ccgame_payload(const fs::path& package_path) {
             if (manifest_paths.empty()) {
                 std::cerr << "ERROR: Failed to decode Files String[,] resource in package: "
                           << package_path << std::endl;
-                cleanup();
                 return std::nullopt;
             }
 
-            std::vector<fs::path> indexed_files = extracted_files;
+            std::vector<CcgamePayload::FileEntry> indexed_files = std::move(contents->members);
             std::sort(indexed_files.begin(), indexed_files.end(),
-                      [](const fs::path& a, const fs::path& b) {
-                          auto a_name = a.filename().string();
-                          auto b_name = b.filename().string();
+                      [](const CcgamePayload::FileEntry& a, const CcgamePayload::FileEntry& b) {
+                          const auto& a_name = a.relative_path;
+                          const auto& b_name = b.relative_path;
                           bool a_numeric = !a_name.empty() &&
                                            std::all_of(a_name.begin(), a_name.end(),
                                                        [](unsigned char ch) { return std::isdigit(ch) != 0; });
@@ -1019,14 +1076,13 @@ std::optional<CcgamePayload> load_ccgame_payload(const fs::path& package_path) {
                           << ") does not match extracted file count ("
                           << indexed_files.size() << ") in package: "
                           << package_path << std::endl;
-                cleanup();
                 return std::nullopt;
             }
 
             for (size_t i = 0; i < indexed_files.size(); i++) {
-                auto bytes = read_binary_file(indexed_files[i]);
-                if (bytes.empty()) continue;
-                payload.files.push_back({manifest_paths[i], std::move(bytes)});
+                if (member_size(indexed_files[i]) == 0) continue;
+                indexed_files[i].relative_path = manifest_paths[i];
+                payload.files.push_back(std::move(indexed_files[i]));
             }
         }
         if (auto* entry = find_dotnet_resource(resource_entries, "GameThumbnail")) {
@@ -1041,35 +1097,38 @@ std::optional<CcgamePayload> load_ccgame_payload(const fs::path& package_path) {
     } else {
         std::cerr << "ERROR: Package is missing XCabInfo.resources: "
                   << package_path << std::endl;
-        cleanup();
         return std::nullopt;
     }
 
     if (payload.startup_assembly.empty()) {
         std::cerr << "ERROR: Package is missing StartupAssembly resource: "
                   << package_path << std::endl;
-        cleanup();
         return std::nullopt;
     }
 
-    for (const auto& file : payload.files) {
-        if (to_lower(file.relative_path) == to_lower(payload.startup_assembly)) {
-            payload.app_data = file.data;
-            break;
+    // The startup assembly is unpacked now; the rest wait for the deploy
+    for (auto& file : payload.files) {
+        if (to_lower(file.relative_path) != to_lower(payload.startup_assembly)) continue;
+        if (file.cabinet_index >= 0 &&
+            !contents->cabinet->Read(static_cast<size_t>(file.cabinet_index), file.data)) {
+            std::cerr << "ERROR: Failed to unpack startup assembly (" << contents->cabinet->error()
+                      << "): " << package_path << std::endl;
+            return std::nullopt;
         }
+        payload.app_data = file.data;
+        break;
     }
 
     if (payload.app_data.empty()) {
         std::cerr << "ERROR: Startup assembly '" << payload.startup_assembly
                   << "' not found in package files: " << package_path << std::endl;
-        cleanup();
         return std::nullopt;
     }
 
     if (payload.product_name.empty()) {
         payload.product_name = fs::path(payload.startup_assembly).stem().string();
     }
-    cleanup();
+    payload.cabinet = std::move(contents->cabinet);
     return payload;
 }
 
@@ -1190,24 +1249,7 @@ public:
     // Payload starts at byte 7, zero-padded, MAC at bytes 1240-1263
     mtp::ByteArray build_frame(uint8_t channel, uint16_t payload_len,
                                 const std::vector<uint8_t>& payload) {
-        mtp::ByteArray frame(XNA_FRAME_SIZE, 0);
-
-        // Sequence number (big-endian)
-        frame[0] = (seq_ >> 24) & 0xFF;
-        frame[1] = (seq_ >> 16) & 0xFF;
-        frame[2] = (seq_ >> 8) & 0xFF;
-        frame[3] = seq_ & 0xFF;
-        seq_++;
-
-        frame[4] = channel;
-        frame[5] = static_cast<uint8_t>((payload_len >> 8) & 0xFF);
-        frame[6] = static_cast<uint8_t>(payload_len & 0xFF);
-
-        // Copy payload starting at byte 7
-        size_t copy_len = std::min(payload.size(), XNA_MAX_PAYLOAD);
-        memcpy(frame.data() + XNA_HEADER_SIZE, payload.data(), copy_len);
-
-        return frame;
+        return zune::BuildXnaFrame(seq_++, channel, payload_len, payload.data(), payload.size());
     }
 
     // Build a channel management frame (msg_type is first payload byte)
@@ -1452,6 +1494,21 @@ void log_schema(const std::vector<SchemaVerb>& verbs) {
     }
 }
 
+// Identifies the firmware's channel interface for the deploy manifest
+uint64_t schema_fingerprint(const std::vector<SchemaVerb>& verbs) {
+    uint64_t hash = zune::XnaDeployManifest::Hash(nullptr, 0);
+    for (const auto& verb : verbs) {
+        hash = zune::XnaDeployManifest::Hash(reinterpret_cast<const uint8_t*>(verb.name.c_str()),
+                                             verb.name.size() + 1, hash);
+        for (const auto& param : verb.params) {
+            hash = zune::XnaDeployManifest::Hash(&param.type, 1, hash);
+            hash = zune::XnaDeployManifest::Hash(reinterpret_cast<const uint8_t*>(param.name.c_str()),
+                                                 param.name.size() + 1, hash);
+        }
+    }
+    return hash;
+}
+
 struct ParsedXnaResponse {
     bool faulted = false;
     bool requires_delayed_parameter = false;
@@ -1465,110 +1522,13 @@ struct ParsedXnaResponse {
     std::string value_summary;
 };
 
-struct ParsedXnaSecureFrame {
-    uint32_t sequence = 0;
-    uint8_t channel = 0;
-    uint16_t payload_length = 0;
-    size_t payload_bytes = 0;
-    bool has_xnaftw_magic = false;
-    bool has_control_opcode = false;
-    uint16_t control_opcode = 0;
-    bool has_control_value = false;
-    uint16_t control_value = 0;
-    bool has_embedded_segment = false;
-    uint8_t embedded_channel = 0;
-    uint16_t embedded_payload_length = 0;
-    bool embedded_has_xnaftw_magic = false;
-};
-
-bool is_xnaftw_response_frame(const mtp::ByteArray& data);
-
-std::optional<ParsedXnaSecureFrame> parse_xna_secure_frame(const mtp::ByteArray& data) {
-    if (data.size() != XNA_FRAME_SIZE) return std::nullopt;
-
-    ParsedXnaSecureFrame frame;
-    frame.sequence = (static_cast<uint32_t>(data[0]) << 24) |
-                     (static_cast<uint32_t>(data[1]) << 16) |
-                     (static_cast<uint32_t>(data[2]) << 8) |
-                     static_cast<uint32_t>(data[3]);
-    frame.channel = data[4];
-    frame.payload_length = (static_cast<uint16_t>(data[5]) << 8) |
-                           static_cast<uint16_t>(data[6]);
-    frame.payload_bytes = std::min(static_cast<size_t>(frame.payload_length),
-                                   data.size() - XNA_HEADER_SIZE);
-
-    if (frame.payload_bytes >= XNA_MAGIC_LEN &&
-        memcmp(data.data() + XNA_HEADER_SIZE, XNA_MAGIC, XNA_MAGIC_LEN) == 0) {
-        frame.has_xnaftw_magic = true;
-    }
-
-    if (frame.channel == 0x00 && !frame.has_xnaftw_magic && frame.payload_bytes >= 2) {
-        frame.has_control_opcode = true;
-        frame.control_opcode = static_cast<uint16_t>(data[XNA_HEADER_SIZE]) |
-                               (static_cast<uint16_t>(data[XNA_HEADER_SIZE + 1]) << 8);
-        if (frame.payload_bytes >= 4) {
-            frame.has_control_value = true;
-            frame.control_value = static_cast<uint16_t>(data[XNA_HEADER_SIZE + 2]) |
-                                  (static_cast<uint16_t>(data[XNA_HEADER_SIZE + 3]) << 8);
-        }
-    }
-
-    size_t embedded_offset = XNA_HEADER_SIZE + frame.payload_bytes;
-    if (embedded_offset + 3 <= data.size()) {
-        uint8_t embedded_channel = data[embedded_offset];
-        uint16_t embedded_payload_length =
-            (static_cast<uint16_t>(data[embedded_offset + 1]) << 8) |
-            static_cast<uint16_t>(data[embedded_offset + 2]);
-        size_t embedded_payload_offset = embedded_offset + 3;
-        if (embedded_payload_length > 0 &&
-            embedded_channel <= 0x02 &&
-            embedded_payload_offset + embedded_payload_length <= data.size()) {
-            frame.has_embedded_segment = true;
-            frame.embedded_channel = embedded_channel;
-            frame.embedded_payload_length = embedded_payload_length;
-            if (embedded_payload_length >= XNA_MAGIC_LEN &&
-                memcmp(data.data() + embedded_payload_offset, XNA_MAGIC, XNA_MAGIC_LEN) == 0) {
-                frame.embedded_has_xnaftw_magic = true;
-            }
-        }
-    }
-
-    return frame;
-}
-
-std::optional<mtp::ByteArray> extract_embedded_xnaftw_response(const mtp::ByteArray& data) {
-    auto frame = parse_xna_secure_frame(data);
-    if (!frame || !frame->has_embedded_segment || !frame->embedded_has_xnaftw_magic) {
-        return std::nullopt;
-    }
-
-    size_t embedded_offset = XNA_HEADER_SIZE + frame->payload_bytes;
-    size_t embedded_payload_offset = embedded_offset + 3;
-    mtp::ByteArray synthetic(XNA_HEADER_SIZE + frame->embedded_payload_length, 0);
-    synthetic[0] = data[0];
-    synthetic[1] = data[1];
-    synthetic[2] = data[2];
-    synthetic[3] = data[3];
-    synthetic[4] = frame->embedded_channel;
-    synthetic[5] = static_cast<uint8_t>((frame->embedded_payload_length >> 8) & 0xFF);
-    synthetic[6] = static_cast<uint8_t>(frame->embedded_payload_length & 0xFF);
-    std::copy(data.begin() + static_cast<std::ptrdiff_t>(embedded_payload_offset),
-              data.begin() + static_cast<std::ptrdiff_t>(
-                  embedded_payload_offset + frame->embedded_payload_length),
-              synthetic.begin() + static_cast<std::ptrdiff_t>(XNA_HEADER_SIZE));
-    if (!is_xnaftw_response_frame(synthetic)) {
-        return std::nullopt;
-    }
-    return synthetic;
-}
-
 std::string describe_xna_control_opcode(uint16_t opcode) {
     switch (opcode) {
     case 0x00B1:
         return "teardown-final?";
     case 0x00D1:
         return "teardown-pulse?";
-    case 0x01D2:
+    case zune::kXnaDelayedStatusOpcode:
         return "delayed-transfer-status?";
     default:
         return {};
@@ -1578,7 +1538,7 @@ std::string describe_xna_control_opcode(uint16_t opcode) {
 void maybe_log_non_xnaftw_frame(const mtp::ByteArray& data) {
     if (!g_verbose) return;
 
-    auto frame = parse_xna_secure_frame(data);
+    auto frame = zune::ParseXnaFrame(data);
     if (!frame || frame->has_xnaftw_magic) return;
 
     std::ostringstream oss;
@@ -1611,14 +1571,8 @@ void maybe_log_non_xnaftw_frame(const mtp::ByteArray& data) {
     std::cout << oss.str() << std::endl;
 }
 
-bool is_xnaftw_response_frame(const mtp::ByteArray& data) {
-    if (data.size() < XNA_HEADER_SIZE + XNA_MAGIC_LEN + 1) return false;
-    if (memcmp(data.data() + XNA_HEADER_SIZE, XNA_MAGIC, XNA_MAGIC_LEN) != 0) return false;
-    return data[XNA_HEADER_SIZE + XNA_MAGIC_LEN] == XNAFTW_RESPONSE;
-}
-
 std::optional<ParsedXnaResponse> parse_xnaftw_response(const mtp::ByteArray& data) {
-    if (!is_xnaftw_response_frame(data)) return std::nullopt;
+    if (!zune::IsXnaResponse(data)) return std::nullopt;
 
     size_t offset = XNA_HEADER_SIZE + XNA_MAGIC_LEN + 1;
     ParsedXnaResponse response;
@@ -1712,15 +1666,31 @@ class XnaSession {
     XnaFrameBuilder builder_;
     std::deque<mtp::ByteArray> pending_rx_;
     std::vector<SchemaVerb> last_schema_;
-
-    mtp::ByteArray try_read_frame_once() {
-        mtp::ByteArray data;
-        try {
-            data = session_->Operation9223();
-        } catch (const mtp::InvalidResponseException& ex) {
-            if (!is_retryable_xna_poll_error(ex)) throw;
-        }
-        return data;
+    zune::XnaTransport transport_;
+
+    zune::XnaTransport::Link make_link() {
+        zune::XnaTransport::Link link;
+        link.write = [this](const mtp::ByteArray& frame) {
+            hex_dump("TX", frame);
+            try {
+                session_->Operation9222(frame);
+            } catch (const mtp::InvalidResponseException& ex) {
+                if (static_cast<uint16_t>(ex.Type) != MTP_RESPONSE_DEVICE_BUSY) throw;
+                return zune::XnaTransport::WriteStatus::Busy;
+            }
+            return zune::XnaTransport::WriteStatus::Sent;
+        };
+        link.read = [this](mtp::ByteArray& frame) {
+            try {
+                frame = session_->Operation9223();
+            } catch (const mtp::InvalidResponseException& ex) {
+                if (!is_retryable_xna_poll_error(ex)) throw;
+                return false;
+            }
+            return !frame.empty();
+        };
+        link.observe = [this](const mtp::ByteArray& frame) { log_inbound_frame(frame); };
+        return link;
     }
 
     void log_inbound_frame(const mtp::ByteArray& data) {
@@ -1736,86 +1706,31 @@ class XnaSession {
         }
     }
 
-    // Channel close from device — high byte is channel ID, low byte is 0xC1
-    bool frame_is_channel_close(const mtp::ByteArray& data) const {
-        auto frame = parse_xna_secure_frame(data);
-        if (!frame || !frame->has_control_opcode) return false;
-        return (frame->control_opcode & 0xFF) == 0xC1;
-    }
-
-    enum class DelayedDrainState {
-        Continue,
-        ResponseQueued,
-        DeviceClosing,
-    };
-
-    DelayedDrainState drain_delayed_transfer_feedback() {
-        int idle_polls = 0;
-        for (int i = 0; i < XNA_DELAYED_DRAIN_MAX_POLLS; ++i) {
-            auto data = try_read_frame_once();
-            if (data.empty()) {
-                ++idle_polls;
-                if (idle_polls >= XNA_DELAYED_DRAIN_IDLE_POLLS) {
-                    return DelayedDrainState::Continue;
-                }
-                if (XNA_DELAYED_DRAIN_DELAY_MS > 0) {
-                    std::this_thread::sleep_for(
-                        std::chrono::milliseconds(XNA_DELAYED_DRAIN_DELAY_MS));
-                }
-                continue;
-            }
-
-            idle_polls = 0;
-            log_inbound_frame(data);
-            pending_rx_.push_back(data);
-
-            if (auto embedded = extract_embedded_xnaftw_response(data)) {
-                pending_rx_.push_back(*embedded);
-                return DelayedDrainState::ResponseQueued;
-            }
-            if (is_xnaftw_response(data)) {
-                return DelayedDrainState::ResponseQueued;
-            }
-            if (frame_is_channel_close(data)) {
-                return DelayedDrainState::DeviceClosing;
-            }
-        }
-        return DelayedDrainState::Continue;
-    }
-
 public:
-    explicit XnaSession(std::shared_ptr<mtp::Session> session) : session_(session) {}
+    explicit XnaSession(std::shared_ptr<mtp::Session> session)
+        : session_(session), transport_(make_link()) {}
 
     void send_frame(const mtp::ByteArray& frame) {
-        hex_dump("TX", frame);
-        session_->Operation9222(frame);
+        if (!transport_.Send(frame)) {
+            throw std::runtime_error("device stayed busy");
+        }
     }
 
-    mtp::ByteArray poll(int max_polls = MAX_POLLS) {
+    mtp::ByteArray poll(int timeout_ms = RESPONSE_TIMEOUT_MS) {
         if (!pending_rx_.empty()) {
             auto data = pending_rx_.front();
             pending_rx_.pop_front();
             return data;
         }
-        for (int i = 0; i < max_polls; i++) {
-            auto data = try_read_frame_once();
-            if (!data.empty()) {
-                log_inbound_frame(data);
-                return data;
-            }
-            if (g_verbose && (i % 10 == 0) && i > 0)
-                std::cout << "      (polling... " << i << "/" << max_polls << ")" << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_DELAY_MS));
-        }
-        return {};
+        return transport_.Receive(std::chrono::milliseconds(timeout_ms));
     }
 
-    mtp::ByteArray send_and_poll(const mtp::ByteArray& frame, int max_polls = MAX_POLLS) {
+    mtp::ByteArray send_and_poll(const mtp::ByteArray& frame, int timeout_ms = RESPONSE_TIMEOUT_MS) {
         send_frame(frame);
-        return poll(max_polls);
+        return poll(timeout_ms);
     }
 
-    mtp::ByteArray wait_for_xnaftw_response(int max_polls = MAX_POLLS) {
+    mtp::ByteArray wait_for_xnaftw_response(int timeout_ms = RESPONSE_TIMEOUT_MS) {
         mtp::ByteArray last;
         while (!pending_rx_.empty()) {
             auto data = pending_rx_.front();
@@ -1824,32 +1739,41 @@ public:
             if (is_xnaftw_response(data)) {
                 return data;
             }
-            if (auto embedded = extract_embedded_xnaftw_response(data)) {
+            if (auto embedded = zune::ExtractEmbeddedXnaResponse(data)) {
                 return *embedded;
             }
         }
-        for (int i = 0; i < max_polls; i++) {
-            auto data = try_read_frame_once();
-            if (!data.empty()) {
-                log_inbound_frame(data);
-                last = data;
-                if (is_xnaftw_response(data)) {
-                    return data;
-                }
-                if (auto embedded = extract_embedded_xnaftw_response(data)) {
-                    return *embedded;
-                }
+        // Skips status frames left over from a delayed transfer
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0) break;
+            auto data = transport_.Receive(remaining);
+            if (data.empty()) break;
+            last = data;
+            if (is_xnaftw_response(data)) {
+                return data;
             }
-            if (g_verbose && (i % 10 == 0) && i > 0) {
-                std::cout << "      (polling... " << i << "/" << max_polls << ")" << std::endl;
+            if (auto embedded = zune::ExtractEmbeddedXnaResponse(data)) {
+                return *embedded;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_DELAY_MS));
         }
         return last;
     }
 
+    void log_transfer_stats() const {
+        if (!g_verbose) return;
+        const auto& stats = transport_.stats();
+        std::cout << "      [XFER] total " << stats.bytes << " bytes, " << stats.frames << " frames, "
+                  << stats.acks << " acks (" << stats.slow_acks << " slow, "
+                  << stats.missed_acks << " missed), " << stats.busy_writes << " busy, "
+                  << "waited " << stats.waited.count() / 1000 << " ms, "
+                  << "paced " << stats.paced.count() / 1000 << " ms" << std::endl;
+    }
+
     static bool is_xnaftw_response(const mtp::ByteArray& data) {
-        return is_xnaftw_response_frame(data);
+        return zune::IsXnaResponse(data);
     }
 
     XnaFrameBuilder& builder() { return builder_; }
@@ -1970,6 +1894,8 @@ public:
     // open broker → ack → CreateChannel RPC → close broker → open named → ack
     bool setup_channel(uint8_t broker_id, uint8_t channel_num,
                        const std::string& channel_name, const Guid& channel_guid) {
+        last_schema_.clear();
+
         // 1. Open broker
         if (!open_broker(broker_id)) return false;
 
@@ -2077,77 +2003,34 @@ public:
                 return resp;
             }
 
-            // Send frames with inter-frame pacing, wait for device ACK between
-            // 128KB chunks. The device sends 0x01d2 status frames as flow control —
-            // we must read at least one before sending the next chunk, or the device's
-            // buffer overflows and it closes the channel on large files.
-            bool got_early_response = false;
-            while (content_offset < content.size() && !got_early_response) {
-                size_t delayed_size = std::min(content.size() - content_offset,
-                                               static_cast<size_t>(XNA_DELAYED_CHUNK_LIMIT));
-                std::vector<uint8_t> delayed_payload;
-                delayed_payload.reserve(5 + delayed_size);
-                delayed_payload.push_back(0x00);
-                delayed_payload.push_back(static_cast<uint8_t>(delayed_size & 0xFF));
-                delayed_payload.push_back(static_cast<uint8_t>((delayed_size >> 8) & 0xFF));
-                delayed_payload.push_back(static_cast<uint8_t>((delayed_size >> 16) & 0xFF));
-                delayed_payload.push_back(static_cast<uint8_t>((delayed_size >> 24) & 0xFF));
-                delayed_payload.insert(
-                    delayed_payload.end(),
-                    content.begin() + static_cast<std::ptrdiff_t>(content_offset),
-                    content.begin() + static_cast<std::ptrdiff_t>(content_offset + delayed_size));
-
-                // Send all frames for this chunk with inter-frame pacing
-                size_t frame_offset = 0;
-                while (frame_offset < delayed_payload.size()) {
-                    size_t frame_size = std::min(delayed_payload.size() - frame_offset,
-                                                 XNA_MAX_PAYLOAD);
-                    try {
-                        send_frame(builder_.build_binary_frame(
-                            channel,
-                            delayed_payload.data() + frame_offset,
-                            frame_size));
-                    } catch (const std::exception& ex) {
-                        log_err("Delayed transfer write failed for " + method + ": " + ex.what());
-                        return resp;
-                    }
-                    frame_offset += frame_size;
-                    if (XNA_DELAYED_FRAME_DELAY_MS > 0) {
-                        std::this_thread::sleep_for(
-                            std::chrono::milliseconds(XNA_DELAYED_FRAME_DELAY_MS));
-                    }
-                }
-
-                content_offset += delayed_size;
-
-                // Drain ALL pending device status frames before sending next chunk.
-                if (content_offset < content.size()) {
-                    int idle_count = 0;
-                    for (int dp = 0; dp < MAX_POLLS && idle_count < 3; dp++) {
-                        auto data = try_read_frame_once();
-                        if (data.empty()) {
-                            idle_count++;
-                            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_DELAY_MS));
-                            continue;
-                        }
-                        idle_count = 0;
-                        log_inbound_frame(data);
-                        if (is_xnaftw_response(data)) {
-                            pending_rx_.push_back(data);
-                            got_early_response = true;
-                            break;
-                        }
-                        if (auto embedded = extract_embedded_xnaftw_response(data)) {
-                            pending_rx_.push_back(*embedded);
-                            got_early_response = true;
-                            break;
-                        }
-                    }
-                }
+            // The transport keeps the device's delayed-transfer buffer full
+            // without overflowing it, pacing only when the device pushes back
+            uint32_t seq = builder_.current_seq();
+            mtp::ByteArray early;
+            zune::XnaTransport::Result sent;
+            try {
+                sent = transport_.SendDelayed(channel, content.data() + content_offset,
+                                              content.size() - content_offset, seq, &early);
+            } catch (const std::exception& ex) {
+                log_err("Delayed transfer write failed for " + method + ": " + ex.what());
+                return resp;
             }
-
-            if (got_early_response) {
+            builder_.set_seq(seq);
+            log_transfer_stats();
+            switch (sent) {
+            case zune::XnaTransport::Result::Sent:
+                content_offset = content.size();
+                break;
+            case zune::XnaTransport::Result::Response:
+                pending_rx_.push_back(early);
                 content_offset = content.size();
+                break;
+            case zune::XnaTransport::Result::ChannelClosed:
+                log_err("Device closed the channel during delayed transfer for " + method);
+                return resp;
+            case zune::XnaTransport::Result::WriteFailed:
+                log_err("Delayed transfer write failed for " + method + ": device stayed busy");
+                return resp;
             }
 
             resp = wait_for_xnaftw_response();
@@ -2195,6 +2078,8 @@ void print_usage(const char* prog) {
     std::cout << "  --thumbnail <png>     Thumbnail PNG file" << std::endl;
     std::cout << "  --runtime-dir <dir>   Directory containing Zune runtime DLLs" << std::endl;
     std::cout << "  --launch              Launch app on device after deploy" << std::endl;
+    std::cout << "  --full                Send every file, even if unchanged since the last deploy" << std::endl;
+    std::cout << "  --manifest-dir <dir>  Where deploy manifests are kept (default ~/.xune/xna-deploy)" << std::endl;
     std::cout << "  --verbose             Show protocol details" << std::endl;
     std::cout << "  --help                Show this help" << std::endl;
 }
@@ -2211,6 +2096,8 @@ int main(int argc, char* argv[]) {
     bool description_overridden = false;
     bool thumbnail_overridden = false;
     bool launch_after_deploy = false;
+    bool full_deploy = false;
+    std::string manifest_dir = std::string(getenv("HOME") ? getenv("HOME") : ".") + "/.xune/xna-deploy";
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -2232,6 +2119,10 @@ int main(int argc, char* argv[]) {
             runtime_dir_override = argv[++i];
         }
         else if (arg == "--launch") launch_after_deploy = true;
+        else if (arg == "--full") full_deploy = true;
+        else if (arg == "--manifest-dir" && i + 1 < argc) {
+            manifest_dir = argv[++i];
+        }
         else if (arg[0] != '-') app_path = arg;
     }
 
@@ -2248,6 +2139,7 @@ int main(int argc, char* argv[]) {
     std::vector<uint8_t> app_data;
     std::vector<uint8_t> thumbnail_data;
     std::vector<CcgamePayload::FileEntry> deploy_files;
+    std::unique_ptr<zune::Cabinet> package_cabinet;
     std::string package_runtime_profile;
     std::string runtime_token = RUNTIME_TOKEN;
     Guid container_id = Guid::zero();
@@ -2259,6 +2151,7 @@ int main(int argc, char* argv[]) {
         app_filename = package->startup_assembly;
         app_data = std::move(package->app_data);
         deploy_files = std::move(package->files);
+        package_cabinet = std::move(package->cabinet);
         if (!name_overridden && !package->product_name.empty()) {
             game_name = package->product_name;
         }
@@ -2502,6 +2395,52 @@ int main(int argc, char* argv[]) {
     Guid chan2_guid = Guid::from_canonical_string("AA3C2881-4EB9-4AF6-8137-635C2E64CE4A");
     if (!xna.setup_channel(0x02, 0x02, "XNACHAN2", chan2_guid)) return 1;
 
+    // Only files changed since the last completed deploy to this device go out
+    std::string manifest_path = (fs::path(manifest_dir) /
+                                 zune::XnaDeployManifest::FileName(devinfo.SerialNumber)).string();
+    zune::XnaDeployManifest manifest;
+    manifest.Load(manifest_path);
+    std::string manifest_key = container_id.to_string_n();
+    if (container_id.parts[0] == 0 && container_id.parts[1] == 0 &&
+        container_id.parts[2] == 0 && container_id.parts[3] == 0) {
+        manifest_key += "/" + app_filename;
+    }
+
+    // Package files still in the cabinet unpack on their own thread, in
+    // deploy order, while earlier ones are sent; each is hashed and checked
+    // against the manifest as it arrives
+    std::unique_ptr<zune::CabinetPrefetcher> prefetcher;
+    if (package_cabinet) {
+        std::vector<size_t> order;
+        for (const auto& file : deploy_files) {
+            if (file.cabinet_index >= 0 && file.data.empty()) {
+                order.push_back(static_cast<size_t>(file.cabinet_index));
+            }
+        }
+        prefetcher = std::make_unique<zune::CabinetPrefetcher>(*package_cabinet, std::move(order),
+                                                               CABINET_PREFETCH_BYTES);
+    }
+
+    zune::XnaDeployManifest::Container deployed;
+    deployed.key = manifest_key;
+    deployed.schema = schema_fingerprint(xna.last_schema());
+    // Copied, as the record is forgotten before the container opens
+    std::optional<zune::XnaDeployManifest::Container> previous_record;
+    if (const auto* found = manifest.Find(manifest_key); found && !full_deploy) {
+        previous_record = *found;
+    }
+    const auto* previous = previous_record ? &*previous_record : nullptr;
+    bool incremental = previous && previous->schema == deployed.schema;
+    if (previous && !incremental) {
+        log_ok("Device schema changed since the last deploy; sending every file");
+    }
+
+    // A deploy that stops part way leaves the container in an unknown state
+    manifest.Forget(manifest_key);
+    if (!manifest.Save(manifest_path)) {
+        log_err("Cannot write deploy manifest " + manifest_path + " (non-fatal)");
+    }
+
     // OpenGameContainer
     {
         XnaParamBuilder params;
@@ -2513,21 +2452,54 @@ int main(int argc, char* argv[]) {
     }
 
     // PutFileInContainer
+    size_t send_count = 0;
     for (size_t fi = 0; fi < deploy_files.size(); fi++) {
         const auto& file = deploy_files[fi];
-        log_op("[" + std::to_string(fi + 1) + "/" + std::to_string(deploy_files.size()) +
-               "] " + file.relative_path);
+        std::string progress = "[" + std::to_string(fi + 1) + "/" +
+                               std::to_string(deploy_files.size()) + "] " + file.relative_path;
+        std::vector<uint8_t> unpacked;
+        if (file.cabinet_index >= 0 && file.data.empty()) {
+            zune::CabinetPrefetcher::Entry entry;
+            if (!prefetcher->Next(entry)) {
+                log_err(progress + ": cannot unpack (" + package_cabinet->error() + ")");
+                return 1;
+            }
+            unpacked = std::move(entry.data);
+        }
+        const auto& content = unpacked.empty() ? file.data : unpacked;
+
+        deployed.files.push_back(zune::XnaDeployManifest::Describe(
+            file.relative_path, content.data(), content.size()));
+        if (!zune::XnaDeployManifest::Changed(previous, deployed.schema, deployed.files.back())) {
+            log_ok(progress + " unchanged");
+            continue;
+        }
+        send_count++;
+        log_op(progress);
         XnaParamBuilder params;
         params.add_string("filePath", 0x08, file.relative_path);
         uint8_t file_content_index =
-            params.add_binary_ref("fileContent", static_cast<uint32_t>(file.data.size()));
+            params.add_binary_ref("fileContent", static_cast<uint32_t>(content.size()));
         auto resp = xna.send_binary_content(MSG_NAMED_CHANNEL, "PutFileInContainer",
-                                            params.serialize(), file.data, file_content_index);
+                                            params.serialize(), content, file_content_index);
         if (!is_success_xna_response(resp)) return 1;
     }
+    prefetcher.reset();
+    if (incremental) {
+        log_ok("Incremental deploy: " + std::to_string(send_count) + " of " +
+               std::to_string(deploy_files.size()) + " files changed");
+    }
 
     // PutThumbnailInContainer
+    static const std::string kThumbnailEntry = "<thumbnail>";
     if (!thumbnail_data.empty()) {
+        deployed.files.push_back(zune::XnaDeployManifest::Describe(
+            kThumbnailEntry, thumbnail_data.data(), thumbnail_data.size()));
+    }
+    if (!thumbnail_data.empty() &&
+        !zune::XnaDeployManifest::Changed(previous, deployed.schema, deployed.files.back())) {
+        log_ok("Thumbnail unchanged");
+    } else if (!thumbnail_data.empty()) {
         XnaParamBuilder params;
         uint8_t thumbnail_content_index =
             params.add_binary_ref("thumbnailContent", static_cast<uint32_t>(thumbnail_data.size()));
@@ -2557,6 +2529,11 @@ int main(int argc, char* argv[]) {
         if (!is_success_xna_response(resp)) return 1;
     }
 
+    manifest.Record(deployed);
+    if (!manifest.Save(manifest_path)) {
+        log_err("Cannot write deploy manifest " + manifest_path + " (non-fatal)");
+    }
+
     // Close XNACHAN2
     xna.send_close(MSG_NAMED_CHANNEL);
 
@@ -2578,6 +2555,9 @@ int main(int argc, char* argv[]) {
             auto resp = xna.xnaftw_call(MSG_NAMED_CHANNEL, "LaunchTestMode", params.serialize());
             if (!is_success_xna_response(resp)) {
                 log_err("LaunchTestMode failed — game was deployed but could not be launched");
+                // Do not trust the container next time
+                manifest.Forget(manifest_key);
+                manifest.Save(manifest_path);
             }
         }
 
@@ -2587,7 +2567,7 @@ int main(int argc, char* argv[]) {
     // ── Teardown ────────────────────────────────────────────────────
 
     log_phase("Teardown");
-    xna.poll(100);
+    xna.poll(500);
 
     // Disconnect frame (msg_type 0xB1)
     {